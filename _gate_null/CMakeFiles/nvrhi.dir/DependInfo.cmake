@@ -0,0 +1,45 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/capture/capture-commandlist.cpp" "CMakeFiles/nvrhi.dir/src/capture/capture-commandlist.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/capture/capture-commandlist.cpp.o.d"
+  "/root/repo/src/capture/capture-device.cpp" "CMakeFiles/nvrhi.dir/src/capture/capture-device.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/capture/capture-device.cpp.o.d"
+  "/root/repo/src/capture/capture-replay.cpp" "CMakeFiles/nvrhi.dir/src/capture/capture-replay.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/capture/capture-replay.cpp.o.d"
+  "/root/repo/src/capture/capture-stream.cpp" "CMakeFiles/nvrhi.dir/src/capture/capture-stream.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/capture/capture-stream.cpp.o.d"
+  "/root/repo/src/common/aftermath.cpp" "CMakeFiles/nvrhi.dir/src/common/aftermath.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/aftermath.cpp.o.d"
+  "/root/repo/src/common/bindless-registry.cpp" "CMakeFiles/nvrhi.dir/src/common/bindless-registry.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/bindless-registry.cpp.o.d"
+  "/root/repo/src/common/cluster-build-context.cpp" "CMakeFiles/nvrhi.dir/src/common/cluster-build-context.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/cluster-build-context.cpp.o.d"
+  "/root/repo/src/common/coopvec-matrix-cache.cpp" "CMakeFiles/nvrhi.dir/src/common/coopvec-matrix-cache.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/coopvec-matrix-cache.cpp.o.d"
+  "/root/repo/src/common/deferred-destruction.cpp" "CMakeFiles/nvrhi.dir/src/common/deferred-destruction.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/deferred-destruction.cpp.o.d"
+  "/root/repo/src/common/format-info.cpp" "CMakeFiles/nvrhi.dir/src/common/format-info.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/format-info.cpp.o.d"
+  "/root/repo/src/common/gpu-profiler.cpp" "CMakeFiles/nvrhi.dir/src/common/gpu-profiler.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/gpu-profiler.cpp.o.d"
+  "/root/repo/src/common/memory-statistics.cpp" "CMakeFiles/nvrhi.dir/src/common/memory-statistics.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/memory-statistics.cpp.o.d"
+  "/root/repo/src/common/misc.cpp" "CMakeFiles/nvrhi.dir/src/common/misc.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/misc.cpp.o.d"
+  "/root/repo/src/common/pipeline-compiler.cpp" "CMakeFiles/nvrhi.dir/src/common/pipeline-compiler.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/pipeline-compiler.cpp.o.d"
+  "/root/repo/src/common/readback-pool.cpp" "CMakeFiles/nvrhi.dir/src/common/readback-pool.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/readback-pool.cpp.o.d"
+  "/root/repo/src/common/residency.cpp" "CMakeFiles/nvrhi.dir/src/common/residency.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/residency.cpp.o.d"
+  "/root/repo/src/common/ring-allocator.cpp" "CMakeFiles/nvrhi.dir/src/common/ring-allocator.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/ring-allocator.cpp.o.d"
+  "/root/repo/src/common/shader-permutation-cache.cpp" "CMakeFiles/nvrhi.dir/src/common/shader-permutation-cache.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/shader-permutation-cache.cpp.o.d"
+  "/root/repo/src/common/state-tracking.cpp" "CMakeFiles/nvrhi.dir/src/common/state-tracking.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/state-tracking.cpp.o.d"
+  "/root/repo/src/common/storage-queue.cpp" "CMakeFiles/nvrhi.dir/src/common/storage-queue.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/storage-queue.cpp.o.d"
+  "/root/repo/src/common/streaming-uploader.cpp" "CMakeFiles/nvrhi.dir/src/common/streaming-uploader.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/streaming-uploader.cpp.o.d"
+  "/root/repo/src/common/tiled-streaming.cpp" "CMakeFiles/nvrhi.dir/src/common/tiled-streaming.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/tiled-streaming.cpp.o.d"
+  "/root/repo/src/common/tlsf-allocator.cpp" "CMakeFiles/nvrhi.dir/src/common/tlsf-allocator.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/tlsf-allocator.cpp.o.d"
+  "/root/repo/src/common/transient-pool.cpp" "CMakeFiles/nvrhi.dir/src/common/transient-pool.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/transient-pool.cpp.o.d"
+  "/root/repo/src/common/utils.cpp" "CMakeFiles/nvrhi.dir/src/common/utils.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/common/utils.cpp.o.d"
+  "/root/repo/src/validation/validation-commandlist.cpp" "CMakeFiles/nvrhi.dir/src/validation/validation-commandlist.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/validation/validation-commandlist.cpp.o.d"
+  "/root/repo/src/validation/validation-device.cpp" "CMakeFiles/nvrhi.dir/src/validation/validation-device.cpp.o" "gcc" "CMakeFiles/nvrhi.dir/src/validation/validation-device.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,63 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nvrhi.dir/src/capture/capture-commandlist.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/capture/capture-commandlist.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/capture/capture-device.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/capture/capture-device.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/capture/capture-replay.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/capture/capture-replay.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/capture/capture-stream.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/capture/capture-stream.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/aftermath.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/aftermath.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/bindless-registry.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/bindless-registry.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/cluster-build-context.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/cluster-build-context.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/coopvec-matrix-cache.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/coopvec-matrix-cache.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/deferred-destruction.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/deferred-destruction.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/format-info.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/format-info.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/gpu-profiler.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/gpu-profiler.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/memory-statistics.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/memory-statistics.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/misc.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/misc.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/pipeline-compiler.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/pipeline-compiler.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/readback-pool.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/readback-pool.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/residency.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/residency.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/ring-allocator.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/ring-allocator.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/shader-permutation-cache.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/shader-permutation-cache.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/state-tracking.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/state-tracking.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/storage-queue.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/storage-queue.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/streaming-uploader.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/streaming-uploader.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/tiled-streaming.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/tiled-streaming.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/tlsf-allocator.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/tlsf-allocator.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/transient-pool.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/transient-pool.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/common/utils.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/common/utils.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/validation/validation-commandlist.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/validation/validation-commandlist.cpp.o.d"
+  "CMakeFiles/nvrhi.dir/src/validation/validation-device.cpp.o"
+  "CMakeFiles/nvrhi.dir/src/validation/validation-device.cpp.o.d"
+  "libnvrhi.a"
+  "libnvrhi.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nvrhi.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/null/null-commandlist.cpp" "CMakeFiles/nvrhi_null.dir/src/null/null-commandlist.cpp.o" "gcc" "CMakeFiles/nvrhi_null.dir/src/null/null-commandlist.cpp.o.d"
+  "/root/repo/src/null/null-device.cpp" "CMakeFiles/nvrhi_null.dir/src/null/null-device.cpp.o" "gcc" "CMakeFiles/nvrhi_null.dir/src/null/null-device.cpp.o.d"
+  "/root/repo/src/null/null-resources.cpp" "CMakeFiles/nvrhi_null.dir/src/null/null-resources.cpp.o" "gcc" "CMakeFiles/nvrhi_null.dir/src/null/null-resources.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
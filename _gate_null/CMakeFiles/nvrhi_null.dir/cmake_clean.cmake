@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nvrhi_null.dir/src/null/null-commandlist.cpp.o"
+  "CMakeFiles/nvrhi_null.dir/src/null/null-commandlist.cpp.o.d"
+  "CMakeFiles/nvrhi_null.dir/src/null/null-device.cpp.o"
+  "CMakeFiles/nvrhi_null.dir/src/null/null-device.cpp.o.d"
+  "CMakeFiles/nvrhi_null.dir/src/null/null-resources.cpp.o"
+  "CMakeFiles/nvrhi_null.dir/src/null/null-resources.cpp.o.d"
+  "libnvrhi_null.a"
+  "libnvrhi_null.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nvrhi_null.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libnvrhi_null.a"
+)
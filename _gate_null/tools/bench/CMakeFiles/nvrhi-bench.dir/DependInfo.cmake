@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tools/bench/bench-devices.cpp" "tools/bench/CMakeFiles/nvrhi-bench.dir/bench-devices.cpp.o" "gcc" "tools/bench/CMakeFiles/nvrhi-bench.dir/bench-devices.cpp.o.d"
+  "/root/repo/tools/bench/bench-scenarios.cpp" "tools/bench/CMakeFiles/nvrhi-bench.dir/bench-scenarios.cpp.o" "gcc" "tools/bench/CMakeFiles/nvrhi-bench.dir/bench-scenarios.cpp.o.d"
+  "/root/repo/tools/bench/nvrhi-bench.cpp" "tools/bench/CMakeFiles/nvrhi-bench.dir/nvrhi-bench.cpp.o" "gcc" "tools/bench/CMakeFiles/nvrhi-bench.dir/nvrhi-bench.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_null/CMakeFiles/nvrhi_null.dir/DependInfo.cmake"
+  "/root/repo/_gate_null/CMakeFiles/nvrhi.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/nvrhi-bench.dir/bench-devices.cpp.o"
+  "CMakeFiles/nvrhi-bench.dir/bench-devices.cpp.o.d"
+  "CMakeFiles/nvrhi-bench.dir/bench-scenarios.cpp.o"
+  "CMakeFiles/nvrhi-bench.dir/bench-scenarios.cpp.o.d"
+  "CMakeFiles/nvrhi-bench.dir/nvrhi-bench.cpp.o"
+  "CMakeFiles/nvrhi-bench.dir/nvrhi-bench.cpp.o.d"
+  "nvrhi-bench"
+  "nvrhi-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/nvrhi-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <string>
+#include <vector>
+
+namespace nvrhi::capture
+{
+    struct CaptureLayerDesc
+    {
+        // Path of the capture file, which is created or overwritten.
+        std::string fileName;
+
+        // The capture file is grown in steps of at least this size, and each step is mapped into memory.
+        uint64_t mappingSize = 64 * 1024 * 1024;
+
+        CaptureLayerDesc& setFileName(const std::string& value) { fileName = value; return *this; }
+        constexpr CaptureLayerDesc& setMappingSize(uint64_t value) { mappingSize = value; return *this; }
+    };
+
+    // Creates a device that passes all calls to the underlying device and writes the calls that create objects,
+    // upload data, record commands and execute command lists into the capture file, to be replayed with replayCapture.
+    // Command list recordings are written when the command lists are closed. The data written through mapped buffers
+    // and staging textures is written when they are unmapped. The file is complete when the capture device is destroyed.
+    // Textures and buffers created from native objects are recreated from their descs on replay, and virtual ones
+    // get their own memory. Acceleration structures and their builds are captured, except TLAS builds from buffers
+    // other than the TLAS instance buffer. Other ray tracing objects and commands, meshlets, sampler feedback, heaps,
+    // tiled resources, async pipelines, shader libraries and timer query pools are passed through but not captured,
+    // and the replay skips the commands that use the objects they return.
+    // Returns nullptr if the capture file cannot be created.
+    NVRHI_API DeviceHandle createCaptureLayer(IDevice* underlyingDevice, const CaptureLayerDesc& desc);
+
+    struct ReplayDesc
+    {
+        // Measure the GPU time of every pass with timer queries. Passes on copy queues and in bundles are not measured.
+        bool measureGpuTime = true;
+
+        constexpr ReplayDesc& setMeasureGpuTime(bool value) { measureGpuTime = value; return *this; }
+    };
+
+    // A pass is the range of commands between a top-level beginMarker and the matching endMarker,
+    // and passes with the same marker name are accumulated together.
+    struct PassTiming
+    {
+        std::string name;
+        uint32_t count = 0;
+
+        // Total time spent recording the commands of the pass into the replay command lists
+        double cpuMilliseconds = 0.0;
+
+        // Total GPU time of the gpuCount measured instances of the pass
+        double gpuMilliseconds = 0.0;
+        uint32_t gpuCount = 0;
+    };
+
+    struct ReplayResult
+    {
+        uint64_t callsReplayed = 0;
+
+        // Calls that were not captured, or that use objects which were not captured
+        uint64_t callsSkipped = 0;
+        std::vector<std::string> unsupportedFunctions;
+
+        // In the order in which the passes first appear in the capture
+        std::vector<PassTiming> passes;
+
+        // Wall time of the whole replay, including object creation and waiting for the GPU
+        double totalMilliseconds = 0.0;
+    };
+
+    // Recreates the objects and replays the calls from a capture file on the given device, which may use any backend.
+    // The capture must have been written with the same NVRHI version. Returns false if the file cannot be read.
+    NVRHI_API bool replayCapture(IDevice* device, const std::string& fileName, const ReplayDesc& desc, ReplayResult& outResult);
+}
@@ -0,0 +1,91 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi
+{
+    typedef uint32_t BindlessIndex;
+    static constexpr BindlessIndex c_InvalidBindlessIndex = ~0u;
+
+    struct BindlessResourceRegistryDesc
+    {
+        // Layout of the descriptor table that holds the registered resources. maxCapacity is ignored.
+        // Use LayoutType::MutableSrvUavCbv to index the table through ResourceDescriptorHeap (SM 6.6) on DX12,
+        // in which case the shaders need to add getDescriptorHeapBase() to the indices.
+        BindlessLayoutDesc layoutDesc;
+
+        // Number of descriptors in the table. The table is allocated once and never grows,
+        // so that the indices stay valid and no descriptors are ever copied.
+        uint32_t capacity = 65536;
+
+        std::string debugName;
+
+                  BindlessResourceRegistryDesc& setLayoutDesc(const BindlessLayoutDesc& value) { layoutDesc = value; return *this; }
+        constexpr BindlessResourceRegistryDesc& setCapacity(uint32_t value) { capacity = value; return *this; }
+                  BindlessResourceRegistryDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Owns a bindless descriptor table and assigns stable indices to the resources registered in it.
+    // The indices are valid in all pipelines that use getBindingLayout(), for as long as the resource stays registered.
+    // Descriptor writes are queued and written by flush(), which must be called once per submission before
+    // executeCommandLists. Released indices may still be used by the command lists submitted after the next flush;
+    // they are reused once the GPU has finished those command lists.
+    // The registry keeps the registered resources alive until their indices are reused. All methods are thread-safe.
+    // flush() writes into a table that the command lists in flight use. On Vulkan, that requires
+    // vulkan::DeviceDesc::descriptorUpdateAfterBindSupported or enableDescriptorBuffer.
+    class IBindlessResourceRegistry : public IResource
+    {
+    public:
+        // Registers a resource and returns its index, or c_InvalidBindlessIndex if the table is full.
+        // The slot of the item is ignored.
+        virtual BindlessIndex registerResource(const BindingSetItem& item) = 0;
+
+        // Replaces the descriptor at a registered index. The previous descriptor must not be in use by the GPU.
+        virtual void updateResource(BindlessIndex index, const BindingSetItem& item) = 0;
+
+        // Returns the index to the registry; see the class comment for when it is reused.
+        virtual void releaseResource(BindlessIndex index) = 0;
+
+        // Writes the queued descriptors, and recycles the indices whose command lists have finished executing.
+        // The event used to track the released indices is signaled on the given queue.
+        virtual void flush(CommandQueue queue = CommandQueue::Graphics) = 0;
+
+        [[nodiscard]] virtual const BindlessResourceRegistryDesc& getDesc() const = 0;
+        [[nodiscard]] virtual IBindingLayout* getBindingLayout() const = 0;
+        [[nodiscard]] virtual IDescriptorTable* getDescriptorTable() const = 0;
+
+        // Returns the position of index 0 in the shader-visible descriptor heap, for ResourceDescriptorHeap indexing
+        [[nodiscard]] virtual uint32_t getDescriptorHeapBase() const = 0;
+
+        // Returns the number of indices that are registered or waiting to be reused
+        [[nodiscard]] virtual uint32_t getNumAllocatedIndices() const = 0;
+    };
+
+    typedef RefCountPtr<IBindlessResourceRegistry> BindlessResourceRegistryHandle;
+
+    // Returns nullptr if the layout or the descriptor table cannot be created.
+    NVRHI_API BindlessResourceRegistryHandle createBindlessResourceRegistry(IDevice* device, const BindlessResourceRegistryDesc& desc);
+
+} // namespace nvrhi
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::rt::cluster
+{
+    struct BuildContextDesc
+    {
+        // Upper bounds of the CLAS builds recorded with the context, with type ClasBuild or ClasInstantiateTemplates.
+        // The CLAS are always built with implicit destinations into the context's CLAS buffer, so the mode is ignored.
+        OperationParams clasParams;
+
+        // Upper bounds of the cluster BLAS builds from those CLAS, with type BlasBuild and implicit destinations
+        // into the context's BLAS buffer. A context with blasParams.maxArgCount = 0 only builds CLAS.
+        OperationParams blasParams;
+
+        std::string debugName;
+
+        BuildContextDesc& setClasParams(const OperationParams& value) { clasParams = value; return *this; }
+        BuildContextDesc& setBlasParams(const OperationParams& value) { blasParams = value; return *this; }
+        BuildContextDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    struct BuildContextInputs
+    {
+        // Indirect arguments of the CLAS build: IndirectTriangleClasArgs or IndirectInstantiateTemplateArgs,
+        // and an optional buffer with their count. Without the count buffer, clasParams.maxArgCount CLAS are built.
+        IBuffer* clasArgCountBuffer = nullptr;
+        uint64_t clasArgCountOffsetInBytes = 0;
+        IBuffer* clasArgsBuffer = nullptr;
+        uint64_t clasArgsOffsetInBytes = 0;
+
+        // Indirect arguments of the BLAS build, IndirectArgs with clusterAddresses pointing into the context's
+        // CLAS address buffer, and an optional count buffer. The BLAS build is skipped when blasArgsBuffer is NULL.
+        IBuffer* blasArgCountBuffer = nullptr;
+        uint64_t blasArgCountOffsetInBytes = 0;
+        IBuffer* blasArgsBuffer = nullptr;
+        uint64_t blasArgsOffsetInBytes = 0;
+
+        BuildContextInputs& setClasArgCountBuffer(IBuffer* value, uint64_t offset = 0) { clasArgCountBuffer = value; clasArgCountOffsetInBytes = offset; return *this; }
+        BuildContextInputs& setClasArgsBuffer(IBuffer* value, uint64_t offset = 0) { clasArgsBuffer = value; clasArgsOffsetInBytes = offset; return *this; }
+        BuildContextInputs& setBlasArgCountBuffer(IBuffer* value, uint64_t offset = 0) { blasArgCountBuffer = value; blasArgCountOffsetInBytes = offset; return *this; }
+        BuildContextInputs& setBlasArgsBuffer(IBuffer* value, uint64_t offset = 0) { blasArgsBuffer = value; blasArgsOffsetInBytes = offset; return *this; }
+    };
+
+    // Keeps the scratch, address, size and result buffers of repeated cluster builds, such as per-frame rebuilds of
+    // animated geometry. The buffers and the operation sizes are created once for the upper bounds given in the desc,
+    // so each build records its operations without size queries or scratch suballocations.
+    // The buffers keep their initial states, so the context can be used with any command list.
+    // Builds recorded into command lists that are in flight at the same time overwrite the same buffers,
+    // so a context should be used for one build at a time, or one context should be created per frame in flight.
+    class IBuildContext : public IResource
+    {
+    public:
+        // Records the CLAS build, and when the inputs have BLAS arguments, the BLAS build from the new CLAS,
+        // with the barriers between them. The two builds share the scratch buffer.
+        virtual void build(ICommandList* commandList, const BuildContextInputs& inputs) = 0;
+
+        [[nodiscard]] virtual const BuildContextDesc& getDesc() const = 0;
+        [[nodiscard]] virtual const OperationSizeInfo& getClasSizeInfo() const = 0;
+        [[nodiscard]] virtual const OperationSizeInfo& getBlasSizeInfo() const = 0;
+
+        // The CLAS data, and one 64-bit address and one 32-bit size per built CLAS, in argument order
+        [[nodiscard]] virtual IBuffer* getClasBuffer() = 0;
+        [[nodiscard]] virtual IBuffer* getClasAddressesBuffer() = 0;
+        [[nodiscard]] virtual IBuffer* getClasSizesBuffer() = 0;
+
+        // The same for the BLAS, or nullptr when the context only builds CLAS
+        [[nodiscard]] virtual IBuffer* getBlasBuffer() = 0;
+        [[nodiscard]] virtual IBuffer* getBlasAddressesBuffer() = 0;
+        [[nodiscard]] virtual IBuffer* getBlasSizesBuffer() = 0;
+
+        [[nodiscard]] virtual IBuffer* getScratchBuffer() = 0;
+    };
+
+    typedef RefCountPtr<IBuildContext> BuildContextHandle;
+
+    // Returns nullptr if the device doesn't support Feature::RayTracingClusters or the buffers cannot be created.
+    NVRHI_API BuildContextHandle createBuildContext(IDevice* device, const BuildContextDesc& desc);
+
+} // namespace nvrhi::rt::cluster
@@ -155,6 +155,22 @@ struct static_vector : private std::array<T, _max_elements>
         return back();
     }
 
+    bool operator ==(const static_vector& other) const
+    {
+        if (current_size != other.current_size)
+            return false;
+
+        for (size_type i = 0; i < current_size; i++)
+        {
+            if (!(*(data() + i) == *(other.data() + i)))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool operator !=(const static_vector& other) const { return !(*this == other); }
+
 private:
     size_type current_size = 0;
 };
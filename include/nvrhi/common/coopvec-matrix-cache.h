@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::coopvec
+{
+    struct MatrixCacheDesc
+    {
+        // Size of the buffers that the converted matrices are placed into.
+        // A matrix larger than a block gets a buffer of its own.
+        uint64_t blockSize = 16 * 1024 * 1024;
+
+        std::string debugName;
+
+        MatrixCacheDesc& setBlockSize(uint64_t value) { blockSize = value; return *this; }
+        MatrixCacheDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // A matrix to be converted from the layout and type in 'src' into an optimal stride matrix with dstType and dstLayout
+    struct MatrixConversionRequest
+    {
+        MatrixLayoutDesc src;
+        DataType dstType = DataType::Float16;
+        MatrixLayout dstLayout = MatrixLayout::InferencingOptimal;
+        uint32_t numRows = 0;
+        uint32_t numColumns = 0;
+
+        MatrixConversionRequest& setSrc(const MatrixLayoutDesc& value) { src = value; return *this; }
+        MatrixConversionRequest& setDstType(DataType value) { dstType = value; return *this; }
+        MatrixConversionRequest& setDstLayout(MatrixLayout value) { dstLayout = value; return *this; }
+        MatrixConversionRequest& setDimensions(uint32_t rows, uint32_t columns) { numRows = rows; numColumns = columns; return *this; }
+    };
+
+    struct ConvertedMatrix
+    {
+        // Location of the converted matrix, with a NULL buffer if the conversion failed.
+        // The buffer stays valid until the entry is invalidated or the cache is cleared or released.
+        MatrixLayoutDesc matrix;
+
+        // True if the conversion was recorded by this call, false if the matrix was found in the cache
+        bool converted = false;
+    };
+
+    // Keeps matrices converted from application-provided layouts into device-specific layouts, such as
+    // InferencingOptimal, so that loading the same network weights again doesn't convert them again.
+    // Entries are identified by the source buffer, its region, type, layout and stride, and the destination
+    // type, layout and dimensions; the cache holds a reference to each source buffer.
+    // The application must invalidate the entries of a source buffer when its contents change.
+    // The destination buffers keep the ShaderResource state, so the conversions can be recorded into a compute
+    // command list and run on the compute queue asynchronously with rendering. The command lists that use the
+    // converted matrices must then wait for it with IDevice::queueWaitForCommandList.
+    class IMatrixCache : public IResource
+    {
+    public:
+        // Fills one ConvertedMatrix per request. The sizes of the matrices that are not in the cache are queried
+        // with one IDevice::getCoopVecMatrixSizes call, and their conversions are recorded with one
+        // ICommandList::convertCoopVecMatrices call. The source buffers must be in a trackable state
+        // or in ResourceStates::ConvertCoopVecMatrixInput.
+        virtual void getConvertedMatrices(ICommandList* commandList, const MatrixConversionRequest* requests, size_t numRequests, ConvertedMatrix* outMatrices) = 0;
+
+        // Removes the entries converted from the given source buffer, and releases the destination buffers
+        // that have no entries left. The GPU may still read from those buffers through command lists in flight.
+        virtual void invalidate(IBuffer* srcBuffer) = 0;
+
+        // Removes all entries and releases all destination buffers
+        virtual void clear() = 0;
+
+        [[nodiscard]] virtual uint64_t getAllocatedBytes() const = 0;
+        [[nodiscard]] virtual const MatrixCacheDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<IMatrixCache> MatrixCacheHandle;
+
+    // Returns nullptr if the device doesn't support Feature::CooperativeVectorInferencing.
+    NVRHI_API MatrixCacheHandle createMatrixCache(IDevice* device, const MatrixCacheDesc& desc);
+
+} // namespace nvrhi::coopvec
@@ -0,0 +1,141 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <vector>
+
+namespace nvrhi
+{
+    static constexpr uint32_t c_InvalidGpuProfilerScope = ~0u;
+
+    struct GpuProfilerDesc
+    {
+        // The queue whose command lists record the scopes. Use one profiler per profiled queue.
+        CommandQueue queue = CommandQueue::Graphics;
+
+        // Scopes beyond this limit are not timed in that frame, but still emit their markers.
+        uint32_t maxScopesPerFrame = 1024;
+
+        // Number of frames that can be recorded or waiting for their results at the same time.
+        uint32_t maxFramesInFlight = 3;
+
+        // Calls beginMarker and endMarker for every scope, so that the scopes also show up
+        // in graphics debuggers and in the Aftermath marker tracking.
+        bool emitMarkers = true;
+
+        // Collects pipeline statistics for the outermost scopes of every command list, see Feature::PipelineStatisticsQueries.
+        // Only one pipeline statistics query can be active at a time, so nested scopes have no statistics of their own.
+        // Every frame in flight uses one query per outermost scope out of the device's pipeline statistics queries.
+        // Ignored when the device doesn't support the queries, or when the queue is not the graphics queue.
+        // On Vulkan, the queries finish the current render pass when the scopes begin and end.
+        bool collectPipelineStatistics = false;
+
+        std::string debugName;
+
+        GpuProfilerDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        GpuProfilerDesc& setMaxScopesPerFrame(uint32_t value) { maxScopesPerFrame = value; return *this; }
+        GpuProfilerDesc& setMaxFramesInFlight(uint32_t value) { maxFramesInFlight = value; return *this; }
+        GpuProfilerDesc& setEmitMarkers(bool value) { emitMarkers = value; return *this; }
+        GpuProfilerDesc& setCollectPipelineStatistics(bool value) { collectPipelineStatistics = value; return *this; }
+        GpuProfilerDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    struct GpuProfilerScope
+    {
+        std::string name;
+        CommandQueue queue = CommandQueue::Graphics;
+
+        // Index of the enclosing scope in the same frame and command list, or c_InvalidGpuProfilerScope
+        uint32_t parent = c_InvalidGpuProfilerScope;
+        uint32_t depth = 0;
+
+        // GPU timestamps in seconds, on the clock of the profiler's queue
+        double gpuStart = 0.0;
+        double gpuEnd = 0.0;
+
+        // CPU time in seconds when the scope was recorded, on the std::chrono::steady_clock clock
+        double cpuRecordTime = 0.0;
+
+        // Statistics of the commands in the scope, including its children, see GpuProfilerDesc::collectPipelineStatistics
+        bool hasPipelineStatistics = false;
+        PipelineStatistics pipelineStatistics;
+    };
+
+    // Records a tree of timed scopes for every frame, built on ITimerQueryPool.
+    // Typical use: beginFrame on the first command list of the frame, any number of begin/endScope pairs
+    // on command lists of the same queue, endFrame on the last command list, and getFrameScopes for
+    // a frame that was started maxFramesInFlight - 1 frames ago. Nothing in the profiler waits for the GPU.
+    // Scopes are nested per command list, and all scopes opened on a command list must be closed before it is closed.
+    class IGpuProfiler : public IResource
+    {
+    public:
+        // Starts a new frame and returns its index. The command list must be executed before all other
+        // command lists that record scopes for this frame.
+        virtual uint64_t beginFrame(ICommandList* commandList) = 0;
+
+        // Opens a scope in the current frame. The name is copied.
+        virtual void beginScope(ICommandList* commandList, const char* name) = 0;
+
+        // Closes the innermost open scope of the command list.
+        virtual void endScope(ICommandList* commandList) = 0;
+
+        // Finishes the current frame. The command list must be executed after all command lists
+        // that record scopes for this frame.
+        virtual void endFrame(ICommandList* commandList) = 0;
+
+        // Returns the scopes of the frame in the order they were opened, so that parents precede their children.
+        // Returns false without waiting if the frame hasn't finished executing on the GPU yet,
+        // or if it has been replaced by a newer frame.
+        virtual bool getFrameScopes(uint64_t frameIndex, std::vector<GpuProfilerScope>& outScopes) = 0;
+
+        [[nodiscard]] virtual const GpuProfilerDesc& getDesc() const = 0;
+        [[nodiscard]] virtual ITimerQueryPool* getTimerQueryPool() const = 0;
+    };
+
+    typedef RefCountPtr<IGpuProfiler> GpuProfilerHandle;
+
+    NVRHI_API GpuProfilerHandle createGpuProfiler(IDevice* device, const GpuProfilerDesc& desc);
+
+    // Automatic begin/end profiler scope for command list, similar to utils::ScopedMarker
+    class ScopedGpuProfilerScope
+    {
+    public:
+        IGpuProfiler* m_profiler;
+        ICommandList* m_commandList;
+
+        ScopedGpuProfilerScope(IGpuProfiler* profiler, ICommandList* commandList, const char* name)
+            : m_profiler(profiler)
+            , m_commandList(commandList)
+        {
+            m_profiler->beginScope(m_commandList, name);
+        }
+
+        ~ScopedGpuProfilerScope()
+        {
+            m_profiler->endScope(m_commandList);
+        }
+    };
+
+} // namespace nvrhi
@@ -25,6 +25,10 @@
 #include <cstdint>
 #include <cassert>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace nvrhi 
 {
     template<typename T> T align(T size, T alignment)
@@ -69,6 +73,32 @@ namespace nvrhi
         return uint32_t(hash) ^ (uint32_t(hash >> 32));
     }
 
+    // Returns the index of the lowest set bit in a non-zero value.
+    inline uint32_t countTrailingZeros(uint64_t value)
+    {
+        assert(value != 0);
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return uint32_t(index);
+#else
+        return uint32_t(__builtin_ctzll(value));
+#endif
+    }
+
+    // Returns the index of the highest set bit in a non-zero value, i.e. floor(log2(value)).
+    inline uint32_t findHighestSetBit(uint64_t value)
+    {
+        assert(value != 0);
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return uint32_t(index);
+#else
+        return 63u - uint32_t(__builtin_clzll(value));
+#endif
+    }
+
     // A type cast that is safer than static_cast in debug builds, and is a simple static_cast in release builds.
     // Used for downcasting various ISomething* pointers to their implementation classes in the backends.
     template <typename T, typename U>
@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi
+{
+    struct ReadbackPoolDesc
+    {
+        // Number of idle staging textures that are kept for reuse. The least recently used ones are released first.
+        uint32_t maxFreeTextures = 16;
+
+        // Number of update calls after which an idle staging texture is released. 0 means never.
+        uint32_t maxIdleUpdates = 60;
+
+        std::string debugName;
+
+        constexpr ReadbackPoolDesc& setMaxFreeTextures(uint32_t value) { maxFreeTextures = value; return *this; }
+        constexpr ReadbackPoolDesc& setMaxIdleUpdates(uint32_t value) { maxIdleUpdates = value; return *this; }
+                  ReadbackPoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // The result of IReadbackPool::readbackTextureAsync. Holds the staging texture with the copied slice
+    // until the handle is released, which returns the texture to the pool.
+    class ITextureReadback : public IResource
+    {
+    public:
+        // Returns true once the command list with the copy has been submitted through IReadbackPool::update
+        // and the GPU has finished executing it. Does not block.
+        [[nodiscard]] virtual bool isReady() = 0;
+
+        // Blocks until the copy has finished. Returns false if the readback has not been submitted yet.
+        virtual bool wait() = 0;
+
+        // Maps the copied slice for reading, or returns nullptr if the readback is not ready yet.
+        // Once isReady returns true, mapping does not wait for the GPU.
+        virtual const void* map(size_t* outRowPitch) = 0;
+        virtual void unmap() = 0;
+
+        // Returns the event query that is signalled when the copy retires, or nullptr before submission.
+        [[nodiscard]] virtual IEventQuery* getEventQuery() = 0;
+
+        [[nodiscard]] virtual IStagingTexture* getStagingTexture() = 0;
+
+        // Returns the source slice, resolved against the source texture.
+        [[nodiscard]] virtual const TextureSlice& getSourceSlice() const = 0;
+    };
+
+    typedef RefCountPtr<ITextureReadback> TextureReadbackHandle;
+
+    // Reads textures back to the CPU without stalling. Staging textures are recycled by format and size,
+    // and readiness is tracked with event queries instead of waiting in mapStagingTexture.
+    // Typical use: call readbackTextureAsync while recording a command list, execute it, call update,
+    // then poll the returned handles in later frames and map the ones that are ready.
+    class IReadbackPool : public IResource
+    {
+    public:
+        // Records a copy of the texture slice into a staging texture from the pool.
+        // Multisampled textures cannot be read back. Returns nullptr on failure.
+        virtual TextureReadbackHandle readbackTextureAsync(ICommandList* commandList, ITexture* source, const TextureSlice& slice = TextureSlice()) = 0;
+
+        // Marks the readbacks recorded since the previous call as submitted to the queue and releases the staging
+        // textures that have been idle for too long. Call after executing the command lists with those readbacks,
+        // on the thread that executes them.
+        virtual void update(CommandQueue queue = CommandQueue::Graphics) = 0;
+
+        // Releases all idle staging textures. Textures held by readback handles are returned to the pool later.
+        virtual void trim() = 0;
+
+        [[nodiscard]] virtual const ReadbackPoolDesc& getDesc() const = 0;
+
+        // Returns the number of idle staging textures kept by the pool.
+        [[nodiscard]] virtual size_t getNumFreeTextures() = 0;
+    };
+
+    typedef RefCountPtr<IReadbackPool> ReadbackPoolHandle;
+
+    NVRHI_API ReadbackPoolHandle createReadbackPool(IDevice* device, const ReadbackPoolDesc& desc);
+
+} // namespace nvrhi
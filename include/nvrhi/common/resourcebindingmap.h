@@ -86,9 +86,11 @@ namespace std
     {
         std::size_t operator()(nvrhi::TextureBindingKey const& s) const noexcept
         {
-            return std::hash<nvrhi::Format>()(s.format)
-                ^ std::hash<nvrhi::TextureSubresourceSet>()(s)
-                ^ std::hash<bool>()(s.isReadOnlyDSV);
+            // Combined rather than XORed: views of one texture differ in few bits, and XOR makes them collide
+            size_t hash = std::hash<nvrhi::TextureSubresourceSet>()(s);
+            nvrhi::hash_combine(hash, s.format);
+            nvrhi::hash_combine(hash, s.isReadOnlyDSV);
+            return hash;
         }
     };
 
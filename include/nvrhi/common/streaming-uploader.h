@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <functional>
+
+namespace nvrhi
+{
+    typedef uint64_t StreamingUploadId;
+    static constexpr StreamingUploadId c_InvalidStreamingUpload = 0;
+
+    // Uploads with higher priorities are recorded first, uploads with equal priorities in the order they were queued.
+    enum class StreamingPriority : uint8_t
+    {
+        Low,
+        Normal,
+        High,
+
+        Count
+    };
+
+    // Called by IStreamingUploader::update once the upload has been submitted and the consumer queue
+    // has been made to wait for it. The source data is no longer used at that point.
+    typedef std::function<void(StreamingUploadId)> StreamingUploadCallback;
+
+    struct StreamingUploaderDesc
+    {
+        // The queue that executes the uploads. If the device has no copy queue, the graphics queue is used instead.
+        CommandQueue queue = CommandQueue::Copy;
+
+        // The queue that uses the uploaded resources. It waits for the uploads submitted by every update call.
+        CommandQueue consumerQueue = CommandQueue::Graphics;
+
+        // Size of the persistent upload ring of each of the uploader's command lists,
+        // see CommandListParameters::uploadRingSize.
+        size_t stagingRingSize = 64 * 1024 * 1024;
+
+        // Number of bytes recorded between two update calls. An upload that is larger than the budget
+        // is recorded alone in a frame. 0 means no limit.
+        uint64_t frameBudgetBytes = 32 * 1024 * 1024;
+
+        // Number of bytes recorded into one command list before it's finished and queued for submission.
+        uint64_t maxBatchBytes = 8 * 1024 * 1024;
+
+        // Number of command lists that can be recorded and waiting for update at the same time.
+        uint32_t maxRecordedBatches = 2;
+
+        // Records the uploads on a thread owned by the uploader. If disabled, update records them.
+        bool useBackgroundThread = true;
+
+        std::string debugName;
+
+        StreamingUploaderDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        StreamingUploaderDesc& setConsumerQueue(CommandQueue value) { consumerQueue = value; return *this; }
+        StreamingUploaderDesc& setStagingRingSize(size_t value) { stagingRingSize = value; return *this; }
+        StreamingUploaderDesc& setFrameBudgetBytes(uint64_t value) { frameBudgetBytes = value; return *this; }
+        StreamingUploaderDesc& setMaxBatchBytes(uint64_t value) { maxBatchBytes = value; return *this; }
+        StreamingUploaderDesc& setMaxRecordedBatches(uint32_t value) { maxRecordedBatches = value; return *this; }
+        StreamingUploaderDesc& setUseBackgroundThread(bool value) { useBackgroundThread = value; return *this; }
+        StreamingUploaderDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Streams texture and buffer contents to the GPU on a dedicated queue, off the application's command lists.
+    // Uploads are queued from any thread, recorded with writeTexture / writeBuffer into the uploader's own command
+    // lists, and submitted by update, which also makes the consumer queue wait for them. Command lists executed
+    // on the consumer queue after update returns can use the uploaded resources.
+    // On the copy queue, resources with keepInitialState must have the initial state Common, because copy queues
+    // cannot transition resources into other states. Resources without keepInitialState are left in CopyDest.
+    class IStreamingUploader : public IResource
+    {
+    public:
+        // Queues an upload of some subresources of a texture. The data contains the subresources in the order
+        // of array slices, then mip levels, each with tightly packed rows of blocks and depth slices.
+        // The data must stay valid until the callback is called.
+        virtual StreamingUploadId enqueueTextureUpload(ITexture* texture, TextureSubresourceSet subresources, const void* data,
+            StreamingUploadCallback callback = nullptr, StreamingPriority priority = StreamingPriority::Normal) = 0;
+
+        // Queues an upload of a range of a buffer. The data must stay valid until the callback is called.
+        virtual StreamingUploadId enqueueBufferUpload(IBuffer* buffer, const void* data, uint64_t dataSize, uint64_t destOffsetBytes = 0,
+            StreamingUploadCallback callback = nullptr, StreamingPriority priority = StreamingPriority::Normal) = 0;
+
+        // Submits the command lists recorded since the previous call, makes the consumer queue wait for them,
+        // calls the callbacks of their uploads and starts a new frame budget. Call once per frame,
+        // on the thread that executes the application's command lists.
+        virtual void update() = 0;
+
+        // Records and submits all queued uploads regardless of the frame budget, like update.
+        virtual void flush() = 0;
+
+        // Returns the number of uploads that have been queued but not submitted yet.
+        [[nodiscard]] virtual size_t getNumPendingUploads() = 0;
+
+        [[nodiscard]] virtual const StreamingUploaderDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<IStreamingUploader> StreamingUploaderHandle;
+
+    NVRHI_API StreamingUploaderHandle createStreamingUploader(IDevice* device, const StreamingUploaderDesc& desc);
+
+} // namespace nvrhi
@@ -0,0 +1,163 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi
+{
+    struct TileHeapPoolDesc
+    {
+        // Size of one tile. Tiles of D3D12 tiled resources and of most Vulkan sparse images are 64 KB.
+        uint64_t tileSizeInBytes = 64 * 1024;
+
+        // Number of tiles in each heap created by the pool. Larger contiguous allocations get a heap of their own.
+        uint32_t tilesPerHeap = 256;
+
+        // Maximum number of heaps that the pool creates. 0 means no limit.
+        uint32_t maxHeaps = 0;
+
+        std::string debugName;
+
+        constexpr TileHeapPoolDesc& setTileSizeInBytes(uint64_t value) { tileSizeInBytes = value; return *this; }
+        constexpr TileHeapPoolDesc& setTilesPerHeap(uint32_t value) { tilesPerHeap = value; return *this; }
+        constexpr TileHeapPoolDesc& setMaxHeaps(uint32_t value) { maxHeaps = value; return *this; }
+                  TileHeapPoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // A range of contiguous tiles in one of the heaps of a tile heap pool.
+    struct TileAllocation
+    {
+        IHeap* heap = nullptr;
+        uint64_t byteOffset = 0;
+        uint32_t numTiles = 0;
+
+        [[nodiscard]] bool valid() const { return heap != nullptr; }
+    };
+
+    // Allocates tiles for tiled textures from a set of device-local heaps.
+    // The pool can be shared by several tiled texture streamers. Tiles released by one streamer can be mapped
+    // by another one right away, as long as all mapping updates and the work using the textures run on the same queue.
+    class ITileHeapPool : public IResource
+    {
+    public:
+        // Allocates contiguous tiles, creating a heap if no existing one has enough free space.
+        // Returns an invalid allocation if the pool has reached maxHeaps.
+        virtual TileAllocation allocateTiles(uint32_t numTiles) = 0;
+        virtual void releaseTiles(const TileAllocation& allocation) = 0;
+
+        // Releases the heaps that have no allocated tiles.
+        // Only call when the GPU has finished the work that used the tiles released from those heaps.
+        virtual void trim() = 0;
+
+        [[nodiscard]] virtual const TileHeapPoolDesc& getDesc() const = 0;
+        [[nodiscard]] virtual uint32_t getNumHeaps() = 0;
+        [[nodiscard]] virtual uint64_t getNumAllocatedTiles() = 0;
+        [[nodiscard]] virtual uint64_t getCapacityInTiles() = 0;
+    };
+
+    typedef RefCountPtr<ITileHeapPool> TileHeapPoolHandle;
+
+    NVRHI_API TileHeapPoolHandle createTileHeapPool(IDevice* device, const TileHeapPoolDesc& desc);
+
+    struct TiledTextureStreamerDesc
+    {
+        // A texture created with isTiled set.
+        ITexture* texture = nullptr;
+
+        // The pool that provides the tiles. It must use the tile size of the texture.
+        ITileHeapPool* heapPool = nullptr;
+
+        // Optional sampler feedback texture paired with 'texture', see ITiledTextureStreamer::resolveFeedback.
+        ISamplerFeedbackTexture* feedbackTexture = nullptr;
+
+        // Maps the packed mips of every array slice on the first update, so that coarse data is always available.
+        bool mapPackedMips = true;
+
+        // Number of feedback resolves that can be in flight at the same time.
+        uint32_t maxFeedbackLatency = 3;
+
+        // Number of processed feedbacks without a request after which a mapped tile is evicted. 0 means never.
+        uint32_t maxIdleFeedbacks = 30;
+
+        // Maximum number of tiles mapped by one update call, to spread the uploads over several frames. 0 means no limit.
+        uint32_t maxTilesPerUpdate = 0;
+
+        std::string debugName;
+
+        constexpr TiledTextureStreamerDesc& setTexture(ITexture* value) { texture = value; return *this; }
+        constexpr TiledTextureStreamerDesc& setHeapPool(ITileHeapPool* value) { heapPool = value; return *this; }
+        constexpr TiledTextureStreamerDesc& setFeedbackTexture(ISamplerFeedbackTexture* value) { feedbackTexture = value; return *this; }
+        constexpr TiledTextureStreamerDesc& setMapPackedMips(bool value) { mapPackedMips = value; return *this; }
+        constexpr TiledTextureStreamerDesc& setMaxFeedbackLatency(uint32_t value) { maxFeedbackLatency = value; return *this; }
+        constexpr TiledTextureStreamerDesc& setMaxIdleFeedbacks(uint32_t value) { maxIdleFeedbacks = value; return *this; }
+        constexpr TiledTextureStreamerDesc& setMaxTilesPerUpdate(uint32_t value) { maxTilesPerUpdate = value; return *this; }
+                  TiledTextureStreamerDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Manages the tile mappings of one tiled texture. Tiles are requested and evicted on the CPU or through
+    // sampler feedback, and the resulting mapping changes are submitted once per update call, in a single
+    // updateTextureTileMappings call that groups the tiles by heap.
+    // Tile coordinates are in tiles, within the standard (not packed) mip levels.
+    // Destroying the streamer returns its tiles to the pool without unmapping them, so the texture must not be used afterwards.
+    class ITiledTextureStreamer : public IResource
+    {
+    public:
+        // Queues the tile for mapping by the next update call. Returns false if the coordinate is out of range.
+        virtual bool requestTile(const TiledTextureCoordinate& tile) = 0;
+
+        // Queues the tile for unmapping by the next update call. Its contents are lost.
+        virtual void evictTile(const TiledTextureCoordinate& tile) = 0;
+
+        // Returns true if the tile has been mapped by an update call and is not waiting to be unmapped.
+        [[nodiscard]] virtual bool isTileMapped(const TiledTextureCoordinate& tile) = 0;
+
+        // Records the decoding of the feedback texture into a readback buffer, followed by a clear of the feedback texture,
+        // so that the next frames accumulate new feedback. Only the first array slice is decoded.
+        // Returns false if there is no feedback texture or if maxFeedbackLatency resolves are already in flight.
+        virtual bool resolveFeedback(ICommandList* commandList) = 0;
+
+        // Call once per frame, after executing the command lists with the feedback resolves, on the thread that executes them.
+        // - Marks the feedback resolves recorded since the previous call as submitted to the queue;
+        // - Turns the completed feedback into tile requests: every tile of the requested and coarser standard mips
+        //   covering a mip region is requested, and the tiles not requested for maxIdleFeedbacks feedbacks are evicted;
+        // - Allocates the tiles and submits the mapping changes on the queue.
+        // The newly mapped tiles are appended to outMappedTiles; their contents are undefined until the application fills them.
+        virtual void update(CommandQueue queue = CommandQueue::Graphics, std::vector<TiledTextureCoordinate>* outMappedTiles = nullptr) = 0;
+
+        [[nodiscard]] virtual const TiledTextureStreamerDesc& getDesc() const = 0;
+        [[nodiscard]] virtual const PackedMipDesc& getPackedMipDesc() const = 0;
+        [[nodiscard]] virtual const TileShape& getTileShape() const = 0;
+
+        // Returns the size of a standard mip level in tiles, or an empty tiling for packed mips.
+        [[nodiscard]] virtual SubresourceTiling getMipTiling(uint32_t mipLevel) const = 0;
+
+        // Returns the number of tiles held by the streamer, including the packed mips.
+        [[nodiscard]] virtual uint32_t getNumMappedTiles() = 0;
+    };
+
+    typedef RefCountPtr<ITiledTextureStreamer> TiledTextureStreamerHandle;
+
+    NVRHI_API TiledTextureStreamerHandle createTiledTextureStreamer(IDevice* device, const TiledTextureStreamerDesc& desc);
+
+} // namespace nvrhi
@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi
+{
+    typedef uint32_t TransientResourceId;
+    static constexpr TransientResourceId c_InvalidTransientResource = ~0u;
+
+    struct TransientResourcePoolDesc
+    {
+        // Type of the heap that holds all resources of the pool
+        HeapType heapType = HeapType::DeviceLocal;
+        std::string debugName;
+
+        constexpr TransientResourcePoolDesc& setHeapType(HeapType value) { heapType = value; return *this; }
+                  TransientResourcePoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Places short-lived textures and buffers into a single heap, so that resources with non-overlapping
+    // lifetimes share memory. The lifetimes are expressed as ranges of pass indices within a frame.
+    // Typical use: declare all resources, compile the pool once, then call beginPass for every pass of every frame.
+    // The pool is built on IDevice::createHeap and bind[Texture|Buffer]Memory, so it works on DX12 and Vulkan.
+    // Note that on DX12 devices with resource heap tier 1, only render targets and depth-stencil textures
+    // can be placed into heaps.
+    class ITransientResourcePool : public IResource
+    {
+    public:
+        // Declares a texture that is used by passes firstPass through lastPass, inclusive.
+        // The texture is created by compile(); its initial contents are undefined in every frame.
+        // Render targets that alias other resources are discarded by beginPass(), so they can be used right away,
+        // but loading their contents is meaningless - clear them or use AttachmentLoadOp::DontCare.
+        virtual TransientResourceId declareTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass) = 0;
+
+        // Declares a buffer that is used by passes firstPass through lastPass, inclusive.
+        virtual TransientResourceId declareBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass) = 0;
+
+        // Creates the declared resources, assigns them overlapping heap ranges where their lifetimes allow it,
+        // creates the heap and binds the resources to it. Returns false if any of these steps failed.
+        virtual bool compile() = 0;
+
+        // Releases the heap and all resources, and removes all declarations.
+        // The resources may still be referenced by command lists in flight, which keep them alive.
+        virtual void reset() = 0;
+
+        // Returns the resources created by compile(), or nullptr if the id refers to a different resource type.
+        virtual ITexture* getTexture(TransientResourceId id) = 0;
+        virtual IBuffer* getBuffer(TransientResourceId id) = 0;
+
+        // Places the aliasing barriers for the resources whose lifetimes begin at the given pass.
+        // Must be called before the first use of those resources in every frame.
+        virtual void beginPass(ICommandList* commandList, uint32_t passIndex) = 0;
+
+        [[nodiscard]] virtual const TransientResourcePoolDesc& getDesc() const = 0;
+
+        // Returns the size of the heap created by compile()
+        [[nodiscard]] virtual uint64_t getHeapSize() const = 0;
+
+        // Returns the total size of the resources, as if they didn't share memory
+        [[nodiscard]] virtual uint64_t getTotalResourceSize() const = 0;
+    };
+
+    typedef RefCountPtr<ITransientResourcePool> TransientResourcePoolHandle;
+
+    NVRHI_API TransientResourcePoolHandle createTransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc);
+
+} // namespace nvrhi
@@ -42,6 +42,25 @@ namespace nvrhi::d3d11
         IMessageCallback* messageCallback = nullptr;
         ID3D11DeviceContext* context = nullptr;
         bool aftermathEnabled = false;
+
+        // Receives the allocations counted by IDevice::getMemoryStatistics
+        IMemoryAllocationCallback* memoryAllocationCallback = nullptr;
+
+        // Number of threads that compile the pipelines created with IDevice::create*PipelineAsync, started on first use.
+        // 0 selects half of the hardware threads.
+        uint32_t pipelineCompilerThreadCount = 0;
+
+        // Return the existing pipeline, sampler or shader specialization when one is created again with equal parameters.
+        // Shaders and layouts are compared by identity; unused entries are released by runGarbageCollection.
+        bool enableObjectDeduplication = false;
+
+        // Resolves IDevice::createShaderSpecialization to precompiled shader variants, see IShaderPermutationProvider.
+        // Shader specializations are not supported without a provider.
+        IShaderPermutationProvider* shaderPermutationProvider = nullptr;
+
+        // Optional directory where the variants returned by shaderPermutationProvider are stored, so that later runs
+        // load them from there instead of calling the provider. The directory must exist.
+        std::string shaderPermutationCacheDirectory;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
@@ -92,6 +92,27 @@ namespace nvrhi::d3d12
         Sampler
     };
 
+    struct PlacedResourceStatistics
+    {
+        // Shared heaps created for placed resources
+        uint32_t heapCount = 0;
+        uint64_t heapBytes = 0;
+
+        // Resources currently placed in the shared heaps, and the heap space they occupy including alignment
+        uint32_t resourceCount = 0;
+        uint64_t resourceBytes = 0;
+
+        // Largest resourceBytes value observed so far
+        uint64_t peakResourceBytes = 0;
+
+        // Shared resources that small buffers are packed into, see DeviceDesc::enableSmallBufferPacking,
+        // and the buffers currently packed into them with the space they occupy including size class rounding
+        uint32_t packedBlockCount = 0;
+        uint64_t packedBlockBytes = 0;
+        uint32_t packedBufferCount = 0;
+        uint64_t packedBufferBytes = 0;
+    };
+
     class IDevice : public nvrhi::IDevice
     {
     public:
@@ -100,6 +121,10 @@ namespace nvrhi::d3d12
         virtual GraphicsPipelineHandle createHandleForNativeGraphicsPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const GraphicsPipelineDesc& desc, const FramebufferInfo& framebufferInfo) = 0;
         virtual MeshletPipelineHandle createHandleForNativeMeshletPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const MeshletPipelineDesc& desc, const FramebufferInfo& framebufferInfo) = 0;
         [[nodiscard]] virtual IDescriptorHeap* getDescriptorHeap(DescriptorHeapType heapType) = 0;
+
+        // Returns the statistics of the shared heaps used for placed resources, see DeviceDesc::enablePlacedResources,
+        // and of the shared resources that small buffers are packed into, see DeviceDesc::enableSmallBufferPacking
+        [[nodiscard]] virtual PlacedResourceStatistics getPlacedResourceStatistics() = 0;
     };
 
     typedef RefCountPtr<IDevice> DeviceHandle;
@@ -117,17 +142,96 @@ namespace nvrhi::d3d12
         uint32_t shaderResourceViewHeapSize = 16384;
         uint32_t samplerHeapSize = 1024;
         uint32_t maxTimerQueries = 256;
+        uint32_t maxOcclusionQueries = 256;
+        uint32_t maxPipelineStatisticsQueries = 64;
+
+        // Number of BLAS'es created with AllowCompaction that can wait for compaction at the same time,
+        // see ICommandList::compactBottomLevelAccelStructs. Not used when NVRHI is built with RTXMU.
+        // The same number of OMMs can wait for ICommandList::compactOpacityMicromaps.
+        uint32_t maxCompactedSizeQueries = 1024;
 
         // If enabled and the device has the capability,
         // create RootSignatures with D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED 
         // and D3D12_ROOT_SIGNATURE_FLAG_SAMPLER_HEAP_DIRECTLY_INDEXED
         bool enableHeapDirectlyIndexed = false;
 
+        // If enabled and the device supports them, use Enhanced Barriers (ID3D12GraphicsCommandList7::Barrier)
+        // for the state transitions instead of the legacy resource barriers. Not used on copy queues.
+        bool enableEnhancedBarriers = false;
+
+        // If enabled, buffers and textures that are not render targets, depth-stencil, MSAA or shared resources
+        // are created as placed resources in shared heaps instead of committed resources.
+        // Unlike committed resources, the contents of placed resources are undefined after creation.
+        // Small textures are placed at 4 KB alignment, buffers always use the 64 KB alignment that D3D12 requires.
+        bool enablePlacedResources = false;
+
+        // Size of the shared heaps used for placed resources. Resources larger than half of it are still committed.
+        uint64_t placedResourceHeapSize = 64 * 1024 * 1024;
+
+        // If enabled, buffers of up to 32 KB that are in the default heap and cannot have UAVs are packed into shared
+        // 64 KB ID3D12Resources, in power-of-2 size classes starting at 256 bytes, instead of getting 64 KB each.
+        // Shared, virtual, tiled, indirect argument, shader table and acceleration structure buffers are not packed.
+        // The buffers packed into one resource share its state, so a transition of one of them transitions all,
+        // and setPermanentBufferState only transitions them. For packed buffers, getNativeObject returns the
+        // shared resource, and the buffer starts at getGpuVirtualAddress() in it.
+        bool enableSmallBufferPacking = false;
+
+        // If enabled, pipeline state objects are stored in an ID3D12PipelineLibrary1 keyed by a hash of their
+        // description, and IDevice::getPipelineCacheData can serialize the library for use in a later run.
+        // Implied by passing initialPipelineCacheData.
+        bool enablePipelineLibrary = false;
+
+        // Optional contents of a pipeline library previously returned by IDevice::getPipelineCacheData.
+        // A blob written by a different adapter or driver version is ignored with a warning.
+        // The data is copied, so it may be freed after createDevice returns.
+        const void* initialPipelineCacheData = nullptr;
+        size_t initialPipelineCacheDataSize = 0;
+
+        // Number of threads that compile the pipelines created with IDevice::create*PipelineAsync, started on first use.
+        // 0 selects half of the hardware threads.
+        uint32_t pipelineCompilerThreadCount = 0;
+
+        // Return the existing pipeline, sampler or shader specialization when one is created again with equal parameters.
+        // Shaders and layouts are compared by identity; unused entries are released by runGarbageCollection.
+        bool enableObjectDeduplication = false;
+
+        // Resolves IDevice::createShaderSpecialization to precompiled shader variants, see IShaderPermutationProvider.
+        // Shader specializations are not supported without a provider.
+        IShaderPermutationProvider* shaderPermutationProvider = nullptr;
+
+        // Optional directory where the variants returned by shaderPermutationProvider are stored, so that later runs
+        // load them from there instead of calling the provider. The directory must exist.
+        std::string shaderPermutationCacheDirectory;
+
+        // If enabled, graphics and meshlet rendering is recorded in render passes (ID3D12GraphicsCommandList4::BeginRenderPass),
+        // with the beginning and ending accesses derived from the framebuffer attachment load and store ops.
+        // A pass begins when setGraphicsState or setMeshletState binds a framebuffer and ends when another framebuffer
+        // is bound or when other commands, such as copies, dispatches or barriers, are recorded, like on Vulkan.
+        bool enableRenderPasses = false;
+
         bool aftermathEnabled = false;
 
         // Enable logging the buffer lifetime to IMessageCallback
         // Useful for debugging resource lifetimes
         bool logBufferLifetime = false;
+
+        // If enabled, the device tracks which committed resources and heaps in the default heap type are used
+        // by the submitted command lists. When runGarbageCollection finds that the local video memory usage
+        // exceeds the budget, the least recently used ones with completed uses are evicted, lowest residency
+        // priority first, and they are made resident again by the next executeCommandLists that uses them.
+        // Acceleration structures are never evicted. Resources that are only used through bindless descriptor tables
+        // are not tracked either; give them or their heaps ResidencyPriority::Maximum.
+        bool enableResidencyManagement = false;
+
+        // Called by runGarbageCollection when the local video memory usage exceeds the budget
+        IMemoryBudgetCallback* budgetCallback = nullptr;
+
+        // Receives the allocations counted by IDevice::getMemoryStatistics
+        IMemoryAllocationCallback* memoryAllocationCallback = nullptr;
+
+        // Object types whose D3D12 resources and descriptors are released from runGarbageCollection
+        // rather than in the thread that releases the last reference.
+        DeferredDestructionFlags deferredDestruction = DeferredDestructionFlags::None;
     };
 
     NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
@@ -0,0 +1,53 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+namespace nvrhi::ObjectTypes
+{
+    constexpr ObjectType Nvrhi_Null_Device = 0x00040101;
+};
+
+namespace nvrhi::null
+{
+    // The null device implements the NVRHI interfaces without a GPU: resources have no memory except where the CPU
+    // can see it, and command lists record nothing. Everything that NVRHI itself does on the CPU is still done,
+    // such as resource state tracking, upload buffer sub-allocation, command list versioning and resource lifetime
+    // tracking, so the device can be used to measure the CPU overhead of NVRHI separately from the driver.
+    // Command lists complete as soon as they are executed. Shader bytecode is not interpreted.
+    struct DeviceDesc
+    {
+        IMessageCallback* messageCallback = nullptr;
+
+        // Receives the allocations counted by IDevice::getMemoryStatistics. Buffers and textures are counted
+        // with the sizes of their data, although the CPU only stores the contents of the mappable buffers.
+        IMemoryAllocationCallback* memoryAllocationCallback = nullptr;
+
+        // Number of threads that compile the pipelines created with IDevice::create*PipelineAsync, started on first use.
+        // 0 selects half of the hardware threads.
+        uint32_t pipelineCompilerThreadCount = 0;
+    };
+
+    NVRHI_API DeviceHandle createDevice(const DeviceDesc& desc);
+}
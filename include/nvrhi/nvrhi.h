@@ -64,7 +64,7 @@ namespace nvrhi
 {
     // Version of the public API provided by NVRHI.
     // Increment this when any changes to the API are made.
-    static constexpr uint32_t c_HeaderVersion = 22;
+    static constexpr uint32_t c_HeaderVersion = 75;
 
     // Verifies that the version of the implementation matches the version of the header.
     // Returns true if they match. Use this when initializing apps using NVRHI as a shared library.
@@ -77,8 +77,10 @@ namespace nvrhi
     static constexpr uint32_t c_MaxBindlessRegisterSpaces = 16;
     static constexpr uint32_t c_MaxVolatileConstantBuffersPerLayout = 6;
     static constexpr uint32_t c_MaxVolatileConstantBuffers = 32;
+    static constexpr uint32_t c_MaxInlineVolatileConstantBufferSize = 64; // see BindingLayoutItem::InlineVolatileConstantBuffer
     static constexpr uint32_t c_MaxPushConstantSize = 128; // D3D12: root signature is 256 bytes max., Vulkan: 128 bytes of push constants guaranteed
     static constexpr uint32_t c_ConstantBufferOffsetSizeAlignment = 256; // Partially bound constant buffers must have offsets aligned to this and sizes multiple of this
+    static constexpr uint32_t c_TiledBufferTileSize = 65536; // Granularity of the tile mappings of tiled buffers, see IDevice::updateBufferTileMappings
 
     //////////////////////////////////////////////////////////////////////////
     // Basic Types
@@ -154,7 +156,8 @@ namespace nvrhi
     {
         D3D11,
         D3D12,
-        VULKAN
+        VULKAN,
+        NULL_DEVICE // see nvrhi/null.h
     };
 
     enum class Format : uint8_t
@@ -315,12 +318,81 @@ namespace nvrhi
 
     typedef RefCountPtr<IHeap> HeapHandle;
 
+    // How important it is to keep a resource in video memory when the memory budget is exceeded.
+    // Resources with the Maximum priority are never evicted by the residency manager.
+    enum class ResidencyPriority : uint8_t
+    {
+        Minimum,
+        Low,
+        Normal,
+        High,
+        Maximum
+    };
+
+    // Video memory budget and usage of the process, as reported by the OS or driver
+    struct VideoMemoryBudget
+    {
+        // Device-local memory
+        uint64_t localBudget = 0;
+        uint64_t localUsage = 0;
+
+        // System memory that is accessible to the device
+        uint64_t nonLocalBudget = 0;
+        uint64_t nonLocalUsage = 0;
+    };
+
     struct MemoryRequirements
     {
         uint64_t size = 0;
         uint64_t alignment = 0;
     };
 
+    // Kinds of memory allocated by NVRHI, see IDevice::getMemoryStatistics
+    enum class MemoryCategory : uint8_t
+    {
+        // Buffers and textures owned by NVRHI, except the resources placed in application heaps and the ones
+        // created from native objects. Volatile buffers are counted here on Vulkan and DX11, where they have
+        // memory of their own, and in UploadChunks on DX12.
+        Buffers,
+        Textures,
+
+        // Chunks and rings used by command lists for uploads and volatile buffer versions
+        UploadChunks,
+
+        // Chunks used by command lists for acceleration structure and micromap build scratch memory
+        ScratchChunks,
+
+        // Descriptor heaps and descriptor buffers owned by the device
+        DescriptorHeaps,
+
+        Count
+    };
+
+    struct MemoryCategoryStatistics
+    {
+        // Total size of the live allocations
+        uint64_t allocatedBytes = 0;
+
+        // Part of allocatedBytes that holds data. Buffers and textures are fully used; the chunks of a command list
+        // and the descriptor heaps can be partially used. The device reports 0 for chunks, which are only
+        // known to be used by their command lists.
+        uint64_t usedBytes = 0;
+
+        // Highest value of allocatedBytes since the device or command list was created
+        uint64_t peakAllocatedBytes = 0;
+
+        // Number of live allocations, e.g. chunks or resources
+        uint32_t allocationCount = 0;
+    };
+
+    struct MemoryStatistics
+    {
+        MemoryCategoryStatistics categories[size_t(MemoryCategory::Count)];
+
+        [[nodiscard]] const MemoryCategoryStatistics& get(MemoryCategory category) const { return categories[size_t(category)]; }
+        [[nodiscard]] MemoryCategoryStatistics& get(MemoryCategory category) { return categories[size_t(category)]; }
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Texture
     //////////////////////////////////////////////////////////////////////////
@@ -345,6 +417,18 @@ namespace nvrhi
         Read,
         Write
     };
+
+    enum class MapBufferFlags : uint8_t
+    {
+        None                = 0,
+
+        // Don't wait for the command lists that used the buffer to finish executing.
+        // The application guarantees that it doesn't access any part of the buffer that is still in use by the GPU.
+        // D3D11: uses D3D11_MAP_WRITE_NO_OVERWRITE for writes
+        NoOverwrite         = 0x01
+    };
+
+    NVRHI_ENUM_CLASS_FLAG_OPERATORS(MapBufferFlags)
     
     enum class ResourceStates : uint32_t
     {
@@ -429,6 +513,14 @@ namespace nvrhi
         bool isVirtual = false;
         bool isTiled = false;
 
+        // Indicates that the texture is only used as a framebuffer attachment whose contents don't outlive the passes
+        // that render to it, such as a depth buffer with AttachmentStoreOp::Discard. On Vulkan, the image is created
+        // with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and placed into lazily allocated memory where available,
+        // which can leave it without any backing memory on tiled GPUs. Requires isRenderTarget = true and
+        // isShaderResource = isUAV = false. The texture cannot be copied, cleared, written or resolved; use the
+        // attachment load ops to initialize it.
+        bool isTransientAttachment = false;
+
         Color clearValue;
         bool useClearValue = false;
 
@@ -453,6 +545,7 @@ namespace nvrhi
         constexpr TextureDesc& setIsUAV(bool value) { isUAV = value; return *this; }
         constexpr TextureDesc& setIsTypeless(bool value) { isTypeless = value; return *this; }
         constexpr TextureDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+        constexpr TextureDesc& setIsTransientAttachment(bool value) { isTransientAttachment = value; return *this; }
         constexpr TextureDesc& setClearValue(const Color& value) { clearValue = value; useClearValue = true; return *this; }
         constexpr TextureDesc& setUseClearValue(bool value) { useClearValue = value; return *this; }
         constexpr TextureDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
@@ -494,6 +587,20 @@ namespace nvrhi
         constexpr TextureSlice& setArraySlice(ArraySlice slice) { arraySlice = slice; return *this; }
     };
 
+    // Source data of one subresource for ICommandList::writeTextureSubresources, with the same layout as writeTexture.
+    struct TextureSubresourceData
+    {
+        MipLevel mipLevel = 0;
+        ArraySlice arraySlice = 0;
+        const void* data = nullptr;
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+
+        constexpr TextureSubresourceData& setMipLevel(MipLevel level) { mipLevel = level; return *this; }
+        constexpr TextureSubresourceData& setArraySlice(ArraySlice slice) { arraySlice = slice; return *this; }
+        constexpr TextureSubresourceData& setData(const void* value, size_t row, size_t depth = 0) { data = value; rowPitch = row; depthPitch = depth; return *this; }
+    };
+
     struct TextureSubresourceSet
     {
         static constexpr MipLevel AllMipLevels = MipLevel(-1);
@@ -582,6 +689,21 @@ namespace nvrhi
         IHeap* heap = nullptr;
     };
 
+    // Maps a range of a tiled buffer to memory in a heap, or unmaps it when 'heap' is null.
+    // All offsets and sizes must be multiples of c_TiledBufferTileSize.
+    struct BufferTilesMapping
+    {
+        uint64_t bufferOffset = 0;
+        uint64_t byteSize = 0;
+        IHeap* heap = nullptr;
+        uint64_t heapOffset = 0;
+
+        constexpr BufferTilesMapping& setBufferOffset(uint64_t value) { bufferOffset = value; return *this; }
+        constexpr BufferTilesMapping& setByteSize(uint64_t value) { byteSize = value; return *this; }
+        constexpr BufferTilesMapping& setHeap(IHeap* value) { heap = value; return *this; }
+        constexpr BufferTilesMapping& setHeapOffset(uint64_t value) { heapOffset = value; return *this; }
+    };
+
     struct PackedMipDesc
     {
         uint32_t numStandardMips = 0;
@@ -692,6 +814,14 @@ namespace nvrhi
         // On DX12, the buffer resource is created at the time of memory binding.
         bool isVirtual = false;
 
+        // Indicates that the buffer is created with an address range but no backing memory,
+        // and ranges of c_TiledBufferTileSize bytes are mapped to heaps later using updateBufferTileMappings.
+        // Tiled buffers cannot have CPU access or be shared.
+        // - DX12: Maps to a reserved resource.
+        // - Vulkan: Maps to a buffer with sparse binding and residency; requires the sparseResidencyBuffer feature.
+        // - DX11: Unsupported.
+        bool isTiled = false;
+
         ResourceStates initialState = ResourceStates::Common;
 
         // see TextureDesc::keepInitialState
@@ -718,6 +848,7 @@ namespace nvrhi
         constexpr BufferDesc& setIsShaderBindingTable(bool value) { isShaderBindingTable = value; return *this; }
         constexpr BufferDesc& setIsVolatile(bool value) { isVolatile = value; return *this; }
         constexpr BufferDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+        constexpr BufferDesc& setIsTiled(bool value) { isTiled = value; return *this; }
         constexpr BufferDesc& setInitialState(ResourceStates value) { initialState = value; return *this; }
         constexpr BufferDesc& setKeepInitialState(bool value) { keepInitialState = value; return *this; }
         constexpr BufferDesc& setCpuAccess(CpuAccessMode value) { cpuAccess = value; return *this; }
@@ -1110,6 +1241,35 @@ namespace nvrhi
         constexpr RasterState& enableQuadFill() { quadFillEnable = true; return *this; }
         constexpr RasterState& disableQuadFill() { quadFillEnable = false; return *this; }
         constexpr RasterState& setSamplePositions(const char* x, const char* y, int count) { for (int i = 0; i < count; i++) { samplePositionsX[i] = x[i]; samplePositionsY[i] = y[i]; } return *this; }
+
+        constexpr bool operator ==(const RasterState& other) const
+        {
+            if (fillMode != other.fillMode
+                || cullMode != other.cullMode
+                || frontCounterClockwise != other.frontCounterClockwise
+                || depthClipEnable != other.depthClipEnable
+                || scissorEnable != other.scissorEnable
+                || multisampleEnable != other.multisampleEnable
+                || antialiasedLineEnable != other.antialiasedLineEnable
+                || depthBias != other.depthBias
+                || depthBiasClamp != other.depthBiasClamp
+                || slopeScaledDepthBias != other.slopeScaledDepthBias
+                || forcedSampleCount != other.forcedSampleCount
+                || programmableSamplePositionsEnable != other.programmableSamplePositionsEnable
+                || conservativeRasterEnable != other.conservativeRasterEnable
+                || quadFillEnable != other.quadFillEnable)
+                return false;
+
+            for (int i = 0; i < 16; i++)
+            {
+                if (samplePositionsX[i] != other.samplePositionsX[i] || samplePositionsY[i] != other.samplePositionsY[i])
+                    return false;
+            }
+
+            return true;
+        }
+
+        constexpr bool operator !=(const RasterState& other) const { return !(*this == other); }
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -1153,6 +1313,16 @@ namespace nvrhi
             constexpr StencilOpDesc& setDepthFailOp(StencilOp value) { depthFailOp = value; return *this; }
             constexpr StencilOpDesc& setPassOp(StencilOp value) { passOp = value; return *this; }
             constexpr StencilOpDesc& setStencilFunc(ComparisonFunc value) { stencilFunc = value; return *this; }
+
+            constexpr bool operator ==(const StencilOpDesc& other) const
+            {
+                return failOp == other.failOp
+                    && depthFailOp == other.depthFailOp
+                    && passOp == other.passOp
+                    && stencilFunc == other.stencilFunc;
+            }
+
+            constexpr bool operator !=(const StencilOpDesc& other) const { return !(*this == other); }
         };
 
         bool            depthTestEnable = true;
@@ -1182,7 +1352,22 @@ namespace nvrhi
         constexpr DepthStencilState& setFrontFaceStencil(const StencilOpDesc& value) { frontFaceStencil = value; return *this; }
         constexpr DepthStencilState& setBackFaceStencil(const StencilOpDesc& value) { backFaceStencil = value; return *this; }
         constexpr DepthStencilState& setDynamicStencilRef(bool value) { dynamicStencilRef = value; return *this; }
-        
+
+        constexpr bool operator ==(const DepthStencilState& other) const
+        {
+            return depthTestEnable == other.depthTestEnable
+                && depthWriteEnable == other.depthWriteEnable
+                && depthFunc == other.depthFunc
+                && stencilEnable == other.stencilEnable
+                && stencilReadMask == other.stencilReadMask
+                && stencilWriteMask == other.stencilWriteMask
+                && stencilRefValue == other.stencilRefValue
+                && dynamicStencilRef == other.dynamicStencilRef
+                && frontFaceStencil == other.frontFaceStencil
+                && backFaceStencil == other.backFaceStencil;
+        }
+
+        constexpr bool operator !=(const DepthStencilState& other) const { return !(*this == other); }
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -1258,6 +1443,22 @@ namespace nvrhi
         SamplerDesc& setAddressW(SamplerAddressMode mode) { addressW = mode; return *this; }
         SamplerDesc& setAllAddressModes(SamplerAddressMode mode) { addressU = addressV = addressW = mode; return *this; }
         SamplerDesc& setReductionType(SamplerReductionType type) { reductionType = type; return *this; }
+
+        bool operator ==(const SamplerDesc& other) const
+        {
+            return borderColor == other.borderColor
+                && maxAnisotropy == other.maxAnisotropy
+                && mipBias == other.mipBias
+                && minFilter == other.minFilter
+                && magFilter == other.magFilter
+                && mipFilter == other.mipFilter
+                && addressU == other.addressU
+                && addressV == other.addressV
+                && addressW == other.addressW
+                && reductionType == other.reductionType;
+        }
+
+        bool operator !=(const SamplerDesc& other) const { return !(*this == other); }
     };
 
     class ISampler : public IResource
@@ -1272,12 +1473,38 @@ namespace nvrhi
     // Framebuffer
     //////////////////////////////////////////////////////////////////////////
 
+    // Operations applied to a framebuffer attachment when a command list starts rendering to the framebuffer,
+    // that is, when it binds a framebuffer different from the last one it rendered to since open().
+    // Rendering that is interrupted by other commands and resumed with the same framebuffer always loads the contents.
+    enum class AttachmentLoadOp : uint8_t
+    {
+        Load,
+        Clear,
+        DontCare
+    };
+
+    // With Discard, the attachment contents are undefined once the command list stops rendering to the framebuffer,
+    // including when rendering is interrupted by other commands such as copies or compute dispatches.
+    // On D3D12, Discard only has an effect when render passes are used.
+    enum class AttachmentStoreOp : uint8_t
+    {
+        Store,
+        Discard
+    };
+
     struct FramebufferAttachment
     {
         ITexture* texture = nullptr;
         TextureSubresourceSet subresources = TextureSubresourceSet(0, 1, 0, 1);
         Format format = Format::UNKNOWN;
         bool isReadOnly = false;
+        AttachmentLoadOp loadOp = AttachmentLoadOp::Load;
+        AttachmentStoreOp storeOp = AttachmentStoreOp::Store;
+
+        // Value used with AttachmentLoadOp::Clear. If useClearValue is false, the texture's clearValue is used.
+        // For depth attachments, r is the depth value and g is the stencil value.
+        bool useClearValue = false;
+        Color clearValue;
         
         constexpr FramebufferAttachment& setTexture(ITexture* t) { texture = t; return *this; }
         constexpr FramebufferAttachment& setSubresources(TextureSubresourceSet value) { subresources = value; return *this; }
@@ -1286,6 +1513,11 @@ namespace nvrhi
         constexpr FramebufferAttachment& setMipLevel(MipLevel level) { subresources.baseMipLevel = level; subresources.numMipLevels = 1; return *this; }
         constexpr FramebufferAttachment& setFormat(Format f) { format = f; return *this; }
         constexpr FramebufferAttachment& setReadOnly(bool ro) { isReadOnly = ro; return *this; }
+        constexpr FramebufferAttachment& setLoadOp(AttachmentLoadOp value) { loadOp = value; return *this; }
+        constexpr FramebufferAttachment& setStoreOp(AttachmentStoreOp value) { storeOp = value; return *this; }
+        constexpr FramebufferAttachment& setClearValue(const Color& value) { clearValue = value; useClearValue = true; return *this; }
+
+        [[nodiscard]] const Color& getEffectiveClearValue() const { return useClearValue || !texture ? clearValue : texture->getDesc().clearValue; }
 
         [[nodiscard]] bool valid() const { return texture != nullptr; }
     };
@@ -1317,6 +1549,11 @@ namespace nvrhi
         uint32_t sampleCount = 1;
         uint32_t sampleQuality = 0;
 
+        // Set for framebuffers with a shading rate attachment.
+        // - Vulkan: Pipelines used with such framebuffers must be created with the
+        //   VK_PIPELINE_CREATE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR flag, which this enables.
+        bool hasShadingRateAttachment = false;
+
         FramebufferInfo() = default;
         NVRHI_API FramebufferInfo(const FramebufferDesc& desc);
         
@@ -1325,7 +1562,8 @@ namespace nvrhi
             return formatsEqual(colorFormats, other.colorFormats)
                 && depthFormat == other.depthFormat
                 && sampleCount == other.sampleCount
-                && sampleQuality == other.sampleQuality;
+                && sampleQuality == other.sampleQuality
+                && hasShadingRateAttachment == other.hasShadingRateAttachment;
         }
         bool operator!=(const FramebufferInfo& other) const { return !(*this == other); }
 
@@ -1333,6 +1571,7 @@ namespace nvrhi
         FramebufferInfo& setDepthFormat(Format format) { depthFormat = format; return *this; }
         FramebufferInfo& setSampleCount(uint32_t count) { sampleCount = count; return *this; }
         FramebufferInfo& setSampleQuality(uint32_t quality) { sampleQuality = quality; return *this; }
+        FramebufferInfo& setHasShadingRateAttachment(bool value) { hasShadingRateAttachment = value; return *this; }
 
     private:
         static bool formatsEqual(const static_vector<Format, c_MaxRenderTargets>& a, const static_vector<Format, c_MaxRenderTargets>& b)
@@ -1444,6 +1683,17 @@ namespace nvrhi
 
         typedef RefCountPtr<IOpacityMicromap> OpacityMicromapHandle;
 
+        // One OMM build for ICommandList::buildOpacityMicromaps.
+        // If desc is null, the desc that the OMM was created with is used.
+        struct OpacityMicromapBuildDesc
+        {
+            IOpacityMicromap* opacityMicromap = nullptr;
+            const OpacityMicromapDesc* desc = nullptr;
+
+            OpacityMicromapBuildDesc& setOpacityMicromap(IOpacityMicromap* value) { opacityMicromap = value; return *this; }
+            OpacityMicromapBuildDesc& setDesc(const OpacityMicromapDesc* value) { desc = value; return *this; }
+        };
+
         //////////////////////////////////////////////////////////////////////////
         // rt::AccelStruct
         //////////////////////////////////////////////////////////////////////////
@@ -1719,6 +1969,10 @@ namespace nvrhi
             bool isTopLevel = false;
             bool isVirtual = false;
 
+            // TLAS only: create a persistent device-local buffer with room for topLevelMaxInstances instances,
+            // see IAccelStruct::getInstanceBuffer(). The buffer is not virtual even when isVirtual is set.
+            bool createInstanceBuffer = false;
+
             AccelStructDesc& setTopLevelMaxInstances(size_t value) { topLevelMaxInstances = value; isTopLevel = true; return *this; }
             AccelStructDesc& addBottomLevelGeometry(const GeometryDesc& value) { bottomLevelGeometries.push_back(value); isTopLevel = false; return *this; }
             AccelStructDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
@@ -1726,6 +1980,7 @@ namespace nvrhi
             AccelStructDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
             AccelStructDesc& setIsTopLevel(bool value) { isTopLevel = value; return *this; }
             AccelStructDesc& setIsVirtual(bool value) { isVirtual = value; return *this; }
+            AccelStructDesc& setCreateInstanceBuffer(bool value) { createInstanceBuffer = value; return *this; }
         };
 
         //////////////////////////////////////////////////////////////////////////
@@ -1738,10 +1993,32 @@ namespace nvrhi
             [[nodiscard]] virtual const AccelStructDesc& getDesc() const = 0;
             [[nodiscard]] virtual bool isCompacted() const = 0;
             [[nodiscard]] virtual uint64_t getDeviceAddress() const = 0;
+
+            // Returns the instance buffer of a TLAS created with AccelStructDesc::createInstanceBuffer, or NULL.
+            // The buffer holds topLevelMaxInstances entries in the rt::InstanceDesc layout with blasDeviceAddress set,
+            // and can be written with ICommandList::updateTopLevelAccelStructInstances(...) or by shaders through
+            // a structured UAV. Build the TLAS from it with ICommandList::buildTopLevelAccelStructFromBuffer(...).
+            // Instances that a culling shader wants to skip should get blasDeviceAddress = 0 or instanceMask = 0,
+            // so that the TLAS can be built for a fixed instance count without reading anything back.
+            [[nodiscard]] virtual IBuffer* getInstanceBuffer() const = 0;
         };
 
         typedef RefCountPtr<IAccelStruct> AccelStructHandle;
 
+        // One BLAS build or update for ICommandList::buildBottomLevelAccelStructs.
+        // The geometry array must stay valid until the call returns.
+        struct BlasBuildDesc
+        {
+            IAccelStruct* accelStruct = nullptr;
+            const GeometryDesc* geometries = nullptr;
+            size_t numGeometries = 0;
+            AccelStructBuildFlags buildFlags = AccelStructBuildFlags::None;
+
+            BlasBuildDesc& setAccelStruct(IAccelStruct* value) { accelStruct = value; return *this; }
+            BlasBuildDesc& setGeometries(const GeometryDesc* value, size_t count) { geometries = value; numGeometries = count; return *this; }
+            BlasBuildDesc& setBuildFlags(AccelStructBuildFlags value) { buildFlags = value; return *this; }
+        };
+
 
         //////////////////////////////////////////////////////////////////////////
         // Clusters
@@ -1857,6 +2134,13 @@ namespace nvrhi
 
                 uint64_t scratchSizeInBytes = 0;                        // Size of scratch resource returned by getClusterOperationSizeInfo() scratchSizeInBytes 
 
+                // Optional persistent scratch memory. When set, the operation uses scratchSizeInBytes bytes of this buffer starting
+                // at scratchOffsetInBytes instead of suballocating them from the command list's scratch memory, which is limited
+                // by CommandListParameters::scratchMaxMemory. The buffer must have canHaveUAVs set, and the offset must be aligned
+                // to 256 bytes. See rt::cluster::IBuildContext for a helper that keeps the scratch and output buffers across frames.
+                IBuffer* scratchBuffer = nullptr;
+                uint64_t scratchOffsetInBytes = 0;
+
                 // Input Resources
                 IBuffer* inIndirectArgCountBuffer = nullptr;            // Buffer containing the number of AS to build, instantiate, or move
                 uint64_t inIndirectArgCountOffsetInBytes = 0;           // Offset (in bytes) to where the count is in the inIndirectArgCountBuffer 
@@ -1898,6 +2182,7 @@ namespace nvrhi
         RayTracingAccelStruct,
         PushConstants,
         SamplerFeedbackTexture_UAV,
+        InlineUniformBlock,
 
         Count
     };
@@ -1908,8 +2193,10 @@ namespace nvrhi
         uint32_t slot;
 
         ResourceType type : 8;
-        uint8_t unused : 8;
+        // Number of 32-bit values when a VolatileConstantBuffer is declared as inline constants, 0 otherwise
+        uint8_t numInlineConstants : 8;
         // Push constant byte size when (type == PushConstants)
+        // Data byte size when (type == InlineUniformBlock)
         // Descriptor array size (1 or more) for all other resource types
         // Must be 1 for VolatileConstantBuffer
         uint16_t size : 16;
@@ -1918,6 +2205,7 @@ namespace nvrhi
         {
             return slot == b.slot
                 && type == b.type
+                && numInlineConstants == b.numInlineConstants
                 && size == b.size;
         }
         bool operator !=(const BindingLayoutItem& b) const { return !(*this == b); }
@@ -1926,7 +2214,7 @@ namespace nvrhi
         constexpr BindingLayoutItem& setType(ResourceType value) { type = value; return *this; }
         constexpr BindingLayoutItem& setSize(uint32_t value) { size = uint16_t(value); return *this; }
 
-        uint32_t getArraySize() const { return (type == ResourceType::PushConstants) ? 1 : size; }
+        uint32_t getArraySize() const { return (type == ResourceType::PushConstants || type == ResourceType::InlineUniformBlock) ? 1 : size; }
 
         // Helper functions for strongly typed initialization
 #define NVRHI_BINDING_LAYOUT_ITEM_INITIALIZER(TYPE) /* NOLINT(cppcoreguidelines-macro-usage) */ \
@@ -1959,6 +2247,32 @@ namespace nvrhi
             result.size = uint16_t(size);
             return result;
         }
+
+        // Declares a small volatile constant buffer, up to c_MaxInlineVolatileConstantBufferSize bytes, that is passed
+        // to the shaders as inline root constants on DX12. Writing such buffer doesn't use the upload manager, and
+        // updating the bound constants between draws costs one SetGraphicsRoot32BitConstants call.
+        // The buffer must be written with at most byteSize bytes of data.
+        // On DX11 and Vulkan, this is a regular volatile constant buffer.
+        static BindingLayoutItem InlineVolatileConstantBuffer(const uint32_t slot, const size_t byteSize)
+        {
+            BindingLayoutItem result = VolatileConstantBuffer(slot);
+            result.numInlineConstants = uint8_t((byteSize + 3) / 4);
+            return result;
+        }
+
+        // Declares a constant buffer whose data is stored in the binding set itself, see BindingSetDesc::addInlineUniformBlock.
+        // The shaders declare it as a regular constant buffer in the constant buffer register range.
+        // Vulkan only, requires VK_EXT_inline_uniform_block. The byte size must be a multiple of 4 and must not exceed
+        // VkPhysicalDeviceInlineUniformBlockProperties::maxInlineUniformBlockSize, which is at least 256 bytes.
+        // Inline uniform blocks cannot be used in layouts with usePushDescriptors.
+        static BindingLayoutItem InlineUniformBlock(const uint32_t slot, const size_t byteSize)
+        {
+            BindingLayoutItem result{};
+            result.slot = slot;
+            result.type = ResourceType::InlineUniformBlock;
+            result.size = uint16_t(byteSize);
+            return result;
+        }
 #undef NVRHI_BINDING_LAYOUT_ITEM_INITIALIZER
     };
 
@@ -2002,6 +2316,15 @@ namespace nvrhi
         //   an error.
         bool registerSpaceIsDescriptorSet = false;
 
+        // Vulkan only: binding sets created with this layout don't allocate descriptor sets, and their descriptors
+        // are written into the command buffer with vkCmdPushDescriptorSetKHR whenever the binding set is bound.
+        // Suited for small per-draw binding sets that change often. Volatile constant buffers are pushed again
+        // when they are written. Requires VK_KHR_push_descriptor; layouts fall back to regular descriptor sets
+        // with a warning when the extension is missing, when the device uses a descriptor buffer, or when the layout
+        // has more than maxPushDescriptors descriptors. At most one layout in a pipeline can use push descriptors.
+        // Ignored on DX11 and DX12.
+        bool usePushDescriptors = false;
+
         std::vector<BindingLayoutItem> bindings;
         VulkanBindingOffsets bindingOffsets;
 
@@ -2010,6 +2333,7 @@ namespace nvrhi
         BindingLayoutDesc& setRegisterSpaceIsDescriptorSet(bool value) { registerSpaceIsDescriptorSet = value; return *this; }
         // Shortcut for .setRegisterSpace(value).setRegisterSpaceIsDescriptorSet(true)
         BindingLayoutDesc& setRegisterSpaceAndDescriptorSet(uint32_t value) { registerSpace = value; registerSpaceIsDescriptorSet = true; return *this; }
+        BindingLayoutDesc& setUsePushDescriptors(bool value) { usePushDescriptors = value; return *this; }
         BindingLayoutDesc& addItem(const BindingLayoutItem& value) { bindings.push_back(value); return *this; }
         BindingLayoutDesc& setBindingOffsets(const VulkanBindingOffsets& value) { bindingOffsets = value; return *this; }
     };
@@ -2331,6 +2655,24 @@ namespace nvrhi
             return result;
         }
 
+        // Refers to byteSize bytes at byteOffset in BindingSetDesc::inlineUniformData,
+        // usually created with BindingSetDesc::addInlineUniformBlock
+        static BindingSetItem InlineUniformBlock(uint32_t slot, uint32_t byteOffset, uint32_t byteSize)
+        {
+            BindingSetItem result;
+            result.slot = slot;
+            result.arrayElement = 0;
+            result.type = ResourceType::InlineUniformBlock;
+            result.resourceHandle = nullptr;
+            result.format = Format::UNKNOWN;
+            result.dimension = TextureDimension::Unknown;
+            result.range.byteOffset = byteOffset;
+            result.range.byteSize = byteSize;
+            result.unused = 0;
+            result.unused2 = 0;
+            return result;
+        }
+
         static BindingSetItem SamplerFeedbackTexture_UAV(uint32_t slot, ISamplerFeedbackTexture* texture)
         {
             BindingSetItem result;
@@ -2360,6 +2702,9 @@ namespace nvrhi
     struct BindingSetDesc
     {
         std::vector<BindingSetItem> bindings;
+
+        // Data of the InlineUniformBlock items, which is copied into the descriptor set when the binding set is created
+        std::vector<uint8_t> inlineUniformData;
        
         // Enables automatic liveness tracking of this binding set by nvrhi command lists.
         // By setting trackLiveness to false, you take the responsibility of not releasing it 
@@ -2371,6 +2716,9 @@ namespace nvrhi
             if (bindings.size() != b.bindings.size())
                 return false;
 
+            if (inlineUniformData != b.inlineUniformData)
+                return false;
+
             for (size_t i = 0; i < bindings.size(); ++i)
             {
                 if (bindings[i] != b.bindings[i])
@@ -2387,6 +2735,17 @@ namespace nvrhi
 
         BindingSetDesc& addItem(const BindingSetItem& value) { bindings.push_back(value); return *this; }
         BindingSetDesc& setTrackLiveness(bool value) { trackLiveness = value; return *this; }
+
+        // Appends the data to inlineUniformData and adds an InlineUniformBlock item that refers to it.
+        // The byte size must be a multiple of 4 and match the size of the layout item.
+        BindingSetDesc& addInlineUniformBlock(uint32_t slot, const void* data, uint32_t byteSize)
+        {
+            const uint32_t byteOffset = uint32_t(inlineUniformData.size());
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            inlineUniformData.insert(inlineUniformData.end(), bytes, bytes + byteSize);
+            bindings.push_back(BindingSetItem::InlineUniformBlock(slot, byteOffset, byteSize));
+            return *this;
+        }
     };
 
     class IBindingSet : public IResource
@@ -2460,6 +2819,16 @@ namespace nvrhi
         constexpr RenderState& setDepthStencilState(const DepthStencilState& value) { depthStencilState = value; return *this; }
         constexpr RenderState& setRasterState(const RasterState& value) { rasterState = value; return *this; }
         constexpr RenderState& setSinglePassStereoState(const SinglePassStereoState& value) { singlePassStereo = value; return *this; }
+
+        bool operator ==(const RenderState& other) const
+        {
+            return blendState == other.blendState
+                && depthStencilState == other.depthStencilState
+                && rasterState == other.rasterState
+                && singlePassStereo == other.singlePassStereo;
+        }
+
+        bool operator !=(const RenderState& other) const { return !(*this == other); }
     };
 
     enum class VariableShadingRate : uint8_t
@@ -2538,6 +2907,24 @@ namespace nvrhi
         GraphicsPipelineDesc& setRenderState(const RenderState& value) { renderState = value; return *this; }
         GraphicsPipelineDesc& setVariableRateShadingState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
         GraphicsPipelineDesc& addBindingLayout(IBindingLayout* layout) { bindingLayouts.push_back(layout); return *this; }
+
+        // Shaders, input and binding layouts are compared by identity
+        bool operator ==(const GraphicsPipelineDesc& other) const
+        {
+            return primType == other.primType
+                && patchControlPoints == other.patchControlPoints
+                && inputLayout == other.inputLayout
+                && VS == other.VS
+                && HS == other.HS
+                && DS == other.DS
+                && GS == other.GS
+                && PS == other.PS
+                && renderState == other.renderState
+                && shadingRateState == other.shadingRateState
+                && bindingLayouts == other.bindingLayouts;
+        }
+
+        bool operator !=(const GraphicsPipelineDesc& other) const { return !(*this == other); }
     };
 
     class IGraphicsPipeline : public IResource
@@ -2557,6 +2944,13 @@ namespace nvrhi
 
         ComputePipelineDesc& setComputeShader(IShader* value) { CS = value; return *this; }
         ComputePipelineDesc& addBindingLayout(IBindingLayout* layout) { bindingLayouts.push_back(layout); return *this; }
+
+        bool operator ==(const ComputePipelineDesc& other) const
+        {
+            return CS == other.CS && bindingLayouts == other.bindingLayouts;
+        }
+
+        bool operator !=(const ComputePipelineDesc& other) const { return !(*this == other); }
     };
 
     class IComputePipeline : public IResource
@@ -2577,6 +2971,10 @@ namespace nvrhi
 
         RenderState renderState;
 
+        // Enables the shading rate set with MeshletState::shadingRateState, including the per-primitive rates
+        // written by mesh shaders. Only used on Vulkan, D3D12 always allows setting the shading rate.
+        VariableRateShadingState shadingRateState;
+
         BindingLayoutVector bindingLayouts;
         
         MeshletPipelineDesc& setPrimType(PrimitiveType value) { primType = value; return *this; }
@@ -2586,6 +2984,7 @@ namespace nvrhi
         MeshletPipelineDesc& setPixelShader(IShader* value) { PS = value; return *this; }
         MeshletPipelineDesc& setFragmentShader(IShader* value) { PS = value; return *this; }
         MeshletPipelineDesc& setRenderState(const RenderState& value) { renderState = value; return *this; }
+        MeshletPipelineDesc& setVariableRateShadingState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
         MeshletPipelineDesc& addBindingLayout(IBindingLayout* layout) { bindingLayouts.push_back(layout); return *this; }
     };
 
@@ -2602,12 +3001,135 @@ namespace nvrhi
     // Draw and Dispatch
     //////////////////////////////////////////////////////////////////////////
 
+    enum class CommandQueue : uint8_t
+    {
+        Graphics = 0,
+        Compute,
+        Copy,
+
+        Count
+    };
+
     class IEventQuery : public IResource { };
     typedef RefCountPtr<IEventQuery> EventQueryHandle;
 
+    // A point in the middle of a command list that other command lists can wait for, see ICommandList::signalSyncPoint.
+    class ISyncPoint : public IResource
+    {
+    public:
+        // Returns the queue that the command list signaling this point was executed on.
+        [[nodiscard]] virtual CommandQueue getQueue() const = 0;
+
+        // Returns the value that is signaled on the timeline semaphore (VK) or fence (DX12) of the queue,
+        // or 0 if the command list signaling this point has not been executed yet.
+        [[nodiscard]] virtual uint64_t getValue() const = 0;
+    };
+    typedef RefCountPtr<ISyncPoint> SyncPointHandle;
+
+    // Pipeline stages of the waiting command list that are blocked by ICommandList::waitSyncPoint.
+    // Stages that are not supported by the queue type are ignored.
+    enum class PipelineStages : uint32_t
+    {
+        None                = 0x0000,
+        DrawIndirect        = 0x0001,
+        VertexInput         = 0x0002,
+        PreRasterization    = 0x0004, // vertex, tessellation, geometry, amplification and mesh shaders
+        PixelShader         = 0x0008,
+        RenderTargets       = 0x0010, // depth-stencil tests and render target writes
+        ComputeShader       = 0x0020,
+        RayTracingShaders   = 0x0040,
+        AccelStructBuild    = 0x0080,
+        Copy                = 0x0100,
+
+        AllGraphics         = 0x001F,
+        All                 = 0xFFFFFFFF
+    };
+
+    NVRHI_ENUM_CLASS_FLAG_OPERATORS(PipelineStages)
+
     class ITimerQuery : public IResource { };
     typedef RefCountPtr<ITimerQuery> TimerQueryHandle;
 
+    enum class OcclusionQueryType : uint8_t
+    {
+        // Counts the samples that passed the depth and stencil tests.
+        // On Vulkan, the count is only exact if the occlusionQueryPrecise feature was enabled on the device.
+        SampleCount,
+
+        // Only reports whether any samples passed, which can be cheaper on some GPUs.
+        // The result is 0 or nonzero, but not necessarily 1. On DX11, only binary queries can be used for predication.
+        Binary
+    };
+
+    class IOcclusionQuery : public IResource
+    {
+    public:
+        [[nodiscard]] virtual OcclusionQueryType getType() const = 0;
+    };
+    typedef RefCountPtr<IOcclusionQuery> OcclusionQueryHandle;
+
+    // Mirrors D3D12_QUERY_DATA_PIPELINE_STATISTICS and the order of VkQueryPipelineStatisticFlagBits
+    struct PipelineStatistics
+    {
+        uint64_t inputAssemblyVertices = 0;
+        uint64_t inputAssemblyPrimitives = 0;
+        uint64_t vertexShaderInvocations = 0;
+        uint64_t geometryShaderInvocations = 0;
+        uint64_t geometryShaderPrimitives = 0;
+        uint64_t clipperInvocations = 0;
+        uint64_t clipperPrimitives = 0;
+        uint64_t pixelShaderInvocations = 0;
+        uint64_t hullShaderInvocations = 0; // on Vulkan, the number of patches processed by the tessellation control shader
+        uint64_t domainShaderInvocations = 0;
+        uint64_t computeShaderInvocations = 0;
+    };
+
+    class IPipelineStatisticsQuery : public IResource { };
+    typedef RefCountPtr<IPipelineStatisticsQuery> PipelineStatisticsQueryHandle;
+
+    enum class PredicationOp : uint8_t
+    {
+        // Skip the predicated commands if the occlusion query result is zero, i.e. nothing was visible
+        SkipIfZero,
+        SkipIfNotZero
+    };
+
+    struct TimerQueryPoolDesc
+    {
+        // Number of timer queries that can be used in each frame, see ICommandList::beginTimerQuery(ITimerQueryPool*, ...).
+        uint32_t maxQueriesPerFrame = 256;
+
+        // Number of frames that can be recorded or waiting for their results at the same time.
+        // The results of a frame can be retrieved until this many newer frames have been started.
+        uint32_t maxFramesInFlight = 3;
+
+        // The queue that executes the command lists recording the queries.
+        // On DX12, it determines the timestamp frequency and the query heap type for the copy queue.
+        CommandQueue queue = CommandQueue::Graphics;
+
+        std::string debugName;
+
+        TimerQueryPoolDesc& setMaxQueriesPerFrame(uint32_t value) { maxQueriesPerFrame = value; return *this; }
+        TimerQueryPoolDesc& setMaxFramesInFlight(uint32_t value) { maxFramesInFlight = value; return *this; }
+        TimerQueryPoolDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        TimerQueryPoolDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // A set of timer queries that are resolved together, once per frame, without waiting for the GPU.
+    // Each frame uses its own range of queries in a single query heap or pool, so the frames can be in flight
+    // at the same time. Frames are started with ICommandList::beginTimerQueryFrame and finished with
+    // ICommandList::resolveTimerQueries, and their results are retrieved later with IDevice::getTimerQueryPoolResults.
+    class ITimerQueryPool : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const TimerQueryPoolDesc& getDesc() const = 0;
+
+        // Returns the index of the frame started by the last beginTimerQueryFrame call, or 0 if none was started.
+        [[nodiscard]] virtual uint64_t getCurrentFrameIndex() const = 0;
+    };
+
+    typedef RefCountPtr<ITimerQueryPool> TimerQueryPoolHandle;
+
     struct VertexBufferBinding
     {
         IBuffer* buffer = nullptr;
@@ -2665,6 +3187,10 @@ namespace nvrhi
 
         IBuffer* indirectParams = nullptr;
 
+        // Buffer that holds the number of draws for drawIndirectCount and drawIndexedIndirectCount.
+        // Must be created with isDrawIndirectArgs, and is transitioned into the IndirectArgument state.
+        IBuffer* indirectCountBuffer = nullptr;
+
         GraphicsState& setPipeline(IGraphicsPipeline* value) { pipeline = value; return *this; }
         GraphicsState& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
         GraphicsState& setViewport(const ViewportState& value) { viewport = value; return *this; }
@@ -2675,6 +3201,7 @@ namespace nvrhi
         GraphicsState& addVertexBuffer(const VertexBufferBinding& value) { vertexBuffers.push_back(value); return *this; }
         GraphicsState& setIndexBuffer(const IndexBufferBinding& value) { indexBuffer = value; return *this; }
         GraphicsState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        GraphicsState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
     };
 
     struct DrawArguments
@@ -2728,9 +3255,13 @@ namespace nvrhi
 
         IBuffer* indirectParams = nullptr;
 
+        // Buffer that holds the number of commands for executeIndirect, see GraphicsState::indirectCountBuffer.
+        IBuffer* indirectCountBuffer = nullptr;
+
         ComputeState& setPipeline(IComputePipeline* value) { pipeline = value; return *this; }
         ComputeState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         ComputeState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        ComputeState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
     };
     
     struct DispatchIndirectArguments
@@ -2754,19 +3285,134 @@ namespace nvrhi
         Color blendConstantColor{};
         uint8_t dynamicStencilRefValue = 0;
 
+        // Use the pipelinePrimitiveCombiner to apply the per-primitive shading rates written by the mesh shader,
+        // see MeshletFeatureInfo::perPrimitiveShadingRate.
+        VariableRateShadingState shadingRateState;
+
         BindingSetVector bindings;
 
         IBuffer* indirectParams = nullptr;
 
+        // Buffer that holds the number of dispatches for dispatchMeshIndirectCount, see GraphicsState::indirectCountBuffer.
+        IBuffer* indirectCountBuffer = nullptr;
+
         MeshletState& setPipeline(IMeshletPipeline* value) { pipeline = value; return *this; }
         MeshletState& setFramebuffer(IFramebuffer* value) { framebuffer = value; return *this; }
         MeshletState& setViewport(const ViewportState& value) { viewport = value; return *this; }
         MeshletState& setBlendColor(const Color& value) { blendConstantColor = value; return *this; }
         MeshletState& addBindingSet(IBindingSet* value) { bindings.push_back(value); return *this; }
         MeshletState& setIndirectParams(IBuffer* value) { indirectParams = value; return *this; }
+        MeshletState& setIndirectCountBuffer(IBuffer* value) { indirectCountBuffer = value; return *this; }
         MeshletState& setDynamicStencilRefValue(uint8_t value) { dynamicStencilRefValue = value; return *this; }
+        MeshletState& setShadingRateState(const VariableRateShadingState& value) { shadingRateState = value; return *this; }
     };
 
+    //////////////////////////////////////////////////////////////////////////
+    // Command Signatures
+    //////////////////////////////////////////////////////////////////////////
+
+    enum class IndirectArgumentType : uint8_t
+    {
+        // Actions, one of which must be the last argument of a signature.
+        // The records use the DrawIndirectArguments, DrawIndexedIndirectArguments and DispatchIndirectArguments layouts.
+        Draw,
+        DrawIndexed,
+        Dispatch,
+        DispatchMesh,
+
+        // State changes that are applied before the action of the same command.
+        PushConstants,          // pushConstantCount 32-bit values written at pushConstantOffset into the push constants
+        VertexBuffer,           // IndirectVertexBufferView bound to the vertex buffer slot 'slot'
+        IndexBuffer,            // IndirectIndexBufferView
+        VolatileConstantBuffer  // 64-bit GPU address of the volatile constant buffer at register 'slot' in binding layout 'layoutIndex'
+    };
+
+    // The record layouts match D3D12_VERTEX_BUFFER_VIEW and D3D12_INDEX_BUFFER_VIEW.
+    struct IndirectVertexBufferView
+    {
+        uint64_t gpuAddress = 0;
+        uint32_t byteSize = 0;
+        uint32_t byteStride = 0;
+    };
+
+    struct IndirectIndexBufferView
+    {
+        uint64_t gpuAddress = 0;
+        uint32_t byteSize = 0;
+        uint32_t format = 0; // DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+    };
+
+    struct IndirectArgumentDesc
+    {
+        IndirectArgumentType type = IndirectArgumentType::Draw;
+        uint32_t slot = 0;
+        uint32_t layoutIndex = 0;
+        uint32_t pushConstantOffset = 0;
+        uint32_t pushConstantCount = 0;
+
+        constexpr IndirectArgumentDesc& setType(IndirectArgumentType value) { type = value; return *this; }
+        constexpr IndirectArgumentDesc& setSlot(uint32_t value) { slot = value; return *this; }
+        constexpr IndirectArgumentDesc& setLayoutIndex(uint32_t value) { layoutIndex = value; return *this; }
+        constexpr IndirectArgumentDesc& setPushConstants(uint32_t offset, uint32_t count) { pushConstantOffset = offset; pushConstantCount = count; return *this; }
+
+        // Returns the size of the argument in an indirect record, in bytes.
+        [[nodiscard]] constexpr uint32_t getByteSize() const
+        {
+            switch (type)
+            {
+            case IndirectArgumentType::Draw: return sizeof(DrawIndirectArguments);
+            case IndirectArgumentType::DrawIndexed: return sizeof(DrawIndexedIndirectArguments);
+            case IndirectArgumentType::Dispatch:
+            case IndirectArgumentType::DispatchMesh: return sizeof(DispatchIndirectArguments);
+            case IndirectArgumentType::PushConstants: return pushConstantCount * 4;
+            case IndirectArgumentType::VertexBuffer: return sizeof(IndirectVertexBufferView);
+            case IndirectArgumentType::IndexBuffer: return sizeof(IndirectIndexBufferView);
+            case IndirectArgumentType::VolatileConstantBuffer: return sizeof(uint64_t);
+            default: return 0;
+            }
+        }
+    };
+
+    struct CommandSignatureDesc
+    {
+        // Arguments of each command, tightly packed in the indirect record in this order.
+        // The last argument must be an action, and the other ones must be state changes.
+        std::vector<IndirectArgumentDesc> arguments;
+
+        // Distance between the records in the indirect buffer. 0 means the total size of the arguments.
+        uint32_t byteStride = 0;
+
+        // The pipeline that the commands are executed with, required when the arguments include PushConstants
+        // or VolatileConstantBuffer, because those refer to its bindings. The same pipeline must be current
+        // when the signature is used in executeIndirect. Only one of the pipelines may be set.
+        // On Vulkan, signatures with state-changing arguments always require the pipeline.
+        IGraphicsPipeline* graphicsPipeline = nullptr;
+        IComputePipeline* computePipeline = nullptr;
+        IMeshletPipeline* meshletPipeline = nullptr;
+
+        CommandSignatureDesc& addArgument(const IndirectArgumentDesc& value) { arguments.push_back(value); return *this; }
+        CommandSignatureDesc& setByteStride(uint32_t value) { byteStride = value; return *this; }
+        CommandSignatureDesc& setGraphicsPipeline(IGraphicsPipeline* value) { graphicsPipeline = value; return *this; }
+        CommandSignatureDesc& setComputePipeline(IComputePipeline* value) { computePipeline = value; return *this; }
+        CommandSignatureDesc& setMeshletPipeline(IMeshletPipeline* value) { meshletPipeline = value; return *this; }
+
+        [[nodiscard]] uint32_t getPackedByteSize() const
+        {
+            uint32_t size = 0;
+            for (const IndirectArgumentDesc& argument : arguments)
+                size += argument.getByteSize();
+            return size;
+        }
+    };
+
+    class ICommandSignature : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const CommandSignatureDesc& getDesc() const = 0;
+    };
+
+    typedef RefCountPtr<ICommandSignature> CommandSignatureHandle;
+
     //////////////////////////////////////////////////////////////////////////
     // Ray Tracing
     //////////////////////////////////////////////////////////////////////////
@@ -2829,7 +3475,8 @@ namespace nvrhi
             // Controls the memory usage and building behavior of the shader table.
             //
             // - When a shader table is cached, it creates an additional buffer that holds the built shader table.
-            //   This buffer is updated in CommandList::setRayTracingState after the shader table is modified.
+            //   This buffer is updated in CommandList::setRayTracingState after the shader table is modified,
+            //   uploading only the modified records when the table layout hasn't changed, see reservedHitGroups.
             // - When a shader table is uncached, this buffer is suballocated from the upload manager when the shader
             //   table is first used in CommandList::setRayTracingState after opening a command list, and reallocated
             //   and rebuilt on subsequent calls to setRayTracingState if the shader table is modified.
@@ -2843,14 +3490,33 @@ namespace nvrhi
             // Ignored when isCached == false.
             uint32_t maxEntries = 0;
 
+            // Numbers of records reserved for the miss shader, hit group and callable shader sections of a cached
+            // shader table, which must fit into maxEntries together with the ray generation shader.
+            // Adding or replacing entries within the reservation only uploads the modified records to the cache,
+            // while a section that outgrows its reservation is grown geometrically and the whole table is uploaded again.
+            // Ignored when isCached == false.
+            uint32_t reservedMissShaders = 0;
+            uint32_t reservedHitGroups = 0;
+            uint32_t reservedCallableShaders = 0;
+
             std::string debugName;
 
             ShaderTableDesc& setIsCached(bool value) { isCached = value; return *this; }
             ShaderTableDesc& setMaxEntries(uint32_t value) { maxEntries = value; return *this; }
+            ShaderTableDesc& setReservedMissShaders(uint32_t value) { reservedMissShaders = value; return *this; }
+            ShaderTableDesc& setReservedHitGroups(uint32_t value) { reservedHitGroups = value; return *this; }
+            ShaderTableDesc& setReservedCallableShaders(uint32_t value) { reservedCallableShaders = value; return *this; }
             ShaderTableDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
             ShaderTableDesc& enableCaching(uint32_t _maxEntries) { isCached = true; maxEntries = _maxEntries; return *this; }
         };
 
+        // Identifies a shader or hit group export of a ray tracing pipeline, see IPipeline::getShaderExportId.
+        // Only valid with shader tables created from the pipeline that returned it.
+        enum class ShaderExportId : uint32_t
+        {
+            Invalid = 0xffffffff
+        };
+
         class IShaderTable : public IResource
         {
         public:
@@ -2860,7 +3526,20 @@ namespace nvrhi
             virtual void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            // Adds 'count' hit groups and returns the index of the first one, or -1 if any of them is invalid,
+            // in which case none are added. 'bindings' is either null or an array of 'count' binding sets.
+            virtual int addHitGroups(const char* const* exportNames, IBindingSet* const* bindings, size_t count) = 0;
+            // Replaces the hit group at 'index', which must be below the number of hit groups in the table.
+            virtual void setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) = 0;
             virtual int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) = 0;
+            // Variants of the functions above that take exports resolved with IPipeline::getShaderExportId,
+            // which avoids looking up the names when the table is rebuilt often.
+            virtual void setRayGenerationShader(ShaderExportId exportId, IBindingSet* bindings = nullptr) = 0;
+            virtual int addMissShader(ShaderExportId exportId, IBindingSet* bindings = nullptr) = 0;
+            virtual int addHitGroup(ShaderExportId exportId, IBindingSet* bindings = nullptr) = 0;
+            virtual int addHitGroups(const ShaderExportId* exportIds, IBindingSet* const* bindings, size_t count) = 0;
+            virtual void setHitGroup(uint32_t index, ShaderExportId exportId, IBindingSet* bindings = nullptr) = 0;
+            virtual int addCallableShader(ShaderExportId exportId, IBindingSet* bindings = nullptr) = 0;
             virtual void clearMissShaders() = 0;
             virtual void clearHitShaders() = 0;
             virtual void clearCallableShaders() = 0;
@@ -2873,6 +3552,8 @@ namespace nvrhi
         public:
             [[nodiscard]] virtual const rt::PipelineDesc& getDesc() const = 0;
             virtual ShaderTableHandle createShaderTable(ShaderTableDesc const& desc = ShaderTableDesc()) = 0;
+            // Returns the ID of the shader or hit group with the given export name, or ShaderExportId::Invalid.
+            [[nodiscard]] virtual ShaderExportId getShaderExportId(const char* exportName) const = 0;
         };
 
         typedef RefCountPtr<IPipeline> PipelineHandle;
@@ -2997,6 +3678,19 @@ namespace nvrhi
             uint32_t numColumns = 0;
         };
 
+        // Describes a matrix whose on-device size is queried with IDevice::getCoopVecMatrixSizes(...)
+        struct MatrixSizeDesc
+        {
+            DataType type = DataType::Float16;
+            MatrixLayout layout = MatrixLayout::InferencingOptimal;
+            uint32_t numRows = 0;
+            uint32_t numColumns = 0;
+
+            constexpr MatrixSizeDesc& setType(DataType value) { type = value; return *this; }
+            constexpr MatrixSizeDesc& setLayout(MatrixLayout value) { layout = value; return *this; }
+            constexpr MatrixSizeDesc& setDimensions(uint32_t rows, uint32_t columns) { numRows = rows; numColumns = columns; return *this; }
+        };
+
         // Returns the size in bytes of a given data type.
         NVRHI_API size_t getDataTypeSize(DataType type);
 
@@ -3035,7 +3729,11 @@ namespace nvrhi
         VirtualResources,
         WaveLaneCountMinMax,
         CooperativeVectorInferencing,
-        CooperativeVectorTraining
+        CooperativeVectorTraining,
+        Bundles,
+        PipelineStatisticsQueries,
+        Predication,
+        GpuDecompression
     };
 
     enum class MessageSeverity : uint8_t
@@ -3046,18 +3744,28 @@ namespace nvrhi
         Fatal
     };
 
-    enum class CommandQueue : uint8_t
+    struct VariableRateShadingFeatureInfo
     {
-        Graphics = 0,
-        Compute,
-        Copy,
-
-        Count
+        uint32_t shadingRateImageTileSize;
     };
 
-    struct VariableRateShadingFeatureInfo
+    // Limits of the meshlet pipelines, returned by queryFeatureSupport(Feature::Meshlets, ...)
+    struct MeshletFeatureInfo
     {
-        uint32_t shadingRateImageTileSize;
+        // Limits of a single dispatchMesh call, for pipelines with and without an amplification shader.
+        uint32_t maxTaskWorkGroupCount[3];
+        uint32_t maxTaskWorkGroupTotalCount;
+        uint32_t maxMeshWorkGroupCount[3];
+        uint32_t maxMeshWorkGroupTotalCount;
+
+        // Size of the payload that an amplification shader passes to the mesh shaders, in bytes.
+        uint32_t maxTaskPayloadSize;
+
+        uint32_t maxMeshOutputVertices;
+        uint32_t maxMeshOutputPrimitives;
+
+        // Indicates if mesh shaders can write per-primitive shading rates (SV_ShadingRate).
+        bool perPrimitiveShadingRate;
     };
 
     struct WaveLaneCountMinMaxFeatureInfo
@@ -3083,6 +3791,83 @@ namespace nvrhi
         IMessageCallback& operator=(const IMessageCallback&) = delete;
         IMessageCallback& operator=(const IMessageCallback&&) = delete;
     };
+
+    // Object types that the DX12 and Vulkan devices destroy in IDevice::runGarbageCollection, once the GPU work
+    // submitted before their last reference was released has completed, instead of in the releasing thread.
+    // See DeviceDesc::deferredDestruction in those backends. Destroying the device destroys the remaining objects.
+    enum class DeferredDestructionFlags : uint8_t
+    {
+        None        = 0x00,
+        Buffers     = 0x01,
+        Textures    = 0x02
+    };
+
+    NVRHI_ENUM_CLASS_FLAG_OPERATORS(DeferredDestructionFlags)
+
+    // IMemoryBudgetCallback can be implemented by the application and passed to the DX12 or Vulkan device,
+    // see DeviceDesc::budgetCallback in those backends.
+    class IMemoryBudgetCallback
+    {
+    protected:
+        IMemoryBudgetCallback() = default;
+        virtual ~IMemoryBudgetCallback() = default;
+
+    public:
+        // Called by IDevice::runGarbageCollection when the device-local memory usage exceeds the budget,
+        // after the residency manager has evicted what it could. The application should release memory,
+        // e.g. by dropping the high-resolution mip levels of streamed textures.
+        virtual void budgetExceeded(const VideoMemoryBudget& budget) = 0;
+
+        IMemoryBudgetCallback(const IMemoryBudgetCallback&) = delete;
+        IMemoryBudgetCallback(const IMemoryBudgetCallback&&) = delete;
+        IMemoryBudgetCallback& operator=(const IMemoryBudgetCallback&) = delete;
+        IMemoryBudgetCallback& operator=(const IMemoryBudgetCallback&&) = delete;
+    };
+
+    // IMemoryAllocationCallback can be implemented by the application and passed to the device,
+    // see DeviceDesc::memoryAllocationCallback in the backends. The methods can be called from any thread
+    // that creates or releases resources or records command lists, and must not call back into NVRHI.
+    class IMemoryAllocationCallback
+    {
+    protected:
+        IMemoryAllocationCallback() = default;
+        virtual ~IMemoryAllocationCallback() = default;
+
+    public:
+        // Called after memory of the given category has been allocated. The debug name is the one of the resource
+        // or null for internal allocations; it is only valid during the call.
+        virtual void memoryAllocated(MemoryCategory category, uint64_t bytes, const char* debugName) = 0;
+
+        // Called when memory reported to memoryAllocated is released
+        virtual void memoryReleased(MemoryCategory category, uint64_t bytes) = 0;
+
+        IMemoryAllocationCallback(const IMemoryAllocationCallback&) = delete;
+        IMemoryAllocationCallback(const IMemoryAllocationCallback&&) = delete;
+        IMemoryAllocationCallback& operator=(const IMemoryAllocationCallback&) = delete;
+        IMemoryAllocationCallback& operator=(const IMemoryAllocationCallback&&) = delete;
+    };
+
+    // IShaderPermutationProvider can be implemented by the application and passed to the DX11 or DX12 device,
+    // see DeviceDesc::shaderPermutationProvider in those backends. These APIs have no specialization constants,
+    // so IDevice::createShaderSpecialization links the shader to a precompiled variant returned by the provider.
+    class IShaderPermutationProvider
+    {
+    protected:
+        IShaderPermutationProvider() = default;
+        virtual ~IShaderPermutationProvider() = default;
+
+    public:
+        // Writes the bytecode of the variant of the shader that was compiled with the given constant values
+        // into outBytecode, or returns false if there is no such variant. The constants are sorted by constantID.
+        // The results are cached by the device, and the provider can be called from multiple threads at once.
+        virtual bool getShaderPermutation(const ShaderDesc& desc, const void* baseBytecode, size_t baseBytecodeSize,
+            const ShaderSpecialization* constants, uint32_t numConstants, std::vector<uint8_t>& outBytecode) = 0;
+
+        IShaderPermutationProvider(const IShaderPermutationProvider&) = delete;
+        IShaderPermutationProvider(const IShaderPermutationProvider&&) = delete;
+        IShaderPermutationProvider& operator=(const IShaderPermutationProvider&) = delete;
+        IShaderPermutationProvider& operator=(const IShaderPermutationProvider&&) = delete;
+    };
     
     class IDevice;
 
@@ -3090,11 +3875,19 @@ namespace nvrhi
     {
         // A command list with enableImmediateExecution = true maps to the immediate context on DX11.
         // Two immediate command lists cannot be open at the same time, which is checked by the validation layer.
+        // On DX11, a command list with enableImmediateExecution = false records into its own deferred context,
+        // so several of them can be recorded on different threads, and executeCommandLists replays them.
         bool enableImmediateExecution = true;
 
         // Minimum size of memory chunks created to upload data to the device on DX12.
         size_t uploadChunkSize = 64 * 1024;
 
+        // Size of the persistently mapped ring buffer used to upload data to the device on DX12 and Vulkan.
+        // When nonzero, uploads are sub-allocated from the ring, which is recycled as the submissions of this
+        // command list finish executing. Chunks are only created for uploads that don't fit into the ring.
+        // When zero, all uploads use chunks.
+        size_t uploadRingSize = 0;
+
         // Minimum size of memory chunks created for AS build scratch buffers.
         size_t scratchChunkSize = 64 * 1024;
 
@@ -3105,11 +3898,53 @@ namespace nvrhi
         // COPY and COMPUTE queues have limited subsets of methods available.
         CommandQueue queueType = CommandQueue::Graphics;
 
+        // Enables the state handoff ("frame graph") mode on DX12 and Vulkan; ignored on DX11.
+        // In this mode, the command list does not need to know the states of resources when it starts using them,
+        // and it leaves the resources in their final states when closed instead of returning them to initial states.
+        // The device resolves the transitions between command lists at executeCommandLists time, in submission order,
+        // and records them into small internal command lists that are executed between the affected lists.
+        // Resources with keepInitialState = true are returned to their initial states at the end of each
+        // executeCommandLists call, and before any command list that doesn't use this mode.
+        bool enableStateHandoff = false;
+
+        // Creates a bundle: a command list that records a sequence of graphics state changes and draws once,
+        // to be replayed any number of times with ICommandList::executeBundle(...) on graphics command lists.
+        // Bundles are never passed to IDevice::executeCommandLists. Only setGraphicsState, the draw* methods,
+        // setPushConstants and markers can be recorded into a bundle, and all graphics states set in a bundle
+        // must use the same framebuffer and viewport state. Resource state requirements are captured when
+        // the bundle is recorded and applied by the command list that executes it.
+        // Re-opening a bundle is allowed when the command lists that executed it may still be in flight.
+        // Re-recording is cheap when they have finished, because the bundle then reuses its allocator or
+        // command buffer, so bundles can also be recorded every frame. To record one large render pass on
+        // several threads, record its draws into one bundle per thread and pass them all to executeBundles(...).
+        // - DX12: Maps to a D3D12_COMMAND_LIST_TYPE_BUNDLE command list.
+        // - Vulkan: Maps to a secondary command buffer.
+        // Not supported on DX11, see Feature::Bundles.
+        bool isBundle = false;
+
+        // Creates a command list that is recorded once and then executed any number of times, until it is opened again.
+        // The upload and scratch memory, the volatile buffer versions written by the list and the resources it references
+        // stay allocated until the next open() or the destruction of the list, and all executions use the same data.
+        // Resource state transitions are recorded once, so at every execution the resources must be in the states
+        // that the list started from: use keepInitialState or permanent states for the resources it uses,
+        // or enableStateHandoff, in which case the device resolves the entry transitions at every execution.
+        // Permanent states set in a reusable list take effect at its first execution.
+        // - DX11: Requires enableImmediateExecution = false; deferred command lists can always be executed again.
+        // - DX12: Keeps the command allocator and ID3D12GraphicsCommandList until the next open().
+        // - Vulkan: Records the command buffer with VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+        //   and split transitions are executed as regular barriers at their end.
+        // Cannot be combined with isBundle.
+        bool reusable = false;
+
         CommandListParameters& setEnableImmediateExecution(bool value) { enableImmediateExecution = value; return *this; }
         CommandListParameters& setUploadChunkSize(size_t value) { uploadChunkSize = value; return *this; }
+        CommandListParameters& setUploadRingSize(size_t value) { uploadRingSize = value; return *this; }
         CommandListParameters& setScratchChunkSize(size_t value) { scratchChunkSize = value; return *this; }
         CommandListParameters& setScratchMaxMemory(size_t value) { scratchMaxMemory = value; return *this; }
         CommandListParameters& setQueueType(CommandQueue value) { queueType = value; return *this; }
+        CommandListParameters& setEnableStateHandoff(bool value) { enableStateHandoff = value; return *this; }
+        CommandListParameters& setIsBundle(bool value) { isBundle = value; return *this; }
+        CommandListParameters& setReusable(bool value) { reusable = value; return *this; }
     };
     
     //////////////////////////////////////////////////////////////////////////
@@ -3117,8 +3952,11 @@ namespace nvrhi
     //////////////////////////////////////////////////////////////////////////
 
     // Represents a sequence of GPU operations.
-    // - DX11: All command list objects map to the single immediate context. Only one command list may be in the open
-    //   state at any given time, and all command lists must have CommandListParameters::enableImmediateExecution = true.
+    // - DX11: Command lists with CommandListParameters::enableImmediateExecution = true map to the single immediate
+    //   context, and only one of them may be in the open state at any given time. Command lists created with
+    //   enableImmediateExecution = false map to deferred contexts. They produce an ID3D11CommandList on close(),
+    //   which executeCommandLists(...) replays on the immediate context, resetting its state afterwards.
+    //   Deferred command lists cannot write a part of a buffer with CPU write access.
     // - DX12: One command list object may contain multiple instances of ID3D12GraphicsCommandList* and
     //   ID3D12CommandAllocator objects, reusing older ones as they finish executing on the GPU. A command list object
     //   also contains the upload manager (for suballocating memory from the upload heap on operations such as
@@ -3137,6 +3975,9 @@ namespace nvrhi
         //   command lists from opening.
         // - DX12, Vulkan: Creates or reuses the command list or buffer object and the command allocator (DX12),
         //   starts tracking the resources being referenced in the command list.
+        // - DX12: Distinct command lists may be opened, recorded and closed on different threads concurrently.
+        //   Each command list recycles its own allocators without taking locks, so recording scales with
+        //   the number of threads as long as each thread uses its own command list.
         virtual void open() = 0;
 
         // Finalizes the command list and prepares it for execution.
@@ -3198,6 +4039,26 @@ namespace nvrhi
         virtual void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data,
             size_t rowPitch, size_t depthPitch = 0) = 0;
 
+        // Uploads several subresources of one texture, e.g. a whole mip chain or array, like a sequence of writeTexture
+        // calls but with one upload buffer suballocation and one set of barriers for all of them.
+        // - DX11: Maps to a sequence of UpdateSubresource calls.
+        // - DX12: Gets the footprints with one GetCopyableFootprints call and records the CopyTextureRegion calls back to back.
+        // - Vulkan: Maps to a single vkCmdCopyBufferToImage call with one region per subresource.
+        virtual void writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources) = 0;
+
+        // Like writeTexture, but returns the upload memory for the subresource so that the data can be produced
+        // directly in the layout that the GPU copies from, without an intermediate copy. Rows of blocks are
+        // 'outRowPitch' bytes apart and depth slices 'outDepthPitch' bytes apart. The memory may be written from
+        // any thread until endTextureWrite is called for the same subresource, which records the copy.
+        // Several subresources can be written at the same time, and all of them must be ended before close().
+        // Returns nullptr if the upload memory couldn't be allocated.
+        // - DX11: Returns CPU memory owned by the command list, endTextureWrite maps to UpdateSubresource.
+        // - DX12: The layout is returned by GetCopyableFootprints, endTextureWrite maps to CopyTextureRegion.
+        // - Vulkan: Rows are tightly packed, endTextureWrite maps to vkCmdCopyBufferToImage.
+        virtual void* beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel,
+            size_t* outRowPitch, size_t* outDepthPitch = nullptr) = 0;
+        virtual void endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) = 0;
+
         // Performs a resolve operation to combine samples from some or all subresources of a multisample texture 'src'
         // into matching subresources of a non-multisample texture 'dest'. Both textures' formats must be of color type.
         // - DX11/12: Maps to a sequence of ResolveSubresource calls, one per subresource.
@@ -3205,6 +4066,26 @@ namespace nvrhi
         virtual void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src,
             const TextureSubresourceSet& srcSubresources) = 0;
 
+        // Fills the mip levels of 'subresources' after the first one, each one downsampled from the previous level
+        // with a 2x2 box filter, or with point sampling if 'linearFilter' is false. Supported for 2D, 2D array and cube
+        // textures with normalized or float color formats, without multisampling. The mip levels are transitioned
+        // between the steps even when automatic barriers are disabled. The graphics, compute, meshlet and ray tracing
+        // states must be set again before the next draw or dispatch.
+        // - DX11/12: Dispatches a compute shader per level, which is compiled on first use with d3dcompiler_47.dll.
+        //   The texture must have the isUAV flag set and a non-sRGB format.
+        // - Vulkan: Maps to a sequence of vkCmdBlitImage calls, one per level, on a graphics queue command list.
+        //   The format must support blits, and linear filtering if 'linearFilter' is true.
+        virtual void generateMips(ITexture* texture, TextureSubresourceSet subresources = AllSubresources, bool linearFilter = true) = 0;
+
+        // Copies a 2D region of texture 'src' into a 2D region of texture 'dest', scaling it to the size of the
+        // destination region and converting between the formats of the textures, with bilinear filtering or point
+        // sampling. The textures must meet the same requirements as for generateMips, and the source and destination
+        // subresources must be different.
+        // - DX11/12: Dispatches the generateMips compute shader, 'dest' must have the isUAV flag set and a non-sRGB format.
+        // - Vulkan: Maps to a single vkCmdBlitImage call.
+        virtual void blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice,
+            bool linearFilter = true) = 0;
+
         // Uploads 'dataSize' bytes of data from CPU memory into the GPU buffer 'b' at offset 'destOffsetBytes'.
         // - DX11: If the buffer's 'cpuAccess' mode is set to Write, maps the buffer and uploads the data that way.
         //   Otherwise, uses UpdateSubresource.
@@ -3256,6 +4137,21 @@ namespace nvrhi
         // Like the other sampler feedback functions, only supported on DX12.
         virtual void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) = 0;
 
+        // Creates a binding set whose descriptors are suballocated from storage owned by the command list,
+        // for sets that are only used in the commands being recorded, such as per-frame post-processing passes.
+        // The returned object is owned by the command list: it must not be released or stored in a handle,
+        // and it may only be used in this command list until the list is closed. All transient binding sets
+        // are reclaimed together when the submitted command list instance finishes executing on the GPU.
+        // On DX12 and Vulkan, the binding set objects are recycled for later transient sets at that point,
+        // so creating a transient set doesn't allocate an object or take a reference once the pool is warm.
+        // Returns nullptr if the command list is not open or if the set cannot be created.
+        // - DX11: Creates a regular binding set that is kept alive by the command list.
+        // - DX12: Descriptor tables are suballocated linearly from chunks of the shader-visible SRV and
+        //   sampler heaps that are attached to the command list instance.
+        // - Vulkan: The descriptor set is allocated from descriptor pools attached to the command buffer,
+        //   which are reset when the command buffer is retired.
+        virtual IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) = 0;
+
         // Writes the provided data into the push constants block for the currently set pipeline.
         // A graphics, compute, ray tracing or meshlet state must be set using the corresponding call
         // (setGraphicsState etc.) before using setPushConstants. Changing the state invalidates push constants.
@@ -3278,6 +4174,18 @@ namespace nvrhi
         // state. To avoid these issues, call clearState() when switching from direct command list access to NVRHI.
         virtual void setGraphicsState(const GraphicsState& state) = 0;
 
+        // Incremental alternatives to setGraphicsState(...) that replace one part of the current graphics state.
+        // They are meant for sequences of draws that only differ in a few bindings or buffers, where building,
+        // comparing and copying a complete GraphicsState for every draw is wasteful. Each function only compares
+        // the part it replaces, and the changes are applied to the underlying API by the next draw call.
+        // setGraphicsState(...) must be called first; the pipeline, framebuffer and other parts of the state
+        // stay as they were set, and calling setGraphicsState(...) again replaces the whole state.
+        // The new objects must be compatible with the current pipeline, just like in setGraphicsState(...).
+        virtual void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) = 0;
+        virtual void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) = 0;
+        virtual void setIndexBuffer(const IndexBufferBinding& indexBuffer) = 0;
+        virtual void setViewportState(const ViewportState& viewport) = 0;
+
         // Draws non-indexed primitives using the current graphics state.
         // setGraphicsState(...) must be called between opening the command list or using other types of pipelines
         // and calling draw(...) or any of its siblings. If the pipeline uses push constants, those must be set
@@ -3315,6 +4223,34 @@ namespace nvrhi
         // - DX12: Maps to ExecuteIndirect with a predefined signature.
         // - Vulkan: Maps to vkCmdDrawIndexedIndirect.
         virtual void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) = 0;
+
+        // Draws up to maxDrawCount sets of non-indexed primitives like drawIndirect(...), where the actual number
+        // of draws is a uint32_t read by the GPU at countOffsetBytes in the indirect count buffer specified
+        // in the prior call to setGraphicsState(...).
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with a predefined signature and a count buffer.
+        // - Vulkan: Maps to vkCmdDrawIndirectCount, requires the drawIndirectCount feature of Vulkan 1.2.
+        virtual void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
+
+        // Draws up to maxDrawCount sets of indexed primitives like drawIndexedIndirect(...), where the actual number
+        // of draws is read from the indirect count buffer, see drawIndirectCount(...).
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with a predefined signature and a count buffer.
+        // - Vulkan: Maps to vkCmdDrawIndexedIndirectCount, requires the drawIndirectCount feature of Vulkan 1.2.
+        virtual void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) = 0;
+
+        // Replays closed bundles in order, see CommandListParameters::isBundle. All bundles must be recorded with
+        // the same framebuffer, and they are executed as parts of one render pass. The resources used by the
+        // bundles are transitioned into the states they require before the pass, and the framebuffer is bound.
+        // After the call, the graphics state of this command list is undefined and must be set again before
+        // the next draw.
+        // - DX12: Maps to ExecuteBundle for each bundle, with the viewports of that bundle. The bundles must be
+        //   recorded with the same shader-visible descriptor heaps as the ones currently used by the device.
+        // - Vulkan: Maps to one vkCmdExecuteCommands inside a rendering pass that is started for the bundles.
+        // Not supported on DX11.
+        virtual void executeBundles(ICommandList* const* bundles, size_t numBundles) = 0;
+
+        void executeBundle(ICommandList* bundle) { executeBundles(&bundle, 1); }
         
         // Sets the specified compute state on the command list.
         // The state includes the pipeline (or individual shaders on DX11) and all resources bound to it.
@@ -3351,9 +4287,42 @@ namespace nvrhi
         // replacing graphics with meshlets.
         // - DX11: Not supported.
         // - DX12: Maps to DispatchMesh.
-        // - Vulkan: Maps to vkCmdDispatchMesh.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksEXT. When only VK_NV_mesh_shader is available, maps to vkCmdDrawMeshTasksNV,
+        //   which only supports 1D dispatches.
         virtual void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
 
+        // Draws meshlet primitives using the parameters provided in the indirect buffer specified in the prior call
+        // to setMeshletState(...). Each dispatch is described by a DispatchIndirectArguments structure, and if
+        // dispatchCount is more than 1, the structures are tightly packed in the indirect parameter buffer.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with a predefined signature.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksIndirectEXT. When only VK_NV_mesh_shader is available, maps to
+        //   vkCmdDrawMeshTasksIndirectNV, which reads groupsX as the task count and groupsY as the first task,
+        //   so groupsY must be 0 and groupsZ is ignored.
+        virtual void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount = 1) = 0;
+
+        // Performs up to maxDispatchCount meshlet dispatches like dispatchMeshIndirect(...), where the actual number
+        // of dispatches is read from the indirect count buffer specified in the prior call to setMeshletState(...).
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect with a predefined signature and a count buffer.
+        // - Vulkan: Maps to vkCmdDrawMeshTasksIndirectCountEXT, or vkCmdDrawMeshTasksIndirectCountNV with the same
+        //   restrictions as above.
+        virtual void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) = 0;
+
+        // Executes up to maxCommandCount commands described by the signature, with the records read from the indirect
+        // params buffer at paramOffsetBytes. The pipeline state that matches the action of the signature must be set
+        // before, and if it has an indirect count buffer, the number of commands is read from it at countOffsetBytes.
+        // The state that is modified by the arguments of the signature is undefined after the call, so the
+        // graphics, compute or meshlet state must be set again before the next draw or dispatch.
+        // - DX11: Not supported.
+        // - DX12: Maps to ExecuteIndirect.
+        // - Vulkan: Signatures that consist of a single action map to vkCmd*Indirect or vkCmd*IndirectCount with the
+        //   stride of the signature. Signatures with state-changing arguments map to vkCmdExecuteGeneratedCommandsEXT
+        //   and require VK_EXT_device_generated_commands, there is no fallback without it. VolatileConstantBuffer
+        //   arguments are not supported, IndexBuffer arguments require the DXGI index buffer input mode, and the
+        //   byteStride of VertexBuffer arguments must match the stride of the input layout.
+        virtual void executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes = 0) = 0;
+
         // Sets the specified ray tracing state on the command list.
         // The state includes the shader table, which references the pipeline, and all bound resources.
         // Not supported on DX11.
@@ -3378,6 +4347,27 @@ namespace nvrhi
         // - DX12: Maps to NvAPI_D3D12_BuildRaytracingOpacityMicromapArray and requires NVAPI.
         // - Vulkan: Maps to vkCmdBuildMicromapsEXT.
         virtual void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) = 0;
+
+        // Builds several OMMs at once, see buildOpacityMicromap(...).
+        // The scratch memory for all builds is suballocated as one region, and the builds are recorded after a single
+        // set of barriers, so that the GPU can execute them concurrently. The OMMs must be distinct.
+        // If the scratch allocation fails, none of the builds is recorded.
+        // OMMs created with the AllowCompaction flag have their compacted sizes written by the build,
+        // see compactOpacityMicromaps().
+        // - DX11: Not supported.
+        // - DX12: Maps to back-to-back OMM array builds without barriers between them.
+        // - Vulkan: Maps to one vkCmdBuildMicromapsEXT call with all builds.
+        virtual void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds) = 0;
+
+        // Compacts all OMMs that are currently available for compaction, i.e. were created and built with the
+        // AllowCompaction flag by command lists that have finished executing. The compacted sizes written by the builds
+        // are read without waiting, and the OMMs are copied into new buffers of that size, which replace their storage.
+        // BLASes referencing these OMMs must be rebuilt after compaction.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyRaytracingAccelerationStructure with the COMPACT mode. Requires DXR 1.2 OMMs,
+        //   the OMMs built through NVAPI are not compacted.
+        // - Vulkan: Maps to vkCmdCopyMicromapEXT with the COMPACT mode.
+        virtual void compactOpacityMicromaps() = 0;
         
         // Builds or updates a bottom-level ray tracing acceleration structure (BLAS).
         // A temporary memory region for the build is suballocated using the scratch buffer manager attached to the
@@ -3398,10 +4388,25 @@ namespace nvrhi
         // Note that RTXMU currently doesn't support OMM or LSS.
         virtual void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries,
             size_t numGeometries, rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
+
+        // Builds or updates several BLASes at once, see buildBottomLevelAccelStruct(...) for the requirements.
+        // The scratch memory for all builds is suballocated as one region, and the builds are recorded after a single
+        // set of barriers, so that the GPU can execute them concurrently. The acceleration structures must be distinct.
+        // If any of the builds fails validation or the scratch allocation fails, none of them is recorded.
+        // - DX11: Not supported.
+        // - DX12: Maps to back-to-back BuildRaytracingAccelerationStructure calls without barriers between them.
+        // - Vulkan: Maps to one vkCmdBuildAccelerationStructuresKHR call with all builds.
+        // With RTXMU, the builds are passed to RTXMU one by one.
+        virtual void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds) = 0;
         
         // Compacts all bottom-level ray tracing acceleration structures (BLASes) that are currently available
-        // for compaction. This process is handled by the RTXMU library. If NVRHI is built without RTXMU,
-        // this function has no effect.
+        // for compaction, i.e. were built with the AllowCompaction flag by command lists that have finished executing.
+        // If NVRHI is built with RTXMU, this process is handled by the RTXMU library. Otherwise, the compacted sizes
+        // written by the builds are read without waiting, and the BLASes are copied into new buffers of that size,
+        // which replace their storage. TLASes referencing these BLASes must be rebuilt after compaction.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyRaytracingAccelerationStructure with the COMPACT mode.
+        // - Vulkan: Maps to vkCmdCopyAccelerationStructureKHR with the COMPACT mode.
         virtual void compactBottomLevelAccelStructs() = 0;
 
         // Builds or updates a top-level ray tracing acceleration structure (TLAS).
@@ -3438,8 +4443,20 @@ namespace nvrhi
             uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) = 0;
 
+        // Writes a range of instances into the instance buffer of a TLAS, see rt::IAccelStruct::getInstanceBuffer().
+        // The instances reference their BLAS'es through bottomLevelAS, like in buildTopLevelAccelStruct(...), and
+        // only the [firstInstance, firstInstance + numInstances) range of the buffer is uploaded. The referenced
+        // BLAS'es are kept alive by the TLAS until their slots are overwritten, if they track liveness.
+        // - DX11: Not supported.
+        // - DX12: Maps to CopyBufferRegion from an upload buffer.
+        // - Vulkan: Maps to vkCmdUpdateBuffer or vkCmdCopyBuffer.
+        virtual void updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance,
+            const rt::InstanceDesc* pInstances, size_t numInstances) = 0;
+
         // Converts one or several CoopVec compatible matrices between layouts in GPU memory.
         // Source and destination buffers must be different.
+        // Can be recorded into graphics and compute command lists, so that conversions can run on the compute queue
+        // asynchronously with rendering. See also coopvec::IMatrixCache, which keeps converted matrices for reuse.
         // - DX11: Not supported.
         // - DX12: Maps to ConvertLinearAlgebraMatrix.
         // - Vulkan: Maps to vkCmdConvertCooperativeVectorMatrixNV.
@@ -3461,6 +4478,90 @@ namespace nvrhi
         // - Vulkan: Maps to vkCmdWriteTimestamp.
         virtual void endTimerQuery(ITimerQuery* query) = 0;
 
+        // Starts a new frame in the timer query pool and makes its queries available for use. The frame gets the next
+        // frame index, and it reuses the queries of the frame started maxFramesInFlight frames before, whose results
+        // can no longer be retrieved after that. Cannot be used in bundles.
+        // - DX11: Not supported.
+        // - DX12: Does not record any commands.
+        // - Vulkan: Maps to vkCmdResetQueryPool.
+        virtual void beginTimerQueryFrame(ITimerQueryPool* pool) = 0;
+
+        // Starts or stops measuring GPU execution time with query 'queryIndex' of the current frame in the pool.
+        // The index must be less than TimerQueryPoolDesc::maxQueriesPerFrame, and each index may be used once per frame.
+        // Unlike with ITimerQuery, the queries of a frame may be used in several command lists, as long as they
+        // are executed before the command list where resolveTimerQueries is called for the frame.
+        // - DX11: Not supported.
+        // - DX12: Maps to EndQuery.
+        // - Vulkan: Maps to vkCmdWriteTimestamp.
+        virtual void beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) = 0;
+        virtual void endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) = 0;
+
+        // Finishes the current frame in the timer query pool. Its results become available through
+        // IDevice::getTimerQueryPoolResults once the GPU has finished executing this command list.
+        // - DX11: Not supported.
+        // - DX12: Maps to ResolveQueryData for all queries used in the frame, into a readback buffer.
+        // - Vulkan: Does not record any commands, the results are read with vkGetQueryPoolResults.
+        virtual void resolveTimerQueries(ITimerQueryPool* pool) = 0;
+
+        // Starts counting the samples that pass the depth and stencil tests with the provided occlusion query.
+        // The begin and end calls must be in the same command list, and only one occlusion query can be active
+        // at a time. Use IDevice::getOcclusionQueryResult(...) or setPredication(...) to consume the result.
+        // - DX11: Maps to Begin on an ID3D11Query, or on an ID3D11Predicate for binary queries.
+        // - DX12: Maps to BeginQuery.
+        // - Vulkan: Maps to vkCmdResetQueryPool and vkCmdBeginQuery. The query is active outside of render passes,
+        //   so the begin and end calls finish the current render pass.
+        virtual void beginOcclusionQuery(IOcclusionQuery* query) = 0;
+
+        // Stops counting samples with the provided occlusion query.
+        // - DX11: Maps to End.
+        // - DX12: Maps to EndQuery and ResolveQueryData into a readback buffer.
+        // - Vulkan: Maps to vkCmdEndQuery.
+        virtual void endOcclusionQuery(IOcclusionQuery* query) = 0;
+
+        // Starts collecting pipeline statistics with the provided query, see Feature::PipelineStatisticsQueries.
+        // The begin and end calls must be in the same command list, and only one pipeline statistics query
+        // can be active at a time.
+        // - DX11: Maps to Begin on an ID3D11Query.
+        // - DX12: Maps to BeginQuery.
+        // - Vulkan: Maps to vkCmdResetQueryPool and vkCmdBeginQuery. Only supported on the graphics queue,
+        //   and like occlusion queries, the begin and end calls finish the current render pass.
+        virtual void beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query) = 0;
+
+        // Stops collecting pipeline statistics with the provided query.
+        // - DX11: Maps to End.
+        // - DX12: Maps to EndQuery and ResolveQueryData into a readback buffer.
+        // - Vulkan: Maps to vkCmdEndQuery.
+        virtual void endPipelineStatisticsQuery(IPipelineStatisticsQuery* query) = 0;
+
+        // Makes the following draw, dispatch and clear commands conditional on the result of an occlusion query
+        // that was ended earlier on the GPU timeline, without reading the result on the CPU.
+        // Copy commands are not predicated. Passing a NULL query disables predication.
+        // Predication is disabled automatically when the command list is closed. See Feature::Predication.
+        // - DX11: Maps to SetPredication; the query must be binary.
+        // - DX12: Maps to ResolveQueryData into a predication buffer and SetPredication.
+        // - Vulkan: Maps to vkCmdCopyQueryPoolResults and vkCmdBeginConditionalRenderingEXT (VK_EXT_conditional_rendering).
+        virtual void setPredication(IOcclusionQuery* query, PredicationOp op = PredicationOp::SkipIfZero) = 0;
+
+        // Returns a sync point that is signaled when the GPU has finished executing the commands recorded so far.
+        // The command list is split at this point, so the previous commands can be waited for by command lists
+        // on other queues with waitSyncPoint while the rest of this command list may still be executing.
+        // The graphics, compute and binding state is reset by the split and has to be set again.
+        // Queries and predication cannot be active at this point.
+        // - DX11: Not supported.
+        // - DX12: Splits the ID3D12GraphicsCommandList and maps to ID3D12CommandQueue::Signal between the parts.
+        // - Vulkan: Splits the VkCommandBuffer and signals the queue's timeline semaphore between the parts.
+        virtual SyncPointHandle signalSyncPoint() = 0;
+
+        // Makes the commands recorded after this call wait until the GPU reaches the sync point, which may be
+        // signaled by a command list on another queue. Only the provided pipeline stages are blocked (VK).
+        // The command list signaling the point must be executed before this one. Like with signalSyncPoint,
+        // the command list is split and its state is reset. Resource states are tracked like with
+        // IDevice::queueWaitForCommandList, each command list transitions the resources it uses itself.
+        // - DX11: Not supported.
+        // - DX12: Maps to ID3D12CommandQueue::Wait between the parts of the command list, the stages are ignored.
+        // - Vulkan: Maps to a semaphore wait with the stage mask in vkQueueSubmit(2) between the parts.
+        virtual void waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages = PipelineStages::All) = 0;
+
         // Places a debug marker denoting the beginning of a range of commands in the command list.
         // Use endMarker() to denote the end of the range. Ranges may be nested, i.e. calling beginMarker(...)
         // multiple times, followed by multiple endMarker(), is allowed.
@@ -3552,6 +4653,33 @@ namespace nvrhi
         // Has no effect on DX11.
         virtual void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) = 0;
 
+        // Begins a split transition of the texture into the given state, so that the GPU can perform the transition
+        // while executing unrelated work. The transition is completed automatically at the next use of the texture
+        // in this command list, or when the command list is closed. Until then, the texture must not be accessed.
+        // Split transitions are only performed on entire textures in a known, uniform state; in other cases,
+        // this works like setTextureState(...).
+        // DX12 uses BEGIN_ONLY and END_ONLY barriers, Vulkan uses events with synchronization2.
+        // Has no effect on DX11.
+        virtual void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources,
+            ResourceStates stateBits) = 0;
+
+        // Begins a split transition of the buffer into the given state.
+        // See the comment to beginTextureStateTransition(...) for more information.
+        // Has no effect on DX11.
+        virtual void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) = 0;
+
+        // Places an aliasing barrier between two textures or buffers bound to overlapping ranges of the same heap.
+        // After the barrier, resourceAfter can be used, and resourceBefore must not be used until another aliasing
+        // barrier activates it again. The contents of resourceAfter are undefined after the barrier.
+        // resourceBefore may be nullptr, which means any resource that overlaps with resourceAfter.
+        // - DX12: Maps to a D3D12_RESOURCE_BARRIER_TYPE_ALIASING barrier. If resourceAfter is a render target or
+        //   depth-stencil texture, it is also transitioned to the RenderTarget or DepthWrite state and discarded,
+        //   which D3D12 requires before its first use.
+        // - Vulkan: Places a memory barrier, and the next transition of resourceAfter, if it's a texture,
+        //   starts from the undefined layout.
+        // Has no effect on DX11.
+        virtual void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) = 0;
+
         // Flushes the barriers from the pending list into the graphics API command list.
         // Has no effect on DX11.
         virtual void commitBarriers() = 0;
@@ -3572,10 +4700,154 @@ namespace nvrhi
 
         // Returns the CommandListParameters structure that was used to create the command list. 
         virtual const CommandListParameters& getDesc() = 0;
+
+        // Returns the upload and scratch chunks owned by this command list, including the upload ring.
+        // Used bytes are the parts of the chunks written since they were last recycled;
+        // chunks are only freed when the command list is destroyed. Other categories are empty.
+        virtual MemoryStatistics getMemoryStatistics() = 0;
     };
 
     typedef RefCountPtr<ICommandList> CommandListHandle;
 
+    //////////////////////////////////////////////////////////////////////////
+    // IAsyncPipeline
+    //////////////////////////////////////////////////////////////////////////
+
+    // A pipeline that is compiled on the device's pipeline compiler threads, see IDevice::createGraphicsPipelineAsync.
+    // The number of threads is set by the backend's DeviceDesc::pipelineCompilerThreadCount.
+    template<typename TPipeline>
+    class IAsyncPipeline : public IResource
+    {
+    public:
+        // Returns true once the compilation has finished, successfully or not.
+        [[nodiscard]] virtual bool isReady() = 0;
+
+        // Blocks until the compilation has finished. Returns the pipeline, or nullptr if it could not be created.
+        virtual TPipeline* wait() = 0;
+
+        // Returns the compiled pipeline if it's ready, otherwise the fallback pipeline passed at creation time.
+        // This is the binding-time policy: pass the result to GraphicsState::setPipeline and friends,
+        // and skip the draw or dispatch when it is nullptr, i.e. when no fallback was provided.
+        [[nodiscard]] virtual TPipeline* getPipeline() = 0;
+    };
+
+    typedef IAsyncPipeline<IGraphicsPipeline> IAsyncGraphicsPipeline;
+    typedef IAsyncPipeline<IComputePipeline> IAsyncComputePipeline;
+    typedef IAsyncPipeline<IMeshletPipeline> IAsyncMeshletPipeline;
+    typedef RefCountPtr<IAsyncGraphicsPipeline> AsyncGraphicsPipelineHandle;
+    typedef RefCountPtr<IAsyncComputePipeline> AsyncComputePipelineHandle;
+    typedef RefCountPtr<IAsyncMeshletPipeline> AsyncMeshletPipelineHandle;
+
+    namespace rt
+    {
+        typedef nvrhi::IAsyncPipeline<IPipeline> IAsyncPipeline;
+        typedef RefCountPtr<IAsyncPipeline> AsyncPipelineHandle;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Storage queues
+    //////////////////////////////////////////////////////////////////////////
+
+    enum class StorageCompression : uint8_t
+    {
+        None,
+
+        // GDeflate streams as written by the DirectStorage GDeflate codec, decompressed by the GPU.
+        // Requires Feature::GpuDecompression.
+        GDeflate
+    };
+
+    // Row pitch alignment of the texture data in storage files, see StorageRequest.
+    static constexpr uint32_t c_StorageTextureRowPitchAlignment = 256;
+
+    // A file opened with IStorageQueue::openFile. Only usable with the queue that opened it.
+    class IStorageFile : public IResource
+    {
+    public:
+        [[nodiscard]] virtual uint64_t getSize() const = 0;
+    };
+    typedef RefCountPtr<IStorageFile> StorageFileHandle;
+
+    // Loads a range of a file into a range of a buffer or into one texture subresource.
+    // The destinations must be created with keepInitialState: they are transitioned to CopyDest for the write and
+    // returned to their initial states, typically ShaderResource for streamed assets, when the request completes.
+    // Texture data is stored as rows of blocks with a pitch aligned to c_StorageTextureRowPitchAlignment bytes,
+    // and the depth slices of 3D textures follow each other. This is the layout of the footprints returned by
+    // D3D12 GetCopyableFootprints, so the padding of the last row may be left out.
+    struct StorageRequest
+    {
+        IStorageFile* file = nullptr;
+        uint64_t fileOffset = 0;
+
+        // Size of the range in the file, i.e. the compressed size of compressed requests.
+        uint32_t sourceSize = 0;
+
+        // Size of the data after decompression. Not used by uncompressed requests.
+        uint32_t uncompressedSize = 0;
+
+        StorageCompression compression = StorageCompression::None;
+
+        // Either a buffer or a texture destination must be set.
+        IBuffer* destBuffer = nullptr;
+        uint64_t destOffset = 0;
+
+        ITexture* destTexture = nullptr;
+        uint32_t arraySlice = 0;
+        uint32_t mipLevel = 0;
+
+        StorageRequest& setFile(IStorageFile* value) { file = value; return *this; }
+        StorageRequest& setFileOffset(uint64_t value) { fileOffset = value; return *this; }
+        StorageRequest& setSourceSize(uint32_t value) { sourceSize = value; return *this; }
+        StorageRequest& setUncompressedSize(uint32_t value) { uncompressedSize = value; return *this; }
+        StorageRequest& setCompression(StorageCompression value) { compression = value; return *this; }
+        StorageRequest& setDestBuffer(IBuffer* value, uint64_t offset = 0) { destBuffer = value; destOffset = offset; return *this; }
+        StorageRequest& setDestTexture(ITexture* value, uint32_t slice = 0, uint32_t mip = 0) { destTexture = value; arraySlice = slice; mipLevel = mip; return *this; }
+    };
+
+    struct StorageQueueDesc
+    {
+        // The queue that writes the loaded data into the destinations, which must support their initial states.
+        CommandQueue queue = CommandQueue::Graphics;
+
+        // Size of the device memory that receives the file data on DX12 with DirectStorage and on Vulkan with
+        // GPU decompression, before it's copied into the destinations. Also limits the size of a single request.
+        uint64_t stagingSize = 64 * 1024 * 1024;
+
+        // Number of requests that can be in flight in the DirectStorage queue, see DSTORAGE_QUEUE_DESC::Capacity.
+        uint16_t capacity = 1024;
+
+        std::string debugName;
+
+        StorageQueueDesc& setQueue(CommandQueue value) { queue = value; return *this; }
+        StorageQueueDesc& setStagingSize(uint64_t value) { stagingSize = value; return *this; }
+        StorageQueueDesc& setCapacity(uint16_t value) { capacity = value; return *this; }
+        StorageQueueDesc& setDebugName(const std::string& value) { debugName = value; return *this; }
+    };
+
+    // Loads file ranges into buffers and textures. On DX12 built with DirectStorage (NVRHI_WITH_DIRECTSTORAGE),
+    // the files are read and decompressed by DirectStorage. On Vulkan with VK_NV_memory_decompression (and its
+    // memoryDecompression feature) and buffer device addresses, the files are read on the CPU and decompressed by the GPU. Otherwise, submit reads the files on the calling thread and
+    // only uncompressed requests are supported.
+    // The methods of a queue must not be called from several threads at the same time.
+    class IStorageQueue : public IResource
+    {
+    public:
+        [[nodiscard]] virtual const StorageQueueDesc& getDesc() const = 0;
+
+        // Returns nullptr if the file cannot be opened.
+        virtual StorageFileHandle openFile(const char* path) = 0;
+
+        // Adds a request to the next submit. The request is validated immediately, and rejected with an error if invalid.
+        virtual void enqueueRequest(const StorageRequest& request) = 0;
+
+        // Starts the requests enqueued since the previous submit. The completion query, if any, is set when they have
+        // completed and their destinations have been transitioned, see IDevice::setEventQuery.
+        // Returns the instance of the command list executed on StorageQueueDesc::queue for the requests, which other
+        // queues can wait for with IDevice::queueWaitForCommandList, or 0 if there was nothing to submit.
+        virtual uint64_t submit(IEventQuery* completion = nullptr) = 0;
+    };
+    typedef RefCountPtr<IStorageQueue> StorageQueueHandle;
+
     //////////////////////////////////////////////////////////////////////////
     // IDevice
     //////////////////////////////////////////////////////////////////////////
@@ -3600,11 +4872,20 @@ namespace nvrhi
         virtual void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) = 0;
         virtual void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
 
+        // Maps or unmaps ranges of a buffer created with isTiled. The mappings are applied in order on the queue,
+        // after the work submitted to it before, and the work using the new mappings must run after them.
+        // The contents of newly mapped ranges are undefined.
+        // - DX12: Maps to ID3D12CommandQueue::UpdateTileMappings.
+        // - Vulkan: Maps to vkQueueBindSparse; the queue must support sparse binding.
+        // - DX11: Unsupported.
+        virtual void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
+
         virtual SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) = 0;
         virtual SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) = 0;
 
         virtual BufferHandle createBuffer(const BufferDesc& d) = 0;
         virtual void* mapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess) = 0;
+        virtual void* mapBuffer(IBuffer* buffer, CpuAccessMode cpuAccess, MapBufferFlags flags) = 0;
         virtual void unmapBuffer(IBuffer* buffer) = 0;
         virtual MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) = 0;
         virtual bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) = 0;
@@ -3612,6 +4893,10 @@ namespace nvrhi
         virtual BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) = 0;
 
         virtual ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) = 0;
+        // Creates a variant of the shader with the given specialization constant values. On Vulkan, these are
+        // specialization constants applied at pipeline creation. On DX11 and DX12, the variant is a precompiled shader
+        // returned by DeviceDesc::shaderPermutationProvider. Supported if Feature::ShaderSpecializations is.
+        // With DeviceDesc::enableObjectDeduplication, equal specializations of a shader return the same object.
         virtual ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) = 0;
         virtual ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) = 0;
         
@@ -3634,6 +4919,33 @@ namespace nvrhi
         virtual float getTimerQueryTime(ITimerQuery* query) = 0;
         virtual void resetTimerQuery(ITimerQuery* query) = 0;
 
+        // Occlusion queries - see also begin/endOcclusionQuery and setPredication in ICommandList
+        virtual OcclusionQueryHandle createOcclusionQuery(OcclusionQueryType type) = 0;
+        virtual bool pollOcclusionQuery(IOcclusionQuery* query) = 0;
+        // returns the number of samples that passed, waits for the query to finish if necessary
+        virtual uint64_t getOcclusionQueryResult(IOcclusionQuery* query) = 0;
+        virtual void resetOcclusionQuery(IOcclusionQuery* query) = 0;
+
+        // Pipeline statistics queries - see also begin/endPipelineStatisticsQuery in ICommandList
+        virtual PipelineStatisticsQueryHandle createPipelineStatisticsQuery() = 0;
+        virtual bool pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query) = 0;
+        // waits for the query to finish if necessary
+        virtual PipelineStatistics getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query) = 0;
+        virtual void resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query) = 0;
+
+        // Timer query pools - see also beginTimerQueryFrame, begin/endTimerQuery and resolveTimerQueries in ICommandList
+        virtual TimerQueryPoolHandle createTimerQueryPool(const TimerQueryPoolDesc& desc) = 0;
+
+        // Writes the times in seconds measured by the first numQueries queries of the frame to pTimes, without waiting.
+        // Returns false if the frame has not finished executing on the GPU yet, or if its queries have been reused
+        // by a newer frame. The times of the queries that were not used in the frame are 0 on Vulkan and undefined on DX12.
+        virtual bool getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries) = 0;
+
+        // Same as getTimerQueryPoolResults, but writes the begin and end timestamps of each query in seconds,
+        // 2 * numQueries values in total. The timestamps share the GPU clock of the pool's queue; the values
+        // of the queries that were not used in the frame are 0.
+        virtual bool getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries) = 0;
+
         // Returns the API kind that the RHI backend is running on top of.
         virtual GraphicsAPI getGraphicsAPI() = 0;
         
@@ -3652,6 +4964,18 @@ namespace nvrhi
         virtual MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) = 0;
 
         virtual rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) = 0;
+
+        // Asynchronous versions of the pipeline creation functions above. They return immediately, and the pipeline
+        // is created on a worker thread. The descriptors are copied, so they may be modified or released afterwards.
+        // The fallback pipeline, if any, is returned by IAsyncPipeline::getPipeline until the compilation finishes.
+        // Compilations that have not started when the device is destroyed are cancelled and complete with nullptr.
+        virtual AsyncGraphicsPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback = nullptr) = 0;
+        virtual AsyncComputePipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback = nullptr) = 0;
+        virtual AsyncMeshletPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback = nullptr) = 0;
+        virtual rt::AsyncPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback = nullptr) = 0;
+
+        // Creates a signature for ICommandList::executeIndirect.
+        virtual CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) = 0;
         
         virtual BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) = 0;
         virtual BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) = 0;
@@ -3662,6 +4986,11 @@ namespace nvrhi
         virtual void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) = 0;
         virtual bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) = 0;
 
+        // Writes several items at once, which is much cheaper than writing them one by one:
+        // one descriptor update on Vulkan and one copy into the shader-visible heap on DX12.
+        // Returns false if any of the items could not be written; the other items are still written.
+        virtual bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems) = 0;
+
         virtual rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) = 0;
         virtual rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) = 0;
         virtual MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) = 0;
@@ -3671,6 +5000,10 @@ namespace nvrhi
         virtual CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) = 0;
         virtual uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) = 0;
         virtual void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) = 0;
+
+        // Creates a queue that loads file ranges into buffers and textures, see IStorageQueue.
+        virtual StorageQueueHandle createStorageQueue(const StorageQueueDesc& desc) = 0;
+
         // returns true if the wait completes successfully, false if detecting a problem (e.g. device removal)
         virtual bool waitForIdle() = 0;
 
@@ -3678,6 +5011,20 @@ namespace nvrhi
         // IMPORTANT: Call this method at least once per frame.
         virtual void runGarbageCollection() = 0;
 
+        // Returns the video memory budget and usage of the process.
+        // Returns false if the device cannot query them, e.g. on Vulkan without VK_EXT_memory_budget.
+        virtual bool getVideoMemoryBudget(VideoMemoryBudget& outBudget) = 0;
+
+        // Returns the memory allocated by NVRHI on this device, by category. The command list chunks are
+        // included with their allocated sizes, see ICommandList::getMemoryStatistics for their usage.
+        // On DX11, texture sizes are estimated from their descriptions.
+        virtual MemoryStatistics getMemoryStatistics() = 0;
+
+        // Sets the residency priority of a texture, buffer or heap. Resources placed in heaps or shared memory blocks
+        // are paged together with them, so set the priority of the heap instead. On Vulkan, this requires
+        // VK_EXT_pageable_device_local_memory, and the priority of a suballocated resource applies to its whole block.
+        virtual void setResidencyPriority(IResource* resource, ResidencyPriority priority) = 0;
+
         virtual bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) = 0;
 
         virtual FormatSupport queryFormatSupport(Format format) = 0;
@@ -3688,8 +5035,23 @@ namespace nvrhi
         // Calculates and returns the on-device size for a CoopVec matrix of the given dimensions, type and layout.
         virtual size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) = 0;
 
+        // Batched version of getCoopVecMatrixSize, writes numDescs sizes to outSizes.
+        // The DX12 and Vulkan devices cache the sizes returned by the driver, so repeated queries for the same
+        // type, layout and dimensions don't call into the driver again.
+        virtual void getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes) = 0;
+
         virtual Object getNativeQueue(ObjectType objectType, CommandQueue queue) = 0;
 
+        // Serializes the device's pipeline cache (VkPipelineCache on Vulkan, ID3D12PipelineLibrary on DX12) so that
+        // it can be stored on disk and passed to a later device through DeviceDesc::initialPipelineCacheData.
+        // Returns false if the device has no pipeline cache.
+        virtual bool getPipelineCacheData(std::vector<uint8_t>& outData) = 0;
+
+        // Merges a cache blob produced by another device on the same adapter and driver, e.g. one used by a worker
+        // that pre-compiles pipelines, into this device's cache. Incompatible blobs are rejected and false is returned.
+        // Must not be called concurrently with pipeline creation on the same device.
+        virtual bool mergePipelineCacheData(const void* data, size_t size) = 0;
+
         virtual IMessageCallback* getMessageCallback() = 0;
 
         virtual bool isAftermathEnabled() = 0;
@@ -3786,6 +5148,7 @@ namespace std
             nvrhi::hash_combine(hash, s.depthFormat);
             nvrhi::hash_combine(hash, s.sampleCount);
             nvrhi::hash_combine(hash, s.sampleQuality);
+            nvrhi::hash_combine(hash, s.hasShadingRateAttachment);
             return hash;
         }
     };
@@ -3831,4 +5194,144 @@ namespace std
             return hash;
         }
     };
+
+    template<> struct hash<nvrhi::RasterState>
+    {
+        std::size_t operator()(nvrhi::RasterState const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.fillMode);
+            nvrhi::hash_combine(hash, s.cullMode);
+            nvrhi::hash_combine(hash, s.frontCounterClockwise);
+            nvrhi::hash_combine(hash, s.depthClipEnable);
+            nvrhi::hash_combine(hash, s.scissorEnable);
+            nvrhi::hash_combine(hash, s.multisampleEnable);
+            nvrhi::hash_combine(hash, s.antialiasedLineEnable);
+            nvrhi::hash_combine(hash, s.depthBias);
+            nvrhi::hash_combine(hash, s.depthBiasClamp);
+            nvrhi::hash_combine(hash, s.slopeScaledDepthBias);
+            nvrhi::hash_combine(hash, s.forcedSampleCount);
+            nvrhi::hash_combine(hash, s.programmableSamplePositionsEnable);
+            nvrhi::hash_combine(hash, s.conservativeRasterEnable);
+            nvrhi::hash_combine(hash, s.quadFillEnable);
+            for (int i = 0; i < 16; i++)
+            {
+                nvrhi::hash_combine(hash, s.samplePositionsX[i]);
+                nvrhi::hash_combine(hash, s.samplePositionsY[i]);
+            }
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::DepthStencilState::StencilOpDesc>
+    {
+        std::size_t operator()(nvrhi::DepthStencilState::StencilOpDesc const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.failOp);
+            nvrhi::hash_combine(hash, s.depthFailOp);
+            nvrhi::hash_combine(hash, s.passOp);
+            nvrhi::hash_combine(hash, s.stencilFunc);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::DepthStencilState>
+    {
+        std::size_t operator()(nvrhi::DepthStencilState const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.depthTestEnable);
+            nvrhi::hash_combine(hash, s.depthWriteEnable);
+            nvrhi::hash_combine(hash, s.depthFunc);
+            nvrhi::hash_combine(hash, s.stencilEnable);
+            nvrhi::hash_combine(hash, s.stencilReadMask);
+            nvrhi::hash_combine(hash, s.stencilWriteMask);
+            nvrhi::hash_combine(hash, s.stencilRefValue);
+            nvrhi::hash_combine(hash, s.dynamicStencilRef);
+            nvrhi::hash_combine(hash, s.frontFaceStencil);
+            nvrhi::hash_combine(hash, s.backFaceStencil);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::SinglePassStereoState>
+    {
+        std::size_t operator()(nvrhi::SinglePassStereoState const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.enabled);
+            nvrhi::hash_combine(hash, s.independentViewportMask);
+            nvrhi::hash_combine(hash, s.renderTargetIndexOffset);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::RenderState>
+    {
+        std::size_t operator()(nvrhi::RenderState const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.blendState);
+            nvrhi::hash_combine(hash, s.depthStencilState);
+            nvrhi::hash_combine(hash, s.rasterState);
+            nvrhi::hash_combine(hash, s.singlePassStereo);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::GraphicsPipelineDesc>
+    {
+        std::size_t operator()(nvrhi::GraphicsPipelineDesc const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.primType);
+            nvrhi::hash_combine(hash, s.patchControlPoints);
+            nvrhi::hash_combine(hash, s.inputLayout);
+            nvrhi::hash_combine(hash, s.VS);
+            nvrhi::hash_combine(hash, s.HS);
+            nvrhi::hash_combine(hash, s.DS);
+            nvrhi::hash_combine(hash, s.GS);
+            nvrhi::hash_combine(hash, s.PS);
+            nvrhi::hash_combine(hash, s.renderState);
+            nvrhi::hash_combine(hash, s.shadingRateState);
+            for (const auto& layout : s.bindingLayouts)
+                nvrhi::hash_combine(hash, layout);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::ComputePipelineDesc>
+    {
+        std::size_t operator()(nvrhi::ComputePipelineDesc const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.CS);
+            for (const auto& layout : s.bindingLayouts)
+                nvrhi::hash_combine(hash, layout);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::SamplerDesc>
+    {
+        std::size_t operator()(nvrhi::SamplerDesc const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.borderColor.r);
+            nvrhi::hash_combine(hash, s.borderColor.g);
+            nvrhi::hash_combine(hash, s.borderColor.b);
+            nvrhi::hash_combine(hash, s.borderColor.a);
+            nvrhi::hash_combine(hash, s.maxAnisotropy);
+            nvrhi::hash_combine(hash, s.mipBias);
+            nvrhi::hash_combine(hash, s.minFilter);
+            nvrhi::hash_combine(hash, s.magFilter);
+            nvrhi::hash_combine(hash, s.mipFilter);
+            nvrhi::hash_combine(hash, s.addressU);
+            nvrhi::hash_combine(hash, s.addressV);
+            nvrhi::hash_combine(hash, s.addressW);
+            nvrhi::hash_combine(hash, s.reductionType);
+            return hash;
+        }
+    };
 }
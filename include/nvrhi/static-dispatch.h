@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+// StaticCommandList is only available when NVRHI is configured with NVRHI_STATIC_DISPATCH set to a backend,
+// which defines NVRHI_STATIC_DISPATCH=1 for the nvrhi target and its users.
+#if NVRHI_STATIC_DISPATCH
+
+namespace nvrhi
+{
+    // A non-virtual view of a command list created by the backend that was selected with NVRHI_STATIC_DISPATCH.
+    // The methods call the final backend implementation directly, without the virtual call through ICommandList,
+    // so that the compiler can inline them with link-time optimization. The methods behave like the
+    // ICommandList methods with the same names. Other calls go through getInterface().
+    // The view does not hold a reference: the command list must stay alive while the view is used.
+    class StaticCommandList
+    {
+    public:
+        StaticCommandList() = default;
+
+        // Returns an empty view if the command list is not a command list of the static dispatch backend,
+        // for example when it is created by the validation layer or the capture layer.
+        NVRHI_API explicit StaticCommandList(ICommandList* commandList);
+
+        [[nodiscard]] explicit operator bool() const { return m_Implementation != nullptr; }
+        [[nodiscard]] ICommandList* getInterface() const { return m_Interface; }
+
+        NVRHI_API void open() const;
+        NVRHI_API void close() const;
+        NVRHI_API void clearState() const;
+
+        NVRHI_API void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) const;
+        NVRHI_API void setPushConstants(const void* data, size_t byteSize) const;
+
+        NVRHI_API void setGraphicsState(const GraphicsState& state) const;
+        NVRHI_API void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) const;
+        NVRHI_API void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) const;
+        NVRHI_API void setIndexBuffer(const IndexBufferBinding& indexBuffer) const;
+        NVRHI_API void setViewportState(const ViewportState& viewport) const;
+        NVRHI_API void draw(const DrawArguments& args) const;
+        NVRHI_API void drawIndexed(const DrawArguments& args) const;
+        NVRHI_API void drawIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) const;
+        NVRHI_API void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount = 1) const;
+
+        NVRHI_API void setComputeState(const ComputeState& state) const;
+        NVRHI_API void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) const;
+        NVRHI_API void dispatchIndirect(uint32_t offsetBytes) const;
+
+        NVRHI_API void setMeshletState(const MeshletState& state) const;
+        NVRHI_API void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) const;
+
+        NVRHI_API void setRayTracingState(const rt::State& state) const;
+        NVRHI_API void dispatchRays(const rt::DispatchRaysArguments& args) const;
+
+        NVRHI_API void beginMarker(const char* name) const;
+        NVRHI_API void endMarker() const;
+
+        NVRHI_API void setResourceStatesForBindingSet(IBindingSet* bindingSet) const;
+        NVRHI_API void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) const;
+        NVRHI_API void setBufferState(IBuffer* buffer, ResourceStates stateBits) const;
+        NVRHI_API void commitBarriers() const;
+
+    private:
+        ICommandList* m_Interface = nullptr;
+
+        // The backend command list object, which is not a complete type outside of the backend
+        void* m_Implementation = nullptr;
+    };
+}
+
+#endif // NVRHI_STATIC_DISPATCH
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <nvrhi/nvrhi.h>
 
@@ -109,6 +111,10 @@ namespace nvrhi::utils
     void NotSupported();
     void InvalidEnum();
 
+    // Allocates integer indices in the range [0, capacity).
+    // The allocation state is stored as 64-bit words, one bit per index, with a summary level that marks
+    // full words, so that free indices are found with a few bit scans. When 'multithreaded' is set,
+    // allocate and release are lock-free and use atomic compare-and-swap on the words.
     class BitSetAllocator
     {
     public:
@@ -116,13 +122,21 @@ namespace nvrhi::utils
 
         int allocate();
         void release(int index);
-        [[nodiscard]] size_t getCapacity() const { return m_Allocated.size(); }
+        [[nodiscard]] size_t getCapacity() const { return m_Capacity; }
 
     private:
-        int m_NextAvailable = 0;
-        std::vector<bool> m_Allocated;
+        // One bit per index, set when allocated. Bits past the capacity in the last word are always set.
+        std::unique_ptr<std::atomic<uint64_t>[]> m_Words;
+        // One bit per word of m_Words, set when that word is full.
+        std::unique_ptr<std::atomic<uint64_t>[]> m_FullWords;
+        size_t m_Capacity = 0;
+        size_t m_NumWords = 0;
+        size_t m_NumSummaryWords = 0;
+        std::atomic<size_t> m_SearchStart = 0; // index into m_FullWords where the search begins
         bool m_MultiThreaded;
-        std::mutex m_Mutex;
+
+        bool allocateInWord(size_t wordIndex, int& outIndex);
+        void setWordFull(size_t wordIndex, bool full);
     };
 
     // Automatic begin/end marker for command list
@@ -26,5 +26,32 @@
 
 namespace nvrhi::validation
 {
+    enum class ValidationLevel : uint8_t
+    {
+        // Only the checks that keep the backend from crashing or from recording into the wrong command list:
+        // open and closed command list state, queue types, and null pipelines and framebuffers.
+        Minimal,
+
+        // The Minimal checks on every call, and the binding, framebuffer and vertex buffer checks
+        // of state-setting calls on one in samplingInterval calls of each command list.
+        Sampled,
+
+        // Every check on every call.
+        Full
+    };
+
+    struct ValidationLayerDesc
+    {
+        ValidationLevel level = ValidationLevel::Full;
+
+        // With ValidationLevel::Sampled, the expensive checks run on the first state-setting call of a command list
+        // and then on one in this many calls.
+        uint32_t samplingInterval = 64;
+
+        constexpr ValidationLayerDesc& setLevel(ValidationLevel value) { level = value; return *this; }
+        constexpr ValidationLayerDesc& setSamplingInterval(uint32_t value) { samplingInterval = value; return *this; }
+    };
+
     NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice);
+    NVRHI_API DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc);
 }
@@ -41,8 +41,20 @@ namespace nvrhi::vulkan
         // Additional Vulkan-specific public methods
         virtual VkSemaphore getQueueSemaphore(CommandQueue queue) = 0;
         virtual void queueWaitForSemaphore(CommandQueue waitQueue, VkSemaphore semaphore, uint64_t value) = 0;
+
+        // Variants of the wait functions that only block the given pipeline stages of the waiting queue on the semaphore.
+        // The other variants wait with VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT. Without VK_KHR_synchronization2,
+        // only the stages that fit into VkPipelineStageFlags are used.
+        virtual void queueWaitForSemaphore(CommandQueue waitQueue, VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 waitStageMask) = 0;
+        using nvrhi::IDevice::queueWaitForCommandList;
+        virtual void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance, VkPipelineStageFlags2 waitStageMask) = 0;
+
         virtual void queueSignalSemaphore(CommandQueue executionQueue, VkSemaphore semaphore, uint64_t value) = 0;
         virtual uint64_t queueGetCompletedInstance(CommandQueue queue) = 0;
+
+        // Frees the shared memory blocks that have no resources placed in them, see DeviceDesc::enableMemorySuballocation.
+        // Returns the number of bytes released.
+        virtual uint64_t releaseEmptyMemoryBlocks() = 0;
     };
 
     typedef RefCountPtr<IDevice> DeviceHandle;
@@ -72,12 +84,88 @@ namespace nvrhi::vulkan
         size_t numDeviceExtensions = 0;
 
         uint32_t maxTimerQueries = 256;
+        uint32_t maxOcclusionQueries = 256;
+        uint32_t maxPipelineStatisticsQueries = 64;
+
+        // Number of BLAS'es created with AllowCompaction that can wait for compaction at the same time,
+        // see ICommandList::compactBottomLevelAccelStructs. Not used when NVRHI is built with RTXMU.
+        // The same number of OMMs can wait for ICommandList::compactOpacityMicromaps.
+        uint32_t maxCompactedSizeQueries = 1024;
 
         // Indicates if VkPhysicalDeviceVulkan12Features::bufferDeviceAddress was set to 'true' at device creation time
         bool bufferDeviceAddressSupported = false;
+        // Indicate if VkPhysicalDeviceFeatures::pipelineStatisticsQuery and occlusionQueryPrecise were set to 'true' at device creation time.
+        // Conditional rendering is used if VK_EXT_conditional_rendering is in the device extension list.
+        bool pipelineStatisticsQuerySupported = false;
+        bool occlusionQueryPreciseSupported = false;
+        // Indicate if VkPhysicalDeviceVulkan12Features::descriptorBindingPartiallyBound, descriptorBindingUpdateUnusedWhilePending
+        // and the descriptorBinding*UpdateAfterBind features of the descriptor types used in bindless layouts were set to 'true'
+        // at device creation time. Bindless layouts and descriptor tables are then created with UPDATE_AFTER_BIND, so that
+        // the descriptors that are not used by the GPU can be written while command lists using the table are in flight,
+        // like IBindlessResourceRegistry::flush does. Not used with enableDescriptorBuffer, which allows that anyway.
+        bool descriptorUpdateAfterBindSupported = false;
         bool aftermathEnabled = false;
         bool logBufferLifetime = false;
 
+        // If enabled, binding sets allocate their descriptor sets from shared descriptor pools owned by the device,
+        // grouped by the descriptor counts of their layouts, instead of creating a VkDescriptorPool per binding set.
+        // Sets released by binding sets are recycled once the GPU work submitted before their release completes.
+        bool enableDescriptorPoolAllocator = false;
+
+        // Number of binding sets that fit into each shared descriptor pool when enableDescriptorPoolAllocator is set.
+        uint32_t descriptorSetsPerPool = 256;
+
+        // If enabled, buffers and textures that are not shared, not too large and don't need dedicated allocations
+        // are placed into shared device memory blocks instead of getting one VkDeviceMemory each.
+        // For such resources, the VK_DeviceMemory native object is the block's memory, and the resource doesn't start at offset 0.
+        bool enableMemorySuballocation = false;
+
+        // Size of the shared memory blocks when enableMemorySuballocation is set.
+        // Blocks are made smaller in small memory heaps, and resources larger than half a block get dedicated allocations.
+        uint64_t memoryBlockSize = 256 * 1024 * 1024;
+
+        // Optional contents of a pipeline cache previously returned by IDevice::getPipelineCacheData.
+        // The header is checked against the physical device, and an incompatible blob is ignored with a warning.
+        // The data is only read during createDevice and may be freed afterwards.
+        const void* initialPipelineCacheData = nullptr;
+        size_t initialPipelineCacheDataSize = 0;
+
+        // Number of threads that compile the pipelines created with IDevice::create*PipelineAsync, started on first use.
+        // 0 selects half of the hardware threads.
+        uint32_t pipelineCompilerThreadCount = 0;
+
+        // Return the existing pipeline, sampler or shader specialization when one is created again with equal parameters.
+        // Shaders and layouts are compared by identity; unused entries are released by runGarbageCollection.
+        bool enableObjectDeduplication = false;
+
+        // If enabled, binding sets and descriptor tables keep their descriptors in a descriptor buffer owned by the device
+        // instead of descriptor sets. Requires VK_EXT_descriptor_buffer with the descriptorBuffer feature enabled, and
+        // buffer device addresses; falls back to descriptor sets with a warning otherwise. The robustBufferAccess feature
+        // must not be enabled in this mode. Descriptor tables start with zero capacity like on D3D12 and are sized
+        // with resizeDescriptorTable. The VK_DescriptorSet native objects of binding sets and tables are null.
+        bool enableDescriptorBuffer = false;
+
+        // Size of the descriptor buffer when enableDescriptorBuffer is set, clamped to the device limits.
+        uint64_t descriptorBufferSize = 32 * 1024 * 1024;
+
+        // If enabled, the device tracks which device-local memory allocations are used by the submitted command lists.
+        // When runGarbageCollection finds that the device-local memory usage exceeds the budget, the least recently
+        // used allocations get the lowest memory priority, lowest residency priority first, so that the driver pages
+        // them out before the others, and their priority is restored when a submitted command list uses them again.
+        // Requires VK_EXT_memory_budget and VK_EXT_pageable_device_local_memory with the pageableDeviceLocalMemory feature.
+        bool enableResidencyManagement = false;
+
+        // Called by runGarbageCollection when the device-local memory usage exceeds the budget.
+        // Requires VK_EXT_memory_budget.
+        IMemoryBudgetCallback* budgetCallback = nullptr;
+
+        // Receives the allocations counted by IDevice::getMemoryStatistics
+        IMemoryAllocationCallback* memoryAllocationCallback = nullptr;
+
+        // Object types whose native objects and memory are released from runGarbageCollection
+        // rather than in the thread that releases the last reference.
+        DeferredDestructionFlags deferredDestruction = DeferredDestructionFlags::None;
+
         std::string vulkanLibraryName; // if empty, use default
     };
 
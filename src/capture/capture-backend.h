@@ -0,0 +1,353 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "capture-stream.h"
+
+#include <mutex>
+
+namespace nvrhi::capture
+{
+    class DeviceWrapper;
+
+    class CommandListWrapper : public RefCounter<ICommandList>
+    {
+    public:
+        friend class DeviceWrapper;
+
+        CommandListWrapper(DeviceWrapper* device, ICommandList* commandList);
+
+    protected:
+        CommandListHandle m_CommandList;
+        RefCountPtr<DeviceWrapper> m_Device;
+
+        // Records of the commands since open(), written to the file as one recording on close()
+        StreamWriter m_Stream;
+
+        // The subresources between beginTextureWrite and endTextureWrite, written as writeTexture calls
+        struct PendingTextureWrite
+        {
+            ITexture* texture = nullptr;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            const void* data = nullptr;
+            size_t rowPitch = 0;
+            size_t depthPitch = 0;
+        };
+        std::vector<PendingTextureWrite> m_PendingTextureWrites;
+
+        void recordWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch);
+        void recordUnsupported(const char* function);
+        ICommandList* getUnderlyingCommandList() const { return m_CommandList; }
+
+    public:
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor) override;
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources) override;
+        void* beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch) override;
+        void endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter) override;
+        void blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter) override;
+
+        void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+
+        void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
+        void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format) override;
+        void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) override;
+        void setIndexBuffer(const IndexBufferBinding& indexBuffer) override;
+        void setViewportState(const ViewportState& viewport) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void executeBundles(ICommandList* const* bundles, size_t numBundles) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes)  override;
+
+        void setMeshletState(const MeshletState& state) override;
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes) override;
+
+        void setRayTracingState(const rt::State& state) override;
+        void dispatchRays(const rt::DispatchRaysArguments& args) override;
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds) override;
+        void compactBottomLevelAccelStructs() override;
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
+        void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
+
+        void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+        void beginTimerQueryFrame(ITimerQueryPool* pool) override;
+        void beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimerQueries(ITimerQueryPool* pool) override;
+        void beginOcclusionQuery(IOcclusionQuery* query) override;
+        void endOcclusionQuery(IOcclusionQuery* query) override;
+        void beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void endPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void setPredication(IOcclusionQuery* query, PredicationOp op) override;
+        SyncPointHandle signalSyncPoint() override;
+        void waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages) override;
+
+        void beginMarker(const char* name) override;
+        void endMarker() override;
+
+        void setEnableAutomaticBarriers(bool enable) override;
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override;
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
+        void commitBarriers() override;
+        
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
+        ResourceStates getBufferState(IBuffer* buffer) override;
+
+        IDevice* getDevice() override;
+        const CommandListParameters& getDesc() override;
+        MemoryStatistics getMemoryStatistics() override;
+    };
+
+    class DeviceWrapper : public RefCounter<IDevice>
+    {
+    public:
+        friend class CommandListWrapper;
+
+        DeviceWrapper(IDevice* device);
+        ~DeviceWrapper() override;
+
+        bool open(const CaptureLayerDesc& desc);
+
+    protected:
+        DeviceHandle m_Device;
+        IMessageCallback* m_MessageCallback;
+
+        std::mutex m_FileMutex;
+        MappedFileWriter m_File;
+
+        // Buffers and staging textures mapped for writing, whose contents are captured when they are unmapped
+        struct MappedBuffer
+        {
+            void* data = nullptr;
+        };
+        struct MappedStagingTexture
+        {
+            void* data = nullptr;
+            TextureSlice slice;
+            size_t rowPitch = 0;
+        };
+        std::mutex m_MappingMutex;
+        std::unordered_map<IBuffer*, MappedBuffer> m_MappedBuffers;
+        std::unordered_map<IStagingTexture*, MappedStagingTexture> m_MappedStagingTextures;
+
+        void error(const std::string& messageText) const;
+
+        void writeRecords(const StreamWriter& stream);
+        void writeCommandListRecording(ICommandList* commandList, const StreamWriter& commands);
+        void recordUnsupported(const char* function);
+
+    public:
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+        void unmapStagingTexture(IStagingTexture* tex) override;
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+
+        SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+        SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags) override;
+        void unmapBuffer(IBuffer* b) override;
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        // event queries
+        EventQueryHandle createEventQuery() override;
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override;
+        bool pollEventQuery(IEventQuery* query) override;
+        void waitEventQuery(IEventQuery* query) override;
+        void resetEventQuery(IEventQuery* query) override;
+
+        // timer queries
+        TimerQueryHandle createTimerQuery() override;
+        bool pollTimerQuery(ITimerQuery* query) override;
+        float getTimerQueryTime(ITimerQuery* query) override;
+        void resetTimerQuery(ITimerQuery* query) override;
+        TimerQueryPoolHandle createTimerQueryPool(const TimerQueryPoolDesc& desc) override;
+        bool getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries) override;
+        bool getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries) override;
+        OcclusionQueryHandle createOcclusionQuery(OcclusionQueryType type) override;
+        bool pollOcclusionQuery(IOcclusionQuery* query) override;
+        uint64_t getOcclusionQueryResult(IOcclusionQuery* query) override;
+        void resetOcclusionQuery(IOcclusionQuery* query) override;
+        PipelineStatisticsQueryHandle createPipelineStatisticsQuery() override;
+        bool pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        PipelineStatistics getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query) override;
+        void resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+
+        GraphicsAPI getGraphicsAPI() override;
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        AsyncGraphicsPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback = nullptr) override;
+        AsyncComputePipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback = nullptr) override;
+        AsyncMeshletPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback = nullptr) override;
+        rt::AsyncPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback = nullptr) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc)  override;
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        StorageQueueHandle createStorageQueue(const StorageQueueDesc& desc) override;
+        bool waitForIdle() override;
+        void runGarbageCollection() override;
+        bool getVideoMemoryBudget(VideoMemoryBudget& outBudget) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void setResidencyPriority(IResource* resource, ResidencyPriority priority) override;
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
+        FormatSupport queryFormatSupport(Format format) override;
+        coopvec::DeviceFeatures queryCoopVecFeatures() override;
+        size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        void getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes) override;
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& outData) override;
+        bool mergePipelineCacheData(const void* data, size_t size) override;
+        IMessageCallback* getMessageCallback() override;
+        bool isAftermathEnabled() override;
+        AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override;
+    };
+
+} // namespace nvrhi::capture
@@ -0,0 +1,933 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+namespace nvrhi::capture
+{
+    CommandListWrapper::CommandListWrapper(DeviceWrapper* device, ICommandList* commandList)
+        : m_CommandList(commandList)
+        , m_Device(device)
+    {
+
+    }
+
+    void CommandListWrapper::recordWriteTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        if (!dest || !data)
+            return;
+
+        m_Stream.beginRecord(Opcode::WriteTexture);
+        m_Stream.writeObject(dest);
+        m_Stream.write(arraySlice);
+        m_Stream.write(mipLevel);
+        m_Stream.write(uint64_t(rowPitch));
+        m_Stream.write(uint64_t(depthPitch));
+        m_Stream.writeBlob(data, getTextureWriteSize(dest->getDesc(), mipLevel, rowPitch, depthPitch));
+        m_Stream.endRecord();
+    }
+
+    void CommandListWrapper::recordUnsupported(const char* function)
+    {
+        // Unsupported commands are written into the device stream, where the replay counts them
+        m_Device->recordUnsupported(function);
+    }
+
+    Object CommandListWrapper::getNativeObject(ObjectType objectType)
+    {
+        return m_CommandList->getNativeObject(objectType);
+    }
+
+    void CommandListWrapper::open()
+    {
+        m_Stream.clear();
+        m_PendingTextureWrites.clear();
+
+        m_CommandList->open();
+    }
+
+    void CommandListWrapper::close()
+    {
+        m_CommandList->close();
+
+        m_Device->writeCommandListRecording(this, m_Stream);
+        m_Stream.clear();
+    }
+
+    void CommandListWrapper::clearState()
+    {
+        m_Stream.beginRecord(Opcode::ClearState);
+        m_Stream.endRecord();
+
+        m_CommandList->clearState();
+    }
+
+    void CommandListWrapper::clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        m_Stream.beginRecord(Opcode::ClearTextureFloat);
+        m_Stream.writeObject(t);
+        m_Stream.write(subresources);
+        m_Stream.write(clearColor);
+        m_Stream.endRecord();
+
+        m_CommandList->clearTextureFloat(t, subresources, clearColor);
+    }
+
+    void CommandListWrapper::clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        m_Stream.beginRecord(Opcode::ClearDepthStencilTexture);
+        m_Stream.writeObject(t);
+        m_Stream.write(subresources);
+        m_Stream.write(clearDepth);
+        m_Stream.write(depth);
+        m_Stream.write(clearStencil);
+        m_Stream.write(stencil);
+        m_Stream.endRecord();
+
+        m_CommandList->clearDepthStencilTexture(t, subresources, clearDepth, depth, clearStencil, stencil);
+    }
+
+    void CommandListWrapper::clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        m_Stream.beginRecord(Opcode::ClearTextureUInt);
+        m_Stream.writeObject(t);
+        m_Stream.write(subresources);
+        m_Stream.write(clearColor);
+        m_Stream.endRecord();
+
+        m_CommandList->clearTextureUInt(t, subresources, clearColor);
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        m_Stream.beginRecord(Opcode::CopyTexture);
+        m_Stream.writeObject(dest);
+        m_Stream.write(destSlice);
+        m_Stream.writeObject(src);
+        m_Stream.write(srcSlice);
+        m_Stream.endRecord();
+
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        m_Stream.beginRecord(Opcode::CopyTextureToStaging);
+        m_Stream.writeObject(dest);
+        m_Stream.write(destSlice);
+        m_Stream.writeObject(src);
+        m_Stream.write(srcSlice);
+        m_Stream.endRecord();
+
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice)
+    {
+        m_Stream.beginRecord(Opcode::CopyTextureFromStaging);
+        m_Stream.writeObject(dest);
+        m_Stream.write(destSlice);
+        m_Stream.writeObject(src);
+        m_Stream.write(srcSlice);
+        m_Stream.endRecord();
+
+        m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
+    }
+
+    void CommandListWrapper::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        recordWriteTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+
+        m_CommandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+    }
+
+    void CommandListWrapper::writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources)
+    {
+        // Replayed as one writeTexture call per subresource
+        for (size_t index = 0; subresources && index < numSubresources; index++)
+        {
+            const TextureSubresourceData& subresource = subresources[index];
+            recordWriteTexture(dest, subresource.arraySlice, subresource.mipLevel, subresource.data, subresource.rowPitch, subresource.depthPitch);
+        }
+
+        m_CommandList->writeTextureSubresources(dest, subresources, numSubresources);
+    }
+
+    void* CommandListWrapper::beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch)
+    {
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+        void* data = m_CommandList->beginTextureWrite(dest, arraySlice, mipLevel, &rowPitch, &depthPitch);
+
+        if (data)
+        {
+            PendingTextureWrite write;
+            write.texture = dest;
+            write.arraySlice = arraySlice;
+            write.mipLevel = mipLevel;
+            write.data = data;
+            write.rowPitch = rowPitch;
+            write.depthPitch = depthPitch;
+            m_PendingTextureWrites.push_back(write);
+        }
+
+        if (outRowPitch)
+            *outRowPitch = rowPitch;
+        if (outDepthPitch)
+            *outDepthPitch = depthPitch;
+
+        return data;
+    }
+
+    void CommandListWrapper::endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        for (auto it = m_PendingTextureWrites.begin(); it != m_PendingTextureWrites.end(); ++it)
+        {
+            if (it->texture == dest && it->arraySlice == arraySlice && it->mipLevel == mipLevel)
+            {
+                // The data is complete now, and stays valid until the command list is executed
+                recordWriteTexture(dest, arraySlice, mipLevel, it->data, it->rowPitch, it->depthPitch);
+                m_PendingTextureWrites.erase(it);
+                break;
+            }
+        }
+
+        m_CommandList->endTextureWrite(dest, arraySlice, mipLevel);
+    }
+
+    void CommandListWrapper::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
+    {
+        m_Stream.beginRecord(Opcode::ResolveTexture);
+        m_Stream.writeObject(dest);
+        m_Stream.write(dstSubresources);
+        m_Stream.writeObject(src);
+        m_Stream.write(srcSubresources);
+        m_Stream.endRecord();
+
+        m_CommandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
+    }
+
+    void CommandListWrapper::generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter)
+    {
+        m_Stream.beginRecord(Opcode::GenerateMips);
+        m_Stream.writeObject(texture);
+        m_Stream.write(subresources);
+        m_Stream.write(linearFilter);
+        m_Stream.endRecord();
+
+        m_CommandList->generateMips(texture, subresources, linearFilter);
+    }
+
+    void CommandListWrapper::blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter)
+    {
+        m_Stream.beginRecord(Opcode::BlitTexture);
+        m_Stream.writeObject(dest);
+        m_Stream.write(destSlice);
+        m_Stream.writeObject(src);
+        m_Stream.write(srcSlice);
+        m_Stream.write(linearFilter);
+        m_Stream.endRecord();
+
+        m_CommandList->blitTexture(dest, destSlice, src, srcSlice, linearFilter);
+    }
+
+    void CommandListWrapper::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        m_Stream.beginRecord(Opcode::WriteBuffer);
+        m_Stream.writeObject(b);
+        m_Stream.write(destOffsetBytes);
+        m_Stream.writeBlob(data, data ? dataSize : 0);
+        m_Stream.endRecord();
+
+        m_CommandList->writeBuffer(b, data, dataSize, destOffsetBytes);
+    }
+
+    void CommandListWrapper::clearBufferUInt(IBuffer* b, uint32_t clearValue)
+    {
+        m_Stream.beginRecord(Opcode::ClearBufferUInt);
+        m_Stream.writeObject(b);
+        m_Stream.write(clearValue);
+        m_Stream.endRecord();
+
+        m_CommandList->clearBufferUInt(b, clearValue);
+    }
+
+    void CommandListWrapper::copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        m_Stream.beginRecord(Opcode::CopyBuffer);
+        m_Stream.writeObject(dest);
+        m_Stream.write(destOffsetBytes);
+        m_Stream.writeObject(src);
+        m_Stream.write(srcOffsetBytes);
+        m_Stream.write(dataSizeBytes);
+        m_Stream.endRecord();
+
+        m_CommandList->copyBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+    }
+
+    void CommandListWrapper::clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture)
+    {
+        recordUnsupported("clearSamplerFeedbackTexture");
+        m_CommandList->clearSamplerFeedbackTexture(texture);
+    }
+
+    void CommandListWrapper::decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format)
+    {
+        recordUnsupported("decodeSamplerFeedbackTexture");
+        m_CommandList->decodeSamplerFeedbackTexture(buffer, texture, format);
+    }
+
+    void CommandListWrapper::setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits)
+    {
+        recordUnsupported("setSamplerFeedbackTextureState");
+        m_CommandList->setSamplerFeedbackTextureState(texture, stateBits);
+    }
+
+    IBindingSet* CommandListWrapper::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        IBindingSet* bindingSet = m_CommandList->createTransientBindingSet(desc, layout);
+
+        if (bindingSet)
+        {
+            m_Stream.beginRecord(Opcode::CreateTransientBindingSet);
+            m_Stream.writeObject(bindingSet);
+            writeBindingSetDesc(m_Stream, desc);
+            m_Stream.writeObject(layout);
+            m_Stream.endRecord();
+        }
+
+        return bindingSet;
+    }
+
+    void CommandListWrapper::setPushConstants(const void* data, size_t byteSize)
+    {
+        m_Stream.beginRecord(Opcode::SetPushConstants);
+        m_Stream.writeBlob(data, data ? byteSize : 0);
+        m_Stream.endRecord();
+
+        m_CommandList->setPushConstants(data, byteSize);
+    }
+
+    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        m_Stream.beginRecord(Opcode::SetGraphicsState);
+        writeGraphicsState(m_Stream, state);
+        m_Stream.endRecord();
+
+        m_CommandList->setGraphicsState(state);
+    }
+
+    void CommandListWrapper::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        m_Stream.beginRecord(Opcode::SetGraphicsBindingSet);
+        m_Stream.write(slot);
+        m_Stream.writeObject(bindingSet);
+        m_Stream.endRecord();
+
+        m_CommandList->setGraphicsBindingSet(slot, bindingSet);
+    }
+
+    void CommandListWrapper::setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers)
+    {
+        m_Stream.beginRecord(Opcode::SetVertexBuffers);
+        writeVertexBuffers(m_Stream, vertexBuffers, vertexBuffers ? numVertexBuffers : 0);
+        m_Stream.endRecord();
+
+        m_CommandList->setVertexBuffers(vertexBuffers, numVertexBuffers);
+    }
+
+    void CommandListWrapper::setIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_Stream.beginRecord(Opcode::SetIndexBuffer);
+        writeIndexBuffer(m_Stream, indexBuffer);
+        m_Stream.endRecord();
+
+        m_CommandList->setIndexBuffer(indexBuffer);
+    }
+
+    void CommandListWrapper::setViewportState(const ViewportState& viewport)
+    {
+        m_Stream.beginRecord(Opcode::SetViewportState);
+        writeViewportState(m_Stream, viewport);
+        m_Stream.endRecord();
+
+        m_CommandList->setViewportState(viewport);
+    }
+
+    void CommandListWrapper::draw(const DrawArguments& args)
+    {
+        m_Stream.beginRecord(Opcode::Draw);
+        m_Stream.write(args);
+        m_Stream.endRecord();
+
+        m_CommandList->draw(args);
+    }
+
+    void CommandListWrapper::drawIndexed(const DrawArguments& args)
+    {
+        m_Stream.beginRecord(Opcode::DrawIndexed);
+        m_Stream.write(args);
+        m_Stream.endRecord();
+
+        m_CommandList->drawIndexed(args);
+    }
+
+    void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        m_Stream.beginRecord(Opcode::DrawIndirect);
+        m_Stream.write(offsetBytes);
+        m_Stream.write(drawCount);
+        m_Stream.endRecord();
+
+        m_CommandList->drawIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        m_Stream.beginRecord(Opcode::DrawIndexedIndirect);
+        m_Stream.write(offsetBytes);
+        m_Stream.write(drawCount);
+        m_Stream.endRecord();
+
+        m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
+    }
+
+    void CommandListWrapper::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        m_Stream.beginRecord(Opcode::DrawIndirectCount);
+        m_Stream.write(paramOffsetBytes);
+        m_Stream.write(countOffsetBytes);
+        m_Stream.write(maxDrawCount);
+        m_Stream.endRecord();
+
+        m_CommandList->drawIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        m_Stream.beginRecord(Opcode::DrawIndexedIndirectCount);
+        m_Stream.write(paramOffsetBytes);
+        m_Stream.write(countOffsetBytes);
+        m_Stream.write(maxDrawCount);
+        m_Stream.endRecord();
+
+        m_CommandList->drawIndexedIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::executeBundles(ICommandList* const* bundles, size_t numBundles)
+    {
+        std::vector<ICommandList*> unwrappedBundles;
+        unwrappedBundles.resize(numBundles);
+
+        m_Stream.beginRecord(Opcode::ExecuteBundles);
+        m_Stream.write(uint64_t(bundles ? numBundles : 0));
+        for (size_t i = 0; bundles && i < numBundles; i++)
+        {
+            m_Stream.writeObject(bundles[i]);
+
+            CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(bundles[i]);
+            unwrappedBundles[i] = wrapper ? wrapper->getUnderlyingCommandList() : bundles[i];
+        }
+        m_Stream.endRecord();
+
+        m_CommandList->executeBundles(bundles ? unwrappedBundles.data() : nullptr, numBundles);
+    }
+
+    void CommandListWrapper::setComputeState(const ComputeState& state)
+    {
+        m_Stream.beginRecord(Opcode::SetComputeState);
+        writeComputeState(m_Stream, state);
+        m_Stream.endRecord();
+
+        m_CommandList->setComputeState(state);
+    }
+
+    void CommandListWrapper::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        m_Stream.beginRecord(Opcode::Dispatch);
+        m_Stream.write(groupsX);
+        m_Stream.write(groupsY);
+        m_Stream.write(groupsZ);
+        m_Stream.endRecord();
+
+        m_CommandList->dispatch(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchIndirect(uint32_t offsetBytes)
+    {
+        m_Stream.beginRecord(Opcode::DispatchIndirect);
+        m_Stream.write(offsetBytes);
+        m_Stream.endRecord();
+
+        m_CommandList->dispatchIndirect(offsetBytes);
+    }
+
+    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    {
+        recordUnsupported("setMeshletState");
+        m_CommandList->setMeshletState(state);
+    }
+
+    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        recordUnsupported("dispatchMesh");
+        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        recordUnsupported("dispatchMeshIndirect");
+        m_CommandList->dispatchMeshIndirect(offsetBytes, dispatchCount);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        recordUnsupported("dispatchMeshIndirectCount");
+        m_CommandList->dispatchMeshIndirectCount(paramOffsetBytes, countOffsetBytes, maxDispatchCount);
+    }
+
+    void CommandListWrapper::executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes)
+    {
+        recordUnsupported("executeIndirect");
+        m_CommandList->executeIndirect(signature, paramOffsetBytes, maxCommandCount, countOffsetBytes);
+    }
+
+    void CommandListWrapper::setRayTracingState(const rt::State& state)
+    {
+        recordUnsupported("setRayTracingState");
+        m_CommandList->setRayTracingState(state);
+    }
+
+    void CommandListWrapper::dispatchRays(const rt::DispatchRaysArguments& args)
+    {
+        recordUnsupported("dispatchRays");
+        m_CommandList->dispatchRays(args);
+    }
+
+    void CommandListWrapper::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
+    {
+        recordUnsupported("buildOpacityMicromap");
+        m_CommandList->buildOpacityMicromap(omm, desc);
+    }
+
+    void CommandListWrapper::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds)
+    {
+        recordUnsupported("buildOpacityMicromaps");
+        m_CommandList->buildOpacityMicromaps(builds, numBuilds);
+    }
+
+    void CommandListWrapper::compactOpacityMicromaps()
+    {
+        recordUnsupported("compactOpacityMicromaps");
+        m_CommandList->compactOpacityMicromaps();
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        m_Stream.beginRecord(Opcode::BuildBottomLevelAccelStruct);
+        m_Stream.writeObject(as);
+        writeGeometryDescs(m_Stream, pGeometries, numGeometries);
+        m_Stream.write(buildFlags);
+        m_Stream.endRecord();
+
+        m_CommandList->buildBottomLevelAccelStruct(as, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds)
+    {
+        m_Stream.beginRecord(Opcode::BuildBottomLevelAccelStructs);
+        m_Stream.write(uint64_t(numBuilds));
+        for (size_t index = 0; index < numBuilds; index++)
+        {
+            m_Stream.writeObject(builds[index].accelStruct);
+            writeGeometryDescs(m_Stream, builds[index].geometries, builds[index].numGeometries);
+            m_Stream.write(builds[index].buildFlags);
+        }
+        m_Stream.endRecord();
+
+        m_CommandList->buildBottomLevelAccelStructs(builds, numBuilds);
+    }
+
+    void CommandListWrapper::compactBottomLevelAccelStructs()
+    {
+        m_Stream.beginRecord(Opcode::CompactBottomLevelAccelStructs);
+        m_Stream.endRecord();
+
+        m_CommandList->compactBottomLevelAccelStructs();
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        m_Stream.beginRecord(Opcode::BuildTopLevelAccelStruct);
+        m_Stream.writeObject(as);
+        writeInstanceDescs(m_Stream, pInstances, numInstances);
+        m_Stream.write(buildFlags);
+        m_Stream.endRecord();
+
+        m_CommandList->buildTopLevelAccelStruct(as, pInstances, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        // Other instance buffers hold BLAS device addresses that are not valid on replay
+        if (as && instanceBuffer && instanceBuffer == as->getInstanceBuffer())
+        {
+            m_Stream.beginRecord(Opcode::BuildTopLevelAccelStructFromBuffer);
+            m_Stream.writeObject(as);
+            m_Stream.write(instanceBufferOffset);
+            m_Stream.write(uint64_t(numInstances));
+            m_Stream.write(buildFlags);
+            m_Stream.endRecord();
+        }
+        else
+            recordUnsupported("buildTopLevelAccelStructFromBuffer");
+
+        m_CommandList->buildTopLevelAccelStructFromBuffer(as, instanceBuffer, instanceBufferOffset, numInstances, buildFlags);
+    }
+
+    void CommandListWrapper::updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        m_Stream.beginRecord(Opcode::UpdateTopLevelAccelStructInstances);
+        m_Stream.writeObject(as);
+        m_Stream.write(uint64_t(firstInstance));
+        writeInstanceDescs(m_Stream, pInstances, numInstances);
+        m_Stream.endRecord();
+
+        m_CommandList->updateTopLevelAccelStructInstances(as, firstInstance, pInstances, numInstances);
+    }
+
+    void CommandListWrapper::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
+    {
+        recordUnsupported("executeMultiIndirectClusterOperation");
+        m_CommandList->executeMultiIndirectClusterOperation(desc);
+    }
+
+    void CommandListWrapper::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
+    {
+        recordUnsupported("convertCoopVecMatrices");
+        m_CommandList->convertCoopVecMatrices(convertDescs, numDescs);
+    }
+
+    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    {
+        m_Stream.beginRecord(Opcode::BeginTimerQuery);
+        m_Stream.writeObject(query);
+        m_Stream.endRecord();
+
+        m_CommandList->beginTimerQuery(query);
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
+    {
+        m_Stream.beginRecord(Opcode::EndTimerQuery);
+        m_Stream.writeObject(query);
+        m_Stream.endRecord();
+
+        m_CommandList->endTimerQuery(query);
+    }
+
+    void CommandListWrapper::beginTimerQueryFrame(ITimerQueryPool* pool)
+    {
+        recordUnsupported("beginTimerQueryFrame");
+        m_CommandList->beginTimerQueryFrame(pool);
+    }
+
+    void CommandListWrapper::beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex)
+    {
+        recordUnsupported("beginTimerQuery");
+        m_CommandList->beginTimerQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex)
+    {
+        recordUnsupported("endTimerQuery");
+        m_CommandList->endTimerQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::resolveTimerQueries(ITimerQueryPool* pool)
+    {
+        recordUnsupported("resolveTimerQueries");
+        m_CommandList->resolveTimerQueries(pool);
+    }
+
+    void CommandListWrapper::beginOcclusionQuery(IOcclusionQuery* query)
+    {
+        m_Stream.beginRecord(Opcode::BeginOcclusionQuery);
+        m_Stream.writeObject(query);
+        m_Stream.endRecord();
+
+        m_CommandList->beginOcclusionQuery(query);
+    }
+
+    void CommandListWrapper::endOcclusionQuery(IOcclusionQuery* query)
+    {
+        m_Stream.beginRecord(Opcode::EndOcclusionQuery);
+        m_Stream.writeObject(query);
+        m_Stream.endRecord();
+
+        m_CommandList->endOcclusionQuery(query);
+    }
+
+    void CommandListWrapper::beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        m_Stream.beginRecord(Opcode::BeginPipelineStatisticsQuery);
+        m_Stream.writeObject(query);
+        m_Stream.endRecord();
+
+        m_CommandList->beginPipelineStatisticsQuery(query);
+    }
+
+    void CommandListWrapper::endPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        m_Stream.beginRecord(Opcode::EndPipelineStatisticsQuery);
+        m_Stream.writeObject(query);
+        m_Stream.endRecord();
+
+        m_CommandList->endPipelineStatisticsQuery(query);
+    }
+
+    void CommandListWrapper::setPredication(IOcclusionQuery* query, PredicationOp op)
+    {
+        m_Stream.beginRecord(Opcode::SetPredication);
+        m_Stream.writeObject(query);
+        m_Stream.write(op);
+        m_Stream.endRecord();
+
+        m_CommandList->setPredication(query, op);
+    }
+
+    SyncPointHandle CommandListWrapper::signalSyncPoint()
+    {
+        SyncPointHandle syncPoint = m_CommandList->signalSyncPoint();
+
+        if (syncPoint)
+        {
+            m_Stream.beginRecord(Opcode::SignalSyncPoint);
+            m_Stream.writeObject(syncPoint);
+            m_Stream.endRecord();
+        }
+
+        return syncPoint;
+    }
+
+    void CommandListWrapper::waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages)
+    {
+        m_Stream.beginRecord(Opcode::WaitSyncPoint);
+        m_Stream.writeObject(syncPoint);
+        m_Stream.write(waitStages);
+        m_Stream.endRecord();
+
+        m_CommandList->waitSyncPoint(syncPoint, waitStages);
+    }
+
+    void CommandListWrapper::beginMarker(const char* name)
+    {
+        m_Stream.beginRecord(Opcode::BeginMarker);
+        m_Stream.writeString(name ? name : "");
+        m_Stream.endRecord();
+
+        m_CommandList->beginMarker(name);
+    }
+
+    void CommandListWrapper::endMarker()
+    {
+        m_Stream.beginRecord(Opcode::EndMarker);
+        m_Stream.endRecord();
+
+        m_CommandList->endMarker();
+    }
+
+    void CommandListWrapper::setEnableAutomaticBarriers(bool enable)
+    {
+        m_Stream.beginRecord(Opcode::SetEnableAutomaticBarriers);
+        m_Stream.write(enable);
+        m_Stream.endRecord();
+
+        m_CommandList->setEnableAutomaticBarriers(enable);
+    }
+
+    void CommandListWrapper::setResourceStatesForBindingSet(IBindingSet* bindingSet)
+    {
+        m_Stream.beginRecord(Opcode::SetResourceStatesForBindingSet);
+        m_Stream.writeObject(bindingSet);
+        m_Stream.endRecord();
+
+        m_CommandList->setResourceStatesForBindingSet(bindingSet);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers)
+    {
+        m_Stream.beginRecord(Opcode::SetEnableUavBarriersForTexture);
+        m_Stream.writeObject(texture);
+        m_Stream.write(enableBarriers);
+        m_Stream.endRecord();
+
+        m_CommandList->setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandListWrapper::setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers)
+    {
+        m_Stream.beginRecord(Opcode::SetEnableUavBarriersForBuffer);
+        m_Stream.writeObject(buffer);
+        m_Stream.write(enableBarriers);
+        m_Stream.endRecord();
+
+        m_CommandList->setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandListWrapper::beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::BeginTrackingTextureState);
+        m_Stream.writeObject(texture);
+        m_Stream.write(subresources);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::BeginTrackingBufferState);
+        m_Stream.writeObject(buffer);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::SetTextureState);
+        m_Stream.writeObject(texture);
+        m_Stream.write(subresources);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->setTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::setBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::SetBufferState);
+        m_Stream.writeObject(buffer);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->setBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::SetAccelStructState);
+        m_Stream.writeObject(as);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->setAccelStructState(as, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentTextureState(ITexture* texture, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::SetPermanentTextureState);
+        m_Stream.writeObject(texture);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->setPermanentTextureState(texture, stateBits);
+    }
+
+    void CommandListWrapper::setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::SetPermanentBufferState);
+        m_Stream.writeObject(buffer);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->setPermanentBufferState(buffer, stateBits);
+    }
+
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::BeginTextureStateTransition);
+        m_Stream.writeObject(texture);
+        m_Stream.write(subresources);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->beginTextureStateTransition(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits)
+    {
+        m_Stream.beginRecord(Opcode::BeginBufferStateTransition);
+        m_Stream.writeObject(buffer);
+        m_Stream.write(stateBits);
+        m_Stream.endRecord();
+
+        m_CommandList->beginBufferStateTransition(buffer, stateBits);
+    }
+
+    void CommandListWrapper::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        m_Stream.beginRecord(Opcode::AliasingBarrier);
+        m_Stream.writeObject(resourceBefore);
+        m_Stream.writeObject(resourceAfter);
+        m_Stream.endRecord();
+
+        m_CommandList->aliasingBarrier(resourceBefore, resourceAfter);
+    }
+
+    void CommandListWrapper::commitBarriers()
+    {
+        m_Stream.beginRecord(Opcode::CommitBarriers);
+        m_Stream.endRecord();
+
+        m_CommandList->commitBarriers();
+    }
+
+    ResourceStates CommandListWrapper::getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        return m_CommandList->getTextureSubresourceState(texture, arraySlice, mipLevel);
+    }
+
+    ResourceStates CommandListWrapper::getBufferState(IBuffer* buffer)
+    {
+        return m_CommandList->getBufferState(buffer);
+    }
+
+    IDevice* CommandListWrapper::getDevice()
+    {
+        return m_Device;
+    }
+
+    const CommandListParameters& CommandListWrapper::getDesc()
+    {
+        return m_CommandList->getDesc();
+    }
+
+    MemoryStatistics CommandListWrapper::getMemoryStatistics()
+    {
+        return m_CommandList->getMemoryStatistics();
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,988 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-backend.h"
+
+namespace nvrhi::capture
+{
+    DeviceHandle createCaptureLayer(IDevice* underlyingDevice, const CaptureLayerDesc& desc)
+    {
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice);
+        DeviceHandle handle = DeviceHandle::Create(wrapper);
+
+        if (!wrapper->open(desc))
+            return nullptr;
+
+        return handle;
+    }
+
+    DeviceWrapper::DeviceWrapper(IDevice* device)
+        : m_Device(device)
+        , m_MessageCallback(device->getMessageCallback())
+    {
+
+    }
+
+    DeviceWrapper::~DeviceWrapper()
+    {
+        m_File.close();
+    }
+
+    bool DeviceWrapper::open(const CaptureLayerDesc& desc)
+    {
+        if (!m_File.open(desc.fileName, desc.mappingSize))
+        {
+            error("Cannot create the capture file '" + desc.fileName + "'");
+            return false;
+        }
+
+        const FileHeader header;
+        m_File.write(&header, sizeof(header));
+        return true;
+    }
+
+    void DeviceWrapper::error(const std::string& messageText) const
+    {
+        m_MessageCallback->message(MessageSeverity::Error, messageText.c_str());
+    }
+
+    void DeviceWrapper::writeRecords(const StreamWriter& stream)
+    {
+        std::lock_guard lockGuard(m_FileMutex);
+
+        if (!m_File.write(stream.data(), stream.size()))
+            error("Cannot write to the capture file, the capture is incomplete");
+    }
+
+    void DeviceWrapper::writeCommandListRecording(ICommandList* commandList, const StreamWriter& commands)
+    {
+        // Write the record header and the commands directly to avoid copying the commands into another stream
+        StreamWriter header;
+        header.write(Opcode::CommandListRecording);
+        header.write(uint64_t(sizeof(ObjectKey) + sizeof(uint64_t) + commands.size()));
+        header.writeObject(commandList);
+        header.write(uint64_t(commands.size()));
+
+        std::lock_guard lockGuard(m_FileMutex);
+
+        if (!m_File.write(header.data(), header.size()) || !m_File.write(commands.data(), commands.size()))
+            error("Cannot write to the capture file, the capture is incomplete");
+    }
+
+    void DeviceWrapper::recordUnsupported(const char* function)
+    {
+        StreamWriter stream;
+        stream.beginRecord(Opcode::Unsupported);
+        stream.writeString(function);
+        stream.endRecord();
+        writeRecords(stream);
+    }
+
+    Object DeviceWrapper::getNativeObject(ObjectType objectType)
+    {
+        return m_Device->getNativeObject(objectType);
+    }
+
+    HeapHandle DeviceWrapper::createHeap(const HeapDesc& d)
+    {
+        // Placed resources are created with their own memory on replay, so heaps are not needed
+        return m_Device->createHeap(d);
+    }
+
+    TextureHandle DeviceWrapper::createTexture(const TextureDesc& d)
+    {
+        TextureHandle texture = m_Device->createTexture(d);
+
+        if (texture)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateTexture);
+            stream.writeObject(texture);
+            writeTextureDesc(stream, d);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return texture;
+    }
+
+    MemoryRequirements DeviceWrapper::getTextureMemoryRequirements(ITexture* texture)
+    {
+        return m_Device->getTextureMemoryRequirements(texture);
+    }
+
+    bool DeviceWrapper::bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindTextureMemory(texture, heap, offset);
+    }
+
+    TextureHandle DeviceWrapper::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        TextureHandle handle = m_Device->createHandleForNativeTexture(objectType, texture, desc);
+
+        // Native textures such as swap chain images are created from their descs on replay
+        if (handle)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateTexture);
+            stream.writeObject(handle);
+            writeTextureDesc(stream, desc);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return handle;
+    }
+
+    StagingTextureHandle DeviceWrapper::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        StagingTextureHandle texture = m_Device->createStagingTexture(d, cpuAccess);
+
+        if (texture)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateStagingTexture);
+            stream.writeObject(texture);
+            writeTextureDesc(stream, d);
+            stream.write(cpuAccess);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return texture;
+    }
+
+    void* DeviceWrapper::mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        void* data = m_Device->mapStagingTexture(tex, slice, cpuAccess, outRowPitch);
+
+        if (data && cpuAccess == CpuAccessMode::Write && outRowPitch)
+        {
+            std::lock_guard lockGuard(m_MappingMutex);
+
+            MappedStagingTexture& mapping = m_MappedStagingTextures[tex];
+            mapping.data = data;
+            mapping.slice = slice;
+            mapping.rowPitch = *outRowPitch;
+        }
+
+        return data;
+    }
+
+    void DeviceWrapper::unmapStagingTexture(IStagingTexture* tex)
+    {
+        MappedStagingTexture mapping;
+        {
+            std::lock_guard lockGuard(m_MappingMutex);
+
+            auto it = m_MappedStagingTextures.find(tex);
+            if (it != m_MappedStagingTextures.end())
+            {
+                mapping = it->second;
+                m_MappedStagingTextures.erase(it);
+            }
+        }
+
+        if (mapping.data)
+        {
+            uint32_t rows = 0;
+            size_t rowSize = 0;
+            getStagingSliceLayout(tex->getDesc(), mapping.slice, rows, rowSize);
+
+            StreamWriter stream;
+            stream.beginRecord(Opcode::WriteStagingTextureContents);
+            stream.writeObject(tex);
+            stream.write(mapping.slice);
+            stream.write(uint64_t(mapping.rowPitch));
+            stream.writeBlob(mapping.data, mapping.rowPitch * (rows - 1) + rowSize);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        m_Device->unmapStagingTexture(tex);
+    }
+
+    void DeviceWrapper::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        m_Device->getTextureTiling(texture, numTiles, desc, tileShape, subresourceTilingsNum, subresourceTilings);
+    }
+
+    void DeviceWrapper::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        recordUnsupported("updateTextureTileMappings");
+        m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
+    }
+
+    void DeviceWrapper::updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        recordUnsupported("updateBufferTileMappings");
+        m_Device->updateBufferTileMappings(buffer, tileMappings, numTileMappings, executionQueue);
+    }
+
+    SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        recordUnsupported("createSamplerFeedbackTexture");
+        return m_Device->createSamplerFeedbackTexture(pairedTexture, desc);
+    }
+
+    SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture)
+    {
+        recordUnsupported("createSamplerFeedbackForNativeTexture");
+        return m_Device->createSamplerFeedbackForNativeTexture(objectType, texture, pairedTexture);
+    }
+
+    BufferHandle DeviceWrapper::createBuffer(const BufferDesc& d)
+    {
+        BufferHandle buffer = m_Device->createBuffer(d);
+
+        if (buffer)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateBuffer);
+            stream.writeObject(buffer);
+            writeBufferDesc(stream, d);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return buffer;
+    }
+
+    void* DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags)
+    {
+        return mapBuffer(b, mapFlags, MapBufferFlags::None);
+    }
+
+    void* DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags)
+    {
+        void* data = m_Device->mapBuffer(b, mapFlags, flags);
+
+        if (data && mapFlags == CpuAccessMode::Write)
+        {
+            std::lock_guard lockGuard(m_MappingMutex);
+            m_MappedBuffers[b].data = data;
+        }
+
+        return data;
+    }
+
+    void DeviceWrapper::unmapBuffer(IBuffer* b)
+    {
+        MappedBuffer mapping;
+        {
+            std::lock_guard lockGuard(m_MappingMutex);
+
+            auto it = m_MappedBuffers.find(b);
+            if (it != m_MappedBuffers.end())
+            {
+                mapping = it->second;
+                m_MappedBuffers.erase(it);
+            }
+        }
+
+        if (mapping.data)
+        {
+            // The whole buffer is captured because there is no way to tell which part was written
+            StreamWriter stream;
+            stream.beginRecord(Opcode::WriteBufferContents);
+            stream.writeObject(b);
+            stream.writeBlob(mapping.data, size_t(b->getDesc().byteSize));
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        m_Device->unmapBuffer(b);
+    }
+
+    MemoryRequirements DeviceWrapper::getBufferMemoryRequirements(IBuffer* buffer)
+    {
+        return m_Device->getBufferMemoryRequirements(buffer);
+    }
+
+    bool DeviceWrapper::bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindBufferMemory(buffer, heap, offset);
+    }
+
+    BufferHandle DeviceWrapper::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
+    {
+        BufferHandle handle = m_Device->createHandleForNativeBuffer(objectType, buffer, desc);
+
+        if (handle)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateBuffer);
+            stream.writeObject(handle);
+            writeBufferDesc(stream, desc);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return handle;
+    }
+
+    ShaderHandle DeviceWrapper::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        ShaderHandle shader = m_Device->createShader(d, binary, binarySize);
+
+        if (shader)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateShader);
+            stream.writeObject(shader);
+            writeShaderDesc(stream, d);
+            stream.writeBlob(binary, binarySize);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return shader;
+    }
+
+    ShaderHandle DeviceWrapper::createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        ShaderHandle shader = m_Device->createShaderSpecialization(baseShader, constants, numConstants);
+
+        if (shader)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateShaderSpecialization);
+            stream.writeObject(shader);
+            stream.writeObject(baseShader);
+            stream.write(numConstants);
+            stream.writeBytes(constants, sizeof(ShaderSpecialization) * numConstants);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return shader;
+    }
+
+    ShaderLibraryHandle DeviceWrapper::createShaderLibrary(const void* binary, size_t binarySize)
+    {
+        recordUnsupported("createShaderLibrary");
+        return m_Device->createShaderLibrary(binary, binarySize);
+    }
+
+    SamplerHandle DeviceWrapper::createSampler(const SamplerDesc& d)
+    {
+        SamplerHandle sampler = m_Device->createSampler(d);
+
+        if (sampler)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateSampler);
+            stream.writeObject(sampler);
+            stream.write(d);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return sampler;
+    }
+
+    InputLayoutHandle DeviceWrapper::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        InputLayoutHandle inputLayout = m_Device->createInputLayout(d, attributeCount, vertexShader);
+
+        if (inputLayout)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateInputLayout);
+            stream.writeObject(inputLayout);
+            writeVertexAttributes(stream, d, attributeCount);
+            stream.writeObject(vertexShader);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return inputLayout;
+    }
+
+    EventQueryHandle DeviceWrapper::createEventQuery()
+    {
+        EventQueryHandle query = m_Device->createEventQuery();
+
+        if (query)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateEventQuery);
+            stream.writeObject(query);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return query;
+    }
+
+    void DeviceWrapper::setEventQuery(IEventQuery* query, CommandQueue queue)
+    {
+        StreamWriter stream;
+        stream.beginRecord(Opcode::SetEventQuery);
+        stream.writeObject(query);
+        stream.write(queue);
+        stream.endRecord();
+        writeRecords(stream);
+
+        m_Device->setEventQuery(query, queue);
+    }
+
+    bool DeviceWrapper::pollEventQuery(IEventQuery* query)
+    {
+        return m_Device->pollEventQuery(query);
+    }
+
+    void DeviceWrapper::waitEventQuery(IEventQuery* query)
+    {
+        m_Device->waitEventQuery(query);
+    }
+
+    void DeviceWrapper::resetEventQuery(IEventQuery* query)
+    {
+        m_Device->resetEventQuery(query);
+    }
+
+    TimerQueryHandle DeviceWrapper::createTimerQuery()
+    {
+        TimerQueryHandle query = m_Device->createTimerQuery();
+
+        if (query)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateTimerQuery);
+            stream.writeObject(query);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return query;
+    }
+
+    bool DeviceWrapper::pollTimerQuery(ITimerQuery* query)
+    {
+        return m_Device->pollTimerQuery(query);
+    }
+
+    float DeviceWrapper::getTimerQueryTime(ITimerQuery* query)
+    {
+        return m_Device->getTimerQueryTime(query);
+    }
+
+    void DeviceWrapper::resetTimerQuery(ITimerQuery* query)
+    {
+        m_Device->resetTimerQuery(query);
+    }
+
+    TimerQueryPoolHandle DeviceWrapper::createTimerQueryPool(const TimerQueryPoolDesc& desc)
+    {
+        recordUnsupported("createTimerQueryPool");
+        return m_Device->createTimerQueryPool(desc);
+    }
+
+    bool DeviceWrapper::getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries)
+    {
+        return m_Device->getTimerQueryPoolResults(pool, frameIndex, pTimes, numQueries);
+    }
+
+    bool DeviceWrapper::getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries)
+    {
+        return m_Device->getTimerQueryPoolTimestamps(pool, frameIndex, pTimestamps, numQueries);
+    }
+
+    OcclusionQueryHandle DeviceWrapper::createOcclusionQuery(OcclusionQueryType type)
+    {
+        OcclusionQueryHandle query = m_Device->createOcclusionQuery(type);
+
+        if (query)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateOcclusionQuery);
+            stream.writeObject(query);
+            stream.write(type);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return query;
+    }
+
+    bool DeviceWrapper::pollOcclusionQuery(IOcclusionQuery* query)
+    {
+        return m_Device->pollOcclusionQuery(query);
+    }
+
+    uint64_t DeviceWrapper::getOcclusionQueryResult(IOcclusionQuery* query)
+    {
+        return m_Device->getOcclusionQueryResult(query);
+    }
+
+    void DeviceWrapper::resetOcclusionQuery(IOcclusionQuery* query)
+    {
+        m_Device->resetOcclusionQuery(query);
+    }
+
+    PipelineStatisticsQueryHandle DeviceWrapper::createPipelineStatisticsQuery()
+    {
+        PipelineStatisticsQueryHandle query = m_Device->createPipelineStatisticsQuery();
+
+        if (query)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreatePipelineStatisticsQuery);
+            stream.writeObject(query);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return query;
+    }
+
+    bool DeviceWrapper::pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        return m_Device->pollPipelineStatisticsQuery(query);
+    }
+
+    PipelineStatistics DeviceWrapper::getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query)
+    {
+        return m_Device->getPipelineStatisticsQueryResult(query);
+    }
+
+    void DeviceWrapper::resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        m_Device->resetPipelineStatisticsQuery(query);
+    }
+
+    GraphicsAPI DeviceWrapper::getGraphicsAPI()
+    {
+        return m_Device->getGraphicsAPI();
+    }
+
+    FramebufferHandle DeviceWrapper::createFramebuffer(const FramebufferDesc& desc)
+    {
+        FramebufferHandle framebuffer = m_Device->createFramebuffer(desc);
+
+        if (framebuffer)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateFramebuffer);
+            stream.writeObject(framebuffer);
+            writeFramebufferDesc(stream, desc);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return framebuffer;
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        GraphicsPipelineHandle pipeline = m_Device->createGraphicsPipeline(desc, fbinfo);
+
+        if (pipeline)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateGraphicsPipeline);
+            stream.writeObject(pipeline);
+            writeGraphicsPipelineDesc(stream, desc);
+            stream.write(fbinfo);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return pipeline;
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+        {
+            error("framebuffer is NULL");
+            return nullptr;
+        }
+
+        return createGraphicsPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        ComputePipelineHandle pipeline = m_Device->createComputePipeline(desc);
+
+        if (pipeline)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateComputePipeline);
+            stream.writeObject(pipeline);
+            writeComputePipelineDesc(stream, desc);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return pipeline;
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        recordUnsupported("createMeshletPipeline");
+        return m_Device->createMeshletPipeline(desc, fbinfo);
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        if (!fb)
+        {
+            error("framebuffer is NULL");
+            return nullptr;
+        }
+
+        return createMeshletPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    rt::PipelineHandle DeviceWrapper::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        recordUnsupported("createRayTracingPipeline");
+        return m_Device->createRayTracingPipeline(desc);
+    }
+
+    AsyncGraphicsPipelineHandle DeviceWrapper::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback)
+    {
+        recordUnsupported("createGraphicsPipelineAsync");
+        return m_Device->createGraphicsPipelineAsync(desc, fbinfo, fallback);
+    }
+
+    AsyncComputePipelineHandle DeviceWrapper::createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback)
+    {
+        recordUnsupported("createComputePipelineAsync");
+        return m_Device->createComputePipelineAsync(desc, fallback);
+    }
+
+    AsyncMeshletPipelineHandle DeviceWrapper::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback)
+    {
+        recordUnsupported("createMeshletPipelineAsync");
+        return m_Device->createMeshletPipelineAsync(desc, fbinfo, fallback);
+    }
+
+    rt::AsyncPipelineHandle DeviceWrapper::createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback)
+    {
+        recordUnsupported("createRayTracingPipelineAsync");
+        return m_Device->createRayTracingPipelineAsync(desc, fallback);
+    }
+
+    CommandSignatureHandle DeviceWrapper::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        recordUnsupported("createCommandSignature");
+        return m_Device->createCommandSignature(desc);
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        BindingLayoutHandle layout = m_Device->createBindingLayout(desc);
+
+        if (layout)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateBindingLayout);
+            stream.writeObject(layout);
+            writeBindingLayoutDesc(stream, desc);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return layout;
+    }
+
+    BindingLayoutHandle DeviceWrapper::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        BindingLayoutHandle layout = m_Device->createBindlessLayout(desc);
+
+        if (layout)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateBindlessLayout);
+            stream.writeObject(layout);
+            writeBindlessLayoutDesc(stream, desc);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return layout;
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+
+        if (bindingSet)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateBindingSet);
+            stream.writeObject(bindingSet);
+            writeBindingSetDesc(stream, desc);
+            stream.writeObject(layout);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return bindingSet;
+    }
+
+    DescriptorTableHandle DeviceWrapper::createDescriptorTable(IBindingLayout* layout)
+    {
+        DescriptorTableHandle descriptorTable = m_Device->createDescriptorTable(layout);
+
+        if (descriptorTable)
+        {
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateDescriptorTable);
+            stream.writeObject(descriptorTable);
+            stream.writeObject(layout);
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return descriptorTable;
+    }
+
+    void DeviceWrapper::resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        StreamWriter stream;
+        stream.beginRecord(Opcode::ResizeDescriptorTable);
+        stream.writeObject(descriptorTable);
+        stream.write(newSize);
+        stream.write(keepContents);
+        stream.endRecord();
+        writeRecords(stream);
+
+        m_Device->resizeDescriptorTable(descriptorTable, newSize, keepContents);
+    }
+
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item)
+    {
+        return writeDescriptorTable(descriptorTable, &item, 1);
+    }
+
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems)
+    {
+        StreamWriter stream;
+        stream.beginRecord(Opcode::WriteDescriptorTable);
+        stream.writeObject(descriptorTable);
+        writeBindingSetItems(stream, items, numItems);
+        stream.endRecord();
+        writeRecords(stream);
+
+        return m_Device->writeDescriptorTable(descriptorTable, items, numItems);
+    }
+
+    rt::OpacityMicromapHandle DeviceWrapper::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
+    {
+        recordUnsupported("createOpacityMicromap");
+        return m_Device->createOpacityMicromap(desc);
+    }
+
+    rt::AccelStructHandle DeviceWrapper::createAccelStruct(const rt::AccelStructDesc& desc)
+    {
+        rt::AccelStructHandle as = m_Device->createAccelStruct(desc);
+
+        if (as)
+        {
+            // The instance buffer is recorded so that the replay can map it to the one of the new TLAS
+            StreamWriter stream;
+            stream.beginRecord(Opcode::CreateAccelStruct);
+            stream.writeObject(as);
+            writeAccelStructDesc(stream, desc);
+            stream.writeObject(as->getInstanceBuffer());
+            stream.endRecord();
+            writeRecords(stream);
+        }
+
+        return as;
+    }
+
+    MemoryRequirements DeviceWrapper::getAccelStructMemoryRequirements(rt::IAccelStruct* as)
+    {
+        return m_Device->getAccelStructMemoryRequirements(as);
+    }
+
+    rt::cluster::OperationSizeInfo DeviceWrapper::getClusterOperationSizeInfo(const rt::cluster::OperationParams& params)
+    {
+        return m_Device->getClusterOperationSizeInfo(params);
+    }
+
+    bool DeviceWrapper::bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset)
+    {
+        return m_Device->bindAccelStructMemory(as, heap, offset);
+    }
+
+    CommandListHandle DeviceWrapper::createCommandList(const CommandListParameters& params)
+    {
+        CommandListHandle commandList = m_Device->createCommandList(params);
+
+        if (commandList == nullptr)
+            return nullptr;
+
+        CommandListWrapper* wrapper = new CommandListWrapper(this, commandList);
+
+        StreamWriter stream;
+        stream.beginRecord(Opcode::CreateCommandList);
+        stream.writeObject(wrapper);
+        stream.write(params);
+        stream.endRecord();
+        writeRecords(stream);
+
+        return CommandListHandle::Create(wrapper);
+    }
+
+    uint64_t DeviceWrapper::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        std::vector<ICommandList*> unwrappedCommandLists;
+        unwrappedCommandLists.resize(numCommandLists);
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(pCommandLists[i]);
+            unwrappedCommandLists[i] = wrapper ? wrapper->getUnderlyingCommandList() : pCommandLists[i];
+        }
+
+        const uint64_t instance = m_Device->executeCommandLists(unwrappedCommandLists.data(), unwrappedCommandLists.size(), executionQueue);
+
+        StreamWriter stream;
+        stream.beginRecord(Opcode::ExecuteCommandLists);
+        stream.write(executionQueue);
+        stream.write(instance);
+        stream.write(uint64_t(numCommandLists));
+        for (size_t i = 0; i < numCommandLists; i++)
+            stream.writeObject(pCommandLists[i]);
+        stream.endRecord();
+        writeRecords(stream);
+
+        return instance;
+    }
+
+    void DeviceWrapper::queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance)
+    {
+        StreamWriter stream;
+        stream.beginRecord(Opcode::QueueWaitForCommandList);
+        stream.write(waitQueue);
+        stream.write(executionQueue);
+        stream.write(instance);
+        stream.endRecord();
+        writeRecords(stream);
+
+        m_Device->queueWaitForCommandList(waitQueue, executionQueue, instance);
+    }
+
+    StorageQueueHandle DeviceWrapper::createStorageQueue(const StorageQueueDesc& desc)
+    {
+        recordUnsupported("createStorageQueue");
+        return m_Device->createStorageQueue(desc);
+    }
+
+    bool DeviceWrapper::waitForIdle()
+    {
+        StreamWriter stream;
+        stream.beginRecord(Opcode::WaitForIdle);
+        stream.endRecord();
+        writeRecords(stream);
+
+        return m_Device->waitForIdle();
+    }
+
+    void DeviceWrapper::runGarbageCollection()
+    {
+        StreamWriter stream;
+        stream.beginRecord(Opcode::RunGarbageCollection);
+        stream.endRecord();
+        writeRecords(stream);
+
+        m_Device->runGarbageCollection();
+    }
+
+    bool DeviceWrapper::getVideoMemoryBudget(VideoMemoryBudget& outBudget)
+    {
+        return m_Device->getVideoMemoryBudget(outBudget);
+    }
+
+    MemoryStatistics DeviceWrapper::getMemoryStatistics()
+    {
+        return m_Device->getMemoryStatistics();
+    }
+
+    void DeviceWrapper::setResidencyPriority(IResource* resource, ResidencyPriority priority)
+    {
+        m_Device->setResidencyPriority(resource, priority);
+    }
+
+    bool DeviceWrapper::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
+    {
+        return m_Device->queryFeatureSupport(feature, pInfo, infoSize);
+    }
+
+    FormatSupport DeviceWrapper::queryFormatSupport(Format format)
+    {
+        return m_Device->queryFormatSupport(format);
+    }
+
+    coopvec::DeviceFeatures DeviceWrapper::queryCoopVecFeatures()
+    {
+        return m_Device->queryCoopVecFeatures();
+    }
+
+    size_t DeviceWrapper::getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns)
+    {
+        return m_Device->getCoopVecMatrixSize(type, layout, rows, columns);
+    }
+
+    void DeviceWrapper::getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes)
+    {
+        m_Device->getCoopVecMatrixSizes(descs, numDescs, outSizes);
+    }
+
+    Object DeviceWrapper::getNativeQueue(ObjectType objectType, CommandQueue queue)
+    {
+        return m_Device->getNativeQueue(objectType, queue);
+    }
+
+    bool DeviceWrapper::getPipelineCacheData(std::vector<uint8_t>& outData)
+    {
+        return m_Device->getPipelineCacheData(outData);
+    }
+
+    bool DeviceWrapper::mergePipelineCacheData(const void* data, size_t size)
+    {
+        return m_Device->mergePipelineCacheData(data, size);
+    }
+
+    IMessageCallback* DeviceWrapper::getMessageCallback()
+    {
+        return m_MessageCallback;
+    }
+
+    bool DeviceWrapper::isAftermathEnabled()
+    {
+        return m_Device->isAftermathEnabled();
+    }
+
+    AftermathCrashDumpHelper& DeviceWrapper::getAftermathCrashDumpHelper()
+    {
+        return m_Device->getAftermathCrashDumpHelper();
+    }
+
+} // namespace nvrhi::capture
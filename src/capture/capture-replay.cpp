@@ -0,0 +1,1048 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+
+namespace nvrhi::capture
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        double millisecondsSince(Clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        class Replayer
+        {
+        public:
+            Replayer(IDevice* device, const ReplayDesc& desc, ReplayResult& result)
+                : m_Device(device)
+                , m_Desc(desc)
+                , m_Result(result)
+            { }
+
+            void replay(StreamReader& stream);
+
+        private:
+            IDevice* m_Device;
+            const ReplayDesc& m_Desc;
+            ReplayResult& m_Result;
+
+            ObjectTable m_Objects;
+
+            // Instances returned by executeCommandLists in the capture and on replay, per queue
+            std::map<std::pair<CommandQueue, uint64_t>, uint64_t> m_Instances;
+
+            std::unordered_map<std::string, size_t> m_PassIndices;
+
+            // State of the pass that is being recorded into the current command list
+            size_t m_CurrentPass = 0;
+            uint32_t m_MarkerDepth = 0;
+            Clock::time_point m_PassStart;
+            ITimerQuery* m_PassQuery = nullptr;
+
+            struct PendingQuery
+            {
+                TimerQueryHandle query;
+                size_t pass = 0;
+                ICommandList* commandList = nullptr;
+                bool submitted = false;
+            };
+            std::vector<PendingQuery> m_PendingQueries;
+            std::vector<TimerQueryHandle> m_FreeQueries;
+
+            bool valid(StreamReader& payload) { return !m_Objects.takeMissing() && !payload.failed(); }
+            void skip(const std::string& unsupportedFunction);
+
+            bool replayDeviceCall(Opcode opcode, StreamReader& payload);
+            bool playRecording(StreamReader& payload);
+            bool replayCommand(ICommandList* commandList, Opcode opcode, StreamReader& payload);
+
+            void beginPass(ICommandList* commandList, const std::string& name);
+            void endPass(ICommandList* commandList);
+            void pollQueries();
+        };
+
+        void Replayer::skip(const std::string& unsupportedFunction)
+        {
+            m_Result.callsSkipped++;
+
+            if (!unsupportedFunction.empty() &&
+                std::find(m_Result.unsupportedFunctions.begin(), m_Result.unsupportedFunctions.end(), unsupportedFunction) == m_Result.unsupportedFunctions.end())
+            {
+                m_Result.unsupportedFunctions.push_back(unsupportedFunction);
+            }
+        }
+
+        void Replayer::replay(StreamReader& stream)
+        {
+            Opcode opcode;
+            StreamReader payload;
+            while (stream.readRecord(opcode, payload))
+            {
+                if (opcode == Opcode::Unsupported)
+                {
+                    skip(payload.readString());
+                    continue;
+                }
+
+                if (replayDeviceCall(opcode, payload))
+                    m_Result.callsReplayed++;
+                else
+                    skip(std::string());
+            }
+
+            m_Device->waitForIdle();
+            pollQueries();
+        }
+
+        bool Replayer::replayDeviceCall(Opcode opcode, StreamReader& payload)
+        {
+            // Records that create or modify one object start with its key
+            const bool hasKey = opcode < Opcode::CommandListRecording || opcode == Opcode::CreateAccelStruct || opcode == Opcode::WriteBufferContents || opcode == Opcode::WriteStagingTextureContents;
+            const ObjectKey key = hasKey ? payload.readObject() : 0;
+
+            switch (opcode)
+            {
+            case Opcode::CreateTexture: {
+                TextureDesc desc;
+                readTextureDesc(payload, desc);
+                // Resources placed in heaps are not captured, so they get their own memory
+                desc.isVirtual = false;
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createTexture(desc));
+                return true;
+            }
+            case Opcode::CreateStagingTexture: {
+                TextureDesc desc;
+                readTextureDesc(payload, desc);
+                const auto cpuAccess = payload.read<CpuAccessMode>();
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createStagingTexture(desc, cpuAccess));
+                return true;
+            }
+            case Opcode::CreateBuffer: {
+                BufferDesc desc;
+                readBufferDesc(payload, desc);
+                desc.isVirtual = false;
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createBuffer(desc));
+                return true;
+            }
+            case Opcode::CreateAccelStruct: {
+                rt::AccelStructDesc desc;
+                readAccelStructDesc(payload, m_Objects, desc);
+                desc.isVirtual = false;
+                const ObjectKey instanceBufferKey = payload.readObject();
+                if (!valid(payload))
+                    return false;
+                rt::AccelStructHandle as = m_Device->createAccelStruct(desc);
+                m_Objects.set(key, as);
+                if (as && instanceBufferKey)
+                    m_Objects.set(instanceBufferKey, as->getInstanceBuffer());
+                return true;
+            }
+            case Opcode::CreateShader: {
+                ShaderDescStorage storage;
+                readShaderDesc(payload, storage);
+                size_t binarySize = 0;
+                const void* binary = payload.readBlob(binarySize);
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createShader(storage.desc, binary, binarySize));
+                return true;
+            }
+            case Opcode::CreateShaderSpecialization: {
+                IShader* baseShader = m_Objects.get<IShader>(payload.readObject());
+                const auto numConstants = payload.read<uint32_t>();
+                std::vector<ShaderSpecialization> constants(numConstants);
+                if (const void* data = payload.readBytes(sizeof(ShaderSpecialization) * numConstants))
+                    memcpy(constants.data(), data, sizeof(ShaderSpecialization) * numConstants);
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createShaderSpecialization(baseShader, constants.data(), numConstants));
+                return true;
+            }
+            case Opcode::CreateSampler: {
+                const auto desc = payload.read<SamplerDesc>();
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createSampler(desc));
+                return true;
+            }
+            case Opcode::CreateInputLayout: {
+                std::vector<VertexAttributeDesc> attributes;
+                readVertexAttributes(payload, attributes);
+                IShader* vertexShader = m_Objects.get<IShader>(payload.readObject());
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createInputLayout(attributes.data(), uint32_t(attributes.size()), vertexShader));
+                return true;
+            }
+            case Opcode::CreateEventQuery:
+                m_Objects.set(key, m_Device->createEventQuery());
+                return true;
+            case Opcode::SetEventQuery: {
+                IEventQuery* query = m_Objects.get<IEventQuery>(key);
+                const auto queue = payload.read<CommandQueue>();
+                if (!query || !valid(payload))
+                    return false;
+                m_Device->setEventQuery(query, queue);
+                return true;
+            }
+            case Opcode::CreateTimerQuery:
+                m_Objects.set(key, m_Device->createTimerQuery());
+                return true;
+            case Opcode::CreateOcclusionQuery: {
+                const auto type = payload.read<OcclusionQueryType>();
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createOcclusionQuery(type));
+                return true;
+            }
+            case Opcode::CreatePipelineStatisticsQuery:
+                m_Objects.set(key, m_Device->createPipelineStatisticsQuery());
+                return true;
+            case Opcode::CreateFramebuffer: {
+                FramebufferDesc desc;
+                readFramebufferDesc(payload, m_Objects, desc);
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createFramebuffer(desc));
+                return true;
+            }
+            case Opcode::CreateGraphicsPipeline: {
+                GraphicsPipelineDesc desc;
+                readGraphicsPipelineDesc(payload, m_Objects, desc);
+                const auto fbinfo = payload.read<FramebufferInfo>();
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createGraphicsPipeline(desc, fbinfo));
+                return true;
+            }
+            case Opcode::CreateComputePipeline: {
+                ComputePipelineDesc desc;
+                readComputePipelineDesc(payload, m_Objects, desc);
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createComputePipeline(desc));
+                return true;
+            }
+            case Opcode::CreateBindingLayout: {
+                BindingLayoutDesc desc;
+                readBindingLayoutDesc(payload, desc);
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createBindingLayout(desc));
+                return true;
+            }
+            case Opcode::CreateBindlessLayout: {
+                BindlessLayoutDesc desc;
+                readBindlessLayoutDesc(payload, desc);
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createBindlessLayout(desc));
+                return true;
+            }
+            case Opcode::CreateBindingSet: {
+                BindingSetDesc desc;
+                readBindingSetDesc(payload, m_Objects, desc);
+                IBindingLayout* layout = m_Objects.get<IBindingLayout>(payload.readObject());
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createBindingSet(desc, layout));
+                return true;
+            }
+            case Opcode::CreateDescriptorTable: {
+                IBindingLayout* layout = m_Objects.get<IBindingLayout>(payload.readObject());
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createDescriptorTable(layout));
+                return true;
+            }
+            case Opcode::ResizeDescriptorTable: {
+                IDescriptorTable* descriptorTable = m_Objects.get<IDescriptorTable>(key);
+                const auto newSize = payload.read<uint32_t>();
+                const auto keepContents = payload.read<bool>();
+                if (!descriptorTable || !valid(payload))
+                    return false;
+                m_Device->resizeDescriptorTable(descriptorTable, newSize, keepContents);
+                return true;
+            }
+            case Opcode::WriteDescriptorTable: {
+                IDescriptorTable* descriptorTable = m_Objects.get<IDescriptorTable>(key);
+                std::vector<BindingSetItem> items;
+                readBindingSetItems(payload, m_Objects, items);
+                if (!descriptorTable || !valid(payload))
+                    return false;
+                m_Device->writeDescriptorTable(descriptorTable, items.data(), items.size());
+                return true;
+            }
+            case Opcode::CreateCommandList: {
+                const auto params = payload.read<CommandListParameters>();
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, m_Device->createCommandList(params));
+                return true;
+            }
+            case Opcode::WriteBufferContents: {
+                IBuffer* buffer = m_Objects.get<IBuffer>(key);
+                size_t dataSize = 0;
+                const void* data = payload.readBlob(dataSize);
+                if (!buffer || !valid(payload))
+                    return false;
+                void* mappedData = m_Device->mapBuffer(buffer, CpuAccessMode::Write);
+                if (!mappedData)
+                    return false;
+                memcpy(mappedData, data, std::min<size_t>(dataSize, size_t(buffer->getDesc().byteSize)));
+                m_Device->unmapBuffer(buffer);
+                return true;
+            }
+            case Opcode::WriteStagingTextureContents: {
+                IStagingTexture* texture = m_Objects.get<IStagingTexture>(key);
+                const auto slice = payload.read<TextureSlice>();
+                const auto capturedRowPitch = size_t(payload.read<uint64_t>());
+                size_t dataSize = 0;
+                const auto* data = static_cast<const uint8_t*>(payload.readBlob(dataSize));
+                if (!texture || !valid(payload))
+                    return false;
+
+                uint32_t rows = 0;
+                size_t rowSize = 0;
+                getStagingSliceLayout(texture->getDesc(), slice, rows, rowSize);
+
+                size_t rowPitch = 0;
+                auto* mappedData = static_cast<uint8_t*>(m_Device->mapStagingTexture(texture, slice, CpuAccessMode::Write, &rowPitch));
+                if (!mappedData)
+                    return false;
+
+                // The row pitch of the replay device may differ from the captured one
+                const size_t copySize = std::min(rowSize, std::min(rowPitch, capturedRowPitch));
+                for (uint32_t row = 0; row < rows && row * capturedRowPitch + copySize <= dataSize; row++)
+                    memcpy(mappedData + row * rowPitch, data + row * capturedRowPitch, copySize);
+
+                m_Device->unmapStagingTexture(texture);
+                return true;
+            }
+            case Opcode::CommandListRecording:
+                return playRecording(payload);
+            case Opcode::ExecuteCommandLists: {
+                const auto queue = payload.read<CommandQueue>();
+                const auto instance = payload.read<uint64_t>();
+                const auto numCommandLists = size_t(payload.read<uint64_t>());
+                std::vector<ICommandList*> commandLists;
+                for (size_t i = 0; i < numCommandLists && !payload.failed(); i++)
+                    commandLists.push_back(m_Objects.get<ICommandList>(payload.readObject()));
+                if (!valid(payload) || std::find(commandLists.begin(), commandLists.end(), nullptr) != commandLists.end())
+                    return false;
+
+                m_Instances[std::make_pair(queue, instance)] = m_Device->executeCommandLists(commandLists.data(), commandLists.size(), queue);
+
+                for (PendingQuery& pending : m_PendingQueries)
+                {
+                    if (std::find(commandLists.begin(), commandLists.end(), pending.commandList) != commandLists.end())
+                        pending.submitted = true;
+                }
+                pollQueries();
+                return true;
+            }
+            case Opcode::QueueWaitForCommandList: {
+                const auto waitQueue = payload.read<CommandQueue>();
+                const auto executionQueue = payload.read<CommandQueue>();
+                const auto instance = payload.read<uint64_t>();
+                const auto it = m_Instances.find(std::make_pair(executionQueue, instance));
+                if (!valid(payload) || it == m_Instances.end())
+                    return false;
+                m_Device->queueWaitForCommandList(waitQueue, executionQueue, it->second);
+                return true;
+            }
+            case Opcode::WaitForIdle:
+                m_Device->waitForIdle();
+                pollQueries();
+                return true;
+            case Opcode::RunGarbageCollection:
+                m_Device->runGarbageCollection();
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool Replayer::playRecording(StreamReader& payload)
+        {
+            ICommandList* commandList = m_Objects.get<ICommandList>(payload.readObject());
+            size_t commandsSize = 0;
+            const auto* commands = static_cast<const uint8_t*>(payload.readBlob(commandsSize));
+            if (!commandList || !valid(payload))
+                return false;
+
+            // Queries in a previous recording of this list that was never executed will not be resolved
+            m_PendingQueries.erase(std::remove_if(m_PendingQueries.begin(), m_PendingQueries.end(), [commandList](const PendingQuery& pending)
+            {
+                return pending.commandList == commandList && !pending.submitted;
+            }), m_PendingQueries.end());
+
+            m_MarkerDepth = 0;
+            m_PassQuery = nullptr;
+
+            commandList->open();
+
+            StreamReader stream(commands, commandsSize);
+            Opcode opcode;
+            StreamReader command;
+            while (stream.readRecord(opcode, command))
+            {
+                if (replayCommand(commandList, opcode, command))
+                    m_Result.callsReplayed++;
+                else
+                    skip(std::string());
+            }
+
+            if (m_MarkerDepth > 0)
+            {
+                m_MarkerDepth = 0;
+                endPass(commandList);
+            }
+
+            commandList->close();
+
+            m_Objects.clearTransient();
+            return true;
+        }
+
+        void Replayer::beginPass(ICommandList* commandList, const std::string& name)
+        {
+            auto it = m_PassIndices.find(name);
+            if (it == m_PassIndices.end())
+            {
+                it = m_PassIndices.emplace(name, m_Result.passes.size()).first;
+                m_Result.passes.push_back(PassTiming());
+                m_Result.passes.back().name = name;
+            }
+
+            m_CurrentPass = it->second;
+            m_Result.passes[m_CurrentPass].count++;
+            m_PassStart = Clock::now();
+
+            const CommandListParameters& params = commandList->getDesc();
+            if (m_Desc.measureGpuTime && params.queueType != CommandQueue::Copy && !params.isBundle)
+            {
+                PendingQuery pending;
+                if (m_FreeQueries.empty())
+                {
+                    pending.query = m_Device->createTimerQuery();
+                }
+                else
+                {
+                    pending.query = m_FreeQueries.back();
+                    m_FreeQueries.pop_back();
+                }
+
+                if (pending.query)
+                {
+                    pending.pass = m_CurrentPass;
+                    pending.commandList = commandList;
+                    m_PassQuery = pending.query;
+                    m_PendingQueries.push_back(pending);
+
+                    commandList->beginTimerQuery(m_PassQuery);
+                }
+            }
+        }
+
+        void Replayer::endPass(ICommandList* commandList)
+        {
+            if (m_PassQuery)
+            {
+                commandList->endTimerQuery(m_PassQuery);
+                m_PassQuery = nullptr;
+            }
+
+            m_Result.passes[m_CurrentPass].cpuMilliseconds += millisecondsSince(m_PassStart);
+        }
+
+        void Replayer::pollQueries()
+        {
+            for (auto it = m_PendingQueries.begin(); it != m_PendingQueries.end(); )
+            {
+                if (it->submitted && m_Device->pollTimerQuery(it->query))
+                {
+                    PassTiming& pass = m_Result.passes[it->pass];
+                    pass.gpuMilliseconds += double(m_Device->getTimerQueryTime(it->query)) * 1000.0;
+                    pass.gpuCount++;
+
+                    m_Device->resetTimerQuery(it->query);
+                    m_FreeQueries.push_back(it->query);
+                    it = m_PendingQueries.erase(it);
+                }
+                else
+                    ++it;
+            }
+        }
+
+        bool Replayer::replayCommand(ICommandList* commandList, Opcode opcode, StreamReader& payload)
+        {
+            switch (opcode)
+            {
+            case Opcode::ClearState:
+                commandList->clearState();
+                return true;
+            case Opcode::ClearTextureFloat: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const auto color = payload.read<Color>();
+                if (!texture || !valid(payload))
+                    return false;
+                commandList->clearTextureFloat(texture, subresources, color);
+                return true;
+            }
+            case Opcode::ClearDepthStencilTexture: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const auto clearDepth = payload.read<bool>();
+                const auto depth = payload.read<float>();
+                const auto clearStencil = payload.read<bool>();
+                const auto stencil = payload.read<uint8_t>();
+                if (!texture || !valid(payload))
+                    return false;
+                commandList->clearDepthStencilTexture(texture, subresources, clearDepth, depth, clearStencil, stencil);
+                return true;
+            }
+            case Opcode::ClearTextureUInt: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const auto color = payload.read<uint32_t>();
+                if (!texture || !valid(payload))
+                    return false;
+                commandList->clearTextureUInt(texture, subresources, color);
+                return true;
+            }
+            case Opcode::CopyTexture:
+            case Opcode::CopyTextureToStaging:
+            case Opcode::CopyTextureFromStaging: {
+                const ObjectKey destKey = payload.readObject();
+                const auto destSlice = payload.read<TextureSlice>();
+                const ObjectKey srcKey = payload.readObject();
+                const auto srcSlice = payload.read<TextureSlice>();
+
+                if (opcode == Opcode::CopyTexture)
+                {
+                    ITexture* dest = m_Objects.get<ITexture>(destKey);
+                    ITexture* src = m_Objects.get<ITexture>(srcKey);
+                    if (!dest || !src || !valid(payload))
+                        return false;
+                    commandList->copyTexture(dest, destSlice, src, srcSlice);
+                }
+                else if (opcode == Opcode::CopyTextureToStaging)
+                {
+                    IStagingTexture* dest = m_Objects.get<IStagingTexture>(destKey);
+                    ITexture* src = m_Objects.get<ITexture>(srcKey);
+                    if (!dest || !src || !valid(payload))
+                        return false;
+                    commandList->copyTexture(dest, destSlice, src, srcSlice);
+                }
+                else
+                {
+                    ITexture* dest = m_Objects.get<ITexture>(destKey);
+                    IStagingTexture* src = m_Objects.get<IStagingTexture>(srcKey);
+                    if (!dest || !src || !valid(payload))
+                        return false;
+                    commandList->copyTexture(dest, destSlice, src, srcSlice);
+                }
+                return true;
+            }
+            case Opcode::WriteTexture: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto arraySlice = payload.read<uint32_t>();
+                const auto mipLevel = payload.read<uint32_t>();
+                const auto rowPitch = size_t(payload.read<uint64_t>());
+                const auto depthPitch = size_t(payload.read<uint64_t>());
+                size_t dataSize = 0;
+                const void* data = payload.readBlob(dataSize);
+                if (!texture || !valid(payload))
+                    return false;
+                commandList->writeTexture(texture, arraySlice, mipLevel, data, rowPitch, depthPitch);
+                return true;
+            }
+            case Opcode::ResolveTexture: {
+                ITexture* dest = m_Objects.get<ITexture>(payload.readObject());
+                const auto destSubresources = payload.read<TextureSubresourceSet>();
+                ITexture* src = m_Objects.get<ITexture>(payload.readObject());
+                const auto srcSubresources = payload.read<TextureSubresourceSet>();
+                if (!dest || !src || !valid(payload))
+                    return false;
+                commandList->resolveTexture(dest, destSubresources, src, srcSubresources);
+                return true;
+            }
+            case Opcode::GenerateMips: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const auto linearFilter = payload.read<bool>();
+                if (!texture || !valid(payload))
+                    return false;
+                commandList->generateMips(texture, subresources, linearFilter);
+                return true;
+            }
+            case Opcode::BlitTexture: {
+                ITexture* dest = m_Objects.get<ITexture>(payload.readObject());
+                const auto destSlice = payload.read<TextureSlice>();
+                ITexture* src = m_Objects.get<ITexture>(payload.readObject());
+                const auto srcSlice = payload.read<TextureSlice>();
+                const auto linearFilter = payload.read<bool>();
+                if (!dest || !src || !valid(payload))
+                    return false;
+                commandList->blitTexture(dest, destSlice, src, srcSlice, linearFilter);
+                return true;
+            }
+            case Opcode::WriteBuffer: {
+                IBuffer* buffer = m_Objects.get<IBuffer>(payload.readObject());
+                const auto destOffset = payload.read<uint64_t>();
+                size_t dataSize = 0;
+                const void* data = payload.readBlob(dataSize);
+                if (!buffer || !valid(payload))
+                    return false;
+                commandList->writeBuffer(buffer, data, dataSize, destOffset);
+                return true;
+            }
+            case Opcode::ClearBufferUInt: {
+                IBuffer* buffer = m_Objects.get<IBuffer>(payload.readObject());
+                const auto clearValue = payload.read<uint32_t>();
+                if (!buffer || !valid(payload))
+                    return false;
+                commandList->clearBufferUInt(buffer, clearValue);
+                return true;
+            }
+            case Opcode::CopyBuffer: {
+                IBuffer* dest = m_Objects.get<IBuffer>(payload.readObject());
+                const auto destOffset = payload.read<uint64_t>();
+                IBuffer* src = m_Objects.get<IBuffer>(payload.readObject());
+                const auto srcOffset = payload.read<uint64_t>();
+                const auto dataSize = payload.read<uint64_t>();
+                if (!dest || !src || !valid(payload))
+                    return false;
+                commandList->copyBuffer(dest, destOffset, src, srcOffset, dataSize);
+                return true;
+            }
+            case Opcode::CreateTransientBindingSet: {
+                const ObjectKey key = payload.readObject();
+                BindingSetDesc desc;
+                readBindingSetDesc(payload, m_Objects, desc);
+                IBindingLayout* layout = m_Objects.get<IBindingLayout>(payload.readObject());
+                if (!valid(payload))
+                    return false;
+                m_Objects.setTransient(key, commandList->createTransientBindingSet(desc, layout));
+                return true;
+            }
+            case Opcode::SetPushConstants: {
+                size_t dataSize = 0;
+                const void* data = payload.readBlob(dataSize);
+                if (!valid(payload))
+                    return false;
+                commandList->setPushConstants(data, dataSize);
+                return true;
+            }
+            case Opcode::SetGraphicsState: {
+                GraphicsState state;
+                readGraphicsState(payload, m_Objects, state);
+                if (!valid(payload))
+                    return false;
+                commandList->setGraphicsState(state);
+                return true;
+            }
+            case Opcode::SetGraphicsBindingSet: {
+                const auto slot = payload.read<uint32_t>();
+                IBindingSet* bindingSet = m_Objects.get<IBindingSet>(payload.readObject());
+                if (!valid(payload))
+                    return false;
+                commandList->setGraphicsBindingSet(slot, bindingSet);
+                return true;
+            }
+            case Opcode::SetVertexBuffers: {
+                static_vector<VertexBufferBinding, c_MaxVertexAttributes> bindings;
+                readVertexBuffers(payload, m_Objects, bindings);
+                if (!valid(payload))
+                    return false;
+                commandList->setVertexBuffers(bindings.data(), bindings.size());
+                return true;
+            }
+            case Opcode::SetIndexBuffer: {
+                IndexBufferBinding binding;
+                readIndexBuffer(payload, m_Objects, binding);
+                if (!valid(payload))
+                    return false;
+                commandList->setIndexBuffer(binding);
+                return true;
+            }
+            case Opcode::SetViewportState: {
+                ViewportState state;
+                readViewportState(payload, state);
+                if (!valid(payload))
+                    return false;
+                commandList->setViewportState(state);
+                return true;
+            }
+            case Opcode::Draw:
+            case Opcode::DrawIndexed: {
+                const auto args = payload.read<DrawArguments>();
+                if (!valid(payload))
+                    return false;
+                if (opcode == Opcode::Draw)
+                    commandList->draw(args);
+                else
+                    commandList->drawIndexed(args);
+                return true;
+            }
+            case Opcode::DrawIndirect:
+            case Opcode::DrawIndexedIndirect: {
+                const auto offsetBytes = payload.read<uint32_t>();
+                const auto drawCount = payload.read<uint32_t>();
+                if (!valid(payload))
+                    return false;
+                if (opcode == Opcode::DrawIndirect)
+                    commandList->drawIndirect(offsetBytes, drawCount);
+                else
+                    commandList->drawIndexedIndirect(offsetBytes, drawCount);
+                return true;
+            }
+            case Opcode::DrawIndirectCount:
+            case Opcode::DrawIndexedIndirectCount: {
+                const auto paramOffsetBytes = payload.read<uint32_t>();
+                const auto countOffsetBytes = payload.read<uint32_t>();
+                const auto maxDrawCount = payload.read<uint32_t>();
+                if (!valid(payload))
+                    return false;
+                if (opcode == Opcode::DrawIndirectCount)
+                    commandList->drawIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+                else
+                    commandList->drawIndexedIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+                return true;
+            }
+            case Opcode::ExecuteBundles: {
+                const auto numBundles = size_t(payload.read<uint64_t>());
+                std::vector<ICommandList*> bundles;
+                for (size_t i = 0; i < numBundles && !payload.failed(); i++)
+                    bundles.push_back(m_Objects.get<ICommandList>(payload.readObject()));
+                if (!valid(payload) || std::find(bundles.begin(), bundles.end(), nullptr) != bundles.end())
+                    return false;
+                commandList->executeBundles(bundles.data(), bundles.size());
+                return true;
+            }
+            case Opcode::SetComputeState: {
+                ComputeState state;
+                readComputeState(payload, m_Objects, state);
+                if (!valid(payload))
+                    return false;
+                commandList->setComputeState(state);
+                return true;
+            }
+            case Opcode::Dispatch: {
+                const auto groupsX = payload.read<uint32_t>();
+                const auto groupsY = payload.read<uint32_t>();
+                const auto groupsZ = payload.read<uint32_t>();
+                if (!valid(payload))
+                    return false;
+                commandList->dispatch(groupsX, groupsY, groupsZ);
+                return true;
+            }
+            case Opcode::DispatchIndirect: {
+                const auto offsetBytes = payload.read<uint32_t>();
+                if (!valid(payload))
+                    return false;
+                commandList->dispatchIndirect(offsetBytes);
+                return true;
+            }
+            case Opcode::BeginTimerQuery:
+            case Opcode::EndTimerQuery: {
+                ITimerQuery* query = m_Objects.get<ITimerQuery>(payload.readObject());
+                if (!query || !valid(payload))
+                    return false;
+                if (opcode == Opcode::BeginTimerQuery)
+                    commandList->beginTimerQuery(query);
+                else
+                    commandList->endTimerQuery(query);
+                return true;
+            }
+            case Opcode::BeginOcclusionQuery:
+            case Opcode::EndOcclusionQuery: {
+                IOcclusionQuery* query = m_Objects.get<IOcclusionQuery>(payload.readObject());
+                if (!query || !valid(payload))
+                    return false;
+                if (opcode == Opcode::BeginOcclusionQuery)
+                    commandList->beginOcclusionQuery(query);
+                else
+                    commandList->endOcclusionQuery(query);
+                return true;
+            }
+            case Opcode::BeginPipelineStatisticsQuery:
+            case Opcode::EndPipelineStatisticsQuery: {
+                IPipelineStatisticsQuery* query = m_Objects.get<IPipelineStatisticsQuery>(payload.readObject());
+                if (!query || !valid(payload))
+                    return false;
+                if (opcode == Opcode::BeginPipelineStatisticsQuery)
+                    commandList->beginPipelineStatisticsQuery(query);
+                else
+                    commandList->endPipelineStatisticsQuery(query);
+                return true;
+            }
+            case Opcode::SetPredication: {
+                IOcclusionQuery* query = m_Objects.get<IOcclusionQuery>(payload.readObject());
+                const auto op = payload.read<PredicationOp>();
+                if (!valid(payload))
+                    return false;
+                commandList->setPredication(query, op);
+                return true;
+            }
+            case Opcode::SignalSyncPoint: {
+                const ObjectKey key = payload.readObject();
+                if (!valid(payload))
+                    return false;
+                m_Objects.set(key, commandList->signalSyncPoint());
+                return true;
+            }
+            case Opcode::WaitSyncPoint: {
+                ISyncPoint* syncPoint = m_Objects.get<ISyncPoint>(payload.readObject());
+                const auto waitStages = payload.read<PipelineStages>();
+                if (!syncPoint || !valid(payload))
+                    return false;
+                commandList->waitSyncPoint(syncPoint, waitStages);
+                return true;
+            }
+            case Opcode::BeginMarker: {
+                const std::string name = payload.readString();
+                if (!valid(payload))
+                    return false;
+                if (m_MarkerDepth++ == 0)
+                    beginPass(commandList, name);
+                commandList->beginMarker(name.c_str());
+                return true;
+            }
+            case Opcode::EndMarker:
+                commandList->endMarker();
+                if (m_MarkerDepth > 0 && --m_MarkerDepth == 0)
+                    endPass(commandList);
+                return true;
+            case Opcode::SetEnableAutomaticBarriers: {
+                const auto enable = payload.read<bool>();
+                if (!valid(payload))
+                    return false;
+                commandList->setEnableAutomaticBarriers(enable);
+                return true;
+            }
+            case Opcode::SetResourceStatesForBindingSet: {
+                IBindingSet* bindingSet = m_Objects.get<IBindingSet>(payload.readObject());
+                if (!bindingSet || !valid(payload))
+                    return false;
+                commandList->setResourceStatesForBindingSet(bindingSet);
+                return true;
+            }
+            case Opcode::SetEnableUavBarriersForTexture: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto enable = payload.read<bool>();
+                if (!texture || !valid(payload))
+                    return false;
+                commandList->setEnableUavBarriersForTexture(texture, enable);
+                return true;
+            }
+            case Opcode::SetEnableUavBarriersForBuffer: {
+                IBuffer* buffer = m_Objects.get<IBuffer>(payload.readObject());
+                const auto enable = payload.read<bool>();
+                if (!buffer || !valid(payload))
+                    return false;
+                commandList->setEnableUavBarriersForBuffer(buffer, enable);
+                return true;
+            }
+            case Opcode::BeginTrackingTextureState:
+            case Opcode::SetTextureState:
+            case Opcode::BeginTextureStateTransition: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto subresources = payload.read<TextureSubresourceSet>();
+                const auto stateBits = payload.read<ResourceStates>();
+                if (!texture || !valid(payload))
+                    return false;
+                if (opcode == Opcode::BeginTrackingTextureState)
+                    commandList->beginTrackingTextureState(texture, subresources, stateBits);
+                else if (opcode == Opcode::SetTextureState)
+                    commandList->setTextureState(texture, subresources, stateBits);
+                else
+                    commandList->beginTextureStateTransition(texture, subresources, stateBits);
+                return true;
+            }
+            case Opcode::BeginTrackingBufferState:
+            case Opcode::SetBufferState:
+            case Opcode::BeginBufferStateTransition:
+            case Opcode::SetPermanentBufferState: {
+                IBuffer* buffer = m_Objects.get<IBuffer>(payload.readObject());
+                const auto stateBits = payload.read<ResourceStates>();
+                if (!buffer || !valid(payload))
+                    return false;
+                if (opcode == Opcode::BeginTrackingBufferState)
+                    commandList->beginTrackingBufferState(buffer, stateBits);
+                else if (opcode == Opcode::SetBufferState)
+                    commandList->setBufferState(buffer, stateBits);
+                else if (opcode == Opcode::BeginBufferStateTransition)
+                    commandList->beginBufferStateTransition(buffer, stateBits);
+                else
+                    commandList->setPermanentBufferState(buffer, stateBits);
+                return true;
+            }
+            case Opcode::SetPermanentTextureState: {
+                ITexture* texture = m_Objects.get<ITexture>(payload.readObject());
+                const auto stateBits = payload.read<ResourceStates>();
+                if (!texture || !valid(payload))
+                    return false;
+                commandList->setPermanentTextureState(texture, stateBits);
+                return true;
+            }
+            case Opcode::AliasingBarrier: {
+                IResource* resourceBefore = m_Objects.get<IResource>(payload.readObject());
+                IResource* resourceAfter = m_Objects.get<IResource>(payload.readObject());
+                if (!valid(payload))
+                    return false;
+                commandList->aliasingBarrier(resourceBefore, resourceAfter);
+                return true;
+            }
+            case Opcode::CommitBarriers:
+                commandList->commitBarriers();
+                return true;
+            case Opcode::BuildBottomLevelAccelStruct: {
+                rt::IAccelStruct* as = m_Objects.get<rt::IAccelStruct>(payload.readObject());
+                std::vector<rt::GeometryDesc> geometries;
+                readGeometryDescs(payload, m_Objects, geometries);
+                const auto buildFlags = payload.read<rt::AccelStructBuildFlags>();
+                if (!as || !valid(payload))
+                    return false;
+                commandList->buildBottomLevelAccelStruct(as, geometries.data(), geometries.size(), buildFlags);
+                return true;
+            }
+            case Opcode::BuildBottomLevelAccelStructs: {
+                const uint64_t numBuilds = payload.read<uint64_t>();
+                std::vector<std::vector<rt::GeometryDesc>> geometries;
+                std::vector<rt::BlasBuildDesc> builds;
+                for (uint64_t index = 0; index < numBuilds && !payload.failed(); index++)
+                {
+                    rt::BlasBuildDesc build;
+                    build.accelStruct = m_Objects.get<rt::IAccelStruct>(payload.readObject());
+                    readGeometryDescs(payload, m_Objects, geometries.emplace_back());
+                    build.buildFlags = payload.read<rt::AccelStructBuildFlags>();
+                    builds.push_back(build);
+                }
+                if (!valid(payload))
+                    return false;
+                for (size_t index = 0; index < builds.size(); index++)
+                {
+                    if (!builds[index].accelStruct)
+                        return false;
+                    builds[index].setGeometries(geometries[index].data(), geometries[index].size());
+                }
+                commandList->buildBottomLevelAccelStructs(builds.data(), builds.size());
+                return true;
+            }
+            case Opcode::CompactBottomLevelAccelStructs:
+                commandList->compactBottomLevelAccelStructs();
+                return true;
+            case Opcode::BuildTopLevelAccelStruct: {
+                rt::IAccelStruct* as = m_Objects.get<rt::IAccelStruct>(payload.readObject());
+                std::vector<rt::InstanceDesc> instances;
+                readInstanceDescs(payload, m_Objects, instances);
+                const auto buildFlags = payload.read<rt::AccelStructBuildFlags>();
+                if (!as || !valid(payload))
+                    return false;
+                commandList->buildTopLevelAccelStruct(as, instances.data(), instances.size(), buildFlags);
+                return true;
+            }
+            case Opcode::BuildTopLevelAccelStructFromBuffer: {
+                // Only builds from the instance buffer of the TLAS itself are captured
+                rt::IAccelStruct* as = m_Objects.get<rt::IAccelStruct>(payload.readObject());
+                const auto instanceBufferOffset = payload.read<uint64_t>();
+                const auto numInstances = size_t(payload.read<uint64_t>());
+                const auto buildFlags = payload.read<rt::AccelStructBuildFlags>();
+                if (!as || !as->getInstanceBuffer() || !valid(payload))
+                    return false;
+                commandList->buildTopLevelAccelStructFromBuffer(as, as->getInstanceBuffer(), instanceBufferOffset, numInstances, buildFlags);
+                return true;
+            }
+            case Opcode::UpdateTopLevelAccelStructInstances: {
+                rt::IAccelStruct* as = m_Objects.get<rt::IAccelStruct>(payload.readObject());
+                const auto firstInstance = size_t(payload.read<uint64_t>());
+                std::vector<rt::InstanceDesc> instances;
+                readInstanceDescs(payload, m_Objects, instances);
+                if (!as || !valid(payload))
+                    return false;
+                commandList->updateTopLevelAccelStructInstances(as, firstInstance, instances.data(), instances.size());
+                return true;
+            }
+            case Opcode::SetAccelStructState: {
+                rt::IAccelStruct* as = m_Objects.get<rt::IAccelStruct>(payload.readObject());
+                const auto stateBits = payload.read<ResourceStates>();
+                if (!as || !valid(payload))
+                    return false;
+                commandList->setAccelStructState(as, stateBits);
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+    }
+
+    bool replayCapture(IDevice* device, const std::string& fileName, const ReplayDesc& desc, ReplayResult& outResult)
+    {
+        outResult = ReplayResult();
+
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+
+        std::vector<uint8_t> data(size_t(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size())))
+            return false;
+
+        FileHeader header;
+        if (data.size() < sizeof(header))
+            return false;
+
+        memcpy(&header, data.data(), sizeof(header));
+        if (header.magic != c_FileMagic || header.fileVersion != c_FileVersion || header.headerVersion != c_HeaderVersion)
+            return false;
+
+        const Clock::time_point start = Clock::now();
+
+        StreamReader stream(data.data() + sizeof(header), data.size() - sizeof(header));
+        Replayer replayer(device, desc, outResult);
+        replayer.replay(stream);
+
+        outResult.totalMilliseconds = millisecondsSince(start);
+        return true;
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,848 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "capture-stream.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace nvrhi::capture
+{
+    void StreamWriter::beginRecord(Opcode opcode)
+    {
+        m_RecordStart = m_Data.size();
+        write(opcode);
+        write(uint64_t(0));
+    }
+
+    void StreamWriter::endRecord()
+    {
+        const uint64_t payloadSize = m_Data.size() - m_RecordStart - sizeof(Opcode) - sizeof(uint64_t);
+        memcpy(m_Data.data() + m_RecordStart + sizeof(Opcode), &payloadSize, sizeof(payloadSize));
+    }
+
+    void StreamWriter::writeBytes(const void* data, size_t size)
+    {
+        if (size == 0)
+            return;
+
+        const size_t offset = m_Data.size();
+        m_Data.resize(offset + size);
+        memcpy(m_Data.data() + offset, data, size);
+    }
+
+    bool StreamReader::readRecord(Opcode& outOpcode, StreamReader& outPayload)
+    {
+        if (m_Failed || m_Offset == m_Size)
+            return false;
+
+        outOpcode = read<Opcode>();
+        const uint64_t payloadSize = read<uint64_t>();
+        const void* payload = readBytes(size_t(payloadSize));
+        if (m_Failed)
+            return false;
+
+        outPayload = StreamReader(static_cast<const uint8_t*>(payload), size_t(payloadSize));
+        return true;
+    }
+
+    const void* StreamReader::readBytes(size_t size)
+    {
+        if (m_Failed || size > m_Size - m_Offset)
+        {
+            m_Failed = true;
+            return nullptr;
+        }
+
+        const void* data = m_Data + m_Offset;
+        m_Offset += size;
+        return data;
+    }
+
+    std::string StreamReader::readString()
+    {
+        size_t size = 0;
+        const void* data = readBlob(size);
+        return data ? std::string(static_cast<const char*>(data), size) : std::string();
+    }
+
+    const void* StreamReader::readBlob(size_t& outSize)
+    {
+        outSize = size_t(read<uint64_t>());
+        const void* data = readBytes(outSize);
+        if (!data)
+            outSize = 0;
+        return data;
+    }
+
+    MappedFileWriter::~MappedFileWriter()
+    {
+        close();
+    }
+
+    bool MappedFileWriter::open(const std::string& fileName, uint64_t mappingSize)
+    {
+        m_MappingSize = std::max<uint64_t>(mappingSize, 64 * 1024);
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        m_File = file;
+#else
+        m_File = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_File < 0)
+            return false;
+#endif
+
+        return map(m_MappingSize);
+    }
+
+    bool MappedFileWriter::map(uint64_t fileSize)
+    {
+#ifdef _WIN32
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READWRITE, DWORD(fileSize >> 32), DWORD(fileSize), nullptr);
+        if (!m_Mapping)
+            return false;
+
+        m_View = static_cast<uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_WRITE, 0, 0, SIZE_T(fileSize)));
+        if (!m_View)
+        {
+            CloseHandle(m_Mapping);
+            m_Mapping = nullptr;
+            return false;
+        }
+#else
+        if (ftruncate(m_File, off_t(fileSize)) != 0)
+            return false;
+
+        void* view = mmap(nullptr, size_t(fileSize), PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+        if (view == MAP_FAILED)
+            return false;
+
+        m_View = static_cast<uint8_t*>(view);
+#endif
+
+        m_FileSize = fileSize;
+        return true;
+    }
+
+    void MappedFileWriter::unmap()
+    {
+        if (!m_View)
+            return;
+
+#ifdef _WIN32
+        UnmapViewOfFile(m_View);
+        CloseHandle(m_Mapping);
+        m_Mapping = nullptr;
+#else
+        munmap(m_View, size_t(m_FileSize));
+#endif
+        m_View = nullptr;
+    }
+
+    bool MappedFileWriter::write(const void* data, size_t size)
+    {
+        if (m_Failed || !m_View)
+            return false;
+
+        if (m_WrittenSize + size > m_FileSize)
+        {
+            // Grow the file by at least one mapping step and map all of it again
+            const uint64_t newSize = std::max(m_WrittenSize + size, m_FileSize + m_MappingSize);
+
+            unmap();
+            if (!map(newSize))
+            {
+                m_Failed = true;
+                return false;
+            }
+        }
+
+        memcpy(m_View + m_WrittenSize, data, size);
+        m_WrittenSize += size;
+        return true;
+    }
+
+    void MappedFileWriter::close()
+    {
+        unmap();
+
+#ifdef _WIN32
+        if (m_File)
+        {
+            LARGE_INTEGER size;
+            size.QuadPart = LONGLONG(m_WrittenSize);
+            SetFilePointerEx(m_File, size, nullptr, FILE_BEGIN);
+            SetEndOfFile(m_File);
+            CloseHandle(m_File);
+            m_File = nullptr;
+        }
+#else
+        if (m_File >= 0)
+        {
+            if (ftruncate(m_File, off_t(m_WrittenSize)) != 0)
+                m_Failed = true;
+            ::close(m_File);
+            m_File = -1;
+        }
+#endif
+    }
+
+    void ObjectTable::set(ObjectKey key, IResource* object)
+    {
+        if (key == 0)
+            return;
+
+        if (object)
+            m_Objects[key] = object;
+        else
+            m_Objects.erase(key);
+
+        m_TransientObjects.erase(key);
+    }
+
+    void ObjectTable::setTransient(ObjectKey key, IResource* object)
+    {
+        if (key != 0 && object)
+            m_TransientObjects[key] = object;
+    }
+
+    IResource* ObjectTable::find(ObjectKey key) const
+    {
+        if (auto it = m_TransientObjects.find(key); it != m_TransientObjects.end())
+            return it->second;
+
+        if (auto it = m_Objects.find(key); it != m_Objects.end())
+            return it->second;
+
+        return nullptr;
+    }
+
+    size_t getTextureWriteSize(const TextureDesc& desc, uint32_t mipLevel, size_t rowPitch, size_t depthPitch)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t rows = (height + blockSize - 1) / blockSize;
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1;
+
+        return depthPitch * (depth - 1) + rowPitch * rows;
+    }
+
+    void getStagingSliceLayout(const TextureDesc& desc, const TextureSlice& slice, uint32_t& outRows, size_t& outRowSize)
+    {
+        const TextureSlice resolved = slice.resolve(desc);
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        outRows = ((resolved.height + blockSize - 1) / blockSize) * std::max(resolved.depth, 1u);
+        outRowSize = size_t((resolved.width + blockSize - 1) / blockSize) * formatInfo.bytesPerBlock;
+    }
+
+    void writeTextureDesc(StreamWriter& stream, const TextureDesc& desc)
+    {
+        stream.write(desc.width);
+        stream.write(desc.height);
+        stream.write(desc.depth);
+        stream.write(desc.arraySize);
+        stream.write(desc.mipLevels);
+        stream.write(desc.sampleCount);
+        stream.write(desc.sampleQuality);
+        stream.write(desc.format);
+        stream.write(desc.dimension);
+        stream.writeString(desc.debugName);
+        stream.write(desc.isShaderResource);
+        stream.write(desc.isRenderTarget);
+        stream.write(desc.isUAV);
+        stream.write(desc.isTypeless);
+        stream.write(desc.isShadingRateSurface);
+        stream.write(desc.sharedResourceFlags);
+        stream.write(desc.isVirtual);
+        stream.write(desc.isTiled);
+        stream.write(desc.isTransientAttachment);
+        stream.write(desc.clearValue);
+        stream.write(desc.useClearValue);
+        stream.write(desc.initialState);
+        stream.write(desc.keepInitialState);
+    }
+
+    void readTextureDesc(StreamReader& stream, TextureDesc& desc)
+    {
+        desc.width = stream.read<uint32_t>();
+        desc.height = stream.read<uint32_t>();
+        desc.depth = stream.read<uint32_t>();
+        desc.arraySize = stream.read<uint32_t>();
+        desc.mipLevels = stream.read<uint32_t>();
+        desc.sampleCount = stream.read<uint32_t>();
+        desc.sampleQuality = stream.read<uint32_t>();
+        desc.format = stream.read<Format>();
+        desc.dimension = stream.read<TextureDimension>();
+        desc.debugName = stream.readString();
+        desc.isShaderResource = stream.read<bool>();
+        desc.isRenderTarget = stream.read<bool>();
+        desc.isUAV = stream.read<bool>();
+        desc.isTypeless = stream.read<bool>();
+        desc.isShadingRateSurface = stream.read<bool>();
+        desc.sharedResourceFlags = stream.read<SharedResourceFlags>();
+        desc.isVirtual = stream.read<bool>();
+        desc.isTiled = stream.read<bool>();
+        desc.isTransientAttachment = stream.read<bool>();
+        desc.clearValue = stream.read<Color>();
+        desc.useClearValue = stream.read<bool>();
+        desc.initialState = stream.read<ResourceStates>();
+        desc.keepInitialState = stream.read<bool>();
+    }
+
+    void writeBufferDesc(StreamWriter& stream, const BufferDesc& desc)
+    {
+        stream.write(desc.byteSize);
+        stream.write(desc.structStride);
+        stream.write(desc.maxVersions);
+        stream.writeString(desc.debugName);
+        stream.write(desc.format);
+        stream.write(desc.canHaveUAVs);
+        stream.write(desc.canHaveTypedViews);
+        stream.write(desc.canHaveRawViews);
+        stream.write(desc.isVertexBuffer);
+        stream.write(desc.isIndexBuffer);
+        stream.write(desc.isConstantBuffer);
+        stream.write(desc.isDrawIndirectArgs);
+        stream.write(desc.isAccelStructBuildInput);
+        stream.write(desc.isAccelStructStorage);
+        stream.write(desc.isShaderBindingTable);
+        stream.write(desc.isVolatile);
+        stream.write(desc.isVirtual);
+        stream.write(desc.isTiled);
+        stream.write(desc.initialState);
+        stream.write(desc.keepInitialState);
+        stream.write(desc.cpuAccess);
+        stream.write(desc.sharedResourceFlags);
+    }
+
+    void readBufferDesc(StreamReader& stream, BufferDesc& desc)
+    {
+        desc.byteSize = stream.read<uint64_t>();
+        desc.structStride = stream.read<uint32_t>();
+        desc.maxVersions = stream.read<uint32_t>();
+        desc.debugName = stream.readString();
+        desc.format = stream.read<Format>();
+        desc.canHaveUAVs = stream.read<bool>();
+        desc.canHaveTypedViews = stream.read<bool>();
+        desc.canHaveRawViews = stream.read<bool>();
+        desc.isVertexBuffer = stream.read<bool>();
+        desc.isIndexBuffer = stream.read<bool>();
+        desc.isConstantBuffer = stream.read<bool>();
+        desc.isDrawIndirectArgs = stream.read<bool>();
+        desc.isAccelStructBuildInput = stream.read<bool>();
+        desc.isAccelStructStorage = stream.read<bool>();
+        desc.isShaderBindingTable = stream.read<bool>();
+        desc.isVolatile = stream.read<bool>();
+        desc.isVirtual = stream.read<bool>();
+        desc.isTiled = stream.read<bool>();
+        desc.initialState = stream.read<ResourceStates>();
+        desc.keepInitialState = stream.read<bool>();
+        desc.cpuAccess = stream.read<CpuAccessMode>();
+        desc.sharedResourceFlags = stream.read<SharedResourceFlags>();
+    }
+
+    void writeShaderDesc(StreamWriter& stream, const ShaderDesc& desc)
+    {
+        stream.write(desc.shaderType);
+        stream.writeString(desc.debugName);
+        stream.writeString(desc.entryName);
+        stream.write(desc.hlslExtensionsUAV);
+        stream.write(desc.useSpecificShaderExt);
+        stream.write(desc.fastGSFlags);
+
+        stream.write(desc.pCustomSemantics ? desc.numCustomSemantics : 0u);
+        for (uint32_t index = 0; desc.pCustomSemantics && index < desc.numCustomSemantics; index++)
+        {
+            stream.write(desc.pCustomSemantics[index].type);
+            stream.writeString(desc.pCustomSemantics[index].name);
+        }
+
+        // The backends read one swizzle per viewport
+        stream.write(desc.pCoordinateSwizzling != nullptr);
+        if (desc.pCoordinateSwizzling)
+            stream.writeBytes(desc.pCoordinateSwizzling, sizeof(uint32_t) * c_MaxViewports);
+    }
+
+    void readShaderDesc(StreamReader& stream, ShaderDescStorage& storage)
+    {
+        ShaderDesc& desc = storage.desc;
+        desc.shaderType = stream.read<ShaderType>();
+        desc.debugName = stream.readString();
+        desc.entryName = stream.readString();
+        desc.hlslExtensionsUAV = stream.read<int>();
+        desc.useSpecificShaderExt = stream.read<bool>();
+        desc.fastGSFlags = stream.read<FastGeometryShaderFlags>();
+
+        const uint32_t numCustomSemantics = stream.read<uint32_t>();
+        for (uint32_t index = 0; index < numCustomSemantics && !stream.failed(); index++)
+        {
+            CustomSemantic semantic;
+            semantic.type = stream.read<CustomSemantic::Type>();
+            semantic.name = stream.readString();
+            storage.customSemantics.push_back(semantic);
+        }
+        desc.numCustomSemantics = uint32_t(storage.customSemantics.size());
+        desc.pCustomSemantics = storage.customSemantics.empty() ? nullptr : storage.customSemantics.data();
+
+        if (stream.read<bool>())
+        {
+            storage.coordinateSwizzling.resize(c_MaxViewports);
+            if (const void* data = stream.readBytes(sizeof(uint32_t) * c_MaxViewports))
+                memcpy(storage.coordinateSwizzling.data(), data, sizeof(uint32_t) * c_MaxViewports);
+            desc.pCoordinateSwizzling = storage.coordinateSwizzling.data();
+        }
+    }
+
+    void writeVertexAttributes(StreamWriter& stream, const VertexAttributeDesc* attributes, uint32_t count)
+    {
+        stream.write(count);
+        for (uint32_t index = 0; index < count; index++)
+        {
+            const VertexAttributeDesc& attribute = attributes[index];
+            stream.writeString(attribute.name);
+            stream.write(attribute.format);
+            stream.write(attribute.arraySize);
+            stream.write(attribute.bufferIndex);
+            stream.write(attribute.offset);
+            stream.write(attribute.elementStride);
+            stream.write(attribute.isInstanced);
+        }
+    }
+
+    void readVertexAttributes(StreamReader& stream, std::vector<VertexAttributeDesc>& attributes)
+    {
+        const uint32_t count = stream.read<uint32_t>();
+        for (uint32_t index = 0; index < count && !stream.failed(); index++)
+        {
+            VertexAttributeDesc attribute;
+            attribute.name = stream.readString();
+            attribute.format = stream.read<Format>();
+            attribute.arraySize = stream.read<uint32_t>();
+            attribute.bufferIndex = stream.read<uint32_t>();
+            attribute.offset = stream.read<uint32_t>();
+            attribute.elementStride = stream.read<uint32_t>();
+            attribute.isInstanced = stream.read<bool>();
+            attributes.push_back(attribute);
+        }
+    }
+
+    static void writeFramebufferAttachment(StreamWriter& stream, const FramebufferAttachment& attachment)
+    {
+        stream.writeObject(attachment.texture);
+        stream.write(attachment.subresources);
+        stream.write(attachment.format);
+        stream.write(attachment.isReadOnly);
+        stream.write(attachment.loadOp);
+        stream.write(attachment.storeOp);
+        stream.write(attachment.useClearValue);
+        stream.write(attachment.clearValue);
+    }
+
+    static void readFramebufferAttachment(StreamReader& stream, ObjectTable& objects, FramebufferAttachment& attachment)
+    {
+        attachment.texture = objects.get<ITexture>(stream.readObject());
+        attachment.subresources = stream.read<TextureSubresourceSet>();
+        attachment.format = stream.read<Format>();
+        attachment.isReadOnly = stream.read<bool>();
+        attachment.loadOp = stream.read<AttachmentLoadOp>();
+        attachment.storeOp = stream.read<AttachmentStoreOp>();
+        attachment.useClearValue = stream.read<bool>();
+        attachment.clearValue = stream.read<Color>();
+    }
+
+    void writeFramebufferDesc(StreamWriter& stream, const FramebufferDesc& desc)
+    {
+        stream.write(uint32_t(desc.colorAttachments.size()));
+        for (const FramebufferAttachment& attachment : desc.colorAttachments)
+            writeFramebufferAttachment(stream, attachment);
+        writeFramebufferAttachment(stream, desc.depthAttachment);
+        writeFramebufferAttachment(stream, desc.shadingRateAttachment);
+    }
+
+    void readFramebufferDesc(StreamReader& stream, ObjectTable& objects, FramebufferDesc& desc)
+    {
+        const uint32_t count = std::min(stream.read<uint32_t>(), c_MaxRenderTargets);
+        desc.colorAttachments.resize(count);
+        for (FramebufferAttachment& attachment : desc.colorAttachments)
+            readFramebufferAttachment(stream, objects, attachment);
+        readFramebufferAttachment(stream, objects, desc.depthAttachment);
+        readFramebufferAttachment(stream, objects, desc.shadingRateAttachment);
+    }
+
+    static void writeBindingLayouts(StreamWriter& stream, const BindingLayoutVector& layouts)
+    {
+        stream.write(uint32_t(layouts.size()));
+        for (IBindingLayout* layout : layouts)
+            stream.writeObject(layout);
+    }
+
+    static void readBindingLayouts(StreamReader& stream, ObjectTable& objects, BindingLayoutVector& layouts)
+    {
+        const uint32_t count = std::min(stream.read<uint32_t>(), c_MaxBindingLayouts);
+        for (uint32_t index = 0; index < count; index++)
+            layouts.push_back(objects.get<IBindingLayout>(stream.readObject()));
+    }
+
+    void writeGraphicsPipelineDesc(StreamWriter& stream, const GraphicsPipelineDesc& desc)
+    {
+        stream.write(desc.primType);
+        stream.write(desc.patchControlPoints);
+        stream.writeObject(desc.inputLayout);
+        stream.writeObject(desc.VS);
+        stream.writeObject(desc.HS);
+        stream.writeObject(desc.DS);
+        stream.writeObject(desc.GS);
+        stream.writeObject(desc.PS);
+        stream.write(desc.renderState);
+        stream.write(desc.shadingRateState);
+        writeBindingLayouts(stream, desc.bindingLayouts);
+    }
+
+    void readGraphicsPipelineDesc(StreamReader& stream, ObjectTable& objects, GraphicsPipelineDesc& desc)
+    {
+        desc.primType = stream.read<PrimitiveType>();
+        desc.patchControlPoints = stream.read<uint32_t>();
+        desc.inputLayout = objects.get<IInputLayout>(stream.readObject());
+        desc.VS = objects.get<IShader>(stream.readObject());
+        desc.HS = objects.get<IShader>(stream.readObject());
+        desc.DS = objects.get<IShader>(stream.readObject());
+        desc.GS = objects.get<IShader>(stream.readObject());
+        desc.PS = objects.get<IShader>(stream.readObject());
+        desc.renderState = stream.read<RenderState>();
+        desc.shadingRateState = stream.read<VariableRateShadingState>();
+        readBindingLayouts(stream, objects, desc.bindingLayouts);
+    }
+
+    void writeComputePipelineDesc(StreamWriter& stream, const ComputePipelineDesc& desc)
+    {
+        stream.writeObject(desc.CS);
+        writeBindingLayouts(stream, desc.bindingLayouts);
+    }
+
+    void readComputePipelineDesc(StreamReader& stream, ObjectTable& objects, ComputePipelineDesc& desc)
+    {
+        desc.CS = objects.get<IShader>(stream.readObject());
+        readBindingLayouts(stream, objects, desc.bindingLayouts);
+    }
+
+    void writeBindingLayoutDesc(StreamWriter& stream, const BindingLayoutDesc& desc)
+    {
+        stream.write(desc.visibility);
+        stream.write(desc.registerSpace);
+        stream.write(desc.registerSpaceIsDescriptorSet);
+        stream.write(desc.usePushDescriptors);
+        stream.write(desc.bindingOffsets);
+        stream.write(uint32_t(desc.bindings.size()));
+        stream.writeBytes(desc.bindings.data(), desc.bindings.size() * sizeof(BindingLayoutItem));
+    }
+
+    void readBindingLayoutDesc(StreamReader& stream, BindingLayoutDesc& desc)
+    {
+        desc.visibility = stream.read<ShaderType>();
+        desc.registerSpace = stream.read<uint32_t>();
+        desc.registerSpaceIsDescriptorSet = stream.read<bool>();
+        desc.usePushDescriptors = stream.read<bool>();
+        desc.bindingOffsets = stream.read<VulkanBindingOffsets>();
+
+        const uint32_t count = stream.read<uint32_t>();
+        for (uint32_t index = 0; index < count && !stream.failed(); index++)
+            desc.bindings.push_back(stream.read<BindingLayoutItem>());
+    }
+
+    void writeBindlessLayoutDesc(StreamWriter& stream, const BindlessLayoutDesc& desc)
+    {
+        stream.write(desc.visibility);
+        stream.write(desc.firstSlot);
+        stream.write(desc.maxCapacity);
+        stream.write(desc.layoutType);
+        stream.write(uint32_t(desc.registerSpaces.size()));
+        stream.writeBytes(desc.registerSpaces.data(), desc.registerSpaces.size() * sizeof(BindingLayoutItem));
+    }
+
+    void readBindlessLayoutDesc(StreamReader& stream, BindlessLayoutDesc& desc)
+    {
+        desc.visibility = stream.read<ShaderType>();
+        desc.firstSlot = stream.read<uint32_t>();
+        desc.maxCapacity = stream.read<uint32_t>();
+        desc.layoutType = stream.read<BindlessLayoutDesc::LayoutType>();
+
+        const uint32_t count = std::min(stream.read<uint32_t>(), c_MaxBindlessRegisterSpaces);
+        for (uint32_t index = 0; index < count; index++)
+            desc.registerSpaces.push_back(stream.read<BindingLayoutItem>());
+    }
+
+    void writeBindingSetItems(StreamWriter& stream, const BindingSetItem* items, size_t count)
+    {
+        // The items are written as they are, with the resource pointers serving as the keys
+        stream.write(uint64_t(count));
+        stream.writeBytes(items, count * sizeof(BindingSetItem));
+    }
+
+    void readBindingSetItems(StreamReader& stream, ObjectTable& objects, std::vector<BindingSetItem>& items)
+    {
+        const uint64_t count = stream.read<uint64_t>();
+        for (uint64_t index = 0; index < count && !stream.failed(); index++)
+        {
+            BindingSetItem item = stream.read<BindingSetItem>();
+            item.resourceHandle = objects.get<IResource>(getObjectKey(item.resourceHandle));
+            items.push_back(item);
+        }
+    }
+
+    void writeBindingSetDesc(StreamWriter& stream, const BindingSetDesc& desc)
+    {
+        stream.write(desc.trackLiveness);
+        writeBindingSetItems(stream, desc.bindings.data(), desc.bindings.size());
+        stream.write(uint64_t(desc.inlineUniformData.size()));
+        stream.writeBytes(desc.inlineUniformData.data(), desc.inlineUniformData.size());
+    }
+
+    void readBindingSetDesc(StreamReader& stream, ObjectTable& objects, BindingSetDesc& desc)
+    {
+        desc.trackLiveness = stream.read<bool>();
+        readBindingSetItems(stream, objects, desc.bindings);
+        const size_t inlineUniformDataSize = size_t(stream.read<uint64_t>());
+        if (const uint8_t* data = static_cast<const uint8_t*>(stream.readBytes(inlineUniformDataSize)))
+            desc.inlineUniformData.assign(data, data + inlineUniformDataSize);
+    }
+
+    void writeGeometryDescs(StreamWriter& stream, const rt::GeometryDesc* geometries, size_t count)
+    {
+        // The geometries are written as they are, with the buffer pointers serving as the keys
+        stream.write(uint64_t(count));
+        stream.writeBytes(geometries, count * sizeof(rt::GeometryDesc));
+    }
+
+    void readGeometryDescs(StreamReader& stream, ObjectTable& objects, std::vector<rt::GeometryDesc>& geometries)
+    {
+        const uint64_t count = stream.read<uint64_t>();
+        for (uint64_t index = 0; index < count && !stream.failed(); index++)
+        {
+            rt::GeometryDesc geometry = stream.read<rt::GeometryDesc>();
+            switch (geometry.geometryType)
+            {
+            case rt::GeometryType::Triangles: {
+                rt::GeometryTriangles& triangles = geometry.geometryData.triangles;
+                triangles.indexBuffer = objects.get<IBuffer>(getObjectKey(triangles.indexBuffer));
+                triangles.vertexBuffer = objects.get<IBuffer>(getObjectKey(triangles.vertexBuffer));
+                triangles.opacityMicromap = objects.get<rt::IOpacityMicromap>(getObjectKey(triangles.opacityMicromap));
+                triangles.ommIndexBuffer = objects.get<IBuffer>(getObjectKey(triangles.ommIndexBuffer));
+                triangles.pOmmUsageCounts = nullptr;
+                triangles.numOmmUsageCounts = 0;
+                break;
+            }
+            case rt::GeometryType::AABBs:
+                geometry.geometryData.aabbs.buffer = objects.get<IBuffer>(getObjectKey(geometry.geometryData.aabbs.buffer));
+                geometry.geometryData.aabbs.unused = nullptr;
+                break;
+            case rt::GeometryType::Spheres:
+                geometry.geometryData.spheres.indexBuffer = objects.get<IBuffer>(getObjectKey(geometry.geometryData.spheres.indexBuffer));
+                geometry.geometryData.spheres.vertexBuffer = objects.get<IBuffer>(getObjectKey(geometry.geometryData.spheres.vertexBuffer));
+                break;
+            case rt::GeometryType::Lss:
+                geometry.geometryData.lss.indexBuffer = objects.get<IBuffer>(getObjectKey(geometry.geometryData.lss.indexBuffer));
+                geometry.geometryData.lss.vertexBuffer = objects.get<IBuffer>(getObjectKey(geometry.geometryData.lss.vertexBuffer));
+                break;
+            default:
+                geometry.geometryData = {};
+                break;
+            }
+            geometries.push_back(geometry);
+        }
+    }
+
+    void writeAccelStructDesc(StreamWriter& stream, const rt::AccelStructDesc& desc)
+    {
+        stream.write(uint64_t(desc.topLevelMaxInstances));
+        writeGeometryDescs(stream, desc.bottomLevelGeometries.data(), desc.bottomLevelGeometries.size());
+        stream.write(desc.buildFlags);
+        stream.writeString(desc.debugName);
+        stream.write(desc.trackLiveness);
+        stream.write(desc.isTopLevel);
+        stream.write(desc.isVirtual);
+        stream.write(desc.createInstanceBuffer);
+    }
+
+    void readAccelStructDesc(StreamReader& stream, ObjectTable& objects, rt::AccelStructDesc& desc)
+    {
+        desc.topLevelMaxInstances = size_t(stream.read<uint64_t>());
+        readGeometryDescs(stream, objects, desc.bottomLevelGeometries);
+        desc.buildFlags = stream.read<rt::AccelStructBuildFlags>();
+        desc.debugName = stream.readString();
+        desc.trackLiveness = stream.read<bool>();
+        desc.isTopLevel = stream.read<bool>();
+        desc.isVirtual = stream.read<bool>();
+        desc.createInstanceBuffer = stream.read<bool>();
+    }
+
+    void writeInstanceDescs(StreamWriter& stream, const rt::InstanceDesc* instances, size_t count)
+    {
+        // The instances are written as they are, with the BLAS pointers serving as the keys
+        stream.write(uint64_t(count));
+        stream.writeBytes(instances, count * sizeof(rt::InstanceDesc));
+    }
+
+    void readInstanceDescs(StreamReader& stream, ObjectTable& objects, std::vector<rt::InstanceDesc>& instances)
+    {
+        const uint64_t count = stream.read<uint64_t>();
+        for (uint64_t index = 0; index < count && !stream.failed(); index++)
+        {
+            rt::InstanceDesc instance = stream.read<rt::InstanceDesc>();
+            instance.bottomLevelAS = objects.get<rt::IAccelStruct>(getObjectKey(instance.bottomLevelAS));
+            instances.push_back(instance);
+        }
+    }
+
+    void writeViewportState(StreamWriter& stream, const ViewportState& state)
+    {
+        stream.write(uint32_t(state.viewports.size()));
+        stream.writeBytes(state.viewports.data(), state.viewports.size() * sizeof(Viewport));
+        stream.write(uint32_t(state.scissorRects.size()));
+        stream.writeBytes(state.scissorRects.data(), state.scissorRects.size() * sizeof(Rect));
+    }
+
+    void readViewportState(StreamReader& stream, ViewportState& state)
+    {
+        const uint32_t numViewports = std::min(stream.read<uint32_t>(), c_MaxViewports);
+        for (uint32_t index = 0; index < numViewports; index++)
+            state.viewports.push_back(stream.read<Viewport>());
+
+        const uint32_t numScissorRects = std::min(stream.read<uint32_t>(), c_MaxViewports);
+        for (uint32_t index = 0; index < numScissorRects; index++)
+            state.scissorRects.push_back(stream.read<Rect>());
+    }
+
+    void writeVertexBuffers(StreamWriter& stream, const VertexBufferBinding* bindings, size_t count)
+    {
+        stream.write(uint32_t(count));
+        for (size_t index = 0; index < count; index++)
+        {
+            stream.writeObject(bindings[index].buffer);
+            stream.write(bindings[index].slot);
+            stream.write(bindings[index].offset);
+        }
+    }
+
+    void readVertexBuffers(StreamReader& stream, ObjectTable& objects, static_vector<VertexBufferBinding, c_MaxVertexAttributes>& bindings)
+    {
+        const uint32_t count = std::min(stream.read<uint32_t>(), c_MaxVertexAttributes);
+        for (uint32_t index = 0; index < count; index++)
+        {
+            VertexBufferBinding binding;
+            binding.buffer = objects.get<IBuffer>(stream.readObject());
+            binding.slot = stream.read<uint32_t>();
+            binding.offset = stream.read<uint64_t>();
+            bindings.push_back(binding);
+        }
+    }
+
+    void writeIndexBuffer(StreamWriter& stream, const IndexBufferBinding& binding)
+    {
+        stream.writeObject(binding.buffer);
+        stream.write(binding.format);
+        stream.write(binding.offset);
+    }
+
+    void readIndexBuffer(StreamReader& stream, ObjectTable& objects, IndexBufferBinding& binding)
+    {
+        binding.buffer = objects.get<IBuffer>(stream.readObject());
+        binding.format = stream.read<Format>();
+        binding.offset = stream.read<uint32_t>();
+    }
+
+    static void writeBindingSets(StreamWriter& stream, const BindingSetVector& bindings)
+    {
+        stream.write(uint32_t(bindings.size()));
+        for (IBindingSet* bindingSet : bindings)
+            stream.writeObject(bindingSet);
+    }
+
+    static void readBindingSets(StreamReader& stream, ObjectTable& objects, BindingSetVector& bindings)
+    {
+        const uint32_t count = std::min(stream.read<uint32_t>(), c_MaxBindingLayouts);
+        for (uint32_t index = 0; index < count; index++)
+            bindings.push_back(objects.get<IBindingSet>(stream.readObject()));
+    }
+
+    void writeGraphicsState(StreamWriter& stream, const GraphicsState& state)
+    {
+        stream.writeObject(state.pipeline);
+        stream.writeObject(state.framebuffer);
+        writeViewportState(stream, state.viewport);
+        stream.write(state.shadingRateState);
+        stream.write(state.blendConstantColor);
+        stream.write(state.dynamicStencilRefValue);
+        writeBindingSets(stream, state.bindings);
+        writeVertexBuffers(stream, state.vertexBuffers.data(), state.vertexBuffers.size());
+        writeIndexBuffer(stream, state.indexBuffer);
+        stream.writeObject(state.indirectParams);
+        stream.writeObject(state.indirectCountBuffer);
+    }
+
+    void readGraphicsState(StreamReader& stream, ObjectTable& objects, GraphicsState& state)
+    {
+        state.pipeline = objects.get<IGraphicsPipeline>(stream.readObject());
+        state.framebuffer = objects.get<IFramebuffer>(stream.readObject());
+        readViewportState(stream, state.viewport);
+        state.shadingRateState = stream.read<VariableRateShadingState>();
+        state.blendConstantColor = stream.read<Color>();
+        state.dynamicStencilRefValue = stream.read<uint8_t>();
+        readBindingSets(stream, objects, state.bindings);
+        readVertexBuffers(stream, objects, state.vertexBuffers);
+        readIndexBuffer(stream, objects, state.indexBuffer);
+        state.indirectParams = objects.get<IBuffer>(stream.readObject());
+        state.indirectCountBuffer = objects.get<IBuffer>(stream.readObject());
+    }
+
+    void writeComputeState(StreamWriter& stream, const ComputeState& state)
+    {
+        stream.writeObject(state.pipeline);
+        writeBindingSets(stream, state.bindings);
+        stream.writeObject(state.indirectParams);
+        stream.writeObject(state.indirectCountBuffer);
+    }
+
+    void readComputeState(StreamReader& stream, ObjectTable& objects, ComputeState& state)
+    {
+        state.pipeline = objects.get<IComputePipeline>(stream.readObject());
+        readBindingSets(stream, objects, state.bindings);
+        state.indirectParams = objects.get<IBuffer>(stream.readObject());
+        state.indirectCountBuffer = objects.get<IBuffer>(stream.readObject());
+    }
+
+} // namespace nvrhi::capture
@@ -0,0 +1,349 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/capture.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi::capture
+{
+    constexpr uint32_t c_FileMagic = 0x5043564e; // "NVCP"
+    constexpr uint32_t c_FileVersion = 3;
+
+    struct FileHeader
+    {
+        uint32_t magic = c_FileMagic;
+        uint32_t fileVersion = c_FileVersion;
+        uint32_t headerVersion = c_HeaderVersion;
+        uint32_t reserved = 0;
+    };
+
+    // Every record in the file is the opcode, the payload size as uint64_t, and the payload.
+    // The device records are written to the file directly, and the command list records are written into
+    // the payload of a CommandListRecording record when the command list is closed.
+    enum class Opcode : uint32_t
+    {
+        // Device
+        CreateTexture = 1,
+        CreateStagingTexture,
+        CreateBuffer,
+        CreateShader,
+        CreateShaderSpecialization,
+        CreateSampler,
+        CreateInputLayout,
+        CreateEventQuery,
+        SetEventQuery,
+        CreateTimerQuery,
+        CreateOcclusionQuery,
+        CreatePipelineStatisticsQuery,
+        CreateFramebuffer,
+        CreateGraphicsPipeline,
+        CreateComputePipeline,
+        CreateBindingLayout,
+        CreateBindlessLayout,
+        CreateBindingSet,
+        CreateDescriptorTable,
+        ResizeDescriptorTable,
+        WriteDescriptorTable,
+        CreateCommandList,
+        CommandListRecording,
+        ExecuteCommandLists,
+        QueueWaitForCommandList,
+        WaitForIdle,
+        RunGarbageCollection,
+        WriteBufferContents,
+        WriteStagingTextureContents,
+        Unsupported,
+        CreateAccelStruct,
+
+        // Command list
+        ClearState = 0x1000,
+        ClearTextureFloat,
+        ClearDepthStencilTexture,
+        ClearTextureUInt,
+        CopyTexture,
+        CopyTextureToStaging,
+        CopyTextureFromStaging,
+        WriteTexture,
+        ResolveTexture,
+        GenerateMips,
+        BlitTexture,
+        WriteBuffer,
+        ClearBufferUInt,
+        CopyBuffer,
+        CreateTransientBindingSet,
+        SetPushConstants,
+        SetGraphicsState,
+        SetGraphicsBindingSet,
+        SetVertexBuffers,
+        SetIndexBuffer,
+        SetViewportState,
+        Draw,
+        DrawIndexed,
+        DrawIndirect,
+        DrawIndexedIndirect,
+        DrawIndirectCount,
+        DrawIndexedIndirectCount,
+        ExecuteBundles,
+        SetComputeState,
+        Dispatch,
+        DispatchIndirect,
+        BeginTimerQuery,
+        EndTimerQuery,
+        BeginOcclusionQuery,
+        EndOcclusionQuery,
+        BeginPipelineStatisticsQuery,
+        EndPipelineStatisticsQuery,
+        SetPredication,
+        SignalSyncPoint,
+        WaitSyncPoint,
+        BeginMarker,
+        EndMarker,
+        SetEnableAutomaticBarriers,
+        SetResourceStatesForBindingSet,
+        SetEnableUavBarriersForTexture,
+        SetEnableUavBarriersForBuffer,
+        BeginTrackingTextureState,
+        BeginTrackingBufferState,
+        SetTextureState,
+        SetBufferState,
+        SetPermanentTextureState,
+        SetPermanentBufferState,
+        BeginTextureStateTransition,
+        BeginBufferStateTransition,
+        AliasingBarrier,
+        CommitBarriers,
+        BuildBottomLevelAccelStruct,
+        BuildBottomLevelAccelStructs,
+        CompactBottomLevelAccelStructs,
+        BuildTopLevelAccelStruct,
+        BuildTopLevelAccelStructFromBuffer,
+        UpdateTopLevelAccelStructInstances,
+        SetAccelStructState
+    };
+
+    // Objects are identified by the address they had when they were created. An address is only reused
+    // after the object that had it is destroyed, so the replay releases its object for a key when another
+    // object is created with the same key.
+    typedef uint64_t ObjectKey;
+
+    inline ObjectKey getObjectKey(const void* object) { return ObjectKey(uintptr_t(object)); }
+
+    class StreamWriter
+    {
+    public:
+        void clear() { m_Data.clear(); }
+        [[nodiscard]] bool empty() const { return m_Data.empty(); }
+        [[nodiscard]] const uint8_t* data() const { return m_Data.data(); }
+        [[nodiscard]] size_t size() const { return m_Data.size(); }
+
+        void beginRecord(Opcode opcode);
+        void endRecord();
+
+        void writeBytes(const void* data, size_t size);
+
+        template<typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written directly");
+            writeBytes(&value, sizeof(T));
+        }
+
+        void writeString(const std::string& value) { writeBlob(value.data(), value.size()); }
+        void writeBlob(const void* data, size_t size) { write(uint64_t(size)); writeBytes(data, size); }
+        void writeObject(const void* object) { write(getObjectKey(object)); }
+
+    private:
+        std::vector<uint8_t> m_Data;
+        size_t m_RecordStart = 0;
+    };
+
+    class StreamReader
+    {
+    public:
+        StreamReader() = default;
+        StreamReader(const uint8_t* data, size_t size) : m_Data(data), m_Size(size) { }
+
+        // Returns false at the end of the stream or if the record is truncated
+        bool readRecord(Opcode& outOpcode, StreamReader& outPayload);
+
+        // Returns nullptr and marks the stream as failed if there are not enough bytes left
+        const void* readBytes(size_t size);
+
+        template<typename T>
+        T read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read directly");
+            T value{};
+            if (const void* data = readBytes(sizeof(T)))
+                memcpy(&value, data, sizeof(T));
+            return value;
+        }
+
+        std::string readString();
+        const void* readBlob(size_t& outSize);
+        ObjectKey readObject() { return read<ObjectKey>(); }
+
+        [[nodiscard]] bool failed() const { return m_Failed; }
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+        size_t m_Offset = 0;
+        bool m_Failed = false;
+    };
+
+    // Appends data to a file through a view of the whole file mapped into memory,
+    // growing the file and remapping it when the written data reaches the end of the view.
+    class MappedFileWriter
+    {
+    public:
+        MappedFileWriter() = default;
+        ~MappedFileWriter();
+
+        MappedFileWriter(const MappedFileWriter&) = delete;
+        MappedFileWriter& operator=(const MappedFileWriter&) = delete;
+
+        bool open(const std::string& fileName, uint64_t mappingSize);
+        bool write(const void* data, size_t size);
+
+        // Unmaps the file and truncates it to the written size
+        void close();
+
+    private:
+        bool map(uint64_t fileSize);
+        void unmap();
+
+#ifdef _WIN32
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#else
+        int m_File = -1;
+#endif
+        uint8_t* m_View = nullptr;
+        uint64_t m_FileSize = 0;
+        uint64_t m_WrittenSize = 0;
+        uint64_t m_MappingSize = 0;
+        bool m_Failed = false;
+    };
+
+    // The objects created by a replay, by the keys they had in the capture
+    class ObjectTable
+    {
+    public:
+        void set(ObjectKey key, IResource* object);
+
+        // Transient objects are owned by a command list and are not kept alive by the table
+        void setTransient(ObjectKey key, IResource* object);
+        void clearTransient() { m_TransientObjects.clear(); }
+
+        // Returns nullptr for key 0. A key that is unknown or refers to an object of a different type
+        // also returns nullptr and sets the missing flag, so that the call using it can be skipped.
+        template<typename T>
+        T* get(ObjectKey key)
+        {
+            if (key == 0)
+                return nullptr;
+
+            IResource* object = find(key);
+            T* result = object ? dynamic_cast<T*>(object) : nullptr;
+            if (!result)
+                m_Missing = true;
+
+            return result;
+        }
+
+        bool takeMissing() { const bool missing = m_Missing; m_Missing = false; return missing; }
+
+    private:
+        IResource* find(ObjectKey key) const;
+
+        std::unordered_map<ObjectKey, RefCountPtr<IResource>> m_Objects;
+        std::unordered_map<ObjectKey, IResource*> m_TransientObjects;
+        bool m_Missing = false;
+    };
+
+    // Number of bytes read by writeTexture for the given subresource and pitches
+    size_t getTextureWriteSize(const TextureDesc& desc, uint32_t mipLevel, size_t rowPitch, size_t depthPitch);
+
+    // Returns the number of rows and the bytes per row of a staging texture slice, in blocks for compressed formats
+    void getStagingSliceLayout(const TextureDesc& desc, const TextureSlice& slice, uint32_t& outRows, size_t& outRowSize);
+
+    void writeTextureDesc(StreamWriter& stream, const TextureDesc& desc);
+    void readTextureDesc(StreamReader& stream, TextureDesc& desc);
+    void writeBufferDesc(StreamWriter& stream, const BufferDesc& desc);
+    void readBufferDesc(StreamReader& stream, BufferDesc& desc);
+
+    // Custom semantics and coordinate swizzling use pointers in ShaderDesc, so the reader keeps them here
+    struct ShaderDescStorage
+    {
+        ShaderDesc desc;
+        std::vector<CustomSemantic> customSemantics;
+        std::vector<uint32_t> coordinateSwizzling;
+    };
+
+    void writeShaderDesc(StreamWriter& stream, const ShaderDesc& desc);
+    void readShaderDesc(StreamReader& stream, ShaderDescStorage& storage);
+    void writeVertexAttributes(StreamWriter& stream, const VertexAttributeDesc* attributes, uint32_t count);
+    void readVertexAttributes(StreamReader& stream, std::vector<VertexAttributeDesc>& attributes);
+
+    void writeFramebufferDesc(StreamWriter& stream, const FramebufferDesc& desc);
+    void readFramebufferDesc(StreamReader& stream, ObjectTable& objects, FramebufferDesc& desc);
+    void writeGraphicsPipelineDesc(StreamWriter& stream, const GraphicsPipelineDesc& desc);
+    void readGraphicsPipelineDesc(StreamReader& stream, ObjectTable& objects, GraphicsPipelineDesc& desc);
+    void writeComputePipelineDesc(StreamWriter& stream, const ComputePipelineDesc& desc);
+    void readComputePipelineDesc(StreamReader& stream, ObjectTable& objects, ComputePipelineDesc& desc);
+    void writeBindingLayoutDesc(StreamWriter& stream, const BindingLayoutDesc& desc);
+    void readBindingLayoutDesc(StreamReader& stream, BindingLayoutDesc& desc);
+    void writeBindlessLayoutDesc(StreamWriter& stream, const BindlessLayoutDesc& desc);
+    void readBindlessLayoutDesc(StreamReader& stream, BindlessLayoutDesc& desc);
+    void writeBindingSetItems(StreamWriter& stream, const BindingSetItem* items, size_t count);
+    void readBindingSetItems(StreamReader& stream, ObjectTable& objects, std::vector<BindingSetItem>& items);
+    void writeBindingSetDesc(StreamWriter& stream, const BindingSetDesc& desc);
+    void readBindingSetDesc(StreamReader& stream, ObjectTable& objects, BindingSetDesc& desc);
+
+    // Opacity micromaps are not captured, so the geometries that use them are read with a missing object
+    void writeGeometryDescs(StreamWriter& stream, const rt::GeometryDesc* geometries, size_t count);
+    void readGeometryDescs(StreamReader& stream, ObjectTable& objects, std::vector<rt::GeometryDesc>& geometries);
+    void writeAccelStructDesc(StreamWriter& stream, const rt::AccelStructDesc& desc);
+    void readAccelStructDesc(StreamReader& stream, ObjectTable& objects, rt::AccelStructDesc& desc);
+    void writeInstanceDescs(StreamWriter& stream, const rt::InstanceDesc* instances, size_t count);
+    void readInstanceDescs(StreamReader& stream, ObjectTable& objects, std::vector<rt::InstanceDesc>& instances);
+
+    void writeViewportState(StreamWriter& stream, const ViewportState& state);
+    void readViewportState(StreamReader& stream, ViewportState& state);
+    void writeVertexBuffers(StreamWriter& stream, const VertexBufferBinding* bindings, size_t count);
+    void readVertexBuffers(StreamReader& stream, ObjectTable& objects, static_vector<VertexBufferBinding, c_MaxVertexAttributes>& bindings);
+    void writeIndexBuffer(StreamWriter& stream, const IndexBufferBinding& binding);
+    void readIndexBuffer(StreamReader& stream, ObjectTable& objects, IndexBufferBinding& binding);
+    void writeGraphicsState(StreamWriter& stream, const GraphicsState& state);
+    void readGraphicsState(StreamReader& stream, ObjectTable& objects, GraphicsState& state);
+    void writeComputeState(StreamWriter& stream, const ComputeState& state);
+    void readComputeState(StreamReader& stream, ObjectTable& objects, ComputeState& state);
+
+} // namespace nvrhi::capture
@@ -0,0 +1,278 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/bindless-registry.h>
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi
+{
+    class BindlessResourceRegistry : public RefCounter<IBindlessResourceRegistry>
+    {
+    public:
+        BindlessResourceRegistry(IDevice* device, const BindlessResourceRegistryDesc& desc)
+            : m_Device(device)
+            , m_Desc(desc)
+        { }
+
+        bool init();
+
+        BindlessIndex registerResource(const BindingSetItem& item) override;
+        void updateResource(BindlessIndex index, const BindingSetItem& item) override;
+        void releaseResource(BindlessIndex index) override;
+        void flush(CommandQueue queue) override;
+        [[nodiscard]] const BindlessResourceRegistryDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] IBindingLayout* getBindingLayout() const override { return m_Layout; }
+        [[nodiscard]] IDescriptorTable* getDescriptorTable() const override { return m_DescriptorTable; }
+        [[nodiscard]] uint32_t getDescriptorHeapBase() const override { return m_DescriptorTable->getFirstDescriptorIndexInHeap(); }
+        [[nodiscard]] uint32_t getNumAllocatedIndices() const override;
+
+    private:
+        // Indices released before one flush may be used by the command lists submitted right after it,
+        // so they are tracked with the event query set by the following flush
+        struct RetiringIndices
+        {
+            EventQueryHandle query;
+            std::vector<BindlessIndex> indices;
+        };
+
+        IDevice* m_Device;
+        BindlessResourceRegistryDesc m_Desc;
+        BindingLayoutHandle m_Layout;
+        DescriptorTableHandle m_DescriptorTable;
+
+        mutable std::mutex m_Mutex;
+        std::vector<ResourceHandle> m_Resources; // indexed by BindlessIndex, keeps the resources alive until reuse
+        std::vector<bool> m_Registered;
+        uint32_t m_NextUnusedIndex = 0;
+        std::vector<BindlessIndex> m_FreeIndices;
+        std::vector<BindlessIndex> m_ReleasedIndices;  // since the last flush
+        std::vector<BindlessIndex> m_AwaitingQuery;    // released before the last flush
+        std::deque<RetiringIndices> m_RetiringIndices; // in submission order
+        std::vector<EventQueryHandle> m_FreeQueries;
+        std::vector<BindingSetItem> m_PendingWrites;
+        std::vector<bool> m_WrittenIndices; // scratch space of flush, all false outside of it
+
+        void error(const std::string& message) const;
+        [[nodiscard]] bool isRegistered(BindlessIndex index) const { return index < m_Registered.size() && m_Registered[index]; }
+        void queueWrite(BindlessIndex index, const BindingSetItem& item);
+        void recycleRetiredIndices();
+    };
+
+    void BindlessResourceRegistry::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    bool BindlessResourceRegistry::init()
+    {
+        BindlessLayoutDesc layoutDesc = m_Desc.layoutDesc;
+        layoutDesc.maxCapacity = m_Desc.capacity;
+
+        m_Layout = m_Device->createBindlessLayout(layoutDesc);
+        if (!m_Layout)
+            return false;
+
+        m_DescriptorTable = m_Device->createDescriptorTable(m_Layout);
+        if (!m_DescriptorTable)
+            return false;
+
+        // Allocate the whole table up front, the indices must not move later
+        m_Device->resizeDescriptorTable(m_DescriptorTable, m_Desc.capacity, false);
+
+        m_Resources.resize(m_Desc.capacity);
+        m_Registered.resize(m_Desc.capacity, false);
+        m_WrittenIndices.resize(m_Desc.capacity, false);
+        return true;
+    }
+
+    void BindlessResourceRegistry::queueWrite(BindlessIndex index, const BindingSetItem& item)
+    {
+        BindingSetItem write = item;
+        write.slot = index;
+        m_PendingWrites.push_back(write);
+
+        m_Resources[index] = item.resourceHandle;
+    }
+
+    BindlessIndex BindlessResourceRegistry::registerResource(const BindingSetItem& item)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        BindlessIndex index;
+        if (!m_FreeIndices.empty())
+        {
+            index = m_FreeIndices.back();
+            m_FreeIndices.pop_back();
+        }
+        else if (m_NextUnusedIndex < m_Desc.capacity)
+        {
+            index = m_NextUnusedIndex++;
+        }
+        else
+        {
+            std::stringstream ss;
+            ss << "Bindless resource registry " << utils::DebugNameToString(m_Desc.debugName)
+                << " is full, its capacity is " << m_Desc.capacity << " descriptors";
+            error(ss.str());
+            return c_InvalidBindlessIndex;
+        }
+
+        m_Registered[index] = true;
+        queueWrite(index, item);
+        return index;
+    }
+
+    void BindlessResourceRegistry::updateResource(BindlessIndex index, const BindingSetItem& item)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!isRegistered(index))
+        {
+            std::stringstream ss;
+            ss << "Cannot update index " << index << " of bindless resource registry "
+                << utils::DebugNameToString(m_Desc.debugName) << " because it is not registered";
+            error(ss.str());
+            return;
+        }
+
+        queueWrite(index, item);
+    }
+
+    void BindlessResourceRegistry::releaseResource(BindlessIndex index)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!isRegistered(index))
+        {
+            std::stringstream ss;
+            ss << "Cannot release index " << index << " of bindless resource registry "
+                << utils::DebugNameToString(m_Desc.debugName) << " because it is not registered";
+            error(ss.str());
+            return;
+        }
+
+        m_Registered[index] = false;
+        m_ReleasedIndices.push_back(index);
+    }
+
+    void BindlessResourceRegistry::recycleRetiredIndices()
+    {
+        while (!m_RetiringIndices.empty() && m_Device->pollEventQuery(m_RetiringIndices.front().query))
+        {
+            RetiringIndices& retiring = m_RetiringIndices.front();
+
+            for (BindlessIndex index : retiring.indices)
+            {
+                m_Resources[index] = nullptr;
+                m_FreeIndices.push_back(index);
+            }
+
+            m_Device->resetEventQuery(retiring.query);
+            m_FreeQueries.push_back(retiring.query);
+            m_RetiringIndices.pop_front();
+        }
+    }
+
+    void BindlessResourceRegistry::flush(CommandQueue queue)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Writes to the same index replace each other, only the last one is needed
+        if (m_PendingWrites.size() > 1)
+        {
+            size_t last = m_PendingWrites.size();
+            for (size_t i = m_PendingWrites.size(); i-- > 0; )
+            {
+                const BindlessIndex index = m_PendingWrites[i].slot;
+                if (m_WrittenIndices[index])
+                    continue;
+
+                m_WrittenIndices[index] = true;
+                m_PendingWrites[--last] = m_PendingWrites[i];
+            }
+            m_PendingWrites.erase(m_PendingWrites.begin(), m_PendingWrites.begin() + ptrdiff_t(last));
+
+            for (const BindingSetItem& item : m_PendingWrites)
+                m_WrittenIndices[item.slot] = false;
+        }
+
+        // Skip the indices that have been released after the write was queued
+        m_PendingWrites.erase(std::remove_if(m_PendingWrites.begin(), m_PendingWrites.end(),
+            [this](const BindingSetItem& item) { return !isRegistered(item.slot); }), m_PendingWrites.end());
+
+        if (!m_PendingWrites.empty())
+            m_Device->writeDescriptorTable(m_DescriptorTable, m_PendingWrites.data(), m_PendingWrites.size());
+        m_PendingWrites.clear();
+
+        recycleRetiredIndices();
+
+        if (!m_AwaitingQuery.empty())
+        {
+            EventQueryHandle query;
+            if (!m_FreeQueries.empty())
+            {
+                query = m_FreeQueries.back();
+                m_FreeQueries.pop_back();
+            }
+            else
+            {
+                query = m_Device->createEventQuery();
+            }
+
+            m_Device->setEventQuery(query, queue);
+
+            RetiringIndices retiring;
+            retiring.query = query;
+            retiring.indices = std::move(m_AwaitingQuery);
+            m_RetiringIndices.push_back(std::move(retiring));
+        }
+
+        m_AwaitingQuery = std::move(m_ReleasedIndices);
+        m_ReleasedIndices.clear();
+    }
+
+    uint32_t BindlessResourceRegistry::getNumAllocatedIndices() const
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_NextUnusedIndex - uint32_t(m_FreeIndices.size());
+    }
+
+    BindlessResourceRegistryHandle createBindlessResourceRegistry(IDevice* device, const BindlessResourceRegistryDesc& desc)
+    {
+        BindlessResourceRegistry* registry = new BindlessResourceRegistry(device, desc);
+        BindlessResourceRegistryHandle handle = BindlessResourceRegistryHandle::Create(registry);
+
+        if (!registry->init())
+            return nullptr;
+
+        return handle;
+    }
+
+} // namespace nvrhi
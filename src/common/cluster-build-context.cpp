@@ -0,0 +1,230 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/cluster-build-context.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace nvrhi::rt::cluster
+{
+    class BuildContext : public RefCounter<IBuildContext>
+    {
+    public:
+        BuildContext(IDevice* device, const BuildContextDesc& desc)
+            : m_Device(device)
+            , m_Desc(desc)
+        {
+            m_Desc.clasParams.mode = OperationMode::ImplicitDestinations;
+            m_Desc.blasParams.mode = OperationMode::ImplicitDestinations;
+        }
+
+        bool initialize();
+
+        void build(ICommandList* commandList, const BuildContextInputs& inputs) override;
+        [[nodiscard]] const BuildContextDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] const OperationSizeInfo& getClasSizeInfo() const override { return m_ClasSizeInfo; }
+        [[nodiscard]] const OperationSizeInfo& getBlasSizeInfo() const override { return m_BlasSizeInfo; }
+        [[nodiscard]] IBuffer* getClasBuffer() override { return m_ClasBuffer; }
+        [[nodiscard]] IBuffer* getClasAddressesBuffer() override { return m_ClasAddressesBuffer; }
+        [[nodiscard]] IBuffer* getClasSizesBuffer() override { return m_ClasSizesBuffer; }
+        [[nodiscard]] IBuffer* getBlasBuffer() override { return m_BlasBuffer; }
+        [[nodiscard]] IBuffer* getBlasAddressesBuffer() override { return m_BlasAddressesBuffer; }
+        [[nodiscard]] IBuffer* getBlasSizesBuffer() override { return m_BlasSizesBuffer; }
+        [[nodiscard]] IBuffer* getScratchBuffer() override { return m_ScratchBuffer; }
+
+    private:
+        DeviceHandle m_Device;
+        BuildContextDesc m_Desc;
+
+        OperationSizeInfo m_ClasSizeInfo;
+        OperationSizeInfo m_BlasSizeInfo;
+
+        BufferHandle m_ClasBuffer;
+        BufferHandle m_ClasAddressesBuffer;
+        BufferHandle m_ClasSizesBuffer;
+        BufferHandle m_BlasBuffer;
+        BufferHandle m_BlasAddressesBuffer;
+        BufferHandle m_BlasSizesBuffer;
+        BufferHandle m_ScratchBuffer;
+
+        void error(const std::string& message) const
+        {
+            std::stringstream ss;
+            ss << "Cluster build context " << utils::DebugNameToString(m_Desc.debugName) << ": " << message;
+            m_Device->getMessageCallback()->message(MessageSeverity::Error, ss.str().c_str());
+        }
+
+        BufferHandle createResultBuffer(uint64_t byteSize, const char* suffix);
+        BufferHandle createArrayBuffer(uint32_t elementCount, uint32_t stride, const char* suffix);
+    };
+
+    BufferHandle BuildContext::createResultBuffer(uint64_t byteSize, const char* suffix)
+    {
+        return m_Device->createBuffer(BufferDesc()
+            .setByteSize(byteSize)
+            .setCanHaveUAVs(true)
+            .setIsAccelStructStorage(true)
+            .setInitialState(ResourceStates::AccelStructRead)
+            .setKeepInitialState(true)
+            .setDebugName(m_Desc.debugName + suffix));
+    }
+
+    BufferHandle BuildContext::createArrayBuffer(uint32_t elementCount, uint32_t stride, const char* suffix)
+    {
+        return m_Device->createBuffer(BufferDesc()
+            .setByteSize(uint64_t(elementCount) * stride)
+            .setStructStride(stride)
+            .setCanHaveUAVs(true)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName(m_Desc.debugName + suffix));
+    }
+
+    bool BuildContext::initialize()
+    {
+        if (!m_Device->queryFeatureSupport(Feature::RayTracingClusters))
+        {
+            error("the device doesn't support cluster acceleration structures");
+            return false;
+        }
+
+        if (m_Desc.clasParams.type != OperationType::ClasBuild && m_Desc.clasParams.type != OperationType::ClasInstantiateTemplates)
+        {
+            error("clasParams.type must be ClasBuild or ClasInstantiateTemplates");
+            return false;
+        }
+
+        if (m_Desc.clasParams.maxArgCount == 0)
+        {
+            error("clasParams.maxArgCount is 0");
+            return false;
+        }
+
+        const bool buildsBlas = m_Desc.blasParams.maxArgCount != 0;
+        if (buildsBlas && m_Desc.blasParams.type != OperationType::BlasBuild)
+        {
+            error("blasParams.type must be BlasBuild");
+            return false;
+        }
+
+        m_ClasSizeInfo = m_Device->getClusterOperationSizeInfo(m_Desc.clasParams);
+        if (buildsBlas)
+            m_BlasSizeInfo = m_Device->getClusterOperationSizeInfo(m_Desc.blasParams);
+
+        if (m_ClasSizeInfo.resultMaxSizeInBytes == 0 || (buildsBlas && m_BlasSizeInfo.resultMaxSizeInBytes == 0))
+        {
+            error("the operation parameters are not supported by the device");
+            return false;
+        }
+
+        m_ClasBuffer = createResultBuffer(m_ClasSizeInfo.resultMaxSizeInBytes, " CLAS");
+        m_ClasAddressesBuffer = createArrayBuffer(m_Desc.clasParams.maxArgCount, sizeof(uint64_t), " CLAS addresses");
+        m_ClasSizesBuffer = createArrayBuffer(m_Desc.clasParams.maxArgCount, sizeof(uint32_t), " CLAS sizes");
+
+        if (buildsBlas)
+        {
+            m_BlasBuffer = createResultBuffer(m_BlasSizeInfo.resultMaxSizeInBytes, " BLAS");
+            m_BlasAddressesBuffer = createArrayBuffer(m_Desc.blasParams.maxArgCount, sizeof(uint64_t), " BLAS addresses");
+            m_BlasSizesBuffer = createArrayBuffer(m_Desc.blasParams.maxArgCount, sizeof(uint32_t), " BLAS sizes");
+        }
+
+        // The builds are separated by barriers, so they can use the same scratch memory
+        const uint64_t scratchSize = std::max(m_ClasSizeInfo.scratchSizeInBytes, m_BlasSizeInfo.scratchSizeInBytes);
+        m_ScratchBuffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(std::max(scratchSize, uint64_t(1)))
+            .setCanHaveUAVs(true)
+            .setInitialState(ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true)
+            .setDebugName(m_Desc.debugName + " scratch"));
+
+        if (!m_ClasBuffer || !m_ClasAddressesBuffer || !m_ClasSizesBuffer || !m_ScratchBuffer ||
+            (buildsBlas && (!m_BlasBuffer || !m_BlasAddressesBuffer || !m_BlasSizesBuffer)))
+        {
+            error("cannot create the buffers");
+            return false;
+        }
+
+        return true;
+    }
+
+    void BuildContext::build(ICommandList* commandList, const BuildContextInputs& inputs)
+    {
+        if (!inputs.clasArgsBuffer)
+        {
+            error("build: clasArgsBuffer is NULL");
+            return;
+        }
+
+        if (inputs.blasArgsBuffer && !m_BlasBuffer)
+        {
+            error("build: the context was created without BLAS parameters, it cannot build BLAS");
+            return;
+        }
+
+        OperationDesc clasDesc;
+        clasDesc.params = m_Desc.clasParams;
+        clasDesc.scratchSizeInBytes = m_ClasSizeInfo.scratchSizeInBytes;
+        clasDesc.scratchBuffer = m_ScratchBuffer;
+        clasDesc.inIndirectArgCountBuffer = inputs.clasArgCountBuffer;
+        clasDesc.inIndirectArgCountOffsetInBytes = inputs.clasArgCountOffsetInBytes;
+        clasDesc.inIndirectArgsBuffer = inputs.clasArgsBuffer;
+        clasDesc.inIndirectArgsOffsetInBytes = inputs.clasArgsOffsetInBytes;
+        clasDesc.inOutAddressesBuffer = m_ClasAddressesBuffer;
+        clasDesc.outSizesBuffer = m_ClasSizesBuffer;
+        clasDesc.outAccelerationStructuresBuffer = m_ClasBuffer;
+        commandList->executeMultiIndirectClusterOperation(clasDesc);
+
+        if (!inputs.blasArgsBuffer)
+            return;
+
+        // The BLAS build reads the new CLAS through the addresses referenced by its arguments
+        commandList->setBufferState(m_ClasBuffer, ResourceStates::AccelStructRead);
+        commandList->setBufferState(m_ClasAddressesBuffer, ResourceStates::ShaderResource);
+        commandList->commitBarriers();
+
+        OperationDesc blasDesc;
+        blasDesc.params = m_Desc.blasParams;
+        blasDesc.scratchSizeInBytes = m_BlasSizeInfo.scratchSizeInBytes;
+        blasDesc.scratchBuffer = m_ScratchBuffer;
+        blasDesc.inIndirectArgCountBuffer = inputs.blasArgCountBuffer;
+        blasDesc.inIndirectArgCountOffsetInBytes = inputs.blasArgCountOffsetInBytes;
+        blasDesc.inIndirectArgsBuffer = inputs.blasArgsBuffer;
+        blasDesc.inIndirectArgsOffsetInBytes = inputs.blasArgsOffsetInBytes;
+        blasDesc.inOutAddressesBuffer = m_BlasAddressesBuffer;
+        blasDesc.outSizesBuffer = m_BlasSizesBuffer;
+        blasDesc.outAccelerationStructuresBuffer = m_BlasBuffer;
+        commandList->executeMultiIndirectClusterOperation(blasDesc);
+    }
+
+    BuildContextHandle createBuildContext(IDevice* device, const BuildContextDesc& desc)
+    {
+        RefCountPtr<BuildContext> context = RefCountPtr<BuildContext>::Create(new BuildContext(device, desc));
+
+        if (!context->initialize())
+            return nullptr;
+
+        return context;
+    }
+
+} // namespace nvrhi::rt::cluster
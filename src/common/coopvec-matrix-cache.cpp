@@ -0,0 +1,410 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/coopvec-matrix-cache.h>
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi::coopvec
+{
+    // Conservative alignment of the converted matrices, satisfies both DX12 and Vulkan
+    constexpr uint64_t c_MatrixAlignment = 128;
+
+    class MatrixCache : public RefCounter<IMatrixCache>
+    {
+    public:
+        MatrixCache(IDevice* device, const MatrixCacheDesc& desc)
+            : m_Device(device)
+            , m_Desc(desc)
+        { }
+
+        bool initialize();
+
+        void getConvertedMatrices(ICommandList* commandList, const MatrixConversionRequest* requests, size_t numRequests, ConvertedMatrix* outMatrices) override;
+        void invalidate(IBuffer* srcBuffer) override;
+        void clear() override;
+        [[nodiscard]] uint64_t getAllocatedBytes() const override;
+        [[nodiscard]] const MatrixCacheDesc& getDesc() const override { return m_Desc; }
+
+    private:
+        struct Key
+        {
+            IBuffer* srcBuffer;
+            uint64_t srcOffset;
+            size_t srcSize;
+            size_t srcStride;
+            DataType srcType;
+            MatrixLayout srcLayout;
+            DataType dstType;
+            MatrixLayout dstLayout;
+            uint32_t numRows;
+            uint32_t numColumns;
+
+            bool operator==(const Key& other) const
+            {
+                return srcBuffer == other.srcBuffer
+                    && srcOffset == other.srcOffset
+                    && srcSize == other.srcSize
+                    && srcStride == other.srcStride
+                    && srcType == other.srcType
+                    && srcLayout == other.srcLayout
+                    && dstType == other.dstType
+                    && dstLayout == other.dstLayout
+                    && numRows == other.numRows
+                    && numColumns == other.numColumns;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                size_t hash = 0;
+                hash_combine(hash, key.srcBuffer);
+                hash_combine(hash, key.srcOffset);
+                hash_combine(hash, key.srcSize);
+                hash_combine(hash, key.srcStride);
+                hash_combine(hash, uint32_t(key.srcType));
+                hash_combine(hash, uint32_t(key.srcLayout));
+                hash_combine(hash, uint32_t(key.dstType));
+                hash_combine(hash, uint32_t(key.dstLayout));
+                hash_combine(hash, key.numRows);
+                hash_combine(hash, key.numColumns);
+                return hash;
+            }
+        };
+
+        struct Entry
+        {
+            BufferHandle srcBuffer; // keeps the buffer alive so that its address can't be reused by another buffer
+            uint32_t blockIndex = 0;
+            uint64_t offset = 0;
+            size_t size = 0;
+        };
+
+        struct Block
+        {
+            BufferHandle buffer; // NULL for released blocks, their slots are reused
+            uint64_t usedBytes = 0;
+            uint32_t entryCount = 0;
+        };
+
+        DeviceHandle m_Device;
+        MatrixCacheDesc m_Desc;
+
+        mutable std::mutex m_Mutex;
+        std::unordered_map<Key, Entry, KeyHash> m_Entries;
+        std::vector<Block> m_Blocks;
+        uint32_t m_CurrentBlock = ~0u; // the block that new matrices are placed into
+        uint64_t m_AllocatedBytes = 0;
+
+        // Used locally in getConvertedMatrices, members to avoid re-allocations
+        std::vector<size_t> m_MissIndices;
+        std::vector<MatrixSizeDesc> m_SizeDescs;
+        std::vector<size_t> m_Sizes;
+        std::vector<ConvertMatrixLayoutDesc> m_ConvertDescs;
+        std::vector<uint32_t> m_UsedBlocks;
+
+        void error(const std::string& message) const
+        {
+            std::stringstream ss;
+            ss << "CoopVec matrix cache " << utils::DebugNameToString(m_Desc.debugName) << ": " << message;
+            m_Device->getMessageCallback()->message(MessageSeverity::Error, ss.str().c_str());
+        }
+
+        static Key makeKey(const MatrixConversionRequest& request)
+        {
+            Key key;
+            key.srcBuffer = request.src.buffer;
+            key.srcOffset = request.src.offset;
+            key.srcSize = request.src.size;
+            key.srcStride = request.src.stride;
+            key.srcType = request.src.type;
+            key.srcLayout = request.src.layout;
+            key.dstType = request.dstType;
+            key.dstLayout = request.dstLayout;
+            key.numRows = request.numRows;
+            key.numColumns = request.numColumns;
+            return key;
+        }
+
+        // Places a matrix into the current block or a new one, returns false if a buffer cannot be created
+        bool allocate(size_t size, uint32_t& outBlockIndex, uint64_t& outOffset);
+        void releaseEntry(const Entry& entry);
+        ConvertedMatrix getConvertedMatrix(const MatrixConversionRequest& request, const Entry& entry) const;
+    };
+
+    bool MatrixCache::initialize()
+    {
+        if (!m_Device->queryFeatureSupport(Feature::CooperativeVectorInferencing))
+        {
+            error("the device doesn't support cooperative vectors");
+            return false;
+        }
+
+        if (m_Desc.blockSize == 0)
+        {
+            error("blockSize is 0");
+            return false;
+        }
+
+        m_Desc.blockSize = align(m_Desc.blockSize, c_MatrixAlignment);
+
+        return true;
+    }
+
+    bool MatrixCache::allocate(size_t size, uint32_t& outBlockIndex, uint64_t& outOffset)
+    {
+        const uint64_t alignedSize = align(uint64_t(size), c_MatrixAlignment);
+
+        if (m_CurrentBlock < m_Blocks.size())
+        {
+            Block& block = m_Blocks[m_CurrentBlock];
+            if (block.usedBytes + alignedSize <= block.buffer->getDesc().byteSize)
+            {
+                outBlockIndex = m_CurrentBlock;
+                outOffset = block.usedBytes;
+                block.usedBytes += alignedSize;
+                ++block.entryCount;
+                return true;
+            }
+        }
+
+        const bool dedicated = alignedSize > m_Desc.blockSize;
+        const uint64_t byteSize = dedicated ? alignedSize : m_Desc.blockSize;
+
+        BufferHandle buffer = m_Device->createBuffer(BufferDesc()
+            .setByteSize(byteSize)
+            .setCanHaveUAVs(true)
+            .setInitialState(ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName(m_Desc.debugName + " block"));
+
+        if (!buffer)
+        {
+            error("cannot create a destination buffer");
+            return false;
+        }
+
+        uint32_t blockIndex = 0;
+        while (blockIndex < m_Blocks.size() && m_Blocks[blockIndex].buffer)
+            ++blockIndex;
+        if (blockIndex == m_Blocks.size())
+            m_Blocks.emplace_back();
+
+        Block& block = m_Blocks[blockIndex];
+        block.buffer = buffer;
+        block.usedBytes = alignedSize;
+        block.entryCount = 1;
+        m_AllocatedBytes += byteSize;
+
+        // Keep filling the current block when the new one is a dedicated buffer for a large matrix
+        if (!dedicated)
+            m_CurrentBlock = blockIndex;
+
+        outBlockIndex = blockIndex;
+        outOffset = 0;
+        return true;
+    }
+
+    void MatrixCache::releaseEntry(const Entry& entry)
+    {
+        Block& block = m_Blocks[entry.blockIndex];
+        if (--block.entryCount != 0)
+            return;
+
+        if (entry.blockIndex == m_CurrentBlock)
+        {
+            // The GPU may still read from the released matrices, so don't place new ones over them
+            m_CurrentBlock = ~0u;
+        }
+
+        m_AllocatedBytes -= block.buffer->getDesc().byteSize;
+        block = Block();
+    }
+
+    ConvertedMatrix MatrixCache::getConvertedMatrix(const MatrixConversionRequest& request, const Entry& entry) const
+    {
+        ConvertedMatrix result;
+        result.matrix.buffer = m_Blocks[entry.blockIndex].buffer;
+        result.matrix.offset = entry.offset;
+        result.matrix.type = request.dstType;
+        result.matrix.layout = request.dstLayout;
+        result.matrix.size = entry.size;
+        result.matrix.stride = getOptimalMatrixStride(request.dstType, request.dstLayout, request.numRows, request.numColumns);
+        return result;
+    }
+
+    void MatrixCache::getConvertedMatrices(ICommandList* commandList, const MatrixConversionRequest* requests, size_t numRequests, ConvertedMatrix* outMatrices)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_MissIndices.clear();
+        m_SizeDescs.clear();
+
+        for (size_t i = 0; i < numRequests; ++i)
+        {
+            const MatrixConversionRequest& request = requests[i];
+            outMatrices[i] = ConvertedMatrix();
+
+            if (!request.src.buffer || request.src.size == 0 || request.numRows == 0 || request.numColumns == 0)
+            {
+                std::stringstream ss;
+                ss << "requests[" << i << "] has no source buffer, size or dimensions";
+                error(ss.str());
+                continue;
+            }
+
+            auto it = m_Entries.find(makeKey(request));
+            if (it != m_Entries.end())
+            {
+                outMatrices[i] = getConvertedMatrix(request, it->second);
+                continue;
+            }
+
+            m_MissIndices.push_back(i);
+            m_SizeDescs.push_back(MatrixSizeDesc()
+                .setType(request.dstType)
+                .setLayout(request.dstLayout)
+                .setDimensions(request.numRows, request.numColumns));
+        }
+
+        if (m_MissIndices.empty())
+            return;
+
+        m_Sizes.resize(m_SizeDescs.size());
+        m_Device->getCoopVecMatrixSizes(m_SizeDescs.data(), m_SizeDescs.size(), m_Sizes.data());
+
+        m_ConvertDescs.clear();
+        m_UsedBlocks.clear();
+
+        for (size_t missIndex = 0; missIndex < m_MissIndices.size(); ++missIndex)
+        {
+            const size_t requestIndex = m_MissIndices[missIndex];
+            const MatrixConversionRequest& request = requests[requestIndex];
+            const Key key = makeKey(request);
+
+            // The same matrix may be requested more than once in a batch
+            auto it = m_Entries.find(key);
+            if (it != m_Entries.end())
+            {
+                outMatrices[requestIndex] = getConvertedMatrix(request, it->second);
+                continue;
+            }
+
+            const size_t size = m_Sizes[missIndex];
+            if (size == 0)
+            {
+                std::stringstream ss;
+                ss << "cannot query the converted size of requests[" << requestIndex << "]";
+                error(ss.str());
+                continue;
+            }
+
+            Entry entry;
+            entry.srcBuffer = request.src.buffer;
+            entry.size = size;
+            if (!allocate(size, entry.blockIndex, entry.offset))
+                continue;
+
+            if (std::find(m_UsedBlocks.begin(), m_UsedBlocks.end(), entry.blockIndex) == m_UsedBlocks.end())
+                m_UsedBlocks.push_back(entry.blockIndex);
+
+            ConvertedMatrix& result = outMatrices[requestIndex];
+            result = getConvertedMatrix(request, entry);
+            result.converted = true;
+
+            ConvertMatrixLayoutDesc& convertDesc = m_ConvertDescs.emplace_back();
+            convertDesc.src = request.src;
+            convertDesc.dst = result.matrix;
+            convertDesc.numRows = request.numRows;
+            convertDesc.numColumns = request.numColumns;
+
+            m_Entries.emplace(key, std::move(entry));
+        }
+
+        if (m_ConvertDescs.empty())
+            return;
+
+        // Transition the destination blocks explicitly so that the conversions work without automatic barriers,
+        // and so that shaders recorded later into the same command list see the converted matrices.
+        for (uint32_t blockIndex : m_UsedBlocks)
+            commandList->setBufferState(m_Blocks[blockIndex].buffer, ResourceStates::ConvertCoopVecMatrixOutput);
+
+        commandList->commitBarriers();
+        commandList->convertCoopVecMatrices(m_ConvertDescs.data(), m_ConvertDescs.size());
+
+        for (uint32_t blockIndex : m_UsedBlocks)
+            commandList->setBufferState(m_Blocks[blockIndex].buffer, ResourceStates::ShaderResource);
+
+        commandList->commitBarriers();
+    }
+
+    void MatrixCache::invalidate(IBuffer* srcBuffer)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+        {
+            if (it->first.srcBuffer == srcBuffer)
+            {
+                releaseEntry(it->second);
+                it = m_Entries.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    void MatrixCache::clear()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Entries.clear();
+        m_Blocks.clear();
+        m_CurrentBlock = ~0u;
+        m_AllocatedBytes = 0;
+    }
+
+    uint64_t MatrixCache::getAllocatedBytes() const
+    {
+        std::lock_guard lockGuard(m_Mutex);
+        return m_AllocatedBytes;
+    }
+
+    MatrixCacheHandle createMatrixCache(IDevice* device, const MatrixCacheDesc& desc)
+    {
+        RefCountPtr<MatrixCache> cache = RefCountPtr<MatrixCache>::Create(new MatrixCache(device, desc));
+
+        if (!cache->initialize())
+            return nullptr;
+
+        return cache;
+    }
+
+} // namespace nvrhi::coopvec
@@ -0,0 +1,92 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace nvrhi
+{
+    // Remembers the on-device sizes of CoopVec matrices returned by the driver, keyed by type, layout and dimensions,
+    // so that size queries repeated for the same matrix shapes don't call into the driver again.
+    // The sizes don't depend on the contents of the matrices, so the entries never need to be invalidated.
+    class CoopVecMatrixSizeCache
+    {
+    public:
+        template<typename TQuery>
+        size_t get(coopvec::DataType type, coopvec::MatrixLayout layout, uint32_t rows, uint32_t columns, TQuery&& query)
+        {
+            const Key key = { type, layout, rows, columns };
+
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                auto it = m_Sizes.find(key);
+                if (it != m_Sizes.end())
+                    return it->second;
+            }
+
+            const size_t size = query(type, layout, rows, columns);
+
+            // Don't remember failed queries, they may succeed later or be caused by invalid arguments
+            if (size != 0)
+            {
+                std::lock_guard lockGuard(m_Mutex);
+                m_Sizes.try_emplace(key, size);
+            }
+
+            return size;
+        }
+
+    private:
+        struct Key
+        {
+            coopvec::DataType type;
+            coopvec::MatrixLayout layout;
+            uint32_t rows;
+            uint32_t columns;
+
+            bool operator==(const Key& other) const
+            {
+                return type == other.type && layout == other.layout && rows == other.rows && columns == other.columns;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                size_t hash = 0;
+                hash_combine(hash, uint32_t(key.type));
+                hash_combine(hash, uint32_t(key.layout));
+                hash_combine(hash, key.rows);
+                hash_combine(hash, key.columns);
+                return hash;
+            }
+        };
+
+        std::mutex m_Mutex;
+        std::unordered_map<Key, size_t, KeyHash> m_Sizes;
+    };
+}
@@ -0,0 +1,267 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d-texture-blitter.h"
+
+#include <nvrhi/utils.h>
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <d3dcompiler.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace nvrhi
+{
+    // Texture2DArray views work for 2D textures, 2D arrays and cube maps alike.
+    // With a linear sampler, sampling at the center of a destination pixel that covers 2x2 source pixels
+    // averages them, which makes the mip generation a box filter.
+    static const char* const c_BlitShaderSource = R"(
+Texture2DArray<float4> t_Source : register(t0);
+RWTexture2DArray<float4> u_Dest : register(u0);
+SamplerState s_Sampler : register(s0);
+
+cbuffer c_Constants : register(b0)
+{
+    float2 g_SourceOrigin;
+    float2 g_SourceStep;
+    uint2 g_DestOrigin;
+    uint2 g_DestSize;
+};
+
+[numthreads(8, 8, 1)]
+void main(uint3 threadId : SV_DispatchThreadID)
+{
+    if (any(threadId.xy >= g_DestSize))
+        return;
+
+    float2 uv = g_SourceOrigin + (float2(threadId.xy) + 0.5) * g_SourceStep;
+    u_Dest[uint3(g_DestOrigin + threadId.xy, threadId.z)] = t_Source.SampleLevel(s_Sampler, float3(uv, threadId.z), 0);
+}
+)";
+
+    static constexpr uint32_t c_BlitGroupSize = 8;
+
+    void D3DTextureBlitter::error(const std::string& message)
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    bool D3DTextureBlitter::initialize()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_InitializeAttempted)
+            return m_Pipeline != nullptr;
+
+        m_InitializeAttempted = true;
+
+        HMODULE compilerModule = LoadLibraryW(L"d3dcompiler_47.dll");
+        pD3DCompile compile = compilerModule
+            ? reinterpret_cast<pD3DCompile>(GetProcAddress(compilerModule, "D3DCompile"))
+            : nullptr;
+
+        if (!compile)
+        {
+            error("Texture blits and mip generation require d3dcompiler_47.dll, which could not be loaded");
+            if (compilerModule)
+                FreeLibrary(compilerModule);
+            return false;
+        }
+
+        RefCountPtr<ID3DBlob> bytecode;
+        RefCountPtr<ID3DBlob> errors;
+        const HRESULT hr = compile(c_BlitShaderSource, strlen(c_BlitShaderSource), "texture-blit.hlsl", nullptr, nullptr,
+            "main", "cs_5_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &bytecode, &errors);
+
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "Failed to compile the texture blit shader, HRESULT = 0x" << std::hex << hr;
+            if (errors)
+                ss << ":\n" << static_cast<const char*>(errors->GetBufferPointer());
+            error(ss.str());
+        }
+        else
+        {
+            m_Shader = m_Device->createShader(ShaderDesc()
+                .setShaderType(ShaderType::Compute)
+                .setDebugName("TextureBlit")
+                .setEntryName("main"),
+                bytecode->GetBufferPointer(), bytecode->GetBufferSize());
+        }
+
+        bytecode = nullptr;
+        errors = nullptr;
+        FreeLibrary(compilerModule);
+
+        if (!m_Shader)
+            return false;
+
+        auto layoutDesc = BindingLayoutDesc()
+            .setVisibility(ShaderType::Compute)
+            .addItem(BindingLayoutItem::PushConstants(0, sizeof(BlitConstants)))
+            .addItem(BindingLayoutItem::Texture_SRV(0))
+            .addItem(BindingLayoutItem::Texture_UAV(0))
+            .addItem(BindingLayoutItem::Sampler(0));
+
+        m_BindingLayout = m_Device->createBindingLayout(layoutDesc);
+        if (!m_BindingLayout)
+            return false;
+
+        m_Pipeline = m_Device->createComputePipeline(ComputePipelineDesc()
+            .setComputeShader(m_Shader)
+            .addBindingLayout(m_BindingLayout));
+
+        m_LinearSampler = m_Device->createSampler(SamplerDesc()
+            .setAllFilters(true)
+            .setAllAddressModes(SamplerAddressMode::Clamp));
+
+        m_PointSampler = m_Device->createSampler(SamplerDesc()
+            .setAllFilters(false)
+            .setAllAddressModes(SamplerAddressMode::Clamp));
+
+        if (!m_LinearSampler || !m_PointSampler)
+            m_Pipeline = nullptr;
+
+        return m_Pipeline != nullptr;
+    }
+
+    bool D3DTextureBlitter::checkDestination(ITexture* dest, const char* function)
+    {
+        const TextureDesc& desc = dest->getDesc();
+
+        if (!desc.isUAV)
+        {
+            std::stringstream ss;
+            ss << function << ": the destination texture " << utils::DebugNameToString(desc.debugName)
+                << " must be created with isUAV = true on DX11 and DX12";
+            error(ss.str());
+            return false;
+        }
+
+        if (getFormatInfo(desc.format).isSRGB)
+        {
+            std::stringstream ss;
+            ss << function << ": the destination texture " << utils::DebugNameToString(desc.debugName)
+                << " has an sRGB format, which cannot be written through a UAV on DX11 and DX12";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void D3DTextureBlitter::dispatch(ICommandList* commandList, ITexture* dest, MipLevel destMipLevel, ArraySlice destArraySlice,
+        ITexture* src, MipLevel srcMipLevel, ArraySlice srcArraySlice, ArraySlice numArraySlices,
+        const BlitConstants& constants, bool linearFilter)
+    {
+        const TextureSubresourceSet srcSubresources(srcMipLevel, 1, srcArraySlice, numArraySlices);
+        const TextureSubresourceSet destSubresources(destMipLevel, 1, destArraySlice, numArraySlices);
+
+        auto bindingSetDesc = BindingSetDesc()
+            .addItem(BindingSetItem::PushConstants(0, sizeof(BlitConstants)))
+            .addItem(BindingSetItem::Texture_SRV(0, src, Format::UNKNOWN, srcSubresources, TextureDimension::Texture2DArray))
+            .addItem(BindingSetItem::Texture_UAV(0, dest, Format::UNKNOWN, destSubresources, TextureDimension::Texture2DArray))
+            .addItem(BindingSetItem::Sampler(0, linearFilter ? m_LinearSampler : m_PointSampler));
+
+        BindingSetHandle bindingSet = m_Device->createBindingSet(bindingSetDesc, m_BindingLayout);
+        if (!bindingSet)
+            return;
+
+        // These transitions are required between the mip levels of generateMips, so they are placed
+        // even when automatic barriers are disabled
+        commandList->setTextureState(src, srcSubresources, ResourceStates::ShaderResource);
+        commandList->setTextureState(dest, destSubresources, ResourceStates::UnorderedAccess);
+        commandList->commitBarriers();
+
+        commandList->setComputeState(ComputeState()
+            .setPipeline(m_Pipeline)
+            .addBindingSet(bindingSet));
+
+        commandList->setPushConstants(&constants, sizeof(constants));
+
+        commandList->dispatch(
+            (constants.destSize[0] + c_BlitGroupSize - 1) / c_BlitGroupSize,
+            (constants.destSize[1] + c_BlitGroupSize - 1) / c_BlitGroupSize,
+            numArraySlices);
+    }
+
+    void D3DTextureBlitter::blitTexture(ICommandList* commandList, ITexture* dest, const TextureSlice& destSlice,
+        ITexture* src, const TextureSlice& srcSlice, bool linearFilter)
+    {
+        if (!checkDestination(dest, "blitTexture") || !initialize())
+            return;
+
+        const TextureDesc& srcDesc = src->getDesc();
+        const TextureSlice resolvedDestSlice = destSlice.resolve(dest->getDesc());
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(srcDesc);
+
+        const float srcMipWidth = float(std::max(srcDesc.width >> resolvedSrcSlice.mipLevel, 1u));
+        const float srcMipHeight = float(std::max(srcDesc.height >> resolvedSrcSlice.mipLevel, 1u));
+
+        BlitConstants constants{};
+        constants.sourceOrigin[0] = float(resolvedSrcSlice.x) / srcMipWidth;
+        constants.sourceOrigin[1] = float(resolvedSrcSlice.y) / srcMipHeight;
+        constants.sourceStep[0] = float(resolvedSrcSlice.width) / srcMipWidth / float(resolvedDestSlice.width);
+        constants.sourceStep[1] = float(resolvedSrcSlice.height) / srcMipHeight / float(resolvedDestSlice.height);
+        constants.destOrigin[0] = resolvedDestSlice.x;
+        constants.destOrigin[1] = resolvedDestSlice.y;
+        constants.destSize[0] = resolvedDestSlice.width;
+        constants.destSize[1] = resolvedDestSlice.height;
+
+        dispatch(commandList, dest, resolvedDestSlice.mipLevel, resolvedDestSlice.arraySlice,
+            src, resolvedSrcSlice.mipLevel, resolvedSrcSlice.arraySlice, 1, constants, linearFilter);
+    }
+
+    void D3DTextureBlitter::generateMips(ICommandList* commandList, ITexture* texture, TextureSubresourceSet subresources, bool linearFilter)
+    {
+        const TextureDesc& desc = texture->getDesc();
+        subresources = subresources.resolve(desc, false);
+
+        if (subresources.numMipLevels < 2)
+            return;
+
+        if (!checkDestination(texture, "generateMips") || !initialize())
+            return;
+
+        for (MipLevel mipLevel = subresources.baseMipLevel + 1; mipLevel < subresources.baseMipLevel + subresources.numMipLevels; mipLevel++)
+        {
+            const uint32_t mipWidth = std::max(desc.width >> mipLevel, 1u);
+            const uint32_t mipHeight = std::max(desc.height >> mipLevel, 1u);
+
+            BlitConstants constants{};
+            constants.sourceStep[0] = 1.f / float(mipWidth);
+            constants.sourceStep[1] = 1.f / float(mipHeight);
+            constants.destSize[0] = mipWidth;
+            constants.destSize[1] = mipHeight;
+
+            dispatch(commandList, texture, mipLevel, subresources.baseArraySlice,
+                texture, mipLevel - 1, subresources.baseArraySlice, subresources.numArraySlices, constants, linearFilter);
+        }
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,76 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <mutex>
+
+namespace nvrhi
+{
+    // Implements ICommandList::blitTexture and generateMips for the DX11 and DX12 backends with a compute shader
+    // that samples the source subresource and stores into the destination subresource through a UAV.
+    // The shader is compiled from HLSL on first use, with D3DCompile loaded from d3dcompiler_47.dll that ships
+    // with Windows, so that building the library does not require a shader compiler.
+    // The blits are recorded through the regular command list interface, so they replace the compute state.
+    class D3DTextureBlitter
+    {
+    public:
+        // The device owns the blitter, so only a weak reference is kept
+        explicit D3DTextureBlitter(IDevice* device)
+            : m_Device(device)
+        { }
+
+        void blitTexture(ICommandList* commandList, ITexture* dest, const TextureSlice& destSlice,
+            ITexture* src, const TextureSlice& srcSlice, bool linearFilter);
+
+        void generateMips(ICommandList* commandList, ITexture* texture, TextureSubresourceSet subresources, bool linearFilter);
+
+    private:
+        struct BlitConstants
+        {
+            float sourceOrigin[2]; // in UV units
+            float sourceStep[2]; // UV distance between the destination pixels
+            uint32_t destOrigin[2];
+            uint32_t destSize[2];
+        };
+
+        IDevice* m_Device;
+        std::mutex m_Mutex;
+        bool m_InitializeAttempted = false;
+
+        ShaderHandle m_Shader;
+        BindingLayoutHandle m_BindingLayout;
+        ComputePipelineHandle m_Pipeline;
+        SamplerHandle m_LinearSampler;
+        SamplerHandle m_PointSampler;
+
+        bool initialize();
+        bool checkDestination(ITexture* dest, const char* function);
+        void error(const std::string& message);
+
+        void dispatch(ICommandList* commandList, ITexture* dest, MipLevel destMipLevel, ArraySlice destArraySlice,
+            ITexture* src, MipLevel srcMipLevel, ArraySlice srcArraySlice, ArraySlice numArraySlices,
+            const BlitConstants& constants, bool linearFilter);
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,179 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Maps descriptors to the objects that were created from them, so that creating an object from a descriptor
+    // seen before returns the existing handle. The cache keeps a reference to each object, which makes it a weak
+    // reference in practice: evictUnused() drops the objects that nothing outside of the cache references anymore.
+    template<typename TKey, typename TObject>
+    class DeduplicationCache
+    {
+    public:
+        [[nodiscard]] RefCountPtr<TObject> find(const TKey& key)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto it = m_Entries.find(key);
+            if (it == m_Entries.end())
+                return nullptr;
+
+            return it->second;
+        }
+
+        // Returns the cached object, which is an existing one if another thread inserted the same key first
+        RefCountPtr<TObject> insert(const TKey& key, const RefCountPtr<TObject>& object)
+        {
+            if (!object)
+                return nullptr;
+
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto [it, inserted] = m_Entries.try_emplace(key, object);
+            return it->second;
+        }
+
+        void evictUnused()
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+            {
+                if (it->second->GetRefCount() == 1)
+                    it = m_Entries.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        void clear()
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            m_Entries.clear();
+        }
+
+    private:
+        std::mutex m_Mutex;
+        std::unordered_map<TKey, RefCountPtr<TObject>> m_Entries;
+    };
+
+    struct GraphicsPipelineKey
+    {
+        GraphicsPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+
+        bool operator ==(const GraphicsPipelineKey& other) const
+        {
+            return desc == other.desc && framebufferInfo == other.framebufferInfo;
+        }
+    };
+
+    // Identifies a shader specialization by the unspecialized shader and the constants sorted by constantID
+    struct ShaderSpecializationKey
+    {
+        IResource* baseShader = nullptr; // referenced by the cached specialization
+        std::vector<ShaderSpecialization> constants;
+
+        ShaderSpecializationKey(IResource* _baseShader, const ShaderSpecialization* _constants, uint32_t numConstants)
+            : baseShader(_baseShader)
+            , constants(_constants, _constants + numConstants)
+        {
+            std::stable_sort(constants.begin(), constants.end(), [](const ShaderSpecialization& a, const ShaderSpecialization& b)
+                { return a.constantID < b.constantID; });
+        }
+
+        bool operator ==(const ShaderSpecializationKey& other) const
+        {
+            if (baseShader != other.baseShader || constants.size() != other.constants.size())
+                return false;
+
+            for (size_t i = 0; i < constants.size(); i++)
+            {
+                if (constants[i].constantID != other.constants[i].constantID || constants[i].value.u != other.constants[i].value.u)
+                    return false;
+            }
+
+            return true;
+        }
+    };
+}
+
+namespace std
+{
+    template<> struct hash<nvrhi::GraphicsPipelineKey>
+    {
+        std::size_t operator()(nvrhi::GraphicsPipelineKey const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.desc);
+            nvrhi::hash_combine(hash, s.framebufferInfo);
+            return hash;
+        }
+    };
+
+    template<> struct hash<nvrhi::ShaderSpecializationKey>
+    {
+        std::size_t operator()(nvrhi::ShaderSpecializationKey const& s) const noexcept
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.baseShader);
+            for (const nvrhi::ShaderSpecialization& constant : s.constants)
+            {
+                nvrhi::hash_combine(hash, constant.constantID);
+                nvrhi::hash_combine(hash, constant.value.u);
+            }
+            return hash;
+        }
+    };
+}
+
+namespace nvrhi
+{
+    // The caches behind DeviceDesc::enableObjectDeduplication, owned by the backend devices
+    class ObjectDeduplicationCaches
+    {
+    public:
+        DeduplicationCache<GraphicsPipelineKey, IGraphicsPipeline> graphicsPipelines;
+        DeduplicationCache<ComputePipelineDesc, IComputePipeline> computePipelines;
+        DeduplicationCache<SamplerDesc, ISampler> samplers;
+        DeduplicationCache<ShaderSpecializationKey, IShader> shaderSpecializations;
+
+        void evictUnused()
+        {
+            // Pipelines first, they can hold the last references to specializations
+            graphicsPipelines.evictUnused();
+            computePipelines.evictUnused();
+            samplers.evictUnused();
+            shaderSpecializations.evictUnused();
+        }
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "deferred-destruction.h"
+
+namespace nvrhi
+{
+    void DeferredDestructionQueue::enqueue(void* object, Deleter deleter)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        Entry& entry = m_Released.emplace_back();
+        entry.object = object;
+        entry.deleter = deleter;
+    }
+
+    void DeferredDestructionQueue::retire(const uint64_t* lastSubmittedInstances, const uint64_t* completedInstances)
+    {
+        std::vector<Entry> completed;
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            for (Entry& entry : m_Released)
+            {
+                for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+                    entry.instances[queue] = lastSubmittedInstances[queue];
+
+                m_Pending.push_back(entry);
+            }
+            m_Released.clear();
+
+            auto ready = [completedInstances](const Entry& entry)
+            {
+                for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+                {
+                    if (entry.instances[queue] > completedInstances[queue])
+                        return false;
+                }
+                return true;
+            };
+
+            auto it = m_Pending.begin();
+            while (it != m_Pending.end())
+            {
+                if (ready(*it))
+                {
+                    completed.push_back(*it);
+                    *it = m_Pending.back();
+                    m_Pending.pop_back();
+                }
+                else
+                    ++it;
+            }
+        }
+
+        // Delete outside of the lock: destructors may release other objects with deferred destruction.
+        // Those are tagged and destroyed by a later call.
+        for (const Entry& entry : completed)
+            entry.deleter(entry.object);
+    }
+
+    void DeferredDestructionQueue::destroyAll()
+    {
+        while (true)
+        {
+            std::vector<Entry> entries;
+
+            {
+                std::lock_guard lockGuard(m_Mutex);
+                entries = std::move(m_Pending);
+                entries.insert(entries.end(), m_Released.begin(), m_Released.end());
+                m_Pending.clear();
+                m_Released.clear();
+            }
+
+            if (entries.empty())
+                break;
+
+            for (const Entry& entry : entries)
+                entry.deleter(entry.object);
+        }
+    }
+
+    size_t DeferredDestructionQueue::getNumPendingObjects()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Pending.size() + m_Released.size();
+    }
+
+} // namespace nvrhi
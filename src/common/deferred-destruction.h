@@ -0,0 +1,115 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // Holds the objects whose last reference was released while deferred destruction was enabled for them,
+    // and destroys them from runGarbageCollection once the GPU work submitted before the release has completed.
+    // That keeps the native destruction calls, which can be slow, out of the threads that drop the references.
+    // Released objects are tagged with the last submitted instances of all queues by the first retire() call
+    // after the release: any work that uses the object was submitted before the release, so that is sufficient
+    // and does not require reading the queue state from the releasing thread.
+    class DeferredDestructionQueue
+    {
+    public:
+        typedef void (*Deleter)(void* object);
+
+        DeferredDestructionQueue() = default;
+        DeferredDestructionQueue(const DeferredDestructionQueue&) = delete;
+        DeferredDestructionQueue& operator=(const DeferredDestructionQueue&) = delete;
+        ~DeferredDestructionQueue() { destroyAll(); }
+
+        // Thread-safe, called from Release
+        void enqueue(void* object, Deleter deleter);
+
+        // Tags the objects released since the previous call with lastSubmittedInstances, and destroys the objects
+        // with all tagged instances completed. Both arrays are indexed by CommandQueue.
+        void retire(const uint64_t* lastSubmittedInstances, const uint64_t* completedInstances);
+
+        // Destroys all objects regardless of the GPU progress, for use when the device is idle
+        void destroyAll();
+
+        [[nodiscard]] size_t getNumPendingObjects();
+
+    private:
+        struct Entry
+        {
+            void* object = nullptr;
+            Deleter deleter = nullptr;
+            uint64_t instances[size_t(CommandQueue::Count)] = {};
+        };
+
+        std::mutex m_Mutex;
+        std::vector<Entry> m_Released; // not tagged yet
+        std::vector<Entry> m_Pending;
+    };
+
+    // Replaces RefCounter<T> in the backend objects that support deferred destruction.
+    // The object is deleted when the last reference is released, unless the device has set a destruction queue,
+    // in which case the queue deletes it later.
+    template<class T>
+    class DeferredRefCounter : public T
+    {
+    private:
+        std::atomic<unsigned long> m_refCount = 1;
+        DeferredDestructionQueue* m_DestructionQueue = nullptr;
+
+        static void deleteObject(void* object)
+        {
+            delete static_cast<DeferredRefCounter*>(object);
+        }
+
+    public:
+        virtual unsigned long AddRef() override
+        {
+            return ++m_refCount;
+        }
+
+        virtual unsigned long Release() override
+        {
+            unsigned long result = --m_refCount;
+            if (result == 0)
+            {
+                if (m_DestructionQueue)
+                    m_DestructionQueue->enqueue(this, &deleteObject);
+                else
+                    delete this;
+            }
+            return result;
+        }
+
+        virtual unsigned long GetRefCount() override
+        {
+            return m_refCount.load();
+        }
+
+        void setDestructionQueue(DeferredDestructionQueue* queue) { m_DestructionQueue = queue; }
+    };
+
+} // namespace nvrhi
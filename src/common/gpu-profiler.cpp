@@ -0,0 +1,293 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/gpu-profiler.h>
+#include <nvrhi/common/misc.h>
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+namespace nvrhi
+{
+    class GpuProfiler : public RefCounter<IGpuProfiler>
+    {
+    public:
+        GpuProfiler(IDevice* device, const GpuProfilerDesc& desc, ITimerQueryPool* pool, bool collectPipelineStatistics)
+            : m_Device(device)
+            , m_Desc(desc)
+            , m_Pool(pool)
+            , m_Frames(desc.maxFramesInFlight)
+            , m_CollectPipelineStatistics(collectPipelineStatistics)
+        { }
+
+        uint64_t beginFrame(ICommandList* commandList) override;
+        void beginScope(ICommandList* commandList, const char* name) override;
+        void endScope(ICommandList* commandList) override;
+        void endFrame(ICommandList* commandList) override;
+        bool getFrameScopes(uint64_t frameIndex, std::vector<GpuProfilerScope>& outScopes) override;
+        [[nodiscard]] const GpuProfilerDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] ITimerQueryPool* getTimerQueryPool() const override { return m_Pool; }
+
+    private:
+        struct ScopeRecord
+        {
+            std::string name;
+            uint32_t parent = c_InvalidGpuProfilerScope;
+            uint32_t depth = 0;
+            double cpuRecordTime = 0.0;
+            uint32_t statisticsQuery = c_InvalidGpuProfilerScope; // index in Frame::statisticsQueries
+        };
+
+        struct Frame
+        {
+            uint64_t frameIndex = 0;
+            std::vector<ScopeRecord> scopes; // indexed by the timer query index
+
+            // Kept across the frames that use this slot, the first numStatisticsQueries are used by the current one
+            std::vector<PipelineStatisticsQueryHandle> statisticsQueries;
+            uint32_t numStatisticsQueries = 0;
+        };
+
+        IDevice* m_Device;
+        GpuProfilerDesc m_Desc;
+        TimerQueryPoolHandle m_Pool;
+
+        std::vector<Frame> m_Frames;
+        uint64_t m_CurrentFrameIndex = 0;
+
+        // Open scopes of every command list that recorded scopes in the current frame.
+        // Scopes that were not timed because the frame ran out of queries are c_InvalidGpuProfilerScope.
+        std::unordered_map<ICommandList*, std::vector<uint32_t>> m_ScopeStacks;
+
+        bool m_CollectPipelineStatistics = false;
+        // Set when the device runs out of pipeline statistics queries, the frames only reuse the ones they have then
+        bool m_StatisticsQueriesExhausted = false;
+
+        std::mutex m_Mutex;
+
+        Frame& getFrame(uint64_t frameIndex) { return m_Frames[(frameIndex - 1) % m_Frames.size()]; }
+    };
+
+    static double getCpuTimeInSeconds()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t GpuProfiler::beginFrame(ICommandList* commandList)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        commandList->beginTimerQueryFrame(m_Pool);
+        m_CurrentFrameIndex = m_Pool->getCurrentFrameIndex();
+
+        Frame& frame = getFrame(m_CurrentFrameIndex);
+        frame.frameIndex = m_CurrentFrameIndex;
+        frame.scopes.clear();
+        frame.numStatisticsQueries = 0;
+
+        m_ScopeStacks.clear();
+
+        return m_CurrentFrameIndex;
+    }
+
+    void GpuProfiler::beginScope(ICommandList* commandList, const char* name)
+    {
+        if (m_Desc.emitMarkers)
+            commandList->beginMarker(name);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_CurrentFrameIndex == 0)
+            return;
+
+        Frame& frame = getFrame(m_CurrentFrameIndex);
+        std::vector<uint32_t>& stack = m_ScopeStacks[commandList];
+
+        if (frame.scopes.size() >= m_Desc.maxScopesPerFrame)
+        {
+            stack.push_back(c_InvalidGpuProfilerScope);
+            return;
+        }
+
+        // the parent is the innermost timed scope, skipping the ones that ran out of queries
+        uint32_t parent = c_InvalidGpuProfilerScope;
+        uint32_t depth = 0;
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+        {
+            if (*it != c_InvalidGpuProfilerScope)
+            {
+                parent = *it;
+                depth = frame.scopes[parent].depth + 1;
+                break;
+            }
+        }
+
+        // Only the outermost scopes get statistics, one pipeline statistics query can be active at a time
+        IPipelineStatisticsQuery* statisticsQuery = nullptr;
+        if (m_CollectPipelineStatistics && stack.empty())
+        {
+            if (frame.numStatisticsQueries < frame.statisticsQueries.size())
+            {
+                // The frame that used the query before has finished, like the timer queries of this frame slot
+                statisticsQuery = frame.statisticsQueries[frame.numStatisticsQueries];
+                m_Device->resetPipelineStatisticsQuery(statisticsQuery);
+            }
+            else if (!m_StatisticsQueriesExhausted)
+            {
+                PipelineStatisticsQueryHandle query = m_Device->createPipelineStatisticsQuery();
+                if (query)
+                {
+                    statisticsQuery = query;
+                    frame.statisticsQueries.push_back(query);
+                }
+                else
+                    m_StatisticsQueriesExhausted = true;
+            }
+        }
+
+        const uint32_t scopeIndex = uint32_t(frame.scopes.size());
+
+        ScopeRecord& scope = frame.scopes.emplace_back();
+        scope.name = name ? name : "";
+        scope.parent = parent;
+        scope.depth = depth;
+        scope.cpuRecordTime = getCpuTimeInSeconds();
+
+        stack.push_back(scopeIndex);
+
+        commandList->beginTimerQuery(m_Pool, scopeIndex);
+
+        if (statisticsQuery)
+        {
+            scope.statisticsQuery = frame.numStatisticsQueries++;
+            commandList->beginPipelineStatisticsQuery(statisticsQuery);
+        }
+    }
+
+    void GpuProfiler::endScope(ICommandList* commandList)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto stack = m_ScopeStacks.find(commandList);
+            if (stack != m_ScopeStacks.end() && !stack->second.empty())
+            {
+                const uint32_t scopeIndex = stack->second.back();
+                stack->second.pop_back();
+
+                if (scopeIndex != c_InvalidGpuProfilerScope)
+                {
+                    Frame& frame = getFrame(m_CurrentFrameIndex);
+                    const uint32_t statisticsQuery = frame.scopes[scopeIndex].statisticsQuery;
+                    if (statisticsQuery != c_InvalidGpuProfilerScope)
+                        commandList->endPipelineStatisticsQuery(frame.statisticsQueries[statisticsQuery]);
+
+                    commandList->endTimerQuery(m_Pool, scopeIndex);
+                }
+            }
+        }
+
+        if (m_Desc.emitMarkers)
+            commandList->endMarker();
+    }
+
+    void GpuProfiler::endFrame(ICommandList* commandList)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_CurrentFrameIndex == 0)
+            return;
+
+        commandList->resolveTimerQueries(m_Pool);
+
+        m_ScopeStacks.clear();
+    }
+
+    bool GpuProfiler::getFrameScopes(uint64_t frameIndex, std::vector<GpuProfilerScope>& outScopes)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (frameIndex == 0)
+            return false;
+
+        const Frame& frame = getFrame(frameIndex);
+        if (frame.frameIndex != frameIndex)
+            return false;
+
+        const uint32_t numScopes = uint32_t(frame.scopes.size());
+
+        std::vector<double> timestamps(numScopes * 2);
+        if (!m_Device->getTimerQueryPoolTimestamps(m_Pool, frameIndex, timestamps.data(), numScopes))
+            return false;
+
+        outScopes.resize(numScopes);
+        for (uint32_t index = 0; index < numScopes; index++)
+        {
+            const ScopeRecord& record = frame.scopes[index];
+            GpuProfilerScope& scope = outScopes[index];
+
+            scope.name = record.name;
+            scope.queue = m_Desc.queue;
+            scope.parent = record.parent;
+            scope.depth = record.depth;
+            scope.gpuStart = timestamps[index * 2];
+            scope.gpuEnd = timestamps[index * 2 + 1];
+            scope.cpuRecordTime = record.cpuRecordTime;
+
+            // The frame has finished, so the statistics are normally available as well, but don't wait for them
+            scope.hasPipelineStatistics = false;
+            scope.pipelineStatistics = PipelineStatistics();
+            if (record.statisticsQuery != c_InvalidGpuProfilerScope)
+            {
+                IPipelineStatisticsQuery* query = frame.statisticsQueries[record.statisticsQuery];
+                if (m_Device->pollPipelineStatisticsQuery(query))
+                {
+                    scope.hasPipelineStatistics = true;
+                    scope.pipelineStatistics = m_Device->getPipelineStatisticsQueryResult(query);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    GpuProfilerHandle createGpuProfiler(IDevice* device, const GpuProfilerDesc& desc)
+    {
+        TimerQueryPoolDesc poolDesc;
+        poolDesc.maxQueriesPerFrame = desc.maxScopesPerFrame;
+        poolDesc.maxFramesInFlight = desc.maxFramesInFlight;
+        poolDesc.queue = desc.queue;
+        poolDesc.debugName = desc.debugName;
+
+        TimerQueryPoolHandle pool = device->createTimerQueryPool(poolDesc);
+        if (!pool)
+            return nullptr;
+
+        // The pipeline statistics queries are only available on the graphics queue of all backends
+        const bool collectPipelineStatistics = desc.collectPipelineStatistics && desc.queue == CommandQueue::Graphics
+            && device->queryFeatureSupport(Feature::PipelineStatisticsQueries);
+
+        return GpuProfilerHandle::Create(new GpuProfiler(device, desc, pool, collectPipelineStatistics));
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi
+{
+    enum class GraphicsStateDirtyFlags : uint8_t
+    {
+        None            = 0x00,
+        Bindings        = 0x01,
+        VertexBuffers   = 0x02,
+        IndexBuffer     = 0x04,
+        Viewport        = 0x08
+    };
+
+    // NVRHI_ENUM_CLASS_FLAG_OPERATORS is undefined at the end of nvrhi.h
+    inline GraphicsStateDirtyFlags operator | (GraphicsStateDirtyFlags a, GraphicsStateDirtyFlags b) { return GraphicsStateDirtyFlags(uint32_t(a) | uint32_t(b)); }
+    inline GraphicsStateDirtyFlags operator & (GraphicsStateDirtyFlags a, GraphicsStateDirtyFlags b) { return GraphicsStateDirtyFlags(uint32_t(a) & uint32_t(b)); }
+    inline GraphicsStateDirtyFlags operator ~ (GraphicsStateDirtyFlags a) { return GraphicsStateDirtyFlags(~uint32_t(a)); }
+
+    // Collects the changes made with the incremental graphics state setters of ICommandList
+    // (setGraphicsBindingSet, setVertexBuffers, ...) until the next draw applies them.
+    // Each setter copies the affected part of the current state on first use and only compares that part,
+    // so a draw after a few small changes doesn't have to diff or copy the whole GraphicsState.
+    // The backends pass their current values in and apply the parts marked in 'dirty' at draw time.
+    struct PendingGraphicsState
+    {
+        GraphicsStateDirtyFlags dirty = GraphicsStateDirtyFlags::None;
+        uint32_t bindingUpdateMask = 0;
+
+        BindingSetVector bindings;
+        static_vector<VertexBufferBinding, c_MaxVertexAttributes> vertexBuffers;
+        IndexBufferBinding indexBuffer;
+        ViewportState viewport;
+
+        [[nodiscard]] bool any() const { return dirty != GraphicsStateDirtyFlags::None; }
+        [[nodiscard]] bool isDirty(GraphicsStateDirtyFlags flag) const { return (dirty & flag) != GraphicsStateDirtyFlags::None; }
+
+        void reset()
+        {
+            dirty = GraphicsStateDirtyFlags::None;
+            bindingUpdateMask = 0;
+        }
+
+        template<typename T>
+        void setBindingSet(const T& currentBindings, uint32_t slot, IBindingSet* bindingSet)
+        {
+            assert(slot < c_MaxBindingLayouts);
+
+            if (!isDirty(GraphicsStateDirtyFlags::Bindings))
+            {
+                bindings.resize(currentBindings.size());
+                for (size_t i = 0; i < currentBindings.size(); i++)
+                    bindings[i] = currentBindings[i];
+            }
+
+            if (slot >= bindings.size())
+            {
+                const size_t oldSize = bindings.size();
+                bindings.resize(slot + 1);
+                for (size_t i = oldSize; i < bindings.size(); i++)
+                    bindings[i] = nullptr;
+            }
+
+            bindings[slot] = bindingSet;
+
+            const bool changed = slot >= currentBindings.size() || currentBindings[slot] != bindingSet;
+            if (changed)
+                bindingUpdateMask |= 1u << slot;
+            else
+                bindingUpdateMask &= ~(1u << slot);
+
+            // A larger array than the current one always counts as a change, even if the new entries are null
+            if (bindingUpdateMask != 0 || bindings.size() != currentBindings.size())
+                dirty = dirty | GraphicsStateDirtyFlags::Bindings;
+            else
+                dirty = dirty & ~GraphicsStateDirtyFlags::Bindings;
+        }
+
+        template<typename T>
+        void setVertexBuffers(const T& currentVertexBuffers, const VertexBufferBinding* newVertexBuffers, size_t count)
+        {
+            assert(count <= c_MaxVertexAttributes);
+
+            vertexBuffers.resize(count);
+            for (size_t i = 0; i < count; i++)
+                vertexBuffers[i] = newVertexBuffers[i];
+
+            if (arraysAreDifferent(vertexBuffers, currentVertexBuffers))
+                dirty = dirty | GraphicsStateDirtyFlags::VertexBuffers;
+            else
+                dirty = dirty & ~GraphicsStateDirtyFlags::VertexBuffers;
+        }
+
+        void setIndexBuffer(const IndexBufferBinding& currentIndexBuffer, const IndexBufferBinding& newIndexBuffer)
+        {
+            indexBuffer = newIndexBuffer;
+
+            if (indexBuffer != currentIndexBuffer)
+                dirty = dirty | GraphicsStateDirtyFlags::IndexBuffer;
+            else
+                dirty = dirty & ~GraphicsStateDirtyFlags::IndexBuffer;
+        }
+
+        void setViewport(const ViewportState& currentViewport, const ViewportState& newViewport)
+        {
+            viewport = newViewport;
+
+            if (arraysAreDifferent(viewport.viewports, currentViewport.viewports) ||
+                arraysAreDifferent(viewport.scissorRects, currentViewport.scissorRects))
+                dirty = dirty | GraphicsStateDirtyFlags::Viewport;
+            else
+                dirty = dirty & ~GraphicsStateDirtyFlags::Viewport;
+        }
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "memory-statistics.h"
+
+namespace nvrhi
+{
+    void MemoryStatisticsTracker::allocated(MemoryCategory category, uint64_t bytes, const char* debugName)
+    {
+        Counters& counters = m_Categories[size_t(category)];
+
+        const uint64_t allocatedBytes = counters.allocatedBytes.fetch_add(bytes) + bytes;
+        counters.allocationCount.fetch_add(1);
+
+        uint64_t peak = counters.peakAllocatedBytes.load();
+        while (peak < allocatedBytes && !counters.peakAllocatedBytes.compare_exchange_weak(peak, allocatedBytes))
+            ;
+
+        if (m_Callback)
+            m_Callback->memoryAllocated(category, bytes, debugName);
+    }
+
+    void MemoryStatisticsTracker::released(MemoryCategory category, uint64_t bytes)
+    {
+        Counters& counters = m_Categories[size_t(category)];
+
+        counters.allocatedBytes.fetch_sub(bytes);
+        counters.allocationCount.fetch_sub(1);
+
+        if (m_Callback)
+            m_Callback->memoryReleased(category, bytes);
+    }
+
+    MemoryStatistics MemoryStatisticsTracker::getStatistics() const
+    {
+        MemoryStatistics statistics;
+
+        for (size_t index = 0; index < size_t(MemoryCategory::Count); ++index)
+        {
+            const Counters& counters = m_Categories[index];
+            MemoryCategoryStatistics& result = statistics.categories[index];
+
+            result.allocatedBytes = counters.allocatedBytes.load();
+            result.peakAllocatedBytes = counters.peakAllocatedBytes.load();
+            result.allocationCount = counters.allocationCount.load();
+        }
+
+        for (MemoryCategory category : { MemoryCategory::Buffers, MemoryCategory::Textures })
+            statistics.get(category).usedBytes = statistics.get(category).allocatedBytes;
+
+        return statistics;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <atomic>
+
+namespace nvrhi
+{
+    // Counts the memory allocated by a device per category, and forwards the allocations to the application's
+    // IMemoryAllocationCallback. The counters are atomic so that resources can be created and released
+    // on any thread without locking.
+    class MemoryStatisticsTracker
+    {
+    public:
+        explicit MemoryStatisticsTracker(IMemoryAllocationCallback* callback)
+            : m_Callback(callback)
+        { }
+
+        void allocated(MemoryCategory category, uint64_t bytes, const char* debugName = nullptr);
+        void released(MemoryCategory category, uint64_t bytes);
+
+        // Returns the counters, with the used bytes of buffers and textures equal to the allocated bytes.
+        // The backends fill in the used bytes of the other categories.
+        [[nodiscard]] MemoryStatistics getStatistics() const;
+
+    private:
+        struct Counters
+        {
+            std::atomic<uint64_t> allocatedBytes = 0;
+            std::atomic<uint64_t> peakAllocatedBytes = 0;
+            std::atomic<uint32_t> allocationCount = 0;
+        };
+
+        Counters m_Categories[size_t(MemoryCategory::Count)];
+        IMemoryAllocationCallback* m_Callback;
+    };
+}
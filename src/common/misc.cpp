@@ -161,6 +161,8 @@ namespace nvrhi
             sampleCount = textureDesc.sampleCount;
             sampleQuality = textureDesc.sampleQuality;
         }
+
+        hasShadingRateAttachment = desc.shadingRateAttachment.valid();
     }
 
     FramebufferInfoEx::FramebufferInfoEx(const FramebufferDesc& desc)
@@ -0,0 +1,226 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "pipeline-compiler.h"
+
+#include <algorithm>
+
+namespace nvrhi
+{
+    PipelineCompiler::PipelineCompiler(uint32_t threadCount)
+        : m_ThreadCount(threadCount)
+    {
+        if (m_ThreadCount == 0)
+            m_ThreadCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+
+    PipelineCompiler::~PipelineCompiler()
+    {
+        shutdown();
+    }
+
+    void PipelineCompiler::shutdown()
+    {
+        std::deque<Job> cancelledJobs;
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Stopping = true;
+            cancelledJobs.swap(m_Jobs);
+        }
+        m_JobCondition.notify_all();
+
+        for (Job& job : cancelledJobs)
+            job(true);
+
+        for (std::thread& thread : m_Threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+        m_Threads.clear();
+    }
+
+    void PipelineCompiler::enqueue(Job job, bool urgent)
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+
+            if (!m_Stopping)
+            {
+                // Start the threads lazily so that devices which never compile asynchronously don't pay for them
+                if (m_Threads.empty())
+                {
+                    for (uint32_t i = 0; i < m_ThreadCount; i++)
+                        m_Threads.emplace_back(&PipelineCompiler::workerThread, this);
+                }
+
+                if (urgent)
+                    m_Jobs.push_front(std::move(job));
+                else
+                    m_Jobs.push_back(std::move(job));
+
+                job = nullptr;
+            }
+        }
+
+        if (job)
+        {
+            job(true);
+            return;
+        }
+
+        m_JobCondition.notify_one();
+    }
+
+    void PipelineCompiler::workerThread()
+    {
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock lock(m_Mutex);
+                m_JobCondition.wait(lock, [this] { return m_Stopping || !m_Jobs.empty(); });
+
+                if (m_Jobs.empty())
+                    return;
+
+                job = std::move(m_Jobs.front());
+                m_Jobs.pop_front();
+            }
+
+            job(false);
+        }
+    }
+
+    void PipelineCompiler::runParallel(uint32_t maxConcurrency, const std::function<void()>& work)
+    {
+        struct Batch
+        {
+            std::mutex mutex;
+            std::condition_variable condition;
+            uint32_t running = 0;
+            bool closed = false;
+        };
+
+        auto batch = std::make_shared<Batch>();
+
+        const uint32_t numHelpers = std::min(std::max(maxConcurrency, 1u) - 1, m_ThreadCount);
+        for (uint32_t i = 0; i < numHelpers; i++)
+        {
+            // Helpers that get to run after the caller has finished do nothing, so 'work' is never called then
+            enqueue([batch, &work](bool cancelled)
+            {
+                {
+                    std::lock_guard lock(batch->mutex);
+                    if (cancelled || batch->closed)
+                        return;
+                    ++batch->running;
+                }
+
+                work();
+
+                {
+                    std::lock_guard lock(batch->mutex);
+                    --batch->running;
+                }
+                batch->condition.notify_all();
+            }, true);
+        }
+
+        work();
+
+        std::unique_lock lock(batch->mutex);
+        batch->closed = true;
+        batch->condition.wait(lock, [&batch] { return batch->running == 0; });
+    }
+
+    void PipelineCompiler::enqueueBackgroundJob(std::function<void()> work)
+    {
+        enqueue([work = std::move(work)](bool cancelled)
+        {
+            if (!cancelled)
+                work();
+        }, false);
+    }
+
+    AsyncGraphicsPipelineHandle PipelineCompiler::createGraphicsPipeline(IDevice* device, const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo, IGraphicsPipeline* fallback)
+    {
+        RefCountPtr<AsyncPipeline<IGraphicsPipeline>> result = RefCountPtr<AsyncPipeline<IGraphicsPipeline>>::Create(new AsyncPipeline<IGraphicsPipeline>(fallback));
+
+        enqueue([device, desc, fbinfo, result](bool cancelled)
+        {
+            if (!cancelled)
+                result->complete(device->createGraphicsPipeline(desc, fbinfo));
+            else
+                result->complete(nullptr);
+        }, false);
+
+        return result;
+    }
+
+    AsyncComputePipelineHandle PipelineCompiler::createComputePipeline(IDevice* device, const ComputePipelineDesc& desc, IComputePipeline* fallback)
+    {
+        RefCountPtr<AsyncPipeline<IComputePipeline>> result = RefCountPtr<AsyncPipeline<IComputePipeline>>::Create(new AsyncPipeline<IComputePipeline>(fallback));
+
+        enqueue([device, desc, result](bool cancelled)
+        {
+            if (!cancelled)
+                result->complete(device->createComputePipeline(desc));
+            else
+                result->complete(nullptr);
+        }, false);
+
+        return result;
+    }
+
+    AsyncMeshletPipelineHandle PipelineCompiler::createMeshletPipeline(IDevice* device, const MeshletPipelineDesc& desc, const FramebufferInfo& fbinfo, IMeshletPipeline* fallback)
+    {
+        RefCountPtr<AsyncPipeline<IMeshletPipeline>> result = RefCountPtr<AsyncPipeline<IMeshletPipeline>>::Create(new AsyncPipeline<IMeshletPipeline>(fallback));
+
+        enqueue([device, desc, fbinfo, result](bool cancelled)
+        {
+            if (!cancelled)
+                result->complete(device->createMeshletPipeline(desc, fbinfo));
+            else
+                result->complete(nullptr);
+        }, false);
+
+        return result;
+    }
+
+    rt::AsyncPipelineHandle PipelineCompiler::createRayTracingPipeline(IDevice* device, const rt::PipelineDesc& desc, rt::IPipeline* fallback)
+    {
+        RefCountPtr<AsyncPipeline<rt::IPipeline>> result = RefCountPtr<AsyncPipeline<rt::IPipeline>>::Create(new AsyncPipeline<rt::IPipeline>(fallback));
+
+        enqueue([device, desc, result](bool cancelled)
+        {
+            if (!cancelled)
+                result->complete(device->createRayTracingPipeline(desc));
+            else
+                result->complete(nullptr);
+        }, false);
+
+        return result;
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,121 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/resource.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nvrhi
+{
+    template<typename TPipeline>
+    class AsyncPipeline final : public RefCounter<IAsyncPipeline<TPipeline>>
+    {
+    public:
+        explicit AsyncPipeline(TPipeline* fallback)
+            : m_Fallback(fallback)
+        { }
+
+        bool isReady() override { return m_Ready.load(std::memory_order_acquire); }
+
+        TPipeline* wait() override
+        {
+            std::unique_lock lock(m_Mutex);
+            m_ReadyCondition.wait(lock, [this] { return m_Ready.load(std::memory_order_relaxed); });
+            return m_Pipeline;
+        }
+
+        TPipeline* getPipeline() override
+        {
+            if (isReady() && m_Pipeline)
+                return m_Pipeline;
+            return m_Fallback;
+        }
+
+        void complete(RefCountPtr<TPipeline> pipeline)
+        {
+            {
+                std::lock_guard lock(m_Mutex);
+                m_Pipeline = std::move(pipeline);
+                m_Ready.store(true, std::memory_order_release);
+            }
+            m_ReadyCondition.notify_all();
+        }
+
+    private:
+        RefCountPtr<TPipeline> m_Pipeline;
+        RefCountPtr<TPipeline> m_Fallback;
+        std::atomic<bool> m_Ready = false;
+        std::mutex m_Mutex;
+        std::condition_variable m_ReadyCondition;
+    };
+
+    // Worker thread pool behind the create*PipelineAsync methods, owned by each backend device.
+    // The threads are started by the first job. Call shutdown() before the device starts to tear down:
+    // it cancels the jobs that have not started and waits for the running ones.
+    class PipelineCompiler
+    {
+    public:
+        // threadCount = 0 picks half of the hardware threads
+        explicit PipelineCompiler(uint32_t threadCount);
+        ~PipelineCompiler();
+
+        void shutdown();
+
+        AsyncGraphicsPipelineHandle createGraphicsPipeline(IDevice* device, const GraphicsPipelineDesc& desc, const FramebufferInfo& fbinfo, IGraphicsPipeline* fallback);
+        AsyncComputePipelineHandle createComputePipeline(IDevice* device, const ComputePipelineDesc& desc, IComputePipeline* fallback);
+        AsyncMeshletPipelineHandle createMeshletPipeline(IDevice* device, const MeshletPipelineDesc& desc, const FramebufferInfo& fbinfo, IMeshletPipeline* fallback);
+        rt::AsyncPipelineHandle createRayTracingPipeline(IDevice* device, const rt::PipelineDesc& desc, rt::IPipeline* fallback);
+
+        // Runs 'work' on the calling thread and on up to (maxConcurrency - 1) worker threads that become free
+        // before it returns, then waits for all invocations to return. Busy workers don't delay the caller,
+        // so this is safe to call from a pipeline job. Used to join driver-side deferred operations.
+        void runParallel(uint32_t maxConcurrency, const std::function<void()>& work);
+
+        // Queues a job behind the pending pipelines that is dropped without running if shutdown() comes first.
+        // Used for work that improves an existing object, such as building link-time optimized pipelines.
+        void enqueueBackgroundJob(std::function<void()> work);
+
+    private:
+        // The argument is true when the job is cancelled by shutdown() and must only complete its result
+        typedef std::function<void(bool cancelled)> Job;
+
+        uint32_t m_ThreadCount;
+        std::vector<std::thread> m_Threads;
+        std::deque<Job> m_Jobs;
+        std::mutex m_Mutex;
+        std::condition_variable m_JobCondition;
+        bool m_Stopping = false;
+
+        void enqueue(Job job, bool urgent);
+        void workerThread();
+    };
+
+} // namespace nvrhi
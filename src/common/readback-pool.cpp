@@ -0,0 +1,334 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/readback-pool.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi
+{
+    namespace
+    {
+        // The readbacks recorded between two update calls share one event query
+        struct ReadbackBatch
+        {
+            EventQueryHandle query;
+        };
+
+        struct StagingTextureKey
+        {
+            Format format = Format::UNKNOWN;
+            TextureDimension dimension = TextureDimension::Unknown;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t depth = 0;
+
+            bool operator==(const StagingTextureKey& other) const
+            {
+                return format == other.format
+                    && dimension == other.dimension
+                    && width == other.width
+                    && height == other.height
+                    && depth == other.depth;
+            }
+        };
+
+        struct FreeStagingTexture
+        {
+            StagingTextureKey key;
+            StagingTextureHandle texture;
+            uint64_t lastUsedUpdate = 0;
+        };
+    }
+
+    class ReadbackPool : public RefCounter<IReadbackPool>
+    {
+    public:
+        ReadbackPool(IDevice* device, const ReadbackPoolDesc& desc)
+            : m_Device(device)
+            , m_Desc(desc)
+        { }
+
+        TextureReadbackHandle readbackTextureAsync(ICommandList* commandList, ITexture* source, const TextureSlice& slice) override;
+        void update(CommandQueue queue) override;
+        void trim() override;
+        [[nodiscard]] const ReadbackPoolDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] size_t getNumFreeTextures() override;
+
+        void releaseStagingTexture(const StagingTextureKey& key, IStagingTexture* texture);
+
+        IDevice* getDevice() const { return m_Device; }
+
+    private:
+        DeviceHandle m_Device;
+        ReadbackPoolDesc m_Desc;
+
+        std::mutex m_Mutex;
+        std::vector<FreeStagingTexture> m_FreeTextures;
+        std::shared_ptr<ReadbackBatch> m_PendingBatch;
+        uint64_t m_UpdateIndex = 0;
+
+        void error(const std::string& message) const
+        {
+            std::stringstream ss;
+            ss << "Readback pool " << utils::DebugNameToString(m_Desc.debugName) << ": " << message;
+            m_Device->getMessageCallback()->message(MessageSeverity::Error, ss.str().c_str());
+        }
+
+        StagingTextureHandle acquireStagingTexture(const StagingTextureKey& key);
+    };
+
+    class TextureReadback : public RefCounter<ITextureReadback>
+    {
+    public:
+        TextureReadback(ReadbackPool* pool, const StagingTextureKey& key, IStagingTexture* texture,
+            const TextureSlice& sourceSlice, std::shared_ptr<ReadbackBatch> batch)
+            : m_Pool(pool)
+            , m_Key(key)
+            , m_Texture(texture)
+            , m_SourceSlice(sourceSlice)
+            , m_Batch(std::move(batch))
+        { }
+
+        ~TextureReadback() override
+        {
+            if (m_Mapped)
+                unmap();
+
+            m_Pool->releaseStagingTexture(m_Key, m_Texture);
+        }
+
+        [[nodiscard]] bool isReady() override
+        {
+            if (m_Ready)
+                return true;
+
+            if (!m_Batch->query)
+                return false;
+
+            m_Ready = m_Pool->getDevice()->pollEventQuery(m_Batch->query);
+            return m_Ready;
+        }
+
+        bool wait() override
+        {
+            if (!m_Batch->query)
+                return false;
+
+            m_Pool->getDevice()->waitEventQuery(m_Batch->query);
+            m_Ready = true;
+            return true;
+        }
+
+        const void* map(size_t* outRowPitch) override
+        {
+            if (!isReady())
+                return nullptr;
+
+            void* data = m_Pool->getDevice()->mapStagingTexture(m_Texture, TextureSlice(), CpuAccessMode::Read, outRowPitch);
+            m_Mapped = data != nullptr;
+            return data;
+        }
+
+        void unmap() override
+        {
+            if (!m_Mapped)
+                return;
+
+            m_Pool->getDevice()->unmapStagingTexture(m_Texture);
+            m_Mapped = false;
+        }
+
+        [[nodiscard]] IEventQuery* getEventQuery() override { return m_Batch->query; }
+        [[nodiscard]] IStagingTexture* getStagingTexture() override { return m_Texture; }
+        [[nodiscard]] const TextureSlice& getSourceSlice() const override { return m_SourceSlice; }
+
+    private:
+        RefCountPtr<ReadbackPool> m_Pool;
+        StagingTextureKey m_Key;
+        StagingTextureHandle m_Texture;
+        TextureSlice m_SourceSlice;
+        std::shared_ptr<ReadbackBatch> m_Batch;
+        bool m_Ready = false;
+        bool m_Mapped = false;
+    };
+
+    StagingTextureHandle ReadbackPool::acquireStagingTexture(const StagingTextureKey& key)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            // Prefer the most recently released texture, the older ones are trimmed first
+            auto it = std::find_if(m_FreeTextures.rbegin(), m_FreeTextures.rend(),
+                [&key](const FreeStagingTexture& entry) { return entry.key == key; });
+
+            if (it != m_FreeTextures.rend())
+            {
+                StagingTextureHandle texture = it->texture;
+                m_FreeTextures.erase(std::next(it).base());
+                return texture;
+            }
+        }
+
+        TextureDesc desc;
+        desc.dimension = key.dimension;
+        desc.format = key.format;
+        desc.width = key.width;
+        desc.height = key.height;
+        desc.depth = key.depth;
+        desc.debugName = m_Desc.debugName;
+
+        return m_Device->createStagingTexture(desc, CpuAccessMode::Read);
+    }
+
+    TextureReadbackHandle ReadbackPool::readbackTextureAsync(ICommandList* commandList, ITexture* source, const TextureSlice& slice)
+    {
+        if (!commandList || !source)
+        {
+            error("readbackTextureAsync called with a null command list or source texture");
+            return nullptr;
+        }
+
+        const TextureDesc& sourceDesc = source->getDesc();
+
+        if (sourceDesc.sampleCount > 1)
+        {
+            std::stringstream ss;
+            ss << "cannot read back multisampled texture " << utils::DebugNameToString(sourceDesc.debugName);
+            error(ss.str());
+            return nullptr;
+        }
+
+        const TextureSlice resolvedSlice = slice.resolve(sourceDesc);
+
+        StagingTextureKey key;
+        key.format = sourceDesc.format;
+        key.width = resolvedSlice.width;
+        key.height = resolvedSlice.height;
+        key.depth = 1;
+
+        switch (sourceDesc.dimension)
+        {
+        case TextureDimension::Texture1D:
+        case TextureDimension::Texture1DArray:
+            key.dimension = TextureDimension::Texture1D;
+            break;
+        case TextureDimension::Texture3D:
+            key.dimension = TextureDimension::Texture3D;
+            key.depth = resolvedSlice.depth;
+            break;
+        default:
+            key.dimension = TextureDimension::Texture2D;
+            break;
+        }
+
+        StagingTextureHandle texture = acquireStagingTexture(key);
+        if (!texture)
+            return nullptr;
+
+        commandList->copyTexture(texture, TextureSlice(), source, resolvedSlice);
+
+        std::shared_ptr<ReadbackBatch> batch;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (!m_PendingBatch)
+                m_PendingBatch = std::make_shared<ReadbackBatch>();
+
+            batch = m_PendingBatch;
+        }
+
+        return TextureReadbackHandle::Create(new TextureReadback(this, key, texture, resolvedSlice, std::move(batch)));
+    }
+
+    void ReadbackPool::update(CommandQueue queue)
+    {
+        std::shared_ptr<ReadbackBatch> batch;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            batch = std::move(m_PendingBatch);
+            ++m_UpdateIndex;
+
+            if (m_Desc.maxIdleUpdates != 0)
+            {
+                const uint64_t updateIndex = m_UpdateIndex;
+                const uint64_t maxIdleUpdates = m_Desc.maxIdleUpdates;
+
+                m_FreeTextures.erase(std::remove_if(m_FreeTextures.begin(), m_FreeTextures.end(),
+                    [updateIndex, maxIdleUpdates](const FreeStagingTexture& entry)
+                    {
+                        return updateIndex - entry.lastUsedUpdate > maxIdleUpdates;
+                    }), m_FreeTextures.end());
+            }
+        }
+
+        if (!batch)
+            return;
+
+        // The query is set before it becomes visible to the readbacks of the batch,
+        // which only read it after update has returned on the submitting thread
+        batch->query = m_Device->createEventQuery();
+        m_Device->setEventQuery(batch->query, queue);
+    }
+
+    void ReadbackPool::trim()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_FreeTextures.clear();
+    }
+
+    size_t ReadbackPool::getNumFreeTextures()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_FreeTextures.size();
+    }
+
+    void ReadbackPool::releaseStagingTexture(const StagingTextureKey& key, IStagingTexture* texture)
+    {
+        if (m_Desc.maxFreeTextures == 0)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_FreeTextures.size() >= m_Desc.maxFreeTextures)
+            m_FreeTextures.erase(m_FreeTextures.begin());
+
+        FreeStagingTexture& entry = m_FreeTextures.emplace_back();
+        entry.key = key;
+        entry.texture = texture;
+        entry.lastUsedUpdate = m_UpdateIndex;
+    }
+
+    ReadbackPoolHandle createReadbackPool(IDevice* device, const ReadbackPoolDesc& desc)
+    {
+        return ReadbackPoolHandle::Create(new ReadbackPool(device, desc));
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,206 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "residency.h"
+
+#include <algorithm>
+
+namespace nvrhi
+{
+    void ResidencyTracker::addAllocation(uint64_t allocation, uint64_t size)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        Allocation& entry = m_Allocations[allocation];
+        entry.size = size;
+        entry.lastUseSerial = m_Serial;
+    }
+
+    void ResidencyTracker::removeAllocation(uint64_t allocation)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Allocations.erase(allocation);
+    }
+
+    void ResidencyTracker::addAlias(uint64_t alias, uint64_t allocation)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Aliases[alias] = allocation;
+    }
+
+    void ResidencyTracker::removeAlias(uint64_t alias)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Aliases.erase(alias);
+    }
+
+    bool ResidencyTracker::setPriority(uint64_t allocation, ResidencyPriority priority)
+    {
+        if (!m_Enabled)
+            return false;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto it = m_Allocations.find(allocation);
+        if (it == m_Allocations.end())
+            return false;
+
+        it->second.priority = priority;
+        return true;
+    }
+
+    ResidencyPriority ResidencyTracker::getPriority(uint64_t allocation)
+    {
+        if (!m_Enabled)
+            return ResidencyPriority::Normal;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto it = m_Allocations.find(allocation);
+        return it != m_Allocations.end() ? it->second.priority : ResidencyPriority::Normal;
+    }
+
+    void ResidencyTracker::markUsed(const std::vector<uint64_t>& keys, std::vector<uint64_t>& outRestored)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        ++m_Serial;
+
+        for (uint64_t key : keys)
+        {
+            auto alias = m_Aliases.find(key);
+            const uint64_t allocation = alias != m_Aliases.end() ? alias->second : key;
+
+            auto it = m_Allocations.find(allocation);
+            if (it == m_Allocations.end())
+                continue;
+
+            Allocation& entry = it->second;
+
+            // Many resources share a heap or a memory block, only mark it once per submission
+            if (entry.lastUseSerial == m_Serial)
+                continue;
+
+            entry.lastUseSerial = m_Serial;
+            entry.used = true;
+            m_MarkedAllocations.push_back(allocation);
+
+            if (!entry.resident)
+            {
+                entry.resident = true;
+                outRestored.push_back(allocation);
+            }
+        }
+    }
+
+    void ResidencyTracker::submitted(CommandQueue queue, uint64_t instance)
+    {
+        if (!m_Enabled)
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (uint64_t allocation : m_MarkedAllocations)
+        {
+            // The allocation may have been released since it was marked
+            auto it = m_Allocations.find(allocation);
+            if (it != m_Allocations.end())
+                it->second.lastUseInstance[size_t(queue)] = instance;
+        }
+
+        m_MarkedAllocations.clear();
+    }
+
+    uint64_t ResidencyTracker::evict(uint64_t bytes, const uint64_t* completedInstances, std::vector<uint64_t>& outEvicted)
+    {
+        if (!m_Enabled || bytes == 0)
+            return bytes;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_EvictionCandidates.clear();
+
+        for (const auto& [key, entry] : m_Allocations)
+        {
+            if (!entry.used || !entry.resident || entry.priority == ResidencyPriority::Maximum)
+                continue;
+
+            // Allocations used by the submissions that have not been tagged yet are not candidates either
+            if (entry.lastUseSerial == m_Serial && !m_MarkedAllocations.empty())
+                continue;
+
+            bool inUse = false;
+            for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+            {
+                if (entry.lastUseInstance[queue] > completedInstances[queue])
+                {
+                    inUse = true;
+                    break;
+                }
+            }
+
+            if (!inUse)
+                m_EvictionCandidates.push_back(std::make_pair(key, &entry));
+        }
+
+        std::sort(m_EvictionCandidates.begin(), m_EvictionCandidates.end(),
+            [](const auto& a, const auto& b)
+            {
+                if (a.second->priority != b.second->priority)
+                    return a.second->priority < b.second->priority;
+
+                return a.second->lastUseSerial < b.second->lastUseSerial;
+            });
+
+        for (const auto& [key, entry] : m_EvictionCandidates)
+        {
+            if (bytes == 0)
+                break;
+
+            m_Allocations[key].resident = false;
+            outEvicted.push_back(key);
+            bytes -= std::min(bytes, entry->size);
+        }
+
+        m_EvictionCandidates.clear();
+        return bytes;
+    }
+
+} // namespace nvrhi
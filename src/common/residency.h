@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Tracks the device-local memory allocations used by submitted command lists, and picks the ones to evict
+    // when the memory budget is exceeded: the least important and least recently used first.
+    // The backends identify allocations by opaque 64-bit keys (ID3D12Pageable pointers, VkDeviceMemory handles)
+    // and map the resources referenced by their command lists to those keys. Other resources, such as placed
+    // textures, are added as aliases of the allocation they live in.
+    // Only the allocations that have been seen in a submission are evicted, so that the resources used internally
+    // by the backends are left alone.
+    // All methods do nothing until the tracker is enabled, so the backends can call them unconditionally.
+    class ResidencyTracker
+    {
+    public:
+        void setEnabled(bool enable) { m_Enabled = enable; }
+        [[nodiscard]] bool isEnabled() const { return m_Enabled; }
+
+        void addAllocation(uint64_t allocation, uint64_t size);
+        void removeAllocation(uint64_t allocation);
+
+        void addAlias(uint64_t alias, uint64_t allocation);
+        void removeAlias(uint64_t alias);
+
+        // Returns false if the allocation is not tracked. Aliases share the priority of their allocation,
+        // so they cannot be given one.
+        bool setPriority(uint64_t allocation, ResidencyPriority priority);
+        [[nodiscard]] ResidencyPriority getPriority(uint64_t allocation);
+
+        // Records the uses of allocations or aliases by the command lists about to be submitted.
+        // The allocations that were evicted are marked resident again and appended to outRestored;
+        // the backend must make them resident before the submission.
+        void markUsed(const std::vector<uint64_t>& keys, std::vector<uint64_t>& outRestored);
+
+        // Tags the allocations marked since the previous call with the submitted instance of the queue
+        void submitted(CommandQueue queue, uint64_t instance);
+
+        // Picks resident allocations whose last uses have completed, with completedInstances indexed by
+        // CommandQueue, until their total size covers the given number of bytes. The picked allocations are
+        // marked evicted and appended to outEvicted. Returns the number of bytes that could not be covered.
+        uint64_t evict(uint64_t bytes, const uint64_t* completedInstances, std::vector<uint64_t>& outEvicted);
+
+    private:
+        struct Allocation
+        {
+            uint64_t size = 0;
+            uint64_t lastUseSerial = 0;
+            uint64_t lastUseInstance[size_t(CommandQueue::Count)] = {};
+            ResidencyPriority priority = ResidencyPriority::Normal;
+            bool resident = true;
+            bool used = false;
+        };
+
+        bool m_Enabled = false;
+        std::mutex m_Mutex;
+        std::unordered_map<uint64_t, Allocation> m_Allocations;
+        std::unordered_map<uint64_t, uint64_t> m_Aliases;
+        std::vector<uint64_t> m_MarkedAllocations;
+        std::vector<std::pair<uint64_t, const Allocation*>> m_EvictionCandidates;
+        uint64_t m_Serial = 0;
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,127 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace nvrhi
+{
+    // The set of objects that a command list keeps alive until its execution completes.
+    // Recording references the same pipelines, binding sets and buffers over and over, and an atomic
+    // AddRef/Release pair on each of them per command makes the threads that record with shared objects
+    // contend for their cache lines. This set takes one reference per unique object instead:
+    // repeated insertions are filtered by comparing to the last inserted object and then by an
+    // open-addressing table of pointers, neither of which touches the objects themselves.
+    // Not thread-safe, like the command list that owns it.
+    class ResourceReferenceSet
+    {
+    public:
+        ResourceReferenceSet() = default;
+        ResourceReferenceSet(const ResourceReferenceSet&) = delete;
+        ResourceReferenceSet& operator=(const ResourceReferenceSet&) = delete;
+        ~ResourceReferenceSet() { clear(); }
+
+        void push_back(IResource* resource)
+        {
+            if (!resource || resource == m_LastResource)
+                return;
+
+            m_LastResource = resource;
+
+            if ((m_Resources.size() + 1) * 2 > m_Slots.size())
+                grow();
+
+            const size_t mask = m_Slots.size() - 1;
+            for (size_t index = hash(resource) & mask; ; index = (index + 1) & mask)
+            {
+                if (m_Slots[index] == resource)
+                    return;
+
+                if (!m_Slots[index])
+                {
+                    m_Slots[index] = resource;
+                    break;
+                }
+            }
+
+            resource->AddRef();
+            m_Resources.push_back(resource);
+        }
+
+        template<typename T>
+        void push_back(const RefCountPtr<T>& resource) { push_back(static_cast<IResource*>(resource.Get())); }
+
+        // Releases the references, keeps the storage for the next recording
+        void clear()
+        {
+            if (m_Resources.empty())
+                return;
+
+            for (IResource* resource : m_Resources)
+                resource->Release();
+
+            m_Resources.clear();
+            std::fill(m_Slots.begin(), m_Slots.end(), nullptr);
+            m_LastResource = nullptr;
+        }
+
+        [[nodiscard]] size_t size() const { return m_Resources.size(); }
+        [[nodiscard]] bool empty() const { return m_Resources.empty(); }
+        [[nodiscard]] std::vector<IResource*>::const_iterator begin() const { return m_Resources.begin(); }
+        [[nodiscard]] std::vector<IResource*>::const_iterator end() const { return m_Resources.end(); }
+
+    private:
+        static constexpr size_t c_InitialCapacity = 64;
+
+        std::vector<IResource*> m_Resources; // in insertion order, each holds one reference
+        std::vector<IResource*> m_Slots; // power of 2 sized, never more than half full
+        IResource* m_LastResource = nullptr;
+
+        static size_t hash(const IResource* resource)
+        {
+            // Objects are at least 16-byte aligned, mix the upper bits down into the index bits
+            const uint64_t value = uint64_t(reinterpret_cast<uintptr_t>(resource) >> 4) * 0x9E3779B97F4A7C15ull;
+            return size_t(value ^ (value >> 32));
+        }
+
+        void grow()
+        {
+            m_Slots.assign(std::max(m_Slots.size() * 2, c_InitialCapacity), nullptr);
+
+            const size_t mask = m_Slots.size() - 1;
+            for (IResource* resource : m_Resources)
+            {
+                size_t index = hash(resource) & mask;
+                while (m_Slots[index])
+                    index = (index + 1) & mask;
+
+                m_Slots[index] = resource;
+            }
+        }
+    };
+
+} // namespace nvrhi
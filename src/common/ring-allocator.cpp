@@ -0,0 +1,94 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "ring-allocator.h"
+#include "versioning.h"
+#include <nvrhi/common/misc.h>
+
+namespace nvrhi
+{
+    bool RingAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset)
+    {
+        if (size > m_Size)
+            return false;
+
+        const uint64_t headOffset = m_Head % m_Size;
+        uint64_t alignedOffset = align(headOffset, alignment);
+
+        // Allocations never wrap around the end of the ring, the remaining space is skipped instead
+        if (alignedOffset + size > m_Size)
+            alignedOffset = m_Size;
+
+        uint64_t newHead = m_Head + (alignedOffset - headOffset);
+
+        if (alignedOffset == m_Size)
+            alignedOffset = 0;
+
+        newHead += size;
+
+        if (newHead - m_Tail > m_Size)
+            return false;
+
+        m_Head = newHead;
+        outOffset = alignedOffset;
+        return true;
+    }
+
+    void RingAllocator::submit(uint64_t submittedVersion)
+    {
+        if (m_Head == m_SubmittedHead)
+            return;
+
+        if (m_NumSubmissions == c_MaxSubmissions)
+        {
+            Submission& newest = m_Submissions[(m_FirstSubmission + m_NumSubmissions - 1) % c_MaxSubmissions];
+            newest.end = m_Head;
+            newest.version = submittedVersion;
+        }
+        else
+        {
+            Submission& submission = m_Submissions[(m_FirstSubmission + m_NumSubmissions) % c_MaxSubmissions];
+            submission.end = m_Head;
+            submission.version = submittedVersion;
+            ++m_NumSubmissions;
+        }
+
+        m_SubmittedHead = m_Head;
+    }
+
+    void RingAllocator::retire(uint64_t completedInstance)
+    {
+        while (m_NumSubmissions != 0)
+        {
+            const Submission& submission = m_Submissions[m_FirstSubmission];
+
+            if (!VersionGetSubmitted(submission.version) || VersionGetInstance(submission.version) > completedInstance)
+                break;
+
+            m_Tail = submission.end;
+            m_FirstSubmission = (m_FirstSubmission + 1) % c_MaxSubmissions;
+            --m_NumSubmissions;
+        }
+    }
+
+} // namespace nvrhi
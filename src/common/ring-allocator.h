@@ -0,0 +1,78 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <array>
+
+namespace nvrhi
+{
+    // Tracks the space in a ring buffer that is sub-allocated by one command list and retired
+    // by the GPU in submission order. The allocator only deals with offsets; the backends own the memory.
+    // Allocation is a pointer bump. Allocations made since the last submission are considered pending
+    // and are tagged with the submitted version in submit(); they are retired once that instance completes.
+    // The submissions are kept in a fixed-capacity ring, so none of the operations allocate heap memory.
+    class RingAllocator
+    {
+    public:
+        void setSize(uint64_t size) { m_Size = size; }
+        [[nodiscard]] uint64_t getSize() const { return m_Size; }
+
+        // Returns false if there is not enough free space in the ring; alignment must be a power of 2
+        [[nodiscard]] bool allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset);
+
+        // Marks everything allocated since the previous submission as used by the given version
+        void submit(uint64_t submittedVersion);
+
+        // Frees the space used by the submissions that have finished executing
+        void retire(uint64_t completedInstance);
+
+        [[nodiscard]] bool hasRetirableSpace() const { return m_NumSubmissions != 0; }
+
+        // Size of the space that is pending or used by submissions not yet retired, including alignment padding
+        [[nodiscard]] uint64_t getUsedSize() const { return m_Head - m_Tail; }
+
+    private:
+        struct Submission
+        {
+            uint64_t end = 0;
+            uint64_t version = 0;
+        };
+
+        uint64_t m_Size = 0;
+
+        // Head and tail are virtual offsets that only grow; head - tail is the size of the used space
+        uint64_t m_Head = 0;
+        uint64_t m_Tail = 0;
+        uint64_t m_SubmittedHead = 0;
+
+        // When all entries are in use, a new submission is merged into the newest one, which is safe because
+        // the instances of one queue complete in order; that space is then retired a little later.
+        static constexpr size_t c_MaxSubmissions = 64;
+        std::array<Submission, c_MaxSubmissions> m_Submissions;
+        size_t m_FirstSubmission = 0;
+        size_t m_NumSubmissions = 0;
+    };
+
+} // namespace nvrhi
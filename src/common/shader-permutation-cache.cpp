@@ -0,0 +1,172 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "shader-permutation-cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace nvrhi
+{
+    namespace
+    {
+        // FNV-1a, which unlike std::hash gives the same keys in every run
+        class StableHash
+        {
+        public:
+            void addBytes(const void* data, size_t size)
+            {
+                const uint8_t* bytes = static_cast<const uint8_t*>(data);
+                for (size_t i = 0; i < size; i++)
+                {
+                    m_Hash ^= bytes[i];
+                    m_Hash *= 0x100000001b3ull;
+                }
+            }
+
+            template<typename T> void add(const T& value) { addBytes(&value, sizeof(value)); }
+
+            [[nodiscard]] uint64_t get() const { return m_Hash; }
+
+        private:
+            uint64_t m_Hash = 0xcbf29ce484222325ull;
+        };
+
+        constexpr uint32_t c_FileMagic = 0x5053564e; // 'NVSP'
+
+        struct FileHeader
+        {
+            uint32_t magic;
+            uint32_t reserved;
+            uint64_t key;
+            uint64_t size;
+        };
+    }
+
+    ShaderPermutationCache::Bytecode ShaderPermutationCache::getPermutation(const ShaderDesc& desc, const void* baseBytecode,
+        size_t baseBytecodeSize, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        StableHash hash;
+        hash.add(uint64_t(baseBytecodeSize));
+        hash.addBytes(baseBytecode, baseBytecodeSize);
+        hash.addBytes(desc.entryName.data(), desc.entryName.size());
+        for (uint32_t i = 0; i < numConstants; i++)
+        {
+            hash.add(constants[i].constantID);
+            hash.add(constants[i].value.u);
+        }
+        const uint64_t key = hash.get();
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto it = m_Permutations.find(key);
+            if (it != m_Permutations.end())
+                return it->second;
+        }
+
+        // Load or resolve the variant outside of the lock, the provider may compile or link it.
+        // Threads asking for the same variant at the same time can both do that, the first one to finish wins.
+        Bytecode bytecode = loadFromDisk(key);
+
+        if (!bytecode)
+        {
+            std::vector<uint8_t> resolved;
+            if (!m_Provider->getShaderPermutation(desc, baseBytecode, baseBytecodeSize, constants, numConstants, resolved) || resolved.empty())
+                return nullptr;
+
+            storeToDisk(key, resolved);
+            bytecode = std::make_shared<const std::vector<uint8_t>>(std::move(resolved));
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+        auto [it, inserted] = m_Permutations.try_emplace(key, std::move(bytecode));
+        return it->second;
+    }
+
+    std::string ShaderPermutationCache::getFilePath(uint64_t key) const
+    {
+        std::stringstream ss;
+        ss << m_Directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+        return ss.str();
+    }
+
+    ShaderPermutationCache::Bytecode ShaderPermutationCache::loadFromDisk(uint64_t key) const
+    {
+        if (m_Directory.empty())
+            return nullptr;
+
+        std::ifstream stream(getFilePath(key), std::ios::binary);
+        if (!stream)
+            return nullptr;
+
+        FileHeader header{};
+        if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.magic != c_FileMagic || header.key != key || header.size == 0)
+        {
+            return nullptr;
+        }
+
+        std::vector<uint8_t> bytecode(header.size);
+        if (!stream.read(reinterpret_cast<char*>(bytecode.data()), std::streamsize(bytecode.size())))
+            return nullptr;
+
+        return std::make_shared<const std::vector<uint8_t>>(std::move(bytecode));
+    }
+
+    void ShaderPermutationCache::storeToDisk(uint64_t key, const std::vector<uint8_t>& bytecode) const
+    {
+        if (m_Directory.empty())
+            return;
+
+        // Write to a temporary file first so that other processes never see a partial file
+        const std::string path = getFilePath(key);
+        const std::string tempPath = path + ".tmp";
+
+        {
+            std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+
+            FileHeader header{};
+            header.magic = c_FileMagic;
+            header.key = key;
+            header.size = bytecode.size();
+
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.write(reinterpret_cast<const char*>(bytecode.data()), std::streamsize(bytecode.size()));
+
+            if (!stream)
+            {
+                m_MessageCallback->message(MessageSeverity::Warning, ("Cannot write the shader permutation cache file " + tempPath).c_str());
+                stream.close();
+                std::remove(tempPath.c_str());
+                return;
+            }
+        }
+
+        std::remove(path.c_str());
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+            std::remove(tempPath.c_str());
+    }
+
+} // namespace nvrhi
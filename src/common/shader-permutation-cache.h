@@ -0,0 +1,66 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi
+{
+    // Resolves shader specializations on the backends without specialization constants, see IShaderPermutationProvider.
+    // The variants returned by the provider are kept in memory for the lifetime of the device and, if a directory
+    // is given, stored there as files named after a hash of the base bytecode, entry point and constant values.
+    // Later lookups of the same variant, including ones from later runs, don't call the provider.
+    class ShaderPermutationCache
+    {
+    public:
+        typedef std::shared_ptr<const std::vector<uint8_t>> Bytecode;
+
+        ShaderPermutationCache(IShaderPermutationProvider* provider, std::string directory, IMessageCallback* messageCallback)
+            : m_Provider(provider)
+            , m_Directory(std::move(directory))
+            , m_MessageCallback(messageCallback)
+        { }
+
+        // Returns null if the provider has no such variant. The constants must be sorted by constantID.
+        [[nodiscard]] Bytecode getPermutation(const ShaderDesc& desc, const void* baseBytecode, size_t baseBytecodeSize,
+            const ShaderSpecialization* constants, uint32_t numConstants);
+
+    private:
+        IShaderPermutationProvider* m_Provider;
+        std::string m_Directory;
+        IMessageCallback* m_MessageCallback;
+
+        std::mutex m_Mutex;
+        std::unordered_map<uint64_t, Bytecode> m_Permutations;
+
+        [[nodiscard]] std::string getFilePath(uint64_t key) const;
+        [[nodiscard]] Bytecode loadFromDisk(uint64_t key) const;
+        void storeToDisk(uint64_t key, const std::vector<uint8_t>& bytecode) const;
+    };
+
+} // namespace nvrhi
@@ -24,10 +24,50 @@
 
 #include <nvrhi/utils.h>
 
+#include <mutex>
 #include <sstream>
 
 namespace nvrhi
 {
+    namespace
+    {
+        struct StateTrackerIndexPool
+        {
+            std::mutex mutex;
+            std::vector<uint32_t> freeIndices;
+            uint32_t nextIndex = 0;
+        };
+
+        StateTrackerIndexPool& getStateTrackerIndexPool()
+        {
+            static StateTrackerIndexPool pool;
+            return pool;
+        }
+    }
+
+    uint32_t allocateStateTrackerIndex()
+    {
+        StateTrackerIndexPool& pool = getStateTrackerIndexPool();
+        std::lock_guard lockGuard(pool.mutex);
+
+        if (!pool.freeIndices.empty())
+        {
+            uint32_t index = pool.freeIndices.back();
+            pool.freeIndices.pop_back();
+            return index;
+        }
+
+        return pool.nextIndex++;
+    }
+
+    void releaseStateTrackerIndex(uint32_t index)
+    {
+        StateTrackerIndexPool& pool = getStateTrackerIndexPool();
+        std::lock_guard lockGuard(pool.mutex);
+
+        pool.freeIndices.push_back(index);
+    }
+
     bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback)
     {
         if ((permanentState & requiredState) != requiredState)
@@ -69,6 +109,11 @@ namespace nvrhi
         const TextureDesc& desc = texture->descRef;
 
         TextureState* tracking = getTextureStateTracking(texture, true);
+        tracking->entryStatePending = false;
+        tracking->contentsDiscarded = false;
+
+        if (tracking->splitStateBefore != ResourceStates::Unknown)
+            endTextureSplitTransition(texture, tracking);
         
         subresources = subresources.resolve(desc, false);
 
@@ -97,6 +142,10 @@ namespace nvrhi
     {
         BufferState* tracking = getBufferStateTracking(buffer, true);
 
+        if (tracking->splitStateBefore != ResourceStates::Unknown)
+            endBufferSplitTransition(buffer, tracking);
+
+        tracking->entryStatePending = false;
         tracking->state = stateBits;
     }
 
@@ -132,6 +181,132 @@ namespace nvrhi
         m_PermanentBufferStates.push_back(std::make_pair(buffer, stateBits));
     }
 
+    void CommandListResourceStateTracker::beginTextureStateTransition(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        if (texture->permanentState != 0)
+        {
+            verifyPermanentResourceState(texture->permanentState, stateBits, true, texture->descRef.debugName, m_MessageCallback);
+            return;
+        }
+
+        subresources = subresources.resolve(texture->descRef, false);
+
+        TextureState* tracking = getTextureStateTracking(texture, true);
+
+        if (tracking->splitStateBefore != ResourceStates::Unknown)
+            endTextureSplitTransition(texture, tracking);
+
+        // Splitting is only done for the simple case of an entire texture in a known state,
+        // everything else goes through the regular transition path
+        if (!subresources.isEntireTexture(texture->descRef) ||
+            !tracking->subresourceStates.empty() ||
+            tracking->state == ResourceStates::Unknown ||
+            tracking->entryStatePending)
+        {
+            requireTextureState(texture, subresources, stateBits);
+            return;
+        }
+
+        if (tracking->state == stateBits)
+            return;
+
+        TextureBarrier barrier;
+        barrier.texture = texture;
+        barrier.entireTexture = true;
+        barrier.split = SplitBarrier::Begin;
+        barrier.stateBefore = tracking->state;
+        barrier.stateAfter = stateBits;
+        m_TextureBarriers.push_back(barrier);
+
+        tracking->splitStateBefore = tracking->state;
+        tracking->state = stateBits;
+    }
+
+    void CommandListResourceStateTracker::beginBufferStateTransition(BufferStateExtension* buffer, ResourceStates stateBits)
+    {
+        if (buffer->descRef.isVolatile)
+            return;
+
+        if (buffer->permanentState != 0)
+        {
+            verifyPermanentResourceState(buffer->permanentState, stateBits, false, buffer->descRef.debugName, m_MessageCallback);
+            return;
+        }
+
+        if (buffer->descRef.cpuAccess != CpuAccessMode::None)
+            return;
+
+        BufferState* tracking = getBufferStateTracking(buffer, true);
+
+        if (tracking->splitStateBefore != ResourceStates::Unknown)
+            endBufferSplitTransition(buffer, tracking);
+
+        if (tracking->state == ResourceStates::Unknown || tracking->entryStatePending)
+        {
+            requireBufferState(buffer, stateBits);
+            return;
+        }
+
+        if (tracking->state == stateBits)
+            return;
+
+        BufferBarrier barrier;
+        barrier.buffer = buffer;
+        barrier.split = SplitBarrier::Begin;
+        barrier.stateBefore = tracking->state;
+        barrier.stateAfter = stateBits;
+        m_BufferBarriers.push_back(barrier);
+
+        tracking->splitStateBefore = tracking->state;
+        tracking->state = stateBits;
+    }
+
+    void CommandListResourceStateTracker::endTextureSplitTransition(TextureStateExtension* texture, TextureState* tracking)
+    {
+        // When the beginning of the transition is still pending, there is no work to overlap it with
+        for (TextureBarrier& barrier : m_TextureBarriers)
+        {
+            if (barrier.texture == texture && barrier.split == SplitBarrier::Begin)
+            {
+                barrier.split = SplitBarrier::None;
+                tracking->splitStateBefore = ResourceStates::Unknown;
+                return;
+            }
+        }
+
+        TextureBarrier barrier;
+        barrier.texture = texture;
+        barrier.entireTexture = true;
+        barrier.split = SplitBarrier::End;
+        barrier.stateBefore = tracking->splitStateBefore;
+        barrier.stateAfter = tracking->state;
+        m_TextureBarriers.push_back(barrier);
+
+        tracking->splitStateBefore = ResourceStates::Unknown;
+    }
+
+    void CommandListResourceStateTracker::endBufferSplitTransition(BufferStateExtension* buffer, BufferState* tracking)
+    {
+        for (BufferBarrier& barrier : m_BufferBarriers)
+        {
+            if (barrier.buffer == buffer && barrier.split == SplitBarrier::Begin)
+            {
+                barrier.split = SplitBarrier::None;
+                tracking->splitStateBefore = ResourceStates::Unknown;
+                return;
+            }
+        }
+
+        BufferBarrier barrier;
+        barrier.buffer = buffer;
+        barrier.split = SplitBarrier::End;
+        barrier.stateBefore = tracking->splitStateBefore;
+        barrier.stateAfter = tracking->state;
+        m_BufferBarriers.push_back(barrier);
+
+        tracking->splitStateBefore = ResourceStates::Unknown;
+    }
+
     ResourceStates CommandListResourceStateTracker::getTextureSubresourceState(TextureStateExtension* texture, ArraySlice arraySlice, MipLevel mipLevel)
     {
         TextureState* tracking = getTextureStateTracking(texture, false);
@@ -150,6 +325,22 @@ namespace nvrhi
         return tracking->subresourceStates[subresource];
     }
 
+    void CommandListResourceStateTracker::discardTextureContents(TextureStateExtension* texture)
+    {
+        if (texture->permanentState != 0)
+            return;
+
+        TextureState* tracking = getTextureStateTracking(texture, true);
+
+        if (tracking->splitStateBefore != ResourceStates::Unknown)
+            endTextureSplitTransition(texture, tracking);
+
+        tracking->entryStatePending = false;
+        tracking->state = ResourceStates::Unknown;
+        tracking->subresourceStates.clear();
+        tracking->contentsDiscarded = true;
+    }
+
     ResourceStates CommandListResourceStateTracker::getBufferState(BufferStateExtension* buffer)
     {
         BufferState* tracking = getBufferStateTracking(buffer, false);
@@ -172,7 +363,19 @@ namespace nvrhi
 
         TextureState* tracking = getTextureStateTracking(texture, true);
 
-        if (tracking->subresourceStates.empty() && tracking->state == ResourceStates::Unknown)
+        if (tracking->splitStateBefore != ResourceStates::Unknown)
+            endTextureSplitTransition(texture, tracking);
+
+        if (tracking->entryStatePending)
+        {
+            // The state of the texture when this command list starts executing is only known at submission.
+            // Make the first required state the entry state, the device will transition the texture into it.
+            tracking->entryStatePending = false;
+            tracking->entryState = state;
+            tracking->state = state;
+        }
+
+        if (tracking->subresourceStates.empty() && tracking->state == ResourceStates::Unknown && !tracking->contentsDiscarded)
         {
             std::stringstream ss;
             ss << "Unknown prior state of texture " << utils::DebugNameToString(texture->descRef.debugName) << ". "
@@ -200,6 +403,7 @@ namespace nvrhi
             }
 
             tracking->state = state;
+            tracking->contentsDiscarded = false;
 
             if (uavNecessary && !transitionNecessary)
             {
@@ -220,16 +424,23 @@ namespace nvrhi
             }
             
             bool anyUavBarrier = false;
+            m_PreviousSliceBarriers.clear();
+
+            // Transitions are collected as runs of consecutive mip levels with the same prior state in each array slice.
+            // When an array slice has exactly the same runs as the previous one, the previous slice's barriers are
+            // extended to cover it, so that uniform ranges of subresources produce one barrier per run.
 
             for (ArraySlice arraySlice = subresources.baseArraySlice; arraySlice < subresources.baseArraySlice + subresources.numArraySlices; arraySlice++)
             {
+                m_SubresourceRuns.clear();
+
                 for (MipLevel mipLevel = subresources.baseMipLevel; mipLevel < subresources.baseMipLevel + subresources.numMipLevels; mipLevel++)
                 {
                     uint32_t subresourceIndex = calcSubresource(mipLevel, arraySlice, texture->descRef);
 
                     auto priorState = tracking->subresourceStates[subresourceIndex];
 
-                    if (priorState == ResourceStates::Unknown && !stateExpanded)
+                    if (priorState == ResourceStates::Unknown && !stateExpanded && !tracking->contentsDiscarded)
                     {
                         std::stringstream ss;
                         ss << "Unknown prior state of texture " << utils::DebugNameToString(texture->descRef.debugName)
@@ -243,7 +454,24 @@ namespace nvrhi
                     bool uavNecessary = ((state & ResourceStates::UnorderedAccess) != 0)
                         && !anyUavBarrier && (tracking->enableUavBarriers || !tracking->firstUavBarrierPlaced);
 
-                    if (transitionNecessary || uavNecessary)
+                    if (transitionNecessary)
+                    {
+                        if (!m_SubresourceRuns.empty() &&
+                            m_SubresourceRuns.back().stateBefore == priorState &&
+                            m_SubresourceRuns.back().mipLevel + m_SubresourceRuns.back().numMipLevels == mipLevel)
+                        {
+                            m_SubresourceRuns.back().numMipLevels++;
+                        }
+                        else
+                        {
+                            SubresourceRun run;
+                            run.mipLevel = mipLevel;
+                            run.numMipLevels = 1;
+                            run.stateBefore = priorState;
+                            m_SubresourceRuns.push_back(run);
+                        }
+                    }
+                    else if (uavNecessary)
                     {
                         TextureBarrier barrier;
                         barrier.texture = texture;
@@ -253,17 +481,70 @@ namespace nvrhi
                         barrier.stateBefore = priorState;
                         barrier.stateAfter = state;
                         m_TextureBarriers.push_back(barrier);
+
+                        anyUavBarrier = true;
+                        tracking->firstUavBarrierPlaced = true;
                     }
 
                     tracking->subresourceStates[subresourceIndex] = state;
+                }
+
+                bool sameRunsAsPreviousSlice = !m_SubresourceRuns.empty() && m_SubresourceRuns.size() == m_PreviousSliceBarriers.size();
+                for (size_t runIndex = 0; sameRunsAsPreviousSlice && runIndex < m_SubresourceRuns.size(); runIndex++)
+                {
+                    const SubresourceRun& run = m_SubresourceRuns[runIndex];
+                    const TextureBarrier& barrier = m_TextureBarriers[m_PreviousSliceBarriers[runIndex]];
 
-                    if (uavNecessary && !transitionNecessary)
+                    sameRunsAsPreviousSlice = barrier.mipLevel == run.mipLevel
+                        && barrier.numMipLevels == run.numMipLevels
+                        && barrier.stateBefore == run.stateBefore;
+                }
+
+                if (sameRunsAsPreviousSlice)
+                {
+                    for (size_t barrierIndex : m_PreviousSliceBarriers)
+                        m_TextureBarriers[barrierIndex].numArraySlices++;
+                }
+                else
+                {
+                    m_PreviousSliceBarriers.clear();
+
+                    for (const SubresourceRun& run : m_SubresourceRuns)
                     {
-                        anyUavBarrier = true;
-                        tracking->firstUavBarrierPlaced = true;
+                        TextureBarrier barrier;
+                        barrier.texture = texture;
+                        barrier.entireTexture = false;
+                        barrier.mipLevel = run.mipLevel;
+                        barrier.numMipLevels = run.numMipLevels;
+                        barrier.arraySlice = arraySlice;
+                        barrier.numArraySlices = 1;
+                        barrier.stateBefore = run.stateBefore;
+                        barrier.stateAfter = state;
+
+                        m_PreviousSliceBarriers.push_back(m_TextureBarriers.size());
+                        m_TextureBarriers.push_back(barrier);
                     }
                 }
             }
+
+            // A single barrier that ended up covering all subresources can be issued as a whole-resource barrier
+            for (size_t barrierIndex : m_PreviousSliceBarriers)
+            {
+                TextureBarrier& barrier = m_TextureBarriers[barrierIndex];
+                if (barrier.mipLevel == 0 && barrier.numMipLevels == texture->descRef.mipLevels &&
+                    barrier.arraySlice == 0 && barrier.numArraySlices == texture->descRef.arraySize)
+                {
+                    barrier.entireTexture = true;
+                }
+            }
+
+            // All subresources are in the same state now, go back to tracking the texture as a whole
+            if (subresources.isEntireTexture(texture->descRef))
+            {
+                tracking->subresourceStates.clear();
+                tracking->state = state;
+                tracking->contentsDiscarded = false;
+            }
         }
     }
 
@@ -287,6 +568,16 @@ namespace nvrhi
 
         BufferState* tracking = getBufferStateTracking(buffer, true);
 
+        if (tracking->splitStateBefore != ResourceStates::Unknown)
+            endBufferSplitTransition(buffer, tracking);
+
+        if (tracking->entryStatePending)
+        {
+            tracking->entryStatePending = false;
+            tracking->entryState = state;
+            tracking->state = state;
+        }
+
         if (tracking->state == ResourceStates::Unknown)
         {
             std::stringstream ss;
@@ -307,7 +598,7 @@ namespace nvrhi
             // Example: same buffer used as index and vertex buffer, or as SRV and indirect arguments.
             for (BufferBarrier& barrier : m_BufferBarriers)
             {
-                if (barrier.buffer == buffer)
+                if (barrier.buffer == buffer && barrier.split == SplitBarrier::None)
                 {
                     barrier.stateAfter = ResourceStates(barrier.stateAfter | state);
                     tracking->state = barrier.stateAfter;
@@ -333,10 +624,36 @@ namespace nvrhi
         tracking->state = state;
     }
 
+    void CommandListResourceStateTracker::endSplitTransitions()
+    {
+        for (size_t index = 0; index < m_NumTextureStates; index++)
+        {
+            TextureState* tracking = m_TextureStates[index].state.get();
+
+            if (tracking->splitStateBefore != ResourceStates::Unknown)
+                endTextureSplitTransition(m_TextureStates[index].resource, tracking);
+        }
+
+        for (size_t index = 0; index < m_NumBufferStates; index++)
+        {
+            BufferState* tracking = m_BufferStates[index].state.get();
+
+            if (tracking->splitStateBefore != ResourceStates::Unknown)
+                endBufferSplitTransition(m_BufferStates[index].resource, tracking);
+        }
+    }
+
     void CommandListResourceStateTracker::keepBufferInitialStates()
     {
-        for (auto& [buffer, tracking] : m_BufferStates)
+        // In state handoff mode, buffers stay in their final states and are transitioned at submission
+        if (m_EnableStateHandoff)
+            return;
+
+        for (size_t index = 0; index < m_NumBufferStates; index++)
         {
+            BufferStateExtension* buffer = m_BufferStates[index].resource;
+            const BufferState* tracking = m_BufferStates[index].state.get();
+
             if (buffer->descRef.keepInitialState && 
                 !buffer->permanentState &&
                 !buffer->descRef.isVolatile &&
@@ -349,8 +666,29 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepTextureInitialStates()
     {
-        for (auto& [texture, tracking] : m_TextureStates)
+        for (size_t index = 0; index < m_NumTextureStates; index++)
         {
+            TextureStateExtension* texture = m_TextureStates[index].resource;
+            const TextureState* tracking = m_TextureStates[index].state.get();
+
+            if (m_EnableStateHandoff)
+            {
+                // Textures stay in their final states and are transitioned at submission,
+                // which is only possible for textures that are in a uniform state
+                if (!tracking->subresourceStates.empty() &&
+                    !texture->permanentState &&
+                    !tracking->permanentTransition)
+                {
+                    ResourceStates finalState = tracking->entryState != ResourceStates::Unknown
+                        ? tracking->entryState
+                        : tracking->subresourceStates[0];
+
+                    if (finalState != ResourceStates::Unknown)
+                        requireTextureState(texture, AllSubresources, finalState);
+                }
+                continue;
+            }
+
             if (texture->descRef.keepInitialState && 
                 !texture->permanentState && 
                 !tracking->permanentTransition)
@@ -360,6 +698,12 @@ namespace nvrhi
         }
     }
 
+    void CommandListResourceStateTracker::addBarriers(const std::vector<TextureBarrier>& textureBarriers, const std::vector<BufferBarrier>& bufferBarriers)
+    {
+        m_TextureBarriers.insert(m_TextureBarriers.end(), textureBarriers.begin(), textureBarriers.end());
+        m_BufferBarriers.insert(m_BufferBarriers.end(), bufferBarriers.begin(), bufferBarriers.end());
+    }
+
     void CommandListResourceStateTracker::commandListSubmitted()
     {
         for (auto [texture, state] : m_PermanentTextureStates)
@@ -392,34 +736,80 @@ namespace nvrhi
         }
         m_PermanentBufferStates.clear();
 
-        for (const auto& [texture, stateTracking] : m_TextureStates)
+        for (size_t index = 0; index < m_NumTextureStates; index++)
         {
+            TextureStateExtension* texture = m_TextureStates[index].resource;
             if (texture->descRef.keepInitialState && !texture->stateInitialized)
                 texture->stateInitialized = true;
         }
 
-        m_TextureStates.clear();
-        m_BufferStates.clear();
+        if (!m_KeepStatesAfterSubmission)
+            resetTrackedStates();
     }
 
-    TextureState* CommandListResourceStateTracker::getTextureStateTracking(TextureStateExtension* texture, bool allowCreate)
+    void CommandListResourceStateTracker::resetTrackedStates()
     {
-        auto it = m_TextureStates.find(texture);
+        // Keep the state objects for the next instance, only invalidate the slots
+        m_NumTextureStates = 0;
+        m_NumBufferStates = 0;
 
-        if (it != m_TextureStates.end())
+        ++m_Generation;
+        if (m_Generation == 0)
+        {
+            // The generation counter wrapped around, old slots could look valid again
+            std::fill(m_TextureSlots.begin(), m_TextureSlots.end(), TrackerSlot());
+            std::fill(m_BufferSlots.begin(), m_BufferSlots.end(), TrackerSlot());
+            m_Generation = 1;
+        }
+    }
+
+    TextureState* CommandListResourceStateTracker::getTextureStateTracking(TextureStateExtension* texture, bool allowCreate)
+    {
+        if (texture->trackerIndex < m_TextureSlots.size())
         {
-            return it->second.get();
+            const TrackerSlot& slot = m_TextureSlots[texture->trackerIndex];
+
+            // Also compare the resource in case the index was recycled while the slot was still current
+            if (slot.generation == m_Generation && m_TextureStates[slot.index].resource == texture)
+                return m_TextureStates[slot.index].state.get();
         }
 
         if (!allowCreate)
             return nullptr;
-        
-        std::unique_ptr<TextureState> trackingRef = std::make_unique<TextureState>();
 
-        TextureState* tracking = trackingRef.get();
-        m_TextureStates.insert(std::make_pair(texture, std::move(trackingRef)));
+        if (texture->trackerIndex >= m_TextureSlots.size())
+            m_TextureSlots.resize(size_t(texture->trackerIndex) + 1);
+
+        if (m_NumTextureStates == m_TextureStates.size())
+        {
+            m_TextureStates.emplace_back();
+            m_TextureStates.back().state = std::make_unique<TextureState>();
+        }
+
+        TrackerSlot& slot = m_TextureSlots[texture->trackerIndex];
+        slot.generation = m_Generation;
+        slot.index = uint32_t(m_NumTextureStates);
+
+        auto& entry = m_TextureStates[m_NumTextureStates++];
+        entry.resource = texture;
+
+        // Reset the pooled state object, keeping the subresource array's storage
+        TextureState* tracking = entry.state.get();
+        tracking->subresourceStates.clear();
+        tracking->state = ResourceStates::Unknown;
+        tracking->entryState = ResourceStates::Unknown;
+        tracking->entryStatePending = false;
+        tracking->splitStateBefore = ResourceStates::Unknown;
+        tracking->enableUavBarriers = true;
+        tracking->firstUavBarrierPlaced = false;
+        tracking->permanentTransition = false;
+        tracking->contentsDiscarded = false;
         
-        if (texture->descRef.keepInitialState)
+        if (m_EnableStateHandoff)
+        {
+            tracking->entryStatePending = true;
+        }
+        else if (texture->descRef.keepInitialState)
         {
             tracking->state = texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
         }
@@ -429,26 +819,300 @@ namespace nvrhi
 
     BufferState* CommandListResourceStateTracker::getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate)
     {
-        auto it = m_BufferStates.find(buffer);
-
-        if (it != m_BufferStates.end())
+        if (buffer->trackerIndex < m_BufferSlots.size())
         {
-            return it->second.get();
+            const TrackerSlot& slot = m_BufferSlots[buffer->trackerIndex];
+
+            if (slot.generation == m_Generation && m_BufferStates[slot.index].resource == buffer)
+                return m_BufferStates[slot.index].state.get();
         }
 
         if (!allowCreate)
             return nullptr;
 
-        std::unique_ptr<BufferState> trackingRef = std::make_unique<BufferState>();
+        if (buffer->trackerIndex >= m_BufferSlots.size())
+            m_BufferSlots.resize(size_t(buffer->trackerIndex) + 1);
+
+        if (m_NumBufferStates == m_BufferStates.size())
+        {
+            m_BufferStates.emplace_back();
+            m_BufferStates.back().state = std::make_unique<BufferState>();
+        }
+
+        TrackerSlot& slot = m_BufferSlots[buffer->trackerIndex];
+        slot.generation = m_Generation;
+        slot.index = uint32_t(m_NumBufferStates);
+
+        auto& entry = m_BufferStates[m_NumBufferStates++];
+        entry.resource = buffer;
 
-        BufferState* tracking = trackingRef.get();
-        m_BufferStates.insert(std::make_pair(buffer, std::move(trackingRef)));
+        BufferState* tracking = entry.state.get();
+        *tracking = BufferState();
                                                    
-        if (buffer->descRef.keepInitialState)
+        if (m_EnableStateHandoff)
+        {
+            tracking->entryStatePending = true;
+        }
+        else if (buffer->descRef.keepInitialState)
         {
             tracking->state = buffer->descRef.initialState;
         }
 
         return tracking;
     }
+
+    static bool subresourceSetsOverlap(const TextureSubresourceSet& a, const TextureSubresourceSet& b)
+    {
+        return a.baseMipLevel < b.baseMipLevel + b.numMipLevels && b.baseMipLevel < a.baseMipLevel + a.numMipLevels
+            && a.baseArraySlice < b.baseArraySlice + b.numArraySlices && b.baseArraySlice < a.baseArraySlice + a.numArraySlices;
+    }
+
+    bool BundleStateRequirements::requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state)
+    {
+        subresources = subresources.resolve(texture->descRef, false);
+
+        std::vector<size_t>& indices = m_TextureIndices[texture];
+        for (size_t index : indices)
+        {
+            const TextureRequirement& requirement = m_Textures[index];
+
+            if (requirement.subresources == subresources)
+                return requirement.state == state;
+
+            if (requirement.state != state && subresourceSetsOverlap(requirement.subresources, subresources))
+                return false;
+        }
+
+        indices.push_back(m_Textures.size());
+        m_Textures.push_back(TextureRequirement{ texture, subresources, state });
+        return true;
+    }
+
+    bool BundleStateRequirements::requireBufferState(BufferStateExtension* buffer, ResourceStates state)
+    {
+        auto found = m_BufferIndices.find(buffer);
+        if (found != m_BufferIndices.end())
+            return m_Buffers[found->second].second == state;
+
+        m_BufferIndices[buffer] = m_Buffers.size();
+        m_Buffers.push_back(std::make_pair(buffer, state));
+        return true;
+    }
+
+    void BundleStateRequirements::apply(CommandListResourceStateTracker& tracker) const
+    {
+        for (const TextureRequirement& requirement : m_Textures)
+            tracker.requireTextureState(requirement.texture, requirement.subresources, requirement.state);
+
+        for (const auto& [buffer, state] : m_Buffers)
+            tracker.requireBufferState(buffer, state);
+    }
+
+    void BundleStateRequirements::clear()
+    {
+        m_Textures.clear();
+        m_Buffers.clear();
+        m_TextureIndices.clear();
+        m_BufferIndices.clear();
+    }
+
+    static ResourceStates getCurrentHandoffState(const TextureStateExtension* texture)
+    {
+        if (texture->handoffState != ResourceStates::Unknown || !texture->descRef.keepInitialState)
+            return texture->handoffState;
+
+        return texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
+    }
+
+    static ResourceStates getCurrentHandoffState(const BufferStateExtension* buffer)
+    {
+        if (buffer->handoffState != ResourceStates::Unknown || !buffer->descRef.keepInitialState)
+            return buffer->handoffState;
+
+        return buffer->descRef.initialState;
+    }
+
+    bool StateHandoffResolver::resolveCommandList(const CommandListResourceStateTracker& commandList)
+    {
+        // Regular command lists expect the keepInitialState resources to be in their initial states
+        if (!commandList.m_EnableStateHandoff)
+            restoreInitialStates();
+
+        for (size_t index = 0; index < commandList.m_NumTextureStates; index++)
+        {
+            TextureStateExtension* texture = commandList.m_TextureStates[index].resource;
+            const TextureState* tracking = commandList.m_TextureStates[index].state.get();
+
+            if (texture->permanentState != 0)
+                continue;
+
+            if (tracking->entryState != ResourceStates::Unknown)
+            {
+                ResourceStates currentState = getCurrentHandoffState(texture);
+
+                if (currentState == ResourceStates::Unknown)
+                {
+                    std::stringstream ss;
+                    ss << "Unknown state of texture " << utils::DebugNameToString(texture->descRef.debugName)
+                        << " at the start of a command list with state handoff. Use the keepInitialState and initialState "
+                        "members of TextureDesc, or call CommandList::beginTrackingTextureState(...) in this or an earlier command list.";
+                    m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+                }
+                else if (currentState != tracking->entryState)
+                {
+                    TextureBarrier barrier;
+                    barrier.texture = texture;
+                    barrier.entireTexture = true;
+                    barrier.stateBefore = currentState;
+                    barrier.stateAfter = tracking->entryState;
+                    m_TextureBarriers.push_back(barrier);
+                }
+            }
+
+            if (tracking->permanentTransition)
+            {
+                // The texture is about to get a permanent state and won't be tracked anymore
+                texture->handoffState = ResourceStates::Unknown;
+                continue;
+            }
+
+            // Textures left in a non-uniform state will have to be tracked explicitly by the next user
+            setTextureHandoffState(texture, tracking->subresourceStates.empty() ? tracking->state : ResourceStates::Unknown);
+        }
+
+        for (size_t index = 0; index < commandList.m_NumBufferStates; index++)
+        {
+            BufferStateExtension* buffer = commandList.m_BufferStates[index].resource;
+            const BufferState* tracking = commandList.m_BufferStates[index].state.get();
+
+            if (buffer->permanentState != 0 || buffer->descRef.isVolatile || buffer->descRef.cpuAccess != CpuAccessMode::None)
+                continue;
+
+            if (tracking->entryState != ResourceStates::Unknown)
+            {
+                ResourceStates currentState = getCurrentHandoffState(buffer);
+
+                if (currentState == ResourceStates::Unknown)
+                {
+                    std::stringstream ss;
+                    ss << "Unknown state of buffer " << utils::DebugNameToString(buffer->descRef.debugName)
+                        << " at the start of a command list with state handoff. Use the keepInitialState and initialState "
+                        "members of BufferDesc, or call CommandList::beginTrackingBufferState(...) in this or an earlier command list.";
+                    m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
+                }
+                else if (currentState != tracking->entryState)
+                {
+                    BufferBarrier barrier;
+                    barrier.buffer = buffer;
+                    barrier.stateBefore = currentState;
+                    barrier.stateAfter = tracking->entryState;
+                    m_BufferBarriers.push_back(barrier);
+                }
+            }
+
+            bool permanentTransition = false;
+            for (const auto& [permanentBuffer, permanentState] : commandList.m_PermanentBufferStates)
+            {
+                if (permanentBuffer == buffer)
+                {
+                    permanentTransition = true;
+                    break;
+                }
+            }
+
+            if (permanentTransition)
+            {
+                buffer->handoffState = ResourceStates::Unknown;
+                continue;
+            }
+
+            setBufferHandoffState(buffer, tracking->state);
+        }
+
+        return !m_TextureBarriers.empty() || !m_BufferBarriers.empty();
+    }
+
+    bool StateHandoffResolver::restoreInitialStates()
+    {
+        for (TextureStateExtension* texture : m_DisplacedTextures)
+        {
+            // Textures may be listed twice, or have become permanent after being displaced
+            if (texture->handoffState == ResourceStates::Unknown || texture->permanentState != 0)
+                continue;
+
+            if (texture->handoffState != texture->descRef.initialState)
+            {
+                TextureBarrier barrier;
+                barrier.texture = texture;
+                barrier.entireTexture = true;
+                barrier.stateBefore = texture->handoffState;
+                barrier.stateAfter = texture->descRef.initialState;
+                m_TextureBarriers.push_back(barrier);
+            }
+
+            texture->handoffState = ResourceStates::Unknown;
+        }
+        m_DisplacedTextures.clear();
+
+        for (BufferStateExtension* buffer : m_DisplacedBuffers)
+        {
+            if (buffer->handoffState == ResourceStates::Unknown || buffer->permanentState != 0)
+                continue;
+
+            if (buffer->handoffState != buffer->descRef.initialState)
+            {
+                BufferBarrier barrier;
+                barrier.buffer = buffer;
+                barrier.stateBefore = buffer->handoffState;
+                barrier.stateAfter = buffer->descRef.initialState;
+                m_BufferBarriers.push_back(barrier);
+            }
+
+            buffer->handoffState = ResourceStates::Unknown;
+        }
+        m_DisplacedBuffers.clear();
+
+        return !m_TextureBarriers.empty() || !m_BufferBarriers.empty();
+    }
+
+    void StateHandoffResolver::setTextureHandoffState(TextureStateExtension* texture, ResourceStates state)
+    {
+        if (!texture->descRef.keepInitialState)
+        {
+            texture->handoffState = state;
+            return;
+        }
+
+        if (state == ResourceStates::Unknown || state == texture->descRef.initialState)
+        {
+            // Unknown handoff state means "in the initial state" for these textures
+            texture->handoffState = ResourceStates::Unknown;
+            return;
+        }
+
+        if (texture->handoffState == ResourceStates::Unknown)
+            m_DisplacedTextures.push_back(texture);
+
+        texture->handoffState = state;
+    }
+
+    void StateHandoffResolver::setBufferHandoffState(BufferStateExtension* buffer, ResourceStates state)
+    {
+        if (!buffer->descRef.keepInitialState)
+        {
+            buffer->handoffState = state;
+            return;
+        }
+
+        if (state == ResourceStates::Unknown || state == buffer->descRef.initialState)
+        {
+            buffer->handoffState = ResourceStates::Unknown;
+            return;
+        }
+
+        if (buffer->handoffState == ResourceStates::Unknown)
+            m_DisplacedBuffers.push_back(buffer);
+
+        buffer->handoffState = state;
+    }
 } // namespace nvrhi
\ No newline at end of file
@@ -25,17 +25,31 @@
 #include <nvrhi/nvrhi.h>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace nvrhi
 {
+    // Dense indices identifying the live resources, used by the state trackers to find their tracking slots
+    // without hashing. The indices are recycled when resources are destroyed, so they stay compact.
+    uint32_t allocateStateTrackerIndex();
+    void releaseStateTrackerIndex(uint32_t index);
+
     struct BufferStateExtension
     {
         const BufferDesc& descRef;
         ResourceStates permanentState = ResourceStates::Unknown;
+        // State of the buffer after the command lists submitted so far, maintained by StateHandoffResolver.
+        // Unknown for keepInitialState buffers means that the buffer is in its initial state.
+        ResourceStates handoffState = ResourceStates::Unknown;
+        const uint32_t trackerIndex;
 
         explicit BufferStateExtension(const BufferDesc& desc)
             : descRef(desc)
+            , trackerIndex(allocateStateTrackerIndex())
         { }
+
+        BufferStateExtension(const BufferStateExtension&) = delete;
+        ~BufferStateExtension() { releaseStateTrackerIndex(trackerIndex); }
     };
 
     struct TextureStateExtension
@@ -44,35 +58,67 @@ namespace nvrhi
         ResourceStates permanentState = ResourceStates::Unknown;
         bool stateInitialized = false;
         bool isSamplerFeedback = false;
+        // State of the texture after the command lists submitted so far, see BufferStateExtension::handoffState
+        ResourceStates handoffState = ResourceStates::Unknown;
+        const uint32_t trackerIndex;
 
         explicit TextureStateExtension(const TextureDesc& desc)
             : descRef(desc)
+            , trackerIndex(allocateStateTrackerIndex())
         { }
+
+        TextureStateExtension(const TextureStateExtension&) = delete;
+        ~TextureStateExtension() { releaseStateTrackerIndex(trackerIndex); }
     };
 
     struct TextureState
     {
         std::vector<ResourceStates> subresourceStates;
         ResourceStates state = ResourceStates::Unknown;
+        // State handoff mode: the state required by the first use of the texture, and whether it's still unused
+        ResourceStates entryState = ResourceStates::Unknown;
+        bool entryStatePending = false;
+        // The state before a split transition that has begun but not ended yet, or Unknown.
+        // While a split transition is in progress, 'state' is the target state.
+        ResourceStates splitStateBefore = ResourceStates::Unknown;
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
         bool permanentTransition = false;
+        // Set when the texture has been activated by an aliasing barrier: its contents are undefined,
+        // and transitions from the Unknown state are allowed until the entire texture is in a known state.
+        bool contentsDiscarded = false;
     };
 
     struct BufferState
     {
         ResourceStates state = ResourceStates::Unknown;
+        ResourceStates entryState = ResourceStates::Unknown;
+        bool entryStatePending = false;
+        ResourceStates splitStateBefore = ResourceStates::Unknown;
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
         bool permanentTransition = false;
     };
 
+    // Split transitions are issued as two barriers with the same states: Begin, and then End before the next use
+    enum class SplitBarrier : uint8_t
+    {
+        None,
+        Begin,
+        End
+    };
+
+    // Describes a transition of a rectangular range of subresources, or of the entire texture.
+    // The range is only valid when entireTexture is false.
     struct TextureBarrier
     {
         TextureStateExtension* texture = nullptr;
         MipLevel mipLevel = 0;
+        MipLevel numMipLevels = 1;
         ArraySlice arraySlice = 0;
+        ArraySlice numArraySlices = 1;
         bool entireTexture = false;
+        SplitBarrier split = SplitBarrier::None;
         ResourceStates stateBefore = ResourceStates::Unknown;
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
@@ -80,6 +126,7 @@ namespace nvrhi
     struct BufferBarrier
     {
         BufferStateExtension* buffer = nullptr;
+        SplitBarrier split = SplitBarrier::None;
         ResourceStates stateBefore = ResourceStates::Unknown;
         ResourceStates stateAfter = ResourceStates::Unknown;
     };
@@ -91,6 +138,15 @@ namespace nvrhi
             : m_MessageCallback(messageCallback)
         { }
 
+        // In state handoff mode, resources that are not explicitly tracked start in an entry state that is
+        // resolved at submission, see CommandListParameters::enableStateHandoff
+        void setEnableStateHandoff(bool enable) { m_EnableStateHandoff = enable; }
+        [[nodiscard]] bool isStateHandoffEnabled() const { return m_EnableStateHandoff; }
+
+        // Reusable command lists keep their tracked states after submission, so that every execution can be
+        // resolved against them; they are reset with resetTrackedStates when the list is recorded again.
+        void setKeepStatesAfterSubmission(bool enable) { m_KeepStatesAfterSubmission = enable; }
+
         // ICommandList-like interface
 
         void setEnableUavBarriersForTexture(TextureStateExtension* texture, bool enableBarriers);
@@ -102,6 +158,13 @@ namespace nvrhi
         void setPermanentTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates stateBits);
         void setPermanentBufferState(BufferStateExtension* buffer, ResourceStates stateBits);
 
+        void beginTextureStateTransition(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates stateBits);
+        void beginBufferStateTransition(BufferStateExtension* buffer, ResourceStates stateBits);
+
+        // Marks the texture contents as undefined, so that its next transition is done from the Unknown state.
+        // Used for textures that become active after an aliasing barrier.
+        void discardTextureContents(TextureStateExtension* texture);
+
         ResourceStates getTextureSubresourceState(TextureStateExtension* texture, ArraySlice arraySlice, MipLevel mipLevel);
         ResourceStates getBufferState(BufferStateExtension* buffer);
 
@@ -110,19 +173,59 @@ namespace nvrhi
         void requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state);
         void requireBufferState(BufferStateExtension* buffer, ResourceStates state);
 
+        // Completes the split transitions that are still in progress, must be called before closing the command list
+        void endSplitTransitions();
         void keepBufferInitialStates();
         void keepTextureInitialStates();
         void commandListSubmitted();
+        void resetTrackedStates();
 
         [[nodiscard]] const std::vector<TextureBarrier>& getTextureBarriers() const { return m_TextureBarriers; }
         [[nodiscard]] const std::vector<BufferBarrier>& getBufferBarriers() const { return m_BufferBarriers; }
         void clearBarriers() { m_TextureBarriers.clear(); m_BufferBarriers.clear(); }
+        void addBarriers(const std::vector<TextureBarrier>& textureBarriers, const std::vector<BufferBarrier>& bufferBarriers);
 
     private:
+        friend class StateHandoffResolver;
+
         IMessageCallback* m_MessageCallback;
+        bool m_EnableStateHandoff = false;
+        bool m_KeepStatesAfterSubmission = false;
 
-        std::unordered_map<TextureStateExtension*, std::unique_ptr<TextureState>> m_TextureStates;
-        std::unordered_map<BufferStateExtension*, std::unique_ptr<BufferState>> m_BufferStates;
+        // Resources tracked since the last commandListSubmitted(), with their states.
+        // The state objects are pooled and reused across command list instances.
+        template<typename Extension, typename State>
+        struct TrackedResource
+        {
+            Extension* resource = nullptr;
+            std::unique_ptr<State> state;
+        };
+
+        // Maps a resource's trackerIndex to its position in the tracked resource array.
+        // Slots with a generation other than m_Generation are stale, which makes resetting them free.
+        struct TrackerSlot
+        {
+            uint32_t generation = 0;
+            uint32_t index = 0;
+        };
+
+        std::vector<TrackedResource<TextureStateExtension, TextureState>> m_TextureStates;
+        std::vector<TrackedResource<BufferStateExtension, BufferState>> m_BufferStates;
+        size_t m_NumTextureStates = 0;
+        size_t m_NumBufferStates = 0;
+        std::vector<TrackerSlot> m_TextureSlots;
+        std::vector<TrackerSlot> m_BufferSlots;
+        uint32_t m_Generation = 1;
+
+        // Scratch storage for requireTextureState, members to avoid re-allocations
+        struct SubresourceRun
+        {
+            MipLevel mipLevel = 0;
+            MipLevel numMipLevels = 0;
+            ResourceStates stateBefore = ResourceStates::Unknown;
+        };
+        std::vector<SubresourceRun> m_SubresourceRuns;
+        std::vector<size_t> m_PreviousSliceBarriers;
 
         // Deferred transitions of textures and buffers to permanent states.
         // They are executed only when the command list is executed, not when the app calls setPermanentTextureState or setPermanentBufferState.
@@ -134,6 +237,75 @@ namespace nvrhi
 
         TextureState* getTextureStateTracking(TextureStateExtension* texture, bool allowCreate);
         BufferState* getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate);
+
+        void endTextureSplitTransition(TextureStateExtension* texture, TextureState* tracking);
+        void endBufferSplitTransition(BufferStateExtension* buffer, BufferState* tracking);
+    };
+
+    // Resource states required by a bundle, captured while the bundle is recorded instead of placing barriers,
+    // which bundles cannot contain. The command list that executes the bundle applies them through its own tracker.
+    class BundleStateRequirements
+    {
+    public:
+        // Return false if the resource is already required in a different state by the same bundle,
+        // which cannot be satisfied without a barrier between the draws.
+        bool requireTextureState(TextureStateExtension* texture, TextureSubresourceSet subresources, ResourceStates state);
+        bool requireBufferState(BufferStateExtension* buffer, ResourceStates state);
+
+        void apply(CommandListResourceStateTracker& tracker) const;
+        void clear();
+
+    private:
+        struct TextureRequirement
+        {
+            TextureStateExtension* texture = nullptr;
+            TextureSubresourceSet subresources;
+            ResourceStates state = ResourceStates::Unknown;
+        };
+
+        std::vector<TextureRequirement> m_Textures;
+        std::vector<std::pair<BufferStateExtension*, ResourceStates>> m_Buffers;
+
+        // Positions of the requirements in the arrays above for each resource, to skip the repeated ones
+        std::unordered_map<TextureStateExtension*, std::vector<size_t>> m_TextureIndices;
+        std::unordered_map<BufferStateExtension*, size_t> m_BufferIndices;
+    };
+
+    // Computes the transitions between command lists at submission time for the state handoff mode.
+    // The device passes all command lists through resolveCommandList in submission order, and executes
+    // the resulting barriers before each list. Not thread-safe, one resolver is used per device.
+    class StateHandoffResolver
+    {
+    public:
+        explicit StateHandoffResolver(IMessageCallback* messageCallback)
+            : m_MessageCallback(messageCallback)
+        { }
+
+        // Produces the barriers from the states that the previous command lists left the resources in to
+        // the entry states of this command list, and advances the resource states to its final states.
+        // Returns true if any barriers were produced.
+        bool resolveCommandList(const CommandListResourceStateTracker& commandList);
+
+        // Produces the barriers returning the keepInitialState resources displaced by handoff command lists
+        // to their initial states. Returns true if any barriers were produced.
+        bool restoreInitialStates();
+
+        [[nodiscard]] const std::vector<TextureBarrier>& getTextureBarriers() const { return m_TextureBarriers; }
+        [[nodiscard]] const std::vector<BufferBarrier>& getBufferBarriers() const { return m_BufferBarriers; }
+        void clearBarriers() { m_TextureBarriers.clear(); m_BufferBarriers.clear(); }
+
+    private:
+        IMessageCallback* m_MessageCallback;
+
+        // keepInitialState resources that are currently not in their initial states
+        std::vector<TextureStateExtension*> m_DisplacedTextures;
+        std::vector<BufferStateExtension*> m_DisplacedBuffers;
+
+        std::vector<TextureBarrier> m_TextureBarriers;
+        std::vector<BufferBarrier> m_BufferBarriers;
+
+        void setTextureHandoffState(TextureStateExtension* texture, ResourceStates state);
+        void setBufferHandoffState(BufferStateExtension* buffer, ResourceStates state);
     };
 
     bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback);
@@ -0,0 +1,207 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// The implementation of nvrhi::StaticCommandList for the backend selected with NVRHI_STATIC_DISPATCH.
+// This file is built into the target of that backend, see CMakeLists.txt.
+
+#include <nvrhi/static-dispatch.h>
+
+#if NVRHI_STATIC_DISPATCH_VULKAN
+#include "../vulkan/vulkan-backend.h"
+#elif NVRHI_STATIC_DISPATCH_D3D12
+#include "../d3d12/d3d12-backend.h"
+#elif NVRHI_STATIC_DISPATCH_D3D11
+#include "../d3d11/d3d11-backend.h"
+#elif NVRHI_STATIC_DISPATCH_NULL
+#include "../null/null-backend.h"
+#else
+#error "NVRHI_STATIC_DISPATCH requires one of the NVRHI_STATIC_DISPATCH_<backend> macros"
+#endif
+
+namespace nvrhi
+{
+    namespace
+    {
+#if NVRHI_STATIC_DISPATCH_VULKAN
+        typedef vulkan::CommandList StaticImplementation;
+#elif NVRHI_STATIC_DISPATCH_D3D12
+        typedef d3d12::CommandList StaticImplementation;
+#elif NVRHI_STATIC_DISPATCH_D3D11
+        typedef d3d11::CommandList StaticImplementation;
+#elif NVRHI_STATIC_DISPATCH_NULL
+        typedef null::CommandList StaticImplementation;
+#endif
+
+        // The calls below only devirtualize if the implementation cannot be derived from
+        static_assert(std::is_final_v<StaticImplementation>, "The static dispatch command list must be final");
+
+        StaticImplementation* get(void* implementation)
+        {
+            return static_cast<StaticImplementation*>(implementation);
+        }
+    }
+
+    StaticCommandList::StaticCommandList(ICommandList* commandList)
+    {
+        if (auto* implementation = dynamic_cast<StaticImplementation*>(commandList))
+        {
+            m_Interface = commandList;
+            m_Implementation = implementation;
+        }
+    }
+
+    void StaticCommandList::open() const
+    {
+        get(m_Implementation)->open();
+    }
+
+    void StaticCommandList::close() const
+    {
+        get(m_Implementation)->close();
+    }
+
+    void StaticCommandList::clearState() const
+    {
+        get(m_Implementation)->clearState();
+    }
+
+    void StaticCommandList::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) const
+    {
+        get(m_Implementation)->writeBuffer(b, data, dataSize, destOffsetBytes);
+    }
+
+    void StaticCommandList::setPushConstants(const void* data, size_t byteSize) const
+    {
+        get(m_Implementation)->setPushConstants(data, byteSize);
+    }
+
+    void StaticCommandList::setGraphicsState(const GraphicsState& state) const
+    {
+        get(m_Implementation)->setGraphicsState(state);
+    }
+
+    void StaticCommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) const
+    {
+        get(m_Implementation)->setGraphicsBindingSet(slot, bindingSet);
+    }
+
+    void StaticCommandList::setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) const
+    {
+        get(m_Implementation)->setVertexBuffers(vertexBuffers, numVertexBuffers);
+    }
+
+    void StaticCommandList::setIndexBuffer(const IndexBufferBinding& indexBuffer) const
+    {
+        get(m_Implementation)->setIndexBuffer(indexBuffer);
+    }
+
+    void StaticCommandList::setViewportState(const ViewportState& viewport) const
+    {
+        get(m_Implementation)->setViewportState(viewport);
+    }
+
+    void StaticCommandList::draw(const DrawArguments& args) const
+    {
+        get(m_Implementation)->draw(args);
+    }
+
+    void StaticCommandList::drawIndexed(const DrawArguments& args) const
+    {
+        get(m_Implementation)->drawIndexed(args);
+    }
+
+    void StaticCommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount) const
+    {
+        get(m_Implementation)->drawIndirect(offsetBytes, drawCount);
+    }
+
+    void StaticCommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) const
+    {
+        get(m_Implementation)->drawIndexedIndirect(offsetBytes, drawCount);
+    }
+
+    void StaticCommandList::setComputeState(const ComputeState& state) const
+    {
+        get(m_Implementation)->setComputeState(state);
+    }
+
+    void StaticCommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) const
+    {
+        get(m_Implementation)->dispatch(groupsX, groupsY, groupsZ);
+    }
+
+    void StaticCommandList::dispatchIndirect(uint32_t offsetBytes) const
+    {
+        get(m_Implementation)->dispatchIndirect(offsetBytes);
+    }
+
+    void StaticCommandList::setMeshletState(const MeshletState& state) const
+    {
+        get(m_Implementation)->setMeshletState(state);
+    }
+
+    void StaticCommandList::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) const
+    {
+        get(m_Implementation)->dispatchMesh(groupsX, groupsY, groupsZ);
+    }
+
+    void StaticCommandList::setRayTracingState(const rt::State& state) const
+    {
+        get(m_Implementation)->setRayTracingState(state);
+    }
+
+    void StaticCommandList::dispatchRays(const rt::DispatchRaysArguments& args) const
+    {
+        get(m_Implementation)->dispatchRays(args);
+    }
+
+    void StaticCommandList::beginMarker(const char* name) const
+    {
+        get(m_Implementation)->beginMarker(name);
+    }
+
+    void StaticCommandList::endMarker() const
+    {
+        get(m_Implementation)->endMarker();
+    }
+
+    void StaticCommandList::setResourceStatesForBindingSet(IBindingSet* bindingSet) const
+    {
+        get(m_Implementation)->setResourceStatesForBindingSet(bindingSet);
+    }
+
+    void StaticCommandList::setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) const
+    {
+        get(m_Implementation)->setTextureState(texture, subresources, stateBits);
+    }
+
+    void StaticCommandList::setBufferState(IBuffer* buffer, ResourceStates stateBits) const
+    {
+        get(m_Implementation)->setBufferState(buffer, stateBits);
+    }
+
+    void StaticCommandList::commitBarriers() const
+    {
+        get(m_Implementation)->commitBarriers();
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,300 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "storage-queue.h"
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+
+namespace nvrhi
+{
+    StorageTextureLayout getStorageTextureLayout(const TextureDesc& desc, uint32_t mipLevel)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        StorageTextureLayout layout;
+        layout.rowSize = uint64_t((width + formatInfo.blockSize - 1) / formatInfo.blockSize) * formatInfo.bytesPerBlock;
+        layout.rowPitch = align(layout.rowSize, uint64_t(c_StorageTextureRowPitchAlignment));
+        layout.numRows = (height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        layout.depth = depth;
+        layout.size = layout.rowPitch * (uint64_t(layout.numRows) * depth - 1) + layout.rowSize;
+        return layout;
+    }
+
+    bool StorageFile::read(uint64_t offset, void* dest, uint64_t size)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Stream.clear();
+        m_Stream.seekg(std::streamoff(offset));
+        m_Stream.read(static_cast<char*>(dest), std::streamsize(size));
+
+        return uint64_t(m_Stream.gcount()) == size;
+    }
+
+    StorageQueue::StorageQueue(IDevice* device, const StorageQueueDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+    { }
+
+    void StorageQueue::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    StorageFileHandle StorageQueue::openFile(const char* path)
+    {
+        std::ifstream stream(path, std::ios::binary | std::ios::ate);
+        if (!stream.is_open())
+        {
+            std::stringstream ss;
+            ss << "openFile: cannot open file " << path;
+            error(ss.str());
+            return nullptr;
+        }
+
+        const uint64_t size = uint64_t(stream.tellg());
+
+        return StorageFileHandle::Create(new StorageFile(std::move(stream), size));
+    }
+
+    uint64_t StorageQueue::getDestinationSize(const StorageRequest& request)
+    {
+        return request.compression == StorageCompression::None ? request.sourceSize : request.uncompressedSize;
+    }
+
+    void StorageQueue::enqueueRequest(const StorageRequest& request)
+    {
+        if (!request.file)
+        {
+            error("enqueueRequest: file is NULL");
+            return;
+        }
+
+        if (!request.destBuffer == !request.destTexture)
+        {
+            error("enqueueRequest: exactly one of destBuffer and destTexture must be set");
+            return;
+        }
+
+        if (request.sourceSize == 0 || request.fileOffset + request.sourceSize > request.file->getSize())
+        {
+            std::stringstream ss;
+            ss << "enqueueRequest: file range at offset " << request.fileOffset << " with size " << request.sourceSize
+                << " is empty or past the end of the file, which is " << request.file->getSize() << " bytes long";
+            error(ss.str());
+            return;
+        }
+
+        if (!isCompressionSupported(request.compression))
+        {
+            error("enqueueRequest: compressed requests require Feature::GpuDecompression");
+            return;
+        }
+
+        const uint64_t destSize = getDestinationSize(request);
+
+        if (destSize == 0)
+        {
+            error("enqueueRequest: uncompressedSize must be set for compressed requests");
+            return;
+        }
+
+        if (destSize > m_Desc.stagingSize)
+        {
+            std::stringstream ss;
+            ss << "enqueueRequest: request of " << destSize << " bytes doesn't fit into the staging memory of "
+                << m_Desc.stagingSize << " bytes, see StorageQueueDesc::stagingSize";
+            error(ss.str());
+            return;
+        }
+
+        bool keepInitialState;
+        ResourceStates initialState;
+        std::string debugName;
+
+        if (request.destBuffer)
+        {
+            const BufferDesc& desc = request.destBuffer->getDesc();
+            keepInitialState = desc.keepInitialState;
+            initialState = desc.initialState;
+            debugName = utils::DebugNameToString(desc.debugName);
+
+            if (request.destOffset + destSize > desc.byteSize)
+            {
+                std::stringstream ss;
+                ss << "enqueueRequest: " << destSize << " bytes at offset " << request.destOffset
+                    << " don't fit into buffer " << debugName << " with size " << desc.byteSize;
+                error(ss.str());
+                return;
+            }
+        }
+        else
+        {
+            const TextureDesc& desc = request.destTexture->getDesc();
+            keepInitialState = desc.keepInitialState;
+            initialState = desc.initialState;
+            debugName = utils::DebugNameToString(desc.debugName);
+
+            if (request.mipLevel >= desc.mipLevels || request.arraySlice >= desc.arraySize)
+            {
+                std::stringstream ss;
+                ss << "enqueueRequest: array slice " << request.arraySlice << " mip level " << request.mipLevel
+                    << " is out of range for texture " << debugName;
+                error(ss.str());
+                return;
+            }
+
+            const FormatInfo& formatInfo = getFormatInfo(desc.format);
+            if (c_StorageTextureRowPitchAlignment % formatInfo.bytesPerBlock != 0)
+            {
+                std::stringstream ss;
+                ss << "enqueueRequest: format " << formatInfo.name << " of texture " << debugName
+                    << " cannot be loaded, its block size doesn't divide the row pitch alignment";
+                error(ss.str());
+                return;
+            }
+
+            const StorageTextureLayout layout = getStorageTextureLayout(desc, request.mipLevel);
+            if (destSize < layout.size)
+            {
+                std::stringstream ss;
+                ss << "enqueueRequest: array slice " << request.arraySlice << " mip level " << request.mipLevel
+                    << " of texture " << debugName << " needs " << layout.size << " bytes of data, but the request has " << destSize;
+                error(ss.str());
+                return;
+            }
+        }
+
+        if (!keepInitialState)
+        {
+            std::stringstream ss;
+            ss << "enqueueRequest: the destination " << debugName << " must be created with keepInitialState";
+            error(ss.str());
+            return;
+        }
+
+        if (m_Desc.queue == CommandQueue::Copy && initialState != ResourceStates::Common)
+        {
+            std::stringstream ss;
+            ss << "enqueueRequest: the destination " << debugName
+                << " has an initial state other than Common, which cannot be restored on the copy queue";
+            error(ss.str());
+            return;
+        }
+
+        PendingRequest pending;
+        pending.request = request;
+        pending.file = request.file;
+        pending.destBuffer = request.destBuffer;
+        pending.destTexture = request.destTexture;
+        m_PendingRequests.push_back(std::move(pending));
+    }
+
+    uint64_t StorageQueue::submit(IEventQuery* completion)
+    {
+        uint64_t instance = 0;
+
+        if (!m_PendingRequests.empty())
+        {
+            if (!m_CommandList)
+                m_CommandList = m_Device->createCommandList(CommandListParameters().setQueueType(m_Desc.queue));
+
+            m_CommandList->open();
+
+            for (const PendingRequest& pending : m_PendingRequests)
+            {
+                const StorageRequest& request = pending.request;
+
+                m_ReadBuffer.resize(request.sourceSize);
+
+                if (!checked_cast<StorageFile*>(pending.file.Get())->read(request.fileOffset, m_ReadBuffer.data(), request.sourceSize))
+                {
+                    std::stringstream ss;
+                    ss << "submit: cannot read " << request.sourceSize << " bytes at offset " << request.fileOffset << " of a file";
+                    error(ss.str());
+                    continue;
+                }
+
+                if (request.compression == StorageCompression::None)
+                    recordWrite(m_CommandList, request, m_ReadBuffer.data());
+                else
+                    recordDecompression(m_CommandList, request, m_ReadBuffer.data());
+            }
+
+            // Closing returns the destinations to their initial states
+            m_CommandList->close();
+
+            instance = m_Device->executeCommandList(m_CommandList, m_Desc.queue);
+
+            m_PendingRequests.clear();
+        }
+
+        if (completion)
+            m_Device->setEventQuery(completion, m_Desc.queue);
+
+        return instance;
+    }
+
+    void StorageQueue::recordWrite(ICommandList* commandList, const StorageRequest& request, const uint8_t* data) const
+    {
+        if (request.destBuffer)
+        {
+            commandList->writeBuffer(request.destBuffer, data, request.sourceSize, request.destOffset);
+            return;
+        }
+
+        const StorageTextureLayout layout = getStorageTextureLayout(request.destTexture->getDesc(), request.mipLevel);
+
+        size_t rowPitch = 0;
+        size_t depthPitch = 0;
+        uint8_t* mappedPtr = static_cast<uint8_t*>(commandList->beginTextureWrite(request.destTexture, request.arraySlice, request.mipLevel, &rowPitch, &depthPitch));
+        if (!mappedPtr)
+            return;
+
+        for (uint32_t slice = 0; slice < layout.depth; slice++)
+        {
+            for (uint32_t row = 0; row < layout.numRows; row++)
+            {
+                const uint64_t sourceRow = uint64_t(slice) * layout.numRows + row;
+                memcpy(mappedPtr + depthPitch * slice + rowPitch * row, data + layout.rowPitch * sourceRow, layout.rowSize);
+            }
+        }
+
+        commandList->endTextureWrite(request.destTexture, request.arraySlice, request.mipLevel);
+    }
+
+    void StorageQueue::recordDecompression(ICommandList*, const StorageRequest&, const void*)
+    {
+        // Compressed requests are rejected by enqueueRequest unless a derived queue supports them
+        assert(!"recordDecompression is not implemented");  // NOLINT(clang-diagnostic-string-conversion)
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,108 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/resource.h>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nvrhi
+{
+    // Layout of the texture data of a storage request, see StorageRequest
+    struct StorageTextureLayout
+    {
+        uint64_t rowPitch = 0;      // aligned to c_StorageTextureRowPitchAlignment
+        uint64_t rowSize = 0;       // bytes in a row of blocks without the padding
+        uint32_t numRows = 0;       // rows of blocks in a depth slice
+        uint32_t depth = 0;
+        uint64_t size = 0;          // without the padding of the last row
+    };
+
+    StorageTextureLayout getStorageTextureLayout(const TextureDesc& desc, uint32_t mipLevel);
+
+    // A file read with the standard library by the storage queues that read on the CPU
+    class StorageFile : public RefCounter<IStorageFile>
+    {
+    public:
+        StorageFile(std::ifstream&& stream, uint64_t size)
+            : m_Stream(std::move(stream))
+            , m_Size(size)
+        { }
+
+        [[nodiscard]] uint64_t getSize() const override { return m_Size; }
+
+        bool read(uint64_t offset, void* dest, uint64_t size);
+
+    private:
+        std::ifstream m_Stream;
+        uint64_t m_Size;
+        std::mutex m_Mutex;
+    };
+
+    // Storage queue that reads the files in submit and writes the data into the destinations with a command list.
+    // Backends can derive from it to decompress the data on the GPU, or to replace the submission altogether.
+    class StorageQueue : public RefCounter<IStorageQueue>
+    {
+    public:
+        StorageQueue(IDevice* device, const StorageQueueDesc& desc);
+
+        [[nodiscard]] const StorageQueueDesc& getDesc() const override { return m_Desc; }
+        StorageFileHandle openFile(const char* path) override;
+        void enqueueRequest(const StorageRequest& request) override;
+        uint64_t submit(IEventQuery* completion) override;
+
+    protected:
+        struct PendingRequest
+        {
+            StorageRequest request;
+
+            // Keep the file and the destination alive until the request is submitted
+            StorageFileHandle file;
+            BufferHandle destBuffer;
+            TextureHandle destTexture;
+        };
+
+        IDevice* m_Device;
+        StorageQueueDesc m_Desc;
+        std::vector<PendingRequest> m_PendingRequests;
+
+        void error(const std::string& message) const;
+
+        // Returns the size of the data that a validated request writes into its destination
+        static uint64_t getDestinationSize(const StorageRequest& request);
+
+        [[nodiscard]] virtual bool isCompressionSupported(StorageCompression compression) const { return compression == StorageCompression::None; }
+
+        // Records the decompression of a request into its destination, with the same barriers as writeBuffer or writeTexture.
+        virtual void recordDecompression(ICommandList* commandList, const StorageRequest& request, const void* compressedData);
+
+    private:
+        CommandListHandle m_CommandList;
+        std::vector<uint8_t> m_ReadBuffer;
+
+        void recordWrite(ICommandList* commandList, const StorageRequest& request, const uint8_t* data) const;
+    };
+}
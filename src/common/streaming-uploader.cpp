@@ -0,0 +1,505 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/streaming-uploader.h>
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace nvrhi
+{
+    class StreamingUploader : public RefCounter<IStreamingUploader>
+    {
+    public:
+        StreamingUploader(IDevice* device, const StreamingUploaderDesc& desc, CommandQueue queue);
+        ~StreamingUploader() override;
+
+        StreamingUploadId enqueueTextureUpload(ITexture* texture, TextureSubresourceSet subresources, const void* data,
+            StreamingUploadCallback callback, StreamingPriority priority) override;
+        StreamingUploadId enqueueBufferUpload(IBuffer* buffer, const void* data, uint64_t dataSize, uint64_t destOffsetBytes,
+            StreamingUploadCallback callback, StreamingPriority priority) override;
+        void update() override;
+        void flush() override;
+        [[nodiscard]] size_t getNumPendingUploads() override;
+        [[nodiscard]] const StreamingUploaderDesc& getDesc() const override { return m_Desc; }
+
+    private:
+        struct Request
+        {
+            StreamingUploadId id = c_InvalidStreamingUpload;
+            TextureHandle texture;
+            TextureSubresourceSet subresources;
+            BufferHandle buffer;
+            uint64_t destOffsetBytes = 0;
+            const uint8_t* data = nullptr;
+            uint64_t dataSize = 0;
+            StreamingUploadCallback callback;
+        };
+
+        struct Batch
+        {
+            CommandListHandle commandList;
+            std::vector<Request> requests;
+        };
+
+        IDevice* m_Device;
+        StreamingUploaderDesc m_Desc;
+        CommandQueue m_Queue;
+
+        std::array<std::deque<Request>, size_t(StreamingPriority::Count)> m_PendingRequests;
+        size_t m_NumPendingRequests = 0;
+        StreamingUploadId m_LastUploadId = c_InvalidStreamingUpload;
+
+        std::vector<CommandListHandle> m_FreeCommandLists;
+        uint32_t m_NumCommandLists = 0;
+        std::vector<Batch> m_RecordedBatches;
+        uint32_t m_NumBatchesRecording = 0;
+
+        uint64_t m_FrameBytes = 0; // recorded since the last update
+        bool m_IgnoreBudget = false; // set during flush
+
+        std::mutex m_Mutex;
+        std::condition_variable m_WorkerCondition; // the worker may have something to record
+        std::condition_variable m_BatchRecordedCondition;
+        std::thread m_Worker;
+        bool m_StopWorker = false;
+
+        void error(const std::string& message) const;
+
+        const Request* peekRequestLocked() const;
+        bool fitsLocked(const Request& request, uint64_t batchBytes) const;
+        bool canRecordLocked() const;
+        bool takeRequestLocked(uint64_t batchBytes, Request& outRequest);
+        void recordBatch(std::unique_lock<std::mutex>& lock);
+        void recordRequest(ICommandList* commandList, const Request& request) const;
+        void submitRecordedBatches();
+        void workerThread();
+    };
+
+    // Computes the tightly packed layout of one subresource as used by the upload data
+    static uint64_t getSubresourceUploadLayout(const TextureDesc& desc, MipLevel mipLevel, size_t& outRowPitch, size_t& outDepthPitch)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        const uint32_t widthInBlocks = (width + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const uint32_t heightInBlocks = (height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        outRowPitch = size_t(widthInBlocks) * formatInfo.bytesPerBlock;
+        outDepthPitch = outRowPitch * heightInBlocks;
+
+        return uint64_t(outDepthPitch) * depth;
+    }
+
+    StreamingUploader::StreamingUploader(IDevice* device, const StreamingUploaderDesc& desc, CommandQueue queue)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_Queue(queue)
+    {
+        m_Desc.maxRecordedBatches = std::max(m_Desc.maxRecordedBatches, 1u);
+
+        if (m_Desc.useBackgroundThread)
+            m_Worker = std::thread(&StreamingUploader::workerThread, this);
+    }
+
+    StreamingUploader::~StreamingUploader()
+    {
+        if (m_Worker.joinable())
+        {
+            {
+                std::lock_guard lockGuard(m_Mutex);
+                m_StopWorker = true;
+            }
+
+            m_WorkerCondition.notify_one();
+            m_Worker.join();
+        }
+    }
+
+    void StreamingUploader::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    StreamingUploadId StreamingUploader::enqueueTextureUpload(ITexture* texture, TextureSubresourceSet subresources, const void* data,
+        StreamingUploadCallback callback, StreamingPriority priority)
+    {
+        if (!texture || !data)
+        {
+            error("enqueueTextureUpload: texture and data must not be NULL");
+            return c_InvalidStreamingUpload;
+        }
+
+        const TextureDesc& desc = texture->getDesc();
+
+        if (m_Queue == CommandQueue::Copy && desc.keepInitialState && desc.initialState != ResourceStates::Common)
+        {
+            std::stringstream ss;
+            ss << "enqueueTextureUpload: texture " << utils::DebugNameToString(desc.debugName)
+                << " has keepInitialState and an initial state other than Common, which cannot be restored on the copy queue";
+            error(ss.str());
+            return c_InvalidStreamingUpload;
+        }
+
+        Request request;
+        request.texture = texture;
+        request.subresources = subresources.resolve(desc, false);
+        request.data = static_cast<const uint8_t*>(data);
+        request.callback = std::move(callback);
+
+        for (MipLevel mipLevel = request.subresources.baseMipLevel; mipLevel < request.subresources.baseMipLevel + request.subresources.numMipLevels; mipLevel++)
+        {
+            size_t rowPitch, depthPitch;
+            request.dataSize += getSubresourceUploadLayout(desc, mipLevel, rowPitch, depthPitch) * request.subresources.numArraySlices;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        request.id = ++m_LastUploadId;
+        const StreamingUploadId id = request.id;
+
+        m_PendingRequests[size_t(priority)].push_back(std::move(request));
+        ++m_NumPendingRequests;
+
+        m_WorkerCondition.notify_one();
+
+        return id;
+    }
+
+    StreamingUploadId StreamingUploader::enqueueBufferUpload(IBuffer* buffer, const void* data, uint64_t dataSize, uint64_t destOffsetBytes,
+        StreamingUploadCallback callback, StreamingPriority priority)
+    {
+        if (!buffer || !data)
+        {
+            error("enqueueBufferUpload: buffer and data must not be NULL");
+            return c_InvalidStreamingUpload;
+        }
+
+        const BufferDesc& desc = buffer->getDesc();
+
+        if (destOffsetBytes + dataSize > desc.byteSize)
+        {
+            std::stringstream ss;
+            ss << "enqueueBufferUpload: the range " << destOffsetBytes << " to " << (destOffsetBytes + dataSize)
+                << " exceeds the size of buffer " << utils::DebugNameToString(desc.debugName) << " (" << desc.byteSize << " bytes)";
+            error(ss.str());
+            return c_InvalidStreamingUpload;
+        }
+
+        if (m_Queue == CommandQueue::Copy && desc.keepInitialState && desc.initialState != ResourceStates::Common)
+        {
+            std::stringstream ss;
+            ss << "enqueueBufferUpload: buffer " << utils::DebugNameToString(desc.debugName)
+                << " has keepInitialState and an initial state other than Common, which cannot be restored on the copy queue";
+            error(ss.str());
+            return c_InvalidStreamingUpload;
+        }
+
+        Request request;
+        request.buffer = buffer;
+        request.destOffsetBytes = destOffsetBytes;
+        request.data = static_cast<const uint8_t*>(data);
+        request.dataSize = dataSize;
+        request.callback = std::move(callback);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        request.id = ++m_LastUploadId;
+        const StreamingUploadId id = request.id;
+
+        m_PendingRequests[size_t(priority)].push_back(std::move(request));
+        ++m_NumPendingRequests;
+
+        m_WorkerCondition.notify_one();
+
+        return id;
+    }
+
+    const StreamingUploader::Request* StreamingUploader::peekRequestLocked() const
+    {
+        for (size_t priority = m_PendingRequests.size(); priority-- > 0; )
+        {
+            if (!m_PendingRequests[priority].empty())
+                return &m_PendingRequests[priority].front();
+        }
+
+        return nullptr;
+    }
+
+    bool StreamingUploader::fitsLocked(const Request& request, uint64_t batchBytes) const
+    {
+        // the first upload of a batch or a frame is always taken, so that large uploads make progress
+        if (batchBytes != 0 && m_Desc.maxBatchBytes != 0 && batchBytes + request.dataSize > m_Desc.maxBatchBytes)
+            return false;
+
+        if (!m_IgnoreBudget && m_FrameBytes != 0 && m_Desc.frameBudgetBytes != 0 && m_FrameBytes + request.dataSize > m_Desc.frameBudgetBytes)
+            return false;
+
+        return true;
+    }
+
+    bool StreamingUploader::canRecordLocked() const
+    {
+        if (m_FreeCommandLists.empty() && m_NumCommandLists >= m_Desc.maxRecordedBatches)
+            return false;
+
+        const Request* request = peekRequestLocked();
+        return request && fitsLocked(*request, 0);
+    }
+
+    bool StreamingUploader::takeRequestLocked(uint64_t batchBytes, Request& outRequest)
+    {
+        const Request* request = peekRequestLocked();
+        if (!request || !fitsLocked(*request, batchBytes))
+            return false;
+
+        for (size_t priority = m_PendingRequests.size(); priority-- > 0; )
+        {
+            if (!m_PendingRequests[priority].empty())
+            {
+                outRequest = std::move(m_PendingRequests[priority].front());
+                m_PendingRequests[priority].pop_front();
+                break;
+            }
+        }
+
+        --m_NumPendingRequests;
+        m_FrameBytes += outRequest.dataSize;
+
+        return true;
+    }
+
+    void StreamingUploader::recordRequest(ICommandList* commandList, const Request& request) const
+    {
+        if (request.buffer)
+        {
+            commandList->writeBuffer(request.buffer, request.data, request.dataSize, request.destOffsetBytes);
+            return;
+        }
+
+        const TextureDesc& desc = request.texture->getDesc();
+        const TextureSubresourceSet& subresources = request.subresources;
+        const uint8_t* data = request.data;
+
+        for (ArraySlice arraySlice = subresources.baseArraySlice; arraySlice < subresources.baseArraySlice + subresources.numArraySlices; arraySlice++)
+        {
+            for (MipLevel mipLevel = subresources.baseMipLevel; mipLevel < subresources.baseMipLevel + subresources.numMipLevels; mipLevel++)
+            {
+                size_t rowPitch, depthPitch;
+                const uint64_t size = getSubresourceUploadLayout(desc, mipLevel, rowPitch, depthPitch);
+
+                commandList->writeTexture(request.texture, arraySlice, mipLevel, data, rowPitch, depthPitch);
+                data += size;
+            }
+        }
+    }
+
+    // Called with the lock held when canRecordLocked() is true, releases it while recording
+    void StreamingUploader::recordBatch(std::unique_lock<std::mutex>& lock)
+    {
+        Batch batch;
+
+        Request request;
+        if (!takeRequestLocked(0, request))
+            return;
+
+        if (!m_FreeCommandLists.empty())
+        {
+            batch.commandList = std::move(m_FreeCommandLists.back());
+            m_FreeCommandLists.pop_back();
+        }
+        else
+        {
+            ++m_NumCommandLists;
+        }
+
+        ++m_NumBatchesRecording;
+        lock.unlock();
+
+        if (!batch.commandList)
+        {
+            // deferred on DX11, so that it can be recorded on the worker thread
+            batch.commandList = m_Device->createCommandList(CommandListParameters()
+                .setQueueType(m_Queue)
+                .setEnableImmediateExecution(false)
+                .setUploadRingSize(m_Desc.stagingRingSize));
+        }
+
+        batch.commandList->open();
+
+        if (!m_Desc.debugName.empty())
+            batch.commandList->beginMarker(m_Desc.debugName.c_str());
+
+        uint64_t batchBytes = 0;
+        bool moreRequests = true;
+        while (moreRequests)
+        {
+            recordRequest(batch.commandList, request);
+            batchBytes += request.dataSize;
+            batch.requests.push_back(std::move(request));
+
+            lock.lock();
+            moreRequests = takeRequestLocked(batchBytes, request);
+            lock.unlock();
+        }
+
+        if (!m_Desc.debugName.empty())
+            batch.commandList->endMarker();
+
+        batch.commandList->close();
+
+        lock.lock();
+        m_RecordedBatches.push_back(std::move(batch));
+        --m_NumBatchesRecording;
+        m_BatchRecordedCondition.notify_all();
+    }
+
+    void StreamingUploader::workerThread()
+    {
+        std::unique_lock lock(m_Mutex);
+
+        while (true)
+        {
+            m_WorkerCondition.wait(lock, [this]() { return m_StopWorker || canRecordLocked(); });
+
+            if (m_StopWorker)
+                break;
+
+            recordBatch(lock);
+        }
+    }
+
+    void StreamingUploader::submitRecordedBatches()
+    {
+        std::vector<Batch> batches;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            batches.swap(m_RecordedBatches);
+            m_FrameBytes = 0;
+        }
+
+        uint64_t lastInstance = 0;
+        for (const Batch& batch : batches)
+        {
+            ICommandList* commandList = batch.commandList;
+            lastInstance = m_Device->executeCommandLists(&commandList, 1, m_Queue);
+        }
+
+        if (!batches.empty() && m_Queue != m_Desc.consumerQueue)
+            m_Device->queueWaitForCommandList(m_Desc.consumerQueue, m_Queue, lastInstance);
+
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            for (Batch& batch : batches)
+                m_FreeCommandLists.push_back(std::move(batch.commandList));
+        }
+
+        m_WorkerCondition.notify_one();
+
+        for (const Batch& batch : batches)
+        {
+            for (const Request& request : batch.requests)
+            {
+                if (request.callback)
+                    request.callback(request.id);
+            }
+        }
+    }
+
+    void StreamingUploader::update()
+    {
+        if (!m_Desc.useBackgroundThread)
+        {
+            std::unique_lock lock(m_Mutex);
+
+            while (canRecordLocked())
+                recordBatch(lock);
+        }
+
+        submitRecordedBatches();
+    }
+
+    void StreamingUploader::flush()
+    {
+        bool done = false;
+        while (!done)
+        {
+            {
+                std::unique_lock lock(m_Mutex);
+                m_IgnoreBudget = true;
+
+                if (m_Desc.useBackgroundThread)
+                {
+                    // wait until the worker has recorded everything, or has no command lists left to record into
+                    m_WorkerCondition.notify_one();
+                    m_BatchRecordedCondition.wait(lock, [this]() { return m_NumBatchesRecording == 0 && !canRecordLocked(); });
+                }
+                else
+                {
+                    while (canRecordLocked())
+                        recordBatch(lock);
+                }
+
+                done = m_NumPendingRequests == 0;
+            }
+
+            submitRecordedBatches();
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+        m_IgnoreBudget = false;
+    }
+
+    size_t StreamingUploader::getNumPendingUploads()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        size_t numUploads = m_NumPendingRequests + m_NumBatchesRecording; // approximation for the batches being recorded
+        for (const Batch& batch : m_RecordedBatches)
+            numUploads += batch.requests.size();
+
+        return numUploads;
+    }
+
+    StreamingUploaderHandle createStreamingUploader(IDevice* device, const StreamingUploaderDesc& desc)
+    {
+        CommandQueue queue = desc.queue;
+        if (queue == CommandQueue::Copy && !device->queryFeatureSupport(Feature::CopyQueue))
+            queue = CommandQueue::Graphics;
+        else if (queue == CommandQueue::Compute && !device->queryFeatureSupport(Feature::ComputeQueue))
+            queue = CommandQueue::Graphics;
+
+        return StreamingUploaderHandle::Create(new StreamingUploader(device, desc, queue));
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,788 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <nvrhi/common/tiled-streaming.h>
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi
+{
+    namespace
+    {
+        struct TileHeap
+        {
+            HeapHandle heap;
+            std::vector<bool> usedTiles;
+            uint32_t numUsedTiles = 0;
+        };
+
+        enum class TileMappingState : uint8_t
+        {
+            Unmapped,
+            PendingMap,
+            Mapped,
+            PendingUnmap
+        };
+
+        struct TileEntry
+        {
+            TileAllocation allocation;
+            uint64_t lastRequestedFeedback = 0;
+            TileMappingState state = TileMappingState::Unmapped;
+        };
+
+        struct FeedbackReadback
+        {
+            BufferHandle buffer;
+            EventQueryHandle query;
+        };
+
+        // The tiles mapped into one heap by an update call
+        struct HeapMappingGroup
+        {
+            IHeap* heap = nullptr;
+            std::vector<TiledTextureCoordinate> coordinates;
+            std::vector<TiledTextureRegion> regions;
+            std::vector<uint64_t> byteOffsets;
+
+            void add(const TiledTextureCoordinate& coordinate, const TiledTextureRegion& region, uint64_t byteOffset)
+            {
+                coordinates.push_back(coordinate);
+                regions.push_back(region);
+                byteOffsets.push_back(byteOffset);
+            }
+        };
+
+        // Decoded sampler feedback rows are laid out like texture copies into buffers on D3D12
+        constexpr uint32_t c_FeedbackRowPitchAlignment = 256;
+        constexpr uint8_t c_FeedbackNotRequested = 0xff;
+    }
+
+    class TileHeapPool : public RefCounter<ITileHeapPool>
+    {
+    public:
+        TileHeapPool(IDevice* device, const TileHeapPoolDesc& desc)
+            : m_Device(device)
+            , m_Desc(desc)
+        { }
+
+        TileAllocation allocateTiles(uint32_t numTiles) override;
+        void releaseTiles(const TileAllocation& allocation) override;
+        void trim() override;
+        [[nodiscard]] const TileHeapPoolDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] uint32_t getNumHeaps() override;
+        [[nodiscard]] uint64_t getNumAllocatedTiles() override;
+        [[nodiscard]] uint64_t getCapacityInTiles() override;
+
+    private:
+        DeviceHandle m_Device;
+        TileHeapPoolDesc m_Desc;
+
+        std::mutex m_Mutex;
+        std::vector<TileHeap> m_Heaps;
+
+        static bool allocateFromHeap(TileHeap& heap, uint32_t numTiles, uint32_t& outFirstTile);
+    };
+
+    bool TileHeapPool::allocateFromHeap(TileHeap& heap, uint32_t numTiles, uint32_t& outFirstTile)
+    {
+        const uint32_t capacity = uint32_t(heap.usedTiles.size());
+        if (capacity - heap.numUsedTiles < numTiles)
+            return false;
+
+        // First fit: most allocations are single tiles, the packed mips are the only larger ones
+        uint32_t runStart = 0;
+        uint32_t runLength = 0;
+        for (uint32_t tile = 0; tile < capacity; ++tile)
+        {
+            if (heap.usedTiles[tile])
+            {
+                runStart = tile + 1;
+                runLength = 0;
+                continue;
+            }
+
+            if (++runLength == numTiles)
+            {
+                std::fill(heap.usedTiles.begin() + runStart, heap.usedTiles.begin() + runStart + numTiles, true);
+                heap.numUsedTiles += numTiles;
+                outFirstTile = runStart;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    TileAllocation TileHeapPool::allocateTiles(uint32_t numTiles)
+    {
+        if (numTiles == 0)
+            return TileAllocation();
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        TileAllocation allocation;
+        allocation.numTiles = numTiles;
+
+        uint32_t firstTile = 0;
+        for (TileHeap& heap : m_Heaps)
+        {
+            if (allocateFromHeap(heap, numTiles, firstTile))
+            {
+                allocation.heap = heap.heap;
+                allocation.byteOffset = uint64_t(firstTile) * m_Desc.tileSizeInBytes;
+                return allocation;
+            }
+        }
+
+        if (m_Desc.maxHeaps != 0 && m_Heaps.size() >= m_Desc.maxHeaps)
+            return TileAllocation();
+
+        const uint32_t heapTiles = std::max(m_Desc.tilesPerHeap, numTiles);
+
+        HeapDesc heapDesc;
+        heapDesc.capacity = uint64_t(heapTiles) * m_Desc.tileSizeInBytes;
+        heapDesc.type = HeapType::DeviceLocal;
+        heapDesc.debugName = m_Desc.debugName;
+
+        HeapHandle heap = m_Device->createHeap(heapDesc);
+        if (!heap)
+            return TileAllocation();
+
+        TileHeap& newHeap = m_Heaps.emplace_back();
+        newHeap.heap = heap;
+        newHeap.usedTiles.resize(heapTiles, false);
+
+        allocateFromHeap(newHeap, numTiles, firstTile);
+        allocation.heap = heap;
+        allocation.byteOffset = uint64_t(firstTile) * m_Desc.tileSizeInBytes;
+        return allocation;
+    }
+
+    void TileHeapPool::releaseTiles(const TileAllocation& allocation)
+    {
+        if (!allocation.valid())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto it = std::find_if(m_Heaps.begin(), m_Heaps.end(),
+            [&allocation](const TileHeap& heap) { return heap.heap == allocation.heap; });
+
+        if (it == m_Heaps.end())
+            return;
+
+        const uint32_t firstTile = uint32_t(allocation.byteOffset / m_Desc.tileSizeInBytes);
+        std::fill(it->usedTiles.begin() + firstTile, it->usedTiles.begin() + firstTile + allocation.numTiles, false);
+        it->numUsedTiles -= allocation.numTiles;
+    }
+
+    void TileHeapPool::trim()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Heaps.erase(std::remove_if(m_Heaps.begin(), m_Heaps.end(),
+            [](const TileHeap& heap) { return heap.numUsedTiles == 0; }), m_Heaps.end());
+    }
+
+    uint32_t TileHeapPool::getNumHeaps()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return uint32_t(m_Heaps.size());
+    }
+
+    uint64_t TileHeapPool::getNumAllocatedTiles()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint64_t result = 0;
+        for (const TileHeap& heap : m_Heaps)
+            result += heap.numUsedTiles;
+        return result;
+    }
+
+    uint64_t TileHeapPool::getCapacityInTiles()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint64_t result = 0;
+        for (const TileHeap& heap : m_Heaps)
+            result += heap.usedTiles.size();
+        return result;
+    }
+
+    TileHeapPoolHandle createTileHeapPool(IDevice* device, const TileHeapPoolDesc& desc)
+    {
+        if (desc.tileSizeInBytes == 0 || desc.tilesPerHeap == 0)
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createTileHeapPool: tileSizeInBytes and tilesPerHeap must be nonzero");
+            return nullptr;
+        }
+
+        return TileHeapPoolHandle::Create(new TileHeapPool(device, desc));
+    }
+
+    class TiledTextureStreamer : public RefCounter<ITiledTextureStreamer>
+    {
+    public:
+        TiledTextureStreamer(IDevice* device, const TiledTextureStreamerDesc& desc);
+        ~TiledTextureStreamer() override;
+
+        bool initialize();
+
+        bool requestTile(const TiledTextureCoordinate& tile) override;
+        void evictTile(const TiledTextureCoordinate& tile) override;
+        [[nodiscard]] bool isTileMapped(const TiledTextureCoordinate& tile) override;
+        bool resolveFeedback(ICommandList* commandList) override;
+        void update(CommandQueue queue, std::vector<TiledTextureCoordinate>* outMappedTiles) override;
+        [[nodiscard]] const TiledTextureStreamerDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] const PackedMipDesc& getPackedMipDesc() const override { return m_PackedMipDesc; }
+        [[nodiscard]] const TileShape& getTileShape() const override { return m_TileShape; }
+        [[nodiscard]] SubresourceTiling getMipTiling(uint32_t mipLevel) const override;
+        [[nodiscard]] uint32_t getNumMappedTiles() override;
+
+    private:
+        DeviceHandle m_Device;
+        TiledTextureStreamerDesc m_Desc;
+        TextureHandle m_Texture;
+        TileHeapPoolHandle m_HeapPool;
+        SamplerFeedbackTextureHandle m_FeedbackTexture;
+
+        PackedMipDesc m_PackedMipDesc;
+        TileShape m_TileShape;
+        std::vector<SubresourceTiling> m_MipTilings;
+        std::vector<uint32_t> m_MipTileOffsets;
+        uint32_t m_TilesPerSlice = 0;
+        uint32_t m_ArraySize = 1;
+
+        std::mutex m_Mutex;
+        std::vector<TileEntry> m_Tiles;
+        std::vector<uint32_t> m_PendingTiles;
+        std::vector<TileAllocation> m_PackedMipAllocations;
+        uint32_t m_NumMappedTiles = 0;
+
+        BufferHandle m_DecodeBuffer;
+        std::vector<FeedbackReadback> m_FeedbackReadbacks;
+        std::vector<uint32_t> m_FreeFeedbackSlots;
+        std::vector<uint32_t> m_RecordedFeedbackSlots;
+        std::deque<uint32_t> m_SubmittedFeedbackSlots;
+        uint32_t m_FeedbackRegionsX = 0;
+        uint32_t m_FeedbackRegionsY = 0;
+        uint32_t m_FeedbackRowPitch = 0;
+        uint64_t m_FeedbackIndex = 0;
+
+        void error(const std::string& message) const
+        {
+            std::stringstream ss;
+            ss << "Tiled texture streamer " << utils::DebugNameToString(m_Desc.debugName) << ": " << message;
+            m_Device->getMessageCallback()->message(MessageSeverity::Error, ss.str().c_str());
+        }
+
+        bool getTileIndex(const TiledTextureCoordinate& tile, uint32_t& outIndex) const;
+        [[nodiscard]] TiledTextureCoordinate getTileCoordinate(uint32_t index) const;
+        void requestTileLocked(uint32_t index);
+        void processFeedback(const uint8_t* data);
+        void evictIdleTiles();
+        void updateTileMappings(CommandQueue queue, std::vector<TiledTextureCoordinate>* outMappedTiles);
+    };
+
+    TiledTextureStreamer::TiledTextureStreamer(IDevice* device, const TiledTextureStreamerDesc& desc)
+        : m_Device(device)
+        , m_Desc(desc)
+        , m_Texture(desc.texture)
+        , m_HeapPool(desc.heapPool)
+        , m_FeedbackTexture(desc.feedbackTexture)
+    { }
+
+    TiledTextureStreamer::~TiledTextureStreamer()
+    {
+        for (const TileEntry& entry : m_Tiles)
+            m_HeapPool->releaseTiles(entry.allocation);
+
+        for (const TileAllocation& allocation : m_PackedMipAllocations)
+            m_HeapPool->releaseTiles(allocation);
+    }
+
+    bool TiledTextureStreamer::initialize()
+    {
+        const TextureDesc& textureDesc = m_Texture->getDesc();
+
+        if (!textureDesc.isTiled)
+        {
+            error("the texture " + std::string(utils::DebugNameToString(textureDesc.debugName)) + " is not tiled");
+            return false;
+        }
+
+        uint32_t numTiles = 0;
+        uint32_t numTilings = textureDesc.mipLevels;
+        m_MipTilings.resize(numTilings);
+        m_Device->getTextureTiling(m_Texture, &numTiles, &m_PackedMipDesc, &m_TileShape, &numTilings, m_MipTilings.data());
+
+        m_MipTilings.resize(std::min(numTilings, m_PackedMipDesc.numStandardMips));
+        m_ArraySize = textureDesc.dimension == TextureDimension::Texture3D ? 1 : textureDesc.arraySize;
+
+        m_MipTileOffsets.reserve(m_MipTilings.size());
+        for (const SubresourceTiling& tiling : m_MipTilings)
+        {
+            m_MipTileOffsets.push_back(m_TilesPerSlice);
+            m_TilesPerSlice += tiling.widthInTiles * tiling.heightInTiles * tiling.depthInTiles;
+        }
+
+        m_Tiles.resize(size_t(m_TilesPerSlice) * m_ArraySize);
+
+        if (m_FeedbackTexture)
+        {
+            const SamplerFeedbackTextureDesc& feedbackDesc = m_FeedbackTexture->getDesc();
+            if (feedbackDesc.samplerFeedbackMipRegionX == 0 || feedbackDesc.samplerFeedbackMipRegionY == 0)
+            {
+                error("the feedback texture has no mip region size");
+                return false;
+            }
+
+            m_FeedbackRegionsX = (textureDesc.width + feedbackDesc.samplerFeedbackMipRegionX - 1) / feedbackDesc.samplerFeedbackMipRegionX;
+            m_FeedbackRegionsY = (textureDesc.height + feedbackDesc.samplerFeedbackMipRegionY - 1) / feedbackDesc.samplerFeedbackMipRegionY;
+            m_FeedbackRowPitch = align(m_FeedbackRegionsX, c_FeedbackRowPitchAlignment);
+
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = uint64_t(m_FeedbackRowPitch) * m_FeedbackRegionsY;
+            bufferDesc.debugName = m_Desc.debugName;
+            bufferDesc.initialState = ResourceStates::CopySource;
+            bufferDesc.keepInitialState = true;
+
+            m_DecodeBuffer = m_Device->createBuffer(bufferDesc);
+            if (!m_DecodeBuffer)
+                return false;
+
+            const uint32_t numSlots = std::max(m_Desc.maxFeedbackLatency, 1u);
+            m_FeedbackReadbacks.resize(numSlots);
+            for (uint32_t slot = numSlots; slot > 0; --slot)
+                m_FreeFeedbackSlots.push_back(slot - 1);
+        }
+
+        return true;
+    }
+
+    bool TiledTextureStreamer::getTileIndex(const TiledTextureCoordinate& tile, uint32_t& outIndex) const
+    {
+        if (tile.mipLevel >= m_MipTilings.size() || tile.arrayLevel >= m_ArraySize)
+            return false;
+
+        const SubresourceTiling& tiling = m_MipTilings[tile.mipLevel];
+        if (tile.x >= tiling.widthInTiles || tile.y >= tiling.heightInTiles || tile.z >= tiling.depthInTiles)
+            return false;
+
+        outIndex = tile.arrayLevel * m_TilesPerSlice + m_MipTileOffsets[tile.mipLevel]
+            + (tile.z * tiling.heightInTiles + tile.y) * tiling.widthInTiles + tile.x;
+        return true;
+    }
+
+    TiledTextureCoordinate TiledTextureStreamer::getTileCoordinate(uint32_t index) const
+    {
+        TiledTextureCoordinate result;
+        result.arrayLevel = uint16_t(index / m_TilesPerSlice);
+        index %= m_TilesPerSlice;
+
+        // The mips are few, a linear search from the coarsest one is enough
+        uint32_t mipLevel = uint32_t(m_MipTileOffsets.size()) - 1;
+        while (m_MipTileOffsets[mipLevel] > index)
+            --mipLevel;
+
+        const SubresourceTiling& tiling = m_MipTilings[mipLevel];
+        index -= m_MipTileOffsets[mipLevel];
+
+        result.mipLevel = uint16_t(mipLevel);
+        result.x = index % tiling.widthInTiles;
+        result.y = (index / tiling.widthInTiles) % tiling.heightInTiles;
+        result.z = index / (tiling.widthInTiles * tiling.heightInTiles);
+        return result;
+    }
+
+    void TiledTextureStreamer::requestTileLocked(uint32_t index)
+    {
+        TileEntry& entry = m_Tiles[index];
+        entry.lastRequestedFeedback = m_FeedbackIndex;
+
+        switch (entry.state)
+        {
+        case TileMappingState::Unmapped:
+            entry.state = TileMappingState::PendingMap;
+            m_PendingTiles.push_back(index);
+            break;
+        case TileMappingState::PendingUnmap:
+            // Still mapped, the stale entry in the pending list is skipped by the update
+            entry.state = TileMappingState::Mapped;
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool TiledTextureStreamer::requestTile(const TiledTextureCoordinate& tile)
+    {
+        uint32_t index = 0;
+        if (!getTileIndex(tile, index))
+            return false;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        requestTileLocked(index);
+        return true;
+    }
+
+    void TiledTextureStreamer::evictTile(const TiledTextureCoordinate& tile)
+    {
+        uint32_t index = 0;
+        if (!getTileIndex(tile, index))
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        TileEntry& entry = m_Tiles[index];
+        switch (entry.state)
+        {
+        case TileMappingState::Mapped:
+            entry.state = TileMappingState::PendingUnmap;
+            m_PendingTiles.push_back(index);
+            break;
+        case TileMappingState::PendingMap:
+            entry.state = TileMappingState::Unmapped;
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool TiledTextureStreamer::isTileMapped(const TiledTextureCoordinate& tile)
+    {
+        uint32_t index = 0;
+        if (!getTileIndex(tile, index))
+            return false;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Tiles[index].state == TileMappingState::Mapped;
+    }
+
+    bool TiledTextureStreamer::resolveFeedback(ICommandList* commandList)
+    {
+        if (!m_FeedbackTexture || !commandList)
+            return false;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (m_FreeFeedbackSlots.empty())
+            return false;
+
+        const uint32_t slot = m_FreeFeedbackSlots.back();
+        FeedbackReadback& readback = m_FeedbackReadbacks[slot];
+
+        if (!readback.buffer)
+        {
+            BufferDesc bufferDesc = m_DecodeBuffer->getDesc();
+            bufferDesc.cpuAccess = CpuAccessMode::Read;
+            bufferDesc.initialState = ResourceStates::CopyDest;
+
+            readback.buffer = m_Device->createBuffer(bufferDesc);
+            readback.query = m_Device->createEventQuery();
+
+            if (!readback.buffer || !readback.query)
+                return false;
+        }
+
+        m_FreeFeedbackSlots.pop_back();
+
+        commandList->decodeSamplerFeedbackTexture(m_DecodeBuffer, m_FeedbackTexture, Format::R8_UINT);
+        commandList->copyBuffer(readback.buffer, 0, m_DecodeBuffer, 0, m_DecodeBuffer->getDesc().byteSize);
+        commandList->clearSamplerFeedbackTexture(m_FeedbackTexture);
+
+        m_RecordedFeedbackSlots.push_back(slot);
+        return true;
+    }
+
+    void TiledTextureStreamer::processFeedback(const uint8_t* data)
+    {
+        const TextureDesc& textureDesc = m_Texture->getDesc();
+        const SamplerFeedbackTextureDesc& feedbackDesc = m_FeedbackTexture->getDesc();
+        const uint32_t numStandardMips = uint32_t(m_MipTilings.size());
+
+        ++m_FeedbackIndex;
+
+        for (uint32_t regionY = 0; regionY < m_FeedbackRegionsY; ++regionY)
+        {
+            const uint8_t* row = data + size_t(regionY) * m_FeedbackRowPitch;
+
+            for (uint32_t regionX = 0; regionX < m_FeedbackRegionsX; ++regionX)
+            {
+                const uint8_t minMip = row[regionX];
+                if (minMip == c_FeedbackNotRequested)
+                    continue;
+
+                // The region's texels in mip 0, the same area is needed in every coarser mip
+                const uint32_t x0 = regionX * feedbackDesc.samplerFeedbackMipRegionX;
+                const uint32_t y0 = regionY * feedbackDesc.samplerFeedbackMipRegionY;
+                const uint32_t x1 = std::min(x0 + feedbackDesc.samplerFeedbackMipRegionX, textureDesc.width) - 1;
+                const uint32_t y1 = std::min(y0 + feedbackDesc.samplerFeedbackMipRegionY, textureDesc.height) - 1;
+
+                for (uint32_t mipLevel = minMip; mipLevel < numStandardMips; ++mipLevel)
+                {
+                    const SubresourceTiling& tiling = m_MipTilings[mipLevel];
+                    const uint32_t tileX0 = (x0 >> mipLevel) / m_TileShape.widthInTexels;
+                    const uint32_t tileY0 = (y0 >> mipLevel) / m_TileShape.heightInTexels;
+                    const uint32_t tileX1 = std::min((x1 >> mipLevel) / m_TileShape.widthInTexels, tiling.widthInTiles - 1);
+                    const uint32_t tileY1 = std::min((y1 >> mipLevel) / m_TileShape.heightInTexels, tiling.heightInTiles - 1);
+
+                    for (uint32_t tileY = tileY0; tileY <= tileY1; ++tileY)
+                    {
+                        for (uint32_t tileX = tileX0; tileX <= tileX1; ++tileX)
+                        {
+                            requestTileLocked(m_MipTileOffsets[mipLevel] + tileY * tiling.widthInTiles + tileX);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void TiledTextureStreamer::evictIdleTiles()
+    {
+        if (m_Desc.maxIdleFeedbacks == 0)
+            return;
+
+        for (uint32_t index = 0; index < uint32_t(m_Tiles.size()); ++index)
+        {
+            TileEntry& entry = m_Tiles[index];
+            if (entry.state == TileMappingState::Mapped && m_FeedbackIndex - entry.lastRequestedFeedback > m_Desc.maxIdleFeedbacks)
+            {
+                entry.state = TileMappingState::PendingUnmap;
+                m_PendingTiles.push_back(index);
+            }
+        }
+    }
+
+    void TiledTextureStreamer::updateTileMappings(CommandQueue queue, std::vector<TiledTextureCoordinate>* outMappedTiles)
+    {
+        HeapMappingGroup unmapGroup;
+        std::vector<HeapMappingGroup> mapGroups;
+        std::vector<TileAllocation> releasedAllocations;
+
+        auto getMapGroup = [&mapGroups](IHeap* heap) -> HeapMappingGroup&
+        {
+            auto it = std::find_if(mapGroups.begin(), mapGroups.end(),
+                [heap](const HeapMappingGroup& group) { return group.heap == heap; });
+
+            if (it != mapGroups.end())
+                return *it;
+
+            HeapMappingGroup& group = mapGroups.emplace_back();
+            group.heap = heap;
+            return group;
+        };
+
+        if (m_Desc.mapPackedMips && m_PackedMipAllocations.empty()
+            && m_PackedMipDesc.numPackedMips != 0 && m_PackedMipDesc.numTilesForPackedMips != 0)
+        {
+            for (uint32_t arraySlice = 0; arraySlice < m_ArraySize; ++arraySlice)
+            {
+                TileAllocation allocation = m_HeapPool->allocateTiles(m_PackedMipDesc.numTilesForPackedMips);
+                if (!allocation.valid())
+                {
+                    error("cannot allocate the tiles for the packed mips");
+                    break;
+                }
+
+                TiledTextureCoordinate coordinate;
+                coordinate.mipLevel = uint16_t(m_PackedMipDesc.numStandardMips);
+                coordinate.arrayLevel = uint16_t(arraySlice);
+
+                TiledTextureRegion region;
+                region.tilesNum = allocation.numTiles;
+
+                getMapGroup(allocation.heap).add(coordinate, region, allocation.byteOffset);
+                m_PackedMipAllocations.push_back(allocation);
+            }
+        }
+
+        // Regions of one tile each: the backends disagree on the units of region sizes, but a 1x1x1 box is one tile on all of them
+        TiledTextureRegion tileRegion;
+        tileRegion.width = 1;
+        tileRegion.height = 1;
+        tileRegion.depth = 1;
+
+        std::vector<uint32_t> pendingTiles = std::move(m_PendingTiles);
+        m_PendingTiles.clear();
+
+        uint32_t numMappedThisUpdate = 0;
+        bool outOfTiles = false;
+
+        for (uint32_t index : pendingTiles)
+        {
+            TileEntry& entry = m_Tiles[index];
+
+            if (entry.state == TileMappingState::PendingUnmap)
+            {
+                unmapGroup.add(getTileCoordinate(index), tileRegion, 0);
+                releasedAllocations.push_back(entry.allocation);
+                entry.allocation = TileAllocation();
+                entry.state = TileMappingState::Unmapped;
+                --m_NumMappedTiles;
+            }
+            else if (entry.state == TileMappingState::PendingMap)
+            {
+                if (outOfTiles || (m_Desc.maxTilesPerUpdate != 0 && numMappedThisUpdate >= m_Desc.maxTilesPerUpdate))
+                {
+                    m_PendingTiles.push_back(index);
+                    continue;
+                }
+
+                entry.allocation = m_HeapPool->allocateTiles(1);
+                if (!entry.allocation.valid())
+                {
+                    // The pool is full, keep the remaining requests for the next update
+                    outOfTiles = true;
+                    m_PendingTiles.push_back(index);
+                    continue;
+                }
+
+                const TiledTextureCoordinate coordinate = getTileCoordinate(index);
+                getMapGroup(entry.allocation.heap).add(coordinate, tileRegion, entry.allocation.byteOffset);
+                entry.state = TileMappingState::Mapped;
+                ++m_NumMappedTiles;
+                ++numMappedThisUpdate;
+
+                if (outMappedTiles)
+                    outMappedTiles->push_back(coordinate);
+            }
+        }
+
+        std::vector<TextureTilesMapping> mappings;
+        mappings.reserve(mapGroups.size() + 1);
+
+        auto addMapping = [&mappings](HeapMappingGroup& group)
+        {
+            if (group.coordinates.empty())
+                return;
+
+            TextureTilesMapping& mapping = mappings.emplace_back();
+            mapping.tiledTextureCoordinates = group.coordinates.data();
+            mapping.tiledTextureRegions = group.regions.data();
+            mapping.byteOffsets = group.byteOffsets.data();
+            mapping.numTextureRegions = uint32_t(group.coordinates.size());
+            mapping.heap = group.heap;
+        };
+
+        // Unmap first, so that the tiles released here can be mapped again by the same call
+        addMapping(unmapGroup);
+        for (HeapMappingGroup& group : mapGroups)
+            addMapping(group);
+
+        for (const TileAllocation& allocation : releasedAllocations)
+            m_HeapPool->releaseTiles(allocation);
+
+        if (!mappings.empty())
+            m_Device->updateTextureTileMappings(m_Texture, mappings.data(), uint32_t(mappings.size()), queue);
+    }
+
+    void TiledTextureStreamer::update(CommandQueue queue, std::vector<TiledTextureCoordinate>* outMappedTiles)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        for (uint32_t slot : m_RecordedFeedbackSlots)
+        {
+            FeedbackReadback& readback = m_FeedbackReadbacks[slot];
+            m_Device->resetEventQuery(readback.query);
+            m_Device->setEventQuery(readback.query, queue);
+            m_SubmittedFeedbackSlots.push_back(slot);
+        }
+        m_RecordedFeedbackSlots.clear();
+
+        bool feedbackProcessed = false;
+        while (!m_SubmittedFeedbackSlots.empty())
+        {
+            const uint32_t slot = m_SubmittedFeedbackSlots.front();
+            FeedbackReadback& readback = m_FeedbackReadbacks[slot];
+
+            if (!m_Device->pollEventQuery(readback.query))
+                break;
+
+            const uint8_t* data = static_cast<const uint8_t*>(m_Device->mapBuffer(readback.buffer, CpuAccessMode::Read));
+            if (data)
+            {
+                processFeedback(data);
+                m_Device->unmapBuffer(readback.buffer);
+                feedbackProcessed = true;
+            }
+
+            m_SubmittedFeedbackSlots.pop_front();
+            m_FreeFeedbackSlots.push_back(slot);
+        }
+
+        if (feedbackProcessed)
+            evictIdleTiles();
+
+        updateTileMappings(queue, outMappedTiles);
+    }
+
+    SubresourceTiling TiledTextureStreamer::getMipTiling(uint32_t mipLevel) const
+    {
+        if (mipLevel >= m_MipTilings.size())
+            return SubresourceTiling();
+
+        return m_MipTilings[mipLevel];
+    }
+
+    uint32_t TiledTextureStreamer::getNumMappedTiles()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint32_t result = m_NumMappedTiles;
+        for (const TileAllocation& allocation : m_PackedMipAllocations)
+            result += allocation.numTiles;
+        return result;
+    }
+
+    TiledTextureStreamerHandle createTiledTextureStreamer(IDevice* device, const TiledTextureStreamerDesc& desc)
+    {
+        if (!desc.texture || !desc.heapPool)
+        {
+            device->getMessageCallback()->message(MessageSeverity::Error,
+                "createTiledTextureStreamer: the texture and the heap pool must be specified");
+            return nullptr;
+        }
+
+        TiledTextureStreamer* streamer = new TiledTextureStreamer(device, desc);
+        TiledTextureStreamerHandle handle = TiledTextureStreamerHandle::Create(streamer);
+
+        if (!streamer->initialize())
+            return nullptr;
+
+        return handle;
+    }
+
+} // namespace nvrhi
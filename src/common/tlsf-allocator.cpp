@@ -0,0 +1,278 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "tlsf-allocator.h"
+#include <nvrhi/nvrhi.h>
+#include <nvrhi/common/misc.h>
+#include <cassert>
+
+namespace nvrhi
+{
+    TlsfAllocator::TlsfAllocator(uint64_t size)
+        : m_Size(size)
+    {
+        for (auto& lists : m_FreeLists)
+        {
+            for (uint32_t& head : lists)
+                head = c_InvalidNode;
+        }
+
+        if (size == 0)
+            return;
+
+        const uint32_t index = createNode();
+        m_Nodes[index].offset = 0;
+        m_Nodes[index].size = size;
+        insertFreeNode(index);
+    }
+
+    void TlsfAllocator::mapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+    {
+        if (size < c_SecondLevelCount)
+        {
+            // Small sizes map linearly into the first list
+            firstLevel = 0;
+            secondLevel = uint32_t(size);
+            return;
+        }
+
+        const uint32_t highestBit = findHighestSetBit(size);
+        firstLevel = highestBit - c_SecondLevelBits + 1;
+        secondLevel = uint32_t(size >> (highestBit - c_SecondLevelBits)) - c_SecondLevelCount;
+    }
+
+    uint32_t TlsfAllocator::createNode()
+    {
+        if (!m_UnusedNodes.empty())
+        {
+            const uint32_t index = m_UnusedNodes.back();
+            m_UnusedNodes.pop_back();
+            m_Nodes[index] = Node();
+            return index;
+        }
+
+        m_Nodes.emplace_back();
+        return uint32_t(m_Nodes.size() - 1);
+    }
+
+    void TlsfAllocator::destroyNode(uint32_t index)
+    {
+        m_UnusedNodes.push_back(index);
+    }
+
+    void TlsfAllocator::insertFreeNode(uint32_t index)
+    {
+        Node& node = m_Nodes[index];
+
+        uint32_t firstLevel, secondLevel;
+        mapSize(node.size, firstLevel, secondLevel);
+
+        uint32_t& head = m_FreeLists[firstLevel][secondLevel];
+        node.free = true;
+        node.prevFree = c_InvalidNode;
+        node.nextFree = head;
+        if (head != c_InvalidNode)
+            m_Nodes[head].prevFree = index;
+        head = index;
+
+        m_FirstLevelBitmap |= 1ull << firstLevel;
+        m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    }
+
+    void TlsfAllocator::removeFreeNode(uint32_t index)
+    {
+        Node& node = m_Nodes[index];
+        assert(node.free);
+
+        uint32_t firstLevel, secondLevel;
+        mapSize(node.size, firstLevel, secondLevel);
+
+        if (node.prevFree != c_InvalidNode)
+            m_Nodes[node.prevFree].nextFree = node.nextFree;
+        else
+            m_FreeLists[firstLevel][secondLevel] = node.nextFree;
+
+        if (node.nextFree != c_InvalidNode)
+            m_Nodes[node.nextFree].prevFree = node.prevFree;
+
+        if (m_FreeLists[firstLevel][secondLevel] == c_InvalidNode)
+        {
+            m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+            if (m_SecondLevelBitmaps[firstLevel] == 0)
+                m_FirstLevelBitmap &= ~(1ull << firstLevel);
+        }
+
+        node.free = false;
+        node.prevFree = c_InvalidNode;
+        node.nextFree = c_InvalidNode;
+    }
+
+    uint32_t TlsfAllocator::findFreeNode(uint64_t size) const
+    {
+        // Round the size up to the next list boundary, so that any node in the list that is found is large enough
+        if (size >= c_SecondLevelCount)
+        {
+            const uint64_t roundUp = (1ull << (findHighestSetBit(size) - c_SecondLevelBits)) - 1;
+            if (size > ~0ull - roundUp)
+                return c_InvalidNode;
+            size += roundUp;
+        }
+
+        uint32_t firstLevel, secondLevel;
+        mapSize(size, firstLevel, secondLevel);
+
+        uint32_t secondLevelMap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+        if (secondLevelMap == 0)
+        {
+            const uint64_t firstLevelMap = (firstLevel + 1 < c_FirstLevelCount)
+                ? m_FirstLevelBitmap & (~0ull << (firstLevel + 1))
+                : 0;
+
+            if (firstLevelMap == 0)
+                return c_InvalidNode;
+
+            firstLevel = countTrailingZeros(firstLevelMap);
+            secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+        }
+
+        secondLevel = countTrailingZeros(secondLevelMap);
+        return m_FreeLists[firstLevel][secondLevel];
+    }
+
+    uint32_t TlsfAllocator::splitNode(uint32_t index, uint64_t size)
+    {
+        // Cuts the node at the given size, returns the index of the new node that follows it
+        const uint32_t remainder = createNode();
+
+        Node& node = m_Nodes[index];
+        Node& remainderNode = m_Nodes[remainder];
+
+        remainderNode.offset = node.offset + size;
+        remainderNode.size = node.size - size;
+        remainderNode.prevPhysical = index;
+        remainderNode.nextPhysical = node.nextPhysical;
+
+        if (node.nextPhysical != c_InvalidNode)
+            m_Nodes[node.nextPhysical].prevPhysical = remainder;
+
+        node.size = size;
+        node.nextPhysical = remainder;
+
+        return remainder;
+    }
+
+    void TlsfAllocator::mergeWithNext(uint32_t index)
+    {
+        Node& node = m_Nodes[index];
+        const uint32_t next = node.nextPhysical;
+        const Node& nextNode = m_Nodes[next];
+
+        node.size += nextNode.size;
+        node.nextPhysical = nextNode.nextPhysical;
+
+        if (node.nextPhysical != c_InvalidNode)
+            m_Nodes[node.nextPhysical].prevPhysical = index;
+
+        destroyNode(next);
+    }
+
+    TlsfAllocator::Allocation TlsfAllocator::allocate(uint64_t size, uint64_t alignment)
+    {
+        assert((alignment & (alignment - 1)) == 0);
+
+        if (size == 0)
+            size = 1;
+        if (alignment == 0)
+            alignment = 1;
+
+        auto fits = [this, size, alignment](uint32_t index)
+        {
+            const Node& node = m_Nodes[index];
+            return align(node.offset, alignment) + size <= node.offset + node.size;
+        };
+
+        // Most free ranges start at aligned offsets already, so try the exact size first,
+        // and only ask for a range that fits any alignment padding if that doesn't work
+        uint32_t index = findFreeNode(size);
+        if (index == c_InvalidNode || !fits(index))
+        {
+            index = (size <= ~0ull - (alignment - 1)) ? findFreeNode(size + alignment - 1) : c_InvalidNode;
+            if (index == c_InvalidNode)
+                return Allocation();
+        }
+
+        removeFreeNode(index);
+
+        const uint64_t padding = align(m_Nodes[index].offset, alignment) - m_Nodes[index].offset;
+        if (padding > 0)
+        {
+            // Keep the padding as a separate free node in front of the allocation
+            const uint32_t aligned = splitNode(index, padding);
+            insertFreeNode(index);
+            index = aligned;
+        }
+
+        if (m_Nodes[index].size > size)
+        {
+            const uint32_t remainder = splitNode(index, size);
+            insertFreeNode(remainder);
+        }
+
+        const Node& node = m_Nodes[index];
+        m_UsedSize += node.size;
+        ++m_NumAllocations;
+
+        Allocation allocation;
+        allocation.offset = node.offset;
+        allocation.size = node.size;
+        allocation.node = index;
+        return allocation;
+    }
+
+    void TlsfAllocator::release(const Allocation& allocation)
+    {
+        uint32_t index = allocation.node;
+        assert(index < m_Nodes.size() && !m_Nodes[index].free);
+
+        m_UsedSize -= m_Nodes[index].size;
+        --m_NumAllocations;
+
+        const uint32_t next = m_Nodes[index].nextPhysical;
+        if (next != c_InvalidNode && m_Nodes[next].free)
+        {
+            removeFreeNode(next);
+            mergeWithNext(index);
+        }
+
+        const uint32_t prev = m_Nodes[index].prevPhysical;
+        if (prev != c_InvalidNode && m_Nodes[prev].free)
+        {
+            removeFreeNode(prev);
+            mergeWithNext(prev);
+            index = prev;
+        }
+
+        insertFreeNode(index);
+    }
+
+} // namespace nvrhi
@@ -0,0 +1,105 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace nvrhi
+{
+    // Two-Level Segregated Fit allocator that manages offsets in a linear address range, such as a memory block.
+    // Allocation and release are O(1): free ranges are kept in lists bucketed by the highest bit of their size
+    // (first level) and a few bits below it (second level), and adjacent free ranges are merged on release.
+    // The allocator doesn't touch any memory itself, so it can be used for device memory blocks and heaps.
+    class TlsfAllocator
+    {
+    public:
+        static constexpr uint32_t c_InvalidNode = ~0u;
+
+        struct Allocation
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t node = c_InvalidNode;
+
+            [[nodiscard]] bool isValid() const { return node != c_InvalidNode; }
+        };
+
+        explicit TlsfAllocator(uint64_t size);
+
+        // Returns an invalid allocation if there is no free range that fits; alignment must be a power of 2
+        [[nodiscard]] Allocation allocate(uint64_t size, uint64_t alignment);
+        void release(const Allocation& allocation);
+
+        [[nodiscard]] uint64_t getSize() const { return m_Size; }
+        [[nodiscard]] uint64_t getUsedSize() const { return m_UsedSize; }
+        [[nodiscard]] uint32_t getNumAllocations() const { return m_NumAllocations; }
+        [[nodiscard]] bool isEmpty() const { return m_NumAllocations == 0; }
+
+    private:
+        static constexpr uint32_t c_SecondLevelBits = 4;
+        static constexpr uint32_t c_SecondLevelCount = 1u << c_SecondLevelBits;
+        static constexpr uint32_t c_FirstLevelCount = 64 - c_SecondLevelBits + 1;
+
+        struct Node
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+
+            // Neighbors in the address range
+            uint32_t prevPhysical = c_InvalidNode;
+            uint32_t nextPhysical = c_InvalidNode;
+
+            // Neighbors in the free list, only valid for free nodes
+            uint32_t prevFree = c_InvalidNode;
+            uint32_t nextFree = c_InvalidNode;
+
+            bool free = false;
+        };
+
+        uint64_t m_Size = 0;
+        uint64_t m_UsedSize = 0;
+        uint32_t m_NumAllocations = 0;
+
+        uint64_t m_FirstLevelBitmap = 0;
+        uint32_t m_SecondLevelBitmaps[c_FirstLevelCount] = {};
+        uint32_t m_FreeLists[c_FirstLevelCount][c_SecondLevelCount];
+
+        // Nodes are stored in a vector and recycled through a list of unused indices,
+        // so there are no heap allocations after the allocator has warmed up
+        std::vector<Node> m_Nodes;
+        std::vector<uint32_t> m_UnusedNodes;
+
+        static void mapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+        uint32_t createNode();
+        void destroyNode(uint32_t index);
+        void insertFreeNode(uint32_t index);
+        void removeFreeNode(uint32_t index);
+        uint32_t findFreeNode(uint64_t size) const;
+        uint32_t splitNode(uint32_t index, uint64_t size);
+        void mergeWithNext(uint32_t index);
+    };
+
+} // namespace nvrhi
@@ -0,0 +1,343 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <nvrhi/common/transient-pool.h>
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace nvrhi
+{
+    class TransientResourcePool : public RefCounter<ITransientResourcePool>
+    {
+    public:
+        TransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc)
+            : m_Device(device)
+            , m_Desc(desc)
+        { }
+
+        TransientResourceId declareTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass) override;
+        TransientResourceId declareBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass) override;
+        bool compile() override;
+        void reset() override;
+        ITexture* getTexture(TransientResourceId id) override;
+        IBuffer* getBuffer(TransientResourceId id) override;
+        void beginPass(ICommandList* commandList, uint32_t passIndex) override;
+        [[nodiscard]] const TransientResourcePoolDesc& getDesc() const override { return m_Desc; }
+        [[nodiscard]] uint64_t getHeapSize() const override { return m_HeapSize; }
+        [[nodiscard]] uint64_t getTotalResourceSize() const override { return m_TotalResourceSize; }
+
+    private:
+        struct Entry
+        {
+            bool isTexture = false;
+            TextureDesc textureDesc;
+            BufferDesc bufferDesc;
+            uint32_t firstPass = 0;
+            uint32_t lastPass = 0;
+
+            TextureHandle texture;
+            BufferHandle buffer;
+            MemoryRequirements memoryRequirements;
+            uint64_t offset = 0;
+
+            [[nodiscard]] IResource* getResource() const { return isTexture ? static_cast<IResource*>(texture.Get()) : buffer.Get(); }
+            [[nodiscard]] uint64_t getEnd() const { return offset + memoryRequirements.size; }
+        };
+
+        // An aliasing barrier placed at the beginning of a pass; 'before' is c_InvalidTransientResource
+        // when the entry shares memory with more than one other resource
+        struct AliasingBarrier
+        {
+            uint32_t passIndex = 0;
+            TransientResourceId before = c_InvalidTransientResource;
+            TransientResourceId after = c_InvalidTransientResource;
+        };
+
+        IDevice* m_Device;
+        TransientResourcePoolDesc m_Desc;
+        std::vector<Entry> m_Entries;
+        std::vector<AliasingBarrier> m_AliasingBarriers; // sorted by passIndex
+        HeapHandle m_Heap;
+        uint64_t m_HeapSize = 0;
+        uint64_t m_TotalResourceSize = 0;
+        bool m_Compiled = false;
+
+        void error(const std::string& message) const;
+        void placeEntries();
+        void findAliasingBarriers();
+    };
+
+    void TransientResourcePool::error(const std::string& message) const
+    {
+        m_Device->getMessageCallback()->message(MessageSeverity::Error, message.c_str());
+    }
+
+    TransientResourceId TransientResourcePool::declareTexture(const TextureDesc& desc, uint32_t firstPass, uint32_t lastPass)
+    {
+        if (m_Compiled || firstPass > lastPass)
+        {
+            error("Cannot declare a transient texture in a compiled pool or with an empty lifetime");
+            return c_InvalidTransientResource;
+        }
+
+        Entry entry;
+        entry.isTexture = true;
+        entry.textureDesc = desc;
+        entry.textureDesc.isVirtual = true;
+        entry.firstPass = firstPass;
+        entry.lastPass = lastPass;
+        m_Entries.push_back(entry);
+
+        return TransientResourceId(m_Entries.size() - 1);
+    }
+
+    TransientResourceId TransientResourcePool::declareBuffer(const BufferDesc& desc, uint32_t firstPass, uint32_t lastPass)
+    {
+        if (m_Compiled || firstPass > lastPass)
+        {
+            error("Cannot declare a transient buffer in a compiled pool or with an empty lifetime");
+            return c_InvalidTransientResource;
+        }
+
+        Entry entry;
+        entry.isTexture = false;
+        entry.bufferDesc = desc;
+        entry.bufferDesc.isVirtual = true;
+        entry.firstPass = firstPass;
+        entry.lastPass = lastPass;
+        m_Entries.push_back(entry);
+
+        return TransientResourceId(m_Entries.size() - 1);
+    }
+
+    void TransientResourcePool::placeEntries()
+    {
+        // Greedy first-fit placement, largest resources first: each resource goes to the lowest offset
+        // where it doesn't overlap any already placed resource with an intersecting lifetime
+        std::vector<uint32_t> order(m_Entries.size());
+        for (uint32_t index = 0; index < uint32_t(order.size()); index++)
+            order[index] = index;
+
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+        {
+            const Entry& entryA = m_Entries[a];
+            const Entry& entryB = m_Entries[b];
+            if (entryA.memoryRequirements.size != entryB.memoryRequirements.size)
+                return entryA.memoryRequirements.size > entryB.memoryRequirements.size;
+            return entryA.firstPass < entryB.firstPass;
+        });
+
+        std::vector<uint32_t> placed;
+        std::vector<uint32_t> conflicts;
+        m_HeapSize = 0;
+
+        for (uint32_t index : order)
+        {
+            Entry& entry = m_Entries[index];
+            const uint64_t alignment = std::max(entry.memoryRequirements.alignment, uint64_t(1));
+
+            conflicts.clear();
+            for (uint32_t other : placed)
+            {
+                const Entry& otherEntry = m_Entries[other];
+                if (otherEntry.firstPass <= entry.lastPass && entry.firstPass <= otherEntry.lastPass)
+                    conflicts.push_back(other);
+            }
+
+            std::sort(conflicts.begin(), conflicts.end(), [this](uint32_t a, uint32_t b)
+            {
+                return m_Entries[a].offset < m_Entries[b].offset;
+            });
+
+            uint64_t offset = 0;
+            for (uint32_t other : conflicts)
+            {
+                const Entry& otherEntry = m_Entries[other];
+                if (align(offset, alignment) + entry.memoryRequirements.size <= otherEntry.offset)
+                    break;
+
+                offset = std::max(offset, otherEntry.getEnd());
+            }
+
+            entry.offset = align(offset, alignment);
+            m_HeapSize = std::max(m_HeapSize, entry.getEnd());
+            placed.push_back(index);
+        }
+    }
+
+    void TransientResourcePool::findAliasingBarriers()
+    {
+        m_AliasingBarriers.clear();
+
+        // A resource needs an aliasing barrier at the beginning of its lifetime if any other resource
+        // shares its memory, including the resources used later in the previous frame
+        for (uint32_t index = 0; index < uint32_t(m_Entries.size()); index++)
+        {
+            const Entry& entry = m_Entries[index];
+
+            uint32_t numOverlapping = 0;
+            TransientResourceId before = c_InvalidTransientResource;
+
+            for (uint32_t other = 0; other < uint32_t(m_Entries.size()); other++)
+            {
+                const Entry& otherEntry = m_Entries[other];
+                if (other == index || otherEntry.offset >= entry.getEnd() || entry.offset >= otherEntry.getEnd())
+                    continue;
+
+                ++numOverlapping;
+                before = other;
+            }
+
+            if (numOverlapping == 0)
+                continue;
+
+            AliasingBarrier barrier;
+            barrier.passIndex = entry.firstPass;
+            barrier.before = numOverlapping == 1 ? before : c_InvalidTransientResource;
+            barrier.after = index;
+            m_AliasingBarriers.push_back(barrier);
+        }
+
+        std::stable_sort(m_AliasingBarriers.begin(), m_AliasingBarriers.end(), [](const AliasingBarrier& a, const AliasingBarrier& b)
+        {
+            return a.passIndex < b.passIndex;
+        });
+    }
+
+    bool TransientResourcePool::compile()
+    {
+        if (m_Compiled)
+            return true;
+
+        m_TotalResourceSize = 0;
+
+        for (Entry& entry : m_Entries)
+        {
+            if (entry.isTexture)
+            {
+                entry.texture = m_Device->createTexture(entry.textureDesc);
+                if (!entry.texture)
+                    return false;
+
+                entry.memoryRequirements = m_Device->getTextureMemoryRequirements(entry.texture);
+            }
+            else
+            {
+                entry.buffer = m_Device->createBuffer(entry.bufferDesc);
+                if (!entry.buffer)
+                    return false;
+
+                entry.memoryRequirements = m_Device->getBufferMemoryRequirements(entry.buffer);
+            }
+
+            m_TotalResourceSize += entry.memoryRequirements.size;
+        }
+
+        placeEntries();
+
+        if (m_HeapSize == 0)
+        {
+            m_Compiled = true;
+            return true;
+        }
+
+        HeapDesc heapDesc;
+        heapDesc.capacity = m_HeapSize;
+        heapDesc.type = m_Desc.heapType;
+        heapDesc.debugName = m_Desc.debugName;
+
+        m_Heap = m_Device->createHeap(heapDesc);
+        if (!m_Heap)
+            return false;
+
+        for (const Entry& entry : m_Entries)
+        {
+            const bool bound = entry.isTexture
+                ? m_Device->bindTextureMemory(entry.texture, m_Heap, entry.offset)
+                : m_Device->bindBufferMemory(entry.buffer, m_Heap, entry.offset);
+
+            if (!bound)
+            {
+                std::stringstream ss;
+                ss << "Failed to bind transient " << (entry.isTexture ? "texture " : "buffer ")
+                    << utils::DebugNameToString(entry.isTexture ? entry.textureDesc.debugName : entry.bufferDesc.debugName)
+                    << " to the heap of pool " << utils::DebugNameToString(m_Desc.debugName);
+                error(ss.str());
+                return false;
+            }
+        }
+
+        findAliasingBarriers();
+
+        m_Compiled = true;
+        return true;
+    }
+
+    void TransientResourcePool::reset()
+    {
+        m_Entries.clear();
+        m_AliasingBarriers.clear();
+        m_Heap = nullptr;
+        m_HeapSize = 0;
+        m_TotalResourceSize = 0;
+        m_Compiled = false;
+    }
+
+    ITexture* TransientResourcePool::getTexture(TransientResourceId id)
+    {
+        if (id >= m_Entries.size() || !m_Entries[id].isTexture)
+            return nullptr;
+
+        return m_Entries[id].texture;
+    }
+
+    IBuffer* TransientResourcePool::getBuffer(TransientResourceId id)
+    {
+        if (id >= m_Entries.size() || m_Entries[id].isTexture)
+            return nullptr;
+
+        return m_Entries[id].buffer;
+    }
+
+    void TransientResourcePool::beginPass(ICommandList* commandList, uint32_t passIndex)
+    {
+        auto it = std::lower_bound(m_AliasingBarriers.begin(), m_AliasingBarriers.end(), passIndex,
+            [](const AliasingBarrier& barrier, uint32_t pass) { return barrier.passIndex < pass; });
+
+        for (; it != m_AliasingBarriers.end() && it->passIndex == passIndex; ++it)
+        {
+            IResource* before = it->before != c_InvalidTransientResource ? m_Entries[it->before].getResource() : nullptr;
+            commandList->aliasingBarrier(before, m_Entries[it->after].getResource());
+        }
+    }
+
+    TransientResourcePoolHandle createTransientResourcePool(IDevice* device, const TransientResourcePoolDesc& desc)
+    {
+        return TransientResourcePoolHandle::Create(new TransientResourcePool(device, desc));
+    }
+
+} // namespace nvrhi
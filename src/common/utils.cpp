@@ -21,6 +21,8 @@
 */
 
 #include <nvrhi/utils.h>
+#include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi::utils
@@ -82,7 +84,7 @@ namespace nvrhi::utils
                 layoutItem.slot = item.slot;
                 layoutItem.type = item.type;
                 layoutItem.size = 1;
-                if (item.type == ResourceType::PushConstants)
+                if (item.type == ResourceType::PushConstants || item.type == ResourceType::InlineUniformBlock)
                     layoutItem.size = uint32_t(item.range.byteSize);
                 layoutDesc.push_back(layoutItem);
             }
@@ -169,10 +171,11 @@ namespace nvrhi::utils
     {
         switch (api)
         {
-        case GraphicsAPI::D3D11:  return "D3D11";
-        case GraphicsAPI::D3D12:  return "D3D12";
-        case GraphicsAPI::VULKAN: return "Vulkan";
-        default:                         return "<UNKNOWN>";
+        case GraphicsAPI::D3D11:       return "D3D11";
+        case GraphicsAPI::D3D12:       return "D3D12";
+        case GraphicsAPI::VULKAN:      return "Vulkan";
+        case GraphicsAPI::NULL_DEVICE: return "Null";
+        default:                       return "<UNKNOWN>";
         }
     }
 
@@ -244,6 +247,7 @@ namespace nvrhi::utils
         case ResourceType::Sampler:                 return "Sampler";
         case ResourceType::RayTracingAccelStruct:   return "RayTracingAccelStruct";
         case ResourceType::PushConstants:           return "PushConstants";
+        case ResourceType::InlineUniformBlock:      return "InlineUniformBlock";
         case ResourceType::Count:
         default:                                    return "<INVALID>";
         }
@@ -382,51 +386,146 @@ namespace nvrhi::utils
     }
 
     BitSetAllocator::BitSetAllocator(const size_t capacity, bool multithreaded)
-        : m_MultiThreaded(multithreaded)
+        : m_Capacity(capacity)
+        , m_NumWords((capacity + 63) / 64)
+        , m_NumSummaryWords((m_NumWords + 63) / 64)
+        , m_MultiThreaded(multithreaded)
     {
-        m_Allocated.resize(capacity);
+        m_Words = std::make_unique<std::atomic<uint64_t>[]>(m_NumWords);
+        m_FullWords = std::make_unique<std::atomic<uint64_t>[]>(m_NumSummaryWords);
+
+        for (size_t wordIndex = 0; wordIndex < m_NumWords; wordIndex++)
+            m_Words[wordIndex].store(0, std::memory_order_relaxed);
+
+        for (size_t summaryIndex = 0; summaryIndex < m_NumSummaryWords; summaryIndex++)
+            m_FullWords[summaryIndex].store(0, std::memory_order_relaxed);
+
+        // Mark the indices past the capacity as allocated so that they're never returned
+        if (capacity % 64)
+        {
+            m_Words[m_NumWords - 1].store(~0ull << (capacity % 64), std::memory_order_relaxed);
+        }
     }
 
-    int BitSetAllocator::allocate()
+    void BitSetAllocator::setWordFull(size_t wordIndex, bool full)
     {
+        std::atomic<uint64_t>& summary = m_FullWords[wordIndex / 64];
+        const uint64_t mask = 1ull << (wordIndex % 64);
+
         if (m_MultiThreaded)
-            m_Mutex.lock();
+        {
+            if (full)
+                summary.fetch_or(mask);
+            else
+                summary.fetch_and(~mask);
+        }
+        else
+        {
+            const uint64_t value = summary.load(std::memory_order_relaxed);
+            summary.store(full ? (value | mask) : (value & ~mask), std::memory_order_relaxed);
+        }
+    }
 
-        int result = -1;
+    bool BitSetAllocator::allocateInWord(size_t wordIndex, int& outIndex)
+    {
+        std::atomic<uint64_t>& word = m_Words[wordIndex];
+        uint64_t value = word.load(std::memory_order_relaxed);
 
-        int capacity = static_cast<int>(m_Allocated.size());
-        for (int i = 0; i < capacity; i++)
+        while (value != ~0ull)
         {
-            int ii = (m_NextAvailable + i) % capacity;
+            const uint32_t bit = countTrailingZeros(~value);
+            const uint64_t newValue = value | (1ull << bit);
 
-            if (!m_Allocated[ii])
+            if (m_MultiThreaded)
+            {
+                // On failure, 'value' is updated with the current contents of the word
+                if (!word.compare_exchange_weak(value, newValue))
+                    continue;
+            }
+            else
             {
-                result = ii;
-                m_NextAvailable = (ii + 1) % capacity;
-                m_Allocated[ii] = true;
-                break;
+                word.store(newValue, std::memory_order_relaxed);
             }
+
+            if (newValue == ~0ull)
+            {
+                setWordFull(wordIndex, true);
+
+                // A concurrent release may have cleared a bit before the summary was updated,
+                // in which case its summary update could have been overwritten: undo ours.
+                if (m_MultiThreaded && word.load() != ~0ull)
+                    setWordFull(wordIndex, false);
+            }
+
+            outIndex = static_cast<int>(wordIndex * 64 + bit);
+            return true;
         }
 
-        if (m_MultiThreaded)
-            m_Mutex.unlock();
+        return false;
+    }
 
-        return result;
+    int BitSetAllocator::allocate()
+    {
+        const size_t searchStart = m_SearchStart.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < m_NumSummaryWords; i++)
+        {
+            const size_t summaryIndex = (searchStart + i) % m_NumSummaryWords;
+            uint64_t fullWords = m_FullWords[summaryIndex].load(std::memory_order_relaxed);
+
+            // Treat the summary bits past the last word as full
+            const size_t wordsInSummary = std::min<size_t>(64, m_NumWords - summaryIndex * 64);
+            if (wordsInSummary < 64)
+                fullWords |= ~0ull << wordsInSummary;
+
+            while (fullWords != ~0ull)
+            {
+                const uint32_t bit = countTrailingZeros(~fullWords);
+
+                int result;
+                if (allocateInWord(summaryIndex * 64 + bit, result))
+                {
+                    if (summaryIndex != searchStart)
+                        m_SearchStart.store(summaryIndex, std::memory_order_relaxed);
+
+                    return result;
+                }
+
+                // The word was filled up by another thread
+                fullWords |= 1ull << bit;
+            }
+        }
+
+        return -1;
     }
 
     void BitSetAllocator::release(const int index)
     {
-        if (index >= 0 && index < static_cast<int>(m_Allocated.size()))
-        {
-            if (m_MultiThreaded)
-                m_Mutex.lock();
+        if (index < 0 || size_t(index) >= m_Capacity)
+            return;
 
-            m_Allocated[index] = false;
-            m_NextAvailable = std::min(m_NextAvailable, index);
+        const size_t wordIndex = size_t(index) / 64;
+        const uint64_t mask = 1ull << (index % 64);
+        std::atomic<uint64_t>& word = m_Words[wordIndex];
 
-            if (m_MultiThreaded)
-                m_Mutex.unlock();
+        uint64_t oldValue;
+        if (m_MultiThreaded)
+        {
+            oldValue = word.fetch_and(~mask);
+        }
+        else
+        {
+            oldValue = word.load(std::memory_order_relaxed);
+            word.store(oldValue & ~mask, std::memory_order_relaxed);
         }
+
+        // Only touch the shared summary word when this word stops being full
+        if (oldValue == ~0ull)
+            setWordFull(wordIndex, false);
+
+        const size_t summaryIndex = wordIndex / 64;
+        if (summaryIndex < m_SearchStart.load(std::memory_order_relaxed))
+            m_SearchStart.store(summaryIndex, std::memory_order_relaxed);
     }
 
 }
@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nvrhi
+{
+    // Insert-only cache of the views created for a resource, read from many threads and rarely written.
+    // Lookups are lock-free: the entries live in an open-addressing table of atomic pointers, and each entry
+    // keeps the hash of its key so that probing compares hashes before keys. Insertions take a mutex, and when
+    // the table grows, the old one is kept alive until the cache is destroyed, since readers may still be probing it.
+    // Values are never moved, so the returned references stay valid for the lifetime of the cache.
+    template<typename TKey, typename TValue, typename THash = std::hash<TKey>>
+    class ViewCache
+    {
+    public:
+        ViewCache() = default;
+        ViewCache(const ViewCache&) = delete;
+        ViewCache& operator=(const ViewCache&) = delete;
+
+        [[nodiscard]] static size_t hash(const TKey& key) { return THash()(key); }
+
+        // Returns the cached value, or nullptr if there is none yet
+        [[nodiscard]] TValue* find(const TKey& key, size_t keyHash) const
+        {
+            const Table* table = m_Table.load(std::memory_order_acquire);
+            if (!table)
+                return nullptr;
+
+            Entry* entry = findInTable(*table, key, keyHash);
+            return entry ? &entry->value : nullptr;
+        }
+
+        // Returns the cached value, otherwise constructs one from 'args', calls 'initialize' on it
+        // and publishes it. 'initialize' runs under the insertion lock, at most once per key.
+        template<typename TInitialize, typename... TArgs>
+        TValue& getOrCreate(const TKey& key, size_t keyHash, TInitialize&& initialize, TArgs&&... args)
+        {
+            if (TValue* value = find(key, keyHash))
+                return *value;
+
+            std::lock_guard lockGuard(m_Mutex);
+
+            // Another thread may have inserted the same key while this one was waiting
+            Table* table = m_Table.load(std::memory_order_relaxed);
+            if (table)
+            {
+                if (Entry* entry = findInTable(*table, key, keyHash))
+                    return entry->value;
+            }
+
+            auto entry = std::make_unique<Entry>(key, keyHash, std::forward<TArgs>(args)...);
+            initialize(entry->value);
+
+            if (!table || (m_Entries.size() + 1) * 2 > table->capacity)
+                table = grow();
+
+            insertIntoTable(*table, entry.get());
+            m_Entries.push_back(std::move(entry));
+
+            return m_Entries.back()->value;
+        }
+
+        // Not thread-safe, only for use when no other thread accesses the cache, e.g. in the resource destructor
+        template<typename TFunction>
+        void forEach(TFunction&& function)
+        {
+            for (const auto& entry : m_Entries)
+                function(entry->key, entry->value);
+        }
+
+    private:
+        struct Entry
+        {
+            TKey key;
+            size_t keyHash;
+            TValue value;
+
+            template<typename... TArgs>
+            Entry(const TKey& _key, size_t _keyHash, TArgs&&... args)
+                : key(_key)
+                , keyHash(_keyHash)
+                , value(std::forward<TArgs>(args)...)
+            { }
+        };
+
+        struct Table
+        {
+            size_t capacity = 0; // power of 2
+            std::unique_ptr<std::atomic<Entry*>[]> slots;
+
+            explicit Table(size_t _capacity)
+                : capacity(_capacity)
+                , slots(new std::atomic<Entry*>[_capacity])
+            {
+                for (size_t index = 0; index < capacity; ++index)
+                    slots[index].store(nullptr, std::memory_order_relaxed);
+            }
+        };
+
+        static constexpr size_t c_InitialCapacity = 8;
+
+        std::atomic<Table*> m_Table = nullptr;
+        std::vector<std::unique_ptr<Table>> m_Tables; // all tables ever published, the last one is current
+        std::vector<std::unique_ptr<Entry>> m_Entries;
+        std::mutex m_Mutex;
+
+        static Entry* findInTable(const Table& table, const TKey& key, size_t keyHash)
+        {
+            const size_t mask = table.capacity - 1;
+            for (size_t index = keyHash & mask; ; index = (index + 1) & mask)
+            {
+                Entry* entry = table.slots[index].load(std::memory_order_acquire);
+                if (!entry)
+                    return nullptr;
+
+                if (entry->keyHash == keyHash && entry->key == key)
+                    return entry;
+            }
+        }
+
+        static void insertIntoTable(Table& table, Entry* entry)
+        {
+            // The table is never more than half full, so there is always a free slot
+            const size_t mask = table.capacity - 1;
+            size_t index = entry->keyHash & mask;
+            while (table.slots[index].load(std::memory_order_relaxed))
+                index = (index + 1) & mask;
+
+            table.slots[index].store(entry, std::memory_order_release);
+        }
+
+        Table* grow()
+        {
+            const Table* oldTable = m_Table.load(std::memory_order_relaxed);
+            auto table = std::make_unique<Table>(oldTable ? oldTable->capacity * 2 : c_InitialCapacity);
+
+            for (const auto& entry : m_Entries)
+                insertIntoTable(*table, entry.get());
+
+            Table* result = table.get();
+            m_Tables.push_back(std::move(table));
+            m_Table.store(result, std::memory_order_release);
+            return result;
+        }
+    };
+
+} // namespace nvrhi
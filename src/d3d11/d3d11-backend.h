@@ -26,9 +26,16 @@
 #include <nvrhi/common/resourcebindingmap.h>
 #include <nvrhi/utils.h>
 #include "../common/dxgi-format.h"
+#include "../common/d3d-texture-blitter.h"
+#include "../common/deduplication-cache.h"
+#include "../common/pipeline-compiler.h"
+#include "../common/shader-permutation-cache.h"
+#include "../common/graphics-state-cache.h"
+#include "../common/memory-statistics.h"
 
 #include <d3d11_1.h>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #ifndef NVRHI_D3D11_WITH_NVAPI
@@ -63,8 +70,12 @@ namespace nvrhi::d3d11
         RefCountPtr<ID3D11DeviceContext> immediateContext;
         RefCountPtr<ID3D11DeviceContext1> immediateContext1;
         RefCountPtr<ID3D11Buffer> pushConstantBuffer;
+        std::unique_ptr<MemoryStatisticsTracker> memoryStatistics;
         IMessageCallback* messageCallback = nullptr;
         bool nvapiAvailable = false;
+        // D3D11_FEATURE_DATA_THREADING::DriverCommandLists; without it, the runtime emulates deferred contexts
+        // and applies the destination box of UpdateSubresource to the source pointer as well
+        bool driverCommandLists = false;
 #if NVRHI_WITH_AFTERMATH
         GFSDK_Aftermath_ContextHandle aftermathContext = nullptr;
 #endif
@@ -79,7 +90,11 @@ namespace nvrhi::d3d11
         RefCountPtr<ID3D11Resource> resource;
         HANDLE sharedHandle = nullptr;
 
+        // Estimated size counted in MemoryCategory::Textures, 0 for native textures
+        uint64_t trackedMemorySize = 0;
+
         Texture(const Context& context) : m_Context(context) { }
+        ~Texture() override;
         const TextureDesc& getDesc() const override { return desc; }
         Object getNativeObject(ObjectType objectType) override;
         Object getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV = false) override;
@@ -113,8 +128,12 @@ namespace nvrhi::d3d11
         BufferDesc desc;
         RefCountPtr<ID3D11Buffer> resource;
         HANDLE sharedHandle = nullptr;
+
+        // Size counted in MemoryCategory::Buffers, 0 for native buffers
+        uint64_t trackedMemorySize = 0;
         
         Buffer(const Context& context) : m_Context(context) { }
+        ~Buffer() override;
         const BufferDesc& getDesc() const override { return desc; }
         GpuVirtualAddress getGpuVirtualAddress() const override { nvrhi::utils::NotImplemented(); return 0; }
         Object getNativeObject(ObjectType objectType) override;
@@ -139,6 +158,7 @@ namespace nvrhi::d3d11
         RefCountPtr<ID3D11PixelShader> PS;
         RefCountPtr<ID3D11ComputeShader> CS;
         std::vector<char> bytecode;
+        ShaderHandle baseShader; // Set for specializations, which are built from the bytecode of this shader
         
         const ShaderDesc& getDesc() const override { return desc; }
 
@@ -171,6 +191,30 @@ namespace nvrhi::d3d11
         bool resolved = false;
         float time = 0.f;
     };
+
+    class OcclusionQuery : public RefCounter<IOcclusionQuery>
+    {
+    public:
+        OcclusionQueryType type = OcclusionQueryType::SampleCount;
+
+        // binary queries are created as predicates, which can also be used with SetPredication
+        RefCountPtr<ID3D11Query> query;
+        RefCountPtr<ID3D11Predicate> predicate;
+
+        bool resolved = false;
+        uint64_t result = 0;
+
+        OcclusionQueryType getType() const override { return type; }
+    };
+
+    class PipelineStatisticsQuery : public RefCounter<IPipelineStatisticsQuery>
+    {
+    public:
+        RefCountPtr<ID3D11Query> query;
+
+        bool resolved = false;
+        PipelineStatistics result;
+    };
     
     class InputLayout : public RefCounter<IInputLayout>
     {
@@ -283,10 +327,10 @@ namespace nvrhi::d3d11
         bool isSupersetOf(const BindingSet& other) const;
     };
 
-    class CommandList : public RefCounter<ICommandList>
+    class CommandList final : public RefCounter<ICommandList>
     {
     public:
-        explicit CommandList(const Context& context, IDevice* device, const CommandListParameters& params);
+        explicit CommandList(const Context& context, IDevice* device, ID3D11DeviceContext* deviceContext, const CommandListParameters& params);
         ~CommandList() override;
 
         // IResource implementation
@@ -305,12 +349,18 @@ namespace nvrhi::d3d11
         void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
         void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, Format format) override;
         void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources) override;
+        void* beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch) override;
+        void endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter) override;
+        void blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -319,10 +369,17 @@ namespace nvrhi::d3d11
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) override;
+        void setIndexBuffer(const IndexBufferBinding& indexBuffer) override;
+        void setViewportState(const ViewportState& viewport) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void executeBundles(ICommandList* const* bundles, size_t numBundles) override { (void)bundles; (void)numBundles; }
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -330,22 +387,40 @@ namespace nvrhi::d3d11
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void beginTimerQueryFrame(ITimerQueryPool* pool) override;
+        void beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimerQueries(ITimerQueryPool* pool) override;
+        void beginOcclusionQuery(IOcclusionQuery* query) override;
+        void endOcclusionQuery(IOcclusionQuery* query) override;
+        void beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void endPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void setPredication(IOcclusionQuery* query, PredicationOp op) override;
+        SyncPointHandle signalSyncPoint() override;
+        void waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages) override;
 
         // perf markers
         void beginMarker(const char* name) override;
@@ -367,19 +442,49 @@ namespace nvrhi::d3d11
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override { (void)texture; (void)stateBits; }
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override { (void)buffer; (void)stateBits; }
 
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override { (void)texture; (void)subresources; (void)stateBits; }
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override { (void)buffer; (void)stateBits; }
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override { (void)resourceBefore; (void)resourceAfter; }
+
         void commitBarriers() override { }
 
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override { (void)texture; (void)arraySlice; (void)mipLevel; return ResourceStates::Common; }
         ResourceStates getBufferState(IBuffer* buffer) override { (void)buffer; return ResourceStates::Common; }
 
         IDevice* getDevice() override { return m_Device; }
+        MemoryStatistics getMemoryStatistics() override { return MemoryStatistics(); }
         const CommandListParameters& getDesc() override { return m_Desc; }
 
+        // The commands recorded by a deferred command list since it was last opened, produced by close()
+        [[nodiscard]] ID3D11CommandList* getRecordedCommandList() const { return m_RecordedCommandList; }
+
+        // Shader stages with their own resource slots, in the order of the *SSet* methods of the context
+        enum class Stage : uint8_t
+        {
+            Vertex,
+            Hull,
+            Domain,
+            Geometry,
+            Pixel,
+            Compute,
+
+            Count
+        };
+
     private:
         const Context& m_Context;
         IDevice* m_Device; // weak reference - to avoid a cyclic reference between Device and its ImmediateCommandList
         CommandListParameters m_Desc;
 
+        // The immediate context, or a deferred context if the list was created with enableImmediateExecution = false
+        RefCountPtr<ID3D11DeviceContext> m_DeviceContext;
+        RefCountPtr<ID3D11DeviceContext1> m_DeviceContext1; // null without D3D11.1, see Feature::ConstantBufferRanges
+        RefCountPtr<ID3D11CommandList> m_RecordedCommandList;
+
+        // Source of the push constant buffer updates; UpdateSubresource has to copy the whole buffer.
+        // Kept per command list so that deferred lists can be recorded on several threads.
+        char m_PushConstantPaddingBuffer[c_MaxPushConstantSize] = {};
+
         RefCountPtr<ID3DUserDefinedAnnotation> m_UserDefinedAnnotation;
 #if NVRHI_WITH_AFTERMATH
         AftermathMarkerTracker m_AftermathTracker;
@@ -408,8 +513,57 @@ namespace nvrhi::d3d11
         Color m_CurrentBlendConstantColor{};
         uint8_t m_CurrentStencilRefValue = 0;
         bool m_CurrentGraphicsStateValid = false;
+        PendingGraphicsState m_PendingGraphicsState;
+
+        // Framebuffer last rendered to since open(), the attachment load ops apply when a different one is used
+        FramebufferHandle m_LastRenderPassFramebuffer;
         bool m_CurrentComputeStateValid = false;
 
+        // Shadow of the resources bound to the slots of each stage, used to skip the slots that don't change.
+        // Raw pointers are fine here because the context holds references to the bound objects.
+        struct StageBindings
+        {
+            ID3D11ShaderResourceView* SRVs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+            ID3D11SamplerState* samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+            ID3D11Buffer* constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+            UINT constantBufferOffsets[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+            UINT constantBufferCounts[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+        };
+        StageBindings m_StageBindings[uint32_t(Stage::Count)] = {};
+
+        // Shadow of the compute UAV slots. Pixel shader UAVs are bound together with the render targets instead.
+        ID3D11UnorderedAccessView* m_ComputeUAVs[D3D11_1_UAV_SLOT_COUNT] = {};
+
+        // Union of the slot ranges of some binding sets, empty ranges have min > max like in BindingSet
+        struct SlotRanges
+        {
+            uint32_t minSRVSlot = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+            uint32_t maxSRVSlot = 0;
+            uint32_t minSamplerSlot = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+            uint32_t maxSamplerSlot = 0;
+            uint32_t minConstantBufferSlot = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+            uint32_t maxConstantBufferSlot = 0;
+            uint32_t minUAVSlot = D3D11_1_UAV_SLOT_COUNT;
+            uint32_t maxUAVSlot = 0;
+
+            void include(const BindingSet& set);
+            [[nodiscard]] bool isEmpty() const;
+        };
+
+        // Binding sets created with createTransientBindingSet, released when the command list is reopened
+        std::vector<BindingSetHandle> m_TransientBindingSets;
+
+        // Subresources between beginTextureWrite and endTextureWrite, written into CPU memory for UpdateSubresource
+        struct PendingTextureWrite
+        {
+            RefCountPtr<Texture> dest;
+            UINT subresource = 0;
+            UINT rowPitch = 0;
+            UINT depthPitch = 0;
+            std::vector<uint8_t> data;
+        };
+        std::vector<PendingTextureWrite> m_PendingTextureWrites;
+
         void copyTexture(ID3D11Resource* dst, const TextureDesc& dstDesc, const TextureSlice& dstSlice,
             ID3D11Resource* src, const TextureDesc& srcDesc, const TextureSlice& srcSlice);
         
@@ -421,9 +575,35 @@ namespace nvrhi::d3d11
             const IGraphicsPipeline* currentPipeline,
             const IGraphicsPipeline* newPipeline,
             bool updateFramebuffer,
-            BindingSetVector& outSetsToBind) const;
-        void bindGraphicsResourceSets(const BindingSetVector& setsToBind, const IGraphicsPipeline* newPipeline) const;
-        void bindComputeResourceSets(const BindingSetVector& resourceSets, const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets) const;
+            BindingSetVector& outSetsToBind);
+        void bindGraphicsResourceSets(const BindingSetVector& setsToBind, const IGraphicsPipeline* newPipeline);
+        void bindPixelShaderUAVs(const BindingSetVector& bindings) const;
+        void bindVertexBuffers(const GraphicsPipeline* pipeline, const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers) const;
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer) const;
+        void setViewports(const ViewportState& viewport) const;
+        void commitGraphicsStateChanges();
+        void bindComputeResourceSets(const BindingSetVector& resourceSets, const static_vector<BindingSetHandle, c_MaxBindingLayouts>* currentResourceSets);
+
+        // Set the slots in [minSlot, maxSlot] that differ from m_StageBindings, one call per contiguous run.
+        // Constant buffers bound without offsets and counts are recorded as covering the whole buffer.
+        void setShaderResourceViews(Stage stage, uint32_t minSlot, uint32_t maxSlot, ID3D11ShaderResourceView* const* views);
+        void setSamplers(Stage stage, uint32_t minSlot, uint32_t maxSlot, ID3D11SamplerState* const* samplers);
+        void setConstantBuffers(Stage stage, uint32_t minSlot, uint32_t maxSlot, ID3D11Buffer* const* buffers, const UINT* offsets, const UINT* counts);
+        void setComputeUnorderedAccessViews(uint32_t minSlot, uint32_t maxSlot, ID3D11UnorderedAccessView* const* views);
+        void bindSetToStage(const BindingSet* set, Stage stage);
+
+        // Copy the slots in the ranges of the set from source into target, or clear them if source is nullptr.
+        // With the set as the source, the target gets the contents that binding the set would produce.
+        static void copySetSlots(StageBindings& target, const BindingSet& set, const StageBindings* source);
+        static void copySetSlots(StageBindings& target, const BindingSet& set, const BindingSet& source);
+        // Set the slots in the ranges that differ from the shadow of the stage
+        void setStageBindings(Stage stage, const StageBindings& target, const SlotRanges& ranges);
+
+        // Unbind the resources of the current state that may conflict with a state of the other pipeline type,
+        // and invalidate that state. Cheaper than clearState() because the remaining bindings stay in place.
+        void unbindGraphicsResources();
+        void unbindComputeResources();
+        void applyAttachmentLoadOps(Framebuffer* framebuffer);
     };
 
     class Device : public RefCounter<IDevice>
@@ -452,12 +632,14 @@ namespace nvrhi::d3d11
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags) override;
         void unmapBuffer(IBuffer* b) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
@@ -484,6 +666,17 @@ namespace nvrhi::d3d11
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimerQueryPoolHandle createTimerQueryPool(const TimerQueryPoolDesc& desc) override;
+        bool getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries) override;
+        bool getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries) override;
+        OcclusionQueryHandle createOcclusionQuery(OcclusionQueryType type) override;
+        bool pollOcclusionQuery(IOcclusionQuery* query) override;
+        uint64_t getOcclusionQueryResult(IOcclusionQuery* query) override;
+        void resetOcclusionQuery(IOcclusionQuery* query) override;
+        PipelineStatisticsQueryHandle createPipelineStatisticsQuery() override;
+        bool pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        PipelineStatistics getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query) override;
+        void resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -500,6 +693,11 @@ namespace nvrhi::d3d11
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        AsyncGraphicsPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback = nullptr) override;
+        AsyncComputePipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback = nullptr) override;
+        AsyncMeshletPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback = nullptr) override;
+        rt::AsyncPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback = nullptr) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -509,6 +707,7 @@ namespace nvrhi::d3d11
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems) override;
 
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
@@ -517,27 +716,38 @@ namespace nvrhi::d3d11
         bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
 
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
-        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override { (void)pCommandLists; (void)numCommandLists; (void)executionQueue; return 0; }
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override { (void)waitQueue; (void)executionQueue; (void)instance; }
+        StorageQueueHandle createStorageQueue(const StorageQueueDesc& desc) override;
         bool waitForIdle() override;
-        void runGarbageCollection() override { }
+        void runGarbageCollection() override;
+        bool getVideoMemoryBudget(VideoMemoryBudget& outBudget) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void setResidencyPriority(IResource* resource, ResidencyPriority priority) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        void getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override { (void)objectType; (void)queue;  return nullptr; }
+        bool getPipelineCacheData(std::vector<uint8_t>& outData) override { outData.clear(); return false; }
+        bool mergePipelineCacheData(const void* data, size_t size) override { (void)data; (void)size; return false; }
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
 
+        // Internal interface
+        D3DTextureBlitter& getTextureBlitter() { return *m_TextureBlitter; }
+
     private:
         Context m_Context;
         EventQueryHandle m_WaitForIdleQuery;
         CommandListHandle m_ImmediateCommandList;
 
-        std::unordered_map<size_t, RefCountPtr<ID3D11BlendState>> m_BlendStates;
-        std::unordered_map<size_t, RefCountPtr<ID3D11DepthStencilState>> m_DepthStencilStates;
-        std::unordered_map<size_t, RefCountPtr<ID3D11RasterizerState>> m_RasterizerStates;
+        std::unordered_map<BlendState, RefCountPtr<ID3D11BlendState>> m_BlendStates;
+        std::unordered_map<DepthStencilState, RefCountPtr<ID3D11DepthStencilState>> m_DepthStencilStates;
+        std::unordered_map<RasterState, RefCountPtr<ID3D11RasterizerState>> m_RasterizerStates;
+        std::mutex m_StateCacheMutex; // the caches are also used by pipelines created on the pipeline compiler threads
 
         bool m_SinglePassStereoSupported = false;
         bool m_HlslExtensionsSupported = false;
@@ -554,6 +764,11 @@ namespace nvrhi::d3d11
 
         bool m_AftermathEnabled = false;
         AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
+
+        PipelineCompiler m_PipelineCompiler;
+        std::unique_ptr<ObjectDeduplicationCaches> m_Deduplication;
+        std::unique_ptr<ShaderPermutationCache> m_ShaderPermutations;
+        std::unique_ptr<D3DTextureBlitter> m_TextureBlitter;
     };
 
 } // namespace nvrhi::d3d11
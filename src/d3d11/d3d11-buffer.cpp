@@ -45,6 +45,12 @@ namespace nvrhi::d3d11
         }
     }
 
+    Buffer::~Buffer()
+    {
+        if (trackedMemorySize)
+            m_Context.memoryStatistics->released(MemoryCategory::Buffers, trackedMemorySize);
+    }
+
     BufferHandle Device::createBuffer(const BufferDesc& d)
     {
         assert(d.byteSize <= UINT_MAX);
@@ -141,6 +147,8 @@ namespace nvrhi::d3d11
         buffer->desc = d;
         buffer->resource = newBuffer;
         buffer->sharedHandle = sharedHandle;
+        buffer->trackedMemorySize = desc11.ByteWidth;
+        m_Context.memoryStatistics->allocated(MemoryCategory::Buffers, buffer->trackedMemorySize, d.debugName.c_str());
         return BufferHandle::Create(buffer);
     }
 
@@ -156,9 +164,21 @@ namespace nvrhi::d3d11
             D3D11_MAPPED_SUBRESOURCE mappedData;
             D3D11_MAP mapType = D3D11_MAP_WRITE_DISCARD;
             if (destOffsetBytes > 0 || dataSize + destOffsetBytes < buffer->desc.byteSize)
+            {
+                // Deferred contexts can only map dynamic resources with WRITE_DISCARD or WRITE_NO_OVERWRITE
+                if (!m_Desc.enableImmediateExecution)
+                {
+                    std::stringstream ss;
+                    ss << "Cannot write a part of buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                        << " in a deferred command list because it has CPU write access; write the whole buffer instead";
+                    m_Context.error(ss.str());
+                    return;
+                }
+
                 mapType = D3D11_MAP_WRITE;
+            }
 
-            const HRESULT res = m_Context.immediateContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
+            const HRESULT res = m_DeviceContext->Map(buffer->resource, 0, mapType, 0, &mappedData);
             if (FAILED(res))
             {
                 std::stringstream ss;
@@ -169,14 +189,19 @@ namespace nvrhi::d3d11
             }
 
             memcpy((char*)mappedData.pData + destOffsetBytes, data, dataSize);
-            m_Context.immediateContext->Unmap(buffer->resource, 0);
+            m_DeviceContext->Unmap(buffer->resource, 0);
         }
         else
         {
             D3D11_BOX box = { UINT(destOffsetBytes), 0, 0, UINT(destOffsetBytes + dataSize), 1, 1 };
             bool useBox = destOffsetBytes > 0 || dataSize < buffer->desc.byteSize;
 
-            m_Context.immediateContext->UpdateSubresource(buffer->resource, 0, useBox ? &box : nullptr, data, (UINT)dataSize, 0);
+            // Compensate for the box offset that the emulated deferred contexts also apply to the source, see Context::driverCommandLists
+            const char* srcData = static_cast<const char*>(data);
+            if (useBox && !m_Desc.enableImmediateExecution && !m_Context.driverCommandLists)
+                srcData -= destOffsetBytes;
+
+            m_DeviceContext->UpdateSubresource(buffer->resource, 0, useBox ? &box : nullptr, srcData, (UINT)dataSize, 0);
         }
     }
 
@@ -191,7 +216,7 @@ namespace nvrhi::d3d11
         ID3D11UnorderedAccessView* uav = checked_cast<Buffer*>(buffer)->getUAV(Format::UNKNOWN, EntireBuffer, viewType);
 
         UINT clearValues[4] = { clearValue, clearValue, clearValue, clearValue };
-        m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+        m_DeviceContext->ClearUnorderedAccessViewUint(uav, clearValues);
     }
 
     void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
@@ -210,10 +235,15 @@ namespace nvrhi::d3d11
         srcBox.top = 0;
         srcBox.front = 0;
         srcBox.back = 1;
-        m_Context.immediateContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
+        m_DeviceContext->CopySubresourceRegion(dest->resource, 0, (UINT)destOffsetBytes, 0, 0, src->resource, 0, &srcBox);
     }
     
     void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags)
+    {
+        return mapBuffer(_buffer, flags, MapBufferFlags::None);
+    }
+
+    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, MapBufferFlags mapFlags)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
@@ -227,7 +257,7 @@ namespace nvrhi::d3d11
 
             case CpuAccessMode::Write:
                 assert(buffer->desc.cpuAccess == CpuAccessMode::Write);
-                mapType = D3D11_MAP_WRITE_DISCARD;
+                mapType = (mapFlags & MapBufferFlags::NoOverwrite) != 0 ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
                 break;
 
             default:
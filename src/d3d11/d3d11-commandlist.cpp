@@ -22,17 +22,23 @@
 
 #include "d3d11-backend.h"
 #include <nvrhi/utils.h>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
 
 namespace nvrhi::d3d11
 {
-    CommandList::CommandList(const Context& context, IDevice* device, const CommandListParameters& params)
+    CommandList::CommandList(const Context& context, IDevice* device, ID3D11DeviceContext* deviceContext, const CommandListParameters& params)
         : m_Context(context)
         , m_Device(device)
         , m_Desc(params)
+        , m_DeviceContext(deviceContext)
     {
-        m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
+        m_DeviceContext->QueryInterface(IID_PPV_ARGS(&m_DeviceContext1));
+        m_DeviceContext->QueryInterface(IID_PPV_ARGS(&m_UserDefinedAnnotation));
 #if NVRHI_WITH_AFTERMATH
-        if (m_Device->isAftermathEnabled())
+        // The Aftermath context handle belongs to the immediate context
+        if (m_Device->isAftermathEnabled() && m_Desc.enableImmediateExecution)
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
 #endif
     }
@@ -40,7 +46,7 @@ namespace nvrhi::d3d11
     CommandList::~CommandList()
     {
 #if NVRHI_WITH_AFTERMATH
-        if (m_Device->isAftermathEnabled())
+        if (m_Device->isAftermathEnabled() && m_Desc.enableImmediateExecution)
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
 #endif
     }
@@ -50,7 +56,7 @@ namespace nvrhi::d3d11
         switch (objectType)
         {
         case ObjectTypes::D3D11_DeviceContext:
-            return Object(m_Context.immediateContext);
+            return Object(m_DeviceContext);
         default:
             return nullptr;
         }
@@ -59,6 +65,11 @@ namespace nvrhi::d3d11
     void CommandList::open()
     {
         clearState();
+
+        m_TransientBindingSets.clear();
+        m_PendingTextureWrites.clear();
+        m_RecordedCommandList = nullptr;
+        m_LastRenderPassFramebuffer = nullptr;
     }
 
     void CommandList::close()
@@ -67,21 +78,39 @@ namespace nvrhi::d3d11
             leaveUAVOverlapSection();
 
         clearState();
+
+        if (!m_Desc.enableImmediateExecution)
+        {
+            // The state of the deferred context has just been cleared, no need to restore it
+            const HRESULT res = m_DeviceContext->FinishCommandList(FALSE, &m_RecordedCommandList);
+            if (FAILED(res))
+            {
+                std::stringstream ss;
+                ss << "FinishCommandList call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+                m_Context.error(ss.str());
+            }
+        }
     }
 
     void CommandList::clearState()
     {
-        m_Context.immediateContext->ClearState();
+        m_DeviceContext->ClearState();
 
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_CurrentGraphicsStateValid && m_CurrentSinglePassStereoState.enabled)
         {
-            NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, 1, 0, 0);
+            NvAPI_D3D_SetSinglePassStereoMode(m_DeviceContext, 1, 0, 0);
         }
 #endif
 
         m_CurrentGraphicsStateValid = false;
         m_CurrentComputeStateValid = false;
+        m_PendingGraphicsState.reset();
+
+        // ClearState unbinds everything from all stages
+        for (StageBindings& stageBindings : m_StageBindings)
+            stageBindings = StageBindings{};
+        std::fill(std::begin(m_ComputeUAVs), std::end(m_ComputeUAVs), nullptr);
 
         // Release the strong references to pipeline objects
         m_CurrentGraphicsPipeline = nullptr;
@@ -118,7 +147,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 0)
-            NvAPI_D3D11_BeginUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_BeginUAVOverlap(m_DeviceContext);
 #endif
 
         m_NumUAVOverlapCommands += 1;
@@ -128,7 +157,7 @@ namespace nvrhi::d3d11
     {
 #if NVRHI_D3D11_WITH_NVAPI
         if (m_NumUAVOverlapCommands == 1)
-            NvAPI_D3D11_EndUAVOverlap(m_Context.immediateContext);
+            NvAPI_D3D11_EndUAVOverlap(m_DeviceContext);
 #endif
 
         m_NumUAVOverlapCommands = std::max(0, m_NumUAVOverlapCommands - 1);
@@ -144,7 +173,7 @@ namespace nvrhi::d3d11
             m_UserDefinedAnnotation->BeginEvent(bufW);
         }
 #if NVRHI_WITH_AFTERMATH
-        if (m_Device->isAftermathEnabled())
+        if (m_Device->isAftermathEnabled() && m_Desc.enableImmediateExecution)
         {
             const size_t aftermathMarker = m_AftermathTracker.pushEvent(name);
             GFSDK_Aftermath_SetEventMarker(m_Context.aftermathContext, (const void*)aftermathMarker, 0);
@@ -159,23 +188,21 @@ namespace nvrhi::d3d11
             m_UserDefinedAnnotation->EndEvent();
         }
 #if NVRHI_WITH_AFTERMATH
-        if (m_Device->isAftermathEnabled())
+        if (m_Device->isAftermathEnabled() && m_Desc.enableImmediateExecution)
             m_AftermathTracker.popEvent();
 #endif
     }
     
-    static char g_PushConstantPaddingBuffer[c_MaxPushConstantSize] = {};
-
     void CommandList::setPushConstants(const void* data, size_t byteSize)
     {
         if (byteSize > c_MaxPushConstantSize)
             return;
 
-        memcpy(g_PushConstantPaddingBuffer, data, byteSize);
+        memcpy(m_PushConstantPaddingBuffer, data, byteSize);
 
-        m_Context.immediateContext->UpdateSubresource(
+        m_DeviceContext->UpdateSubresource(
             m_Context.pushConstantBuffer, 0, nullptr, 
-            g_PushConstantPaddingBuffer, 0, 0);
+            m_PushConstantPaddingBuffer, 0, 0);
     }
 
     void CommandList::setMeshletState(const MeshletState&)
@@ -188,6 +215,31 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::dispatchMeshIndirect(uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::drawIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::executeIndirect(ICommandSignature*, uint32_t, uint32_t, uint32_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::setRayTracingState(const rt::State&)
     {
         utils::NotSupported();
@@ -203,11 +255,26 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
+    void CommandList::compactOpacityMicromaps()
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct*, const rt::GeometryDesc*, size_t, rt::AccelStructBuildFlags)
     {
         utils::NotSupported();
     }
 
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::compactBottomLevelAccelStructs()
     {
         utils::NotSupported();
@@ -223,6 +290,11 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void CommandList::updateTopLevelAccelStructInstances(rt::IAccelStruct*, size_t, const rt::InstanceDesc*, size_t)
+    {
+        utils::NotSupported();
+    }
+
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc&)
     {
         utils::NotSupported();
@@ -29,12 +29,23 @@ namespace nvrhi::d3d11
 
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        if (m_Deduplication)
+        {
+            if (ComputePipelineHandle existing = m_Deduplication->computePipelines.find(desc))
+                return existing;
+        }
+
         ComputePipeline *pso = new ComputePipeline();
         pso->desc = desc;
 
         if (desc.CS) pso->shader = checked_cast<Shader*>(desc.CS.Get())->CS;
 
-        return ComputePipelineHandle::Create(pso);
+        ComputePipelineHandle pipeline = ComputePipelineHandle::Create(pso);
+
+        if (m_Deduplication)
+            pipeline = m_Deduplication->computePipelines.insert(desc, pipeline);
+
+        return pipeline;
     }
 
     void CommandList::setComputeState(const ComputeState& state)
@@ -44,16 +55,16 @@ namespace nvrhi::d3d11
         if (m_CurrentGraphicsStateValid)
         {
             // If the previous operation has been a Draw call, there is a possibility of RT/UAV/SRV hazards.
-            // Unbind everything to be sure, and to avoid checking the binding sets against each other. 
+            // Unbind the graphics outputs and shader resources, and avoid checking the binding sets against each other.
             // This only happens on switches between compute and graphics modes.
 
-            clearState();
+            unbindGraphicsResources();
         }
 
         bool updatePipeline = !m_CurrentComputeStateValid || pso != m_CurrentComputePipeline;
         bool updateBindings = updatePipeline || arraysAreDifferent(m_CurrentBindings, state.bindings);
 
-        if (updatePipeline) m_Context.immediateContext->CSSetShader(pso->shader, nullptr, 0);
+        if (updatePipeline) m_DeviceContext->CSSetShader(pso->shader, nullptr, 0);
         if (updateBindings) bindComputeResourceSets(state.bindings, m_CurrentComputeStateValid ? &m_CurrentBindings : nullptr);
 
         m_CurrentIndirectBuffer = state.indirectParams;
@@ -74,7 +85,7 @@ namespace nvrhi::d3d11
 
     void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
     {
-        m_Context.immediateContext->Dispatch(groupsX, groupsY, groupsZ);
+        m_DeviceContext->Dispatch(groupsX, groupsY, groupsZ);
     }
 
     void CommandList::dispatchIndirect(uint32_t offsetBytes)
@@ -83,7 +94,7 @@ namespace nvrhi::d3d11
         
         if (indirectParams) // validation layer will issue an error otherwise
         {
-            m_Context.immediateContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
+            m_DeviceContext->DispatchIndirect(indirectParams->resource, (UINT)offsetBytes);
         }
     }
 
@@ -21,8 +21,10 @@
 */
 
 #include "d3d11-backend.h"
+#include "../common/storage-queue.h"
 
 #include <nvrhi/utils.h>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -45,12 +47,18 @@ namespace nvrhi::d3d11
     }
 
     Device::Device(const DeviceDesc& desc)
+        : m_PipelineCompiler(desc.pipelineCompilerThreadCount)
     {
         m_Context.messageCallback = desc.messageCallback;
+        m_Context.memoryStatistics = std::make_unique<MemoryStatisticsTracker>(desc.memoryAllocationCallback);
         m_Context.immediateContext = desc.context;
         m_Context.immediateContext->QueryInterface(IID_PPV_ARGS(&m_Context.immediateContext1));
         desc.context->GetDevice(&m_Context.device);
 
+        D3D11_FEATURE_DATA_THREADING threadingCaps = {};
+        if (SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threadingCaps, sizeof(threadingCaps))))
+            m_Context.driverCommandLists = threadingCaps.DriverCommandLists != FALSE;
+
 #if NVRHI_D3D11_WITH_NVAPI
         m_Context.nvapiAvailable = NvAPI_Initialize() == NVAPI_OK;
 
@@ -118,11 +126,29 @@ namespace nvrhi::d3d11
             m_Context.error(ss.str());
         }
 
-        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, CommandListParameters()));   
+        m_ImmediateCommandList = CommandListHandle::Create(new CommandList(m_Context, this, m_Context.immediateContext, CommandListParameters()));   
+
+        if (desc.enableObjectDeduplication)
+            m_Deduplication = std::make_unique<ObjectDeduplicationCaches>();
+
+        if (desc.shaderPermutationProvider)
+        {
+            m_ShaderPermutations = std::make_unique<ShaderPermutationCache>(desc.shaderPermutationProvider,
+                desc.shaderPermutationCacheDirectory, m_Context.messageCallback);
+        }
+
+        m_TextureBlitter = std::make_unique<D3DTextureBlitter>(this);
     }
 
     Device::~Device()
     {
+        // Finish or cancel the pipeline jobs while the device is still intact
+        m_PipelineCompiler.shutdown();
+
+        // The cached objects reference the device
+        m_Deduplication.reset();
+        m_TextureBlitter.reset();
+
         // Release the command list so that it unregisters the Aftermath marker tracker before the device is destroyed
         m_ImmediateCommandList = nullptr;
 
@@ -136,6 +162,66 @@ namespace nvrhi::d3d11
 #endif
     }
 
+    void Device::runGarbageCollection()
+    {
+        if (m_Deduplication)
+            m_Deduplication->evictUnused();
+    }
+
+    bool Device::getVideoMemoryBudget(VideoMemoryBudget& outBudget)
+    {
+        // D3D11 manages residency on its own, and the budget is only reported through IDXGIAdapter3
+        (void)outBudget;
+        return false;
+    }
+
+    MemoryStatistics Device::getMemoryStatistics()
+    {
+        return m_Context.memoryStatistics->getStatistics();
+    }
+
+    void Device::setResidencyPriority(IResource* resource, ResidencyPriority priority)
+    {
+        ID3D11Resource* d3dResource = resource ? static_cast<ID3D11Resource*>(resource->getNativeObject(ObjectTypes::D3D11_Resource)) : nullptr;
+        if (!d3dResource)
+        {
+            m_Context.error("setResidencyPriority: the resource is not a texture or buffer");
+            return;
+        }
+
+        UINT evictionPriority = DXGI_RESOURCE_PRIORITY_NORMAL;
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum: evictionPriority = DXGI_RESOURCE_PRIORITY_MINIMUM; break;
+        case ResidencyPriority::Low:     evictionPriority = DXGI_RESOURCE_PRIORITY_LOW; break;
+        case ResidencyPriority::Normal:  evictionPriority = DXGI_RESOURCE_PRIORITY_NORMAL; break;
+        case ResidencyPriority::High:    evictionPriority = DXGI_RESOURCE_PRIORITY_HIGH; break;
+        case ResidencyPriority::Maximum: evictionPriority = DXGI_RESOURCE_PRIORITY_MAXIMUM; break;
+        }
+
+        d3dResource->SetEvictionPriority(evictionPriority);
+    }
+
+    AsyncGraphicsPipelineHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback)
+    {
+        return m_PipelineCompiler.createGraphicsPipeline(this, desc, fbinfo, fallback);
+    }
+
+    AsyncComputePipelineHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback)
+    {
+        return m_PipelineCompiler.createComputePipeline(this, desc, fallback);
+    }
+
+    AsyncMeshletPipelineHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback)
+    {
+        return m_PipelineCompiler.createMeshletPipeline(this, desc, fbinfo, fallback);
+    }
+
+    rt::AsyncPipelineHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback)
+    {
+        return m_PipelineCompiler.createRayTracingPipeline(this, desc, fallback);
+    }
+
     GraphicsAPI Device::getGraphicsAPI()
     {
         return GraphicsAPI::D3D11;
@@ -164,9 +250,9 @@ namespace nvrhi::d3d11
 
     CommandListHandle Device::createCommandList(const CommandListParameters& params)
     {
-        if (!params.enableImmediateExecution)
+        if (params.isBundle)
         {
-            m_Context.error("Deferred command lists are not supported by the D3D11 backend.");
+            m_Context.error("Bundles are not supported by the D3D11 backend.");
             return nullptr;
         }
 
@@ -176,7 +262,61 @@ namespace nvrhi::d3d11
             return nullptr;
         }
         
-        return m_ImmediateCommandList;
+        if (params.enableImmediateExecution)
+        {
+            if (params.reusable)
+            {
+                m_Context.error("Reusable command lists must be created with enableImmediateExecution = false on D3D11.");
+                return nullptr;
+            }
+
+            return m_ImmediateCommandList;
+        }
+
+        // Deferred command lists record into their own deferred context and are replayed by executeCommandLists
+        RefCountPtr<ID3D11DeviceContext> deferredContext;
+        const HRESULT res = m_Context.device->CreateDeferredContext(0, &deferredContext);
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreateDeferredContext call failed, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        return CommandListHandle::Create(new CommandList(m_Context, this, deferredContext, params));
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        (void)executionQueue;
+
+        bool executedDeferredLists = false;
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+
+            // Immediate command lists have already been executed while they were recorded
+            if (commandList->getDesc().enableImmediateExecution)
+                continue;
+
+            ID3D11CommandList* recordedCommandList = commandList->getRecordedCommandList();
+            if (!recordedCommandList)
+            {
+                m_Context.error("Cannot execute a deferred command list that has not been closed");
+                continue;
+            }
+
+            // The immediate context state is reset after the command list, like with clearState()
+            m_Context.immediateContext->ExecuteCommandList(recordedCommandList, FALSE);
+            executedDeferredLists = true;
+        }
+
+        // Keep the state cache and binding shadows of the immediate command list in sync with the reset context
+        if (executedDeferredLists)
+            m_ImmediateCommandList->clearState();
+
+        return 0;
     }
 
     void Device::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
@@ -201,6 +341,16 @@ namespace nvrhi::d3d11
         utils::NotSupported();
     }
 
+    void Device::updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        (void)buffer;
+        (void)tileMappings;
+        (void)numTileMappings;
+        (void)executionQueue;
+
+        utils::NotSupported();
+    }
+
     SamplerFeedbackTextureHandle Device::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
     {
         (void)pairedTexture;
@@ -230,7 +380,9 @@ namespace nvrhi::d3d11
         switch (feature)  // NOLINT(clang-diagnostic-switch-enum)
         {
         case Feature::DeferredCommandLists:
-            return false;
+            return true;
+        case Feature::ShaderSpecializations:
+            return m_ShaderPermutations != nullptr;
         case Feature::SinglePassStereo:
             return m_SinglePassStereoSupported;
         case Feature::FastGeometryShader:
@@ -245,6 +397,9 @@ namespace nvrhi::d3d11
             return m_Context.immediateContext1 != nullptr;
         case Feature::HlslExtensionUAV:
             return m_HlslExtensionsSupported;
+        case Feature::PipelineStatisticsQueries:
+        case Feature::Predication:
+            return true;
         default:
             return false;
         }
@@ -346,6 +501,18 @@ namespace nvrhi::d3d11
         return nullptr;
     }
 
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc&)
+    {
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    StorageQueueHandle Device::createStorageQueue(const StorageQueueDesc& desc)
+    {
+        // No GPU decompression on DX11, the files are read on the CPU
+        return StorageQueueHandle::Create(new nvrhi::StorageQueue(this, desc));
+    }
+
     bool Device::waitForIdle()
     {
         if (!m_WaitForIdleQuery)
@@ -364,6 +531,12 @@ namespace nvrhi::d3d11
 
     SamplerHandle Device::createSampler(const SamplerDesc& d)
     {
+        if (m_Deduplication)
+        {
+            if (SamplerHandle existing = m_Deduplication->samplers.find(d))
+                return existing;
+        }
+
         D3D11_SAMPLER_DESC desc11;
 
         UINT reductionType = convertSamplerReductionType(d.reductionType);
@@ -408,7 +581,12 @@ namespace nvrhi::d3d11
         Sampler* sampler = new Sampler();
         sampler->sampler = sState;
         sampler->desc = d;
-        return SamplerHandle::Create(sampler);
+        SamplerHandle handle = SamplerHandle::Create(sampler);
+
+        if (m_Deduplication)
+            handle = m_Deduplication->samplers.insert(d, handle);
+
+        return handle;
     }
 
     coopvec::DeviceFeatures Device::queryCoopVecFeatures()
@@ -423,4 +601,10 @@ namespace nvrhi::d3d11
         return 0;
     }
 
+    void Device::getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc*, size_t numDescs, size_t* outSizes)
+    {
+        utils::NotSupported();
+        std::fill(outSizes, outSizes + numDescs, size_t(0));
+    }
+
 } // namespace nvrhi::d3d11
@@ -52,6 +52,12 @@ namespace nvrhi::d3d11
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        if (m_Deduplication)
+        {
+            if (GraphicsPipelineHandle existing = m_Deduplication->graphicsPipelines.find({ desc, fbinfo }))
+                return existing;
+        }
+
         const RenderState& renderState = desc.renderState;
 
         if (desc.renderState.singlePassStereo.enabled && !m_SinglePassStereoSupported)
@@ -101,7 +107,12 @@ namespace nvrhi::d3d11
                 break;
         }
         
-        return GraphicsPipelineHandle::Create(pso);
+        GraphicsPipelineHandle pipeline = GraphicsPipelineHandle::Create(pso);
+
+        if (m_Deduplication)
+            pipeline = m_Deduplication->graphicsPipelines.insert({ desc, fbinfo }, pipeline);
+
+        return pipeline;
     }
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
@@ -114,16 +125,16 @@ namespace nvrhi::d3d11
 
     void CommandList::bindGraphicsPipeline(const GraphicsPipeline* pso) const
     {
-        m_Context.immediateContext->IASetPrimitiveTopology(pso->primitiveTopology);
-        m_Context.immediateContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
+        m_DeviceContext->IASetPrimitiveTopology(pso->primitiveTopology);
+        m_DeviceContext->IASetInputLayout(pso->inputLayout ? pso->inputLayout->layout : nullptr);
 
-        m_Context.immediateContext->RSSetState(pso->pRS);
+        m_DeviceContext->RSSetState(pso->pRS);
 
-        m_Context.immediateContext->VSSetShader(pso->pVS, nullptr, 0);
-        m_Context.immediateContext->HSSetShader(pso->pHS, nullptr, 0);
-        m_Context.immediateContext->DSSetShader(pso->pDS, nullptr, 0);
-        m_Context.immediateContext->GSSetShader(pso->pGS, nullptr, 0);
-        m_Context.immediateContext->PSSetShader(pso->pPS, nullptr, 0);
+        m_DeviceContext->VSSetShader(pso->pVS, nullptr, 0);
+        m_DeviceContext->HSSetShader(pso->pHS, nullptr, 0);
+        m_DeviceContext->DSSetShader(pso->pDS, nullptr, 0);
+        m_DeviceContext->GSSetShader(pso->pGS, nullptr, 0);
+        m_DeviceContext->PSSetShader(pso->pPS, nullptr, 0);
     }
 
     static DX11_ViewportState convertViewportState(const ViewportState& vpState)
@@ -153,18 +164,149 @@ namespace nvrhi::d3d11
         return ret;
     }
 
+    void CommandList::bindPixelShaderUAVs(const BindingSetVector& bindings) const
+    {
+        ID3D11UnorderedAccessView* UAVs[D3D11_1_UAV_SLOT_COUNT] = {};
+        static const UINT initialCounts[D3D11_1_UAV_SLOT_COUNT] = {};
+        uint32_t minUAVSlot = D3D11_1_UAV_SLOT_COUNT;
+        uint32_t maxUAVSlot = 0;
+        for (auto _bindingSet : bindings)
+        {
+            BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+            if (!bindingSet || (bindingSet->visibility & ShaderType::Pixel) == 0)
+                continue;
+
+            for (uint32_t slot = bindingSet->minUAVSlot; slot <= bindingSet->maxUAVSlot; slot++)
+            {
+                UAVs[slot] = bindingSet->UAVs[slot];
+            }
+            minUAVSlot = std::min(minUAVSlot, bindingSet->minUAVSlot);
+            maxUAVSlot = std::max(maxUAVSlot, bindingSet->maxUAVSlot);
+        }
+
+        m_DeviceContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
+    }
+
+    void CommandList::bindVertexBuffers(const GraphicsPipeline* pipeline, const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers) const
+    {
+        ID3D11Buffer *pVertexBuffers[c_MaxVertexAttributes] = {};
+        UINT pVertexBufferStrides[c_MaxVertexAttributes] = {};
+        UINT pVertexBufferOffsets[c_MaxVertexAttributes] = {};
+        uint32_t maxVbIndex = 0;
+
+        const auto *inputLayout = pipeline->inputLayout;
+        for (size_t i = 0; i < vertexBuffers.size(); i++)
+        {
+            const VertexBufferBinding& binding = vertexBuffers[i];
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+            
+            assert(binding.offset <= UINT_MAX);
+
+            pVertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->resource;
+            pVertexBufferStrides[binding.slot] = inputLayout->elementStrides.at(binding.slot);
+            pVertexBufferOffsets[binding.slot] = UINT(binding.offset);
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+        }
+
+        if (m_CurrentGraphicsStateValid)
+        {
+            for (const VertexBufferBinding& binding : m_CurrentVertexBufferBindings)
+            {
+                if (binding.slot < c_MaxVertexAttributes)
+                    maxVbIndex = std::max(maxVbIndex, binding.slot);
+            }
+        }
+
+        m_DeviceContext->IASetVertexBuffers(0, maxVbIndex + 1,
+            pVertexBuffers,
+            pVertexBufferStrides,
+            pVertexBufferOffsets);
+    }
+
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer) const
+    {
+        if (indexBuffer.buffer)
+        {
+            m_DeviceContext->IASetIndexBuffer(checked_cast<Buffer*>(indexBuffer.buffer)->resource,
+                getDxgiFormatMapping(indexBuffer.format).srvFormat,
+                indexBuffer.offset);
+        }
+        else
+        {
+            m_DeviceContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
+        }
+    }
+
+    void CommandList::setViewports(const ViewportState& viewport) const
+    {
+        DX11_ViewportState vpState = convertViewportState(viewport);
+
+        if (vpState.numViewports)
+        {
+            m_DeviceContext->RSSetViewports(vpState.numViewports, vpState.viewports);
+        }
+
+        if (vpState.numScissorRects)
+        {
+            m_DeviceContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+        }
+    }
+
+    void CommandList::applyAttachmentLoadOps(Framebuffer* framebuffer)
+    {
+        // There are no render passes on D3D11, so the store ops are ignored, and DontCare uses DiscardView
+        // where D3D11.1 is available.
+        m_LastRenderPassFramebuffer = framebuffer;
+
+        for (uint32_t rtIndex = 0; rtIndex < framebuffer->RTVs.size(); rtIndex++)
+        {
+            const FramebufferAttachment& attachment = framebuffer->desc.colorAttachments[rtIndex];
+
+            if (attachment.loadOp == AttachmentLoadOp::Clear)
+                m_DeviceContext->ClearRenderTargetView(framebuffer->RTVs[rtIndex], &attachment.getEffectiveClearValue().r);
+            else if (attachment.loadOp == AttachmentLoadOp::DontCare && m_DeviceContext1)
+                m_DeviceContext1->DiscardView(framebuffer->RTVs[rtIndex]);
+        }
+
+        const FramebufferAttachment& depthAttachment = framebuffer->desc.depthAttachment;
+        if (framebuffer->DSV && !depthAttachment.isReadOnly)
+        {
+            if (depthAttachment.loadOp == AttachmentLoadOp::Clear)
+            {
+                const Color& clearValue = depthAttachment.getEffectiveClearValue();
+
+                UINT clearFlags = D3D11_CLEAR_DEPTH;
+                if (getFormatInfo(depthAttachment.texture->getDesc().format).hasStencil)
+                    clearFlags |= D3D11_CLEAR_STENCIL;
+
+                m_DeviceContext->ClearDepthStencilView(framebuffer->DSV, clearFlags, clearValue.r, UINT8(clearValue.g));
+            }
+            else if (depthAttachment.loadOp == AttachmentLoadOp::DontCare && m_DeviceContext1)
+            {
+                m_DeviceContext1->DiscardView(framebuffer->DSV);
+            }
+        }
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
+        // The complete state replaces anything set with the incremental setters since the last draw
+        m_PendingGraphicsState.reset();
+
         GraphicsPipeline* pipeline = checked_cast<GraphicsPipeline*>(state.pipeline);
         Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
 
         if (m_CurrentComputeStateValid)
         {
             // If the previous operation has been a Dispatch call, there is a possibility of RT/UAV/SRV hazards.
-            // Unbind everything to be sure, and to avoid checking the binding sets against each other. 
+            // Unbind the compute UAVs and shader resources, and avoid checking the binding sets against each other.
             // This only happens on switches between compute and graphics modes.
 
-            clearState();
+            unbindComputeResources();
         }
 
         const bool updateFramebuffer = !m_CurrentGraphicsStateValid || m_CurrentFramebuffer != state.framebuffer;
@@ -199,19 +341,24 @@ namespace nvrhi::d3d11
 
             if (pipeline->pixelShaderHasUAVs)
             {
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(
+                m_DeviceContext->OMSetRenderTargetsAndUnorderedAccessViews(
                     UINT(RTVs.size()), RTVs.data(),
                     framebuffer->DSV,
                     D3D11_KEEP_UNORDERED_ACCESS_VIEWS, 0, nullptr, nullptr);
             }
             else
             {
-                m_Context.immediateContext->OMSetRenderTargets(
+                m_DeviceContext->OMSetRenderTargets(
                     UINT(RTVs.size()),RTVs.data(),
                     framebuffer->DSV);
             }
         }
 
+        if (framebuffer != m_LastRenderPassFramebuffer)
+        {
+            applyAttachmentLoadOps(framebuffer);
+        }
+
         if (updatePipeline)
         {
             bindGraphicsPipeline(pipeline);
@@ -222,13 +369,13 @@ namespace nvrhi::d3d11
             m_CurrentStencilRefValue = pipeline->desc.renderState.depthStencilState.dynamicStencilRef
                 ? state.dynamicStencilRefValue
                 : pipeline->desc.renderState.depthStencilState.stencilRefValue;
-            m_Context.immediateContext->OMSetDepthStencilState(pipeline->pDepthStencilState, m_CurrentStencilRefValue);
+            m_DeviceContext->OMSetDepthStencilState(pipeline->pDepthStencilState, m_CurrentStencilRefValue);
         }
 
         if (updatePipeline || updateBlendState)
         {
             float blendFactor[4]{ state.blendConstantColor.r, state.blendConstantColor.g, state.blendConstantColor.b, state.blendConstantColor.a };
-            m_Context.immediateContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
+            m_DeviceContext->OMSetBlendState(pipeline->pBlendState, blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
         }
 
         if (updateBindings)
@@ -237,42 +384,13 @@ namespace nvrhi::d3d11
 
             if (pipeline->pixelShaderHasUAVs)
             {
-                ID3D11UnorderedAccessView* UAVs[D3D11_1_UAV_SLOT_COUNT] = {};
-                static const UINT initialCounts[D3D11_1_UAV_SLOT_COUNT] = {};
-                uint32_t minUAVSlot = D3D11_1_UAV_SLOT_COUNT;
-                uint32_t maxUAVSlot = 0;
-                for (auto _bindingSet : state.bindings)
-                {
-                    BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
-
-                    if ((bindingSet->visibility & ShaderType::Pixel) == 0)
-                        continue;
-
-                    for (uint32_t slot = bindingSet->minUAVSlot; slot <= bindingSet->maxUAVSlot; slot++)
-                    {
-                        UAVs[slot] = bindingSet->UAVs[slot];
-                    }
-                    minUAVSlot = std::min(minUAVSlot, bindingSet->minUAVSlot);
-                    maxUAVSlot = std::max(maxUAVSlot, bindingSet->maxUAVSlot);
-                }
-
-                m_Context.immediateContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, minUAVSlot, maxUAVSlot - minUAVSlot + 1, UAVs + minUAVSlot, initialCounts);
+                bindPixelShaderUAVs(state.bindings);
             }
         }
 
         if (updateViewports)
         {
-            DX11_ViewportState vpState = convertViewportState(state.viewport);
-
-            if (vpState.numViewports)
-            {
-                m_Context.immediateContext->RSSetViewports(vpState.numViewports, vpState.viewports);
-            }
-
-            if (vpState.numScissorRects)
-            {
-                m_Context.immediateContext->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
-            }
+            setViewports(state.viewport);
         }
 
 #if NVRHI_D3D11_WITH_NVAPI
@@ -282,7 +400,7 @@ namespace nvrhi::d3d11
         {
             const SinglePassStereoState& spsState = pipeline->desc.renderState.singlePassStereo;
 
-            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_Context.immediateContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
+            NvAPI_Status Status = NvAPI_D3D_SetSinglePassStereoMode(m_DeviceContext, spsState.enabled ? 2 : 1, spsState.renderTargetIndexOffset, spsState.independentViewportMask);
 
             if (Status != NVAPI_OK)
             {
@@ -295,55 +413,12 @@ namespace nvrhi::d3d11
 
         if (updateVertexBuffers)
         {
-            ID3D11Buffer *pVertexBuffers[c_MaxVertexAttributes] = {};
-            UINT pVertexBufferStrides[c_MaxVertexAttributes] = {};
-            UINT pVertexBufferOffsets[c_MaxVertexAttributes] = {};
-            uint32_t maxVbIndex = 0;
-
-            const auto *inputLayout = pipeline->inputLayout;
-            for (size_t i = 0; i < state.vertexBuffers.size(); i++)
-            {
-                const VertexBufferBinding& binding = state.vertexBuffers[i];
-
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-                
-                assert(binding.offset <= UINT_MAX);
-
-                pVertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->resource;
-                pVertexBufferStrides[binding.slot] = inputLayout->elementStrides.at(binding.slot);
-                pVertexBufferOffsets[binding.slot] = UINT(binding.offset);
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-            }
-
-            if (m_CurrentGraphicsStateValid)
-            {
-                for (const VertexBufferBinding& binding : m_CurrentVertexBufferBindings)
-                {
-                    if (binding.slot < c_MaxVertexAttributes)
-                        maxVbIndex = std::max(maxVbIndex, binding.slot);
-                }
-            }
-
-            m_Context.immediateContext->IASetVertexBuffers(0, maxVbIndex + 1,
-                pVertexBuffers,
-                pVertexBufferStrides,
-                pVertexBufferOffsets);
+            bindVertexBuffers(pipeline, state.vertexBuffers);
         }
 
         if (updateIndexBuffer)
         {
-            if (state.indexBuffer.buffer)
-            {
-                m_Context.immediateContext->IASetIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->resource,
-                    getDxgiFormatMapping(state.indexBuffer.format).srvFormat,
-                    state.indexBuffer.offset);
-            }
-            else
-            {
-                m_Context.immediateContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
-            }
+            bindIndexBuffer(state.indexBuffer);
         }
 
         m_CurrentIndirectBuffer = state.indirectParams;
@@ -374,18 +449,106 @@ namespace nvrhi::d3d11
         }
     }
 
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        m_PendingGraphicsState.setBindingSet(m_CurrentBindings, slot, bindingSet);
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers)
+    {
+        m_PendingGraphicsState.setVertexBuffers(m_CurrentVertexBufferBindings, vertexBuffers, numVertexBuffers);
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_PendingGraphicsState.setIndexBuffer(m_CurrentIndexBufferBinding, indexBuffer);
+    }
+
+    void CommandList::setViewportState(const ViewportState& viewport)
+    {
+        m_PendingGraphicsState.setViewport(m_CurrentViewports, viewport);
+    }
+
+    void CommandList::commitGraphicsStateChanges()
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_PendingGraphicsState.reset();
+            return;
+        }
+
+        GraphicsPipeline* pipeline = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsPipeline.Get());
+        const PendingGraphicsState& pending = m_PendingGraphicsState;
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Bindings))
+        {
+            BindingSetVector setsToBind;
+            prepareToBindGraphicsResourceSets(pending.bindings, &m_CurrentBindings, pipeline, pipeline, false, setsToBind);
+            bindGraphicsResourceSets(setsToBind, pipeline);
+
+            if (pipeline->pixelShaderHasUAVs)
+            {
+                bindPixelShaderUAVs(pending.bindings);
+            }
+
+            m_CurrentBindings.resize(pending.bindings.size());
+            for (size_t i = 0; i < pending.bindings.size(); i++)
+            {
+                m_CurrentBindings[i] = pending.bindings[i];
+            }
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Viewport))
+        {
+            setViewports(pending.viewport);
+
+            m_CurrentViewports = pending.viewport;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::VertexBuffers))
+        {
+            bindVertexBuffers(pipeline, pending.vertexBuffers);
+
+            m_CurrentVertexBufferBindings = pending.vertexBuffers;
+            m_CurrentVertexBuffers.resize(pending.vertexBuffers.size());
+            for (size_t i = 0; i < pending.vertexBuffers.size(); i++)
+            {
+                m_CurrentVertexBuffers[i] = pending.vertexBuffers[i].buffer;
+            }
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::IndexBuffer))
+        {
+            bindIndexBuffer(pending.indexBuffer);
+
+            m_CurrentIndexBufferBinding = pending.indexBuffer;
+            m_CurrentIndexBuffer = pending.indexBuffer.buffer;
+        }
+
+        m_PendingGraphicsState.reset();
+    }
+
     void CommandList::draw(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
+        m_DeviceContext->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
     }
 
     void CommandList::drawIndexed(const DrawArguments& args)
     {
-        m_Context.immediateContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
+        m_DeviceContext->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
     }
 
     void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentIndirectBuffer.Get());
         
         if (indirectParams) // validation layer will issue an error otherwise
@@ -393,7 +556,7 @@ namespace nvrhi::d3d11
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_DeviceContext->DrawInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndirectArguments);
             }
         }
@@ -401,6 +564,9 @@ namespace nvrhi::d3d11
 
     void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentIndirectBuffer.Get());
 
         if (indirectParams)
@@ -408,7 +574,7 @@ namespace nvrhi::d3d11
             // Simulate multi-command D3D12 ExecuteIndirect or Vulkan vkCmdDrawIndirect with a loop
             for (uint32_t drawIndex = 0; drawIndex < drawCount; ++drawIndex)
             {
-                m_Context.immediateContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
+                m_DeviceContext->DrawIndexedInstancedIndirect(indirectParams->resource, offsetBytes);
                 offsetBytes += sizeof(DrawIndexedIndirectArguments);
             }
         }
@@ -416,22 +582,9 @@ namespace nvrhi::d3d11
 
     ID3D11BlendState* Device::getBlendState(const BlendState& blendState)
     {
-        size_t hash = 0;
-        hash_combine(hash, blendState.alphaToCoverageEnable);
+        std::lock_guard lockGuard(m_StateCacheMutex);
 
-        for (const auto& target : blendState.targets)
-        {
-            hash_combine(hash, target.blendEnable);
-            hash_combine(hash, target.srcBlend);
-            hash_combine(hash, target.destBlend);
-            hash_combine(hash, target.blendOp);
-            hash_combine(hash, target.srcBlendAlpha);
-            hash_combine(hash, target.destBlendAlpha);
-            hash_combine(hash, target.blendOpAlpha);
-            hash_combine(hash, target.colorWriteMask);
-        }
-
-        RefCountPtr<ID3D11BlendState> d3dBlendState = m_BlendStates[hash];
+        RefCountPtr<ID3D11BlendState> d3dBlendState = m_BlendStates[blendState];
 
         if (d3dBlendState)
             return d3dBlendState;
@@ -465,29 +618,20 @@ namespace nvrhi::d3d11
             return nullptr;
         }
 
-        m_BlendStates[hash] = d3dBlendState;
+        m_BlendStates[blendState] = d3dBlendState;
         return d3dBlendState;
     }
 
     ID3D11DepthStencilState* Device::getDepthStencilState(const DepthStencilState& depthState)
     {
-        size_t hash = 0;
-        hash_combine(hash, depthState.depthTestEnable);
-        hash_combine(hash, depthState.depthWriteEnable);
-        hash_combine(hash, depthState.depthFunc);
-        hash_combine(hash, depthState.stencilEnable);
-        hash_combine(hash, depthState.stencilReadMask);
-        hash_combine(hash, depthState.stencilWriteMask);
-        hash_combine(hash, depthState.frontFaceStencil.failOp);
-        hash_combine(hash, depthState.frontFaceStencil.depthFailOp);
-        hash_combine(hash, depthState.frontFaceStencil.passOp);
-        hash_combine(hash, depthState.frontFaceStencil.stencilFunc);
-        hash_combine(hash, depthState.backFaceStencil.failOp);
-        hash_combine(hash, depthState.backFaceStencil.depthFailOp);
-        hash_combine(hash, depthState.backFaceStencil.passOp);
-        hash_combine(hash, depthState.backFaceStencil.stencilFunc);
-        
-        RefCountPtr<ID3D11DepthStencilState> d3dDepthStencilState = m_DepthStencilStates[hash];
+        // The stencil reference is set on the context, not in the state object
+        DepthStencilState key = depthState;
+        key.stencilRefValue = 0;
+        key.dynamicStencilRef = false;
+
+        std::lock_guard lockGuard(m_StateCacheMutex);
+
+        RefCountPtr<ID3D11DepthStencilState> d3dDepthStencilState = m_DepthStencilStates[key];
 
         if (d3dDepthStencilState)
             return d3dDepthStencilState;
@@ -517,38 +661,23 @@ namespace nvrhi::d3d11
             return nullptr;
         }
 
-        m_DepthStencilStates[hash] = d3dDepthStencilState;
+        m_DepthStencilStates[key] = d3dDepthStencilState;
         return d3dDepthStencilState;
     }
 
     ID3D11RasterizerState* Device::getRasterizerState(const RasterState& rasterState)
     {
-        size_t hash = 0;
-        hash_combine(hash, rasterState.fillMode);
-        hash_combine(hash, rasterState.cullMode);
-        hash_combine(hash, rasterState.frontCounterClockwise);
-        hash_combine(hash, rasterState.depthClipEnable);
-        hash_combine(hash, rasterState.scissorEnable);
-        hash_combine(hash, rasterState.multisampleEnable);
-        hash_combine(hash, rasterState.antialiasedLineEnable);
-        hash_combine(hash, rasterState.depthBias);
-        hash_combine(hash, rasterState.depthBiasClamp);
-        hash_combine(hash, rasterState.slopeScaledDepthBias);
-        hash_combine(hash, rasterState.forcedSampleCount);
-        hash_combine(hash, rasterState.programmableSamplePositionsEnable);
-        hash_combine(hash, rasterState.conservativeRasterEnable);
-        hash_combine(hash, rasterState.quadFillEnable);
-
-        if (rasterState.programmableSamplePositionsEnable)
-        {
-            for (int i = 0; i < 16; i++)
-            {
-                hash_combine(hash, rasterState.samplePositionsX[i]);
-                hash_combine(hash, rasterState.samplePositionsY[i]);
-            }
+        // The sample positions are ignored unless programmable sample positions are enabled
+        RasterState key = rasterState;
+        if (!key.programmableSamplePositionsEnable)
+        {
+            memset(key.samplePositionsX, 0, sizeof(key.samplePositionsX));
+            memset(key.samplePositionsY, 0, sizeof(key.samplePositionsY));
         }
 
-        RefCountPtr<ID3D11RasterizerState> d3dRasterizerState = m_RasterizerStates[hash];
+        std::lock_guard lockGuard(m_StateCacheMutex);
+
+        RefCountPtr<ID3D11RasterizerState> d3dRasterizerState = m_RasterizerStates[key];
 
         if (d3dRasterizerState)
             return d3dRasterizerState;
@@ -633,7 +762,7 @@ namespace nvrhi::d3d11
             }
         }
 
-        m_RasterizerStates[hash] = d3dRasterizerState;
+        m_RasterizerStates[key] = d3dRasterizerState;
         return d3dRasterizerState;
     }
 
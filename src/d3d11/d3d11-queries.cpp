@@ -159,8 +159,8 @@ void CommandList::beginTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->Begin(query->disjoint.Get());
-    m_Context.immediateContext->End(query->start.Get());
+    m_DeviceContext->Begin(query->disjoint.Get());
+    m_DeviceContext->End(query->start.Get());
 }
 
 void CommandList::endTimerQuery(ITimerQuery* _query)
@@ -168,8 +168,8 @@ void CommandList::endTimerQuery(ITimerQuery* _query)
     TimerQuery* query = checked_cast<TimerQuery*>(_query);
 
     assert(!query->resolved);
-    m_Context.immediateContext->End(query->end.Get());
-    m_Context.immediateContext->End(query->disjoint.Get());
+    m_DeviceContext->End(query->end.Get());
+    m_DeviceContext->End(query->disjoint.Get());
 }
 
 bool Device::pollTimerQuery(ITimerQuery* _query)
@@ -243,4 +243,270 @@ void Device::resetTimerQuery(ITimerQuery* _query)
     query->time = 0.f;
 }
 
+OcclusionQueryHandle Device::createOcclusionQuery(OcclusionQueryType type)
+{
+    OcclusionQuery* ret = new OcclusionQuery();
+    ret->type = type;
+
+    D3D11_QUERY_DESC queryDesc;
+    queryDesc.MiscFlags = 0;
+
+    if (type == OcclusionQueryType::Binary)
+    {
+        queryDesc.Query = D3D11_QUERY_OCCLUSION_PREDICATE;
+
+        const HRESULT res = m_Context.device->CreatePredicate(&queryDesc, &ret->predicate);
+        if (FAILED(res))
+        {
+            std::stringstream ss;
+            ss << "CreatePredicate call failed for OcclusionQuery, HRESULT = 0x" << std::hex << std::setw(8) << res;
+            m_Context.error(ss.str());
+
+            delete ret;
+            return nullptr;
+        }
+
+        ret->query = ret->predicate.Get();
+    }
+    else
+    {
+        queryDesc.Query = D3D11_QUERY_OCCLUSION;
+
+        if (!checkedCreateQuery(queryDesc, "OcclusionQuery", m_Context, &ret->query))
+        {
+            delete ret;
+            return nullptr;
+        }
+    }
+
+    return OcclusionQueryHandle::Create(ret);
+}
+
+void CommandList::beginOcclusionQuery(IOcclusionQuery* _query)
+{
+    OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+    assert(!query->resolved);
+    m_DeviceContext->Begin(query->query.Get());
+}
+
+void CommandList::endOcclusionQuery(IOcclusionQuery* _query)
+{
+    OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+    assert(!query->resolved);
+    m_DeviceContext->End(query->query.Get());
+}
+
+void CommandList::setPredication(IOcclusionQuery* _query, PredicationOp op)
+{
+    if (!_query)
+    {
+        m_DeviceContext->SetPredication(nullptr, FALSE);
+        return;
+    }
+
+    OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+    if (!query->predicate)
+    {
+        m_Context.error("setPredication: only binary occlusion queries can be used for predication on DX11");
+        return;
+    }
+
+    // the predicate is TRUE when any samples passed, and rendering is skipped when it equals PredicateValue
+    m_DeviceContext->SetPredication(query->predicate, op == PredicationOp::SkipIfNotZero ? TRUE : FALSE);
+}
+
+SyncPointHandle CommandList::signalSyncPoint()
+{
+    utils::NotSupported();
+    return nullptr;
+}
+
+void CommandList::waitSyncPoint(ISyncPoint*, PipelineStages)
+{
+    utils::NotSupported();
+}
+
+bool Device::pollOcclusionQuery(IOcclusionQuery* _query)
+{
+    OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+    if (query->resolved)
+    {
+        return true;
+    }
+
+    const HRESULT hr = m_Context.immediateContext->GetData(query->query.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+
+    return hr == S_OK;
+}
+
+uint64_t Device::getOcclusionQueryResult(IOcclusionQuery* _query)
+{
+    OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+    if (!query->resolved)
+    {
+        HRESULT hr;
+
+        if (query->predicate)
+        {
+            BOOL anySamplesPassed = FALSE;
+            do {
+                hr = m_Context.immediateContext->GetData(query->query.Get(), &anySamplesPassed, sizeof(anySamplesPassed), 0);
+            } while (hr == S_FALSE);
+
+            query->result = anySamplesPassed ? 1 : 0;
+        }
+        else
+        {
+            UINT64 numSamples = 0;
+            do {
+                hr = m_Context.immediateContext->GetData(query->query.Get(), &numSamples, sizeof(numSamples), 0);
+            } while (hr == S_FALSE);
+
+            query->result = numSamples;
+        }
+
+        assert(SUCCEEDED(hr));
+        query->resolved = true;
+    }
+
+    return query->result;
+}
+
+void Device::resetOcclusionQuery(IOcclusionQuery* _query)
+{
+    OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+    query->resolved = false;
+    query->result = 0;
+}
+
+PipelineStatisticsQueryHandle Device::createPipelineStatisticsQuery()
+{
+    PipelineStatisticsQuery* ret = new PipelineStatisticsQuery();
+
+    D3D11_QUERY_DESC queryDesc;
+    queryDesc.Query = D3D11_QUERY_PIPELINE_STATISTICS;
+    queryDesc.MiscFlags = 0;
+
+    if (!checkedCreateQuery(queryDesc, "PipelineStatisticsQuery", m_Context, &ret->query))
+    {
+        delete ret;
+        return nullptr;
+    }
+
+    return PipelineStatisticsQueryHandle::Create(ret);
+}
+
+void CommandList::beginPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+{
+    PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+    assert(!query->resolved);
+    m_DeviceContext->Begin(query->query.Get());
+}
+
+void CommandList::endPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+{
+    PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+    assert(!query->resolved);
+    m_DeviceContext->End(query->query.Get());
+}
+
+bool Device::pollPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+{
+    PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+    if (query->resolved)
+    {
+        return true;
+    }
+
+    const HRESULT hr = m_Context.immediateContext->GetData(query->query.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+
+    return hr == S_OK;
+}
+
+PipelineStatistics Device::getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* _query)
+{
+    PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+    if (!query->resolved)
+    {
+        D3D11_QUERY_DATA_PIPELINE_STATISTICS data = {};
+
+        HRESULT hr;
+        do {
+            hr = m_Context.immediateContext->GetData(query->query.Get(), &data, sizeof(data), 0);
+        } while (hr == S_FALSE);
+        assert(SUCCEEDED(hr));
+
+        query->result.inputAssemblyVertices = data.IAVertices;
+        query->result.inputAssemblyPrimitives = data.IAPrimitives;
+        query->result.vertexShaderInvocations = data.VSInvocations;
+        query->result.geometryShaderInvocations = data.GSInvocations;
+        query->result.geometryShaderPrimitives = data.GSPrimitives;
+        query->result.clipperInvocations = data.CInvocations;
+        query->result.clipperPrimitives = data.CPrimitives;
+        query->result.pixelShaderInvocations = data.PSInvocations;
+        query->result.hullShaderInvocations = data.HSInvocations;
+        query->result.domainShaderInvocations = data.DSInvocations;
+        query->result.computeShaderInvocations = data.CSInvocations;
+        query->resolved = true;
+    }
+
+    return query->result;
+}
+
+void Device::resetPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+{
+    PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+    query->resolved = false;
+    query->result = PipelineStatistics();
+}
+
+TimerQueryPoolHandle Device::createTimerQueryPool(const TimerQueryPoolDesc&)
+{
+    utils::NotSupported();
+    return nullptr;
+}
+
+bool Device::getTimerQueryPoolResults(ITimerQueryPool*, uint64_t, float*, uint32_t)
+{
+    utils::NotSupported();
+    return false;
+}
+
+bool Device::getTimerQueryPoolTimestamps(ITimerQueryPool*, uint64_t, double*, uint32_t)
+{
+    utils::NotSupported();
+    return false;
+}
+
+void CommandList::beginTimerQueryFrame(ITimerQueryPool*)
+{
+    utils::NotSupported();
+}
+
+void CommandList::beginTimerQuery(ITimerQueryPool*, uint32_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::endTimerQuery(ITimerQueryPool*, uint32_t)
+{
+    utils::NotSupported();
+}
+
+void CommandList::resolveTimerQueries(ITimerQueryPool*)
+{
+    utils::NotSupported();
+}
+
 } // namespace nvrhi::d3d11
\ No newline at end of file
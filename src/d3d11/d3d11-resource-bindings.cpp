@@ -191,11 +191,38 @@ bool Device::writeDescriptorTable(IDescriptorTable*, const BindingSetItem&)
     return false;
 }
 
-static ID3D11Buffer *NullCBs[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = { nullptr };
+bool Device::writeDescriptorTable(IDescriptorTable*, const BindingSetItem*, size_t)
+{
+    utils::NotSupported();
+    return false;
+}
+
+IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+{
+    // D3D11 binding sets are just arrays of views, there is no descriptor memory to suballocate
+    BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+    if (!bindingSet)
+        return nullptr;
+
+    m_TransientBindingSets.push_back(bindingSet);
+    return bindingSet;
+}
+
 static ID3D11ShaderResourceView *NullSRVs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { nullptr };
-static ID3D11SamplerState *NullSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = { nullptr };
-static ID3D11UnorderedAccessView *NullUAVs[D3D11_PS_CS_UAV_REGISTER_COUNT] = { 0 };
-static UINT NullUAVInitialCounts[D3D11_PS_CS_UAV_REGISTER_COUNT] = { 0 };
+static ID3D11UnorderedAccessView *NullUAVs[D3D11_1_UAV_SLOT_COUNT] = { 0 };
+static UINT NullUAVInitialCounts[D3D11_1_UAV_SLOT_COUNT] = { 0 };
+
+// Indexed by CommandList::Stage
+static const ShaderType c_StageShaderTypes[] = {
+    ShaderType::Vertex,
+    ShaderType::Hull,
+    ShaderType::Domain,
+    ShaderType::Geometry,
+    ShaderType::Pixel,
+    ShaderType::Compute
+};
+
+static_assert(std::size(c_StageShaderTypes) == size_t(CommandList::Stage::Count));
 
 bool BindingSet::isSupersetOf(const BindingSet& other) const
 {
@@ -205,12 +232,231 @@ bool BindingSet::isSupersetOf(const BindingSet& other) const
         && minConstantBufferSlot <= other.minConstantBufferSlot && maxConstantBufferSlot >= other.maxConstantBufferSlot;
 }
 
-#define D3D11_SET_ARRAY(method, min, max, array) \
-        if ((max) >= (min)) \
-            m_Context.immediateContext->method(min, ((max) - (min) + 1), &(array)[min])
-#define D3D11_SET_ARRAY1(method, min, max, array, offsets, counts) \
-        if ((max) >= (min)) \
-            m_Context.immediateContext1->method(min, ((max) - (min) + 1), &(array)[min], &(offsets)[min], &(counts)[min])
+void CommandList::setShaderResourceViews(Stage stage, uint32_t minSlot, uint32_t maxSlot, ID3D11ShaderResourceView* const* views)
+{
+    ID3D11ShaderResourceView** bound = m_StageBindings[uint32_t(stage)].SRVs;
+
+    // Set each contiguous run of slots that differ from the shadow with one call
+    uint32_t slot = minSlot;
+    while (slot <= maxSlot)
+    {
+        if (bound[slot] == views[slot])
+        {
+            ++slot;
+            continue;
+        }
+
+        const uint32_t start = slot;
+        for (; slot <= maxSlot && bound[slot] != views[slot]; ++slot)
+            bound[slot] = views[slot];
+
+        const UINT count = slot - start;
+        switch (stage)
+        {
+        case Stage::Vertex:   m_DeviceContext->VSSetShaderResources(start, count, &views[start]); break;
+        case Stage::Hull:     m_DeviceContext->HSSetShaderResources(start, count, &views[start]); break;
+        case Stage::Domain:   m_DeviceContext->DSSetShaderResources(start, count, &views[start]); break;
+        case Stage::Geometry: m_DeviceContext->GSSetShaderResources(start, count, &views[start]); break;
+        case Stage::Pixel:    m_DeviceContext->PSSetShaderResources(start, count, &views[start]); break;
+        case Stage::Compute:  m_DeviceContext->CSSetShaderResources(start, count, &views[start]); break;
+        case Stage::Count:
+        default:
+            utils::InvalidEnum();
+            return;
+        }
+    }
+}
+
+void CommandList::setSamplers(Stage stage, uint32_t minSlot, uint32_t maxSlot, ID3D11SamplerState* const* samplers)
+{
+    ID3D11SamplerState** bound = m_StageBindings[uint32_t(stage)].samplers;
+
+    uint32_t slot = minSlot;
+    while (slot <= maxSlot)
+    {
+        if (bound[slot] == samplers[slot])
+        {
+            ++slot;
+            continue;
+        }
+
+        const uint32_t start = slot;
+        for (; slot <= maxSlot && bound[slot] != samplers[slot]; ++slot)
+            bound[slot] = samplers[slot];
+
+        const UINT count = slot - start;
+        switch (stage)
+        {
+        case Stage::Vertex:   m_DeviceContext->VSSetSamplers(start, count, &samplers[start]); break;
+        case Stage::Hull:     m_DeviceContext->HSSetSamplers(start, count, &samplers[start]); break;
+        case Stage::Domain:   m_DeviceContext->DSSetSamplers(start, count, &samplers[start]); break;
+        case Stage::Geometry: m_DeviceContext->GSSetSamplers(start, count, &samplers[start]); break;
+        case Stage::Pixel:    m_DeviceContext->PSSetSamplers(start, count, &samplers[start]); break;
+        case Stage::Compute:  m_DeviceContext->CSSetSamplers(start, count, &samplers[start]); break;
+        case Stage::Count:
+        default:
+            utils::InvalidEnum();
+            return;
+        }
+    }
+}
+
+void CommandList::setConstantBuffers(Stage stage, uint32_t minSlot, uint32_t maxSlot, ID3D11Buffer* const* buffers, const UINT* offsets, const UINT* counts)
+{
+    StageBindings& bound = m_StageBindings[uint32_t(stage)];
+
+    // Bindings without offsets cover the whole buffer and are recorded as offset 0, count 0
+    auto isBound = [&bound, buffers, offsets, counts](uint32_t slot)
+    {
+        return bound.constantBuffers[slot] == buffers[slot]
+            && bound.constantBufferOffsets[slot] == (offsets ? offsets[slot] : 0)
+            && bound.constantBufferCounts[slot] == (counts ? counts[slot] : 0);
+    };
+
+    uint32_t slot = minSlot;
+    while (slot <= maxSlot)
+    {
+        if (isBound(slot))
+        {
+            ++slot;
+            continue;
+        }
+
+        const uint32_t start = slot;
+        for (; slot <= maxSlot && !isBound(slot); ++slot)
+        {
+            bound.constantBuffers[slot] = buffers[slot];
+            bound.constantBufferOffsets[slot] = offsets ? offsets[slot] : 0;
+            bound.constantBufferCounts[slot] = counts ? counts[slot] : 0;
+        }
+
+        const UINT count = slot - start;
+        if (offsets && counts)
+        {
+            switch (stage)
+            {
+            case Stage::Vertex:   m_DeviceContext1->VSSetConstantBuffers1(start, count, &buffers[start], &offsets[start], &counts[start]); break;
+            case Stage::Hull:     m_DeviceContext1->HSSetConstantBuffers1(start, count, &buffers[start], &offsets[start], &counts[start]); break;
+            case Stage::Domain:   m_DeviceContext1->DSSetConstantBuffers1(start, count, &buffers[start], &offsets[start], &counts[start]); break;
+            case Stage::Geometry: m_DeviceContext1->GSSetConstantBuffers1(start, count, &buffers[start], &offsets[start], &counts[start]); break;
+            case Stage::Pixel:    m_DeviceContext1->PSSetConstantBuffers1(start, count, &buffers[start], &offsets[start], &counts[start]); break;
+            case Stage::Compute:  m_DeviceContext1->CSSetConstantBuffers1(start, count, &buffers[start], &offsets[start], &counts[start]); break;
+            case Stage::Count:
+            default:
+                utils::InvalidEnum();
+                return;
+            }
+        }
+        else
+        {
+            switch (stage)
+            {
+            case Stage::Vertex:   m_DeviceContext->VSSetConstantBuffers(start, count, &buffers[start]); break;
+            case Stage::Hull:     m_DeviceContext->HSSetConstantBuffers(start, count, &buffers[start]); break;
+            case Stage::Domain:   m_DeviceContext->DSSetConstantBuffers(start, count, &buffers[start]); break;
+            case Stage::Geometry: m_DeviceContext->GSSetConstantBuffers(start, count, &buffers[start]); break;
+            case Stage::Pixel:    m_DeviceContext->PSSetConstantBuffers(start, count, &buffers[start]); break;
+            case Stage::Compute:  m_DeviceContext->CSSetConstantBuffers(start, count, &buffers[start]); break;
+            case Stage::Count:
+            default:
+                utils::InvalidEnum();
+                return;
+            }
+        }
+    }
+}
+
+void CommandList::setComputeUnorderedAccessViews(uint32_t minSlot, uint32_t maxSlot, ID3D11UnorderedAccessView* const* views)
+{
+    uint32_t slot = minSlot;
+    while (slot <= maxSlot)
+    {
+        if (m_ComputeUAVs[slot] == views[slot])
+        {
+            ++slot;
+            continue;
+        }
+
+        const uint32_t start = slot;
+        for (; slot <= maxSlot && m_ComputeUAVs[slot] != views[slot]; ++slot)
+            m_ComputeUAVs[slot] = views[slot];
+
+        m_DeviceContext->CSSetUnorderedAccessViews(start, slot - start, &views[start], NullUAVInitialCounts);
+    }
+}
+
+void CommandList::SlotRanges::include(const BindingSet& set)
+{
+    minSRVSlot = std::min(minSRVSlot, set.minSRVSlot);
+    maxSRVSlot = std::max(maxSRVSlot, set.maxSRVSlot);
+    minSamplerSlot = std::min(minSamplerSlot, set.minSamplerSlot);
+    maxSamplerSlot = std::max(maxSamplerSlot, set.maxSamplerSlot);
+    minConstantBufferSlot = std::min(minConstantBufferSlot, set.minConstantBufferSlot);
+    maxConstantBufferSlot = std::max(maxConstantBufferSlot, set.maxConstantBufferSlot);
+    minUAVSlot = std::min(minUAVSlot, set.minUAVSlot);
+    maxUAVSlot = std::max(maxUAVSlot, set.maxUAVSlot);
+}
+
+bool CommandList::SlotRanges::isEmpty() const
+{
+    return minSRVSlot > maxSRVSlot && minSamplerSlot > maxSamplerSlot
+        && minConstantBufferSlot > maxConstantBufferSlot && minUAVSlot > maxUAVSlot;
+}
+
+void CommandList::copySetSlots(StageBindings& target, const BindingSet& set, const StageBindings* source)
+{
+    for (uint32_t slot = set.minSRVSlot; slot <= set.maxSRVSlot; slot++)
+        target.SRVs[slot] = source ? source->SRVs[slot] : nullptr;
+
+    for (uint32_t slot = set.minSamplerSlot; slot <= set.maxSamplerSlot; slot++)
+        target.samplers[slot] = source ? source->samplers[slot] : nullptr;
+
+    for (uint32_t slot = set.minConstantBufferSlot; slot <= set.maxConstantBufferSlot; slot++)
+    {
+        target.constantBuffers[slot] = source ? source->constantBuffers[slot] : nullptr;
+        target.constantBufferOffsets[slot] = source ? source->constantBufferOffsets[slot] : 0;
+        target.constantBufferCounts[slot] = source ? source->constantBufferCounts[slot] : 0;
+    }
+}
+
+void CommandList::copySetSlots(StageBindings& target, const BindingSet& set, const BindingSet& source)
+{
+    for (uint32_t slot = set.minSRVSlot; slot <= set.maxSRVSlot; slot++)
+        target.SRVs[slot] = source.SRVs[slot];
+
+    for (uint32_t slot = set.minSamplerSlot; slot <= set.maxSamplerSlot; slot++)
+        target.samplers[slot] = source.samplers[slot];
+
+    for (uint32_t slot = set.minConstantBufferSlot; slot <= set.maxConstantBufferSlot; slot++)
+    {
+        target.constantBuffers[slot] = source.constantBuffers[slot];
+        target.constantBufferOffsets[slot] = source.constantBufferOffsets[slot];
+        target.constantBufferCounts[slot] = source.constantBufferCounts[slot];
+    }
+}
+
+void CommandList::setStageBindings(Stage stage, const StageBindings& target, const SlotRanges& ranges)
+{
+    // Without ID3D11DeviceContext1, all constant buffers are bound whole and the shadow offsets are zero
+    if (m_DeviceContext1)
+        setConstantBuffers(stage, ranges.minConstantBufferSlot, ranges.maxConstantBufferSlot, target.constantBuffers, target.constantBufferOffsets, target.constantBufferCounts);
+    else
+        setConstantBuffers(stage, ranges.minConstantBufferSlot, ranges.maxConstantBufferSlot, target.constantBuffers, nullptr, nullptr);
+
+    setShaderResourceViews(stage, ranges.minSRVSlot, ranges.maxSRVSlot, target.SRVs);
+    setSamplers(stage, ranges.minSamplerSlot, ranges.maxSamplerSlot, target.samplers);
+}
+
+void CommandList::bindSetToStage(const BindingSet* set, Stage stage)
+{
+    if (m_DeviceContext1)
+        setConstantBuffers(stage, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
+    else
+        setConstantBuffers(stage, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, nullptr, nullptr);
+
+    setShaderResourceViews(stage, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
+    setSamplers(stage, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
+}
 
 void CommandList::prepareToBindGraphicsResourceSets(
     const BindingSetVector& resourceSets, 
@@ -218,7 +464,7 @@ void CommandList::prepareToBindGraphicsResourceSets(
     const IGraphicsPipeline* _currentPipeline,
     const IGraphicsPipeline* _newPipeline, 
     bool updateFramebuffer, 
-    BindingSetVector& outSetsToBind) const
+    BindingSetVector& outSetsToBind)
 {
     outSetsToBind = resourceSets;
 
@@ -268,49 +514,40 @@ void CommandList::prepareToBindGraphicsResourceSets(
             }
         }
 
-        for (IBindingSet* _set : setsToUnbind)
+        // Only the slots that none of the new sets use are cleared here. The other slots keep their contents until
+        // bindGraphicsResourceSets overwrites them, so each slot is set at most once. The cleared slots must be unbound
+        // before the framebuffer changes, in case the previous inputs become render targets.
+        for (uint32_t stage = 0; stage < uint32_t(Stage::Compute); stage++)
         {
-            if (!_set)
-                continue;
-
-            BindingSet* set = checked_cast<BindingSet*>(_set);
+            const ShaderType stageType = c_StageShaderTypes[stage];
+            const StageBindings& shadow = m_StageBindings[stage];
 
-            ShaderType stagesToUnbind = set->visibility & currentPipeline->shaderMask;
+            StageBindings target = shadow;
+            SlotRanges freedRanges;
 
-            if ((stagesToUnbind & ShaderType::Vertex) != 0)
+            for (IBindingSet* _set : setsToUnbind)
             {
-                D3D11_SET_ARRAY(VSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(VSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(VSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
+                const BindingSet* set = checked_cast<const BindingSet*>(_set);
+                if (!set || (set->visibility & currentPipeline->shaderMask & stageType) == 0)
+                    continue;
 
-            if ((stagesToUnbind & ShaderType::Hull) != 0)
-            {
-                D3D11_SET_ARRAY(HSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(HSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(HSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
+                copySetSlots(target, *set, nullptr);
+                freedRanges.include(*set);
             }
 
-            if ((stagesToUnbind & ShaderType::Domain) != 0)
-            {
-                D3D11_SET_ARRAY(DSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(DSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(DSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
+            if (freedRanges.isEmpty())
+                continue;
 
-            if ((stagesToUnbind & ShaderType::Geometry) != 0)
+            for (IBindingSet* _set : resourceSets)
             {
-                D3D11_SET_ARRAY(GSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(GSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(GSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
-            }
+                const BindingSet* set = checked_cast<const BindingSet*>(_set);
+                if (!set || (set->visibility & newPipeline->shaderMask & stageType) == 0)
+                    continue;
 
-            if ((stagesToUnbind & ShaderType::Pixel) != 0)
-            {
-                D3D11_SET_ARRAY(PSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-                D3D11_SET_ARRAY(PSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-                D3D11_SET_ARRAY(PSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
+                copySetSlots(target, *set, &shadow);
             }
+
+            setStageBindings(Stage(stage), target, freedRanges);
         }
     }
 }
@@ -318,7 +555,7 @@ void CommandList::prepareToBindGraphicsResourceSets(
 
 void CommandList::bindGraphicsResourceSets(
     const BindingSetVector& setsToBind,
-    const IGraphicsPipeline* newPipeline) const
+    const IGraphicsPipeline* newPipeline)
 {
     for(IBindingSet* _set : setsToBind)
     {
@@ -330,174 +567,126 @@ void CommandList::bindGraphicsResourceSets(
 
         ShaderType stagesToBind = set->visibility & pipeline->shaderMask;
 
-        if ((stagesToBind & ShaderType::Vertex) != 0)
-        {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(VSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(VSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(VSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(VSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
-        }
-
-        if ((stagesToBind & ShaderType::Hull) != 0)
+        for (uint32_t stage = 0; stage < uint32_t(Stage::Compute); stage++)
         {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(HSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(HSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(HSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(HSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
-        }
-
-        if ((stagesToBind & ShaderType::Domain) != 0)
-        {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(DSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(DSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(DSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(DSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
-        }
-
-        if ((stagesToBind & ShaderType::Geometry) != 0)
-        {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(GSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(GSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(GSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(GSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
-        }
-
-        if ((stagesToBind & ShaderType::Pixel) != 0)
-        {
-            if (m_Context.immediateContext1)
-            {
-                D3D11_SET_ARRAY1(PSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-            }
-            else
-            {
-                D3D11_SET_ARRAY(PSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-            }
-            D3D11_SET_ARRAY(PSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-            D3D11_SET_ARRAY(PSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
+            if ((stagesToBind & c_StageShaderTypes[stage]) != 0)
+                bindSetToStage(set, Stage(stage));
         }
     }
 }
 
 void CommandList::bindComputeResourceSets(
     const BindingSetVector& resourceSets,
-    const static_vector<BindingSetHandle,c_MaxBindingLayouts>* currentResourceSets) const
+    const static_vector<BindingSetHandle,c_MaxBindingLayouts>* currentResourceSets)
 {
-    BindingSetVector setsToBind = resourceSets;
+    // Combine the new sets into the contents of all slots that they and the previous sets use, with the slots of the
+    // previous sets cleared first, and then set only the slots that differ from the shadows.
+    StageBindings target = m_StageBindings[uint32_t(Stage::Compute)];
+    ID3D11UnorderedAccessView* targetUAVs[D3D11_1_UAV_SLOT_COUNT];
+    std::copy(std::begin(m_ComputeUAVs), std::end(m_ComputeUAVs), targetUAVs);
+    SlotRanges ranges;
 
     if (currentResourceSets)
     {
-        BindingSetVector setsToUnbind;
-
-        for (const BindingSetHandle& bindingSet : *currentResourceSets)
+        for (const BindingSetHandle& _set : *currentResourceSets)
         {
-            setsToUnbind.push_back(bindingSet);
-        }
+            const BindingSet* set = checked_cast<const BindingSet*>(_set.Get());
+            if (!set || (set->visibility & ShaderType::Compute) == 0)
+                continue;
 
-        for (uint32_t i = 0; i < uint32_t(setsToBind.size()); i++)
-        {
-            if (setsToBind[i])
-                for (uint32_t j = 0; j < uint32_t(setsToUnbind.size()); j++)
-                {
-                    if (setsToBind[i] == setsToUnbind[j])
-                    {
-                        setsToBind[i] = nullptr;
-                        setsToUnbind[j] = nullptr;
-                        break;
-                    }
-                }
-        }
-        
-        for (uint32_t i = 0; i < uint32_t(setsToBind.size()); i++)
-        {
-            if (setsToBind[i])
-                for (uint32_t j = 0; j < uint32_t(setsToUnbind.size()); j++)
-                {
-                    BindingSet* setToBind = checked_cast<BindingSet*>(setsToBind[i]);
-                    BindingSet* setToUnbind = checked_cast<BindingSet*>(setsToUnbind[j]);
+            copySetSlots(target, *set, nullptr);
+            for (uint32_t slot = set->minUAVSlot; slot <= set->maxUAVSlot; slot++)
+                targetUAVs[slot] = nullptr;
 
-                    if (setToUnbind && setToBind->isSupersetOf(*setToUnbind) && setToUnbind->maxUAVSlot < setToUnbind->minUAVSlot)
-                    {
-                        setsToUnbind[j] = nullptr;
-                    }
-                }
+            ranges.include(*set);
         }
+    }
 
-        for (IBindingSet* _set : setsToUnbind)
-        {
-            if (!_set)
-                continue;
+    for (IBindingSet* _set : resourceSets)
+    {
+        const BindingSet* set = checked_cast<const BindingSet*>(_set);
+        if (!set || (set->visibility & ShaderType::Compute) == 0)
+            continue;
+
+        copySetSlots(target, *set, *set);
+        for (uint32_t slot = set->minUAVSlot; slot <= set->maxUAVSlot; slot++)
+            targetUAVs[slot] = set->UAVs[slot];
+
+        ranges.include(*set);
+    }
+
+    // UAVs go first: the runtime unbinds any inputs that conflict with them, and those slots are set again below
+    // because the new sets can't use the same resources as inputs
+    setComputeUnorderedAccessViews(ranges.minUAVSlot, ranges.maxUAVSlot, targetUAVs);
+    setStageBindings(Stage::Compute, target, ranges);
+}
 
-            BindingSet* set = checked_cast<BindingSet*>(_set);
+void CommandList::unbindGraphicsResources()
+{
+    // Outputs and shader resources of the graphics stages may conflict with the UAVs of the next dispatches.
+    // The D3D runtime would unbind the conflicting inputs behind the back of the stage shadows, so unbind them here.
+    // Constant buffers and samplers can't conflict and stay bound for the next draws.
+    m_DeviceContext->OMSetRenderTargetsAndUnorderedAccessViews(0, nullptr, nullptr, 0, 0, nullptr, nullptr);
+
+    if (m_CurrentGraphicsPipeline)
+    {
+        const GraphicsPipeline* pipeline = checked_cast<const GraphicsPipeline*>(m_CurrentGraphicsPipeline.Get());
 
-            if ((set->visibility & ShaderType::Compute) == 0)
+        for (const BindingSetHandle& _set : m_CurrentBindings)
+        {
+            const BindingSet* set = checked_cast<const BindingSet*>(_set.Get());
+            if (!set)
                 continue;
 
-            D3D11_SET_ARRAY(CSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, NullCBs);
-            D3D11_SET_ARRAY(CSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
-            D3D11_SET_ARRAY(CSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, NullSamplers);
+            ShaderType stagesToUnbind = set->visibility & pipeline->shaderMask;
 
-            if (set->maxUAVSlot >= set->minUAVSlot)
+            for (uint32_t stage = 0; stage < uint32_t(Stage::Compute); stage++)
             {
-                m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
-                    set->maxUAVSlot - set->minUAVSlot + 1,
-                    NullUAVs,
-                    NullUAVInitialCounts);
+                if ((stagesToUnbind & c_StageShaderTypes[stage]) != 0)
+                    setShaderResourceViews(Stage(stage), set->minSRVSlot, set->maxSRVSlot, NullSRVs);
             }
         }
     }
 
-    for(IBindingSet* _set : resourceSets)
+    if (!m_CurrentVertexBufferBindings.empty())
     {
-        BindingSet* set = checked_cast<BindingSet*>(_set);
+        ID3D11Buffer* nullBuffers[c_MaxVertexAttributes] = {};
+        UINT zeros[c_MaxVertexAttributes] = {};
+        m_DeviceContext->IASetVertexBuffers(0, c_MaxVertexAttributes, nullBuffers, zeros, zeros);
+    }
 
-        if ((set->visibility & ShaderType::Compute) == 0)
-            continue;
+    if (m_CurrentIndexBuffer)
+        m_DeviceContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
+
+    m_CurrentGraphicsStateValid = false;
+    m_PendingGraphicsState.reset();
+    m_CurrentGraphicsPipeline = nullptr;
+    m_CurrentFramebuffer = nullptr;
+    m_CurrentBindings.resize(0);
+    m_CurrentVertexBufferBindings.resize(0);
+    m_CurrentIndexBufferBinding = IndexBufferBinding();
+    m_CurrentVertexBuffers.resize(0);
+    m_CurrentIndexBuffer = nullptr;
+    m_CurrentIndirectBuffer = nullptr;
+}
 
-        if (m_Context.immediateContext1)
-        {
-            D3D11_SET_ARRAY1(CSSetConstantBuffers1, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers, set->constantBufferOffsets, set->constantBufferCounts);
-        }
-        else
-        {
-            D3D11_SET_ARRAY(CSSetConstantBuffers, set->minConstantBufferSlot, set->maxConstantBufferSlot, set->constantBuffers);
-        }
-        D3D11_SET_ARRAY(CSSetShaderResources, set->minSRVSlot, set->maxSRVSlot, set->SRVs);
-        D3D11_SET_ARRAY(CSSetSamplers, set->minSamplerSlot, set->maxSamplerSlot, set->samplers);
+void CommandList::unbindComputeResources()
+{
+    // The compute UAVs and SRVs may conflict with the render targets and inputs of the next draws
+    for (const BindingSetHandle& _set : m_CurrentBindings)
+    {
+        const BindingSet* set = checked_cast<const BindingSet*>(_set.Get());
+        if (!set || (set->visibility & ShaderType::Compute) == 0)
+            continue;
 
-        if (set->maxUAVSlot >= set->minUAVSlot)
-        {
-            m_Context.immediateContext->CSSetUnorderedAccessViews(set->minUAVSlot,
-                set->maxUAVSlot - set->minUAVSlot + 1,
-                &set->UAVs[set->minUAVSlot],
-                NullUAVInitialCounts);
-        }
+        setShaderResourceViews(Stage::Compute, set->minSRVSlot, set->maxSRVSlot, NullSRVs);
+        setComputeUnorderedAccessViews(set->minUAVSlot, set->maxUAVSlot, NullUAVs);
     }
-}
 
-#undef D3D11_SET_ARRAY
+    m_CurrentComputeStateValid = false;
+    m_CurrentComputePipeline = nullptr;
+    m_CurrentBindings.resize(0);
+    m_CurrentIndirectBuffer = nullptr;
+}
 
 } // namespace nvrhi::d3d11
@@ -298,10 +298,49 @@ namespace nvrhi::d3d11
         return shader;  // NOLINT(clang-diagnostic-return-std-move-in-c++11)
     }
     
-    ShaderHandle Device::createShaderSpecialization(IShader*, const ShaderSpecialization*, uint32_t)
+    ShaderHandle Device::createShaderSpecialization(IShader* _baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
     {
-        utils::NotSupported();
-        return nullptr;
+        if (!m_ShaderPermutations)
+        {
+            utils::NotSupported();
+            return nullptr;
+        }
+
+        Shader* baseShader = checked_cast<Shader*>(_baseShader);
+        assert(constants);
+        assert(numConstants != 0);
+
+        // The provider always gets the original bytecode, so specializing a specialization replaces its constants
+        Shader* originalShader = baseShader->baseShader ? checked_cast<Shader*>(baseShader->baseShader.Get()) : baseShader;
+        ShaderSpecializationKey key(originalShader, constants, numConstants);
+
+        if (m_Deduplication)
+        {
+            if (ShaderHandle existing = m_Deduplication->shaderSpecializations.find(key))
+                return existing;
+        }
+
+        ShaderPermutationCache::Bytecode bytecode = m_ShaderPermutations->getPermutation(originalShader->desc,
+            originalShader->bytecode.data(), originalShader->bytecode.size(), key.constants.data(), uint32_t(key.constants.size()));
+
+        if (!bytecode)
+        {
+            m_Context.error(std::string("The shader permutation provider has no variant of shader ")
+                + utils::DebugNameToString(originalShader->desc.debugName) + " with the requested constants");
+            return nullptr;
+        }
+
+        ShaderHandle handle = createShader(originalShader->desc, bytecode->data(), bytecode->size());
+        if (!handle)
+            return nullptr;
+
+        // Hold a strong reference to the parent object
+        checked_cast<Shader*>(handle.Get())->baseShader = originalShader;
+
+        if (m_Deduplication)
+            handle = m_Deduplication->shaderSpecializations.insert(key, handle);
+
+        return handle;
     }
 
     InputLayoutHandle Device::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* _vertexShader)
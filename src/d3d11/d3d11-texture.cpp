@@ -24,6 +24,7 @@
 
 #include <nvrhi/utils.h>
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -60,6 +61,32 @@ namespace nvrhi::d3d11
         }
     }
 
+    Texture::~Texture()
+    {
+        if (trackedMemorySize)
+            m_Context.memoryStatistics->released(MemoryCategory::Textures, trackedMemorySize);
+    }
+
+    // D3D11 doesn't report the memory used by resources, so the size of a texture is estimated
+    // from its dimensions and format, without any padding or alignment that the driver may add
+    static uint64_t estimateTextureSize(const TextureDesc& desc)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+
+        uint64_t size = 0;
+        for (MipLevel mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+        {
+            const uint64_t columns = (std::max(desc.width >> mipLevel, 1u) + blockSize - 1) / blockSize;
+            const uint64_t rows = (std::max(desc.height >> mipLevel, 1u) + blockSize - 1) / blockSize;
+            const uint64_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+            size += columns * rows * depth * formatInfo.bytesPerBlock;
+        }
+
+        const uint32_t arraySize = desc.dimension == TextureDimension::Texture3D ? 1u : desc.arraySize;
+        return size * arraySize * std::max(desc.sampleCount, 1u);
+    }
+
     TextureHandle Device::createTexture(const TextureDesc& d, CpuAccessMode cpuAccess) const
     {
         if (d.isVirtual)
@@ -222,6 +249,8 @@ namespace nvrhi::d3d11
         texture->desc = d;
         texture->resource = pResource;
         texture->sharedHandle = sharedHandle;
+        texture->trackedMemorySize = estimateTextureSize(d);
+        m_Context.memoryStatistics->allocated(MemoryCategory::Textures, texture->trackedMemorySize, d.debugName.c_str());
         return TextureHandle::Create(texture);
     }
 
@@ -287,13 +316,13 @@ namespace nvrhi::d3d11
             {
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
-                m_Context.immediateContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
+                m_DeviceContext->ClearUnorderedAccessViewFloat(uav, &clearColor.r);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
-                m_Context.immediateContext->ClearRenderTargetView(rtv, &clearColor.r);
+                m_DeviceContext->ClearRenderTargetView(rtv, &clearColor.r);
             }
             else
             {
@@ -330,7 +359,7 @@ namespace nvrhi::d3d11
                 UINT clearFlags = 0;
                 if (clearDepth)   clearFlags |= D3D11_CLEAR_DEPTH;
                 if (clearStencil) clearFlags |= D3D11_CLEAR_STENCIL;
-                m_Context.immediateContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
+                m_DeviceContext->ClearDepthStencilView(dsv, clearFlags, depth, stencil);
             }
         }
     }
@@ -356,14 +385,14 @@ namespace nvrhi::d3d11
                 ID3D11UnorderedAccessView* uav = texture->getUAV(Format::UNKNOWN, currentMipSlice, TextureDimension::Unknown);
 
                 uint32_t clearValues[4] = { clearColor, clearColor, clearColor, clearColor };
-                m_Context.immediateContext->ClearUnorderedAccessViewUint(uav, clearValues);
+                m_DeviceContext->ClearUnorderedAccessViewUint(uav, clearValues);
             }
             else if (texture->desc.isRenderTarget)
             {
                 ID3D11RenderTargetView* rtv = texture->getRTV(Format::UNKNOWN, currentMipSlice);
 
                 float clearValues[4] = { float(clearColor), float(clearColor), float(clearColor), float(clearColor) };
-                m_Context.immediateContext->ClearRenderTargetView(rtv, clearValues);
+                m_DeviceContext->ClearRenderTargetView(rtv, clearValues);
             }
             else
             {
@@ -416,7 +445,7 @@ namespace nvrhi::d3d11
         srcBox.bottom = resolvedSrcSlice.y + resolvedSrcSlice.height;
         srcBox.back = resolvedSrcSlice.z + resolvedSrcSlice.depth;
 
-        m_Context.immediateContext->CopySubresourceRegion(dst,
+        m_DeviceContext->CopySubresourceRegion(dst,
                                        dstSubresource,
                                        resolvedDstSlice.x, resolvedDstSlice.y, resolvedDstSlice.z,
                                        src,
@@ -457,7 +486,65 @@ namespace nvrhi::d3d11
 
         UINT subresource = D3D11CalcSubresource(mipLevel, arraySlice, dest->desc.mipLevels);
 
-        m_Context.immediateContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+        m_DeviceContext->UpdateSubresource(dest->resource, subresource, nullptr, data, UINT(rowPitch), UINT(depthPitch));
+    }
+
+    void CommandList::writeTextureSubresources(ITexture* _dest, const TextureSubresourceData* subresources, size_t numSubresources)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        for (size_t i = 0; i < numSubresources; i++)
+        {
+            const TextureSubresourceData& subresource = subresources[i];
+            UINT subresourceIndex = D3D11CalcSubresource(subresource.mipLevel, subresource.arraySlice, dest->desc.mipLevels);
+
+            m_DeviceContext->UpdateSubresource(dest->resource, subresourceIndex, nullptr, subresource.data, UINT(subresource.rowPitch), UINT(subresource.depthPitch));
+        }
+    }
+
+    void* CommandList::beginTextureWrite(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        const uint32_t mipWidth = std::max(dest->desc.width >> mipLevel, 1u);
+        const uint32_t mipHeight = std::max(dest->desc.height >> mipLevel, 1u);
+        const uint32_t mipDepth = std::max(dest->desc.depth >> mipLevel, 1u);
+
+        const FormatInfo& formatInfo = getFormatInfo(dest->desc.format);
+        const uint32_t numCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const uint32_t numRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        // There is no upload memory to write into on D3D11, the data goes through UpdateSubresource in endTextureWrite
+        PendingTextureWrite write;
+        write.dest = dest;
+        write.subresource = D3D11CalcSubresource(mipLevel, arraySlice, dest->desc.mipLevels);
+        write.rowPitch = numCols * formatInfo.bytesPerBlock;
+        write.depthPitch = write.rowPitch * numRows;
+        write.data.resize(size_t(write.depthPitch) * mipDepth);
+
+        if (outRowPitch)
+            *outRowPitch = write.rowPitch;
+        if (outDepthPitch)
+            *outDepthPitch = write.depthPitch;
+
+        m_PendingTextureWrites.push_back(std::move(write));
+        return m_PendingTextureWrites.back().data.data();
+    }
+
+    void CommandList::endTextureWrite(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+        const UINT subresource = D3D11CalcSubresource(mipLevel, arraySlice, dest->desc.mipLevels);
+
+        auto it = std::find_if(m_PendingTextureWrites.begin(), m_PendingTextureWrites.end(), [dest, subresource](const PendingTextureWrite& write)
+            { return write.dest == dest && write.subresource == subresource; });
+
+        if (it == m_PendingTextureWrites.end())
+            return; // let the validation layer report it
+
+        m_DeviceContext->UpdateSubresource(dest->resource, subresource, nullptr, it->data.data(), it->rowPitch, it->depthPitch);
+
+        m_PendingTextureWrites.erase(it);
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
@@ -480,11 +567,21 @@ namespace nvrhi::d3d11
             {
                 uint32_t dstSubresource = D3D11CalcSubresource(mipLevel + dstSR.baseMipLevel, arrayIndex + dstSR.baseArraySlice, dest->desc.mipLevels);
                 uint32_t srcSubresource = D3D11CalcSubresource(mipLevel + srcSR.baseMipLevel, arrayIndex + srcSR.baseArraySlice, src->desc.mipLevels);
-                m_Context.immediateContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
+                m_DeviceContext->ResolveSubresource(dest->resource, dstSubresource, src->resource, srcSubresource, formatMapping.rtvFormat);
             }
         }
     }
 
+    void CommandList::generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter)
+    {
+        checked_cast<Device*>(m_Device)->getTextureBlitter().generateMips(this, texture, subresources, linearFilter);
+    }
+
+    void CommandList::blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter)
+    {
+        checked_cast<Device*>(m_Device)->getTextureBlitter().blitTexture(this, dest, destSlice, src, srcSlice, linearFilter);
+    }
+
     void *Device::mapStagingTexture(IStagingTexture* _stagingTexture, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch)
     {
         StagingTexture* stagingTexture = checked_cast<StagingTexture*>(_stagingTexture);
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <nvrhi/d3d12.h>
+#include <dxgi1_4.h>
 
 #ifndef NVRHI_D3D12_WITH_NVAPI
 #define NVRHI_D3D12_WITH_NVAPI 0
@@ -77,6 +78,15 @@
 #define NVRHI_D3D12_WITH_COOPVEC (0)
 #endif
 
+// Enhanced barriers are declared by the Agility SDK 1.606+ and Windows SDK 10.0.22621+ headers
+#if defined(__ID3D12GraphicsCommandList7_INTERFACE_DEFINED__)
+#define NVRHI_D3D12_WITH_ENHANCED_BARRIERS (1)
+#else
+#define NVRHI_D3D12_WITH_ENHANCED_BARRIERS (0)
+#endif
+
+#include <array>
+#include <atomic>
 #include <bitset>
 #include <memory>
 #include <queue>
@@ -90,6 +100,19 @@
 #include "../common/state-tracking.h"
 #include "../common/dxgi-format.h"
 #include "../common/versioning.h"
+#include "../common/memory-statistics.h"
+#include "../common/residency.h"
+#include "../common/resource-references.h"
+#include "../common/view-cache.h"
+#include "../common/ring-allocator.h"
+#include "../common/tlsf-allocator.h"
+#include "../common/d3d-texture-blitter.h"
+#include "../common/deduplication-cache.h"
+#include "../common/deferred-destruction.h"
+#include "../common/coopvec-size-cache.h"
+#include "../common/shader-permutation-cache.h"
+#include "../common/pipeline-compiler.h"
+#include "../common/graphics-state-cache.h"
 
 #ifdef NVRHI_WITH_RTXMU
 #include <rtxmu/D3D12AccelStructManager.h>
@@ -99,6 +122,8 @@ namespace nvrhi::d3d12
 {
     class RootSignature;
     class Buffer;
+    class AccelStruct;
+    class OpacityMicromap;
     class CommandList;
     class Device;
     struct Context;
@@ -145,15 +170,27 @@ namespace nvrhi::d3d12
         std::unique_ptr<rtxmu::DxAccelStructManager> rtxMemUtil;
 #endif
 
+        // Declared before the buffers below, which release their memory from it
+        std::unique_ptr<MemoryStatisticsTracker> memoryStatistics;
+
         RefCountPtr<ID3D12CommandSignature> drawIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> drawIndexedIndirectSignature;
         RefCountPtr<ID3D12CommandSignature> dispatchIndirectSignature;
+        RefCountPtr<ID3D12CommandSignature> dispatchMeshIndirectSignature;
         RefCountPtr<ID3D12QueryHeap> timerQueryHeap;
         RefCountPtr<Buffer> timerQueryResolveBuffer;
+        RefCountPtr<ID3D12QueryHeap> occlusionQueryHeap;
+        RefCountPtr<Buffer> occlusionQueryResolveBuffer;
+        RefCountPtr<Buffer> predicationBuffer; // default heap, not state tracked: see CommandList::setPredication
+        RefCountPtr<ID3D12QueryHeap> pipelineStatisticsQueryHeap;
+        RefCountPtr<Buffer> pipelineStatisticsQueryResolveBuffer;
 
         bool logBufferLifetime = false;
+        bool enhancedBarriersEnabled = false;
+        bool renderPassesEnabled = false;
         IMessageCallback* messageCallback = nullptr;
         void error(const std::string& message) const;
+        void warning(const std::string& message) const;
         void info(const std::string& message) const;
     };
 
@@ -169,17 +206,32 @@ namespace nvrhi::d3d12
         D3D12_GPU_DESCRIPTOR_HANDLE m_StartGpuHandleShaderVisible = { 0 };
         uint32_t m_Stride = 0;
         uint32_t m_NumDescriptors = 0;
-        std::vector<bool> m_AllocatedDescriptors;
+        std::vector<uint64_t> m_AllocatedDescriptors; // one bit per descriptor, 64 descriptors per word
         DescriptorIndex m_SearchStart = 0;
         uint32_t m_NumAllocatedDescriptors = 0;
         std::mutex m_Mutex;
 
+        // Lock-free cache of released single descriptors that serves single-descriptor allocations
+        // without taking the mutex. Each thread starts probing at its own slot to avoid contention.
+        // Cached descriptors remain marked as allocated in the bitmap until the cache is flushed.
+        static constexpr uint32_t c_SingleDescriptorCacheSize = 256;
+        static constexpr uint32_t c_SingleDescriptorCacheProbes = 8;
+        std::array<std::atomic<DescriptorIndex>, c_SingleDescriptorCacheSize> m_SingleDescriptorCache;
+
         HRESULT Grow(uint32_t minRequiredSize);
+        DescriptorIndex findFreeRange(uint32_t count) const;
+        void markDescriptors(DescriptorIndex baseIndex, uint32_t count, bool allocated);
+        DescriptorIndex takeCachedDescriptor();
+        bool putCachedDescriptor(DescriptorIndex index);
+        bool flushSingleDescriptorCache();
     public:
         explicit StaticDescriptorHeap(const Context& context);
 
         HRESULT allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors, bool shaderVisible);
         void copyToShaderVisibleHeap(DescriptorIndex index, uint32_t count = 1);
+
+        // Adds the descriptor storage of this heap, and of its shader visible copy, to the statistics
+        void getStatistics(MemoryCategoryStatistics& statistics);
         
         DescriptorIndex allocateDescriptors(uint32_t count) override;
         DescriptorIndex allocateDescriptor() override;
@@ -192,6 +244,101 @@ namespace nvrhi::d3d12
         [[nodiscard]] ID3D12DescriptorHeap* getShaderVisibleHeap() const override;
     };
 
+    // Key of a committed resource or heap in ResidencyTracker
+    inline uint64_t getResidencyKey(ID3D12Pageable* pageable) { return uint64_t(reinterpret_cast<uintptr_t>(pageable)); }
+
+    struct PlacedResourceHeap;
+
+    struct PlacedResourceAllocation
+    {
+        PlacedResourceHeap* heap = nullptr;
+        TlsfAllocator::Allocation suballocation;
+
+        [[nodiscard]] bool isValid() const { return heap != nullptr; }
+    };
+
+    // Sub-allocates placed resources from shared ID3D12Heaps, see DeviceDesc::enablePlacedResources.
+    // With resource heap tier 1, buffers and textures are placed into separate heaps.
+    class PlacedResourceAllocator
+    {
+    public:
+        PlacedResourceAllocator(const Context& context, ResidencyTracker& residency)
+            : m_Context(context)
+            , m_Residency(residency)
+        { }
+
+        void initialize(uint64_t heapSize, D3D12_RESOURCE_HEAP_TIER heapTier);
+        [[nodiscard]] bool isEnabled() const { return m_HeapSize != 0; }
+
+        // Returns true if the resource can be placed at all, and updates its alignment to the smallest legal one
+        [[nodiscard]] bool canPlaceResource(D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_ALLOCATION_INFO& outAllocationInfo) const;
+
+        bool allocate(D3D12_HEAP_TYPE heapType, bool isTexture, const D3D12_RESOURCE_ALLOCATION_INFO& allocationInfo,
+            PlacedResourceAllocation& outAllocation, ID3D12Heap** outHeap, uint64_t* outOffset);
+        void release(PlacedResourceAllocation& allocation);
+
+        [[nodiscard]] PlacedResourceStatistics getStatistics();
+
+    private:
+        const Context& m_Context;
+        ResidencyTracker& m_Residency;
+        uint64_t m_HeapSize = 0;
+        D3D12_RESOURCE_HEAP_TIER m_HeapTier = D3D12_RESOURCE_HEAP_TIER_1;
+
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<PlacedResourceHeap>> m_Heaps;
+        PlacedResourceStatistics m_Statistics;
+
+        PlacedResourceHeap* createHeap(D3D12_HEAP_TYPE heapType, bool forTextures);
+    };
+
+    struct SmallBufferBlock;
+
+    struct SmallBufferAllocation
+    {
+        SmallBufferBlock* block = nullptr;
+        uint32_t slot = 0;
+
+        [[nodiscard]] bool isValid() const { return block != nullptr; }
+    };
+
+    // Packs small buffers into shared 64 KB buffers, see DeviceDesc::enableSmallBufferPacking.
+    // Every block serves one power-of-2 size class, and one initial state and keepInitialState combination,
+    // because the buffers packed into a block are tracked as the block buffer and share its state.
+    class SmallBufferAllocator
+    {
+    public:
+        static constexpr uint64_t c_BlockSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        static constexpr uint64_t c_MinSlotSize = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+        static constexpr uint64_t c_MaxSlotSize = c_BlockSize / 2;
+
+        SmallBufferAllocator() = default;
+        ~SmallBufferAllocator();
+
+        // The blocks are created with device->createBuffer
+        void initialize(Device* device) { m_Device = device; }
+        [[nodiscard]] bool isEnabled() const { return m_Device != nullptr; }
+
+        // Returns true if views and copies of the buffer work at an offset inside a shared resource
+        [[nodiscard]] static bool canPackBuffer(const BufferDesc& desc);
+
+        bool allocate(const BufferDesc& desc, SmallBufferAllocation& outAllocation, Buffer*& outBlockBuffer, uint64_t& outOffset);
+        void release(SmallBufferAllocation& allocation);
+
+        // Drops the references to the block buffers, called when the device is destroyed
+        void releaseBlocks();
+
+        void getStatistics(PlacedResourceStatistics& statistics);
+
+    private:
+        Device* m_Device = nullptr;
+
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<SmallBufferBlock>> m_Blocks;
+        uint32_t m_NumBuffers = 0;
+        uint64_t m_BufferBytes = 0;
+    };
+
     class DeviceResources
     {
     public:
@@ -200,6 +347,8 @@ namespace nvrhi::d3d12
         StaticDescriptorHeap shaderResourceViewHeap;
         StaticDescriptorHeap samplerHeap;
         utils::BitSetAllocator timerQueries;
+        utils::BitSetAllocator occlusionQueries;
+        utils::BitSetAllocator pipelineStatisticsQueries;
 #ifdef NVRHI_WITH_RTXMU
         std::mutex asListMutex;
         std::vector<uint64_t> asBuildsCompleted;
@@ -207,6 +356,25 @@ namespace nvrhi::d3d12
 
         // The cache does not own the RS objects, so store weak references
         std::unordered_map<size_t, RootSignature*> rootsigCache;
+        std::mutex rootsigCacheMutex; // pipelines can be created on the pipeline compiler threads
+
+        // Declared before placedResources, which registers its heaps here
+        ResidencyTracker residency;
+        PlacedResourceAllocator placedResources;
+        // Declared after placedResources, the blocks are buffers that may be placed in its heaps
+        SmallBufferAllocator smallBuffers;
+
+        // Native BLAS compaction, used when NVRHI is built without RTXMU.
+        // The builds write compacted sizes into sizeBuffer, which are copied into the mapped readback buffer;
+        // BLAS'es are added to asCompactionCandidates when their build command lists finish.
+        // OMMs share the size slots and are added to ommCompactionCandidates, also with RTXMU.
+        utils::BitSetAllocator compactedSizeQueries;
+        BufferHandle compactedSizeBuffer;
+        BufferHandle compactedSizeReadbackBuffer;
+        const uint64_t* compactedSizes = nullptr;
+        std::vector<AccelStruct*> asCompactionCandidates;
+        std::vector<OpacityMicromap*> ommCompactionCandidates;
+        std::mutex asCompactionMutex;
 
         explicit DeviceResources(const Context& context, const DeviceDesc& desc);
 
@@ -223,6 +391,7 @@ namespace nvrhi::d3d12
     public:
         ShaderDesc desc;
         std::vector<char> bytecode;
+        ShaderHandle baseShader; // Set for specializations, which are built from the bytecode of this shader
     #if NVRHI_D3D12_WITH_NVAPI
         std::vector<NVAPI_D3D12_PSO_EXTENSION_DESC*> extensions;
         std::vector<NV_CUSTOM_SEMANTIC> customSemantics;
@@ -267,10 +436,20 @@ namespace nvrhi::d3d12
         HeapDesc desc;
         RefCountPtr<ID3D12Heap> heap;
 
+        explicit Heap(ResidencyTracker& residency)
+            : m_Residency(residency)
+        { }
+
+        ~Heap() override;
+
         const HeapDesc& getDesc() override { return desc; }
+        Object getNativeObject(ObjectType objectType) override;
+
+    private:
+        ResidencyTracker& m_Residency;
     };
 
-    class Texture : public RefCounter<ITexture>, public TextureStateExtension
+    class Texture : public DeferredRefCounter<ITexture>, public TextureStateExtension
     {
     public:
         const TextureDesc desc;
@@ -279,7 +458,10 @@ namespace nvrhi::d3d12
         uint8_t planeCount = 1;
         HANDLE sharedHandle = nullptr;
         HeapHandle heap;
+        PlacedResourceAllocation placedAllocation;
 
+        // Size counted in MemoryCategory::Textures, 0 for the resources that NVRHI doesn't allocate
+        uint64_t trackedMemorySize = 0;
 
         Texture(const Context& context, DeviceResources& resources, TextureDesc desc, const D3D12_RESOURCE_DESC& resourceDesc)
             : TextureStateExtension(this->desc)
@@ -309,14 +491,15 @@ namespace nvrhi::d3d12
         const Context& m_Context;
         DeviceResources& m_Resources;
 
-        TextureBindingKey_HashMap<DescriptorIndex> m_RenderTargetViews;
-        TextureBindingKey_HashMap<DescriptorIndex> m_DepthStencilViews;
-        TextureBindingKey_HashMap<DescriptorIndex> m_CustomSRVs;
-        TextureBindingKey_HashMap<DescriptorIndex> m_CustomUAVs;
+        // getNativeView is free-threaded, these caches are read without locking
+        ViewCache<TextureBindingKey, DescriptorIndex> m_RenderTargetViews;
+        ViewCache<TextureBindingKey, DescriptorIndex> m_DepthStencilViews;
+        ViewCache<TextureBindingKey, DescriptorIndex> m_CustomSRVs;
+        ViewCache<TextureBindingKey, DescriptorIndex> m_CustomUAVs;
         std::vector<DescriptorIndex> m_ClearMipLevelUAVs;
     };
 
-    class Buffer : public RefCounter<IBuffer>, public BufferStateExtension
+    class Buffer : public DeferredRefCounter<IBuffer>, public BufferStateExtension
     {
     public:
         const BufferDesc desc;
@@ -325,11 +508,21 @@ namespace nvrhi::d3d12
         D3D12_RESOURCE_DESC resourceDesc{};
 
         HeapHandle heap;
+        PlacedResourceAllocation placedAllocation;
+
+        // Buffers packed by SmallBufferAllocator share the resource of their block at resourceOffset,
+        // and their states are tracked as the states of the block
+        RefCountPtr<Buffer> packedBlock;
+        SmallBufferAllocation packedAllocation;
+        uint64_t resourceOffset = 0;
 
         RefCountPtr<ID3D12Fence> lastUseFence;
         uint64_t lastUseFenceValue = 0;
         HANDLE sharedHandle = nullptr;
 
+        // Size counted in MemoryCategory::Buffers, 0 for the resources that NVRHI doesn't allocate
+        uint64_t trackedMemorySize = 0;
+
         Buffer(const Context& context, DeviceResources& resources, BufferDesc desc)
             : BufferStateExtension(this->desc)
             , desc(std::move(desc))
@@ -344,6 +537,9 @@ namespace nvrhi::d3d12
 
         Object getNativeObject(ObjectType objectType) override;
 
+        // The buffer whose state is tracked for this one
+        [[nodiscard]] Buffer* getTrackedBuffer() { return packedBlock ? packedBlock.Get() : this; }
+
         void postCreate();
         DescriptorIndex getClearUAV();
         void createCBV(size_t descriptor, BufferRange range) const;
@@ -463,6 +659,17 @@ namespace nvrhi::d3d12
         bool resolved = false;
     };
 
+    class SyncPoint : public RefCounter<ISyncPoint>
+    {
+    public:
+        CommandQueue queue = CommandQueue::Graphics;
+        RefCountPtr<ID3D12Fence> fence; // the fence of the queue
+        std::atomic<uint64_t> value = 0; // assigned when the signaling command list is executed
+
+        [[nodiscard]] CommandQueue getQueue() const override { return queue; }
+        [[nodiscard]] uint64_t getValue() const override { return value; }
+    };
+
     class TimerQuery : public RefCounter<ITimerQuery>
     {
     public:
@@ -486,6 +693,95 @@ namespace nvrhi::d3d12
         DeviceResources& m_Resources;
     };
 
+    class OcclusionQuery : public RefCounter<IOcclusionQuery>
+    {
+    public:
+        OcclusionQueryType type = OcclusionQueryType::SampleCount;
+        uint32_t queryIndex = 0;
+
+        RefCountPtr<ID3D12Fence> fence;
+        uint64_t fenceCounter = 0;
+
+        bool started = false;
+        bool resolved = false;
+        uint64_t result = 0;
+
+        OcclusionQuery(DeviceResources& resources)
+            : m_Resources(resources)
+        { }
+
+        ~OcclusionQuery() override;
+
+        OcclusionQueryType getType() const override { return type; }
+        [[nodiscard]] D3D12_QUERY_TYPE getQueryType() const { return type == OcclusionQueryType::Binary ? D3D12_QUERY_TYPE_BINARY_OCCLUSION : D3D12_QUERY_TYPE_OCCLUSION; }
+
+    private:
+        DeviceResources& m_Resources;
+    };
+
+    class PipelineStatisticsQuery : public RefCounter<IPipelineStatisticsQuery>
+    {
+    public:
+        uint32_t queryIndex = 0;
+
+        RefCountPtr<ID3D12Fence> fence;
+        uint64_t fenceCounter = 0;
+
+        bool started = false;
+        bool resolved = false;
+        PipelineStatistics result;
+
+        PipelineStatisticsQuery(DeviceResources& resources)
+            : m_Resources(resources)
+        { }
+
+        ~PipelineStatisticsQuery() override;
+
+    private:
+        DeviceResources& m_Resources;
+    };
+
+    class TimerQueryPool : public RefCounter<ITimerQueryPool>
+    {
+    public:
+        struct Frame
+        {
+            uint64_t frameIndex = 0; // 0 if the slot was never used
+            std::atomic<uint32_t> numQueriesUsed = 0; // highest ended query index + 1, determines the resolved range
+
+            // set when the command list that resolves the frame is executed
+            RefCountPtr<ID3D12Fence> fence;
+            uint64_t fenceCounter = 0;
+        };
+
+        TimerQueryPoolDesc desc;
+        RefCountPtr<ID3D12QueryHeap> heap;
+        RefCountPtr<Buffer> resolveBuffer;
+        const uint64_t* resolveData = nullptr; // the readback buffer stays mapped
+        uint64_t timestampFrequency = 0;
+
+        std::vector<Frame> frames;
+        std::atomic<uint64_t> currentFrameIndex = 0;
+        std::mutex mutex;
+
+        Frame& getFrame(uint64_t frameIndex) { return frames[(frameIndex - 1) % frames.size()]; }
+        [[nodiscard]] uint32_t getFirstQuery(uint64_t frameIndex) const { return uint32_t((frameIndex - 1) % frames.size()) * desc.maxQueriesPerFrame * 2; }
+
+        ~TimerQueryPool() override;
+
+        const TimerQueryPoolDesc& getDesc() const override { return desc; }
+        uint64_t getCurrentFrameIndex() const override { return currentFrameIndex; }
+        Object getNativeObject(ObjectType objectType) override;
+    };
+
+    struct VolatileConstantBufferParameter
+    {
+        RootParameterIndex rootParameterIndex = ~0u;
+        D3D12_ROOT_DESCRIPTOR1 descriptor{};
+        // Number of 32-bit values if the CB is passed as inline root constants, 0 if it's a root CBV
+        uint32_t numInlineConstants = 0;
+    };
+
     class BindingLayout : public RefCounter<IBindingLayout>
     {
     public:
@@ -499,7 +795,7 @@ namespace nvrhi::d3d12
         std::vector<D3D12_DESCRIPTOR_RANGE1> descriptorRangesSRVetc;
         std::vector<D3D12_DESCRIPTOR_RANGE1> descriptorRangesSamplers;
         std::vector<BindingLayoutItem> bindingLayoutsSRVetc;
-        static_vector<std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
+        static_vector<VolatileConstantBufferParameter, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
         static_vector<D3D12_ROOT_PARAMETER1, 32> rootParameters;
 
         BindingLayout(const BindingLayoutDesc& desc);
@@ -525,6 +821,7 @@ namespace nvrhi::d3d12
     {
     public:
         size_t hash = 0;
+        uint64_t serializedHash = 0; // StableHasher of the serialized blob, used in pipeline library keys
         static_vector<std::pair<BindingLayoutHandle, RootParameterIndex>, c_MaxBindingLayouts> pipelineLayouts;
         RefCountPtr<ID3D12RootSignature> handle;
         uint32_t pushConstantByteSize = 0;
@@ -584,6 +881,7 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12PipelineState> pipelineState;
 
         bool requiresBlendFactor = false;
+        bool pixelShaderHasUAVs = false;
         
         const GraphicsPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
@@ -614,12 +912,28 @@ namespace nvrhi::d3d12
         DX12_ViewportState viewportState;
 
         bool requiresBlendFactor = false;
+        bool pixelShaderHasUAVs = false;
         
         const MeshletPipelineDesc& getDesc() const override { return desc; }
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
         Object getNativeObject(ObjectType objectType) override;
     };
     
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        RefCountPtr<ID3D12CommandSignature> signature;
+        RefCountPtr<IResource> pipeline;
+        IndirectArgumentType action = IndirectArgumentType::Draw;
+
+        // True if the arguments overwrite any bindings, which have to be set again after executeIndirect
+        bool changesState = false;
+
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override;
+    };
+
     class BindingSet : public RefCounter<IBindingSet>
     {
     public:
@@ -635,6 +949,9 @@ namespace nvrhi::d3d12
         bool descriptorTableValidSamplers = false;
         bool hasUavBindings = false;
 
+        // Transient sets don't release their descriptor tables, those are owned by a command list instance
+        bool isTransient = false;
+
         static_vector<std::pair<RootParameterIndex, IBuffer*>, c_MaxVolatileConstantBuffersPerLayout> rootParametersVolatileCB;
         
         std::vector<RefCountPtr<IResource>> resources;
@@ -648,7 +965,12 @@ namespace nvrhi::d3d12
 
         ~BindingSet() override;
 
-        void createDescriptors();
+        // Allocates and fills the descriptor tables. Pre-allocated table locations can be provided
+        // for transient binding sets, otherwise the tables are allocated from the device heaps.
+        void createDescriptors(DescriptorIndex samplerTableBase = c_InvalidDescriptorIndex, DescriptorIndex srvTableBase = c_InvalidDescriptorIndex);
+
+        // Returns a transient binding set object to its initial state before it is reused, see CommandList::createTransientBindingSet
+        void resetTransient();
 
         const BindingSetDesc* getDesc() const override { return &desc; }
         IBindingLayout* getLayout() const override { return layout; }
@@ -681,6 +1003,9 @@ namespace nvrhi::d3d12
 
     DX12_ViewportState convertViewportState(const RasterState& rasterState, const FramebufferInfoEx& framebufferInfo, const ViewportState& vpState);
 
+    // Tells if any of the layouts can bind UAVs to the pixel shader, which requires D3D12_RENDER_PASS_FLAG_ALLOW_UAV_WRITES
+    bool pixelShaderMayWriteUAVs(const BindingLayoutVector& bindingLayouts);
+
     class TextureState
     {
     public:
@@ -706,6 +1031,18 @@ namespace nvrhi::d3d12
     };
 
     D3D12_RESOURCE_STATES convertResourceStates(ResourceStates stateBits);
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+    struct BarrierStateMapping
+    {
+        D3D12_BARRIER_SYNC sync = D3D12_BARRIER_SYNC_NONE;
+        // Accumulated from the state bits, COMMON is zero - replaced with NO_ACCESS when no sync is needed
+        D3D12_BARRIER_ACCESS access = D3D12_BARRIER_ACCESS_COMMON;
+        D3D12_BARRIER_LAYOUT layout = D3D12_BARRIER_LAYOUT_UNDEFINED;
+    };
+
+    BarrierStateMapping convertBarrierStates(ResourceStates stateBits, bool isTexture);
+#endif
     
     class BufferChunk
     {
@@ -720,19 +1057,26 @@ namespace nvrhi::d3d12
         D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
         uint32_t identifier = 0;
 
+        // Set once the chunk is created, the chunk releases its memory from the tracker
+        MemoryStatisticsTracker* memoryStatistics = nullptr;
+        MemoryCategory memoryCategory = MemoryCategory::UploadChunks;
+
         ~BufferChunk();
     };
 
     class UploadManager
     {
     public:
-        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer);
+        UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer, uint64_t ringSize);
 
         bool suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset, void** pCpuVA,
             D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment = 256);
 
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
+        // Adds the chunks and the ring of this manager to the statistics of its category
+        void getStatistics(MemoryStatistics& statistics) const;
+
     private:
         const Context& m_Context;
         Queue* m_Queue;
@@ -744,7 +1088,12 @@ namespace nvrhi::d3d12
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
 
+        RingAllocator m_Ring;
+        std::shared_ptr<BufferChunk> m_RingChunk;
+
         [[nodiscard]] std::shared_ptr<BufferChunk> createChunk(size_t size) const;
+        bool suballocateFromRing(uint64_t size, ID3D12Resource** pBuffer, size_t* pOffset, void** pCpuVA,
+            D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint32_t alignment);
     };
 
     class OpacityMicromap : public RefCounter<rt::IOpacityMicromap>
@@ -754,15 +1103,23 @@ namespace nvrhi::d3d12
         rt::OpacityMicromapDesc desc;
         bool allowUpdate = false;
         bool compacted = false;
+        bool compactionPending = false; // listed in DeviceResources::ommCompactionCandidates
+        int compactedSizeQuery = -1; // slot in DeviceResources::compactedSizeBuffer, kept until the OMM is compacted
 
-        OpacityMicromap()
+        explicit OpacityMicromap(DeviceResources& resources)
+            : m_Resources(resources)
         { }
 
+        ~OpacityMicromap() override;
+
         Object getNativeObject(ObjectType objectType) override;
 
         const rt::OpacityMicromapDesc& getDesc() const override { return desc; }
         bool isCompacted() const override { return compacted; }
         uint64_t getDeviceAddress() const override;
+
+    private:
+        DeviceResources& m_Resources;
     };
 
     class AccelStruct : public RefCounter<rt::IAccelStruct>
@@ -771,16 +1128,22 @@ namespace nvrhi::d3d12
         RefCountPtr<d3d12::Buffer> dataBuffer;
         std::vector<rt::AccelStructHandle> bottomLevelASes;
         std::vector<D3D12_RAYTRACING_INSTANCE_DESC> dxrInstances;
+        RefCountPtr<d3d12::Buffer> instanceBuffer;
+        std::vector<rt::AccelStructHandle> instanceBufferBLASes; // per instance slot, for liveness tracking
         rt::AccelStructDesc desc;
+        size_t builtInstances = 0;
         bool allowUpdate = false;
         bool compacted = false;
+        bool compactionPending = false; // listed in DeviceResources::asCompactionCandidates
+        int compactedSizeQuery = -1; // slot in DeviceResources::compactedSizeBuffer, kept until the BLAS is compacted
         size_t rtxmuId = ~0ull;
 #ifdef NVRHI_WITH_RTXMU
         D3D12_GPU_VIRTUAL_ADDRESS rtxmuGpuVA = 0;
 #endif
 
-        AccelStruct(const Context& context)
+        AccelStruct(const Context& context, DeviceResources& resources)
             : m_Context(context)
+            , m_Resources(resources)
         { }
 
         ~AccelStruct() override;
@@ -792,9 +1155,11 @@ namespace nvrhi::d3d12
         const rt::AccelStructDesc& getDesc() const override { return desc; }
         bool isCompacted() const override { return compacted; }
         uint64_t getDeviceAddress() const override;
+        IBuffer* getInstanceBuffer() const override { return instanceBuffer; }
         
     private:
         const Context& m_Context;
+        DeviceResources& m_Resources;
     };
 
     class RayTracingPipeline : public RefCounter<rt::IPipeline>
@@ -813,7 +1178,8 @@ namespace nvrhi::d3d12
             const void* pShaderIdentifier;
         };
 
-        std::unordered_map<std::string, ExportTableEntry> exports;
+        std::vector<ExportTableEntry> exportEntries; // indexed by rt::ShaderExportId
+        std::unordered_map<std::string, rt::ShaderExportId> exports;
         uint32_t maxLocalRootParameters = 0;
 
         RayTracingPipeline(const Context& context, Device* device)
@@ -821,12 +1187,14 @@ namespace nvrhi::d3d12
             , m_Device(device)
         { }
 
-        const ExportTableEntry* getExport(const char* name);
+        const ExportTableEntry* getExport(rt::ShaderExportId exportId) const; // returns nullptr if the ID is invalid
+        void addExport(const std::string& exportName, const ExportTableEntry& entry);
         uint32_t getShaderTableEntrySize() const;
         bool hasLocalResources() const { return maxLocalRootParameters != 0; }
 
         const rt::PipelineDesc& getDesc() const override { return desc; }
         rt::ShaderTableHandle createShaderTable(rt::ShaderTableDesc const& stDesc) override;
+        rt::ShaderExportId getShaderExportId(const char* exportName) const override;
 
     private:
         const Context& m_Context;
@@ -838,6 +1206,7 @@ namespace nvrhi::d3d12
     {
     public:
         uint32_t committedVersion = 0;
+        uint32_t committedLayoutVersion = 0;
         ID3D12DescriptorHeap* descriptorHeapSRV = nullptr;
         ID3D12DescriptorHeap* descriptorHeapSamplers = nullptr;
         D3D12_DISPATCH_RAYS_DESC dispatchRaysTemplate = {};
@@ -861,6 +1230,16 @@ namespace nvrhi::d3d12
 
         uint32_t version = 0;
 
+        // Cached tables keep each section at a fixed place in the cache, with room for the reserved number of records.
+        // The layout version changes when a reservation grows, which requires uploading the whole table again.
+        uint32_t missCapacity = 0;
+        uint32_t hitGroupCapacity = 0;
+        uint32_t callableCapacity = 0;
+        uint32_t layoutVersion = 1;
+
+        // Indices of the cache records modified since the last upload
+        std::vector<uint32_t> dirtyRecords;
+
         BufferHandle cache;
         ShaderTableState cacheState;
         
@@ -868,10 +1247,25 @@ namespace nvrhi::d3d12
             : pipeline(_pipeline)
             , m_Context(context)
             , m_Desc(desc)
-        { }
+        {
+            if (desc.isCached)
+            {
+                missCapacity = desc.reservedMissShaders;
+                hitGroupCapacity = desc.reservedHitGroups;
+                callableCapacity = desc.reservedCallableShaders;
+            }
+        }
 
-        size_t getUploadSize() const { return pipeline->getShaderTableEntrySize() * size_t(getNumEntries()); }
+        uint32_t getMissShaderBase() const { return 1; }
+        uint32_t getHitGroupBase() const { return getMissShaderBase() + (m_Desc.isCached ? missCapacity : uint32_t(missShaders.size())); }
+        uint32_t getCallableShaderBase() const { return getHitGroupBase() + (m_Desc.isCached ? hitGroupCapacity : uint32_t(hitGroups.size())); }
+        uint32_t getNumRecords() const { return getCallableShaderBase() + (m_Desc.isCached ? callableCapacity : uint32_t(callableShaders.size())); }
+        size_t getUploadSize() const { return pipeline->getShaderTableEntrySize() * size_t(getNumRecords()); }
         bool isStateValid(ShaderTableState const& state, DeviceResources const& resources) const;
+        bool canUpdateRecords(ShaderTableState const& state, DeviceResources const& resources) const;
+        const Entry* getRecord(uint32_t recordIndex) const;
+        void writeRecord(uint8_t* cpuVA, uint32_t recordIndex, DeviceResources& resources) const;
+        void fillDispatchRaysTemplate(D3D12_GPU_VIRTUAL_ADDRESS gpuVA, ShaderTableState& state) const;
         void bake(uint8_t* cpuVA, D3D12_GPU_VIRTUAL_ADDRESS gpuVA, DeviceResources& resources,
             ShaderTableState& state);
         
@@ -881,7 +1275,15 @@ namespace nvrhi::d3d12
         void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addHitGroups(const char* const* exportNames, IBindingSet* const* bindings, size_t count) override;
+        void setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
         int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        void setRayGenerationShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addMissShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addHitGroup(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addHitGroups(const rt::ShaderExportId* exportIds, IBindingSet* const* bindings, size_t count) override;
+        void setHitGroup(uint32_t index, rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addCallableShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
@@ -890,7 +1292,10 @@ namespace nvrhi::d3d12
         const Context& m_Context;
         rt::ShaderTableDesc const m_Desc;
 
+        bool resolveExportName(const char* exportName, rt::ShaderExportId& outExportId) const;
         bool verifyExport(const RayTracingPipeline::ExportTableEntry* pExport, IBindingSet* bindings) const;
+        void reserveRecords(uint32_t& capacity, size_t count);
+        void markRecordDirty(uint32_t recordIndex);
     };
 
 
@@ -899,16 +1304,26 @@ namespace nvrhi::d3d12
     public:
         RefCountPtr<ID3D12CommandQueue> queue;
         RefCountPtr<ID3D12Fence> fence;
-        uint64_t lastSubmittedInstance = 0;
-        uint64_t lastCompletedInstance = 0;
+        // Written by executeCommandLists, read concurrently by command lists being opened on other threads
+        std::atomic<uint64_t> lastSubmittedInstance = 0;
+        std::atomic<uint64_t> lastCompletedInstance = 0;
         std::atomic<uint64_t> recordingInstance = 1;
         std::deque<std::shared_ptr<class CommandListInstance>> commandListsInFlight;
 
         explicit Queue(const Context& context, ID3D12CommandQueue* queue);
         uint64_t updateLastCompletedInstance();
 
+        // Allocator/list pairs left over by destroyed command lists, shared by all command lists on this queue.
+        // Only used when a command list's own pool has nothing to reuse, so it's off the common open() path.
+        std::shared_ptr<class InternalCommandList> takeRecycledCommandList(uint64_t completedInstance);
+        void recycleCommandLists(std::list<std::shared_ptr<class InternalCommandList>>& commandLists);
+
     private:
         const Context& m_Context;
+
+        std::mutex m_RecycledCommandListsMutex;
+        std::deque<std::shared_ptr<class InternalCommandList>> m_RecycledCommandLists;
+        std::atomic<size_t> m_NumRecycledCommandLists = 0;
     };
     
     class InternalCommandList
@@ -918,6 +1333,9 @@ namespace nvrhi::d3d12
         RefCountPtr<ID3D12GraphicsCommandList> commandList;
         RefCountPtr<ID3D12GraphicsCommandList4> commandList4;
         RefCountPtr<ID3D12GraphicsCommandList6> commandList6;
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        RefCountPtr<ID3D12GraphicsCommandList7> commandList7;
+#endif
 #if NVRHI_D3D12_WITH_COOPVEC
         RefCountPtr<ID3D12GraphicsCommandListPreview> commandListPreview;
 #endif
@@ -927,19 +1345,46 @@ namespace nvrhi::d3d12
 #endif
     };
 
+    struct TransientDescriptorChunk
+    {
+        StaticDescriptorHeap* heap = nullptr;
+        DescriptorIndex baseIndex = c_InvalidDescriptorIndex;
+        uint32_t count = 0;
+    };
+
+    // Objects of transient binding sets, shared by a command list and its instances.
+    // The instances return their sets when they are destroyed, and the command list takes them all at once when it runs out.
+    struct TransientBindingSetPool
+    {
+        std::mutex mutex;
+        std::vector<RefCountPtr<BindingSet>> freeSets;
+    };
+
     class CommandListInstance
     {
     public:
+        ~CommandListInstance();
+
         uint64_t submittedInstance = 0;
         CommandQueue commandQueue = CommandQueue::Graphics;
         RefCountPtr<ID3D12Fence> fence;
         RefCountPtr<ID3D12CommandAllocator> commandAllocator;
         RefCountPtr<ID3D12CommandList> commandList;
-        std::vector<RefCountPtr<IResource>> referencedResources;
+        ResourceReferenceSet referencedResources; // one reference per unique object
         std::vector<RefCountPtr<IUnknown>> referencedNativeResources;
         std::vector<RefCountPtr<StagingTexture>> referencedStagingTextures;
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers;
         std::vector<RefCountPtr<TimerQuery>> referencedTimerQueries;
+        std::vector<RefCountPtr<OcclusionQuery>> referencedOcclusionQueries;
+        std::vector<RefCountPtr<PipelineStatisticsQuery>> referencedPipelineStatisticsQueries;
+        std::vector<std::pair<RefCountPtr<TimerQueryPool>, uint64_t>> resolvedTimerQueryFrames; // pool and frame index
+        std::vector<TransientDescriptorChunk> transientDescriptorChunks; // returned to their heaps on destruction
+        std::vector<RefCountPtr<BindingSet>> transientBindingSets; // returned to transientBindingSetPool on destruction
+        std::shared_ptr<TransientBindingSetPool> transientBindingSetPool;
+        std::vector<std::shared_ptr<CommandListInstance>> referencedBundles; // recordings of the bundles executed in this instance
+        std::vector<rt::AccelStructHandle> accelStructsToCompact; // BLAS'es that had their compacted sizes written
+        std::vector<rt::OpacityMicromapHandle> ommsToCompact; // OMMs that had their compacted sizes written
+        std::shared_ptr<CommandListInstance> reusedInstance; // for executions of reusable command lists, the recording that was executed
 #ifdef NVRHI_WITH_RTXMU
         std::vector<uint64_t> rtxmuBuildIds;
         std::vector<uint64_t> rtxmuCompactionIds;
@@ -960,6 +1405,25 @@ namespace nvrhi::d3d12
         void requireBufferState(IBuffer* buffer, ResourceStates state);
         ID3D12CommandList* getD3D12CommandList() const { return m_ActiveCommandList->commandList; }
 
+        // Copies one subresource from a buffer laid out as returned by GetCopyableFootprints, starting at srcOffset
+        void copyBufferToTexture(Texture* dest, uint32_t arraySlice, uint32_t mipLevel, Buffer* src, uint64_t srcOffset);
+
+        // Copies between two buffers packed into the same shared resource through m_PackedCopyBuffer
+        void copyPackedBuffer(Buffer* dest, uint64_t destOffsetBytes, Buffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes);
+
+        // Parts of the recording that were finished by signalSyncPoint or waitSyncPoint, in execution order.
+        // m_ActiveCommandList records the part after the last one.
+        struct SyncSegment
+        {
+            std::shared_ptr<InternalCommandList> commandList;
+            RefCountPtr<SyncPoint> signalAfter; // signaled after this part
+            RefCountPtr<SyncPoint> waitAfter; // waited for before the next part
+        };
+        const std::vector<SyncSegment>& getSyncSegments() const { return m_SyncSegments; }
+        const CommandListInstance& getInstance() const { return *m_Instance; }
+        const CommandListResourceStateTracker& getStateTracker() const { return m_StateTracker; }
+        void recordStateHandoffBarriers(const StateHandoffResolver& resolver);
+
         // IResource implementation
 
         Object getNativeObject(ObjectType objectType) override;
@@ -976,12 +1440,18 @@ namespace nvrhi::d3d12
         void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
         void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, Format format) override;
         void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources) override;
+        void* beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch) override;
+        void endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter) override;
+        void blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -990,10 +1460,17 @@ namespace nvrhi::d3d12
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) override;
+        void setIndexBuffer(const IndexBufferBinding& indexBuffer) override;
+        void setViewportState(const ViewportState& viewport) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void executeBundles(nvrhi::ICommandList* const* bundles, size_t numBundles) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -1001,22 +1478,40 @@ namespace nvrhi::d3d12
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void beginTimerQueryFrame(ITimerQueryPool* pool) override;
+        void beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimerQueries(ITimerQueryPool* pool) override;
+        void beginOcclusionQuery(IOcclusionQuery* query) override;
+        void endOcclusionQuery(IOcclusionQuery* query) override;
+        void beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void endPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void setPredication(IOcclusionQuery* query, PredicationOp op) override;
+        SyncPointHandle signalSyncPoint() override;
+        void waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages) override;
 
         void beginMarker(const char *name) override;
         void endMarker() override;
@@ -1037,6 +1532,10 @@ namespace nvrhi::d3d12
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
 
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
         void commitBarriers() override;
 
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
@@ -1044,6 +1543,7 @@ namespace nvrhi::d3d12
 
         nvrhi::IDevice* getDevice() override;
         const CommandListParameters& getDesc() override { return m_Desc; }
+        MemoryStatistics getMemoryStatistics() override;
 
         // D3D12 specific methods
 
@@ -1065,8 +1565,34 @@ namespace nvrhi::d3d12
         {
             uint32_t bindingPoint; // RootParameterIndex
             Buffer* buffer;
-            D3D12_GPU_VIRTUAL_ADDRESS address;
+            uint32_t numInlineConstants; // 0 for root CBVs
+            uint32_t version; // VolatileConstantBufferState::version that was last bound
         };
+
+        // The latest contents of a volatile CB written in this command list.
+        // Small writes are kept on the CPU, and are only uploaded if the buffer is bound as a root CBV.
+        struct VolatileConstantBufferState
+        {
+            Buffer* buffer = nullptr;
+            D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0; // 0 if the data hasn't been uploaded yet
+            uint32_t version = 0; // incremented on every write
+            uint32_t inlineDataSize = 0; // 0 if the data is too large for inline constants
+            std::array<uint32_t, c_MaxInlineVolatileConstantBufferSize / 4> inlineData{};
+        };
+
+        // Maps Buffer::trackerIndex to the position in m_VolatileConstantBuffers, slots with a generation
+        // other than the current one are stale
+        struct VolatileConstantBufferSlot
+        {
+            uint32_t generation = 0;
+            uint32_t index = 0;
+        };
+
+        VolatileConstantBufferState* getVolatileConstantBufferState(Buffer* buffer, bool allowCreate);
+        D3D12_GPU_VIRTUAL_ADDRESS getVolatileConstantBufferGpuVA(VolatileConstantBufferState& state);
+        void clearVolatileConstantBufferStates();
+        void releaseReusableRecording();
+        bool setRootVolatileConstantBuffer(bool isGraphics, uint32_t rootParameterIndex, uint32_t numInlineConstants, VolatileConstantBufferState& state);
         
         IDevice* m_Device;
         Queue* m_Queue;
@@ -1079,8 +1605,10 @@ namespace nvrhi::d3d12
 
         std::shared_ptr<InternalCommandList> m_ActiveCommandList;
         std::list<std::shared_ptr<InternalCommandList>> m_CommandListPool;
+        std::vector<SyncSegment> m_SyncSegments;
         std::shared_ptr<CommandListInstance> m_Instance;
         uint64_t m_RecordingVersion = 0;
+        uint64_t m_ReusableSubmittedVersion = 0; // last execution of the current recording of a reusable command list
 #if NVRHI_WITH_AFTERMATH
         AftermathMarkerTracker m_AftermathTracker;
 #endif
@@ -1092,6 +1620,7 @@ namespace nvrhi::d3d12
         MeshletState m_CurrentMeshletState;
         rt::State m_CurrentRayTracingState;
         bool m_CurrentGraphicsStateValid = false;
+        PendingGraphicsState m_PendingGraphicsState;
         bool m_CurrentComputeStateValid = false;
         bool m_CurrentMeshletStateValid = false;
         bool m_CurrentRayTracingStateValid = false;
@@ -1102,12 +1631,60 @@ namespace nvrhi::d3d12
         ID3D12DescriptorHeap* m_CurrentHeapSRVetc = nullptr;
         ID3D12DescriptorHeap* m_CurrentHeapSamplers = nullptr;
         ID3D12Resource* m_CurrentUploadBuffer = nullptr;
+
+        // Intermediate buffer for copies between buffers packed into the same shared resource, created on first use
+        BufferHandle m_PackedCopyBuffer;
+
+        // Subresources between beginTextureWrite and endTextureWrite
+        struct PendingTextureWrite
+        {
+            RefCountPtr<Texture> dest;
+            uint32_t subresource = 0;
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+            uint32_t numRows = 0;
+            uint64_t rowSizeInBytes = 0;
+            ID3D12Resource* uploadBuffer = nullptr;
+            void* cpuVA = nullptr;
+        };
+        std::vector<PendingTextureWrite> m_PendingTextureWrites;
+
+        // Used locally in writeTextureSubresources, members to avoid re-allocations
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> m_SubresourceFootprints;
+        std::vector<UINT> m_SubresourceNumRows;
+        std::vector<UINT64> m_SubresourceRowSizes;
+#if NVRHI_D3D12_WITH_COOPVEC
+        std::vector<D3D12_LINEAR_ALGEBRA_MATRIX_CONVERSION_INFO> m_CoopVecConvertInfos; // used locally in convertCoopVecMatrices
+#endif
         SinglePassStereoState m_CurrentSinglePassStereoState;
+        bool m_PredicationEnabled = false;
+        bool m_PredicationBufferInPredicationState = false; // otherwise, in the COMMON or COPY_DEST state
+
+        // Framebuffer last rendered to since open(), the attachment load ops apply when a different one is used
+        Framebuffer* m_LastRenderPassFramebuffer = nullptr; // referenced by m_Instance
+
+        // Framebuffer of the active render pass in the render pass mode, see DeviceDesc::enableRenderPasses
+        Framebuffer* m_RenderPassFramebuffer = nullptr;
+        bool m_RenderPassAllowsUavWrites = false;
         
-        std::unordered_map<IBuffer*, D3D12_GPU_VIRTUAL_ADDRESS> m_VolatileConstantBufferAddresses;
+        std::vector<VolatileConstantBufferState> m_VolatileConstantBuffers;
+        std::vector<VolatileConstantBufferSlot> m_VolatileConstantBufferSlots;
+        uint32_t m_VolatileConstantBufferGeneration = 1;
         bool m_AnyVolatileBufferWrites = false;
 
+        // Bundle recording state, see CommandListParameters::isBundle.
+        // Bundles inherit the render targets and viewports from the calling command list, so their graphics states
+        // only record the framebuffer and viewports here, and executeBundles sets them on the caller.
+        BundleStateRequirements m_BundleStateRequirements;
+        Framebuffer* m_BundleFramebuffer = nullptr; // referenced by m_Instance
+        DX12_ViewportState m_BundleViewportState;
+        ID3D12DescriptorHeap* m_BundleHeapSRVetc = nullptr;
+        ID3D12DescriptorHeap* m_BundleHeapSamplers = nullptr;
+
         std::vector<D3D12_RESOURCE_BARRIER> m_D3DBarriers; // Used locally in commitBarriers, member to avoid re-allocations
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        std::vector<D3D12_TEXTURE_BARRIER> m_D3DTextureBarriers; // Same for the enhanced barriers
+        std::vector<D3D12_BUFFER_BARRIER> m_D3DBufferBarriers;
+#endif
 
         // Bound volatile buffer state. Saves currently bound volatile buffers and their current GPU VAs.
         // Necessary to patch the bound VAs when a buffer is updated between setGraphicsState and draw, or between draws.
@@ -1117,19 +1694,100 @@ namespace nvrhi::d3d12
 
         std::unordered_map<rt::IShaderTable*, std::unique_ptr<ShaderTableState>> m_UncachedShaderTableStates;
         ShaderTableState& getShaderTableState(rt::IShaderTable* shaderTable);
+        bool updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state);
+
+        // Linear allocators for transient binding sets, suballocating from chunks owned by m_Instance
+
+        struct TransientDescriptorRing
+        {
+            DescriptorIndex baseIndex = c_InvalidDescriptorIndex;
+            uint32_t capacity = 0;
+            uint32_t used = 0;
+        };
+
+        TransientDescriptorRing m_TransientSRVetcRing;
+        TransientDescriptorRing m_TransientSamplerRing;
+
+        std::shared_ptr<TransientBindingSetPool> m_TransientBindingSetPool = std::make_shared<TransientBindingSetPool>();
+        std::vector<RefCountPtr<BindingSet>> m_FreeTransientBindingSets; // taken from m_TransientBindingSetPool
+
+        DescriptorIndex allocateTransientDescriptors(StaticDescriptorHeap& heap, TransientDescriptorRing& ring, uint32_t count, uint32_t chunkSize);
         
         void clearStateCache();
 
+        void commitBarriersInternal();
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        void commitBarriersInternal_enhanced();
+#endif
+
         void bindGraphicsPipeline(GraphicsPipeline* pso, bool updateRootSignature) const;
         void bindMeshletPipeline(MeshletPipeline* pso, bool updateRootSignature) const;
         void bindFramebuffer(Framebuffer* fb);
+        void applyAttachmentLoadOps(Framebuffer* fb);
+        void beginRendering(Framebuffer* fb, bool allowUavWrites);
+        void beginRenderPass(Framebuffer* fb, bool allowUavWrites);
+        void endRenderPass();
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer);
+        void bindVertexBuffers(const GraphicsPipeline* pso, const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers);
+        void setViewports(const GraphicsPipeline* pso, const Framebuffer* fb, const ViewportState& viewport);
+        void commitGraphicsStateChanges();
         void unbindShadingRateState();
         
         std::shared_ptr<InternalCommandList> createInternalCommandList() const;
+        std::shared_ptr<InternalCommandList> acquireInternalCommandList();
+        void splitCommandList(SyncPoint* signalAfter, SyncPoint* waitAfter);
 
         void buildTopLevelAccelStructInternal(AccelStruct* as, D3D12_GPU_VIRTUAL_ADDRESS instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags);
     };
 
+    // FNV-1a hash used for the keys that are persisted across runs, where std::hash gives no guarantees
+    class StableHasher
+    {
+    public:
+        void addBytes(const void* data, size_t size);
+        template<typename T> void add(const T& value) { addBytes(&value, sizeof(value)); }
+        void addShader(const D3D12_SHADER_BYTECODE& bytecode);
+        void addBlendDesc(const D3D12_BLEND_DESC& desc);
+        void addDepthStencilDesc(const D3D12_DEPTH_STENCIL_DESC& desc);
+        void addRasterizerDesc(const D3D12_RASTERIZER_DESC& desc);
+        [[nodiscard]] uint64_t get() const { return m_Hash; }
+
+    private:
+        uint64_t m_Hash = 0xcbf29ce484222325ull;
+    };
+
+    // Stores pipeline state objects in an ID3D12PipelineLibrary1, see DeviceDesc::enablePipelineLibrary.
+    // Entries are named after a stable hash of the translated PSO description and the serialized root signature.
+    class PipelineLibrary
+    {
+    public:
+        explicit PipelineLibrary(const Context& context)
+            : m_Context(context)
+        { }
+
+        bool initialize(const void* initialData, size_t initialDataSize);
+
+        // Return null if the library has no matching entry
+        RefCountPtr<ID3D12PipelineState> loadGraphicsPipeline(uint64_t key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+        RefCountPtr<ID3D12PipelineState> loadComputePipeline(uint64_t key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+        RefCountPtr<ID3D12PipelineState> loadPipeline(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+
+        void storePipeline(uint64_t key, ID3D12PipelineState* pipelineState);
+        bool serialize(std::vector<uint8_t>& outData);
+
+    private:
+        const Context& m_Context;
+        RefCountPtr<ID3D12PipelineLibrary1> m_Library;
+
+        // The library references the blob it was created from instead of copying it
+        std::vector<uint8_t> m_InitialData;
+
+        // Loading the same entry from several threads at once is not safe, and creation is rare enough to serialize
+        std::mutex m_Mutex;
+
+        static std::wstring getEntryName(uint64_t key);
+    };
+
     class Device final : public RefCounter<IDevice>
     {
     public:
@@ -1156,12 +1814,14 @@ namespace nvrhi::d3d12
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags) override;
         void unmapBuffer(IBuffer* b) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
@@ -1186,6 +1846,17 @@ namespace nvrhi::d3d12
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimerQueryPoolHandle createTimerQueryPool(const TimerQueryPoolDesc& desc) override;
+        bool getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries) override;
+        bool getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries) override;
+        OcclusionQueryHandle createOcclusionQuery(OcclusionQueryType type) override;
+        bool pollOcclusionQuery(IOcclusionQuery* query) override;
+        uint64_t getOcclusionQueryResult(IOcclusionQuery* query) override;
+        void resetOcclusionQuery(IOcclusionQuery* query) override;
+        PipelineStatisticsQueryHandle createPipelineStatisticsQuery() override;
+        bool pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        PipelineStatistics getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query) override;
+        void resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -1202,6 +1873,11 @@ namespace nvrhi::d3d12
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        AsyncGraphicsPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback = nullptr) override;
+        AsyncComputePipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback = nullptr) override;
+        AsyncMeshletPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback = nullptr) override;
+        rt::AsyncPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback = nullptr) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -1211,6 +1887,7 @@ namespace nvrhi::d3d12
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems) override;
 
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
@@ -1222,13 +1899,20 @@ namespace nvrhi::d3d12
         nvrhi::CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        StorageQueueHandle createStorageQueue(const StorageQueueDesc& desc) override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        bool getVideoMemoryBudget(VideoMemoryBudget& outBudget) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void setResidencyPriority(IResource* resource, ResidencyPriority priority) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        void getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& outData) override;
+        bool mergePipelineCacheData(const void* data, size_t size) override;
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
@@ -1239,9 +1923,11 @@ namespace nvrhi::d3d12
         GraphicsPipelineHandle createHandleForNativeGraphicsPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const GraphicsPipelineDesc& desc, const FramebufferInfo& framebufferInfo) override;
         MeshletPipelineHandle createHandleForNativeMeshletPipeline(IRootSignature* rootSignature, ID3D12PipelineState* pipelineState, const MeshletPipelineDesc& desc, const FramebufferInfo& framebufferInfo) override;
         IDescriptorHeap* getDescriptorHeap(DescriptorHeapType heapType) override;
+        PlacedResourceStatistics getPlacedResourceStatistics() override;
 
         // Internal interface
         Queue* getQueue(CommandQueue type) { return m_Queues[int(type)].get(); }
+        D3DTextureBlitter& getTextureBlitter() { return *m_TextureBlitter; }
 
         Context& getContext() { return m_Context; }
 
@@ -1263,6 +1949,15 @@ namespace nvrhi::d3d12
         std::mutex m_Mutex;
 
         std::vector<ID3D12CommandList*> m_CommandListsToExecute; // used locally in executeCommandLists, member to avoid re-allocations
+
+        // Video memory budget queries and residency management, see DeviceDesc::enableResidencyManagement
+        RefCountPtr<IDXGIAdapter3> m_Adapter;
+        IMemoryBudgetCallback* m_BudgetCallback = nullptr;
+        std::vector<uint64_t> m_ResidencyKeys;
+        std::vector<uint64_t> m_ResidencyChanges;
+        std::vector<ID3D12Pageable*> m_ResidencyPageables;
+
+        std::unique_ptr<PipelineLibrary> m_PipelineLibrary;
         
         bool m_NvapiIsInitialized = false;
         bool m_SinglePassStereoSupported = false;
@@ -1282,8 +1977,15 @@ namespace nvrhi::d3d12
         bool m_HeapDirectlyIndexedEnabled = false;
         bool m_CoopVecInferencingSupported = false;
         bool m_CoopVecTrainingSupported = false;
+        CoopVecMatrixSizeCache m_CoopVecMatrixSizes;
         AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
+        PipelineCompiler m_PipelineCompiler;
+        std::unique_ptr<ObjectDeduplicationCaches> m_Deduplication;
+        std::unique_ptr<ShaderPermutationCache> m_ShaderPermutations;
 
+        DeferredDestructionQueue m_DeferredDestruction;
+        DeferredDestructionFlags m_DeferredDestructionFlags = DeferredDestructionFlags::None;
+        std::unique_ptr<D3DTextureBlitter> m_TextureBlitter;
 
         D3D12_FEATURE_DATA_D3D12_OPTIONS  m_Options = {};
         D3D12_FEATURE_DATA_D3D12_OPTIONS1 m_Options1 = {};
@@ -1291,7 +1993,28 @@ namespace nvrhi::d3d12
         D3D12_FEATURE_DATA_D3D12_OPTIONS6 m_Options6 = {};
         D3D12_FEATURE_DATA_D3D12_OPTIONS7 m_Options7 = {};
 
+        // State handoff mode, only active after the first command list with enableStateHandoff is created.
+        // Declared last so that the internal command lists are destroyed before the other members.
+        std::unique_ptr<StateHandoffResolver> m_StateHandoffResolver;
+        std::atomic<bool> m_StateHandoffUsed = false;
+        std::array<std::vector<CommandListHandle>, (int)CommandQueue::Count> m_StateHandoffCommandLists;
+        std::vector<nvrhi::ICommandList*> m_StateHandoffSubmission;
+
+        void resolveStateHandoff(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue);
+
+        // Makes the allocations used by the command lists resident before they are submitted
+        void makeReferencedResourcesResident(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists);
+        // Evicts unused allocations and calls the budget callback when over the budget, from runGarbageCollection
+        void updateResidency();
+
         RefCountPtr<RootSignature> getRootSignature(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& pipelineLayouts, bool allowInputLayout);
+
+        // Creates the descriptor of a descriptor table item in the CPU-only heap, without copying it to the shader-visible heap
+        bool createDescriptorTableItem(DescriptorTable* descriptorTable, const BindingSetItem& binding);
+        // Creates the buffers used for native BLAS compaction on first use, returns false if they couldn't be created
+        bool createCompactedSizeBuffers();
+        // Queries the driver for the size of a matrix, bypassing m_CoopVecMatrixSizes
+        size_t queryCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, uint32_t rows, uint32_t columns) const;
         RefCountPtr<ID3D12PipelineState> createPipelineState(const GraphicsPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
         RefCountPtr<ID3D12PipelineState> createPipelineState(const ComputePipelineDesc& desc, RootSignature* pRS) const;
         RefCountPtr<ID3D12PipelineState> createPipelineState(const MeshletPipelineDesc& desc, RootSignature* pRS, const FramebufferInfo& fbinfo) const;
@@ -57,6 +57,27 @@ namespace nvrhi::d3d12
             m_Resources.shaderResourceViewHeap.releaseDescriptor(m_ClearUAV);
             m_ClearUAV = c_InvalidDescriptorIndex;
         }
+
+        if (packedAllocation.isValid())
+        {
+            // The block is still referenced by packedBlock, so nothing else needs to happen to the resource
+            resource = nullptr;
+            m_Resources.smallBuffers.release(packedAllocation);
+        }
+        else if (resource)
+        {
+            m_Resources.residency.removeAllocation(getResidencyKey(resource));
+            m_Resources.residency.removeAlias(getResidencyKey(resource));
+        }
+
+        if (placedAllocation.isValid())
+        {
+            resource = nullptr;
+            m_Resources.placedResources.release(placedAllocation);
+        }
+
+        if (trackedMemorySize)
+            m_Context.memoryStatistics->released(MemoryCategory::Buffers, trackedMemorySize);
     }
 
     BufferHandle Device::createBuffer(const BufferDesc& d)
@@ -68,6 +89,9 @@ namespace nvrhi::d3d12
         }
 
         Buffer* buffer = new Buffer(m_Context, m_Resources, desc);
+
+        if ((m_DeferredDestructionFlags & DeferredDestructionFlags::Buffers) != 0)
+            buffer->setDestructionQueue(&m_DeferredDestruction);
         
         if (d.isVolatile)
         {
@@ -94,6 +118,20 @@ namespace nvrhi::d3d12
             return BufferHandle::Create(buffer);
         }
 
+        if (m_Resources.smallBuffers.isEnabled())
+        {
+            Buffer* blockBuffer = nullptr;
+            if (m_Resources.smallBuffers.allocate(buffer->desc, buffer->packedAllocation, blockBuffer, buffer->resourceOffset))
+            {
+                // The block holds the memory and the residency entry, and is counted in the memory statistics
+                buffer->packedBlock = blockBuffer;
+                buffer->resource = blockBuffer->resource;
+                buffer->postCreate();
+
+                return BufferHandle::Create(buffer);
+            }
+        }
+
         D3D12_HEAP_PROPERTIES heapProps = {};
         D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_NONE;
         D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON;
@@ -138,24 +176,80 @@ namespace nvrhi::d3d12
             initialState = D3D12_RESOURCE_STATE_COMMON;
         }
 
-        HRESULT res = m_Context.device->CreateCommittedResource(
-            &heapProps,
-            heapFlags,
-            &resourceDesc,
-            initialState,
-            nullptr,
-            IID_PPV_ARGS(&buffer->resource));
+        ID3D12Heap* placedHeap = nullptr;
+        uint64_t placedOffset = 0;
+        D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+
+        if (!d.isTiled && !isShared && heapProps.Type != D3D12_HEAP_TYPE_CUSTOM &&
+            m_Resources.placedResources.canPlaceResource(resourceDesc, allocationInfo))
+        {
+            m_Resources.placedResources.allocate(heapProps.Type, false, allocationInfo, buffer->placedAllocation, &placedHeap, &placedOffset);
+        }
+
+        HRESULT res;
+        if (d.isTiled)
+        {
+            res = m_Context.device->CreateReservedResource(
+                &resourceDesc,
+                initialState,
+                nullptr,
+                IID_PPV_ARGS(&buffer->resource));
+        }
+        else if (buffer->placedAllocation.isValid())
+        {
+            res = m_Context.device->CreatePlacedResource(
+                placedHeap, placedOffset,
+                &resourceDesc,
+                initialState,
+                nullptr,
+                IID_PPV_ARGS(&buffer->resource));
+        }
+        else
+        {
+            res = m_Context.device->CreateCommittedResource(
+                &heapProps,
+                heapFlags,
+                &resourceDesc,
+                initialState,
+                nullptr,
+                IID_PPV_ARGS(&buffer->resource));
+        }
 
         if (FAILED(res))
         {
             std::stringstream ss;
-            ss << "CreateCommittedResource call failed for buffer " << utils::DebugNameToString(d.debugName)
+            ss << (d.isTiled ? "CreateReservedResource" : buffer->placedAllocation.isValid() ? "CreatePlacedResource" : "CreateCommittedResource")
+                << " call failed for buffer " << utils::DebugNameToString(d.debugName)
                 << ", HRESULT = 0x" << std::hex << std::setw(8) << res;
             m_Context.error(ss.str());
 
             delete buffer;
             return nullptr;
         }
+
+        // Tiled buffers are not tracked, the heaps mapped into them are kept resident instead
+        if (m_Resources.residency.isEnabled() && !d.isTiled)
+        {
+            // Acceleration structures are used through the TLAS'es that reference them, so they are never evicted,
+            // and neither are the heaps they are placed in
+            if (d.isAccelStructStorage)
+            {
+                if (buffer->placedAllocation.isValid())
+                    m_Resources.residency.setPriority(getResidencyKey(placedHeap), ResidencyPriority::Maximum);
+            }
+            else if (buffer->placedAllocation.isValid())
+                m_Resources.residency.addAlias(getResidencyKey(buffer->resource), getResidencyKey(placedHeap));
+            else if (heapProps.Type == D3D12_HEAP_TYPE_DEFAULT)
+                m_Resources.residency.addAllocation(getResidencyKey(buffer->resource),
+                    m_Context.device->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes);
+        }
+
+        // Tiled buffers have no memory of their own
+        if (!d.isTiled)
+        {
+            buffer->trackedMemorySize = m_Context.device->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+            m_Context.memoryStatistics->allocated(MemoryCategory::Buffers, buffer->trackedMemorySize, d.debugName.c_str());
+        }
         
         if (isShared)
         {
@@ -186,9 +280,10 @@ namespace nvrhi::d3d12
 
     void Buffer::postCreate()
     {
-        gpuVA = resource->GetGPUVirtualAddress();
+        gpuVA = resource->GetGPUVirtualAddress() + resourceOffset;
 
-        if (!desc.debugName.empty())
+        // Packed buffers share the resource and the name of their block
+        if (!desc.debugName.empty() && !packedBlock)
         {
             std::wstring wname(desc.debugName.begin(), desc.debugName.end());
             resource->SetName(wname.c_str());
@@ -250,10 +345,16 @@ namespace nvrhi::d3d12
     }
 
     void *Device::mapBuffer(IBuffer* _b, CpuAccessMode flags)
+    {
+        return mapBuffer(_b, flags, MapBufferFlags::None);
+    }
+
+    void *Device::mapBuffer(IBuffer* _b, CpuAccessMode flags, MapBufferFlags mapFlags)
     {
         Buffer* b = checked_cast<Buffer*>(_b);
 
-        if (b->lastUseFence)
+        // With NoOverwrite, keep the fence so that a later blocking map still waits for the GPU
+        if (b->lastUseFence && (mapFlags & MapBufferFlags::NoOverwrite) == 0)
         {
             WaitForFence(b->lastUseFence, b->lastUseFenceValue, m_FenceEvent);
             b->lastUseFence = nullptr;
@@ -339,6 +440,11 @@ namespace nvrhi::d3d12
         buffer->heap = heap;
         buffer->postCreate();
 
+        if (buffer->desc.isAccelStructStorage)
+            m_Resources.residency.setPriority(getResidencyKey(heap->heap), ResidencyPriority::Maximum);
+        else
+            m_Resources.residency.addAlias(getResidencyKey(buffer->resource), getResidencyKey(heap->heap));
+
         return true;
     }
 
@@ -368,7 +474,7 @@ namespace nvrhi::d3d12
         assert(range.byteSize <= UINT_MAX);
 
         D3D12_CONSTANT_BUFFER_VIEW_DESC viewDesc;
-        viewDesc.BufferLocation = resource->GetGPUVirtualAddress() + range.byteOffset;
+        viewDesc.BufferLocation = gpuVA + range.byteOffset;
         viewDesc.SizeInBytes = align((UINT)range.byteSize, c_ConstantBufferOffsetSizeAlignment);
         m_Context.device->CreateConstantBufferView(&viewDesc, { descriptor });
     }
@@ -403,14 +509,14 @@ namespace nvrhi::d3d12
         case ResourceType::StructuredBuffer_SRV:
             assert(desc.structStride != 0);
             viewDesc.Format = DXGI_FORMAT_UNKNOWN;
-            viewDesc.Buffer.FirstElement = range.byteOffset / desc.structStride;
+            viewDesc.Buffer.FirstElement = (resourceOffset + range.byteOffset) / desc.structStride;
             viewDesc.Buffer.NumElements = (UINT)(range.byteSize / desc.structStride);
             viewDesc.Buffer.StructureByteStride = desc.structStride;
             break;
 
         case ResourceType::RawBuffer_SRV:
             viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-            viewDesc.Buffer.FirstElement = range.byteOffset / 4;
+            viewDesc.Buffer.FirstElement = (resourceOffset + range.byteOffset) / 4;
             viewDesc.Buffer.NumElements = (UINT)(range.byteSize / 4);
             viewDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
             break;
@@ -421,8 +527,19 @@ namespace nvrhi::d3d12
             const DxgiFormatMapping& mapping = getDxgiFormatMapping(format);
             const FormatInfo& formatInfo = getFormatInfo(format);
 
+            // SmallBufferAllocator only packs buffers whose own format divides the slot offset
+            if (resourceOffset % formatInfo.bytesPerBlock != 0)
+            {
+                std::stringstream ss;
+                ss << "Cannot create a typed SRV with format " << formatInfo.name << " for buffer "
+                   << utils::DebugNameToString(desc.debugName) << " because it is packed into a shared resource "
+                   "at an offset that is not a multiple of the format size";
+                m_Context.error(ss.str());
+                return;
+            }
+
             viewDesc.Format = mapping.srvFormat;
-            viewDesc.Buffer.FirstElement = range.byteOffset / formatInfo.bytesPerBlock;
+            viewDesc.Buffer.FirstElement = (resourceOffset + range.byteOffset) / formatInfo.bytesPerBlock;
             viewDesc.Buffer.NumElements = (UINT)(range.byteSize / formatInfo.bytesPerBlock);
             break;
         }
@@ -463,14 +580,14 @@ namespace nvrhi::d3d12
         case ResourceType::StructuredBuffer_UAV:
             assert(desc.structStride != 0);
             viewDesc.Format = DXGI_FORMAT_UNKNOWN;
-            viewDesc.Buffer.FirstElement = range.byteOffset / desc.structStride;
+            viewDesc.Buffer.FirstElement = (resourceOffset + range.byteOffset) / desc.structStride;
             viewDesc.Buffer.NumElements = (UINT)(range.byteSize / desc.structStride);
             viewDesc.Buffer.StructureByteStride = desc.structStride;
             break;
 
         case ResourceType::RawBuffer_UAV:
             viewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-            viewDesc.Buffer.FirstElement = range.byteOffset / 4;
+            viewDesc.Buffer.FirstElement = (resourceOffset + range.byteOffset) / 4;
             viewDesc.Buffer.NumElements = (UINT)(range.byteSize / 4);
             viewDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_RAW;
             break;
@@ -482,7 +599,7 @@ namespace nvrhi::d3d12
             const FormatInfo& formatInfo = getFormatInfo(format);
 
             viewDesc.Format = mapping.srvFormat;
-            viewDesc.Buffer.FirstElement = range.byteOffset / formatInfo.bytesPerBlock;
+            viewDesc.Buffer.FirstElement = (resourceOffset + range.byteOffset) / formatInfo.bytesPerBlock;
             viewDesc.Buffer.NumElements = (UINT)(range.byteSize / formatInfo.bytesPerBlock);
             break;
         }
@@ -495,10 +612,91 @@ namespace nvrhi::d3d12
         m_Context.device->CreateUnorderedAccessView(resource, nullptr, &viewDesc, { descriptor });
     }
     
+    CommandList::VolatileConstantBufferState* CommandList::getVolatileConstantBufferState(Buffer* buffer, bool allowCreate)
+    {
+        if (buffer->trackerIndex < m_VolatileConstantBufferSlots.size())
+        {
+            const VolatileConstantBufferSlot& slot = m_VolatileConstantBufferSlots[buffer->trackerIndex];
+
+            if (slot.generation == m_VolatileConstantBufferGeneration && m_VolatileConstantBuffers[slot.index].buffer == buffer)
+                return &m_VolatileConstantBuffers[slot.index];
+        }
+
+        if (!allowCreate)
+            return nullptr;
+
+        if (buffer->trackerIndex >= m_VolatileConstantBufferSlots.size())
+            m_VolatileConstantBufferSlots.resize(size_t(buffer->trackerIndex) + 1);
+
+        VolatileConstantBufferSlot& slot = m_VolatileConstantBufferSlots[buffer->trackerIndex];
+        slot.generation = m_VolatileConstantBufferGeneration;
+        slot.index = uint32_t(m_VolatileConstantBuffers.size());
+
+        VolatileConstantBufferState& state = m_VolatileConstantBuffers.emplace_back();
+        state.buffer = buffer;
+        return &state;
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS CommandList::getVolatileConstantBufferGpuVA(VolatileConstantBufferState& state)
+    {
+        if (state.gpuVA != 0 || state.inlineDataSize == 0)
+            return state.gpuVA;
+
+        // The data was kept for inline constants, upload it now that it's needed in memory
+        void* cpuVA;
+        ID3D12Resource* uploadBuffer;
+        if (!m_UploadManager.suballocateBuffer(state.inlineDataSize, nullptr, &uploadBuffer, nullptr, &cpuVA, &state.gpuVA,
+            m_RecordingVersion, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return 0;
+        }
+
+        if (uploadBuffer != m_CurrentUploadBuffer)
+        {
+            m_Instance->referencedNativeResources.push_back(uploadBuffer);
+            m_CurrentUploadBuffer = uploadBuffer;
+        }
+
+        memcpy(cpuVA, state.inlineData.data(), state.inlineDataSize);
+
+        return state.gpuVA;
+    }
+
+    void CommandList::clearVolatileConstantBufferStates()
+    {
+        m_VolatileConstantBuffers.clear();
+
+        ++m_VolatileConstantBufferGeneration;
+        if (m_VolatileConstantBufferGeneration == 0)
+        {
+            // The generation counter wrapped around, old slots could look valid again
+            std::fill(m_VolatileConstantBufferSlots.begin(), m_VolatileConstantBufferSlots.end(), VolatileConstantBufferSlot());
+            m_VolatileConstantBufferGeneration = 1;
+        }
+    }
+
     void CommandList::writeBuffer(IBuffer* _b, const void * data, size_t dataSize, uint64_t destOffsetBytes)
     {
+        endRenderPass();
+
         Buffer* buffer = checked_cast<Buffer*>(_b);
 
+        if (buffer->desc.isVolatile && dataSize <= c_MaxInlineVolatileConstantBufferSize)
+        {
+            // Keep small volatile CB contents on the CPU: they are either set as inline root constants,
+            // or uploaded when the buffer is first bound as a root CBV
+            VolatileConstantBufferState& state = *getVolatileConstantBufferState(buffer, true);
+            state.inlineData.fill(0);
+            memcpy(state.inlineData.data(), data, dataSize);
+            state.inlineDataSize = uint32_t(dataSize);
+            state.gpuVA = 0;
+            ++state.version;
+
+            m_AnyVolatileBufferWrites = true;
+            return;
+        }
+
         void* cpuVA;
         D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
         ID3D12Resource* uploadBuffer;
@@ -520,7 +718,11 @@ namespace nvrhi::d3d12
 
         if (buffer->desc.isVolatile)
         {
-            m_VolatileConstantBufferAddresses[buffer] = gpuVA;
+            VolatileConstantBufferState& state = *getVolatileConstantBufferState(buffer, true);
+            state.gpuVA = gpuVA;
+            state.inlineDataSize = 0;
+            ++state.version;
+
             m_AnyVolatileBufferWrites = true;
         }
         else
@@ -534,12 +736,14 @@ namespace nvrhi::d3d12
 
             m_Instance->referencedResources.push_back(buffer);
 
-            m_ActiveCommandList->commandList->CopyBufferRegion(buffer->resource, destOffsetBytes, uploadBuffer, offsetInUploadBuffer, dataSize);
+            m_ActiveCommandList->commandList->CopyBufferRegion(buffer->resource, buffer->resourceOffset + destOffsetBytes, uploadBuffer, offsetInUploadBuffer, dataSize);
         }
     }
 
     void CommandList::clearBufferUInt(IBuffer* _b, uint32_t clearValue)
     {
+        endRenderPass();
+
         Buffer* b = checked_cast<Buffer*>(_b);
 
         if (!b->desc.canHaveUAVs)
@@ -574,9 +778,18 @@ namespace nvrhi::d3d12
 
     void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
     {
+        endRenderPass();
+
         Buffer* dest = checked_cast<Buffer*>(_dest);
         Buffer* src = checked_cast<Buffer*>(_src);
 
+        // Buffers packed into one resource cannot be in the copy source and copy destination states at once
+        if (src->packedBlock && src->packedBlock == dest->packedBlock)
+        {
+            copyPackedBuffer(dest, destOffsetBytes, src, srcOffsetBytes, dataSizeBytes);
+            return;
+        }
+
         if (m_EnableAutomaticBarriers)
         {
             requireBufferState(dest, ResourceStates::CopyDest);
@@ -595,7 +808,50 @@ namespace nvrhi::d3d12
         else
             m_Instance->referencedResources.push_back(dest);
 
-        m_ActiveCommandList->commandList->CopyBufferRegion(dest->resource, destOffsetBytes, src->resource, srcOffsetBytes, dataSizeBytes);
+        m_ActiveCommandList->commandList->CopyBufferRegion(dest->resource, dest->resourceOffset + destOffsetBytes,
+            src->resource, src->resourceOffset + srcOffsetBytes, dataSizeBytes);
+    }
+
+    void CommandList::copyPackedBuffer(Buffer* dest, uint64_t destOffsetBytes, Buffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        if (!m_PackedCopyBuffer)
+        {
+            // Larger than SmallBufferAllocator::c_MaxSlotSize, so it is never packed itself
+            BufferDesc copyBufferDesc;
+            copyBufferDesc.byteSize = SmallBufferAllocator::c_BlockSize;
+            copyBufferDesc.debugName = "PackedCopyBuffer";
+            copyBufferDesc.enableAutomaticStateTracking(ResourceStates::CopyDest);
+
+            m_PackedCopyBuffer = m_Device->createBuffer(copyBufferDesc);
+            if (!m_PackedCopyBuffer)
+            {
+                m_Context.error("Couldn't create the intermediate buffer for a copy between packed buffers");
+                return;
+            }
+        }
+
+        Buffer* intermediate = checked_cast<Buffer*>(m_PackedCopyBuffer.Get());
+        assert(dataSizeBytes <= intermediate->desc.byteSize);
+
+        // The transitions cannot be left to the application here because the block goes through both copy states
+        requireBufferState(intermediate, ResourceStates::CopyDest);
+        requireBufferState(src, ResourceStates::CopySource);
+        commitBarriers();
+
+        m_ActiveCommandList->commandList->CopyBufferRegion(intermediate->resource, 0,
+            src->resource, src->resourceOffset + srcOffsetBytes, dataSizeBytes);
+
+        requireBufferState(intermediate, ResourceStates::CopySource);
+        requireBufferState(dest, ResourceStates::CopyDest);
+        m_BindingStatesDirty = true;
+        commitBarriers();
+
+        m_ActiveCommandList->commandList->CopyBufferRegion(dest->resource, dest->resourceOffset + destOffsetBytes,
+            intermediate->resource, 0, dataSizeBytes);
+
+        m_Instance->referencedResources.push_back(src);
+        m_Instance->referencedResources.push_back(dest);
+        m_Instance->referencedResources.push_back(intermediate);
     }
 
 } // namespace nvrhi::d3d12
@@ -0,0 +1,255 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <iomanip>
+#include <sstream>
+
+namespace nvrhi::d3d12
+{
+    Object CommandSignature::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_CommandSignature:
+            return Object(signature.Get());
+        default:
+            return nullptr;
+        }
+    }
+
+    static RootParameterIndex findVolatileConstantBufferParameter(const RootSignature* rootSignature, uint32_t layoutIndex, uint32_t slot)
+    {
+        if (layoutIndex >= rootSignature->pipelineLayouts.size())
+            return c_InvalidRootParameterIndex;
+
+        const auto& [layoutHandle, rootParameterOffset] = rootSignature->pipelineLayouts[layoutIndex];
+        if (!layoutHandle->getDesc())
+            return c_InvalidRootParameterIndex;
+
+        const BindingLayout* layout = checked_cast<const BindingLayout*>(layoutHandle.Get());
+        for (const VolatileConstantBufferParameter& parameter : layout->rootParametersVolatileCB)
+        {
+            // CBs passed as inline root constants can't be replaced with a buffer address
+            if (parameter.descriptor.ShaderRegister == slot && parameter.numInlineConstants == 0)
+                return rootParameterOffset + parameter.rootParameterIndex;
+        }
+
+        return c_InvalidRootParameterIndex;
+    }
+
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        if (desc.arguments.empty())
+        {
+            m_Context.error("A command signature must have at least one argument");
+            return nullptr;
+        }
+
+        RefCountPtr<IResource> pipeline;
+        RootSignature* rootSignature = nullptr;
+        if (desc.graphicsPipeline)
+        {
+            pipeline = desc.graphicsPipeline;
+            rootSignature = checked_cast<GraphicsPipeline*>(desc.graphicsPipeline)->rootSignature;
+        }
+        else if (desc.computePipeline)
+        {
+            pipeline = desc.computePipeline;
+            rootSignature = checked_cast<ComputePipeline*>(desc.computePipeline)->rootSignature;
+        }
+        else if (desc.meshletPipeline)
+        {
+            pipeline = desc.meshletPipeline;
+            rootSignature = checked_cast<MeshletPipeline*>(desc.meshletPipeline)->rootSignature;
+        }
+
+        std::vector<D3D12_INDIRECT_ARGUMENT_DESC> argumentDescs;
+        argumentDescs.reserve(desc.arguments.size());
+
+        bool changesState = false;
+        bool changesRootArguments = false;
+
+        for (const IndirectArgumentDesc& argument : desc.arguments)
+        {
+            D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
+
+            switch (argument.type)
+            {
+            case IndirectArgumentType::Draw:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+                break;
+
+            case IndirectArgumentType::DrawIndexed:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+                break;
+
+            case IndirectArgumentType::Dispatch:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+                break;
+
+            case IndirectArgumentType::DispatchMesh:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+                break;
+
+            case IndirectArgumentType::PushConstants:
+                if (!rootSignature || rootSignature->rootParameterPushConstants == c_InvalidRootParameterIndex)
+                {
+                    m_Context.error("PushConstants indirect arguments require a pipeline with push constants in the command signature");
+                    return nullptr;
+                }
+
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+                argDesc.Constant.RootParameterIndex = rootSignature->rootParameterPushConstants;
+                argDesc.Constant.DestOffsetIn32BitValues = argument.pushConstantOffset;
+                argDesc.Constant.Num32BitValuesToSet = argument.pushConstantCount;
+                changesRootArguments = true;
+                break;
+
+            case IndirectArgumentType::VertexBuffer:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+                argDesc.VertexBuffer.Slot = argument.slot;
+                changesState = true;
+                break;
+
+            case IndirectArgumentType::IndexBuffer:
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+                changesState = true;
+                break;
+
+            case IndirectArgumentType::VolatileConstantBuffer: {
+                RootParameterIndex rootParameter = rootSignature
+                    ? findVolatileConstantBufferParameter(rootSignature, argument.layoutIndex, argument.slot)
+                    : c_InvalidRootParameterIndex;
+
+                if (rootParameter == c_InvalidRootParameterIndex)
+                {
+                    std::stringstream ss;
+                    ss << "The pipeline in the command signature has no volatile constant buffer at slot " << argument.slot
+                       << " of binding layout " << argument.layoutIndex << " that is not passed as inline constants";
+                    m_Context.error(ss.str());
+                    return nullptr;
+                }
+
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW;
+                argDesc.ConstantBufferView.RootParameterIndex = rootParameter;
+                changesRootArguments = true;
+                break;
+            }
+
+            default:
+                utils::InvalidEnum();
+                return nullptr;
+            }
+
+            argumentDescs.push_back(argDesc);
+        }
+
+        D3D12_COMMAND_SIGNATURE_DESC csDesc = {};
+        csDesc.ByteStride = desc.byteStride ? desc.byteStride : desc.getPackedByteSize();
+        csDesc.NumArgumentDescs = UINT(argumentDescs.size());
+        csDesc.pArgumentDescs = argumentDescs.data();
+
+        CommandSignatureHandle handle = CommandSignatureHandle::Create(new CommandSignature());
+        CommandSignature* signature = checked_cast<CommandSignature*>(handle.Get());
+        signature->desc = desc;
+        signature->pipeline = pipeline;
+        signature->action = desc.arguments.back().type;
+        signature->changesState = changesState || changesRootArguments;
+
+        // The root signature must only be provided when the arguments change root parameters
+        const HRESULT hr = m_Context.device->CreateCommandSignature(&csDesc,
+            changesRootArguments ? rootSignature->handle.Get() : nullptr, IID_PPV_ARGS(&signature->signature));
+
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "CreateCommandSignature call failed, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        return handle;
+    }
+
+    void CommandList::executeIndirect(ICommandSignature* _signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes)
+    {
+        CommandSignature* signature = checked_cast<CommandSignature*>(_signature);
+
+        IBuffer* indirectParams = nullptr;
+        IBuffer* indirectCount = nullptr;
+
+        switch (signature->action)
+        {
+        case IndirectArgumentType::Draw:
+        case IndirectArgumentType::DrawIndexed:
+            if (m_PendingGraphicsState.any())
+                commitGraphicsStateChanges();
+
+            updateGraphicsVolatileBuffers();
+
+            indirectParams = m_CurrentGraphicsState.indirectParams;
+            indirectCount = m_CurrentGraphicsState.indirectCountBuffer;
+            break;
+
+        case IndirectArgumentType::Dispatch:
+            updateComputeVolatileBuffers();
+
+            indirectParams = m_CurrentComputeState.indirectParams;
+            indirectCount = m_CurrentComputeState.indirectCountBuffer;
+            break;
+
+        case IndirectArgumentType::DispatchMesh:
+            updateGraphicsVolatileBuffers();
+
+            indirectParams = m_CurrentMeshletState.indirectParams;
+            indirectCount = m_CurrentMeshletState.indirectCountBuffer;
+            break;
+
+        default:
+            utils::InvalidEnum();
+            return;
+        }
+
+        assert(indirectParams); // validation layer handles this
+
+        ID3D12Resource* countResource = indirectCount ? checked_cast<Buffer*>(indirectCount)->resource.Get() : nullptr;
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(signature->signature, maxCommandCount,
+            checked_cast<Buffer*>(indirectParams)->resource, paramOffsetBytes,
+            countResource, countResource ? countOffsetBytes : 0);
+
+        m_Instance->referencedResources.push_back(signature);
+
+        if (signature->changesState)
+        {
+            // The arguments have overwritten some bindings, make the next set*State call bind everything again
+            m_CurrentGraphicsStateValid = false;
+            m_CurrentComputeStateValid = false;
+            m_CurrentMeshletStateValid = false;
+        }
+    }
+
+} // namespace nvrhi::d3d12
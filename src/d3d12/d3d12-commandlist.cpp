@@ -28,16 +28,39 @@
 
 namespace nvrhi::d3d12
 {
+    CommandListInstance::~CommandListInstance()
+    {
+        for (const TransientDescriptorChunk& chunk : transientDescriptorChunks)
+        {
+            chunk.heap->releaseDescriptors(chunk.baseIndex, chunk.count);
+        }
+
+        if (!transientBindingSets.empty())
+        {
+            for (const RefCountPtr<BindingSet>& bindingSet : transientBindingSets)
+            {
+                bindingSet->resetTransient();
+            }
+
+            std::lock_guard lockGuard(transientBindingSetPool->mutex);
+            transientBindingSetPool->freeSets.insert(transientBindingSetPool->freeSets.end(),
+                std::make_move_iterator(transientBindingSets.begin()), std::make_move_iterator(transientBindingSets.end()));
+        }
+    }
+
     CommandList::CommandList(Device* device, const Context& context, DeviceResources& resources, const CommandListParameters& params)
         : m_Context(context)
         , m_Resources(resources)
         , m_Device(device)
         , m_Queue(device->getQueue(params.queueType))
-        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false)
-        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true)
+        , m_UploadManager(context, m_Queue, params.uploadChunkSize, 0, false, params.uploadRingSize)
+        , m_DxrScratchManager(context, m_Queue, params.scratchChunkSize, params.scratchMaxMemory, true, 0)
         , m_StateTracker(context.messageCallback)
         , m_Desc(params)
     {
+        m_StateTracker.setEnableStateHandoff(params.enableStateHandoff);
+        m_StateTracker.setKeepStatesAfterSubmission(params.reusable);
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
@@ -46,6 +69,12 @@ namespace nvrhi::d3d12
 
     CommandList::~CommandList()
     {
+        if (m_Desc.reusable)
+            releaseReusableRecording();
+
+        // Let other command lists on the same queue reuse the allocators instead of creating new ones
+        m_Queue->recycleCommandLists(m_CommandListPool);
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
@@ -99,11 +128,18 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        if (m_Desc.isBundle)
+            d3dCommandListType = D3D12_COMMAND_LIST_TYPE_BUNDLE;
+
         m_Context.device->CreateCommandAllocator(d3dCommandListType, IID_PPV_ARGS(&commandList->allocator));
         m_Context.device->CreateCommandList(0, d3dCommandListType, commandList->allocator, nullptr, IID_PPV_ARGS(&commandList->commandList));
 
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList4));
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList6));
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        if (m_Context.enhancedBarriersEnabled && m_Desc.queueType != CommandQueue::Copy)
+            commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandList7));
+#endif
 #if NVRHI_D3D12_WITH_COOPVEC
         commandList->commandList->QueryInterface(IID_PPV_ARGS(&commandList->commandListPreview));
 #endif
@@ -159,7 +195,8 @@ namespace nvrhi::d3d12
 
         if (buffer->desc.isVolatile)
         {
-            return m_VolatileConstantBufferAddresses[buffer];
+            VolatileConstantBufferState* state = getVolatileConstantBufferState(buffer, false);
+            return state ? getVolatileConstantBufferGpuVA(*state) : 0;
         }
 
         return buffer->gpuVA;
@@ -170,6 +207,14 @@ namespace nvrhi::d3d12
         return m_Device;
     }
 
+    MemoryStatistics CommandList::getMemoryStatistics()
+    {
+        MemoryStatistics statistics;
+        m_UploadManager.getStatistics(statistics);
+        m_DxrScratchManager.getStatistics(statistics);
+        return statistics;
+    }
+
     void CommandList::beginMarker(const char* name)
     {
         PIXBeginEvent(m_ActiveCommandList->commandList, 0, name);
@@ -234,45 +279,168 @@ namespace nvrhi::d3d12
 
     void CommandList::open()
     {
-        uint64_t completedInstance = m_Queue->updateLastCompletedInstance();
-
-        std::shared_ptr<InternalCommandList> chunk;
-
-        if (!m_CommandListPool.empty())
+        if (m_Desc.isBundle)
         {
-            chunk = m_CommandListPool.front();
-
-            if (chunk->lastSubmittedInstance <= completedInstance)
+            // The previous recording may still be referenced by command lists that executed it. If it's not,
+            // reuse its allocator, otherwise start on new objects and leave the old ones to those command lists.
+            if (m_ActiveCommandList && m_Instance.use_count() == 1)
             {
-                chunk->allocator->Reset();
-                chunk->commandList->Reset(chunk->allocator, nullptr);
-                m_CommandListPool.pop_front();
+                m_ActiveCommandList->allocator->Reset();
+                m_ActiveCommandList->commandList->Reset(m_ActiveCommandList->allocator, nullptr);
             }
             else
             {
-                chunk = nullptr;
+                m_ActiveCommandList = createInternalCommandList();
             }
-        }
 
-        if (chunk == nullptr)
-        {
-            chunk = createInternalCommandList();
+            m_Instance = std::make_shared<CommandListInstance>();
+            m_Instance->commandAllocator = m_ActiveCommandList->allocator;
+            m_Instance->commandList = m_ActiveCommandList->commandList;
+            m_Instance->commandQueue = m_Desc.queueType;
+
+            m_BundleStateRequirements.clear();
+            m_BundleFramebuffer = nullptr;
+            m_BundleViewportState = DX12_ViewportState();
+            return;
         }
 
-        m_ActiveCommandList = chunk;
+        if (m_Desc.reusable)
+            releaseReusableRecording();
+
+        m_SyncSegments.clear(); // left over if the previous recording was not executed
+        m_ActiveCommandList = acquireInternalCommandList();
 
         m_Instance = std::make_shared<CommandListInstance>();
         m_Instance->commandAllocator = m_ActiveCommandList->allocator;
         m_Instance->commandList = m_ActiveCommandList->commandList;
         m_Instance->commandQueue = m_Desc.queueType;
 
+        m_TransientSRVetcRing = TransientDescriptorRing();
+        m_TransientSamplerRing = TransientDescriptorRing();
+
+        m_PredicationEnabled = false;
+        m_PredicationBufferInPredicationState = false;
+        m_LastRenderPassFramebuffer = nullptr;
+        m_RenderPassFramebuffer = nullptr;
+
         m_RecordingVersion = MakeVersion(m_Queue->recordingInstance++, m_Desc.queueType, false);
     }
 
+    void CommandList::releaseReusableRecording()
+    {
+        // The executions in flight keep the recording alive through their instances,
+        // and the pooled allocators are only reset after the last execution has finished
+        for (SyncSegment& segment : m_SyncSegments)
+        {
+            m_CommandListPool.push_back(segment.commandList);
+        }
+        m_SyncSegments.clear();
+
+        if (m_ActiveCommandList)
+        {
+            m_CommandListPool.push_back(m_ActiveCommandList);
+            m_ActiveCommandList.reset();
+        }
+        m_Instance.reset();
+
+        if (m_RecordingVersion)
+        {
+            // Unpin the upload and scratch memory. A recording that was never executed gets
+            // the submitted version 0, which is always complete.
+            uint64_t submittedVersion = m_ReusableSubmittedVersion
+                ? m_ReusableSubmittedVersion
+                : MakeVersion(0, m_Desc.queueType, true);
+            m_UploadManager.submitChunks(m_RecordingVersion, submittedVersion);
+            m_DxrScratchManager.submitChunks(m_RecordingVersion, submittedVersion);
+            m_RecordingVersion = 0;
+        }
+        m_ReusableSubmittedVersion = 0;
+
+        m_StateTracker.resetTrackedStates();
+    }
+
+    std::shared_ptr<InternalCommandList> CommandList::acquireInternalCommandList()
+    {
+        uint64_t completedInstance = m_Queue->updateLastCompletedInstance();
+
+        std::shared_ptr<InternalCommandList> chunk;
+
+        // The pool is owned by this command list, so reusing from it takes no locks.
+        // The oldest entry is at the front, if that one is still in flight, all of them are.
+        if (!m_CommandListPool.empty() && m_CommandListPool.front()->lastSubmittedInstance <= completedInstance)
+        {
+            chunk = m_CommandListPool.front();
+            m_CommandListPool.pop_front();
+        }
+        else
+        {
+            chunk = m_Queue->takeRecycledCommandList(completedInstance);
+        }
+
+        if (chunk)
+        {
+            chunk->allocator->Reset();
+            chunk->commandList->Reset(chunk->allocator, nullptr);
+        }
+        else
+        {
+            chunk = createInternalCommandList();
+        }
+
+        return chunk;
+    }
+
+    void CommandList::splitCommandList(SyncPoint* signalAfter, SyncPoint* waitAfter)
+    {
+        endRenderPass();
+
+        commitBarriers();
+
+        m_ActiveCommandList->commandList->Close();
+
+        // the instance keeps the finished part alive until it's executed, like the active one
+        m_Instance->referencedNativeResources.push_back(m_ActiveCommandList->allocator);
+        m_Instance->referencedNativeResources.push_back(m_ActiveCommandList->commandList);
+
+        SyncSegment& segment = m_SyncSegments.emplace_back();
+        segment.commandList = m_ActiveCommandList;
+        segment.signalAfter = signalAfter;
+        segment.waitAfter = waitAfter;
+
+        m_ActiveCommandList = acquireInternalCommandList();
+        m_Instance->commandAllocator = m_ActiveCommandList->allocator;
+        m_Instance->commandList = m_ActiveCommandList->commandList;
+
+        // nothing is bound in the new command list
+        clearStateCache();
+        commitDescriptorHeaps();
+    }
+
+    SyncPointHandle CommandList::signalSyncPoint()
+    {
+        SyncPoint* syncPoint = new SyncPoint();
+        syncPoint->queue = m_Desc.queueType;
+        syncPoint->fence = m_Queue->fence;
+
+        splitCommandList(syncPoint, nullptr);
+
+        return SyncPointHandle::Create(syncPoint);
+    }
+
+    void CommandList::waitSyncPoint(ISyncPoint* _syncPoint, PipelineStages waitStages)
+    {
+        (void)waitStages; // ID3D12CommandQueue::Wait blocks the whole queue
+
+        SyncPoint* syncPoint = checked_cast<SyncPoint*>(_syncPoint);
+
+        splitCommandList(nullptr, syncPoint);
+    }
+
     void CommandList::clearStateCache()
     {
         m_AnyVolatileBufferWrites = false;
         m_CurrentGraphicsStateValid = false;
+        m_PendingGraphicsState.reset();
         m_CurrentComputeStateValid = false;
         m_CurrentMeshletStateValid = false;
         m_CurrentRayTracingStateValid = false;
@@ -285,6 +453,8 @@ namespace nvrhi::d3d12
 
     void CommandList::clearState()
     {
+        endRenderPass();
+
         m_ActiveCommandList->commandList->ClearState(nullptr);
 
 #if NVRHI_D3D12_WITH_NVAPI
@@ -307,6 +477,24 @@ namespace nvrhi::d3d12
 
     void CommandList::close()
     {
+        endRenderPass();
+
+        if (m_Desc.isBundle)
+        {
+            m_ActiveCommandList->commandList->Close();
+
+            m_BundleHeapSRVetc = m_CurrentHeapSRVetc;
+            m_BundleHeapSamplers = m_CurrentHeapSamplers;
+
+            // Keep m_ActiveCommandList and m_Instance for executeBundles
+            clearStateCache();
+            return;
+        }
+
+        if (m_PredicationEnabled)
+            setPredication(nullptr, PredicationOp::SkipIfZero);
+
+        m_StateTracker.endSplitTransitions();
         m_StateTracker.keepBufferInitialStates();
         m_StateTracker.keepTextureInitialStates();
         commitBarriers();
@@ -323,7 +511,8 @@ namespace nvrhi::d3d12
         clearStateCache();
 
         m_CurrentUploadBuffer = nullptr;
-        m_VolatileConstantBufferAddresses.clear();
+        m_PendingTextureWrites.clear();
+        clearVolatileConstantBufferStates();
         m_UncachedShaderTableStates.clear();
     }
 
@@ -332,11 +521,27 @@ namespace nvrhi::d3d12
         std::shared_ptr<CommandListInstance> instance = m_Instance;
         instance->fence = pQueue->fence;
         instance->submittedInstance = pQueue->lastSubmittedInstance;
-        m_Instance.reset();
 
+        for (SyncSegment& segment : m_SyncSegments)
+        {
+            segment.commandList->lastSubmittedInstance = pQueue->lastSubmittedInstance;
+        }
         m_ActiveCommandList->lastSubmittedInstance = pQueue->lastSubmittedInstance;
-        m_CommandListPool.push_back(m_ActiveCommandList);
-        m_ActiveCommandList.reset();
+
+        // A reusable command list keeps its recording for the next executions, see releaseReusableRecording
+        if (!m_Desc.reusable)
+        {
+            m_Instance.reset();
+
+            for (SyncSegment& segment : m_SyncSegments)
+            {
+                m_CommandListPool.push_back(segment.commandList);
+            }
+            m_SyncSegments.clear();
+
+            m_CommandListPool.push_back(m_ActiveCommandList);
+            m_ActiveCommandList.reset();
+        }
 
         for (const auto& it : instance->referencedStagingTextures)
         {
@@ -358,8 +563,61 @@ namespace nvrhi::d3d12
             it->fenceCounter = instance->submittedInstance;
         }
 
+        for (const auto& it : instance->referencedOcclusionQueries)
+        {
+            it->started = true;
+            it->resolved = false;
+            it->fence = pQueue->fence;
+            it->fenceCounter = instance->submittedInstance;
+        }
+
+        for (const auto& it : instance->referencedPipelineStatisticsQueries)
+        {
+            it->started = true;
+            it->resolved = false;
+            it->fence = pQueue->fence;
+            it->fenceCounter = instance->submittedInstance;
+        }
+
+        for (const auto& [pool, frameIndex] : instance->resolvedTimerQueryFrames)
+        {
+            std::lock_guard lockGuard(pool->mutex);
+
+            // the frame may have been restarted already if the results were not needed
+            TimerQueryPool::Frame& frame = pool->getFrame(frameIndex);
+            if (frame.frameIndex == frameIndex)
+            {
+                frame.fence = pQueue->fence;
+                frame.fenceCounter = instance->submittedInstance;
+            }
+        }
+
         m_StateTracker.commandListSubmitted();
 
+        if (m_Desc.reusable)
+        {
+            // The upload memory stays pinned until the list is opened again. Each execution is tracked by the queue
+            // as a separate instance that references the recording, so that the queue can retire them in order.
+            m_ReusableSubmittedVersion = MakeVersion(instance->submittedInstance, m_Desc.queueType, true);
+
+            std::shared_ptr<CommandListInstance> execution = std::make_shared<CommandListInstance>();
+            execution->fence = instance->fence;
+            execution->submittedInstance = instance->submittedInstance;
+            execution->commandQueue = instance->commandQueue;
+            execution->accelStructsToCompact = std::move(instance->accelStructsToCompact);
+            execution->ommsToCompact = std::move(instance->ommsToCompact);
+            instance->accelStructsToCompact.clear();
+            instance->ommsToCompact.clear();
+#ifdef NVRHI_WITH_RTXMU
+            execution->rtxmuBuildIds = std::move(instance->rtxmuBuildIds);
+            execution->rtxmuCompactionIds = std::move(instance->rtxmuCompactionIds);
+            instance->rtxmuBuildIds.clear();
+            instance->rtxmuCompactionIds.clear();
+#endif
+            execution->reusedInstance = instance;
+            return execution;
+        }
+
         uint64_t submittedVersion = MakeVersion(instance->submittedInstance, m_Desc.queueType, true);
         m_UploadManager.submitChunks(m_RecordingVersion, submittedVersion);
         m_DxrScratchManager.submitChunks(m_RecordingVersion, submittedVersion);
@@ -370,6 +628,8 @@ namespace nvrhi::d3d12
 
     void CommandList::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
     {
+        endRenderPass();
+
 #if NVRHI_D3D12_WITH_COOPVEC
         if (numDescs == 0)
             return;
@@ -377,7 +637,8 @@ namespace nvrhi::d3d12
         if (!m_ActiveCommandList->commandListPreview)
             return;
         
-        std::vector<D3D12_LINEAR_ALGEBRA_MATRIX_CONVERSION_INFO> d3dConvertDescs;
+        std::vector<D3D12_LINEAR_ALGEBRA_MATRIX_CONVERSION_INFO>& d3dConvertDescs = m_CoopVecConvertInfos;
+        d3dConvertDescs.clear();
         d3dConvertDescs.reserve(numDescs);
 
         for (size_t i = 0; i < numDescs; ++i)
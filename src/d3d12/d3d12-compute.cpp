@@ -67,6 +67,19 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        uint64_t libraryKey = 0;
+        if (m_PipelineLibrary)
+        {
+            StableHasher hasher;
+            hasher.add(pRS->serializedHash);
+            hasher.addShader(desc.CS);
+            libraryKey = hasher.get();
+
+            pipelineState = m_PipelineLibrary->loadComputePipeline(libraryKey, desc);
+            if (pipelineState)
+                return pipelineState;
+        }
+
         const HRESULT hr = m_Context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
 
         if (FAILED(hr))
@@ -75,11 +88,20 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        if (m_PipelineLibrary)
+            m_PipelineLibrary->storePipeline(libraryKey, pipelineState);
+
         return pipelineState;
     }
 
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        if (m_Deduplication)
+        {
+            if (ComputePipelineHandle existing = m_Deduplication->computePipelines.find(desc))
+                return existing;
+        }
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, false);
         RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS);
 
@@ -93,11 +115,18 @@ namespace nvrhi::d3d12
         pso->rootSignature = pRS;
         pso->pipelineState = pPSO;
 
-        return ComputePipelineHandle::Create(pso);
+        ComputePipelineHandle pipeline = ComputePipelineHandle::Create(pso);
+
+        if (m_Deduplication)
+            pipeline = m_Deduplication->computePipelines.insert(desc, pipeline);
+
+        return pipeline;
     }
 
     void CommandList::setComputeState(const ComputeState& state)
     {
+        endRenderPass();
+
         ComputePipeline* pso = checked_cast<ComputePipeline*>(state.pipeline);
 
         const bool updateRootSignature = !m_CurrentComputeStateValid || m_CurrentComputeState.pipeline == nullptr ||
@@ -130,6 +159,15 @@ namespace nvrhi::d3d12
 
         setComputeBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
 
+        if (state.indirectCountBuffer && (!m_CurrentComputeStateValid || m_CurrentComputeState.indirectCountBuffer != state.indirectCountBuffer))
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+            m_Instance->referencedResources.push_back(state.indirectCountBuffer);
+        }
+
         unbindShadingRateState();
         
         m_CurrentGraphicsStateValid = false;
@@ -150,13 +188,13 @@ namespace nvrhi::d3d12
 
         for (VolatileConstantBufferBinding& parameter : m_CurrentComputeVolatileCBs)
         {
-            const D3D12_GPU_VIRTUAL_ADDRESS currentGpuVA = m_VolatileConstantBufferAddresses[parameter.buffer];
+            VolatileConstantBufferState* state = getVolatileConstantBufferState(parameter.buffer, false);
 
-            if (currentGpuVA != parameter.address)
+            if (state && state->version != parameter.version)
             {
-                m_ActiveCommandList->commandList->SetComputeRootConstantBufferView(parameter.bindingPoint, currentGpuVA);
+                setRootVolatileConstantBuffer(false, parameter.bindingPoint, parameter.numInlineConstants, *state);
 
-                parameter.address = currentGpuVA;
+                parameter.version = state->version;
             }
         }
 
@@ -275,6 +275,197 @@ namespace nvrhi::d3d12
         return result;
     }
 
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+    struct BarrierStateMappingInternal
+    {
+        ResourceStates nvrhiState;
+        D3D12_BARRIER_SYNC sync;
+        D3D12_BARRIER_ACCESS access;
+        D3D12_BARRIER_LAYOUT layout;
+    };
+
+    // Indexed by the bit position of the state in ResourceStates
+    static const BarrierStateMappingInternal g_BarrierStateMap[] =
+    {
+        { ResourceStates::Common,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_COMMON,
+            D3D12_BARRIER_LAYOUT_COMMON },
+        { ResourceStates::ConstantBuffer,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_CONSTANT_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::VertexBuffer,
+            D3D12_BARRIER_SYNC_VERTEX_SHADING,
+            D3D12_BARRIER_ACCESS_VERTEX_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::IndexBuffer,
+            D3D12_BARRIER_SYNC_INDEX_INPUT,
+            D3D12_BARRIER_ACCESS_INDEX_BUFFER,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::IndirectArgument,
+            D3D12_BARRIER_SYNC_EXECUTE_INDIRECT,
+            D3D12_BARRIER_ACCESS_INDIRECT_ARGUMENT,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ShaderResource,
+            D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_SHADER_RESOURCE },
+        { ResourceStates::UnorderedAccess,
+            D3D12_BARRIER_SYNC_ALL_SHADING | D3D12_BARRIER_SYNC_CLEAR_UNORDERED_ACCESS_VIEW,
+            D3D12_BARRIER_ACCESS_UNORDERED_ACCESS,
+            D3D12_BARRIER_LAYOUT_UNORDERED_ACCESS },
+        { ResourceStates::RenderTarget,
+            D3D12_BARRIER_SYNC_RENDER_TARGET,
+            D3D12_BARRIER_ACCESS_RENDER_TARGET,
+            D3D12_BARRIER_LAYOUT_RENDER_TARGET },
+        { ResourceStates::DepthWrite,
+            D3D12_BARRIER_SYNC_DEPTH_STENCIL,
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE,
+            D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE },
+        { ResourceStates::DepthRead,
+            D3D12_BARRIER_SYNC_DEPTH_STENCIL,
+            D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ,
+            D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ },
+        { ResourceStates::StreamOut,
+            D3D12_BARRIER_SYNC_VERTEX_SHADING,
+            D3D12_BARRIER_ACCESS_STREAM_OUTPUT,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::CopyDest,
+            D3D12_BARRIER_SYNC_COPY,
+            D3D12_BARRIER_ACCESS_COPY_DEST,
+            D3D12_BARRIER_LAYOUT_COPY_DEST },
+        { ResourceStates::CopySource,
+            D3D12_BARRIER_SYNC_COPY,
+            D3D12_BARRIER_ACCESS_COPY_SOURCE,
+            D3D12_BARRIER_LAYOUT_COPY_SOURCE },
+        { ResourceStates::ResolveDest,
+            D3D12_BARRIER_SYNC_RESOLVE,
+            D3D12_BARRIER_ACCESS_RESOLVE_DEST,
+            D3D12_BARRIER_LAYOUT_RESOLVE_DEST },
+        { ResourceStates::ResolveSource,
+            D3D12_BARRIER_SYNC_RESOLVE,
+            D3D12_BARRIER_ACCESS_RESOLVE_SOURCE,
+            D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE },
+        { ResourceStates::Present,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_COMMON,
+            D3D12_BARRIER_LAYOUT_PRESENT },
+        { ResourceStates::AccelStructRead,
+            D3D12_BARRIER_SYNC_RAYTRACING | D3D12_BARRIER_SYNC_ALL_SHADING,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructWrite,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructBuildInput,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::AccelStructBuildBlas,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ShadingRateSurface,
+            D3D12_BARRIER_SYNC_PIXEL_SHADING,
+            D3D12_BARRIER_ACCESS_SHADING_RATE_SOURCE,
+            D3D12_BARRIER_LAYOUT_SHADING_RATE_SOURCE },
+        { ResourceStates::OpacityMicromapWrite,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::OpacityMicromapBuildInput,
+            D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ConvertCoopVecMatrixInput,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+        { ResourceStates::ConvertCoopVecMatrixOutput,
+            D3D12_BARRIER_SYNC_ALL,
+            D3D12_BARRIER_ACCESS_UNORDERED_ACCESS,
+            D3D12_BARRIER_LAYOUT_UNDEFINED },
+    };
+
+    static bool isReadOnlyTextureLayout(D3D12_BARRIER_LAYOUT layout)
+    {
+        return layout == D3D12_BARRIER_LAYOUT_SHADER_RESOURCE
+            || layout == D3D12_BARRIER_LAYOUT_COPY_SOURCE
+            || layout == D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE
+            || layout == D3D12_BARRIER_LAYOUT_GENERIC_READ;
+    }
+
+    BarrierStateMapping convertBarrierStates(ResourceStates stateBits, bool isTexture)
+    {
+        BarrierStateMapping result;
+
+        constexpr uint32_t numStateBits = sizeof(g_BarrierStateMap) / sizeof(g_BarrierStateMap[0]);
+
+        uint32_t stateTmp = uint32_t(stateBits);
+        uint32_t bitIndex = 0;
+
+        while (stateTmp != 0 && bitIndex < numStateBits)
+        {
+            uint32_t bit = (1 << bitIndex);
+
+            if (stateTmp & bit)
+            {
+                const BarrierStateMappingInternal& mapping = g_BarrierStateMap[bitIndex];
+
+                assert(uint32_t(mapping.nvrhiState) == bit);
+
+                result.sync |= mapping.sync;
+                result.access |= mapping.access;
+
+                if (isTexture && mapping.layout != D3D12_BARRIER_LAYOUT_UNDEFINED && mapping.layout != result.layout)
+                {
+                    if (result.layout == D3D12_BARRIER_LAYOUT_UNDEFINED || mapping.layout == D3D12_BARRIER_LAYOUT_COMMON)
+                    {
+                        result.layout = mapping.layout;
+                    }
+                    else if (result.layout == D3D12_BARRIER_LAYOUT_COMMON)
+                    {
+                        // The common layout supports all accesses, keep it
+                    }
+                    else if (result.layout == D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ || mapping.layout == D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ)
+                    {
+                        // Depth textures are sampled in the read-only depth layout
+                        assert(isReadOnlyTextureLayout(result.layout) || isReadOnlyTextureLayout(mapping.layout));
+                        result.layout = D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ;
+                    }
+                    else
+                    {
+                        // Combinations of read-only states, such as ShaderResource | CopySource, use the generic read layout.
+                        // Writable layouts cannot be combined with anything.
+                        assert(isReadOnlyTextureLayout(result.layout) && isReadOnlyTextureLayout(mapping.layout));
+                        result.layout = D3D12_BARRIER_LAYOUT_GENERIC_READ;
+                    }
+                }
+
+                stateTmp &= ~bit;
+            }
+
+            bitIndex++;
+        }
+
+        if ((stateBits & (ResourceStates::Common | ResourceStates::Present)) != 0)
+        {
+            // Common access is only valid on its own, and it covers all other accesses anyway
+            result.sync = D3D12_BARRIER_SYNC_ALL;
+            result.access = D3D12_BARRIER_ACCESS_COMMON;
+        }
+        else if (result.sync == D3D12_BARRIER_SYNC_NONE)
+        {
+            // Unknown states have no prior accesses to wait for, and SYNC_NONE requires NO_ACCESS
+            result.access = D3D12_BARRIER_ACCESS_NO_ACCESS;
+        }
+
+        return result;
+    }
+#endif
+
     D3D12_SHADING_RATE convertPixelShadingRate(VariableShadingRate shadingRate)
     {
         switch (shadingRate)
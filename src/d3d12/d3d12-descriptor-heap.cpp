@@ -21,6 +21,10 @@
 */
 
 #include "d3d12-backend.h"
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
 
 namespace nvrhi::d3d12
 {
@@ -28,6 +32,8 @@ namespace nvrhi::d3d12
     StaticDescriptorHeap::StaticDescriptorHeap(const Context& context)
         : m_Context(context)
     {
+        for (auto& slot : m_SingleDescriptorCache)
+            slot.store(c_InvalidDescriptorIndex, std::memory_order_relaxed);
     }
     
     HRESULT StaticDescriptorHeap::allocateResources(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors, bool shaderVisible)
@@ -62,7 +68,7 @@ namespace nvrhi::d3d12
         m_HeapType = heapDesc.Type;
         m_StartCpuHandle = m_Heap->GetCPUDescriptorHandleForHeapStart();
         m_Stride = m_Context.device->GetDescriptorHandleIncrementSize(heapDesc.Type);
-        m_AllocatedDescriptors.resize(m_NumDescriptors);
+        m_AllocatedDescriptors.resize((m_NumDescriptors + 63) / 64);
 
         return S_OK;
     }
@@ -118,32 +124,183 @@ namespace nvrhi::d3d12
         return S_OK;
     }
 
-    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    DescriptorIndex StaticDescriptorHeap::findFreeRange(uint32_t count) const
     {
-        std::lock_guard lockGuard(m_Mutex);
-
-        DescriptorIndex foundIndex = 0;
+        DescriptorIndex runStart = 0;
         uint32_t freeCount = 0;
-        bool found = false;
 
-        // Find a contiguous range of 'count' indices for which m_AllocatedDescriptors[index] is false
+        // Find a contiguous range of 'count' clear bits in m_AllocatedDescriptors, processing whole words at a time
 
-        for (DescriptorIndex index = m_SearchStart; index < m_NumDescriptors; index++)
+        DescriptorIndex index = m_SearchStart;
+        while (index < m_NumDescriptors)
         {
-            if (m_AllocatedDescriptors[index])
-                freeCount = 0;
-            else
-                freeCount += 1;
+            const uint32_t bit = index & 63;
+            const uint32_t bitsInWord = std::min(64 - bit, m_NumDescriptors - index);
+            uint64_t word = m_AllocatedDescriptors[index >> 6] >> bit;
+
+            if (word == 0)
+            {
+                // The rest of the word is free
+                if (freeCount == 0)
+                    runStart = index;
+
+                freeCount += bitsInWord;
+                if (freeCount >= count)
+                    return runStart;
+
+                index += bitsInWord;
+                continue;
+            }
+
+            uint32_t offset = 0;
+            if (freeCount == 0)
+            {
+                // Skip the allocated descriptors at the start of the word
+                const uint64_t freeBits = ~word;
+                if (freeBits == 0 || (bitsInWord < 64 && (freeBits & ((1ull << bitsInWord) - 1)) == 0))
+                {
+                    index += bitsInWord;
+                    continue;
+                }
+
+                offset = countTrailingZeros(freeBits);
+            }
 
-            if (freeCount >= count)
+            for (; offset < bitsInWord; offset++)
             {
-                foundIndex = index - count + 1;
-                found = true;
-                break;
+                if (word & (1ull << offset))
+                {
+                    freeCount = 0;
+                }
+                else
+                {
+                    if (freeCount == 0)
+                        runStart = index + offset;
+
+                    if (++freeCount >= count)
+                        return runStart;
+                }
             }
+
+            index += bitsInWord;
         }
 
-        if (!found)
+        return c_InvalidDescriptorIndex;
+    }
+
+    void StaticDescriptorHeap::markDescriptors(DescriptorIndex baseIndex, uint32_t count, bool allocated)
+    {
+        DescriptorIndex index = baseIndex;
+        const DescriptorIndex endIndex = baseIndex + count;
+
+        while (index < endIndex)
+        {
+            const uint32_t bit = index & 63;
+            const uint32_t bitsInWord = std::min(64 - bit, endIndex - index);
+            const uint64_t mask = (bitsInWord == 64) ? ~0ull : (((1ull << bitsInWord) - 1) << bit);
+            uint64_t& word = m_AllocatedDescriptors[index >> 6];
+
+            if (allocated)
+            {
+                word |= mask;
+            }
+            else
+            {
+#ifdef _DEBUG
+                if ((word & mask) != mask)
+                {
+                    m_Context.error("Attempted to release an un-allocated descriptor");
+                }
+#endif
+                word &= ~mask;
+            }
+
+            index += bitsInWord;
+        }
+    }
+
+    static uint32_t getSingleDescriptorCacheProbeStart(uint32_t cacheSize)
+    {
+        static thread_local uint32_t probeStart = uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        return probeStart % cacheSize;
+    }
+
+    DescriptorIndex StaticDescriptorHeap::takeCachedDescriptor()
+    {
+        const uint32_t probeStart = getSingleDescriptorCacheProbeStart(c_SingleDescriptorCacheSize);
+
+        for (uint32_t probe = 0; probe < c_SingleDescriptorCacheProbes; probe++)
+        {
+            auto& slot = m_SingleDescriptorCache[(probeStart + probe) % c_SingleDescriptorCacheSize];
+
+            // Cheap check first to avoid writing to cache lines of empty slots
+            if (slot.load(std::memory_order_relaxed) == c_InvalidDescriptorIndex)
+                continue;
+
+            const DescriptorIndex index = slot.exchange(c_InvalidDescriptorIndex, std::memory_order_acquire);
+            if (index != c_InvalidDescriptorIndex)
+                return index;
+        }
+
+        return c_InvalidDescriptorIndex;
+    }
+
+    bool StaticDescriptorHeap::putCachedDescriptor(DescriptorIndex index)
+    {
+        const uint32_t probeStart = getSingleDescriptorCacheProbeStart(c_SingleDescriptorCacheSize);
+
+        for (uint32_t probe = 0; probe < c_SingleDescriptorCacheProbes; probe++)
+        {
+            auto& slot = m_SingleDescriptorCache[(probeStart + probe) % c_SingleDescriptorCacheSize];
+
+            DescriptorIndex expected = c_InvalidDescriptorIndex;
+            if (slot.compare_exchange_strong(expected, index, std::memory_order_release, std::memory_order_relaxed))
+                return true;
+        }
+
+        return false;
+    }
+
+    bool StaticDescriptorHeap::flushSingleDescriptorCache()
+    {
+        // Must be called with m_Mutex locked
+        bool anyFlushed = false;
+
+        for (auto& slot : m_SingleDescriptorCache)
+        {
+            const DescriptorIndex index = slot.exchange(c_InvalidDescriptorIndex, std::memory_order_acquire);
+            if (index == c_InvalidDescriptorIndex)
+                continue;
+
+            markDescriptors(index, 1, false);
+            m_NumAllocatedDescriptors -= 1;
+            m_SearchStart = std::min(m_SearchStart, index);
+            anyFlushed = true;
+        }
+
+        return anyFlushed;
+    }
+
+    DescriptorIndex StaticDescriptorHeap::allocateDescriptors(uint32_t count)
+    {
+        if (count == 1)
+        {
+            const DescriptorIndex cachedIndex = takeCachedDescriptor();
+            if (cachedIndex != c_InvalidDescriptorIndex)
+                return cachedIndex;
+        }
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        DescriptorIndex foundIndex = findFreeRange(count);
+
+        // The descriptors held in the cache may be enough to satisfy the request without growing
+        if (foundIndex == c_InvalidDescriptorIndex && flushSingleDescriptorCache())
+        {
+            foundIndex = findFreeRange(count);
+        }
+
+        if (foundIndex == c_InvalidDescriptorIndex)
         {
             foundIndex = m_NumDescriptors;
 
@@ -154,10 +311,7 @@ namespace nvrhi::d3d12
             }
         }
 
-        for (DescriptorIndex index = foundIndex; index < foundIndex + count; index++)
-        {
-            m_AllocatedDescriptors[index] = true;
-        }
+        markDescriptors(foundIndex, count, true);
 
         m_NumAllocatedDescriptors += count;
 
@@ -172,22 +326,15 @@ namespace nvrhi::d3d12
 
     void StaticDescriptorHeap::releaseDescriptors(DescriptorIndex baseIndex, uint32_t count)
     {
-        std::lock_guard lockGuard(m_Mutex);
-
         if (count == 0)
             return;
 
-        for (DescriptorIndex index = baseIndex; index < baseIndex + count; index++)
-        {
-#ifdef _DEBUG
-            if (!m_AllocatedDescriptors[index])
-            {
-                m_Context.error("Attempted to release an un-allocated descriptor");
-            }
-#endif
+        if (count == 1 && putCachedDescriptor(baseIndex))
+            return;
 
-            m_AllocatedDescriptors[index] = false;
-        }
+        std::lock_guard lockGuard(m_Mutex);
+
+        markDescriptors(baseIndex, count, false);
 
         m_NumAllocatedDescriptors -= count;
 
@@ -231,6 +378,24 @@ namespace nvrhi::d3d12
         return m_ShaderVisibleHeap;
     }
 
+    void StaticDescriptorHeap::getStatistics(MemoryCategoryStatistics& statistics)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (!m_Heap)
+            return;
+
+        const uint32_t numHeaps = m_ShaderVisibleHeap ? 2 : 1;
+        const uint64_t heapSize = uint64_t(m_NumDescriptors) * m_Stride * numHeaps;
+
+        // The heaps only grow, so the current size is also the peak.
+        // Released descriptors waiting in the single descriptor cache are counted as used.
+        statistics.allocatedBytes += heapSize;
+        statistics.peakAllocatedBytes += heapSize;
+        statistics.usedBytes += uint64_t(m_NumAllocatedDescriptors) * m_Stride * numHeaps;
+        statistics.allocationCount += numHeaps;
+    }
+
     void StaticDescriptorHeap::copyToShaderVisibleHeap(DescriptorIndex index, uint32_t count)
     {
         m_Context.device->CopyDescriptorsSimple(count, getCpuHandleShaderVisible(index), getCpuHandle(index), m_HeapType);
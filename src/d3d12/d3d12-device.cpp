@@ -38,6 +38,11 @@ namespace nvrhi::d3d12
         messageCallback->message(MessageSeverity::Error, message.c_str());
     }
 
+    void Context::warning(const std::string& message) const
+    {
+        messageCallback->message(MessageSeverity::Warning, message.c_str());
+    }
+
     void Context::info(const std::string& message) const
     {
         messageCallback->message(MessageSeverity::Info, message.c_str());
@@ -68,6 +73,10 @@ namespace nvrhi::d3d12
         , shaderResourceViewHeap(context)
         , samplerHeap(context)
         , timerQueries(desc.maxTimerQueries, true)
+        , occlusionQueries(desc.maxOcclusionQueries, true)
+        , pipelineStatisticsQueries(desc.maxPipelineStatisticsQueries, true)
+        , placedResources(context, residency)
+        , compactedSizeQueries(desc.maxCompactedSizeQueries, true)
         , m_Context(context)
     {
     }
@@ -82,19 +91,77 @@ namespace nvrhi::d3d12
 
     uint64_t Queue::updateLastCompletedInstance()
     {
-        if (lastCompletedInstance < lastSubmittedInstance)
+        uint64_t completed = lastCompletedInstance.load();
+
+        if (completed < lastSubmittedInstance.load())
+        {
+            const uint64_t fenceValue = fence->GetCompletedValue();
+
+            // Several threads may be opening command lists at once, only ever move the value forward
+            while (completed < fenceValue && !lastCompletedInstance.compare_exchange_weak(completed, fenceValue))
+                ;
+
+            return std::max(completed, fenceValue);
+        }
+
+        return completed;
+    }
+
+    std::shared_ptr<InternalCommandList> Queue::takeRecycledCommandList(uint64_t completedInstance)
+    {
+        if (m_NumRecycledCommandLists.load(std::memory_order_relaxed) == 0)
+            return nullptr;
+
+        std::lock_guard lockGuard(m_RecycledCommandListsMutex);
+
+        for (auto it = m_RecycledCommandLists.begin(); it != m_RecycledCommandLists.end(); ++it)
         {
-            lastCompletedInstance = fence->GetCompletedValue();
+            if ((*it)->lastSubmittedInstance <= completedInstance)
+            {
+                std::shared_ptr<InternalCommandList> commandList = std::move(*it);
+                m_RecycledCommandLists.erase(it);
+                m_NumRecycledCommandLists.store(m_RecycledCommandLists.size(), std::memory_order_relaxed);
+                return commandList;
+            }
         }
-        return lastCompletedInstance;
+
+        return nullptr;
+    }
+
+    void Queue::recycleCommandLists(std::list<std::shared_ptr<InternalCommandList>>& commandLists)
+    {
+        if (commandLists.empty())
+            return;
+
+        std::lock_guard lockGuard(m_RecycledCommandListsMutex);
+
+        for (auto& commandList : commandLists)
+            m_RecycledCommandLists.push_back(std::move(commandList));
+        commandLists.clear();
+
+        m_NumRecycledCommandLists.store(m_RecycledCommandLists.size(), std::memory_order_relaxed);
     }
 
     Device::Device(const DeviceDesc& desc)
         : m_Resources(m_Context, desc)
+        , m_PipelineCompiler(desc.pipelineCompilerThreadCount)
     {
         m_Context.device = desc.pDevice;
         m_Context.logBufferLifetime = desc.logBufferLifetime;
         m_Context.messageCallback = desc.errorCB;
+        m_Context.memoryStatistics = std::make_unique<MemoryStatisticsTracker>(desc.memoryAllocationCallback);
+        m_StateHandoffResolver = std::make_unique<StateHandoffResolver>(m_Context.messageCallback);
+
+        // Enabled before any resources are created, so that all of them are registered
+        m_Resources.residency.setEnabled(desc.enableResidencyManagement);
+        m_BudgetCallback = desc.budgetCallback;
+        m_DeferredDestructionFlags = desc.deferredDestruction;
+
+        {
+            RefCountPtr<IDXGIFactory4> factory;
+            if (SUCCEEDED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory))))
+                factory->EnumAdapterByLuid(m_Context.device->GetAdapterLuid(), IID_PPV_ARGS(&m_Adapter));
+        }
 
         if (desc.pGraphicsCommandQueue)
             m_Queues[int(CommandQueue::Graphics)] = std::make_unique<Queue>(m_Context, desc.pGraphicsCommandQueue);
@@ -114,6 +181,19 @@ namespace nvrhi::d3d12
         bool hasOptions6 = SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS6, &m_Options6, sizeof(m_Options6)));
         bool hasOptions7 = SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS7, &m_Options7, sizeof(m_Options7)));
 
+        if (desc.enablePlacedResources)
+            m_Resources.placedResources.initialize(desc.placedResourceHeapSize, m_Options.ResourceHeapTier);
+
+        if (desc.enableSmallBufferPacking)
+            m_Resources.smallBuffers.initialize(this);
+
+        if (desc.enablePipelineLibrary || desc.initialPipelineCacheData)
+        {
+            m_PipelineLibrary = std::make_unique<PipelineLibrary>(m_Context);
+            if (!m_PipelineLibrary->initialize(desc.initialPipelineCacheData, desc.initialPipelineCacheDataSize))
+                m_PipelineLibrary = nullptr;
+        }
+
         if (SUCCEEDED(m_Context.device->QueryInterface(&m_Context.device5)) && hasOptions5)
         {
             m_RayTracingSupported = m_Options5.RaytracingTier >= D3D12_RAYTRACING_TIER_1_0;
@@ -178,6 +258,13 @@ namespace nvrhi::d3d12
             csDesc.ByteStride = 12;
             argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
             m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchIndirectSignature));
+
+            if (m_MeshletsSupported)
+            {
+                csDesc.ByteStride = 12;
+                argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+                m_Context.device->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&m_Context.dispatchMeshIndirectSignature));
+            }
         }
         
         m_FenceEvent = CreateEvent(nullptr, false, false, nullptr);
@@ -308,12 +395,50 @@ namespace nvrhi::d3d12
             m_HeapDirectlyIndexedEnabled = m_Options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_3 && 
                 hasShaderModel && shaderModel.HighestShaderModel >= D3D_SHADER_MODEL_6_6;
         }
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        if (desc.enableEnhancedBarriers)
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS12 options12 = {};
+            bool hasOptions12 = SUCCEEDED(m_Context.device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS12, &options12, sizeof(options12)));
+
+            m_Context.enhancedBarriersEnabled = hasOptions12 && options12.EnhancedBarriersSupported;
+        }
+#endif
+
+        // Render passes need ID3D12GraphicsCommandList4, which comes with the same runtimes as OPTIONS5
+        m_Context.renderPassesEnabled = desc.enableRenderPasses && hasOptions5;
+
+        if (desc.enableObjectDeduplication)
+            m_Deduplication = std::make_unique<ObjectDeduplicationCaches>();
+
+        if (desc.shaderPermutationProvider)
+        {
+            m_ShaderPermutations = std::make_unique<ShaderPermutationCache>(desc.shaderPermutationProvider,
+                desc.shaderPermutationCacheDirectory, m_Context.messageCallback);
+        }
+
+        m_TextureBlitter = std::make_unique<D3DTextureBlitter>(this);
     }
 
     Device::~Device()
     {
+        // Finish or cancel the pipeline jobs while the device is still intact
+        m_PipelineCompiler.shutdown();
+
+        // The cached objects reference the device
+        m_Deduplication.reset();
+        m_TextureBlitter.reset();
+
         waitForIdle();
 
+        // The objects waiting for deferred destruction reference the context and the descriptor heaps
+        m_DeferredDestruction.destroyAll();
+
+        // Releasing the blocks of the packed buffers queues them for deferred destruction as well
+        m_Resources.smallBuffers.releaseBlocks();
+        m_DeferredDestruction.destroyAll();
+
         if (m_FenceEvent)
         {
             CloseHandle(m_FenceEvent);
@@ -321,6 +446,26 @@ namespace nvrhi::d3d12
         }
     }
 
+    AsyncGraphicsPipelineHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback)
+    {
+        return m_PipelineCompiler.createGraphicsPipeline(this, desc, fbinfo, fallback);
+    }
+
+    AsyncComputePipelineHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback)
+    {
+        return m_PipelineCompiler.createComputePipeline(this, desc, fallback);
+    }
+
+    AsyncMeshletPipelineHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback)
+    {
+        return m_PipelineCompiler.createMeshletPipeline(this, desc, fbinfo, fallback);
+    }
+
+    rt::AsyncPipelineHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback)
+    {
+        return m_PipelineCompiler.createRayTracingPipeline(this, desc, fallback);
+    }
+
     bool Device::waitForIdle()
     {
         // Wait for every queue to reach its last submitted instance
@@ -392,8 +537,19 @@ namespace nvrhi::d3d12
     
     SamplerHandle Device::createSampler(const SamplerDesc& d)
     {
+        if (m_Deduplication)
+        {
+            if (SamplerHandle existing = m_Deduplication->samplers.find(d))
+                return existing;
+        }
+
         Sampler* sampler = new Sampler(m_Context, d);
-        return SamplerHandle::Create(sampler);
+        SamplerHandle handle = SamplerHandle::Create(sampler);
+
+        if (m_Deduplication)
+            handle = m_Deduplication->samplers.insert(d, handle);
+
+        return handle;
     }
     
     GraphicsAPI Device::getGraphicsAPI()
@@ -422,23 +578,78 @@ namespace nvrhi::d3d12
         if (!getQueue(params.queueType))
             return nullptr;
 
+        if (params.enableStateHandoff)
+            m_StateHandoffUsed = true;
+
         return CommandListHandle::Create(new CommandList(this, m_Context, m_Resources, params));
     }
     
     uint64_t Device::executeCommandLists(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
     {
-        m_CommandListsToExecute.resize(numCommandLists);
-        for (size_t i = 0; i < numCommandLists; i++)
+        if (m_StateHandoffUsed)
         {
-            m_CommandListsToExecute[i] = checked_cast<CommandList*>(pCommandLists[i])->getD3D12CommandList();
+            // Insert the command lists with cross-list transitions, and submit the extended sequence instead
+            resolveStateHandoff(pCommandLists, numCommandLists, executionQueue);
+            pCommandLists = m_StateHandoffSubmission.data();
+            numCommandLists = m_StateHandoffSubmission.size();
         }
 
+        if (m_Resources.residency.isEnabled())
+            makeReferencedResourcesResident(pCommandLists, numCommandLists);
+
         Queue* pQueue = getQueue(executionQueue);
 
-        pQueue->queue->ExecuteCommandLists(uint32_t(m_CommandListsToExecute.size()), m_CommandListsToExecute.data());
+        auto flushCommandLists = [this, pQueue]()
+        {
+            if (!m_CommandListsToExecute.empty())
+            {
+                pQueue->queue->ExecuteCommandLists(uint32_t(m_CommandListsToExecute.size()), m_CommandListsToExecute.data());
+                m_CommandListsToExecute.clear();
+            }
+        };
+
+        m_CommandListsToExecute.clear();
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+
+            // Command lists split by sync points are executed in parts, with the fence signals and waits between them
+            for (const CommandList::SyncSegment& segment : commandList->getSyncSegments())
+            {
+                m_CommandListsToExecute.push_back(segment.commandList->commandList);
+
+                if (segment.signalAfter)
+                {
+                    flushCommandLists();
+                    pQueue->lastSubmittedInstance++;
+                    pQueue->queue->Signal(pQueue->fence, pQueue->lastSubmittedInstance);
+                    segment.signalAfter->value = pQueue->lastSubmittedInstance;
+                }
+
+                if (segment.waitAfter)
+                {
+                    const uint64_t value = segment.waitAfter->value;
+                    if (value == 0)
+                    {
+                        m_Context.error("A command list waits for a sync point that is signaled by a command list "
+                            "which has not been executed yet, the wait is ignored");
+                        continue;
+                    }
+
+                    flushCommandLists();
+                    pQueue->queue->Wait(segment.waitAfter->fence, value);
+                }
+            }
+
+            m_CommandListsToExecute.push_back(commandList->getD3D12CommandList());
+        }
+
+        flushCommandLists();
         pQueue->lastSubmittedInstance++;
         pQueue->queue->Signal(pQueue->fence, pQueue->lastSubmittedInstance);
 
+        m_Resources.residency.submitted(executionQueue, pQueue->lastSubmittedInstance);
+
         for (size_t i = 0; i < numCommandLists; i++)
         {
             auto instance = checked_cast<CommandList*>(pCommandLists[i])->executed(pQueue);
@@ -510,6 +721,10 @@ namespace nvrhi::d3d12
         {
             ID3D12Heap* heap = tileMappings[i].heap ? checked_cast<Heap*>(tileMappings[i].heap)->heap : nullptr;
 
+            // Uses of the tiles are not tracked, so the heaps mapped into tiled textures are never evicted
+            if (heap)
+                m_Resources.residency.setPriority(getResidencyKey(heap), ResidencyPriority::Maximum);
+
             uint32_t numRegions = tileMappings[i].numTextureRegions;
             std::vector<D3D12_TILED_RESOURCE_COORDINATE> resourceCoordinates(numRegions);
             std::vector<D3D12_TILE_REGION_SIZE> regionSizes(numRegions);
@@ -557,6 +772,36 @@ namespace nvrhi::d3d12
         }
     }
 
+    void Device::updateBufferTileMappings(IBuffer* _buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Queue* queue = getQueue(executionQueue);
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        for (uint32_t i = 0; i < numTileMappings; i++)
+        {
+            const BufferTilesMapping& mapping = tileMappings[i];
+            ID3D12Heap* heap = mapping.heap ? checked_cast<Heap*>(mapping.heap)->heap : nullptr;
+
+            // Uses of the tiles are not tracked, so the heaps mapped into tiled buffers are never evicted
+            if (heap)
+                m_Resources.residency.setPriority(getResidencyKey(heap), ResidencyPriority::Maximum);
+
+            // Buffers have one subresource, and their tiles are addressed linearly along X
+            D3D12_TILED_RESOURCE_COORDINATE resourceCoordinate = {};
+            resourceCoordinate.X = UINT(mapping.bufferOffset / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+
+            D3D12_TILE_REGION_SIZE regionSize = {};
+            regionSize.NumTiles = UINT(mapping.byteSize / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+            regionSize.UseBox = false;
+
+            const D3D12_TILE_RANGE_FLAGS rangeFlags = heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+            const UINT heapStartOffset = UINT(mapping.heapOffset / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+            const UINT rangeTileCount = regionSize.NumTiles;
+
+            queue->queue->UpdateTileMappings(buffer->resource, 1, &resourceCoordinate, &regionSize, heap, 1, &rangeFlags, heap ? &heapStartOffset : nullptr, &rangeTileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+        }
+    }
+
     void Device::runGarbageCollection()
     {
         for (const auto& pQueue : m_Queues)
@@ -574,6 +819,44 @@ namespace nvrhi::d3d12
                 
                 if (pQueue->lastCompletedInstance >= instance->submittedInstance)
                 {
+                    if (!instance->accelStructsToCompact.empty())
+                    {
+                        {
+                            std::lock_guard lockGuard(m_Resources.asCompactionMutex);
+
+                            // A BLAS can be built by several command lists before it is compacted, list it only once
+                            for (const rt::AccelStructHandle& handle : instance->accelStructsToCompact)
+                            {
+                                AccelStruct* as = checked_cast<AccelStruct*>(handle.Get());
+                                if (!as->compactionPending)
+                                {
+                                    as->compactionPending = true;
+                                    m_Resources.asCompactionCandidates.push_back(as);
+                                }
+                            }
+                        }
+
+                        // Released outside of the lock, the AccelStruct destructor takes it
+                        instance->accelStructsToCompact.clear();
+                    }
+                    if (!instance->ommsToCompact.empty())
+                    {
+                        {
+                            std::lock_guard lockGuard(m_Resources.asCompactionMutex);
+
+                            for (const rt::OpacityMicromapHandle& handle : instance->ommsToCompact)
+                            {
+                                OpacityMicromap* omm = checked_cast<OpacityMicromap*>(handle.Get());
+                                if (!omm->compactionPending)
+                                {
+                                    omm->compactionPending = true;
+                                    m_Resources.ommCompactionCandidates.push_back(omm);
+                                }
+                            }
+                        }
+
+                        instance->ommsToCompact.clear();
+                    }
 #ifdef NVRHI_WITH_RTXMU
                     if (!instance->rtxmuBuildIds.empty())
                     {
@@ -598,6 +881,27 @@ namespace nvrhi::d3d12
                 }
             }
         }
+
+        {
+            uint64_t lastSubmittedInstances[size_t(CommandQueue::Count)] = {};
+            uint64_t completedInstances[size_t(CommandQueue::Count)] = {};
+            for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+            {
+                if (m_Queues[queue])
+                {
+                    lastSubmittedInstances[queue] = m_Queues[queue]->lastSubmittedInstance;
+                    completedInstances[queue] = m_Queues[queue]->lastCompletedInstance;
+                }
+            }
+
+            m_DeferredDestruction.retire(lastSubmittedInstances, completedInstances);
+        }
+
+        if (m_Deduplication)
+            m_Deduplication->evictUnused();
+
+        if (m_Resources.residency.isEnabled() || m_BudgetCallback)
+            updateResidency();
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -606,6 +910,10 @@ namespace nvrhi::d3d12
         {
         case Feature::DeferredCommandLists:
             return true;
+        case Feature::Bundles:
+            return true;
+        case Feature::ShaderSpecializations:
+            return m_ShaderPermutations != nullptr;
         case Feature::SinglePassStereo:
             return m_SinglePassStereoSupported;
         case Feature::RayTracingAccelStruct:
@@ -626,7 +934,33 @@ namespace nvrhi::d3d12
             return m_SpheresSupported;
         case Feature::LinearSweptSpheres:
             return m_LinearSweptSpheresSupported;
+        case Feature::PipelineStatisticsQueries:
+        case Feature::Predication:
+            return true;
+        case Feature::GpuDecompression:
+            return NVRHI_D3D12_WITH_DIRECTSTORAGE != 0;
         case Feature::Meshlets:
+            if (pInfo)
+            {
+                if (infoSize == sizeof(MeshletFeatureInfo))
+                {
+                    // The limits are fixed by the D3D12 mesh shader specification
+                    auto* pMeshletInfo = reinterpret_cast<MeshletFeatureInfo*>(pInfo);
+                    for (int i = 0; i < 3; i++)
+                    {
+                        pMeshletInfo->maxTaskWorkGroupCount[i] = D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+                        pMeshletInfo->maxMeshWorkGroupCount[i] = D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+                    }
+                    pMeshletInfo->maxTaskWorkGroupTotalCount = 1u << 22;
+                    pMeshletInfo->maxMeshWorkGroupTotalCount = 1u << 22;
+                    pMeshletInfo->maxTaskPayloadSize = 16384;
+                    pMeshletInfo->maxMeshOutputVertices = 256;
+                    pMeshletInfo->maxMeshOutputPrimitives = 256;
+                    pMeshletInfo->perPrimitiveShadingRate = m_MeshletsSupported && m_VariableRateShadingSupported;
+                }
+                else
+                    utils::NotSupported();
+            }
             return m_MeshletsSupported;
         case Feature::VariableRateShading:
             if (pInfo)
@@ -796,6 +1130,28 @@ namespace nvrhi::d3d12
     }
 
     size_t Device::getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns)
+    {
+        if (!m_CoopVecInferencingSupported || rows <= 0 || columns <= 0)
+            return 0;
+
+        return m_CoopVecMatrixSizes.get(type, layout, uint32_t(rows), uint32_t(columns),
+            [this](coopvec::DataType t, coopvec::MatrixLayout l, uint32_t r, uint32_t c) { return queryCoopVecMatrixSize(t, l, r, c); });
+    }
+
+    void Device::getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes)
+    {
+        for (size_t i = 0; i < numDescs; ++i)
+        {
+            const coopvec::MatrixSizeDesc& desc = descs[i];
+
+            outSizes[i] = m_CoopVecInferencingSupported && desc.numRows != 0 && desc.numColumns != 0
+                ? m_CoopVecMatrixSizes.get(desc.type, desc.layout, desc.numRows, desc.numColumns,
+                    [this](coopvec::DataType t, coopvec::MatrixLayout l, uint32_t r, uint32_t c) { return queryCoopVecMatrixSize(t, l, r, c); })
+                : 0;
+        }
+    }
+
+    size_t Device::queryCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, uint32_t rows, uint32_t columns) const
     {
 #if NVRHI_D3D12_WITH_COOPVEC
         D3D12_LINEAR_ALGEBRA_MATRIX_CONVERSION_DEST_INFO destInfo = {};
@@ -850,6 +1206,13 @@ namespace nvrhi::d3d12
         return nullptr;
     }
 
+    PlacedResourceStatistics Device::getPlacedResourceStatistics()
+    {
+        PlacedResourceStatistics statistics = m_Resources.placedResources.getStatistics();
+        m_Resources.smallBuffers.getStatistics(statistics);
+        return statistics;
+    }
+
     HeapHandle Device::createHeap(const HeapDesc& d)
     {
         D3D12_HEAP_DESC heapDesc;
@@ -900,10 +1263,30 @@ namespace nvrhi::d3d12
             d3dHeap->SetName(wname.c_str());
         }
 
-        Heap* heap = new Heap();
+        Heap* heap = new Heap(m_Resources.residency);
         heap->heap = d3dHeap;
         heap->desc = d;
+
+        if (d.type == HeapType::DeviceLocal)
+            m_Resources.residency.addAllocation(getResidencyKey(d3dHeap), d.capacity);
+
         return HeapHandle::Create(heap);
     }
 
+    Heap::~Heap()
+    {
+        m_Residency.removeAllocation(getResidencyKey(heap));
+    }
+
+    Object Heap::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_Heap:
+            return Object(heap);
+        default:
+            return nullptr;
+        }
+    }
+
 } // namespace nvrhi::d3d12
@@ -169,6 +169,44 @@ namespace nvrhi::d3d12
         }
 #endif
 
+        uint64_t libraryKey = 0;
+        if (m_PipelineLibrary)
+        {
+            // Shaders and the input layout are hashed by contents: their addresses change between runs
+            StableHasher hasher;
+            hasher.add(pRS->serializedHash);
+            hasher.addShader(desc.VS);
+            hasher.addShader(desc.HS);
+            hasher.addShader(desc.DS);
+            hasher.addShader(desc.GS);
+            hasher.addShader(desc.PS);
+            hasher.addBlendDesc(desc.BlendState);
+            hasher.add(desc.SampleMask);
+            hasher.addRasterizerDesc(desc.RasterizerState);
+            hasher.addDepthStencilDesc(desc.DepthStencilState);
+            for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+            {
+                const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+                hasher.addBytes(element.SemanticName, strlen(element.SemanticName));
+                hasher.add(element.SemanticIndex);
+                hasher.add(element.Format);
+                hasher.add(element.InputSlot);
+                hasher.add(element.AlignedByteOffset);
+                hasher.add(element.InputSlotClass);
+                hasher.add(element.InstanceDataStepRate);
+            }
+            hasher.add(desc.PrimitiveTopologyType);
+            hasher.add(desc.NumRenderTargets);
+            hasher.add(desc.RTVFormats);
+            hasher.add(desc.DSVFormat);
+            hasher.add(desc.SampleDesc);
+            libraryKey = hasher.get();
+
+            pipelineState = m_PipelineLibrary->loadGraphicsPipeline(libraryKey, desc);
+            if (pipelineState)
+                return pipelineState;
+        }
+
         const HRESULT hr = m_Context.device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
 
         if (FAILED(hr))
@@ -177,16 +215,30 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        if (m_PipelineLibrary)
+            m_PipelineLibrary->storePipeline(libraryKey, pipelineState);
+
         return pipelineState;
     }
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        if (m_Deduplication)
+        {
+            if (GraphicsPipelineHandle existing = m_Deduplication->graphicsPipelines.find({ desc, fbinfo }))
+                return existing;
+        }
+
         RefCountPtr<RootSignature> pRS = getRootSignature(desc.bindingLayouts, desc.inputLayout != nullptr);
 
         RefCountPtr<ID3D12PipelineState> pPSO = createPipelineState(desc, pRS, fbinfo);
 
-        return createHandleForNativeGraphicsPipeline(pRS, pPSO, desc, fbinfo);
+        GraphicsPipelineHandle pipeline = createHandleForNativeGraphicsPipeline(pRS, pPSO, desc, fbinfo);
+
+        if (m_Deduplication)
+            pipeline = m_Deduplication->graphicsPipelines.insert({ desc, fbinfo }, pipeline);
+
+        return pipeline;
     }
     
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
@@ -211,6 +263,7 @@ namespace nvrhi::d3d12
         pso->rootSignature = checked_cast<RootSignature*>(rootSignature);
         pso->pipelineState = pipelineState;
         pso->requiresBlendFactor = desc.renderState.blendState.usesConstantColor(uint32_t(pso->framebufferInfo.colorFormats.size()));
+        pso->pixelShaderHasUAVs = desc.PS && pixelShaderMayWriteUAVs(desc.bindingLayouts);
         
         return GraphicsPipelineHandle::Create(pso);
     }
@@ -292,11 +345,338 @@ namespace nvrhi::d3d12
         m_ActiveCommandList->commandList->OMSetRenderTargets(UINT(RTVs.size()), RTVs.data(), false, fb->desc.depthAttachment.valid() ? &DSV : nullptr);
     }
 
+    static bool isUavResourceType(ResourceType type)
+    {
+        switch (type)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case ResourceType::Texture_UAV:
+        case ResourceType::TypedBuffer_UAV:
+        case ResourceType::StructuredBuffer_UAV:
+        case ResourceType::RawBuffer_UAV:
+        case ResourceType::SamplerFeedbackTexture_UAV:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool pixelShaderMayWriteUAVs(const BindingLayoutVector& bindingLayouts)
+    {
+        for (const BindingLayoutHandle& layout : bindingLayouts)
+        {
+            if (const BindingLayoutDesc* desc = layout->getDesc())
+            {
+                if ((desc->visibility & ShaderType::Pixel) == 0)
+                    continue;
+
+                for (const BindingLayoutItem& item : desc->bindings)
+                {
+                    if (isUavResourceType(item.type))
+                        return true;
+                }
+            }
+            else if (const BindlessLayoutDesc* bindlessDesc = layout->getBindlessDesc())
+            {
+                if ((bindlessDesc->visibility & ShaderType::Pixel) == 0)
+                    continue;
+
+                // Mutable layouts give access to the whole descriptor heap
+                if (bindlessDesc->layoutType == BindlessLayoutDesc::LayoutType::MutableSrvUavCbv ||
+                    bindlessDesc->layoutType == BindlessLayoutDesc::LayoutType::MutableCounters)
+                    return true;
+
+                for (const BindingLayoutItem& item : bindlessDesc->registerSpaces)
+                {
+                    if (isUavResourceType(item.type))
+                        return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    static void discardAttachment(ID3D12GraphicsCommandList* commandList, const FramebufferAttachment& attachment)
+    {
+        Texture* texture = checked_cast<Texture*>(attachment.texture);
+        TextureSubresourceSet subresources = attachment.subresources.resolve(texture->desc, false);
+
+        for (ArraySlice arraySlice = subresources.baseArraySlice; arraySlice < subresources.baseArraySlice + subresources.numArraySlices; arraySlice++)
+        {
+            for (uint8_t plane = 0; plane < texture->planeCount; plane++)
+            {
+                D3D12_DISCARD_REGION region = {};
+                region.FirstSubresource = calcSubresource(subresources.baseMipLevel, arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
+                region.NumSubresources = subresources.numMipLevels;
+                commandList->DiscardResource(texture->resource, &region);
+            }
+        }
+    }
+
+    static D3D12_RENDER_PASS_BEGINNING_ACCESS convertBeginningAccess(AttachmentLoadOp loadOp, DXGI_FORMAT format, const Color& clearValue, bool isDepthStencil)
+    {
+        D3D12_RENDER_PASS_BEGINNING_ACCESS access = {};
+
+        switch (loadOp)
+        {
+        case AttachmentLoadOp::Clear:
+            access.Type = D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_CLEAR;
+            access.Clear.ClearValue.Format = format;
+            if (isDepthStencil)
+            {
+                access.Clear.ClearValue.DepthStencil.Depth = clearValue.r;
+                access.Clear.ClearValue.DepthStencil.Stencil = UINT8(clearValue.g);
+            }
+            else
+            {
+                access.Clear.ClearValue.Color[0] = clearValue.r;
+                access.Clear.ClearValue.Color[1] = clearValue.g;
+                access.Clear.ClearValue.Color[2] = clearValue.b;
+                access.Clear.ClearValue.Color[3] = clearValue.a;
+            }
+            break;
+        case AttachmentLoadOp::DontCare:
+            access.Type = D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_DISCARD;
+            break;
+        case AttachmentLoadOp::Load:
+        default:
+            access.Type = D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_PRESERVE;
+            break;
+        }
+
+        return access;
+    }
+
+    static D3D12_RENDER_PASS_ENDING_ACCESS convertEndingAccess(AttachmentStoreOp storeOp)
+    {
+        D3D12_RENDER_PASS_ENDING_ACCESS access = {};
+        access.Type = storeOp == AttachmentStoreOp::Discard
+            ? D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_DISCARD
+            : D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_PRESERVE;
+        return access;
+    }
+
+    void CommandList::beginRenderPass(Framebuffer* fb, bool allowUavWrites)
+    {
+        // A pass that resumes rendering to the framebuffer after an interruption preserves the contents
+        const bool resuming = fb == m_LastRenderPassFramebuffer;
+
+        static_vector<D3D12_RENDER_PASS_RENDER_TARGET_DESC, c_MaxRenderTargets> renderTargets;
+        for (uint32_t rtIndex = 0; rtIndex < fb->RTVs.size(); rtIndex++)
+        {
+            const FramebufferAttachment& attachment = fb->desc.colorAttachments[rtIndex];
+            const Format format = attachment.format == Format::UNKNOWN ? attachment.texture->getDesc().format : attachment.format;
+
+            D3D12_RENDER_PASS_RENDER_TARGET_DESC renderTarget = {};
+            renderTarget.cpuDescriptor = m_Resources.renderTargetViewHeap.getCpuHandle(fb->RTVs[rtIndex]);
+            renderTarget.BeginningAccess = convertBeginningAccess(resuming ? AttachmentLoadOp::Load : attachment.loadOp,
+                getDxgiFormatMapping(format).rtvFormat, attachment.getEffectiveClearValue(), false);
+            renderTarget.EndingAccess = convertEndingAccess(attachment.storeOp);
+            renderTargets.push_back(renderTarget);
+        }
+
+        D3D12_RENDER_PASS_FLAGS flags = D3D12_RENDER_PASS_FLAG_NONE;
+        if (allowUavWrites)
+            flags |= D3D12_RENDER_PASS_FLAG_ALLOW_UAV_WRITES;
+
+        D3D12_RENDER_PASS_DEPTH_STENCIL_DESC depthStencil = {};
+        const FramebufferAttachment& depthAttachment = fb->desc.depthAttachment;
+        if (depthAttachment.valid())
+        {
+            const Format format = depthAttachment.texture->getDesc().format;
+            const bool hasStencil = getFormatInfo(format).hasStencil;
+
+            depthStencil.cpuDescriptor = m_Resources.depthStencilViewHeap.getCpuHandle(fb->DSV);
+
+            if (depthAttachment.isReadOnly)
+            {
+                flags |= D3D12_RENDER_PASS_FLAG_BIND_READ_ONLY_DEPTH;
+                if (hasStencil)
+                    flags |= D3D12_RENDER_PASS_FLAG_BIND_READ_ONLY_STENCIL;
+            }
+
+            const AttachmentLoadOp loadOp = resuming || depthAttachment.isReadOnly ? AttachmentLoadOp::Load : depthAttachment.loadOp;
+            const AttachmentStoreOp storeOp = depthAttachment.isReadOnly ? AttachmentStoreOp::Store : depthAttachment.storeOp;
+
+            depthStencil.DepthBeginningAccess = convertBeginningAccess(loadOp, getDxgiFormatMapping(format).rtvFormat,
+                depthAttachment.getEffectiveClearValue(), true);
+            depthStencil.DepthEndingAccess = convertEndingAccess(storeOp);
+
+            if (hasStencil)
+            {
+                depthStencil.StencilBeginningAccess = depthStencil.DepthBeginningAccess;
+                depthStencil.StencilEndingAccess = depthStencil.DepthEndingAccess;
+            }
+            else
+            {
+                depthStencil.StencilBeginningAccess.Type = D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_NO_ACCESS;
+                depthStencil.StencilEndingAccess.Type = D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_NO_ACCESS;
+            }
+        }
+
+        m_ActiveCommandList->commandList4->BeginRenderPass(UINT(renderTargets.size()), renderTargets.data(),
+            depthAttachment.valid() ? &depthStencil : nullptr, flags);
+
+        m_RenderPassFramebuffer = fb;
+        m_RenderPassAllowsUavWrites = allowUavWrites;
+        m_LastRenderPassFramebuffer = fb;
+    }
+
+    void CommandList::endRenderPass()
+    {
+        if (!m_RenderPassFramebuffer)
+            return;
+
+        m_ActiveCommandList->commandList4->EndRenderPass();
+        m_RenderPassFramebuffer = nullptr;
+    }
+
+    void CommandList::beginRendering(Framebuffer* fb, bool allowUavWrites)
+    {
+        // Called after the barriers for the framebuffer are committed
+        if (m_Context.renderPassesEnabled)
+        {
+            if (m_RenderPassFramebuffer == fb && (m_RenderPassAllowsUavWrites || !allowUavWrites))
+                return;
+
+            endRenderPass();
+            beginRenderPass(fb, allowUavWrites);
+        }
+        else if (fb != m_LastRenderPassFramebuffer)
+        {
+            applyAttachmentLoadOps(fb);
+        }
+    }
+
+    void CommandList::applyAttachmentLoadOps(Framebuffer* fb)
+    {
+        // Called after the barriers for the framebuffer are committed, so the attachments are in the render target
+        // and depth write states that ClearRenderTargetView, ClearDepthStencilView and DiscardResource require.
+        // Store ops have no equivalent without render passes.
+        m_LastRenderPassFramebuffer = fb;
+
+        for (uint32_t rtIndex = 0; rtIndex < fb->RTVs.size(); rtIndex++)
+        {
+            const FramebufferAttachment& attachment = fb->desc.colorAttachments[rtIndex];
+
+            if (attachment.loadOp == AttachmentLoadOp::Clear)
+            {
+                m_ActiveCommandList->commandList->ClearRenderTargetView(m_Resources.renderTargetViewHeap.getCpuHandle(fb->RTVs[rtIndex]),
+                    &attachment.getEffectiveClearValue().r, 0, nullptr);
+            }
+            else if (attachment.loadOp == AttachmentLoadOp::DontCare)
+            {
+                discardAttachment(m_ActiveCommandList->commandList, attachment);
+            }
+        }
+
+        const FramebufferAttachment& depthAttachment = fb->desc.depthAttachment;
+        if (depthAttachment.valid() && !depthAttachment.isReadOnly)
+        {
+            if (depthAttachment.loadOp == AttachmentLoadOp::Clear)
+            {
+                const Color& clearValue = depthAttachment.getEffectiveClearValue();
+
+                D3D12_CLEAR_FLAGS clearFlags = D3D12_CLEAR_FLAG_DEPTH;
+                if (getFormatInfo(depthAttachment.texture->getDesc().format).hasStencil)
+                    clearFlags |= D3D12_CLEAR_FLAG_STENCIL;
+
+                m_ActiveCommandList->commandList->ClearDepthStencilView(m_Resources.depthStencilViewHeap.getCpuHandle(fb->DSV),
+                    clearFlags, clearValue.r, UINT8(clearValue.g), 0, nullptr);
+            }
+            else if (depthAttachment.loadOp == AttachmentLoadOp::DontCare)
+            {
+                discardAttachment(m_ActiveCommandList->commandList, depthAttachment);
+            }
+        }
+    }
+
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        D3D12_INDEX_BUFFER_VIEW IBV = {};
+
+        if (indexBuffer.buffer)
+        {
+            Buffer* buffer = checked_cast<Buffer*>(indexBuffer.buffer);
+
+            IBV.Format = getDxgiFormatMapping(indexBuffer.format).srvFormat;
+            IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - indexBuffer.offset);
+            IBV.BufferLocation = buffer->gpuVA + indexBuffer.offset;
+
+            m_Instance->referencedResources.push_back(indexBuffer.buffer);
+        }
+
+        m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+    }
+
+    void CommandList::bindVertexBuffers(const GraphicsPipeline* pso, const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers)
+    {
+        D3D12_VERTEX_BUFFER_VIEW VBVs[c_MaxVertexAttributes] = {};
+        uint32_t maxVbIndex = 0;
+        InputLayout* inputLayout = checked_cast<InputLayout*>(pso->desc.inputLayout.Get());
+
+        for (const VertexBufferBinding& binding : vertexBuffers)
+        {
+            Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
+
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            VBVs[binding.slot].StrideInBytes = inputLayout->elementStrides[binding.slot];
+            VBVs[binding.slot].SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
+            VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+
+            m_Instance->referencedResources.push_back(buffer);
+        }
+
+        // Also clear the slots that were used by the previous bindings
+        if (m_CurrentGraphicsStateValid)
+        {
+            for (const VertexBufferBinding& binding : m_CurrentGraphicsState.vertexBuffers)
+            {
+                if (binding.slot < c_MaxVertexAttributes)
+                    maxVbIndex = std::max(maxVbIndex, binding.slot);
+            }
+        }
+
+        m_ActiveCommandList->commandList->IASetVertexBuffers(0, maxVbIndex + 1, VBVs);
+    }
+
+    void CommandList::setViewports(const GraphicsPipeline* pso, const Framebuffer* fb, const ViewportState& viewport)
+    {
+        DX12_ViewportState vpState = convertViewportState(pso->desc.renderState.rasterState, fb->framebufferInfo, viewport);
+
+        if (m_Desc.isBundle)
+        {
+            // Viewports and scissor rects cannot be set in bundles, executeBundles applies them on the direct list
+            m_BundleViewportState = vpState;
+            return;
+        }
+
+        if (vpState.numViewports)
+        {
+            m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
+        }
+
+        if (vpState.numScissorRects)
+        {
+            m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+        }
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
+        // The complete state replaces anything set with the incremental setters since the last draw
+        m_PendingGraphicsState.reset();
+
         GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
         Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
 
+        if (m_CurrentMeshletStateValid)
+            unbindShadingRateState();
+
         const bool updateFramebuffer = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.framebuffer != state.framebuffer;
         const bool updateRootSignature = !m_CurrentGraphicsStateValid || m_CurrentGraphicsState.pipeline == nullptr ||
             checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline)->rootSignature != pso->rootSignature;
@@ -348,7 +728,12 @@ namespace nvrhi::d3d12
 
         if (updateFramebuffer)
         {
-            bindFramebuffer(framebuffer);
+            // In the render pass mode, BeginRenderPass sets the render targets
+            if (m_Desc.isBundle)
+                m_BundleFramebuffer = framebuffer;
+            else if (!m_Context.renderPassesEnabled)
+                bindFramebuffer(framebuffer);
+
             m_Instance->referencedResources.push_back(framebuffer);
         }
         
@@ -359,22 +744,18 @@ namespace nvrhi::d3d12
 
         setGraphicsBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
 
-        if (updateIndexBuffer)
+        if (state.indirectCountBuffer && (!m_CurrentGraphicsStateValid || m_CurrentGraphicsState.indirectCountBuffer != state.indirectCountBuffer))
         {
-            D3D12_INDEX_BUFFER_VIEW IBV = {};
-
-            if (state.indexBuffer.buffer)
+            if (m_EnableAutomaticBarriers)
             {
-                Buffer* buffer = checked_cast<Buffer*>(state.indexBuffer.buffer);
-
-                IBV.Format = getDxgiFormatMapping(state.indexBuffer.format).srvFormat;
-                IBV.SizeInBytes = (UINT)(buffer->desc.byteSize - state.indexBuffer.offset);
-                IBV.BufferLocation = buffer->gpuVA + state.indexBuffer.offset;
-
-                m_Instance->referencedResources.push_back(state.indexBuffer.buffer);
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
             }
+            m_Instance->referencedResources.push_back(state.indirectCountBuffer);
+        }
 
-            m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+        if (updateIndexBuffer)
+        {
+            bindIndexBuffer(state.indexBuffer);
         }
 
         if (m_EnableAutomaticBarriers && state.indexBuffer.buffer && (m_BindingStatesDirty || updateIndexBuffer))
@@ -386,36 +767,7 @@ namespace nvrhi::d3d12
 
         if (updateVertexBuffers)
         {
-            D3D12_VERTEX_BUFFER_VIEW VBVs[c_MaxVertexAttributes] = {};
-            uint32_t maxVbIndex = 0;
-            InputLayout* inputLayout = checked_cast<InputLayout*>(pso->desc.inputLayout.Get());
-
-            for (const VertexBufferBinding& binding : state.vertexBuffers)
-            {
-                Buffer* buffer = checked_cast<Buffer*>(binding.buffer);
-
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-
-                VBVs[binding.slot].StrideInBytes = inputLayout->elementStrides[binding.slot];
-                VBVs[binding.slot].SizeInBytes = (UINT)(std::min(buffer->desc.byteSize - binding.offset, (uint64_t)ULONG_MAX));
-                VBVs[binding.slot].BufferLocation = buffer->gpuVA + binding.offset;
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-
-                m_Instance->referencedResources.push_back(buffer);
-            }
-
-            if (m_CurrentGraphicsStateValid)
-            {
-                for (const VertexBufferBinding& binding : m_CurrentGraphicsState.vertexBuffers)
-                {
-                    if (binding.slot < c_MaxVertexAttributes)
-                        maxVbIndex = std::max(maxVbIndex, binding.slot);
-                }
-            }
-
-            m_ActiveCommandList->commandList->IASetVertexBuffers(0, maxVbIndex + 1, VBVs);
+            bindVertexBuffers(pso, state.vertexBuffers);
         }
 
         if (m_EnableAutomaticBarriers && state.indexBuffer.buffer && (m_BindingStatesDirty || updateVertexBuffers))
@@ -466,19 +818,14 @@ namespace nvrhi::d3d12
         
         commitBarriers();
 
-        if (updateViewports)
+        if (!m_Desc.isBundle && framebuffer)
         {
-            DX12_ViewportState vpState = convertViewportState(pso->desc.renderState.rasterState, framebuffer->framebufferInfo, state.viewport);
-
-            if (vpState.numViewports)
-            {
-                m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
-            }
+            beginRendering(framebuffer, pso->pixelShaderHasUAVs);
+        }
 
-            if (vpState.numScissorRects)
-            {
-                m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
-            }
+        if (updateViewports)
+        {
+            setViewports(pso, framebuffer, state.viewport);
         }
 
 #if NVRHI_D3D12_WITH_NVAPI
@@ -508,6 +855,158 @@ namespace nvrhi::d3d12
         m_BindingStatesDirty = false;
     }
 
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        m_PendingGraphicsState.setBindingSet(m_CurrentGraphicsState.bindings, slot, bindingSet);
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers)
+    {
+        m_PendingGraphicsState.setVertexBuffers(m_CurrentGraphicsState.vertexBuffers, vertexBuffers, numVertexBuffers);
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_PendingGraphicsState.setIndexBuffer(m_CurrentGraphicsState.indexBuffer, indexBuffer);
+    }
+
+    void CommandList::setViewportState(const ViewportState& viewport)
+    {
+        m_PendingGraphicsState.setViewport(m_CurrentGraphicsState.viewport, viewport);
+    }
+
+    void CommandList::commitGraphicsStateChanges()
+    {
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_PendingGraphicsState.reset();
+            return;
+        }
+
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+        Framebuffer* framebuffer = checked_cast<Framebuffer*>(m_CurrentGraphicsState.framebuffer);
+        const PendingGraphicsState& pending = m_PendingGraphicsState;
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Bindings))
+        {
+            uint32_t bindingUpdateMask = pending.bindingUpdateMask;
+            if (commitDescriptorHeaps())
+                bindingUpdateMask = ~0u;
+
+            setGraphicsBindings(pending.bindings, bindingUpdateMask, m_CurrentGraphicsState.indirectParams, false, pso->rootSignature);
+
+            m_CurrentGraphicsState.bindings = pending.bindings;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::IndexBuffer))
+        {
+            bindIndexBuffer(pending.indexBuffer);
+
+            if (m_EnableAutomaticBarriers && pending.indexBuffer.buffer)
+                requireBufferState(pending.indexBuffer.buffer, ResourceStates::IndexBuffer);
+
+            m_CurrentGraphicsState.indexBuffer = pending.indexBuffer;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::VertexBuffers))
+        {
+            bindVertexBuffers(pso, pending.vertexBuffers);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                for (const VertexBufferBinding& binding : pending.vertexBuffers)
+                    requireBufferState(binding.buffer, ResourceStates::VertexBuffer);
+            }
+
+            m_CurrentGraphicsState.vertexBuffers = pending.vertexBuffers;
+        }
+
+        commitBarriers();
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Viewport))
+        {
+            setViewports(pso, framebuffer, pending.viewport);
+
+            m_CurrentGraphicsState.viewport = pending.viewport;
+        }
+
+        m_PendingGraphicsState.reset();
+    }
+
+    void CommandList::executeBundles(nvrhi::ICommandList* const* bundles, size_t numBundles)
+    {
+        Framebuffer* framebuffer = nullptr;
+
+        for (size_t i = 0; i < numBundles; i++)
+        {
+            CommandList* bundle = checked_cast<CommandList*>(bundles[i]);
+
+            if (!bundle->m_Instance || !bundle->m_BundleFramebuffer)
+            {
+                m_Context.error("Cannot execute a bundle that was not recorded with any graphics state");
+                return;
+            }
+
+            if (framebuffer && bundle->m_BundleFramebuffer != framebuffer)
+            {
+                m_Context.error("All bundles executed together must be recorded with the same framebuffer");
+                return;
+            }
+
+            framebuffer = bundle->m_BundleFramebuffer;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                bundle->m_BundleStateRequirements.apply(m_StateTracker);
+            }
+        }
+
+        if (!framebuffer)
+            return;
+
+        commitBarriers();
+
+        commitDescriptorHeaps();
+
+        // Bundles inherit the render targets, viewports and the shading rate from the calling command list
+        unbindShadingRateState();
+
+        if (!m_Context.renderPassesEnabled)
+            bindFramebuffer(framebuffer);
+        m_Instance->referencedResources.push_back(framebuffer);
+
+        // The pipelines used by the bundles are not known here, so the render pass allows UAV writes
+        beginRendering(framebuffer, true);
+
+        for (size_t i = 0; i < numBundles; i++)
+        {
+            CommandList* bundle = checked_cast<CommandList*>(bundles[i]);
+
+            if (bundle->m_BundleHeapSRVetc != m_CurrentHeapSRVetc || bundle->m_BundleHeapSamplers != m_CurrentHeapSamplers)
+            {
+                m_Context.error("The shader-visible descriptor heaps have been reallocated since the bundle was recorded, "
+                    "the bundle must be recorded again");
+                continue;
+            }
+
+            const DX12_ViewportState& vpState = bundle->m_BundleViewportState;
+            if (vpState.numViewports)
+                m_ActiveCommandList->commandList->RSSetViewports(vpState.numViewports, vpState.viewports);
+            if (vpState.numScissorRects)
+                m_ActiveCommandList->commandList->RSSetScissorRects(vpState.numScissorRects, vpState.scissorRects);
+
+            m_ActiveCommandList->commandList->ExecuteBundle(bundle->m_ActiveCommandList->commandList);
+            m_Instance->referencedBundles.push_back(bundle->m_Instance);
+        }
+
+        // The pipeline state, topology and root arguments set by the bundles stay set on this command list
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentGraphicsVolatileCBs.resize(0);
+    }
+
     void CommandList::unbindShadingRateState()
     {
         if (m_CurrentGraphicsStateValid && m_CurrentGraphicsState.shadingRateState.enabled)
@@ -517,6 +1016,14 @@ namespace nvrhi::d3d12
             m_CurrentGraphicsState.shadingRateState.enabled = false;
             m_CurrentGraphicsState.framebuffer = nullptr;
         }
+
+        if (m_CurrentMeshletStateValid && m_CurrentMeshletState.shadingRateState.enabled)
+        {
+            m_ActiveCommandList->commandList6->RSSetShadingRateImage(nullptr);
+            m_ActiveCommandList->commandList6->RSSetShadingRate(D3D12_SHADING_RATE_1X1, nullptr);
+            m_CurrentMeshletState.shadingRateState.enabled = false;
+            m_CurrentMeshletState.framebuffer = nullptr;
+        }
     }
 
 
@@ -528,13 +1035,13 @@ namespace nvrhi::d3d12
 
         for (VolatileConstantBufferBinding& parameter : m_CurrentGraphicsVolatileCBs)
         {
-            D3D12_GPU_VIRTUAL_ADDRESS currentGpuVA = m_VolatileConstantBufferAddresses[parameter.buffer];
+            VolatileConstantBufferState* state = getVolatileConstantBufferState(parameter.buffer, false);
 
-            if (currentGpuVA != parameter.address)
+            if (state && state->version != parameter.version)
             {
-                m_ActiveCommandList->commandList->SetGraphicsRootConstantBufferView(parameter.bindingPoint, currentGpuVA);
+                setRootVolatileConstantBuffer(true, parameter.bindingPoint, parameter.numInlineConstants, *state);
 
-                parameter.address = currentGpuVA;
+                parameter.version = state->version;
             }
         }
 
@@ -557,6 +1064,9 @@ namespace nvrhi::d3d12
 
     void CommandList::draw(const DrawArguments& args)
     {
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->DrawInstanced(args.vertexCount, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
@@ -564,6 +1074,9 @@ namespace nvrhi::d3d12
 
     void CommandList::drawIndexed(const DrawArguments& args)
     {
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->DrawIndexedInstanced(args.vertexCount, args.instanceCount, args.startIndexLocation, args.startVertexLocation, args.startInstanceLocation);
@@ -574,6 +1087,9 @@ namespace nvrhi::d3d12
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         assert(indirectParams); // validation layer handles this
 
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
@@ -584,10 +1100,43 @@ namespace nvrhi::d3d12
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
         assert(indirectParams);
 
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, drawCount, indirectParams->resource, offsetBytes, nullptr, 0);
     }
+
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && indirectCount); // validation layer handles this
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndirectSignature, maxDrawCount, indirectParams->resource, paramOffsetBytes,
+            indirectCount->resource, countOffsetBytes);
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && indirectCount);
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.drawIndexedIndirectSignature, maxDrawCount, indirectParams->resource, paramOffsetBytes,
+            indirectCount->resource, countOffsetBytes);
+    }
     
     DX12_ViewportState convertViewportState(const RasterState& rasterState, const FramebufferInfoEx& framebufferInfo, const ViewportState& vpState)
     {
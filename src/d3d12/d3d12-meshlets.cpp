@@ -145,6 +145,29 @@ namespace nvrhi::d3d12
         streamDesc.pPipelineStateSubobjectStream = &psoDesc;
         streamDesc.SizeInBytes = sizeof(psoDesc);
 
+        uint64_t libraryKey = 0;
+        if (m_PipelineLibrary)
+        {
+            StableHasher hasher;
+            hasher.add(pRS->serializedHash);
+            hasher.add(psoDesc.PrimitiveTopologyType);
+            hasher.addShader(psoDesc.AmplificationShader);
+            hasher.addShader(psoDesc.MeshShader);
+            hasher.addShader(psoDesc.PixelShader);
+            hasher.addRasterizerDesc(psoDesc.RasterizerState);
+            hasher.addDepthStencilDesc(psoDesc.DepthStencilState);
+            hasher.addBlendDesc(psoDesc.BlendState);
+            hasher.add(psoDesc.SampleDesc);
+            hasher.add(psoDesc.SampleMask);
+            hasher.add(psoDesc.RenderTargets);
+            hasher.add(psoDesc.DSVFormat);
+            libraryKey = hasher.get();
+
+            pipelineState = m_PipelineLibrary->loadPipeline(libraryKey, streamDesc);
+            if (pipelineState)
+                return pipelineState;
+        }
+
         HRESULT hr = m_Context.device2->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&pipelineState));
         if (FAILED(hr))
         {
@@ -152,6 +175,9 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        if (m_PipelineLibrary)
+            m_PipelineLibrary->storePipeline(libraryKey, pipelineState);
+
         return pipelineState;
     }
 
@@ -186,6 +212,7 @@ namespace nvrhi::d3d12
         pso->rootSignature = checked_cast<RootSignature*>(rootSignature);
         pso->pipelineState = pipelineState;
         pso->requiresBlendFactor = desc.renderState.blendState.usesConstantColor(uint32_t(pso->framebufferInfo.colorFormats.size()));
+        pso->pixelShaderHasUAVs = desc.PS && pixelShaderMayWriteUAVs(desc.bindingLayouts);
 
         return MeshletPipelineHandle::Create(pso);
     }
@@ -221,7 +248,8 @@ namespace nvrhi::d3d12
         MeshletPipeline* pso = checked_cast<MeshletPipeline*>(state.pipeline);
         Framebuffer* framebuffer = checked_cast<Framebuffer*>(state.framebuffer);
 
-        unbindShadingRateState();
+        if (m_CurrentGraphicsStateValid)
+            unbindShadingRateState();
 
         const bool updateFramebuffer = !m_CurrentMeshletStateValid || m_CurrentMeshletState.framebuffer != state.framebuffer;
         const bool updateRootSignature = !m_CurrentMeshletStateValid || m_CurrentMeshletState.pipeline == nullptr ||
@@ -240,6 +268,8 @@ namespace nvrhi::d3d12
             ? state.dynamicStencilRefValue
             : pso->desc.renderState.depthStencilState.stencilRefValue;
         const bool updateStencilRef = !m_CurrentMeshletStateValid || m_CurrentMeshletState.dynamicStencilRefValue != effectiveStencilRefValue;
+
+        const bool updateShadingRate = !m_CurrentMeshletStateValid || m_CurrentMeshletState.shadingRateState != state.shadingRateState;
         
         uint32_t bindingUpdateMask = 0;
         if (!m_CurrentMeshletStateValid || updateRootSignature)
@@ -269,7 +299,8 @@ namespace nvrhi::d3d12
 
         if (updateFramebuffer)
         {
-            bindFramebuffer(framebuffer);
+            if (!m_Context.renderPassesEnabled)
+                bindFramebuffer(framebuffer);
             m_Instance->referencedResources.push_back(framebuffer);
         }
 
@@ -279,9 +310,57 @@ namespace nvrhi::d3d12
         }
         
         setGraphicsBindings(state.bindings, bindingUpdateMask, state.indirectParams, updateIndirectParams, pso->rootSignature);
+
+        if (state.indirectCountBuffer && (!m_CurrentMeshletStateValid || m_CurrentMeshletState.indirectCountBuffer != state.indirectCountBuffer))
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+            m_Instance->referencedResources.push_back(state.indirectCountBuffer);
+        }
+
+        if (updateShadingRate || updateFramebuffer)
+        {
+            const auto& framebufferDesc = framebuffer->getDesc();
+            bool shouldEnableVariableRateShading = framebufferDesc.shadingRateAttachment.valid() && state.shadingRateState.enabled;
+            bool variableRateShadingCurrentlyEnabled = m_CurrentMeshletStateValid && m_CurrentMeshletState.shadingRateState.enabled
+                && m_CurrentMeshletState.framebuffer->getDesc().shadingRateAttachment.valid();
+
+            if (shouldEnableVariableRateShading)
+            {
+                Texture* texture = checked_cast<Texture*>(framebufferDesc.shadingRateAttachment.texture);
+                m_ActiveCommandList->commandList6->RSSetShadingRateImage(texture->resource);
+            }
+            else if (variableRateShadingCurrentlyEnabled)
+            {
+                m_ActiveCommandList->commandList6->RSSetShadingRateImage(nullptr);
+            }
+        }
+
+        if (updateShadingRate)
+        {
+            if (state.shadingRateState.enabled)
+            {
+                // combiners[0] applies the per-primitive rates written by the mesh shader
+                D3D12_SHADING_RATE_COMBINER combiners[D3D12_RS_SET_SHADING_RATE_COMBINER_COUNT];
+                combiners[0] = convertShadingRateCombiner(state.shadingRateState.pipelinePrimitiveCombiner);
+                combiners[1] = convertShadingRateCombiner(state.shadingRateState.imageCombiner);
+                m_ActiveCommandList->commandList6->RSSetShadingRate(convertPixelShadingRate(state.shadingRateState.shadingRate), combiners);
+            }
+            else if (m_CurrentMeshletStateValid && m_CurrentMeshletState.shadingRateState.enabled)
+            {
+                m_ActiveCommandList->commandList6->RSSetShadingRate(D3D12_SHADING_RATE_1X1, nullptr);
+            }
+        }
         
         commitBarriers();
 
+        if (framebuffer)
+        {
+            beginRendering(framebuffer, pso->pixelShaderHasUAVs);
+        }
+
         if (updateViewports)
         {
             DX12_ViewportState vpState = convertViewportState(pso->desc.renderState.rasterState, framebuffer->framebufferInfo, state.viewport);
@@ -314,4 +393,26 @@ namespace nvrhi::d3d12
 
         m_ActiveCommandList->commandList6->DispatchMesh(groupsX, groupsY, groupsZ);
     }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams); // validation layer handles this
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchMeshIndirectSignature, dispatchCount, indirectParams->resource, offsetBytes, nullptr, 0);
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(indirectParams && indirectCount);
+
+        updateGraphicsVolatileBuffers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_Context.dispatchMeshIndirectSignature, maxDispatchCount, indirectParams->resource, paramOffsetBytes,
+            indirectCount->resource, countOffsetBytes);
+    }
 } // namespace nvrhi::d3d12
@@ -0,0 +1,242 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <sstream>
+#include <iomanip>
+
+namespace nvrhi::d3d12
+{
+    void StableHasher::addBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            m_Hash ^= bytes[i];
+            m_Hash *= 0x100000001b3ull;
+        }
+    }
+
+    void StableHasher::addShader(const D3D12_SHADER_BYTECODE& bytecode)
+    {
+        add(uint64_t(bytecode.BytecodeLength));
+        if (bytecode.pShaderBytecode)
+            addBytes(bytecode.pShaderBytecode, bytecode.BytecodeLength);
+    }
+
+    // The blend and depth-stencil descs have padding, so hash them field by field
+
+    void StableHasher::addBlendDesc(const D3D12_BLEND_DESC& desc)
+    {
+        add(desc.AlphaToCoverageEnable);
+        add(desc.IndependentBlendEnable);
+        for (const D3D12_RENDER_TARGET_BLEND_DESC& target : desc.RenderTarget)
+        {
+            add(target.BlendEnable);
+            add(target.LogicOpEnable);
+            add(target.SrcBlend);
+            add(target.DestBlend);
+            add(target.BlendOp);
+            add(target.SrcBlendAlpha);
+            add(target.DestBlendAlpha);
+            add(target.BlendOpAlpha);
+            add(target.LogicOp);
+            add(target.RenderTargetWriteMask);
+        }
+    }
+
+    void StableHasher::addDepthStencilDesc(const D3D12_DEPTH_STENCIL_DESC& desc)
+    {
+        add(desc.DepthEnable);
+        add(desc.DepthWriteMask);
+        add(desc.DepthFunc);
+        add(desc.StencilEnable);
+        add(desc.StencilReadMask);
+        add(desc.StencilWriteMask);
+        add(desc.FrontFace);
+        add(desc.BackFace);
+    }
+
+    void StableHasher::addRasterizerDesc(const D3D12_RASTERIZER_DESC& desc)
+    {
+        add(desc.FillMode);
+        add(desc.CullMode);
+        add(desc.FrontCounterClockwise);
+        add(desc.DepthBias);
+        add(desc.DepthBiasClamp);
+        add(desc.SlopeScaledDepthBias);
+        add(desc.DepthClipEnable);
+        add(desc.MultisampleEnable);
+        add(desc.AntialiasedLineEnable);
+        add(desc.ForcedSampleCount);
+        add(desc.ConservativeRaster);
+    }
+
+    bool PipelineLibrary::initialize(const void* initialData, size_t initialDataSize)
+    {
+        RefCountPtr<ID3D12Device1> device1;
+        if (FAILED(m_Context.device->QueryInterface(&device1)))
+        {
+            m_Context.error("Pipeline libraries require ID3D12Device1");
+            return false;
+        }
+
+        if (initialData && initialDataSize)
+        {
+            m_InitialData.assign(static_cast<const uint8_t*>(initialData), static_cast<const uint8_t*>(initialData) + initialDataSize);
+
+            const HRESULT hr = device1->CreatePipelineLibrary(m_InitialData.data(), m_InitialData.size(), IID_PPV_ARGS(&m_Library));
+            if (SUCCEEDED(hr))
+                return true;
+
+            if (hr == D3D12_ERROR_ADAPTER_NOT_FOUND || hr == D3D12_ERROR_DRIVER_VERSION_MISMATCH || hr == E_INVALIDARG)
+            {
+                m_Context.warning("The initial pipeline cache data was created for a different adapter or driver and is ignored");
+            }
+            else
+            {
+                std::stringstream ss;
+                ss << "CreatePipelineLibrary call failed, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+                m_Context.error(ss.str());
+            }
+
+            m_InitialData.clear();
+            m_Library = nullptr;
+        }
+
+        const HRESULT hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_Library));
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "CreatePipelineLibrary call failed, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    std::wstring PipelineLibrary::getEntryName(uint64_t key)
+    {
+        std::wstringstream ss;
+        ss << L"nvrhi_" << std::hex << std::setw(16) << std::setfill(L'0') << key;
+        return ss.str();
+    }
+
+    RefCountPtr<ID3D12PipelineState> PipelineLibrary::loadGraphicsPipeline(uint64_t key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+    {
+        const std::wstring name = getEntryName(key);
+        RefCountPtr<ID3D12PipelineState> pipelineState;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // A missing entry or a mismatching description both return E_INVALIDARG, which is not an error here
+        if (FAILED(m_Library->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+            return nullptr;
+
+        return pipelineState;
+    }
+
+    RefCountPtr<ID3D12PipelineState> PipelineLibrary::loadComputePipeline(uint64_t key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+    {
+        const std::wstring name = getEntryName(key);
+        RefCountPtr<ID3D12PipelineState> pipelineState;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (FAILED(m_Library->LoadComputePipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+            return nullptr;
+
+        return pipelineState;
+    }
+
+    RefCountPtr<ID3D12PipelineState> PipelineLibrary::loadPipeline(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+    {
+        const std::wstring name = getEntryName(key);
+        RefCountPtr<ID3D12PipelineState> pipelineState;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        if (FAILED(m_Library->LoadPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+            return nullptr;
+
+        return pipelineState;
+    }
+
+    void PipelineLibrary::storePipeline(uint64_t key, ID3D12PipelineState* pipelineState)
+    {
+        if (!pipelineState)
+            return;
+
+        const std::wstring name = getEntryName(key);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        // Fails with E_INVALIDARG if another thread has stored the same pipeline first, which is fine
+        m_Library->StorePipeline(name.c_str(), pipelineState);
+    }
+
+    bool PipelineLibrary::serialize(std::vector<uint8_t>& outData)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        outData.resize(m_Library->GetSerializedSize());
+
+        const HRESULT hr = m_Library->Serialize(outData.data(), outData.size());
+        if (FAILED(hr))
+        {
+            outData.clear();
+
+            std::stringstream ss;
+            ss << "ID3D12PipelineLibrary::Serialize call failed, HRESULT = 0x" << std::hex << std::setw(8) << hr;
+            m_Context.error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Device::getPipelineCacheData(std::vector<uint8_t>& outData)
+    {
+        outData.clear();
+
+        if (!m_PipelineLibrary)
+            return false;
+
+        return m_PipelineLibrary->serialize(outData);
+    }
+
+    bool Device::mergePipelineCacheData(const void* data, size_t size)
+    {
+        (void)data;
+        (void)size;
+
+        // Pipeline libraries cannot enumerate or import entries, so there is nothing to merge into
+        m_Context.warning("Merging pipeline cache data is not supported on DX12, "
+            "pass the blob through DeviceDesc::initialPipelineCacheData instead");
+        return false;
+    }
+
+} // namespace nvrhi::d3d12
@@ -0,0 +1,393 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "d3d12-backend.h"
+
+#include <nvrhi/common/misc.h>
+#include <sstream>
+
+namespace nvrhi::d3d12
+{
+    struct PlacedResourceHeap
+    {
+        RefCountPtr<ID3D12Heap> heap;
+        D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_DEFAULT;
+        bool forTextures = false;
+        TlsfAllocator allocator;
+
+        explicit PlacedResourceHeap(uint64_t size)
+            : allocator(size)
+        { }
+    };
+
+    void PlacedResourceAllocator::initialize(uint64_t heapSize, D3D12_RESOURCE_HEAP_TIER heapTier)
+    {
+        m_HeapSize = align(heapSize, uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+        m_HeapTier = heapTier;
+    }
+
+    bool PlacedResourceAllocator::canPlaceResource(D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_ALLOCATION_INFO& outAllocationInfo) const
+    {
+        if (!isEnabled())
+            return false;
+
+        // Placed render targets and depth-stencil surfaces must be initialized with a clear, copy or discard
+        // before use, which existing code doesn't do. They also tend to be large, so keep them committed.
+        constexpr D3D12_RESOURCE_FLAGS excludedFlags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET
+            | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL
+            | D3D12_RESOURCE_FLAG_ALLOW_CROSS_ADAPTER;
+
+        if ((resourceDesc.Flags & excludedFlags) != 0)
+            return false;
+
+        if (resourceDesc.SampleDesc.Count > 1)
+            return false;
+
+        resourceDesc.Alignment = 0;
+
+        // Small textures can use 4 KB alignment instead of 64 KB, if the driver agrees.
+        // Buffers always require D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT: the small alignment is only defined for
+        // textures, and GetResourceAllocationInfo rejects a buffer desc with any other alignment. Placing them still
+        // saves the implicit heap that every committed resource gets, but sub-64 KB buffers don't pack any tighter.
+        if (resourceDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            resourceDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+            outAllocationInfo = m_Context.device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+            if (outAllocationInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+                resourceDesc.Alignment = 0;
+        }
+
+        if (resourceDesc.Alignment == 0)
+            outAllocationInfo = m_Context.device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+        if (outAllocationInfo.SizeInBytes == UINT64_MAX)
+            return false;
+
+        // Large resources would waste too much of a heap
+        return outAllocationInfo.SizeInBytes <= m_HeapSize / 2;
+    }
+
+    PlacedResourceHeap* PlacedResourceAllocator::createHeap(D3D12_HEAP_TYPE heapType, bool forTextures)
+    {
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes = m_HeapSize;
+        heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        heapDesc.Properties.Type = heapType;
+        heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+        heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+        heapDesc.Properties.CreationNodeMask = 1; // no mGPU support in nvrhi so far
+        heapDesc.Properties.VisibleNodeMask = 1;
+
+        if (m_HeapTier == D3D12_RESOURCE_HEAP_TIER_1)
+            heapDesc.Flags = forTextures ? D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        else
+            heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+
+        auto heap = std::make_unique<PlacedResourceHeap>(m_HeapSize);
+        heap->heapType = heapType;
+        heap->forTextures = forTextures;
+
+        const HRESULT res = m_Context.device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap->heap));
+        if (FAILED(res))
+            return nullptr;
+
+        std::wstringstream wss;
+        wss << L"Placed Resource Heap " << m_Heaps.size();
+        heap->heap->SetName(wss.str().c_str());
+
+        if (heapType == D3D12_HEAP_TYPE_DEFAULT)
+            m_Residency.addAllocation(getResidencyKey(heap->heap), m_HeapSize);
+
+        m_Statistics.heapCount++;
+        m_Statistics.heapBytes += m_HeapSize;
+
+        m_Heaps.push_back(std::move(heap));
+        return m_Heaps.back().get();
+    }
+
+    bool PlacedResourceAllocator::allocate(D3D12_HEAP_TYPE heapType, bool isTexture, const D3D12_RESOURCE_ALLOCATION_INFO& allocationInfo,
+        PlacedResourceAllocation& outAllocation, ID3D12Heap** outHeap, uint64_t* outOffset)
+    {
+        // On tier 2 hardware, buffers and textures can share heaps
+        const bool forTextures = isTexture && m_HeapTier == D3D12_RESOURCE_HEAP_TIER_1;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        PlacedResourceHeap* heap = nullptr;
+        TlsfAllocator::Allocation suballocation;
+
+        for (const auto& candidate : m_Heaps)
+        {
+            if (candidate->heapType != heapType || candidate->forTextures != forTextures)
+                continue;
+
+            suballocation = candidate->allocator.allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+            if (suballocation.isValid())
+            {
+                heap = candidate.get();
+                break;
+            }
+        }
+
+        if (!heap)
+        {
+            heap = createHeap(heapType, forTextures);
+            if (!heap)
+                return false;
+
+            suballocation = heap->allocator.allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+            if (!suballocation.isValid())
+                return false;
+        }
+
+        m_Statistics.resourceCount++;
+        m_Statistics.resourceBytes += suballocation.size;
+        m_Statistics.peakResourceBytes = std::max(m_Statistics.peakResourceBytes, m_Statistics.resourceBytes);
+
+        outAllocation.heap = heap;
+        outAllocation.suballocation = suballocation;
+        *outHeap = heap->heap;
+        *outOffset = suballocation.offset;
+
+        return true;
+    }
+
+    void PlacedResourceAllocator::release(PlacedResourceAllocation& allocation)
+    {
+        if (!allocation.isValid())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        PlacedResourceHeap* heap = allocation.heap;
+        heap->allocator.release(allocation.suballocation);
+
+        m_Statistics.resourceCount--;
+        m_Statistics.resourceBytes -= allocation.suballocation.size;
+
+        // Keep one empty heap of each kind around to avoid recreating it over and over
+        if (heap->allocator.isEmpty())
+        {
+            for (size_t index = 0; index < m_Heaps.size(); index++)
+            {
+                const PlacedResourceHeap* other = m_Heaps[index].get();
+                if (other != heap && other->heapType == heap->heapType &&
+                    other->forTextures == heap->forTextures && other->allocator.isEmpty())
+                {
+                    m_Statistics.heapCount--;
+                    m_Statistics.heapBytes -= other->allocator.getSize();
+                    m_Residency.removeAllocation(getResidencyKey(other->heap));
+                    m_Heaps.erase(m_Heaps.begin() + ptrdiff_t(index));
+                    break;
+                }
+            }
+        }
+
+        allocation = PlacedResourceAllocation();
+    }
+
+    PlacedResourceStatistics PlacedResourceAllocator::getStatistics()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Statistics;
+    }
+
+    struct SmallBufferBlock
+    {
+        BufferHandle buffer;
+        uint64_t slotSize = 0;
+        ResourceStates initialState = ResourceStates::Unknown;
+        bool keepInitialState = false;
+        std::vector<uint32_t> freeSlots;
+
+        [[nodiscard]] uint32_t getSlotCount() const { return uint32_t(SmallBufferAllocator::c_BlockSize / slotSize); }
+        [[nodiscard]] bool isEmpty() const { return freeSlots.size() == getSlotCount(); }
+        [[nodiscard]] bool matches(uint64_t size, ResourceStates state, bool keepState) const
+        {
+            return slotSize == size && initialState == state && keepInitialState == keepState;
+        }
+    };
+
+    SmallBufferAllocator::~SmallBufferAllocator() = default;
+
+    static bool isPowerOf2(uint64_t value)
+    {
+        return value != 0 && (value & (value - 1)) == 0;
+    }
+
+    static uint64_t getSmallBufferSlotSize(uint64_t byteSize)
+    {
+        uint64_t slotSize = SmallBufferAllocator::c_MinSlotSize;
+        while (slotSize < byteSize)
+            slotSize *= 2;
+        return slotSize;
+    }
+
+    bool SmallBufferAllocator::canPackBuffer(const BufferDesc& desc)
+    {
+        if (desc.byteSize == 0 || desc.byteSize > c_MaxSlotSize)
+            return false;
+
+        if (desc.cpuAccess != CpuAccessMode::None || desc.isVolatile || desc.isVirtual || desc.isTiled ||
+            desc.sharedResourceFlags != SharedResourceFlags::None)
+            return false;
+
+        // UAVs tend to be written in place and need UAV barriers that would apply to the whole block,
+        // and the other kinds are used at offsets in their resource that don't account for the slot offset
+        if (desc.canHaveUAVs || desc.isAccelStructStorage || desc.isShaderBindingTable || desc.isDrawIndirectArgs)
+            return false;
+
+        if ((desc.initialState & (ResourceStates::AccelStructRead | ResourceStates::AccelStructWrite |
+            ResourceStates::AccelStructBuildBlas | ResourceStates::OpacityMicromapWrite |
+            ResourceStates::OpacityMicromapBuildInput)) != 0)
+            return false;
+
+        // Slot offsets are multiples of the slot size, which is a power of 2, so the view FirstElement
+        // can be computed for power-of-2 element sizes only
+        if (desc.structStride != 0 && !isPowerOf2(desc.structStride))
+            return false;
+
+        if (desc.canHaveTypedViews && desc.format != Format::UNKNOWN &&
+            !isPowerOf2(getFormatInfo(desc.format).bytesPerBlock))
+            return false;
+
+        return true;
+    }
+
+    bool SmallBufferAllocator::allocate(const BufferDesc& desc, SmallBufferAllocation& outAllocation, Buffer*& outBlockBuffer, uint64_t& outOffset)
+    {
+        if (!isEnabled() || !canPackBuffer(desc))
+            return false;
+
+        const uint64_t slotSize = getSmallBufferSlotSize(desc.byteSize);
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        SmallBufferBlock* block = nullptr;
+        for (const auto& candidate : m_Blocks)
+        {
+            if (candidate->matches(slotSize, desc.initialState, desc.keepInitialState) && !candidate->freeSlots.empty())
+            {
+                block = candidate.get();
+                break;
+            }
+        }
+
+        if (!block)
+        {
+            BufferDesc blockDesc;
+            blockDesc.byteSize = c_BlockSize;
+            blockDesc.canHaveTypedViews = true;
+            blockDesc.canHaveRawViews = true;
+            blockDesc.initialState = desc.initialState;
+            blockDesc.keepInitialState = desc.keepInitialState;
+            blockDesc.debugName = "SmallBufferBlock";
+
+            BufferHandle blockBuffer = m_Device->createBuffer(blockDesc);
+            if (!blockBuffer)
+                return false;
+
+            auto newBlock = std::make_unique<SmallBufferBlock>();
+            newBlock->buffer = blockBuffer;
+            newBlock->slotSize = slotSize;
+            newBlock->initialState = desc.initialState;
+            newBlock->keepInitialState = desc.keepInitialState;
+
+            // Hand out the slots from the start of the block
+            const uint32_t slotCount = newBlock->getSlotCount();
+            newBlock->freeSlots.reserve(slotCount);
+            for (uint32_t slot = slotCount; slot > 0; slot--)
+                newBlock->freeSlots.push_back(slot - 1);
+
+            block = newBlock.get();
+            m_Blocks.push_back(std::move(newBlock));
+        }
+
+        const uint32_t slot = block->freeSlots.back();
+        block->freeSlots.pop_back();
+
+        m_NumBuffers++;
+        m_BufferBytes += slotSize;
+
+        outAllocation.block = block;
+        outAllocation.slot = slot;
+        outBlockBuffer = checked_cast<Buffer*>(block->buffer.Get());
+        outOffset = uint64_t(slot) * slotSize;
+        return true;
+    }
+
+    void SmallBufferAllocator::release(SmallBufferAllocation& allocation)
+    {
+        if (!allocation.isValid())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        SmallBufferBlock* block = allocation.block;
+        block->freeSlots.push_back(allocation.slot);
+
+        m_NumBuffers--;
+        m_BufferBytes -= block->slotSize;
+
+        // Keep one empty block of each kind around, like PlacedResourceAllocator does with heaps.
+        // The buffers packed into a block reference its buffer, so dropping it here is safe while they're in flight.
+        if (block->isEmpty())
+        {
+            for (size_t index = 0; index < m_Blocks.size(); index++)
+            {
+                const SmallBufferBlock* other = m_Blocks[index].get();
+                if (other != block && other->isEmpty() &&
+                    other->matches(block->slotSize, block->initialState, block->keepInitialState))
+                {
+                    m_Blocks.erase(m_Blocks.begin() + ptrdiff_t(index));
+                    break;
+                }
+            }
+        }
+
+        allocation = SmallBufferAllocation();
+    }
+
+    void SmallBufferAllocator::releaseBlocks()
+    {
+        std::vector<std::unique_ptr<SmallBufferBlock>> blocks;
+        {
+            std::lock_guard lockGuard(m_Mutex);
+            blocks = std::move(m_Blocks);
+            m_Blocks.clear();
+        }
+    }
+
+    void SmallBufferAllocator::getStatistics(PlacedResourceStatistics& statistics)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        statistics.packedBlockCount = uint32_t(m_Blocks.size());
+        statistics.packedBlockBytes = uint64_t(m_Blocks.size()) * c_BlockSize;
+        statistics.packedBufferCount = m_NumBuffers;
+        statistics.packedBufferBytes = m_BufferBytes;
+    }
+
+} // namespace nvrhi::d3d12
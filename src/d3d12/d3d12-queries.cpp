@@ -219,5 +219,514 @@ namespace nvrhi::d3d12
             query->beginQueryIndex * 8);
     }
 
+    OcclusionQuery::~OcclusionQuery()
+    {
+        m_Resources.occlusionQueries.release(static_cast<int>(queryIndex));
+    }
+
+    PipelineStatisticsQuery::~PipelineStatisticsQuery()
+    {
+        m_Resources.pipelineStatisticsQueries.release(static_cast<int>(queryIndex));
+    }
+
+    OcclusionQueryHandle Device::createOcclusionQuery(OcclusionQueryType type)
+    {
+        if (!m_Context.occlusionQueryHeap)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (!m_Context.occlusionQueryHeap)
+            {
+                // both the sample count and binary queries live in the same heap
+                D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+                queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_OCCLUSION;
+                queryHeapDesc.Count = uint32_t(m_Resources.occlusionQueries.getCapacity());
+                m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_Context.occlusionQueryHeap));
+
+                BufferDesc qbDesc;
+                qbDesc.byteSize = queryHeapDesc.Count * 8;
+                qbDesc.cpuAccess = CpuAccessMode::Read;
+
+                BufferHandle resolveBuffer = createBuffer(qbDesc);
+                m_Context.occlusionQueryResolveBuffer = checked_cast<Buffer*>(resolveBuffer.Get());
+
+                BufferDesc pbDesc;
+                pbDesc.byteSize = queryHeapDesc.Count * 8;
+
+                BufferHandle predicationBuffer = createBuffer(pbDesc);
+                m_Context.predicationBuffer = checked_cast<Buffer*>(predicationBuffer.Get());
+            }
+        }
+
+        int queryIndex = m_Resources.occlusionQueries.allocate();
+
+        if (queryIndex < 0)
+            return nullptr;
+
+        OcclusionQuery* query = new OcclusionQuery(m_Resources);
+        query->type = type;
+        query->queryIndex = uint32_t(queryIndex);
+
+        return OcclusionQueryHandle::Create(query);
+    }
+
+    bool Device::pollOcclusionQuery(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        if (!query->started)
+            return false;
+
+        if (!query->fence)
+            return true;
+
+        if (query->fence->GetCompletedValue() >= query->fenceCounter)
+        {
+            query->fence = nullptr;
+            return true;
+        }
+
+        return false;
+    }
+
+    uint64_t Device::getOcclusionQueryResult(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        if (!query->started)
+            return 0;
+
+        if (!query->resolved)
+        {
+            if (query->fence)
+            {
+                WaitForFence(query->fence, query->fenceCounter, m_FenceEvent);
+                query->fence = nullptr;
+            }
+
+            D3D12_RANGE bufferReadRange = {
+                query->queryIndex * sizeof(uint64_t),
+                (query->queryIndex + 1) * sizeof(uint64_t) };
+            uint64_t* data;
+            const HRESULT res = m_Context.occlusionQueryResolveBuffer->resource->Map(0, &bufferReadRange, (void**)&data);
+
+            if (FAILED(res))
+            {
+                m_Context.error("getOcclusionQueryResult: Map() failed");
+                return 0;
+            }
+
+            query->resolved = true;
+            query->result = data[query->queryIndex];
+
+            m_Context.occlusionQueryResolveBuffer->resource->Unmap(0, nullptr);
+        }
+
+        return query->result;
+    }
+
+    void Device::resetOcclusionQuery(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        query->started = false;
+        query->resolved = false;
+        query->result = 0;
+        query->fence = nullptr;
+    }
+
+    PipelineStatisticsQueryHandle Device::createPipelineStatisticsQuery()
+    {
+        if (!m_Context.pipelineStatisticsQueryHeap)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (!m_Context.pipelineStatisticsQueryHeap)
+            {
+                D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+                queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS;
+                queryHeapDesc.Count = uint32_t(m_Resources.pipelineStatisticsQueries.getCapacity());
+                m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_Context.pipelineStatisticsQueryHeap));
+
+                BufferDesc qbDesc;
+                qbDesc.byteSize = queryHeapDesc.Count * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS);
+                qbDesc.cpuAccess = CpuAccessMode::Read;
+
+                BufferHandle resolveBuffer = createBuffer(qbDesc);
+                m_Context.pipelineStatisticsQueryResolveBuffer = checked_cast<Buffer*>(resolveBuffer.Get());
+            }
+        }
+
+        int queryIndex = m_Resources.pipelineStatisticsQueries.allocate();
+
+        if (queryIndex < 0)
+            return nullptr;
+
+        PipelineStatisticsQuery* query = new PipelineStatisticsQuery(m_Resources);
+        query->queryIndex = uint32_t(queryIndex);
+
+        return PipelineStatisticsQueryHandle::Create(query);
+    }
+
+    bool Device::pollPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        if (!query->started)
+            return false;
+
+        if (!query->fence)
+            return true;
+
+        if (query->fence->GetCompletedValue() >= query->fenceCounter)
+        {
+            query->fence = nullptr;
+            return true;
+        }
+
+        return false;
+    }
+
+    PipelineStatistics Device::getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        if (!query->started)
+            return PipelineStatistics();
+
+        if (!query->resolved)
+        {
+            if (query->fence)
+            {
+                WaitForFence(query->fence, query->fenceCounter, m_FenceEvent);
+                query->fence = nullptr;
+            }
+
+            D3D12_RANGE bufferReadRange = {
+                query->queryIndex * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS),
+                (query->queryIndex + 1) * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS) };
+            D3D12_QUERY_DATA_PIPELINE_STATISTICS* data;
+            const HRESULT res = m_Context.pipelineStatisticsQueryResolveBuffer->resource->Map(0, &bufferReadRange, (void**)&data);
+
+            if (FAILED(res))
+            {
+                m_Context.error("getPipelineStatisticsQueryResult: Map() failed");
+                return PipelineStatistics();
+            }
+
+            static_assert(sizeof(PipelineStatistics) == sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS));
+            memcpy(&query->result, &data[query->queryIndex], sizeof(PipelineStatistics));
+            query->resolved = true;
+
+            m_Context.pipelineStatisticsQueryResolveBuffer->resource->Unmap(0, nullptr);
+        }
+
+        return query->result;
+    }
+
+    void Device::resetPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        query->started = false;
+        query->resolved = false;
+        query->result = PipelineStatistics();
+        query->fence = nullptr;
+    }
+
+    void CommandList::beginOcclusionQuery(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        m_Instance->referencedOcclusionQueries.push_back(query);
+
+        m_ActiveCommandList->commandList->BeginQuery(m_Context.occlusionQueryHeap, query->getQueryType(), query->queryIndex);
+    }
+
+    void CommandList::endOcclusionQuery(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        m_Instance->referencedOcclusionQueries.push_back(query);
+
+        m_ActiveCommandList->commandList->EndQuery(m_Context.occlusionQueryHeap, query->getQueryType(), query->queryIndex);
+
+        m_ActiveCommandList->commandList->ResolveQueryData(m_Context.occlusionQueryHeap,
+            query->getQueryType(),
+            query->queryIndex,
+            1,
+            m_Context.occlusionQueryResolveBuffer->resource,
+            query->queryIndex * 8);
+    }
+
+    void CommandList::setPredication(IOcclusionQuery* _query, PredicationOp op)
+    {
+        endRenderPass();
+
+        // the predication buffer cannot be transitioned while it's in use
+        if (m_PredicationEnabled)
+        {
+            m_ActiveCommandList->commandList->SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+            m_PredicationEnabled = false;
+        }
+
+        if (!_query)
+            return;
+
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        // The predication buffer bypasses the state tracker: it's only used here, and buffers decay to COMMON
+        // at the end of every command list, from where the resolve promotes it to COPY_DEST.
+        ID3D12Resource* predicationBuffer = m_Context.predicationBuffer->resource;
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource = predicationBuffer;
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+        if (m_PredicationBufferInPredicationState)
+        {
+            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PREDICATION;
+            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+            m_ActiveCommandList->commandList->ResourceBarrier(1, &barrier);
+        }
+
+        m_ActiveCommandList->commandList->ResolveQueryData(m_Context.occlusionQueryHeap,
+            query->getQueryType(),
+            query->queryIndex,
+            1,
+            predicationBuffer,
+            query->queryIndex * 8);
+
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PREDICATION;
+        m_ActiveCommandList->commandList->ResourceBarrier(1, &barrier);
+        m_PredicationBufferInPredicationState = true;
+
+        m_ActiveCommandList->commandList->SetPredication(predicationBuffer, query->queryIndex * 8,
+            (op == PredicationOp::SkipIfZero) ? D3D12_PREDICATION_OP_EQUAL_ZERO : D3D12_PREDICATION_OP_NOT_EQUAL_ZERO);
+        m_PredicationEnabled = true;
+    }
+
+    void CommandList::beginPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        m_Instance->referencedPipelineStatisticsQueries.push_back(query);
+
+        m_ActiveCommandList->commandList->BeginQuery(m_Context.pipelineStatisticsQueryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS, query->queryIndex);
+    }
+
+    void CommandList::endPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        m_Instance->referencedPipelineStatisticsQueries.push_back(query);
+
+        m_ActiveCommandList->commandList->EndQuery(m_Context.pipelineStatisticsQueryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS, query->queryIndex);
+
+        m_ActiveCommandList->commandList->ResolveQueryData(m_Context.pipelineStatisticsQueryHeap,
+            D3D12_QUERY_TYPE_PIPELINE_STATISTICS,
+            query->queryIndex,
+            1,
+            m_Context.pipelineStatisticsQueryResolveBuffer->resource,
+            query->queryIndex * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS));
+    }
+
+    TimerQueryPool::~TimerQueryPool()
+    {
+        if (resolveData)
+        {
+            resolveBuffer->resource->Unmap(0, nullptr);
+            resolveData = nullptr;
+        }
+    }
+
+    Object TimerQueryPool::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::D3D12_QueryHeap:
+            return Object(heap.Get());
+        default:
+            return nullptr;
+        }
+    }
+
+    TimerQueryPoolHandle Device::createTimerQueryPool(const TimerQueryPoolDesc& desc)
+    {
+        const uint32_t numQueries = desc.maxQueriesPerFrame * desc.maxFramesInFlight * 2; // 2 timestamps per query
+
+        Queue* queue = getQueue(desc.queue);
+        if (!queue)
+        {
+            m_Context.error("Cannot create a timer query pool for a queue that doesn't exist");
+            return nullptr;
+        }
+
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = (desc.queue == CommandQueue::Copy) ? D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP : D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = numQueries;
+
+        RefCountPtr<ID3D12QueryHeap> heap;
+        HRESULT hr = m_Context.device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&heap));
+        if (FAILED(hr))
+        {
+            m_Context.error("Failed to create a timer query heap");
+            return nullptr;
+        }
+
+        BufferDesc resolveBufferDesc;
+        resolveBufferDesc.byteSize = uint64_t(numQueries) * sizeof(uint64_t);
+        resolveBufferDesc.cpuAccess = CpuAccessMode::Read;
+        resolveBufferDesc.debugName = desc.debugName;
+
+        BufferHandle resolveBuffer = createBuffer(resolveBufferDesc);
+        if (!resolveBuffer)
+            return nullptr;
+
+        TimerQueryPool* pool = new TimerQueryPool();
+        pool->desc = desc;
+        pool->heap = heap;
+        pool->resolveBuffer = checked_cast<Buffer*>(resolveBuffer.Get());
+        pool->frames = std::vector<TimerQueryPool::Frame>(desc.maxFramesInFlight);
+        queue->queue->GetTimestampFrequency(&pool->timestampFrequency);
+
+        if (!desc.debugName.empty())
+        {
+            std::wstring wname(desc.debugName.begin(), desc.debugName.end());
+            heap->SetName(wname.c_str());
+        }
+
+        TimerQueryPoolHandle handle = TimerQueryPoolHandle::Create(pool);
+
+        void* mappedData = nullptr;
+        hr = pool->resolveBuffer->resource->Map(0, nullptr, &mappedData);
+        if (FAILED(hr))
+        {
+            m_Context.error("Failed to map the timer query pool readback buffer");
+            return nullptr;
+        }
+        pool->resolveData = static_cast<const uint64_t*>(mappedData);
+
+        return handle;
+    }
+
+    bool Device::getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries)
+    {
+        std::vector<double> timestamps(numQueries * 2);
+
+        if (!getTimerQueryPoolTimestamps(pool, frameIndex, timestamps.data(), numQueries))
+            return false;
+
+        for (uint32_t index = 0; index < numQueries; index++)
+        {
+            const double begin = timestamps[index * 2];
+            const double end = timestamps[index * 2 + 1];
+            pTimes[index] = (end > begin) ? float(end - begin) : 0.f;
+        }
+
+        return true;
+    }
+
+    bool Device::getTimerQueryPoolTimestamps(ITimerQueryPool* _pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        if (frameIndex == 0)
+            return false;
+
+        std::lock_guard lockGuard(pool->mutex);
+
+        TimerQueryPool::Frame& frame = pool->getFrame(frameIndex);
+
+        if (frame.frameIndex != frameIndex || !frame.fence)
+            return false;
+
+        if (frame.fence->GetCompletedValue() < frame.fenceCounter)
+            return false;
+
+        const uint64_t* timestamps = pool->resolveData + pool->getFirstQuery(frameIndex);
+        const double scale = 1.0 / double(pool->timestampFrequency);
+        const uint32_t numResolved = std::min(numQueries, frame.numQueriesUsed.load());
+
+        for (uint32_t index = 0; index < numResolved * 2; index++)
+        {
+            pTimestamps[index] = double(timestamps[index]) * scale;
+        }
+
+        for (uint32_t index = numResolved * 2; index < numQueries * 2; index++)
+        {
+            pTimestamps[index] = 0.0;
+        }
+
+        return true;
+    }
+
+    void CommandList::beginTimerQueryFrame(ITimerQueryPool* _pool)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        std::lock_guard lockGuard(pool->mutex);
+
+        const uint64_t frameIndex = ++pool->currentFrameIndex;
+
+        TimerQueryPool::Frame& frame = pool->getFrame(frameIndex);
+        frame.frameIndex = frameIndex;
+        frame.numQueriesUsed = 0;
+        frame.fence = nullptr;
+        frame.fenceCounter = 0;
+
+        m_Instance->referencedResources.push_back(pool);
+    }
+
+    void CommandList::beginTimerQuery(ITimerQueryPool* _pool, uint32_t queryIndex)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        assert(queryIndex < pool->desc.maxQueriesPerFrame);
+
+        const uint32_t firstQuery = pool->getFirstQuery(pool->currentFrameIndex);
+        m_ActiveCommandList->commandList->EndQuery(pool->heap, D3D12_QUERY_TYPE_TIMESTAMP, firstQuery + queryIndex * 2);
+
+        m_Instance->referencedResources.push_back(pool);
+    }
+
+    void CommandList::endTimerQuery(ITimerQueryPool* _pool, uint32_t queryIndex)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        assert(queryIndex < pool->desc.maxQueriesPerFrame);
+
+        const uint64_t frameIndex = pool->currentFrameIndex;
+        m_ActiveCommandList->commandList->EndQuery(pool->heap, D3D12_QUERY_TYPE_TIMESTAMP, pool->getFirstQuery(frameIndex) + queryIndex * 2 + 1);
+
+        std::atomic<uint32_t>& numQueriesUsed = pool->getFrame(frameIndex).numQueriesUsed;
+        uint32_t used = numQueriesUsed.load();
+        while (used < queryIndex + 1 && !numQueriesUsed.compare_exchange_weak(used, queryIndex + 1))
+            ;
+    }
+
+    void CommandList::resolveTimerQueries(ITimerQueryPool* _pool)
+    {
+        endRenderPass();
+
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        const uint64_t frameIndex = pool->currentFrameIndex;
+        const uint32_t firstQuery = pool->getFirstQuery(frameIndex);
+        const uint32_t numQueriesUsed = pool->getFrame(frameIndex).numQueriesUsed;
+
+        // Resolve all of the frame's queries at once, the readback heap buffer is always in the copy destination state
+        if (numQueriesUsed > 0)
+        {
+            m_ActiveCommandList->commandList->ResolveQueryData(pool->heap, D3D12_QUERY_TYPE_TIMESTAMP,
+                firstQuery, numQueriesUsed * 2, pool->resolveBuffer->resource, uint64_t(firstQuery) * sizeof(uint64_t));
+        }
+
+        m_Instance->resolvedTimerQueryFrames.emplace_back(pool, frameIndex);
+        m_Instance->referencedResources.push_back(pool);
+    }
+
 
 } // namespace nvrhi::d3d12
@@ -281,7 +281,7 @@ namespace nvrhi::d3d12
     {
         if (!pExport)
         {
-            m_Context.error("Couldn't find a DXR PSO export with a given name");
+            m_Context.error("Invalid DXR PSO export ID");
             return false;
         }
 
@@ -306,30 +306,131 @@ namespace nvrhi::d3d12
         return true;
     }
 
+    void ShaderTable::reserveRecords(uint32_t& capacity, size_t count)
+    {
+        if (!m_Desc.isCached || count <= capacity)
+            return;
+
+        // Grow the section geometrically within maxEntries, so that streaming in new entries
+        // doesn't change the layout of the cache every time. If the entries don't fit anyway,
+        // the error is reported when the table is used in setRayTracingState.
+
+        uint32_t const otherRecords = getNumRecords() - capacity;
+        uint32_t const available = (m_Desc.maxEntries > otherRecords) ? m_Desc.maxEntries - otherRecords : 0;
+        capacity = std::max(uint32_t(count), std::min(std::max(capacity * 2, 16u), available));
+        ++layoutVersion;
+    }
+
+    void ShaderTable::markRecordDirty(uint32_t recordIndex)
+    {
+        if (!m_Desc.isCached)
+            return;
+
+        // When most of the table has been modified, uploading it whole is cheaper than patching.
+        if (dirtyRecords.size() >= getNumEntries() / 2)
+        {
+            dirtyRecords.clear();
+            ++layoutVersion;
+            return;
+        }
+
+        dirtyRecords.push_back(recordIndex);
+    }
+
+    bool ShaderTable::resolveExportName(const char* exportName, rt::ShaderExportId& outExportId) const
+    {
+        outExportId = pipeline->getShaderExportId(exportName);
+
+        if (outExportId == rt::ShaderExportId::Invalid)
+        {
+            m_Context.error(std::string("Couldn't find a DXR PSO export with name ") + (exportName ? exportName : "<null>"));
+            return false;
+        }
+
+        return true;
+    }
+
     void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
+        rt::ShaderExportId exportId;
+        if (resolveExportName(exportName, exportId))
+            setRayGenerationShader(exportId, bindings);
+    }
+
+    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addMissShader(exportId, bindings);
+    }
+
+    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addHitGroups(&exportId, bindings ? &bindings : nullptr, 1);
+    }
+
+    int ShaderTable::addHitGroups(const char* const* exportNames, IBindingSet* const* bindings, size_t count)
+    {
+        std::vector<rt::ShaderExportId> exportIds(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!resolveExportName(exportNames[i], exportIds[i]))
+                return -1;
+        }
+
+        return addHitGroups(exportIds.data(), bindings, count);
+    }
+
+    void ShaderTable::setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (resolveExportName(exportName, exportId))
+            setHitGroup(index, exportId, bindings);
+    }
+
+    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addCallableShader(exportId, bindings);
+    }
+
+    void ShaderTable::setRayGenerationShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportId);
 
         if (verifyExport(pipelineExport, bindings))
         {
             rayGenerationShader.pShaderIdentifier = pipelineExport->pShaderIdentifier;
             rayGenerationShader.localBindings = bindings;
 
+            markRecordDirty(0);
             ++version;
         }
     }
 
-    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    int ShaderTable::addMissShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
+        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportId);
 
         if (verifyExport(pipelineExport, bindings))
         {
             Entry entry;
             entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
             entry.localBindings = bindings;
+            reserveRecords(missCapacity, missShaders.size() + 1);
             missShaders.push_back(entry);
 
+            markRecordDirty(getMissShaderBase() + uint32_t(missShaders.size()) - 1);
             ++version;
 
             return int(missShaders.size()) - 1;
@@ -338,36 +439,79 @@ namespace nvrhi::d3d12
         return -1;
     }
 
-    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    int ShaderTable::addHitGroup(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
+        return addHitGroups(&exportId, bindings ? &bindings : nullptr, 1);
+    }
 
-        if (verifyExport(pipelineExport, bindings))
+    int ShaderTable::addHitGroups(const rt::ShaderExportId* exportIds, IBindingSet* const* bindings, size_t count)
+    {
+        if (count == 0)
+            return int(hitGroups.size());
+
+        // Verify all the exports first to add either all or none of them.
+
+        for (size_t i = 0; i < count; ++i)
         {
-            Entry entry;
-            entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
-            entry.localBindings = bindings;
-            hitGroups.push_back(entry);
+            IBindingSet* entryBindings = bindings ? bindings[i] : nullptr;
+            if (!verifyExport(pipeline->getExport(exportIds[i]), entryBindings))
+                return -1;
+        }
 
-            ++version;
+        int const firstIndex = int(hitGroups.size());
 
-            return int(hitGroups.size()) - 1;
+        reserveRecords(hitGroupCapacity, hitGroups.size() + count);
+        hitGroups.resize(hitGroups.size() + count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Entry& entry = hitGroups[firstIndex + i];
+            entry.pShaderIdentifier = pipeline->getExport(exportIds[i])->pShaderIdentifier;
+            entry.localBindings = bindings ? bindings[i] : nullptr;
+
+            markRecordDirty(getHitGroupBase() + uint32_t(firstIndex + i));
         }
 
-        return -1;
+        ++version;
+
+        return firstIndex;
     }
 
-    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    void ShaderTable::setHitGroup(uint32_t index, rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (index >= hitGroups.size())
+        {
+            std::stringstream ss;
+            ss << "Cannot replace hit group " << index << " in a shader table that has " << hitGroups.size() << " hit groups";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportId);
+
+        if (verifyExport(pipelineExport, bindings))
+        {
+            hitGroups[index].pShaderIdentifier = pipelineExport->pShaderIdentifier;
+            hitGroups[index].localBindings = bindings;
+
+            markRecordDirty(getHitGroupBase() + index);
+            ++version;
+        }
+    }
+
+    int ShaderTable::addCallableShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
     {
-        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportName);
+        const RayTracingPipeline::ExportTableEntry* pipelineExport = pipeline->getExport(exportId);
 
         if (verifyExport(pipelineExport, bindings))
         {
             Entry entry;
             entry.pShaderIdentifier = pipelineExport->pShaderIdentifier;
             entry.localBindings = bindings;
+            reserveRecords(callableCapacity, callableShaders.size() + 1);
             callableShaders.push_back(entry);
 
+            markRecordDirty(getCallableShaderBase() + uint32_t(callableShaders.size()) - 1);
             ++version;
 
             return int(callableShaders.size()) - 1;
@@ -376,6 +520,8 @@ namespace nvrhi::d3d12
         return -1;
     }
 
+    // Clearing a section keeps its reservation, so the records added later can be patched into the cache.
+
     void ShaderTable::clearMissShaders()
     {
         missShaders.clear();
@@ -394,15 +540,34 @@ namespace nvrhi::d3d12
         ++version;
     }
 
-    const RayTracingPipeline::ExportTableEntry* RayTracingPipeline::getExport(const char* name)
+    const RayTracingPipeline::ExportTableEntry* RayTracingPipeline::getExport(rt::ShaderExportId exportId) const
     {
-        const auto exportEntryIt = exports.find(name);
-        if (exportEntryIt == exports.end())
-        {
+        if (uint32_t(exportId) >= exportEntries.size())
             return nullptr;
-        }
 
-        return &exportEntryIt->second;
+        return &exportEntries[uint32_t(exportId)];
+    }
+
+    rt::ShaderExportId RayTracingPipeline::getShaderExportId(const char* exportName) const
+    {
+        if (!exportName)
+            return rt::ShaderExportId::Invalid;
+
+        const auto exportEntryIt = exports.find(exportName);
+        if (exportEntryIt == exports.end())
+            return rt::ShaderExportId::Invalid;
+
+        return exportEntryIt->second;
+    }
+
+    void RayTracingPipeline::addExport(const std::string& exportName, const ExportTableEntry& entry)
+    {
+        // A later export with the same name replaces the earlier one
+        auto [exportEntryIt, inserted] = exports.try_emplace(exportName, rt::ShaderExportId(exportEntries.size()));
+        if (inserted)
+            exportEntries.push_back(entry);
+        else
+            exportEntries[uint32_t(exportEntryIt->second)] = entry;
     }
 
     rt::ShaderTableHandle RayTracingPipeline::createShaderTable(rt::ShaderTableDesc const& stDesc)
@@ -415,6 +580,12 @@ namespace nvrhi::d3d12
                 m_Context.error("maxEntries must be nonzero for a cached ShaderTable");
                 return nullptr;
             }
+
+            if (uint64_t(stDesc.reservedMissShaders) + stDesc.reservedHitGroups + stDesc.reservedCallableShaders >= stDesc.maxEntries)
+            {
+                m_Context.error("The reserved records of a cached ShaderTable and its RayGen shader don't fit into maxEntries");
+                return nullptr;
+            }
             
             BufferDesc bufferDesc = BufferDesc()
                 .setDebugName(stDesc.debugName)
@@ -450,6 +621,27 @@ namespace nvrhi::d3d12
             rtxmuId = ~0ull;
         }
 #endif // NVRHI_WITH_RTXMU
+
+        if (compactedSizeQuery >= 0)
+        {
+            std::lock_guard lockGuard(m_Resources.asCompactionMutex);
+
+            auto& candidates = m_Resources.asCompactionCandidates;
+            candidates.erase(std::remove(candidates.begin(), candidates.end(), this), candidates.end());
+            m_Resources.compactedSizeQueries.release(compactedSizeQuery);
+        }
+    }
+
+    OpacityMicromap::~OpacityMicromap()
+    {
+        if (compactedSizeQuery >= 0)
+        {
+            std::lock_guard lockGuard(m_Resources.asCompactionMutex);
+
+            auto& candidates = m_Resources.ommCompactionCandidates;
+            candidates.erase(std::remove(candidates.begin(), candidates.end(), this), candidates.end());
+            m_Resources.compactedSizeQueries.release(compactedSizeQuery);
+        }
     }
 
     Object OpacityMicromap::getNativeObject(ObjectType objectType)
@@ -732,6 +924,28 @@ namespace nvrhi::d3d12
         }
     }
 
+    // Places the scratch memory of the builds starting at groupBegin one after another, for as long as the total
+    // size stays within maxGroupSize, and returns the end of the group. The group always contains at least one build.
+    static size_t placeScratchGroup(const std::vector<uint64_t>& scratchSizes, size_t groupBegin, uint64_t maxGroupSize,
+        std::vector<uint64_t>& outScratchOffsets, uint64_t& outGroupSize)
+    {
+        size_t groupEnd = groupBegin;
+        outGroupSize = 0;
+
+        while (groupEnd < scratchSizes.size())
+        {
+            const uint64_t offset = align(outGroupSize, uint64_t(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT));
+            if (groupEnd > groupBegin && offset + scratchSizes[groupEnd] > maxGroupSize)
+                break;
+
+            outScratchOffsets[groupEnd] = offset;
+            outGroupSize = offset + scratchSizes[groupEnd];
+            ++groupEnd;
+        }
+
+        return groupEnd;
+    }
+
     static void fillAsInputDescForPreBuildInfo(
         D3D12BuildRaytracingAccelerationStructureInputs& outASInputs,
         const rt::AccelStructDesc& desc)
@@ -792,7 +1006,7 @@ namespace nvrhi::d3d12
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ommPreBuildInfo;
         m_Context.device8.Get()->GetRaytracingAccelerationStructurePrebuildInfo(&ommInputs, &ommPreBuildInfo);
 
-        OpacityMicromap* om = new OpacityMicromap();
+        OpacityMicromap* om = new OpacityMicromap(m_Resources);
         om->desc = desc;
         om->compacted = false;
 
@@ -807,7 +1021,22 @@ namespace nvrhi::d3d12
         bufferDesc.isVirtual = false;
         BufferHandle buffer = createBuffer(bufferDesc);
         om->dataBuffer = checked_cast<Buffer*>(buffer.Get());
-                
+
+        if ((desc.flags & rt::OpacityMicromapBuildFlags::AllowCompaction) != 0)
+        {
+            if (createCompactedSizeBuffers())
+                om->compactedSizeQuery = m_Resources.compactedSizeQueries.allocate();
+
+            if (om->compactedSizeQuery < 0)
+            {
+                std::stringstream ss;
+                ss << "All " << m_Resources.compactedSizeQueries.getCapacity() << " compacted size queries are in use, "
+                    "OMM " << utils::DebugNameToString(desc.debugName) << " will not be compacted. "
+                    "Consider increasing DeviceDesc::maxCompactedSizeQueries.";
+                m_Context.warning(ss.str());
+            }
+        }
+
         return rt::OpacityMicromapHandle::Create(om);
 
 #elif NVRHI_WITH_NVAPI_OPACITY_MICROMAP
@@ -826,7 +1055,7 @@ namespace nvrhi::d3d12
         if (status != S_OK)
             return nullptr;
 
-        OpacityMicromap* om = new OpacityMicromap();
+        OpacityMicromap* om = new OpacityMicromap(m_Resources);
         om->desc = desc;
         om->compacted = false;
 
@@ -884,12 +1113,30 @@ namespace nvrhi::d3d12
         if (!GetAccelStructPreBuildInfo(ASPreBuildInfo, desc))
             return nullptr;
 
-        AccelStruct* as = new AccelStruct(m_Context);
+        AccelStruct* as = new AccelStruct(m_Context, m_Resources);
         as->desc = desc;
         as->allowUpdate = (desc.buildFlags & rt::AccelStructBuildFlags::AllowUpdate) != 0;
 
         assert(ASPreBuildInfo.ResultDataMaxSizeInBytes <= ~0u);
 
+#ifndef NVRHI_WITH_RTXMU
+        // Virtual BLAS'es live in user-provided heaps and are not moved to compacted storage
+        if (!desc.isTopLevel && !desc.isVirtual && (desc.buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0)
+        {
+            if (createCompactedSizeBuffers())
+                as->compactedSizeQuery = m_Resources.compactedSizeQueries.allocate();
+
+            if (as->compactedSizeQuery < 0)
+            {
+                std::stringstream ss;
+                ss << "All " << m_Resources.compactedSizeQueries.getCapacity() << " compacted size queries are in use, "
+                    "BLAS " << utils::DebugNameToString(desc.debugName) << " will not be compacted. "
+                    "Consider increasing DeviceDesc::maxCompactedSizeQueries.";
+                m_Context.warning(ss.str());
+            }
+        }
+#endif
+
 #ifdef NVRHI_WITH_RTXMU
         bool needBuffer = desc.isTopLevel;
 #else
@@ -909,6 +1156,23 @@ namespace nvrhi::d3d12
             BufferHandle buffer = createBuffer(bufferDesc);
             as->dataBuffer = checked_cast<Buffer*>(buffer.Get());
         }
+
+        if (desc.isTopLevel && desc.createInstanceBuffer)
+        {
+            BufferDesc instanceBufferDesc;
+            instanceBufferDesc.byteSize = sizeof(rt::InstanceDesc) * std::max<size_t>(desc.topLevelMaxInstances, 1);
+            instanceBufferDesc.structStride = sizeof(rt::InstanceDesc);
+            instanceBufferDesc.canHaveUAVs = true;
+            instanceBufferDesc.isAccelStructBuildInput = true;
+            instanceBufferDesc.initialState = ResourceStates::AccelStructBuildInput;
+            instanceBufferDesc.keepInitialState = true;
+            instanceBufferDesc.debugName = desc.debugName + " instances";
+            BufferHandle instanceBuffer = createBuffer(instanceBufferDesc);
+            as->instanceBuffer = checked_cast<Buffer*>(instanceBuffer.Get());
+
+            if (desc.trackLiveness)
+                as->instanceBufferBLASes.resize(desc.topLevelMaxInstances);
+        }
         
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the desc
         for (auto& geometry : as->desc.bottomLevelGeometries)
@@ -936,6 +1200,39 @@ namespace nvrhi::d3d12
         return rt::AccelStructHandle::Create(as);
     }
 
+    bool Device::createCompactedSizeBuffers()
+    {
+        std::lock_guard lockGuard(m_Resources.asCompactionMutex);
+
+        if (m_Resources.compactedSizes)
+            return true;
+
+        const uint64_t byteSize = m_Resources.compactedSizeQueries.getCapacity()
+            * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = byteSize;
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.initialState = ResourceStates::UnorderedAccess;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.debugName = "CompactedSizeBuffer";
+        m_Resources.compactedSizeBuffer = createBuffer(bufferDesc);
+
+        bufferDesc.canHaveUAVs = false;
+        bufferDesc.cpuAccess = CpuAccessMode::Read;
+        bufferDesc.initialState = ResourceStates::CopyDest;
+        bufferDesc.debugName = "CompactedSizeReadbackBuffer";
+        m_Resources.compactedSizeReadbackBuffer = createBuffer(bufferDesc);
+
+        if (!m_Resources.compactedSizeBuffer || !m_Resources.compactedSizeReadbackBuffer)
+            return false;
+
+        // The readback buffer stays mapped, the sizes are only read after their copies have finished
+        m_Resources.compactedSizes = static_cast<const uint64_t*>(mapBuffer(m_Resources.compactedSizeReadbackBuffer, CpuAccessMode::Read));
+
+        return m_Resources.compactedSizes != nullptr;
+    }
+
     MemoryRequirements Device::getAccelStructMemoryRequirements(rt::IAccelStruct* _as)
     {
         AccelStruct* as = checked_cast<AccelStruct*>(_as);
@@ -1520,7 +1817,7 @@ namespace nvrhi::d3d12
                 return nullptr;
             }
 
-            pso->exports[exportName] = RayTracingPipeline::ExportTableEntry{ shaderDesc.bindingLayout, pShaderIdentifier };
+            pso->addExport(exportName, RayTracingPipeline::ExportTableEntry{ shaderDesc.bindingLayout, pShaderIdentifier });
         }
 
         for(const rt::PipelineHitGroupDesc& hitGroupDesc : desc.hitGroups)
@@ -1534,88 +1831,109 @@ namespace nvrhi::d3d12
                 return nullptr;
             }
 
-            pso->exports[hitGroupDesc.exportName] = RayTracingPipeline::ExportTableEntry{ hitGroupDesc.bindingLayout, pShaderIdentifier };
+            pso->addExport(hitGroupDesc.exportName, RayTracingPipeline::ExportTableEntry{ hitGroupDesc.bindingLayout, pShaderIdentifier });
         }
 
         return rt::PipelineHandle::Create(pso);
     }
 
-    void ShaderTable::bake(uint8_t* cpuVA, D3D12_GPU_VIRTUAL_ADDRESS gpuVA, DeviceResources& resources, ShaderTableState& state)
+    const ShaderTable::Entry* ShaderTable::getRecord(uint32_t recordIndex) const
     {
-        uint32_t const entrySize = pipeline->getShaderTableEntrySize();
+        if (recordIndex == 0)
+            return &rayGenerationShader;
+
+        uint32_t const missBase = getMissShaderBase();
+        if (recordIndex >= missBase && recordIndex < missBase + missShaders.size())
+            return &missShaders[recordIndex - missBase];
+
+        uint32_t const hitGroupBase = getHitGroupBase();
+        if (recordIndex >= hitGroupBase && recordIndex < hitGroupBase + hitGroups.size())
+            return &hitGroups[recordIndex - hitGroupBase];
+
+        uint32_t const callableBase = getCallableShaderBase();
+        if (recordIndex >= callableBase && recordIndex < callableBase + callableShaders.size())
+            return &callableShaders[recordIndex - callableBase];
+
+        // The record is in the unused part of a section reservation
+        return nullptr;
+    }
+
+    void ShaderTable::writeRecord(uint8_t* cpuVA, uint32_t recordIndex, DeviceResources& resources) const
+    {
+        const Entry* entry = getRecord(recordIndex);
+        if (!entry || !entry->pShaderIdentifier)
+            return;
 
-        auto writeEntry = [this, &resources, entrySize, &cpuVA, &gpuVA](const ShaderTable::Entry& entry) 
+        memcpy(cpuVA, entry->pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+
+        if (entry->localBindings)
         {
-            memcpy(cpuVA, entry.pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+            d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry->localBindings.Get());
+            d3d12::BindingLayout* layout = bindingSet->layout;
 
-            if (entry.localBindings)
+            if (layout->descriptorTableSizeSamplers > 0)
             {
-                d3d12::BindingSet* bindingSet = checked_cast<d3d12::BindingSet*>(entry.localBindings.Get());
-                d3d12::BindingLayout* layout = bindingSet->layout;
-
-                if (layout->descriptorTableSizeSamplers > 0)
-                {
-                    auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
-                        + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                    *pTable = resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
-                }
+                auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
+                    + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSamplers * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+                *pTable = resources.samplerHeap.getGpuHandle(bindingSet->descriptorTableSamplers);
+            }
 
-                if (layout->descriptorTableSizeSRVetc > 0)
-                {
-                    auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
-                        + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
-                    *pTable = resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
-                }
+            if (layout->descriptorTableSizeSRVetc > 0)
+            {
+                auto pTable = reinterpret_cast<D3D12_GPU_DESCRIPTOR_HANDLE*>(cpuVA
+                    + D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES + layout->rootParameterSRVetc * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+                *pTable = resources.shaderResourceViewHeap.getGpuHandle(bindingSet->descriptorTableSRVetc);
+            }
 
-                if (!layout->rootParametersVolatileCB.empty())
-                {
-                    m_Context.error("Cannot use Volatile CBs in a shader binding table");
-                    return;
-                }
+            if (!layout->rootParametersVolatileCB.empty())
+            {
+                m_Context.error("Cannot use Volatile CBs in a shader binding table");
+                return;
             }
+        }
+    }
 
-            cpuVA += entrySize;
-            gpuVA += entrySize;
-        };
+    void ShaderTable::fillDispatchRaysTemplate(D3D12_GPU_VIRTUAL_ADDRESS gpuVA, ShaderTableState& state) const
+    {
+        uint32_t const entrySize = pipeline->getShaderTableEntrySize();
 
         D3D12_DISPATCH_RAYS_DESC& drd = state.dispatchRaysTemplate;
         memset(&drd, 0, sizeof(D3D12_DISPATCH_RAYS_DESC));
 
         drd.RayGenerationShaderRecord.StartAddress = gpuVA;
         drd.RayGenerationShaderRecord.SizeInBytes = entrySize;
-        writeEntry(rayGenerationShader);
-        
-        if (!missShaders.empty())
+
+        auto fillTable = [gpuVA, entrySize](D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE& table, uint32_t base, size_t count)
         {
-            drd.MissShaderTable.StartAddress = gpuVA;
-            drd.MissShaderTable.StrideInBytes = (missShaders.size() == 1) ? 0 : entrySize;
-            drd.MissShaderTable.SizeInBytes = uint32_t(missShaders.size()) * entrySize;
+            if (count == 0)
+                return;
 
-            for (auto& entry : missShaders)
-                writeEntry(entry);
-        }
+            table.StartAddress = gpuVA + uint64_t(base) * entrySize;
+            table.StrideInBytes = (count == 1) ? 0 : entrySize;
+            table.SizeInBytes = uint32_t(count) * entrySize;
+        };
 
-        if (!hitGroups.empty())
-        {
-            drd.HitGroupTable.StartAddress = gpuVA;
-            drd.HitGroupTable.StrideInBytes = (hitGroups.size() == 1) ? 0 : entrySize;
-            drd.HitGroupTable.SizeInBytes = uint32_t(hitGroups.size()) * entrySize;
+        fillTable(drd.MissShaderTable, getMissShaderBase(), missShaders.size());
+        fillTable(drd.HitGroupTable, getHitGroupBase(), hitGroups.size());
+        fillTable(drd.CallableShaderTable, getCallableShaderBase(), callableShaders.size());
+    }
 
-            for (auto& entry : hitGroups)
-                writeEntry(entry);
-        }
+    void ShaderTable::bake(uint8_t* cpuVA, D3D12_GPU_VIRTUAL_ADDRESS gpuVA, DeviceResources& resources, ShaderTableState& state)
+    {
+        uint32_t const entrySize = pipeline->getShaderTableEntrySize();
 
-        if (!callableShaders.empty())
-        {
-            drd.CallableShaderTable.StartAddress = gpuVA;
-            drd.CallableShaderTable.StrideInBytes = (callableShaders.size() == 1) ? 0 : entrySize;
-            drd.CallableShaderTable.SizeInBytes = uint32_t(callableShaders.size()) * entrySize;
+        // The unused records in section reservations are left uninitialized, they are never accessed by the GPU.
 
-            for (auto& entry : callableShaders)
-                writeEntry(entry);
+        uint32_t const numRecords = getNumRecords();
+        for (uint32_t recordIndex = 0; recordIndex < numRecords; ++recordIndex)
+        {
+            writeRecord(cpuVA + uint64_t(recordIndex) * entrySize, recordIndex, resources);
         }
 
+        fillDispatchRaysTemplate(gpuVA, state);
+
         state.committedVersion = version;
+        state.committedLayoutVersion = layoutVersion;
         if (pipeline->hasLocalResources())
         {
             state.descriptorHeapSRV =  resources.shaderResourceViewHeap.getShaderVisibleHeap();
@@ -1626,6 +1944,9 @@ namespace nvrhi::d3d12
             state.descriptorHeapSRV = nullptr;
             state.descriptorHeapSamplers = nullptr;
         }
+
+        if (m_Desc.isCached)
+            dirtyRecords.clear();
     }
 
     bool ShaderTable::isStateValid(ShaderTableState const& state, DeviceResources const& resources) const
@@ -1642,6 +1963,17 @@ namespace nvrhi::d3d12
         }
     }
     
+    bool ShaderTable::canUpdateRecords(ShaderTableState const& state, DeviceResources const& resources) const
+    {
+        // The records reference descriptor tables in the shader-visible heaps, so a heap change requires a full upload.
+        if (pipeline->hasLocalResources() && (
+            state.descriptorHeapSRV != resources.shaderResourceViewHeap.getShaderVisibleHeap() ||
+            state.descriptorHeapSamplers != resources.samplerHeap.getShaderVisibleHeap()))
+            return false;
+
+        return m_Desc.isCached && state.committedLayoutVersion == layoutVersion;
+    }
+    
     ShaderTableState& CommandList::getShaderTableState(rt::IShaderTable* _shaderTable)
     {
         ShaderTable* shaderTable = checked_cast<ShaderTable*>(_shaderTable);
@@ -1663,8 +1995,65 @@ namespace nvrhi::d3d12
         return state;
     }
 
+    bool CommandList::updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state)
+    {
+        std::vector<uint32_t>& records = shaderTable->dirtyRecords;
+        std::sort(records.begin(), records.end());
+        records.erase(std::unique(records.begin(), records.end()), records.end());
+        records.erase(std::remove_if(records.begin(), records.end(),
+            [shaderTable](uint32_t recordIndex) { return shaderTable->getRecord(recordIndex) == nullptr; }), records.end());
+
+        if (!records.empty())
+        {
+            uint32_t const entrySize = shaderTable->pipeline->getShaderTableEntrySize();
+
+            // Write the modified records next to each other in the upload buffer,
+            // and copy them into the cache with one copy per contiguous range of records.
+
+            ID3D12Resource* uploadBuffer = nullptr;
+            uint64_t uploadOffset = 0;
+            uint8_t* uploadCpuVA = nullptr;
+            bool allocated = m_UploadManager.suballocateBuffer(records.size() * entrySize, nullptr, &uploadBuffer, &uploadOffset,
+                (void**)&uploadCpuVA, nullptr, m_RecordingVersion, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+
+            if (!allocated)
+            {
+                m_Context.error("Couldn't suballocate an upload buffer");
+                return false;
+            }
+
+            setBufferState(shaderTable->cache, nvrhi::ResourceStates::CopyDest);
+            commitBarriers();
+
+            ID3D12Resource* cacheBuffer = shaderTable->cache->getNativeObject(nvrhi::ObjectTypes::D3D12_Resource);
+
+            size_t rangeStart = 0;
+            for (size_t i = 0; i < records.size(); ++i)
+            {
+                shaderTable->writeRecord(uploadCpuVA + i * entrySize, records[i], m_Resources);
+
+                bool const lastInRange = (i + 1 == records.size()) || (records[i + 1] != records[i] + 1);
+                if (lastInRange)
+                {
+                    m_ActiveCommandList->commandList->CopyBufferRegion(cacheBuffer, uint64_t(records[rangeStart]) * entrySize,
+                        uploadBuffer, uploadOffset + rangeStart * entrySize, (i + 1 - rangeStart) * entrySize);
+
+                    rangeStart = i + 1;
+                }
+            }
+        }
+
+        shaderTable->fillDispatchRaysTemplate(shaderTable->cache->getGpuVirtualAddress(), state);
+        state.committedVersion = shaderTable->version;
+        records.clear();
+
+        return true;
+    }
+
     void CommandList::setRayTracingState(const rt::State& state)
     {
+        endRenderPass();
+
         ShaderTable* shaderTable = checked_cast<ShaderTable*>(state.shaderTable);
         RayTracingPipeline* pso = shaderTable->pipeline;
 
@@ -1675,7 +2064,14 @@ namespace nvrhi::d3d12
         ShaderTableState& shaderTableState = getShaderTableState(shaderTable);
         bool const rebuildShaderTable = !shaderTable->isStateValid(shaderTableState, m_Resources);
 
-        if (rebuildShaderTable)
+        if (rebuildShaderTable && shaderTable->canUpdateRecords(shaderTableState, m_Resources))
+        {
+            // The layout of the cached table is unchanged, only upload the modified records.
+
+            if (!updateShaderTableRecords(shaderTable, shaderTableState))
+                return;
+        }
+        else if (rebuildShaderTable)
         {
             size_t shaderTableSize = shaderTable->getUploadSize();
 
@@ -1794,190 +2190,408 @@ namespace nvrhi::d3d12
         m_ActiveCommandList->commandList4->DispatchRays(&desc);
     }
 
-    void CommandList::buildOpacityMicromap([[maybe_unused]] rt::IOpacityMicromap* pOmm, [[maybe_unused]] const rt::OpacityMicromapDesc& desc)
+    void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* pOmm, const rt::OpacityMicromapDesc& desc)
+    {
+        const rt::OpacityMicromapBuildDesc build = rt::OpacityMicromapBuildDesc()
+            .setOpacityMicromap(pOmm)
+            .setDesc(&desc);
+
+        buildOpacityMicromaps(&build, 1);
+    }
+
+    void CommandList::buildOpacityMicromaps([[maybe_unused]] const rt::OpacityMicromapBuildDesc* builds, [[maybe_unused]] size_t numBuilds)
     {
+        endRenderPass();
+
 #if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP || NVRHI_WITH_NVAPI_OPACITY_MICROMAP
-        OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pOmm);
+        // Sized up front, the build inputs point into the array descs
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> buildInputs(numBuilds);
+        std::vector<D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC> arrayDescs(numBuilds);
+#else
+        std::vector<NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS> buildInputs(numBuilds);
+#endif
 
-        if (m_EnableAutomaticBarriers)
+        // Place the scratch memory of all builds into one allocation, so that the builds can run concurrently
+        std::vector<uint64_t> scratchOffsets(numBuilds);
+        uint64_t totalScratchSize = 0;
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
-            requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+            const rt::OpacityMicromapDesc& desc = builds[buildIndex].desc ? *builds[buildIndex].desc : omm->desc;
 
-            requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
-            m_BindingStatesDirty = true;
-        }
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+            fillD3dOpacityMicromapDesc(buildInputs[buildIndex], arrayDescs[buildIndex], desc);
 
-        if (desc.trackLiveness)
-        {
-            m_Instance->referencedResources.push_back(desc.inputBuffer);
-            m_Instance->referencedResources.push_back(desc.perOmmDescs);
-            m_Instance->referencedResources.push_back(omm->dataBuffer);
-        }
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ommPreBuildInfo = {};
+            m_Context.device8.Get()->GetRaytracingAccelerationStructurePrebuildInfo(&buildInputs[buildIndex], &ommPreBuildInfo);
 
-        commitBarriers();
+            const uint64_t resultSize = ommPreBuildInfo.ResultDataMaxSizeInBytes;
+            const uint64_t scratchSize = ommPreBuildInfo.ScratchDataSizeInBytes;
+#else
+            fillD3dOpacityMicromapDesc(buildInputs[buildIndex], desc);
+
+            NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO vmPreBuildInfo = {};
+
+            NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS prebuildParams;
+            prebuildParams.version = NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS_VER;
+            prebuildParams.pDesc = &buildInputs[buildIndex];
+            prebuildParams.pInfo = &vmPreBuildInfo;
+            NvAPI_Status status = NvAPI_D3D12_GetRaytracingOpacityMicromapArrayPrebuildInfo(m_Context.device5.Get(), &prebuildParams);
+            assert(status == S_OK);
+            if (status != S_OK)
+                return;
+
+            const uint64_t resultSize = vmPreBuildInfo.resultDataMaxSizeInBytes;
+            const uint64_t scratchSize = vmPreBuildInfo.scratchDataSizeInBytes;
 #endif
 
-#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+            if (resultSize > omm->dataBuffer->desc.byteSize)
+            {
+                std::stringstream ss;
+                ss << "OMM " << utils::DebugNameToString(omm->desc.debugName) << " build requires at least "
+                    << resultSize << " bytes in the data buffer, while the allocated buffer is only "
+                    << omm->dataBuffer->desc.byteSize << " bytes";
 
-        // Gather prebuild info to get scratch buffer requirements
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS ommInputs = {};
-        D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC ommArrayDesc = {};
-        fillD3dOpacityMicromapDesc(ommInputs, ommArrayDesc, desc);
+                m_Context.error(ss.str());
+                return;
+            }
 
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ommPreBuildInfo;
-        m_Context.device8.Get()->GetRaytracingAccelerationStructurePrebuildInfo(&ommInputs, &ommPreBuildInfo);
+            scratchOffsets[buildIndex] = align(totalScratchSize, uint64_t(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT));
+            totalScratchSize = scratchOffsets[buildIndex] + scratchSize;
+        }
 
-        // Allocate scratch buffer
         D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (ommPreBuildInfo.ScratchDataSizeInBytes > 0)
+        if (totalScratchSize != 0)
         {
-            if (!m_DxrScratchManager.suballocateBuffer(ommPreBuildInfo.ScratchDataSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
+            if (!m_DxrScratchManager.suballocateBuffer(totalScratchSize, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
                 &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
             {
                 std::stringstream ss;
-                ss << "Couldn't suballocate a scratch buffer for VM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
-                    "The build requires " << ommPreBuildInfo.ScratchDataSizeInBytes << " bytes of scratch space.";
+                if (numBuilds == 1)
+                    ss << "Couldn't suballocate a scratch buffer for OMM " << utils::DebugNameToString(builds[0].opacityMicromap->getDesc().debugName) << " build. ";
+                else
+                    ss << "Couldn't suballocate a scratch buffer for " << numBuilds << " OMM builds. ";
+                ss << "The build requires " << totalScratchSize << " bytes of scratch space.";
 
                 m_Context.error(ss.str());
                 return;
             }
         }
 
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC asDesc;
-        asDesc.Inputs = ommInputs;
-        asDesc.ScratchAccelerationStructureData = scratchGpuVA;
-        asDesc.DestAccelerationStructureData = omm->getDeviceAddress();
-        m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&asDesc, 0, nullptr); // No immediate post-build info supported.
-
-#elif NVRHI_WITH_NVAPI_OPACITY_MICROMAP
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+            const rt::OpacityMicromapDesc& desc = builds[buildIndex].desc ? *builds[buildIndex].desc : omm->desc;
 
-        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_INPUTS inputs = {};
-        fillD3dOpacityMicromapDesc(inputs, desc);
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
+                requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
 
-        NVAPI_D3D12_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO vmPreBuildInfo = {};
+                requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
+                m_BindingStatesDirty = true;
+            }
 
-        NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS prebuildParams;
-        prebuildParams.version = NVAPI_GET_RAYTRACING_OPACITY_MICROMAP_ARRAY_PREBUILD_INFO_PARAMS_VER;
-        prebuildParams.pDesc = &inputs;
-        prebuildParams.pInfo = &vmPreBuildInfo;
-        NvAPI_Status status = NvAPI_D3D12_GetRaytracingOpacityMicromapArrayPrebuildInfo(m_Context.device5.Get(), &prebuildParams);
-        assert(status == S_OK);
-        if (status != S_OK)
-            return;
+            if (desc.trackLiveness)
+            {
+                m_Instance->referencedResources.push_back(desc.inputBuffer);
+                m_Instance->referencedResources.push_back(desc.perOmmDescs);
+                m_Instance->referencedResources.push_back(omm->dataBuffer);
+            }
+        }
 
-        D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (vmPreBuildInfo.scratchDataSizeInBytes != 0)
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        // The OMMs that can be compacted write their compacted sizes into the device's size buffer
+        std::vector<OpacityMicromap*> compactedSizeWrites;
+        std::vector<bool> writesCompactedSize(numBuilds, false);
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            if (!m_DxrScratchManager.suballocateBuffer(vmPreBuildInfo.scratchDataSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
-                &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+
+            if (omm->compactedSizeQuery >= 0 && (buildInputs[buildIndex].Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION) != 0)
             {
-                std::stringstream ss;
-                ss << "Couldn't suballocate a scratch buffer for VM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
-                    "The build requires " << vmPreBuildInfo.scratchDataSizeInBytes << " bytes of scratch space.";
+                compactedSizeWrites.push_back(omm);
+                writesCompactedSize[buildIndex] = true;
+            }
+        }
 
-                m_Context.error(ss.str());
-                return;
+        Buffer* compactedSizeBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeBuffer.Get());
+        if (!compactedSizeWrites.empty())
+            requireBufferState(compactedSizeBuffer, nvrhi::ResourceStates::UnorderedAccess);
+#endif
+
+        commitBarriers();
+
+        // The builds use disjoint scratch and data memory, so they are issued back to back without UAV barriers
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfo = {};
+            UINT numPostbuildInfoDescs = 0;
+            if (writesCompactedSize[buildIndex])
+            {
+                postbuildInfo.DestBuffer = compactedSizeBuffer->gpuVA
+                    + uint64_t(omm->compactedSizeQuery) * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+                postbuildInfo.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+                numPostbuildInfoDescs = 1;
             }
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC asDesc = {};
+            asDesc.Inputs = buildInputs[buildIndex];
+            asDesc.ScratchAccelerationStructureData = scratchGpuVA ? scratchGpuVA + scratchOffsets[buildIndex] : 0;
+            asDesc.DestAccelerationStructureData = omm->getDeviceAddress();
+            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&asDesc,
+                numPostbuildInfoDescs, numPostbuildInfoDescs ? &postbuildInfo : nullptr);
+#else
+            NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC nativeDesc = {};
+            nativeDesc.destOpacityMicromapArrayData = omm->getDeviceAddress();
+            nativeDesc.inputs = buildInputs[buildIndex];
+            nativeDesc.scratchOpacityMicromapArrayData = scratchGpuVA ? scratchGpuVA + scratchOffsets[buildIndex] : 0;
+
+            NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS params;
+            params.version = NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS_VER;
+            params.pDesc = &nativeDesc;
+            params.numPostbuildInfoDescs = 0;
+            params.pPostbuildInfoDescs = nullptr;
+
+            [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingOpacityMicromapArray(m_ActiveCommandList->commandList4, &params);
+            assert(status == S_OK);
+#endif
         }
 
-        NVAPI_D3D12_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_DESC nativeDesc = {};
-        nativeDesc.destOpacityMicromapArrayData = omm->getDeviceAddress();
-        nativeDesc.inputs = inputs;
-        nativeDesc.scratchOpacityMicromapArrayData = scratchGpuVA;
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+        if (!compactedSizeWrites.empty())
+        {
+            // Copy the sizes into the readback buffer, compactOpacityMicromaps reads them
+            // after this command list has finished executing
+            Buffer* readbackBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeReadbackBuffer.Get());
 
-        NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS params;
-        params.version = NVAPI_BUILD_RAYTRACING_OPACITY_MICROMAP_ARRAY_PARAMS_VER;
-        params.pDesc = &nativeDesc;
-        params.numPostbuildInfoDescs = 0;
-        params.pPostbuildInfoDescs = nullptr;
+            requireBufferState(compactedSizeBuffer, nvrhi::ResourceStates::CopySource);
+            requireBufferState(readbackBuffer, nvrhi::ResourceStates::CopyDest);
+            commitBarriers();
 
-        status = NvAPI_D3D12_BuildRaytracingOpacityMicromapArray(m_ActiveCommandList->commandList4, &params);
-        assert(status == S_OK);
+            for (OpacityMicromap* omm : compactedSizeWrites)
+            {
+                const uint64_t offset = uint64_t(omm->compactedSizeQuery)
+                    * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+
+                m_ActiveCommandList->commandList->CopyBufferRegion(readbackBuffer->resource, offset,
+                    compactedSizeBuffer->resource, offset,
+                    sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC));
+
+                m_Instance->ommsToCompact.push_back(omm);
+            }
+        }
+#endif
 #else
         utils::NotSupported();
 #endif
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandList::compactOpacityMicromaps()
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        endRenderPass();
 
-        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
-        if (performUpdate)
+        // Hold the lock while the candidates are processed, the OpacityMicromap destructor removes them from the list
+        std::lock_guard lockGuard(m_Resources.asCompactionMutex);
+
+        if (m_Resources.ommCompactionCandidates.empty())
+            return;
+
+        for (OpacityMicromap* omm : m_Resources.ommCompactionCandidates)
         {
-            assert(as->allowUpdate);
+            // The build command list has finished, so the size is already in the readback buffer
+            const uint64_t compactedSize = m_Resources.compactedSizes[omm->compactedSizeQuery];
+            omm->compactionPending = false;
+
+            if (compactedSize == 0 || compactedSize >= omm->dataBuffer->desc.byteSize)
+                continue;
+
+            BufferDesc bufferDesc = omm->dataBuffer->desc;
+            bufferDesc.byteSize = compactedSize;
+            BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+            if (!buffer)
+                continue;
+
+            Buffer* compactedBuffer = checked_cast<Buffer*>(buffer.Get());
+
+            m_ActiveCommandList->commandList4->CopyRaytracingAccelerationStructure(compactedBuffer->gpuVA, omm->dataBuffer->gpuVA,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+            // Keep the original storage alive until the copy has finished
+            m_Instance->referencedResources.push_back(omm->dataBuffer);
+            omm->dataBuffer = compactedBuffer;
+            omm->compacted = true;
+
+            m_Resources.compactedSizeQueries.release(omm->compactedSizeQuery);
+            omm->compactedSizeQuery = -1;
+
+            if (omm->desc.trackLiveness)
+                m_Instance->referencedResources.push_back(omm);
         }
 
-        for (uint32_t i = 0; i < numGeometries; i++)
+        m_Resources.ommCompactionCandidates.clear();
+
+        // Make the compacted OMMs visible to the BLAS builds that follow
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barrier.UAV.pResource = nullptr;
+        m_ActiveCommandList->commandList->ResourceBarrier(1, &barrier);
+    }
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        const rt::BlasBuildDesc build = rt::BlasBuildDesc()
+            .setAccelStruct(as)
+            .setGeometries(pGeometries, numGeometries)
+            .setBuildFlags(buildFlags);
+
+        buildBottomLevelAccelStructs(&build, 1);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds)
+    {
+        endRenderPass();
+
+        // Filled in place, the inputs contain pointers into themselves
+        std::vector<D3D12BuildRaytracingAccelerationStructureInputs> buildInputs(numBuilds);
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            const auto& geometryDesc = pGeometries[i];
-            if (geometryDesc.geometryType == rt::GeometryType::Triangles)
-            {
-                const auto& triangles = geometryDesc.geometryData.triangles;
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+            const rt::GeometryDesc* pGeometries = build.geometries;
+            const size_t numGeometries = build.numGeometries;
+            const rt::AccelStructBuildFlags buildFlags = build.buildFlags;
 
-                OpacityMicromap* om = triangles.opacityMicromap ? checked_cast<OpacityMicromap*>(triangles.opacityMicromap) : nullptr;
+            const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+            if (performUpdate)
+            {
+                assert(as->allowUpdate);
+            }
 
-                if (m_EnableAutomaticBarriers)
+            for (uint32_t i = 0; i < numGeometries; i++)
+            {
+                const auto& geometryDesc = pGeometries[i];
+                if (geometryDesc.geometryType == rt::GeometryType::Triangles)
                 {
-                    requireBufferState(triangles.indexBuffer, ResourceStates::AccelStructBuildInput);
-                    requireBufferState(triangles.vertexBuffer, ResourceStates::AccelStructBuildInput);
-                    if (om)
-                        requireBufferState(om->dataBuffer, ResourceStates::AccelStructBuildInput);
+                    const auto& triangles = geometryDesc.geometryData.triangles;
+
+                    OpacityMicromap* om = triangles.opacityMicromap ? checked_cast<OpacityMicromap*>(triangles.opacityMicromap) : nullptr;
+
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        requireBufferState(triangles.indexBuffer, ResourceStates::AccelStructBuildInput);
+                        requireBufferState(triangles.vertexBuffer, ResourceStates::AccelStructBuildInput);
+                        if (om)
+                            requireBufferState(om->dataBuffer, ResourceStates::AccelStructBuildInput);
+                        if (triangles.ommIndexBuffer)
+                            requireBufferState(triangles.ommIndexBuffer, ResourceStates::AccelStructBuildInput);
+                    }
+
+                    m_Instance->referencedResources.push_back(triangles.indexBuffer);
+                    m_Instance->referencedResources.push_back(triangles.vertexBuffer);
+                    if (om && om->desc.trackLiveness)
+                        m_Instance->referencedResources.push_back(om);
                     if (triangles.ommIndexBuffer)
-                        requireBufferState(triangles.ommIndexBuffer, ResourceStates::AccelStructBuildInput);
+                        m_Instance->referencedResources.push_back(triangles.ommIndexBuffer);
                 }
+                else if (geometryDesc.geometryType == rt::GeometryType::AABBs)
+                {
+                    const auto& aabbs = geometryDesc.geometryData.aabbs;
 
-                m_Instance->referencedResources.push_back(triangles.indexBuffer);
-                m_Instance->referencedResources.push_back(triangles.vertexBuffer);
-                if (om && om->desc.trackLiveness)
-                    m_Instance->referencedResources.push_back(om);
-                if (triangles.ommIndexBuffer)
-                    m_Instance->referencedResources.push_back(triangles.ommIndexBuffer);
-            }
-            else if (geometryDesc.geometryType == rt::GeometryType::AABBs)
-            {
-                const auto& aabbs = geometryDesc.geometryData.aabbs;
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        requireBufferState(aabbs.buffer, ResourceStates::AccelStructBuildInput);
+                    }
 
-                if (m_EnableAutomaticBarriers)
+                    m_Instance->referencedResources.push_back(aabbs.buffer);
+                }
+#if NVRHI_WITH_NVAPI_LSS
+                else if (geometryDesc.geometryType == rt::GeometryType::Spheres)
                 {
-                    requireBufferState(aabbs.buffer, ResourceStates::AccelStructBuildInput);
+                    const auto& spheres = geometryDesc.geometryData.spheres;
+
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        if (spheres.indexBuffer)
+                        {
+                            requireBufferState(spheres.indexBuffer, ResourceStates::AccelStructBuildInput);
+                        }
+                        requireBufferState(spheres.vertexBuffer, ResourceStates::AccelStructBuildInput);
+                    }
+
+                    m_Instance->referencedResources.push_back(spheres.indexBuffer);
+                    m_Instance->referencedResources.push_back(spheres.vertexBuffer);
                 }
+                else if (geometryDesc.geometryType == rt::GeometryType::Lss)
+                {
+                    const auto& lss = geometryDesc.geometryData.lss;
+
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        if (lss.indexBuffer)
+                        {
+                            requireBufferState(lss.indexBuffer, ResourceStates::AccelStructBuildInput);
+                        }
+                        requireBufferState(lss.vertexBuffer, ResourceStates::AccelStructBuildInput);
+                    }
 
-                m_Instance->referencedResources.push_back(aabbs.buffer);
+                    m_Instance->referencedResources.push_back(lss.indexBuffer);
+                    m_Instance->referencedResources.push_back(lss.vertexBuffer);
+                }
+#endif
             }
-#if NVRHI_WITH_NVAPI_LSS
-            else if (geometryDesc.geometryType == rt::GeometryType::Spheres)
+
+            D3D12BuildRaytracingAccelerationStructureInputs& inputs = buildInputs[buildIndex];
+            inputs.SetType(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL);
+            if (as->allowUpdate)
+                inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)buildFlags | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE);
+            else
+                inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)buildFlags);
+
+            inputs.SetGeometryDescCount((UINT)numGeometries);
+            bool hasOMM = false;
+            for (uint32_t i = 0; i < numGeometries; i++)
             {
-                const auto& spheres = geometryDesc.geometryData.spheres;
+                const auto& geometryDesc = pGeometries[i];
 
-                if (m_EnableAutomaticBarriers)
+                D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
+                if (geometryDesc.useTransform)
                 {
-                    if (spheres.indexBuffer)
+                    void* cpuVA = nullptr;
+                    if (!m_UploadManager.suballocateBuffer(sizeof(rt::AffineTransform), nullptr, nullptr, nullptr,
+                        &cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_TRANSFORM3X4_BYTE_ALIGNMENT))
                     {
-                        requireBufferState(spheres.indexBuffer, ResourceStates::AccelStructBuildInput);
+                        m_Context.error("Couldn't suballocate an upload buffer");
+                        return;
                     }
-                    requireBufferState(spheres.vertexBuffer, ResourceStates::AccelStructBuildInput);
+
+                    memcpy(cpuVA, &geometryDesc.transform, sizeof(rt::AffineTransform));
                 }
 
-                m_Instance->referencedResources.push_back(spheres.indexBuffer);
-                m_Instance->referencedResources.push_back(spheres.vertexBuffer);
+                D3D12RaytracingGeometryDesc& geomDesc = inputs.GetGeometryDesc(i);
+                fillD3dGeometryDesc(geomDesc, geometryDesc, gpuVA);
+                if (geometryDesc.geometryData.triangles.opacityMicromap != nullptr)
+                {
+                    hasOMM = true;
+                }
             }
-            else if (geometryDesc.geometryType == rt::GeometryType::Lss)
+#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
+            if (hasOMM)
             {
-                const auto& lss = geometryDesc.geometryData.lss;
+                inputs.SetOMMDescCount((uint32_t)numGeometries);
 
-                if (m_EnableAutomaticBarriers)
+                for (uint32_t i = 0; i < numGeometries; i++)
                 {
-                    if (lss.indexBuffer)
-                    {
-                        requireBufferState(lss.indexBuffer, ResourceStates::AccelStructBuildInput);
-                    }
-                    requireBufferState(lss.vertexBuffer, ResourceStates::AccelStructBuildInput);
+                    const rt::GeometryDesc& srcDesc = pGeometries[i];
+                    D3D12_RAYTRACING_GEOMETRY_OMM_LINKAGE_DESC& outLinkage = inputs.GetOMMLinkageDesc(i);
+                    fillD3dGeometryOMMLinkageDesc(outLinkage, srcDesc);
                 }
-
-                m_Instance->referencedResources.push_back(lss.indexBuffer);
-                m_Instance->referencedResources.push_back(lss.vertexBuffer);
             }
 #endif
         }
@@ -1988,158 +2602,240 @@ namespace nvrhi::d3d12
         }
         commitBarriers();
 
-        D3D12BuildRaytracingAccelerationStructureInputs inputs;
-        inputs.SetType(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL);
-        if (as->allowUpdate)
-            inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)buildFlags | D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE);
-        else
-            inputs.SetFlags((D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)buildFlags);
-
-        inputs.SetGeometryDescCount((UINT)numGeometries);
-        bool hasOMM = false;
-        for (uint32_t i = 0; i < numGeometries; i++)
+#ifdef NVRHI_WITH_RTXMU
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            const auto& geometryDesc = pGeometries[i];
+            AccelStruct* as = checked_cast<AccelStruct*>(builds[buildIndex].accelStruct);
 
-            D3D12_GPU_VIRTUAL_ADDRESS gpuVA = 0;
-            if (geometryDesc.useTransform)
+            std::vector<uint64_t> accelStructsToBuild;
+            std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> rtxmuInputs;
+            rtxmuInputs.push_back(buildInputs[buildIndex].GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>());
+
+            if(as->rtxmuId == ~0ull)
             {
-                void* cpuVA = nullptr;
-                if (!m_UploadManager.suballocateBuffer(sizeof(rt::AffineTransform), nullptr, nullptr, nullptr,
-                    &cpuVA, &gpuVA, m_RecordingVersion, D3D12_RAYTRACING_TRANSFORM3X4_BYTE_ALIGNMENT))
-                {
-                    m_Context.error("Couldn't suballocate an upload buffer");
-                    return;
-                }
+                m_Context.rtxMemUtil->PopulateBuildCommandList(m_ActiveCommandList->commandList4.Get(),
+                                                               rtxmuInputs.data(),
+                                                               rtxmuInputs.size(),
+                                                               accelStructsToBuild);
 
-                memcpy(cpuVA, &geometryDesc.transform, sizeof(rt::AffineTransform));
-            }
+                as->rtxmuId = accelStructsToBuild[0];
 
-            D3D12RaytracingGeometryDesc& geomDesc = inputs.GetGeometryDesc(i);
-            fillD3dGeometryDesc(geomDesc, geometryDesc, gpuVA);
-            if (geometryDesc.geometryData.triangles.opacityMicromap != nullptr)
-            {
-                hasOMM = true;
-            }
-        }
-#if NVRHI_D3D12_WITH_DXR12_OPACITY_MICROMAP
-        if (hasOMM)
-        {
-            inputs.SetOMMDescCount((uint32_t)numGeometries);
+                as->rtxmuGpuVA = m_Context.rtxMemUtil->GetAccelStructGPUVA(as->rtxmuId);
 
-            for (uint32_t i = 0; i < numGeometries; i++)
+                m_Instance->rtxmuBuildIds.push_back(as->rtxmuId);
+
+            }
+            else
             {
-                const rt::GeometryDesc& srcDesc = pGeometries[i];
-                D3D12_RAYTRACING_GEOMETRY_OMM_LINKAGE_DESC& outLinkage = inputs.GetOMMLinkageDesc(i);
-                fillD3dGeometryOMMLinkageDesc(outLinkage, srcDesc);
+                std::vector<uint64_t> buildsToUpdate(1, as->rtxmuId);
+
+                m_Context.rtxMemUtil->PopulateUpdateCommandList(m_ActiveCommandList->commandList4.Get(),
+                                                                rtxmuInputs.data(),
+                                                                uint32_t(rtxmuInputs.size()),
+                                                                buildsToUpdate);
             }
         }
-#endif
-
-#ifdef NVRHI_WITH_RTXMU
-        std::vector<uint64_t> accelStructsToBuild;
-        std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> buildInputs;
-        buildInputs.push_back(inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>());
+#else
+        // The scratch memory of each group of builds is placed into one allocation, so that the builds can run concurrently
+        std::vector<uint64_t> scratchSizes(numBuilds);
+        std::vector<uint64_t> scratchOffsets(numBuilds);
 
-        if(as->rtxmuId == ~0ull)
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            m_Context.rtxMemUtil->PopulateBuildCommandList(m_ActiveCommandList->commandList4.Get(),
-                                                           buildInputs.data(),
-                                                           buildInputs.size(),
-                                                           accelStructsToBuild);
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+            const bool performUpdate = (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
 
-            as->rtxmuId = accelStructsToBuild[0];
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
 
-            as->rtxmuGpuVA = m_Context.rtxMemUtil->GetAccelStructGPUVA(as->rtxmuId);
+            if (!checked_cast<d3d12::Device*>(m_Device)->GetAccelStructPreBuildInfo(ASPreBuildInfo, as->getDesc()))
+                return;
 
-            m_Instance->rtxmuBuildIds.push_back(as->rtxmuId);
+            if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataBuffer->desc.byteSize)
+            {
+                std::stringstream ss;
+                ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
+                    << ASPreBuildInfo.ResultDataMaxSizeInBytes << " bytes in the data buffer, while the allocated buffer is only "
+                    << as->dataBuffer->desc.byteSize << " bytes";
 
-        }
-        else
-        {
-            std::vector<uint64_t> buildsToUpdate(1, as->rtxmuId);
+                m_Context.error(ss.str());
+                return;
+            }
 
-            m_Context.rtxMemUtil->PopulateUpdateCommandList(m_ActiveCommandList->commandList4.Get(),
-                                                            buildInputs.data(),
-                                                            uint32_t(buildInputs.size()),
-                                                            buildsToUpdate);
+            scratchSizes[buildIndex] = performUpdate
+                ? ASPreBuildInfo.UpdateScratchDataSizeInBytes
+                : ASPreBuildInfo.ScratchDataSizeInBytes;
         }
-#else
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO ASPreBuildInfo = {};
 
-        if (!checked_cast<d3d12::Device*>(m_Device)->GetAccelStructPreBuildInfo(ASPreBuildInfo, as->getDesc()))
-            return;
-
-        if (ASPreBuildInfo.ResultDataMaxSizeInBytes > as->dataBuffer->desc.byteSize)
+        // The BLAS'es that can be compacted write their compacted sizes into the device's size buffer
+        std::vector<AccelStruct*> compactedSizeWrites;
+        std::vector<bool> writesCompactedSize(numBuilds, false);
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            std::stringstream ss;
-            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
-                << ASPreBuildInfo.ResultDataMaxSizeInBytes << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->desc.byteSize << " bytes";
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
 
-            m_Context.error(ss.str());
-            return;
+            if (as->compactedSizeQuery >= 0 && (build.buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0
+                && (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) == 0)
+            {
+                compactedSizeWrites.push_back(as);
+                writesCompactedSize[buildIndex] = true;
+            }
         }
 
-        uint64_t scratchSize = performUpdate
-            ? ASPreBuildInfo.UpdateScratchDataSizeInBytes
-            : ASPreBuildInfo.ScratchDataSizeInBytes;
-
-        D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (!m_DxrScratchManager.suballocateBuffer(scratchSize, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
-            &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
-        {
-            std::stringstream ss;
-            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
-                "The build requires " << scratchSize << " bytes of scratch space.";
-
-            m_Context.error(ss.str());
-            return;
-        }
+        Buffer* compactedSizeBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeBuffer.Get());
 
         if (m_EnableAutomaticBarriers)
         {
-            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+                requireBufferState(checked_cast<AccelStruct*>(builds[buildIndex].accelStruct)->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
             m_BindingStatesDirty = true;
         }
+        if (!compactedSizeWrites.empty())
+            requireBufferState(compactedSizeBuffer, nvrhi::ResourceStates::UnorderedAccess);
         commitBarriers();
 
+        // Split the builds into groups whose scratch memory fits into the scratch memory limit. The builds within a group
+        // use disjoint scratch and data memory, so they are issued back to back without UAV barriers. Different groups
+        // may reuse the same scratch memory, so they are separated by UAV barriers.
+        const uint64_t scratchLimit = m_Desc.scratchMaxMemory > 0 ? uint64_t(m_Desc.scratchMaxMemory) : UINT64_MAX;
+        uint64_t groupScratchLimit = scratchLimit;
+        size_t groupBegin = 0;
+        bool issuedBuilds = false;
+
+        while (groupBegin < numBuilds)
+        {
+            uint64_t groupScratchSize = 0;
+            const size_t groupEnd = placeScratchGroup(scratchSizes, groupBegin, groupScratchLimit, scratchOffsets, groupScratchSize);
+
+            D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
+            if (!m_DxrScratchManager.suballocateBuffer(groupScratchSize, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
+                &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
+            {
+                if (groupEnd - groupBegin > 1)
+                {
+                    // The scratch memory may be available in smaller chunks only, try again with fewer builds
+                    groupScratchLimit = groupScratchSize / 2;
+                    continue;
+                }
+
+                AccelStruct* as = checked_cast<AccelStruct*>(builds[groupBegin].accelStruct);
+
+                std::stringstream ss;
+                ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
+                    << "The build requires " << groupScratchSize << " bytes of scratch space.";
+                m_Context.error(ss.str());
+
+                // Skip this build, the size it would write must not be used for compaction
+                if (writesCompactedSize[groupBegin])
+                {
+                    writesCompactedSize[groupBegin] = false;
+                    compactedSizeWrites.erase(std::find(compactedSizeWrites.begin(), compactedSizeWrites.end(), as));
+                }
+
+                groupBegin = groupEnd;
+                groupScratchLimit = scratchLimit;
+                continue;
+            }
+
+            if (issuedBuilds)
+            {
+                D3D12_RESOURCE_BARRIER barrier = {};
+                barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+                barrier.UAV.pResource = nullptr;
+                m_ActiveCommandList->commandList->ResourceBarrier(1, &barrier);
+            }
+
+            for (size_t buildIndex = groupBegin; buildIndex < groupEnd; buildIndex++)
+            {
+                const rt::BlasBuildDesc& build = builds[buildIndex];
+                AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+                const bool performUpdate = (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+                const D3D12BuildRaytracingAccelerationStructureInputs& inputs = buildInputs[buildIndex];
+                const D3D12_GPU_VIRTUAL_ADDRESS buildScratchGpuVA = scratchGpuVA + scratchOffsets[buildIndex];
+
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfo = {};
+                UINT numPostbuildInfoDescs = 0;
+                if (writesCompactedSize[buildIndex])
+                {
+                    postbuildInfo.DestBuffer = compactedSizeBuffer->gpuVA
+                        + uint64_t(as->compactedSizeQuery) * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+                    postbuildInfo.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+                    numPostbuildInfoDescs = 1;
+                }
+
 #if NVRHI_WITH_NVAPI_OPACITY_MICROMAP || NVRHI_WITH_NVAPI_LSS
-        d3d12::Device* d3d12Device = checked_cast<d3d12::Device*>(m_Device);
-        if (d3d12Device->GetOpacityMicromapSupported() || d3d12Device->GetLinearSweptSpheresSupported())
-        {
-            NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC_EX buildDesc = {};
-            buildDesc.inputs = inputs.GetAs<NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX>();
-            buildDesc.scratchAccelerationStructureData = scratchGpuVA;
-            buildDesc.destAccelerationStructureData = as->dataBuffer->gpuVA;
-            buildDesc.sourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
-
-            NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS params = {};
-            params.version = NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS_VER;
-            params.pDesc = &buildDesc;
-            params.numPostbuildInfoDescs = 0;
-            params.pPostbuildInfoDescs = nullptr;
-            [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingAccelerationStructureEx(m_ActiveCommandList->commandList4, &params);
-            assert(status == S_OK);
-        }
-        else
+                d3d12::Device* d3d12Device = checked_cast<d3d12::Device*>(m_Device);
+                if (d3d12Device->GetOpacityMicromapSupported() || d3d12Device->GetLinearSweptSpheresSupported())
+                {
+                    NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC_EX buildDesc = {};
+                    buildDesc.inputs = inputs.GetAs<NVAPI_D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS_EX>();
+                    buildDesc.scratchAccelerationStructureData = buildScratchGpuVA;
+                    buildDesc.destAccelerationStructureData = as->dataBuffer->gpuVA;
+                    buildDesc.sourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
+
+                    NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS params = {};
+                    params.version = NVAPI_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_EX_PARAMS_VER;
+                    params.pDesc = &buildDesc;
+                    params.numPostbuildInfoDescs = numPostbuildInfoDescs;
+                    params.pPostbuildInfoDescs = numPostbuildInfoDescs ? &postbuildInfo : nullptr;
+                    [[maybe_unused]] NvAPI_Status status = NvAPI_D3D12_BuildRaytracingAccelerationStructureEx(m_ActiveCommandList->commandList4, &params);
+                    assert(status == S_OK);
+                }
+                else
 #endif
+                {
+                    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+                    buildDesc.Inputs = inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>();
+                    buildDesc.ScratchAccelerationStructureData = buildScratchGpuVA;
+                    buildDesc.DestAccelerationStructureData = as->dataBuffer->gpuVA;
+                    buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
+                    m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc,
+                        numPostbuildInfoDescs, numPostbuildInfoDescs ? &postbuildInfo : nullptr);
+                }
+            }
+
+            issuedBuilds = true;
+            groupBegin = groupEnd;
+            groupScratchLimit = scratchLimit;
+        }
+
+        if (!compactedSizeWrites.empty())
         {
-            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
-            buildDesc.Inputs = inputs.GetAs<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS>();
-            buildDesc.ScratchAccelerationStructureData = scratchGpuVA;
-            buildDesc.DestAccelerationStructureData = as->dataBuffer->gpuVA;
-            buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
-            m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+            // Copy the sizes into the readback buffer, compactBottomLevelAccelStructs reads them
+            // after this command list has finished executing
+            Buffer* readbackBuffer = checked_cast<Buffer*>(m_Resources.compactedSizeReadbackBuffer.Get());
+
+            requireBufferState(compactedSizeBuffer, nvrhi::ResourceStates::CopySource);
+            requireBufferState(readbackBuffer, nvrhi::ResourceStates::CopyDest);
+            commitBarriers();
+
+            for (AccelStruct* as : compactedSizeWrites)
+            {
+                const uint64_t offset = uint64_t(as->compactedSizeQuery)
+                    * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+
+                m_ActiveCommandList->commandList->CopyBufferRegion(readbackBuffer->resource, offset,
+                    compactedSizeBuffer->resource, offset,
+                    sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC));
+
+                m_Instance->accelStructsToCompact.push_back(as);
+            }
         }
 #endif // NVRHI_WITH_RTXMU
 
-        if (as->desc.trackLiveness)
-            m_Instance->referencedResources.push_back(as);
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            AccelStruct* as = checked_cast<AccelStruct*>(builds[buildIndex].accelStruct);
+            if (as->desc.trackLiveness)
+                m_Instance->referencedResources.push_back(as);
+        }
     }
 
     void CommandList::compactBottomLevelAccelStructs()
     {
+        endRenderPass();
+
 #ifdef NVRHI_WITH_RTXMU
 
         if (!m_Resources.asBuildsCompleted.empty())
@@ -2155,11 +2851,60 @@ namespace nvrhi::d3d12
                 m_Resources.asBuildsCompleted.clear();
             }
         }
+#else
+        // Hold the lock while the candidates are processed, the AccelStruct destructor removes them from the list
+        std::lock_guard lockGuard(m_Resources.asCompactionMutex);
+
+        if (m_Resources.asCompactionCandidates.empty())
+            return;
+
+        for (AccelStruct* as : m_Resources.asCompactionCandidates)
+        {
+            // The build command list has finished, so the size is already in the readback buffer
+            const uint64_t compactedSize = m_Resources.compactedSizes[as->compactedSizeQuery];
+            as->compactionPending = false;
+
+            // The query slot is kept when the BLAS is not compacted, so that a later build can make it a candidate again
+            if (compactedSize == 0 || compactedSize >= as->dataBuffer->desc.byteSize)
+                continue;
+
+            BufferDesc bufferDesc = as->dataBuffer->desc;
+            bufferDesc.byteSize = compactedSize;
+            BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+            if (!buffer)
+                continue;
+
+            Buffer* compactedBuffer = checked_cast<Buffer*>(buffer.Get());
+
+            m_ActiveCommandList->commandList4->CopyRaytracingAccelerationStructure(compactedBuffer->gpuVA, as->dataBuffer->gpuVA,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+            // Keep the original storage alive until the copy has finished
+            m_Instance->referencedResources.push_back(as->dataBuffer);
+            as->dataBuffer = compactedBuffer;
+            as->compacted = true;
+
+            m_Resources.compactedSizeQueries.release(as->compactedSizeQuery);
+            as->compactedSizeQuery = -1;
+
+            if (as->desc.trackLiveness)
+                m_Instance->referencedResources.push_back(as);
+        }
+
+        m_Resources.asCompactionCandidates.clear();
+
+        // Make the compacted BLAS'es visible to the TLAS builds that follow
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barrier.UAV.pResource = nullptr;
+        m_ActiveCommandList->commandList->ResourceBarrier(1, &barrier);
 #endif
     }
 
     void CommandList::buildTopLevelAccelStructInternal(AccelStruct* as, D3D12_GPU_VIRTUAL_ADDRESS instanceData, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
     {
+        endRenderPass();
+
         // Remove the internal flag
         buildFlags = buildFlags & ~rt::AccelStructBuildFlags::AllowEmptyInstances;
 
@@ -2168,7 +2913,7 @@ namespace nvrhi::d3d12
         if (performUpdate)
         {
             assert(as->allowUpdate);
-            assert(as->dxrInstances.size() == numInstances); // DXR doesn't allow updating to a different instance count
+            assert(as->builtInstances == numInstances); // DXR doesn't allow updating to a different instance count
         }
 
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS ASInputs;
@@ -2217,6 +2962,8 @@ namespace nvrhi::d3d12
         buildDesc.SourceAccelerationStructureData = performUpdate ? as->dataBuffer->gpuVA : 0;
 
         m_ActiveCommandList->commandList4->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+
+        as->builtInstances = numInstances;
     }
 
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -2313,9 +3060,61 @@ namespace nvrhi::d3d12
             m_Instance->referencedResources.push_back(as);
     }
 
+    void CommandList::updateTopLevelAccelStructInstances(rt::IAccelStruct* _as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (!as->instanceBuffer || numInstances == 0)
+            return;
+
+        std::vector<D3D12_RAYTRACING_INSTANCE_DESC> dxrInstances(numInstances);
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            const rt::InstanceDesc& instance = pInstances[i];
+            D3D12_RAYTRACING_INSTANCE_DESC& dxrInstance = dxrInstances[i];
+            rt::AccelStructHandle blasReference;
+
+            static_assert(sizeof(dxrInstance) == sizeof(instance));
+            memcpy(&dxrInstance, &instance, sizeof(instance));
+
+            if (instance.bottomLevelAS)
+            {
+                AccelStruct* blas = checked_cast<AccelStruct*>(instance.bottomLevelAS);
+
+#ifdef NVRHI_WITH_RTXMU
+                dxrInstance.AccelerationStructure = m_Context.rtxMemUtil->GetAccelStructGPUVA(blas->rtxmuId);
+#else
+                dxrInstance.AccelerationStructure = blas->dataBuffer->gpuVA;
+
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+                }
+#endif
+                if (blas->desc.trackLiveness)
+                    blasReference = blas;
+            }
+            else // !instance.bottomLevelAS
+            {
+                dxrInstance.AccelerationStructure = 0;
+            }
+
+            if (!as->instanceBufferBLASes.empty())
+                as->instanceBufferBLASes[firstInstance + i] = blasReference;
+        }
+
+        writeBuffer(as->instanceBuffer, dxrInstances.data(), dxrInstances.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC),
+            firstInstance * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+
+        if (as->desc.trackLiveness)
+            m_Instance->referencedResources.push_back(as);
+    }
 
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
+        endRenderPass();
+
 #if NVRHI_WITH_NVAPI_CLUSTERS
         // Early out: no acceleration structures to build, instantiate, or move
         if (desc.params.maxArgCount == 0) return;
@@ -2344,8 +3143,14 @@ namespace nvrhi::d3d12
         Buffer* inIndirectArgCountBuffer = checked_cast<Buffer*>(desc.inIndirectArgCountBuffer);
         Buffer* inIndirectArgsBuffer = checked_cast<Buffer*>(desc.inIndirectArgsBuffer);
 
+        Buffer* scratchBuffer = checked_cast<Buffer*>(desc.scratchBuffer);
+
         D3D12_GPU_VIRTUAL_ADDRESS scratchGpuVA = 0;
-        if (!m_DxrScratchManager.suballocateBuffer(desc.scratchSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
+        if (scratchBuffer)
+        {
+            scratchGpuVA = scratchBuffer->gpuVA + desc.scratchOffsetInBytes;
+        }
+        else if (!m_DxrScratchManager.suballocateBuffer(desc.scratchSizeInBytes, m_ActiveCommandList->commandList, nullptr, nullptr, nullptr,
             &scratchGpuVA, m_RecordingVersion, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT))
         {
             const char* clusterOperationType = "Unknown";
@@ -2380,10 +3185,15 @@ namespace nvrhi::d3d12
                 requireBufferState(outAccelerationStructuresBuffer, ResourceStates::AccelStructWrite);
             if (outSizesBuffer)
                 requireBufferState(outSizesBuffer, ResourceStates::UnorderedAccess);
+            if (scratchBuffer)
+                requireBufferState(scratchBuffer, ResourceStates::UnorderedAccess);
             m_BindingStatesDirty = true;
         }
         commitBarriers();
 
+        if (scratchBuffer)
+            m_Instance->referencedResources.push_back(scratchBuffer);
+
         // Describe the cluster operation
         NVAPI_D3D12_RAYTRACING_MULTI_INDIRECT_CLUSTER_OPERATION_DESC d3d12Desc = {};
         d3d12Desc.inputs = inputs;
@@ -0,0 +1,199 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+
+#include <sstream>
+
+namespace nvrhi::d3d12
+{
+    static D3D12_RESIDENCY_PRIORITY convertResidencyPriority(ResidencyPriority priority)
+    {
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum: return D3D12_RESIDENCY_PRIORITY_MINIMUM;
+        case ResidencyPriority::Low:     return D3D12_RESIDENCY_PRIORITY_LOW;
+        case ResidencyPriority::Normal:  return D3D12_RESIDENCY_PRIORITY_NORMAL;
+        case ResidencyPriority::High:    return D3D12_RESIDENCY_PRIORITY_HIGH;
+        case ResidencyPriority::Maximum: return D3D12_RESIDENCY_PRIORITY_MAXIMUM;
+        default:
+            utils::InvalidEnum();
+            return D3D12_RESIDENCY_PRIORITY_NORMAL;
+        }
+    }
+
+    bool Device::getVideoMemoryBudget(VideoMemoryBudget& outBudget)
+    {
+        if (!m_Adapter)
+            return false;
+
+        DXGI_QUERY_VIDEO_MEMORY_INFO localInfo = {};
+        DXGI_QUERY_VIDEO_MEMORY_INFO nonLocalInfo = {};
+
+        if (FAILED(m_Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &localInfo)) ||
+            FAILED(m_Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &nonLocalInfo)))
+            return false;
+
+        outBudget.localBudget = localInfo.Budget;
+        outBudget.localUsage = localInfo.CurrentUsage;
+        outBudget.nonLocalBudget = nonLocalInfo.Budget;
+        outBudget.nonLocalUsage = nonLocalInfo.CurrentUsage;
+        return true;
+    }
+
+    MemoryStatistics Device::getMemoryStatistics()
+    {
+        MemoryStatistics statistics = m_Context.memoryStatistics->getStatistics();
+
+        MemoryCategoryStatistics& descriptorHeaps = statistics.get(MemoryCategory::DescriptorHeaps);
+        m_Resources.renderTargetViewHeap.getStatistics(descriptorHeaps);
+        m_Resources.depthStencilViewHeap.getStatistics(descriptorHeaps);
+        m_Resources.shaderResourceViewHeap.getStatistics(descriptorHeaps);
+        m_Resources.samplerHeap.getStatistics(descriptorHeaps);
+
+        return statistics;
+    }
+
+    void Device::setResidencyPriority(IResource* resource, ResidencyPriority priority)
+    {
+        ID3D12Pageable* pageable = nullptr;
+        if (resource)
+        {
+            pageable = resource->getNativeObject(ObjectTypes::D3D12_Heap);
+            if (!pageable)
+                pageable = resource->getNativeObject(ObjectTypes::D3D12_Resource);
+        }
+
+        if (!pageable)
+        {
+            m_Context.error("setResidencyPriority: the resource is not a texture, buffer or heap");
+            return;
+        }
+
+        m_Resources.residency.setPriority(getResidencyKey(pageable), priority);
+
+        RefCountPtr<ID3D12Device1> device1;
+        if (SUCCEEDED(m_Context.device->QueryInterface(&device1)))
+        {
+            const D3D12_RESIDENCY_PRIORITY residencyPriority = convertResidencyPriority(priority);
+            device1->SetResidencyPriority(1, &pageable, &residencyPriority);
+        }
+    }
+
+    void Device::makeReferencedResourcesResident(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        m_ResidencyKeys.clear();
+        m_ResidencyChanges.clear();
+
+        auto addResource = [this](IResource* resource)
+        {
+            if (!resource)
+                return;
+
+            if (ID3D12Resource* d3dResource = resource->getNativeObject(ObjectTypes::D3D12_Resource))
+            {
+                m_ResidencyKeys.push_back(getResidencyKey(d3dResource));
+            }
+            else if (BindingSet* bindingSet = dynamic_cast<BindingSet*>(resource))
+            {
+                // Binding sets without automatic barriers are the only reference to their resources
+                for (const auto& bindingResource : bindingSet->resources)
+                {
+                    if (!bindingResource)
+                        continue;
+
+                    if (ID3D12Resource* bindingD3DResource = bindingResource->getNativeObject(ObjectTypes::D3D12_Resource))
+                        m_ResidencyKeys.push_back(getResidencyKey(bindingD3DResource));
+                }
+            }
+        };
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            const CommandListInstance& instance = checked_cast<CommandList*>(pCommandLists[i])->getInstance();
+
+            for (const auto& resource : instance.referencedResources)
+                addResource(resource);
+
+            for (const auto& bundle : instance.referencedBundles)
+            {
+                for (const auto& resource : bundle->referencedResources)
+                    addResource(resource);
+            }
+        }
+
+        m_Resources.residency.markUsed(m_ResidencyKeys, m_ResidencyChanges);
+
+        if (m_ResidencyChanges.empty())
+            return;
+
+        m_ResidencyPageables.clear();
+        for (uint64_t key : m_ResidencyChanges)
+            m_ResidencyPageables.push_back(reinterpret_cast<ID3D12Pageable*>(key));
+
+        // Blocks until the allocations are resident, which they must be before the command lists execute
+        const HRESULT hr = m_Context.device->MakeResident(UINT(m_ResidencyPageables.size()), m_ResidencyPageables.data());
+        if (FAILED(hr))
+        {
+            std::stringstream ss;
+            ss << "MakeResident call failed for " << m_ResidencyPageables.size() << " objects, HRESULT = 0x"
+                << std::hex << hr;
+            m_Context.error(ss.str());
+        }
+    }
+
+    void Device::updateResidency()
+    {
+        VideoMemoryBudget budget;
+        if (!getVideoMemoryBudget(budget))
+            return;
+
+        if (budget.localUsage <= budget.localBudget)
+            return;
+
+        if (m_Resources.residency.isEnabled())
+        {
+            uint64_t completedInstances[size_t(CommandQueue::Count)] = {};
+            for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+            {
+                if (m_Queues[queue])
+                    completedInstances[queue] = m_Queues[queue]->lastCompletedInstance;
+            }
+
+            m_ResidencyChanges.clear();
+            m_Resources.residency.evict(budget.localUsage - budget.localBudget, completedInstances, m_ResidencyChanges);
+
+            if (!m_ResidencyChanges.empty())
+            {
+                m_ResidencyPageables.clear();
+                for (uint64_t key : m_ResidencyChanges)
+                    m_ResidencyPageables.push_back(reinterpret_cast<ID3D12Pageable*>(key));
+
+                m_Context.device->Evict(UINT(m_ResidencyPageables.size()), m_ResidencyPageables.data());
+            }
+        }
+
+        if (m_BudgetCallback)
+            m_BudgetCallback->budgetExceeded(budget);
+    }
+
+} // namespace nvrhi::d3d12
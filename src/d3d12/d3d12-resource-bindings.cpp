@@ -23,6 +23,7 @@
 #include "d3d12-backend.h"
 
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -66,15 +67,15 @@ namespace nvrhi::d3d12
         return false;
     }
     
-    void BindingSet::createDescriptors()
+    void BindingSet::createDescriptors(DescriptorIndex samplerTableBase, DescriptorIndex srvTableBase)
     {
         // Process the volatile constant buffers: they occupy one root parameter each
-        for (const std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>& parameter : layout->rootParametersVolatileCB)
+        for (const VolatileConstantBufferParameter& parameter : layout->rootParametersVolatileCB)
         {
             IBuffer* foundBuffer = nullptr;
 
-            RootParameterIndex rootParameterIndex = parameter.first;
-            const D3D12_ROOT_DESCRIPTOR1& rootDescriptor = parameter.second;
+            RootParameterIndex rootParameterIndex = parameter.rootParameterIndex;
+            const D3D12_ROOT_DESCRIPTOR1& rootDescriptor = parameter.descriptor;
 
             for (const auto& binding : desc.bindings)
             {
@@ -95,7 +96,9 @@ namespace nvrhi::d3d12
 
         if (layout->descriptorTableSizeSamplers > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.samplerHeap.allocateDescriptors(layout->descriptorTableSizeSamplers);
+            DescriptorIndex descriptorTableBaseIndex = (samplerTableBase != c_InvalidDescriptorIndex)
+                ? samplerTableBase
+                : m_Resources.samplerHeap.allocateDescriptors(layout->descriptorTableSizeSamplers);
             descriptorTableSamplers = descriptorTableBaseIndex;
             rootParameterIndexSamplers = layout->rootParameterSamplers;
             descriptorTableValidSamplers = true;
@@ -136,7 +139,9 @@ namespace nvrhi::d3d12
 
         if (layout->descriptorTableSizeSRVetc > 0)
         {
-            DescriptorIndex descriptorTableBaseIndex = m_Resources.shaderResourceViewHeap.allocateDescriptors(layout->descriptorTableSizeSRVetc);
+            DescriptorIndex descriptorTableBaseIndex = (srvTableBase != c_InvalidDescriptorIndex)
+                ? srvTableBase
+                : m_Resources.shaderResourceViewHeap.allocateDescriptors(layout->descriptorTableSizeSRVetc);
             descriptorTableSRVetc = descriptorTableBaseIndex;
             rootParameterIndexSRVetc = layout->rootParameterSRVetc;
             descriptorTableValidSRVetc = true;
@@ -365,6 +370,102 @@ namespace nvrhi::d3d12
         return BindingSetHandle::Create(ret);
     }
 
+    // Sizes of the chunks that transient binding sets suballocate their descriptor tables from.
+    // The shader-visible sampler heap is limited to 2048 entries, so sampler chunks are kept small.
+    static constexpr uint32_t c_TransientSRVetcChunkSize = 1024;
+    static constexpr uint32_t c_TransientSamplerChunkSize = 64;
+
+    DescriptorIndex CommandList::allocateTransientDescriptors(StaticDescriptorHeap& heap, TransientDescriptorRing& ring, uint32_t count, uint32_t chunkSize)
+    {
+        if (ring.baseIndex == c_InvalidDescriptorIndex || ring.used + count > ring.capacity)
+        {
+            // Start a new chunk, the remainder of the current one is abandoned until the instance retires
+            const uint32_t capacity = std::max(count, chunkSize);
+            const DescriptorIndex baseIndex = heap.allocateDescriptors(capacity);
+            if (baseIndex == c_InvalidDescriptorIndex)
+                return c_InvalidDescriptorIndex;
+
+            TransientDescriptorChunk chunk;
+            chunk.heap = &heap;
+            chunk.baseIndex = baseIndex;
+            chunk.count = capacity;
+            m_Instance->transientDescriptorChunks.push_back(chunk);
+
+            ring.baseIndex = baseIndex;
+            ring.capacity = capacity;
+            ring.used = 0;
+        }
+
+        const DescriptorIndex result = ring.baseIndex + ring.used;
+        ring.used += count;
+        return result;
+    }
+
+    IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    {
+        if (!m_Instance)
+            return nullptr;
+
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        DescriptorIndex samplerTableBase = c_InvalidDescriptorIndex;
+        DescriptorIndex srvTableBase = c_InvalidDescriptorIndex;
+
+        if (layout->descriptorTableSizeSamplers > 0)
+        {
+            samplerTableBase = allocateTransientDescriptors(m_Resources.samplerHeap, m_TransientSamplerRing,
+                layout->descriptorTableSizeSamplers, c_TransientSamplerChunkSize);
+
+            if (samplerTableBase == c_InvalidDescriptorIndex)
+                return nullptr;
+        }
+
+        if (layout->descriptorTableSizeSRVetc > 0)
+        {
+            srvTableBase = allocateTransientDescriptors(m_Resources.shaderResourceViewHeap, m_TransientSRVetcRing,
+                layout->descriptorTableSizeSRVetc, c_TransientSRVetcChunkSize);
+
+            if (srvTableBase == c_InvalidDescriptorIndex)
+                return nullptr;
+        }
+
+        // The set objects are reused after the instances that used them are destroyed,
+        // so that transient sets don't create objects or take references in the steady state
+        if (m_FreeTransientBindingSets.empty())
+        {
+            std::lock_guard lockGuard(m_TransientBindingSetPool->mutex);
+            m_FreeTransientBindingSets.swap(m_TransientBindingSetPool->freeSets);
+        }
+
+        RefCountPtr<BindingSet> bindingSet;
+        if (!m_FreeTransientBindingSets.empty())
+        {
+            bindingSet = std::move(m_FreeTransientBindingSets.back());
+            m_FreeTransientBindingSets.pop_back();
+        }
+        else
+        {
+            bindingSet = RefCountPtr<BindingSet>::Create(new BindingSet(m_Context, m_Resources));
+            bindingSet->isTransient = true;
+        }
+
+        bindingSet->desc = desc;
+        // The instance keeps the set alive, binding it doesn't need to add a reference
+        bindingSet->desc.trackLiveness = false;
+        bindingSet->layout = layout;
+
+        bindingSet->createDescriptors(samplerTableBase, srvTableBase);
+
+        // The instance holds the set for exactly as long as its descriptors live
+        if (!m_Instance->transientBindingSetPool)
+            m_Instance->transientBindingSetPool = m_TransientBindingSetPool;
+
+        BindingSet* result = bindingSet;
+        m_Instance->transientBindingSets.push_back(std::move(bindingSet));
+
+        return result;
+    }
+
     DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
     {
         (void)layout; // not necessary on DX12
@@ -376,8 +477,22 @@ namespace nvrhi::d3d12
         return DescriptorTableHandle::Create(ret);
     }
 
+    void BindingSet::resetTransient()
+    {
+        layout = nullptr;
+        descriptorTableValidSRVetc = false;
+        descriptorTableValidSamplers = false;
+        hasUavBindings = false;
+        rootParametersVolatileCB.resize(0);
+        resources.clear();
+        bindingsThatNeedTransitions.clear();
+    }
+
     BindingSet::~BindingSet()
     {
+        if (isTransient)
+            return;
+
         m_Resources.shaderResourceViewHeap.releaseDescriptors(descriptorTableSRVetc, layout->descriptorTableSizeSRVetc);
     
         m_Resources.samplerHeap.releaseDescriptors(descriptorTableSamplers, layout->descriptorTableSizeSamplers);
@@ -401,17 +516,17 @@ namespace nvrhi::d3d12
         {
             if (binding.type == ResourceType::VolatileConstantBuffer)
             {
-                D3D12_ROOT_DESCRIPTOR1 rootDescriptor;
-                rootDescriptor.ShaderRegister = binding.slot;
-                rootDescriptor.RegisterSpace = desc.registerSpace;
+                VolatileConstantBufferParameter& parameter = rootParametersVolatileCB.emplace_back();
+                parameter.descriptor.ShaderRegister = binding.slot;
+                parameter.descriptor.RegisterSpace = desc.registerSpace;
 
                 // Volatile CBs are static descriptors, however strange that may seem.
                 // A volatile CB can only be bound to a command list after it's been written into, and 
                 // after that the data will not change until the command list has finished executing.
                 // Subsequent writes will be made into a newly allocated portion of an upload buffer.
-                rootDescriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+                parameter.descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
 
-                rootParametersVolatileCB.push_back(std::make_pair(-1, rootDescriptor));
+                parameter.numInlineConstants = binding.numInlineConstants;
             }
             else if (binding.type == ResourceType::PushConstants)
             {
@@ -420,6 +535,11 @@ namespace nvrhi::d3d12
                 rootConstants.RegisterSpace = desc.registerSpace;
                 rootConstants.Num32BitValues = binding.size / 4;
             }
+            else if (binding.type == ResourceType::InlineUniformBlock)
+            {
+                // Vulkan only, the validation layer reports them on other APIs
+                continue;
+            }
             else if (!AreResourceTypesCompatible(binding.type, currentType) || binding.slot != currentSlot + 1)
             {
                 // Start a new range
@@ -534,16 +654,27 @@ namespace nvrhi::d3d12
             rootParameterPushConstants = RootParameterIndex(rootParameters.size() - 1);
         }
 
-        for (std::pair<RootParameterIndex, D3D12_ROOT_DESCRIPTOR1>& rootParameterVolatileCB : rootParametersVolatileCB)
+        for (VolatileConstantBufferParameter& rootParameterVolatileCB : rootParametersVolatileCB)
         {
             rootParameters.resize(rootParameters.size() + 1);
             D3D12_ROOT_PARAMETER1& param = rootParameters[rootParameters.size() - 1];
 
-            param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
             param.ShaderVisibility = convertShaderStage(desc.visibility);
-            param.Descriptor = rootParameterVolatileCB.second;
 
-            rootParameterVolatileCB.first = RootParameterIndex(rootParameters.size() - 1);
+            if (rootParameterVolatileCB.numInlineConstants)
+            {
+                param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+                param.Constants.ShaderRegister = rootParameterVolatileCB.descriptor.ShaderRegister;
+                param.Constants.RegisterSpace = rootParameterVolatileCB.descriptor.RegisterSpace;
+                param.Constants.Num32BitValues = rootParameterVolatileCB.numInlineConstants;
+            }
+            else
+            {
+                param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+                param.Descriptor = rootParameterVolatileCB.descriptor;
+            }
+
+            rootParameterVolatileCB.rootParameterIndex = RootParameterIndex(rootParameters.size() - 1);
         }
 
         if (descriptorTableSizeSamplers > 0)
@@ -751,6 +882,10 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        StableHasher serializedHasher;
+        serializedHasher.addBytes(rsBlob->GetBufferPointer(), rsBlob->GetBufferSize());
+        rootsig->serializedHash = serializedHasher.get();
+
         // Create the RS object
 
         res = m_Context.device->CreateRootSignature(0, rsBlob->GetBufferPointer(), rsBlob->GetBufferSize(), IID_PPV_ARGS(&rootsig->handle));
@@ -776,6 +911,8 @@ namespace nvrhi::d3d12
         
         hash_combine(hash, allowInputLayout ? 1u : 0u);
         
+        std::lock_guard lockGuard(m_Resources.rootsigCacheMutex);
+
         // Get a cached RS and AddRef it (if it exists)
         RefCountPtr<RootSignature> rootsig = m_Resources.rootsigCache[hash];
 
@@ -795,8 +932,9 @@ namespace nvrhi::d3d12
     RootSignature::~RootSignature()
     {
         // Remove the root signature from the cache
+        std::lock_guard lockGuard(m_Resources.rootsigCacheMutex);
         const auto it = m_Resources.rootsigCache.find(hash);
-        if (it != m_Resources.rootsigCache.end())
+        if (it != m_Resources.rootsigCache.end() && it->second == this)
             m_Resources.rootsigCache.erase(it);
     }
 
@@ -804,6 +942,64 @@ namespace nvrhi::d3d12
     {
         DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
 
+        if (!createDescriptorTableItem(descriptorTable, binding))
+            return false;
+
+        m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTable->firstDescriptor + binding.slot, 1);
+        return true;
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem* items, size_t numItems)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        // Create all descriptors in the CPU-only heap first
+        bool success = true;
+        std::vector<uint32_t> writtenSlots;
+        writtenSlots.reserve(numItems);
+        for (size_t index = 0; index < numItems; index++)
+        {
+            if (createDescriptorTableItem(descriptorTable, items[index]))
+                writtenSlots.push_back(items[index].slot);
+            else
+                success = false;
+        }
+
+        if (writtenSlots.empty())
+            return success;
+
+        // Copy them into the shader-visible heap with one call, merging adjacent slots into ranges
+        std::sort(writtenSlots.begin(), writtenSlots.end());
+
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> destRangeStarts;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> srcRangeStarts;
+        std::vector<UINT> rangeSizes;
+
+        size_t rangeStart = 0;
+        while (rangeStart < writtenSlots.size())
+        {
+            size_t rangeEnd = rangeStart + 1;
+            while (rangeEnd < writtenSlots.size() && writtenSlots[rangeEnd] <= writtenSlots[rangeEnd - 1] + 1)
+                ++rangeEnd;
+
+            const DescriptorIndex firstDescriptor = descriptorTable->firstDescriptor + writtenSlots[rangeStart];
+            destRangeStarts.push_back(m_Resources.shaderResourceViewHeap.getCpuHandleShaderVisible(firstDescriptor));
+            srcRangeStarts.push_back(m_Resources.shaderResourceViewHeap.getCpuHandle(firstDescriptor));
+            rangeSizes.push_back(writtenSlots[rangeEnd - 1] - writtenSlots[rangeStart] + 1);
+
+            rangeStart = rangeEnd;
+        }
+
+        m_Context.device->CopyDescriptors(
+            UINT(rangeSizes.size()), destRangeStarts.data(), rangeSizes.data(),
+            UINT(rangeSizes.size()), srcRangeStarts.data(), rangeSizes.data(),
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        return success;
+    }
+
+    bool Device::createDescriptorTableItem(DescriptorTable* descriptorTable, const BindingSetItem& binding)
+    {
         if (binding.slot >= descriptorTable->capacity)
             return false;
 
@@ -866,7 +1062,6 @@ namespace nvrhi::d3d12
             return false;
         }
 
-        m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorTable->firstDescriptor + binding.slot, 1);
         return true;
     }
 
@@ -910,6 +1105,42 @@ namespace nvrhi::d3d12
         descriptorTable->capacity = newSize;
     }
 
+    bool CommandList::setRootVolatileConstantBuffer(bool isGraphics, uint32_t rootParameterIndex, uint32_t numInlineConstants, VolatileConstantBufferState& state)
+    {
+        if (numInlineConstants)
+        {
+            if (!state.inlineDataSize)
+            {
+                std::stringstream ss;
+                ss << "Volatile constant buffer " << utils::DebugNameToString(state.buffer->desc.debugName)
+                    << " is bound as inline constants, but it was written with more than "
+                    << c_MaxInlineVolatileConstantBufferSize << " bytes of data";
+                m_Context.error(ss.str());
+                return false;
+            }
+
+            numInlineConstants = std::min(numInlineConstants, uint32_t(state.inlineData.size()));
+
+            if (isGraphics)
+                m_ActiveCommandList->commandList->SetGraphicsRoot32BitConstants(rootParameterIndex, numInlineConstants, state.inlineData.data(), 0);
+            else
+                m_ActiveCommandList->commandList->SetComputeRoot32BitConstants(rootParameterIndex, numInlineConstants, state.inlineData.data(), 0);
+
+            return true;
+        }
+
+        const D3D12_GPU_VIRTUAL_ADDRESS gpuVA = getVolatileConstantBufferGpuVA(state);
+        if (!gpuVA)
+            return false;
+
+        if (isGraphics)
+            m_ActiveCommandList->commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, gpuVA);
+        else
+            m_ActiveCommandList->commandList->SetComputeRootConstantBufferView(rootParameterIndex, gpuVA);
+
+        return true;
+    }
+
     void CommandList::setComputeBindings(
         const BindingSetVector& bindings, uint32_t bindingUpdateMask,
         IBuffer* indirectParams, bool updateIndirectParams,
@@ -949,9 +1180,9 @@ namespace nvrhi::d3d12
 
                             if (buffer->desc.isVolatile)
                             {
-                                D3D12_GPU_VIRTUAL_ADDRESS volatileData = m_VolatileConstantBufferAddresses[buffer];
+                                VolatileConstantBufferState* volatileState = getVolatileConstantBufferState(buffer, false);
 
-                                if (!volatileData)
+                                if (!volatileState)
                                 {
                                     std::stringstream ss;
                                     ss << "Attempted use of a volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName)
@@ -961,12 +1192,25 @@ namespace nvrhi::d3d12
                                     continue;
                                 }
 
-                                if (updateThisSet || volatileData != m_CurrentComputeVolatileCBs[newVolatileCBs.size()].address)
+                                const uint32_t numInlineConstants = bindingSet->layout->rootParametersVolatileCB[volatileCbIndex].numInlineConstants;
+
+                                const size_t currentIndex = newVolatileCBs.size();
+                                if (updateThisSet || currentIndex >= m_CurrentComputeVolatileCBs.size()
+                                    || m_CurrentComputeVolatileCBs[currentIndex].buffer != buffer
+                                    || m_CurrentComputeVolatileCBs[currentIndex].version != volatileState->version)
                                 {
-                                    m_ActiveCommandList->commandList->SetComputeRootConstantBufferView(rootParameterIndex, volatileData);
+                                    setRootVolatileConstantBuffer(false, rootParameterIndex, numInlineConstants, *volatileState);
                                 }
 
-                                newVolatileCBs.push_back(VolatileConstantBufferBinding{ rootParameterIndex, buffer, volatileData });
+                                newVolatileCBs.push_back(VolatileConstantBufferBinding{ rootParameterIndex, buffer, numInlineConstants, volatileState->version });
+                            }
+                            else if (bindingSet->layout->rootParametersVolatileCB[volatileCbIndex].numInlineConstants)
+                            {
+                                // The validation layer reports this when the binding set is created
+                                std::stringstream ss;
+                                ss << "Constant buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                                    << " is bound to an inline constants slot, but it is not volatile";
+                                m_Context.error(ss.str());
                             }
                             else if (updateThisSet)
                             {
@@ -1075,9 +1319,9 @@ namespace nvrhi::d3d12
 
                             if (buffer->desc.isVolatile)
                             {
-                                const D3D12_GPU_VIRTUAL_ADDRESS volatileData = m_VolatileConstantBufferAddresses[buffer];
+                                VolatileConstantBufferState* volatileState = getVolatileConstantBufferState(buffer, false);
 
-                                if (!volatileData)
+                                if (!volatileState)
                                 {
                                     std::stringstream ss;
                                     ss << "Attempted use of a volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName)
@@ -1087,12 +1331,25 @@ namespace nvrhi::d3d12
                                     continue;
                                 }
 
-                                if (updateThisSet || volatileData != m_CurrentGraphicsVolatileCBs[newVolatileCBs.size()].address)
+                                const uint32_t numInlineConstants = bindingSet->layout->rootParametersVolatileCB[volatileCbIndex].numInlineConstants;
+
+                                const size_t currentIndex = newVolatileCBs.size();
+                                if (updateThisSet || currentIndex >= m_CurrentGraphicsVolatileCBs.size()
+                                    || m_CurrentGraphicsVolatileCBs[currentIndex].buffer != buffer
+                                    || m_CurrentGraphicsVolatileCBs[currentIndex].version != volatileState->version)
                                 {
-                                    m_ActiveCommandList->commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, volatileData);
+                                    setRootVolatileConstantBuffer(true, rootParameterIndex, numInlineConstants, *volatileState);
                                 }
 
-                                newVolatileCBs.push_back(VolatileConstantBufferBinding{ rootParameterIndex, buffer, volatileData });
+                                newVolatileCBs.push_back(VolatileConstantBufferBinding{ rootParameterIndex, buffer, numInlineConstants, volatileState->version });
+                            }
+                            else if (bindingSet->layout->rootParametersVolatileCB[volatileCbIndex].numInlineConstants)
+                            {
+                                // The validation layer reports this when the binding set is created
+                                std::stringstream ss;
+                                ss << "Constant buffer " << utils::DebugNameToString(buffer->desc.debugName)
+                                    << " is bound to an inline constants slot, but it is not volatile";
+                                m_Context.error(ss.str());
                             }
                             else if (updateThisSet)
                             {
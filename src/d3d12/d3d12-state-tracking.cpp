@@ -75,10 +75,25 @@ namespace nvrhi::d3d12
         }
     }
     
+    static void reportBundleStateConflict(const Context& context, const std::string& debugName)
+    {
+        std::stringstream ss;
+        ss << "Resource " << utils::DebugNameToString(debugName) << " is used in different states within the same "
+            "bundle, which requires a barrier that cannot be placed in a bundle";
+        context.error(ss.str());
+    }
+
     void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
 
+        if (m_Desc.isBundle)
+        {
+            if (!m_BundleStateRequirements.requireTextureState(texture, subresources, state))
+                reportBundleStateConflict(m_Context, texture->desc.debugName);
+            return;
+        }
+
         m_StateTracker.requireTextureState(texture, subresources, state);
     }
 
@@ -86,23 +101,47 @@ namespace nvrhi::d3d12
     {
         SamplerFeedbackTexture* texture = checked_cast<SamplerFeedbackTexture*>(_texture);
 
+        if (m_Desc.isBundle)
+        {
+            if (!m_BundleStateRequirements.requireTextureState(texture, AllSubresources, state))
+                reportBundleStateConflict(m_Context, texture->descRef.debugName);
+            return;
+        }
+
         m_StateTracker.requireTextureState(texture, AllSubresources, state);
     }
     
     void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
     {
-        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+        // Buffers packed into a shared resource are tracked as that resource
+        Buffer* buffer = checked_cast<Buffer*>(_buffer)->getTrackedBuffer();
+
+        if (m_Desc.isBundle)
+        {
+            if (!m_BundleStateRequirements.requireBufferState(buffer, state))
+                reportBundleStateConflict(m_Context, buffer->desc.debugName);
+            return;
+        }
 
         m_StateTracker.requireBufferState(buffer, state);
     }
 
-    void CommandList::commitBarriers()
+    void CommandList::commitBarriersInternal()
     {
         const auto& textureBarriers = m_StateTracker.getTextureBarriers();
         const auto& bufferBarriers = m_StateTracker.getBufferBarriers();
         const size_t barrierCount = textureBarriers.size() + bufferBarriers.size();
-        if (barrierCount == 0)
-            return;
+
+        auto convertSplitBarrierFlags = [](SplitBarrier split)
+        {
+            switch (split)
+            {
+            case SplitBarrier::Begin: return D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+            case SplitBarrier::End: return D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+            case SplitBarrier::None:
+            default: return D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            }
+        };
 
         // Allocate vector space for the barriers assuming 1:1 translation.
         // For partial transitions on multi-plane textures, original barriers may translate
@@ -132,6 +171,7 @@ namespace nvrhi::d3d12
             if (stateBefore != stateAfter)
             {
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                d3dbarrier.Flags = convertSplitBarrierFlags(barrier.split);
                 d3dbarrier.Transition.StateBefore = stateBefore;
                 d3dbarrier.Transition.StateAfter = stateAfter;
                 d3dbarrier.Transition.pResource = resource;
@@ -142,15 +182,23 @@ namespace nvrhi::d3d12
                 }
                 else
                 {
+                    // Transition barriers address one subresource each, expand the range
                     for (uint8_t plane = 0; plane < texture->planeCount; plane++)
                     {
-                        d3dbarrier.Transition.Subresource = calcSubresource(barrier.mipLevel, barrier.arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
-                        m_D3DBarriers.push_back(d3dbarrier);
+                        for (ArraySlice arraySlice = barrier.arraySlice; arraySlice < barrier.arraySlice + barrier.numArraySlices; arraySlice++)
+                        {
+                            for (MipLevel mipLevel = barrier.mipLevel; mipLevel < barrier.mipLevel + barrier.numMipLevels; mipLevel++)
+                            {
+                                d3dbarrier.Transition.Subresource = calcSubresource(mipLevel, arraySlice, plane, texture->desc.mipLevels, texture->desc.arraySize);
+                                m_D3DBarriers.push_back(d3dbarrier);
+                            }
+                        }
                     }
                 }
             }
-            else if (stateAfter & D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+            else if ((stateAfter & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) && barrier.split != SplitBarrier::Begin)
             {
+                // UAV barriers cannot be split, place one at the end of the transition
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
                 d3dbarrier.UAV.pResource = resource;
                 m_D3DBarriers.push_back(d3dbarrier);
@@ -170,12 +218,17 @@ namespace nvrhi::d3d12
                 (stateAfter & D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE) == 0)
             {
                 d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                d3dbarrier.Flags = convertSplitBarrierFlags(barrier.split);
                 d3dbarrier.Transition.StateBefore = stateBefore;
                 d3dbarrier.Transition.StateAfter = stateAfter;
                 d3dbarrier.Transition.pResource = buffer->resource;
                 d3dbarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
                 m_D3DBarriers.push_back(d3dbarrier);
             }
+            else if (barrier.split == SplitBarrier::Begin)
+            {
+                // UAV barriers cannot be split, the end of the transition will place one if necessary
+            }
             else if ((barrier.stateBefore == ResourceStates::AccelStructWrite && (barrier.stateAfter & (ResourceStates::AccelStructRead | ResourceStates::AccelStructBuildBlas)) != 0) ||
                 (barrier.stateAfter == ResourceStates::AccelStructWrite && (barrier.stateBefore & (ResourceStates::AccelStructRead | ResourceStates::AccelStructBuildBlas)) != 0) ||
                 (barrier.stateBefore == ResourceStates::OpacityMicromapWrite && (barrier.stateAfter & (ResourceStates::AccelStructBuildInput)) != 0) ||
@@ -189,6 +242,147 @@ namespace nvrhi::d3d12
 
         if (m_D3DBarriers.size() > 0)
             m_ActiveCommandList->commandList->ResourceBarrier(uint32_t(m_D3DBarriers.size()), m_D3DBarriers.data());
+    }
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+    static bool isWriteAccess(D3D12_BARRIER_ACCESS access)
+    {
+        // Common access may include any writes
+        if (access == D3D12_BARRIER_ACCESS_COMMON)
+            return true;
+
+        constexpr D3D12_BARRIER_ACCESS writeAccessMask = D3D12_BARRIER_ACCESS_UNORDERED_ACCESS
+            | D3D12_BARRIER_ACCESS_RENDER_TARGET
+            | D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE
+            | D3D12_BARRIER_ACCESS_STREAM_OUTPUT
+            | D3D12_BARRIER_ACCESS_COPY_DEST
+            | D3D12_BARRIER_ACCESS_RESOLVE_DEST
+            | D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE;
+
+        return (access & writeAccessMask) != 0;
+    }
+
+    void CommandList::commitBarriersInternal_enhanced()
+    {
+        m_D3DTextureBarriers.clear();
+        m_D3DBufferBarriers.clear();
+
+        for (const auto& barrier : m_StateTracker.getTextureBarriers())
+        {
+            const Texture* texture = nullptr;
+            ID3D12Resource* resource = nullptr;
+
+            if (barrier.texture->isSamplerFeedback)
+            {
+                resource = static_cast<const SamplerFeedbackTexture*>(barrier.texture)->resource;
+            }
+            else
+            {
+                texture = static_cast<const Texture*>(barrier.texture);
+                resource = texture->resource;
+            }
+
+            // Same as the legacy path: repeated states only need a barrier between UAV accesses
+            if (barrier.stateBefore == barrier.stateAfter && (barrier.stateAfter & ResourceStates::UnorderedAccess) == 0)
+                continue;
+
+            const BarrierStateMapping before = convertBarrierStates(barrier.stateBefore, true);
+            const BarrierStateMapping after = convertBarrierStates(barrier.stateAfter, true);
+
+            D3D12_TEXTURE_BARRIER d3dbarrier{};
+            // Split barriers use the SPLIT sync scope on the inner side of each half
+            d3dbarrier.SyncBefore = barrier.split == SplitBarrier::End ? D3D12_BARRIER_SYNC_SPLIT : before.sync;
+            d3dbarrier.SyncAfter = barrier.split == SplitBarrier::Begin ? D3D12_BARRIER_SYNC_SPLIT : after.sync;
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            // An undefined layout before the barrier would discard the contents, use common instead
+            d3dbarrier.LayoutBefore = before.layout != D3D12_BARRIER_LAYOUT_UNDEFINED ? before.layout : D3D12_BARRIER_LAYOUT_COMMON;
+            d3dbarrier.LayoutAfter = after.layout != D3D12_BARRIER_LAYOUT_UNDEFINED ? after.layout : D3D12_BARRIER_LAYOUT_COMMON;
+            d3dbarrier.pResource = resource;
+            d3dbarrier.Flags = D3D12_TEXTURE_BARRIER_FLAG_NONE;
+
+            if (barrier.entireTexture || !texture)
+            {
+                // NumMipLevels = 0 makes IndexOrFirstMipLevel a subresource index, and this one means all subresources
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+                d3dbarrier.Subresources.NumMipLevels = 0;
+            }
+            else
+            {
+                // Enhanced barriers address ranges of subresources directly
+                d3dbarrier.Subresources.IndexOrFirstMipLevel = barrier.mipLevel;
+                d3dbarrier.Subresources.NumMipLevels = barrier.numMipLevels;
+                d3dbarrier.Subresources.FirstArraySlice = barrier.arraySlice;
+                d3dbarrier.Subresources.NumArraySlices = barrier.numArraySlices;
+                d3dbarrier.Subresources.FirstPlane = 0;
+                d3dbarrier.Subresources.NumPlanes = texture->planeCount;
+            }
+
+            m_D3DTextureBarriers.push_back(d3dbarrier);
+        }
+
+        for (const auto& barrier : m_StateTracker.getBufferBarriers())
+        {
+            const Buffer* buffer = static_cast<const Buffer*>(barrier.buffer);
+
+            const BarrierStateMapping before = convertBarrierStates(barrier.stateBefore, false);
+            const BarrierStateMapping after = convertBarrierStates(barrier.stateAfter, false);
+
+            // Buffers have no layouts, so there is nothing to synchronize between two read-only accesses
+            if (!isWriteAccess(before.access) && !isWriteAccess(after.access))
+                continue;
+
+            D3D12_BUFFER_BARRIER d3dbarrier{};
+            d3dbarrier.SyncBefore = barrier.split == SplitBarrier::End ? D3D12_BARRIER_SYNC_SPLIT : before.sync;
+            d3dbarrier.SyncAfter = barrier.split == SplitBarrier::Begin ? D3D12_BARRIER_SYNC_SPLIT : after.sync;
+            d3dbarrier.AccessBefore = before.access;
+            d3dbarrier.AccessAfter = after.access;
+            d3dbarrier.pResource = buffer->resource;
+            d3dbarrier.Offset = 0;
+            d3dbarrier.Size = UINT64_MAX;
+
+            m_D3DBufferBarriers.push_back(d3dbarrier);
+        }
+
+        std::array<D3D12_BARRIER_GROUP, 2> barrierGroups{};
+        uint32_t numBarrierGroups = 0;
+
+        if (!m_D3DTextureBarriers.empty())
+        {
+            D3D12_BARRIER_GROUP& group = barrierGroups[numBarrierGroups++];
+            group.Type = D3D12_BARRIER_TYPE_TEXTURE;
+            group.NumBarriers = uint32_t(m_D3DTextureBarriers.size());
+            group.pTextureBarriers = m_D3DTextureBarriers.data();
+        }
+
+        if (!m_D3DBufferBarriers.empty())
+        {
+            D3D12_BARRIER_GROUP& group = barrierGroups[numBarrierGroups++];
+            group.Type = D3D12_BARRIER_TYPE_BUFFER;
+            group.NumBarriers = uint32_t(m_D3DBufferBarriers.size());
+            group.pBufferBarriers = m_D3DBufferBarriers.data();
+        }
+
+        if (numBarrierGroups > 0)
+            m_ActiveCommandList->commandList7->Barrier(numBarrierGroups, barrierGroups.data());
+    }
+#endif
+
+    void CommandList::commitBarriers()
+    {
+        if (m_StateTracker.getTextureBarriers().empty() && m_StateTracker.getBufferBarriers().empty())
+            return;
+
+        // Transitions of the attachments cannot be recorded inside render passes
+        endRenderPass();
+
+#if NVRHI_D3D12_WITH_ENHANCED_BARRIERS
+        // commandList7 is only queried when enhanced barriers are enabled on the device
+        if (m_ActiveCommandList->commandList7)
+            commitBarriersInternal_enhanced();
+        else
+#endif
+            commitBarriersInternal();
 
         m_StateTracker.clearBarriers();
     }
@@ -209,7 +403,7 @@ namespace nvrhi::d3d12
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
+        m_StateTracker.setEnableUavBarriersForBuffer(buffer->getTrackedBuffer(), enableBarriers);
     }
     
     void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
@@ -223,7 +417,7 @@ namespace nvrhi::d3d12
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_StateTracker.beginTrackingBufferState(buffer, stateBits);
+        m_StateTracker.beginTrackingBufferState(buffer->getTrackedBuffer(), stateBits);
     }
 
     void CommandList::setTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
@@ -240,7 +434,7 @@ namespace nvrhi::d3d12
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_StateTracker.requireBufferState(buffer, stateBits);
+        m_StateTracker.requireBufferState(buffer->getTrackedBuffer(), stateBits);
 
         if (m_Instance)
             m_Instance->referencedResources.push_back(buffer);
@@ -273,12 +467,80 @@ namespace nvrhi::d3d12
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_StateTracker.setPermanentBufferState(buffer, stateBits);
+        // The state of a packed buffer is shared with the other buffers in its resource, so it cannot be permanent
+        if (buffer->packedBlock)
+            m_StateTracker.requireBufferState(buffer->packedBlock, stateBits);
+        else
+            m_StateTracker.setPermanentBufferState(buffer, stateBits);
         
         if (m_Instance)
             m_Instance->referencedResources.push_back(buffer);
     }
 
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, subresources, stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer->getTrackedBuffer(), stateBits);
+
+        if (m_Instance)
+            m_Instance->referencedResources.push_back(buffer);
+    }
+
+    void CommandList::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        endRenderPass();
+
+        // The pending transitions of the previous resource must execute before the aliasing barrier
+        commitBarriers();
+
+        ID3D12Resource* d3dResourceAfter = resourceAfter ? static_cast<ID3D12Resource*>(resourceAfter->getNativeObject(ObjectTypes::D3D12_Resource)) : nullptr;
+
+        // The D3D12 resources remember their states across aliasing, so the tracked states stay valid,
+        // but their contents don't survive it
+        D3D12_RESOURCE_BARRIER d3dbarrier{};
+        d3dbarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+        d3dbarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        d3dbarrier.Aliasing.pResourceBefore = resourceBefore ? static_cast<ID3D12Resource*>(resourceBefore->getNativeObject(ObjectTypes::D3D12_Resource)) : nullptr;
+        d3dbarrier.Aliasing.pResourceAfter = d3dResourceAfter;
+
+        m_ActiveCommandList->commandList->ResourceBarrier(1, &d3dbarrier);
+
+        // Render targets and depth-stencil surfaces must be initialized with a discard, clear or copy after they
+        // are activated by an aliasing barrier, before any other use. Other resources don't have that requirement.
+        // Only textures can have these flags, and sampler feedback textures never have them.
+        if (d3dResourceAfter && (d3dResourceAfter->GetDesc().Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0)
+        {
+            Texture* texture = checked_cast<Texture*>(resourceAfter);
+            const FormatInfo& formatInfo = getFormatInfo(texture->desc.format);
+
+            // DiscardResource requires the render target or depth write state
+            m_StateTracker.requireTextureState(texture, AllSubresources,
+                (formatInfo.hasDepth || formatInfo.hasStencil) ? ResourceStates::DepthWrite : ResourceStates::RenderTarget);
+            commitBarriers();
+
+            m_ActiveCommandList->commandList->DiscardResource(d3dResourceAfter, nullptr);
+        }
+
+        if (m_Instance)
+        {
+            if (resourceBefore)
+                m_Instance->referencedResources.push_back(resourceBefore);
+            if (resourceAfter)
+                m_Instance->referencedResources.push_back(resourceAfter);
+        }
+    }
+
     ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
@@ -290,7 +552,49 @@ namespace nvrhi::d3d12
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        return m_StateTracker.getBufferState(buffer);
+        return m_StateTracker.getBufferState(buffer->getTrackedBuffer());
+    }
+
+    void CommandList::recordStateHandoffBarriers(const StateHandoffResolver& resolver)
+    {
+        m_StateTracker.addBarriers(resolver.getTextureBarriers(), resolver.getBufferBarriers());
+        commitBarriers();
+    }
+
+    void Device::resolveStateHandoff(nvrhi::ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        auto& handoffCommandLists = m_StateHandoffCommandLists[int(executionQueue)];
+        size_t numHandoffCommandLists = 0;
+
+        m_StateHandoffSubmission.clear();
+
+        // Records the barriers produced by the resolver into an internal command list and adds it to the submission
+        auto submitHandoffBarriers = [this, &handoffCommandLists, &numHandoffCommandLists, executionQueue]()
+        {
+            if (numHandoffCommandLists == handoffCommandLists.size())
+                handoffCommandLists.push_back(createCommandList(CommandListParameters().setQueueType(executionQueue)));
+
+            CommandList* commandList = checked_cast<CommandList*>(handoffCommandLists[numHandoffCommandLists++].Get());
+            commandList->open();
+            commandList->recordStateHandoffBarriers(*m_StateHandoffResolver);
+            commandList->close();
+
+            m_StateHandoffResolver->clearBarriers();
+            m_StateHandoffSubmission.push_back(commandList);
+        };
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+
+            if (m_StateHandoffResolver->resolveCommandList(commandList->getStateTracker()))
+                submitHandoffBarriers();
+
+            m_StateHandoffSubmission.push_back(commandList);
+        }
+
+        if (m_StateHandoffResolver->restoreInitialStates())
+            submitHandoffBarriers();
     }
     
 } // namespace nvrhi::d3d12
\ No newline at end of file
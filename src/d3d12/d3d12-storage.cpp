@@ -0,0 +1,298 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "d3d12-backend.h"
+#include "../common/storage-queue.h"
+#include <nvrhi/common/misc.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#if NVRHI_D3D12_WITH_DIRECTSTORAGE
+#include <dstorage.h>
+#endif
+
+namespace nvrhi::d3d12
+{
+#if NVRHI_D3D12_WITH_DIRECTSTORAGE
+
+    class StorageFile : public RefCounter<IStorageFile>
+    {
+    public:
+        RefCountPtr<IDStorageFile> file;
+        uint64_t size = 0;
+
+        [[nodiscard]] uint64_t getSize() const override { return size; }
+    };
+
+    // Reads and decompresses the files with DirectStorage into a staging buffer, and copies the data
+    // into the destinations on the NVRHI queue once the DirectStorage fence has been signaled.
+    // The staging buffer is used as a ring: when it wraps around, submit waits for the copies out of it.
+    class DirectStorageQueue : public nvrhi::StorageQueue
+    {
+    public:
+        DirectStorageQueue(Device* device, const StorageQueueDesc& desc, IDStorageFactory* factory, IDStorageQueue* queue)
+            : nvrhi::StorageQueue(device, desc)
+            , m_D3D12Device(device)
+            , m_Factory(factory)
+            , m_Queue(queue)
+        { }
+
+        ~DirectStorageQueue() override
+        {
+            // DirectStorage may still be writing into the staging buffer
+            if (m_Fence && m_Fence->GetCompletedValue() < m_FenceValue)
+                m_Fence->SetEventOnCompletion(m_FenceValue, nullptr);
+        }
+
+        bool initialize();
+
+        StorageFileHandle openFile(const char* path) override;
+        uint64_t submit(IEventQuery* completion) override;
+
+    protected:
+        [[nodiscard]] bool isCompressionSupported(StorageCompression) const override { return true; }
+
+    private:
+        struct StagedRequest
+        {
+            const PendingRequest* pending = nullptr;
+            uint64_t stagingOffset = 0;
+        };
+
+        Device* m_D3D12Device;
+        RefCountPtr<IDStorageFactory> m_Factory;
+        RefCountPtr<IDStorageQueue> m_Queue;
+        RefCountPtr<ID3D12Fence> m_Fence;
+        uint64_t m_FenceValue = 0;
+
+        BufferHandle m_StagingBuffer;
+        uint64_t m_StagingOffset = 0;
+        EventQueryHandle m_StagingQuery;
+
+        CommandListHandle m_CommandList;
+        std::vector<StagedRequest> m_StagedRequests;
+        uint64_t m_LastInstance = 0;
+
+        void reportErrors() const;
+        void flushStagedRequests();
+    };
+
+    bool DirectStorageQueue::initialize()
+    {
+        const Context& context = m_D3D12Device->getContext();
+
+        HRESULT hr = context.device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_Fence));
+        if (FAILED(hr))
+            return false;
+
+        BufferDesc stagingDesc;
+        stagingDesc.byteSize = m_Desc.stagingSize;
+        stagingDesc.debugName = m_Desc.debugName.empty() ? "StorageStagingBuffer" : m_Desc.debugName + " staging";
+        // DirectStorage writes into the buffer on its own queue, from where buffers decay to Common
+        stagingDesc.initialState = ResourceStates::Common;
+        stagingDesc.keepInitialState = true;
+        m_StagingBuffer = m_Device->createBuffer(stagingDesc);
+        if (!m_StagingBuffer)
+            return false;
+
+        m_StagingQuery = m_Device->createEventQuery();
+        m_CommandList = m_Device->createCommandList(CommandListParameters().setQueueType(m_Desc.queue));
+
+        return true;
+    }
+
+    StorageFileHandle DirectStorageQueue::openFile(const char* path)
+    {
+        const int pathLength = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+        std::wstring widePath(size_t(std::max(pathLength, 1)), L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path, -1, widePath.data(), pathLength);
+
+        StorageFile* file = new StorageFile();
+
+        HRESULT hr = m_Factory->OpenFile(widePath.c_str(), IID_PPV_ARGS(&file->file));
+        if (FAILED(hr))
+        {
+            delete file;
+
+            std::stringstream ss;
+            ss << "openFile: cannot open file " << path << ", error code = 0x" << std::hex << std::setw(8) << hr;
+            error(ss.str());
+            return nullptr;
+        }
+
+        BY_HANDLE_FILE_INFORMATION info = {};
+        file->file->GetFileInformation(&info);
+        file->size = (uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+
+        return StorageFileHandle::Create(file);
+    }
+
+    void DirectStorageQueue::reportErrors() const
+    {
+        DSTORAGE_ERROR_RECORD record = {};
+        m_Queue->RetrieveErrorRecord(&record);
+
+        if (record.FailureCount == 0)
+            return;
+
+        std::stringstream ss;
+        ss << record.FailureCount << " DirectStorage request(s) failed, the first one with error code = 0x"
+            << std::hex << std::setw(8) << record.FirstFailure.HResult;
+        error(ss.str());
+    }
+
+    uint64_t DirectStorageQueue::submit(IEventQuery* completion)
+    {
+        reportErrors();
+
+        m_LastInstance = 0;
+
+        for (const PendingRequest& pending : m_PendingRequests)
+        {
+            const StorageRequest& request = pending.request;
+            const uint64_t size = getDestinationSize(request);
+
+            uint64_t offset = align(m_StagingOffset, uint64_t(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+            if (offset + size > m_Desc.stagingSize)
+            {
+                // Let the copies out of the staging buffer finish before it's overwritten from the start
+                flushStagedRequests();
+
+                m_Device->setEventQuery(m_StagingQuery, m_Desc.queue);
+                m_Device->waitEventQuery(m_StagingQuery);
+                m_Device->resetEventQuery(m_StagingQuery);
+
+                offset = 0;
+            }
+            m_StagingOffset = offset + size;
+
+            DSTORAGE_REQUEST storageRequest = {};
+            storageRequest.Options.SourceType = DSTORAGE_REQUEST_SOURCE_FILE;
+            storageRequest.Options.DestinationType = DSTORAGE_REQUEST_DESTINATION_BUFFER;
+            storageRequest.Options.CompressionFormat = request.compression == StorageCompression::GDeflate
+                ? DSTORAGE_COMPRESSION_FORMAT_GDEFLATE
+                : DSTORAGE_COMPRESSION_FORMAT_NONE;
+            storageRequest.Source.File.Source = checked_cast<StorageFile*>(pending.file.Get())->file;
+            storageRequest.Source.File.Offset = request.fileOffset;
+            storageRequest.Source.File.Size = request.sourceSize;
+            storageRequest.UncompressedSize = uint32_t(size);
+            const Buffer* stagingBuffer = checked_cast<Buffer*>(m_StagingBuffer.Get());
+            storageRequest.Destination.Buffer.Resource = stagingBuffer->resource;
+            storageRequest.Destination.Buffer.Offset = stagingBuffer->resourceOffset + offset;
+            storageRequest.Destination.Buffer.Size = uint32_t(size);
+
+            m_Queue->EnqueueRequest(&storageRequest);
+
+            m_StagedRequests.push_back({ &pending, offset });
+        }
+
+        flushStagedRequests();
+
+        m_PendingRequests.clear();
+
+        if (completion)
+            m_Device->setEventQuery(completion, m_Desc.queue);
+
+        return m_LastInstance;
+    }
+
+    void DirectStorageQueue::flushStagedRequests()
+    {
+        if (m_StagedRequests.empty())
+            return;
+
+        ++m_FenceValue;
+        m_Queue->EnqueueSignal(m_Fence, m_FenceValue);
+        m_Queue->Submit();
+
+        // The copies can only start once DirectStorage has written the staging buffer
+        m_D3D12Device->getQueue(m_Desc.queue)->queue->Wait(m_Fence, m_FenceValue);
+
+        m_CommandList->open();
+
+        CommandList* commandList = checked_cast<CommandList*>(m_CommandList.Get());
+        Buffer* stagingBuffer = checked_cast<Buffer*>(m_StagingBuffer.Get());
+
+        for (const StagedRequest& staged : m_StagedRequests)
+        {
+            const StorageRequest& request = staged.pending->request;
+
+            if (request.destBuffer)
+            {
+                commandList->copyBuffer(request.destBuffer, request.destOffset, stagingBuffer, staged.stagingOffset, getDestinationSize(request));
+            }
+            else
+            {
+                commandList->copyBufferToTexture(checked_cast<Texture*>(request.destTexture), request.arraySlice, request.mipLevel,
+                    stagingBuffer, staged.stagingOffset);
+            }
+        }
+
+        // Closing returns the destinations to their initial states
+        m_CommandList->close();
+
+        m_LastInstance = m_Device->executeCommandList(m_CommandList, m_Desc.queue);
+
+        m_StagedRequests.clear();
+    }
+
+#endif // NVRHI_D3D12_WITH_DIRECTSTORAGE
+
+    StorageQueueHandle Device::createStorageQueue(const StorageQueueDesc& desc)
+    {
+#if NVRHI_D3D12_WITH_DIRECTSTORAGE
+        RefCountPtr<IDStorageFactory> factory;
+        HRESULT hr = DStorageGetFactory(IID_PPV_ARGS(&factory));
+
+        RefCountPtr<IDStorageQueue> queue;
+        if (SUCCEEDED(hr))
+        {
+            DSTORAGE_QUEUE_DESC queueDesc = {};
+            queueDesc.SourceType = DSTORAGE_REQUEST_SOURCE_FILE;
+            queueDesc.Capacity = std::clamp(desc.capacity, uint16_t(DSTORAGE_MIN_QUEUE_CAPACITY), uint16_t(DSTORAGE_MAX_QUEUE_CAPACITY));
+            queueDesc.Priority = DSTORAGE_PRIORITY_NORMAL;
+            queueDesc.Name = desc.debugName.c_str();
+            queueDesc.Device = m_Context.device;
+
+            hr = factory->CreateQueue(&queueDesc, IID_PPV_ARGS(&queue));
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            RefCountPtr<DirectStorageQueue> storageQueue = RefCountPtr<DirectStorageQueue>::Create(new DirectStorageQueue(this, desc, factory, queue));
+            if (storageQueue->initialize())
+                return storageQueue;
+
+            hr = E_FAIL;
+        }
+
+        std::stringstream ss;
+        ss << "Couldn't create a DirectStorage queue, error code = 0x" << std::hex << std::setw(8) << hr
+            << ". Falling back to reading the files on the CPU, compressed requests will be rejected.";
+        m_Context.warning(ss.str());
+#endif
+
+        return StorageQueueHandle::Create(new nvrhi::StorageQueue(this, desc));
+    }
+
+} // namespace nvrhi::d3d12
@@ -24,6 +24,7 @@
 
 #include <nvrhi/common/misc.h>
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -50,84 +51,58 @@ namespace nvrhi::d3d12
         switch (objectType)
         {
         case nvrhi::ObjectTypes::D3D12_ShaderResourceViewGpuDescripror: {
-            TextureBindingKey key = TextureBindingKey(subresources, format);
-            DescriptorIndex descriptorIndex;
-            auto found = m_CustomSRVs.find(key);
-            if (found == m_CustomSRVs.end())
-            {
-                descriptorIndex = m_Resources.shaderResourceViewHeap.allocateDescriptor();
-                m_CustomSRVs[key] = descriptorIndex;
+            const TextureBindingKey key = TextureBindingKey(subresources, format);
+            const DescriptorIndex descriptorIndex = m_CustomSRVs.getOrCreate(key, m_CustomSRVs.hash(key),
+                [&](DescriptorIndex& index)
+                {
+                    index = m_Resources.shaderResourceViewHeap.allocateDescriptor();
 
-                const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.shaderResourceViewHeap.getCpuHandle(descriptorIndex);
-                createSRV(cpuHandle.ptr, format, dimension, subresources);
-                m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorIndex);
-            }
-            else
-            {
-                descriptorIndex = found->second;
-            }
+                    const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.shaderResourceViewHeap.getCpuHandle(index);
+                    createSRV(cpuHandle.ptr, format, dimension, subresources);
+                    m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(index);
+                });
 
             return Object(m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorIndex).ptr);
         }
 
         case nvrhi::ObjectTypes::D3D12_UnorderedAccessViewGpuDescripror: {
-            TextureBindingKey key = TextureBindingKey(subresources, format);
-            DescriptorIndex descriptorIndex;
-            auto found = m_CustomUAVs.find(key);
-            if (found == m_CustomUAVs.end())
-            {
-                descriptorIndex = m_Resources.shaderResourceViewHeap.allocateDescriptor();
-                m_CustomUAVs[key] = descriptorIndex;
+            const TextureBindingKey key = TextureBindingKey(subresources, format);
+            const DescriptorIndex descriptorIndex = m_CustomUAVs.getOrCreate(key, m_CustomUAVs.hash(key),
+                [&](DescriptorIndex& index)
+                {
+                    index = m_Resources.shaderResourceViewHeap.allocateDescriptor();
 
-                const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.shaderResourceViewHeap.getCpuHandle(descriptorIndex);
-                createUAV(cpuHandle.ptr, format, dimension, subresources);
-                m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(descriptorIndex);
-            }
-            else
-            {
-                descriptorIndex = found->second;
-            }
+                    const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.shaderResourceViewHeap.getCpuHandle(index);
+                    createUAV(cpuHandle.ptr, format, dimension, subresources);
+                    m_Resources.shaderResourceViewHeap.copyToShaderVisibleHeap(index);
+                });
 
             return Object(m_Resources.shaderResourceViewHeap.getGpuHandle(descriptorIndex).ptr);
         }
         case nvrhi::ObjectTypes::D3D12_RenderTargetViewDescriptor: {
-            TextureBindingKey key = TextureBindingKey(subresources, format);
-            DescriptorIndex descriptorIndex;
-
-            auto found = m_RenderTargetViews.find(key);
-            if (found == m_RenderTargetViews.end())
-            {
-                descriptorIndex = m_Resources.renderTargetViewHeap.allocateDescriptor();
-                m_RenderTargetViews[key] = descriptorIndex;
+            const TextureBindingKey key = TextureBindingKey(subresources, format);
+            const DescriptorIndex descriptorIndex = m_RenderTargetViews.getOrCreate(key, m_RenderTargetViews.hash(key),
+                [&](DescriptorIndex& index)
+                {
+                    index = m_Resources.renderTargetViewHeap.allocateDescriptor();
 
-                const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.renderTargetViewHeap.getCpuHandle(descriptorIndex);
-                createRTV(cpuHandle.ptr, format, subresources);
-            }
-            else
-            {
-                descriptorIndex = found->second;
-            }
+                    const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.renderTargetViewHeap.getCpuHandle(index);
+                    createRTV(cpuHandle.ptr, format, subresources);
+                });
 
             return Object(m_Resources.renderTargetViewHeap.getCpuHandle(descriptorIndex).ptr);
         }
 
         case nvrhi::ObjectTypes::D3D12_DepthStencilViewDescriptor: {
-            TextureBindingKey key = TextureBindingKey(subresources, format, isReadOnlyDSV);
-            DescriptorIndex descriptorIndex;
+            const TextureBindingKey key = TextureBindingKey(subresources, format, isReadOnlyDSV);
+            const DescriptorIndex descriptorIndex = m_DepthStencilViews.getOrCreate(key, m_DepthStencilViews.hash(key),
+                [&](DescriptorIndex& index)
+                {
+                    index = m_Resources.depthStencilViewHeap.allocateDescriptor();
 
-            auto found = m_DepthStencilViews.find(key);
-            if (found == m_DepthStencilViews.end())
-            {
-                descriptorIndex = m_Resources.depthStencilViewHeap.allocateDescriptor();
-                m_DepthStencilViews[key] = descriptorIndex;
-
-                const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.depthStencilViewHeap.getCpuHandle(descriptorIndex);
-                createDSV(cpuHandle.ptr, subresources, isReadOnlyDSV);
-            }
-            else
-            {
-                descriptorIndex = found->second;
-            }
+                    const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_Resources.depthStencilViewHeap.getCpuHandle(index);
+                    createDSV(cpuHandle.ptr, subresources, isReadOnlyDSV);
+                });
 
             return Object(m_Resources.depthStencilViewHeap.getCpuHandle(descriptorIndex).ptr);
         }
@@ -139,20 +114,35 @@ namespace nvrhi::d3d12
 
     Texture::~Texture()
     {
-        for (auto pair : m_RenderTargetViews)
-            m_Resources.renderTargetViewHeap.releaseDescriptor(pair.second);
+        m_RenderTargetViews.forEach([this](const TextureBindingKey&, DescriptorIndex index)
+            { m_Resources.renderTargetViewHeap.releaseDescriptor(index); });
 
-        for (auto pair : m_DepthStencilViews)
-            m_Resources.depthStencilViewHeap.releaseDescriptor(pair.second);
+        m_DepthStencilViews.forEach([this](const TextureBindingKey&, DescriptorIndex index)
+            { m_Resources.depthStencilViewHeap.releaseDescriptor(index); });
 
         for (auto index : m_ClearMipLevelUAVs)
             m_Resources.shaderResourceViewHeap.releaseDescriptor(index);
 
-        for (auto pair : m_CustomSRVs)
-            m_Resources.shaderResourceViewHeap.releaseDescriptor(pair.second);
+        m_CustomSRVs.forEach([this](const TextureBindingKey&, DescriptorIndex index)
+            { m_Resources.shaderResourceViewHeap.releaseDescriptor(index); });
+
+        m_CustomUAVs.forEach([this](const TextureBindingKey&, DescriptorIndex index)
+            { m_Resources.shaderResourceViewHeap.releaseDescriptor(index); });
+
+        if (resource)
+        {
+            m_Resources.residency.removeAllocation(getResidencyKey(resource));
+            m_Resources.residency.removeAlias(getResidencyKey(resource));
+        }
+
+        if (placedAllocation.isValid())
+        {
+            resource = nullptr;
+            m_Resources.placedResources.release(placedAllocation);
+        }
 
-        for (auto pair : m_CustomUAVs)
-            m_Resources.shaderResourceViewHeap.releaseDescriptor(pair.second);
+        if (trackedMemorySize)
+            m_Context.memoryStatistics->released(MemoryCategory::Textures, trackedMemorySize);
     }
 
     StagingTexture::SliceRegion StagingTexture::getSliceRegion(ID3D12Device *device, const TextureSlice& slice)
@@ -327,7 +317,28 @@ namespace nvrhi::d3d12
             rd.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
         }
 
+        PlacedResourceAllocation placedAllocation;
+        ID3D12Heap* placedHeap = nullptr;
+        uint64_t placedOffset = 0;
+
+        if (!d.isVirtual && !d.isTiled && !isShared)
+        {
+            D3D12_RESOURCE_DESC placedDesc = rd;
+            D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+
+            // The placed resource may need a different alignment in its desc, so decide before creating the texture object
+            if (m_Resources.placedResources.canPlaceResource(placedDesc, allocationInfo) &&
+                m_Resources.placedResources.allocate(D3D12_HEAP_TYPE_DEFAULT, true, allocationInfo, placedAllocation, &placedHeap, &placedOffset))
+            {
+                rd = placedDesc;
+            }
+        }
+
         Texture* texture = new Texture(m_Context, m_Resources, d, rd);
+        texture->placedAllocation = placedAllocation;
+
+        if ((m_DeferredDestructionFlags & DeferredDestructionFlags::Textures) != 0)
+            texture->setDestructionQueue(&m_DeferredDestruction);
 
         D3D12_CLEAR_VALUE clearValue = convertTextureClearValue(d);
         HRESULT hr = S_OK;
@@ -346,6 +357,16 @@ namespace nvrhi::d3d12
                 d.useClearValue ? &clearValue : nullptr,
                 IID_PPV_ARGS(&texture->resource));
         }
+        else if (texture->placedAllocation.isValid())
+        {
+            // Optimized clear values are only allowed for render targets and depth-stencil surfaces, which are never placed
+            hr = m_Context.device->CreatePlacedResource(
+                placedHeap, placedOffset,
+                &texture->resourceDesc,
+                convertResourceStates(d.initialState),
+                nullptr,
+                IID_PPV_ARGS(&texture->resource));
+        }
         else
         {
             heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
@@ -371,6 +392,23 @@ namespace nvrhi::d3d12
             return nullptr;
         }
 
+        // Tiled textures are not tracked, the heaps mapped into them are kept resident instead
+        if (m_Resources.residency.isEnabled() && !d.isTiled)
+        {
+            if (texture->placedAllocation.isValid())
+                m_Resources.residency.addAlias(getResidencyKey(texture->resource), getResidencyKey(placedHeap));
+            else
+                m_Resources.residency.addAllocation(getResidencyKey(texture->resource),
+                    m_Context.device->GetResourceAllocationInfo(0, 1, &texture->resourceDesc).SizeInBytes);
+        }
+
+        // Tiled textures have no memory of their own
+        if (!d.isTiled)
+        {
+            texture->trackedMemorySize = m_Context.device->GetResourceAllocationInfo(0, 1, &texture->resourceDesc).SizeInBytes;
+            m_Context.memoryStatistics->allocated(MemoryCategory::Textures, texture->trackedMemorySize, d.debugName.c_str());
+        }
+
         if (isShared)
         {
             hr = m_Context.device->CreateSharedHandle(
@@ -445,6 +483,8 @@ namespace nvrhi::d3d12
         texture->heap = heap;
         texture->postCreate();
 
+        m_Resources.residency.addAlias(getResidencyKey(texture->resource), getResidencyKey(heap->heap));
+
         return true;
     }
     
@@ -971,6 +1011,8 @@ namespace nvrhi::d3d12
 
     void CommandList::clearTextureFloat(ITexture* _t, TextureSubresourceSet subresources, const Color & clearColor)
     {
+        endRenderPass();
+
         Texture* t = checked_cast<Texture*>(_t);
 
 #ifdef _DEBUG
@@ -1029,6 +1071,8 @@ namespace nvrhi::d3d12
 
     void CommandList::clearDepthStencilTexture(ITexture* _t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
     {
+        endRenderPass();
+
         if (!clearDepth && !clearStencil)
         {
             return;
@@ -1077,6 +1121,8 @@ namespace nvrhi::d3d12
 
     void CommandList::clearTextureUInt(ITexture* _t, TextureSubresourceSet subresources, uint32_t clearColor)
     {
+        endRenderPass();
+
         Texture* t = checked_cast<Texture*>(_t);
 
 #ifdef _DEBUG
@@ -1134,6 +1180,8 @@ namespace nvrhi::d3d12
 
     void CommandList::clearSamplerFeedbackTexture(ISamplerFeedbackTexture* _texture)
     {
+        endRenderPass();
+
         SamplerFeedbackTexture* texture = checked_cast<SamplerFeedbackTexture*>(_texture);
 
         DescriptorIndex& descriptorIndex = texture->clearDescriptorIndex;
@@ -1155,9 +1203,21 @@ namespace nvrhi::d3d12
 
     void CommandList::decodeSamplerFeedbackTexture(IBuffer* _buffer, ISamplerFeedbackTexture* _texture, nvrhi::Format format)
     {
+        endRenderPass();
+
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
         SamplerFeedbackTexture* texture = checked_cast<SamplerFeedbackTexture*>(_texture);
 
+        // ResolveSubresourceRegion writes to the start of the destination resource
+        if (buffer->packedBlock)
+        {
+            std::stringstream ss;
+            ss << "Cannot decode sampler feedback into buffer " << utils::DebugNameToString(buffer->desc.debugName)
+               << " because it is packed into a shared resource, see DeviceDesc::enableSmallBufferPacking";
+            m_Context.error(ss.str());
+            return;
+        }
+
         if (m_EnableAutomaticBarriers)
         {
             requireBufferState(buffer, ResourceStates::ResolveDest);
@@ -1179,6 +1239,8 @@ namespace nvrhi::d3d12
     void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice,
         ITexture* _src, const TextureSlice& srcSlice)
     {
+        endRenderPass();
+
         Texture* dst = checked_cast<Texture*>(_dst);
         Texture* src = checked_cast<Texture*>(_src);
 
@@ -1227,6 +1289,8 @@ namespace nvrhi::d3d12
 
     void CommandList::copyTexture(ITexture* _dst, const TextureSlice& dstSlice, IStagingTexture* _src, const TextureSlice& srcSlice)
     {
+        endRenderPass();
+
         StagingTexture* src = checked_cast<StagingTexture*>(_src);
         Texture* dst = checked_cast<Texture*>(_dst);
 
@@ -1272,6 +1336,8 @@ namespace nvrhi::d3d12
 
     void CommandList::copyTexture(IStagingTexture* _dst, const TextureSlice& dstSlice, ITexture* _src, const TextureSlice& srcSlice)
     {
+        endRenderPass();
+
         Texture* src = checked_cast<Texture*>(_src);
         StagingTexture* dst = checked_cast<StagingTexture*>(_dst);
 
@@ -1315,26 +1381,66 @@ namespace nvrhi::d3d12
             &srcLocation, &srcBox);
     }
 
-    void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    void CommandList::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
     {
+        if (!beginTextureWrite(dest, arraySlice, mipLevel, nullptr, nullptr))
+            return;
+
+        const PendingTextureWrite& write = m_PendingTextureWrites.back();
+
+        assert(write.numRows <= write.footprint.Footprint.Height);
+
+        for (uint32_t depthSlice = 0; depthSlice < write.footprint.Footprint.Depth; depthSlice++)
+        {
+            for (uint32_t row = 0; row < write.numRows; row++)
+            {
+                void* destAddress = (char*)write.cpuVA + uint64_t(write.footprint.Footprint.RowPitch) * uint64_t(row + depthSlice * write.numRows);
+                const void* srcAddress = (const char*)data + rowPitch * row + depthPitch * depthSlice;
+                memcpy(destAddress, srcAddress, std::min(rowPitch, write.rowSizeInBytes));
+            }
+        }
+
+        endTextureWrite(dest, arraySlice, mipLevel);
+    }
+
+    void CommandList::writeTextureSubresources(ITexture* _dest, const TextureSubresourceData* subresources, size_t numSubresources)
+    {
+        endRenderPass();
+
+        if (numSubresources == 0)
+            return;
+
         Texture* dest = checked_cast<Texture*>(_dest);
 
-        if (m_EnableAutomaticBarriers)
+        // Get the footprints of the whole range of subresources covered by the writes in one call
+        uint32_t firstSubresource = ~0u;
+        uint32_t lastSubresource = 0;
+        for (size_t i = 0; i < numSubresources; i++)
         {
-            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
-            m_BindingStatesDirty = true;
+            const uint32_t subresource = calcSubresource(subresources[i].mipLevel, subresources[i].arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+            firstSubresource = std::min(firstSubresource, subresource);
+            lastSubresource = std::max(lastSubresource, subresource);
         }
-        commitBarriers();
 
-        uint32_t subresource = calcSubresource(mipLevel, arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+        const uint32_t numFootprints = lastSubresource - firstSubresource + 1;
+        m_SubresourceFootprints.resize(numFootprints);
+        m_SubresourceNumRows.resize(numFootprints);
+        m_SubresourceRowSizes.resize(numFootprints);
 
         D3D12_RESOURCE_DESC resourceDesc = dest->resource->GetDesc();
-        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
-        uint32_t numRows;
-        uint64_t rowSizeInBytes;
-        uint64_t totalBytes;
+        m_Context.device->GetCopyableFootprints(&resourceDesc, firstSubresource, numFootprints, 0,
+            m_SubresourceFootprints.data(), m_SubresourceNumRows.data(), m_SubresourceRowSizes.data(), nullptr);
 
-        m_Context.device->GetCopyableFootprints(&resourceDesc, subresource, 1, 0, &footprint, &numRows, &rowSizeInBytes, &totalBytes);
+        // Pack the written subresources into one upload buffer block
+        uint64_t totalBytes = 0;
+        for (size_t i = 0; i < numSubresources; i++)
+        {
+            const uint32_t index = calcSubresource(subresources[i].mipLevel, subresources[i].arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize) - firstSubresource;
+            const D3D12_SUBRESOURCE_FOOTPRINT& footprint = m_SubresourceFootprints[index].Footprint;
+
+            totalBytes = align(totalBytes, uint64_t(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+            totalBytes += uint64_t(footprint.RowPitch) * m_SubresourceNumRows[index] * footprint.Depth;
+        }
 
         void* cpuVA;
         ID3D12Resource* uploadBuffer;
@@ -1345,43 +1451,175 @@ namespace nvrhi::d3d12
             m_Context.error("Couldn't suballocate an upload buffer");
             return;
         }
-        footprint.Offset = uint64_t(offsetInUploadBuffer);
 
-        assert(numRows <= footprint.Footprint.Height);
+        if (m_EnableAutomaticBarriers)
+        {
+            for (size_t i = 0; i < numSubresources; i++)
+            {
+                requireTextureState(dest, TextureSubresourceSet(subresources[i].mipLevel, 1, subresources[i].arraySlice, 1), ResourceStates::CopyDest);
+            }
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_Instance->referencedResources.push_back(dest);
+
+        if (uploadBuffer != m_CurrentUploadBuffer)
+        {
+            m_Instance->referencedNativeResources.push_back(uploadBuffer);
+            m_CurrentUploadBuffer = uploadBuffer;
+        }
 
-        for (uint32_t depthSlice = 0; depthSlice < footprint.Footprint.Depth; depthSlice++)
+        uint64_t offset = 0;
+        for (size_t i = 0; i < numSubresources; i++)
         {
-            for (uint32_t row = 0; row < numRows; row++)
+            const TextureSubresourceData& subresource = subresources[i];
+            const uint32_t subresourceIndex = calcSubresource(subresource.mipLevel, subresource.arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+            const uint32_t index = subresourceIndex - firstSubresource;
+
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = m_SubresourceFootprints[index];
+            const uint32_t numRows = m_SubresourceNumRows[index];
+            const uint64_t rowSizeInBytes = m_SubresourceRowSizes[index];
+
+            offset = align(offset, uint64_t(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+            footprint.Offset = uint64_t(offsetInUploadBuffer) + offset;
+
+            for (uint32_t depthSlice = 0; depthSlice < footprint.Footprint.Depth; depthSlice++)
             {
-                void* destAddress = (char*)cpuVA + uint64_t(footprint.Footprint.RowPitch) * uint64_t(row + depthSlice * numRows);
-                const void* srcAddress = (const char*)data + rowPitch * row + depthPitch * depthSlice;
-                memcpy(destAddress, srcAddress, std::min(rowPitch, rowSizeInBytes));
+                for (uint32_t row = 0; row < numRows; row++)
+                {
+                    void* destAddress = (char*)cpuVA + offset + uint64_t(footprint.Footprint.RowPitch) * uint64_t(row + depthSlice * numRows);
+                    const void* srcAddress = (const char*)subresource.data + subresource.rowPitch * row + subresource.depthPitch * depthSlice;
+                    memcpy(destAddress, srcAddress, std::min(subresource.rowPitch, rowSizeInBytes));
+                }
             }
+
+            offset += uint64_t(footprint.Footprint.RowPitch) * numRows * footprint.Footprint.Depth;
+
+            D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
+            destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            destCopyLocation.SubresourceIndex = subresourceIndex;
+            destCopyLocation.pResource = dest->resource;
+
+            D3D12_TEXTURE_COPY_LOCATION srcCopyLocation;
+            srcCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            srcCopyLocation.PlacedFootprint = footprint;
+            srcCopyLocation.pResource = uploadBuffer;
+
+            m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
         }
+    }
+
+    void* CommandList::beginTextureWrite(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        PendingTextureWrite write;
+        write.dest = dest;
+        write.subresource = calcSubresource(mipLevel, arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+
+        D3D12_RESOURCE_DESC resourceDesc = dest->resource->GetDesc();
+        uint64_t totalBytes;
+
+        m_Context.device->GetCopyableFootprints(&resourceDesc, write.subresource, 1, 0, &write.footprint, &write.numRows, &write.rowSizeInBytes, &totalBytes);
+
+        size_t offsetInUploadBuffer;
+        if (!m_UploadManager.suballocateBuffer(totalBytes, nullptr, &write.uploadBuffer, &offsetInUploadBuffer, &write.cpuVA, nullptr, 
+            m_RecordingVersion, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return nullptr;
+        }
+        write.footprint.Offset = uint64_t(offsetInUploadBuffer);
+
+        if (outRowPitch)
+            *outRowPitch = write.footprint.Footprint.RowPitch;
+        if (outDepthPitch)
+            *outDepthPitch = size_t(write.footprint.Footprint.RowPitch) * write.numRows;
+
+        m_PendingTextureWrites.push_back(write);
+        return write.cpuVA;
+    }
+
+    void CommandList::endTextureWrite(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        endRenderPass();
+
+        Texture* dest = checked_cast<Texture*>(_dest);
+        const uint32_t subresource = calcSubresource(mipLevel, arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+
+        auto it = std::find_if(m_PendingTextureWrites.begin(), m_PendingTextureWrites.end(), [dest, subresource](const PendingTextureWrite& write)
+            { return write.dest == dest && write.subresource == subresource; });
+
+        if (it == m_PendingTextureWrites.end())
+            return; // let the validation layer report it
+
+        const PendingTextureWrite write = *it;
+        m_PendingTextureWrites.erase(it);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
 
         D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
         destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        destCopyLocation.SubresourceIndex = subresource;
+        destCopyLocation.SubresourceIndex = write.subresource;
         destCopyLocation.pResource = dest->resource;
 
         D3D12_TEXTURE_COPY_LOCATION srcCopyLocation;
         srcCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        srcCopyLocation.PlacedFootprint = footprint;
-        srcCopyLocation.pResource = uploadBuffer;
+        srcCopyLocation.PlacedFootprint = write.footprint;
+        srcCopyLocation.pResource = write.uploadBuffer;
 
         m_Instance->referencedResources.push_back(dest);
 
-        if (uploadBuffer != m_CurrentUploadBuffer)
+        if (write.uploadBuffer != m_CurrentUploadBuffer)
         {
-            m_Instance->referencedNativeResources.push_back(uploadBuffer);
-            m_CurrentUploadBuffer = uploadBuffer;
+            m_Instance->referencedNativeResources.push_back(write.uploadBuffer);
+            m_CurrentUploadBuffer = write.uploadBuffer;
+        }
+
+        m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
+    }
+
+    void CommandList::copyBufferToTexture(Texture* dest, uint32_t arraySlice, uint32_t mipLevel, Buffer* src, uint64_t srcOffset)
+    {
+        endRenderPass();
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
+            requireBufferState(src, ResourceStates::CopySource);
+            m_BindingStatesDirty = true;
         }
+        commitBarriers();
+
+        const uint32_t subresource = calcSubresource(mipLevel, arraySlice, 0, dest->desc.mipLevels, dest->desc.arraySize);
+        D3D12_RESOURCE_DESC resourceDesc = dest->resource->GetDesc();
+
+        D3D12_TEXTURE_COPY_LOCATION destCopyLocation;
+        destCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        destCopyLocation.SubresourceIndex = subresource;
+        destCopyLocation.pResource = dest->resource;
+
+        D3D12_TEXTURE_COPY_LOCATION srcCopyLocation;
+        srcCopyLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        srcCopyLocation.pResource = src->resource;
+        m_Context.device->GetCopyableFootprints(&resourceDesc, subresource, 1, src->resourceOffset + srcOffset, &srcCopyLocation.PlacedFootprint, nullptr, nullptr, nullptr);
+
+        m_Instance->referencedResources.push_back(dest);
+        m_Instance->referencedResources.push_back(src);
 
         m_ActiveCommandList->commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
     }
 
     void CommandList::resolveTexture(ITexture* _dest, const TextureSubresourceSet& dstSubresources, ITexture* _src, const TextureSubresourceSet& srcSubresources)
     {
+        endRenderPass();
+
         Texture* dest = checked_cast<Texture*>(_dest);
         Texture* src = checked_cast<Texture*>(_src);
 
@@ -1416,6 +1654,16 @@ namespace nvrhi::d3d12
         }
     }
 
+    void CommandList::generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter)
+    {
+        checked_cast<Device*>(m_Device)->getTextureBlitter().generateMips(this, texture, subresources, linearFilter);
+    }
+
+    void CommandList::blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter)
+    {
+        checked_cast<Device*>(m_Device)->getTextureBlitter().blitTexture(this, dest, destSlice, src, srcSlice, linearFilter);
+    }
+
     // helper function for texture subresource calculations
     // https://msdn.microsoft.com/en-us/library/windows/desktop/dn705766(v=vs.85).aspx
     uint32_t calcSubresource(uint32_t MipSlice, uint32_t ArraySlice, uint32_t PlaneSlice, uint32_t MipLevels, uint32_t ArraySize)
@@ -35,9 +35,12 @@ namespace nvrhi::d3d12
             buffer->Unmap(0, nullptr);
             cpuVA = nullptr;
         }
+
+        if (memoryStatistics)
+            memoryStatistics->released(memoryCategory, bufferSize);
     }
     
-    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+    UploadManager::UploadManager(const Context& context, class Queue* pQueue, size_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer, uint64_t ringSize)
         : m_Context(context)
         , m_Queue(pQueue)
         , m_DefaultChunkSize(defaultChunkSize)
@@ -45,6 +48,10 @@ namespace nvrhi::d3d12
         , m_IsScratchBuffer(isScratchBuffer)
     {
         assert(pQueue);
+
+        // Scratch memory is not mapped, ring allocation only makes sense for uploads
+        if (!isScratchBuffer)
+            m_Ring.setSize(align(ringSize, BufferChunk::c_sizeAlignment));
     }
 
     std::shared_ptr<BufferChunk> UploadManager::createChunk(size_t size) const
@@ -96,15 +103,61 @@ namespace nvrhi::d3d12
             wss << L"Upload Buffer " << chunk->identifier;
         chunk->buffer->SetName(wss.str().c_str());
 
+        chunk->memoryStatistics = m_Context.memoryStatistics.get();
+        chunk->memoryCategory = m_IsScratchBuffer ? MemoryCategory::ScratchChunks : MemoryCategory::UploadChunks;
+        chunk->memoryStatistics->allocated(chunk->memoryCategory, size);
+
         return chunk;
     }
         
+    bool UploadManager::suballocateFromRing(uint64_t size, ID3D12Resource** pBuffer, size_t* pOffset, void** pCpuVA,
+        D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint32_t alignment)
+    {
+        if (!m_RingChunk)
+        {
+            m_RingChunk = createChunk(m_Ring.getSize());
+
+            if (!m_RingChunk)
+            {
+                // Couldn't create the ring buffer, use chunks from now on
+                m_Ring.setSize(0);
+                return false;
+            }
+
+            m_AllocatedMemory += m_RingChunk->bufferSize;
+        }
+
+        uint64_t offset = 0;
+        if (!m_Ring.allocate(size, alignment, offset))
+        {
+            // Only look at the fence when the ring is full and some of it may have been released by the GPU
+            if (!m_Ring.hasRetirableSpace())
+                return false;
+
+            m_Ring.retire(m_Queue->updateLastCompletedInstance());
+
+            if (!m_Ring.allocate(size, alignment, offset))
+                return false;
+        }
+
+        if (pBuffer) *pBuffer = m_RingChunk->buffer;
+        if (pOffset) *pOffset = offset;
+        if (pCpuVA) *pCpuVA = (char*)m_RingChunk->cpuVA + offset;
+        if (pGpuVA) *pGpuVA = m_RingChunk->gpuVA + offset;
+
+        return true;
+    }
+
     bool UploadManager::suballocateBuffer(uint64_t size, ID3D12GraphicsCommandList* pCommandList, ID3D12Resource** pBuffer, size_t* pOffset,
         void** pCpuVA, D3D12_GPU_VIRTUAL_ADDRESS* pGpuVA, uint64_t currentVersion, uint32_t alignment)
     {
         // Scratch allocations need a command list, upload ones don't
         assert(!m_IsScratchBuffer || pCommandList);
 
+        // Uploads that don't fit into the ring fall back to dedicated chunks
+        if (m_Ring.getSize() > 0 && suballocateFromRing(size, pBuffer, pOffset, pCpuVA, pGpuVA, alignment))
+            return true;
+
         std::shared_ptr<BufferChunk> chunkToRetire;
 
         // Try to allocate from the current chunk first
@@ -224,6 +277,11 @@ namespace nvrhi::d3d12
             else
             {
                 m_CurrentChunk = createChunk(sizeToAllocate);
+
+                if (!m_CurrentChunk)
+                    return false;
+
+                m_AllocatedMemory += m_CurrentChunk->bufferSize;
             }
         }
 
@@ -240,6 +298,8 @@ namespace nvrhi::d3d12
 
     void UploadManager::submitChunks(uint64_t currentVersion, uint64_t submittedVersion)
     {
+        m_Ring.submit(submittedVersion);
+
         if (m_CurrentChunk)
         {
             m_ChunkPool.push_back(m_CurrentChunk);
@@ -252,4 +312,33 @@ namespace nvrhi::d3d12
                 chunk->version = submittedVersion;
         }
     }
+
+    void UploadManager::getStatistics(MemoryStatistics& statistics) const
+    {
+        MemoryCategoryStatistics& result = statistics.get(m_IsScratchBuffer ? MemoryCategory::ScratchChunks : MemoryCategory::UploadChunks);
+
+        // Chunks are never freed before the manager, so the allocated memory is also the peak
+        result.allocatedBytes += m_AllocatedMemory;
+        result.peakAllocatedBytes += m_AllocatedMemory;
+
+        auto addChunk = [&result](const BufferChunk& chunk)
+        {
+            // Chunks with a zero version have been recycled and hold no data
+            if (chunk.version != 0)
+                result.usedBytes += chunk.writePointer;
+            ++result.allocationCount;
+        };
+
+        for (const auto& chunk : m_ChunkPool)
+            addChunk(*chunk);
+
+        if (m_CurrentChunk)
+            addChunk(*m_CurrentChunk);
+
+        if (m_RingChunk)
+        {
+            result.usedBytes += m_Ring.getUsedSize();
+            ++result.allocationCount;
+        }
+    }
 } // namespace nvrhi::d3d12
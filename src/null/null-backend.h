@@ -0,0 +1,813 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/null.h>
+#include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+#include "../common/state-tracking.h"
+#include "../common/versioning.h"
+#include "../common/ring-allocator.h"
+#include "../common/resource-references.h"
+#include "../common/pipeline-compiler.h"
+#include "../common/graphics-state-cache.h"
+#include "../common/memory-statistics.h"
+
+#include <nvrhi/common/aftermath.h>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nvrhi::null
+{
+    class Device;
+
+    struct Context
+    {
+        IMessageCallback* messageCallback = nullptr;
+        std::unique_ptr<MemoryStatisticsTracker> memoryStatistics;
+
+        // Fake GPU virtual addresses for buffers and acceleration structures, never reused
+        mutable std::atomic<uint64_t> nextGpuAddress = 0x10000;
+
+        void error(const std::string& message) const;
+        void warning(const std::string& message) const;
+
+        uint64_t allocateGpuAddress(uint64_t size) const;
+    };
+
+    class Queue
+    {
+    public:
+        explicit Queue(CommandQueue queueID)
+            : m_QueueID(queueID)
+        { }
+
+        // Command lists finish executing as soon as they are submitted, so the last submitted instance is also
+        // the last completed one. Submissions to one queue are serialized by the device.
+        std::atomic<uint64_t> lastSubmittedInstance = 0;
+        std::atomic<uint64_t> lastRecordingID = 0;
+
+        [[nodiscard]] CommandQueue getQueueID() const { return m_QueueID; }
+        [[nodiscard]] uint64_t getLastCompletedInstance() const { return lastSubmittedInstance.load(); }
+
+    private:
+        CommandQueue m_QueueID;
+    };
+
+    // Sizes of the tightly packed texture data, with rows of whole compression blocks
+    size_t getTextureRowPitch(const TextureDesc& desc, MipLevel mipLevel);
+    size_t getTextureSubresourceSize(const TextureDesc& desc, MipLevel mipLevel);
+    uint64_t getTextureSize(const TextureDesc& desc);
+
+    class Heap : public RefCounter<IHeap>
+    {
+    public:
+        HeapDesc desc;
+
+        const HeapDesc& getDesc() override { return desc; }
+    };
+
+    class Buffer : public RefCounter<IBuffer>, public BufferStateExtension
+    {
+    public:
+        BufferDesc desc;
+        GpuVirtualAddress gpuAddress = 0;
+
+        // Contents of the buffers that the CPU can map
+        std::vector<uint8_t> hostMemory;
+
+        HeapHandle heap;
+        uint64_t heapOffset = 0;
+
+        // Size counted in MemoryCategory::Buffers, 0 for virtual and volatile buffers
+        MemoryStatisticsTracker* memoryStatistics = nullptr;
+        uint64_t trackedMemorySize = 0;
+
+        explicit Buffer(const BufferDesc& _desc)
+            : BufferStateExtension(desc)
+            , desc(_desc)
+        { }
+
+        ~Buffer() override;
+
+        const BufferDesc& getDesc() const override { return desc; }
+        GpuVirtualAddress getGpuVirtualAddress() const override { return gpuAddress; }
+    };
+
+    class Texture : public RefCounter<ITexture>, public TextureStateExtension
+    {
+    public:
+        TextureDesc desc;
+
+        HeapHandle heap;
+        uint64_t heapOffset = 0;
+
+        // Size counted in MemoryCategory::Textures, 0 for virtual textures
+        MemoryStatisticsTracker* memoryStatistics = nullptr;
+        uint64_t trackedMemorySize = 0;
+
+        explicit Texture(const TextureDesc& _desc)
+            : TextureStateExtension(desc)
+            , desc(_desc)
+        { }
+
+        ~Texture() override;
+
+        const TextureDesc& getDesc() const override { return desc; }
+        Object getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV = false) override;
+    };
+
+    class StagingTexture : public RefCounter<IStagingTexture>
+    {
+    public:
+        TextureDesc desc;
+        CpuAccessMode cpuAccess = CpuAccessMode::None;
+
+        // Subresources are stored tightly packed, array slice by array slice, mip level by mip level
+        std::vector<uint8_t> hostMemory;
+        std::vector<size_t> subresourceOffsets;
+
+        const TextureDesc& getDesc() const override { return desc; }
+
+        void allocate();
+        [[nodiscard]] size_t getSubresourceOffset(ArraySlice arraySlice, MipLevel mipLevel) const;
+    };
+
+    class SamplerFeedbackTexture : public RefCounter<ISamplerFeedbackTexture>, public TextureStateExtension
+    {
+    public:
+        SamplerFeedbackTextureDesc desc;
+        TextureDesc textureDesc; // used with state tracking
+        TextureHandle pairedTexture;
+
+        SamplerFeedbackTexture(const SamplerFeedbackTextureDesc& _desc, const TextureDesc& _textureDesc, ITexture* _pairedTexture)
+            : TextureStateExtension(textureDesc)
+            , desc(_desc)
+            , textureDesc(_textureDesc)
+            , pairedTexture(_pairedTexture)
+        {
+            TextureStateExtension::isSamplerFeedback = true;
+        }
+
+        const SamplerFeedbackTextureDesc& getDesc() const override { return desc; }
+        TextureHandle getPairedTexture() override { return pairedTexture; }
+    };
+
+    class Sampler : public RefCounter<ISampler>
+    {
+    public:
+        SamplerDesc desc;
+
+        const SamplerDesc& getDesc() const override { return desc; }
+    };
+
+    class Shader : public RefCounter<IShader>
+    {
+    public:
+        ShaderDesc desc;
+        std::vector<char> bytecode;
+        std::vector<ShaderSpecialization> specializationConstants;
+        ShaderHandle baseShader;
+
+        const ShaderDesc& getDesc() const override { return desc; }
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override;
+    };
+
+    class ShaderLibrary : public RefCounter<IShaderLibrary>
+    {
+    public:
+        std::vector<char> bytecode;
+
+        void getBytecode(const void** ppBytecode, size_t* pSize) const override;
+        ShaderHandle getShader(const char* entryName, ShaderType shaderType) override;
+    };
+
+    class InputLayout : public RefCounter<IInputLayout>
+    {
+    public:
+        std::vector<VertexAttributeDesc> attributes;
+
+        uint32_t getNumAttributes() const override { return uint32_t(attributes.size()); }
+        const VertexAttributeDesc* getAttributeDesc(uint32_t index) const override;
+    };
+
+    class Framebuffer : public RefCounter<IFramebuffer>
+    {
+    public:
+        FramebufferDesc desc;
+        FramebufferInfoEx framebufferInfo;
+
+        // Hold strong references to the attachments
+        static_vector<TextureHandle, c_MaxRenderTargets + 2> resources;
+
+        const FramebufferDesc& getDesc() const override { return desc; }
+        const FramebufferInfoEx& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+
+        const GraphicsPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class ComputePipeline : public RefCounter<IComputePipeline>
+    {
+    public:
+        ComputePipelineDesc desc;
+
+        const ComputePipelineDesc& getDesc() const override { return desc; }
+    };
+
+    class MeshletPipeline : public RefCounter<IMeshletPipeline>
+    {
+    public:
+        MeshletPipelineDesc desc;
+        FramebufferInfo framebufferInfo;
+
+        const MeshletPipelineDesc& getDesc() const override { return desc; }
+        const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
+    };
+
+    class BindingLayout : public RefCounter<IBindingLayout>
+    {
+    public:
+        BindingLayoutDesc desc;
+        BindlessLayoutDesc bindlessDesc;
+        bool isBindless = false;
+
+        const BindingLayoutDesc* getDesc() const override { return isBindless ? nullptr : &desc; }
+        const BindlessLayoutDesc* getBindlessDesc() const override { return isBindless ? &bindlessDesc : nullptr; }
+    };
+
+    class BindingSet : public RefCounter<IBindingSet>
+    {
+    public:
+        BindingSetDesc desc;
+        BindingLayoutHandle layout;
+
+        // Hold strong references to the bound resources
+        std::vector<RefCountPtr<IResource>> resources;
+
+        // Bindings of the resources without permanent states, which need barriers when the set is used
+        std::vector<uint16_t> bindingsThatNeedTransitions;
+        bool hasUavBindings = false;
+
+        const BindingSetDesc* getDesc() const override { return &desc; }
+        IBindingLayout* getLayout() const override { return layout; }
+    };
+
+    class DescriptorTable : public RefCounter<IDescriptorTable>
+    {
+    public:
+        BindingLayoutHandle layout;
+        std::vector<BindingSetItem> descriptors;
+        std::vector<RefCountPtr<IResource>> resources;
+
+        const BindingSetDesc* getDesc() const override { return nullptr; }
+        IBindingLayout* getLayout() const override { return layout; }
+        uint32_t getCapacity() const override { return uint32_t(descriptors.size()); }
+        uint32_t getFirstDescriptorIndexInHeap() const override { return 0; }
+    };
+
+    class EventQuery : public RefCounter<IEventQuery>
+    {
+    public:
+        CommandQueue queue = CommandQueue::Graphics;
+        uint64_t commandListInstance = 0;
+    };
+
+    class TimerQuery : public RefCounter<ITimerQuery>
+    {
+    public:
+        bool started = false;
+        bool resolved = false;
+    };
+
+    class TimerQueryPool : public RefCounter<ITimerQueryPool>
+    {
+    public:
+        TimerQueryPoolDesc desc;
+        std::atomic<uint64_t> currentFrameIndex = 0;
+
+        // Index of the newest frame whose resolveTimerQueries call has been executed
+        std::atomic<uint64_t> lastExecutedFrameIndex = 0;
+
+        const TimerQueryPoolDesc& getDesc() const override { return desc; }
+        uint64_t getCurrentFrameIndex() const override { return currentFrameIndex.load(); }
+    };
+
+    class OcclusionQuery : public RefCounter<IOcclusionQuery>
+    {
+    public:
+        OcclusionQueryType type = OcclusionQueryType::Binary;
+
+        OcclusionQueryType getType() const override { return type; }
+    };
+
+    class PipelineStatisticsQuery : public RefCounter<IPipelineStatisticsQuery>
+    {
+    };
+
+    class SyncPoint : public RefCounter<ISyncPoint>
+    {
+    public:
+        CommandQueue queue = CommandQueue::Graphics;
+        std::atomic<uint64_t> value = 0;
+
+        CommandQueue getQueue() const override { return queue; }
+        uint64_t getValue() const override { return value.load(); }
+    };
+
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+    };
+
+    class OpacityMicromap : public RefCounter<rt::IOpacityMicromap>
+    {
+    public:
+        rt::OpacityMicromapDesc desc;
+        RefCountPtr<Buffer> dataBuffer;
+        bool compacted = false;
+
+        const rt::OpacityMicromapDesc& getDesc() const override { return desc; }
+        bool isCompacted() const override { return compacted; }
+        uint64_t getDeviceAddress() const override { return dataBuffer->gpuAddress; }
+    };
+
+    class AccelStruct : public RefCounter<rt::IAccelStruct>
+    {
+    public:
+        rt::AccelStructDesc desc;
+        RefCountPtr<Buffer> dataBuffer;
+        BufferHandle instanceBuffer;
+        bool compacted = false;
+        bool allowUpdate = false;
+
+        // Hold strong references to the BLAS'es and micromaps that a TLAS or BLAS is built from
+        std::vector<RefCountPtr<IResource>> buildReferences;
+
+        const rt::AccelStructDesc& getDesc() const override { return desc; }
+        bool isCompacted() const override { return compacted; }
+        uint64_t getDeviceAddress() const override { return dataBuffer ? dataBuffer->gpuAddress : 0; }
+        IBuffer* getInstanceBuffer() const override { return instanceBuffer; }
+    };
+
+    class RayTracingPipeline : public RefCounter<rt::IPipeline>
+    {
+    public:
+        rt::PipelineDesc desc;
+        std::unordered_map<std::string, rt::ShaderExportId> exports;
+
+        // Local binding layouts of the shaders and hit groups, indexed by export ID
+        std::vector<BindingLayoutHandle> exportBindingLayouts;
+
+        explicit RayTracingPipeline(const Context& context)
+            : m_Context(context)
+        { }
+
+        const rt::PipelineDesc& getDesc() const override { return desc; }
+        rt::ShaderTableHandle createShaderTable(rt::ShaderTableDesc const& stDesc) override;
+        rt::ShaderExportId getShaderExportId(const char* exportName) const override;
+
+    private:
+        const Context& m_Context;
+    };
+
+    class ShaderTable : public RefCounter<rt::IShaderTable>
+    {
+    public:
+        struct Entry
+        {
+            rt::ShaderExportId exportId = rt::ShaderExportId::Invalid;
+            BindingSetHandle localBindings;
+        };
+
+        RefCountPtr<RayTracingPipeline> pipeline;
+
+        Entry rayGenerationShader;
+        std::vector<Entry> missShaders;
+        std::vector<Entry> callableShaders;
+        std::vector<Entry> hitGroups;
+
+        uint32_t version = 0;
+
+        ShaderTable(const Context& context, RayTracingPipeline* _pipeline, rt::ShaderTableDesc const& desc)
+            : pipeline(_pipeline)
+            , m_Context(context)
+            , m_Desc(desc)
+        { }
+
+        rt::ShaderTableDesc const& getDesc() const override { return m_Desc; }
+        uint32_t getNumEntries() const override;
+        rt::IPipeline* getPipeline() const override { return pipeline; }
+        void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addHitGroups(const char* const* exportNames, IBindingSet* const* bindings, size_t count) override;
+        void setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        void setRayGenerationShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addMissShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addHitGroup(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addHitGroups(const rt::ShaderExportId* exportIds, IBindingSet* const* bindings, size_t count) override;
+        void setHitGroup(uint32_t index, rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addCallableShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        void clearMissShaders() override;
+        void clearHitShaders() override;
+        void clearCallableShaders() override;
+
+    private:
+        const Context& m_Context;
+        rt::ShaderTableDesc const m_Desc;
+
+        bool resolveExportName(const char* exportName, rt::ShaderExportId& outExportId) const;
+        bool verifyExport(rt::ShaderExportId exportId, IBindingSet* bindings) const;
+    };
+
+    // Sub-allocates the CPU memory that the uploads of a command list are copied into, like the upload managers
+    // of the other backends: from a ring if the command list has one, otherwise from chunks that are reused when
+    // the command list instance that used them has finished.
+    class UploadManager
+    {
+    public:
+        UploadManager(Queue* queue, MemoryStatisticsTracker& memoryStatistics, size_t defaultChunkSize, uint64_t ringSize);
+        ~UploadManager();
+
+        void* suballocate(uint64_t size, uint64_t currentVersion, uint32_t alignment = 256);
+        void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
+
+        // Adds the chunks and the ring to the upload chunk statistics
+        void getStatistics(MemoryStatistics& statistics) const;
+
+    private:
+        struct Chunk
+        {
+            std::unique_ptr<uint8_t[]> memory;
+            uint64_t size = 0;
+            uint64_t writePointer = 0;
+            uint64_t version = 0;
+        };
+
+        Queue* m_Queue;
+        MemoryStatisticsTracker& m_MemoryStatistics;
+        size_t m_DefaultChunkSize;
+        uint64_t m_AllocatedMemory = 0;
+
+        std::list<std::unique_ptr<Chunk>> m_ChunkPool;
+        std::unique_ptr<Chunk> m_CurrentChunk;
+
+        RingAllocator m_Ring;
+        std::unique_ptr<uint8_t[]> m_RingMemory;
+    };
+
+    class CommandList final : public RefCounter<ICommandList>
+    {
+    public:
+        CommandList(Device* device, const Context& context, const CommandListParameters& parameters);
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // ICommandList implementation
+
+        void open() override;
+        void close() override;
+        void clearState() override;
+
+        void clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor) override;
+        void clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil) override;
+        void clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor) override;
+
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
+        void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
+        void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources) override;
+        void* beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch) override;
+        void endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
+        void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter) override;
+        void blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter) override;
+
+        void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
+        void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
+        void copyBuffer(IBuffer* dest, uint64_t destOffsetBytes, IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override;
+
+        void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
+        void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format) override;
+        void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+
+        void setPushConstants(const void* data, size_t byteSize) override;
+
+        void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) override;
+        void setIndexBuffer(const IndexBufferBinding& indexBuffer) override;
+        void setViewportState(const ViewportState& viewport) override;
+        void draw(const DrawArguments& args) override;
+        void drawIndexed(const DrawArguments& args) override;
+        void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void executeBundles(ICommandList* const* bundles, size_t numBundles) override;
+
+        void setComputeState(const ComputeState& state) override;
+        void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchIndirect(uint32_t offsetBytes) override;
+
+        void setMeshletState(const MeshletState& state) override;
+        void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes) override;
+
+        void setRayTracingState(const rt::State& state) override;
+        void dispatchRays(const rt::DispatchRaysArguments& args) override;
+
+        void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
+        void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds) override;
+        void compactBottomLevelAccelStructs() override;
+        void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
+        void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+            rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
+        void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
+
+        void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
+
+        void beginTimerQuery(ITimerQuery* query) override;
+        void endTimerQuery(ITimerQuery* query) override;
+        void beginTimerQueryFrame(ITimerQueryPool* pool) override;
+        void beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimerQueries(ITimerQueryPool* pool) override;
+        void beginOcclusionQuery(IOcclusionQuery* query) override;
+        void endOcclusionQuery(IOcclusionQuery* query) override;
+        void beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void endPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void setPredication(IOcclusionQuery* query, PredicationOp op) override;
+        SyncPointHandle signalSyncPoint() override;
+        void waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages) override;
+
+        void beginMarker(const char* name) override;
+        void endMarker() override;
+
+        void setEnableAutomaticBarriers(bool enable) override;
+        void setResourceStatesForBindingSet(IBindingSet* bindingSet) override;
+
+        void setEnableUavBarriersForTexture(ITexture* texture, bool enableBarriers) override;
+        void setEnableUavBarriersForBuffer(IBuffer* buffer, bool enableBarriers) override;
+
+        void beginTrackingTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginTrackingBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void setTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void setBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+        void setAccelStructState(rt::IAccelStruct* as, ResourceStates stateBits) override;
+
+        void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
+        void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
+
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
+        void commitBarriers() override;
+
+        ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
+        ResourceStates getBufferState(IBuffer* buffer) override;
+
+        IDevice* getDevice() override;
+        const CommandListParameters& getDesc() override { return m_CommandListParameters; }
+        MemoryStatistics getMemoryStatistics() override;
+
+        // Internal methods
+
+        void executed(Queue& queue, uint64_t submissionID);
+        [[nodiscard]] const CommandListResourceStateTracker& getStateTracker() const { return m_StateTracker; }
+        [[nodiscard]] const BundleStateRequirements& getBundleStateRequirements() const { return m_BundleStateRequirements; }
+
+    private:
+        Device* m_Device;
+        const Context& m_Context;
+        CommandListParameters m_CommandListParameters;
+
+        CommandListResourceStateTracker m_StateTracker;
+        BundleStateRequirements m_BundleStateRequirements;
+        bool m_EnableAutomaticBarriers = true;
+        bool m_BindingStatesDirty = false;
+
+        UploadManager m_UploadManager;
+        uint64_t m_RecordingVersion = 0;
+        uint64_t m_ReusableSubmittedVersion = 0; // last execution of the current recording of a reusable command list
+
+        // Objects used by the current recording, released when it's executed or re-recorded
+        ResourceReferenceSet m_ReferencedResources;
+        std::vector<RefCountPtr<IBindingSet>> m_TransientBindingSets;
+        std::vector<RefCountPtr<SyncPoint>> m_SignaledSyncPoints;
+        std::vector<std::pair<RefCountPtr<TimerQueryPool>, uint64_t>> m_ResolvedTimerQueryFrames;
+
+        GraphicsState m_CurrentGraphicsState;
+        PendingGraphicsState m_PendingGraphicsState;
+        ComputeState m_CurrentComputeState;
+        MeshletState m_CurrentMeshletState;
+        rt::State m_CurrentRayTracingState;
+        bool m_CurrentGraphicsStateValid = false;
+        bool m_CurrentComputeStateValid = false;
+        bool m_CurrentMeshletStateValid = false;
+        bool m_CurrentRayTracingStateValid = false;
+
+        void requireTextureState(ITexture* texture, TextureSubresourceSet subresources, ResourceStates state);
+        void requireBufferState(IBuffer* buffer, ResourceStates state);
+        void requireStagingTextureState(IStagingTexture* texture);
+        void setResourceStatesForFramebuffer(IFramebuffer* framebuffer);
+        void insertResourceBarriersForBindingSets(const BindingSetVector& newBindings, const BindingSetVector& oldBindings);
+        void referenceBindingSets(const BindingSetVector& bindings);
+        void commitGraphicsStateChanges();
+        void writeTextureRegion(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch);
+        void* allocateUpload(uint64_t size);
+    };
+
+    class Device : public RefCounter<IDevice>
+    {
+    public:
+        explicit Device(const DeviceDesc& desc);
+        ~Device() override;
+
+        Queue& getQueue(CommandQueue queue) { return *m_Queues[uint32_t(queue)]; }
+
+        // IResource implementation
+
+        Object getNativeObject(ObjectType objectType) override;
+
+        // IDevice implementation
+
+        HeapHandle createHeap(const HeapDesc& d) override;
+
+        TextureHandle createTexture(const TextureDesc& d) override;
+        MemoryRequirements getTextureMemoryRequirements(ITexture* texture) override;
+        bool bindTextureMemory(ITexture* texture, IHeap* heap, uint64_t offset) override;
+
+        TextureHandle createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc) override;
+
+        StagingTextureHandle createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess) override;
+        void *mapStagingTexture(IStagingTexture* tex, const TextureSlice& slice, CpuAccessMode cpuAccess, size_t *outRowPitch) override;
+        void unmapStagingTexture(IStagingTexture* tex) override;
+
+        void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
+        void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+
+        SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
+        SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
+
+        BufferHandle createBuffer(const BufferDesc& d) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags) override;
+        void unmapBuffer(IBuffer* b) override;
+        MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
+        bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
+
+        BufferHandle createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc) override;
+
+        ShaderHandle createShader(const ShaderDesc& d, const void* binary, size_t binarySize) override;
+        ShaderHandle createShaderSpecialization(IShader* baseShader, const ShaderSpecialization* constants, uint32_t numConstants) override;
+        ShaderLibraryHandle createShaderLibrary(const void* binary, size_t binarySize) override;
+
+        SamplerHandle createSampler(const SamplerDesc& d) override;
+
+        InputLayoutHandle createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader) override;
+
+        // event queries
+        EventQueryHandle createEventQuery() override;
+        void setEventQuery(IEventQuery* query, CommandQueue queue) override;
+        bool pollEventQuery(IEventQuery* query) override;
+        void waitEventQuery(IEventQuery* query) override;
+        void resetEventQuery(IEventQuery* query) override;
+
+        // timer queries
+        TimerQueryHandle createTimerQuery() override;
+        bool pollTimerQuery(ITimerQuery* query) override;
+        float getTimerQueryTime(ITimerQuery* query) override;
+        void resetTimerQuery(ITimerQuery* query) override;
+        TimerQueryPoolHandle createTimerQueryPool(const TimerQueryPoolDesc& desc) override;
+        bool getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries) override;
+        bool getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries) override;
+        OcclusionQueryHandle createOcclusionQuery(OcclusionQueryType type) override;
+        bool pollOcclusionQuery(IOcclusionQuery* query) override;
+        uint64_t getOcclusionQueryResult(IOcclusionQuery* query) override;
+        void resetOcclusionQuery(IOcclusionQuery* query) override;
+        PipelineStatisticsQueryHandle createPipelineStatisticsQuery() override;
+        bool pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        PipelineStatistics getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query) override;
+        void resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+
+        GraphicsAPI getGraphicsAPI() override { return GraphicsAPI::NULL_DEVICE; }
+
+        FramebufferHandle createFramebuffer(const FramebufferDesc& desc) override;
+
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+        GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb) override;
+        ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& desc) override;
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo) override;
+        MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
+        rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        AsyncGraphicsPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback = nullptr) override;
+        AsyncComputePipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback = nullptr) override;
+        AsyncMeshletPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback = nullptr) override;
+        rt::AsyncPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback = nullptr) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+
+        BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
+        BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
+
+        BindingSetHandle createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
+        DescriptorTableHandle createDescriptorTable(IBindingLayout* layout) override;
+
+        void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems) override;
+
+        rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
+        rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
+        MemoryRequirements getAccelStructMemoryRequirements(rt::IAccelStruct* as) override;
+        rt::cluster::OperationSizeInfo getClusterOperationSizeInfo(const rt::cluster::OperationParams& params) override;
+        bool bindAccelStructMemory(rt::IAccelStruct* as, IHeap* heap, uint64_t offset) override;
+
+        CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
+        uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        StorageQueueHandle createStorageQueue(const StorageQueueDesc& desc) override;
+        bool waitForIdle() override;
+        void runGarbageCollection() override;
+        bool getVideoMemoryBudget(VideoMemoryBudget& outBudget) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void setResidencyPriority(IResource* resource, ResidencyPriority priority) override;
+        bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
+        FormatSupport queryFormatSupport(Format format) override;
+        coopvec::DeviceFeatures queryCoopVecFeatures() override;
+        size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        void getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes) override;
+        Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& outData) override;
+        bool mergePipelineCacheData(const void* data, size_t size) override;
+        IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
+        bool isAftermathEnabled() override { return false; }
+        AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
+
+    private:
+        Context m_Context;
+        std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> m_Queues;
+
+        // Serializes the submissions, which share the state handoff resolver
+        std::mutex m_ExecutionMutex;
+        std::unique_ptr<StateHandoffResolver> m_StateHandoffResolver;
+
+        PipelineCompiler m_PipelineCompiler;
+        AftermathCrashDumpHelper m_AftermathCrashDumpHelper;
+
+        RefCountPtr<Buffer> createBufferObject(const BufferDesc& desc);
+    };
+
+} // namespace nvrhi::null
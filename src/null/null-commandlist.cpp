@@ -0,0 +1,1591 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace nvrhi::null
+{
+    UploadManager::UploadManager(Queue* queue, MemoryStatisticsTracker& memoryStatistics, size_t defaultChunkSize, uint64_t ringSize)
+        : m_Queue(queue)
+        , m_MemoryStatistics(memoryStatistics)
+        , m_DefaultChunkSize(defaultChunkSize)
+    {
+        m_Ring.setSize(align<uint64_t>(ringSize, 256));
+    }
+
+    UploadManager::~UploadManager()
+    {
+        for (const auto& chunk : m_ChunkPool)
+            m_MemoryStatistics.released(MemoryCategory::UploadChunks, chunk->size);
+
+        if (m_CurrentChunk)
+            m_MemoryStatistics.released(MemoryCategory::UploadChunks, m_CurrentChunk->size);
+
+        if (m_RingMemory)
+            m_MemoryStatistics.released(MemoryCategory::UploadChunks, m_Ring.getSize());
+    }
+
+    void* UploadManager::suballocate(uint64_t size, uint64_t currentVersion, uint32_t alignment)
+    {
+        // Uploads that don't fit into the ring fall back to chunks
+        if (m_Ring.getSize() > 0)
+        {
+            if (!m_RingMemory)
+            {
+                m_RingMemory = std::make_unique<uint8_t[]>(size_t(m_Ring.getSize()));
+                m_AllocatedMemory += m_Ring.getSize();
+                m_MemoryStatistics.allocated(MemoryCategory::UploadChunks, m_Ring.getSize());
+            }
+
+            uint64_t offset = 0;
+            bool allocated = m_Ring.allocate(size, alignment, offset);
+
+            if (!allocated && m_Ring.hasRetirableSpace())
+            {
+                m_Ring.retire(m_Queue->getLastCompletedInstance());
+                allocated = m_Ring.allocate(size, alignment, offset);
+            }
+
+            if (allocated)
+                return m_RingMemory.get() + offset;
+        }
+
+        std::unique_ptr<Chunk> chunkToRetire;
+
+        // Try to allocate from the current chunk first
+        if (m_CurrentChunk)
+        {
+            uint64_t alignedOffset = align(m_CurrentChunk->writePointer, uint64_t(alignment));
+            uint64_t endOfDataInChunk = alignedOffset + size;
+
+            if (endOfDataInChunk <= m_CurrentChunk->size)
+            {
+                // The buffer can fit into the current chunk - great, we're done
+                m_CurrentChunk->writePointer = endOfDataInChunk;
+
+                return m_CurrentChunk->memory.get() + alignedOffset;
+            }
+
+            chunkToRetire = std::move(m_CurrentChunk);
+        }
+
+        const uint64_t completedInstance = m_Queue->getLastCompletedInstance();
+
+        // Try to find a chunk in the pool that's no longer used and is large enough to allocate our buffer
+        for (auto it = m_ChunkPool.begin(); it != m_ChunkPool.end(); ++it)
+        {
+            std::unique_ptr<Chunk>& chunk = *it;
+
+            if (VersionGetSubmitted(chunk->version)
+                && VersionGetInstance(chunk->version) <= completedInstance)
+            {
+                chunk->version = 0;
+            }
+
+            if (chunk->version == 0 && chunk->size >= size)
+            {
+                m_CurrentChunk = std::move(chunk);
+                m_ChunkPool.erase(it);
+                break;
+            }
+        }
+
+        if (chunkToRetire)
+        {
+            m_ChunkPool.push_back(std::move(chunkToRetire));
+        }
+
+        if (!m_CurrentChunk)
+        {
+            m_CurrentChunk = std::make_unique<Chunk>();
+            m_CurrentChunk->size = align<uint64_t>(std::max<uint64_t>(size, m_DefaultChunkSize), 65536);
+            m_CurrentChunk->memory = std::make_unique<uint8_t[]>(size_t(m_CurrentChunk->size));
+            m_AllocatedMemory += m_CurrentChunk->size;
+            m_MemoryStatistics.allocated(MemoryCategory::UploadChunks, m_CurrentChunk->size);
+        }
+
+        m_CurrentChunk->version = currentVersion;
+        m_CurrentChunk->writePointer = size;
+
+        return m_CurrentChunk->memory.get();
+    }
+
+    void UploadManager::submitChunks(uint64_t currentVersion, uint64_t submittedVersion)
+    {
+        m_Ring.submit(submittedVersion);
+
+        if (m_CurrentChunk)
+        {
+            m_ChunkPool.push_back(std::move(m_CurrentChunk));
+        }
+
+        for (const auto& chunk : m_ChunkPool)
+        {
+            if (chunk->version == currentVersion)
+                chunk->version = submittedVersion;
+        }
+    }
+
+    void UploadManager::getStatistics(MemoryStatistics& statistics) const
+    {
+        MemoryCategoryStatistics& result = statistics.get(MemoryCategory::UploadChunks);
+
+        // Chunks are never freed before the manager, so the allocated memory is also the peak
+        result.allocatedBytes += m_AllocatedMemory;
+        result.peakAllocatedBytes += m_AllocatedMemory;
+
+        auto addChunk = [&result](const Chunk& chunk)
+        {
+            // Chunks with a zero version have been recycled and hold no data
+            if (chunk.version != 0)
+                result.usedBytes += chunk.writePointer;
+            ++result.allocationCount;
+        };
+
+        for (const auto& chunk : m_ChunkPool)
+            addChunk(*chunk);
+
+        if (m_CurrentChunk)
+            addChunk(*m_CurrentChunk);
+
+        if (m_RingMemory)
+        {
+            result.usedBytes += m_Ring.getUsedSize();
+            ++result.allocationCount;
+        }
+    }
+
+    CommandList::CommandList(Device* device, const Context& context, const CommandListParameters& parameters)
+        : m_Device(device)
+        , m_Context(context)
+        , m_CommandListParameters(parameters)
+        , m_StateTracker(context.messageCallback)
+        , m_UploadManager(&device->getQueue(parameters.queueType), *context.memoryStatistics, parameters.uploadChunkSize, parameters.isBundle ? 0 : parameters.uploadRingSize)
+    {
+        m_StateTracker.setEnableStateHandoff(parameters.enableStateHandoff);
+        m_StateTracker.setKeepStatesAfterSubmission(parameters.reusable);
+    }
+
+    Object CommandList::getNativeObject(ObjectType objectType)
+    {
+        (void)objectType;
+        return nullptr;
+    }
+
+    MemoryStatistics CommandList::getMemoryStatistics()
+    {
+        MemoryStatistics statistics;
+        m_UploadManager.getStatistics(statistics);
+        return statistics;
+    }
+
+    IDevice* CommandList::getDevice()
+    {
+        return m_Device;
+    }
+
+    void CommandList::open()
+    {
+        if (m_CommandListParameters.reusable && m_RecordingVersion)
+        {
+            // Unpin the upload memory of the previous recording, which is complete if it was never executed
+            m_UploadManager.submitChunks(m_RecordingVersion, m_ReusableSubmittedVersion
+                ? m_ReusableSubmittedVersion
+                : MakeVersion(0, m_CommandListParameters.queueType, true));
+            m_ReusableSubmittedVersion = 0;
+            m_StateTracker.resetTrackedStates();
+        }
+
+        // The references of the previous recording are released here for the command lists that were closed
+        // but never executed, and for bundles, which are not passed to executeCommandLists.
+        m_ReferencedResources.clear();
+        m_TransientBindingSets.clear();
+        m_SignaledSyncPoints.clear();
+        m_ResolvedTimerQueryFrames.clear();
+
+        if (m_CommandListParameters.isBundle)
+            m_BundleStateRequirements.clear();
+
+        Queue& queue = m_Device->getQueue(m_CommandListParameters.queueType);
+        m_RecordingVersion = MakeVersion(++queue.lastRecordingID, m_CommandListParameters.queueType, false);
+
+        clearState();
+    }
+
+    void CommandList::close()
+    {
+        if (!m_CommandListParameters.isBundle)
+        {
+            m_StateTracker.endSplitTransitions();
+            m_StateTracker.keepBufferInitialStates();
+            m_StateTracker.keepTextureInitialStates();
+            commitBarriers();
+        }
+
+        clearState();
+    }
+
+    void CommandList::clearState()
+    {
+        m_CurrentGraphicsState = GraphicsState();
+        m_CurrentComputeState = ComputeState();
+        m_CurrentMeshletState = MeshletState();
+        m_CurrentRayTracingState = rt::State();
+        m_PendingGraphicsState.reset();
+
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+
+        m_BindingStatesDirty = true;
+    }
+
+    void CommandList::executed(Queue& queue, uint64_t submissionID)
+    {
+        const uint64_t submittedVersion = MakeVersion(submissionID, queue.getQueueID(), true);
+
+        for (const auto& syncPoint : m_SignaledSyncPoints)
+            syncPoint->value.store(submissionID);
+
+        for (const auto& [pool, frameIndex] : m_ResolvedTimerQueryFrames)
+        {
+            // Frames of one pool are resolved in order, but they may be submitted from different threads
+            uint64_t executedFrameIndex = pool->lastExecutedFrameIndex.load();
+            while (executedFrameIndex < frameIndex && !pool->lastExecutedFrameIndex.compare_exchange_weak(executedFrameIndex, frameIndex))
+                ;
+        }
+
+        if (m_CommandListParameters.reusable)
+        {
+            // Keep the references and the upload memory for the next executions, until the list is opened again
+            m_ReusableSubmittedVersion = submittedVersion;
+            m_StateTracker.commandListSubmitted();
+            return;
+        }
+
+        m_UploadManager.submitChunks(m_RecordingVersion, submittedVersion);
+        m_SignaledSyncPoints.clear();
+        m_ResolvedTimerQueryFrames.clear();
+
+        // The work is complete when submitted, so the objects used by it can be released now
+        m_ReferencedResources.clear();
+        m_TransientBindingSets.clear();
+
+        m_StateTracker.commandListSubmitted();
+    }
+
+    void* CommandList::allocateUpload(uint64_t size)
+    {
+        return m_UploadManager.suballocate(size, m_RecordingVersion);
+    }
+
+    void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (m_CommandListParameters.isBundle)
+        {
+            if (!m_BundleStateRequirements.requireTextureState(texture, subresources, state))
+            {
+                std::stringstream ss;
+                ss << "Resource " << utils::DebugNameToString(texture->desc.debugName) << " is used in different states within the same "
+                    "bundle, which requires a barrier that cannot be placed in a bundle";
+                m_Context.error(ss.str());
+            }
+            return;
+        }
+
+        m_StateTracker.requireTextureState(texture, subresources, state);
+    }
+
+    void CommandList::requireBufferState(IBuffer* _buffer, ResourceStates state)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (m_CommandListParameters.isBundle)
+        {
+            if (!m_BundleStateRequirements.requireBufferState(buffer, state))
+            {
+                std::stringstream ss;
+                ss << "Resource " << utils::DebugNameToString(buffer->desc.debugName) << " is used in different states within the same "
+                    "bundle, which requires a barrier that cannot be placed in a bundle";
+                m_Context.error(ss.str());
+            }
+            return;
+        }
+
+        m_StateTracker.requireBufferState(buffer, state);
+    }
+
+    void CommandList::setResourceStatesForFramebuffer(IFramebuffer* framebuffer)
+    {
+        const FramebufferDesc& desc = framebuffer->getDesc();
+
+        for (const auto& attachment : desc.colorAttachments)
+        {
+            requireTextureState(attachment.texture, attachment.subresources, ResourceStates::RenderTarget);
+        }
+
+        if (desc.depthAttachment.valid())
+        {
+            requireTextureState(desc.depthAttachment.texture, desc.depthAttachment.subresources,
+                desc.depthAttachment.isReadOnly ? ResourceStates::DepthRead : ResourceStates::DepthWrite);
+        }
+
+        if (desc.shadingRateAttachment.valid())
+        {
+            requireTextureState(desc.shadingRateAttachment.texture, desc.shadingRateAttachment.subresources, ResourceStates::ShadingRateSurface);
+        }
+    }
+
+    void CommandList::setResourceStatesForBindingSet(IBindingSet* _bindingSet)
+    {
+        if (_bindingSet == nullptr)
+            return;
+        if (_bindingSet->getDesc() == nullptr)
+            return; // is bindless
+
+        BindingSet* bindingSet = checked_cast<BindingSet*>(_bindingSet);
+
+        for (auto bindingIndex : bindingSet->bindingsThatNeedTransitions)
+        {
+            const BindingSetItem& binding = bindingSet->desc.bindings[bindingIndex];
+
+            switch(binding.type)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+                case ResourceType::Texture_SRV:
+                    requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::ShaderResource);
+                    break;
+
+                case ResourceType::Texture_UAV:
+                    requireTextureState(checked_cast<ITexture*>(binding.resourceHandle), binding.subresources, ResourceStates::UnorderedAccess);
+                    break;
+
+                case ResourceType::TypedBuffer_SRV:
+                case ResourceType::StructuredBuffer_SRV:
+                case ResourceType::RawBuffer_SRV:
+                    requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ShaderResource);
+                    break;
+
+                case ResourceType::TypedBuffer_UAV:
+                case ResourceType::StructuredBuffer_UAV:
+                case ResourceType::RawBuffer_UAV:
+                    requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::UnorderedAccess);
+                    break;
+
+                case ResourceType::ConstantBuffer:
+                    requireBufferState(checked_cast<IBuffer*>(binding.resourceHandle), ResourceStates::ConstantBuffer);
+                    break;
+
+                case ResourceType::RayTracingAccelStruct:
+                    requireBufferState(checked_cast<AccelStruct*>(binding.resourceHandle)->dataBuffer, ResourceStates::AccelStructRead);
+                    break;
+
+                default:
+                    // do nothing
+                    break;
+            }
+        }
+    }
+
+    void CommandList::insertResourceBarriersForBindingSets(const BindingSetVector& newBindings, const BindingSetVector& oldBindings)
+    {
+        uint32_t bindingUpdateMask = 0;
+
+        if (m_BindingStatesDirty)
+            bindingUpdateMask = ~0u;
+
+        if (bindingUpdateMask == 0)
+            bindingUpdateMask = arrayDifferenceMask(newBindings, oldBindings);
+
+        if (bindingUpdateMask != 0)
+        {
+            for (size_t i = 0; i < newBindings.size(); i++)
+            {
+                if (!newBindings[i] || newBindings[i]->getDesc() == nullptr) // Ignore bindless sets
+                    continue;
+
+                BindingSet const* bindingSet = checked_cast<BindingSet const*>(newBindings[i]);
+
+                bool const updateThisSet = (bindingUpdateMask & (1u << i)) != 0;
+                if (updateThisSet || bindingSet->hasUavBindings) // UAV bindings may place UAV barriers on the same binding set
+                    setResourceStatesForBindingSet(newBindings[i]);
+            }
+        }
+    }
+
+    void CommandList::referenceBindingSets(const BindingSetVector& bindings)
+    {
+        for (IBindingSet* bindingSet : bindings)
+            m_ReferencedResources.push_back(bindingSet);
+    }
+
+    void CommandList::clearTextureFloat(ITexture* t, TextureSubresourceSet subresources, const Color& clearColor)
+    {
+        (void)clearColor;
+
+        if (m_EnableAutomaticBarriers)
+            requireTextureState(t, subresources, ResourceStates::RenderTarget);
+        commitBarriers();
+
+        m_ReferencedResources.push_back(t);
+    }
+
+    void CommandList::clearDepthStencilTexture(ITexture* t, TextureSubresourceSet subresources, bool clearDepth, float depth, bool clearStencil, uint8_t stencil)
+    {
+        (void)depth;
+        (void)stencil;
+
+        if (!clearDepth && !clearStencil)
+            return;
+
+        if (m_EnableAutomaticBarriers)
+            requireTextureState(t, subresources, ResourceStates::DepthWrite);
+        commitBarriers();
+
+        m_ReferencedResources.push_back(t);
+    }
+
+    void CommandList::clearTextureUInt(ITexture* t, TextureSubresourceSet subresources, uint32_t clearColor)
+    {
+        (void)clearColor;
+
+        if (m_EnableAutomaticBarriers)
+            requireTextureState(t, subresources, ResourceStates::UnorderedAccess);
+        commitBarriers();
+
+        m_ReferencedResources.push_back(t);
+    }
+
+    void CommandList::copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        const TextureSlice resolvedDstSlice = destSlice.resolve(dest->getDesc());
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->getDesc());
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::CopyDest);
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::copyTexture(IStagingTexture* _dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice)
+    {
+        StagingTexture* dest = checked_cast<StagingTexture*>(_dest);
+        const TextureSlice resolvedDstSlice = destSlice.resolve(dest->desc);
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->getDesc());
+
+        (void)resolvedDstSlice;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* _src, const TextureSlice& srcSlice)
+    {
+        StagingTexture* src = checked_cast<StagingTexture*>(_src);
+        const TextureSlice resolvedDstSlice = destSlice.resolve(dest->getDesc());
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->desc);
+
+        (void)resolvedSrcSlice;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::writeTextureRegion(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        const TextureDesc& desc = dest->getDesc();
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        const size_t uploadRowPitch = getTextureRowPitch(desc, mipLevel);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t numRows = (height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        uint8_t* uploadMemory = static_cast<uint8_t*>(allocateUpload(uint64_t(uploadRowPitch) * numRows * depth));
+
+        // Repack the rows like the other backends do when copying into the upload buffer
+        if (data)
+        {
+            for (uint32_t z = 0; z < depth; z++)
+            {
+                const uint8_t* srcSlice = static_cast<const uint8_t*>(data) + depthPitch * z;
+                for (uint32_t row = 0; row < numRows; row++)
+                {
+                    memcpy(uploadMemory + (size_t(z) * numRows + row) * uploadRowPitch, srcSlice + rowPitch * row, std::min(rowPitch, uploadRowPitch));
+                }
+            }
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+    }
+
+    void CommandList::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        writeTextureRegion(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
+    }
+
+    void CommandList::writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources)
+    {
+        for (size_t i = 0; i < numSubresources; i++)
+        {
+            const TextureSubresourceData& subresource = subresources[i];
+            writeTextureRegion(dest, subresource.arraySlice, subresource.mipLevel, subresource.data, subresource.rowPitch, subresource.depthPitch);
+        }
+    }
+
+    void* CommandList::beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch)
+    {
+        const TextureDesc& desc = dest->getDesc();
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        const size_t rowPitch = getTextureRowPitch(desc, mipLevel);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const size_t depthPitch = rowPitch * ((height + formatInfo.blockSize - 1) / formatInfo.blockSize);
+
+        if (outRowPitch) *outRowPitch = rowPitch;
+        if (outDepthPitch) *outDepthPitch = depthPitch;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(mipLevel, 1, arraySlice, 1), ResourceStates::CopyDest);
+        }
+
+        m_ReferencedResources.push_back(dest);
+
+        return allocateUpload(getTextureSubresourceSize(desc, mipLevel));
+    }
+
+    void CommandList::endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        (void)dest;
+        (void)arraySlice;
+        (void)mipLevel;
+
+        commitBarriers();
+    }
+
+    void CommandList::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, dstSubresources, ResourceStates::ResolveDest);
+            requireTextureState(src, srcSubresources, ResourceStates::ResolveSource);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter)
+    {
+        (void)linearFilter;
+
+        const TextureSubresourceSet resolved = subresources.resolve(texture->getDesc(), false);
+
+        if (resolved.numMipLevels < 2)
+            return;
+
+        // Each level is read as a shader resource and the next one is written as a render target
+        for (MipLevel mipLevel = resolved.baseMipLevel; mipLevel + 1 < resolved.baseMipLevel + resolved.numMipLevels; mipLevel++)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireTextureState(texture, TextureSubresourceSet(mipLevel, 1, resolved.baseArraySlice, resolved.numArraySlices), ResourceStates::ShaderResource);
+                requireTextureState(texture, TextureSubresourceSet(mipLevel + 1, 1, resolved.baseArraySlice, resolved.numArraySlices), ResourceStates::RenderTarget);
+            }
+            commitBarriers();
+        }
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter)
+    {
+        (void)linearFilter;
+
+        const TextureSlice resolvedDstSlice = destSlice.resolve(dest->getDesc());
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->getDesc());
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(resolvedDstSlice.mipLevel, 1, resolvedDstSlice.arraySlice, 1), ResourceStates::RenderTarget);
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::ShaderResource);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::writeBuffer(IBuffer* _buffer, const void* data, size_t dataSize, uint64_t destOffsetBytes)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        // Volatile buffers and regular buffers both receive the data through the upload memory
+        void* uploadMemory = allocateUpload(dataSize);
+        memcpy(uploadMemory, data, dataSize);
+
+        if (!buffer->desc.isVolatile)
+        {
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(buffer, ResourceStates::CopyDest);
+            }
+            commitBarriers();
+        }
+
+        // Make the CPU-visible buffers see the contents, as if the copy had been executed
+        if (!buffer->hostMemory.empty() && destOffsetBytes + dataSize <= buffer->hostMemory.size())
+            memcpy(buffer->hostMemory.data() + destOffsetBytes, data, dataSize);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::clearBufferUInt(IBuffer* b, uint32_t clearValue)
+    {
+        (void)clearValue;
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(b, ResourceStates::UnorderedAccess);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(b);
+    }
+
+    void CommandList::copyBuffer(IBuffer* _dest, uint64_t destOffsetBytes, IBuffer* _src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes)
+    {
+        Buffer* dest = checked_cast<Buffer*>(_dest);
+        Buffer* src = checked_cast<Buffer*>(_src);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(dest, ResourceStates::CopyDest);
+            requireBufferState(src, ResourceStates::CopySource);
+        }
+        commitBarriers();
+
+        if (!dest->hostMemory.empty() && !src->hostMemory.empty()
+            && destOffsetBytes + dataSizeBytes <= dest->hostMemory.size()
+            && srcOffsetBytes + dataSizeBytes <= src->hostMemory.size())
+        {
+            memmove(dest->hostMemory.data() + destOffsetBytes, src->hostMemory.data() + srcOffsetBytes, size_t(dataSizeBytes));
+        }
+
+        m_ReferencedResources.push_back(dest);
+        m_ReferencedResources.push_back(src);
+    }
+
+    void CommandList::clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture)
+    {
+        (void)texture;
+        utils::NotSupported();
+    }
+
+    void CommandList::decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format)
+    {
+        (void)buffer;
+        (void)texture;
+        (void)format;
+        utils::NotSupported();
+    }
+
+    void CommandList::setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits)
+    {
+        (void)texture;
+        (void)stateBits;
+        utils::NotSupported();
+    }
+
+    IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSetHandle bindingSet = m_Device->createBindingSet(desc, layout);
+        if (!bindingSet)
+            return nullptr;
+
+        m_TransientBindingSets.push_back(bindingSet);
+        return bindingSet;
+    }
+
+    void CommandList::setPushConstants(const void* data, size_t byteSize)
+    {
+        (void)data;
+        (void)byteSize;
+    }
+
+    void CommandList::setGraphicsState(const GraphicsState& state)
+    {
+        // The complete state replaces anything set with the incremental setters since the last draw
+        m_PendingGraphicsState.reset();
+
+        if (m_EnableAutomaticBarriers)
+        {
+            insertResourceBarriersForBindingSets(state.bindings, m_CurrentGraphicsState.bindings);
+
+            if (state.indexBuffer.buffer && (m_BindingStatesDirty || state.indexBuffer.buffer != m_CurrentGraphicsState.indexBuffer.buffer))
+            {
+                requireBufferState(state.indexBuffer.buffer, ResourceStates::IndexBuffer);
+            }
+
+            if (m_BindingStatesDirty || arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
+            {
+                for (const auto& vb : state.vertexBuffers)
+                {
+                    requireBufferState(vb.buffer, ResourceStates::VertexBuffer);
+                }
+            }
+
+            if (state.framebuffer && (m_BindingStatesDirty || m_CurrentGraphicsState.framebuffer != state.framebuffer))
+            {
+                setResourceStatesForFramebuffer(state.framebuffer);
+            }
+
+            if (state.indirectParams && (m_BindingStatesDirty || state.indirectParams != m_CurrentGraphicsState.indirectParams))
+            {
+                requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
+            }
+
+            if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentGraphicsState.indirectCountBuffer))
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+
+            m_BindingStatesDirty = false;
+        }
+
+        commitBarriers();
+
+        if (!m_CurrentGraphicsStateValid || m_CurrentGraphicsState.pipeline != state.pipeline)
+            m_ReferencedResources.push_back(state.pipeline);
+
+        if (!m_CurrentGraphicsStateValid || m_CurrentGraphicsState.framebuffer != state.framebuffer)
+            m_ReferencedResources.push_back(state.framebuffer);
+
+        if (!m_CurrentGraphicsStateValid || arraysAreDifferent(m_CurrentGraphicsState.bindings, state.bindings))
+            referenceBindingSets(state.bindings);
+
+        if (state.indexBuffer.buffer)
+            m_ReferencedResources.push_back(state.indexBuffer.buffer);
+
+        for (const auto& vb : state.vertexBuffers)
+            m_ReferencedResources.push_back(vb.buffer);
+
+        m_ReferencedResources.push_back(state.indirectParams);
+        m_ReferencedResources.push_back(state.indirectCountBuffer);
+
+        m_CurrentGraphicsState = state;
+        m_CurrentGraphicsStateValid = true;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+    }
+
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        m_PendingGraphicsState.setBindingSet(m_CurrentGraphicsState.bindings, slot, bindingSet);
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers)
+    {
+        m_PendingGraphicsState.setVertexBuffers(m_CurrentGraphicsState.vertexBuffers, vertexBuffers, numVertexBuffers);
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_PendingGraphicsState.setIndexBuffer(m_CurrentGraphicsState.indexBuffer, indexBuffer);
+    }
+
+    void CommandList::setViewportState(const ViewportState& viewport)
+    {
+        m_PendingGraphicsState.setViewport(m_CurrentGraphicsState.viewport, viewport);
+    }
+
+    void CommandList::commitGraphicsStateChanges()
+    {
+        const PendingGraphicsState& pending = m_PendingGraphicsState;
+
+        if (!m_CurrentGraphicsStateValid)
+        {
+            m_PendingGraphicsState.reset();
+            return;
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            if (pending.isDirty(GraphicsStateDirtyFlags::Bindings))
+                insertResourceBarriersForBindingSets(pending.bindings, m_CurrentGraphicsState.bindings);
+
+            if (pending.isDirty(GraphicsStateDirtyFlags::IndexBuffer) && pending.indexBuffer.buffer)
+                requireBufferState(pending.indexBuffer.buffer, ResourceStates::IndexBuffer);
+
+            if (pending.isDirty(GraphicsStateDirtyFlags::VertexBuffers))
+            {
+                for (const auto& vb : pending.vertexBuffers)
+                    requireBufferState(vb.buffer, ResourceStates::VertexBuffer);
+            }
+        }
+
+        commitBarriers();
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Bindings))
+        {
+            referenceBindingSets(pending.bindings);
+            m_CurrentGraphicsState.bindings = pending.bindings;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::IndexBuffer))
+        {
+            m_ReferencedResources.push_back(pending.indexBuffer.buffer);
+            m_CurrentGraphicsState.indexBuffer = pending.indexBuffer;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::VertexBuffers))
+        {
+            for (const auto& vb : pending.vertexBuffers)
+                m_ReferencedResources.push_back(vb.buffer);
+
+            m_CurrentGraphicsState.vertexBuffers = pending.vertexBuffers;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Viewport))
+        {
+            m_CurrentGraphicsState.viewport = pending.viewport;
+        }
+
+        m_PendingGraphicsState.reset();
+    }
+
+    void CommandList::draw(const DrawArguments& args)
+    {
+        (void)args;
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+    }
+
+    void CommandList::drawIndexed(const DrawArguments& args)
+    {
+        (void)args;
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+    }
+
+    void CommandList::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+    }
+
+    void CommandList::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
+    {
+        (void)offsetBytes;
+        (void)drawCount;
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+    }
+
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countOffsetBytes;
+        (void)maxDrawCount;
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+    }
+
+    void CommandList::executeBundles(ICommandList* const* bundles, size_t numBundles)
+    {
+        for (size_t i = 0; i < numBundles; i++)
+        {
+            CommandList* bundle = checked_cast<CommandList*>(bundles[i]);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                bundle->m_BundleStateRequirements.apply(m_StateTracker);
+            }
+
+            // The resources used by the bundle are referenced by the bundle itself
+            m_ReferencedResources.push_back(bundle);
+        }
+
+        commitBarriers();
+
+        // None of the state set by the bundles is inherited back
+        clearState();
+    }
+
+    void CommandList::setComputeState(const ComputeState& state)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            insertResourceBarriersForBindingSets(state.bindings, m_CurrentComputeState.bindings);
+
+            if (state.indirectParams && (m_BindingStatesDirty || state.indirectParams != m_CurrentComputeState.indirectParams))
+            {
+                requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
+            }
+
+            if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentComputeState.indirectCountBuffer))
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+
+            m_BindingStatesDirty = false;
+        }
+
+        commitBarriers();
+
+        if (!m_CurrentComputeStateValid || m_CurrentComputeState.pipeline != state.pipeline)
+            m_ReferencedResources.push_back(state.pipeline);
+
+        if (!m_CurrentComputeStateValid || arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings))
+            referenceBindingSets(state.bindings);
+
+        m_ReferencedResources.push_back(state.indirectParams);
+        m_ReferencedResources.push_back(state.indirectCountBuffer);
+
+        m_CurrentComputeState = state;
+        m_CurrentComputeStateValid = true;
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentGraphicsState = GraphicsState();
+        m_PendingGraphicsState.reset();
+    }
+
+    void CommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        (void)groupsX;
+        (void)groupsY;
+        (void)groupsZ;
+    }
+
+    void CommandList::dispatchIndirect(uint32_t offsetBytes)
+    {
+        (void)offsetBytes;
+    }
+
+    void CommandList::setMeshletState(const MeshletState& state)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            insertResourceBarriersForBindingSets(state.bindings, m_CurrentMeshletState.bindings);
+
+            if (state.framebuffer && (m_BindingStatesDirty || m_CurrentMeshletState.framebuffer != state.framebuffer))
+            {
+                setResourceStatesForFramebuffer(state.framebuffer);
+            }
+
+            if (state.indirectParams && (m_BindingStatesDirty || state.indirectParams != m_CurrentMeshletState.indirectParams))
+            {
+                requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
+            }
+
+            if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentMeshletState.indirectCountBuffer))
+            {
+                requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+            }
+
+            m_BindingStatesDirty = false;
+        }
+
+        commitBarriers();
+
+        if (!m_CurrentMeshletStateValid || m_CurrentMeshletState.pipeline != state.pipeline)
+            m_ReferencedResources.push_back(state.pipeline);
+
+        if (!m_CurrentMeshletStateValid || m_CurrentMeshletState.framebuffer != state.framebuffer)
+            m_ReferencedResources.push_back(state.framebuffer);
+
+        if (!m_CurrentMeshletStateValid || arraysAreDifferent(m_CurrentMeshletState.bindings, state.bindings))
+            referenceBindingSets(state.bindings);
+
+        m_ReferencedResources.push_back(state.indirectParams);
+        m_ReferencedResources.push_back(state.indirectCountBuffer);
+
+        m_CurrentMeshletState = state;
+        m_CurrentMeshletStateValid = true;
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentRayTracingStateValid = false;
+        m_CurrentGraphicsState = GraphicsState();
+        m_PendingGraphicsState.reset();
+    }
+
+    void CommandList::dispatchMesh(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        (void)groupsX;
+        (void)groupsY;
+        (void)groupsZ;
+    }
+
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        (void)offsetBytes;
+        (void)dispatchCount;
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        (void)paramOffsetBytes;
+        (void)countOffsetBytes;
+        (void)maxDispatchCount;
+    }
+
+    void CommandList::executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes)
+    {
+        (void)paramOffsetBytes;
+        (void)maxCommandCount;
+        (void)countOffsetBytes;
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
+        m_ReferencedResources.push_back(signature);
+    }
+
+    void CommandList::setRayTracingState(const rt::State& state)
+    {
+        if (m_EnableAutomaticBarriers)
+        {
+            insertResourceBarriersForBindingSets(state.bindings, m_CurrentRayTracingState.bindings);
+
+            m_BindingStatesDirty = false;
+        }
+
+        commitBarriers();
+
+        if (!m_CurrentRayTracingStateValid || m_CurrentRayTracingState.shaderTable != state.shaderTable)
+        {
+            // The shader table holds the pipeline and the local binding sets
+            m_ReferencedResources.push_back(state.shaderTable);
+        }
+
+        if (!m_CurrentRayTracingStateValid || arraysAreDifferent(m_CurrentRayTracingState.bindings, state.bindings))
+            referenceBindingSets(state.bindings);
+
+        m_CurrentRayTracingState = state;
+        m_CurrentRayTracingStateValid = true;
+        m_CurrentGraphicsStateValid = false;
+        m_CurrentComputeStateValid = false;
+        m_CurrentMeshletStateValid = false;
+        m_CurrentGraphicsState = GraphicsState();
+        m_PendingGraphicsState.reset();
+    }
+
+    void CommandList::dispatchRays(const rt::DispatchRaysArguments& args)
+    {
+        (void)args;
+    }
+
+    void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc)
+    {
+        rt::OpacityMicromapBuildDesc build;
+        build.setOpacityMicromap(omm).setDesc(&desc);
+
+        buildOpacityMicromaps(&build, 1);
+    }
+
+    void CommandList::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds)
+    {
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+            const rt::OpacityMicromapDesc& desc = builds[buildIndex].desc ? *builds[buildIndex].desc : omm->desc;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
+                requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
+                requireBufferState(omm->dataBuffer, ResourceStates::OpacityMicromapWrite);
+            }
+
+            m_ReferencedResources.push_back(omm);
+            m_ReferencedResources.push_back(desc.inputBuffer);
+            m_ReferencedResources.push_back(desc.perOmmDescs);
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::compactOpacityMicromaps()
+    {
+    }
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        rt::BlasBuildDesc build;
+        build.setAccelStruct(as).setGeometries(pGeometries, numGeometries).setBuildFlags(buildFlags);
+
+        buildBottomLevelAccelStructs(&build, 1);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds)
+    {
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+
+            if (m_EnableAutomaticBarriers)
+            {
+                for (size_t i = 0; i < build.numGeometries; i++)
+                {
+                    // The first two fields of all geometry types are input buffers
+                    const rt::GeometryTriangles& buffers = build.geometries[i].geometryData.triangles;
+
+                    if (buffers.indexBuffer)
+                        requireBufferState(buffers.indexBuffer, ResourceStates::AccelStructBuildInput);
+                    if (buffers.vertexBuffer)
+                        requireBufferState(buffers.vertexBuffer, ResourceStates::AccelStructBuildInput);
+
+                    if (build.geometries[i].geometryType == rt::GeometryType::Triangles && buffers.opacityMicromap)
+                        requireBufferState(checked_cast<OpacityMicromap*>(buffers.opacityMicromap)->dataBuffer, ResourceStates::AccelStructBuildInput);
+                }
+
+                requireBufferState(as->dataBuffer, ResourceStates::AccelStructWrite);
+            }
+
+            for (size_t i = 0; i < build.numGeometries; i++)
+            {
+                const rt::GeometryTriangles& buffers = build.geometries[i].geometryData.triangles;
+                m_ReferencedResources.push_back(buffers.indexBuffer);
+                m_ReferencedResources.push_back(buffers.vertexBuffer);
+
+                if (build.geometries[i].geometryType == rt::GeometryType::Triangles)
+                    m_ReferencedResources.push_back(buffers.opacityMicromap);
+            }
+
+            m_ReferencedResources.push_back(as);
+        }
+
+        commitBarriers();
+    }
+
+    void CommandList::compactBottomLevelAccelStructs()
+    {
+    }
+
+    void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
+    {
+        (void)buildFlags;
+
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (numInstances > as->desc.topLevelMaxInstances)
+        {
+            std::stringstream ss;
+            ss << "Attempted to build TLAS " << utils::DebugNameToString(as->desc.debugName) << " with " << numInstances
+               << " instances, which is greater than topLevelMaxInstances (" << as->desc.topLevelMaxInstances << ")";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        // The instances are copied into the upload memory, with the BLAS pointers replaced by their addresses
+        rt::InstanceDesc* uploadInstances = static_cast<rt::InstanceDesc*>(allocateUpload(std::max<uint64_t>(numInstances, 1) * sizeof(rt::InstanceDesc)));
+
+        as->buildReferences.clear();
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            const rt::InstanceDesc& instance = pInstances[i];
+            AccelStruct* blas = checked_cast<AccelStruct*>(instance.bottomLevelAS);
+
+            uploadInstances[i] = instance;
+            uploadInstances[i].blasDeviceAddress = blas ? blas->getDeviceAddress() : 0;
+
+            if (blas)
+            {
+                as->buildReferences.push_back(blas);
+
+                if (m_EnableAutomaticBarriers)
+                    requireBufferState(blas->dataBuffer, ResourceStates::AccelStructBuildBlas);
+            }
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->dataBuffer, ResourceStates::AccelStructWrite);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(as);
+    }
+
+    void CommandList::buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* _as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
+        rt::AccelStructBuildFlags buildFlags)
+    {
+        (void)instanceBufferOffset;
+        (void)buildFlags;
+
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (numInstances > as->desc.topLevelMaxInstances)
+        {
+            std::stringstream ss;
+            ss << "Attempted to build TLAS " << utils::DebugNameToString(as->desc.debugName) << " with " << numInstances
+               << " instances, which is greater than topLevelMaxInstances (" << as->desc.topLevelMaxInstances << ")";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        // The BLAS'es are only known by their addresses, so they can't be kept alive by the TLAS
+        as->buildReferences.clear();
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(instanceBuffer, ResourceStates::AccelStructBuildInput);
+            requireBufferState(as->dataBuffer, ResourceStates::AccelStructWrite);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(as);
+        m_ReferencedResources.push_back(instanceBuffer);
+    }
+
+    void CommandList::updateTopLevelAccelStructInstances(rt::IAccelStruct* _as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (!as->instanceBuffer)
+        {
+            std::stringstream ss;
+            ss << "Cannot update the instances of TLAS " << utils::DebugNameToString(as->desc.debugName)
+               << " that was created without createInstanceBuffer";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        if (firstInstance + numInstances > as->desc.topLevelMaxInstances)
+        {
+            std::stringstream ss;
+            ss << "Attempted to update instances " << firstInstance << " to " << firstInstance + numInstances - 1
+               << " of TLAS " << utils::DebugNameToString(as->desc.debugName)
+               << ", which has topLevelMaxInstances = " << as->desc.topLevelMaxInstances;
+            m_Context.error(ss.str());
+            return;
+        }
+
+        rt::InstanceDesc* uploadInstances = static_cast<rt::InstanceDesc*>(allocateUpload(std::max<uint64_t>(numInstances, 1) * sizeof(rt::InstanceDesc)));
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            AccelStruct* blas = checked_cast<AccelStruct*>(pInstances[i].bottomLevelAS);
+
+            uploadInstances[i] = pInstances[i];
+            uploadInstances[i].blasDeviceAddress = blas ? blas->getDeviceAddress() : 0;
+
+            if (blas)
+                as->buildReferences.push_back(blas);
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireBufferState(as->instanceBuffer, ResourceStates::CopyDest);
+        }
+        commitBarriers();
+
+        m_ReferencedResources.push_back(as);
+    }
+
+    void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
+    {
+        (void)desc;
+        utils::NotSupported();
+    }
+
+    void CommandList::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
+    {
+        (void)convertDescs;
+        (void)numDescs;
+        utils::NotSupported();
+    }
+
+    void CommandList::beginTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        query->started = true;
+        query->resolved = false;
+
+        m_ReferencedResources.push_back(query);
+    }
+
+    void CommandList::endTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        // The queries are resolved at the end of the command list on the other backends, and the work here
+        // completes when it's submitted, so the result is as good as available by the time anyone polls it
+        query->resolved = true;
+
+        m_ReferencedResources.push_back(query);
+    }
+
+    void CommandList::beginTimerQueryFrame(ITimerQueryPool* _pool)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        ++pool->currentFrameIndex;
+
+        m_ReferencedResources.push_back(pool);
+    }
+
+    void CommandList::beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex)
+    {
+        (void)pool;
+        (void)queryIndex;
+    }
+
+    void CommandList::endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex)
+    {
+        (void)pool;
+        (void)queryIndex;
+    }
+
+    void CommandList::resolveTimerQueries(ITimerQueryPool* _pool)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        m_ResolvedTimerQueryFrames.emplace_back(pool, pool->currentFrameIndex.load());
+    }
+
+    void CommandList::beginOcclusionQuery(IOcclusionQuery* query)
+    {
+        m_ReferencedResources.push_back(query);
+    }
+
+    void CommandList::endOcclusionQuery(IOcclusionQuery* query)
+    {
+        (void)query;
+    }
+
+    void CommandList::beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        m_ReferencedResources.push_back(query);
+    }
+
+    void CommandList::endPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        (void)query;
+    }
+
+    void CommandList::setPredication(IOcclusionQuery* query, PredicationOp op)
+    {
+        (void)op;
+
+        m_ReferencedResources.push_back(query);
+    }
+
+    SyncPointHandle CommandList::signalSyncPoint()
+    {
+        RefCountPtr<SyncPoint> syncPoint = RefCountPtr<SyncPoint>::Create(new SyncPoint());
+        syncPoint->queue = m_CommandListParameters.queueType;
+
+        m_SignaledSyncPoints.push_back(syncPoint);
+
+        return syncPoint;
+    }
+
+    void CommandList::waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages)
+    {
+        (void)syncPoint;
+        (void)waitStages;
+    }
+
+    void CommandList::beginMarker(const char* name)
+    {
+        (void)name;
+    }
+
+    void CommandList::endMarker()
+    {
+    }
+
+    void CommandList::setEnableAutomaticBarriers(bool enable)
+    {
+        m_EnableAutomaticBarriers = enable;
+    }
+
+    void CommandList::setEnableUavBarriersForTexture(ITexture* _texture, bool enableBarriers)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setEnableUavBarriersForTexture(texture, enableBarriers);
+    }
+
+    void CommandList::setEnableUavBarriersForBuffer(IBuffer* _buffer, bool enableBarriers)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
+    }
+
+    void CommandList::beginTrackingTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTrackingTextureState(texture, subresources, stateBits);
+    }
+
+    void CommandList::beginTrackingBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginTrackingBufferState(buffer, stateBits);
+    }
+
+    void CommandList::setTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        requireTextureState(_texture, subresources, stateBits);
+
+        m_ReferencedResources.push_back(_texture);
+    }
+
+    void CommandList::setBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        requireBufferState(_buffer, stateBits);
+
+        m_ReferencedResources.push_back(_buffer);
+    }
+
+    void CommandList::setAccelStructState(rt::IAccelStruct* _as, ResourceStates stateBits)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (as->dataBuffer)
+        {
+            requireBufferState(as->dataBuffer, stateBits);
+            m_ReferencedResources.push_back(as);
+        }
+    }
+
+    void CommandList::setPermanentTextureState(ITexture* _texture, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.setPermanentTextureState(texture, AllSubresources, stateBits);
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::setPermanentBufferState(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.setPermanentBufferState(buffer, stateBits);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, subresources, stateBits);
+
+        m_ReferencedResources.push_back(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, stateBits);
+
+        m_ReferencedResources.push_back(buffer);
+    }
+
+    void CommandList::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        m_ReferencedResources.push_back(resourceBefore);
+        m_ReferencedResources.push_back(resourceAfter);
+    }
+
+    void CommandList::commitBarriers()
+    {
+        // There is nothing to record the barriers into, they only need to leave the tracker
+        m_StateTracker.clearBarriers();
+    }
+
+    ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        return m_StateTracker.getTextureSubresourceState(texture, arraySlice, mipLevel);
+    }
+
+    ResourceStates CommandList::getBufferState(IBuffer* _buffer)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        return m_StateTracker.getBufferState(buffer);
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,1089 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+#include "../common/storage-queue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace nvrhi::null
+{
+    DeviceHandle createDevice(const DeviceDesc& desc)
+    {
+        Device* device = new Device(desc);
+        return DeviceHandle::Create(device);
+    }
+
+    Device::Device(const DeviceDesc& desc)
+        : m_PipelineCompiler(desc.pipelineCompilerThreadCount)
+    {
+        m_Context.messageCallback = desc.messageCallback;
+        m_Context.memoryStatistics = std::make_unique<MemoryStatisticsTracker>(desc.memoryAllocationCallback);
+
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            m_Queues[queueIndex] = std::make_unique<Queue>(CommandQueue(queueIndex));
+        }
+
+        m_StateHandoffResolver = std::make_unique<StateHandoffResolver>(m_Context.messageCallback);
+    }
+
+    Device::~Device()
+    {
+        // The compiler threads call into the device, stop them first
+        m_PipelineCompiler.shutdown();
+    }
+
+    Object Device::getNativeObject(ObjectType objectType)
+    {
+        if (objectType == ObjectTypes::Nvrhi_Null_Device)
+            return this;
+
+        return nullptr;
+    }
+
+    Object Device::getNativeQueue(ObjectType objectType, CommandQueue queue)
+    {
+        (void)objectType;
+        (void)queue;
+
+        return nullptr;
+    }
+
+    HeapHandle Device::createHeap(const HeapDesc& d)
+    {
+        Heap* heap = new Heap();
+        heap->desc = d;
+        return HeapHandle::Create(heap);
+    }
+
+    TextureHandle Device::createTexture(const TextureDesc& d)
+    {
+        Texture* texture = new Texture(d);
+
+        if (!d.isVirtual)
+        {
+            texture->memoryStatistics = m_Context.memoryStatistics.get();
+            texture->trackedMemorySize = getTextureSize(d);
+            texture->memoryStatistics->allocated(MemoryCategory::Textures, texture->trackedMemorySize, d.debugName.c_str());
+        }
+
+        return TextureHandle::Create(texture);
+    }
+
+    MemoryRequirements Device::getTextureMemoryRequirements(ITexture* texture)
+    {
+        MemoryRequirements memReq;
+        memReq.size = align<uint64_t>(getTextureSize(texture->getDesc()), 65536);
+        memReq.alignment = 65536;
+        return memReq;
+    }
+
+    bool Device::bindTextureMemory(ITexture* _texture, IHeap* heap, uint64_t offset)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        if (texture->heap)
+            return false;
+
+        if (!texture->desc.isVirtual)
+            return false;
+
+        texture->heap = heap;
+        texture->heapOffset = offset;
+
+        return true;
+    }
+
+    TextureHandle Device::createHandleForNativeTexture(ObjectType objectType, Object texture, const TextureDesc& desc)
+    {
+        (void)objectType;
+        (void)texture;
+        (void)desc;
+
+        // There are no native textures to wrap
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    StagingTextureHandle Device::createStagingTexture(const TextureDesc& d, CpuAccessMode cpuAccess)
+    {
+        StagingTexture* texture = new StagingTexture();
+        texture->desc = d;
+        texture->cpuAccess = cpuAccess;
+        texture->allocate();
+
+        return StagingTextureHandle::Create(texture);
+    }
+
+    void* Device::mapStagingTexture(IStagingTexture* _tex, const TextureSlice& _slice, CpuAccessMode cpuAccess, size_t* outRowPitch)
+    {
+        (void)cpuAccess;
+
+        StagingTexture* tex = checked_cast<StagingTexture*>(_tex);
+        const TextureSlice slice = _slice.resolve(tex->desc);
+        const FormatInfo& formatInfo = getFormatInfo(tex->desc.format);
+
+        const size_t rowPitch = getTextureRowPitch(tex->desc, slice.mipLevel);
+        const uint32_t height = std::max(tex->desc.height >> slice.mipLevel, 1u);
+        const size_t depthPitch = rowPitch * ((height + formatInfo.blockSize - 1) / formatInfo.blockSize);
+
+        const size_t offset = tex->getSubresourceOffset(tex->desc.dimension == TextureDimension::Texture3D ? 0 : slice.arraySlice, slice.mipLevel)
+            + slice.z * depthPitch
+            + (slice.y / formatInfo.blockSize) * rowPitch
+            + (slice.x / formatInfo.blockSize) * formatInfo.bytesPerBlock;
+
+        if (outRowPitch)
+            *outRowPitch = rowPitch;
+
+        return tex->hostMemory.data() + offset;
+    }
+
+    void Device::unmapStagingTexture(IStagingTexture* tex)
+    {
+        (void)tex;
+    }
+
+    void Device::getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings)
+    {
+        (void)texture;
+
+        // Report a texture that only consists of packed mips
+        if (numTiles)
+            *numTiles = 0;
+
+        if (desc)
+            *desc = PackedMipDesc();
+
+        if (tileShape)
+            *tileShape = TileShape();
+
+        if (subresourceTilingsNum)
+        {
+            for (uint32_t i = 0; i < *subresourceTilingsNum; ++i)
+                subresourceTilings[i] = SubresourceTiling();
+        }
+    }
+
+    void Device::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        (void)texture;
+        (void)tileMappings;
+        (void)numTileMappings;
+        (void)executionQueue;
+    }
+
+    void Device::updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        (void)buffer;
+        (void)tileMappings;
+        (void)numTileMappings;
+        (void)executionQueue;
+    }
+
+    SamplerFeedbackTextureHandle Device::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
+    {
+        (void)pairedTexture;
+        (void)desc;
+
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    SamplerFeedbackTextureHandle Device::createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture)
+    {
+        (void)objectType;
+        (void)texture;
+        (void)pairedTexture;
+
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    RefCountPtr<Buffer> Device::createBufferObject(const BufferDesc& desc)
+    {
+        RefCountPtr<Buffer> buffer = RefCountPtr<Buffer>::Create(new Buffer(desc));
+        buffer->gpuAddress = m_Context.allocateGpuAddress(desc.byteSize);
+
+        // Only the buffers that the CPU can map need their contents, nothing reads the others
+        if (desc.cpuAccess != CpuAccessMode::None)
+            buffer->hostMemory.resize(size_t(desc.byteSize));
+
+        // The versions of volatile buffers live in the upload memory of the command lists, like on DX12
+        if (!desc.isVirtual && !desc.isVolatile)
+        {
+            buffer->memoryStatistics = m_Context.memoryStatistics.get();
+            buffer->trackedMemorySize = desc.byteSize;
+            buffer->memoryStatistics->allocated(MemoryCategory::Buffers, buffer->trackedMemorySize, desc.debugName.c_str());
+        }
+
+        return buffer;
+    }
+
+    BufferHandle Device::createBuffer(const BufferDesc& d)
+    {
+        if (d.isVolatile && !d.isConstantBuffer)
+        {
+            m_Context.error("Volatile buffers must be constant buffers");
+            return nullptr;
+        }
+
+        return createBufferObject(d);
+    }
+
+    void* Device::mapBuffer(IBuffer* b, CpuAccessMode mapFlags)
+    {
+        return mapBuffer(b, mapFlags, MapBufferFlags::None);
+    }
+
+    void* Device::mapBuffer(IBuffer* _buffer, CpuAccessMode mapFlags, MapBufferFlags flags)
+    {
+        (void)mapFlags;
+        (void)flags;
+
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (buffer->hostMemory.empty())
+        {
+            std::stringstream ss;
+            ss << "Cannot map buffer " << utils::DebugNameToString(buffer->desc.debugName) << " that was created with CpuAccessMode::None";
+            m_Context.error(ss.str());
+            return nullptr;
+        }
+
+        return buffer->hostMemory.data();
+    }
+
+    void Device::unmapBuffer(IBuffer* b)
+    {
+        (void)b;
+    }
+
+    MemoryRequirements Device::getBufferMemoryRequirements(IBuffer* buffer)
+    {
+        MemoryRequirements memReq;
+        memReq.size = align<uint64_t>(buffer->getDesc().byteSize, 256);
+        memReq.alignment = 256;
+        return memReq;
+    }
+
+    bool Device::bindBufferMemory(IBuffer* _buffer, IHeap* heap, uint64_t offset)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        if (buffer->heap)
+            return false;
+
+        if (!buffer->desc.isVirtual)
+            return false;
+
+        buffer->heap = heap;
+        buffer->heapOffset = offset;
+
+        return true;
+    }
+
+    BufferHandle Device::createHandleForNativeBuffer(ObjectType objectType, Object buffer, const BufferDesc& desc)
+    {
+        (void)objectType;
+        (void)buffer;
+        (void)desc;
+
+        // There are no native buffers to wrap
+        utils::NotSupported();
+        return nullptr;
+    }
+
+    ShaderHandle Device::createShader(const ShaderDesc& d, const void* binary, size_t binarySize)
+    {
+        Shader* shader = new Shader();
+        shader->desc = d;
+        shader->bytecode.resize(binarySize);
+        if (binarySize)
+            memcpy(shader->bytecode.data(), binary, binarySize);
+
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderHandle Device::createShaderSpecialization(IShader* _baseShader, const ShaderSpecialization* constants, uint32_t numConstants)
+    {
+        Shader* baseShader = checked_cast<Shader*>(_baseShader);
+
+        // Specializations of specializations refer to the original shader
+        if (baseShader->baseShader)
+            baseShader = checked_cast<Shader*>(baseShader->baseShader.Get());
+
+        Shader* shader = new Shader();
+        shader->desc = baseShader->desc;
+        shader->bytecode = baseShader->bytecode;
+        shader->baseShader = baseShader;
+        shader->specializationConstants.assign(constants, constants + numConstants);
+
+        return ShaderHandle::Create(shader);
+    }
+
+    ShaderLibraryHandle Device::createShaderLibrary(const void* binary, size_t binarySize)
+    {
+        ShaderLibrary* library = new ShaderLibrary();
+        library->bytecode.resize(binarySize);
+        if (binarySize)
+            memcpy(library->bytecode.data(), binary, binarySize);
+
+        return ShaderLibraryHandle::Create(library);
+    }
+
+    SamplerHandle Device::createSampler(const SamplerDesc& d)
+    {
+        Sampler* sampler = new Sampler();
+        sampler->desc = d;
+        return SamplerHandle::Create(sampler);
+    }
+
+    InputLayoutHandle Device::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, IShader* vertexShader)
+    {
+        (void)vertexShader;
+
+        InputLayout* layout = new InputLayout();
+        layout->attributes.assign(d, d + attributeCount);
+        return InputLayoutHandle::Create(layout);
+    }
+
+    EventQueryHandle Device::createEventQuery()
+    {
+        EventQuery* query = new EventQuery();
+        return EventQueryHandle::Create(query);
+    }
+
+    void Device::setEventQuery(IEventQuery* _query, CommandQueue queue)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        query->queue = queue;
+        query->commandListInstance = getQueue(queue).lastSubmittedInstance.load();
+    }
+
+    bool Device::pollEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        return getQueue(query->queue).getLastCompletedInstance() >= query->commandListInstance;
+    }
+
+    void Device::waitEventQuery(IEventQuery* query)
+    {
+        // Everything that was submitted has completed
+        (void)query;
+    }
+
+    void Device::resetEventQuery(IEventQuery* _query)
+    {
+        EventQuery* query = checked_cast<EventQuery*>(_query);
+
+        query->commandListInstance = 0;
+    }
+
+    TimerQueryHandle Device::createTimerQuery()
+    {
+        TimerQuery* query = new TimerQuery();
+        return TimerQueryHandle::Create(query);
+    }
+
+    bool Device::pollTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        return query->resolved;
+    }
+
+    float Device::getTimerQueryTime(ITimerQuery* query)
+    {
+        // Nothing takes any GPU time
+        (void)query;
+        return 0.f;
+    }
+
+    void Device::resetTimerQuery(ITimerQuery* _query)
+    {
+        TimerQuery* query = checked_cast<TimerQuery*>(_query);
+
+        query->started = false;
+        query->resolved = false;
+    }
+
+    TimerQueryPoolHandle Device::createTimerQueryPool(const TimerQueryPoolDesc& desc)
+    {
+        TimerQueryPool* pool = new TimerQueryPool();
+        pool->desc = desc;
+        return TimerQueryPoolHandle::Create(pool);
+    }
+
+    static bool areTimerQueryPoolResultsAvailable(const TimerQueryPool* pool, uint64_t frameIndex)
+    {
+        // The frame must have been resolved and executed, and not reused by a newer frame
+        return frameIndex != 0
+            && frameIndex <= pool->lastExecutedFrameIndex.load()
+            && frameIndex + pool->desc.maxFramesInFlight > pool->currentFrameIndex.load();
+    }
+
+    bool Device::getTimerQueryPoolResults(ITimerQueryPool* _pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        if (!areTimerQueryPoolResultsAvailable(pool, frameIndex))
+            return false;
+
+        std::fill(pTimes, pTimes + numQueries, 0.f);
+        return true;
+    }
+
+    bool Device::getTimerQueryPoolTimestamps(ITimerQueryPool* _pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        if (!areTimerQueryPoolResultsAvailable(pool, frameIndex))
+            return false;
+
+        std::fill(pTimestamps, pTimestamps + 2 * size_t(numQueries), 0.0);
+        return true;
+    }
+
+    OcclusionQueryHandle Device::createOcclusionQuery(OcclusionQueryType type)
+    {
+        OcclusionQuery* query = new OcclusionQuery();
+        query->type = type;
+        return OcclusionQueryHandle::Create(query);
+    }
+
+    bool Device::pollOcclusionQuery(IOcclusionQuery* query)
+    {
+        (void)query;
+        return true;
+    }
+
+    uint64_t Device::getOcclusionQueryResult(IOcclusionQuery* query)
+    {
+        (void)query;
+        return 0;
+    }
+
+    void Device::resetOcclusionQuery(IOcclusionQuery* query)
+    {
+        (void)query;
+    }
+
+    PipelineStatisticsQueryHandle Device::createPipelineStatisticsQuery()
+    {
+        PipelineStatisticsQuery* query = new PipelineStatisticsQuery();
+        return PipelineStatisticsQueryHandle::Create(query);
+    }
+
+    bool Device::pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        (void)query;
+        return true;
+    }
+
+    PipelineStatistics Device::getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query)
+    {
+        (void)query;
+        return PipelineStatistics();
+    }
+
+    void Device::resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        (void)query;
+    }
+
+    FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
+    {
+        Framebuffer* fb = new Framebuffer();
+        fb->desc = desc;
+        fb->framebufferInfo = FramebufferInfoEx(desc);
+
+        for (const auto& attachment : desc.colorAttachments)
+        {
+            if (attachment.valid())
+                fb->resources.push_back(attachment.texture);
+        }
+
+        if (desc.depthAttachment.valid())
+            fb->resources.push_back(desc.depthAttachment.texture);
+
+        if (desc.shadingRateAttachment.valid())
+            fb->resources.push_back(desc.shadingRateAttachment.texture);
+
+        return FramebufferHandle::Create(fb);
+    }
+
+    GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        GraphicsPipeline* pso = new GraphicsPipeline();
+        pso->desc = desc;
+        pso->framebufferInfo = fbinfo;
+        return GraphicsPipelineHandle::Create(pso);
+    }
+
+    GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return createGraphicsPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
+    {
+        ComputePipeline* pso = new ComputePipeline();
+        pso->desc = desc;
+        return ComputePipelineHandle::Create(pso);
+    }
+
+    MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
+    {
+        MeshletPipeline* pso = new MeshletPipeline();
+        pso->desc = desc;
+        pso->framebufferInfo = fbinfo;
+        return MeshletPipelineHandle::Create(pso);
+    }
+
+    MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb)
+    {
+        return createMeshletPipeline(desc, fb->getFramebufferInfo());
+    }
+
+    rt::PipelineHandle Device::createRayTracingPipeline(const rt::PipelineDesc& desc)
+    {
+        RayTracingPipeline* pso = new RayTracingPipeline(m_Context);
+        pso->desc = desc;
+
+        auto addExport = [pso](const std::string& exportName, IBindingLayout* bindingLayout)
+        {
+            // A later export with the same name replaces the earlier one
+            auto [exportIt, inserted] = pso->exports.try_emplace(exportName, rt::ShaderExportId(pso->exportBindingLayouts.size()));
+            if (inserted)
+                pso->exportBindingLayouts.push_back(bindingLayout);
+            else
+                pso->exportBindingLayouts[uint32_t(exportIt->second)] = bindingLayout;
+        };
+
+        for (const auto& shaderDesc : desc.shaders)
+        {
+            std::string exportName = shaderDesc.exportName.empty() ? shaderDesc.shader->getDesc().entryName : shaderDesc.exportName;
+            addExport(exportName, shaderDesc.bindingLayout);
+        }
+
+        for (const auto& hitGroupDesc : desc.hitGroups)
+        {
+            addExport(hitGroupDesc.exportName, hitGroupDesc.bindingLayout);
+        }
+
+        return rt::PipelineHandle::Create(pso);
+    }
+
+    AsyncGraphicsPipelineHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback)
+    {
+        return m_PipelineCompiler.createGraphicsPipeline(this, desc, fbinfo, fallback);
+    }
+
+    AsyncComputePipelineHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback)
+    {
+        return m_PipelineCompiler.createComputePipeline(this, desc, fallback);
+    }
+
+    AsyncMeshletPipelineHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback)
+    {
+        return m_PipelineCompiler.createMeshletPipeline(this, desc, fbinfo, fallback);
+    }
+
+    rt::AsyncPipelineHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback)
+    {
+        return m_PipelineCompiler.createRayTracingPipeline(this, desc, fallback);
+    }
+
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        CommandSignature* signature = new CommandSignature();
+        signature->desc = desc;
+        return CommandSignatureHandle::Create(signature);
+    }
+
+    BindingLayoutHandle Device::createBindingLayout(const BindingLayoutDesc& desc)
+    {
+        BindingLayout* layout = new BindingLayout();
+        layout->desc = desc;
+        return BindingLayoutHandle::Create(layout);
+    }
+
+    BindingLayoutHandle Device::createBindlessLayout(const BindlessLayoutDesc& desc)
+    {
+        BindingLayout* layout = new BindingLayout();
+        layout->bindlessDesc = desc;
+        layout->isBindless = true;
+        return BindingLayoutHandle::Create(layout);
+    }
+
+    BindingSetHandle Device::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSet* bindingSet = new BindingSet();
+        bindingSet->desc = desc;
+        bindingSet->layout = layout;
+
+        for (size_t bindingIndex = 0; bindingIndex < desc.bindings.size(); bindingIndex++)
+        {
+            const BindingSetItem& binding = desc.bindings[bindingIndex];
+
+            if (binding.resourceHandle)
+                bindingSet->resources.push_back(binding.resourceHandle);
+
+            switch (binding.type)  // NOLINT(clang-diagnostic-switch-enum)
+            {
+            case ResourceType::Texture_SRV:
+            case ResourceType::Texture_UAV: {
+                const bool isUav = binding.type == ResourceType::Texture_UAV;
+                const auto texture = checked_cast<Texture*>(binding.resourceHandle);
+
+                if (!texture->permanentState)
+                    bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(texture->permanentState,
+                        isUav ? ResourceStates::UnorderedAccess : ResourceStates::ShaderResource,
+                        true, texture->desc.debugName, m_Context.messageCallback);
+
+                if (isUav)
+                    bindingSet->hasUavBindings = true;
+                break;
+            }
+
+            case ResourceType::TypedBuffer_SRV:
+            case ResourceType::StructuredBuffer_SRV:
+            case ResourceType::RawBuffer_SRV:
+            case ResourceType::TypedBuffer_UAV:
+            case ResourceType::StructuredBuffer_UAV:
+            case ResourceType::RawBuffer_UAV:
+            case ResourceType::ConstantBuffer: {
+                const auto buffer = checked_cast<Buffer*>(binding.resourceHandle);
+
+                ResourceStates requiredState;
+                if (binding.type == ResourceType::TypedBuffer_UAV || binding.type == ResourceType::StructuredBuffer_UAV || binding.type == ResourceType::RawBuffer_UAV)
+                {
+                    requiredState = ResourceStates::UnorderedAccess;
+                    bindingSet->hasUavBindings = true;
+                }
+                else if (binding.type == ResourceType::ConstantBuffer)
+                    requiredState = ResourceStates::ConstantBuffer;
+                else
+                    requiredState = ResourceStates::ShaderResource;
+
+                if (!buffer->permanentState)
+                    bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                else
+                    verifyPermanentResourceState(buffer->permanentState, requiredState,
+                        false, buffer->desc.debugName, m_Context.messageCallback);
+                break;
+            }
+
+            case ResourceType::RayTracingAccelStruct:
+                bindingSet->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                break;
+
+            default:
+                // Samplers, volatile constant buffers and push constants don't need transitions
+                break;
+            }
+        }
+
+        return BindingSetHandle::Create(bindingSet);
+    }
+
+    DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* layout)
+    {
+        DescriptorTable* descriptorTable = new DescriptorTable();
+        descriptorTable->layout = layout;
+        return DescriptorTableHandle::Create(descriptorTable);
+    }
+
+    void Device::resizeDescriptorTable(IDescriptorTable* _descriptorTable, uint32_t newSize, bool keepContents)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (!keepContents)
+        {
+            descriptorTable->descriptors.clear();
+            descriptorTable->resources.clear();
+        }
+
+        descriptorTable->descriptors.resize(newSize);
+        descriptorTable->resources.resize(newSize);
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& item)
+    {
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+
+        if (item.slot >= descriptorTable->descriptors.size())
+            return false;
+
+        descriptorTable->descriptors[item.slot] = item;
+        descriptorTable->resources[item.slot] = item.resourceHandle;
+
+        return true;
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems)
+    {
+        bool success = true;
+
+        for (size_t i = 0; i < numItems; i++)
+            success = writeDescriptorTable(descriptorTable, items[i]) && success;
+
+        return success;
+    }
+
+    rt::OpacityMicromapHandle Device::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
+    {
+        uint64_t dataSize = 0;
+        for (const auto& usage : desc.counts)
+        {
+            // Up to 2 bits per micro-triangle, plus a descriptor per micromap
+            dataSize += uint64_t(usage.count) * ((uint64_t(1) << (2 * usage.subdivisionLevel)) / 4 + 8);
+        }
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = std::max<uint64_t>(dataSize, 256);
+        bufferDesc.debugName = desc.debugName;
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.isAccelStructStorage = true;
+        bufferDesc.initialState = ResourceStates::AccelStructBuildBlas;
+        bufferDesc.keepInitialState = true;
+
+        OpacityMicromap* omm = new OpacityMicromap();
+        omm->desc = desc;
+        omm->dataBuffer = createBufferObject(bufferDesc);
+        return rt::OpacityMicromapHandle::Create(omm);
+    }
+
+    static uint64_t estimateAccelStructSize(const rt::AccelStructDesc& desc)
+    {
+        // Roughly what the drivers need: some bytes per instance or primitive, and a minimum allocation
+        constexpr uint64_t c_BytesPerPrimitive = 64;
+        constexpr uint64_t c_MinSize = 64 * 1024;
+
+        if (desc.isTopLevel)
+            return std::max(uint64_t(desc.topLevelMaxInstances) * 2 * c_BytesPerPrimitive, c_MinSize);
+
+        uint64_t size = 0;
+        for (const auto& geometry : desc.bottomLevelGeometries)
+        {
+            switch (geometry.geometryType)
+            {
+            case rt::GeometryType::Triangles: {
+                const auto& triangles = geometry.geometryData.triangles;
+                const uint32_t numTriangles = (triangles.indexFormat != Format::UNKNOWN ? triangles.indexCount : triangles.vertexCount) / 3;
+                size += uint64_t(numTriangles) * c_BytesPerPrimitive;
+                break;
+            }
+            case rt::GeometryType::AABBs:
+                size += uint64_t(geometry.geometryData.aabbs.count) * c_BytesPerPrimitive;
+                break;
+            default:
+                size += c_MinSize;
+                break;
+            }
+        }
+
+        return std::max(size, c_MinSize);
+    }
+
+    rt::AccelStructHandle Device::createAccelStruct(const rt::AccelStructDesc& desc)
+    {
+        AccelStruct* as = new AccelStruct();
+        as->desc = desc;
+        as->allowUpdate = (desc.buildFlags & rt::AccelStructBuildFlags::AllowUpdate) != 0;
+
+        if (!desc.isVirtual)
+        {
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = estimateAccelStructSize(desc);
+            bufferDesc.debugName = desc.debugName;
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.isAccelStructStorage = true;
+            bufferDesc.initialState = desc.isTopLevel ? ResourceStates::AccelStructRead : ResourceStates::AccelStructBuildBlas;
+            bufferDesc.keepInitialState = true;
+
+            as->dataBuffer = createBufferObject(bufferDesc);
+        }
+
+        if (desc.isTopLevel && desc.createInstanceBuffer)
+        {
+            BufferDesc bufferDesc;
+            bufferDesc.byteSize = std::max<uint64_t>(desc.topLevelMaxInstances, 1) * sizeof(rt::InstanceDesc);
+            bufferDesc.debugName = desc.debugName + " instances";
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.isAccelStructBuildInput = true;
+            bufferDesc.initialState = ResourceStates::AccelStructBuildInput;
+            bufferDesc.keepInitialState = true;
+
+            as->instanceBuffer = createBufferObject(bufferDesc);
+        }
+
+        return rt::AccelStructHandle::Create(as);
+    }
+
+    MemoryRequirements Device::getAccelStructMemoryRequirements(rt::IAccelStruct* as)
+    {
+        MemoryRequirements memReq;
+        memReq.size = align<uint64_t>(estimateAccelStructSize(as->getDesc()), 65536);
+        memReq.alignment = 65536;
+        return memReq;
+    }
+
+    rt::cluster::OperationSizeInfo Device::getClusterOperationSizeInfo(const rt::cluster::OperationParams& params)
+    {
+        (void)params;
+
+        utils::NotSupported();
+        return rt::cluster::OperationSizeInfo();
+    }
+
+    bool Device::bindAccelStructMemory(rt::IAccelStruct* _as, IHeap* heap, uint64_t offset)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (as->dataBuffer)
+            return false;
+
+        BufferDesc bufferDesc;
+        bufferDesc.byteSize = estimateAccelStructSize(as->desc);
+        bufferDesc.debugName = as->desc.debugName;
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.isAccelStructStorage = true;
+        bufferDesc.initialState = as->desc.isTopLevel ? ResourceStates::AccelStructRead : ResourceStates::AccelStructBuildBlas;
+        bufferDesc.keepInitialState = true;
+
+        as->dataBuffer = createBufferObject(bufferDesc);
+        as->dataBuffer->heap = heap;
+        as->dataBuffer->heapOffset = offset;
+
+        return true;
+    }
+
+    CommandListHandle Device::createCommandList(const CommandListParameters& params)
+    {
+        CommandList* commandList = new CommandList(this, m_Context, params);
+        return CommandListHandle::Create(commandList);
+    }
+
+    uint64_t Device::executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        Queue& queue = getQueue(executionQueue);
+
+        std::lock_guard lockGuard(m_ExecutionMutex);
+
+        // There is nothing to record the cross-list transitions into, but resolving them keeps the states
+        // that the next command lists start from the same as on the other backends.
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+            m_StateHandoffResolver->resolveCommandList(commandList->getStateTracker());
+        }
+
+        m_StateHandoffResolver->restoreInitialStates();
+        m_StateHandoffResolver->clearBarriers();
+
+        const uint64_t submissionID = queue.lastSubmittedInstance.load() + 1;
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            checked_cast<CommandList*>(pCommandLists[i])->executed(queue, submissionID);
+        }
+
+        // The work is complete as soon as it's submitted
+        queue.lastSubmittedInstance.store(submissionID);
+
+        return submissionID;
+    }
+
+    void Device::queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance)
+    {
+        (void)waitQueue;
+        (void)executionQueue;
+        (void)instance;
+    }
+
+    StorageQueueHandle Device::createStorageQueue(const StorageQueueDesc& desc)
+    {
+        return StorageQueueHandle::Create(new StorageQueue(this, desc));
+    }
+
+    bool Device::waitForIdle()
+    {
+        return true;
+    }
+
+    void Device::runGarbageCollection()
+    {
+    }
+
+    bool Device::getVideoMemoryBudget(VideoMemoryBudget& outBudget)
+    {
+        (void)outBudget;
+        return false;
+    }
+
+    MemoryStatistics Device::getMemoryStatistics()
+    {
+        return m_Context.memoryStatistics->getStatistics();
+    }
+
+    void Device::setResidencyPriority(IResource* resource, ResidencyPriority priority)
+    {
+        (void)resource;
+        (void)priority;
+    }
+
+    bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
+    {
+        switch (feature)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case Feature::ComputeQueue:
+        case Feature::CopyQueue:
+        case Feature::ConstantBufferRanges:
+        case Feature::DeferredCommandLists:
+        case Feature::RayQuery:
+        case Feature::RayTracingAccelStruct:
+        case Feature::RayTracingOpacityMicromap:
+        case Feature::RayTracingPipeline:
+        case Feature::ShaderSpecializations:
+        case Feature::VirtualResources:
+        case Feature::Bundles:
+        case Feature::PipelineStatisticsQueries:
+        case Feature::Predication:
+            return true;
+        case Feature::Meshlets:
+            if (pInfo)
+            {
+                if (infoSize == sizeof(MeshletFeatureInfo))
+                {
+                    // The D3D12 limits, which are also the minimums guaranteed by VK_EXT_mesh_shader
+                    auto* pMeshletInfo = reinterpret_cast<MeshletFeatureInfo*>(pInfo);
+                    for (int i = 0; i < 3; i++)
+                    {
+                        pMeshletInfo->maxTaskWorkGroupCount[i] = 65535;
+                        pMeshletInfo->maxMeshWorkGroupCount[i] = 65535;
+                    }
+                    pMeshletInfo->maxTaskWorkGroupTotalCount = 1 << 22;
+                    pMeshletInfo->maxMeshWorkGroupTotalCount = 1 << 22;
+                    pMeshletInfo->maxTaskPayloadSize = 16384;
+                    pMeshletInfo->maxMeshOutputVertices = 256;
+                    pMeshletInfo->maxMeshOutputPrimitives = 256;
+                    pMeshletInfo->perPrimitiveShadingRate = false;
+                }
+                else
+                    utils::NotSupported();
+            }
+            return true;
+        case Feature::WaveLaneCountMinMax:
+            if (pInfo)
+            {
+                if (infoSize == sizeof(WaveLaneCountMinMaxFeatureInfo))
+                {
+                    auto* pWaveLaneCountMinMaxInfo = reinterpret_cast<WaveLaneCountMinMaxFeatureInfo*>(pInfo);
+                    pWaveLaneCountMinMaxInfo->minWaveLaneCount = 32;
+                    pWaveLaneCountMinMaxInfo->maxWaveLaneCount = 32;
+                }
+                else
+                    utils::NotSupported();
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    FormatSupport Device::queryFormatSupport(Format format)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(format);
+
+        if (format == Format::UNKNOWN)
+            return FormatSupport::None;
+
+        FormatSupport result = FormatSupport::Texture | FormatSupport::ShaderLoad | FormatSupport::ShaderSample;
+
+        if (formatInfo.hasDepth || formatInfo.hasStencil)
+            return result | FormatSupport::DepthStencil;
+
+        // Block-compressed formats can only be sampled
+        if (formatInfo.blockSize != 1)
+            return result;
+
+        result = result | FormatSupport::Buffer | FormatSupport::VertexBuffer
+            | FormatSupport::RenderTarget | FormatSupport::ShaderUavLoad | FormatSupport::ShaderUavStore;
+
+        if (formatInfo.kind != FormatKind::Integer)
+            result = result | FormatSupport::Blendable;
+
+        if (format == Format::R16_UINT || format == Format::R32_UINT)
+            result = result | FormatSupport::IndexBuffer;
+
+        if (format == Format::R32_UINT || format == Format::R32_SINT)
+            result = result | FormatSupport::ShaderAtomic;
+
+        return result;
+    }
+
+    coopvec::DeviceFeatures Device::queryCoopVecFeatures()
+    {
+        return coopvec::DeviceFeatures();
+    }
+
+    size_t Device::getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns)
+    {
+        (void)type;
+        (void)layout;
+        (void)rows;
+        (void)columns;
+
+        utils::NotSupported();
+        return 0;
+    }
+
+    void Device::getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes)
+    {
+        (void)descs;
+
+        utils::NotSupported();
+        std::fill(outSizes, outSizes + numDescs, size_t(0));
+    }
+
+    bool Device::getPipelineCacheData(std::vector<uint8_t>& outData)
+    {
+        outData.clear();
+        return false;
+    }
+
+    bool Device::mergePipelineCacheData(const void* data, size_t size)
+    {
+        (void)data;
+        (void)size;
+        return false;
+    }
+
+} // namespace nvrhi::null
@@ -0,0 +1,373 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "null-backend.h"
+
+#include <sstream>
+
+namespace nvrhi::null
+{
+    void Context::error(const std::string& message) const
+    {
+        if (messageCallback)
+            messageCallback->message(MessageSeverity::Error, message.c_str());
+    }
+
+    void Context::warning(const std::string& message) const
+    {
+        if (messageCallback)
+            messageCallback->message(MessageSeverity::Warning, message.c_str());
+    }
+
+    uint64_t Context::allocateGpuAddress(uint64_t size) const
+    {
+        // Keep the fake addresses aligned and non-overlapping, so that address arithmetic in the application works
+        return nextGpuAddress.fetch_add(align<uint64_t>(std::max<uint64_t>(size, 1), 65536));
+    }
+
+    size_t getTextureRowPitch(const TextureDesc& desc, MipLevel mipLevel)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t width = std::max(desc.width >> mipLevel, 1u);
+        const uint32_t blocks = (width + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        return size_t(blocks) * formatInfo.bytesPerBlock;
+    }
+
+    size_t getTextureSubresourceSize(const TextureDesc& desc, MipLevel mipLevel)
+    {
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const uint32_t height = std::max(desc.height >> mipLevel, 1u);
+        const uint32_t rows = (height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        const uint32_t depth = desc.dimension == TextureDimension::Texture3D ? std::max(desc.depth >> mipLevel, 1u) : 1u;
+
+        return getTextureRowPitch(desc, mipLevel) * rows * depth;
+    }
+
+    uint64_t getTextureSize(const TextureDesc& desc)
+    {
+        uint64_t size = 0;
+        for (MipLevel mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+            size += getTextureSubresourceSize(desc, mipLevel);
+
+        const uint32_t arraySize = desc.dimension == TextureDimension::Texture3D ? 1u : desc.arraySize;
+        return size * arraySize * std::max(desc.sampleCount, 1u);
+    }
+
+    Buffer::~Buffer()
+    {
+        if (trackedMemorySize)
+            memoryStatistics->released(MemoryCategory::Buffers, trackedMemorySize);
+    }
+
+    Texture::~Texture()
+    {
+        if (trackedMemorySize)
+            memoryStatistics->released(MemoryCategory::Textures, trackedMemorySize);
+    }
+
+    Object Texture::getNativeView(ObjectType objectType, Format format, TextureSubresourceSet subresources, TextureDimension dimension, bool isReadOnlyDSV)
+    {
+        (void)objectType;
+        (void)format;
+        (void)subresources;
+        (void)dimension;
+        (void)isReadOnlyDSV;
+
+        return nullptr;
+    }
+
+    void StagingTexture::allocate()
+    {
+        const uint32_t arraySize = desc.dimension == TextureDimension::Texture3D ? 1u : desc.arraySize;
+
+        size_t size = 0;
+        subresourceOffsets.resize(size_t(arraySize) * desc.mipLevels);
+
+        for (ArraySlice arraySlice = 0; arraySlice < arraySize; arraySlice++)
+        {
+            for (MipLevel mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+            {
+                subresourceOffsets[arraySlice * desc.mipLevels + mipLevel] = size;
+                size += getTextureSubresourceSize(desc, mipLevel);
+            }
+        }
+
+        hostMemory.resize(size);
+    }
+
+    size_t StagingTexture::getSubresourceOffset(ArraySlice arraySlice, MipLevel mipLevel) const
+    {
+        return subresourceOffsets[arraySlice * desc.mipLevels + mipLevel];
+    }
+
+    void Shader::getBytecode(const void** ppBytecode, size_t* pSize) const
+    {
+        if (ppBytecode) *ppBytecode = bytecode.data();
+        if (pSize) *pSize = bytecode.size();
+    }
+
+    void ShaderLibrary::getBytecode(const void** ppBytecode, size_t* pSize) const
+    {
+        if (ppBytecode) *ppBytecode = bytecode.data();
+        if (pSize) *pSize = bytecode.size();
+    }
+
+    ShaderHandle ShaderLibrary::getShader(const char* entryName, ShaderType shaderType)
+    {
+        Shader* shader = new Shader();
+        shader->desc.shaderType = shaderType;
+        shader->desc.entryName = entryName;
+        shader->bytecode = bytecode;
+
+        return ShaderHandle::Create(shader);
+    }
+
+    const VertexAttributeDesc* InputLayout::getAttributeDesc(uint32_t index) const
+    {
+        if (index < uint32_t(attributes.size()))
+            return &attributes[index];
+
+        return nullptr;
+    }
+
+    rt::ShaderTableHandle RayTracingPipeline::createShaderTable(rt::ShaderTableDesc const& stDesc)
+    {
+        return rt::ShaderTableHandle::Create(new ShaderTable(m_Context, this, stDesc));
+    }
+
+    rt::ShaderExportId RayTracingPipeline::getShaderExportId(const char* exportName) const
+    {
+        if (!exportName)
+            return rt::ShaderExportId::Invalid;
+
+        const auto exportIt = exports.find(exportName);
+        if (exportIt == exports.end())
+            return rt::ShaderExportId::Invalid;
+
+        return exportIt->second;
+    }
+
+    uint32_t ShaderTable::getNumEntries() const
+    {
+        return 1 + // rayGeneration
+            uint32_t(missShaders.size()) +
+            uint32_t(hitGroups.size()) +
+            uint32_t(callableShaders.size());
+    }
+
+    bool ShaderTable::resolveExportName(const char* exportName, rt::ShaderExportId& outExportId) const
+    {
+        outExportId = pipeline->getShaderExportId(exportName);
+
+        if (outExportId == rt::ShaderExportId::Invalid)
+        {
+            m_Context.error(std::string("Couldn't find a ray tracing pipeline export with name ") + (exportName ? exportName : "<null>"));
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ShaderTable::verifyExport(rt::ShaderExportId exportId, IBindingSet* bindings) const
+    {
+        if (uint32_t(exportId) >= pipeline->exportBindingLayouts.size())
+        {
+            m_Context.error("Invalid ray tracing pipeline export ID");
+            return false;
+        }
+
+        IBindingLayout* bindingLayout = pipeline->exportBindingLayouts[uint32_t(exportId)];
+
+        if (bindingLayout && !bindings)
+        {
+            m_Context.error("A shader table entry does not provide required local bindings");
+            return false;
+        }
+
+        if (!bindingLayout && bindings)
+        {
+            m_Context.error("A shader table entry provides local bindings, but none are required");
+            return false;
+        }
+
+        if (bindings && bindings->getLayout() != bindingLayout)
+        {
+            m_Context.error("A shader table entry provides local bindings that do not match the expected layout");
+            return false;
+        }
+
+        return true;
+    }
+
+    void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (resolveExportName(exportName, exportId))
+            setRayGenerationShader(exportId, bindings);
+    }
+
+    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addMissShader(exportId, bindings);
+    }
+
+    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addHitGroups(&exportId, bindings ? &bindings : nullptr, 1);
+    }
+
+    int ShaderTable::addHitGroups(const char* const* exportNames, IBindingSet* const* bindings, size_t count)
+    {
+        std::vector<rt::ShaderExportId> exportIds(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!resolveExportName(exportNames[i], exportIds[i]))
+                return -1;
+        }
+
+        return addHitGroups(exportIds.data(), bindings, count);
+    }
+
+    void ShaderTable::setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (resolveExportName(exportName, exportId))
+            setHitGroup(index, exportId, bindings);
+    }
+
+    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addCallableShader(exportId, bindings);
+    }
+
+    void ShaderTable::setRayGenerationShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (verifyExport(exportId, bindings))
+        {
+            rayGenerationShader.exportId = exportId;
+            rayGenerationShader.localBindings = bindings;
+            ++version;
+        }
+    }
+
+    int ShaderTable::addMissShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!verifyExport(exportId, bindings))
+            return -1;
+
+        missShaders.push_back(Entry{ exportId, bindings });
+        ++version;
+
+        return int(missShaders.size()) - 1;
+    }
+
+    int ShaderTable::addHitGroup(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        return addHitGroups(&exportId, bindings ? &bindings : nullptr, 1);
+    }
+
+    int ShaderTable::addHitGroups(const rt::ShaderExportId* exportIds, IBindingSet* const* bindings, size_t count)
+    {
+        if (count == 0)
+            return int(hitGroups.size());
+
+        // Verify all the exports first to add either all or none of them.
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!verifyExport(exportIds[i], bindings ? bindings[i] : nullptr))
+                return -1;
+        }
+
+        int const firstIndex = int(hitGroups.size());
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            hitGroups.push_back(Entry{ exportIds[i], bindings ? bindings[i] : nullptr });
+        }
+
+        ++version;
+
+        return firstIndex;
+    }
+
+    void ShaderTable::setHitGroup(uint32_t index, rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (index >= hitGroups.size())
+        {
+            std::stringstream ss;
+            ss << "Cannot replace hit group " << index << " in a shader table that has " << hitGroups.size() << " hit groups";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        if (verifyExport(exportId, bindings))
+        {
+            hitGroups[index] = Entry{ exportId, bindings };
+            ++version;
+        }
+    }
+
+    int ShaderTable::addCallableShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (!verifyExport(exportId, bindings))
+            return -1;
+
+        callableShaders.push_back(Entry{ exportId, bindings });
+        ++version;
+
+        return int(callableShaders.size()) - 1;
+    }
+
+    void ShaderTable::clearMissShaders()
+    {
+        missShaders.clear();
+        ++version;
+    }
+
+    void ShaderTable::clearHitShaders()
+    {
+        hitGroups.clear();
+        ++version;
+    }
+
+    void ShaderTable::clearCallableShaders()
+    {
+        callableShaders.clear();
+        ++version;
+    }
+
+} // namespace nvrhi::null
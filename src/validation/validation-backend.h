@@ -140,6 +140,7 @@ namespace nvrhi::validation
         const rt::AccelStructDesc& getDesc() const override { return m_AccelStruct->getDesc(); }
         bool isCompacted() const override { return m_AccelStruct->isCompacted(); }
         uint64_t getDeviceAddress() const override { return m_AccelStruct->getDeviceAddress(); };
+        IBuffer* getInstanceBuffer() const override { return m_AccelStruct->getInstanceBuffer(); }
         
     private:
         rt::AccelStructHandle m_AccelStruct;
@@ -150,16 +151,21 @@ namespace nvrhi::validation
     public:
         friend class DeviceWrapper;
 
-        CommandListWrapper(DeviceWrapper* device, ICommandList* commandList, bool isImmediate, CommandQueue queueType);
+        CommandListWrapper(DeviceWrapper* device, ICommandList* commandList, bool isImmediate, bool isBundle, CommandQueue queueType);
 
     protected:
         CommandListHandle m_CommandList;
         RefCountPtr<DeviceWrapper> m_Device;
         IMessageCallback* m_MessageCallback;
         bool m_IsImmediate;
+        bool m_IsBundle;
         CommandQueue m_type;
+        FramebufferHandle m_BundleFramebuffer; // the framebuffer used by all graphics states in this bundle
 
         CommandListState m_State = CommandListState::INITIAL;
+        ValidationLevel m_Level;
+        uint32_t m_SamplingInterval;
+        uint32_t m_SampleCounter = 0;
         bool m_GraphicsStateSet = false;
         bool m_ComputeStateSet = false;
         bool m_MeshletStateSet = false;
@@ -171,19 +177,43 @@ namespace nvrhi::validation
 
         size_t m_PipelinePushConstantSize = 0;
         bool m_PushConstantsSet = false;
+        IOcclusionQuery* m_ActiveOcclusionQuery = nullptr;
+        IPipelineStatisticsQuery* m_ActivePipelineStatisticsQuery = nullptr;
+        bool m_PredicationEnabled = false;
+
+        // Subresources between beginTextureWrite and endTextureWrite
+        struct PendingTextureWrite
+        {
+            ITexture* texture = nullptr;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+        };
+        std::vector<PendingTextureWrite> m_PendingTextureWrites;
 
         void error(const std::string& messageText) const;
         void warning(const std::string& messageText) const;
 
-        bool requireOpenState() const;
+        bool requireOpenState(bool allowedInBundles = false) const;
         bool requireExecuteState();
         bool requireType(CommandQueue queueType, const char* operation) const;
+        bool sampleExpensiveChecks();
+        bool validateBlitTexture(ITexture* texture, bool isDest, const char* operation) const;
+        bool validateNotTransientAttachment(ITexture* texture, const char* operation) const;
+        void invalidateState();
         ICommandList* getUnderlyingCommandList() const { return m_CommandList; }
 
         void evaluatePushConstantSize(const nvrhi::BindingLayoutVector& bindingLayouts);
         bool validatePushConstants(const char* pipelineType, const char* stateFunctionName) const;
+        bool validateTimerQueryPoolIndex(ITimerQueryPool* pool, uint32_t queryIndex, const char* function) const;
+        bool validateSyncPointSplit(const char* function);
         bool validateBindingSetsAgainstLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& layouts, const static_vector<IBindingSet*, c_MaxBindingLayouts>& sets) const;
+        bool validateVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers, std::stringstream& ss) const;
+        bool validateGraphicsState(const GraphicsState& state) const;
+        bool validateComputeState(const ComputeState& state) const;
+        bool validateMeshletState(const MeshletState& state) const;
+        bool requireGraphicsStateForUpdate(const char* operation) const;
 
+        bool validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const;
         bool validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const;
 
     public:
@@ -206,7 +236,12 @@ namespace nvrhi::validation
         void copyTexture(IStagingTexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources) override;
+        void* beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch) override;
+        void endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter) override;
+        void blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -215,14 +250,22 @@ namespace nvrhi::validation
         void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
         void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, nvrhi::Format format) override;
         void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) override;
+        void setIndexBuffer(const IndexBufferBinding& indexBuffer) override;
+        void setViewportState(const ViewportState& viewport) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void executeBundles(ICommandList* const* bundles, size_t numBundles) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -230,22 +273,40 @@ namespace nvrhi::validation
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
 
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void beginTimerQueryFrame(ITimerQueryPool* pool) override;
+        void beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimerQueries(ITimerQueryPool* pool) override;
+        void beginOcclusionQuery(IOcclusionQuery* query) override;
+        void endOcclusionQuery(IOcclusionQuery* query) override;
+        void beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void endPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void setPredication(IOcclusionQuery* query, PredicationOp op) override;
+        SyncPointHandle signalSyncPoint() override;
+        void waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages) override;
 
         void beginMarker(const char* name) override;
         void endMarker() override;
@@ -266,6 +327,10 @@ namespace nvrhi::validation
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
 
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
         void commitBarriers() override;
         
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
@@ -273,6 +338,7 @@ namespace nvrhi::validation
 
         IDevice* getDevice() override;
         const CommandListParameters& getDesc() override;
+        MemoryStatistics getMemoryStatistics() override;
     };
 
     class DeviceWrapper : public RefCounter<IDevice>
@@ -280,20 +346,25 @@ namespace nvrhi::validation
     public:
         friend class CommandListWrapper;
 
-        DeviceWrapper(IDevice* device);
+        DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc);
         
     protected:
         DeviceHandle m_Device;
         IMessageCallback* m_MessageCallback;
+        ValidationLayerDesc m_Desc;
         std::atomic<unsigned int> m_NumOpenImmediateCommandLists = 0;
 
         void error(const std::string& messageText) const;
         void warning(const std::string& messageText) const;
 
         bool validateBindingSetItem(const BindingSetItem& binding, IDescriptorTable *pOptDescriptorTable, std::stringstream& errorStream);
+        bool validateBindingSetDesc(const BindingSetDesc& desc, IBindingLayout* layout, BindingSetDesc& outPatchedDesc);
         bool validatePipelineBindingLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& bindingLayouts, const std::vector<IShader*>& shaders) const;
         bool validateShaderType(ShaderType expected, const ShaderDesc& shaderDesc, const char* function) const;
         bool validateRenderState(const RenderState& renderState, FramebufferInfo const& fbinfo) const;
+        bool validateGraphicsPipelineDesc(const GraphicsPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo, const char* function) const;
+        bool validateComputePipelineDesc(const ComputePipelineDesc& pipelineDesc, const char* function) const;
+        bool validateMeshletPipelineDesc(const MeshletPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo, const char* function) const;
 
         bool validateClusterOperationParams(const rt::cluster::OperationParams& params) const;
     public:
@@ -318,12 +389,14 @@ namespace nvrhi::validation
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
         BufferHandle createBuffer(const BufferDesc& d) override;
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags) override;
         void unmapBuffer(IBuffer* b) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
@@ -350,6 +423,17 @@ namespace nvrhi::validation
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimerQueryPoolHandle createTimerQueryPool(const TimerQueryPoolDesc& desc) override;
+        bool getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries) override;
+        bool getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries) override;
+        OcclusionQueryHandle createOcclusionQuery(OcclusionQueryType type) override;
+        bool pollOcclusionQuery(IOcclusionQuery* query) override;
+        uint64_t getOcclusionQueryResult(IOcclusionQuery* query) override;
+        void resetOcclusionQuery(IOcclusionQuery* query) override;
+        PipelineStatisticsQueryHandle createPipelineStatisticsQuery() override;
+        bool pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        PipelineStatistics getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query) override;
+        void resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -366,6 +450,11 @@ namespace nvrhi::validation
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        AsyncGraphicsPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback = nullptr) override;
+        AsyncComputePipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback = nullptr) override;
+        AsyncMeshletPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback = nullptr) override;
+        rt::AsyncPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback = nullptr) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -375,6 +464,7 @@ namespace nvrhi::validation
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems) override;
 
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc)  override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
@@ -385,13 +475,20 @@ namespace nvrhi::validation
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        StorageQueueHandle createStorageQueue(const StorageQueueDesc& desc) override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        bool getVideoMemoryBudget(VideoMemoryBudget& outBudget) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void setResidencyPriority(IResource* resource, ResidencyPriority priority) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        void getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& outData) override;
+        bool mergePipelineCacheData(const void* data, size_t size) override;
         IMessageCallback* getMessageCallback() override;
         bool isAftermathEnabled() override;
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override;
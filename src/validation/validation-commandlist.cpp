@@ -25,18 +25,23 @@
 #include <nvrhi/common/misc.h>
 #include <nvrhi/utils.h>
 
+#include <algorithm>
 #include <sstream>
+#include <unordered_set>
 
 
 namespace nvrhi::validation
 {
 
-    CommandListWrapper::CommandListWrapper(DeviceWrapper* device, ICommandList* commandList, bool isImmediate, CommandQueue queueType)
+    CommandListWrapper::CommandListWrapper(DeviceWrapper* device, ICommandList* commandList, bool isImmediate, bool isBundle, CommandQueue queueType)
         : m_CommandList(commandList)
         , m_Device(device)
         , m_MessageCallback(device->getMessageCallback())
         , m_IsImmediate(isImmediate)
+        , m_IsBundle(isBundle)
         , m_type(queueType)
+        , m_Level(device->m_Desc.level)
+        , m_SamplingInterval(std::max(device->m_Desc.samplingInterval, 1u))
     {
     }
     
@@ -81,17 +86,25 @@ namespace nvrhi::validation
         }
     }
 
-    bool CommandListWrapper::requireOpenState() const
+    bool CommandListWrapper::requireOpenState(bool allowedInBundles) const
     {
-        if (m_State == CommandListState::OPEN)
-            return true;
+        if (m_State != CommandListState::OPEN)
+        {
+            std::stringstream ss;
+            ss << "A command list must be opened before any rendering commands can be executed. "
+                "Actual state: " << CommandListStateToString(m_State);
+            error(ss.str());
 
-        std::stringstream ss;
-        ss << "A command list must be opened before any rendering commands can be executed. "
-            "Actual state: " << CommandListStateToString(m_State);
-        error(ss.str());
+            return false;
+        }
+
+        if (m_IsBundle && !allowedInBundles)
+        {
+            error("Only setGraphicsState, draw commands, setPushConstants and markers can be recorded into a bundle");
+            return false;
+        }
 
-        return false;
+        return true;
     }
 
     bool CommandListWrapper::requireExecuteState()
@@ -109,7 +122,10 @@ namespace nvrhi::validation
             break;
         }
 
-        m_State = CommandListState::INITIAL;
+        // Reusable command lists stay closed and can be executed again until they are reopened
+        if (!m_CommandList->getDesc().reusable)
+            m_State = CommandListState::INITIAL;
+
         return true;
     }
 
@@ -128,6 +144,20 @@ namespace nvrhi::validation
         return true;
     }
 
+    bool CommandListWrapper::sampleExpensiveChecks()
+    {
+        switch (m_Level)
+        {
+        case ValidationLevel::Minimal:
+            return false;
+        case ValidationLevel::Sampled:
+            return (m_SampleCounter++ % m_SamplingInterval) == 0;
+        case ValidationLevel::Full:
+        default:
+            return true;
+        }
+    }
+
     Object CommandListWrapper::getNativeObject(ObjectType objectType)
     {
         return m_CommandList->getNativeObject(objectType);
@@ -146,6 +176,12 @@ namespace nvrhi::validation
                 error("An immediate command list cannot be abandoned and must be executed before it is re-opened");
                 return;
             }
+            else if (m_IsBundle || m_CommandList->getDesc().reusable)
+            {
+                // Bundles are never executed directly, and reusable lists stay closed after executions,
+                // re-recording them is the normal use
+                break;
+            }
             else
             {
                 warning("A command list should be executed before it is reopened");
@@ -169,9 +205,14 @@ namespace nvrhi::validation
         m_CommandList->open();
 
         m_State = CommandListState::OPEN;
+        m_BundleFramebuffer = nullptr;
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
         m_MeshletStateSet = false;
+        m_ActiveOcclusionQuery = nullptr;
+        m_ActivePipelineStatisticsQuery = nullptr;
+        m_PredicationEnabled = false;
+        m_PendingTextureWrites.clear();
     }
 
     void CommandListWrapper::close()
@@ -189,6 +230,21 @@ namespace nvrhi::validation
             break;
         }
 
+        if (m_ActiveOcclusionQuery)
+            error("An occlusion query was begun in this command list, but not ended before closing it");
+
+        if (m_ActivePipelineStatisticsQuery)
+            error("A pipeline statistics query was begun in this command list, but not ended before closing it");
+
+        for (const PendingTextureWrite& write : m_PendingTextureWrites)
+        {
+            std::stringstream ss;
+            ss << "A write to texture " << utils::DebugNameToString(write.texture->getDesc().debugName)
+                << " array slice " << write.arraySlice << " mip level " << write.mipLevel
+                << " was begun in this command list, but not ended before closing it";
+            error(ss.str());
+        }
+
         if (m_IsImmediate)
         {
             --m_Device->m_NumOpenImmediateCommandLists;
@@ -207,6 +263,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!validateNotTransientAttachment(t, "clearTextureFloat"))
+            return;
+
         if (!requireType(CommandQueue::Compute, "clearTextureFloat"))
             return;
 
@@ -248,6 +307,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!validateNotTransientAttachment(t, "clearDepthStencilTexture"))
+            return;
+
         if (!requireType(CommandQueue::Graphics, "clearDepthStencilTexture"))
             return;
 
@@ -278,6 +340,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!validateNotTransientAttachment(t, "clearTextureUInt"))
+            return;
+
         if (!requireType(CommandQueue::Compute, "clearTextureUInt"))
             return;
 
@@ -318,6 +383,9 @@ namespace nvrhi::validation
     {
         if (!requireOpenState())
             return;
+
+        if (!validateNotTransientAttachment(dest, "copyTexture") || !validateNotTransientAttachment(src, "copyTexture"))
+            return;
         
         m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
     }
@@ -327,6 +395,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!validateNotTransientAttachment(src, "copyTexture"))
+            return;
+
         m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
     }
 
@@ -335,6 +406,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!validateNotTransientAttachment(dest, "copyTexture"))
+            return;
+
         m_CommandList->copyTexture(dest, destSlice, src, srcSlice);
     }
 
@@ -343,6 +417,9 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (!validateNotTransientAttachment(dest, "writeTexture"))
+            return;
+
         if (dest->getDesc().height > 1 && rowPitch == 0)
         {
             error("writeTexture: rowPitch is 0 but dest has multiple rows");
@@ -351,11 +428,136 @@ namespace nvrhi::validation
         m_CommandList->writeTexture(dest, arraySlice, mipLevel, data, rowPitch, depthPitch);
     }
 
+    void CommandListWrapper::writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateNotTransientAttachment(dest, "writeTextureSubresources"))
+            return;
+
+        if (!dest)
+        {
+            error("writeTextureSubresources: dest is NULL");
+            return;
+        }
+
+        if (numSubresources != 0 && !subresources)
+        {
+            error("writeTextureSubresources: subresources is NULL");
+            return;
+        }
+
+        const TextureDesc& desc = dest->getDesc();
+
+        for (size_t i = 0; i < numSubresources; i++)
+        {
+            const TextureSubresourceData& subresource = subresources[i];
+
+            if (subresource.mipLevel >= desc.mipLevels || subresource.arraySlice >= desc.arraySize)
+            {
+                std::stringstream ss;
+                ss << "writeTextureSubresources: subresources[" << i << "] with array slice " << subresource.arraySlice
+                    << " mip level " << subresource.mipLevel << " is out of range for texture " << utils::DebugNameToString(desc.debugName)
+                    << " with " << desc.arraySize << " array slices and " << desc.mipLevels << " mip levels";
+                error(ss.str());
+                return;
+            }
+
+            if (!subresource.data)
+            {
+                std::stringstream ss;
+                ss << "writeTextureSubresources: subresources[" << i << "].data is NULL";
+                error(ss.str());
+                return;
+            }
+
+            if (desc.height > 1 && subresource.rowPitch == 0)
+            {
+                std::stringstream ss;
+                ss << "writeTextureSubresources: subresources[" << i << "].rowPitch is 0 but dest has multiple rows";
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_CommandList->writeTextureSubresources(dest, subresources, numSubresources);
+    }
+
+    void* CommandListWrapper::beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch)
+    {
+        if (!requireOpenState())
+            return nullptr;
+
+        if (!dest)
+        {
+            error("beginTextureWrite: dest is NULL");
+            return nullptr;
+        }
+
+        const TextureDesc& desc = dest->getDesc();
+
+        if (mipLevel >= desc.mipLevels || arraySlice >= desc.arraySize)
+        {
+            std::stringstream ss;
+            ss << "beginTextureWrite: array slice " << arraySlice << " mip level " << mipLevel
+                << " is out of range for texture " << utils::DebugNameToString(desc.debugName)
+                << " with " << desc.arraySize << " array slices and " << desc.mipLevels << " mip levels";
+            error(ss.str());
+            return nullptr;
+        }
+
+        for (const PendingTextureWrite& write : m_PendingTextureWrites)
+        {
+            if (write.texture == dest && write.arraySlice == arraySlice && write.mipLevel == mipLevel)
+            {
+                std::stringstream ss;
+                ss << "beginTextureWrite: array slice " << arraySlice << " mip level " << mipLevel
+                    << " of texture " << utils::DebugNameToString(desc.debugName) << " is already being written";
+                error(ss.str());
+                return nullptr;
+            }
+        }
+
+        void* mappedPtr = m_CommandList->beginTextureWrite(dest, arraySlice, mipLevel, outRowPitch, outDepthPitch);
+
+        if (mappedPtr)
+            m_PendingTextureWrites.push_back({ dest, arraySlice, mipLevel });
+
+        return mappedPtr;
+    }
+
+    void CommandListWrapper::endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        if (!requireOpenState())
+            return;
+
+        auto it = std::find_if(m_PendingTextureWrites.begin(), m_PendingTextureWrites.end(), [dest, arraySlice, mipLevel](const PendingTextureWrite& write)
+            { return write.texture == dest && write.arraySlice == arraySlice && write.mipLevel == mipLevel; });
+
+        if (it == m_PendingTextureWrites.end())
+        {
+            std::stringstream ss;
+            ss << "endTextureWrite: array slice " << arraySlice << " mip level " << mipLevel
+                << " of texture " << (dest ? utils::DebugNameToString(dest->getDesc().debugName) : "NULL")
+                << " is not being written, call beginTextureWrite first";
+            error(ss.str());
+            return;
+        }
+
+        m_PendingTextureWrites.erase(it);
+
+        m_CommandList->endTextureWrite(dest, arraySlice, mipLevel);
+    }
+
     void CommandListWrapper::resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources)
     {
         if (!requireOpenState())
             return;
 
+        if (!validateNotTransientAttachment(dest, "resolveTexture") || !validateNotTransientAttachment(src, "resolveTexture"))
+            return;
+
         if (!requireType(CommandQueue::Graphics, "resolveTexture"))
             return;
 
@@ -422,6 +624,168 @@ namespace nvrhi::validation
         m_CommandList->resolveTexture(dest, dstSubresources, src, srcSubresources);
     }
 
+    bool CommandListWrapper::validateNotTransientAttachment(ITexture* texture, const char* operation) const
+    {
+        if (texture && texture->getDesc().isTransientAttachment)
+        {
+            error(std::string(operation) + ": texture " + utils::DebugNameToString(texture->getDesc().debugName)
+                + " is a transient attachment, which can only be accessed by rendering to it");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CommandListWrapper::validateBlitTexture(ITexture* texture, bool isDest, const char* operation) const
+    {
+        if (!texture)
+        {
+            std::stringstream ss;
+            ss << operation << ": texture is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        const TextureDesc& desc = texture->getDesc();
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+        const bool isD3D = m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN;
+        bool anyErrors = false;
+
+        if (!validateNotTransientAttachment(texture, operation))
+            return false;
+
+        switch (desc.dimension)
+        {
+        case TextureDimension::Texture2D:
+        case TextureDimension::Texture2DArray:
+        case TextureDimension::TextureCube:
+        case TextureDimension::TextureCubeArray:
+            break;
+        default:
+            error(std::string(operation) + ": texture " + utils::DebugNameToString(desc.debugName)
+                + " has dimension " + utils::TextureDimensionToString(desc.dimension)
+                + ", only 2D, 2D array and cube textures are supported");
+            anyErrors = true;
+        }
+
+        if (desc.sampleCount != 1)
+        {
+            error(std::string(operation) + ": texture " + utils::DebugNameToString(desc.debugName) + " must not be multi-sampled");
+            anyErrors = true;
+        }
+
+        if ((formatInfo.kind != FormatKind::Normalized && formatInfo.kind != FormatKind::Float) || formatInfo.blockSize != 1)
+        {
+            error(std::string(operation) + ": texture " + utils::DebugNameToString(desc.debugName) + " has format "
+                + formatInfo.name + ", only uncompressed normalized and float color formats are supported");
+            anyErrors = true;
+        }
+
+        if (isDest && isD3D && !desc.isUAV)
+        {
+            error(std::string(operation) + ": the destination texture " + utils::DebugNameToString(desc.debugName)
+                + " must have the isUAV flag set on DX11 and DX12");
+            anyErrors = true;
+        }
+
+        if (isDest && isD3D && formatInfo.isSRGB)
+        {
+            error(std::string(operation) + ": the destination texture " + utils::DebugNameToString(desc.debugName)
+                + " must not have an sRGB format on DX11 and DX12");
+            anyErrors = true;
+        }
+
+        return !anyErrors;
+    }
+
+    void CommandListWrapper::invalidateState()
+    {
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_MeshletStateSet = false;
+        m_RayTracingStateSet = false;
+        m_PushConstantsSet = false;
+    }
+
+    void CommandListWrapper::generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter)
+    {
+        if (!requireOpenState())
+            return;
+
+        // Blits need a graphics queue on Vulkan, the DX11/12 implementation is a compute shader
+        const bool isVulkan = m_Device->getGraphicsAPI() == GraphicsAPI::VULKAN;
+        if (!requireType(isVulkan ? CommandQueue::Graphics : CommandQueue::Compute, "generateMips"))
+            return;
+
+        if (!validateBlitTexture(texture, true, "generateMips"))
+            return;
+
+        const TextureDesc& desc = texture->getDesc();
+        if (subresources.baseMipLevel >= desc.mipLevels || subresources.baseArraySlice >= desc.arraySize)
+        {
+            error(std::string("generateMips: the subresource set is outside of the texture ") + utils::DebugNameToString(desc.debugName));
+            return;
+        }
+
+        m_CommandList->generateMips(texture, subresources, linearFilter);
+
+        invalidateState();
+    }
+
+    void CommandListWrapper::blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter)
+    {
+        if (!requireOpenState())
+            return;
+
+        const bool isVulkan = m_Device->getGraphicsAPI() == GraphicsAPI::VULKAN;
+        if (!requireType(isVulkan ? CommandQueue::Graphics : CommandQueue::Compute, "blitTexture"))
+            return;
+
+        if (!validateBlitTexture(dest, true, "blitTexture") || !validateBlitTexture(src, false, "blitTexture"))
+            return;
+
+        const TextureDesc& destDesc = dest->getDesc();
+        const TextureDesc& srcDesc = src->getDesc();
+        const TextureSlice resolvedDestSlice = destSlice.resolve(destDesc);
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(srcDesc);
+
+        bool anyErrors = false;
+
+        auto validateSlice = [this, &anyErrors](const TextureSlice& slice, const TextureDesc& desc, const char* name)
+        {
+            if (slice.mipLevel >= desc.mipLevels || slice.arraySlice >= desc.arraySize)
+            {
+                error(std::string("blitTexture: the ") + name + " slice is outside of the texture " + utils::DebugNameToString(desc.debugName));
+                anyErrors = true;
+                return;
+            }
+
+            const uint32_t mipWidth = std::max(desc.width >> slice.mipLevel, 1u);
+            const uint32_t mipHeight = std::max(desc.height >> slice.mipLevel, 1u);
+            if (slice.width == 0 || slice.height == 0 || slice.x + slice.width > mipWidth || slice.y + slice.height > mipHeight)
+            {
+                error(std::string("blitTexture: the ") + name + " region is empty or exceeds the mip level of the texture " + utils::DebugNameToString(desc.debugName));
+                anyErrors = true;
+            }
+        };
+
+        validateSlice(resolvedDestSlice, destDesc, "destination");
+        validateSlice(resolvedSrcSlice, srcDesc, "source");
+
+        if (dest == src && resolvedDestSlice.mipLevel == resolvedSrcSlice.mipLevel && resolvedDestSlice.arraySlice == resolvedSrcSlice.arraySlice)
+        {
+            error("blitTexture: the source and destination subresources must be different");
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+            return;
+
+        m_CommandList->blitTexture(dest, destSlice, src, srcSlice, linearFilter);
+
+        invalidateState();
+    }
+
     void CommandListWrapper::writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes)
     {
         if (!requireOpenState())
@@ -482,6 +846,18 @@ namespace nvrhi::validation
         m_CommandList->setSamplerFeedbackTextureState(texture, stateBits);
     }
 
+    IBindingSet* CommandListWrapper::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        if (!requireOpenState())
+            return nullptr;
+
+        BindingSetDesc patchedDesc;
+        if (!m_Device->validateBindingSetDesc(desc, layout, patchedDesc))
+            return nullptr;
+
+        return m_CommandList->createTransientBindingSet(patchedDesc, layout);
+    }
+
     bool CommandListWrapper::validateBindingSetsAgainstLayouts(const static_vector<BindingLayoutHandle, c_MaxBindingLayouts>& layouts, const static_vector<IBindingSet*, c_MaxBindingLayouts>& sets) const
     {
         if (layouts.size() != sets.size())
@@ -533,7 +909,7 @@ namespace nvrhi::validation
 
     void CommandListWrapper::setPushConstants(const void* data, size_t byteSize)
     {
-        if (!requireOpenState())
+        if (!requireOpenState(true))
             return;
 
         if (!m_GraphicsStateSet && !m_ComputeStateSet && !m_MeshletStateSet && !m_RayTracingStateSet)
@@ -568,39 +944,13 @@ namespace nvrhi::validation
         m_CommandList->setPushConstants(data, byteSize);
     }
 
-    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    bool CommandListWrapper::validateVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers, std::stringstream& ss) const
     {
-        if (!requireOpenState())
-            return;
-
-        if (!requireType(CommandQueue::Graphics, "setGraphicsState"))
-            return;
-
         bool anyErrors = false;
-        std::stringstream ss;
-        ss << "setGraphicsState: " << std::endl;
 
-        if (!state.pipeline)
-        {
-            ss << "pipeline is NULL." << std::endl;
-            anyErrors = true;
-        }
-
-        if (!state.framebuffer)
-        {
-            ss << "framebuffer is NULL." << std::endl;
-            anyErrors = true;
-        }
-
-        if (state.indexBuffer.buffer && !state.indexBuffer.buffer->getDesc().isIndexBuffer)
+        for (size_t index = 0; index < numVertexBuffers; index++)
         {
-            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indexBuffer.buffer->getDesc().debugName) << "' as an index buffer because it does not have the isIndexBuffer flag set." << std::endl;
-            anyErrors = true;
-        }
-
-        for (size_t index = 0; index < state.vertexBuffers.size(); index++)
-        {
-            const VertexBufferBinding& vb = state.vertexBuffers[index];
+            const VertexBufferBinding& vb = vertexBuffers[index];
 
             if (!vb.buffer)
             {
@@ -620,16 +970,74 @@ namespace nvrhi::validation
             }
         }
 
+        return !anyErrors;
+    }
+
+    bool CommandListWrapper::validateGraphicsState(const GraphicsState& state) const
+    {
+        bool anyErrors = false;
+        std::stringstream ss;
+        ss << "setGraphicsState: " << std::endl;
+
+        if (!state.pipeline)
+        {
+            ss << "pipeline is NULL." << std::endl;
+            anyErrors = true;
+        }
+
+        if (!state.framebuffer)
+        {
+            ss << "framebuffer is NULL." << std::endl;
+            anyErrors = true;
+        }
+
+        if (state.indexBuffer.buffer && !state.indexBuffer.buffer->getDesc().isIndexBuffer)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indexBuffer.buffer->getDesc().debugName) << "' as an index buffer because it does not have the isIndexBuffer flag set." << std::endl;
+            anyErrors = true;
+        }
+
+        if (!validateVertexBuffers(state.vertexBuffers.data(), state.vertexBuffers.size(), ss))
+            anyErrors = true;
+
         if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
         {
             ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectParams->getDesc().debugName) << "' as a DrawIndirect argument buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
             anyErrors = true;
         }
 
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) << "' as a DrawIndirect count buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+            anyErrors = true;
+        }
+
+        if (m_IsBundle)
+        {
+            if (m_GraphicsStateSet && state.framebuffer != m_CurrentGraphicsState.framebuffer)
+            {
+                ss << "All graphics states in a bundle must use the same framebuffer." << std::endl;
+                anyErrors = true;
+            }
+
+            if (m_GraphicsStateSet && (arraysAreDifferent(state.viewport.viewports, m_CurrentGraphicsState.viewport.viewports) ||
+                arraysAreDifferent(state.viewport.scissorRects, m_CurrentGraphicsState.viewport.scissorRects)))
+            {
+                ss << "All graphics states in a bundle must use the same viewport state." << std::endl;
+                anyErrors = true;
+            }
+
+            if (state.shadingRateState.enabled)
+            {
+                ss << "Variable rate shading cannot be used in bundles." << std::endl;
+                anyErrors = true;
+            }
+        }
+
         if (anyErrors)
         {
             error(ss.str());
-            return;
+            return false;
         }
 
         if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
@@ -638,13 +1046,35 @@ namespace nvrhi::validation
         if (state.framebuffer->getFramebufferInfo() != state.pipeline->getFramebufferInfo())
         {
             ss << "The framebuffer used in the draw call does not match the framebuffer used to create the pipeline." << std::endl <<
-                "Formats and sample counts of the framebuffers must match." << std::endl;
+                "Formats, sample counts and the presence of a shading rate attachment must match." << std::endl;
             anyErrors = true;
         }
 
         if (anyErrors)
         {
             error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::setGraphicsState(const GraphicsState& state)
+    {
+        if (!requireOpenState(true))
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setGraphicsState"))
+            return;
+
+        if (sampleExpensiveChecks())
+        {
+            if (!validateGraphicsState(state))
+                return;
+        }
+        else if (!state.pipeline || !state.framebuffer)
+        {
+            error("setGraphicsState: pipeline or framebuffer is NULL.");
             return;
         }
 
@@ -658,11 +1088,127 @@ namespace nvrhi::validation
         m_RayTracingStateSet = false;
         m_PushConstantsSet = false;
         m_CurrentGraphicsState = state;
+
+        if (m_IsBundle)
+            m_BundleFramebuffer = state.framebuffer;
+    }
+
+    bool CommandListWrapper::requireGraphicsStateForUpdate(const char* operation) const
+    {
+        if (!requireOpenState(true))
+            return false;
+
+        if (!requireType(CommandQueue::Graphics, operation))
+            return false;
+
+        if (!m_GraphicsStateSet)
+        {
+            std::stringstream ss;
+            ss << operation << " can only modify a graphics state that was previously set with setGraphicsState.\n"
+                "Note that setting compute state invalidates the graphics state.";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        if (!requireGraphicsStateForUpdate("setGraphicsBindingSet"))
+            return;
+
+        const auto& layouts = m_CurrentGraphicsState.pipeline->getDesc().bindingLayouts;
+        if (slot >= layouts.size())
+        {
+            std::stringstream ss;
+            ss << "setGraphicsBindingSet: slot " << slot << " is out of range, the pipeline has " << layouts.size() << " binding layouts";
+            error(ss.str());
+            return;
+        }
+
+        BindingSetVector bindings = m_CurrentGraphicsState.bindings;
+        bindings[slot] = bindingSet;
+
+        if (sampleExpensiveChecks() && !validateBindingSetsAgainstLayouts(layouts, bindings))
+            return;
+
+        m_CommandList->setGraphicsBindingSet(slot, bindingSet);
+
+        m_CurrentGraphicsState.bindings = bindings;
+    }
+
+    void CommandListWrapper::setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers)
+    {
+        if (!requireGraphicsStateForUpdate("setVertexBuffers"))
+            return;
+
+        if (numVertexBuffers > c_MaxVertexAttributes)
+        {
+            std::stringstream ss;
+            ss << "setVertexBuffers: " << std::endl;
+            ss << "Too many vertex buffer bindings (" << numVertexBuffers << "), the maximum is " << c_MaxVertexAttributes << "." << std::endl;
+            error(ss.str());
+            return;
+        }
+
+        if (sampleExpensiveChecks())
+        {
+            std::stringstream ss;
+            ss << "setVertexBuffers: " << std::endl;
+
+            if (!validateVertexBuffers(vertexBuffers, numVertexBuffers, ss))
+            {
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_CommandList->setVertexBuffers(vertexBuffers, numVertexBuffers);
+
+        m_CurrentGraphicsState.vertexBuffers.resize(numVertexBuffers);
+        for (size_t index = 0; index < numVertexBuffers; index++)
+            m_CurrentGraphicsState.vertexBuffers[index] = vertexBuffers[index];
+    }
+
+    void CommandListWrapper::setIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        if (!requireGraphicsStateForUpdate("setIndexBuffer"))
+            return;
+
+        if (indexBuffer.buffer && !indexBuffer.buffer->getDesc().isIndexBuffer)
+        {
+            std::stringstream ss;
+            ss << "setIndexBuffer: Cannot use buffer '" << utils::DebugNameToString(indexBuffer.buffer->getDesc().debugName) << "' as an index buffer because it does not have the isIndexBuffer flag set.";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->setIndexBuffer(indexBuffer);
+
+        m_CurrentGraphicsState.indexBuffer = indexBuffer;
+    }
+
+    void CommandListWrapper::setViewportState(const ViewportState& viewport)
+    {
+        if (!requireGraphicsStateForUpdate("setViewportState"))
+            return;
+
+        if (m_IsBundle && (arraysAreDifferent(viewport.viewports, m_CurrentGraphicsState.viewport.viewports) ||
+            arraysAreDifferent(viewport.scissorRects, m_CurrentGraphicsState.viewport.scissorRects)))
+        {
+            error("setViewportState: All graphics states in a bundle must use the same viewport state.");
+            return;
+        }
+
+        m_CommandList->setViewportState(viewport);
+
+        m_CurrentGraphicsState.viewport = viewport;
     }
 
     void CommandListWrapper::draw(const DrawArguments& args)
     {
-        if (!requireOpenState())
+        if (!requireOpenState(true))
             return;
 
         if (!requireType(CommandQueue::Graphics, "draw"))
@@ -683,7 +1229,7 @@ namespace nvrhi::validation
 
     void CommandListWrapper::drawIndexed(const DrawArguments& args)
     {
-        if (!requireOpenState())
+        if (!requireOpenState(true))
             return;
 
         if (!requireType(CommandQueue::Graphics, "drawIndexed"))
@@ -710,7 +1256,7 @@ namespace nvrhi::validation
 
     void CommandListWrapper::drawIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
-        if (!requireOpenState())
+        if (!requireOpenState(true))
             return;
 
         if (!requireType(CommandQueue::Graphics, "drawIndirect"))
@@ -737,7 +1283,7 @@ namespace nvrhi::validation
 
     void CommandListWrapper::drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount)
     {
-        if (!requireOpenState())
+        if (!requireOpenState(true))
             return;
 
         if (!requireType(CommandQueue::Graphics, "drawIndexedIndirect"))
@@ -762,14 +1308,165 @@ namespace nvrhi::validation
         m_CommandList->drawIndexedIndirect(offsetBytes, drawCount);
     }
 
-    void CommandListWrapper::setComputeState(const ComputeState& state)
+    void CommandListWrapper::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState(true))
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "drawIndirectCount"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndirectCount call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndirectCount call.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectCountBuffer)
+        {
+            error("Indirect count buffer is not set before a drawIndirectCount call.");
+            return;
+        }
+
+        if (countOffsetBytes % 4 != 0)
+        {
+            error("The count offset in a drawIndirectCount call must be a multiple of 4 bytes.");
+            return;
+        }
+
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        if (!requireOpenState(true))
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "drawIndexedIndirectCount"))
+            return;
+
+        if (!m_GraphicsStateSet)
+        {
+            error("Graphics state is not set before a drawIndexedIndirectCount call.\n"
+                "Note that setting compute state invalidates the graphics state.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a drawIndexedIndirectCount call.");
+            return;
+        }
+
+        if (!m_CurrentGraphicsState.indirectCountBuffer)
+        {
+            error("Indirect count buffer is not set before a drawIndexedIndirectCount call.");
+            return;
+        }
+
+        if (countOffsetBytes % 4 != 0)
+        {
+            error("The count offset in a drawIndexedIndirectCount call must be a multiple of 4 bytes.");
+            return;
+        }
+
+        if (!validatePushConstants("graphics", "setGraphicsState"))
+            return;
+
+        m_CommandList->drawIndexedIndirectCount(paramOffsetBytes, countOffsetBytes, maxDrawCount);
+    }
+
+    void CommandListWrapper::executeBundles(ICommandList* const* bundles, size_t numBundles)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "setComputeState"))
+        if (!requireType(CommandQueue::Graphics, "executeBundles"))
+            return;
+
+        if (numBundles == 0)
+            return;
+
+        if (!bundles)
+        {
+            error("executeBundles: bundles is NULL");
             return;
+        }
+
+        std::vector<ICommandList*> underlyingBundles;
+        underlyingBundles.resize(numBundles);
+
+        IFramebuffer* framebuffer = nullptr;
+
+        for (size_t i = 0; i < numBundles; i++)
+        {
+            if (!bundles[i])
+            {
+                std::stringstream ss;
+                ss << "executeBundles: bundles[" << i << "] is NULL";
+                error(ss.str());
+                return;
+            }
+
+            if (!bundles[i]->getDesc().isBundle)
+            {
+                std::stringstream ss;
+                ss << "executeBundles: the command list [" << i << "] was not created as a bundle";
+                error(ss.str());
+                return;
+            }
+
+            CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(bundles[i]);
+            if (wrapper)
+            {
+                if (wrapper->m_State != CommandListState::CLOSED)
+                {
+                    std::stringstream ss;
+                    ss << "executeBundles: the bundle [" << i << "] must be recorded and closed before it is executed";
+                    error(ss.str());
+                    return;
+                }
+
+                if (!wrapper->m_BundleFramebuffer)
+                {
+                    std::stringstream ss;
+                    ss << "executeBundles: the bundle [" << i << "] was not recorded with any graphics state";
+                    error(ss.str());
+                    return;
+                }
+
+                if (framebuffer && wrapper->m_BundleFramebuffer != framebuffer)
+                {
+                    error("executeBundles: all bundles executed together must be recorded with the same framebuffer");
+                    return;
+                }
+
+                framebuffer = wrapper->m_BundleFramebuffer;
+                underlyingBundles[i] = wrapper->getUnderlyingCommandList();
+            }
+            else
+                underlyingBundles[i] = bundles[i];
+        }
+
+        m_CommandList->executeBundles(underlyingBundles.data(), numBundles);
 
+        // The bundles leave the graphics state undefined
+        m_GraphicsStateSet = false;
+        m_MeshletStateSet = false;
+    }
+
+    bool CommandListWrapper::validateComputeState(const ComputeState& state) const
+    {
         bool anyErrors = false;
         std::stringstream ss;
         ss << "setComputeState: " << std::endl;
@@ -786,157 +1483,690 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
-        if (anyErrors)
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) << "' as an indirect count buffer because it does not have the isDrawIndirectArgs flag set." << std::endl;
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return false;
+        }
+
+        return validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings);
+    }
+
+    void CommandListWrapper::setComputeState(const ComputeState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "setComputeState"))
+            return;
+
+        if (sampleExpensiveChecks())
+        {
+            if (!validateComputeState(state))
+                return;
+        }
+        else if (!state.pipeline)
+        {
+            error("setComputeState: pipeline is NULL.");
+            return;
+        }
+
+        evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
+
+        m_CommandList->setComputeState(state);
+
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = true;
+        m_MeshletStateSet = false;
+        m_RayTracingStateSet = false;
+        m_PushConstantsSet = false;
+        m_CurrentComputeState = state;
+    }
+
+    void CommandListWrapper::dispatch(uint32_t groupsX, uint32_t groupsY /*= 1*/, uint32_t groupsZ /*= 1*/)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "dispatch"))
+            return;
+
+        if (!m_ComputeStateSet)
+        {
+            error("Compute state is not set before a dispatch call.\n"
+                "Note that setting graphics state invalidates the compute state.");
+            return;
+        }
+
+        if (!validatePushConstants("compute", "setComputeState"))
+            return;
+
+        m_CommandList->dispatch(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchIndirect(uint32_t offsetBytes)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "dispatchIndirect"))
+            return;
+
+        if (!m_ComputeStateSet)
+        {
+            error("Compute state is not set before a dispatchIndirect call.\n"
+                "Note that setting graphics state invalidates the compute state.");
+            return;
+        }
+
+        if (!m_CurrentComputeState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a dispatchIndirect call.");
+            return;
+        }
+
+        if (!validatePushConstants("compute", "setComputeState"))
+            return;
+
+        m_CommandList->dispatchIndirect(offsetBytes);
+    }
+
+    bool CommandListWrapper::validateMeshletState(const MeshletState& state) const
+    {
+        bool anyErrors = false;
+        if (!state.pipeline)
+        {
+            error("MeshletState::pipeline is NULL");
+            anyErrors = true;
+        }
+
+        if (state.indirectParams && !state.indirectParams->getDesc().isDrawIndirectArgs)
+        {
+            std::stringstream ss;
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectParams->getDesc().debugName) << "' as a DispatchMesh argument buffer because it does not have the isDrawIndirectArgs flag set.";
+            error(ss.str());
+            anyErrors = true;
+        }
+
+        if (state.indirectCountBuffer && !state.indirectCountBuffer->getDesc().isDrawIndirectArgs)
+        {
+            std::stringstream ss;
+            ss << "Cannot use buffer '" << utils::DebugNameToString(state.indirectCountBuffer->getDesc().debugName) << "' as a DispatchMesh count buffer because it does not have the isDrawIndirectArgs flag set.";
+            error(ss.str());
+            anyErrors = true;
+        }
+
+        if (anyErrors)
+            return false;
+
+        return validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings);
+    }
+
+    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "setMeshletState"))
+            return;
+
+        if (sampleExpensiveChecks())
+        {
+            if (!validateMeshletState(state))
+                return;
+        }
+        else if (!state.pipeline)
+        {
+            error("MeshletState::pipeline is NULL");
+            return;
+        }
+
+        evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
+
+        m_CommandList->setMeshletState(state);
+
+        m_GraphicsStateSet = false;
+        m_ComputeStateSet = false;
+        m_MeshletStateSet = true;
+        m_RayTracingStateSet = false;
+        m_PushConstantsSet = false;
+        m_CurrentMeshletState = state;
+    }
+
+    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY /*= 1*/, uint32_t groupsZ /*= 1*/)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "dispatchMesh"))
+            return;
+
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMesh call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return;
+        }
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return;
+
+        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "dispatchMeshIndirect"))
+            return;
+
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMeshIndirect call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return;
+        }
+
+        if (!m_CurrentMeshletState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a dispatchMeshIndirect call.");
+            return;
+        }
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return;
+
+        m_CommandList->dispatchMeshIndirect(offsetBytes, dispatchCount);
+    }
+
+    void CommandListWrapper::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "dispatchMeshIndirectCount"))
+            return;
+
+        if (!m_MeshletStateSet)
+        {
+            error("Meshlet state is not set before a dispatchMeshIndirectCount call.\n"
+                "Note that setting graphics or compute state invalidates the meshlet state.");
+            return;
+        }
+
+        if (!m_CurrentMeshletState.indirectParams)
+        {
+            error("Indirect params buffer is not set before a dispatchMeshIndirectCount call.");
+            return;
+        }
+
+        if (!m_CurrentMeshletState.indirectCountBuffer)
+        {
+            error("Indirect count buffer is not set before a dispatchMeshIndirectCount call.");
+            return;
+        }
+
+        if (countOffsetBytes % 4 != 0)
+        {
+            error("The count offset in a dispatchMeshIndirectCount call must be a multiple of 4 bytes.");
+            return;
+        }
+
+        if (!validatePushConstants("meshlet", "setMeshletState"))
+            return;
+
+        m_CommandList->dispatchMeshIndirectCount(paramOffsetBytes, countOffsetBytes, maxDispatchCount);
+    }
+
+    void CommandListWrapper::executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes)
+    {
+        if (!signature)
+        {
+            error("executeIndirect: signature is NULL");
+            return;
+        }
+
+        const CommandSignatureDesc& desc = signature->getDesc();
+        const IndirectArgumentType action = desc.arguments.back().type;
+
+        if (!requireOpenState(action == IndirectArgumentType::Draw || action == IndirectArgumentType::DrawIndexed))
+            return;
+
+        IBuffer* indirectParams = nullptr;
+        IBuffer* indirectCount = nullptr;
+        IResource* currentPipeline = nullptr;
+        IResource* signaturePipeline = nullptr;
+
+        switch (action)
+        {
+        case IndirectArgumentType::Draw:
+        case IndirectArgumentType::DrawIndexed:
+            if (!requireType(CommandQueue::Graphics, "executeIndirect"))
+                return;
+
+            if (!m_GraphicsStateSet)
+            {
+                error("Graphics state is not set before an executeIndirect call with a draw signature.\n"
+                    "Note that setting compute state invalidates the graphics state.");
+                return;
+            }
+
+            if (!validatePushConstants("graphics", "setGraphicsState"))
+                return;
+
+            indirectParams = m_CurrentGraphicsState.indirectParams;
+            indirectCount = m_CurrentGraphicsState.indirectCountBuffer;
+            currentPipeline = m_CurrentGraphicsState.pipeline;
+            signaturePipeline = desc.graphicsPipeline;
+            break;
+
+        case IndirectArgumentType::Dispatch:
+            if (!requireType(CommandQueue::Compute, "executeIndirect"))
+                return;
+
+            if (!m_ComputeStateSet)
+            {
+                error("Compute state is not set before an executeIndirect call with a dispatch signature.\n"
+                    "Note that setting graphics state invalidates the compute state.");
+                return;
+            }
+
+            if (!validatePushConstants("compute", "setComputeState"))
+                return;
+
+            indirectParams = m_CurrentComputeState.indirectParams;
+            indirectCount = m_CurrentComputeState.indirectCountBuffer;
+            currentPipeline = m_CurrentComputeState.pipeline;
+            signaturePipeline = desc.computePipeline;
+            break;
+
+        case IndirectArgumentType::DispatchMesh:
+            if (!requireType(CommandQueue::Graphics, "executeIndirect"))
+                return;
+
+            if (!m_MeshletStateSet)
+            {
+                error("Meshlet state is not set before an executeIndirect call with a mesh dispatch signature.\n"
+                    "Note that setting graphics or compute state invalidates the meshlet state.");
+                return;
+            }
+
+            if (!validatePushConstants("meshlet", "setMeshletState"))
+                return;
+
+            indirectParams = m_CurrentMeshletState.indirectParams;
+            indirectCount = m_CurrentMeshletState.indirectCountBuffer;
+            currentPipeline = m_CurrentMeshletState.pipeline;
+            signaturePipeline = desc.meshletPipeline;
+            break;
+
+        default:
+            utils::InvalidEnum();
+            return;
+        }
+
+        if (!indirectParams)
+        {
+            error("Indirect params buffer is not set before an executeIndirect call.");
+            return;
+        }
+
+        if (signaturePipeline && signaturePipeline != currentPipeline)
+        {
+            error("The pipeline of the command signature used in executeIndirect is not the current pipeline.");
+            return;
+        }
+
+        if (indirectCount && countOffsetBytes % 4 != 0)
+        {
+            error("The count offset in an executeIndirect call must be a multiple of 4 bytes.");
+            return;
+        }
+
+        m_CommandList->executeIndirect(signature, paramOffsetBytes, maxCommandCount, countOffsetBytes);
+
+        if (desc.arguments.size() > 1)
+        {
+            // The arguments have modified the state, so it must be set again before the next draw or dispatch
+            m_GraphicsStateSet = false;
+            m_ComputeStateSet = false;
+            m_MeshletStateSet = false;
+        }
+    }
+
+    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->beginTimerQuery(query);
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->endTimerQuery(query);
+    }
+
+    void CommandListWrapper::beginTimerQueryFrame(ITimerQueryPool* pool)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!pool)
+        {
+            error("beginTimerQueryFrame: pool is NULL");
+            return;
+        }
+
+        if (pool->getDesc().queue != m_type)
+        {
+            std::stringstream ss;
+            ss << "beginTimerQueryFrame: pool '" << utils::DebugNameToString(pool->getDesc().debugName) << "' was created for the "
+                << CommandQueueTypeToString(pool->getDesc().queue) << " queue, but the command list is of type " << CommandQueueTypeToString(m_type);
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->beginTimerQueryFrame(pool);
+    }
+
+    bool CommandListWrapper::validateTimerQueryPoolIndex(ITimerQueryPool* pool, uint32_t queryIndex, const char* function) const
+    {
+        if (!pool)
+        {
+            std::stringstream ss;
+            ss << function << ": pool is NULL";
+            error(ss.str());
+            return false;
+        }
+
+        if (pool->getCurrentFrameIndex() == 0)
+        {
+            std::stringstream ss;
+            ss << function << ": no frame has been started in pool '" << utils::DebugNameToString(pool->getDesc().debugName)
+                << "', call beginTimerQueryFrame first";
+            error(ss.str());
+            return false;
+        }
+
+        if (pool->getDesc().queue != m_type)
+        {
+            std::stringstream ss;
+            ss << function << ": pool '" << utils::DebugNameToString(pool->getDesc().debugName) << "' was created for the "
+                << CommandQueueTypeToString(pool->getDesc().queue) << " queue, but the command list is of type " << CommandQueueTypeToString(m_type);
+            error(ss.str());
+            return false;
+        }
+
+        if (queryIndex >= pool->getDesc().maxQueriesPerFrame)
+        {
+            std::stringstream ss;
+            ss << function << ": queryIndex (" << queryIndex << ") is out of range, pool '" << utils::DebugNameToString(pool->getDesc().debugName)
+                << "' has " << pool->getDesc().maxQueriesPerFrame << " queries per frame";
+            error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandListWrapper::beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateTimerQueryPoolIndex(pool, queryIndex, "beginTimerQuery"))
+            return;
+
+        m_CommandList->beginTimerQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!validateTimerQueryPoolIndex(pool, queryIndex, "endTimerQuery"))
+            return;
+
+        m_CommandList->endTimerQuery(pool, queryIndex);
+    }
+
+    void CommandListWrapper::resolveTimerQueries(ITimerQueryPool* pool)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!pool)
+        {
+            error("resolveTimerQueries: pool is NULL");
+            return;
+        }
+
+        if (pool->getCurrentFrameIndex() == 0)
+        {
+            std::stringstream ss;
+            ss << "resolveTimerQueries: no frame has been started in pool '" << utils::DebugNameToString(pool->getDesc().debugName) << "'";
+            error(ss.str());
+            return;
+        }
+
+        m_CommandList->resolveTimerQueries(pool);
+    }
+
+    void CommandListWrapper::beginOcclusionQuery(IOcclusionQuery* query)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Graphics, "beginOcclusionQuery"))
+            return;
+
+        if (!query)
+        {
+            error("beginOcclusionQuery: query is NULL");
+            return;
+        }
+
+        if (m_ActiveOcclusionQuery)
         {
-            error(ss.str());
+            error("beginOcclusionQuery: another occlusion query is already active in this command list");
             return;
         }
 
-        if (anyErrors)
+        m_ActiveOcclusionQuery = query;
+
+        m_CommandList->beginOcclusionQuery(query);
+    }
+
+    void CommandListWrapper::endOcclusionQuery(IOcclusionQuery* query)
+    {
+        if (!requireOpenState())
             return;
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
-            anyErrors = true;
+        if (!requireType(CommandQueue::Graphics, "endOcclusionQuery"))
+            return;
 
-        if (anyErrors)
+        if (!query)
+        {
+            error("endOcclusionQuery: query is NULL");
             return;
+        }
 
-        evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
+        if (query != m_ActiveOcclusionQuery)
+        {
+            error("endOcclusionQuery: the query was not begun in this command list");
+            return;
+        }
 
-        m_CommandList->setComputeState(state);
+        m_ActiveOcclusionQuery = nullptr;
 
-        m_GraphicsStateSet = false;
-        m_ComputeStateSet = true;
-        m_MeshletStateSet = false;
-        m_RayTracingStateSet = false;
-        m_PushConstantsSet = false;
-        m_CurrentComputeState = state;
+        m_CommandList->endOcclusionQuery(query);
     }
 
-    void CommandListWrapper::dispatch(uint32_t groupsX, uint32_t groupsY /*= 1*/, uint32_t groupsZ /*= 1*/)
+    void CommandListWrapper::beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "dispatch"))
+        if (!requireType(CommandQueue::Compute, "beginPipelineStatisticsQuery"))
             return;
 
-        if (!m_ComputeStateSet)
+        if (!query)
         {
-            error("Compute state is not set before a dispatch call.\n"
-                "Note that setting graphics state invalidates the compute state.");
+            error("beginPipelineStatisticsQuery: query is NULL");
             return;
         }
 
-        if (!validatePushConstants("compute", "setComputeState"))
+        if (m_ActivePipelineStatisticsQuery)
+        {
+            error("beginPipelineStatisticsQuery: another pipeline statistics query is already active in this command list");
             return;
+        }
 
-        m_CommandList->dispatch(groupsX, groupsY, groupsZ);
+        m_ActivePipelineStatisticsQuery = query;
+
+        m_CommandList->beginPipelineStatisticsQuery(query);
     }
 
-    void CommandListWrapper::dispatchIndirect(uint32_t offsetBytes)
+    void CommandListWrapper::endPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Compute, "dispatchIndirect"))
-            return;
-
-        if (!m_ComputeStateSet)
+        if (!query)
         {
-            error("Compute state is not set before a dispatchIndirect call.\n"
-                "Note that setting graphics state invalidates the compute state.");
+            error("endPipelineStatisticsQuery: query is NULL");
             return;
         }
 
-        if (!m_CurrentComputeState.indirectParams)
+        if (query != m_ActivePipelineStatisticsQuery)
         {
-            error("Indirect params buffer is not set before a dispatchIndirect call.");
+            error("endPipelineStatisticsQuery: the query was not begun in this command list");
             return;
         }
 
-        if (!validatePushConstants("compute", "setComputeState"))
-            return;
+        m_ActivePipelineStatisticsQuery = nullptr;
 
-        m_CommandList->dispatchIndirect(offsetBytes);
+        m_CommandList->endPipelineStatisticsQuery(query);
     }
 
-    void CommandListWrapper::setMeshletState(const MeshletState& state)
+    void CommandListWrapper::setPredication(IOcclusionQuery* query, PredicationOp op)
     {
         if (!requireOpenState())
             return;
 
-        if (!requireType(CommandQueue::Graphics, "setMeshletState"))
+        if (!requireType(CommandQueue::Compute, "setPredication"))
             return;
 
-        bool anyErrors = false;
-        if (!state.pipeline)
+        if (query)
         {
-            error("MeshletState::pipeline is NULL");
-            anyErrors = true;
+            if (!m_Device->queryFeatureSupport(Feature::Predication))
+            {
+                error("setPredication: predication is not supported by the device");
+                return;
+            }
+
+            if (query == m_ActiveOcclusionQuery)
+            {
+                error("setPredication: the occlusion query must be ended before it can be used for predication");
+                return;
+            }
+
+            if (m_Device->getGraphicsAPI() == GraphicsAPI::D3D11 && query->getType() != OcclusionQueryType::Binary)
+            {
+                error("setPredication: only binary occlusion queries can be used for predication on DX11");
+                return;
+            }
         }
 
-        if (anyErrors)
-            return;
+        m_CommandList->setPredication(query, op);
+        m_PredicationEnabled = query != nullptr;
+    }
 
-        if (!validateBindingSetsAgainstLayouts(state.pipeline->getDesc().bindingLayouts, state.bindings))
-            anyErrors = true;
+    bool CommandListWrapper::validateSyncPointSplit(const char* function)
+    {
+        if (m_Device->getGraphicsAPI() == GraphicsAPI::D3D11)
+        {
+            error(std::string(function) + ": sync points are not supported on DX11");
+            return false;
+        }
 
-        if (anyErrors)
-            return;
+        if (m_ActiveOcclusionQuery)
+        {
+            error(std::string(function) + ": cannot split the command list while an occlusion query is active");
+            return false;
+        }
 
-        evaluatePushConstantSize(state.pipeline->getDesc().bindingLayouts);
+        if (m_ActivePipelineStatisticsQuery)
+        {
+            error(std::string(function) + ": cannot split the command list while a pipeline statistics query is active");
+            return false;
+        }
 
-        m_CommandList->setMeshletState(state);
+        if (m_PredicationEnabled)
+        {
+            error(std::string(function) + ": cannot split the command list while predication is enabled");
+            return false;
+        }
 
+        // the split resets the state of the underlying command list
         m_GraphicsStateSet = false;
         m_ComputeStateSet = false;
-        m_MeshletStateSet = true;
+        m_MeshletStateSet = false;
         m_RayTracingStateSet = false;
-        m_PushConstantsSet = false;
-        m_CurrentMeshletState = state;
+
+        return true;
     }
 
-    void CommandListWrapper::dispatchMesh(uint32_t groupsX, uint32_t groupsY /*= 1*/, uint32_t groupsZ /*= 1*/)
+    SyncPointHandle CommandListWrapper::signalSyncPoint()
     {
         if (!requireOpenState())
-            return;
-
-        if (!requireType(CommandQueue::Graphics, "dispatchMesh"))
-            return;
-
-        if (!m_MeshletStateSet)
-        {
-            error("Meshlet state is not set before a dispatchMesh call.\n"
-                "Note that setting graphics or compute state invalidates the meshlet state.");
-            return;
-        }
+            return nullptr;
 
-        if (!validatePushConstants("meshlet", "setMeshletState"))
-            return;
+        if (!validateSyncPointSplit("signalSyncPoint"))
+            return nullptr;
 
-        m_CommandList->dispatchMesh(groupsX, groupsY, groupsZ);
+        return m_CommandList->signalSyncPoint();
     }
 
-    void CommandListWrapper::beginTimerQuery(ITimerQuery* query)
+    void CommandListWrapper::waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages)
     {
         if (!requireOpenState())
             return;
 
-        m_CommandList->beginTimerQuery(query);
-    }
+        if (!syncPoint)
+        {
+            error("waitSyncPoint: syncPoint is NULL");
+            return;
+        }
 
-    void CommandListWrapper::endTimerQuery(ITimerQuery* query)
-    {
-        if (!requireOpenState())
+        if (waitStages == PipelineStages::None)
+        {
+            error("waitSyncPoint: waitStages is None, nothing would wait for the sync point");
             return;
+        }
 
-        m_CommandList->endTimerQuery(query);
+        if (!validateSyncPointSplit("waitSyncPoint"))
+            return;
+
+        m_CommandList->waitSyncPoint(syncPoint, waitStages);
     }
 
     void CommandListWrapper::beginMarker(const char *name)
     {
-        if (!requireOpenState())
+        if (!requireOpenState(true))
             return;
 
         m_CommandList->beginMarker(name);
@@ -944,7 +2174,7 @@ namespace nvrhi::validation
 
     void CommandListWrapper::endMarker()
     {
-        if (!requireOpenState())
+        if (!requireOpenState(true))
             return;
 
         m_CommandList->endMarker();
@@ -1033,6 +2263,10 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (m_CommandList->getDesc().reusable)
+            warning("setPermanentTextureState: the permanent state of a resource set in a reusable command list only takes effect "
+                "when the list is executed for the first time");
+
         m_CommandList->setPermanentTextureState(texture, stateBits);
     }
 
@@ -1041,9 +2275,43 @@ namespace nvrhi::validation
         if (!requireOpenState())
             return;
 
+        if (m_CommandList->getDesc().reusable)
+            warning("setPermanentBufferState: the permanent state of a resource set in a reusable command list only takes effect "
+                "when the list is executed for the first time");
+
         m_CommandList->setPermanentBufferState(buffer, stateBits);
     }
 
+    void CommandListWrapper::beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->beginTextureStateTransition(texture, subresources, stateBits);
+    }
+
+    void CommandListWrapper::beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits)
+    {
+        if (!requireOpenState())
+            return;
+
+        m_CommandList->beginBufferStateTransition(buffer, stateBits);
+    }
+
+    void CommandListWrapper::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!resourceAfter)
+        {
+            error("aliasingBarrier: resourceAfter is NULL");
+            return;
+        }
+
+        m_CommandList->aliasingBarrier(resourceBefore, resourceAfter);
+    }
+
     void CommandListWrapper::commitBarriers()
     {
         if (!requireOpenState())
@@ -1092,6 +2360,11 @@ namespace nvrhi::validation
         return m_CommandList->getDesc();
     }
 
+    MemoryStatistics CommandListWrapper::getMemoryStatistics()
+    {
+        return m_CommandList->getMemoryStatistics();
+    }
+
     void CommandListWrapper::setRayTracingState(const rt::State& state)
     {
         if (!requireOpenState())
@@ -1155,6 +2428,68 @@ namespace nvrhi::validation
         m_CommandList->buildOpacityMicromap(omm, desc);
     }
 
+    void CommandListWrapper::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildOpacityMicromaps"))
+            return;
+
+        if (numBuilds > 0 && !builds)
+        {
+            error("buildOpacityMicromaps: builds is NULL");
+            return;
+        }
+
+        std::unordered_set<rt::IOpacityMicromap*> opacityMicromaps;
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            const rt::OpacityMicromapBuildDesc& build = builds[buildIndex];
+
+            if (!build.opacityMicromap)
+            {
+                std::stringstream ss;
+                ss << "buildOpacityMicromaps: build " << buildIndex << " has a NULL opacity micromap";
+                error(ss.str());
+                return;
+            }
+
+            if (!opacityMicromaps.insert(build.opacityMicromap).second)
+            {
+                std::stringstream ss;
+                ss << "buildOpacityMicromaps: OMM " << utils::DebugNameToString(build.opacityMicromap->getDesc().debugName)
+                    << " is built more than once in the same call";
+                error(ss.str());
+                return;
+            }
+
+            const rt::OpacityMicromapDesc& desc = build.desc ? *build.desc : build.opacityMicromap->getDesc();
+            if (!desc.inputBuffer || !desc.perOmmDescs)
+            {
+                std::stringstream ss;
+                ss << "buildOpacityMicromaps: OMM " << utils::DebugNameToString(build.opacityMicromap->getDesc().debugName)
+                    << " is built without " << (desc.inputBuffer ? "perOmmDescs" : "inputBuffer");
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_CommandList->buildOpacityMicromaps(builds, numBuilds);
+    }
+
+    void CommandListWrapper::compactOpacityMicromaps()
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "compactOpacityMicromaps"))
+            return;
+
+        m_CommandList->compactOpacityMicromaps();
+    }
+
     void CommandListWrapper::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
     {
         if (!requireOpenState())
@@ -1170,373 +2505,445 @@ namespace nvrhi::validation
         {
             underlyingAS = wrapper->getUnderlyingObject();
 
-            if (wrapper->isTopLevel)
+            if (!validateBuildBottomLevelAccelStruct(wrapper, pGeometries, numGeometries, buildFlags))
+                return;
+
+            wrapper->wasBuilt = true;
+            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+        }
+
+        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+    }
+
+    void CommandListWrapper::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "buildBottomLevelAccelStructs"))
+            return;
+
+        if (numBuilds > 0 && !builds)
+        {
+            error("buildBottomLevelAccelStructs: builds is NULL");
+            return;
+        }
+
+        std::vector<rt::BlasBuildDesc> underlyingBuilds(builds, builds + numBuilds);
+        std::unordered_set<rt::IAccelStruct*> accelStructs;
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+
+            if (!build.accelStruct)
             {
-                error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
+                std::stringstream ss;
+                ss << "buildBottomLevelAccelStructs: build " << buildIndex << " has a NULL acceleration structure";
+                error(ss.str());
                 return;
             }
-            
-            for (size_t i = 0; i < numGeometries; i++)
+
+            if (!accelStructs.insert(build.accelStruct).second)
             {
-                const auto& geom = pGeometries[i];
+                std::stringstream ss;
+                ss << "buildBottomLevelAccelStructs: BLAS " << utils::DebugNameToString(build.accelStruct->getDesc().debugName)
+                    << " is built more than once in the same call";
+                error(ss.str());
+                return;
+            }
 
-                if (geom.geometryType == rt::GeometryType::Triangles)
-                {
-                    const auto& triangles = geom.geometryData.triangles;
+            AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct);
+            if (wrapper)
+            {
+                underlyingBuilds[buildIndex].accelStruct = wrapper->getUnderlyingObject();
 
-                    if (triangles.indexFormat != Format::UNKNOWN)
-                    {
-                        switch (triangles.indexFormat)  // NOLINT(clang-diagnostic-switch-enum)
-                        {
-                        case Format::R8_UINT:
-                            if (m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN)
-                            {
-                                std::stringstream ss;
-                                ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                    << " has index format R8_UINT which is only supported on Vulkan";
-                                error(ss.str());
-                                return;
-                            }
-                            break;
-                        case Format::R16_UINT:
-                        case Format::R32_UINT:
-                            break;
-                        default: {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has unsupported index format: " << utils::FormatToString(triangles.indexFormat);
-                            error(ss.str());
-                            return;
-                        }
-                        }
+                if (!validateBuildBottomLevelAccelStruct(wrapper, build.geometries, build.numGeometries, build.buildFlags))
+                    return;
+            }
+        }
 
-                        if (triangles.indexBuffer == nullptr)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has a NULL index buffer but indexFormat is " << utils::FormatToString(triangles.indexFormat);
-                            error(ss.str());
-                            return;
-                        }
+        // All builds are valid, none of them will be skipped
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            const rt::BlasBuildDesc& build = builds[buildIndex];
 
-                        const BufferDesc& indexBufferDesc = triangles.indexBuffer->getDesc();
-                        if (!indexBufferDesc.isAccelStructBuildInput)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has index buffer = " << utils::DebugNameToString(indexBufferDesc.debugName)
-                                << " which does not have the isAccelStructBuildInput flag set";
-                            error(ss.str());
-                            return;
-                        }
+            AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(build.accelStruct);
+            if (wrapper)
+            {
+                wrapper->wasBuilt = true;
+                wrapper->buildGeometries.assign(build.geometries, build.geometries + build.numGeometries);
+            }
+        }
 
-                        const size_t indexSize = triangles.indexCount * getFormatInfo(triangles.indexFormat).bytesPerBlock;
-                        if (triangles.indexOffset + indexSize > indexBufferDesc.byteSize)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " points at " << indexSize << " bytes of index data at offset " << triangles.indexOffset
-                                << " in buffer " << utils::DebugNameToString(indexBufferDesc.debugName) << " whose size is " << indexBufferDesc.byteSize
-                                << ", which will result in a buffer overrun";
-                            error(ss.str());
-                            return;
-                        }
+        m_CommandList->buildBottomLevelAccelStructs(underlyingBuilds.data(), underlyingBuilds.size());
+    }
+
+    bool CommandListWrapper::validateBuildBottomLevelAccelStruct(AccelStructWrapper* wrapper, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) const
+    {
+        if (wrapper->isTopLevel)
+        {
+            error("Cannot perform buildBottomLevelAccelStruct on a top-level AS");
+            return false;
+        }
+        
+        for (size_t i = 0; i < numGeometries; i++)
+        {
+            const auto& geom = pGeometries[i];
 
-                        if ((triangles.indexCount % 3) != 0)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexCount = " << triangles.indexCount
-                                << ", which is not a multiple of 3";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                    else
-                    {
-                        if (triangles.indexCount != 0 || triangles.indexBuffer != nullptr)
-                        {
-                            std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexFormat = UNKNOWN but nonzero indexCount = " << triangles.indexCount;
-                            error(ss.str());
-                            return;
-                        }
+            if (geom.geometryType == rt::GeometryType::Triangles)
+            {
+                const auto& triangles = geom.geometryData.triangles;
 
-                        if (triangles.indexBuffer != nullptr)
+                if (triangles.indexFormat != Format::UNKNOWN)
+                {
+                    switch (triangles.indexFormat)  // NOLINT(clang-diagnostic-switch-enum)
+                    {
+                    case Format::R8_UINT:
+                        if (m_Device->getGraphicsAPI() != GraphicsAPI::VULKAN)
                         {
                             std::stringstream ss;
-                            ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                                << " has indexFormat = UNKNOWN but non-NULL indexBuffer = "
-                                << utils::DebugNameToString(triangles.indexBuffer->getDesc().debugName);
+                            ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                                << " has index format R8_UINT which is only supported on Vulkan";
                             error(ss.str());
-                            return;
+                            return false;
                         }
-                    }
-
-                    switch (triangles.vertexFormat)  // NOLINT(clang-diagnostic-switch-enum)
-                    {
-                    case Format::RG32_FLOAT:
-                    case Format::RGB32_FLOAT:
-                    case Format::RGBA32_FLOAT:
-                    case Format::RG16_FLOAT:
-                    case Format::RGBA16_FLOAT:
-                    case Format::RG16_SNORM:
-                    case Format::RGBA16_SNORM:
-                    case Format::RGBA16_UNORM:
-                    case Format::RG16_UNORM:
-                    case Format::R10G10B10A2_UNORM:
-                    case Format::RGBA8_UNORM:
-                    case Format::RG8_UNORM:
-                    case Format::RGBA8_SNORM:
-                    case Format::RG8_SNORM:
+                        break;
+                    case Format::R16_UINT:
+                    case Format::R32_UINT:
                         break;
                     default: {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has unsupported vertex format: " << utils::FormatToString(triangles.vertexFormat);
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has unsupported index format: " << utils::FormatToString(triangles.indexFormat);
                         error(ss.str());
-                        return;
-                    }
+                        return false;
                     }
-
-                    if (triangles.vertexBuffer == nullptr)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL vertex buffer";
-                        error(ss.str());
-                        return;
                     }
 
-                    if (triangles.vertexStride == 0)
+                    if (triangles.indexBuffer == nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has vertexStride = 0";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has a NULL index buffer but indexFormat is " << utils::FormatToString(triangles.indexFormat);
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    if ((triangles.indexFormat == Format::UNKNOWN) && (triangles.vertexCount % 3) != 0)
+                    const BufferDesc& indexBufferDesc = triangles.indexBuffer->getDesc();
+                    if (!indexBufferDesc.isAccelStructBuildInput)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has indexFormat = UNKNOWN and vertexCount = " << triangles.vertexCount
-                            << ", which is not a multiple of 3";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has index buffer = " << utils::DebugNameToString(indexBufferDesc.debugName)
+                            << " which does not have the isAccelStructBuildInput flag set";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const BufferDesc& vertexBufferDesc = triangles.vertexBuffer->getDesc();
-                    if (!vertexBufferDesc.isAccelStructBuildInput)
+                    const size_t indexSize = triangles.indexCount * getFormatInfo(triangles.indexFormat).bytesPerBlock;
+                    if (triangles.indexOffset + indexSize > indexBufferDesc.byteSize)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has vertex buffer = " << utils::DebugNameToString(vertexBufferDesc.debugName)
-                            << " which does not have the isAccelStructBuildInput flag set";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " points at " << indexSize << " bytes of index data at offset " << triangles.indexOffset
+                            << " in buffer " << utils::DebugNameToString(indexBufferDesc.debugName) << " whose size is " << indexBufferDesc.byteSize
+                            << ", which will result in a buffer overrun";
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const size_t vertexDataSize = triangles.vertexCount * triangles.vertexStride;
-                    if (triangles.vertexOffset + vertexDataSize > vertexBufferDesc.byteSize)
+                    if ((triangles.indexCount % 3) != 0)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " points at " << vertexDataSize << " bytes of vertex data at offset " << triangles.vertexOffset
-                            << " in buffer " << utils::DebugNameToString(vertexBufferDesc.debugName) << " whose size is " << vertexBufferDesc.byteSize
-                            << ", which will result in a buffer overrun";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexCount = " << triangles.indexCount
+                            << ", which is not a multiple of 3";
                         error(ss.str());
-                        return;
+                        return false;
                     }
                 }
-                else if (geom.geometryType == rt::GeometryType::AABBs)
+                else
                 {
-                    const auto& aabbs = geom.geometryData.aabbs;
-
-                    if (aabbs.buffer== nullptr)
+                    if (triangles.indexCount != 0 || triangles.indexBuffer != nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL AABB data buffer";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexFormat = UNKNOWN but nonzero indexCount = " << triangles.indexCount;
                         error(ss.str());
-                        return;
+                        return false;
                     }
 
-                    const BufferDesc& aabbBufferDesc = aabbs.buffer->getDesc();
-                    if (!aabbBufferDesc.isAccelStructBuildInput)
+                    if (triangles.indexBuffer != nullptr)
                     {
                         std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has AABB data buffer = " << utils::DebugNameToString(aabbBufferDesc.debugName)
-                            << " which does not have the isAccelStructBuildInput flag set";
+                        ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                            << " has indexFormat = UNKNOWN but non-NULL indexBuffer = "
+                            << utils::DebugNameToString(triangles.indexBuffer->getDesc().debugName);
                         error(ss.str());
-                        return;
+                        return false;
                     }
+                }
 
-                    if (aabbs.count > 1 && aabbs.stride < sizeof(rt::GeometryAABB))
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has AABB stride = " << aabbs.stride
-                            << " which is less than the size of one AABB (" << sizeof(rt::GeometryAABB) << " bytes)";
-                        error(ss.str());
-                        return;
-                    }
+                switch (triangles.vertexFormat)  // NOLINT(clang-diagnostic-switch-enum)
+                {
+                case Format::RG32_FLOAT:
+                case Format::RGB32_FLOAT:
+                case Format::RGBA32_FLOAT:
+                case Format::RG16_FLOAT:
+                case Format::RGBA16_FLOAT:
+                case Format::RG16_SNORM:
+                case Format::RGBA16_SNORM:
+                case Format::RGBA16_UNORM:
+                case Format::RG16_UNORM:
+                case Format::R10G10B10A2_UNORM:
+                case Format::RGBA8_UNORM:
+                case Format::RG8_UNORM:
+                case Format::RGBA8_SNORM:
+                case Format::RG8_SNORM:
+                    break;
+                default: {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has unsupported vertex format: " << utils::FormatToString(triangles.vertexFormat);
+                    error(ss.str());
+                    return false;
+                }
+                }
 
-                    const size_t aabbDataSize = aabbs.count * aabbs.stride;
-                    if (aabbs.offset + aabbDataSize > aabbBufferDesc.byteSize)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " points at " << aabbDataSize << " bytes of AABB data at offset " << aabbs.offset
-                            << " in buffer " << utils::DebugNameToString(aabbBufferDesc.debugName) << " whose size is " << aabbBufferDesc.byteSize
-                            << ", which will result in a buffer overrun";
-                        error(ss.str());
-                        return;
-                    }
+                if (triangles.vertexBuffer == nullptr)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL vertex buffer";
+                    error(ss.str());
+                    return false;
+                }
 
-                    if (geom.useTransform)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " is of type AABB but has useTransform = true, "
-                            "which is unsupported, and the transform will be ignored";
-                        m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
-                    }
+                if (triangles.vertexStride == 0)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has vertexStride = 0";
+                    error(ss.str());
+                    return false;
                 }
-                else if (geom.geometryType == rt::GeometryType::Spheres)
+
+                if ((triangles.indexFormat == Format::UNKNOWN) && (triangles.vertexCount % 3) != 0)
                 {
-                    const auto& spheres = geom.geometryData.spheres;
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has indexFormat = UNKNOWN and vertexCount = " << triangles.vertexCount
+                        << ", which is not a multiple of 3";
+                    error(ss.str());
+                    return false;
+                }
 
-                    if (spheres.vertexBuffer == nullptr)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL vertex buffer";
-                        error(ss.str());
-                        return;
-                    }
+                const BufferDesc& vertexBufferDesc = triangles.vertexBuffer->getDesc();
+                if (!vertexBufferDesc.isAccelStructBuildInput)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has vertex buffer = " << utils::DebugNameToString(vertexBufferDesc.debugName)
+                        << " which does not have the isAccelStructBuildInput flag set";
+                    error(ss.str());
+                    return false;
+                }
 
-                    // TODO: Add more validation
+                const size_t vertexDataSize = triangles.vertexCount * triangles.vertexStride;
+                if (triangles.vertexOffset + vertexDataSize > vertexBufferDesc.byteSize)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " points at " << vertexDataSize << " bytes of vertex data at offset " << triangles.vertexOffset
+                        << " in buffer " << utils::DebugNameToString(vertexBufferDesc.debugName) << " whose size is " << vertexBufferDesc.byteSize
+                        << ", which will result in a buffer overrun";
+                    error(ss.str());
+                    return false;
                 }
-                else if (geom.geometryType == rt::GeometryType::Lss)
+            }
+            else if (geom.geometryType == rt::GeometryType::AABBs)
+            {
+                const auto& aabbs = geom.geometryData.aabbs;
+
+                if (aabbs.buffer== nullptr)
                 {
-                    const auto& lss = geom.geometryData.lss;
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL AABB data buffer";
+                    error(ss.str());
+                    return false;
+                }
 
-                    if (lss.vertexBuffer == nullptr)
-                    {
-                        std::stringstream ss;
-                        ss << "BLAS " << utils::DebugNameToString(as->getDesc().debugName) << " build geometry " << i
-                            << " has NULL vertex buffer";
-                        error(ss.str());
-                        return;
-                    }
+                const BufferDesc& aabbBufferDesc = aabbs.buffer->getDesc();
+                if (!aabbBufferDesc.isAccelStructBuildInput)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has AABB data buffer = " << utils::DebugNameToString(aabbBufferDesc.debugName)
+                        << " which does not have the isAccelStructBuildInput flag set";
+                    error(ss.str());
+                    return false;
+                }
 
-                    // TODO: Add more validation
+                if (aabbs.count > 1 && aabbs.stride < sizeof(rt::GeometryAABB))
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has AABB stride = " << aabbs.stride
+                        << " which is less than the size of one AABB (" << sizeof(rt::GeometryAABB) << " bytes)";
+                    error(ss.str());
+                    return false;
+                }
+
+                const size_t aabbDataSize = aabbs.count * aabbs.stride;
+                if (aabbs.offset + aabbDataSize > aabbBufferDesc.byteSize)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " points at " << aabbDataSize << " bytes of AABB data at offset " << aabbs.offset
+                        << " in buffer " << utils::DebugNameToString(aabbBufferDesc.debugName) << " whose size is " << aabbBufferDesc.byteSize
+                        << ", which will result in a buffer overrun";
+                    error(ss.str());
+                    return false;
                 }
-            }
 
-            if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+                if (geom.useTransform)
+                {
+                    std::stringstream ss;
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " is of type AABB but has useTransform = true, "
+                        "which is unsupported, and the transform will be ignored";
+                    m_MessageCallback->message(MessageSeverity::Warning, ss.str().c_str());
+                }
+            }
+            else if (geom.geometryType == rt::GeometryType::Spheres)
             {
-                if (!wrapper->allowUpdate)
+                const auto& spheres = geom.geometryData.spheres;
+
+                if (spheres.vertexBuffer == nullptr)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " that was not created with the AllowUpdate flag";
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL vertex buffer";
                     error(ss.str());
-                    return;
+                    return false;
                 }
 
-                if (!wrapper->wasBuilt)
+                // TODO: Add more validation
+            }
+            else if (geom.geometryType == rt::GeometryType::Lss)
+            {
+                const auto& lss = geom.geometryData.lss;
+
+                if (lss.vertexBuffer == nullptr)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " before the same BLAS was initially built";
+                    ss << "BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName) << " build geometry " << i
+                        << " has NULL vertex buffer";
                     error(ss.str());
-                    return;
+                    return false;
                 }
 
-                if (numGeometries != wrapper->buildGeometries.size())
+                // TODO: Add more validation
+            }
+        }
+
+        if ((buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0)
+        {
+            if (!wrapper->allowUpdate)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " that was not created with the AllowUpdate flag";
+                error(ss.str());
+                return false;
+            }
+
+            if (!wrapper->wasBuilt)
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " before the same BLAS was initially built";
+                error(ss.str());
+                return false;
+            }
+
+            if (numGeometries != wrapper->buildGeometries.size())
+            {
+                std::stringstream ss;
+                ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                    << " with " << numGeometries << " geometries "
+                    "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
+                error(ss.str());
+                return false;
+            }
+            
+            for (size_t i = 0; i < numGeometries; i++)
+            {
+                const auto& before = wrapper->buildGeometries[i];
+                const auto& after = pGeometries[i];
+
+                if (before.geometryType != after.geometryType)
                 {
                     std::stringstream ss;
-                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                        << " with " << numGeometries << " geometries "
-                        "when this BLAS was built with " << wrapper->buildGeometries.size() << " geometries";
+                    ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                        << " with mismatching geometry types in slot " << i;
                     error(ss.str());
-                    return;
+                    return false;
                 }
-                
-                for (size_t i = 0; i < numGeometries; i++)
+
+                if (before.geometryType == rt::GeometryType::Triangles)
                 {
-                    const auto& before = wrapper->buildGeometries[i];
-                    const auto& after = pGeometries[i];
+                    uint32_t primitivesBefore = (before.geometryData.triangles.vertexFormat == Format::UNKNOWN)
+                        ? before.geometryData.triangles.vertexCount
+                        : before.geometryData.triangles.indexCount;
+
+                    uint32_t primitivesAfter = (after.geometryData.triangles.vertexFormat == Format::UNKNOWN)
+                        ? after.geometryData.triangles.vertexCount
+                        : after.geometryData.triangles.indexCount;
 
-                    if (before.geometryType != after.geometryType)
+                    primitivesBefore /= 3;
+                    primitivesAfter /= 3;
+
+                    if (primitivesBefore != primitivesAfter)
                     {
                         std::stringstream ss;
-                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                            << " with mismatching geometry types in slot " << i;
+                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                            << " with mismatching triangle counts in geometry slot " << i << ": "
+                            "built with " << primitivesBefore << " triangles, updating with " << primitivesAfter << " triangles";
                         error(ss.str());
-                        return;
+                        return false;
                     }
+                }
+                else // AABBs
+                {
+                    uint32_t aabbsBefore = before.geometryData.aabbs.count;
+                    uint32_t aabbsAfter = after.geometryData.aabbs.count;
 
-                    if (before.geometryType == rt::GeometryType::Triangles)
-                    {
-                        uint32_t primitivesBefore = (before.geometryData.triangles.vertexFormat == Format::UNKNOWN)
-                            ? before.geometryData.triangles.vertexCount
-                            : before.geometryData.triangles.indexCount;
-
-                        uint32_t primitivesAfter = (after.geometryData.triangles.vertexFormat == Format::UNKNOWN)
-                            ? after.geometryData.triangles.vertexCount
-                            : after.geometryData.triangles.indexCount;
-
-                        primitivesBefore /= 3;
-                        primitivesAfter /= 3;
-
-                        if (primitivesBefore != primitivesAfter)
-                        {
-                            std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                                << " with mismatching triangle counts in geometry slot " << i << ": "
-                                "built with " << primitivesBefore << " triangles, updating with " << primitivesAfter << " triangles";
-                            error(ss.str());
-                            return;
-                        }
-                    }
-                    else // AABBs
+                    if (aabbsBefore != aabbsAfter)
                     {
-                        uint32_t aabbsBefore = before.geometryData.aabbs.count;
-                        uint32_t aabbsAfter = after.geometryData.aabbs.count;
-
-                        if (aabbsBefore != aabbsAfter)
-                        {
-                            std::stringstream ss;
-                            ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                                << " with mismatching AABB counts in geometry slot " << i << ": "
-                                "built with " << aabbsBefore << " AABBs, updating with " << aabbsAfter << " AABBs";
-                            error(ss.str());
-                            return;
-                        }
+                        std::stringstream ss;
+                        ss << "Cannot perform an update on BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                            << " with mismatching AABB counts in geometry slot " << i << ": "
+                            "built with " << aabbsBefore << " AABBs, updating with " << aabbsAfter << " AABBs";
+                        error(ss.str());
+                        return false;
                     }
                 }
             }
+        }
 
-            if (wrapper->allowCompaction && wrapper->wasBuilt)
-            {
-                std::stringstream ss;
-                ss << "Cannot rebuild BLAS " << utils::DebugNameToString(as->getDesc().debugName)
-                    << " that has the AllowCompaction flag set";
-                error(ss.str());
-                return;
-            }
-
-            wrapper->wasBuilt = true;
-            wrapper->buildGeometries.assign(pGeometries, pGeometries + numGeometries);
+        if (wrapper->allowCompaction && wrapper->wasBuilt)
+        {
+            std::stringstream ss;
+            ss << "Cannot rebuild BLAS " << utils::DebugNameToString(wrapper->getDesc().debugName)
+                << " that has the AllowCompaction flag set";
+            error(ss.str());
+            return false;
         }
 
-        m_CommandList->buildBottomLevelAccelStruct(underlyingAS, pGeometries, numGeometries, buildFlags);
+        return true;
     }
 
     bool CommandListWrapper::validateBuildTopLevelAccelStruct(AccelStructWrapper* wrapper, size_t numInstances, rt::AccelStructBuildFlags buildFlags) const
@@ -1742,6 +3149,77 @@ namespace nvrhi::validation
         m_CommandList->buildTopLevelAccelStructFromBuffer(underlyingAS, instanceBuffer, instanceBufferOffset, numInstances, buildFlags);
     }
 
+    void CommandListWrapper::updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "updateTopLevelAccelStructInstances"))
+            return;
+
+        if (!as)
+        {
+            error("updateTopLevelAccelStructInstances: 'as' is NULL");
+            return;
+        }
+
+        if (numInstances != 0 && !pInstances)
+        {
+            error("updateTopLevelAccelStructInstances: 'pInstances' is NULL");
+            return;
+        }
+
+        const rt::AccelStructDesc& asDesc = as->getDesc();
+
+        if (!asDesc.isTopLevel || !as->getInstanceBuffer())
+        {
+            std::stringstream ss;
+            ss << "Cannot perform updateTopLevelAccelStructInstances on AccelStruct " << utils::DebugNameToString(asDesc.debugName)
+                << " that is not a TLAS created with the createInstanceBuffer flag";
+            error(ss.str());
+            return;
+        }
+
+        if (firstInstance + numInstances > asDesc.topLevelMaxInstances)
+        {
+            std::stringstream ss;
+            ss << "Cannot write instances [" << firstInstance << ", " << firstInstance + numInstances << ") into TLAS "
+                << utils::DebugNameToString(asDesc.debugName) << " which has topLevelMaxInstances = " << asDesc.topLevelMaxInstances;
+            error(ss.str());
+            return;
+        }
+
+        std::vector<rt::InstanceDesc> patchedInstances;
+        patchedInstances.assign(pInstances, pInstances + numInstances);
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            rt::InstanceDesc& instance = patchedInstances[i];
+            if (!instance.bottomLevelAS)
+                continue;
+
+            AccelStructWrapper* blasWrapper = dynamic_cast<AccelStructWrapper*>(instance.bottomLevelAS);
+            if (blasWrapper && blasWrapper->isTopLevel)
+            {
+                std::stringstream ss;
+                ss << "TLAS " << utils::DebugNameToString(asDesc.debugName) << " instance " << firstInstance + i
+                    << " refers to another TLAS, which is unsupported";
+                error(ss.str());
+                return;
+            }
+
+            instance.bottomLevelAS = checked_cast<rt::IAccelStruct*>(unwrapResource(instance.bottomLevelAS));
+        }
+
+        rt::IAccelStruct* underlyingAS = as;
+
+        AccelStructWrapper* wrapper = dynamic_cast<AccelStructWrapper*>(as);
+        if (wrapper)
+            underlyingAS = wrapper->getUnderlyingObject();
+
+        m_CommandList->updateTopLevelAccelStructInstances(underlyingAS, firstInstance, patchedInstances.data(), numInstances);
+    }
+
     void CommandListWrapper::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
         if (!requireOpenState())
@@ -1771,6 +3249,30 @@ namespace nvrhi::validation
             return;
         }
 
+        if (desc.scratchBuffer)
+        {
+            const BufferDesc& scratchDesc = desc.scratchBuffer->getDesc();
+
+            if (!scratchDesc.canHaveUAVs)
+            {
+                std::stringstream ss;
+                ss << "executeMultiIndirectClusterOperation: 'scratchBuffer' " << utils::DebugNameToString(scratchDesc.debugName)
+                    << " must be created with canHaveUAVs = true";
+                error(ss.str());
+                return;
+            }
+
+            if (desc.scratchOffsetInBytes % 256 != 0 || desc.scratchOffsetInBytes + desc.scratchSizeInBytes > scratchDesc.byteSize)
+            {
+                std::stringstream ss;
+                ss << "executeMultiIndirectClusterOperation: the scratch range at offset " << desc.scratchOffsetInBytes
+                    << " with size " << desc.scratchSizeInBytes << " is misaligned or doesn't fit into 'scratchBuffer' "
+                    << utils::DebugNameToString(scratchDesc.debugName) << " of size " << scratchDesc.byteSize;
+                error(ss.str());
+                return;
+            }
+        }
+
         if (desc.params.mode == rt::cluster::OperationMode::ImplicitDestinations)
         {
             if (desc.inOutAddressesBuffer == nullptr)
@@ -1806,6 +3308,12 @@ namespace nvrhi::validation
 
     void CommandListWrapper::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
     {
+        if (!requireOpenState())
+            return;
+
+        if (!requireType(CommandQueue::Compute, "convertCoopVecMatrices"))
+            return;
+
         if (!m_Device->queryFeatureSupport(Feature::CooperativeVectorInferencing))
         {
             error("convertCoopVecMatrices: Cooperative Vectors are not supported by the device");
@@ -25,6 +25,7 @@
 #include <nvrhi/utils.h>
 #include <nvrhi/common/misc.h>
 
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi::validation
@@ -59,13 +60,19 @@ namespace nvrhi::validation
 
     DeviceHandle createValidationLayer(IDevice* underlyingDevice)
     {
-        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice);
+        return createValidationLayer(underlyingDevice, ValidationLayerDesc());
+    }
+
+    DeviceHandle createValidationLayer(IDevice* underlyingDevice, const ValidationLayerDesc& desc)
+    {
+        DeviceWrapper* wrapper = new DeviceWrapper(underlyingDevice, desc);
         return DeviceHandle::Create(wrapper);
     }
 
-    DeviceWrapper::DeviceWrapper(IDevice* device)
+    DeviceWrapper::DeviceWrapper(IDevice* device, const ValidationLayerDesc& desc)
         : m_Device(device)
         , m_MessageCallback(device->getMessageCallback())
+        , m_Desc(desc)
     {
 
     }
@@ -258,6 +265,26 @@ namespace nvrhi::validation
             error(ss.str());
             anyErrors = true;
         }
+
+        if (d.isTransientAttachment)
+        {
+            if (!d.isRenderTarget || d.isShaderResource || d.isUAV || d.isShadingRateSurface)
+            {
+                std::stringstream ss;
+                ss << dimensionStr << " " << debugName << ": transient attachments must be created with isRenderTarget = true "
+                    "and isShaderResource = isUAV = isShadingRateSurface = false";
+                error(ss.str());
+                anyErrors = true;
+            }
+
+            if (d.isVirtual || d.isTiled || d.sharedResourceFlags != SharedResourceFlags::None)
+            {
+                std::stringstream ss;
+                ss << dimensionStr << " " << debugName << ": transient attachments cannot be virtual, tiled or shared";
+                error(ss.str());
+                anyErrors = true;
+            }
+        }
         
         if(anyErrors)
             return nullptr;
@@ -279,6 +306,67 @@ namespace nvrhi::validation
         m_Device->updateTextureTileMappings(texture, tileMappings, numTileMappings, executionQueue);
     }
 
+    void DeviceWrapper::updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        if (!buffer)
+        {
+            error("updateBufferTileMappings: buffer is NULL");
+            return;
+        }
+
+        const BufferDesc& desc = buffer->getDesc();
+        if (!desc.isTiled)
+        {
+            std::stringstream ss;
+            ss << "updateBufferTileMappings: buffer " << utils::DebugNameToString(desc.debugName) << " was not created with isTiled = true";
+            error(ss.str());
+            return;
+        }
+
+        if (numTileMappings > 0 && !tileMappings)
+        {
+            error("updateBufferTileMappings: tileMappings is NULL");
+            return;
+        }
+
+        const uint64_t mappableSize = align(desc.byteSize, uint64_t(c_TiledBufferTileSize));
+
+        for (uint32_t i = 0; i < numTileMappings; i++)
+        {
+            const BufferTilesMapping& mapping = tileMappings[i];
+
+            if (mapping.bufferOffset % c_TiledBufferTileSize != 0 || mapping.byteSize % c_TiledBufferTileSize != 0 ||
+                mapping.heapOffset % c_TiledBufferTileSize != 0)
+            {
+                std::stringstream ss;
+                ss << "updateBufferTileMappings: the offsets and size of mapping " << i << " for buffer "
+                    << utils::DebugNameToString(desc.debugName) << " are not multiples of " << c_TiledBufferTileSize << " bytes";
+                error(ss.str());
+                return;
+            }
+
+            if (mapping.bufferOffset + mapping.byteSize > mappableSize)
+            {
+                std::stringstream ss;
+                ss << "updateBufferTileMappings: mapping " << i << " (offset " << mapping.bufferOffset << ", size " << mapping.byteSize
+                    << ") is out of bounds of buffer " << utils::DebugNameToString(desc.debugName) << " (" << desc.byteSize << " bytes)";
+                error(ss.str());
+                return;
+            }
+
+            if (mapping.heap && mapping.heapOffset + mapping.byteSize > mapping.heap->getDesc().capacity)
+            {
+                std::stringstream ss;
+                ss << "updateBufferTileMappings: mapping " << i << " for buffer " << utils::DebugNameToString(desc.debugName)
+                    << " is out of bounds of heap " << utils::DebugNameToString(mapping.heap->getDesc().debugName);
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_Device->updateBufferTileMappings(buffer, tileMappings, numTileMappings, executionQueue);
+    }
+
     SamplerFeedbackTextureHandle DeviceWrapper::createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc)
     {
         const GraphicsAPI graphicsApi = m_Device->getGraphicsAPI();
@@ -464,6 +552,23 @@ namespace nvrhi::validation
             return nullptr;
         }
 
+        if (d.isTiled)
+        {
+            if (m_Device->getGraphicsAPI() == GraphicsAPI::D3D11)
+            {
+                error("Tiled buffers are not supported on DX11");
+                return nullptr;
+            }
+
+            if (d.isVolatile || d.isVirtual || d.cpuAccess != CpuAccessMode::None || d.sharedResourceFlags != SharedResourceFlags::None)
+            {
+                std::stringstream ss;
+                ss << "Tiled buffer " << patchedDesc.debugName << " cannot be volatile, virtual, shared or have CPU access";
+                error(ss.str());
+                return nullptr;
+            }
+        }
+
         if (d.keepInitialState && d.initialState == ResourceStates::Unknown)
         {
             std::stringstream ss;
@@ -480,6 +585,11 @@ namespace nvrhi::validation
         return m_Device->mapBuffer(b, mapFlags);
     }
 
+    void * DeviceWrapper::mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags)
+    {
+        return m_Device->mapBuffer(b, mapFlags, flags);
+    }
+
     void DeviceWrapper::unmapBuffer(IBuffer* b)
     {
         m_Device->unmapBuffer(b);
@@ -659,6 +769,115 @@ namespace nvrhi::validation
         return m_Device->resetTimerQuery(query);
     }
 
+    OcclusionQueryHandle DeviceWrapper::createOcclusionQuery(OcclusionQueryType type)
+    {
+        return m_Device->createOcclusionQuery(type);
+    }
+
+    bool DeviceWrapper::pollOcclusionQuery(IOcclusionQuery* query)
+    {
+        return m_Device->pollOcclusionQuery(query);
+    }
+
+    uint64_t DeviceWrapper::getOcclusionQueryResult(IOcclusionQuery* query)
+    {
+        return m_Device->getOcclusionQueryResult(query);
+    }
+
+    void DeviceWrapper::resetOcclusionQuery(IOcclusionQuery* query)
+    {
+        m_Device->resetOcclusionQuery(query);
+    }
+
+    PipelineStatisticsQueryHandle DeviceWrapper::createPipelineStatisticsQuery()
+    {
+        if (!m_Device->queryFeatureSupport(Feature::PipelineStatisticsQueries))
+        {
+            error("createPipelineStatisticsQuery: pipeline statistics queries are not supported by the device");
+            return nullptr;
+        }
+
+        return m_Device->createPipelineStatisticsQuery();
+    }
+
+    bool DeviceWrapper::pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        return m_Device->pollPipelineStatisticsQuery(query);
+    }
+
+    PipelineStatistics DeviceWrapper::getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query)
+    {
+        return m_Device->getPipelineStatisticsQueryResult(query);
+    }
+
+    void DeviceWrapper::resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query)
+    {
+        m_Device->resetPipelineStatisticsQuery(query);
+    }
+
+    TimerQueryPoolHandle DeviceWrapper::createTimerQueryPool(const TimerQueryPoolDesc& desc)
+    {
+        if (desc.maxQueriesPerFrame == 0 || desc.maxFramesInFlight == 0)
+        {
+            error("createTimerQueryPool: maxQueriesPerFrame and maxFramesInFlight must be nonzero");
+            return nullptr;
+        }
+
+        return m_Device->createTimerQueryPool(desc);
+    }
+
+    bool DeviceWrapper::getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries)
+    {
+        if (!pool)
+        {
+            error("getTimerQueryPoolResults: pool is NULL");
+            return false;
+        }
+
+        if (numQueries > pool->getDesc().maxQueriesPerFrame)
+        {
+            std::stringstream ss;
+            ss << "getTimerQueryPoolResults: numQueries (" << numQueries << ") is greater than maxQueriesPerFrame ("
+                << pool->getDesc().maxQueriesPerFrame << ") of pool '" << utils::DebugNameToString(pool->getDesc().debugName) << "'";
+            error(ss.str());
+            return false;
+        }
+
+        if (numQueries > 0 && !pTimes)
+        {
+            error("getTimerQueryPoolResults: pTimes is NULL");
+            return false;
+        }
+
+        return m_Device->getTimerQueryPoolResults(pool, frameIndex, pTimes, numQueries);
+    }
+
+    bool DeviceWrapper::getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries)
+    {
+        if (!pool)
+        {
+            error("getTimerQueryPoolTimestamps: pool is NULL");
+            return false;
+        }
+
+        if (numQueries > pool->getDesc().maxQueriesPerFrame)
+        {
+            std::stringstream ss;
+            ss << "getTimerQueryPoolTimestamps: numQueries (" << numQueries << ") is greater than maxQueriesPerFrame ("
+                << pool->getDesc().maxQueriesPerFrame << ") of pool '" << utils::DebugNameToString(pool->getDesc().debugName) << "'";
+            error(ss.str());
+            return false;
+        }
+
+        if (numQueries > 0 && !pTimestamps)
+        {
+            error("getTimerQueryPoolTimestamps: pTimestamps is NULL");
+            return false;
+        }
+
+        return m_Device->getTimerQueryPoolTimestamps(pool, frameIndex, pTimestamps, numQueries);
+    }
+
     GraphicsAPI DeviceWrapper::getGraphicsAPI()
     {
         return m_Device->getGraphicsAPI();
@@ -703,6 +922,15 @@ namespace nvrhi::validation
                 error(ss.str());
                 return nullptr;
             }
+
+            if (desc.depthAttachment.isReadOnly && (desc.depthAttachment.loadOp != AttachmentLoadOp::Load || desc.depthAttachment.storeOp != AttachmentStoreOp::Store))
+            {
+                std::stringstream ss;
+                ss << "Depth attachment texture " << utils::DebugNameToString(d.debugName)
+                    << " is read-only and must use AttachmentLoadOp::Load and AttachmentStoreOp::Store";
+                error(ss.str());
+                return nullptr;
+            }
         }
 
         for (size_t i = 0; i < desc.colorAttachments.size(); ++i)
@@ -843,6 +1071,7 @@ namespace nvrhi::validation
         case ResourceType::ConstantBuffer:
         case ResourceType::VolatileConstantBuffer:
         case ResourceType::PushConstants:
+        case ResourceType::InlineUniformBlock:
             location.type = GraphicsResourceType::CB;
             bindings.rangeCB.add(location.slot);
             if (type == ResourceType::VolatileConstantBuffer)
@@ -1104,6 +1333,7 @@ namespace nvrhi::validation
 
         int pushConstantCount = 0;
         uint32_t pushConstantSize = 0;
+        int pushDescriptorLayoutCount = 0;
         enum class RegisterSpaceIsDescriptorSet
         {
             False,
@@ -1128,6 +1358,9 @@ namespace nvrhi::validation
                     }
                 }
 
+                if (layoutDesc->usePushDescriptors)
+                    pushDescriptorLayoutCount++;
+
                 if (layoutDesc->registerSpaceIsDescriptorSet)
                 {
                     if (layoutDesc->registerSpace >= c_MaxBindingLayouts)
@@ -1192,6 +1425,14 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (pushDescriptorLayoutCount > 1 && m_Device->getGraphicsAPI() == GraphicsAPI::VULKAN)
+        {
+            std::stringstream errorStream;
+            errorStream << "Pipeline contains more than one (" << pushDescriptorLayoutCount << ") binding layouts with usePushDescriptors";
+            error(errorStream.str());
+            anyErrors = true;
+        }
+
         return !anyErrors;
     }
 
@@ -1230,7 +1471,7 @@ namespace nvrhi::validation
         return true;
     }
 
-    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo)
+    bool DeviceWrapper::validateGraphicsPipelineDesc(const GraphicsPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo, const char* function) const
     {
         std::vector<IShader*> shaders;
 
@@ -1241,15 +1482,23 @@ namespace nvrhi::validation
             {
                 shaders.push_back(shader);
 
-                if (!validateShaderType(stage, shader->getDesc(), "createGraphicsPipeline"))
-                    return nullptr;
+                if (!validateShaderType(stage, shader->getDesc(), function))
+                    return false;
             }
         }
 
         if (!validatePipelineBindingLayouts(pipelineDesc.bindingLayouts, shaders))
-            return nullptr;
+            return false;
 
         if (!validateRenderState(pipelineDesc.renderState, fbinfo))
+            return false;
+
+        return true;
+    }
+
+    GraphicsPipelineHandle DeviceWrapper::createGraphicsPipeline(const GraphicsPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo)
+    {
+        if (!validateGraphicsPipelineDesc(pipelineDesc, fbinfo, "createGraphicsPipeline"))
             return nullptr;
 
         return m_Device->createGraphicsPipeline(pipelineDesc, fbinfo);
@@ -1266,26 +1515,34 @@ namespace nvrhi::validation
         return createGraphicsPipeline(pipelineDesc, fb->getFramebufferInfo());
     }
 
-    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& pipelineDesc)
+    bool DeviceWrapper::validateComputePipelineDesc(const ComputePipelineDesc& pipelineDesc, const char* function) const
     {
         if (!pipelineDesc.CS)
         {
-            error("createComputePipeline: CS = NULL");
-            return nullptr;
+            error(std::string(function) + ": CS = NULL");
+            return false;
         }
 
         std::vector<IShader*> shaders = { pipelineDesc.CS };
         
         if (!validatePipelineBindingLayouts(pipelineDesc.bindingLayouts, shaders))
-            return nullptr;
+            return false;
+
+        if (!validateShaderType(ShaderType::Compute, pipelineDesc.CS->getDesc(), function))
+            return false;
+
+        return true;
+    }
 
-        if (!validateShaderType(ShaderType::Compute, pipelineDesc.CS->getDesc(), "createComputePipeline"))
+    ComputePipelineHandle DeviceWrapper::createComputePipeline(const ComputePipelineDesc& pipelineDesc)
+    {
+        if (!validateComputePipelineDesc(pipelineDesc, "createComputePipeline"))
             return nullptr;
 
         return m_Device->createComputePipeline(pipelineDesc);
     }
 
-    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo)
+    bool DeviceWrapper::validateMeshletPipelineDesc(const MeshletPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo, const char* function) const
     {
         std::vector<IShader*> shaders;
 
@@ -1296,15 +1553,23 @@ namespace nvrhi::validation
             {
                 shaders.push_back(shader);
 
-                if (!validateShaderType(stage, shader->getDesc(), "createMeshletPipeline"))
-                    return nullptr;
+                if (!validateShaderType(stage, shader->getDesc(), function))
+                    return false;
             }
         }
 
         if (!validatePipelineBindingLayouts(pipelineDesc.bindingLayouts, shaders))
-            return nullptr;
+            return false;
                
         if (!validateRenderState(pipelineDesc.renderState, fbinfo))
+            return false;
+
+        return true;
+    }
+
+    MeshletPipelineHandle DeviceWrapper::createMeshletPipeline(const MeshletPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo)
+    {
+        if (!validateMeshletPipelineDesc(pipelineDesc, fbinfo, "createMeshletPipeline"))
             return nullptr;
 
         return m_Device->createMeshletPipeline(pipelineDesc, fbinfo);
@@ -1326,6 +1591,142 @@ namespace nvrhi::validation
         return m_Device->createRayTracingPipeline(desc);
     }
 
+    // The async versions validate the descriptors right away, so that errors are reported on the calling thread
+
+    AsyncGraphicsPipelineHandle DeviceWrapper::createGraphicsPipelineAsync(const GraphicsPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback)
+    {
+        if (!validateGraphicsPipelineDesc(pipelineDesc, fbinfo, "createGraphicsPipelineAsync"))
+            return nullptr;
+
+        return m_Device->createGraphicsPipelineAsync(pipelineDesc, fbinfo, fallback);
+    }
+
+    AsyncComputePipelineHandle DeviceWrapper::createComputePipelineAsync(const ComputePipelineDesc& pipelineDesc, IComputePipeline* fallback)
+    {
+        if (!validateComputePipelineDesc(pipelineDesc, "createComputePipelineAsync"))
+            return nullptr;
+
+        return m_Device->createComputePipelineAsync(pipelineDesc, fallback);
+    }
+
+    AsyncMeshletPipelineHandle DeviceWrapper::createMeshletPipelineAsync(const MeshletPipelineDesc& pipelineDesc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback)
+    {
+        if (!validateMeshletPipelineDesc(pipelineDesc, fbinfo, "createMeshletPipelineAsync"))
+            return nullptr;
+
+        return m_Device->createMeshletPipelineAsync(pipelineDesc, fbinfo, fallback);
+    }
+
+    rt::AsyncPipelineHandle DeviceWrapper::createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback)
+    {
+        return m_Device->createRayTracingPipelineAsync(desc, fallback);
+    }
+
+    static bool isIndirectAction(IndirectArgumentType type)
+    {
+        switch (type)
+        {
+        case IndirectArgumentType::Draw:
+        case IndirectArgumentType::DrawIndexed:
+        case IndirectArgumentType::Dispatch:
+        case IndirectArgumentType::DispatchMesh:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    CommandSignatureHandle DeviceWrapper::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        std::stringstream ss;
+        bool anyErrors = false;
+
+        ss << "createCommandSignature: ";
+
+        if (desc.arguments.empty())
+        {
+            ss << "the signature has no arguments." << std::endl;
+            error(ss.str());
+            return nullptr;
+        }
+
+        int numPipelines = int(desc.graphicsPipeline != nullptr) + int(desc.computePipeline != nullptr) + int(desc.meshletPipeline != nullptr);
+        if (numPipelines > 1)
+        {
+            ss << "only one of graphicsPipeline, computePipeline and meshletPipeline may be set." << std::endl;
+            anyErrors = true;
+        }
+
+        for (size_t index = 0; index < desc.arguments.size(); index++)
+        {
+            const IndirectArgumentDesc& argument = desc.arguments[index];
+            bool const isLast = index == desc.arguments.size() - 1;
+
+            if (isLast && !isIndirectAction(argument.type))
+            {
+                ss << "the last argument must be Draw, DrawIndexed, Dispatch or DispatchMesh." << std::endl;
+                anyErrors = true;
+            }
+            else if (!isLast && isIndirectAction(argument.type))
+            {
+                ss << "argument " << index << " is an action, but only the last argument may be an action." << std::endl;
+                anyErrors = true;
+            }
+
+            switch (argument.type)
+            {
+            case IndirectArgumentType::PushConstants:
+                if (argument.pushConstantCount == 0)
+                {
+                    ss << "argument " << index << " writes zero push constants." << std::endl;
+                    anyErrors = true;
+                }
+                [[fallthrough]];
+            case IndirectArgumentType::VolatileConstantBuffer:
+                if (numPipelines == 0)
+                {
+                    ss << "argument " << index << " refers to the pipeline bindings, but no pipeline is set." << std::endl;
+                    anyErrors = true;
+                }
+                break;
+            case IndirectArgumentType::VertexBuffer:
+                if (argument.slot >= c_MaxVertexAttributes)
+                {
+                    ss << "argument " << index << " uses vertex buffer slot " << argument.slot
+                        << ", which is out of range (" << c_MaxVertexAttributes << ")." << std::endl;
+                    anyErrors = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (desc.byteStride != 0)
+        {
+            if (desc.byteStride < desc.getPackedByteSize())
+            {
+                ss << "byteStride (" << desc.byteStride << ") is smaller than the size of the arguments ("
+                    << desc.getPackedByteSize() << ")." << std::endl;
+                anyErrors = true;
+            }
+
+            if (desc.byteStride % 4 != 0)
+            {
+                ss << "byteStride (" << desc.byteStride << ") must be a multiple of 4." << std::endl;
+                anyErrors = true;
+            }
+        }
+
+        if (anyErrors)
+        {
+            error(ss.str());
+            return nullptr;
+        }
+
+        return m_Device->createCommandSignature(desc);
+    }
+
     BindingLayoutHandle DeviceWrapper::createBindingLayout(const BindingLayoutDesc& desc)
     {
         std::stringstream errorStream;
@@ -1358,6 +1759,7 @@ namespace nvrhi::validation
         uint32_t noneItemCount = 0;
         uint32_t pushConstantCount = 0;
         uint32_t zeroSizeCount = 0;
+        uint32_t inlineUniformBlockCount = 0;
         for (const BindingLayoutItem& item : desc.bindings)
         {
             if (item.type == ResourceType::None)
@@ -1385,6 +1787,17 @@ namespace nvrhi::validation
 
                 pushConstantCount++;
             }
+            else if (item.type == ResourceType::InlineUniformBlock)
+            {
+                if (item.size == 0 || (item.size % 4) != 0)
+                {
+                    errorStream << "Inline uniform block size (" << item.size << ") at slot " << item.slot
+                        << " must be a nonzero multiple of 4" << std::endl;
+                    anyErrors = true;
+                }
+
+                inlineUniformBlockCount++;
+            }
             else
             {
                 if (item.size == 0)
@@ -1395,6 +1808,19 @@ namespace nvrhi::validation
                     errorStream << "Arrays of volatile constant buffers are not supported (size = " << item.size << ")" << std::endl;
                     anyErrors = true;
                 }
+
+                if (item.numInlineConstants * 4 > c_MaxInlineVolatileConstantBufferSize)
+                {
+                    errorStream << "Inline volatile constant buffer at slot " << item.slot << " is too large ("
+                        << item.numInlineConstants * 4 << " bytes), the maximum is " << c_MaxInlineVolatileConstantBufferSize << std::endl;
+                    anyErrors = true;
+                }
+
+                if (item.numInlineConstants != 0 && item.type != ResourceType::VolatileConstantBuffer)
+                {
+                    errorStream << "Inline constants can only be declared for volatile constant buffers (slot " << item.slot << ")" << std::endl;
+                    anyErrors = true;
+                }
             }
         }
 
@@ -1425,6 +1851,18 @@ namespace nvrhi::validation
             anyErrors = true;
         }
 
+        if (inlineUniformBlockCount && graphicsApi != GraphicsAPI::VULKAN)
+        {
+            errorStream << "Inline uniform blocks are only supported on Vulkan" << std::endl;
+            anyErrors = true;
+        }
+
+        if (inlineUniformBlockCount && desc.usePushDescriptors)
+        {
+            errorStream << "Binding layouts with usePushDescriptors cannot contain inline uniform blocks" << std::endl;
+            anyErrors = true;
+        }
+
         if (anyErrors)
         {
             error(errorStream.str());
@@ -1490,6 +1928,10 @@ namespace nvrhi::validation
                 errorStream << "Push constants cannot be placed into a bindless layout (slot " << item.slot << ")" << std::endl;
                 anyErrors = true;
                 break;
+            case ResourceType::InlineUniformBlock:
+                errorStream << "Inline uniform blocks cannot be placed into a bindless layout (slot " << item.slot << ")" << std::endl;
+                anyErrors = true;
+                break;
 
             case ResourceType::None:
             case ResourceType::Count:
@@ -1559,6 +2001,9 @@ namespace nvrhi::validation
                 case ResourceType::PushConstants:
                     errorStream << "ResourceType::PushConstants is not allowed for bindless layouts with LayoutType::MutableSrvUavCbv." << std::endl;
                     return false;
+                case ResourceType::InlineUniformBlock:
+                    errorStream << "ResourceType::InlineUniformBlock is not allowed for bindless layouts with LayoutType::MutableSrvUavCbv." << std::endl;
+                    return false;
                 case ResourceType::RayTracingAccelStruct:
                     errorStream << "ResourceType::RayTracingAccelStruct is not allowed for bindless layouts with LayoutType::MutableSrvUavCbv." << std::endl;
                     return false;
@@ -1806,6 +2251,24 @@ namespace nvrhi::validation
             }
             break;
 
+        case ResourceType::InlineUniformBlock:
+            if (isDescriptorTable)
+            {
+                errorStream << "Inline uniform blocks cannot be used in a descriptor table." << std::endl;
+                return false;
+            }
+            if (binding.resourceHandle != nullptr)
+            {
+                errorStream << "Inline uniform blocks cannot have a resource specified." << std::endl;
+                return false;
+            }
+            if (binding.range.byteSize == 0 || (binding.range.byteSize % 4) != 0 || (binding.range.byteOffset % 4) != 0)
+            {
+                errorStream << "Inline uniform blocks must have a nonzero size and an offset that are multiples of 4 bytes." << std::endl;
+                return false;
+            }
+            break;
+
         case ResourceType::Count:
         default:
             errorStream << "Unrecognized resourceType = " << uint32_t(binding.type) << std::endl;
@@ -1815,19 +2278,19 @@ namespace nvrhi::validation
         return true;
     }
 
-    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    bool DeviceWrapper::validateBindingSetDesc(const BindingSetDesc& desc, IBindingLayout* layout, BindingSetDesc& outPatchedDesc)
     {
         if (layout == nullptr)
         {
             error("Cannot create a binding set without a valid layout");
-            return nullptr;
+            return false;
         }
 
         const BindingLayoutDesc* layoutDesc = layout->getDesc();
         if (!layoutDesc)
         {
             error("Cannot create a binding set from a bindless layout");
-            return nullptr;
+            return false;
         }
 
         std::stringstream errorStream;
@@ -1876,19 +2339,52 @@ namespace nvrhi::validation
                 anyErrors = true;
         }
 
+        for (const BindingSetItem& item : desc.bindings)
+        {
+            if (item.type != ResourceType::InlineUniformBlock)
+                continue;
+
+            if (item.range.byteOffset + item.range.byteSize > desc.inlineUniformData.size())
+            {
+                errorStream << "Inline uniform block at slot " << item.slot << " refers to bytes " << item.range.byteOffset
+                    << ".." << item.range.byteOffset + item.range.byteSize << " of inlineUniformData, which has only "
+                    << desc.inlineUniformData.size() << " bytes" << std::endl;
+                anyErrors = true;
+            }
+
+            for (const BindingLayoutItem& layoutItem : layoutDesc->bindings)
+            {
+                if (layoutItem.type == ResourceType::InlineUniformBlock && layoutItem.slot == item.slot && layoutItem.size != item.range.byteSize)
+                {
+                    errorStream << "Inline uniform block at slot " << item.slot << " has " << item.range.byteSize
+                        << " bytes, but the layout declares " << layoutItem.size << " bytes" << std::endl;
+                    anyErrors = true;
+                }
+            }
+        }
+
         if (anyErrors)
         {
             error(errorStream.str());
-            return nullptr;
+            return false;
         }
 
         // Unwrap the resources
-        BindingSetDesc patchedDesc = desc;
-        for (auto& binding : patchedDesc.bindings)
+        outPatchedDesc = desc;
+        for (auto& binding : outPatchedDesc.bindings)
         {
             binding.resourceHandle = unwrapResource(binding.resourceHandle);
         }
 
+        return true;
+    }
+
+    BindingSetHandle DeviceWrapper::createBindingSet(const BindingSetDesc& desc, IBindingLayout* layout)
+    {
+        BindingSetDesc patchedDesc;
+        if (!validateBindingSetDesc(desc, layout, patchedDesc))
+            return nullptr;
+
         return m_Device->createBindingSet(patchedDesc, layout);
     }
 
@@ -1924,6 +2420,39 @@ namespace nvrhi::validation
         return m_Device->writeDescriptorTable(descriptorTable, patchedItem);
     }
 
+    bool DeviceWrapper::writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems)
+    {
+        if (numItems > 0 && !items)
+        {
+            error("writeDescriptorTable: items is NULL");
+            return false;
+        }
+
+        bool success = true;
+        std::vector<BindingSetItem> patchedItems;
+        patchedItems.reserve(numItems);
+
+        for (size_t index = 0; index < numItems; index++)
+        {
+            std::stringstream errorStream;
+
+            if (!validateBindingSetItem(items[index], descriptorTable, errorStream))
+            {
+                error(errorStream.str());
+                success = false;
+                continue;
+            }
+
+            BindingSetItem& patchedItem = patchedItems.emplace_back(items[index]);
+            patchedItem.resourceHandle = unwrapResource(patchedItem.resourceHandle);
+        }
+
+        if (patchedItems.empty())
+            return success;
+
+        return m_Device->writeDescriptorTable(descriptorTable, patchedItems.data(), patchedItems.size()) && success;
+    }
+
     rt::OpacityMicromapHandle DeviceWrapper::createOpacityMicromap(const rt::OpacityMicromapDesc& desc)
     {
         if (desc.inputBuffer == nullptr)
@@ -1974,6 +2503,15 @@ namespace nvrhi::validation
             return nullptr;
         }
 
+        if (desc.createInstanceBuffer && !desc.isTopLevel)
+        {
+            std::stringstream ss;
+            ss << "Cannot create BLAS " << utils::DebugNameToString(desc.debugName)
+                << " with the createInstanceBuffer flag set: instance buffers only apply to TLAS'es";
+            error(ss.str());
+            return nullptr;
+        }
+
         AccelStructWrapper* wrapper = new AccelStructWrapper(as);
         wrapper->isTopLevel = desc.isTopLevel;
         wrapper->allowUpdate = !!(desc.buildFlags & rt::AccelStructBuildFlags::AllowUpdate);
@@ -2217,12 +2755,34 @@ namespace nvrhi::validation
             return nullptr;
         }
 
+        if (params.isBundle)
+        {
+            if (params.queueType != CommandQueue::Graphics)
+            {
+                error("Bundles can only be created for the graphics queue");
+                return nullptr;
+            }
+
+            if (!m_Device->queryFeatureSupport(Feature::Bundles))
+            {
+                error("Bundles are not supported by this device");
+                return nullptr;
+            }
+        }
+
+        if (params.reusable && params.isBundle)
+        {
+            error("A command list cannot be both a bundle and reusable, bundles can always be executed many times");
+            return nullptr;
+        }
+
         CommandListHandle commandList = m_Device->createCommandList(params);
 
         if (commandList == nullptr)
             return nullptr;
 
-        CommandListWrapper* wrapper = new CommandListWrapper(this, commandList, params.enableImmediateExecution, params.queueType);
+        CommandListWrapper* wrapper = new CommandListWrapper(this, commandList,
+            params.enableImmediateExecution && !params.isBundle, params.isBundle, params.queueType);
         return CommandListHandle::Create(wrapper);
     }
     
@@ -2260,6 +2820,14 @@ namespace nvrhi::validation
                 return 0;
             }
 
+            if (desc.isBundle)
+            {
+                std::stringstream ss;
+                ss << "executeCommandLists: The command list [" << i << "] is a bundle, use ICommandList::executeBundles to execute it";
+                error(ss.str());
+                return 0;
+            }
+
             CommandListWrapper* wrapper = dynamic_cast<CommandListWrapper*>(pCommandLists[i]);
             if (wrapper)
             {
@@ -2280,6 +2848,25 @@ namespace nvrhi::validation
         m_Device->queueWaitForCommandList(waitQueue, executionQueue, instance);
     }
 
+    StorageQueueHandle DeviceWrapper::createStorageQueue(const StorageQueueDesc& desc)
+    {
+        if ((desc.queue == CommandQueue::Compute && !m_Device->queryFeatureSupport(Feature::ComputeQueue)) ||
+            (desc.queue == CommandQueue::Copy && !m_Device->queryFeatureSupport(Feature::CopyQueue)))
+        {
+            error("createStorageQueue: the queue is not supported or initialized in this device");
+            return nullptr;
+        }
+
+        if (desc.stagingSize == 0)
+        {
+            error("createStorageQueue: stagingSize must not be 0");
+            return nullptr;
+        }
+
+        // The requests are validated by the queue itself
+        return m_Device->createStorageQueue(desc);
+    }
+
     bool DeviceWrapper::waitForIdle()
     {
         return m_Device->waitForIdle();
@@ -2290,6 +2877,27 @@ namespace nvrhi::validation
         m_Device->runGarbageCollection();
     }
 
+    bool DeviceWrapper::getVideoMemoryBudget(VideoMemoryBudget& outBudget)
+    {
+        return m_Device->getVideoMemoryBudget(outBudget);
+    }
+
+    MemoryStatistics DeviceWrapper::getMemoryStatistics()
+    {
+        return m_Device->getMemoryStatistics();
+    }
+
+    void DeviceWrapper::setResidencyPriority(IResource* resource, ResidencyPriority priority)
+    {
+        if (!resource)
+        {
+            error("setResidencyPriority: resource is NULL");
+            return;
+        }
+
+        m_Device->setResidencyPriority(unwrapResource(resource), priority);
+    }
+
     bool DeviceWrapper::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
     {
         return m_Device->queryFeatureSupport(feature, pInfo, infoSize);
@@ -2322,11 +2930,60 @@ namespace nvrhi::validation
         return m_Device->getCoopVecMatrixSize(type, layout, rows, columns);
     }
 
+    void DeviceWrapper::getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes)
+    {
+        if (numDescs == 0)
+            return;
+
+        if (!descs || !outSizes)
+        {
+            error("getCoopVecMatrixSizes: descs and outSizes must not be NULL when numDescs is nonzero");
+            return;
+        }
+
+        std::fill(outSizes, outSizes + numDescs, size_t(0));
+
+        if (!m_Device->queryFeatureSupport(Feature::CooperativeVectorInferencing))
+        {
+            error("getCoopVecMatrixSizes: Cooperative Vectors are not supported by the device");
+            return;
+        }
+
+        for (size_t i = 0; i < numDescs; ++i)
+        {
+            if (descs[i].numRows == 0 || descs[i].numColumns == 0)
+            {
+                std::stringstream ss;
+                ss << "getCoopVecMatrixSizes: numRows and numColumns must be positive for descs[" << i << "]";
+                error(ss.str());
+                return;
+            }
+        }
+
+        m_Device->getCoopVecMatrixSizes(descs, numDescs, outSizes);
+    }
+
     Object DeviceWrapper::getNativeQueue(ObjectType objectType, CommandQueue queue)
     {
         return m_Device->getNativeQueue(objectType, queue);
     }
 
+    bool DeviceWrapper::getPipelineCacheData(std::vector<uint8_t>& outData)
+    {
+        return m_Device->getPipelineCacheData(outData);
+    }
+
+    bool DeviceWrapper::mergePipelineCacheData(const void* data, size_t size)
+    {
+        if (!data && size)
+        {
+            error("mergePipelineCacheData: data is NULL but size is nonzero");
+            return false;
+        }
+
+        return m_Device->mergePipelineCacheData(data, size);
+    }
+
     IMessageCallback* DeviceWrapper::getMessageCallback()
     {
         return m_MessageCallback;
@@ -45,60 +45,157 @@ namespace nvrhi::vulkan
         return flags;
     }
 
-    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress) const
+    VulkanAllocator::~VulkanAllocator()
+    {
+        for (const auto& block : m_Blocks)
+        {
+            if (block->mappedMemory)
+                m_Context.device.unmapMemory(block->memory);
+
+            if (m_Context.residency)
+                m_Context.residency->removeAllocation(getResidencyKey(block->memory));
+
+            m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+        }
+
+        m_Blocks.clear();
+    }
+
+    void VulkanAllocator::enableSuballocation(uint64_t blockSize)
+    {
+        m_BlockSize = blockSize;
+    }
+
+    bool VulkanAllocator::shouldSuballocate(const vk::MemoryRequirements& memRequirements,
+        const vk::MemoryDedicatedRequirements& dedicatedRequirements, bool enableExportMemory) const
+    {
+        if (m_BlockSize == 0)
+            return false;
+
+        // Exported memory is shared with other APIs as a whole, so it must not contain other resources
+        if (enableExportMemory)
+            return false;
+
+        if (dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation)
+            return false;
+
+        // Large resources would waste too much of a block
+        return memRequirements.size <= m_BlockSize / 2;
+    }
+
+    vk::Result VulkanAllocator::allocateBufferMemory(Buffer *buffer, bool enableDeviceAddress)
     {
         // figure out memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getBufferMemoryRequirements(buffer->buffer, &memRequirements);
+        auto dedicatedRequirements = vk::MemoryDedicatedRequirements();
+        auto memRequirements2 = vk::MemoryRequirements2();
+        memRequirements2.pNext = &dedicatedRequirements;
+        auto requirementsInfo = vk::BufferMemoryRequirementsInfo2()
+            .setBuffer(buffer->buffer);
+        m_Context.device.getBufferMemoryRequirements2(&requirementsInfo, &memRequirements2);
+        const vk::MemoryRequirements& memRequirements = memRequirements2.memoryRequirements;
 
-        // allocate memory
         const bool enableMemoryExport = (buffer->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
-        const vk::Result res = allocateMemory(buffer, memRequirements, pickBufferMemoryProperties(buffer->desc), enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
+        const vk::MemoryPropertyFlags memProperties = pickBufferMemoryProperties(buffer->desc);
+
+        if (shouldSuballocate(memRequirements, dedicatedRequirements, enableMemoryExport))
+        {
+            vk::MemoryRequirements blockRequirements = memRequirements;
+
+            // Mapped ranges are flushed in units of nonCoherentAtomSize, keep them from spilling into other buffers
+            if (buffer->desc.cpuAccess != CpuAccessMode::None)
+                blockRequirements.alignment = std::max(blockRequirements.alignment, m_Context.physicalDeviceProperties.limits.nonCoherentAtomSize);
+
+            if (suballocateMemory(buffer, blockRequirements, memProperties, false) == vk::Result::eSuccess)
+            {
+                m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, buffer->memoryOffset);
+                trackMemory(buffer, memRequirements.size, buffer->desc.debugName);
+                return vk::Result::eSuccess;
+            }
+
+            // If there is no space and no new block can be created, try a dedicated allocation
+        }
+
+        // allocate memory
+        const vk::Result res = allocateMemory(buffer, memRequirements, memProperties, enableDeviceAddress, enableMemoryExport, nullptr, buffer->buffer);
         CHECK_VK_RETURN(res)
 
         m_Context.device.bindBufferMemory(buffer->buffer, buffer->memory, 0);
+        trackMemory(buffer, memRequirements.size, buffer->desc.debugName);
 
         return vk::Result::eSuccess;
     }
 
-    void VulkanAllocator::freeBufferMemory(Buffer *buffer) const
+    void VulkanAllocator::freeBufferMemory(Buffer *buffer)
     {
         freeMemory(buffer);
     }
 
-    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture) const
+    void VulkanAllocator::trackMemory(MemoryResource* res, uint64_t size, const std::string& debugName) const
+    {
+        res->trackedMemorySize = size;
+        m_Context.memoryStatistics->allocated(res->memoryCategory, size, debugName.c_str());
+    }
+
+    vk::Result VulkanAllocator::allocateTextureMemory(Texture *texture)
     {
+        texture->memoryCategory = MemoryCategory::Textures;
+
         // grab the image memory requirements
-        vk::MemoryRequirements memRequirements;
-        m_Context.device.getImageMemoryRequirements(texture->image, &memRequirements);
+        auto dedicatedRequirements = vk::MemoryDedicatedRequirements();
+        auto memRequirements2 = vk::MemoryRequirements2();
+        memRequirements2.pNext = &dedicatedRequirements;
+        auto requirementsInfo = vk::ImageMemoryRequirementsInfo2()
+            .setImage(texture->image);
+        m_Context.device.getImageMemoryRequirements2(&requirementsInfo, &memRequirements2);
+        const vk::MemoryRequirements& memRequirements = memRequirements2.memoryRequirements;
 
-        // allocate memory
         const vk::MemoryPropertyFlags memProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
         const bool enableDeviceAddress = false;
         const bool enableMemoryExport = (texture->desc.sharedResourceFlags & SharedResourceFlags::Shared) != 0;
+
+        // Transient attachments go into lazily allocated memory where the device has it, which is committed
+        // only as far as the render passes need it. Such memory is never suballocated.
+        if (texture->desc.isTransientAttachment)
+        {
+            const vk::MemoryPropertyFlags lazyProperties = memProperties | vk::MemoryPropertyFlagBits::eLazilyAllocated;
+            if (findMemoryType(memRequirements.memoryTypeBits, lazyProperties) != ~0u)
+            {
+                const vk::Result res = allocateMemory(texture, memRequirements, lazyProperties, enableDeviceAddress, enableMemoryExport, texture->image, nullptr);
+                CHECK_VK_RETURN(res)
+
+                m_Context.device.bindImageMemory(texture->image, texture->memory, 0);
+                trackMemory(texture, memRequirements.size, texture->desc.debugName);
+
+                return vk::Result::eSuccess;
+            }
+        }
+
+        // Images are placed into their own blocks, which avoids any bufferImageGranularity conflicts with buffers
+        if (shouldSuballocate(memRequirements, dedicatedRequirements, enableMemoryExport) &&
+            suballocateMemory(texture, memRequirements, memProperties, true) == vk::Result::eSuccess)
+        {
+            m_Context.device.bindImageMemory(texture->image, texture->memory, texture->memoryOffset);
+            trackMemory(texture, memRequirements.size, texture->desc.debugName);
+            return vk::Result::eSuccess;
+        }
+
+        // allocate memory
         const vk::Result res = allocateMemory(texture, memRequirements, memProperties, enableDeviceAddress, enableMemoryExport, texture->image, nullptr);
         CHECK_VK_RETURN(res)
 
         m_Context.device.bindImageMemory(texture->image, texture->memory, 0);
+        trackMemory(texture, memRequirements.size, texture->desc.debugName);
 
         return vk::Result::eSuccess;
     }
 
-    void VulkanAllocator::freeTextureMemory(Texture *texture) const
+    void VulkanAllocator::freeTextureMemory(Texture *texture)
     {
         freeMemory(texture);
     }
 
-    vk::Result VulkanAllocator::allocateMemory(MemoryResource *res,
-                                               vk::MemoryRequirements memRequirements,
-                                               vk::MemoryPropertyFlags memPropertyFlags,
-                                                bool enableDeviceAddress,
-                                                bool enableExportMemory,
-                                                VkImage dedicatedImage,
-                                                VkBuffer dedicatedBuffer) const
+    uint32_t VulkanAllocator::findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags) const
     {
-        res->managed = true;
-
         // find a memory space that satisfies the requirements
         vk::PhysicalDeviceMemoryProperties memProperties;
         m_Context.physicalDevice.getMemoryProperties(&memProperties);
@@ -106,14 +203,151 @@ namespace nvrhi::vulkan
         uint32_t memTypeIndex;
         for(memTypeIndex = 0; memTypeIndex < memProperties.memoryTypeCount; memTypeIndex++)
         {
-            if ((memRequirements.memoryTypeBits & (1 << memTypeIndex)) &&
+            if ((memoryTypeBits & (1 << memTypeIndex)) &&
                 ((memProperties.memoryTypes[memTypeIndex].propertyFlags & memPropertyFlags) == memPropertyFlags))
             {
+                return memTypeIndex;
+            }
+        }
+
+        return ~0u;
+    }
+
+    MemoryBlock* VulkanAllocator::createBlock(uint32_t memoryTypeIndex, uint64_t minSize, bool forImages)
+    {
+        vk::PhysicalDeviceMemoryProperties memProperties;
+        m_Context.physicalDevice.getMemoryProperties(&memProperties);
+
+        const vk::MemoryType& memoryType = memProperties.memoryTypes[memoryTypeIndex];
+
+        // Don't let a single block take a large part of a small heap, such as the BAR memory
+        const uint64_t heapSize = memProperties.memoryHeaps[memoryType.heapIndex].size;
+        const uint64_t blockSize = std::max(std::min(m_BlockSize, heapSize / 8), minSize);
+
+        auto allocFlags = vk::MemoryAllocateFlagsInfo();
+        if (!forImages && m_Context.extensions.buffer_device_address)
+            allocFlags.flags |= vk::MemoryAllocateFlagBits::eDeviceAddress;
+
+        auto allocInfo = vk::MemoryAllocateInfo()
+            .setAllocationSize(blockSize)
+            .setMemoryTypeIndex(memoryTypeIndex)
+            .setPNext(&allocFlags);
+
+        auto block = std::make_unique<MemoryBlock>(blockSize);
+        block->memoryTypeIndex = memoryTypeIndex;
+        block->forImages = forImages;
+
+        vk::Result res = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &block->memory);
+        if (res != vk::Result::eSuccess)
+            return nullptr;
+
+        // Host visible blocks are mapped once, the resources placed in them get pointers into that mapping
+        if (memoryType.propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+        {
+            res = m_Context.device.mapMemory(block->memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), &block->mappedMemory);
+            if (res != vk::Result::eSuccess)
+            {
+                m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+                return nullptr;
+            }
+        }
+
+        if (m_Context.residency && (memoryType.propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+            m_Context.residency->addAllocation(getResidencyKey(block->memory), blockSize);
+
+        m_Blocks.push_back(std::move(block));
+        return m_Blocks.back().get();
+    }
+
+    vk::Result VulkanAllocator::suballocateMemory(MemoryResource* res, vk::MemoryRequirements memRequirements,
+        vk::MemoryPropertyFlags memPropertyFlags, bool forImages)
+    {
+        const uint32_t memTypeIndex = findMemoryType(memRequirements.memoryTypeBits, memPropertyFlags);
+        if (memTypeIndex == ~0u)
+            return vk::Result::eErrorOutOfDeviceMemory;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        MemoryBlock* block = nullptr;
+        TlsfAllocator::Allocation allocation;
+
+        for (const auto& candidate : m_Blocks)
+        {
+            if (candidate->memoryTypeIndex != memTypeIndex || candidate->forImages != forImages)
+                continue;
+
+            allocation = candidate->allocator.allocate(memRequirements.size, memRequirements.alignment);
+            if (allocation.isValid())
+            {
+                block = candidate.get();
                 break;
             }
         }
 
-        if (memTypeIndex == memProperties.memoryTypeCount)
+        if (!block)
+        {
+            block = createBlock(memTypeIndex, memRequirements.size, forImages);
+            if (!block)
+                return vk::Result::eErrorOutOfDeviceMemory;
+
+            allocation = block->allocator.allocate(memRequirements.size, memRequirements.alignment);
+            if (!allocation.isValid())
+                return vk::Result::eErrorOutOfDeviceMemory;
+        }
+
+        res->managed = true;
+        res->memory = block->memory;
+        res->memoryBlock = block;
+        res->suballocation = allocation;
+        res->memoryOffset = allocation.offset;
+        res->mappedBlockMemory = block->mappedMemory ? (char*)block->mappedMemory + allocation.offset : nullptr;
+
+        return vk::Result::eSuccess;
+    }
+
+    uint64_t VulkanAllocator::releaseEmptyBlocks()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        uint64_t releasedSize = 0;
+        size_t numRemaining = 0;
+        for (auto& block : m_Blocks)
+        {
+            if (block->allocator.isEmpty())
+            {
+                if (block->mappedMemory)
+                    m_Context.device.unmapMemory(block->memory);
+
+                if (m_Context.residency)
+                    m_Context.residency->removeAllocation(getResidencyKey(block->memory));
+
+                m_Context.device.freeMemory(block->memory, m_Context.allocationCallbacks);
+                releasedSize += block->allocator.getSize();
+                block.reset();
+            }
+            else
+            {
+                m_Blocks[numRemaining++] = std::move(block);
+            }
+        }
+
+        m_Blocks.resize(numRemaining);
+        return releasedSize;
+    }
+
+    vk::Result VulkanAllocator::allocateMemory(MemoryResource *res,
+                                               vk::MemoryRequirements memRequirements,
+                                               vk::MemoryPropertyFlags memPropertyFlags,
+                                                bool enableDeviceAddress,
+                                                bool enableExportMemory,
+                                                VkImage dedicatedImage,
+                                                VkBuffer dedicatedBuffer) const
+    {
+        res->managed = true;
+
+        const uint32_t memTypeIndex = findMemoryType(memRequirements.memoryTypeBits, memPropertyFlags);
+
+        if (memTypeIndex == ~0u)
         {
             // xxxnsubtil: this is incorrect; need better error reporting
             return vk::Result::eErrorOutOfDeviceMemory;
@@ -156,13 +390,64 @@ namespace nvrhi::vulkan
                             .setMemoryTypeIndex(memTypeIndex)
                             .setPNext(pNext);
 
-        return m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
+        const vk::Result result = m_Context.device.allocateMemory(&allocInfo, m_Context.allocationCallbacks, &res->memory);
+
+        if (result == vk::Result::eSuccess && m_Context.residency && (memPropertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+            m_Context.residency->addAllocation(getResidencyKey(res->memory), memRequirements.size);
+
+        return result;
     }
 
-    void VulkanAllocator::freeMemory(MemoryResource *res) const
+    void VulkanAllocator::freeMemory(MemoryResource *res)
     {
         assert(res->managed);
 
+        if (res->trackedMemorySize)
+        {
+            m_Context.memoryStatistics->released(res->memoryCategory, res->trackedMemorySize);
+            res->trackedMemorySize = 0;
+        }
+
+        if (res->memoryBlock)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            MemoryBlock* block = res->memoryBlock;
+            block->allocator.release(res->suballocation);
+
+            // Keep one empty block per memory type around to avoid reallocating it over and over
+            if (block->allocator.isEmpty())
+            {
+                for (size_t index = 0; index < m_Blocks.size(); index++)
+                {
+                    const MemoryBlock* other = m_Blocks[index].get();
+                    if (other != block && other->memoryTypeIndex == block->memoryTypeIndex &&
+                        other->forImages == block->forImages && other->allocator.isEmpty())
+                    {
+                        if (other->mappedMemory)
+                            m_Context.device.unmapMemory(other->memory);
+
+                        if (m_Context.residency)
+                            m_Context.residency->removeAllocation(getResidencyKey(other->memory));
+
+                        m_Context.device.freeMemory(other->memory, m_Context.allocationCallbacks);
+                        m_Blocks.erase(m_Blocks.begin() + ptrdiff_t(index));
+                        break;
+                    }
+                }
+            }
+
+            res->memoryBlock = nullptr;
+            res->suballocation = TlsfAllocator::Allocation();
+            res->memoryOffset = 0;
+            res->mappedBlockMemory = nullptr;
+            res->memory = vk::DeviceMemory(nullptr);
+            return;
+        }
+
+        if (m_Context.residency)
+            m_Context.residency->removeAllocation(getResidencyKey(res->memory));
+
         m_Context.device.freeMemory(res->memory, m_Context.allocationCallbacks);
         res->memory = vk::DeviceMemory(nullptr);
     }
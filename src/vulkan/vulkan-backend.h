@@ -25,10 +25,24 @@
 #include <nvrhi/vulkan.h>
 #include <nvrhi/utils.h>
 #include <nvrhi/common/aftermath.h>
+#include <nvrhi/common/misc.h>
 #include "../common/state-tracking.h"
 #include "../common/versioning.h"
+#include "../common/ring-allocator.h"
+#include "../common/tlsf-allocator.h"
+#include "../common/deduplication-cache.h"
+#include "../common/deferred-destruction.h"
+#include "../common/coopvec-size-cache.h"
+#include "../common/pipeline-compiler.h"
+#include "../common/memory-statistics.h"
+#include "../common/residency.h"
+#include "../common/resource-references.h"
+#include "../common/storage-queue.h"
+#include "../common/graphics-state-cache.h"
+#include "../common/view-cache.h"
 #include <mutex>
 #include <list>
+#include <atomic>
 
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include <vulkan/vulkan.hpp>
@@ -73,10 +87,15 @@ namespace nvrhi::vulkan
     class GraphicsPipeline;
     class ComputePipeline;
     class BindingSet;
+    class UploadManager;
     class EventQuery;
     class TimerQuery;
+    class AccelStruct;
+    class OpacityMicromap;
     class Marker;
     class Device;
+    class DescriptorBufferAllocator;
+    struct VulkanContext;
 
     struct ResourceStateMapping
     {
@@ -100,6 +119,7 @@ namespace nvrhi::vulkan
 
     vk::SamplerAddressMode convertSamplerAddressMode(SamplerAddressMode mode);
     vk::PipelineStageFlagBits2 convertShaderTypeToPipelineStageFlagBits(ShaderType shaderType);
+    vk::PipelineStageFlags2 convertPipelineStages(PipelineStages stages, CommandQueue queue, const VulkanContext& context);
     vk::ShaderStageFlagBits convertShaderTypeToShaderStageFlagBits(ShaderType shaderType);
     ResourceStateMapping convertResourceState(ResourceStates state, bool isImage);
     ResourceStateMapping2 convertResourceState2(ResourceStates state, bool isImage);
@@ -142,6 +162,27 @@ namespace nvrhi::vulkan
     };
 #endif
 
+    // Native BLAS compaction state, used when NVRHI is built without RTXMU.
+    // BLAS'es are added to the candidates when the command buffers that queried their compacted sizes are retired.
+    struct AccelStructCompaction
+    {
+        explicit AccelStructCompaction(uint32_t maxQueries)
+            : queries(maxQueries, true)
+            , micromapQueries(maxQueries, true)
+        { }
+
+        vk::QueryPool queryPool;
+        utils::BitSetAllocator queries;
+        std::vector<AccelStruct*> candidates;
+
+        // OMMs use a query pool of their own, compacted micromap sizes are a different query type
+        vk::QueryPool micromapQueryPool;
+        utils::BitSetAllocator micromapQueries;
+        std::vector<OpacityMicromap*> micromapCandidates;
+
+        std::mutex mutex;
+    };
+
     // underlying vulkan context
     struct VulkanContext
     {
@@ -172,6 +213,7 @@ namespace nvrhi::vulkan
             bool KHR_ray_query = false;
             bool KHR_ray_tracing_pipeline = false;
             bool NV_mesh_shader = false;
+            bool EXT_mesh_shader = false;
             bool KHR_fragment_shading_rate = false;
             bool EXT_conservative_rasterization = false;
             bool EXT_opacity_micromap = false;
@@ -181,6 +223,16 @@ namespace nvrhi::vulkan
             bool EXT_debug_utils = false;
             bool NV_cooperative_vector = false;
             bool NV_ray_tracing_linear_swept_spheres = false;
+            bool KHR_pipeline_library = false;
+            bool EXT_graphics_pipeline_library = false;
+            bool EXT_descriptor_buffer = false;
+            bool EXT_conditional_rendering = false;
+            bool NV_memory_decompression = false;
+            bool EXT_memory_budget = false;
+            bool EXT_pageable_device_local_memory = false;
+            bool KHR_push_descriptor = false;
+            bool EXT_inline_uniform_block = false;
+            bool EXT_device_generated_commands = false;
 #if NVRHI_WITH_AFTERMATH
             bool NV_device_diagnostic_checkpoints = false;
             bool NV_device_diagnostics_config= false;
@@ -200,14 +252,48 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceCooperativeVectorPropertiesNV coopVecProperties;
         vk::PhysicalDeviceRayTracingLinearSweptSpheresFeaturesNV linearSweptSpheresFeatures;
         vk::PhysicalDeviceSubgroupProperties subgroupProperties;
+        vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties;
+        vk::PhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties;
+        vk::PhysicalDeviceMeshShaderPropertiesEXT meshShaderProperties;
+        vk::PhysicalDeviceMeshShaderPropertiesNV nvMeshShaderProperties;
+        vk::PhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures;
+        vk::PhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties;
+        vk::PhysicalDeviceInlineUniformBlockPropertiesEXT inlineUniformBlockProperties;
+        vk::PhysicalDeviceDeviceGeneratedCommandsPropertiesEXT deviceGeneratedCommandsProperties;
         IMessageCallback* messageCallback = nullptr;
         bool logBufferLifetime = false;
+        bool descriptorUpdateAfterBind = false; // see DeviceDesc::descriptorUpdateAfterBindSupported
 #ifdef NVRHI_WITH_RTXMU
         std::unique_ptr<rtxmu::VkAccelStructManager> rtxMemUtil;
         std::unique_ptr<RtxMuResources> rtxMuResources;
 #endif
+        std::unique_ptr<AccelStructCompaction> accelStructCompaction;
         vk::DescriptorSetLayout emptyDescriptorSetLayout;
 
+        // not null when residency management is enabled, see DeviceDesc::enableResidencyManagement
+        std::unique_ptr<ResidencyTracker> residency;
+
+        // always created, see IDevice::getMemoryStatistics
+        std::unique_ptr<MemoryStatisticsTracker> memoryStatistics;
+
+        // not null when the device uses a descriptor buffer, see DeviceDesc::enableDescriptorBuffer
+        DescriptorBufferAllocator* descriptorBuffer = nullptr;
+
+        // flags that all pipelines must be created with
+        [[nodiscard]] vk::PipelineCreateFlags getPipelineCreateFlags() const
+        {
+            return descriptorBuffer ? vk::PipelineCreateFlags(vk::PipelineCreateFlagBits::eDescriptorBufferEXT) : vk::PipelineCreateFlags();
+        }
+
+        // flags for the graphics and meshlet pipelines that render into framebuffers with the given info
+        [[nodiscard]] vk::PipelineCreateFlags getPipelineCreateFlags(const FramebufferInfo& fbinfo) const
+        {
+            vk::PipelineCreateFlags flags = getPipelineCreateFlags();
+            if (fbinfo.hasShadingRateAttachment)
+                flags |= vk::PipelineCreateFlagBits::eRenderingFragmentShadingRateAttachmentKHR;
+            return flags;
+        }
+
         void nameVKObject(const void* handle, const vk::ObjectType objtype,
             const vk::DebugReportObjectTypeEXT objtypeEXT, const char* name) const;
         void error(const std::string& message) const;
@@ -216,6 +302,17 @@ namespace nvrhi::vulkan
     };
 
     // command buffer with resource tracking
+    class SyncPoint : public RefCounter<ISyncPoint>
+    {
+    public:
+        CommandQueue queue = CommandQueue::Graphics;
+        vk::Semaphore semaphore; // the tracking semaphore of the queue
+        std::atomic<uint64_t> value = 0; // assigned when the signaling command list is submitted
+
+        [[nodiscard]] CommandQueue getQueue() const override { return queue; }
+        [[nodiscard]] uint64_t getValue() const override { return value; }
+    };
+
     class TrackedCommandBuffer
     {
     public:
@@ -224,12 +321,50 @@ namespace nvrhi::vulkan
         vk::CommandBuffer cmdBuf = vk::CommandBuffer();
         vk::CommandPool cmdPool = vk::CommandPool();
 
-        std::vector<RefCountPtr<IResource>> referencedResources; // to keep them alive
+        // Parts of the recording that were finished by signalSyncPoint or waitSyncPoint, in submission order.
+        // cmdBuf records the part after the last one.
+        struct SyncSegment
+        {
+            vk::CommandBuffer cmdBuf;
+            RefCountPtr<SyncPoint> signalAfter; // signaled after this part
+            RefCountPtr<SyncPoint> waitAfter; // waited for before the next part
+            vk::PipelineStageFlags2 waitStages;
+        };
+        std::vector<SyncSegment> syncSegments;
+
+        // command buffers allocated from cmdPool for the parts, reused when the command buffer is retired
+        std::vector<vk::CommandBuffer> spareSegmentCmdBufs;
+
+        ResourceReferenceSet referencedResources; // to keep them alive, one reference per unique object
         std::vector<RefCountPtr<Buffer>> referencedStagingBuffers; // to allow synchronous mapBuffer
+        std::vector<std::shared_ptr<TrackedCommandBuffer>> referencedBundles; // secondary command buffers executed by this one
+
+        // descriptor pools for transient binding sets, reset when the command buffer is retired
+        std::vector<vk::DescriptorPool> transientDescriptorPools;
+        size_t currentTransientDescriptorPool = 0;
+
+        // objects of the transient binding sets, reused after the command buffer is retired
+        std::vector<BindingSetHandle> transientBindingSets;
+        size_t numTransientBindingSetsUsed = 0;
+
+        // events used for split barriers, reset when the command buffer is retired
+        std::vector<vk::Event> splitBarrierEvents;
+        size_t numSplitBarrierEventsUsed = 0;
 
         uint64_t recordingID = 0;
         uint64_t submissionID = 0;
 
+        // set while the command buffer belongs to a reusable command list, which can submit it many times,
+        // it is only added to the in-flight list by releaseReusableCommandBuffer
+        bool ownedByReusableList = false;
+
+        // upload managers of a destroyed reusable command list, kept until its last submission is retired
+        std::vector<std::unique_ptr<UploadManager>> retainedUploadManagers;
+
+        std::vector<rt::AccelStructHandle> accelStructsToCompact; // BLAS'es that had their compacted sizes queried
+        std::vector<rt::OpacityMicromapHandle> micromapsToCompact; // OMMs that had their compacted sizes queried
+        std::vector<std::pair<RefCountPtr<ITimerQueryPool>, uint64_t>> resolvedTimerQueryFrames; // pool and frame index
+
 #ifdef NVRHI_WITH_RTXMU
         std::vector<uint64_t> rtxmuBuildIds;
         std::vector<uint64_t> rtxmuCompactionIds;
@@ -240,6 +375,9 @@ namespace nvrhi::vulkan
         { }
 
         ~TrackedCommandBuffer();
+
+        // Releases the descriptors and resources of the transient binding sets once the command buffer is no longer in use
+        void resetTransientBindingSets();
     
     private:
         const VulkanContext& m_Context;
@@ -257,17 +395,21 @@ namespace nvrhi::vulkan
         ~Queue();
 
         // creates a command buffer and its synchronization resources
-        TrackedCommandBufferPtr createCommandBuffer();
+        TrackedCommandBufferPtr createCommandBuffer(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
 
         TrackedCommandBufferPtr getOrCreateCommandBuffer();
 
-        void addWaitSemaphore(vk::Semaphore semaphore, uint64_t value);
+        // returns the command buffer of a reusable command list to the queue, it is retired after its last submission
+        void releaseReusableCommandBuffer(TrackedCommandBufferPtr commandBuffer);
+
+        void addWaitSemaphore(vk::Semaphore semaphore, uint64_t value, vk::PipelineStageFlags2 waitStageMask = vk::PipelineStageFlagBits2::eAllCommands);
         void addSignalSemaphore(vk::Semaphore semaphore, uint64_t value);
 
         // submits a command buffer to this queue, returns submissionID
         uint64_t submit(ICommandList* const* ppCmd, size_t numCmd);
 
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings);
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings);
 
         // retire any command buffers that have finished execution from the pending execution list
         void retireCommandBuffers();
@@ -291,25 +433,85 @@ namespace nvrhi::vulkan
         uint32_t m_QueueFamilyIndex = uint32_t(-1);
 
         std::mutex m_Mutex;
-        std::vector<vk::Semaphore> m_WaitSemaphores;
-        std::vector<uint64_t> m_WaitSemaphoreValues;
-        std::vector<vk::Semaphore> m_SignalSemaphores;
-        std::vector<uint64_t> m_SignalSemaphoreValues;
+        std::vector<vk::SemaphoreSubmitInfo> m_WaitSemaphores;
+        std::vector<vk::SemaphoreSubmitInfo> m_SignalSemaphores;
+
+        // ranges of the submit arrays used by one VkSubmitInfo(2), each range ends where the next batch begins
+        struct SubmitBatch
+        {
+            uint32_t firstWait;
+            uint32_t firstCommandBuffer;
+            uint32_t firstSignal;
+        };
+
+        // scratch arrays for submit, cleared but never shrunk so that steady-state submission doesn't allocate
+        std::vector<vk::SemaphoreSubmitInfo> m_SubmitWaitInfos;
+        std::vector<vk::CommandBufferSubmitInfo> m_SubmitCommandBuffers;
+        std::vector<vk::SemaphoreSubmitInfo> m_SubmitSignalInfos;
+        std::vector<SubmitBatch> m_SubmitBatches;
+        std::vector<vk::SubmitInfo2> m_SubmitInfos;
+        std::vector<vk::SubmitInfo> m_LegacySubmitInfos;
+        std::vector<vk::TimelineSemaphoreSubmitInfo> m_LegacyTimelineSemaphoreInfos;
+        std::vector<vk::CommandBuffer> m_LegacySubmitCommandBuffers;
+        std::vector<vk::Semaphore> m_LegacyWaitSemaphores;
+        std::vector<uint64_t> m_LegacyWaitSemaphoreValues;
+        std::vector<vk::PipelineStageFlags> m_LegacyWaitStages;
+        std::vector<vk::Semaphore> m_LegacySignalSemaphores;
+        std::vector<uint64_t> m_LegacySignalSemaphoreValues;
 
         uint64_t m_LastRecordingID = 0;
         uint64_t m_LastSubmittedID = 0;
         uint64_t m_LastFinishedID = 0;
 
-        // tracks the list of command buffers in flight on this queue
+        // tracks the list of command buffers in flight on this queue.
+        // List nodes are moved between the lists with splice and never freed: a command buffer taken from the pool
+        // leaves its node in m_SpareListNodes, and submit takes a node from there for the in-flight list.
         std::list<TrackedCommandBufferPtr> m_CommandBuffersInFlight;
         std::list<TrackedCommandBufferPtr> m_CommandBuffersPool;
+        std::list<TrackedCommandBufferPtr> m_SpareListNodes;
+
+        void beginSubmitBatch();
+        bool isSubmitBatchEmpty() const;
+        SubmitBatch getSubmitBatchEnd(size_t index) const;
+        void submitLegacy();
     };
 
+    struct MemoryBlock;
+
+    // Key of a device memory allocation in ResidencyTracker
+    inline uint64_t getResidencyKey(vk::DeviceMemory memory) { return uint64_t(VkDeviceMemory(memory)); }
+
     class MemoryResource
     {
     public:
         bool managed = true;
         vk::DeviceMemory memory;
+
+        // Set when the resource is placed in a shared memory block, see DeviceDesc::enableMemorySuballocation.
+        // In that case, 'memory' is the block's memory and the resource starts at 'memoryOffset' in it.
+        MemoryBlock* memoryBlock = nullptr;
+        TlsfAllocator::Allocation suballocation;
+        vk::DeviceSize memoryOffset = 0;
+        void* mappedBlockMemory = nullptr; // pointer to the resource in a persistently mapped block
+
+        // Set when the memory is counted in the device memory statistics, see VulkanAllocator::trackMemory
+        uint64_t trackedMemorySize = 0;
+        MemoryCategory memoryCategory = MemoryCategory::Buffers;
+
+        [[nodiscard]] bool isSuballocated() const { return memoryBlock != nullptr; }
+    };
+
+    struct MemoryBlock
+    {
+        vk::DeviceMemory memory;
+        void* mappedMemory = nullptr;
+        uint32_t memoryTypeIndex = 0;
+        bool forImages = false;
+        TlsfAllocator allocator;
+
+        explicit MemoryBlock(uint64_t size)
+            : allocator(size)
+        { }
     };
 
     class VulkanAllocator
@@ -319,11 +521,16 @@ namespace nvrhi::vulkan
             : m_Context(context)
         { }
 
-        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false) const;
-        void freeBufferMemory(Buffer* buffer) const;
+        ~VulkanAllocator();
+
+        // Enables placing buffers and textures into shared memory blocks of the given size
+        void enableSuballocation(uint64_t blockSize);
 
-        vk::Result allocateTextureMemory(Texture* texture) const;
-        void freeTextureMemory(Texture* texture) const;
+        vk::Result allocateBufferMemory(Buffer* buffer, bool enableBufferAddress = false);
+        void freeBufferMemory(Buffer* buffer);
+
+        vk::Result allocateTextureMemory(Texture* texture);
+        void freeTextureMemory(Texture* texture);
 
         vk::Result allocateMemory(MemoryResource* res,
             vk::MemoryRequirements memRequirements,
@@ -332,10 +539,25 @@ namespace nvrhi::vulkan
             bool enableExportMemory = false,
             VkImage dedicatedImage = nullptr,
             VkBuffer dedicatedBuffer = nullptr) const;
-        void freeMemory(MemoryResource* res) const;
+        void freeMemory(MemoryResource* res);
+
+        // Frees the memory blocks that have no resources placed in them, returns the number of bytes released
+        uint64_t releaseEmptyBlocks();
 
     private:
         const VulkanContext& m_Context;
+
+        std::mutex m_Mutex;
+        uint64_t m_BlockSize = 0;
+        std::vector<std::unique_ptr<MemoryBlock>> m_Blocks;
+
+        [[nodiscard]] uint32_t findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memPropertyFlags) const;
+        [[nodiscard]] bool shouldSuballocate(const vk::MemoryRequirements& memRequirements, const vk::MemoryDedicatedRequirements& dedicatedRequirements, bool enableExportMemory) const;
+        vk::Result suballocateMemory(MemoryResource* res, vk::MemoryRequirements memRequirements, vk::MemoryPropertyFlags memPropertyFlags, bool forImages);
+        MemoryBlock* createBlock(uint32_t memoryTypeIndex, uint64_t minSize, bool forImages);
+
+        // Counts the memory of a resource in its category until freeMemory
+        void trackMemory(MemoryResource* res, uint64_t size, const std::string& debugName) const;
     };
 
     class Heap : public MemoryResource, public RefCounter<IHeap>
@@ -350,6 +572,7 @@ namespace nvrhi::vulkan
         HeapDesc desc;
         
         const HeapDesc& getDesc() override { return desc; }
+        Object getNativeObject(ObjectType objectType) override;
 
     private:
         VulkanAllocator& m_Allocator;
@@ -378,7 +601,7 @@ namespace nvrhi::vulkan
         }
     };
 
-    class Texture : public MemoryResource, public RefCounter<ITexture>, public TextureStateExtension
+    class Texture : public MemoryResource, public DeferredRefCounter<ITexture>, public TextureStateExtension
     {
     public:
 
@@ -426,7 +649,7 @@ namespace nvrhi::vulkan
 
         // contains subresource views for this texture
         // note that we only create the views that the app uses, and that multiple views may map to the same subresources
-        std::unordered_map<SubresourceViewKey, TextureSubresourceView, Texture::Hash> subresourceViews;
+        ViewCache<SubresourceViewKey, TextureSubresourceView, Texture::Hash> subresourceViews;
 
         Texture(const VulkanContext& context, VulkanAllocator& allocator)
             : TextureStateExtension(desc)
@@ -451,7 +674,7 @@ namespace nvrhi::vulkan
     private:
         const VulkanContext& m_Context;
         VulkanAllocator& m_Allocator;
-        std::mutex m_Mutex;
+        std::atomic<TextureSubresourceView*> m_DefaultView = nullptr;
     };
 
     /* ----------------------------------------------------------------------------
@@ -511,6 +734,11 @@ namespace nvrhi::vulkan
             pending or submitted. If pending, it matches the recordingID field of 
             TrackedCommandBuffer, otherwise the submissionID.
 
+    Versions are allocated in ring order: Buffer::nextVersion is atomically incremented
+    to pick the next candidate, so that concurrent writers don't need to search or
+    retry on the same version. Since versions retire in approximately the same order,
+    the candidate is nearly always available, and if it's not, the next one is tried.
+
     When a buffer version is allocated, it is transitioned into the pending state.
     When the command list containing such pending versions is submitted, all the
     pending versions are transitioned to the submitted state. In the submitted 
@@ -530,9 +758,11 @@ namespace nvrhi::vulkan
     struct VolatileBufferState
     {
         int latestVersion = 0;
-        int minVersion = 0;
-        int maxVersion = 0;
-        bool initialized = false;
+
+        // Versions written in this command list, as a range in the ring of versions that may wrap around:
+        // firstVersion, firstVersion + 1, ... modulo maxVersions, numVersions in total
+        uint32_t firstVersion = 0;
+        uint32_t numVersions = 0;
     };
     
     // A copyable version of std::atomic to be used in an std::vector
@@ -555,7 +785,7 @@ namespace nvrhi::vulkan
         }
     };
 
-    class Buffer : public MemoryResource, public RefCounter<IBuffer>, public BufferStateExtension
+    class Buffer : public MemoryResource, public DeferredRefCounter<IBuffer>, public BufferStateExtension
     {
     public:
         BufferDesc desc;
@@ -570,7 +800,7 @@ namespace nvrhi::vulkan
         std::vector<BufferVersionItem> versionTracking;
         void* mappedMemory = nullptr;
         void* sharedHandle = nullptr;
-        uint32_t versionSearchStart = 0;
+        std::atomic<uint32_t> nextVersion = 0;
 
         // For staging buffers only
         CommandQueue lastUseQueue = CommandQueue::Graphics;
@@ -725,6 +955,83 @@ namespace nvrhi::vulkan
         utils::BitSetAllocator& m_QueryAllocator;
     };
 
+    class OcclusionQuery : public RefCounter<IOcclusionQuery>
+    {
+    public:
+        OcclusionQueryType type = OcclusionQueryType::SampleCount;
+        int queryIndex = -1;
+
+        bool started = false;
+        bool resolved = false;
+        uint64_t result = 0;
+
+        explicit OcclusionQuery(utils::BitSetAllocator& allocator)
+            : m_QueryAllocator(allocator)
+        { }
+
+        ~OcclusionQuery() override;
+
+        OcclusionQueryType getType() const override { return type; }
+
+    private:
+        utils::BitSetAllocator& m_QueryAllocator;
+    };
+
+    class PipelineStatisticsQuery : public RefCounter<IPipelineStatisticsQuery>
+    {
+    public:
+        int queryIndex = -1;
+
+        bool started = false;
+        bool resolved = false;
+        PipelineStatistics result;
+
+        explicit PipelineStatisticsQuery(utils::BitSetAllocator& allocator)
+            : m_QueryAllocator(allocator)
+        { }
+
+        ~PipelineStatisticsQuery() override;
+
+    private:
+        utils::BitSetAllocator& m_QueryAllocator;
+    };
+
+    class TimerQueryPool : public RefCounter<ITimerQueryPool>
+    {
+    public:
+        struct Frame
+        {
+            uint64_t frameIndex = 0; // 0 if the slot was never used
+
+            // set when the command list that resolves the frame is executed
+            CommandQueue queue = CommandQueue::Graphics;
+            uint64_t submissionID = 0;
+        };
+
+        TimerQueryPoolDesc desc;
+        vk::QueryPool queryPool;
+
+        std::vector<Frame> frames;
+        std::atomic<uint64_t> currentFrameIndex = 0;
+        std::mutex mutex;
+
+        explicit TimerQueryPool(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        Frame& getFrame(uint64_t frameIndex) { return frames[(frameIndex - 1) % frames.size()]; }
+        [[nodiscard]] uint32_t getFirstQuery(uint64_t frameIndex) const { return uint32_t((frameIndex - 1) % frames.size()) * desc.maxQueriesPerFrame * 2; }
+
+        ~TimerQueryPool() override;
+
+        const TimerQueryPoolDesc& getDesc() const override { return desc; }
+        uint64_t getCurrentFrameIndex() const override { return currentFrameIndex; }
+        Object getNativeObject(ObjectType objectType) override;
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
     class Framebuffer : public RefCounter<IFramebuffer>
     {
     public:
@@ -755,9 +1062,16 @@ namespace nvrhi::vulkan
 
         vk::DescriptorSetLayout descriptorSetLayout;
 
-        // descriptor pool size information per binding set
+        // Set when desc.usePushDescriptors is set and the device can push the layout's descriptors,
+        // binding sets of such layouts have no descriptor set
+        bool usesPushDescriptors = false;
+
+        // descriptor pool size information per binding set, empty for push descriptor layouts
         std::vector<vk::DescriptorPoolSize> descriptorPoolSizeInfo;
 
+        // Set for bindless layouts created with UPDATE_AFTER_BIND, their pools need the matching flag
+        bool updateAfterBind = false;
+
         BindingLayout(const VulkanContext& context, const BindingLayoutDesc& desc);
         BindingLayout(const VulkanContext& context, const BindlessLayoutDesc& desc);
         ~BindingLayout() override;
@@ -772,6 +1086,158 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
+    // Inline uniform blocks take one pool descriptor per byte and at least 4 bytes each, so the pool sizes
+    // bound the number of inline uniform block bindings in the sets allocated from a pool
+    uint32_t getMaxInlineUniformBlockBindings(const std::vector<vk::DescriptorPoolSize>& poolSizes);
+
+    // Allocates descriptor sets for binding sets from shared pools instead of creating a dedicated
+    // vk::DescriptorPool for every binding set, see DeviceDesc::enableDescriptorPoolAllocator.
+    // Pools are grouped into size classes keyed by BindingLayout::descriptorPoolSizeInfo, so every set
+    // in a pool consumes the same number of descriptors and a freed set can always be reallocated.
+    // Released sets are not returned to their pool until every queue has finished the work that was
+    // submitted before the release, which keeps sets created with trackLiveness = false safe as well.
+    class DescriptorPoolAllocator
+    {
+    public:
+        typedef std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> QueueArray;
+
+        DescriptorPoolAllocator(const VulkanContext& context, const QueueArray& queues, uint32_t setsPerPool)
+            : m_Context(context)
+            , m_Queues(queues)
+            , m_SetsPerPool(std::max(setsPerPool, 1u))
+        { }
+
+        ~DescriptorPoolAllocator();
+
+        vk::Result allocateDescriptorSet(const BindingLayout* layout, vk::DescriptorPool& outPool, vk::DescriptorSet& outSet);
+        void releaseDescriptorSet(const BindingLayout* layout, vk::DescriptorPool pool, vk::DescriptorSet set);
+
+        // returns the released sets that are no longer in use by any queue to their pools
+        void retireReleasedSets();
+
+    private:
+        struct Pool
+        {
+            vk::DescriptorPool pool;
+            uint32_t freeSets = 0;
+        };
+
+        struct SizeClass
+        {
+            std::vector<vk::DescriptorPoolSize> setSizes;
+            std::vector<Pool> pools;
+        };
+
+        struct ReleasedSet
+        {
+            SizeClass* sizeClass = nullptr;
+            size_t poolIndex = 0;
+            vk::DescriptorSet set;
+            std::array<uint64_t, uint32_t(CommandQueue::Count)> lastSubmittedIDs{};
+        };
+
+        struct SizeClassHash
+        {
+            std::size_t operator()(std::vector<vk::DescriptorPoolSize> const& sizes) const noexcept
+            {
+                size_t hash = 0;
+                for (const auto& size : sizes)
+                {
+                    hash_combine(hash, uint32_t(size.type));
+                    hash_combine(hash, size.descriptorCount);
+                }
+                return hash;
+            }
+        };
+
+        const VulkanContext& m_Context;
+        const QueueArray& m_Queues;
+        uint32_t m_SetsPerPool;
+
+        std::mutex m_Mutex;
+        std::unordered_map<std::vector<vk::DescriptorPoolSize>, std::unique_ptr<SizeClass>, SizeClassHash> m_SizeClasses;
+        std::vector<ReleasedSet> m_ReleasedSets;
+
+        SizeClass* getSizeClass(const std::vector<vk::DescriptorPoolSize>& setSizes);
+        vk::Result createPool(SizeClass& sizeClass);
+        void retireReleasedSetsInternal();
+    };
+
+    // Owns the descriptor buffer used when DeviceDesc::enableDescriptorBuffer is set and sub-allocates the descriptor
+    // ranges of binding sets and descriptor tables from it. The buffer holds both resource and sampler descriptors and
+    // stays mapped, so descriptors are written with vkGetDescriptorEXT directly into its memory.
+    // Like with DescriptorPoolAllocator, released ranges are only reused once every queue has finished the work
+    // that was submitted before the release.
+    class DescriptorBufferAllocator
+    {
+    public:
+        typedef std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> QueueArray;
+
+        DescriptorBufferAllocator(const VulkanContext& context, VulkanAllocator& allocator, const QueueArray& queues, uint64_t size);
+
+        // creates and maps the buffer
+        vk::Result initialize();
+
+        // returns an invalid allocation when the buffer is full
+        TlsfAllocator::Allocation allocate(uint64_t size);
+        void release(const TlsfAllocator::Allocation& allocation);
+
+        // for ranges that are only referenced by command buffers that have finished execution
+        void releaseImmediately(const TlsfAllocator::Allocation& allocation);
+
+        // size of the ranges that are allocated or waiting to be retired
+        [[nodiscard]] uint64_t getUsedSize();
+
+        // returns the released ranges that are no longer in use by any queue
+        void retireReleasedRanges();
+
+        [[nodiscard]] uint8_t* getMappedMemory(uint64_t offset) const { return m_MappedMemory + offset; }
+        [[nodiscard]] vk::DescriptorBufferBindingInfoEXT getBindingInfo() const;
+        [[nodiscard]] size_t getDescriptorSize(vk::DescriptorType descriptorType) const;
+
+        // Translates descriptor set writes into descriptors in the range of a set with the given layout that starts
+        // at 'offset'. Texel buffer writes carry a vk::DescriptorAddressInfoEXT in pNext instead of a buffer view.
+        void writeDescriptors(const BindingLayout* layout, uint64_t offset, const vk::WriteDescriptorSet* writes, size_t numWrites) const;
+
+        // writes a uniform buffer descriptor at an absolute offset in the buffer
+        void writeUniformBufferDescriptor(uint64_t offset, vk::DeviceAddress address, vk::DeviceSize range) const;
+
+    private:
+        struct ReleasedRange
+        {
+            TlsfAllocator::Allocation allocation;
+            std::array<uint64_t, uint32_t(CommandQueue::Count)> lastSubmittedIDs{};
+        };
+
+        const VulkanContext& m_Context;
+        VulkanAllocator& m_Allocator;
+        const QueueArray& m_Queues;
+
+        RefCountPtr<Buffer> m_Buffer;
+        uint8_t* m_MappedMemory = nullptr;
+        vk::DeviceAddress m_DeviceAddress = 0;
+
+        std::mutex m_Mutex;
+        TlsfAllocator m_Ranges;
+        std::vector<ReleasedRange> m_ReleasedRanges;
+
+        void retireReleasedRangesInternal();
+    };
+
+    // Descriptor writes collected for the bindings of a binding set, see BindingSet::writeDescriptors
+    struct BindingSetWrites
+    {
+        std::vector<vk::DescriptorImageInfo> descriptorImageInfo;
+        std::vector<vk::DescriptorBufferInfo> descriptorBufferInfo;
+        std::vector<vk::WriteDescriptorSet> descriptorWriteInfo;
+        std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> accelStructWriteInfo;
+        std::vector<vk::DescriptorAddressInfoEXT> texelBufferAddressInfo;
+        std::vector<vk::WriteDescriptorSetInlineUniformBlockEXT> inlineUniformBlockWriteInfo;
+
+        // clears the arrays, keeping their memory
+        void reset(size_t numBindings);
+    };
+
     // contains a vk::DescriptorSet
     class BindingSet : public RefCounter<IBindingSet>
     {
@@ -779,13 +1245,30 @@ namespace nvrhi::vulkan
         BindingSetDesc desc;
         BindingLayoutHandle layout;
 
-        // TODO: move pool to the context instead
+        // The pool is either owned by this binding set or shared, when poolAllocator is not null.
+        // Transient binding sets leave it empty because their set is owned by the command buffer.
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
+        DescriptorPoolAllocator* poolAllocator = nullptr;
+
+        // Used instead of the descriptor set when the device uses a descriptor buffer
+        TlsfAllocator::Allocation descriptorBufferRange;
 
         std::vector<ResourceHandle> resources;
         static_vector<Buffer*, c_MaxVolatileConstantBuffersPerLayout> volatileConstantBuffers;
 
+        // offsets of the volatile constant buffer descriptors in descriptorBufferRange, parallel to volatileConstantBuffers
+        static_vector<vk::DeviceSize, c_MaxVolatileConstantBuffersPerLayout> volatileConstantBufferDescriptorOffsets;
+
+        // Used instead of the descriptor set when the layout uses push descriptors, see CommandList::pushDescriptorSet.
+        // The writes point into the info arrays. The volatile constant buffer infos are patched into copies of the writes
+        // when they're pushed, their indices in pushBufferInfos are parallel to volatileConstantBuffers.
+        std::vector<vk::WriteDescriptorSet> pushDescriptorWrites;
+        std::vector<vk::DescriptorImageInfo> pushImageInfos;
+        std::vector<vk::DescriptorBufferInfo> pushBufferInfos;
+        std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> pushAccelStructInfos;
+        static_vector<uint32_t, c_MaxVolatileConstantBuffersPerLayout> pushVolatileBufferInfoIndices;
+
         std::vector<uint16_t> bindingsThatNeedTransitions;
         bool hasUavBindings = false;
 
@@ -794,6 +1277,14 @@ namespace nvrhi::vulkan
         { }
 
         ~BindingSet() override;
+
+        // writes the descriptors for all bindings in desc into descriptorSet, using the arrays in writes as scratch space
+        void writeDescriptors(BindingSetWrites& writes);
+
+        // Returns a transient binding set object to its initial state before it is reused, see CommandList::createTransientBindingSet.
+        // The descriptor set and descriptor buffer range belong to the command buffer and are not released here.
+        void resetTransient();
+
         const BindingSetDesc* getDesc() const override { return &desc; }
         IBindingLayout* getLayout() const override { return layout; }
         Object getNativeObject(ObjectType objectType) override;
@@ -811,6 +1302,9 @@ namespace nvrhi::vulkan
         vk::DescriptorPool descriptorPool;
         vk::DescriptorSet descriptorSet;
 
+        // Used instead of the descriptor set when the device uses a descriptor buffer, sized for 'capacity'
+        TlsfAllocator::Allocation descriptorBufferRange;
+
         explicit DescriptorTable(const VulkanContext& context)
             : m_Context(context)
         { }
@@ -828,6 +1322,17 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
+    // Descriptor writes collected for one or more items of a descriptor table, submitted in one update
+    struct DescriptorTableWrites
+    {
+        std::vector<vk::DescriptorImageInfo> descriptorImageInfo;
+        std::vector<vk::DescriptorBufferInfo> descriptorBufferInfo;
+        std::vector<vk::WriteDescriptorSet> descriptorWriteInfo;
+        std::vector<vk::DescriptorAddressInfoEXT> texelBufferAddressInfo;
+
+        void reserve(size_t numItems);
+    };
+
     template <typename T>
     using BindingVector = static_vector<T, c_MaxBindingLayouts>;
 
@@ -840,6 +1345,25 @@ namespace nvrhi::vulkan
         VulkanContext const& context,
         BindingLayoutVector const& inBindingLayouts);
 
+    // One of the four state subsets of a graphics pipeline built with VK_EXT_graphics_pipeline_library
+    class GraphicsPipelineLibrary
+    {
+    public:
+        vk::Pipeline pipeline;
+        vk::PipelineLayout pipelineLayout; // only the shader subsets have a layout
+
+        explicit GraphicsPipelineLibrary(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~GraphicsPipelineLibrary();
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
+    typedef std::shared_ptr<GraphicsPipelineLibrary> GraphicsPipelineLibraryPtr;
+
     class GraphicsPipeline : public RefCounter<IGraphicsPipeline>
     {
     public:
@@ -853,6 +1377,12 @@ namespace nvrhi::vulkan
         vk::ShaderStageFlags pushConstantVisibility;
         bool usesBlendConstants = false;
 
+        // A pipeline linked from libraries starts out fast-linked in 'pipeline' and gets the link-time optimized
+        // version here once a pipeline compiler thread has built it. The fast-linked one is kept until destruction
+        // because the command buffers recorded before the swap may still use it.
+        std::atomic<VkPipeline> optimizedPipeline = VK_NULL_HANDLE;
+        std::array<GraphicsPipelineLibraryPtr, 4> libraries; // released after the optimized link
+
         explicit GraphicsPipeline(const VulkanContext& context)
             : m_Context(context)
         { }
@@ -862,8 +1392,104 @@ namespace nvrhi::vulkan
         const FramebufferInfo& getFramebufferInfo() const override { return framebufferInfo; }
         Object getNativeObject(ObjectType objectType) override;
 
+        vk::Pipeline getBindablePipeline() const
+        {
+            const VkPipeline optimized = optimizedPipeline.load(std::memory_order_acquire);
+            return optimized != VK_NULL_HANDLE ? vk::Pipeline(optimized) : pipeline;
+        }
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
+    // Precompiled vertex input, pre-rasterization, fragment shader and fragment output libraries,
+    // shared by all graphics pipelines that have the same state for a subset.
+    // The entries keep the shaders and layouts in their keys alive; evictUnused() drops the entries
+    // that no pipeline uses and whose keys reference objects that nothing else holds anymore.
+    class GraphicsPipelineLibraryCache
+    {
+    public:
+        explicit GraphicsPipelineLibraryCache(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        // Gets or creates the libraries for 'pso' and fast-links them into pso->pipeline.
+        // The libraries take their state from pipelineInfo, the complete description of the pipeline.
+        vk::Result linkPipeline(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo,
+            const vk::PipelineRenderingCreateInfo& renderingInfo);
+
+        // Builds the link-time optimized version of a pipeline created by linkPipeline and publishes it
+        // in pso->optimizedPipeline. Called on a pipeline compiler thread.
+        void optimizePipeline(GraphicsPipeline* pso);
+
+        void evictUnused();
+
     private:
+        struct VertexInputKey
+        {
+            InputLayoutHandle inputLayout;
+            PrimitiveType primType = PrimitiveType::TriangleList;
+
+            bool operator ==(const VertexInputKey& other) const;
+            bool isStale() const;
+            struct Hash { size_t operator()(const VertexInputKey& key) const; };
+        };
+
+        struct PreRasterizationKey
+        {
+            ShaderHandle VS, HS, DS, GS;
+            BindingLayoutVector bindingLayouts;
+            RasterState rasterState;
+            uint32_t patchControlPoints = 0;
+            VariableRateShadingState shadingRateState;
+            bool hasShadingRateAttachment = false;
+
+            bool operator ==(const PreRasterizationKey& other) const;
+            bool isStale() const;
+            struct Hash { size_t operator()(const PreRasterizationKey& key) const; };
+        };
+
+        struct FragmentShaderKey
+        {
+            ShaderHandle PS;
+            BindingLayoutVector bindingLayouts;
+            DepthStencilState depthStencilState;
+            VariableRateShadingState shadingRateState;
+            Format depthFormat = Format::UNKNOWN;
+            uint32_t sampleCount = 1;
+            bool alphaToCoverageEnable = false;
+            bool hasShadingRateAttachment = false;
+
+            bool operator ==(const FragmentShaderKey& other) const;
+            bool isStale() const;
+            struct Hash { size_t operator()(const FragmentShaderKey& key) const; };
+        };
+
+        struct FragmentOutputKey
+        {
+            FramebufferInfo framebufferInfo;
+            BlendState blendState;
+
+            bool operator ==(const FragmentOutputKey& other) const;
+            bool isStale() const { return false; }
+            struct Hash { size_t operator()(const FragmentOutputKey& key) const; };
+        };
+
+        template<typename TKey>
+        using LibraryMap = std::unordered_map<TKey, GraphicsPipelineLibraryPtr, typename TKey::Hash>;
+
         const VulkanContext& m_Context;
+        std::mutex m_Mutex;
+        LibraryMap<VertexInputKey> m_VertexInputLibraries;
+        LibraryMap<PreRasterizationKey> m_PreRasterizationLibraries;
+        LibraryMap<FragmentShaderKey> m_FragmentShaderLibraries;
+        LibraryMap<FragmentOutputKey> m_FragmentOutputLibraries;
+
+        template<typename TKey>
+        GraphicsPipelineLibraryPtr getLibrary(LibraryMap<TKey>& map, const TKey& key, const std::function<GraphicsPipelineLibraryPtr()>& create);
+
+        GraphicsPipelineLibraryPtr createLibrary(vk::GraphicsPipelineLibraryFlagsEXT subset, vk::GraphicsPipelineCreateInfo info,
+            vk::PipelineCreateFlags flags, const void* renderingInfo, const BindingLayoutVector* bindingLayouts);
     };
 
     class ComputePipeline : public RefCounter<IComputePipeline>
@@ -915,6 +1541,34 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
     };
 
+    class CommandSignature : public RefCounter<ICommandSignature>
+    {
+    public:
+        CommandSignatureDesc desc;
+        RefCountPtr<IResource> pipeline;
+        IndirectArgumentType action = IndirectArgumentType::Draw;
+        uint32_t byteStride = 0;
+
+        // Only created for signatures with state-changing arguments, which are executed as device-generated commands
+        vk::IndirectCommandsLayoutEXT indirectCommandsLayout;
+        vk::Pipeline nativePipeline;
+        vk::ShaderStageFlags shaderStages;
+        bool changesVertexBuffers = false;
+        bool changesIndexBuffer = false;
+
+        explicit CommandSignature(const VulkanContext& context)
+            : m_Context(context)
+        { }
+
+        ~CommandSignature() override;
+
+        const CommandSignatureDesc& getDesc() const override { return desc; }
+        Object getNativeObject(ObjectType objectType) override;
+
+    private:
+        const VulkanContext& m_Context;
+    };
+
     class RayTracingPipeline : public RefCounter<rt::IPipeline>
     {
     public:
@@ -925,7 +1579,7 @@ namespace nvrhi::vulkan
         vk::Pipeline pipeline;
         vk::ShaderStageFlags pushConstantVisibility;
 
-        std::unordered_map<std::string, uint32_t> shaderGroups; // name -> index
+        std::unordered_map<std::string, uint32_t> shaderGroups; // name -> index, which is also the rt::ShaderExportId
         std::vector<uint8_t> shaderGroupHandles;
 
         explicit RayTracingPipeline(const VulkanContext& context, Device* device)
@@ -938,7 +1592,8 @@ namespace nvrhi::vulkan
         rt::ShaderTableHandle createShaderTable(rt::ShaderTableDesc const& stDesc) override;
         Object getNativeObject(ObjectType objectType) override;
 
-        int findShaderGroup(const std::string& name); // returns -1 if not found
+        rt::ShaderExportId getShaderExportId(const char* exportName) const override;
+        bool isValidShaderExport(rt::ShaderExportId exportId) const;
         uint32_t getShaderTableEntrySize() const { return m_Context.rayTracingPipelineProperties.shaderGroupBaseAlignment; }
 
     private:
@@ -949,6 +1604,7 @@ namespace nvrhi::vulkan
     struct ShaderTableState
     {
         uint32_t version = 0;
+        uint32_t layoutVersion = 0;
         vk::StridedDeviceAddressRegionKHR rayGen;
         vk::StridedDeviceAddressRegionKHR miss;
         vk::StridedDeviceAddressRegionKHR hitGroups;
@@ -967,6 +1623,16 @@ namespace nvrhi::vulkan
 
         uint32_t version = 0;
 
+        // Cached tables keep each section at a fixed place in the cache, with room for the reserved number of records.
+        // The layout version changes when a reservation grows, which requires uploading the whole table again.
+        uint32_t missCapacity = 0;
+        uint32_t hitGroupCapacity = 0;
+        uint32_t callableCapacity = 0;
+        uint32_t layoutVersion = 1;
+
+        // Indices of the cache records modified since the last upload
+        std::vector<uint32_t> dirtyRecords;
+
         BufferHandle cache;
         ShaderTableState cacheState;
 
@@ -974,9 +1640,24 @@ namespace nvrhi::vulkan
             : pipeline(_pipeline)
             , m_Context(context)
             , m_Desc(desc)
-        { }
+        {
+            if (desc.isCached)
+            {
+                missCapacity = desc.reservedMissShaders;
+                hitGroupCapacity = desc.reservedHitGroups;
+                callableCapacity = desc.reservedCallableShaders;
+            }
+        }
         
-        size_t getUploadSize() const { return pipeline->getShaderTableEntrySize() * size_t(getNumEntries()); }
+        uint32_t getMissShaderBase() const { return 1; }
+        uint32_t getHitGroupBase() const { return getMissShaderBase() + (m_Desc.isCached ? missCapacity : uint32_t(missShaders.size())); }
+        uint32_t getCallableShaderBase() const { return getHitGroupBase() + (m_Desc.isCached ? hitGroupCapacity : uint32_t(hitGroups.size())); }
+        uint32_t getNumRecords() const { return getCallableShaderBase() + (m_Desc.isCached ? callableCapacity : uint32_t(callableShaders.size())); }
+        size_t getUploadSize() const { return pipeline->getShaderTableEntrySize() * size_t(getNumRecords()); }
+        bool canUpdateRecords(ShaderTableState const& state) const { return m_Desc.isCached && state.layoutVersion == layoutVersion; }
+        int getRecordShaderGroup(uint32_t recordIndex) const;
+        void writeRecord(uint8_t* cpuVA, uint32_t recordIndex) const;
+        void fillRegions(vk::DeviceAddress gpuVA, ShaderTableState& state) const;
         void bake(uint8_t* cpuVA, vk::DeviceAddress gpuVA, ShaderTableState& state);
 
         rt::ShaderTableDesc const& getDesc() const override { return m_Desc; }
@@ -985,7 +1666,15 @@ namespace nvrhi::vulkan
         void setRayGenerationShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addMissShader(const char* exportName, IBindingSet* bindings = nullptr) override;
         int addHitGroup(const char* exportName, IBindingSet* bindings = nullptr) override;
+        int addHitGroups(const char* const* exportNames, IBindingSet* const* bindings, size_t count) override;
+        void setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings = nullptr) override;
         int addCallableShader(const char* exportName, IBindingSet* bindings = nullptr) override;
+        void setRayGenerationShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addMissShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addHitGroup(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addHitGroups(const rt::ShaderExportId* exportIds, IBindingSet* const* bindings, size_t count) override;
+        void setHitGroup(uint32_t index, rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
+        int addCallableShader(rt::ShaderExportId exportId, IBindingSet* bindings = nullptr) override;
         void clearMissShaders() override;
         void clearHitShaders() override;
         void clearCallableShaders() override;
@@ -994,7 +1683,10 @@ namespace nvrhi::vulkan
         const VulkanContext& m_Context;
         rt::ShaderTableDesc const m_Desc;
 
-        bool verifyShaderGroupExists(const char* exportName, int shaderGroupIndex) const;
+        bool resolveExportName(const char* exportName, rt::ShaderExportId& outExportId) const;
+        bool verifyShaderExport(rt::ShaderExportId exportId) const;
+        void reserveRecords(uint32_t& capacity, size_t count);
+        void markRecordDirty(uint32_t recordIndex);
     };
 
     struct BufferChunk
@@ -1011,18 +1703,25 @@ namespace nvrhi::vulkan
     class UploadManager
     {
     public:
-        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer)
+        UploadManager(Device* pParent, uint64_t defaultChunkSize, uint64_t memoryLimit, bool isScratchBuffer, uint64_t ringSize)
             : m_Device(pParent)
             , m_DefaultChunkSize(defaultChunkSize)
             , m_MemoryLimit(memoryLimit)
             , m_IsScratchBuffer(isScratchBuffer)
-        { }
+        {
+            // Scratch memory is not mapped, ring allocation only makes sense for uploads
+            if (!isScratchBuffer)
+                m_Ring.setSize(align(ringSize, BufferChunk::c_sizeAlignment));
+        }
 
         std::shared_ptr<BufferChunk> CreateChunk(uint64_t size);
 
         bool suballocateBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA, uint64_t currentVersion, uint32_t alignment = 256);
         void submitChunks(uint64_t currentVersion, uint64_t submittedVersion);
 
+        // Adds the chunks and the ring of this manager to the statistics of its category
+        void getStatistics(MemoryStatistics& statistics) const;
+
     private:
         Device* m_Device;
         uint64_t m_DefaultChunkSize = 0;
@@ -1032,6 +1731,11 @@ namespace nvrhi::vulkan
 
         std::list<std::shared_ptr<BufferChunk>> m_ChunkPool;
         std::shared_ptr<BufferChunk> m_CurrentChunk;
+
+        RingAllocator m_Ring;
+        std::shared_ptr<BufferChunk> m_RingChunk;
+
+        bool suballocateFromRing(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA, uint64_t currentVersion, uint32_t alignment);
     };
 
     class AccelStruct : public RefCounter<rt::IAccelStruct>
@@ -1039,11 +1743,16 @@ namespace nvrhi::vulkan
     public:
         BufferHandle dataBuffer;
         std::vector<vk::AccelerationStructureInstanceKHR> instances;
+        BufferHandle instanceBuffer;
+        std::vector<rt::AccelStructHandle> instanceBufferBLASes; // per instance slot, for liveness tracking
         vk::AccelerationStructureKHR accelStruct;
         vk::DeviceAddress accelStructDeviceAddress = 0;
         rt::AccelStructDesc desc;
+        size_t builtInstances = 0;
         bool allowUpdate = false;
         bool compacted = false;
+        bool compactionPending = false; // listed in AccelStructCompaction::candidates
+        int compactedSizeQuery = -1; // index in AccelStructCompaction::queryPool, kept until the BLAS is compacted
         size_t rtxmuId = ~0ull;
         vk::Buffer rtxmuBuffer;
 
@@ -1058,6 +1767,7 @@ namespace nvrhi::vulkan
         const rt::AccelStructDesc& getDesc() const override { return desc; }
         bool isCompacted() const override { return compacted; }
         uint64_t getDeviceAddress() const override;
+        IBuffer* getInstanceBuffer() const override { return instanceBuffer; }
 
     private:
         const VulkanContext& m_Context;
@@ -1071,8 +1781,11 @@ namespace nvrhi::vulkan
         rt::OpacityMicromapDesc desc;
         bool allowUpdate = false;
         bool compacted = false;
+        bool compactionPending = false; // listed in AccelStructCompaction::micromapCandidates
+        int compactedSizeQuery = -1; // index in AccelStructCompaction::micromapQueryPool, kept until the OMM is compacted
 
-        explicit OpacityMicromap()
+        explicit OpacityMicromap(const VulkanContext& context)
+            : m_Context(context)
         { }
 
         ~OpacityMicromap() override;
@@ -1081,6 +1794,9 @@ namespace nvrhi::vulkan
         const rt::OpacityMicromapDesc& getDesc() const override { return desc; }
         bool isCompacted() const override { return compacted; }
         uint64_t getDeviceAddress() const override;
+
+    private:
+        const VulkanContext& m_Context;
     };
 
     class Device : public RefCounter<nvrhi::vulkan::IDevice>
@@ -1093,6 +1809,11 @@ namespace nvrhi::vulkan
 
         Queue* getQueue(CommandQueue queue) const { return m_Queues[int(queue)].get(); }
         vk::QueryPool getTimerQueryPool() const { return m_TimerQueryPool; }
+        vk::QueryPool getOcclusionQueryPool() const { return m_OcclusionQueryPool; }
+        vk::QueryPool getPipelineStatisticsQueryPool() const { return m_PipelineStatisticsQueryPool; }
+        Buffer* getPredicationBuffer() const { return m_PredicationBuffer; }
+        bool isOcclusionQueryPreciseSupported() const { return m_OcclusionQueryPreciseSupported; }
+
 
         // IResource implementation
 
@@ -1115,12 +1836,16 @@ namespace nvrhi::vulkan
 
         void getTextureTiling(ITexture* texture, uint32_t* numTiles, PackedMipDesc* desc, TileShape* tileShape, uint32_t* subresourceTilingsNum, SubresourceTiling* subresourceTilings) override;
         void updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
+        void updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue = CommandQueue::Graphics) override;
 
         SamplerFeedbackTextureHandle createSamplerFeedbackTexture(ITexture* pairedTexture, const SamplerFeedbackTextureDesc& desc) override;
         SamplerFeedbackTextureHandle createSamplerFeedbackForNativeTexture(ObjectType objectType, Object texture, ITexture* pairedTexture) override;
 
-        BufferHandle createBuffer(const BufferDesc& d) override;
+        BufferHandle createBuffer(const BufferDesc& d) override { return createBuffer(d, MemoryCategory::Buffers); }
+        // Creates a buffer whose memory is counted in the given category, used for the command list chunks
+        BufferHandle createBuffer(const BufferDesc& d, MemoryCategory memoryCategory);
         void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags) override;
+        void *mapBuffer(IBuffer* b, CpuAccessMode mapFlags, MapBufferFlags flags) override;
         void unmapBuffer(IBuffer* b) override;
         MemoryRequirements getBufferMemoryRequirements(IBuffer* buffer) override;
         bool bindBufferMemory(IBuffer* buffer, IHeap* heap, uint64_t offset) override;
@@ -1147,6 +1872,17 @@ namespace nvrhi::vulkan
         bool pollTimerQuery(ITimerQuery* query) override;
         float getTimerQueryTime(ITimerQuery* query) override;
         void resetTimerQuery(ITimerQuery* query) override;
+        TimerQueryPoolHandle createTimerQueryPool(const TimerQueryPoolDesc& desc) override;
+        bool getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries) override;
+        bool getTimerQueryPoolTimestamps(ITimerQueryPool* pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries) override;
+        OcclusionQueryHandle createOcclusionQuery(OcclusionQueryType type) override;
+        bool pollOcclusionQuery(IOcclusionQuery* query) override;
+        uint64_t getOcclusionQueryResult(IOcclusionQuery* query) override;
+        void resetOcclusionQuery(IOcclusionQuery* query) override;
+        PipelineStatisticsQueryHandle createPipelineStatisticsQuery() override;
+        bool pollPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        PipelineStatistics getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* query) override;
+        void resetPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
 
         GraphicsAPI getGraphicsAPI() override;
 
@@ -1163,6 +1899,11 @@ namespace nvrhi::vulkan
         MeshletPipelineHandle createMeshletPipeline(const MeshletPipelineDesc& desc, IFramebuffer* fb) override;
 
         rt::PipelineHandle createRayTracingPipeline(const rt::PipelineDesc& desc) override;
+        AsyncGraphicsPipelineHandle createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback = nullptr) override;
+        AsyncComputePipelineHandle createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback = nullptr) override;
+        AsyncMeshletPipelineHandle createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback = nullptr) override;
+        rt::AsyncPipelineHandle createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback = nullptr) override;
+        CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
 
         BindingLayoutHandle createBindingLayout(const BindingLayoutDesc& desc) override;
         BindingLayoutHandle createBindlessLayout(const BindlessLayoutDesc& desc) override;
@@ -1172,6 +1913,7 @@ namespace nvrhi::vulkan
 
         void resizeDescriptorTable(IDescriptorTable* descriptorTable, uint32_t newSize, bool keepContents = true) override;
         bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem& item) override;
+        bool writeDescriptorTable(IDescriptorTable* descriptorTable, const BindingSetItem* items, size_t numItems) override;
         
         rt::OpacityMicromapHandle createOpacityMicromap(const rt::OpacityMicromapDesc& desc) override;
         rt::AccelStructHandle createAccelStruct(const rt::AccelStructDesc& desc) override;
@@ -1182,13 +1924,21 @@ namespace nvrhi::vulkan
         CommandListHandle createCommandList(const CommandListParameters& params = CommandListParameters()) override;
         uint64_t executeCommandLists(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue = CommandQueue::Graphics) override;
         void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance) override;
+        void queueWaitForCommandList(CommandQueue waitQueue, CommandQueue executionQueue, uint64_t instance, VkPipelineStageFlags2 waitStageMask) override;
+        StorageQueueHandle createStorageQueue(const StorageQueueDesc& desc) override;
         bool waitForIdle() override;
         void runGarbageCollection() override;
+        bool getVideoMemoryBudget(VideoMemoryBudget& outBudget) override;
+        MemoryStatistics getMemoryStatistics() override;
+        void setResidencyPriority(IResource* resource, ResidencyPriority priority) override;
         bool queryFeatureSupport(Feature feature, void* pInfo = nullptr, size_t infoSize = 0) override;
         FormatSupport queryFormatSupport(Format format) override;
         coopvec::DeviceFeatures queryCoopVecFeatures() override;
         size_t getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns) override;
+        void getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes) override;
         Object getNativeQueue(ObjectType objectType, CommandQueue queue) override;
+        bool getPipelineCacheData(std::vector<uint8_t>& outData) override;
+        bool mergePipelineCacheData(const void* data, size_t size) override;
         IMessageCallback* getMessageCallback() override { return m_Context.messageCallback; }
         bool isAftermathEnabled() override { return m_AftermathEnabled; }
         AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { return m_AftermathCrashDumpHelper; }
@@ -1196,8 +1946,10 @@ namespace nvrhi::vulkan
         // vulkan::IDevice implementation
         VkSemaphore getQueueSemaphore(CommandQueue queue) override;
         void queueWaitForSemaphore(CommandQueue waitQueue, VkSemaphore semaphore, uint64_t value) override;
+        void queueWaitForSemaphore(CommandQueue waitQueue, VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 waitStageMask) override;
         void queueSignalSemaphore(CommandQueue executionQueue, VkSemaphore semaphore, uint64_t value) override;
         uint64_t queueGetCompletedInstance(CommandQueue queue) override;
+        uint64_t releaseEmptyMemoryBlocks() override;
 
     private:
         // Warning m_AftermathCrashDump helper must be first due to reverse destruction order
@@ -1211,15 +1963,63 @@ namespace nvrhi::vulkan
         vk::QueryPool m_TimerQueryPool = nullptr;
         utils::BitSetAllocator m_TimerQueryAllocator;
 
+        vk::QueryPool m_OcclusionQueryPool = nullptr;
+        utils::BitSetAllocator m_OcclusionQueryAllocator;
+        RefCountPtr<Buffer> m_PredicationBuffer; // one 32-bit value per occlusion query, see CommandList::setPredication
+        bool m_OcclusionQueryPreciseSupported = false;
+
+        vk::QueryPool m_PipelineStatisticsQueryPool = nullptr;
+        utils::BitSetAllocator m_PipelineStatisticsQueryAllocator;
+        bool m_PipelineStatisticsQuerySupported = false;
+
         std::mutex m_Mutex;
 
+        // Declared before the queues because the command buffers release their ranges into it
+        std::unique_ptr<DescriptorBufferAllocator> m_DescriptorBuffer;
+
         // array of submission queues
         std::array<std::unique_ptr<Queue>, uint32_t(CommandQueue::Count)> m_Queues;
-        
-        void *mapBuffer(IBuffer* b, CpuAccessMode flags, uint64_t offset, size_t size) const;
+
+        std::unique_ptr<DescriptorPoolAllocator> m_DescriptorPoolAllocator;
+
+        PipelineCompiler m_PipelineCompiler;
+        std::unique_ptr<ObjectDeduplicationCaches> m_Deduplication;
+
+        DeferredDestructionQueue m_DeferredDestruction;
+        DeferredDestructionFlags m_DeferredDestructionFlags = DeferredDestructionFlags::None;
+
+        // Video memory budget queries and residency management, see DeviceDesc::enableResidencyManagement
+        IMemoryBudgetCallback* m_BudgetCallback = nullptr;
+        std::vector<uint64_t> m_ResidencyKeys;
+        std::vector<uint64_t> m_ResidencyChanges;
+
+        CoopVecMatrixSizeCache m_CoopVecMatrixSizes;
+
+        // Only created when VK_EXT_graphics_pipeline_library is enabled and supports fast linking
+        std::unique_ptr<GraphicsPipelineLibraryCache> m_GraphicsPipelineLibraries;
+
+        // State handoff mode, only active after the first command list with enableStateHandoff is created.
+        // Declared last so that the internal command lists are destroyed before the other members.
+        std::unique_ptr<StateHandoffResolver> m_StateHandoffResolver;
+        std::atomic<bool> m_StateHandoffUsed = false;
+        std::array<std::vector<CommandListHandle>, uint32_t(CommandQueue::Count)> m_StateHandoffCommandLists;
+        std::vector<ICommandList*> m_StateHandoffSubmission;
+
+        void resolveStateHandoff(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue);
+
+        // Restores the memory priorities of the allocations used by the command lists before they are submitted
+        void makeReferencedResourcesResident(ICommandList* const* pCommandLists, size_t numCommandLists);
+        // Demotes unused allocations and calls the budget callback when over the budget, from runGarbageCollection
+        void updateResidency();
+        bool collectDescriptorTableWrites(DescriptorTable* descriptorTable, const BindingSetItem& binding, DescriptorTableWrites& writes);
+        void fillMeshletFeatureInfo(MeshletFeatureInfo& info) const;
+        // Queries the driver for the size of a matrix, bypassing m_CoopVecMatrixSizes
+        size_t queryCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, uint32_t rows, uint32_t columns) const;
+
+        void *mapBuffer(IBuffer* b, CpuAccessMode flags, uint64_t offset, size_t size, MapBufferFlags mapFlags = MapBufferFlags::None) const;
     };
 
-    class CommandList : public RefCounter<ICommandList>
+    class CommandList final : public RefCounter<ICommandList>
     {
     public:
         // Internal backend methods
@@ -1229,6 +2029,9 @@ namespace nvrhi::vulkan
 
         void executed(Queue& queue, uint64_t submissionID);
 
+        // Records the GPU decompression of a GDeflate storage request, see vulkan-storage.cpp
+        void decompressStorageRequest(const StorageRequest& request, const void* compressedData);
+
         // IResource implementation
 
         Object getNativeObject(ObjectType objectType) override;
@@ -1245,12 +2048,18 @@ namespace nvrhi::vulkan
         void clearSamplerFeedbackTexture(ISamplerFeedbackTexture* texture) override;
         void decodeSamplerFeedbackTexture(IBuffer* buffer, ISamplerFeedbackTexture* texture, Format format) override;
         void setSamplerFeedbackTextureState(ISamplerFeedbackTexture* texture, ResourceStates stateBits) override;
+        IBindingSet* createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* layout) override;
 
         void copyTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(IStagingTexture* dest, const TextureSlice& dstSlice, ITexture* src, const TextureSlice& srcSlice) override;
         void copyTexture(ITexture* dest, const TextureSlice& dstSlice, IStagingTexture* src, const TextureSlice& srcSlice) override;
         void writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch) override;
+        void writeTextureSubresources(ITexture* dest, const TextureSubresourceData* subresources, size_t numSubresources) override;
+        void* beginTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch) override;
+        void endTextureWrite(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel) override;
         void resolveTexture(ITexture* dest, const TextureSubresourceSet& dstSubresources, ITexture* src, const TextureSubresourceSet& srcSubresources) override;
+        void generateMips(ITexture* texture, TextureSubresourceSet subresources, bool linearFilter) override;
+        void blitTexture(ITexture* dest, const TextureSlice& destSlice, ITexture* src, const TextureSlice& srcSlice, bool linearFilter) override;
 
         void writeBuffer(IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes = 0) override;
         void clearBufferUInt(IBuffer* b, uint32_t clearValue) override;
@@ -1259,10 +2068,17 @@ namespace nvrhi::vulkan
         void setPushConstants(const void* data, size_t byteSize) override;
 
         void setGraphicsState(const GraphicsState& state) override;
+        void setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet) override;
+        void setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers) override;
+        void setIndexBuffer(const IndexBufferBinding& indexBuffer) override;
+        void setViewportState(const ViewportState& viewport) override;
         void draw(const DrawArguments& args) override;
         void drawIndexed(const DrawArguments& args) override;
         void drawIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
         void drawIndexedIndirect(uint32_t offsetBytes, uint32_t drawCount) override;
+        void drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount) override;
+        void executeBundles(ICommandList* const* bundles, size_t numBundles) override;
 
         void setComputeState(const ComputeState& state) override;
         void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
@@ -1270,22 +2086,40 @@ namespace nvrhi::vulkan
 
         void setMeshletState(const MeshletState& state) override;
         void dispatchMesh(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
+        void dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount) override;
+        void dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount) override;
+        void executeIndirect(ICommandSignature* signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes) override;
 
         void setRayTracingState(const rt::State& state) override;
         void dispatchRays(const rt::DispatchRaysArguments& args) override;
         
         void buildOpacityMicromap(rt::IOpacityMicromap* omm, const rt::OpacityMicromapDesc& desc) override;
+        void buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds) override;
+        void compactOpacityMicromaps() override;
         void buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags) override;
+        void buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds) override;
         void compactBottomLevelAccelStructs() override;
         void buildTopLevelAccelStruct(rt::IAccelStruct* as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags) override;
         void buildTopLevelAccelStructFromBuffer(rt::IAccelStruct* as, nvrhi::IBuffer* instanceBuffer, uint64_t instanceBufferOffset, size_t numInstances,
             rt::AccelStructBuildFlags buildFlags = rt::AccelStructBuildFlags::None) override;
+        void updateTopLevelAccelStructInstances(rt::IAccelStruct* as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances) override;
         void executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc) override;
 
         void convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs) override;
 
         void beginTimerQuery(ITimerQuery* query) override;
         void endTimerQuery(ITimerQuery* query) override;
+        void beginTimerQueryFrame(ITimerQueryPool* pool) override;
+        void beginTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void endTimerQuery(ITimerQueryPool* pool, uint32_t queryIndex) override;
+        void resolveTimerQueries(ITimerQueryPool* pool) override;
+        void beginOcclusionQuery(IOcclusionQuery* query) override;
+        void endOcclusionQuery(IOcclusionQuery* query) override;
+        void beginPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void endPipelineStatisticsQuery(IPipelineStatisticsQuery* query) override;
+        void setPredication(IOcclusionQuery* query, PredicationOp op) override;
+        SyncPointHandle signalSyncPoint() override;
+        void waitSyncPoint(ISyncPoint* syncPoint, PipelineStages waitStages) override;
 
         void beginMarker(const char* name) override;
         void endMarker() override;
@@ -1306,6 +2140,10 @@ namespace nvrhi::vulkan
         void setPermanentTextureState(ITexture* texture, ResourceStates stateBits) override;
         void setPermanentBufferState(IBuffer* buffer, ResourceStates stateBits) override;
 
+        void beginTextureStateTransition(ITexture* texture, TextureSubresourceSet subresources, ResourceStates stateBits) override;
+        void beginBufferStateTransition(IBuffer* buffer, ResourceStates stateBits) override;
+        void aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter) override;
+
         void commitBarriers() override;
 
         ResourceStates getTextureSubresourceState(ITexture* texture, ArraySlice arraySlice, MipLevel mipLevel) override;
@@ -1313,8 +2151,11 @@ namespace nvrhi::vulkan
 
         IDevice* getDevice() override { return m_Device; }
         const CommandListParameters& getDesc() override { return m_CommandListParameters; }
+        MemoryStatistics getMemoryStatistics() override;
 
         TrackedCommandBufferPtr getCurrentCmdBuf() const { return m_CurrentCmdBuf; }
+        const CommandListResourceStateTracker& getStateTracker() const { return m_StateTracker; }
+        void recordStateHandoffBarriers(const StateHandoffResolver& resolver);
 
     private:
         Device* m_Device;
@@ -1335,26 +2176,96 @@ namespace nvrhi::vulkan
         vk::PipelineLayout m_CurrentPipelineLayout;
         vk::ShaderStageFlags m_CurrentPushConstantsVisibility;
         GraphicsState m_CurrentGraphicsState{};
+        PendingGraphicsState m_PendingGraphicsState;
         ComputeState m_CurrentComputeState{};
         MeshletState m_CurrentMeshletState{};
         rt::State m_CurrentRayTracingState;
         bool m_AnyVolatileBufferWrites = false;
         bool m_BindingStatesDirty = false;
+        bool m_DescriptorBufferBound = false;
+        bool m_PredicationEnabled = false;
+
+        // Framebuffer of the last rendering pass since open(), used to tell starting from resuming a pass
+        Framebuffer* m_LastRenderPassFramebuffer = nullptr;
 
         std::unordered_map<rt::IShaderTable*, std::unique_ptr<ShaderTableState>> m_UncachedShaderTableStates;
         ShaderTableState& getShaderTableState(rt::IShaderTable* shaderTable);
+        bool updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state);
+
+        // Volatile buffers written in this command list. m_VolatileBufferSlots maps Buffer::trackerIndex to
+        // the position in m_VolatileBuffers, slots with a generation other than the current one are stale.
+        struct VolatileBufferSlot
+        {
+            uint32_t generation = 0;
+            uint32_t index = 0;
+        };
+        std::vector<std::pair<Buffer*, VolatileBufferState>> m_VolatileBuffers;
+        std::vector<VolatileBufferSlot> m_VolatileBufferSlots;
+        uint32_t m_VolatileBufferGeneration = 1;
 
-        std::unordered_map<Buffer*, VolatileBufferState> m_VolatileBufferStates;
+        VolatileBufferState* getVolatileBufferState(Buffer* buffer, bool allowCreate);
+        void clearVolatileBufferStates();
+        void releaseReusableRecording();
 
         std::unique_ptr<UploadManager> m_UploadManager;
         std::unique_ptr<UploadManager> m_ScratchManager;
+
+        // Subresources between beginTextureWrite and endTextureWrite
+        struct PendingTextureWrite
+        {
+            RefCountPtr<Texture> dest;
+            uint32_t arraySlice = 0;
+            uint32_t mipLevel = 0;
+            Buffer* uploadBuffer = nullptr;
+            uint64_t uploadOffset = 0;
+            void* cpuVA = nullptr;
+            uint32_t numCols = 0;
+            uint32_t numRows = 0;
+            uint32_t rowPitch = 0;
+            vk::Extent3D extent;
+        };
+        std::vector<PendingTextureWrite> m_PendingTextureWrites;
+
+        std::vector<vk::BufferImageCopy> m_BufferImageCopies; // used locally in writeTextureSubresources
+
+        // Used locally in convertCoopVecMatrices, members to avoid re-allocations
+        std::vector<vk::ConvertCooperativeVectorMatrixInfoNV> m_CoopVecConvertInfos;
+        std::vector<size_t> m_CoopVecDstSizes;
+
+        // Used locally in createTransientBindingSet, member to avoid re-allocations
+        BindingSetWrites m_TransientBindingSetWrites;
+
+        // Used locally in pushDescriptorSet for sets with volatile constant buffers, members to avoid re-allocations
+        std::vector<vk::WriteDescriptorSet> m_PushDescriptorWrites;
+        std::vector<vk::DescriptorBufferInfo> m_PushDescriptorBufferInfos;
         
         void clearTexture(ITexture* texture, TextureSubresourceSet subresources, const vk::ClearColorValue& clearValue);
 
+        vk::Result allocateTransientDescriptorSet(const BindingLayout* layout, vk::DescriptorSet& outSet);
+
         void bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx);
+        void bindDescriptorBufferOffsets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx);
+        // Records the descriptors of a binding set whose layout uses push descriptors, with the current volatile buffer versions
+        void pushDescriptorSet(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, uint32_t set, const BindingSet* bindingSet);
 
-        void beginRenderPass(nvrhi::IFramebuffer* framebuffer);
+        void beginRenderPass(nvrhi::IFramebuffer* framebuffer, vk::RenderingFlags flags = vk::RenderingFlags());
         void endRenderPass();
+        void splitCommandBuffer(SyncPoint* signalAfter, SyncPoint* waitAfter, vk::PipelineStageFlags2 waitStages);
+        void bindIndexBuffer(const IndexBufferBinding& indexBuffer);
+        void bindVertexBuffers(const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers);
+        void setViewports(const ViewportState& viewport, const ViewportState& currentViewport);
+        void commitGraphicsStateChanges();
+
+        // Executes the commands of a signature with state-changing arguments as device-generated commands
+        void executeGeneratedCommands(CommandSignature* signature, Buffer* indirectParams, uint32_t paramOffsetBytes,
+            Buffer* indirectCount, uint32_t countOffsetBytes, uint32_t maxCommandCount);
+
+        // Bundle recording state, see CommandListParameters::isBundle.
+        // The secondary command buffer is begun by the first setGraphicsState, which provides the attachment
+        // formats that it must inherit from the rendering pass started by executeBundles.
+        BundleStateRequirements m_BundleStateRequirements;
+        Framebuffer* m_BundleFramebuffer = nullptr; // referenced by m_CurrentCmdBuf
+        void beginBundleRecording(Framebuffer* framebuffer);
 
         void insertGraphicsResourceBarriers(const GraphicsState& state);
         void insertComputeResourceBarriers(const ComputeState& state);
@@ -1379,6 +2290,10 @@ namespace nvrhi::vulkan
 
         void commitBarriersInternal();
         void commitBarriersInternal_synchronization2();
+
+        // Events of the split barriers that have begun, keyed by the state extension of the resource
+        std::unordered_map<const void*, vk::Event> m_SplitBarrierEvents;
+        vk::Event allocateSplitBarrierEvent();
     };
 
 } // namespace nvrhi::vulkan
@@ -28,7 +28,7 @@
 namespace nvrhi::vulkan
 {
 
-    BufferHandle Device::createBuffer(const BufferDesc& desc)
+    BufferHandle Device::createBuffer(const BufferDesc& desc, MemoryCategory memoryCategory)
     {
         // Check some basic constraints first - the validation layer is expected to handle them too
 
@@ -44,6 +44,10 @@ namespace nvrhi::vulkan
 
         Buffer *buffer = new Buffer(m_Context, m_Allocator);
         buffer->desc = desc;
+        buffer->memoryCategory = memoryCategory;
+
+        if ((m_DeferredDestructionFlags & DeferredDestructionFlags::Buffers) != 0)
+            buffer->setDestructionQueue(&m_DeferredDestruction);
 
         vk::BufferUsageFlags usageFlags = vk::BufferUsageFlagBits::eTransferSrc |
                                           vk::BufferUsageFlagBits::eTransferDst;
@@ -56,6 +60,10 @@ namespace nvrhi::vulkan
         
         if (desc.isDrawIndirectArgs)
             usageFlags |= vk::BufferUsageFlagBits::eIndirectBuffer;
+
+        // indirect argument buffers are also the GPU-written predicates, like on D3D12
+        if (desc.isDrawIndirectArgs && m_Context.extensions.EXT_conditional_rendering)
+            usageFlags |= vk::BufferUsageFlagBits::eConditionalRenderingEXT;
         
         if (desc.isConstantBuffer)
             usageFlags |= vk::BufferUsageFlagBits::eUniformBuffer;
@@ -117,30 +125,49 @@ namespace nvrhi::vulkan
             .setUsage(usageFlags)
             .setSharingMode(vk::SharingMode::eExclusive);
 
+        if (desc.isTiled)
+            bufferInfo.setFlags(vk::BufferCreateFlagBits::eSparseBinding | vk::BufferCreateFlagBits::eSparseResidency);
+
 #if _WIN32
         const auto handleType = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueWin32;
 #else
         const auto handleType = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd;
 #endif
         vk::ExternalMemoryBufferCreateInfo externalBuffer{ handleType };
+
+        // Scratch chunks also hold the preprocess memory of device-generated commands,
+        // see CommandList::executeGeneratedCommands. The preprocess usage only exists in the 64-bit usage flags.
+        auto usageFlags2 = vk::BufferUsageFlags2CreateInfoKHR()
+            .setUsage(vk::BufferUsageFlags2KHR(VkBufferUsageFlags2KHR(VkBufferUsageFlags(usageFlags)))
+                | vk::BufferUsageFlagBits2KHR::ePreprocessBufferEXT);
+
         if (desc.sharedResourceFlags == SharedResourceFlags::Shared)
             bufferInfo.setPNext(&externalBuffer);
+        else if (memoryCategory == MemoryCategory::ScratchChunks && m_Context.extensions.EXT_device_generated_commands)
+            bufferInfo.setPNext(&usageFlags2);
 
         vk::Result res = m_Context.device.createBuffer(&bufferInfo, m_Context.allocationCallbacks, &buffer->buffer);
         CHECK_VK_FAIL(res);
 
         m_Context.nameVKObject(VkBuffer(buffer->buffer), vk::ObjectType::eBuffer, vk::DebugReportObjectTypeEXT::eBuffer, desc.debugName.c_str());
 
-        if (!desc.isVirtual)
+        if (!desc.isVirtual && !desc.isTiled)
         {
             res = m_Allocator.allocateBufferMemory(buffer, (usageFlags & vk::BufferUsageFlagBits::eShaderDeviceAddress) != vk::BufferUsageFlags(0));
             CHECK_VK_FAIL(res)
 
-            m_Context.nameVKObject(buffer->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            // Shared memory blocks contain many resources, don't name them after one of them
+            if (!buffer->isSuballocated())
+                m_Context.nameVKObject(buffer->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
 
-            if (desc.isVolatile)
+            // Volatile and CPU-accessible buffers stay mapped for their whole lifetime,
+            // so that mapBuffer doesn't have to call vkMapMemory every time
+            if (buffer->desc.cpuAccess != CpuAccessMode::None)
             {
-                buffer->mappedMemory = m_Context.device.mapMemory(buffer->memory, 0, size);
+                if (buffer->isSuballocated())
+                    buffer->mappedMemory = buffer->mappedBlockMemory; // the allocator keeps the whole block mapped
+                else
+                    buffer->mappedMemory = m_Context.device.mapMemory(buffer->memory, 0, size);
                 assert(buffer->mappedMemory);
             }
 
@@ -160,6 +187,13 @@ namespace nvrhi::vulkan
 #endif
             }
         }
+        else if (desc.isTiled && m_Context.extensions.buffer_device_address)
+        {
+            // Sparse buffers have their address range from the start, memory is bound in updateBufferTileMappings
+            auto addressInfo = vk::BufferDeviceAddressInfo().setBuffer(buffer->buffer);
+
+            buffer->deviceAddress = m_Context.device.getBufferAddress(addressInfo);
+        }
 
         if (m_Context.logBufferLifetime)
         {
@@ -268,110 +302,145 @@ namespace nvrhi::vulkan
         return 0;
     }
 
-    void CommandList::writeVolatileBuffer(Buffer* buffer, const void* data, size_t dataSize)
+    static bool isBufferVersionAvailable(Device* device, uint64_t versionInfo)
     {
-        VolatileBufferState& state = m_VolatileBufferStates[buffer];
+        if (versionInfo == 0)
+        {
+            // Previously unused version - definitely available
+            return true;
+        }
 
-        if (!state.initialized)
+        // Decode the bitfield
+        bool isSubmitted = (versionInfo & c_VersionSubmittedFlag) != 0;
+        uint32_t queueIndex = uint32_t(versionInfo >> c_VersionQueueShift) & c_VersionQueueMask;
+        uint64_t id = versionInfo & c_VersionIDMask;
+
+        // If the version is in a recorded but not submitted command list,
+        // we can't use it. So, only compare the version ID for submitted CLs.
+        if (!isSubmitted)
+            return false;
+
+        // Versions can potentially be used in CLs submitted to different queues.
+        // So we store the queue index and use look at the last finished CL in that queue.
+
+        if (queueIndex >= uint32_t(CommandQueue::Count))
         {
-            state.minVersion = int(buffer->desc.maxVersions);
-            state.maxVersion = -1;
-            state.initialized = true;
+            // If the version points at an invalid queue, assume it's available. Signal the error too.
+            utils::InvalidEnum();
+            return true;
         }
-        
-        std::array<uint64_t, uint32_t(CommandQueue::Count)> queueCompletionValues = {
-            getQueueLastFinishedID(m_Device, CommandQueue::Graphics),
-            getQueueLastFinishedID(m_Device, CommandQueue::Compute),
-            getQueueLastFinishedID(m_Device, CommandQueue::Copy)
-        };
-
-        uint32_t searchStart = buffer->versionSearchStart;
-        uint32_t maxVersions = buffer->desc.maxVersions;
-        uint32_t version = 0;
 
-        uint64_t originalVersionInfo = 0;
+        // If the version was used in a completed CL, it's available.
+        return id <= getQueueLastFinishedID(device, CommandQueue(queueIndex));
+    }
 
-        // Since versionTracking[] can be accessed by multiple threads concurrently,
-        // perform the search in a loop ending with compare_exchange until the exchange is successful.
-        while (true)
+    VolatileBufferState* CommandList::getVolatileBufferState(Buffer* buffer, bool allowCreate)
+    {
+        if (buffer->trackerIndex < m_VolatileBufferSlots.size())
         {
-            bool found = false;
+            const VolatileBufferSlot& slot = m_VolatileBufferSlots[buffer->trackerIndex];
 
-            // Search through the versions of this buffer, looking for either unused (0)
-            // or submitted and already finished versions
+            if (slot.generation == m_VolatileBufferGeneration && m_VolatileBuffers[slot.index].first == buffer)
+                return &m_VolatileBuffers[slot.index].second;
+        }
 
-            for (uint32_t searchIndex = 0; searchIndex < maxVersions; searchIndex++)
-            {
-                version = searchIndex + searchStart;
-                version = (version >= maxVersions) ? (version - maxVersions) : version;
+        if (!allowCreate)
+            return nullptr;
 
-                originalVersionInfo = buffer->versionTracking[version];
+        if (buffer->trackerIndex >= m_VolatileBufferSlots.size())
+            m_VolatileBufferSlots.resize(size_t(buffer->trackerIndex) + 1);
 
-                if (originalVersionInfo == 0)
-                {
-                    // Previously unused version - definitely available
-                    found = true;
-                    break;
-                }
+        VolatileBufferSlot& slot = m_VolatileBufferSlots[buffer->trackerIndex];
+        slot.generation = m_VolatileBufferGeneration;
+        slot.index = uint32_t(m_VolatileBuffers.size());
 
-                // Decode the bitfield
-                bool isSubmitted = (originalVersionInfo & c_VersionSubmittedFlag) != 0;
-                uint32_t queueIndex = uint32_t(originalVersionInfo >> c_VersionQueueShift) & c_VersionQueueMask;
-                uint64_t id = originalVersionInfo & c_VersionIDMask;
+        m_VolatileBuffers.emplace_back(buffer, VolatileBufferState());
 
-                // If the version is in a recorded but not submitted command list,
-                // we can't use it. So, only compare the version ID for submitted CLs.
-                if (isSubmitted)
-                {
-                    // Versions can potentially be used in CLs submitted to different queues.
-                    // So we store the queue index and use look at the last finished CL in that queue.
-
-                    if (queueIndex >= uint32_t(CommandQueue::Count))
-                    {
-                        // If the version points at an invalid queue, assume it's available. Signal the error too.
-                        utils::InvalidEnum();
-                        found = true;
-                        break;
-                    }
-
-                    if (id <= queueCompletionValues[queueIndex])
-                    {
-                        // If the version was used in a completed CL, it's available.
-                        found = true;
-                        break;
-                    }
-                }
-            }
+        return &m_VolatileBuffers.back().second;
+    }
 
-            if (!found)
-            {
-                // Not enough versions - need to relay this information to the developer.
-                // This has to be a real message and not assert, because asserts only happen in the
-                // debug mode, and buffer versioning will behave differently in debug vs. release,
-                // or validation on vs. off, because it is timing related.
+    void CommandList::clearVolatileBufferStates()
+    {
+        m_VolatileBuffers.clear();
 
-                std::stringstream ss;
-                ss << "Volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName) <<
-                    " has maxVersions = " << buffer->desc.maxVersions << ", which is insufficient.";
+        ++m_VolatileBufferGeneration;
+        if (m_VolatileBufferGeneration == 0)
+        {
+            // The generation counter wrapped around, old slots could look valid again
+            std::fill(m_VolatileBufferSlots.begin(), m_VolatileBufferSlots.end(), VolatileBufferSlot());
+            m_VolatileBufferGeneration = 1;
+        }
+    }
 
-                m_Context.error(ss.str());
-                return;
-            }
+    void CommandList::writeVolatileBuffer(Buffer* buffer, const void* data, size_t dataSize)
+    {
+        VolatileBufferState& state = *getVolatileBufferState(buffer, true);
 
-            // Encode the current CL ID for this version of the buffer, in a "pending" state
-            uint64_t newVersionInfo = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (m_CurrentCmdBuf->recordingID);
+        const uint32_t maxVersions = buffer->desc.maxVersions;
 
-            // Try to store the new version info, end the loop if we actually won this version, i.e. no other thread has claimed it
-            if (buffer->versionTracking[version].compare_exchange_weak(originalVersionInfo, newVersionInfo))
+        // Encode the current CL ID for this version of the buffer, in a "pending" state
+        const uint64_t newVersionInfo = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (m_CurrentCmdBuf->recordingID);
+
+        uint32_t version = 0;
+        bool found = false;
+
+        // Take the versions in ring order. The atomic increment gives concurrent writers different candidates,
+        // and compare_exchange resolves the rare case when two threads got the same version after a wrap-around.
+        for (uint32_t attempt = 0; attempt < maxVersions; attempt++)
+        {
+            version = buffer->nextVersion.fetch_add(1, std::memory_order_relaxed) % maxVersions;
+
+            uint64_t originalVersionInfo = buffer->versionTracking[version];
+
+            if (isBufferVersionAvailable(m_Device, originalVersionInfo) &&
+                buffer->versionTracking[version].compare_exchange_strong(originalVersionInfo, newVersionInfo))
+            {
+                found = true;
                 break;
+            }
         }
 
-        buffer->versionSearchStart = (version + 1 < maxVersions) ? (version + 1) : 0;
+        if (!found)
+        {
+            // Not enough versions - need to relay this information to the developer.
+            // This has to be a real message and not assert, because asserts only happen in the
+            // debug mode, and buffer versioning will behave differently in debug vs. release,
+            // or validation on vs. off, because it is timing related.
+
+            std::stringstream ss;
+            ss << "Volatile constant buffer " << utils::DebugNameToString(buffer->desc.debugName) <<
+                " has maxVersions = " << buffer->desc.maxVersions << ", which is insufficient.";
+
+            m_Context.error(ss.str());
+            return;
+        }
 
         // Store the current version and expand the version range in this CL
         state.latestVersion = int(version);
-        state.minVersion = std::min(int(version), state.minVersion);
-        state.maxVersion = std::max(int(version), state.maxVersion);
+        if (state.numVersions == 0)
+        {
+            state.firstVersion = version;
+            state.numVersions = 1;
+        }
+        else
+        {
+            // The versions are taken in ring order, so the range normally grows forward and wraps around
+            // at the end of the ring. Grow it in the direction that adds fewer versions.
+            const uint32_t distanceForward = (version + maxVersions - state.firstVersion) % maxVersions;
+            if (distanceForward >= state.numVersions)
+            {
+                const uint32_t distanceBackward = maxVersions - distanceForward;
+                if (distanceForward + 1 - state.numVersions <= distanceBackward)
+                {
+                    state.numVersions = distanceForward + 1;
+                }
+                else
+                {
+                    state.firstVersion = version;
+                    state.numVersions = std::min(state.numVersions + distanceBackward, maxVersions);
+                }
+            }
+        }
 
         // Finally, write the actual data
         void* hostData = (char*)buffer->mappedMemory + version * buffer->desc.byteSize;
@@ -388,24 +457,29 @@ namespace nvrhi::vulkan
 
         std::vector<vk::MappedMemoryRange> ranges;
 
-        for (auto& iter : m_VolatileBufferStates)
+        for (auto& [buffer, state] : m_VolatileBuffers)
         {
-            Buffer* buffer = iter.first;
-            VolatileBufferState& state = iter.second;
-
-            if (state.maxVersion < state.minVersion || !state.initialized)
+            if (state.numVersions == 0)
                 continue;
 
-            // Flush all the versions between min and max - that might be too conservative,
+            // Flush all the versions in the range - that might be too conservative,
             // but that should be fine - better than using potentially hundreds of ranges.
-            int numVersions = state.maxVersion - state.minVersion + 1;
+            // A range that wraps around the end of the ring takes two memory ranges.
+            const uint32_t maxVersions = buffer->desc.maxVersions;
+            const uint32_t numVersionsBeforeEnd = std::min(state.numVersions, maxVersions - state.firstVersion);
 
-            auto range = vk::MappedMemoryRange()
+            ranges.push_back(vk::MappedMemoryRange()
                 .setMemory(buffer->memory)
-                .setOffset(state.minVersion * buffer->desc.byteSize)
-                .setSize(numVersions * buffer->desc.byteSize);
+                .setOffset(buffer->memoryOffset + state.firstVersion * buffer->desc.byteSize)
+                .setSize(numVersionsBeforeEnd * buffer->desc.byteSize));
 
-            ranges.push_back(range);
+            if (numVersionsBeforeEnd < state.numVersions)
+            {
+                ranges.push_back(vk::MappedMemoryRange()
+                    .setMemory(buffer->memory)
+                    .setOffset(buffer->memoryOffset)
+                    .setSize((state.numVersions - numVersionsBeforeEnd) * buffer->desc.byteSize));
+            }
         }
 
         if (!ranges.empty())
@@ -419,21 +493,19 @@ namespace nvrhi::vulkan
         // For each volatile CB that was written in this command list, and for every version thereof,
         // we need to replace the tracking information from "pending" to "submitted".
         // This is potentially slow as there might be hundreds of versions of a buffer,
-        // but at least the find-and-replace operation is constrained to the min/max version range.
+        // but at least the find-and-replace operation is constrained to the range of versions written in this CL.
 
         uint64_t stateToFind = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (recordingID & c_VersionIDMask);
         uint64_t stateToReplace = (uint64_t(m_CommandListParameters.queueType) << c_VersionQueueShift) | (submittedID & c_VersionIDMask) | c_VersionSubmittedFlag;
 
-        for (auto& iter : m_VolatileBufferStates)
+        for (auto& [buffer, state] : m_VolatileBuffers)
         {
-            Buffer* buffer = iter.first;
-            VolatileBufferState& state = iter.second;
+            const uint32_t maxVersions = buffer->desc.maxVersions;
 
-            if (!state.initialized)
-                continue;
-
-            for (int version = state.minVersion; version <= state.maxVersion; version++)
+            for (uint32_t index = 0; index < state.numVersions; index++)
             {
+                const uint32_t version = (state.firstVersion + index) % maxVersions;
+
                 // Use compare_exchange to conditionally replace the entries equal to stateToFind with stateToReplace.
                 uint64_t expected = stateToFind;
                 buffer->versionTracking[version].compare_exchange_strong(expected, stateToReplace);
@@ -534,7 +606,8 @@ namespace nvrhi::vulkan
 
         if (mappedMemory)
         {
-            m_Context.device.unmapMemory(memory);
+            if (!isSuballocated())
+                m_Context.device.unmapMemory(memory);
             mappedMemory = nullptr;
         }
 
@@ -575,14 +648,15 @@ namespace nvrhi::vulkan
         }
     }
 
-    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, uint64_t offset, size_t size) const
+    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, uint64_t offset, size_t size, MapBufferFlags mapFlags) const
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
         assert(flags != CpuAccessMode::None);
 
-        // If the buffer has been used in a command list before, wait for that CL to complete
-        if (buffer->lastUseCommandListID != 0)
+        // If the buffer has been used in a command list before, wait for that CL to complete,
+        // unless the application has promised not to touch the data that's still in use
+        if (buffer->lastUseCommandListID != 0 && (mapFlags & MapBufferFlags::NoOverwrite) == 0)
         {
             auto& queue = m_Queues[uint32_t(buffer->lastUseQueue)];
             queue->waitCommandList(buffer->lastUseCommandListID, ~0ull);
@@ -609,6 +683,10 @@ namespace nvrhi::vulkan
         // TODO: there should be a barrier... But there can't be a command list here
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eHost, accessFlags);
 
+        if (buffer->mappedMemory)
+            return (char*)buffer->mappedMemory + offset;
+
+        // Virtual buffers are not mapped persistently because their memory is bound later
         void* ptr = nullptr;
         [[maybe_unused]] const vk::Result res = m_Context.device.mapMemory(buffer->memory, offset, size, vk::MemoryMapFlags(), &ptr);
         assert(res == vk::Result::eSuccess);
@@ -623,11 +701,19 @@ namespace nvrhi::vulkan
         return mapBuffer(buffer, flags, 0, buffer->desc.byteSize);
     }
 
+    void *Device::mapBuffer(IBuffer* _buffer, CpuAccessMode flags, MapBufferFlags mapFlags)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        return mapBuffer(buffer, flags, 0, buffer->desc.byteSize, mapFlags);
+    }
+
     void Device::unmapBuffer(IBuffer* _buffer)
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
-        m_Context.device.unmapMemory(buffer->memory);
+        if (!buffer->mappedMemory)
+            m_Context.device.unmapMemory(buffer->memory);
 
         // TODO: there should be a barrier
         // buffer->barrier(cmd, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
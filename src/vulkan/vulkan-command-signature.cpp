@@ -0,0 +1,408 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+#include <sstream>
+
+namespace nvrhi::vulkan
+{
+    CommandSignature::~CommandSignature()
+    {
+        if (indirectCommandsLayout)
+        {
+            m_Context.device.destroyIndirectCommandsLayoutEXT(indirectCommandsLayout, m_Context.allocationCallbacks);
+            indirectCommandsLayout = vk::IndirectCommandsLayoutEXT();
+        }
+    }
+
+    Object CommandSignature::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::VK_IndirectCommandsLayoutEXT:
+            return Object(indirectCommandsLayout);
+        default:
+            return nullptr;
+        }
+    }
+
+    static vk::ShaderStageFlags getPipelineShaderStages(const CommandSignatureDesc& desc)
+    {
+        vk::ShaderStageFlags stages;
+
+        if (desc.graphicsPipeline)
+        {
+            const GraphicsPipelineDesc& pipelineDesc = desc.graphicsPipeline->getDesc();
+            if (pipelineDesc.VS) stages |= vk::ShaderStageFlagBits::eVertex;
+            if (pipelineDesc.HS) stages |= vk::ShaderStageFlagBits::eTessellationControl;
+            if (pipelineDesc.DS) stages |= vk::ShaderStageFlagBits::eTessellationEvaluation;
+            if (pipelineDesc.GS) stages |= vk::ShaderStageFlagBits::eGeometry;
+            if (pipelineDesc.PS) stages |= vk::ShaderStageFlagBits::eFragment;
+        }
+        else if (desc.computePipeline)
+        {
+            stages = vk::ShaderStageFlagBits::eCompute;
+        }
+        else if (desc.meshletPipeline)
+        {
+            const MeshletPipelineDesc& pipelineDesc = desc.meshletPipeline->getDesc();
+            if (pipelineDesc.AS) stages |= vk::ShaderStageFlagBits::eTaskEXT;
+            if (pipelineDesc.MS) stages |= vk::ShaderStageFlagBits::eMeshEXT;
+            if (pipelineDesc.PS) stages |= vk::ShaderStageFlagBits::eFragment;
+        }
+
+        return stages;
+    }
+
+    CommandSignatureHandle Device::createCommandSignature(const CommandSignatureDesc& desc)
+    {
+        if (desc.arguments.empty())
+        {
+            m_Context.error("A command signature must have at least one argument");
+            return nullptr;
+        }
+
+        CommandSignatureHandle handle = CommandSignatureHandle::Create(new CommandSignature(m_Context));
+        CommandSignature* signature = checked_cast<CommandSignature*>(handle.Get());
+        signature->desc = desc;
+        signature->action = desc.arguments.back().type;
+        signature->byteStride = desc.byteStride ? desc.byteStride : desc.getPackedByteSize();
+
+        vk::PipelineLayout pipelineLayout;
+        vk::ShaderStageFlags pushConstantVisibility;
+
+        if (desc.graphicsPipeline)
+        {
+            GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(desc.graphicsPipeline);
+            signature->pipeline = pso;
+            signature->nativePipeline = pso->pipeline;
+            pipelineLayout = pso->pipelineLayout;
+            pushConstantVisibility = pso->pushConstantVisibility;
+        }
+        else if (desc.computePipeline)
+        {
+            ComputePipeline* pso = checked_cast<ComputePipeline*>(desc.computePipeline);
+            signature->pipeline = pso;
+            signature->nativePipeline = pso->pipeline;
+            pipelineLayout = pso->pipelineLayout;
+            pushConstantVisibility = pso->pushConstantVisibility;
+        }
+        else if (desc.meshletPipeline)
+        {
+            MeshletPipeline* pso = checked_cast<MeshletPipeline*>(desc.meshletPipeline);
+            signature->pipeline = pso;
+            signature->nativePipeline = pso->pipeline;
+            pipelineLayout = pso->pipelineLayout;
+            pushConstantVisibility = pso->pushConstantVisibility;
+        }
+
+        // Signatures that consist of a single action map to the regular indirect draw and dispatch commands
+        if (desc.arguments.size() == 1)
+            return handle;
+
+        if (!m_Context.extensions.EXT_device_generated_commands)
+        {
+            m_Context.error("Command signatures with state-changing arguments require VK_EXT_device_generated_commands");
+            return nullptr;
+        }
+
+        if (!signature->nativePipeline)
+        {
+            m_Context.error("Command signatures with state-changing arguments require a pipeline on Vulkan");
+            return nullptr;
+        }
+
+        const vk::PhysicalDeviceDeviceGeneratedCommandsPropertiesEXT& properties = m_Context.deviceGeneratedCommandsProperties;
+
+        signature->shaderStages = getPipelineShaderStages(desc);
+        if ((signature->shaderStages & properties.supportedIndirectCommandsShaderStages) != signature->shaderStages)
+        {
+            m_Context.error("The device does not support device-generated commands for the shader stages of the pipeline "
+                "in the command signature");
+            return nullptr;
+        }
+
+        // The token data is referenced by the tokens until the layout is created
+        const size_t numArguments = desc.arguments.size();
+        std::vector<vk::IndirectCommandsPushConstantTokenEXT> pushConstantTokens(numArguments);
+        std::vector<vk::IndirectCommandsVertexBufferTokenEXT> vertexBufferTokens(numArguments);
+        const auto indexBufferToken = vk::IndirectCommandsIndexBufferTokenEXT()
+            .setMode(vk::IndirectCommandsInputModeFlagBitsEXT::eDxgiIndexBuffer);
+
+        std::vector<vk::IndirectCommandsLayoutTokenEXT> tokens(numArguments);
+        uint32_t offset = 0;
+
+        for (size_t index = 0; index < numArguments; ++index)
+        {
+            const IndirectArgumentDesc& argument = desc.arguments[index];
+            vk::IndirectCommandsLayoutTokenEXT& token = tokens[index];
+            token.setOffset(offset);
+            offset += argument.getByteSize();
+
+            switch (argument.type)
+            {
+            case IndirectArgumentType::Draw:
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eDraw);
+                break;
+
+            case IndirectArgumentType::DrawIndexed:
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eDrawIndexed);
+                break;
+
+            case IndirectArgumentType::Dispatch:
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eDispatch);
+                break;
+
+            case IndirectArgumentType::DispatchMesh:
+                token.setType(m_Context.extensions.EXT_mesh_shader
+                    ? vk::IndirectCommandsTokenTypeEXT::eDrawMeshTasks
+                    : vk::IndirectCommandsTokenTypeEXT::eDrawMeshTasksNV);
+                break;
+
+            case IndirectArgumentType::PushConstants:
+                if (!pushConstantVisibility)
+                {
+                    m_Context.error("PushConstants indirect arguments require a pipeline with push constants in the command signature");
+                    return nullptr;
+                }
+
+                pushConstantTokens[index].setUpdateRange(vk::PushConstantRange()
+                    .setStageFlags(pushConstantVisibility)
+                    .setOffset(argument.pushConstantOffset * 4)
+                    .setSize(argument.pushConstantCount * 4));
+
+                token.setType(vk::IndirectCommandsTokenTypeEXT::ePushConstant);
+                token.setData(vk::IndirectCommandsTokenDataEXT().setPPushConstant(&pushConstantTokens[index]));
+                break;
+
+            case IndirectArgumentType::VertexBuffer:
+                vertexBufferTokens[index].setVertexBindingUnit(argument.slot);
+
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eVertexBuffer);
+                token.setData(vk::IndirectCommandsTokenDataEXT().setPVertexBuffer(&vertexBufferTokens[index]));
+                signature->changesVertexBuffers = true;
+                break;
+
+            case IndirectArgumentType::IndexBuffer:
+                // The records hold DXGI formats, like on D3D12
+                if (!(properties.supportedIndirectCommandsInputModes & vk::IndirectCommandsInputModeFlagBitsEXT::eDxgiIndexBuffer))
+                {
+                    m_Context.error("The device does not support DXGI index buffer records in device-generated commands");
+                    return nullptr;
+                }
+
+                token.setType(vk::IndirectCommandsTokenTypeEXT::eIndexBuffer);
+                token.setData(vk::IndirectCommandsTokenDataEXT().setPIndexBuffer(&indexBufferToken));
+                signature->changesIndexBuffer = true;
+                break;
+
+            case IndirectArgumentType::VolatileConstantBuffer:
+                // Device-generated commands cannot change descriptors
+                m_Context.error("VolatileConstantBuffer indirect arguments are not supported on Vulkan");
+                return nullptr;
+
+            default:
+                utils::InvalidEnum();
+                return nullptr;
+            }
+        }
+
+        auto layoutInfo = vk::IndirectCommandsLayoutCreateInfoEXT()
+            .setShaderStages(signature->shaderStages)
+            .setIndirectStride(signature->byteStride)
+            .setPipelineLayout(pipelineLayout)
+            .setTokens(tokens);
+
+        const vk::Result res = m_Context.device.createIndirectCommandsLayoutEXT(&layoutInfo, m_Context.allocationCallbacks,
+            &signature->indirectCommandsLayout);
+        CHECK_VK_FAIL(res)
+
+        return handle;
+    }
+
+    void CommandList::executeIndirect(ICommandSignature* _signature, uint32_t paramOffsetBytes, uint32_t maxCommandCount, uint32_t countOffsetBytes)
+    {
+        assert(m_CurrentCmdBuf);
+
+        CommandSignature* signature = checked_cast<CommandSignature*>(_signature);
+        const uint32_t stride = signature->byteStride;
+
+        switch (signature->action)
+        {
+        case IndirectArgumentType::Draw:
+        case IndirectArgumentType::DrawIndexed: {
+            if (m_PendingGraphicsState.any())
+                commitGraphicsStateChanges();
+
+            updateGraphicsVolatileBuffers();
+
+            Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+            Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+            assert(indirectParams);
+
+            if (signature->indirectCommandsLayout)
+            {
+                executeGeneratedCommands(signature, indirectParams, paramOffsetBytes, indirectCount, countOffsetBytes, maxCommandCount);
+                break;
+            }
+
+            const bool indexed = signature->action == IndirectArgumentType::DrawIndexed;
+
+            if (indirectCount && indexed)
+                m_CurrentCmdBuf->cmdBuf.drawIndexedIndirectCount(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes, maxCommandCount, stride);
+            else if (indirectCount)
+                m_CurrentCmdBuf->cmdBuf.drawIndirectCount(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes, maxCommandCount, stride);
+            else if (indexed)
+                m_CurrentCmdBuf->cmdBuf.drawIndexedIndirect(indirectParams->buffer, paramOffsetBytes, maxCommandCount, stride);
+            else
+                m_CurrentCmdBuf->cmdBuf.drawIndirect(indirectParams->buffer, paramOffsetBytes, maxCommandCount, stride);
+            break;
+        }
+
+        case IndirectArgumentType::Dispatch: {
+            updateComputeVolatileBuffers();
+
+            Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentComputeState.indirectParams);
+            assert(indirectParams);
+
+            if (signature->indirectCommandsLayout)
+            {
+                executeGeneratedCommands(signature, indirectParams, paramOffsetBytes,
+                    checked_cast<Buffer*>(m_CurrentComputeState.indirectCountBuffer), countOffsetBytes, maxCommandCount);
+                break;
+            }
+
+            if (m_CurrentComputeState.indirectCountBuffer)
+            {
+                m_Context.error("Dispatch command signatures cannot be used with an indirect count buffer on Vulkan");
+                return;
+            }
+
+            // There is no multi-dispatch command in Vulkan
+            for (uint32_t index = 0; index < maxCommandCount; ++index)
+            {
+                m_CurrentCmdBuf->cmdBuf.dispatchIndirect(indirectParams->buffer, paramOffsetBytes + uint64_t(index) * stride);
+            }
+            break;
+        }
+
+        case IndirectArgumentType::DispatchMesh: {
+            updateMeshletVolatileBuffers();
+
+            Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+            Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+            assert(indirectParams);
+
+            if (signature->indirectCommandsLayout)
+                executeGeneratedCommands(signature, indirectParams, paramOffsetBytes, indirectCount, countOffsetBytes, maxCommandCount);
+            else if (m_Context.extensions.EXT_mesh_shader && indirectCount)
+                m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountEXT(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes, maxCommandCount, stride);
+            else if (m_Context.extensions.EXT_mesh_shader)
+                m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectEXT(indirectParams->buffer, paramOffsetBytes, maxCommandCount, stride);
+            else if (indirectCount)
+                m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountNV(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes, maxCommandCount, stride);
+            else
+                m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectNV(indirectParams->buffer, paramOffsetBytes, maxCommandCount, stride);
+            break;
+        }
+
+        default:
+            utils::InvalidEnum();
+            return;
+        }
+
+        m_CurrentCmdBuf->referencedResources.push_back(signature);
+    }
+
+    void CommandList::executeGeneratedCommands(CommandSignature* signature, Buffer* indirectParams, uint32_t paramOffsetBytes,
+        Buffer* indirectCount, uint32_t countOffsetBytes, uint32_t maxCommandCount)
+    {
+        if (maxCommandCount == 0)
+            return;
+
+        if (maxCommandCount > m_Context.deviceGeneratedCommandsProperties.maxIndirectSequenceCount)
+        {
+            std::stringstream ss;
+            ss << "executeIndirect with " << maxCommandCount << " commands exceeds the device limit of "
+                << m_Context.deviceGeneratedCommandsProperties.maxIndirectSequenceCount << " device-generated commands";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        // Signatures with state-changing arguments can only be used with the pipeline they were created for
+        auto pipelineInfo = vk::GeneratedCommandsPipelineInfoEXT()
+            .setPipeline(signature->nativePipeline);
+
+        auto requirementsInfo = vk::GeneratedCommandsMemoryRequirementsInfoEXT()
+            .setIndirectCommandsLayout(signature->indirectCommandsLayout)
+            .setMaxSequenceCount(maxCommandCount)
+            .setPNext(&pipelineInfo);
+
+        const vk::MemoryRequirements2 requirements = m_Context.device.getGeneratedCommandsMemoryRequirementsEXT(requirementsInfo);
+
+        // Each execution gets its own range of scratch memory, so that executions that may overlap on the GPU
+        // do not share one. The scratch chunks are created with the preprocess usage and reused after their
+        // command buffer is retired.
+        vk::DeviceAddress preprocessAddress = 0;
+        if (requirements.memoryRequirements.size > 0)
+        {
+            Buffer* scratchBuffer = nullptr;
+            uint64_t scratchOffset = 0;
+            const uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+
+            if (!m_ScratchManager->suballocateBuffer(requirements.memoryRequirements.size, &scratchBuffer, &scratchOffset, nullptr,
+                currentVersion, uint32_t(requirements.memoryRequirements.alignment)))
+            {
+                std::stringstream ss;
+                ss << "Couldn't suballocate " << requirements.memoryRequirements.size
+                    << " bytes of scratch memory for the preprocessing of device-generated commands";
+                m_Context.error(ss.str());
+                return;
+            }
+
+            preprocessAddress = scratchBuffer->deviceAddress + scratchOffset;
+        }
+
+        auto generatedCommandsInfo = vk::GeneratedCommandsInfoEXT()
+            .setShaderStages(signature->shaderStages)
+            .setIndirectCommandsLayout(signature->indirectCommandsLayout)
+            .setIndirectAddress(indirectParams->deviceAddress + paramOffsetBytes)
+            .setIndirectAddressSize(uint64_t(maxCommandCount) * signature->byteStride)
+            .setPreprocessAddress(preprocessAddress)
+            .setPreprocessSize(requirements.memoryRequirements.size)
+            .setMaxSequenceCount(maxCommandCount)
+            .setSequenceCountAddress(indirectCount ? indirectCount->deviceAddress + countOffsetBytes : 0)
+            .setPNext(&pipelineInfo);
+
+        m_CurrentCmdBuf->cmdBuf.executeGeneratedCommandsEXT(false, generatedCommandsInfo);
+
+        // The bindings written by the commands are undefined afterwards, make the next setGraphicsState bind them again
+        if (signature->changesVertexBuffers)
+            m_CurrentGraphicsState.vertexBuffers.resize(0);
+
+        if (signature->changesIndexBuffer)
+            m_CurrentGraphicsState.indexBuffer = IndexBufferBinding();
+    }
+
+} // namespace nvrhi::vulkan
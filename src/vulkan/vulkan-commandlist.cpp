@@ -30,9 +30,12 @@ namespace nvrhi::vulkan
         , m_Context(context)
         , m_CommandListParameters(parameters)
         , m_StateTracker(context.messageCallback)
-        , m_UploadManager(std::make_unique<UploadManager>(device, parameters.uploadChunkSize, 0, false))
-        , m_ScratchManager(std::make_unique<UploadManager>(device, parameters.scratchChunkSize, parameters.scratchMaxMemory, true))
+        , m_UploadManager(std::make_unique<UploadManager>(device, parameters.uploadChunkSize, 0, false, parameters.uploadRingSize))
+        , m_ScratchManager(std::make_unique<UploadManager>(device, parameters.scratchChunkSize, parameters.scratchMaxMemory, true, 0))
     {
+        m_StateTracker.setEnableStateHandoff(parameters.enableStateHandoff);
+        m_StateTracker.setKeepStatesAfterSubmission(parameters.reusable);
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().registerAftermathMarkerTracker(&m_AftermathTracker);
@@ -41,12 +44,28 @@ namespace nvrhi::vulkan
 
     CommandList::~CommandList()
     {
+        if (m_CommandListParameters.reusable && m_CurrentCmdBuf)
+        {
+            // The command buffer doesn't reference this command list, so let it keep the upload memory instead
+            m_CurrentCmdBuf->retainedUploadManagers.push_back(std::move(m_UploadManager));
+            m_CurrentCmdBuf->retainedUploadManagers.push_back(std::move(m_ScratchManager));
+            releaseReusableRecording();
+        }
+
 #if NVRHI_WITH_AFTERMATH
         if (m_Device->isAftermathEnabled())
             m_Device->getAftermathCrashDumpHelper().unRegisterAftermathMarkerTracker(&m_AftermathTracker);
 #endif
     }
 
+    MemoryStatistics CommandList::getMemoryStatistics()
+    {
+        MemoryStatistics statistics;
+        m_UploadManager->getStatistics(statistics);
+        m_ScratchManager->getStatistics(statistics);
+        return statistics;
+    }
+
     nvrhi::Object CommandList::getNativeObject(ObjectType objectType)
     {
         switch (objectType)
@@ -60,21 +79,90 @@ namespace nvrhi::vulkan
 
     void CommandList::open()
     {
+        if (m_CommandListParameters.isBundle)
+        {
+            // The previous recording may still be referenced by command buffers that executed it. If it's not,
+            // reuse its command buffer, otherwise start on a new one and leave the old one to those command buffers.
+            // Recording begins in setGraphicsState. The bundle itself is not added to referencedResources,
+            // that would make a reference cycle.
+            if (m_CurrentCmdBuf && m_CurrentCmdBuf.use_count() == 1)
+            {
+                m_CurrentCmdBuf->cmdBuf.reset();
+                m_CurrentCmdBuf->referencedResources.clear();
+                m_CurrentCmdBuf->resetTransientBindingSets();
+
+                for (vk::DescriptorPool pool : m_CurrentCmdBuf->transientDescriptorPools)
+                {
+                    m_Context.device.resetDescriptorPool(pool);
+                }
+                m_CurrentCmdBuf->currentTransientDescriptorPool = 0;
+
+                for (const TlsfAllocator::Allocation& range : m_CurrentCmdBuf->transientDescriptorBufferRanges)
+                {
+                    m_Context.descriptorBuffer->releaseImmediately(range);
+                }
+                m_CurrentCmdBuf->transientDescriptorBufferRanges.clear();
+            }
+            else
+            {
+                m_CurrentCmdBuf = m_Device->getQueue(m_CommandListParameters.queueType)->createCommandBuffer(vk::CommandBufferLevel::eSecondary);
+            }
+
+            m_BundleStateRequirements.clear();
+            m_BundleFramebuffer = nullptr;
+
+            clearState();
+            return;
+        }
+
+        if (m_CommandListParameters.reusable)
+            releaseReusableRecording();
+
         m_CurrentCmdBuf = m_Device->getQueue(m_CommandListParameters.queueType)->getOrCreateCommandBuffer();
 
         auto beginInfo = vk::CommandBufferBeginInfo()
-            .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+            .setFlags(m_CommandListParameters.reusable
+                ? vk::CommandBufferUsageFlagBits::eSimultaneousUse
+                : vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 
         (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
-        m_CurrentCmdBuf->referencedResources.push_back(this); // prevent deletion of e.g. UploadManager
+
+        if (m_CommandListParameters.reusable)
+        {
+            // This command list keeps the command buffer, so referencing the list from it would make a cycle
+            m_CurrentCmdBuf->ownedByReusableList = true;
+        }
+        else
+        {
+            m_CurrentCmdBuf->referencedResources.push_back(this); // prevent deletion of e.g. UploadManager
+        }
+
+        m_SplitBarrierEvents.clear();
+        m_PendingTextureWrites.clear();
+        m_PredicationEnabled = false;
+        m_LastRenderPassFramebuffer = nullptr;
 
         clearState();
     }
 
     void CommandList::close()
     {
+        if (m_CommandListParameters.isBundle)
+        {
+            // Keep m_CurrentCmdBuf for executeBundles. A bundle without any graphics state was never begun.
+            if (m_BundleFramebuffer)
+                m_CurrentCmdBuf->cmdBuf.end();
+
+            clearState();
+            return;
+        }
+
         endRenderPass();
 
+        if (m_PredicationEnabled)
+            setPredication(nullptr, PredicationOp::SkipIfZero);
+
+        m_StateTracker.endSplitTransitions();
         m_StateTracker.keepBufferInitialStates();
         m_StateTracker.keepTextureInitialStates();
         commitBarriers();
@@ -107,7 +195,9 @@ namespace nvrhi::vulkan
         m_CurrentMeshletState = MeshletState();
         m_CurrentRayTracingState = rt::State();
 
+        m_PendingGraphicsState.reset();
         m_AnyVolatileBufferWrites = false;
+        m_DescriptorBufferBound = false;
 
         // TODO: add real context clearing code here 
     }
@@ -126,6 +216,31 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->submissionID = submissionID;
 
         const CommandQueue queueID = queue.getQueueID();
+
+        for (const auto& [_pool, frameIndex] : m_CurrentCmdBuf->resolvedTimerQueryFrames)
+        {
+            TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool.Get());
+
+            std::lock_guard lockGuard(pool->mutex);
+
+            // the frame may have been restarted already if the results were not needed
+            TimerQueryPool::Frame& frame = pool->getFrame(frameIndex);
+            if (frame.frameIndex == frameIndex)
+            {
+                frame.queue = queueID;
+                frame.submissionID = submissionID;
+            }
+        }
+
+        if (m_CommandListParameters.reusable)
+        {
+            // Keep the command buffer and the pinned upload memory and volatile buffer versions
+            // for the next executions, see releaseReusableRecording
+            m_StateTracker.commandListSubmitted();
+            return;
+        }
+
+        m_CurrentCmdBuf->resolvedTimerQueryFrames.clear();
         const uint64_t recordingID = m_CurrentCmdBuf->recordingID;
 
         m_CurrentCmdBuf = nullptr;
@@ -142,7 +257,39 @@ namespace nvrhi::vulkan
             MakeVersion(recordingID, queueID, false),
             MakeVersion(submissionID, queueID, true));
 
-        m_VolatileBufferStates.clear();
+        clearVolatileBufferStates();
+    }
+
+    void CommandList::releaseReusableRecording()
+    {
+        if (!m_CurrentCmdBuf)
+            return;
+
+        // Unpin the upload memory and volatile buffer versions with the last submission of the recording.
+        // A recording that was never executed uses submission 0, which is always finished.
+        const uint64_t recordingID = m_CurrentCmdBuf->recordingID;
+        const uint64_t submissionID = m_CurrentCmdBuf->submissionID;
+        const CommandQueue queueID = m_CommandListParameters.queueType;
+
+        submitVolatileBuffers(recordingID, submissionID);
+        clearVolatileBufferStates();
+
+        if (m_UploadManager)
+        {
+            m_UploadManager->submitChunks(
+                MakeVersion(recordingID, queueID, false),
+                MakeVersion(submissionID, queueID, true));
+
+            m_ScratchManager->submitChunks(
+                MakeVersion(recordingID, queueID, false),
+                MakeVersion(submissionID, queueID, true));
+        }
+
+        m_CurrentCmdBuf->resolvedTimerQueryFrames.clear();
+        m_Device->getQueue(queueID)->releaseReusableCommandBuffer(std::move(m_CurrentCmdBuf));
+        m_CurrentCmdBuf = nullptr;
+
+        m_StateTracker.resetTrackedStates();
     }
  
     void CommandList::convertCoopVecMatrices(coopvec::ConvertMatrixLayoutDesc const* convertDescs, size_t numDescs)
@@ -153,10 +300,13 @@ namespace nvrhi::vulkan
         if (numDescs == 0)
             return;
 
-        std::vector<vk::ConvertCooperativeVectorMatrixInfoNV> vkConvertDescs;
+        // The pDstSize pointers refer into dstSizes, so it must not reallocate while the descriptors are filled
+        std::vector<vk::ConvertCooperativeVectorMatrixInfoNV>& vkConvertDescs = m_CoopVecConvertInfos;
+        vkConvertDescs.clear();
         vkConvertDescs.reserve(numDescs);
 
-        std::vector<size_t> dstSizes;
+        std::vector<size_t>& dstSizes = m_CoopVecDstSizes;
+        dstSizes.clear();
         dstSizes.reserve(numDescs);
 
         for (size_t i = 0; i < numDescs; i++)
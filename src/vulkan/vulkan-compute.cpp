@@ -27,6 +27,12 @@ namespace nvrhi::vulkan
 {
     ComputePipelineHandle Device::createComputePipeline(const ComputePipelineDesc& desc)
     {
+        if (m_Deduplication)
+        {
+            if (ComputePipelineHandle existing = m_Deduplication->computePipelines.find(desc))
+                return existing;
+        }
+
         vk::Result res;
 
         assert(desc.CS);
@@ -68,6 +74,7 @@ namespace nvrhi::vulkan
             specInfos, specMapEntries, specData);
         
         auto pipelineInfo = vk::ComputePipelineCreateInfo()
+                                .setFlags(m_Context.getPipelineCreateFlags())
                                 .setStage(shaderStageInfo)
                                 .setLayout(pso->pipelineLayout);
 
@@ -78,7 +85,12 @@ namespace nvrhi::vulkan
 
         CHECK_VK_FAIL(res)
 
-        return ComputePipelineHandle::Create(pso);
+        ComputePipelineHandle pipeline = ComputePipelineHandle::Create(pso);
+
+        if (m_Deduplication)
+            pipeline = m_Deduplication->computePipelines.insert(desc, pipeline);
+
+        return pipeline;
     }
 
     ComputePipeline::~ComputePipeline()
@@ -134,6 +146,11 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
         }
 
+        if (state.indirectCountBuffer && state.indirectCountBuffer != m_CurrentComputeState.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.push_back(state.indirectCountBuffer);
+        }
+
         if (arraysAreDifferent(m_CurrentComputeState.bindings, state.bindings) || m_AnyVolatileBufferWrites)
         {
             bindBindingSets(vk::PipelineBindPoint::eCompute, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
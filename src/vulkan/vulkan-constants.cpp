@@ -156,13 +156,61 @@ namespace nvrhi::vulkan
         if ((shaderType & ShaderType::Domain) != 0)         result |= uint32_t(vk::PipelineStageFlagBits2::eTessellationEvaluationShader);
         if ((shaderType & ShaderType::Geometry) != 0)       result |= uint32_t(vk::PipelineStageFlagBits2::eGeometryShader);
         if ((shaderType & ShaderType::Pixel) != 0)          result |= uint32_t(vk::PipelineStageFlagBits2::eFragmentShader);
-        if ((shaderType & ShaderType::Amplification) != 0)  result |= uint32_t(vk::PipelineStageFlagBits2::eTaskShaderNV);
-        if ((shaderType & ShaderType::Mesh) != 0)           result |= uint32_t(vk::PipelineStageFlagBits2::eMeshShaderNV);
+        if ((shaderType & ShaderType::Amplification) != 0)  result |= uint32_t(vk::PipelineStageFlagBits2::eTaskShaderEXT); // or eTaskShaderNV, they have the same value
+        if ((shaderType & ShaderType::Mesh) != 0)           result |= uint32_t(vk::PipelineStageFlagBits2::eMeshShaderEXT); // same
         if ((shaderType & ShaderType::AllRayTracing) != 0)  result |= uint32_t(vk::PipelineStageFlagBits2::eRayTracingShaderKHR); // or eRayTracingShaderNV, they have the same value
 
         return vk::PipelineStageFlagBits2(result);
     }
 
+    vk::PipelineStageFlags2 convertPipelineStages(PipelineStages stages, CommandQueue queue, const VulkanContext& context)
+    {
+        if (stages == PipelineStages::All)
+            return vk::PipelineStageFlagBits2::eAllCommands;
+
+        const bool graphics = queue == CommandQueue::Graphics;
+        const bool compute = graphics || queue == CommandQueue::Compute;
+
+        vk::PipelineStageFlags2 result;
+
+        if (compute && (stages & PipelineStages::DrawIndirect) != 0)
+            result |= vk::PipelineStageFlagBits2::eDrawIndirect;
+        if (graphics && (stages & PipelineStages::VertexInput) != 0)
+            result |= vk::PipelineStageFlagBits2::eVertexInput;
+        if (graphics && (stages & PipelineStages::PreRasterization) != 0)
+        {
+            result |= vk::PipelineStageFlagBits2::eVertexShader
+                | vk::PipelineStageFlagBits2::eTessellationControlShader
+                | vk::PipelineStageFlagBits2::eTessellationEvaluationShader
+                | vk::PipelineStageFlagBits2::eGeometryShader;
+
+            if (context.extensions.EXT_mesh_shader || context.extensions.NV_mesh_shader)
+                result |= vk::PipelineStageFlagBits2::eTaskShaderEXT | vk::PipelineStageFlagBits2::eMeshShaderEXT; // or the NV bits, they have the same values
+        }
+        if (graphics && (stages & PipelineStages::PixelShader) != 0)
+            result |= vk::PipelineStageFlagBits2::eFragmentShader;
+        if (graphics && (stages & PipelineStages::RenderTargets) != 0)
+        {
+            result |= vk::PipelineStageFlagBits2::eEarlyFragmentTests
+                | vk::PipelineStageFlagBits2::eLateFragmentTests
+                | vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+        }
+        if (compute && (stages & PipelineStages::ComputeShader) != 0)
+            result |= vk::PipelineStageFlagBits2::eComputeShader;
+        if (compute && (stages & PipelineStages::RayTracingShaders) != 0 && context.extensions.KHR_ray_tracing_pipeline)
+            result |= vk::PipelineStageFlagBits2::eRayTracingShaderKHR;
+        if (compute && (stages & PipelineStages::AccelStructBuild) != 0 && context.extensions.KHR_acceleration_structure)
+            result |= vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR;
+        if ((stages & PipelineStages::Copy) != 0)
+            result |= vk::PipelineStageFlagBits2::eTransfer;
+
+        // Nothing that the queue can execute was requested, wait for everything rather than not at all
+        if (!result)
+            return vk::PipelineStageFlagBits2::eAllCommands;
+
+        return result;
+    }
+
     vk::ShaderStageFlagBits convertShaderTypeToShaderStageFlagBits(ShaderType shaderType)
     {
         if (shaderType == ShaderType::All)
@@ -178,8 +226,8 @@ namespace nvrhi::vulkan
         static_assert(uint32_t(ShaderType::Geometry)      == uint32_t(VK_SHADER_STAGE_GEOMETRY_BIT));
         static_assert(uint32_t(ShaderType::Pixel)         == uint32_t(VK_SHADER_STAGE_FRAGMENT_BIT));
         static_assert(uint32_t(ShaderType::Compute)       == uint32_t(VK_SHADER_STAGE_COMPUTE_BIT));
-        static_assert(uint32_t(ShaderType::Amplification) == uint32_t(VK_SHADER_STAGE_TASK_BIT_NV));
-        static_assert(uint32_t(ShaderType::Mesh)          == uint32_t(VK_SHADER_STAGE_MESH_BIT_NV));
+        static_assert(uint32_t(ShaderType::Amplification) == uint32_t(VK_SHADER_STAGE_TASK_BIT_EXT));
+        static_assert(uint32_t(ShaderType::Mesh)          == uint32_t(VK_SHADER_STAGE_MESH_BIT_EXT));
         static_assert(uint32_t(ShaderType::RayGeneration) == uint32_t(VK_SHADER_STAGE_RAYGEN_BIT_KHR));
         static_assert(uint32_t(ShaderType::ClosestHit)    == uint32_t(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR));
         static_assert(uint32_t(ShaderType::AnyHit)        == uint32_t(VK_SHADER_STAGE_ANY_HIT_BIT_KHR));
@@ -197,8 +245,8 @@ namespace nvrhi::vulkan
         if ((shaderType & ShaderType::Domain) != 0)         result |= uint32_t(vk::ShaderStageFlagBits::eTessellationEvaluation);
         if ((shaderType & ShaderType::Geometry) != 0)       result |= uint32_t(vk::ShaderStageFlagBits::eGeometry);
         if ((shaderType & ShaderType::Pixel) != 0)          result |= uint32_t(vk::ShaderStageFlagBits::eFragment);
-        if ((shaderType & ShaderType::Amplification) != 0)  result |= uint32_t(vk::ShaderStageFlagBits::eTaskNV);
-        if ((shaderType & ShaderType::Mesh) != 0)           result |= uint32_t(vk::ShaderStageFlagBits::eMeshNV);
+        if ((shaderType & ShaderType::Amplification) != 0)  result |= uint32_t(vk::ShaderStageFlagBits::eTaskEXT);   // or eTaskNV, they have the same value
+        if ((shaderType & ShaderType::Mesh) != 0)           result |= uint32_t(vk::ShaderStageFlagBits::eMeshEXT);   // same
         if ((shaderType & ShaderType::RayGeneration) != 0)  result |= uint32_t(vk::ShaderStageFlagBits::eRaygenKHR); // or eRaygenNV, they have the same value
         if ((shaderType & ShaderType::Miss) != 0)           result |= uint32_t(vk::ShaderStageFlagBits::eMissKHR);   // same etc...
         if ((shaderType & ShaderType::ClosestHit) != 0)     result |= uint32_t(vk::ShaderStageFlagBits::eClosestHitKHR);
@@ -879,6 +927,9 @@ namespace nvrhi::vulkan
             return vk::DescriptorType::eAccelerationStructureKHR;
             break;
 
+        case ResourceType::InlineUniformBlock:
+            return vk::DescriptorType::eInlineUniformBlock;
+
         default:
             utils::InvalidEnum();
             return vk::DescriptorType(0);
@@ -0,0 +1,327 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "vulkan-backend.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nvrhi::vulkan
+{
+    // The buffer holds both resource and sampler descriptors, so it must fit into the limits of both
+    static uint64_t clampDescriptorBufferSize(const VulkanContext& context, uint64_t size)
+    {
+        const vk::PhysicalDeviceDescriptorBufferPropertiesEXT& props = context.descriptorBufferProperties;
+
+        return std::min({ size,
+            uint64_t(props.maxResourceDescriptorBufferRange),
+            uint64_t(props.maxSamplerDescriptorBufferRange),
+            uint64_t(props.resourceDescriptorBufferAddressSpaceSize),
+            uint64_t(props.samplerDescriptorBufferAddressSpaceSize),
+            uint64_t(props.descriptorBufferAddressSpaceSize) });
+    }
+
+    DescriptorBufferAllocator::DescriptorBufferAllocator(const VulkanContext& context, VulkanAllocator& allocator, const QueueArray& queues, uint64_t size)
+        : m_Context(context)
+        , m_Allocator(allocator)
+        , m_Queues(queues)
+        , m_Ranges(clampDescriptorBufferSize(context, size))
+    { }
+
+    vk::Result DescriptorBufferAllocator::initialize()
+    {
+        Buffer* buffer = new Buffer(m_Context, m_Allocator);
+        buffer->desc.byteSize = m_Ranges.getSize();
+        buffer->desc.cpuAccess = CpuAccessMode::Write; // to get the right memory type allocated
+        buffer->desc.debugName = "DescriptorBuffer";
+        buffer->memoryCategory = MemoryCategory::DescriptorHeaps;
+        m_Buffer = RefCountPtr<Buffer>::Create(buffer);
+
+        auto bufferInfo = vk::BufferCreateInfo()
+            .setSize(buffer->desc.byteSize)
+            .setUsage(vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT |
+                      vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT |
+                      vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            .setSharingMode(vk::SharingMode::eExclusive);
+
+        vk::Result res = m_Context.device.createBuffer(&bufferInfo, m_Context.allocationCallbacks, &buffer->buffer);
+        CHECK_VK_RETURN(res)
+
+        m_Context.nameVKObject(VkBuffer(buffer->buffer), vk::ObjectType::eBuffer, vk::DebugReportObjectTypeEXT::eBuffer, buffer->desc.debugName.c_str());
+
+        res = m_Allocator.allocateBufferMemory(buffer, true);
+        CHECK_VK_RETURN(res)
+
+        if (buffer->isSuballocated())
+            buffer->mappedMemory = buffer->mappedBlockMemory;
+        else
+            buffer->mappedMemory = m_Context.device.mapMemory(buffer->memory, 0, buffer->desc.byteSize);
+
+        if (!buffer->mappedMemory)
+            return vk::Result::eErrorMemoryMapFailed;
+
+        buffer->deviceAddress = m_Context.device.getBufferAddress(vk::BufferDeviceAddressInfo().setBuffer(buffer->buffer));
+
+        m_MappedMemory = static_cast<uint8_t*>(buffer->mappedMemory);
+        m_DeviceAddress = buffer->deviceAddress;
+
+        return vk::Result::eSuccess;
+    }
+
+    TlsfAllocator::Allocation DescriptorBufferAllocator::allocate(uint64_t size)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        const uint64_t alignment = std::max<uint64_t>(m_Context.descriptorBufferProperties.descriptorBufferOffsetAlignment, 1);
+
+        TlsfAllocator::Allocation allocation = m_Ranges.allocate(size, alignment);
+
+        // Try to recycle the ranges released earlier before giving up
+        if (!allocation.isValid() && !m_ReleasedRanges.empty())
+        {
+            retireReleasedRangesInternal();
+            allocation = m_Ranges.allocate(size, alignment);
+        }
+
+        return allocation;
+    }
+
+    uint64_t DescriptorBufferAllocator::getUsedSize()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        return m_Ranges.getUsedSize();
+    }
+
+    void DescriptorBufferAllocator::release(const TlsfAllocator::Allocation& allocation)
+    {
+        if (!allocation.isValid())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        ReleasedRange releasedRange;
+        releasedRange.allocation = allocation;
+
+        // The range may still be referenced by any work submitted so far
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            if (m_Queues[queueIndex])
+                releasedRange.lastSubmittedIDs[queueIndex] = m_Queues[queueIndex]->getLastSubmittedID();
+        }
+
+        m_ReleasedRanges.push_back(releasedRange);
+    }
+
+    void DescriptorBufferAllocator::releaseImmediately(const TlsfAllocator::Allocation& allocation)
+    {
+        if (!allocation.isValid())
+            return;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        m_Ranges.release(allocation);
+    }
+
+    void DescriptorBufferAllocator::retireReleasedRanges()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        retireReleasedRangesInternal();
+    }
+
+    void DescriptorBufferAllocator::retireReleasedRangesInternal()
+    {
+        if (m_ReleasedRanges.empty())
+            return;
+
+        std::array<uint64_t, uint32_t(CommandQueue::Count)> lastFinishedIDs{};
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            if (m_Queues[queueIndex])
+                lastFinishedIDs[queueIndex] = m_Context.device.getSemaphoreCounterValue(m_Queues[queueIndex]->trackingSemaphore);
+        }
+
+        size_t numRemaining = 0;
+        for (const ReleasedRange& releasedRange : m_ReleasedRanges)
+        {
+            bool finished = true;
+            for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+            {
+                if (releasedRange.lastSubmittedIDs[queueIndex] > lastFinishedIDs[queueIndex])
+                {
+                    finished = false;
+                    break;
+                }
+            }
+
+            if (finished)
+                m_Ranges.release(releasedRange.allocation);
+            else
+                m_ReleasedRanges[numRemaining++] = releasedRange;
+        }
+
+        m_ReleasedRanges.resize(numRemaining);
+    }
+
+    vk::DescriptorBufferBindingInfoEXT DescriptorBufferAllocator::getBindingInfo() const
+    {
+        return vk::DescriptorBufferBindingInfoEXT()
+            .setAddress(m_DeviceAddress)
+            .setUsage(vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT);
+    }
+
+    // The non-robust sizes are used for buffers, see DeviceDesc::enableDescriptorBuffer
+    size_t DescriptorBufferAllocator::getDescriptorSize(vk::DescriptorType descriptorType) const
+    {
+        const vk::PhysicalDeviceDescriptorBufferPropertiesEXT& props = m_Context.descriptorBufferProperties;
+
+        switch (descriptorType)  // NOLINT(clang-diagnostic-switch-enum)
+        {
+        case vk::DescriptorType::eSampler:
+            return props.samplerDescriptorSize;
+        case vk::DescriptorType::eSampledImage:
+            return props.sampledImageDescriptorSize;
+        case vk::DescriptorType::eStorageImage:
+            return props.storageImageDescriptorSize;
+        case vk::DescriptorType::eUniformTexelBuffer:
+            return props.uniformTexelBufferDescriptorSize;
+        case vk::DescriptorType::eStorageTexelBuffer:
+            return props.storageTexelBufferDescriptorSize;
+        case vk::DescriptorType::eUniformBuffer:
+        case vk::DescriptorType::eUniformBufferDynamic:
+            return props.uniformBufferDescriptorSize;
+        case vk::DescriptorType::eStorageBuffer:
+        case vk::DescriptorType::eStorageBufferDynamic:
+            return props.storageBufferDescriptorSize;
+        case vk::DescriptorType::eAccelerationStructureKHR:
+            return props.accelerationStructureDescriptorSize;
+        case vk::DescriptorType::eInlineUniformBlock:
+            return 1; // the binding size is the block size in bytes
+        default:
+            utils::InvalidEnum();
+            return 0;
+        }
+    }
+
+    void DescriptorBufferAllocator::writeDescriptors(const BindingLayout* layout, uint64_t offset, const vk::WriteDescriptorSet* writes, size_t numWrites) const
+    {
+        for (size_t writeIndex = 0; writeIndex < numWrites; writeIndex++)
+        {
+            const vk::WriteDescriptorSet& write = writes[writeIndex];
+
+            const auto found = layout->descriptorBufferBindings.find(write.dstBinding);
+            assert(found != layout->descriptorBufferBindings.end());
+            if (found == layout->descriptorBufferBindings.end())
+                continue;
+
+            const BindingLayout::DescriptorBufferBinding& binding = found->second;
+
+            if (write.descriptorType == vk::DescriptorType::eInlineUniformBlock)
+            {
+                // Inline uniform blocks are stored in the descriptor buffer as is, dstArrayElement is the byte offset
+                const auto* inlineWrite = static_cast<const vk::WriteDescriptorSetInlineUniformBlockEXT*>(write.pNext);
+                memcpy(getMappedMemory(offset + binding.offset + write.dstArrayElement), inlineWrite->pData, inlineWrite->dataSize);
+                continue;
+            }
+
+            // Volatile constant buffers are plain uniform buffers in this mode, CommandList patches their addresses
+            const vk::DescriptorType descriptorType = (write.descriptorType == vk::DescriptorType::eUniformBufferDynamic)
+                ? vk::DescriptorType::eUniformBuffer
+                : write.descriptorType;
+
+            for (uint32_t element = 0; element < write.descriptorCount; element++)
+            {
+                vk::DescriptorDataEXT data;
+                vk::DescriptorAddressInfoEXT bufferAddress;
+
+                switch (descriptorType)  // NOLINT(clang-diagnostic-switch-enum)
+                {
+                case vk::DescriptorType::eSampler:
+                    data.setPSampler(&write.pImageInfo[element].sampler);
+                    break;
+                case vk::DescriptorType::eSampledImage:
+                    data.setPSampledImage(&write.pImageInfo[element]);
+                    break;
+                case vk::DescriptorType::eStorageImage:
+                    data.setPStorageImage(&write.pImageInfo[element]);
+                    break;
+                case vk::DescriptorType::eUniformTexelBuffer:
+                    data.setPUniformTexelBuffer(static_cast<const vk::DescriptorAddressInfoEXT*>(write.pNext) + element);
+                    break;
+                case vk::DescriptorType::eStorageTexelBuffer:
+                    data.setPStorageTexelBuffer(static_cast<const vk::DescriptorAddressInfoEXT*>(write.pNext) + element);
+                    break;
+                case vk::DescriptorType::eUniformBuffer:
+                case vk::DescriptorType::eStorageBuffer:
+                {
+                    const vk::DescriptorBufferInfo& bufferInfo = write.pBufferInfo[element];
+                    bufferAddress
+                        .setAddress(m_Context.device.getBufferAddress(vk::BufferDeviceAddressInfo().setBuffer(bufferInfo.buffer)) + bufferInfo.offset)
+                        .setRange(bufferInfo.range);
+
+                    if (descriptorType == vk::DescriptorType::eUniformBuffer)
+                        data.setPUniformBuffer(&bufferAddress);
+                    else
+                        data.setPStorageBuffer(&bufferAddress);
+                    break;
+                }
+                case vk::DescriptorType::eAccelerationStructureKHR:
+                {
+                    const auto* accelStructWrite = static_cast<const vk::WriteDescriptorSetAccelerationStructureKHR*>(write.pNext);
+                    auto addressInfo = vk::AccelerationStructureDeviceAddressInfoKHR()
+                        .setAccelerationStructure(accelStructWrite->pAccelerationStructures[element]);
+                    data.setAccelerationStructure(m_Context.device.getAccelerationStructureAddressKHR(addressInfo));
+                    break;
+                }
+                default:
+                    utils::InvalidEnum();
+                    continue;
+                }
+
+                auto getInfo = vk::DescriptorGetInfoEXT()
+                    .setType(descriptorType)
+                    .setData(data);
+
+                const uint64_t descriptorOffset = offset + binding.offset + (write.dstArrayElement + element) * binding.stride;
+                m_Context.device.getDescriptorEXT(&getInfo, getDescriptorSize(descriptorType), getMappedMemory(descriptorOffset));
+            }
+        }
+    }
+
+    void DescriptorBufferAllocator::writeUniformBufferDescriptor(uint64_t offset, vk::DeviceAddress address, vk::DeviceSize range) const
+    {
+        auto bufferAddress = vk::DescriptorAddressInfoEXT()
+            .setAddress(address)
+            .setRange(range);
+
+        vk::DescriptorDataEXT data;
+        data.setPUniformBuffer(&bufferAddress);
+
+        auto getInfo = vk::DescriptorGetInfoEXT()
+            .setType(vk::DescriptorType::eUniformBuffer)
+            .setData(data);
+
+        m_Context.device.getDescriptorEXT(&getInfo, m_Context.descriptorBufferProperties.uniformBufferDescriptorSize, getMappedMemory(offset));
+    }
+
+} // namespace nvrhi::vulkan
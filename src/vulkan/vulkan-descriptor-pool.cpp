@@ -0,0 +1,227 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+
+namespace nvrhi::vulkan
+{
+    DescriptorPoolAllocator::~DescriptorPoolAllocator()
+    {
+        for (auto& [setSizes, sizeClass] : m_SizeClasses)
+        {
+            for (Pool& pool : sizeClass->pools)
+            {
+                m_Context.device.destroyDescriptorPool(pool.pool, m_Context.allocationCallbacks);
+            }
+        }
+
+        m_SizeClasses.clear();
+        m_ReleasedSets.clear();
+    }
+
+    DescriptorPoolAllocator::SizeClass* DescriptorPoolAllocator::getSizeClass(const std::vector<vk::DescriptorPoolSize>& setSizes)
+    {
+        auto found = m_SizeClasses.find(setSizes);
+        if (found != m_SizeClasses.end())
+            return found->second.get();
+
+        auto sizeClass = std::make_unique<SizeClass>();
+        sizeClass->setSizes = setSizes;
+
+        SizeClass* result = sizeClass.get();
+        m_SizeClasses[setSizes] = std::move(sizeClass);
+        return result;
+    }
+
+    vk::Result DescriptorPoolAllocator::createPool(SizeClass& sizeClass)
+    {
+        std::vector<vk::DescriptorPoolSize> poolSizes = sizeClass.setSizes;
+        for (auto& poolSize : poolSizes)
+        {
+            poolSize.descriptorCount *= m_SetsPerPool;
+        }
+
+        auto inlineUniformBlockInfo = vk::DescriptorPoolInlineUniformBlockCreateInfoEXT()
+            .setMaxInlineUniformBlockBindings(getMaxInlineUniformBlockBindings(poolSizes));
+
+        // eFreeDescriptorSet is required to return individual sets to the pool;
+        // all sets in the pool have the same size, so that doesn't fragment it.
+        auto poolInfo = vk::DescriptorPoolCreateInfo()
+            .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet)
+            .setPoolSizeCount(uint32_t(poolSizes.size()))
+            .setPPoolSizes(poolSizes.data())
+            .setMaxSets(m_SetsPerPool)
+            .setPNext(inlineUniformBlockInfo.maxInlineUniformBlockBindings ? &inlineUniformBlockInfo : nullptr);
+
+        Pool pool;
+        const vk::Result res = m_Context.device.createDescriptorPool(&poolInfo,
+                                                                   m_Context.allocationCallbacks,
+                                                                   &pool.pool);
+        CHECK_VK_RETURN(res)
+
+        pool.freeSets = m_SetsPerPool;
+        sizeClass.pools.push_back(pool);
+
+        return vk::Result::eSuccess;
+    }
+
+    vk::Result DescriptorPoolAllocator::allocateDescriptorSet(const BindingLayout* layout, vk::DescriptorPool& outPool, vk::DescriptorSet& outSet)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        SizeClass& sizeClass = *getSizeClass(layout->descriptorPoolSizeInfo);
+
+        auto findPoolWithSpace = [&sizeClass]()
+        {
+            for (size_t index = 0; index < sizeClass.pools.size(); index++)
+            {
+                if (sizeClass.pools[index].freeSets > 0)
+                    return int(index);
+            }
+            return -1;
+        };
+
+        bool retiredSets = false;
+
+        while (true)
+        {
+            int poolIndex = findPoolWithSpace();
+
+            // Try to recycle the sets released earlier before growing the size class
+            if (poolIndex < 0 && !retiredSets && !m_ReleasedSets.empty())
+            {
+                retireReleasedSetsInternal();
+                retiredSets = true;
+                continue;
+            }
+
+            const bool newPool = poolIndex < 0;
+            if (newPool)
+            {
+                const vk::Result res = createPool(sizeClass);
+                CHECK_VK_RETURN(res)
+
+                poolIndex = int(sizeClass.pools.size()) - 1;
+            }
+
+            Pool& pool = sizeClass.pools[poolIndex];
+
+            auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
+                .setDescriptorPool(pool.pool)
+                .setDescriptorSetCount(1)
+                .setPSetLayouts(&layout->descriptorSetLayout);
+
+            const vk::Result res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+
+            if (res == vk::Result::eSuccess)
+            {
+                --pool.freeSets;
+                outPool = pool.pool;
+                return res;
+            }
+
+            // A fresh pool that cannot fit a single set is a real error, otherwise move on to the next pool
+            if (newPool || (res != vk::Result::eErrorOutOfPoolMemory && res != vk::Result::eErrorFragmentedPool))
+                return res;
+
+            pool.freeSets = 0;
+        }
+    }
+
+    void DescriptorPoolAllocator::releaseDescriptorSet(const BindingLayout* layout, vk::DescriptorPool pool, vk::DescriptorSet set)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        ReleasedSet releasedSet;
+        releasedSet.sizeClass = getSizeClass(layout->descriptorPoolSizeInfo);
+        releasedSet.set = set;
+
+        const auto& pools = releasedSet.sizeClass->pools;
+        for (size_t index = 0; index < pools.size(); index++)
+        {
+            if (pools[index].pool == pool)
+            {
+                releasedSet.poolIndex = index;
+                break;
+            }
+        }
+
+        // The set may still be referenced by any work submitted so far
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            if (m_Queues[queueIndex])
+                releasedSet.lastSubmittedIDs[queueIndex] = m_Queues[queueIndex]->getLastSubmittedID();
+        }
+
+        m_ReleasedSets.push_back(releasedSet);
+    }
+
+    void DescriptorPoolAllocator::retireReleasedSets()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        retireReleasedSetsInternal();
+    }
+
+    void DescriptorPoolAllocator::retireReleasedSetsInternal()
+    {
+        if (m_ReleasedSets.empty())
+            return;
+
+        std::array<uint64_t, uint32_t(CommandQueue::Count)> lastFinishedIDs{};
+        for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+        {
+            if (m_Queues[queueIndex])
+                lastFinishedIDs[queueIndex] = m_Context.device.getSemaphoreCounterValue(m_Queues[queueIndex]->trackingSemaphore);
+        }
+
+        size_t numRemaining = 0;
+        for (const ReleasedSet& releasedSet : m_ReleasedSets)
+        {
+            bool finished = true;
+            for (uint32_t queueIndex = 0; queueIndex < uint32_t(CommandQueue::Count); queueIndex++)
+            {
+                if (releasedSet.lastSubmittedIDs[queueIndex] > lastFinishedIDs[queueIndex])
+                {
+                    finished = false;
+                    break;
+                }
+            }
+
+            if (finished)
+            {
+                Pool& pool = releasedSet.sizeClass->pools[releasedSet.poolIndex];
+
+                m_Context.device.freeDescriptorSets(pool.pool, releasedSet.set);
+
+                ++pool.freeSets;
+            }
+            else
+            {
+                m_ReleasedSets[numRemaining++] = releasedSet;
+            }
+        }
+
+        m_ReleasedSets.resize(numRemaining);
+    }
+
+} // namespace nvrhi::vulkan
@@ -49,12 +49,35 @@ namespace nvrhi::vulkan
         Device* device = new Device(desc);
         return DeviceHandle::Create(device);
     }
+
+    static bool isPipelineCacheDataCompatible(const VulkanContext& context, const void* data, size_t size)
+    {
+        VkPipelineCacheHeaderVersionOne header;
+        if (size < sizeof(header))
+            return false;
+
+        memcpy(&header, data, sizeof(header));
+
+        const vk::PhysicalDeviceProperties& props = context.physicalDeviceProperties;
+        return header.headerSize >= sizeof(header)
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == props.vendorID
+            && header.deviceID == props.deviceID
+            && memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    }
         
     Device::Device(const DeviceDesc& desc)
         : m_Context(desc.instance, desc.physicalDevice, desc.device, reinterpret_cast<vk::AllocationCallbacks*>(desc.allocationCallbacks))
         , m_Allocator(m_Context)
         , m_TimerQueryAllocator(desc.maxTimerQueries, true)
+        , m_OcclusionQueryAllocator(desc.maxOcclusionQueries, true)
+        , m_OcclusionQueryPreciseSupported(desc.occlusionQueryPreciseSupported)
+        , m_PipelineStatisticsQueryAllocator(desc.maxPipelineStatisticsQueries, true)
+        , m_PipelineStatisticsQuerySupported(desc.pipelineStatisticsQuerySupported)
+        , m_PipelineCompiler(desc.pipelineCompilerThreadCount)
     {
+        m_Context.accelStructCompaction = std::make_unique<AccelStructCompaction>(desc.maxCompactedSizeQueries);
+
         if (desc.graphicsQueue)
         {
             m_Queues[uint32_t(CommandQueue::Graphics)] = std::make_unique<Queue>(m_Context,
@@ -88,11 +111,22 @@ namespace nvrhi::vulkan
             { VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, &m_Context.extensions.KHR_ray_tracing_pipeline },
             { VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, &m_Context.extensions.KHR_synchronization2 },
             { VK_NV_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.NV_mesh_shader },
+            { VK_EXT_MESH_SHADER_EXTENSION_NAME, &m_Context.extensions.EXT_mesh_shader },
             { VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME, &m_Context.extensions.NV_ray_tracing_invocation_reorder },
             { VK_NV_CLUSTER_ACCELERATION_STRUCTURE_EXTENSION_NAME, &m_Context.extensions.NV_cluster_acceleration_structure },
             { VK_EXT_MUTABLE_DESCRIPTOR_TYPE_EXTENSION_NAME, &m_Context.extensions.EXT_mutable_descriptor_type },
             { VK_NV_COOPERATIVE_VECTOR_EXTENSION_NAME, &m_Context.extensions.NV_cooperative_vector },
             { VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME, &m_Context.extensions.NV_ray_tracing_linear_swept_spheres },
+            { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, &m_Context.extensions.KHR_pipeline_library },
+            { VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, &m_Context.extensions.EXT_graphics_pipeline_library },
+            { VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, &m_Context.extensions.EXT_descriptor_buffer },
+            { VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME, &m_Context.extensions.EXT_conditional_rendering },
+            { VK_NV_MEMORY_DECOMPRESSION_EXTENSION_NAME, &m_Context.extensions.NV_memory_decompression },
+            { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, &m_Context.extensions.EXT_memory_budget },
+            { VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME, &m_Context.extensions.EXT_pageable_device_local_memory },
+            { VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, &m_Context.extensions.KHR_push_descriptor },
+            { VK_EXT_INLINE_UNIFORM_BLOCK_EXTENSION_NAME, &m_Context.extensions.EXT_inline_uniform_block },
+            { VK_EXT_DEVICE_GENERATED_COMMANDS_EXTENSION_NAME, &m_Context.extensions.EXT_device_generated_commands },
 #if NVRHI_WITH_AFTERMATH
             { VK_NV_DEVICE_DIAGNOSTIC_CHECKPOINTS_EXTENSION_NAME, &m_Context.extensions.NV_device_diagnostic_checkpoints },
             { VK_NV_DEVICE_DIAGNOSTICS_CONFIG_EXTENSION_NAME, &m_Context.extensions.NV_device_diagnostics_config }
@@ -122,6 +156,25 @@ namespace nvrhi::vulkan
         if (desc.bufferDeviceAddressSupported)
             m_Context.extensions.buffer_device_address = true;
 
+        // Created before any memory is allocated, so that all allocations are registered
+        m_Context.memoryStatistics = std::make_unique<MemoryStatisticsTracker>(desc.memoryAllocationCallback);
+
+        if (desc.enableResidencyManagement)
+        {
+            if (m_Context.extensions.EXT_memory_budget && m_Context.extensions.EXT_pageable_device_local_memory)
+            {
+                m_Context.residency = std::make_unique<ResidencyTracker>();
+                m_Context.residency->setEnabled(true);
+            }
+            else
+            {
+                m_Context.warning("Residency management requires VK_EXT_memory_budget and VK_EXT_pageable_device_local_memory, "
+                    "it is disabled");
+            }
+        }
+        m_BudgetCallback = desc.budgetCallback;
+        m_DeferredDestructionFlags = desc.deferredDestruction;
+
         void* pNext = nullptr;
         vk::PhysicalDeviceAccelerationStructurePropertiesKHR accelStructProperties;
         vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingPipelineProperties;
@@ -132,6 +185,13 @@ namespace nvrhi::vulkan
         vk::PhysicalDeviceClusterAccelerationStructurePropertiesNV nvClusterAccelerationStructureProperties;
         vk::PhysicalDeviceCooperativeVectorPropertiesNV nvCoopVecProperties;
         vk::PhysicalDeviceSubgroupProperties subgroupProperties;
+        vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties;
+        vk::PhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties;
+        vk::PhysicalDeviceMeshShaderPropertiesEXT meshShaderProperties;
+        vk::PhysicalDeviceMeshShaderPropertiesNV nvMeshShaderProperties;
+        vk::PhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties;
+        vk::PhysicalDeviceInlineUniformBlockPropertiesEXT inlineUniformBlockProperties;
+        vk::PhysicalDeviceDeviceGeneratedCommandsPropertiesEXT deviceGeneratedCommandsProperties;
         
         vk::PhysicalDeviceProperties2 deviceProperties2;
 
@@ -187,6 +247,48 @@ namespace nvrhi::vulkan
             pNext = &nvCoopVecProperties;
         }
 
+        if (m_Context.extensions.EXT_graphics_pipeline_library)
+        {
+            graphicsPipelineLibraryProperties.pNext = pNext;
+            pNext = &graphicsPipelineLibraryProperties;
+        }
+
+        if (m_Context.extensions.EXT_descriptor_buffer)
+        {
+            descriptorBufferProperties.pNext = pNext;
+            pNext = &descriptorBufferProperties;
+        }
+
+        if (m_Context.extensions.EXT_mesh_shader)
+        {
+            meshShaderProperties.pNext = pNext;
+            pNext = &meshShaderProperties;
+        }
+
+        if (m_Context.extensions.NV_mesh_shader)
+        {
+            nvMeshShaderProperties.pNext = pNext;
+            pNext = &nvMeshShaderProperties;
+        }
+
+        if (m_Context.extensions.KHR_push_descriptor)
+        {
+            pushDescriptorProperties.pNext = pNext;
+            pNext = &pushDescriptorProperties;
+        }
+
+        if (m_Context.extensions.EXT_inline_uniform_block)
+        {
+            inlineUniformBlockProperties.pNext = pNext;
+            pNext = &inlineUniformBlockProperties;
+        }
+
+        if (m_Context.extensions.EXT_device_generated_commands)
+        {
+            deviceGeneratedCommandsProperties.pNext = pNext;
+            pNext = &deviceGeneratedCommandsProperties;
+        }
+
         deviceProperties2.pNext = pNext;
 
         m_Context.physicalDevice.getProperties2(&deviceProperties2);
@@ -201,8 +303,17 @@ namespace nvrhi::vulkan
         m_Context.subgroupProperties = subgroupProperties;
         m_Context.nvClusterAccelerationStructureProperties = nvClusterAccelerationStructureProperties;
         m_Context.coopVecProperties = nvCoopVecProperties;
+        m_Context.graphicsPipelineLibraryProperties = graphicsPipelineLibraryProperties;
+        m_Context.descriptorBufferProperties = descriptorBufferProperties;
+        m_Context.meshShaderProperties = meshShaderProperties;
+        m_Context.nvMeshShaderProperties = nvMeshShaderProperties;
+        m_Context.pushDescriptorProperties = pushDescriptorProperties;
+        m_Context.inlineUniformBlockProperties = inlineUniformBlockProperties;
+        m_Context.deviceGeneratedCommandsProperties = deviceGeneratedCommandsProperties;
         m_Context.messageCallback = desc.errorCB;
         m_Context.logBufferLifetime = desc.logBufferLifetime;
+        m_Context.descriptorUpdateAfterBind = desc.descriptorUpdateAfterBindSupported;
+        m_StateHandoffResolver = std::make_unique<StateHandoffResolver>(m_Context.messageCallback);
 
         if (m_Context.extensions.EXT_opacity_micromap && !m_Context.extensions.KHR_synchronization2)
         {
@@ -230,6 +341,29 @@ namespace nvrhi::vulkan
             deviceFeatures2.setPNext(&m_Context.linearSweptSpheresFeatures);
             m_Context.physicalDevice.getFeatures2(&deviceFeatures2);
         }
+
+        if (m_Context.extensions.EXT_mesh_shader)
+        {
+            vk::PhysicalDeviceFeatures2 deviceFeatures2;
+            deviceFeatures2.setPNext(&m_Context.meshShaderFeatures);
+            m_Context.physicalDevice.getFeatures2(&deviceFeatures2);
+
+            // VK_EXT_mesh_shader is preferred over VK_NV_mesh_shader when both are enabled, unless it's unusable
+            if (!m_Context.meshShaderFeatures.meshShader)
+                m_Context.extensions.EXT_mesh_shader = false;
+        }
+
+        if (m_Context.extensions.EXT_device_generated_commands)
+        {
+            vk::PhysicalDeviceDeviceGeneratedCommandsFeaturesEXT deviceGeneratedCommandsFeatures;
+            vk::PhysicalDeviceFeatures2 deviceFeatures2;
+            deviceFeatures2.setPNext(&deviceGeneratedCommandsFeatures);
+            m_Context.physicalDevice.getFeatures2(&deviceFeatures2);
+
+            // The indirect records are addressed by their GPU addresses
+            if (!deviceGeneratedCommandsFeatures.deviceGeneratedCommands || !m_Context.extensions.buffer_device_address)
+                m_Context.extensions.EXT_device_generated_commands = false;
+        }
 #ifdef NVRHI_WITH_RTXMU
         if (m_Context.extensions.KHR_acceleration_structure)
         {
@@ -247,6 +381,20 @@ namespace nvrhi::vulkan
         }
 #endif
         auto pipelineInfo = vk::PipelineCacheCreateInfo();
+        if (desc.initialPipelineCacheData && desc.initialPipelineCacheDataSize)
+        {
+            // Drivers are supposed to reject foreign caches, but some of them crash instead, so check the header here
+            if (isPipelineCacheDataCompatible(m_Context, desc.initialPipelineCacheData, desc.initialPipelineCacheDataSize))
+            {
+                pipelineInfo.setInitialDataSize(desc.initialPipelineCacheDataSize);
+                pipelineInfo.setPInitialData(desc.initialPipelineCacheData);
+            }
+            else
+            {
+                m_Context.warning("The initial pipeline cache data was created for a different device or driver and is ignored");
+            }
+        }
+
         vk::Result res = m_Context.device.createPipelineCache(&pipelineInfo,
             m_Context.allocationCallbacks,
             &m_Context.pipelineCache);
@@ -256,10 +404,35 @@ namespace nvrhi::vulkan
             m_Context.error("Failed to create the pipeline cache");
         }
 
-        // Create an empty Vk::DescriptorSetLayout
+        if (desc.enableDescriptorBuffer)
+        {
+            if (m_Context.extensions.EXT_descriptor_buffer && m_Context.extensions.buffer_device_address)
+            {
+                m_DescriptorBuffer = std::make_unique<DescriptorBufferAllocator>(m_Context, m_Allocator, m_Queues, desc.descriptorBufferSize);
+
+                if (m_DescriptorBuffer->initialize() == vk::Result::eSuccess)
+                {
+                    m_Context.descriptorBuffer = m_DescriptorBuffer.get();
+                }
+                else
+                {
+                    m_Context.warning("Failed to create the descriptor buffer, descriptor sets will be used instead");
+                    m_DescriptorBuffer.reset();
+                }
+            }
+            else
+            {
+                m_Context.warning("The descriptor buffer mode requires VK_EXT_descriptor_buffer and buffer device addresses, descriptor sets will be used instead");
+            }
+        }
+
+        // Create an empty Vk::DescriptorSetLayout, it must be compatible with the other layouts in the pipelines
         auto descriptorSetLayoutInfo = vk::DescriptorSetLayoutCreateInfo()
             .setBindingCount(0)
             .setPBindings(nullptr);
+
+        if (m_Context.descriptorBuffer)
+            descriptorSetLayoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT);
         res = m_Context.device.createDescriptorSetLayout(&descriptorSetLayoutInfo,
             m_Context.allocationCallbacks,
             &m_Context.emptyDescriptorSetLayout);
@@ -269,6 +442,28 @@ namespace nvrhi::vulkan
             m_Context.error("Failed to create an empty descriptor set layout");
         }
 
+        if (desc.enableMemorySuballocation)
+        {
+            m_Allocator.enableSuballocation(desc.memoryBlockSize);
+        }
+
+        if (desc.enableDescriptorPoolAllocator)
+        {
+            m_DescriptorPoolAllocator = std::make_unique<DescriptorPoolAllocator>(m_Context, m_Queues, desc.descriptorSetsPerPool);
+        }
+
+        if (desc.enableObjectDeduplication)
+        {
+            m_Deduplication = std::make_unique<ObjectDeduplicationCaches>();
+        }
+
+        // Without fast linking, linking the libraries at first use is not much cheaper than a full compile
+        if (m_Context.extensions.KHR_pipeline_library && m_Context.extensions.EXT_graphics_pipeline_library &&
+            m_Context.graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking)
+        {
+            m_GraphicsPipelineLibraries = std::make_unique<GraphicsPipelineLibraryCache>(m_Context);
+        }
+
 #if NVRHI_WITH_AFTERMATH
         m_AftermathEnabled = desc.aftermathEnabled;
 #endif
@@ -276,12 +471,51 @@ namespace nvrhi::vulkan
 
     Device::~Device()
     {
+        // Finish or cancel the pipeline jobs while the device is still intact
+        m_PipelineCompiler.shutdown();
+
+        // The cached objects reference the device
+        m_Deduplication.reset();
+
+        // The objects waiting for deferred destruction reference the context and the allocator
+        if (m_DeferredDestruction.getNumPendingObjects() != 0)
+        {
+            waitForIdle();
+            m_DeferredDestruction.destroyAll();
+        }
+
         if (m_TimerQueryPool)
         {
             m_Context.device.destroyQueryPool(m_TimerQueryPool);
             m_TimerQueryPool = vk::QueryPool();
         }
 
+        if (m_OcclusionQueryPool)
+        {
+            m_Context.device.destroyQueryPool(m_OcclusionQueryPool);
+            m_OcclusionQueryPool = vk::QueryPool();
+        }
+
+        if (m_PipelineStatisticsQueryPool)
+        {
+            m_Context.device.destroyQueryPool(m_PipelineStatisticsQueryPool);
+            m_PipelineStatisticsQueryPool = vk::QueryPool();
+        }
+
+        m_PredicationBuffer = nullptr;
+
+        if (m_Context.accelStructCompaction->queryPool)
+        {
+            m_Context.device.destroyQueryPool(m_Context.accelStructCompaction->queryPool);
+            m_Context.accelStructCompaction->queryPool = vk::QueryPool();
+        }
+
+        if (m_Context.accelStructCompaction->micromapQueryPool)
+        {
+            m_Context.device.destroyQueryPool(m_Context.accelStructCompaction->micromapQueryPool);
+            m_Context.accelStructCompaction->micromapQueryPool = vk::QueryPool();
+        }
+
         if (m_Context.pipelineCache)
         {
             m_Context.device.destroyPipelineCache(m_Context.pipelineCache);
@@ -338,6 +572,46 @@ namespace nvrhi::vulkan
                 m_Queue->retireCommandBuffers();
             }
         }
+
+        {
+            uint64_t lastSubmittedInstances[size_t(CommandQueue::Count)] = {};
+            uint64_t completedInstances[size_t(CommandQueue::Count)] = {};
+            for (size_t queue = 0; queue < size_t(CommandQueue::Count); queue++)
+            {
+                if (m_Queues[queue])
+                {
+                    lastSubmittedInstances[queue] = m_Queues[queue]->getLastSubmittedID();
+                    completedInstances[queue] = m_Queues[queue]->getLastFinishedID();
+                }
+            }
+
+            m_DeferredDestruction.retire(lastSubmittedInstances, completedInstances);
+        }
+
+        if (m_DescriptorPoolAllocator)
+        {
+            m_DescriptorPoolAllocator->retireReleasedSets();
+        }
+
+        if (m_DescriptorBuffer)
+        {
+            m_DescriptorBuffer->retireReleasedRanges();
+        }
+
+        if (m_Deduplication)
+        {
+            m_Deduplication->evictUnused();
+        }
+
+        if (m_GraphicsPipelineLibraries)
+        {
+            m_GraphicsPipelineLibraries->evictUnused();
+        }
+
+        if (m_Context.residency || m_BudgetCallback)
+        {
+            updateResidency();
+        }
     }
 
     bool Device::queryFeatureSupport(Feature feature, void* pInfo, size_t infoSize)
@@ -346,6 +620,8 @@ namespace nvrhi::vulkan
         {
         case Feature::DeferredCommandLists:
             return true;
+        case Feature::Bundles:
+            return true;
         case Feature::RayTracingAccelStruct:
             return m_Context.extensions.KHR_acceleration_structure;
         case Feature::RayTracingPipeline:
@@ -370,8 +646,21 @@ namespace nvrhi::vulkan
             return m_Context.extensions.NV_cluster_acceleration_structure;
         case Feature::ShaderSpecializations:
             return true;
+        case Feature::PipelineStatisticsQueries:
+            return m_PipelineStatisticsQuerySupported;
+        case Feature::Predication:
+            return m_Context.extensions.EXT_conditional_rendering;
+        case Feature::GpuDecompression:
+            return m_Context.extensions.NV_memory_decompression && m_Context.extensions.buffer_device_address;
         case Feature::Meshlets:
-            return m_Context.extensions.NV_mesh_shader;
+            if (pInfo)
+            {
+                if (infoSize == sizeof(MeshletFeatureInfo))
+                    fillMeshletFeatureInfo(*reinterpret_cast<MeshletFeatureInfo*>(pInfo));
+                else
+                    utils::NotSupported();
+            }
+            return m_Context.extensions.EXT_mesh_shader || m_Context.extensions.NV_mesh_shader;
         case Feature::VariableRateShading:
             if (pInfo)
             {
@@ -426,6 +715,41 @@ namespace nvrhi::vulkan
         }
     }
 
+    void Device::fillMeshletFeatureInfo(MeshletFeatureInfo& info) const
+    {
+        info = MeshletFeatureInfo();
+
+        if (m_Context.extensions.EXT_mesh_shader)
+        {
+            const vk::PhysicalDeviceMeshShaderPropertiesEXT& props = m_Context.meshShaderProperties;
+            for (int i = 0; i < 3; i++)
+            {
+                info.maxTaskWorkGroupCount[i] = props.maxTaskWorkGroupCount[i];
+                info.maxMeshWorkGroupCount[i] = props.maxMeshWorkGroupCount[i];
+            }
+            info.maxTaskWorkGroupTotalCount = props.maxTaskWorkGroupTotalCount;
+            info.maxMeshWorkGroupTotalCount = props.maxMeshWorkGroupTotalCount;
+            info.maxTaskPayloadSize = props.maxTaskPayloadSize;
+            info.maxMeshOutputVertices = props.maxMeshOutputVertices;
+            info.maxMeshOutputPrimitives = props.maxMeshOutputPrimitives;
+            info.perPrimitiveShadingRate = m_Context.meshShaderFeatures.primitiveFragmentShadingRateMeshShader
+                && m_Context.extensions.KHR_fragment_shading_rate && m_Context.shadingRateFeatures.primitiveFragmentShadingRate;
+        }
+        else if (m_Context.extensions.NV_mesh_shader)
+        {
+            // Only 1D dispatches are available with the NV extension
+            const vk::PhysicalDeviceMeshShaderPropertiesNV& props = m_Context.nvMeshShaderProperties;
+            info.maxTaskWorkGroupCount[0] = info.maxMeshWorkGroupCount[0] = props.maxDrawMeshTasksCount;
+            info.maxTaskWorkGroupCount[1] = info.maxMeshWorkGroupCount[1] = 1;
+            info.maxTaskWorkGroupCount[2] = info.maxMeshWorkGroupCount[2] = 1;
+            info.maxTaskWorkGroupTotalCount = info.maxMeshWorkGroupTotalCount = props.maxDrawMeshTasksCount;
+            info.maxTaskPayloadSize = props.maxTaskTotalMemorySize;
+            info.maxMeshOutputVertices = props.maxMeshOutputVertices;
+            info.maxMeshOutputPrimitives = props.maxMeshOutputPrimitives;
+            info.perPrimitiveShadingRate = false;
+        }
+    }
+
     FormatSupport Device::queryFormatSupport(Format format)
     {
         VkFormat vulkanFormat = convertFormat(format);
@@ -523,9 +847,28 @@ namespace nvrhi::vulkan
 
     size_t Device::getCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, int rows, int columns)
     {
-        if (!m_Context.extensions.NV_cooperative_vector)
+        if (!m_Context.extensions.NV_cooperative_vector || rows <= 0 || columns <= 0)
             return 0;
 
+        return m_CoopVecMatrixSizes.get(type, layout, uint32_t(rows), uint32_t(columns),
+            [this](coopvec::DataType t, coopvec::MatrixLayout l, uint32_t r, uint32_t c) { return queryCoopVecMatrixSize(t, l, r, c); });
+    }
+
+    void Device::getCoopVecMatrixSizes(const coopvec::MatrixSizeDesc* descs, size_t numDescs, size_t* outSizes)
+    {
+        for (size_t i = 0; i < numDescs; ++i)
+        {
+            const coopvec::MatrixSizeDesc& desc = descs[i];
+
+            outSizes[i] = m_Context.extensions.NV_cooperative_vector && desc.numRows != 0 && desc.numColumns != 0
+                ? m_CoopVecMatrixSizes.get(desc.type, desc.layout, desc.numRows, desc.numColumns,
+                    [this](coopvec::DataType t, coopvec::MatrixLayout l, uint32_t r, uint32_t c) { return queryCoopVecMatrixSize(t, l, r, c); })
+                : 0;
+        }
+    }
+
+    size_t Device::queryCoopVecMatrixSize(coopvec::DataType type, coopvec::MatrixLayout layout, uint32_t rows, uint32_t columns) const
+    {
         size_t dstSize = 0;
         size_t dataTypeSize = coopvec::getDataTypeSize(type);
         vk::ConvertCooperativeVectorMatrixInfoNV convertInfo = {};
@@ -549,6 +892,95 @@ namespace nvrhi::vulkan
         return 0;
     }
 
+    bool Device::getPipelineCacheData(std::vector<uint8_t>& outData)
+    {
+        outData.clear();
+
+        if (!m_Context.pipelineCache)
+            return false;
+
+        // The cache may grow between the two calls if pipelines are created concurrently, so retry on eIncomplete
+        vk::Result res;
+        do
+        {
+            size_t dataSize = 0;
+            res = m_Context.device.getPipelineCacheData(m_Context.pipelineCache, &dataSize, nullptr);
+            if (res != vk::Result::eSuccess)
+                break;
+
+            outData.resize(dataSize);
+            res = m_Context.device.getPipelineCacheData(m_Context.pipelineCache, &dataSize, outData.data());
+            outData.resize(dataSize);
+        } while (res == vk::Result::eIncomplete);
+
+        if (res != vk::Result::eSuccess)
+        {
+            outData.clear();
+            m_Context.error("Failed to get the pipeline cache data");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Device::mergePipelineCacheData(const void* data, size_t size)
+    {
+        if (!m_Context.pipelineCache || !data || !size)
+            return false;
+
+        if (!isPipelineCacheDataCompatible(m_Context, data, size))
+        {
+            m_Context.warning("The pipeline cache data was created for a different device or driver and cannot be merged");
+            return false;
+        }
+
+        auto cacheInfo = vk::PipelineCacheCreateInfo()
+            .setInitialDataSize(size)
+            .setPInitialData(data);
+
+        vk::PipelineCache srcCache;
+        vk::Result res = m_Context.device.createPipelineCache(&cacheInfo, m_Context.allocationCallbacks, &srcCache);
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to create a pipeline cache from the merged data");
+            return false;
+        }
+
+        // vkMergePipelineCaches requires external synchronization of the destination cache,
+        // which is why this method must not race with pipeline creation
+        res = m_Context.device.mergePipelineCaches(m_Context.pipelineCache, 1, &srcCache);
+
+        m_Context.device.destroyPipelineCache(srcCache, m_Context.allocationCallbacks);
+
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to merge the pipeline caches");
+            return false;
+        }
+
+        return true;
+    }
+
+    AsyncGraphicsPipelineHandle Device::createGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo, IGraphicsPipeline* fallback)
+    {
+        return m_PipelineCompiler.createGraphicsPipeline(this, desc, fbinfo, fallback);
+    }
+
+    AsyncComputePipelineHandle Device::createComputePipelineAsync(const ComputePipelineDesc& desc, IComputePipeline* fallback)
+    {
+        return m_PipelineCompiler.createComputePipeline(this, desc, fallback);
+    }
+
+    AsyncMeshletPipelineHandle Device::createMeshletPipelineAsync(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo, IMeshletPipeline* fallback)
+    {
+        return m_PipelineCompiler.createMeshletPipeline(this, desc, fbinfo, fallback);
+    }
+
+    rt::AsyncPipelineHandle Device::createRayTracingPipelineAsync(const rt::PipelineDesc& desc, rt::IPipeline* fallback)
+    {
+        return m_PipelineCompiler.createRayTracingPipeline(this, desc, fallback);
+    }
+
     Object Device::getNativeQueue(ObjectType objectType, CommandQueue queue)
     {
         if (objectType != ObjectTypes::VK_Queue)
@@ -565,6 +997,9 @@ namespace nvrhi::vulkan
         if (!m_Queues[uint32_t(params.queueType)])
             return nullptr;
 
+        if (params.enableStateHandoff)
+            m_StateHandoffUsed = true;
+
         CommandList* cmdList = new CommandList(this, m_Context, params);
 
         return CommandListHandle::Create(cmdList);
@@ -574,8 +1009,22 @@ namespace nvrhi::vulkan
     {
         Queue& queue = *m_Queues[uint32_t(executionQueue)];
 
+        if (m_StateHandoffUsed)
+        {
+            // Insert the command lists with cross-list transitions, and submit the extended sequence instead
+            resolveStateHandoff(pCommandLists, numCommandLists, executionQueue);
+            pCommandLists = m_StateHandoffSubmission.data();
+            numCommandLists = m_StateHandoffSubmission.size();
+        }
+
+        if (m_Context.residency)
+            makeReferencedResourcesResident(pCommandLists, numCommandLists);
+
         uint64_t submissionID = queue.submit(pCommandLists, numCommandLists);
 
+        if (m_Context.residency)
+            m_Context.residency->submitted(executionQueue, submissionID);
+
         for (size_t i = 0; i < numCommandLists; i++)
         {
             checked_cast<CommandList*>(pCommandLists[i])->executed(queue, submissionID);
@@ -749,6 +1198,22 @@ namespace nvrhi::vulkan
         }
     }
 
+    Object Heap::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::VK_DeviceMemory:
+            return Object(memory);
+        default:
+            return nullptr;
+        }
+    }
+
+    uint64_t Device::releaseEmptyMemoryBlocks()
+    {
+        return m_Allocator.releaseEmptyBlocks();
+    }
+
     void VulkanContext::nameVKObject(const void* handle, const vk::ObjectType objtype,
         const vk::DebugReportObjectTypeEXT objtypeEXT, const char* name) const
     {
@@ -0,0 +1,460 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "vulkan-backend.h"
+#include <algorithm>
+
+namespace nvrhi::vulkan
+{
+    GraphicsPipelineLibrary::~GraphicsPipelineLibrary()
+    {
+        if (pipeline)
+        {
+            m_Context.device.destroyPipeline(pipeline, m_Context.allocationCallbacks);
+            pipeline = nullptr;
+        }
+
+        if (pipelineLayout)
+        {
+            m_Context.device.destroyPipelineLayout(pipelineLayout, m_Context.allocationCallbacks);
+            pipelineLayout = nullptr;
+        }
+    }
+
+    static void hashBindingLayouts(size_t& hash, const BindingLayoutVector& bindingLayouts)
+    {
+        for (const BindingLayoutHandle& layout : bindingLayouts)
+            hash_combine(hash, layout.Get());
+    }
+
+    static bool isReferencedOnlyByCache(IResource* resource)
+    {
+        return resource && resource->GetRefCount() == 1;
+    }
+
+    static bool anyReferencedOnlyByCache(const BindingLayoutVector& bindingLayouts)
+    {
+        for (const BindingLayoutHandle& layout : bindingLayouts)
+        {
+            if (isReferencedOnlyByCache(layout))
+                return true;
+        }
+        return false;
+    }
+
+    bool GraphicsPipelineLibraryCache::VertexInputKey::operator ==(const VertexInputKey& other) const
+    {
+        return inputLayout == other.inputLayout
+            && primType == other.primType;
+    }
+
+    bool GraphicsPipelineLibraryCache::VertexInputKey::isStale() const
+    {
+        return isReferencedOnlyByCache(inputLayout);
+    }
+
+    size_t GraphicsPipelineLibraryCache::VertexInputKey::Hash::operator()(const VertexInputKey& key) const
+    {
+        size_t hash = 0;
+        hash_combine(hash, key.inputLayout.Get());
+        hash_combine(hash, key.primType);
+        return hash;
+    }
+
+    bool GraphicsPipelineLibraryCache::PreRasterizationKey::operator ==(const PreRasterizationKey& other) const
+    {
+        return VS == other.VS
+            && HS == other.HS
+            && DS == other.DS
+            && GS == other.GS
+            && bindingLayouts == other.bindingLayouts
+            && rasterState == other.rasterState
+            && patchControlPoints == other.patchControlPoints
+            && shadingRateState == other.shadingRateState
+            && hasShadingRateAttachment == other.hasShadingRateAttachment;
+    }
+
+    bool GraphicsPipelineLibraryCache::PreRasterizationKey::isStale() const
+    {
+        return isReferencedOnlyByCache(VS)
+            || isReferencedOnlyByCache(HS)
+            || isReferencedOnlyByCache(DS)
+            || isReferencedOnlyByCache(GS)
+            || anyReferencedOnlyByCache(bindingLayouts);
+    }
+
+    size_t GraphicsPipelineLibraryCache::PreRasterizationKey::Hash::operator()(const PreRasterizationKey& key) const
+    {
+        size_t hash = 0;
+        hash_combine(hash, key.VS.Get());
+        hash_combine(hash, key.HS.Get());
+        hash_combine(hash, key.DS.Get());
+        hash_combine(hash, key.GS.Get());
+        hashBindingLayouts(hash, key.bindingLayouts);
+        hash_combine(hash, key.rasterState);
+        hash_combine(hash, key.patchControlPoints);
+        hash_combine(hash, key.shadingRateState);
+        hash_combine(hash, key.hasShadingRateAttachment);
+        return hash;
+    }
+
+    bool GraphicsPipelineLibraryCache::FragmentShaderKey::operator ==(const FragmentShaderKey& other) const
+    {
+        return PS == other.PS
+            && bindingLayouts == other.bindingLayouts
+            && depthStencilState == other.depthStencilState
+            && shadingRateState == other.shadingRateState
+            && depthFormat == other.depthFormat
+            && sampleCount == other.sampleCount
+            && alphaToCoverageEnable == other.alphaToCoverageEnable
+            && hasShadingRateAttachment == other.hasShadingRateAttachment;
+    }
+
+    bool GraphicsPipelineLibraryCache::FragmentShaderKey::isStale() const
+    {
+        return isReferencedOnlyByCache(PS)
+            || anyReferencedOnlyByCache(bindingLayouts);
+    }
+
+    size_t GraphicsPipelineLibraryCache::FragmentShaderKey::Hash::operator()(const FragmentShaderKey& key) const
+    {
+        size_t hash = 0;
+        hash_combine(hash, key.PS.Get());
+        hashBindingLayouts(hash, key.bindingLayouts);
+        hash_combine(hash, key.depthStencilState);
+        hash_combine(hash, key.shadingRateState);
+        hash_combine(hash, key.depthFormat);
+        hash_combine(hash, key.sampleCount);
+        hash_combine(hash, key.alphaToCoverageEnable);
+        hash_combine(hash, key.hasShadingRateAttachment);
+        return hash;
+    }
+
+    bool GraphicsPipelineLibraryCache::FragmentOutputKey::operator ==(const FragmentOutputKey& other) const
+    {
+        return framebufferInfo == other.framebufferInfo
+            && blendState == other.blendState;
+    }
+
+    size_t GraphicsPipelineLibraryCache::FragmentOutputKey::Hash::operator()(const FragmentOutputKey& key) const
+    {
+        size_t hash = 0;
+        hash_combine(hash, key.framebufferInfo);
+        hash_combine(hash, key.blendState);
+        return hash;
+    }
+
+    template<typename TKey>
+    GraphicsPipelineLibraryPtr GraphicsPipelineLibraryCache::getLibrary(LibraryMap<TKey>& map, const TKey& key,
+        const std::function<GraphicsPipelineLibraryPtr()>& create)
+    {
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            auto it = map.find(key);
+            if (it != map.end())
+                return it->second;
+        }
+
+        // Compile outside of the lock so that the pipeline compiler threads can build different libraries in parallel.
+        // If two threads build the same library, the first one to finish is kept.
+        GraphicsPipelineLibraryPtr library = create();
+        if (!library)
+            return nullptr;
+
+        std::lock_guard lockGuard(m_Mutex);
+
+        auto [it, inserted] = map.try_emplace(key, library);
+        return it->second;
+    }
+
+    GraphicsPipelineLibraryPtr GraphicsPipelineLibraryCache::createLibrary(vk::GraphicsPipelineLibraryFlagsEXT subset,
+        vk::GraphicsPipelineCreateInfo info, vk::PipelineCreateFlags flags, const void* renderingInfo, const BindingLayoutVector* bindingLayouts)
+    {
+        auto library = std::make_shared<GraphicsPipelineLibrary>(m_Context);
+
+        // The shader subsets need a layout that is identically defined to the one of the final pipeline,
+        // which is created from the same binding layouts. The library owns its copy.
+        if (bindingLayouts)
+        {
+            BindingVector<RefCountPtr<BindingLayout>> pipelineBindingLayouts;
+            BindingVector<uint32_t> descriptorSetIdxToBindingIdx;
+            vk::ShaderStageFlags pushConstantVisibility;
+
+            const vk::Result res = createPipelineLayout(
+                library->pipelineLayout,
+                pipelineBindingLayouts,
+                pushConstantVisibility,
+                descriptorSetIdxToBindingIdx,
+                m_Context,
+                *bindingLayouts);
+
+            if (res != vk::Result::eSuccess)
+            {
+                m_Context.error("Failed to create a pipeline layout for a graphics pipeline library");
+                return nullptr;
+            }
+        }
+
+        auto libraryInfo = vk::GraphicsPipelineLibraryCreateInfoEXT()
+            .setPNext(const_cast<void*>(renderingInfo))
+            .setFlags(subset);
+
+        info.setPNext(&libraryInfo)
+            .setFlags(vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT | flags)
+            .setLayout(library->pipelineLayout);
+
+        const vk::Result res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+            1, &info,
+            m_Context.allocationCallbacks,
+            &library->pipeline);
+
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.error("Failed to create a graphics pipeline library");
+            return nullptr;
+        }
+
+        return library;
+    }
+
+    static vk::PipelineDynamicStateCreateInfo filterDynamicStates(const vk::PipelineDynamicStateCreateInfo* dynamicStateInfo,
+        std::initializer_list<vk::DynamicState> subsetStates, static_vector<vk::DynamicState, 5>& outStates)
+    {
+        if (dynamicStateInfo)
+        {
+            for (uint32_t i = 0; i < dynamicStateInfo->dynamicStateCount; i++)
+            {
+                const vk::DynamicState state = dynamicStateInfo->pDynamicStates[i];
+                if (std::find(subsetStates.begin(), subsetStates.end(), state) != subsetStates.end())
+                    outStates.push_back(state);
+            }
+        }
+
+        return vk::PipelineDynamicStateCreateInfo()
+            .setDynamicStateCount(uint32_t(outStates.size()))
+            .setPDynamicStates(outStates.data());
+    }
+
+    vk::Result GraphicsPipelineLibraryCache::linkPipeline(GraphicsPipeline* pso, const vk::GraphicsPipelineCreateInfo& pipelineInfo,
+        const vk::PipelineRenderingCreateInfo& renderingInfo)
+    {
+        const GraphicsPipelineDesc& desc = pso->desc;
+        const FramebufferInfo& fbinfo = pso->framebufferInfo;
+
+        static_vector<vk::PipelineShaderStageCreateInfo, 4> preRasterizationStages;
+        static_vector<vk::PipelineShaderStageCreateInfo, 1> fragmentStages;
+        for (uint32_t i = 0; i < pipelineInfo.stageCount; i++)
+        {
+            const vk::PipelineShaderStageCreateInfo& stage = pipelineInfo.pStages[i];
+            if (stage.stage == vk::ShaderStageFlagBits::eFragment)
+                fragmentStages.push_back(stage);
+            else
+                preRasterizationStages.push_back(stage);
+        }
+
+        // The shader subsets only use the view mask of the rendering info, and the fragment shader subset
+        // also the depth and stencil formats; the color formats are part of the fragment output subset.
+        const auto preRasterizationRendering = vk::PipelineRenderingCreateInfo()
+            .setPNext(renderingInfo.pNext)
+            .setViewMask(renderingInfo.viewMask);
+
+        const auto fragmentShaderRendering = vk::PipelineRenderingCreateInfo(preRasterizationRendering)
+            .setDepthAttachmentFormat(renderingInfo.depthAttachmentFormat)
+            .setStencilAttachmentFormat(renderingInfo.stencilAttachmentFormat);
+
+        VertexInputKey vertexInputKey;
+        vertexInputKey.inputLayout = desc.inputLayout;
+        vertexInputKey.primType = desc.primType;
+
+        PreRasterizationKey preRasterizationKey;
+        preRasterizationKey.VS = desc.VS;
+        preRasterizationKey.HS = desc.HS;
+        preRasterizationKey.DS = desc.DS;
+        preRasterizationKey.GS = desc.GS;
+        preRasterizationKey.bindingLayouts = desc.bindingLayouts;
+        preRasterizationKey.rasterState = desc.renderState.rasterState;
+        preRasterizationKey.patchControlPoints = desc.primType == PrimitiveType::PatchList ? desc.patchControlPoints : 0;
+        preRasterizationKey.shadingRateState = desc.shadingRateState;
+        preRasterizationKey.hasShadingRateAttachment = fbinfo.hasShadingRateAttachment;
+
+        FragmentShaderKey fragmentShaderKey;
+        fragmentShaderKey.PS = desc.PS;
+        fragmentShaderKey.bindingLayouts = desc.bindingLayouts;
+        fragmentShaderKey.depthStencilState = desc.renderState.depthStencilState;
+        fragmentShaderKey.shadingRateState = desc.shadingRateState;
+        fragmentShaderKey.depthFormat = fbinfo.depthFormat;
+        fragmentShaderKey.sampleCount = fbinfo.sampleCount;
+        fragmentShaderKey.alphaToCoverageEnable = desc.renderState.blendState.alphaToCoverageEnable;
+        fragmentShaderKey.hasShadingRateAttachment = fbinfo.hasShadingRateAttachment;
+
+        // The shading rate attachment flag applies to the subsets that include rasterization and fragment state
+        const vk::PipelineCreateFlags renderingFlags = m_Context.getPipelineCreateFlags(fbinfo);
+
+        FragmentOutputKey fragmentOutputKey;
+        fragmentOutputKey.framebufferInfo = fbinfo;
+        fragmentOutputKey.blendState = desc.renderState.blendState;
+
+        pso->libraries[0] = getLibrary(m_VertexInputLibraries, vertexInputKey, [&]()
+        {
+            auto info = vk::GraphicsPipelineCreateInfo()
+                .setPVertexInputState(pipelineInfo.pVertexInputState)
+                .setPInputAssemblyState(pipelineInfo.pInputAssemblyState);
+
+            return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface, info,
+                m_Context.getPipelineCreateFlags(), nullptr, nullptr);
+        });
+
+        pso->libraries[1] = getLibrary(m_PreRasterizationLibraries, preRasterizationKey, [&]()
+        {
+            static_vector<vk::DynamicState, 5> dynamicStates;
+            const auto dynamicStateInfo = filterDynamicStates(pipelineInfo.pDynamicState, {
+                vk::DynamicState::eViewport,
+                vk::DynamicState::eScissor,
+                vk::DynamicState::eFragmentShadingRateKHR }, dynamicStates);
+
+            auto info = vk::GraphicsPipelineCreateInfo()
+                .setStageCount(uint32_t(preRasterizationStages.size()))
+                .setPStages(preRasterizationStages.data())
+                .setPViewportState(pipelineInfo.pViewportState)
+                .setPRasterizationState(pipelineInfo.pRasterizationState)
+                .setPTessellationState(pipelineInfo.pTessellationState)
+                .setPDynamicState(&dynamicStateInfo);
+
+            return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders, info,
+                renderingFlags, &preRasterizationRendering, &desc.bindingLayouts);
+        });
+
+        pso->libraries[2] = getLibrary(m_FragmentShaderLibraries, fragmentShaderKey, [&]()
+        {
+            static_vector<vk::DynamicState, 5> dynamicStates;
+            const auto dynamicStateInfo = filterDynamicStates(pipelineInfo.pDynamicState, {
+                vk::DynamicState::eStencilReference,
+                vk::DynamicState::eFragmentShadingRateKHR }, dynamicStates);
+
+            auto info = vk::GraphicsPipelineCreateInfo()
+                .setStageCount(uint32_t(fragmentStages.size()))
+                .setPStages(fragmentStages.data())
+                .setPMultisampleState(pipelineInfo.pMultisampleState)
+                .setPDepthStencilState(pipelineInfo.pDepthStencilState)
+                .setPDynamicState(&dynamicStateInfo);
+
+            return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader, info,
+                renderingFlags, &fragmentShaderRendering, &desc.bindingLayouts);
+        });
+
+        pso->libraries[3] = getLibrary(m_FragmentOutputLibraries, fragmentOutputKey, [&]()
+        {
+            static_vector<vk::DynamicState, 5> dynamicStates;
+            const auto dynamicStateInfo = filterDynamicStates(pipelineInfo.pDynamicState, {
+                vk::DynamicState::eBlendConstants }, dynamicStates);
+
+            auto info = vk::GraphicsPipelineCreateInfo()
+                .setPColorBlendState(pipelineInfo.pColorBlendState)
+                .setPMultisampleState(pipelineInfo.pMultisampleState)
+                .setPDynamicState(&dynamicStateInfo);
+
+            return createLibrary(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface, info,
+                renderingFlags, &renderingInfo, nullptr);
+        });
+
+        std::array<vk::Pipeline, 4> libraryPipelines;
+        for (size_t i = 0; i < pso->libraries.size(); i++)
+        {
+            if (!pso->libraries[i])
+                return vk::Result::eErrorInitializationFailed;
+
+            libraryPipelines[i] = pso->libraries[i]->pipeline;
+        }
+
+        auto libraryInfo = vk::PipelineLibraryCreateInfoKHR()
+            .setLibraries(libraryPipelines);
+
+        auto linkInfo = vk::GraphicsPipelineCreateInfo()
+            .setPNext(&libraryInfo)
+            .setFlags(renderingFlags)
+            .setLayout(pso->pipelineLayout);
+
+        return m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+            1, &linkInfo,
+            m_Context.allocationCallbacks,
+            &pso->pipeline);
+    }
+
+    void GraphicsPipelineLibraryCache::optimizePipeline(GraphicsPipeline* pso)
+    {
+        std::array<vk::Pipeline, 4> libraryPipelines;
+        for (size_t i = 0; i < pso->libraries.size(); i++)
+            libraryPipelines[i] = pso->libraries[i]->pipeline;
+
+        auto libraryInfo = vk::PipelineLibraryCreateInfoKHR()
+            .setLibraries(libraryPipelines);
+
+        auto linkInfo = vk::GraphicsPipelineCreateInfo()
+            .setPNext(&libraryInfo)
+            .setFlags(vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT | m_Context.getPipelineCreateFlags(pso->framebufferInfo))
+            .setLayout(pso->pipelineLayout);
+
+        vk::Pipeline optimized;
+        const vk::Result res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+            1, &linkInfo,
+            m_Context.allocationCallbacks,
+            &optimized);
+
+        // Not fatal: the pipeline keeps using its fast-linked version
+        if (res != vk::Result::eSuccess)
+        {
+            m_Context.warning("Failed to build a link-time optimized graphics pipeline");
+            return;
+        }
+
+        pso->optimizedPipeline.store(VkPipeline(optimized), std::memory_order_release);
+
+        // The optimized pipeline doesn't depend on the libraries, so the cache can evict them now
+        for (GraphicsPipelineLibraryPtr& library : pso->libraries)
+            library.reset();
+    }
+
+    template<typename TKey>
+    static void evictUnusedLibraries(std::unordered_map<TKey, GraphicsPipelineLibraryPtr, typename TKey::Hash>& map)
+    {
+        for (auto it = map.begin(); it != map.end(); )
+        {
+            if (it->second.use_count() == 1 && it->first.isStale())
+                it = map.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void GraphicsPipelineLibraryCache::evictUnused()
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        evictUnusedLibraries(m_VertexInputLibraries);
+        evictUnusedLibraries(m_PreRasterizationLibraries);
+        evictUnusedLibraries(m_FragmentShaderLibraries);
+        evictUnusedLibraries(m_FragmentOutputLibraries);
+    }
+
+} // namespace nvrhi::vulkan
@@ -53,6 +53,44 @@ namespace nvrhi::vulkan
         return dimension;
     }
 
+    static vk::AttachmentLoadOp convertAttachmentLoadOp(AttachmentLoadOp op)
+    {
+        switch (op)
+        {
+        case AttachmentLoadOp::Clear:
+            return vk::AttachmentLoadOp::eClear;
+        case AttachmentLoadOp::DontCare:
+            return vk::AttachmentLoadOp::eDontCare;
+        case AttachmentLoadOp::Load:
+        default:
+            return vk::AttachmentLoadOp::eLoad;
+        }
+    }
+
+    static vk::AttachmentStoreOp convertAttachmentStoreOp(AttachmentStoreOp op)
+    {
+        return op == AttachmentStoreOp::Discard ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
+    }
+
+    static vk::ClearValue convertAttachmentClearValue(const FramebufferAttachment& attachment, Format format)
+    {
+        const Color& color = attachment.getEffectiveClearValue();
+        const FormatInfo& formatInfo = getFormatInfo(format);
+
+        if (formatInfo.hasDepth || formatInfo.hasStencil)
+            return vk::ClearDepthStencilValue(color.r, uint32_t(color.g));
+
+        if (formatInfo.kind == FormatKind::Integer)
+        {
+            if (formatInfo.isSigned)
+                return vk::ClearColorValue(std::array<int32_t, 4>{ int32_t(color.r), int32_t(color.g), int32_t(color.b), int32_t(color.a) });
+
+            return vk::ClearColorValue(std::array<uint32_t, 4>{ uint32_t(color.r), uint32_t(color.g), uint32_t(color.b), uint32_t(color.a) });
+        }
+
+        return vk::ClearColorValue(std::array<float, 4>{ color.r, color.g, color.b, color.a });
+    }
+
     FramebufferHandle Device::createFramebuffer(const FramebufferDesc& desc)
     {
         Framebuffer *fb = new Framebuffer();
@@ -77,8 +115,9 @@ namespace nvrhi::vulkan
             attachmentInfo = vk::RenderingAttachmentInfo()
                 .setImageView(view.view)
                 .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
-                .setLoadOp(vk::AttachmentLoadOp::eLoad)
-                .setStoreOp(vk::AttachmentStoreOp::eStore);
+                .setLoadOp(convertAttachmentLoadOp(rt.loadOp))
+                .setStoreOp(convertAttachmentStoreOp(rt.storeOp))
+                .setClearValue(convertAttachmentClearValue(rt, rt.format == Format::UNKNOWN ? t->desc.format : rt.format));
 
             fb->resources.push_back(rt.texture);
         }
@@ -108,8 +147,9 @@ namespace nvrhi::vulkan
             fb->depthAttachment = vk::RenderingAttachmentInfo()
                 .setImageView(view.view)
                 .setImageLayout(depthLayout)
-                .setLoadOp(vk::AttachmentLoadOp::eLoad)
-                .setStoreOp(vk::AttachmentStoreOp::eStore);
+                .setLoadOp(convertAttachmentLoadOp(att.loadOp))
+                .setStoreOp(convertAttachmentStoreOp(att.storeOp))
+                .setClearValue(convertAttachmentClearValue(att, texture->desc.format));
 
             if (getFormatInfo(texture->desc.format).hasStencil)
                 fb->stencilAttachment = fb->depthAttachment;
@@ -130,15 +170,12 @@ namespace nvrhi::vulkan
 
             const auto& view = vrsTexture->getSubresourceView(subresources, dimension, vrsAttachment.format, vk::ImageUsageFlagBits::eFragmentShadingRateAttachmentKHR);
 
-            auto rateProps = vk::PhysicalDeviceFragmentShadingRatePropertiesKHR();
-            auto props = vk::PhysicalDeviceProperties2();
-            props.pNext = &rateProps;
-            m_Context.physicalDevice.getProperties2(&props);
-
+            // The texel size comes from the properties queried at device creation, which keeps
+            // framebuffer creation free of driver calls other than the cached view lookups
             fb->shadingRateAttachment = vk::RenderingFragmentShadingRateAttachmentInfoKHR()
                 .setImageLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR)
                 .setImageView(view.view)
-                .setShadingRateAttachmentTexelSize(rateProps.minFragmentShadingRateAttachmentTexelSize);
+                .setShadingRateAttachmentTexelSize(m_Context.shadingRateProperties.minFragmentShadingRateAttachmentTexelSize);
 
             fb->resources.push_back(vrsAttachment.texture);
         }
@@ -215,6 +252,12 @@ namespace nvrhi::vulkan
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
+        if (m_Deduplication)
+        {
+            if (GraphicsPipelineHandle existing = m_Deduplication->graphicsPipelines.find({ desc, fbinfo }))
+                return existing;
+        }
+
         if (desc.renderState.singlePassStereo.enabled)
         {
             m_Context.error("Single-pass stereo is not supported by the Vulkan backend");
@@ -411,6 +454,7 @@ namespace nvrhi::vulkan
 
         auto pipelineInfo = vk::GraphicsPipelineCreateInfo()
             .setPNext(&renderingInfo)
+            .setFlags(m_Context.getPipelineCreateFlags(fbinfo))
             .setStageCount(uint32_t(shaderStages.size()))
             .setPStages(shaderStages.data())
             .setPVertexInputState(&vertexInput)
@@ -437,14 +481,37 @@ namespace nvrhi::vulkan
             pipelineInfo.setPTessellationState(&tessellationState);
         }
 
-        res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
-                                                     1, &pipelineInfo,
-                                                     m_Context.allocationCallbacks,
-                                                     &pso->pipeline);
+        if (m_GraphicsPipelineLibraries)
+        {
+            res = m_GraphicsPipelineLibraries->linkPipeline(pso, pipelineInfo, renderingInfo);
+        }
+        else
+        {
+            res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
+                                                         1, &pipelineInfo,
+                                                         m_Context.allocationCallbacks,
+                                                         &pso->pipeline);
+        }
         ASSERT_VK_OK(res); // for debugging
         CHECK_VK_FAIL(res);
         
-        return GraphicsPipelineHandle::Create(pso);
+        GraphicsPipelineHandle pipeline = GraphicsPipelineHandle::Create(pso);
+
+        if (m_GraphicsPipelineLibraries)
+        {
+            // Replace the fast-linked pipeline with an optimized one in the background
+            RefCountPtr<GraphicsPipeline> linkedPipeline = pso;
+            GraphicsPipelineLibraryCache* libraries = m_GraphicsPipelineLibraries.get();
+            m_PipelineCompiler.enqueueBackgroundJob([libraries, linkedPipeline]()
+            {
+                libraries->optimizePipeline(linkedPipeline.Get());
+            });
+        }
+
+        if (m_Deduplication)
+            pipeline = m_Deduplication->graphicsPipelines.insert({ desc, fbinfo }, pipeline);
+
+        return pipeline;
     }
 
     GraphicsPipelineHandle Device::createGraphicsPipeline(const GraphicsPipelineDesc& desc, IFramebuffer* fb)
@@ -463,6 +530,11 @@ namespace nvrhi::vulkan
             pipeline = nullptr;
         }
 
+        if (VkPipeline optimized = optimizedPipeline.exchange(VK_NULL_HANDLE))
+        {
+            m_Context.device.destroyPipeline(optimized, m_Context.allocationCallbacks);
+        }
+
         if (pipelineLayout)
         {
             m_Context.device.destroyPipelineLayout(pipelineLayout, m_Context.allocationCallbacks);
@@ -477,13 +549,13 @@ namespace nvrhi::vulkan
         case ObjectTypes::VK_PipelineLayout:
             return Object(pipelineLayout);
         case ObjectTypes::VK_Pipeline:
-            return Object(pipeline);
+            return Object(VkPipeline(getBindablePipeline()));
         default:
             return nullptr;
         }
     }
 
-    void CommandList::beginRenderPass(nvrhi::IFramebuffer* _framebuffer)
+    void CommandList::beginRenderPass(nvrhi::IFramebuffer* _framebuffer, vk::RenderingFlags flags)
     {
         endRenderPass();
 
@@ -495,15 +567,54 @@ namespace nvrhi::vulkan
         m_CurrentGraphicsState.framebuffer = framebuffer;
         m_CurrentMeshletState.framebuffer = framebuffer;
 
+        // Bundles are recorded inside the rendering pass started by executeBundles
+        if (m_CommandListParameters.isBundle)
+            return;
+
+        const vk::RenderingAttachmentInfo* colorAttachments = framebuffer->colorAttachments.data();
+        const vk::RenderingAttachmentInfo* depthAttachment = framebuffer->depthAttachment.imageView ? &framebuffer->depthAttachment : nullptr;
+        const vk::RenderingAttachmentInfo* stencilAttachment = framebuffer->stencilAttachment.imageView ? &framebuffer->stencilAttachment : nullptr;
+
+        // The attachment load ops only apply when the command list starts rendering to a framebuffer.
+        // When the rendering was interrupted, e.g. by a barrier or a copy, the contents are loaded back.
+        static_vector<vk::RenderingAttachmentInfo, c_MaxRenderTargets> resumedColorAttachments;
+        vk::RenderingAttachmentInfo resumedDepthAttachment;
+        vk::RenderingAttachmentInfo resumedStencilAttachment;
+
+        if (framebuffer == m_LastRenderPassFramebuffer)
+        {
+            for (const vk::RenderingAttachmentInfo& attachment : framebuffer->colorAttachments)
+                resumedColorAttachments.push_back(vk::RenderingAttachmentInfo(attachment).setLoadOp(vk::AttachmentLoadOp::eLoad));
+            colorAttachments = resumedColorAttachments.data();
+
+            if (depthAttachment)
+            {
+                resumedDepthAttachment = vk::RenderingAttachmentInfo(*depthAttachment).setLoadOp(vk::AttachmentLoadOp::eLoad);
+                depthAttachment = &resumedDepthAttachment;
+            }
+
+            if (stencilAttachment)
+            {
+                resumedStencilAttachment = vk::RenderingAttachmentInfo(*stencilAttachment).setLoadOp(vk::AttachmentLoadOp::eLoad);
+                stencilAttachment = &resumedStencilAttachment;
+            }
+        }
+
+        m_LastRenderPassFramebuffer = framebuffer;
+
         vk::RenderingInfo renderingInfo = vk::RenderingInfo()
+            .setFlags(flags)
             .setRenderArea(vk::Rect2D()
                 .setOffset(vk::Offset2D(0, 0))
                 .setExtent(vk::Extent2D(framebuffer->framebufferInfo.width, framebuffer->framebufferInfo.height)))
             .setLayerCount(framebuffer->framebufferInfo.arraySize)
             .setColorAttachmentCount(uint32_t(framebuffer->colorAttachments.size()))
-            .setPColorAttachments(framebuffer->colorAttachments.data())
-            .setPDepthAttachment(framebuffer->depthAttachment.imageView ? &framebuffer->depthAttachment : nullptr)
-            .setPStencilAttachment(framebuffer->stencilAttachment.imageView ? &framebuffer->stencilAttachment : nullptr);
+            .setPColorAttachments(colorAttachments)
+            .setPDepthAttachment(depthAttachment)
+            .setPStencilAttachment(stencilAttachment);
+
+        if (framebuffer->shadingRateAttachment.imageView)
+            renderingInfo.setPNext(&framebuffer->shadingRateAttachment);
         
         m_CurrentCmdBuf->cmdBuf.beginRendering(renderingInfo);
         m_CurrentCmdBuf->referencedResources.push_back(framebuffer);
@@ -513,7 +624,9 @@ namespace nvrhi::vulkan
     {
         if (m_CurrentGraphicsState.framebuffer || m_CurrentMeshletState.framebuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.endRendering();
+            if (!m_CommandListParameters.isBundle)
+                m_CurrentCmdBuf->cmdBuf.endRendering();
+
             m_CurrentGraphicsState.framebuffer = nullptr;
             m_CurrentMeshletState.framebuffer = nullptr;
         }
@@ -525,13 +638,79 @@ namespace nvrhi::vulkan
         return vk::Viewport(v.minX, v.maxY, v.maxX - v.minX, -(v.maxY - v.minY), v.minZ, v.maxZ);
     }
 
+    void CommandList::bindIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(indexBuffer.buffer)->buffer,
+            indexBuffer.offset,
+            indexBuffer.format == Format::R16_UINT ?
+            vk::IndexType::eUint16 : vk::IndexType::eUint32);
+
+        m_CurrentCmdBuf->referencedResources.push_back(indexBuffer.buffer);
+    }
+
+    void CommandList::bindVertexBuffers(const static_vector<VertexBufferBinding, c_MaxVertexAttributes>& vertexBuffers)
+    {
+        vk::Buffer buffers[c_MaxVertexAttributes];
+        vk::DeviceSize bufferOffsets[c_MaxVertexAttributes];
+        uint32_t maxVbIndex = 0;
+
+        for (const auto& binding : vertexBuffers)
+        {
+            // This is tested by the validation layer, skip invalid slots here if VL is not used.
+            if (binding.slot >= c_MaxVertexAttributes)
+                continue;
+
+            buffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->buffer;
+            bufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
+            maxVbIndex = std::max(maxVbIndex, binding.slot);
+
+            m_CurrentCmdBuf->referencedResources.push_back(binding.buffer);
+        }
+
+        m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, buffers, bufferOffsets);
+    }
+
+    void CommandList::setViewports(const ViewportState& viewport, const ViewportState& currentViewport)
+    {
+        if (!viewport.viewports.empty() && arraysAreDifferent(viewport.viewports, currentViewport.viewports))
+        {
+            nvrhi::static_vector<vk::Viewport, c_MaxViewports> viewports;
+            for (const auto& vp : viewport.viewports)
+            {
+                viewports.push_back(VKViewportWithDXCoords(vp));
+            }
+
+            m_CurrentCmdBuf->cmdBuf.setViewport(0, uint32_t(viewports.size()), viewports.data());
+        }
+
+        if (!viewport.scissorRects.empty() && arraysAreDifferent(viewport.scissorRects, currentViewport.scissorRects))
+        {
+            nvrhi::static_vector<vk::Rect2D, c_MaxViewports> scissors;
+            for (const auto& sc : viewport.scissorRects)
+            {
+                scissors.push_back(vk::Rect2D(vk::Offset2D(sc.minX, sc.minY),
+                    vk::Extent2D(std::abs(sc.maxX - sc.minX), std::abs(sc.maxY - sc.minY))));
+            }
+
+            m_CurrentCmdBuf->cmdBuf.setScissor(0, uint32_t(scissors.size()), scissors.data());
+        }
+    }
+
     void CommandList::setGraphicsState(const GraphicsState& state)
     {
         assert(m_CurrentCmdBuf);
 
+        // The complete state replaces anything set with the incremental setters since the last draw
+        m_PendingGraphicsState.reset();
+
         GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(state.pipeline);
         Framebuffer* fb = checked_cast<Framebuffer*>(state.framebuffer);
 
+        if (m_CommandListParameters.isBundle && !m_BundleFramebuffer)
+        {
+            beginBundleRecording(fb);
+        }
+
         if (m_EnableAutomaticBarriers)
         {
             insertGraphicsResourceBarriers(state);
@@ -542,7 +721,7 @@ namespace nvrhi::vulkan
 
         if (m_CurrentGraphicsState.pipeline != state.pipeline)
         {
-            m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->pipeline);
+            m_CurrentCmdBuf->cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pso->getBindablePipeline());
 
             m_CurrentCmdBuf->referencedResources.push_back(state.pipeline);
             updatePipeline = true;
@@ -568,28 +747,7 @@ namespace nvrhi::vulkan
             bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, state.bindings, pso->descriptorSetIdxToBindingIdx);
         }
 
-        if (!state.viewport.viewports.empty() && arraysAreDifferent(state.viewport.viewports, m_CurrentGraphicsState.viewport.viewports))
-        {
-            nvrhi::static_vector<vk::Viewport, c_MaxViewports> viewports;
-            for (const auto& vp : state.viewport.viewports)
-            {
-                viewports.push_back(VKViewportWithDXCoords(vp));
-            }
-
-            m_CurrentCmdBuf->cmdBuf.setViewport(0, uint32_t(viewports.size()), viewports.data());
-        }
-
-        if (!state.viewport.scissorRects.empty() && arraysAreDifferent(state.viewport.scissorRects, m_CurrentGraphicsState.viewport.scissorRects))
-        {
-            nvrhi::static_vector<vk::Rect2D, c_MaxViewports> scissors;
-            for (const auto& sc : state.viewport.scissorRects)
-            {
-                scissors.push_back(vk::Rect2D(vk::Offset2D(sc.minX, sc.minY),
-                    vk::Extent2D(std::abs(sc.maxX - sc.minX), std::abs(sc.maxY - sc.minY))));
-            }
-
-            m_CurrentCmdBuf->cmdBuf.setScissor(0, uint32_t(scissors.size()), scissors.data());
-        }
+        setViewports(state.viewport, m_CurrentGraphicsState.viewport);
 
         if (pso->desc.renderState.depthStencilState.dynamicStencilRef && (updatePipeline || m_CurrentGraphicsState.dynamicStencilRefValue != state.dynamicStencilRefValue))
         {
@@ -603,34 +761,12 @@ namespace nvrhi::vulkan
 
         if (state.indexBuffer.buffer && m_CurrentGraphicsState.indexBuffer != state.indexBuffer)
         {
-            m_CurrentCmdBuf->cmdBuf.bindIndexBuffer(checked_cast<Buffer*>(state.indexBuffer.buffer)->buffer,
-                state.indexBuffer.offset,
-                state.indexBuffer.format == Format::R16_UINT ?
-                vk::IndexType::eUint16 : vk::IndexType::eUint32);
-
-            m_CurrentCmdBuf->referencedResources.push_back(state.indexBuffer.buffer);
+            bindIndexBuffer(state.indexBuffer);
         }
 
         if (!state.vertexBuffers.empty() && arraysAreDifferent(state.vertexBuffers, m_CurrentGraphicsState.vertexBuffers))
         {
-            vk::Buffer vertexBuffers[c_MaxVertexAttributes];
-            vk::DeviceSize vertexBufferOffsets[c_MaxVertexAttributes];
-            uint32_t maxVbIndex = 0;
-
-            for (const auto& binding : state.vertexBuffers)
-            {
-                // This is tested by the validation layer, skip invalid slots here if VL is not used.
-                if (binding.slot >= c_MaxVertexAttributes)
-                    continue;
-
-                vertexBuffers[binding.slot] = checked_cast<Buffer*>(binding.buffer)->buffer;
-                vertexBufferOffsets[binding.slot] = vk::DeviceSize(binding.offset);
-                maxVbIndex = std::max(maxVbIndex, binding.slot);
-
-                m_CurrentCmdBuf->referencedResources.push_back(binding.buffer);
-            }
-
-            m_CurrentCmdBuf->cmdBuf.bindVertexBuffers(0, maxVbIndex + 1, vertexBuffers, vertexBufferOffsets);
+            bindVertexBuffers(state.vertexBuffers);
         }
 
         if (state.indirectParams)
@@ -638,6 +774,11 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
         }
 
+        if (state.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.push_back(state.indirectCountBuffer);
+        }
+
         if (state.shadingRateState.enabled)
         {
             vk::FragmentShadingRateCombinerOpKHR combiners[2] = { convertShadingRateCombiner(state.shadingRateState.pipelinePrimitiveCombiner), convertShadingRateCombiner(state.shadingRateState.imageCombiner) };
@@ -652,6 +793,98 @@ namespace nvrhi::vulkan
         m_AnyVolatileBufferWrites = false;
     }
 
+    void CommandList::beginBundleRecording(Framebuffer* framebuffer)
+    {
+        const FramebufferInfoEx& fbinfo = framebuffer->framebufferInfo;
+
+        static_vector<vk::Format, c_MaxRenderTargets> colorFormats;
+        for (Format format : fbinfo.colorFormats)
+            colorFormats.push_back(vk::Format(convertFormat(format)));
+
+        const FormatInfo& depthStencilFormatInfo = getFormatInfo(fbinfo.depthFormat);
+        const vk::Format depthStencilFormat = vk::Format(convertFormat(fbinfo.depthFormat));
+
+        auto renderingInfo = vk::CommandBufferInheritanceRenderingInfo()
+            .setColorAttachmentCount(uint32_t(colorFormats.size()))
+            .setPColorAttachmentFormats(colorFormats.data())
+            .setDepthAttachmentFormat(depthStencilFormatInfo.hasDepth ? depthStencilFormat : vk::Format::eUndefined)
+            .setStencilAttachmentFormat(depthStencilFormatInfo.hasStencil ? depthStencilFormat : vk::Format::eUndefined)
+            .setRasterizationSamples(vk::SampleCountFlagBits(fbinfo.sampleCount));
+
+        auto inheritanceInfo = vk::CommandBufferInheritanceInfo()
+            .setPNext(&renderingInfo);
+
+        // eSimultaneousUse because the bundle may be executed by several command buffers in flight
+        auto beginInfo = vk::CommandBufferBeginInfo()
+            .setFlags(vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse)
+            .setPInheritanceInfo(&inheritanceInfo);
+
+        (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
+
+        m_BundleFramebuffer = framebuffer;
+        m_CurrentCmdBuf->referencedResources.push_back(framebuffer);
+    }
+
+    void CommandList::executeBundles(ICommandList* const* bundles, size_t numBundles)
+    {
+        Framebuffer* framebuffer = nullptr;
+        static_vector<vk::CommandBuffer, 64> commandBuffers;
+
+        endRenderPass();
+
+        for (size_t i = 0; i < numBundles; i++)
+        {
+            CommandList* bundle = checked_cast<CommandList*>(bundles[i]);
+
+            if (!bundle->m_BundleFramebuffer)
+            {
+                m_Context.error("Cannot execute a bundle that was not recorded with any graphics state");
+                return;
+            }
+
+            if (framebuffer && bundle->m_BundleFramebuffer != framebuffer)
+            {
+                m_Context.error("All bundles executed together must be recorded with the same framebuffer");
+                return;
+            }
+
+            framebuffer = bundle->m_BundleFramebuffer;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                bundle->m_BundleStateRequirements.apply(m_StateTracker);
+            }
+        }
+
+        if (!framebuffer)
+            return;
+
+        commitBarriers();
+
+        beginRenderPass(framebuffer, vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+
+        for (size_t i = 0; i < numBundles; i++)
+        {
+            CommandList* bundle = checked_cast<CommandList*>(bundles[i]);
+
+            if (commandBuffers.size() == commandBuffers.max_size())
+            {
+                m_CurrentCmdBuf->cmdBuf.executeCommands(uint32_t(commandBuffers.size()), commandBuffers.data());
+                commandBuffers.resize(0);
+            }
+
+            commandBuffers.push_back(bundle->m_CurrentCmdBuf->cmdBuf);
+            m_CurrentCmdBuf->referencedBundles.push_back(bundle->m_CurrentCmdBuf);
+        }
+
+        m_CurrentCmdBuf->cmdBuf.executeCommands(uint32_t(commandBuffers.size()), commandBuffers.data());
+
+        endRenderPass();
+
+        // None of the state set by the secondary command buffers is inherited back
+        clearState();
+    }
+
     void CommandList::updateGraphicsVolatileBuffers()
     {
         if (m_AnyVolatileBufferWrites && m_CurrentGraphicsState.pipeline)
@@ -664,10 +897,102 @@ namespace nvrhi::vulkan
         }
     }
 
+    void CommandList::setGraphicsBindingSet(uint32_t slot, IBindingSet* bindingSet)
+    {
+        m_PendingGraphicsState.setBindingSet(m_CurrentGraphicsState.bindings, slot, bindingSet);
+    }
+
+    void CommandList::setVertexBuffers(const VertexBufferBinding* vertexBuffers, size_t numVertexBuffers)
+    {
+        m_PendingGraphicsState.setVertexBuffers(m_CurrentGraphicsState.vertexBuffers, vertexBuffers, numVertexBuffers);
+    }
+
+    void CommandList::setIndexBuffer(const IndexBufferBinding& indexBuffer)
+    {
+        m_PendingGraphicsState.setIndexBuffer(m_CurrentGraphicsState.indexBuffer, indexBuffer);
+    }
+
+    void CommandList::setViewportState(const ViewportState& viewport)
+    {
+        m_PendingGraphicsState.setViewport(m_CurrentGraphicsState.viewport, viewport);
+    }
+
+    void CommandList::commitGraphicsStateChanges()
+    {
+        GraphicsPipeline* pso = checked_cast<GraphicsPipeline*>(m_CurrentGraphicsState.pipeline);
+        Framebuffer* fb = checked_cast<Framebuffer*>(m_CurrentGraphicsState.framebuffer);
+        const PendingGraphicsState& pending = m_PendingGraphicsState;
+
+        if (!pso)
+        {
+            m_PendingGraphicsState.reset();
+            return;
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            if (pending.isDirty(GraphicsStateDirtyFlags::Bindings))
+                insertResourceBarriersForBindingSets(pending.bindings, m_CurrentGraphicsState.bindings);
+
+            if (pending.isDirty(GraphicsStateDirtyFlags::IndexBuffer) && pending.indexBuffer.buffer)
+                requireBufferState(pending.indexBuffer.buffer, ResourceStates::IndexBuffer);
+
+            if (pending.isDirty(GraphicsStateDirtyFlags::VertexBuffers))
+            {
+                for (const auto& vb : pending.vertexBuffers)
+                    requireBufferState(vb.buffer, ResourceStates::VertexBuffer);
+            }
+        }
+
+        // Barriers cannot be placed inside a render pass, so restart it if the new bindings need any
+        if (anyBarriers())
+        {
+            endRenderPass();
+            commitBarriers();
+            beginRenderPass(fb);
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Bindings))
+        {
+            bindBindingSets(vk::PipelineBindPoint::eGraphics, pso->pipelineLayout, pending.bindings, pso->descriptorSetIdxToBindingIdx);
+
+            m_CurrentGraphicsState.bindings = pending.bindings;
+            m_AnyVolatileBufferWrites = false;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::IndexBuffer))
+        {
+            if (pending.indexBuffer.buffer)
+                bindIndexBuffer(pending.indexBuffer);
+
+            m_CurrentGraphicsState.indexBuffer = pending.indexBuffer;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::VertexBuffers))
+        {
+            if (!pending.vertexBuffers.empty())
+                bindVertexBuffers(pending.vertexBuffers);
+
+            m_CurrentGraphicsState.vertexBuffers = pending.vertexBuffers;
+        }
+
+        if (pending.isDirty(GraphicsStateDirtyFlags::Viewport))
+        {
+            setViewports(pending.viewport, m_CurrentGraphicsState.viewport);
+
+            m_CurrentGraphicsState.viewport = pending.viewport;
+        }
+
+        m_PendingGraphicsState.reset();
+    }
+
     void CommandList::draw(const DrawArguments& args)
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         m_CurrentCmdBuf->cmdBuf.draw(args.vertexCount,
@@ -680,6 +1005,9 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         m_CurrentCmdBuf->cmdBuf.drawIndexed(args.vertexCount,
@@ -693,6 +1021,9 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
@@ -705,6 +1036,9 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
         updateGraphicsVolatileBuffers();
 
         Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
@@ -713,4 +1047,38 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.drawIndexedIndirect(indirectParams->buffer, offsetBytes, drawCount, sizeof(DrawIndexedIndirectArguments));
     }
 
+    void CommandList::drawIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
+        updateGraphicsVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && indirectCount);
+
+        m_CurrentCmdBuf->cmdBuf.drawIndirectCount(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes,
+            maxDrawCount, sizeof(DrawIndirectArguments));
+    }
+
+    void CommandList::drawIndexedIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDrawCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        if (m_PendingGraphicsState.any())
+            commitGraphicsStateChanges();
+
+        updateGraphicsVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectParams);
+        Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentGraphicsState.indirectCountBuffer);
+        assert(indirectParams && indirectCount);
+
+        m_CurrentCmdBuf->cmdBuf.drawIndexedIndirectCount(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes,
+            maxDrawCount, sizeof(DrawIndexedIndirectArguments));
+    }
+
 } // namespace nvrhi::vulkan
@@ -27,7 +27,7 @@ namespace nvrhi::vulkan
 {
     MeshletPipelineHandle Device::createMeshletPipeline(const MeshletPipelineDesc& desc, FramebufferInfo const& fbinfo)
     {
-        if (!m_Context.extensions.NV_mesh_shader)
+        if (!m_Context.extensions.EXT_mesh_shader && !m_Context.extensions.NV_mesh_shader)
         {
             utils::NotSupported();
             return nullptr;
@@ -124,6 +124,15 @@ namespace nvrhi::vulkan
                                 .setFront(convertStencilState(depthStencilState, depthStencilState.frontFaceStencil))
                                 .setBack(convertStencilState(depthStencilState, depthStencilState.backFaceStencil));
 
+        // VRS state, the primitive combiner applies the rates written by the mesh shader
+        std::array<vk::FragmentShadingRateCombinerOpKHR, 2> combiners = {
+            convertShadingRateCombiner(desc.shadingRateState.pipelinePrimitiveCombiner),
+            convertShadingRateCombiner(desc.shadingRateState.imageCombiner)
+        };
+        auto shadingRateState = vk::PipelineFragmentShadingRateStateCreateInfoKHR()
+            .setCombinerOps(combiners)
+            .setFragmentSize(convertFragmentShadingRate(desc.shadingRateState.shadingRate));
+
         res = createPipelineLayout(
             pso->pipelineLayout,
             pso->pipelineBindingLayouts,
@@ -146,7 +155,7 @@ namespace nvrhi::vulkan
 
         pso->usesBlendConstants = blendState.usesConstantColor(uint32_t(fbinfo.colorFormats.size()));
         
-        static_vector<vk::DynamicState, 4> dynamicStates = {
+        static_vector<vk::DynamicState, 5> dynamicStates = {
             vk::DynamicState::eViewport,
             vk::DynamicState::eScissor
         };
@@ -154,6 +163,8 @@ namespace nvrhi::vulkan
             dynamicStates.push_back(vk::DynamicState::eBlendConstants);
         if (pso->desc.renderState.depthStencilState.dynamicStencilRef)
             dynamicStates.push_back(vk::DynamicState::eStencilReference);
+        if (pso->desc.shadingRateState.enabled)
+            dynamicStates.push_back(vk::DynamicState::eFragmentShadingRateKHR);
 
         auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo()
             .setDynamicStateCount(uint32_t(dynamicStates.size()))
@@ -174,6 +185,7 @@ namespace nvrhi::vulkan
 
         auto pipelineInfo = vk::GraphicsPipelineCreateInfo()
             .setPNext(&renderingInfo)
+            .setFlags(m_Context.getPipelineCreateFlags(fbinfo))
             .setStageCount(uint32_t(shaderStages.size()))
             .setPStages(shaderStages.data())
             .setPInputAssemblyState(&inputAssembly)
@@ -187,6 +199,9 @@ namespace nvrhi::vulkan
             .setBasePipelineHandle(nullptr)
             .setBasePipelineIndex(-1);
 
+        if (pso->desc.shadingRateState.enabled)
+            renderingInfo.setPNext(&shadingRateState);
+
         res = m_Context.device.createGraphicsPipelines(m_Context.pipelineCache,
                                                      1, &pipelineInfo,
                                                      m_Context.allocationCallbacks,
@@ -321,6 +336,18 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(state.indirectParams);
         }
 
+        if (state.indirectCountBuffer)
+        {
+            m_CurrentCmdBuf->referencedResources.push_back(state.indirectCountBuffer);
+        }
+
+        if (state.shadingRateState.enabled)
+        {
+            vk::FragmentShadingRateCombinerOpKHR combiners[2] = { convertShadingRateCombiner(state.shadingRateState.pipelinePrimitiveCombiner), convertShadingRateCombiner(state.shadingRateState.imageCombiner) };
+            vk::Extent2D shadingRate = convertFragmentShadingRate(state.shadingRateState.shadingRate);
+            m_CurrentCmdBuf->cmdBuf.setFragmentShadingRateKHR(&shadingRate, combiners);
+        }
+
         m_CurrentComputeState = ComputeState();
         m_CurrentGraphicsState = GraphicsState();
         m_CurrentMeshletState = state;
@@ -344,9 +371,17 @@ namespace nvrhi::vulkan
     {
         assert(m_CurrentCmdBuf);
 
+        if (m_Context.extensions.EXT_mesh_shader)
+        {
+            updateMeshletVolatileBuffers();
+
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksEXT(groupsX, groupsY, groupsZ);
+            return;
+        }
+
         if (groupsY > 1 || groupsZ > 1)
         {
-            // only 1D dispatches are supported by Vulkan
+            // only 1D dispatches are supported by VK_NV_mesh_shader
             utils::NotSupported();
             return;
         }
@@ -356,4 +391,43 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.drawMeshTasksNV(groupsX, 0);
     }
 
+    void CommandList::dispatchMeshIndirect(uint32_t offsetBytes, uint32_t dispatchCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateMeshletVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        assert(indirectParams);
+
+        // VkDrawMeshTasksIndirectCommandEXT has the same layout as DispatchIndirectArguments.
+        // The NV entry point reads the first two members of DispatchIndirectArguments as taskCount and firstTask.
+        if (m_Context.extensions.EXT_mesh_shader)
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectEXT(indirectParams->buffer, offsetBytes, dispatchCount, sizeof(DispatchIndirectArguments));
+        else
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectNV(indirectParams->buffer, offsetBytes, dispatchCount, sizeof(DispatchIndirectArguments));
+    }
+
+    void CommandList::dispatchMeshIndirectCount(uint32_t paramOffsetBytes, uint32_t countOffsetBytes, uint32_t maxDispatchCount)
+    {
+        assert(m_CurrentCmdBuf);
+
+        updateMeshletVolatileBuffers();
+
+        Buffer* indirectParams = checked_cast<Buffer*>(m_CurrentMeshletState.indirectParams);
+        Buffer* indirectCount = checked_cast<Buffer*>(m_CurrentMeshletState.indirectCountBuffer);
+        assert(indirectParams && indirectCount);
+
+        if (m_Context.extensions.EXT_mesh_shader)
+        {
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountEXT(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes,
+                maxDispatchCount, sizeof(DispatchIndirectArguments));
+        }
+        else
+        {
+            m_CurrentCmdBuf->cmdBuf.drawMeshTasksIndirectCountNV(indirectParams->buffer, paramOffsetBytes, indirectCount->buffer, countOffsetBytes,
+                maxDispatchCount, sizeof(DispatchIndirectArguments));
+        }
+    }
+
 } // namespace nvrhi::vulkan
@@ -190,8 +190,20 @@ namespace nvrhi::vulkan
 
         if (!query->resolved)
         {
-            while(!pollTimerQuery(query))
-                ;
+            // block in the driver instead of spinning on pollTimerQuery
+            uint64_t timestamps[2] = { 0, 0 };
+
+            const vk::Result res = m_Context.device.getQueryPoolResults(m_TimerQueryPool,
+                query->beginQueryIndex, 2,
+                sizeof(timestamps), timestamps,
+                sizeof(timestamps[0]), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+            if (res != vk::Result::eSuccess)
+                return 0.f;
+
+            const auto timestampPeriod = m_Context.physicalDeviceProperties.limits.timestampPeriod; // in nanoseconds
+            query->time = float(double(timestamps[1] - timestamps[0]) * 1e-9 * timestampPeriod);
+            query->resolved = true;
         }
 
         query->started = false;
@@ -209,6 +221,529 @@ namespace nvrhi::vulkan
         query->time = 0.f;
     }
 
+    OcclusionQueryHandle Device::createOcclusionQuery(OcclusionQueryType type)
+    {
+        if (!m_OcclusionQueryPool)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (!m_OcclusionQueryPool)
+            {
+                // set up the occlusion query pool and the predicate values on first use
+                auto poolInfo = vk::QueryPoolCreateInfo()
+                    .setQueryType(vk::QueryType::eOcclusion)
+                    .setQueryCount(uint32_t(m_OcclusionQueryAllocator.getCapacity()));
+
+                vk::QueryPool queryPool;
+                const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &queryPool);
+                CHECK_VK_FAIL(res)
+
+                if (m_Context.extensions.EXT_conditional_rendering)
+                {
+                    BufferDesc predicationBufferDesc;
+                    predicationBufferDesc.byteSize = m_OcclusionQueryAllocator.getCapacity() * sizeof(uint32_t);
+                    predicationBufferDesc.isDrawIndirectArgs = true;
+                    predicationBufferDesc.debugName = "PredicationBuffer";
+
+                    BufferHandle predicationBuffer = createBuffer(predicationBufferDesc);
+                    m_PredicationBuffer = checked_cast<Buffer*>(predicationBuffer.Get());
+                }
+
+                m_OcclusionQueryPool = queryPool;
+            }
+        }
+
+        int queryIndex = m_OcclusionQueryAllocator.allocate();
+
+        if (queryIndex < 0)
+        {
+            m_Context.error("Insufficient query pool space, increase DeviceDesc::maxOcclusionQueries");
+            return nullptr;
+        }
+
+        OcclusionQuery* query = new OcclusionQuery(m_OcclusionQueryAllocator);
+        query->type = type;
+        query->queryIndex = queryIndex;
+
+        return OcclusionQueryHandle::Create(query);
+    }
+
+    OcclusionQuery::~OcclusionQuery()
+    {
+        m_QueryAllocator.release(queryIndex);
+        queryIndex = -1;
+    }
+
+    void CommandList::beginOcclusionQuery(IOcclusionQuery* _query)
+    {
+        endRenderPass();
+
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        assert(query->queryIndex >= 0);
+        assert(m_CurrentCmdBuf);
+
+        query->resolved = false;
+
+        const vk::QueryControlFlags flags = (query->type == OcclusionQueryType::SampleCount && m_Device->isOcclusionQueryPreciseSupported())
+            ? vk::QueryControlFlagBits::ePrecise
+            : vk::QueryControlFlags();
+
+        m_CurrentCmdBuf->cmdBuf.resetQueryPool(m_Device->getOcclusionQueryPool(), query->queryIndex, 1);
+        m_CurrentCmdBuf->cmdBuf.beginQuery(m_Device->getOcclusionQueryPool(), query->queryIndex, flags);
+    }
+
+    void CommandList::endOcclusionQuery(IOcclusionQuery* _query)
+    {
+        endRenderPass();
+
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        assert(query->queryIndex >= 0);
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->cmdBuf.endQuery(m_Device->getOcclusionQueryPool(), query->queryIndex);
+        query->started = true;
+    }
+
+    void CommandList::setPredication(IOcclusionQuery* _query, PredicationOp op)
+    {
+        assert(m_CurrentCmdBuf);
+
+        // conditional rendering that starts outside of a render pass must also end outside of it
+        endRenderPass();
+
+        if (m_PredicationEnabled)
+        {
+            m_CurrentCmdBuf->cmdBuf.endConditionalRenderingEXT();
+            m_PredicationEnabled = false;
+        }
+
+        if (!_query)
+            return;
+
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+        Buffer* predicationBuffer = m_Device->getPredicationBuffer();
+
+        if (!predicationBuffer)
+        {
+            m_Context.error("setPredication: VK_EXT_conditional_rendering is not enabled");
+            return;
+        }
+
+        const vk::DeviceSize offset = vk::DeviceSize(query->queryIndex) * sizeof(uint32_t);
+
+        // The predicate values bypass the state tracker, they're only written and read here.
+        // Wait for the earlier predicated commands before overwriting a value they may still be reading.
+        auto barrier = vk::BufferMemoryBarrier()
+            .setBuffer(predicationBuffer->buffer)
+            .setOffset(offset)
+            .setSize(sizeof(uint32_t))
+            .setSrcAccessMask(vk::AccessFlagBits::eConditionalRenderingReadEXT)
+            .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eConditionalRenderingEXT, vk::PipelineStageFlagBits::eTransfer,
+            vk::DependencyFlags(), {}, { barrier }, {});
+
+        // 32-bit results, which is what conditional rendering reads; eWait makes the copy wait for the query on the GPU
+        m_CurrentCmdBuf->cmdBuf.copyQueryPoolResults(m_Device->getOcclusionQueryPool(), query->queryIndex, 1,
+            predicationBuffer->buffer, offset, sizeof(uint32_t), vk::QueryResultFlagBits::eWait);
+
+        barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eConditionalRenderingReadEXT);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eConditionalRenderingEXT,
+            vk::DependencyFlags(), {}, { barrier }, {});
+
+        auto conditionalRenderingInfo = vk::ConditionalRenderingBeginInfoEXT()
+            .setBuffer(predicationBuffer->buffer)
+            .setOffset(offset)
+            .setFlags(op == PredicationOp::SkipIfNotZero ? vk::ConditionalRenderingFlagBitsEXT::eInverted : vk::ConditionalRenderingFlagsEXT());
+
+        m_CurrentCmdBuf->cmdBuf.beginConditionalRenderingEXT(conditionalRenderingInfo);
+        m_PredicationEnabled = true;
+    }
+
+    bool Device::pollOcclusionQuery(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        if (!query->started)
+            return false;
+
+        if (query->resolved)
+            return true;
+
+        uint64_t result = 0;
+
+        const vk::Result res = m_Context.device.getQueryPoolResults(m_OcclusionQueryPool,
+            query->queryIndex, 1,
+            sizeof(result), &result,
+            sizeof(result), vk::QueryResultFlagBits::e64);
+
+        if (res != vk::Result::eSuccess)
+            return false;
+
+        query->result = result;
+        query->resolved = true;
+        return true;
+    }
+
+    uint64_t Device::getOcclusionQueryResult(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        if (!query->started)
+            return 0;
+
+        if (!query->resolved)
+        {
+            uint64_t result = 0;
+
+            const vk::Result res = m_Context.device.getQueryPoolResults(m_OcclusionQueryPool,
+                query->queryIndex, 1,
+                sizeof(result), &result,
+                sizeof(result), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+            if (res != vk::Result::eSuccess)
+                return 0;
+
+            query->result = result;
+            query->resolved = true;
+        }
+
+        return query->result;
+    }
+
+    void Device::resetOcclusionQuery(IOcclusionQuery* _query)
+    {
+        OcclusionQuery* query = checked_cast<OcclusionQuery*>(_query);
+
+        query->started = false;
+        query->resolved = false;
+        query->result = 0;
+    }
+
+    PipelineStatisticsQueryHandle Device::createPipelineStatisticsQuery()
+    {
+        if (!m_PipelineStatisticsQuerySupported)
+        {
+            m_Context.error("Pipeline statistics queries require the pipelineStatisticsQuery feature, "
+                "see DeviceDesc::pipelineStatisticsQuerySupported");
+            return nullptr;
+        }
+
+        if (!m_PipelineStatisticsQueryPool)
+        {
+            std::lock_guard lockGuard(m_Mutex);
+
+            if (!m_PipelineStatisticsQueryPool)
+            {
+                // the order of the flags determines the order of the results, which matches PipelineStatistics
+                auto poolInfo = vk::QueryPoolCreateInfo()
+                    .setQueryType(vk::QueryType::ePipelineStatistics)
+                    .setQueryCount(uint32_t(m_PipelineStatisticsQueryAllocator.getCapacity()))
+                    .setPipelineStatistics(
+                        vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+                        vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+                        vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+                        vk::QueryPipelineStatisticFlagBits::eGeometryShaderInvocations |
+                        vk::QueryPipelineStatisticFlagBits::eGeometryShaderPrimitives |
+                        vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+                        vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+                        vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+                        vk::QueryPipelineStatisticFlagBits::eTessellationControlShaderPatches |
+                        vk::QueryPipelineStatisticFlagBits::eTessellationEvaluationShaderInvocations |
+                        vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations);
+
+                const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &m_PipelineStatisticsQueryPool);
+                CHECK_VK_FAIL(res)
+            }
+        }
+
+        int queryIndex = m_PipelineStatisticsQueryAllocator.allocate();
+
+        if (queryIndex < 0)
+        {
+            m_Context.error("Insufficient query pool space, increase DeviceDesc::maxPipelineStatisticsQueries");
+            return nullptr;
+        }
+
+        PipelineStatisticsQuery* query = new PipelineStatisticsQuery(m_PipelineStatisticsQueryAllocator);
+        query->queryIndex = queryIndex;
+
+        return PipelineStatisticsQueryHandle::Create(query);
+    }
+
+    PipelineStatisticsQuery::~PipelineStatisticsQuery()
+    {
+        m_QueryAllocator.release(queryIndex);
+        queryIndex = -1;
+    }
+
+    void CommandList::beginPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        if (m_CommandListParameters.queueType != CommandQueue::Graphics)
+        {
+            m_Context.error("Pipeline statistics queries are only supported on the graphics queue");
+            return;
+        }
+
+        endRenderPass();
+
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        assert(query->queryIndex >= 0);
+        assert(m_CurrentCmdBuf);
+
+        query->resolved = false;
+
+        m_CurrentCmdBuf->cmdBuf.resetQueryPool(m_Device->getPipelineStatisticsQueryPool(), query->queryIndex, 1);
+        m_CurrentCmdBuf->cmdBuf.beginQuery(m_Device->getPipelineStatisticsQueryPool(), query->queryIndex, vk::QueryControlFlags());
+    }
+
+    void CommandList::endPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        if (m_CommandListParameters.queueType != CommandQueue::Graphics)
+            return;
+
+        endRenderPass();
+
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        assert(query->queryIndex >= 0);
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->cmdBuf.endQuery(m_Device->getPipelineStatisticsQueryPool(), query->queryIndex);
+        query->started = true;
+    }
+
+    bool Device::pollPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        if (!query->started)
+            return false;
+
+        if (query->resolved)
+            return true;
+
+        PipelineStatistics result;
+
+        const vk::Result res = m_Context.device.getQueryPoolResults(m_PipelineStatisticsQueryPool,
+            query->queryIndex, 1,
+            sizeof(result), &result,
+            sizeof(result), vk::QueryResultFlagBits::e64);
+
+        if (res != vk::Result::eSuccess)
+            return false;
+
+        query->result = result;
+        query->resolved = true;
+        return true;
+    }
+
+    PipelineStatistics Device::getPipelineStatisticsQueryResult(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        if (!query->started)
+            return PipelineStatistics();
+
+        if (!query->resolved)
+        {
+            PipelineStatistics result;
+
+            const vk::Result res = m_Context.device.getQueryPoolResults(m_PipelineStatisticsQueryPool,
+                query->queryIndex, 1,
+                sizeof(result), &result,
+                sizeof(result), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+            if (res != vk::Result::eSuccess)
+                return PipelineStatistics();
+
+            query->result = result;
+            query->resolved = true;
+        }
+
+        return query->result;
+    }
+
+    void Device::resetPipelineStatisticsQuery(IPipelineStatisticsQuery* _query)
+    {
+        PipelineStatisticsQuery* query = checked_cast<PipelineStatisticsQuery*>(_query);
+
+        query->started = false;
+        query->resolved = false;
+        query->result = PipelineStatistics();
+    }
+
+    TimerQueryPoolHandle Device::createTimerQueryPool(const TimerQueryPoolDesc& desc)
+    {
+        auto poolInfo = vk::QueryPoolCreateInfo()
+            .setQueryType(vk::QueryType::eTimestamp)
+            .setQueryCount(desc.maxQueriesPerFrame * desc.maxFramesInFlight * 2); // 2 timestamps per query
+
+        vk::QueryPool queryPool;
+        const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &queryPool);
+        CHECK_VK_FAIL(res)
+
+        TimerQueryPool* pool = new TimerQueryPool(m_Context);
+        pool->desc = desc;
+        pool->queryPool = queryPool;
+        pool->frames = std::vector<TimerQueryPool::Frame>(desc.maxFramesInFlight);
+
+        if (!desc.debugName.empty())
+            m_Context.nameVKObject(VkQueryPool(queryPool), vk::ObjectType::eQueryPool, vk::DebugReportObjectTypeEXT::eQueryPool, desc.debugName.c_str());
+
+        return TimerQueryPoolHandle::Create(pool);
+    }
+
+    TimerQueryPool::~TimerQueryPool()
+    {
+        if (queryPool)
+        {
+            m_Context.device.destroyQueryPool(queryPool, m_Context.allocationCallbacks);
+            queryPool = nullptr;
+        }
+    }
+
+    Object TimerQueryPool::getNativeObject(ObjectType objectType)
+    {
+        switch (objectType)
+        {
+        case ObjectTypes::VK_QueryPool:
+            return Object(queryPool);
+        default:
+            return nullptr;
+        }
+    }
+
+    bool Device::getTimerQueryPoolResults(ITimerQueryPool* pool, uint64_t frameIndex, float* pTimes, uint32_t numQueries)
+    {
+        std::vector<double> timestamps(numQueries * 2);
+
+        if (!getTimerQueryPoolTimestamps(pool, frameIndex, timestamps.data(), numQueries))
+            return false;
+
+        for (uint32_t index = 0; index < numQueries; index++)
+        {
+            const double begin = timestamps[index * 2];
+            const double end = timestamps[index * 2 + 1];
+            pTimes[index] = (end > begin) ? float(end - begin) : 0.f;
+        }
+
+        return true;
+    }
+
+    bool Device::getTimerQueryPoolTimestamps(ITimerQueryPool* _pool, uint64_t frameIndex, double* pTimestamps, uint32_t numQueries)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        if (frameIndex == 0)
+            return false;
+
+        std::lock_guard lockGuard(pool->mutex);
+
+        const TimerQueryPool::Frame& frame = pool->getFrame(frameIndex);
+
+        if (frame.frameIndex != frameIndex || frame.submissionID == 0)
+            return false;
+
+        if (!m_Queues[uint32_t(frame.queue)]->pollCommandList(frame.submissionID))
+            return false;
+
+        if (numQueries == 0)
+            return true;
+
+        // the queries that were not written in this frame stay unavailable, read them with availability
+        // so that the whole range can be fetched in one call
+        struct TimestampWithAvailability
+        {
+            uint64_t value;
+            uint64_t available;
+        };
+
+        std::vector<TimestampWithAvailability> timestamps(numQueries * 2);
+
+        const vk::Result res = m_Context.device.getQueryPoolResults(pool->queryPool,
+            pool->getFirstQuery(frameIndex), numQueries * 2,
+            timestamps.size() * sizeof(TimestampWithAvailability), timestamps.data(),
+            sizeof(TimestampWithAvailability), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+        if (res != vk::Result::eSuccess && res != vk::Result::eNotReady)
+            return false;
+
+        const double scale = 1e-9 * m_Context.physicalDeviceProperties.limits.timestampPeriod;
+
+        for (uint32_t index = 0; index < numQueries * 2; index++)
+        {
+            pTimestamps[index] = timestamps[index].available ? double(timestamps[index].value) * scale : 0.0;
+        }
+
+        return true;
+    }
+
+    void CommandList::beginTimerQueryFrame(ITimerQueryPool* _pool)
+    {
+        endRenderPass();
+
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        uint64_t frameIndex;
+        {
+            std::lock_guard lockGuard(pool->mutex);
+
+            frameIndex = ++pool->currentFrameIndex;
+
+            TimerQueryPool::Frame& frame = pool->getFrame(frameIndex);
+            frame.frameIndex = frameIndex;
+            frame.submissionID = 0;
+        }
+
+        m_CurrentCmdBuf->cmdBuf.resetQueryPool(pool->queryPool, pool->getFirstQuery(frameIndex), pool->desc.maxQueriesPerFrame * 2);
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+    }
+
+    void CommandList::beginTimerQuery(ITimerQueryPool* _pool, uint32_t queryIndex)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        assert(queryIndex < pool->desc.maxQueriesPerFrame);
+        assert(m_CurrentCmdBuf);
+
+        // timestamps are allowed inside render passes, unlike resets
+        m_CurrentCmdBuf->cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pool->queryPool,
+            pool->getFirstQuery(pool->currentFrameIndex) + queryIndex * 2);
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+    }
+
+    void CommandList::endTimerQuery(ITimerQueryPool* _pool, uint32_t queryIndex)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        assert(queryIndex < pool->desc.maxQueriesPerFrame);
+        assert(m_CurrentCmdBuf);
+
+        m_CurrentCmdBuf->cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pool->queryPool,
+            pool->getFirstQuery(pool->currentFrameIndex) + queryIndex * 2 + 1);
+    }
+
+    void CommandList::resolveTimerQueries(ITimerQueryPool* _pool)
+    {
+        TimerQueryPool* pool = checked_cast<TimerQueryPool*>(_pool);
+
+        assert(m_CurrentCmdBuf);
+
+        // nothing to record, the results are copied on the host by getTimerQueryPoolResults once the submission completes
+        m_CurrentCmdBuf->resolvedTimerQueryFrames.emplace_back(pool, pool->currentFrameIndex);
+        m_CurrentCmdBuf->referencedResources.push_back(pool);
+    }
+
 
     void CommandList::beginMarker(const char* name)
     {
@@ -29,9 +29,35 @@ namespace nvrhi::vulkan
 
     TrackedCommandBuffer::~TrackedCommandBuffer()
     {
+        resetTransientBindingSets();
+
+        for (vk::DescriptorPool pool : transientDescriptorPools)
+        {
+            m_Context.device.destroyDescriptorPool(pool, m_Context.allocationCallbacks);
+        }
+
+        for (const TlsfAllocator::Allocation& range : transientDescriptorBufferRanges)
+        {
+            m_Context.descriptorBuffer->releaseImmediately(range);
+        }
+
+        for (vk::Event event : splitBarrierEvents)
+        {
+            m_Context.device.destroyEvent(event, m_Context.allocationCallbacks);
+        }
+
         m_Context.device.destroyCommandPool(cmdPool, m_Context.allocationCallbacks);
     }
 
+    void TrackedCommandBuffer::resetTransientBindingSets()
+    {
+        for (size_t index = 0; index < numTransientBindingSetsUsed; index++)
+        {
+            checked_cast<BindingSet*>(transientBindingSets[index].Get())->resetTransient();
+        }
+        numTransientBindingSetsUsed = 0;
+    }
+
     Queue::Queue(const VulkanContext& context, CommandQueue queueID, vk::Queue queue, uint32_t queueFamilyIndex)
         : m_Context(context)
         , m_Queue(queue)
@@ -53,7 +79,7 @@ namespace nvrhi::vulkan
         trackingSemaphore = vk::Semaphore();
     }
 
-    TrackedCommandBufferPtr Queue::createCommandBuffer()
+    TrackedCommandBufferPtr Queue::createCommandBuffer(vk::CommandBufferLevel level)
     {
         vk::Result res;
 
@@ -69,7 +95,7 @@ namespace nvrhi::vulkan
         
         // allocate command buffer
         auto allocInfo = vk::CommandBufferAllocateInfo()
-                            .setLevel(vk::CommandBufferLevel::ePrimary)
+                            .setLevel(level)
                             .setCommandPool(ret->cmdPool)
                             .setCommandBufferCount(1);
 
@@ -92,21 +118,42 @@ namespace nvrhi::vulkan
         }
         else
         {
-            cmdBuf = m_CommandBuffersPool.front();
-            m_CommandBuffersPool.pop_front();
+            // keep the list node for the in-flight list, see submit
+            cmdBuf = std::move(m_CommandBuffersPool.front());
+            m_SpareListNodes.splice(m_SpareListNodes.end(), m_CommandBuffersPool, m_CommandBuffersPool.begin());
         }
 
         cmdBuf->recordingID = recordingID;
         return cmdBuf;
     }
 
-    void Queue::addWaitSemaphore(vk::Semaphore semaphore, uint64_t value)
+    void Queue::releaseReusableCommandBuffer(TrackedCommandBufferPtr commandBuffer)
+    {
+        std::lock_guard lockGuard(m_Mutex);
+
+        // A command buffer that was never submitted has submissionID 0 and is retired right away
+        commandBuffer->ownedByReusableList = false;
+
+        if (m_SpareListNodes.empty())
+        {
+            m_CommandBuffersInFlight.push_back(std::move(commandBuffer));
+        }
+        else
+        {
+            m_CommandBuffersInFlight.splice(m_CommandBuffersInFlight.end(), m_SpareListNodes, m_SpareListNodes.begin());
+            m_CommandBuffersInFlight.back() = std::move(commandBuffer);
+        }
+    }
+
+    void Queue::addWaitSemaphore(vk::Semaphore semaphore, uint64_t value, vk::PipelineStageFlags2 waitStageMask)
     {
         if (!semaphore)
             return;
 
-        m_WaitSemaphores.push_back(semaphore);
-        m_WaitSemaphoreValues.push_back(value);
+        m_WaitSemaphores.push_back(vk::SemaphoreSubmitInfo()
+            .setSemaphore(semaphore)
+            .setValue(value)
+            .setStageMask(waitStageMask));
     }
 
     void Queue::addSignalSemaphore(vk::Semaphore semaphore, uint64_t value)
@@ -114,62 +161,141 @@ namespace nvrhi::vulkan
         if (!semaphore)
             return;
 
-        m_SignalSemaphores.push_back(semaphore);
-        m_SignalSemaphoreValues.push_back(value);
+        m_SignalSemaphores.push_back(vk::SemaphoreSubmitInfo()
+            .setSemaphore(semaphore)
+            .setValue(value)
+            .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+    }
+
+    void Queue::beginSubmitBatch()
+    {
+        m_SubmitBatches.push_back(SubmitBatch{
+            uint32_t(m_SubmitWaitInfos.size()),
+            uint32_t(m_SubmitCommandBuffers.size()),
+            uint32_t(m_SubmitSignalInfos.size()) });
+    }
+
+    bool Queue::isSubmitBatchEmpty() const
+    {
+        const SubmitBatch& batch = m_SubmitBatches.back();
+        return batch.firstCommandBuffer == m_SubmitCommandBuffers.size() && batch.firstSignal == m_SubmitSignalInfos.size();
     }
 
     uint64_t Queue::submit(ICommandList* const* ppCmd, size_t numCmd)
     {
-        std::vector<vk::PipelineStageFlags> waitStageArray(m_WaitSemaphores.size());
-        std::vector<vk::CommandBuffer> commandBuffers(numCmd);
+        m_SubmitWaitInfos.clear();
+        m_SubmitCommandBuffers.clear();
+        m_SubmitSignalInfos.clear();
+        m_SubmitBatches.clear();
+
+        // Command lists split by sync points are submitted as several batches,
+        // with the sync point signals and waits between them
+        beginSubmitBatch();
+        m_SubmitWaitInfos.insert(m_SubmitWaitInfos.end(), m_WaitSemaphores.begin(), m_WaitSemaphores.end());
 
-        for (size_t i = 0; i < m_WaitSemaphores.size(); i++)
+        for (size_t i = 0; i < numCmd; i++)
         {
-            waitStageArray[i] = vk::PipelineStageFlagBits::eTopOfPipe;
+            CommandList* commandList = checked_cast<CommandList*>(ppCmd[i]);
+            TrackedCommandBufferPtr commandBuffer = commandList->getCurrentCmdBuf();
+
+            for (const TrackedCommandBuffer::SyncSegment& segment : commandBuffer->syncSegments)
+            {
+                m_SubmitCommandBuffers.push_back(vk::CommandBufferSubmitInfo()
+                    .setCommandBuffer(segment.cmdBuf));
+
+                if (segment.signalAfter)
+                {
+                    segment.signalAfter->value = ++m_LastSubmittedID;
+
+                    m_SubmitSignalInfos.push_back(vk::SemaphoreSubmitInfo()
+                        .setSemaphore(trackingSemaphore)
+                        .setValue(m_LastSubmittedID)
+                        .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+
+                    beginSubmitBatch();
+                }
+
+                if (segment.waitAfter)
+                {
+                    const uint64_t value = segment.waitAfter->value;
+                    if (value == 0)
+                    {
+                        m_Context.error("A command list waits for a sync point that is signaled by a command list "
+                            "which has not been executed yet, the wait is ignored");
+                        continue;
+                    }
+
+                    if (!isSubmitBatchEmpty())
+                        beginSubmitBatch();
+
+                    m_SubmitWaitInfos.push_back(vk::SemaphoreSubmitInfo()
+                        .setSemaphore(segment.waitAfter->semaphore)
+                        .setValue(value)
+                        .setStageMask(segment.waitStages));
+                }
+            }
+
+            m_SubmitCommandBuffers.push_back(vk::CommandBufferSubmitInfo()
+                .setCommandBuffer(commandBuffer->cmdBuf));
+
+            // The command list keeps a reusable command buffer until it is released
+            if (!commandBuffer->ownedByReusableList)
+            {
+                std::lock_guard lockGuard(m_Mutex);
+
+                if (m_SpareListNodes.empty())
+                {
+                    m_CommandBuffersInFlight.push_back(commandBuffer);
+                }
+                else
+                {
+                    m_CommandBuffersInFlight.splice(m_CommandBuffersInFlight.end(), m_SpareListNodes, m_SpareListNodes.begin());
+                    m_CommandBuffersInFlight.back() = commandBuffer;
+                }
+            }
         }
 
         m_LastSubmittedID++;
-
+        
         for (size_t i = 0; i < numCmd; i++)
         {
             CommandList* commandList = checked_cast<CommandList*>(ppCmd[i]);
-            TrackedCommandBufferPtr commandBuffer = commandList->getCurrentCmdBuf();
-
-            commandBuffers[i] = commandBuffer->cmdBuf;
-            m_CommandBuffersInFlight.push_back(commandBuffer);
 
-            for (const auto& buffer : commandBuffer->referencedStagingBuffers)
+            for (const auto& buffer : commandList->getCurrentCmdBuf()->referencedStagingBuffers)
             {
                 buffer->lastUseQueue = m_QueueID;
                 buffer->lastUseCommandListID = m_LastSubmittedID;
             }
         }
-        
-        m_SignalSemaphores.push_back(trackingSemaphore);
-        m_SignalSemaphoreValues.push_back(m_LastSubmittedID);
 
-        auto timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
-            .setSignalSemaphoreValueCount(uint32_t(m_SignalSemaphoreValues.size()))
-            .setPSignalSemaphoreValues(m_SignalSemaphoreValues.data());
+        addSignalSemaphore(trackingSemaphore, m_LastSubmittedID);
+        m_SubmitSignalInfos.insert(m_SubmitSignalInfos.end(), m_SignalSemaphores.begin(), m_SignalSemaphores.end());
 
-        if (!m_WaitSemaphoreValues.empty()) 
-        {
-            timelineSemaphoreInfo.setWaitSemaphoreValueCount(uint32_t(m_WaitSemaphoreValues.size()));
-            timelineSemaphoreInfo.setPWaitSemaphoreValues(m_WaitSemaphoreValues.data());
-        }
+        try {
+            if (m_Context.extensions.KHR_synchronization2)
+            {
+                m_SubmitInfos.clear();
 
-        auto submitInfo = vk::SubmitInfo()
-            .setPNext(&timelineSemaphoreInfo)
-            .setCommandBufferCount(uint32_t(numCmd))
-            .setPCommandBuffers(commandBuffers.data())
-            .setWaitSemaphoreCount(uint32_t(m_WaitSemaphores.size()))
-            .setPWaitSemaphores(m_WaitSemaphores.data())
-            .setPWaitDstStageMask(waitStageArray.data())
-            .setSignalSemaphoreCount(uint32_t(m_SignalSemaphores.size()))
-            .setPSignalSemaphores(m_SignalSemaphores.data());
+                for (size_t index = 0; index < m_SubmitBatches.size(); index++)
+                {
+                    const SubmitBatch& batch = m_SubmitBatches[index];
+                    const SubmitBatch end = getSubmitBatchEnd(index);
+
+                    m_SubmitInfos.push_back(vk::SubmitInfo2()
+                        .setWaitSemaphoreInfoCount(end.firstWait - batch.firstWait)
+                        .setPWaitSemaphoreInfos(m_SubmitWaitInfos.data() + batch.firstWait)
+                        .setCommandBufferInfoCount(end.firstCommandBuffer - batch.firstCommandBuffer)
+                        .setPCommandBufferInfos(m_SubmitCommandBuffers.data() + batch.firstCommandBuffer)
+                        .setSignalSemaphoreInfoCount(end.firstSignal - batch.firstSignal)
+                        .setPSignalSemaphoreInfos(m_SubmitSignalInfos.data() + batch.firstSignal));
+                }
 
-        try {
-            m_Queue.submit(submitInfo);
+                m_Queue.submit2(m_SubmitInfos);
+            }
+            else
+            {
+                submitLegacy();
+            }
         }
         catch (vk::DeviceLostError&)
         {
@@ -177,13 +303,83 @@ namespace nvrhi::vulkan
         }
 
         m_WaitSemaphores.clear();
-        m_WaitSemaphoreValues.clear();
         m_SignalSemaphores.clear();
-        m_SignalSemaphoreValues.clear();
         
         return m_LastSubmittedID;
     }
 
+    Queue::SubmitBatch Queue::getSubmitBatchEnd(size_t index) const
+    {
+        if (index + 1 < m_SubmitBatches.size())
+            return m_SubmitBatches[index + 1];
+
+        return SubmitBatch{
+            uint32_t(m_SubmitWaitInfos.size()),
+            uint32_t(m_SubmitCommandBuffers.size()),
+            uint32_t(m_SubmitSignalInfos.size()) };
+    }
+
+    void Queue::submitLegacy()
+    {
+        m_LegacySubmitCommandBuffers.clear();
+        m_LegacyWaitSemaphores.clear();
+        m_LegacyWaitSemaphoreValues.clear();
+        m_LegacyWaitStages.clear();
+        m_LegacySignalSemaphores.clear();
+        m_LegacySignalSemaphoreValues.clear();
+
+        // The legacy arrays are parallel to the synchronization2 ones, so the batches index them the same way
+        for (const vk::CommandBufferSubmitInfo& info : m_SubmitCommandBuffers)
+            m_LegacySubmitCommandBuffers.push_back(info.commandBuffer);
+
+        for (const vk::SemaphoreSubmitInfo& info : m_SubmitWaitInfos)
+        {
+            m_LegacyWaitSemaphores.push_back(info.semaphore);
+            m_LegacyWaitSemaphoreValues.push_back(info.value);
+
+            // synchronization2 stage flags are identical to the old values within the 32-bit range
+            auto stages = vk::PipelineStageFlags(VkPipelineStageFlags(VkPipelineStageFlags2(info.stageMask)));
+            m_LegacyWaitStages.push_back(stages ? stages : vk::PipelineStageFlagBits::eAllCommands);
+        }
+
+        for (const vk::SemaphoreSubmitInfo& info : m_SubmitSignalInfos)
+        {
+            m_LegacySignalSemaphores.push_back(info.semaphore);
+            m_LegacySignalSemaphoreValues.push_back(info.value);
+        }
+
+        // the timeline infos are referenced by the submit infos, so size them before taking pointers
+        m_LegacyTimelineSemaphoreInfos.resize(m_SubmitBatches.size());
+        m_LegacySubmitInfos.clear();
+
+        for (size_t index = 0; index < m_SubmitBatches.size(); index++)
+        {
+            const SubmitBatch& batch = m_SubmitBatches[index];
+            const SubmitBatch end = getSubmitBatchEnd(index);
+            const uint32_t numWaits = end.firstWait - batch.firstWait;
+            const uint32_t numSignals = end.firstSignal - batch.firstSignal;
+
+            vk::TimelineSemaphoreSubmitInfo& timelineSemaphoreInfo = m_LegacyTimelineSemaphoreInfos[index];
+            timelineSemaphoreInfo = vk::TimelineSemaphoreSubmitInfo()
+                .setWaitSemaphoreValueCount(numWaits)
+                .setPWaitSemaphoreValues(m_LegacyWaitSemaphoreValues.data() + batch.firstWait)
+                .setSignalSemaphoreValueCount(numSignals)
+                .setPSignalSemaphoreValues(m_LegacySignalSemaphoreValues.data() + batch.firstSignal);
+
+            m_LegacySubmitInfos.push_back(vk::SubmitInfo()
+                .setPNext(&timelineSemaphoreInfo)
+                .setCommandBufferCount(end.firstCommandBuffer - batch.firstCommandBuffer)
+                .setPCommandBuffers(m_LegacySubmitCommandBuffers.data() + batch.firstCommandBuffer)
+                .setWaitSemaphoreCount(numWaits)
+                .setPWaitSemaphores(m_LegacyWaitSemaphores.data() + batch.firstWait)
+                .setPWaitDstStageMask(m_LegacyWaitStages.data() + batch.firstWait)
+                .setSignalSemaphoreCount(numSignals)
+                .setPSignalSemaphores(m_LegacySignalSemaphores.data() + batch.firstSignal));
+        }
+
+        m_Queue.submit(m_LegacySubmitInfos);
+    }
+
     void Queue::updateTextureTileMappings(ITexture* _texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
@@ -284,6 +480,39 @@ namespace nvrhi::vulkan
         m_Queue.bindSparse(bindSparseInfo, vk::Fence());
     }
 
+    void Queue::updateBufferTileMappings(IBuffer* _buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        std::vector<vk::SparseMemoryBind> sparseMemoryBinds;
+        sparseMemoryBinds.reserve(numTileMappings);
+
+        for (uint32_t i = 0; i < numTileMappings; i++)
+        {
+            const BufferTilesMapping& mapping = tileMappings[i];
+            Heap* heap = mapping.heap ? checked_cast<Heap*>(mapping.heap) : nullptr;
+            vk::DeviceMemory deviceMemory = heap ? heap->memory : VK_NULL_HANDLE;
+
+            sparseMemoryBinds.push_back(vk::SparseMemoryBind()
+                .setResourceOffset(mapping.bufferOffset)
+                .setSize(mapping.byteSize)
+                .setMemory(deviceMemory)
+                .setMemoryOffset(deviceMemory ? mapping.heapOffset : 0));
+        }
+
+        if (sparseMemoryBinds.empty())
+            return;
+
+        vk::SparseBufferMemoryBindInfo sparseBufferMemoryBindInfo;
+        sparseBufferMemoryBindInfo.setBuffer(buffer->buffer);
+        sparseBufferMemoryBindInfo.setBinds(sparseMemoryBinds);
+
+        vk::BindSparseInfo bindSparseInfo = {};
+        bindSparseInfo.setBufferBinds(sparseBufferMemoryBindInfo);
+
+        m_Queue.bindSparse(bindSparseInfo, vk::Fence());
+    }
+
     uint64_t Queue::updateLastFinishedID()
     {
         m_LastFinishedID = m_Context.device.getSemaphoreCounterValue(trackingSemaphore);
@@ -293,18 +522,87 @@ namespace nvrhi::vulkan
 
     void Queue::retireCommandBuffers()
     {
-        std::list<TrackedCommandBufferPtr> submissions = std::move(m_CommandBuffersInFlight);
-
         uint64_t lastFinishedID = updateLastFinishedID();
         
-        for (const TrackedCommandBufferPtr& cmd : submissions)
+        auto it = m_CommandBuffersInFlight.begin();
+        while (it != m_CommandBuffersInFlight.end())
         {
+            const TrackedCommandBufferPtr& cmd = *it;
+
             if (cmd->submissionID <= lastFinishedID)
             {
                 cmd->referencedResources.clear();
                 cmd->referencedStagingBuffers.clear();
+                cmd->referencedBundles.clear();
+                cmd->retainedUploadManagers.clear();
                 cmd->submissionID = 0;
-                m_CommandBuffersPool.push_back(cmd);
+
+                // recycle all descriptors of the transient binding sets at once
+                cmd->resetTransientBindingSets();
+                for (vk::DescriptorPool pool : cmd->transientDescriptorPools)
+                {
+                    m_Context.device.resetDescriptorPool(pool);
+                }
+                cmd->currentTransientDescriptorPool = 0;
+
+                for (const TlsfAllocator::Allocation& range : cmd->transientDescriptorBufferRanges)
+                {
+                    m_Context.descriptorBuffer->releaseImmediately(range);
+                }
+                cmd->transientDescriptorBufferRanges.clear();
+
+                // the split barriers have signaled their events, unsignal them for reuse
+                for (size_t index = 0; index < cmd->numSplitBarrierEventsUsed; index++)
+                {
+                    m_Context.device.resetEvent(cmd->splitBarrierEvents[index]);
+                }
+                cmd->numSplitBarrierEventsUsed = 0;
+
+                for (const TrackedCommandBuffer::SyncSegment& segment : cmd->syncSegments)
+                {
+                    cmd->spareSegmentCmdBufs.push_back(segment.cmdBuf);
+                }
+                cmd->syncSegments.clear();
+
+                if (!cmd->accelStructsToCompact.empty())
+                {
+                    {
+                        std::lock_guard lockGuard(m_Context.accelStructCompaction->mutex);
+
+                        // A BLAS can be built by several command buffers before it is compacted, list it only once
+                        for (const rt::AccelStructHandle& handle : cmd->accelStructsToCompact)
+                        {
+                            AccelStruct* as = checked_cast<AccelStruct*>(handle.Get());
+                            if (!as->compactionPending)
+                            {
+                                as->compactionPending = true;
+                                m_Context.accelStructCompaction->candidates.push_back(as);
+                            }
+                        }
+                    }
+
+                    // Released outside of the lock, the AccelStruct destructor takes it
+                    cmd->accelStructsToCompact.clear();
+                }
+
+                if (!cmd->micromapsToCompact.empty())
+                {
+                    {
+                        std::lock_guard lockGuard(m_Context.accelStructCompaction->mutex);
+
+                        for (const rt::OpacityMicromapHandle& handle : cmd->micromapsToCompact)
+                        {
+                            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(handle.Get());
+                            if (!omm->compactionPending)
+                            {
+                                omm->compactionPending = true;
+                                m_Context.accelStructCompaction->micromapCandidates.push_back(omm);
+                            }
+                        }
+                    }
+
+                    cmd->micromapsToCompact.clear();
+                }
 
 #ifdef NVRHI_WITH_RTXMU
                 if (!cmd->rtxmuBuildIds.empty())
@@ -322,10 +620,14 @@ namespace nvrhi::vulkan
                     cmd->rtxmuCompactionIds.clear();
                 }
 #endif
+
+                // move the list node with the command buffer into the pool
+                std::lock_guard lockGuard(m_Mutex);
+                m_CommandBuffersPool.splice(m_CommandBuffersPool.end(), m_CommandBuffersInFlight, it++);
             }
             else
             {
-                m_CommandBuffersInFlight.push_back(cmd);
+                ++it;
             }
         }
     }
@@ -355,6 +657,13 @@ namespace nvrhi::vulkan
         waitQueue.addWaitSemaphore(semaphore, value);
     }
 
+    void Device::queueWaitForSemaphore(CommandQueue waitQueueID, VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 waitStageMask)
+    {
+        Queue& waitQueue = *m_Queues[uint32_t(waitQueueID)];
+
+        waitQueue.addWaitSemaphore(semaphore, value, vk::PipelineStageFlags2(waitStageMask));
+    }
+
     void Device::queueSignalSemaphore(CommandQueue executionQueueID, VkSemaphore semaphore, uint64_t value)
     {
         Queue& executionQueue = *m_Queues[uint32_t(executionQueueID)];
@@ -367,6 +676,71 @@ namespace nvrhi::vulkan
         queueWaitForSemaphore(waitQueueID, getQueueSemaphore(executionQueueID), instance);
     }
 
+    void Device::queueWaitForCommandList(CommandQueue waitQueueID, CommandQueue executionQueueID, uint64_t instance, VkPipelineStageFlags2 waitStageMask)
+    {
+        queueWaitForSemaphore(waitQueueID, getQueueSemaphore(executionQueueID), instance, waitStageMask);
+    }
+
+    void CommandList::splitCommandBuffer(SyncPoint* signalAfter, SyncPoint* waitAfter, vk::PipelineStageFlags2 waitStages)
+    {
+        assert(m_CurrentCmdBuf);
+
+        endRenderPass();
+        commitBarriers();
+
+        m_CurrentCmdBuf->cmdBuf.end();
+
+        TrackedCommandBuffer::SyncSegment& segment = m_CurrentCmdBuf->syncSegments.emplace_back();
+        segment.cmdBuf = m_CurrentCmdBuf->cmdBuf;
+        segment.signalAfter = signalAfter;
+        segment.waitAfter = waitAfter;
+        segment.waitStages = waitStages;
+
+        if (!m_CurrentCmdBuf->spareSegmentCmdBufs.empty())
+        {
+            m_CurrentCmdBuf->cmdBuf = m_CurrentCmdBuf->spareSegmentCmdBufs.back();
+            m_CurrentCmdBuf->spareSegmentCmdBufs.pop_back();
+        }
+        else
+        {
+            auto allocInfo = vk::CommandBufferAllocateInfo()
+                .setLevel(vk::CommandBufferLevel::ePrimary)
+                .setCommandPool(m_CurrentCmdBuf->cmdPool)
+                .setCommandBufferCount(1);
+
+            const vk::Result res = m_Context.device.allocateCommandBuffers(&allocInfo, &m_CurrentCmdBuf->cmdBuf);
+            ASSERT_VK_OK(res);
+        }
+
+        auto beginInfo = vk::CommandBufferBeginInfo()
+            .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+        (void)m_CurrentCmdBuf->cmdBuf.begin(&beginInfo);
+
+        // nothing is bound in the new command buffer
+        clearState();
+    }
+
+    SyncPointHandle CommandList::signalSyncPoint()
+    {
+        Queue& queue = *m_Device->getQueue(m_CommandListParameters.queueType);
+
+        SyncPoint* syncPoint = new SyncPoint();
+        syncPoint->queue = m_CommandListParameters.queueType;
+        syncPoint->semaphore = queue.trackingSemaphore;
+
+        splitCommandBuffer(syncPoint, nullptr, vk::PipelineStageFlags2());
+
+        return SyncPointHandle::Create(syncPoint);
+    }
+
+    void CommandList::waitSyncPoint(ISyncPoint* _syncPoint, PipelineStages waitStages)
+    {
+        SyncPoint* syncPoint = checked_cast<SyncPoint*>(_syncPoint);
+
+        splitCommandBuffer(nullptr, syncPoint, convertPipelineStages(waitStages, m_CommandListParameters.queueType, m_Context));
+    }
+
     void Device::updateTextureTileMappings(ITexture* texture, const TextureTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
     {
         Queue& queue = *m_Queues[uint32_t(executionQueue)];
@@ -374,6 +748,13 @@ namespace nvrhi::vulkan
         queue.updateTextureTileMappings(texture, tileMappings, numTileMappings);
     }
 
+    void Device::updateBufferTileMappings(IBuffer* buffer, const BufferTilesMapping* tileMappings, uint32_t numTileMappings, CommandQueue executionQueue)
+    {
+        Queue& queue = *m_Queues[uint32_t(executionQueue)];
+
+        queue.updateBufferTileMappings(buffer, tileMappings, numTileMappings);
+    }
+
     uint64_t Device::queueGetCompletedInstance(CommandQueue queue)
     {
         return m_Context.device.getSemaphoreCounterValue(getQueueSemaphore(queue));
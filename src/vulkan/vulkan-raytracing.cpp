@@ -22,6 +22,7 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi::vulkan
@@ -295,7 +296,7 @@ namespace nvrhi::vulkan
 
         m_Context.device.getMicromapBuildSizesEXT(vk::AccelerationStructureBuildTypeKHR::eDevice, &buildInfo, &buildSize);
 
-        OpacityMicromap* om = new OpacityMicromap();
+        OpacityMicromap* om = new OpacityMicromap(m_Context);
         om->desc = desc;
         om->compacted = false;
         
@@ -318,6 +319,41 @@ namespace nvrhi::vulkan
             .setDeviceAddress(getMutableBufferAddress(buffer, 0).deviceAddress);
 
         om->opacityMicromap = m_Context.device.createMicromapEXTUnique(create, m_Context.allocationCallbacks);
+
+        if ((desc.flags & rt::OpacityMicromapBuildFlags::AllowCompaction) != 0)
+        {
+            AccelStructCompaction& compaction = *m_Context.accelStructCompaction;
+
+            {
+                std::lock_guard lockGuard(compaction.mutex);
+
+                if (!compaction.micromapQueryPool)
+                {
+                    // set up the compacted size query pool on first use
+                    auto poolInfo = vk::QueryPoolCreateInfo()
+                        .setQueryType(vk::QueryType::eMicromapCompactedSizeEXT)
+                        .setQueryCount(uint32_t(compaction.micromapQueries.getCapacity()));
+
+                    const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &compaction.micromapQueryPool);
+                    ASSERT_VK_OK(res);
+                    if (res != vk::Result::eSuccess)
+                        compaction.micromapQueryPool = vk::QueryPool();
+                }
+            }
+
+            if (compaction.micromapQueryPool)
+                om->compactedSizeQuery = compaction.micromapQueries.allocate();
+
+            if (om->compactedSizeQuery < 0)
+            {
+                std::stringstream ss;
+                ss << "All " << compaction.micromapQueries.getCapacity() << " compacted size queries are in use, "
+                    "OMM " << utils::DebugNameToString(desc.debugName) << " will not be compacted. "
+                    "Consider increasing DeviceDesc::maxCompactedSizeQueries.";
+                m_Context.warning(ss.str());
+            }
+        }
+
         return rt::OpacityMicromapHandle::Create(om);
     }
 
@@ -403,6 +439,59 @@ namespace nvrhi::vulkan
             }
         }
 
+#ifndef NVRHI_WITH_RTXMU
+        // Virtual BLAS'es live in user-provided heaps and are not moved to compacted storage
+        if (!desc.isTopLevel && !desc.isVirtual && (desc.buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0)
+        {
+            AccelStructCompaction& compaction = *m_Context.accelStructCompaction;
+
+            {
+                std::lock_guard lockGuard(compaction.mutex);
+
+                if (!compaction.queryPool)
+                {
+                    // set up the compacted size query pool on first use
+                    auto poolInfo = vk::QueryPoolCreateInfo()
+                        .setQueryType(vk::QueryType::eAccelerationStructureCompactedSizeKHR)
+                        .setQueryCount(uint32_t(compaction.queries.getCapacity()));
+
+                    const vk::Result res = m_Context.device.createQueryPool(&poolInfo, m_Context.allocationCallbacks, &compaction.queryPool);
+                    ASSERT_VK_OK(res);
+                    if (res != vk::Result::eSuccess)
+                        compaction.queryPool = vk::QueryPool();
+                }
+            }
+
+            if (compaction.queryPool)
+                as->compactedSizeQuery = compaction.queries.allocate();
+
+            if (as->compactedSizeQuery < 0)
+            {
+                std::stringstream ss;
+                ss << "All " << compaction.queries.getCapacity() << " compacted size queries are in use, "
+                    "BLAS " << utils::DebugNameToString(desc.debugName) << " will not be compacted. "
+                    "Consider increasing DeviceDesc::maxCompactedSizeQueries.";
+                m_Context.warning(ss.str());
+            }
+        }
+#endif
+
+        if (desc.isTopLevel && desc.createInstanceBuffer)
+        {
+            BufferDesc instanceBufferDesc;
+            instanceBufferDesc.byteSize = sizeof(rt::InstanceDesc) * std::max<size_t>(desc.topLevelMaxInstances, 1);
+            instanceBufferDesc.structStride = sizeof(rt::InstanceDesc);
+            instanceBufferDesc.canHaveUAVs = true;
+            instanceBufferDesc.isAccelStructBuildInput = true;
+            instanceBufferDesc.initialState = ResourceStates::AccelStructBuildInput;
+            instanceBufferDesc.keepInitialState = true;
+            instanceBufferDesc.debugName = desc.debugName + " instances";
+            as->instanceBuffer = createBuffer(instanceBufferDesc);
+
+            if (desc.trackLiveness)
+                as->instanceBufferBLASes.resize(desc.topLevelMaxInstances);
+        }
+
         // Sanitize the geometry data to avoid dangling pointers, we don't need these buffers in the Desc
         for (auto& geometry : as->desc.bottomLevelGeometries)
         {
@@ -439,6 +528,28 @@ namespace nvrhi::vulkan
         return MemoryRequirements();
     }
 
+    // Places the scratch memory of the builds starting at groupBegin one after another, for as long as the total
+    // size stays within maxGroupSize, and returns the end of the group. The group always contains at least one build.
+    static size_t placeScratchGroup(const std::vector<uint64_t>& scratchSizes, size_t groupBegin, uint64_t maxGroupSize,
+        uint64_t alignment, std::vector<uint64_t>& outScratchOffsets, uint64_t& outGroupSize)
+    {
+        size_t groupEnd = groupBegin;
+        outGroupSize = 0;
+
+        while (groupEnd < scratchSizes.size())
+        {
+            const uint64_t offset = align(outGroupSize, alignment);
+            if (groupEnd > groupBegin && offset + scratchSizes[groupEnd] > maxGroupSize)
+                break;
+
+            outScratchOffsets[groupEnd] = offset;
+            outGroupSize = offset + scratchSizes[groupEnd];
+            ++groupEnd;
+        }
+
+        return groupEnd;
+    }
+
     static vk::ClusterAccelerationStructureTypeNV convertClusterAccelerationStructureType(rt::cluster::OperationMoveType type)
     {
         switch (type)
@@ -607,260 +718,619 @@ namespace nvrhi::vulkan
 
     void CommandList::buildOpacityMicromap(rt::IOpacityMicromap* pOpacityMicromap, const rt::OpacityMicromapDesc& desc)
     {
-        OpacityMicromap* omm = checked_cast<OpacityMicromap*>(pOpacityMicromap);
-
-        if (m_EnableAutomaticBarriers)
-        {
-            requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
-            requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
+        const rt::OpacityMicromapBuildDesc build = rt::OpacityMicromapBuildDesc()
+            .setOpacityMicromap(pOpacityMicromap)
+            .setDesc(&desc);
 
-            requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
-            m_BindingStatesDirty = true;
-        }
+        buildOpacityMicromaps(&build, 1);
+    }
 
-        if (desc.trackLiveness)
-        {
-            m_CurrentCmdBuf->referencedResources.push_back(desc.inputBuffer);
-            m_CurrentCmdBuf->referencedResources.push_back(desc.perOmmDescs);
-            m_CurrentCmdBuf->referencedResources.push_back(omm->dataBuffer);
-        }
+    void CommandList::buildOpacityMicromaps(const rt::OpacityMicromapBuildDesc* builds, size_t numBuilds)
+    {
+        std::vector<vk::MicromapBuildInfoEXT> buildInfos(numBuilds);
+
+        // Place the scratch memory of all builds into one allocation, so that they can run concurrently
+        const uint64_t scratchAlignment = std::max(uint64_t(m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment), uint64_t(1));
+        std::vector<uint64_t> scratchOffsets(numBuilds);
+        uint64_t totalScratchSize = 0;
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+            const rt::OpacityMicromapDesc& desc = builds[buildIndex].desc ? *builds[buildIndex].desc : omm->desc;
+
+            vk::MicromapBuildInfoEXT& buildInfo = buildInfos[buildIndex];
+            buildInfo = vk::MicromapBuildInfoEXT()
+                .setType(vk::MicromapTypeEXT::eOpacityMicromap)
+                .setFlags(GetAsVkBuildMicromapFlagBitsEXT(desc.flags))
+                .setMode(vk::BuildMicromapModeEXT::eBuild)
+                .setDstMicromap(omm->opacityMicromap.get())
+                .setPUsageCounts(GetAsVkOpacityMicromapUsageCounts(desc.counts.data()))
+                .setUsageCountsCount((uint32_t)desc.counts.size())
+                .setData(getBufferAddress(desc.inputBuffer, desc.inputBufferOffset))
+                .setTriangleArray(getBufferAddress(desc.perOmmDescs, desc.perOmmDescsOffset))
+                .setTriangleArrayStride((VkDeviceSize)sizeof(vk::MicromapTriangleEXT))
+                ;
+
+            vk::MicromapBuildSizesInfoEXT buildSize;
+            m_Context.device.getMicromapBuildSizesEXT(vk::AccelerationStructureBuildTypeKHR::eDevice, &buildInfo, &buildSize);
+
+            if (buildSize.micromapSize > omm->dataBuffer->getDesc().byteSize)
+            {
+                std::stringstream ss;
+                ss << "OMM " << utils::DebugNameToString(omm->desc.debugName) << " build requires at least "
+                    << buildSize.micromapSize << " bytes in the data buffer, while the allocated buffer is only "
+                    << omm->dataBuffer->getDesc().byteSize << " bytes";
 
-        commitBarriers();
+                m_Context.error(ss.str());
+                return;
+            }
 
-        auto buildInfo = vk::MicromapBuildInfoEXT()
-            .setType(vk::MicromapTypeEXT::eOpacityMicromap)
-            .setFlags(GetAsVkBuildMicromapFlagBitsEXT(desc.flags))
-            .setMode(vk::BuildMicromapModeEXT::eBuild)
-            .setDstMicromap(omm->opacityMicromap.get())
-            .setPUsageCounts(GetAsVkOpacityMicromapUsageCounts(desc.counts.data()))
-            .setUsageCountsCount((uint32_t)desc.counts.size())
-            .setData(getBufferAddress(desc.inputBuffer, desc.inputBufferOffset))
-            .setTriangleArray(getBufferAddress(desc.perOmmDescs, desc.perOmmDescsOffset))
-            .setTriangleArrayStride((VkDeviceSize)sizeof(vk::MicromapTriangleEXT))
-            ;
+            scratchOffsets[buildIndex] = align(totalScratchSize, scratchAlignment);
+            totalScratchSize = scratchOffsets[buildIndex] + buildSize.buildScratchSize;
+        }
 
-        vk::MicromapBuildSizesInfoEXT buildSize;
-        m_Context.device.getMicromapBuildSizesEXT(vk::AccelerationStructureBuildTypeKHR::eDevice, &buildInfo, &buildSize);
+        Buffer* scratchBuffer = nullptr;
+        uint64_t scratchOffset = 0;
 
-        if (buildSize.buildScratchSize != 0)
+        if (totalScratchSize != 0)
         {
-            Buffer* scratchBuffer = nullptr;
-            uint64_t scratchOffset = 0;
             uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-            bool allocated = m_ScratchManager->suballocateBuffer(buildSize.buildScratchSize, &scratchBuffer, &scratchOffset, nullptr,
+            bool allocated = m_ScratchManager->suballocateBuffer(totalScratchSize, &scratchBuffer, &scratchOffset, nullptr,
                 currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
 
             if (!allocated)
             {
                 std::stringstream ss;
-                ss << "Couldn't suballocate a scratch buffer for OMM " << utils::DebugNameToString(omm->desc.debugName) << " build. "
-                    "The build requires " << buildSize.buildScratchSize << " bytes of scratch space.";
+                if (numBuilds == 1)
+                    ss << "Couldn't suballocate a scratch buffer for OMM " << utils::DebugNameToString(builds[0].opacityMicromap->getDesc().debugName) << " build. ";
+                else
+                    ss << "Couldn't suballocate a scratch buffer for " << numBuilds << " OMM builds. ";
+                ss << "The build requires " << totalScratchSize << " bytes of scratch space.";
 
                 m_Context.error(ss.str());
                 return;
             }
+        }
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+            const rt::OpacityMicromapDesc& desc = builds[buildIndex].desc ? *builds[buildIndex].desc : omm->desc;
+
+            if (m_EnableAutomaticBarriers)
+            {
+                requireBufferState(desc.inputBuffer, ResourceStates::OpacityMicromapBuildInput);
+                requireBufferState(desc.perOmmDescs, ResourceStates::OpacityMicromapBuildInput);
+
+                requireBufferState(omm->dataBuffer, nvrhi::ResourceStates::OpacityMicromapWrite);
+                m_BindingStatesDirty = true;
+            }
+
+            if (desc.trackLiveness)
+            {
+                m_CurrentCmdBuf->referencedResources.push_back(desc.inputBuffer);
+                m_CurrentCmdBuf->referencedResources.push_back(desc.perOmmDescs);
+                m_CurrentCmdBuf->referencedResources.push_back(omm->dataBuffer);
+            }
+
+            if (scratchBuffer)
+                buildInfos[buildIndex].setScratchData(getMutableBufferAddress(scratchBuffer, scratchOffset + scratchOffsets[buildIndex]));
+        }
+
+        commitBarriers();
 
-            buildInfo.setScratchData(getMutableBufferAddress(scratchBuffer, scratchOffset));
+        // The OMMs that can be compacted get their compacted sizes queried after the builds
+        const vk::QueryPool compactedSizeQueryPool = m_Context.accelStructCompaction->micromapQueryPool;
+        std::vector<OpacityMicromap*> compactedSizeWrites;
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+        {
+            OpacityMicromap* omm = checked_cast<OpacityMicromap*>(builds[buildIndex].opacityMicromap);
+
+            if (omm->compactedSizeQuery >= 0 && (buildInfos[buildIndex].flags & vk::BuildMicromapFlagBitsEXT::eAllowCompaction))
+            {
+                m_CurrentCmdBuf->cmdBuf.resetQueryPool(compactedSizeQueryPool, uint32_t(omm->compactedSizeQuery), 1);
+                compactedSizeWrites.push_back(omm);
+            }
         }
 
-        m_CurrentCmdBuf->cmdBuf.buildMicromapsEXT(1, &buildInfo);
+        m_CurrentCmdBuf->cmdBuf.buildMicromapsEXT(uint32_t(buildInfos.size()), buildInfos.data());
+
+        if (!compactedSizeWrites.empty())
+        {
+            // The properties can only be queried once the builds have finished
+            auto barrier = vk::MemoryBarrier2()
+                .setSrcStageMask(vk::PipelineStageFlagBits2::eMicromapBuildEXT)
+                .setSrcAccessMask(vk::AccessFlagBits2::eMicromapWriteEXT)
+                .setDstStageMask(vk::PipelineStageFlagBits2::eMicromapBuildEXT)
+                .setDstAccessMask(vk::AccessFlagBits2::eMicromapReadEXT);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(vk::DependencyInfo().setMemoryBarriers(barrier));
+
+            for (OpacityMicromap* omm : compactedSizeWrites)
+            {
+                m_CurrentCmdBuf->cmdBuf.writeMicromapsPropertiesEXT({ omm->opacityMicromap.get() },
+                    vk::QueryType::eMicromapCompactedSizeEXT, compactedSizeQueryPool, uint32_t(omm->compactedSizeQuery));
+
+                m_CurrentCmdBuf->micromapsToCompact.push_back(omm);
+            }
+        }
     }
 
-    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* _as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    void CommandList::compactOpacityMicromaps()
     {
-        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+        AccelStructCompaction& compaction = *m_Context.accelStructCompaction;
 
-        const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
-        if (performUpdate)
+        // Hold the lock while the candidates are processed, the OpacityMicromap destructor removes them from the list
+        std::lock_guard lockGuard(compaction.mutex);
+
+        if (compaction.micromapCandidates.empty())
+            return;
+
+        for (OpacityMicromap* omm : compaction.micromapCandidates)
         {
-            assert(as->allowUpdate);
+            // The querying command buffer has been retired, so the result is available without waiting
+            uint64_t compactedSize = 0;
+            const vk::Result res = m_Context.device.getQueryPoolResults(compaction.micromapQueryPool,
+                uint32_t(omm->compactedSizeQuery), 1, sizeof(compactedSize), &compactedSize, sizeof(compactedSize),
+                vk::QueryResultFlagBits::e64);
+
+            omm->compactionPending = false;
+
+            if (res != vk::Result::eSuccess || compactedSize == 0 || compactedSize >= omm->dataBuffer->getDesc().byteSize)
+                continue;
+
+            BufferDesc bufferDesc = omm->dataBuffer->getDesc();
+            bufferDesc.byteSize = compactedSize;
+            BufferHandle compactedBuffer = m_Device->createBuffer(bufferDesc);
+            if (!compactedBuffer)
+                continue;
+
+            Buffer* buffer = checked_cast<Buffer*>(compactedBuffer.Get());
+
+            auto createInfo = vk::MicromapCreateInfoEXT()
+                .setType(vk::MicromapTypeEXT::eOpacityMicromap)
+                .setBuffer(buffer->buffer)
+                .setSize(compactedSize)
+                .setDeviceAddress(getMutableBufferAddress(buffer, 0).deviceAddress);
+
+            vk::UniqueMicromapEXT compactedMicromap = m_Context.device.createMicromapEXTUnique(createInfo, m_Context.allocationCallbacks);
+
+            m_CurrentCmdBuf->cmdBuf.copyMicromapEXT(vk::CopyMicromapInfoEXT()
+                .setSrc(omm->opacityMicromap.get())
+                .setDst(compactedMicromap.get())
+                .setMode(vk::CopyMicromapModeEXT::eCompact));
+
+            // Keep the original storage alive until the copy has finished
+            OpacityMicromap* original = new OpacityMicromap(m_Context);
+            original->opacityMicromap = std::move(omm->opacityMicromap);
+            original->dataBuffer = omm->dataBuffer;
+            m_CurrentCmdBuf->referencedResources.push_back(rt::OpacityMicromapHandle::Create(original));
+
+            omm->opacityMicromap = std::move(compactedMicromap);
+            omm->dataBuffer = compactedBuffer;
+            omm->compacted = true;
+
+            compaction.micromapQueries.release(omm->compactedSizeQuery);
+            omm->compactedSizeQuery = -1;
+
+            if (omm->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.push_back(omm);
         }
 
-        std::vector<vk::AccelerationStructureGeometryKHR> geometries;
-        std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
-        std::vector<vk::AccelerationStructureGeometryLinearSweptSpheresDataNV> lss;
-        std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
-        std::vector<uint32_t> maxPrimitiveCounts;
-        geometries.resize(numGeometries);
-        omms.resize(numGeometries);
-        lss.resize(numGeometries);
-        maxPrimitiveCounts.resize(numGeometries);
-        buildRanges.resize(numGeometries);
+        compaction.micromapCandidates.clear();
+
+        // Make the compacted OMMs visible to the BLAS builds that follow
+        auto barrier = vk::MemoryBarrier2()
+            .setSrcStageMask(vk::PipelineStageFlagBits2::eMicromapBuildEXT)
+            .setSrcAccessMask(vk::AccessFlagBits2::eMicromapWriteEXT)
+            .setDstStageMask(vk::PipelineStageFlagBits2::eMicromapBuildEXT | vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR)
+            .setDstAccessMask(vk::AccessFlagBits2::eMicromapReadEXT);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(vk::DependencyInfo().setMemoryBarriers(barrier));
+    }
+
+    void CommandList::buildBottomLevelAccelStruct(rt::IAccelStruct* as, const rt::GeometryDesc* pGeometries, size_t numGeometries, rt::AccelStructBuildFlags buildFlags)
+    {
+        const rt::BlasBuildDesc build = rt::BlasBuildDesc()
+            .setAccelStruct(as)
+            .setGeometries(pGeometries, numGeometries)
+            .setBuildFlags(buildFlags);
+
+        buildBottomLevelAccelStructs(&build, 1);
+    }
+
+    void CommandList::buildBottomLevelAccelStructs(const rt::BlasBuildDesc* builds, size_t numBuilds)
+    {
+        // Sized up front, the build infos point into these arrays
+        struct BuildData
+        {
+            std::vector<vk::AccelerationStructureGeometryKHR> geometries;
+            std::vector<vk::AccelerationStructureTrianglesOpacityMicromapEXT> omms;
+            std::vector<vk::AccelerationStructureGeometryLinearSweptSpheresDataNV> lss;
+            std::vector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges;
+            std::vector<uint32_t> maxPrimitiveCounts;
+        };
+
+        std::vector<BuildData> buildData(numBuilds);
+        std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos(numBuilds);
 
         uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-        for (size_t i = 0; i < numGeometries; i++)
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            convertBottomLevelGeometry(pGeometries[i], geometries[i], omms[i], lss[i], maxPrimitiveCounts[i], &buildRanges[i],
-                m_Context, m_UploadManager.get(), currentVersion);
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+            const rt::GeometryDesc* pGeometries = build.geometries;
+            const size_t numGeometries = build.numGeometries;
+            const rt::AccelStructBuildFlags buildFlags = build.buildFlags;
+
+            const bool performUpdate = (buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+            if (performUpdate)
+            {
+                assert(as->allowUpdate);
+            }
 
-            const rt::GeometryDesc& src = pGeometries[i];
+            BuildData& data = buildData[buildIndex];
+            data.geometries.resize(numGeometries);
+            data.omms.resize(numGeometries);
+            data.lss.resize(numGeometries);
+            data.maxPrimitiveCounts.resize(numGeometries);
+            data.buildRanges.resize(numGeometries);
 
-            switch (src.geometryType)
+            for (size_t i = 0; i < numGeometries; i++)
             {
-            case rt::GeometryType::Triangles: {
-                const rt::GeometryTriangles& srct = src.geometryData.triangles;
-                if (m_EnableAutomaticBarriers)
+                convertBottomLevelGeometry(pGeometries[i], data.geometries[i], data.omms[i], data.lss[i], data.maxPrimitiveCounts[i], &data.buildRanges[i],
+                    m_Context, m_UploadManager.get(), currentVersion);
+
+                const rt::GeometryDesc& src = pGeometries[i];
+
+                switch (src.geometryType)
                 {
-                    if (srct.indexBuffer)
-                        requireBufferState(srct.indexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
-                    if (srct.vertexBuffer)
-                        requireBufferState(srct.vertexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
-                    if (OpacityMicromap* om = checked_cast<OpacityMicromap*>(srct.opacityMicromap))
-                        requireBufferState(om->dataBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                case rt::GeometryType::Triangles: {
+                    const rt::GeometryTriangles& srct = src.geometryData.triangles;
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        if (srct.indexBuffer)
+                            requireBufferState(srct.indexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                        if (srct.vertexBuffer)
+                            requireBufferState(srct.vertexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                        if (OpacityMicromap* om = checked_cast<OpacityMicromap*>(srct.opacityMicromap))
+                            requireBufferState(om->dataBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                    }
+                    break;
                 }
-                break;
-            }
-            case rt::GeometryType::AABBs: {
-                const rt::GeometryAABBs& srca = src.geometryData.aabbs;
-                if (m_EnableAutomaticBarriers)
-                {
-                    if (srca.buffer)
-                        requireBufferState(srca.buffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                case rt::GeometryType::AABBs: {
+                    const rt::GeometryAABBs& srca = src.geometryData.aabbs;
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        if (srca.buffer)
+                            requireBufferState(srca.buffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                    }
+                    break;
+                }
+                case rt::GeometryType::Spheres:
+                    utils::NotImplemented();
+                    break;
+                case rt::GeometryType::Lss: {
+                    const rt::GeometryLss& srcLss = src.geometryData.lss;
+                    if (m_EnableAutomaticBarriers)
+                    {
+                        if (srcLss.indexBuffer)
+                            requireBufferState(srcLss.indexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                        if (srcLss.vertexBuffer)
+                            requireBufferState(srcLss.vertexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
+                    }
+                    break;
                 }
-                break;
-            }
-            case rt::GeometryType::Spheres:
-                utils::NotImplemented();
-                break;
-            case rt::GeometryType::Lss: {
-                const rt::GeometryLss& srcLss = src.geometryData.lss;
-                if (m_EnableAutomaticBarriers)
-                {
-                    if (srcLss.indexBuffer)
-                        requireBufferState(srcLss.indexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
-                    if (srcLss.vertexBuffer)
-                        requireBufferState(srcLss.vertexBuffer, nvrhi::ResourceStates::AccelStructBuildInput);
                 }
-                break;
-            }
             }
-        }
 
-        m_BindingStatesDirty = true;
+            vk::AccelerationStructureBuildGeometryInfoKHR& buildInfo = buildInfos[buildIndex];
+            buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR()
+                .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+                .setMode(performUpdate ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild)
+                .setGeometries(data.geometries)
+                .setFlags(convertAccelStructBuildFlags(buildFlags))
+                .setDstAccelerationStructure(as->accelStruct);
 
-        auto buildInfo = vk::AccelerationStructureBuildGeometryInfoKHR()
-            .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
-            .setMode(performUpdate ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild)
-            .setGeometries(geometries)
-            .setFlags(convertAccelStructBuildFlags(buildFlags))
-            .setDstAccelerationStructure(as->accelStruct);
+            if (as->allowUpdate)
+                buildInfo.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
 
-        if (as->allowUpdate)
-            buildInfo.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+            if (performUpdate)
+                buildInfo.setSrcAccelerationStructure(as->accelStruct);
+        }
+
+        m_BindingStatesDirty = true;
 
-        if (performUpdate)
-            buildInfo.setSrcAccelerationStructure(as->accelStruct);
-        
 #ifdef NVRHI_WITH_RTXMU
         commitBarriers();
 
-        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
-        std::array<const uint32_t*, 1> maxPrimArrays = { maxPrimitiveCounts.data() };
-
-        if(as->rtxmuId == ~0ull)
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            std::vector<uint64_t> accelStructsToBuild;
-            m_Context.rtxMemUtil->PopulateBuildCommandList(m_CurrentCmdBuf->cmdBuf,
-                                                           buildInfos.data(),
-                                                           buildRangeArrays.data(),
-                                                           maxPrimArrays.data(),
-                                                           (uint32_t)buildInfos.size(),
-                                                           accelStructsToBuild);
+            AccelStruct* as = checked_cast<AccelStruct*>(builds[buildIndex].accelStruct);
 
+            std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> rtxmuBuildInfos = { buildInfos[buildIndex] };
+            std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildData[buildIndex].buildRanges.data() };
+            std::array<const uint32_t*, 1> maxPrimArrays = { buildData[buildIndex].maxPrimitiveCounts.data() };
 
-            as->rtxmuId = accelStructsToBuild[0];
-            
-            as->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(as->rtxmuId);
-            as->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(as->rtxmuId);
-            as->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(as->rtxmuId);
+            if(as->rtxmuId == ~0ull)
+            {
+                std::vector<uint64_t> accelStructsToBuild;
+                m_Context.rtxMemUtil->PopulateBuildCommandList(m_CurrentCmdBuf->cmdBuf,
+                                                               rtxmuBuildInfos.data(),
+                                                               buildRangeArrays.data(),
+                                                               maxPrimArrays.data(),
+                                                               (uint32_t)rtxmuBuildInfos.size(),
+                                                               accelStructsToBuild);
+
+
+                as->rtxmuId = accelStructsToBuild[0];
+                
+                as->rtxmuBuffer = m_Context.rtxMemUtil->GetBuffer(as->rtxmuId);
+                as->accelStruct = m_Context.rtxMemUtil->GetAccelerationStruct(as->rtxmuId);
+                as->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(as->rtxmuId);
+
+                m_CurrentCmdBuf->rtxmuBuildIds.push_back(as->rtxmuId);
+            }
+            else
+            {
+                std::vector<uint64_t> buildsToUpdate(1, as->rtxmuId);
+
+                m_Context.rtxMemUtil->PopulateUpdateCommandList(m_CurrentCmdBuf->cmdBuf,
+                                                                rtxmuBuildInfos.data(),
+                                                                buildRangeArrays.data(),
+                                                                maxPrimArrays.data(),
+                                                                (uint32_t)rtxmuBuildInfos.size(),
+                                                                buildsToUpdate);
+            }
+        }
+#else
 
-            m_CurrentCmdBuf->rtxmuBuildIds.push_back(as->rtxmuId);
+        if (m_EnableAutomaticBarriers)
+        {
+            for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+                requireBufferState(checked_cast<AccelStruct*>(builds[buildIndex].accelStruct)->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
         }
-        else
+        commitBarriers();
+
+        // The BLAS'es that can be compacted get their compacted sizes queried after the builds
+        const vk::QueryPool compactedSizeQueryPool = m_Context.accelStructCompaction->queryPool;
+        std::vector<AccelStruct*> compactedSizeWrites;
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            std::vector<uint64_t> buildsToUpdate(1, as->rtxmuId);
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
 
-            m_Context.rtxMemUtil->PopulateUpdateCommandList(m_CurrentCmdBuf->cmdBuf,
-                                                            buildInfos.data(),
-                                                            buildRangeArrays.data(),
-                                                            maxPrimArrays.data(),
-                                                            (uint32_t)buildInfos.size(),
-                                                            buildsToUpdate);
+            if (as->compactedSizeQuery >= 0 && (build.buildFlags & rt::AccelStructBuildFlags::AllowCompaction) != 0
+                && (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) == 0)
+            {
+                m_CurrentCmdBuf->cmdBuf.resetQueryPool(compactedSizeQueryPool, uint32_t(as->compactedSizeQuery), 1);
+                compactedSizeWrites.push_back(as);
+            }
         }
-#else
 
-        if (m_EnableAutomaticBarriers)
+        // The scratch memory of each group of builds is placed into one allocation, so that the builds can run concurrently
+        const uint64_t scratchAlignment = std::max(uint64_t(m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment), uint64_t(1));
+        std::vector<uint64_t> scratchSizes(numBuilds);
+        std::vector<uint64_t> scratchOffsets(numBuilds);
+
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            requireBufferState(as->dataBuffer, nvrhi::ResourceStates::AccelStructWrite);
+            const rt::BlasBuildDesc& build = builds[buildIndex];
+            AccelStruct* as = checked_cast<AccelStruct*>(build.accelStruct);
+            const bool performUpdate = (build.buildFlags & rt::AccelStructBuildFlags::PerformUpdate) != 0;
+
+            auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
+                vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfos[buildIndex], buildData[buildIndex].maxPrimitiveCounts);
+
+            if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
+            {
+                std::stringstream ss;
+                ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
+                    << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
+                    << as->dataBuffer->getDesc().byteSize << " bytes";
+
+                m_Context.error(ss.str());
+                return;
+            }
+
+            scratchSizes[buildIndex] = performUpdate
+                ? buildSizes.updateScratchSize
+                : buildSizes.buildScratchSize;
         }
-        commitBarriers();
 
-        auto buildSizes = m_Context.device.getAccelerationStructureBuildSizesKHR(
-            vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, maxPrimitiveCounts);
+        std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> buildRangeArrays(numBuilds);
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
+            buildRangeArrays[buildIndex] = buildData[buildIndex].buildRanges.data();
 
-        if (buildSizes.accelerationStructureSize > as->dataBuffer->getDesc().byteSize)
+        // Split the builds into groups whose scratch memory fits into the scratch memory limit. The builds within a group
+        // use disjoint scratch and data memory, so they are issued with one command. Different groups may reuse
+        // the same scratch memory, so they are separated by barriers.
+        const uint64_t scratchLimit = m_CommandListParameters.scratchMaxMemory > 0 ? uint64_t(m_CommandListParameters.scratchMaxMemory) : UINT64_MAX;
+        uint64_t groupScratchLimit = scratchLimit;
+        size_t groupBegin = 0;
+        bool issuedBuilds = false;
+
+        while (groupBegin < numBuilds)
         {
-            std::stringstream ss;
-            ss << "BLAS " << utils::DebugNameToString(as->desc.debugName) << " build requires at least "
-                << buildSizes.accelerationStructureSize << " bytes in the data buffer, while the allocated buffer is only "
-                << as->dataBuffer->getDesc().byteSize << " bytes";
+            uint64_t groupScratchSize = 0;
+            const size_t groupEnd = placeScratchGroup(scratchSizes, groupBegin, groupScratchLimit, scratchAlignment, scratchOffsets, groupScratchSize);
 
-            m_Context.error(ss.str());
-            return;
+            Buffer* scratchBuffer = nullptr;
+            uint64_t scratchOffset = 0;
+
+            if (!m_ScratchManager->suballocateBuffer(groupScratchSize, &scratchBuffer, &scratchOffset, nullptr,
+                currentVersion, scratchAlignment))
+            {
+                if (groupEnd - groupBegin > 1)
+                {
+                    // The scratch memory may be available in smaller chunks only, try again with fewer builds
+                    groupScratchLimit = groupScratchSize / 2;
+                    continue;
+                }
+
+                AccelStruct* as = checked_cast<AccelStruct*>(builds[groupBegin].accelStruct);
+
+                std::stringstream ss;
+                ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
+                    << "The build requires " << groupScratchSize << " bytes of scratch space.";
+                m_Context.error(ss.str());
+
+                // Skip this build, the size query it would write must not be used for compaction
+                auto it = std::find(compactedSizeWrites.begin(), compactedSizeWrites.end(), as);
+                if (it != compactedSizeWrites.end())
+                    compactedSizeWrites.erase(it);
+
+                groupBegin = groupEnd;
+                groupScratchLimit = scratchLimit;
+                continue;
+            }
+
+            assert(scratchBuffer->deviceAddress);
+
+            if (issuedBuilds)
+            {
+                auto barrier = vk::MemoryBarrier()
+                    .setSrcAccessMask(vk::AccessFlagBits::eAccelerationStructureWriteKHR)
+                    .setDstAccessMask(vk::AccessFlagBits::eAccelerationStructureReadKHR | vk::AccessFlagBits::eAccelerationStructureWriteKHR);
+
+                m_CurrentCmdBuf->cmdBuf.pipelineBarrier(
+                    vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+                    vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+                    vk::DependencyFlags(), { barrier }, {}, {});
+            }
+
+            for (size_t buildIndex = groupBegin; buildIndex < groupEnd; buildIndex++)
+                buildInfos[buildIndex].setScratchData(scratchBuffer->deviceAddress + scratchOffset + scratchOffsets[buildIndex]);
+
+            m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(uint32_t(groupEnd - groupBegin),
+                buildInfos.data() + groupBegin, buildRangeArrays.data() + groupBegin);
+
+            issuedBuilds = true;
+            groupBegin = groupEnd;
+            groupScratchLimit = scratchLimit;
         }
 
-        size_t scratchSize = performUpdate
-            ? buildSizes.updateScratchSize
-            : buildSizes.buildScratchSize;
+        if (!compactedSizeWrites.empty())
+        {
+            // The properties can only be queried once the builds have finished
+            auto barrier = vk::MemoryBarrier()
+                .setSrcAccessMask(vk::AccessFlagBits::eAccelerationStructureWriteKHR)
+                .setDstAccessMask(vk::AccessFlagBits::eAccelerationStructureReadKHR);
 
-        Buffer* scratchBuffer = nullptr;
-        uint64_t scratchOffset = 0;
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier(
+                vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+                vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+                vk::DependencyFlags(), { barrier }, {}, {});
 
-        bool allocated = m_ScratchManager->suballocateBuffer(scratchSize, &scratchBuffer, &scratchOffset, nullptr,
-            currentVersion, m_Context.accelStructProperties.minAccelerationStructureScratchOffsetAlignment);
+            for (AccelStruct* as : compactedSizeWrites)
+            {
+                m_CurrentCmdBuf->cmdBuf.writeAccelerationStructuresPropertiesKHR({ as->accelStruct },
+                    vk::QueryType::eAccelerationStructureCompactedSizeKHR, compactedSizeQueryPool, uint32_t(as->compactedSizeQuery));
 
-        if (!allocated)
+                m_CurrentCmdBuf->accelStructsToCompact.push_back(as);
+            }
+        }
+#endif
+        for (size_t buildIndex = 0; buildIndex < numBuilds; buildIndex++)
         {
-            std::stringstream ss;
-            ss << "Couldn't suballocate a scratch buffer for BLAS " << utils::DebugNameToString(as->desc.debugName) << " build. "
-                "The build requires " << scratchSize << " bytes of scratch space.";
+            AccelStruct* as = checked_cast<AccelStruct*>(builds[buildIndex].accelStruct);
+            if (as->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.push_back(as);
+        }
+    }
 
-            m_Context.error(ss.str());
-            return;
+    void CommandList::compactBottomLevelAccelStructs()
+    {
+#ifdef NVRHI_WITH_RTXMU
+
+        if (!m_Context.rtxMuResources->asBuildsCompleted.empty())
+        {
+            std::lock_guard lockGuard(m_Context.rtxMuResources->asListMutex);
+
+            if (!m_Context.rtxMuResources->asBuildsCompleted.empty())
+            {
+                m_Context.rtxMemUtil->PopulateCompactionCommandList(m_CurrentCmdBuf->cmdBuf, m_Context.rtxMuResources->asBuildsCompleted);
+
+                m_CurrentCmdBuf->rtxmuCompactionIds.insert(m_CurrentCmdBuf->rtxmuCompactionIds.end(), m_Context.rtxMuResources->asBuildsCompleted.begin(), m_Context.rtxMuResources->asBuildsCompleted.end());
+
+                m_Context.rtxMuResources->asBuildsCompleted.clear();
+            }
         }
-        
-        assert(scratchBuffer->deviceAddress);
-        buildInfo.setScratchData(scratchBuffer->deviceAddress + scratchOffset);
+#else
+        AccelStructCompaction& compaction = *m_Context.accelStructCompaction;
 
-        std::array<vk::AccelerationStructureBuildGeometryInfoKHR, 1> buildInfos = { buildInfo };
-        std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
+        // Hold the lock while the candidates are processed, the AccelStruct destructor removes them from the list
+        std::lock_guard lockGuard(compaction.mutex);
+
+        if (compaction.candidates.empty())
+            return;
+
+        for (AccelStruct* as : compaction.candidates)
+        {
+            // The querying command buffer has been retired, so the result is available without waiting
+            uint64_t compactedSize = 0;
+            const vk::Result res = m_Context.device.getQueryPoolResults(compaction.queryPool,
+                uint32_t(as->compactedSizeQuery), 1, sizeof(compactedSize), &compactedSize, sizeof(compactedSize),
+                vk::QueryResultFlagBits::e64);
+
+            as->compactionPending = false;
+
+            // The query slot is kept when the BLAS is not compacted, so that a later build can make it a candidate again
+            if (res != vk::Result::eSuccess || compactedSize == 0 || compactedSize >= as->dataBuffer->getDesc().byteSize)
+                continue;
+
+            BufferDesc bufferDesc = as->dataBuffer->getDesc();
+            bufferDesc.byteSize = compactedSize;
+            BufferHandle compactedBuffer = m_Device->createBuffer(bufferDesc);
+            if (!compactedBuffer)
+                continue;
+
+            auto createInfo = vk::AccelerationStructureCreateInfoKHR()
+                .setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+                .setBuffer(checked_cast<Buffer*>(compactedBuffer.Get())->buffer)
+                .setSize(compactedSize);
 
-        m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
-#endif
-        if (as->desc.trackLiveness)
-            m_CurrentCmdBuf->referencedResources.push_back(as);
-    }
+            vk::AccelerationStructureKHR compactedAccelStruct = m_Context.device.createAccelerationStructureKHR(createInfo, m_Context.allocationCallbacks);
 
-    void CommandList::compactBottomLevelAccelStructs()
-    {
-#ifdef NVRHI_WITH_RTXMU
+            m_CurrentCmdBuf->cmdBuf.copyAccelerationStructureKHR(vk::CopyAccelerationStructureInfoKHR()
+                .setSrc(as->accelStruct)
+                .setDst(compactedAccelStruct)
+                .setMode(vk::CopyAccelerationStructureModeKHR::eCompact));
 
-        if (!m_Context.rtxMuResources->asBuildsCompleted.empty())
-        {
-            std::lock_guard lockGuard(m_Context.rtxMuResources->asListMutex);
+            // Keep the original storage alive until the copy has finished
+            AccelStruct* original = new AccelStruct(m_Context);
+            original->accelStruct = as->accelStruct;
+            original->dataBuffer = as->dataBuffer;
+            m_CurrentCmdBuf->referencedResources.push_back(rt::AccelStructHandle::Create(original));
 
-            if (!m_Context.rtxMuResources->asBuildsCompleted.empty())
-            {
-                m_Context.rtxMemUtil->PopulateCompactionCommandList(m_CurrentCmdBuf->cmdBuf, m_Context.rtxMuResources->asBuildsCompleted);
+            as->accelStruct = compactedAccelStruct;
+            as->dataBuffer = compactedBuffer;
+            as->accelStructDeviceAddress = m_Context.device.getAccelerationStructureAddressKHR(
+                vk::AccelerationStructureDeviceAddressInfoKHR().setAccelerationStructure(compactedAccelStruct));
+            as->compacted = true;
 
-                m_CurrentCmdBuf->rtxmuCompactionIds.insert(m_CurrentCmdBuf->rtxmuCompactionIds.end(), m_Context.rtxMuResources->asBuildsCompleted.begin(), m_Context.rtxMuResources->asBuildsCompleted.end());
+            compaction.queries.release(as->compactedSizeQuery);
+            as->compactedSizeQuery = -1;
 
-                m_Context.rtxMuResources->asBuildsCompleted.clear();
-            }
+            if (as->desc.trackLiveness)
+                m_CurrentCmdBuf->referencedResources.push_back(as);
         }
+
+        compaction.candidates.clear();
+
+        // Make the compacted BLAS'es visible to the TLAS builds that follow
+        auto barrier = vk::MemoryBarrier()
+            .setSrcAccessMask(vk::AccessFlagBits::eAccelerationStructureWriteKHR)
+            .setDstAccessMask(vk::AccessFlagBits::eAccelerationStructureReadKHR);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(
+            vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+            vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR | vk::PipelineStageFlagBits::eRayTracingShaderKHR
+                | vk::PipelineStageFlagBits::eComputeShader,
+            vk::DependencyFlags(), { barrier }, {}, {});
 #endif
     }
 
@@ -873,7 +1343,7 @@ namespace nvrhi::vulkan
         if (performUpdate)
         {
             assert(as->allowUpdate);
-            assert(as->instances.size() == numInstances);
+            assert(as->builtInstances == numInstances);
         }
 
         auto geometry = vk::AccelerationStructureGeometryKHR()
@@ -942,6 +1412,8 @@ namespace nvrhi::vulkan
         std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> buildRangeArrays = { buildRanges.data() };
 
         m_CurrentCmdBuf->cmdBuf.buildAccelerationStructuresKHR(buildInfos, buildRangeArrays);
+
+        as->builtInstances = numInstances;
     }
 
     void CommandList::buildTopLevelAccelStruct(rt::IAccelStruct* _as, const rt::InstanceDesc* pInstances, size_t numInstances, rt::AccelStructBuildFlags buildFlags)
@@ -1038,6 +1510,61 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(as);
     }
 
+    void CommandList::updateTopLevelAccelStructInstances(rt::IAccelStruct* _as, size_t firstInstance, const rt::InstanceDesc* pInstances, size_t numInstances)
+    {
+        AccelStruct* as = checked_cast<AccelStruct*>(_as);
+
+        if (!as->instanceBuffer || numInstances == 0)
+            return;
+
+        std::vector<vk::AccelerationStructureInstanceKHR> instances(numInstances);
+
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            const rt::InstanceDesc& src = pInstances[i];
+            vk::AccelerationStructureInstanceKHR& dst = instances[i];
+            rt::AccelStructHandle blasReference;
+
+            if (src.bottomLevelAS)
+            {
+                AccelStruct* blas = checked_cast<AccelStruct*>(src.bottomLevelAS);
+#ifdef NVRHI_WITH_RTXMU
+                blas->accelStructDeviceAddress = m_Context.rtxMemUtil->GetDeviceAddress(blas->rtxmuId);
+#else
+                if (m_EnableAutomaticBarriers)
+                {
+                    requireBufferState(blas->dataBuffer, nvrhi::ResourceStates::AccelStructBuildBlas);
+                }
+#endif
+                dst.setAccelerationStructureReference(blas->accelStructDeviceAddress);
+
+                if (blas->desc.trackLiveness)
+                    blasReference = blas;
+            }
+            else // !src.bottomLevelAS
+            {
+                dst.setAccelerationStructureReference(0);
+            }
+
+            dst.setInstanceCustomIndex(src.instanceID);
+            dst.setInstanceShaderBindingTableRecordOffset(src.instanceContributionToHitGroupIndex);
+            dst.setFlags(convertInstanceFlags(src.flags));
+            dst.setMask(src.instanceMask);
+            memcpy(dst.transform.matrix.data(), src.transform, sizeof(float) * 12);
+
+            if (!as->instanceBufferBLASes.empty())
+                as->instanceBufferBLASes[firstInstance + i] = blasReference;
+        }
+
+        static_assert(sizeof(vk::AccelerationStructureInstanceKHR) == sizeof(rt::InstanceDesc));
+
+        writeBuffer(as->instanceBuffer, instances.data(), instances.size() * sizeof(vk::AccelerationStructureInstanceKHR),
+            firstInstance * sizeof(vk::AccelerationStructureInstanceKHR));
+
+        if (as->desc.trackLiveness)
+            m_CurrentCmdBuf->referencedResources.push_back(as);
+    }
+
     void CommandList::executeMultiIndirectClusterOperation(const rt::cluster::OperationDesc& desc)
     {
         // Create Vulkan operation info
@@ -1055,6 +1582,7 @@ namespace nvrhi::vulkan
         Buffer* inOutAddressesBuffer = checked_cast<Buffer*>(desc.inOutAddressesBuffer);
         Buffer* outSizesBuffer = checked_cast<Buffer*>(desc.outSizesBuffer);
         Buffer* outAccelerationStructuresBuffer = checked_cast<Buffer*>(desc.outAccelerationStructuresBuffer);
+        Buffer* persistentScratchBuffer = checked_cast<Buffer*>(desc.scratchBuffer);
 
         // Set up resource states and barriers
         if (m_EnableAutomaticBarriers)
@@ -1069,6 +1597,8 @@ namespace nvrhi::vulkan
                 requireBufferState(outSizesBuffer, ResourceStates::UnorderedAccess);
             if (outAccelerationStructuresBuffer)
                 requireBufferState(outAccelerationStructuresBuffer, ResourceStates::AccelStructWrite);
+            if (persistentScratchBuffer)
+                requireBufferState(persistentScratchBuffer, ResourceStates::UnorderedAccess);
             m_BindingStatesDirty = true;
         }
 
@@ -1083,6 +1613,8 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(outSizesBuffer);
         if (outAccelerationStructuresBuffer)
             m_CurrentCmdBuf->referencedResources.push_back(outAccelerationStructuresBuffer);
+        if (persistentScratchBuffer)
+            m_CurrentCmdBuf->referencedResources.push_back(persistentScratchBuffer);
 
         commitBarriers();
 
@@ -1091,7 +1623,12 @@ namespace nvrhi::vulkan
         uint64_t scratchOffset = 0;
         uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
 
-        if (desc.scratchSizeInBytes > 0)
+        if (persistentScratchBuffer)
+        {
+            scratchBuffer = persistentScratchBuffer;
+            scratchOffset = desc.scratchOffsetInBytes;
+        }
+        else if (desc.scratchSizeInBytes > 0)
         {
             if (!m_ScratchManager->suballocateBuffer(desc.scratchSizeInBytes, &scratchBuffer, &scratchOffset, nullptr,
                 currentVersion, m_Context.nvClusterAccelerationStructureProperties.clusterScratchByteAlignment))
@@ -1166,6 +1703,16 @@ namespace nvrhi::vulkan
             m_Context.device.destroyAccelerationStructureKHR(accelStruct, m_Context.allocationCallbacks);
             accelStruct = nullptr;
         }
+
+        if (compactedSizeQuery >= 0)
+        {
+            AccelStructCompaction& compaction = *m_Context.accelStructCompaction;
+            std::lock_guard lockGuard(compaction.mutex);
+
+            compaction.candidates.erase(std::remove(compaction.candidates.begin(), compaction.candidates.end(), this),
+                compaction.candidates.end());
+            compaction.queries.release(compactedSizeQuery);
+        }
     }
 
     Object AccelStruct::getNativeObject(ObjectType objectType)
@@ -1195,6 +1742,15 @@ namespace nvrhi::vulkan
 
     OpacityMicromap::~OpacityMicromap()
     {
+        if (compactedSizeQuery >= 0)
+        {
+            AccelStructCompaction& compaction = *m_Context.accelStructCompaction;
+            std::lock_guard lockGuard(compaction.mutex);
+
+            compaction.micromapCandidates.erase(std::remove(compaction.micromapCandidates.begin(), compaction.micromapCandidates.end(), this),
+                compaction.micromapCandidates.end());
+            compaction.micromapQueries.release(compactedSizeQuery);
+        }
     }
 
     Object OpacityMicromap::getNativeObject(ObjectType objectType)
@@ -1218,85 +1774,82 @@ namespace nvrhi::vulkan
         return getBufferAddress(dataBuffer, 0).deviceAddress;
     }
 
-    void ShaderTable::bake(uint8_t* uploadCpuVA, vk::DeviceAddress uploadGpuVA, ShaderTableState& state)
+    int ShaderTable::getRecordShaderGroup(uint32_t recordIndex) const
     {
-        const uint32_t shaderGroupHandleSize = m_Context.rayTracingPipelineProperties.shaderGroupHandleSize;
-        const uint32_t shaderGroupBaseAlignment = m_Context.rayTracingPipelineProperties.shaderGroupBaseAlignment;
+        if (recordIndex == 0)
+            return rayGenerationShader;
 
-        // Copy the shader and group handles into the device SBT, record the pointers and the version.
+        uint32_t const missBase = getMissShaderBase();
+        if (recordIndex >= missBase && recordIndex < missBase + missShaders.size())
+            return int(missShaders[recordIndex - missBase]);
 
-        state.version = version;
+        uint32_t const hitGroupBase = getHitGroupBase();
+        if (recordIndex >= hitGroupBase && recordIndex < hitGroupBase + hitGroups.size())
+            return int(hitGroups[recordIndex - hitGroupBase]);
 
-        // ... RayGen
+        uint32_t const callableBase = getCallableShaderBase();
+        if (recordIndex >= callableBase && recordIndex < callableBase + callableShaders.size())
+            return int(callableShaders[recordIndex - callableBase]);
 
-        uint32_t sbtIndex = 0;
-        memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-            pipeline->shaderGroupHandles.data() + shaderGroupHandleSize * rayGenerationShader,
-            shaderGroupHandleSize);
-        state.rayGen.setDeviceAddress(uploadGpuVA + sbtIndex * shaderGroupBaseAlignment);
-        state.rayGen.setSize(shaderGroupBaseAlignment);
-        state.rayGen.setStride(shaderGroupBaseAlignment);
-        sbtIndex++;
+        // The record is in the unused part of a section reservation
+        return -1;
+    }
 
-        // ... Miss
+    void ShaderTable::writeRecord(uint8_t* cpuVA, uint32_t recordIndex) const
+    {
+        const uint32_t shaderGroupHandleSize = m_Context.rayTracingPipelineProperties.shaderGroupHandleSize;
+        const int shaderGroupIndex = getRecordShaderGroup(recordIndex);
 
-        if (!missShaders.empty())
-        {
-            state.miss.setDeviceAddress(uploadGpuVA + sbtIndex * shaderGroupBaseAlignment);
-            for (uint32_t shaderGroupIndex : missShaders)
-            {
-                memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-                    pipeline->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex,
-                    shaderGroupHandleSize);
-                sbtIndex++;
-            }
-            state.miss.setSize(shaderGroupBaseAlignment * uint32_t(missShaders.size()));
-            state.miss.setStride(shaderGroupBaseAlignment);
-        }
-        else
+        if (shaderGroupIndex >= 0)
         {
-            state.miss = vk::StridedDeviceAddressRegionKHR();
+            memcpy(cpuVA, pipeline->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex,
+                shaderGroupHandleSize);
         }
+    }
 
-        // ... Hit Groups
+    void ShaderTable::fillRegions(vk::DeviceAddress gpuVA, ShaderTableState& state) const
+    {
+        const uint32_t shaderGroupBaseAlignment = m_Context.rayTracingPipelineProperties.shaderGroupBaseAlignment;
 
-        if (!hitGroups.empty())
+        auto fillRegion = [gpuVA, shaderGroupBaseAlignment](vk::StridedDeviceAddressRegionKHR& region, uint32_t base, size_t count)
         {
-            state.hitGroups.setDeviceAddress(uploadGpuVA + sbtIndex * shaderGroupBaseAlignment);
-            for (uint32_t shaderGroupIndex : hitGroups)
+            if (count == 0)
             {
-                memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-                    pipeline->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex,
-                    shaderGroupHandleSize);
-                sbtIndex++;
+                region = vk::StridedDeviceAddressRegionKHR();
+                return;
             }
-            state.hitGroups.setSize(shaderGroupBaseAlignment * uint32_t(hitGroups.size()));
-            state.hitGroups.setStride(shaderGroupBaseAlignment);
-        }
-        else
-        {
-            state.hitGroups = vk::StridedDeviceAddressRegionKHR();
-        }
 
-        // ... Callable
+            region.setDeviceAddress(gpuVA + base * shaderGroupBaseAlignment);
+            region.setSize(shaderGroupBaseAlignment * uint32_t(count));
+            region.setStride(shaderGroupBaseAlignment);
+        };
 
-        if (!callableShaders.empty())
-        {
-            state.callable.setDeviceAddress(uploadGpuVA + sbtIndex * shaderGroupBaseAlignment);
-            for (uint32_t shaderGroupIndex : callableShaders)
-            {
-                memcpy(uploadCpuVA + sbtIndex * shaderGroupBaseAlignment,
-                    pipeline->shaderGroupHandles.data() + shaderGroupHandleSize * shaderGroupIndex,
-                    shaderGroupHandleSize);
-                sbtIndex++;
-            }
-            state.callable.setSize(shaderGroupBaseAlignment * uint32_t(callableShaders.size()));
-            state.callable.setStride(shaderGroupBaseAlignment);
-        }
-        else
+        fillRegion(state.rayGen, 0, 1);
+        fillRegion(state.miss, getMissShaderBase(), missShaders.size());
+        fillRegion(state.hitGroups, getHitGroupBase(), hitGroups.size());
+        fillRegion(state.callable, getCallableShaderBase(), callableShaders.size());
+    }
+
+    void ShaderTable::bake(uint8_t* uploadCpuVA, vk::DeviceAddress uploadGpuVA, ShaderTableState& state)
+    {
+        const uint32_t shaderGroupBaseAlignment = m_Context.rayTracingPipelineProperties.shaderGroupBaseAlignment;
+
+        // Copy the shader and group handles into the device SBT, record the pointers and the version.
+        // The unused records in section reservations are left uninitialized, they are never accessed by the GPU.
+
+        uint32_t const numRecords = getNumRecords();
+        for (uint32_t recordIndex = 0; recordIndex < numRecords; ++recordIndex)
         {
-            state.callable = vk::StridedDeviceAddressRegionKHR();
+            writeRecord(uploadCpuVA + recordIndex * shaderGroupBaseAlignment, recordIndex);
         }
+
+        fillRegions(uploadGpuVA, state);
+
+        state.version = version;
+        state.layoutVersion = layoutVersion;
+
+        if (m_Desc.isCached)
+            dirtyRecords.clear();
     }
 
     ShaderTableState& CommandList::getShaderTableState(rt::IShaderTable* _shaderTable)
@@ -1320,6 +1873,72 @@ namespace nvrhi::vulkan
         return state;
     }
 
+    bool CommandList::updateShaderTableRecords(ShaderTable* shaderTable, ShaderTableState& state)
+    {
+        std::vector<uint32_t>& records = shaderTable->dirtyRecords;
+        std::sort(records.begin(), records.end());
+        records.erase(std::unique(records.begin(), records.end()), records.end());
+        records.erase(std::remove_if(records.begin(), records.end(),
+            [shaderTable](uint32_t recordIndex) { return shaderTable->getRecordShaderGroup(recordIndex) < 0; }), records.end());
+
+        if (!records.empty())
+        {
+            uint32_t const entrySize = shaderTable->pipeline->getShaderTableEntrySize();
+
+            // Write the modified records next to each other in the upload buffer,
+            // and copy them into the cache with one region per contiguous range of records.
+
+            Buffer* uploadBuffer = nullptr;
+            uint64_t uploadOffset = 0;
+            uint8_t* uploadCpuVA = nullptr;
+            bool allocated = m_UploadManager->suballocateBuffer(records.size() * entrySize, &uploadBuffer, &uploadOffset, (void**)&uploadCpuVA,
+                MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false),
+                entrySize);
+
+            if (!allocated)
+            {
+                m_Context.error("Failed to suballocate an upload buffer for the SBT");
+                return false;
+            }
+
+            std::vector<vk::BufferCopy> copyRegions;
+            for (size_t i = 0; i < records.size(); ++i)
+            {
+                shaderTable->writeRecord(uploadCpuVA + i * entrySize, records[i]);
+
+                uint64_t const srcOffset = uploadOffset + i * entrySize;
+                uint64_t const dstOffset = uint64_t(records[i]) * entrySize;
+
+                if (!copyRegions.empty() && copyRegions.back().dstOffset + copyRegions.back().size == dstOffset)
+                {
+                    copyRegions.back().size += entrySize;
+                    continue;
+                }
+
+                copyRegions.push_back(vk::BufferCopy()
+                    .setSrcOffset(srcOffset)
+                    .setDstOffset(dstOffset)
+                    .setSize(entrySize));
+            }
+
+            Buffer* cache = checked_cast<Buffer*>(shaderTable->cache.Get());
+
+            m_CurrentCmdBuf->referencedStagingBuffers.push_back(uploadBuffer);
+
+            requireBufferState(uploadBuffer, ResourceStates::CopySource);
+            requireBufferState(cache, ResourceStates::CopyDest);
+            commitBarriers();
+
+            m_CurrentCmdBuf->cmdBuf.copyBuffer(uploadBuffer->buffer, cache->buffer, copyRegions);
+        }
+
+        shaderTable->fillRegions(shaderTable->cache->getGpuVirtualAddress(), state);
+        state.version = shaderTable->version;
+        records.clear();
+
+        return true;
+    }
+
     void CommandList::setRayTracingState(const rt::State& state)
     {
         if (!state.shaderTable)
@@ -1363,7 +1982,14 @@ namespace nvrhi::vulkan
         ShaderTableState& shaderTableState = getShaderTableState(shaderTable);
         bool const rebuildShaderTable = shaderTableState.version != shaderTable->version;
 
-        if (rebuildShaderTable)
+        if (rebuildShaderTable && shaderTable->canUpdateRecords(shaderTableState))
+        {
+            // The layout of the cached table is unchanged, only upload the modified records.
+
+            if (!updateShaderTableRecords(shaderTable, shaderTableState))
+                return;
+        }
+        else if (rebuildShaderTable)
         {
             size_t const shaderTableSize = shaderTable->getUploadSize();
 
@@ -1628,7 +2254,12 @@ namespace nvrhi::vulkan
         auto pipelineFlags2 = vk::PipelineCreateFlags2CreateInfoKHR();
         pipelineFlags2.setFlags(vk::PipelineCreateFlagBits2::eRayTracingAllowSpheresAndLinearSweptSpheresNV);
 
+        // When chained, the flags2 structure replaces the flags in the create info
+        if (m_Context.descriptorBuffer)
+            pipelineFlags2.flags |= vk::PipelineCreateFlagBits2::eDescriptorBufferEXT;
+
         auto pipelineInfo = vk::RayTracingPipelineCreateInfoKHR()
+            .setFlags(m_Context.getPipelineCreateFlags())
             .setStages(shaderStages)
             .setGroups(shaderGroups)
             .setLayout(pso->pipelineLayout)
@@ -1641,11 +2272,44 @@ namespace nvrhi::vulkan
             pipelineInfo.setPNext(&pipelineClusters);
         }
 
-        res = m_Context.device.createRayTracingPipelinesKHR(vk::DeferredOperationKHR(), m_Context.pipelineCache,
+        // Use a deferred operation so that the driver can spread the compilation over the pipeline compiler threads.
+        // VK_KHR_deferred_host_operations is required by VK_KHR_acceleration_structure.
+        vk::DeferredOperationKHR deferredOperation;
+        if (m_Context.device.createDeferredOperationKHR(m_Context.allocationCallbacks, &deferredOperation) != vk::Result::eSuccess)
+            deferredOperation = vk::DeferredOperationKHR();
+
+        res = m_Context.device.createRayTracingPipelinesKHR(deferredOperation, m_Context.pipelineCache,
             1, &pipelineInfo,
             m_Context.allocationCallbacks,
             &pso->pipeline);
 
+        if (res == vk::Result::eOperationDeferredKHR)
+        {
+            const uint32_t maxConcurrency = m_Context.device.getDeferredOperationMaxConcurrencyKHR(deferredOperation);
+
+            m_PipelineCompiler.runParallel(maxConcurrency, [this, deferredOperation]()
+            {
+                // eThreadIdleKHR means that there may be more work for this thread later
+                while (m_Context.device.deferredOperationJoinKHR(deferredOperation) == vk::Result::eThreadIdleKHR)
+                    std::this_thread::yield();
+            });
+
+            // Every joining thread has returned, but the operation may still be finishing on the last one's work
+            res = m_Context.device.getDeferredOperationResultKHR(deferredOperation);
+            while (res == vk::Result::eNotReady)
+            {
+                std::this_thread::yield();
+                res = m_Context.device.getDeferredOperationResultKHR(deferredOperation);
+            }
+        }
+        else if (res == vk::Result::eOperationNotDeferredKHR)
+        {
+            res = vk::Result::eSuccess;
+        }
+
+        if (deferredOperation)
+            m_Context.device.destroyDeferredOperationKHR(deferredOperation, m_Context.allocationCallbacks);
+
         CHECK_VK_FAIL(res)
 
         // Obtain the shader group handles to fill the SBT buffer later
@@ -1686,6 +2350,12 @@ namespace nvrhi::vulkan
                 m_Context.error("maxEntries must be nonzero for a cached ShaderTable");
                 return nullptr;
             }
+
+            if (uint64_t(stDesc.reservedMissShaders) + stDesc.reservedHitGroups + stDesc.reservedCallableShaders >= stDesc.maxEntries)
+            {
+                m_Context.error("The reserved records of a cached ShaderTable and its RayGen shader don't fit into maxEntries");
+                return nullptr;
+            }
             
             BufferDesc bufferDesc = BufferDesc()
                 .setDebugName(stDesc.debugName)
@@ -1717,50 +2387,154 @@ namespace nvrhi::vulkan
         }
     }
 
-    int RayTracingPipeline::findShaderGroup(const std::string& name)
+    rt::ShaderExportId RayTracingPipeline::getShaderExportId(const char* exportName) const
     {
-        auto it = shaderGroups.find(name);
+        if (!exportName)
+            return rt::ShaderExportId::Invalid;
+
+        auto it = shaderGroups.find(exportName);
         if (it == shaderGroups.end())
-            return -1;
+            return rt::ShaderExportId::Invalid;
 
-        return int(it->second);
+        return rt::ShaderExportId(it->second);
     }
 
-    bool ShaderTable::verifyShaderGroupExists(const char* exportName, int shaderGroupIndex) const
+    bool RayTracingPipeline::isValidShaderExport(rt::ShaderExportId exportId) const
     {
-        if (shaderGroupIndex >= 0)
+        size_t const shaderGroupHandleSize = m_Context.rayTracingPipelineProperties.shaderGroupHandleSize;
+        return size_t(exportId) < shaderGroupHandles.size() / shaderGroupHandleSize;
+    }
+
+    bool ShaderTable::resolveExportName(const char* exportName, rt::ShaderExportId& outExportId) const
+    {
+        outExportId = pipeline->getShaderExportId(exportName);
+
+        if (outExportId != rt::ShaderExportId::Invalid)
             return true;
 
         std::stringstream ss;
-        ss << "Cannot find a RT pipeline shader group for RayGen shader with name " << exportName;
+        ss << "Cannot find a RT pipeline shader group with name " << (exportName ? exportName : "<null>");
         m_Context.error(ss.str());
         return false;
     }
 
+    bool ShaderTable::verifyShaderExport(rt::ShaderExportId exportId) const
+    {
+        if (pipeline->isValidShaderExport(exportId))
+            return true;
+
+        m_Context.error("Invalid RT pipeline shader export ID");
+        return false;
+    }
+
+    void ShaderTable::reserveRecords(uint32_t& capacity, size_t count)
+    {
+        if (!m_Desc.isCached || count <= capacity)
+            return;
+
+        // Grow the section geometrically within maxEntries, so that streaming in new entries
+        // doesn't change the layout of the cache every time. If the entries don't fit anyway,
+        // the error is reported when the table is used in setRayTracingState.
+
+        uint32_t const otherRecords = getNumRecords() - capacity;
+        uint32_t const available = (m_Desc.maxEntries > otherRecords) ? m_Desc.maxEntries - otherRecords : 0;
+        capacity = std::max(uint32_t(count), std::min(std::max(capacity * 2, 16u), available));
+        ++layoutVersion;
+    }
+
+    void ShaderTable::markRecordDirty(uint32_t recordIndex)
+    {
+        if (!m_Desc.isCached)
+            return;
+
+        // When most of the table has been modified, uploading it whole is cheaper than patching.
+        if (dirtyRecords.size() >= getNumEntries() / 2)
+        {
+            dirtyRecords.clear();
+            ++layoutVersion;
+            return;
+        }
+
+        dirtyRecords.push_back(recordIndex);
+    }
+
     void ShaderTable::setRayGenerationShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (resolveExportName(exportName, exportId))
+            setRayGenerationShader(exportId, bindings);
+    }
+
+    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addMissShader(exportId, bindings);
+    }
+
+    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addHitGroups(&exportId, bindings ? &bindings : nullptr, 1);
+    }
+
+    int ShaderTable::addHitGroups(const char* const* exportNames, IBindingSet* const* bindings, size_t count)
+    {
+        std::vector<rt::ShaderExportId> exportIds(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!resolveExportName(exportNames[i], exportIds[i]))
+                return -1;
+        }
+
+        return addHitGroups(exportIds.data(), bindings, count);
+    }
+
+    void ShaderTable::setHitGroup(uint32_t index, const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (resolveExportName(exportName, exportId))
+            setHitGroup(index, exportId, bindings);
+    }
+
+    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    {
+        rt::ShaderExportId exportId;
+        if (!resolveExportName(exportName, exportId))
+            return -1;
+
+        return addCallableShader(exportId, bindings);
+    }
+
+    void ShaderTable::setRayGenerationShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
     {
         if (bindings != nullptr)
             utils::NotSupported();
 
-        const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
-
-        if (verifyShaderGroupExists(exportName, shaderGroupIndex))
+        if (verifyShaderExport(exportId))
         {
-            rayGenerationShader = shaderGroupIndex;
+            rayGenerationShader = int(exportId);
+            markRecordDirty(0);
             ++version;
         }
     }
 
-    int ShaderTable::addMissShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    int ShaderTable::addMissShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
     {
         if (bindings != nullptr)
             utils::NotSupported();
 
-        const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
-
-        if (verifyShaderGroupExists(exportName, shaderGroupIndex))
+        if (verifyShaderExport(exportId))
         {
-            missShaders.push_back(uint32_t(shaderGroupIndex));
+            reserveRecords(missCapacity, missShaders.size() + 1);
+            missShaders.push_back(uint32_t(exportId));
+            markRecordDirty(getMissShaderBase() + uint32_t(missShaders.size()) - 1);
             ++version;
 
             return int(missShaders.size()) - 1;
@@ -1769,34 +2543,74 @@ namespace nvrhi::vulkan
         return -1;
     }
 
-    int ShaderTable::addHitGroup(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    int ShaderTable::addHitGroup(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
     {
-        if (bindings != nullptr)
-            utils::NotSupported();
+        return addHitGroups(&exportId, bindings ? &bindings : nullptr, 1);
+    }
 
-        const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
+    int ShaderTable::addHitGroups(const rt::ShaderExportId* exportIds, IBindingSet* const* bindings, size_t count)
+    {
+        if (count == 0)
+            return int(hitGroups.size());
+
+        // Verify all the groups first to add either all or none of them.
 
-        if (verifyShaderGroupExists(exportName, shaderGroupIndex))
+        for (size_t i = 0; i < count; ++i)
         {
-            hitGroups.push_back(uint32_t(shaderGroupIndex));
-            ++version;
+            if (bindings != nullptr && bindings[i] != nullptr)
+                utils::NotSupported();
 
-            return int(hitGroups.size()) - 1;
+            if (!verifyShaderExport(exportIds[i]))
+                return -1;
         }
 
-        return -1;
+        int const firstIndex = int(hitGroups.size());
+
+        reserveRecords(hitGroupCapacity, hitGroups.size() + count);
+        hitGroups.reserve(hitGroups.size() + count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            hitGroups.push_back(uint32_t(exportIds[i]));
+            markRecordDirty(getHitGroupBase() + uint32_t(firstIndex + i));
+        }
+
+        ++version;
+
+        return firstIndex;
     }
 
-    int ShaderTable::addCallableShader(const char* exportName, IBindingSet* bindings /*= nullptr*/)
+    void ShaderTable::setHitGroup(uint32_t index, rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
     {
         if (bindings != nullptr)
             utils::NotSupported();
 
-        const int shaderGroupIndex = pipeline->findShaderGroup(exportName);
+        if (index >= hitGroups.size())
+        {
+            std::stringstream ss;
+            ss << "Cannot replace hit group " << index << " in a shader table that has " << hitGroups.size() << " hit groups";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        if (verifyShaderExport(exportId))
+        {
+            hitGroups[index] = uint32_t(exportId);
+            markRecordDirty(getHitGroupBase() + index);
+            ++version;
+        }
+    }
+
+    int ShaderTable::addCallableShader(rt::ShaderExportId exportId, IBindingSet* bindings /*= nullptr*/)
+    {
+        if (bindings != nullptr)
+            utils::NotSupported();
 
-        if (verifyShaderGroupExists(exportName, shaderGroupIndex))
+        if (verifyShaderExport(exportId))
         {
-            callableShaders.push_back(uint32_t(shaderGroupIndex));
+            reserveRecords(callableCapacity, callableShaders.size() + 1);
+            callableShaders.push_back(uint32_t(exportId));
+            markRecordDirty(getCallableShaderBase() + uint32_t(callableShaders.size()) - 1);
             ++version;
 
             return int(callableShaders.size()) - 1;
@@ -1805,6 +2619,8 @@ namespace nvrhi::vulkan
         return -1;
     }
 
+    // Clearing a section keeps its reservation, so the records added later can be patched into the cache.
+
     void ShaderTable::clearMissShaders()
     {
         missShaders.clear();
@@ -0,0 +1,185 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+
+#include <limits>
+
+namespace nvrhi::vulkan
+{
+    static float convertResidencyPriority(ResidencyPriority priority)
+    {
+        switch (priority)
+        {
+        case ResidencyPriority::Minimum: return 0.f;
+        case ResidencyPriority::Low:     return 0.25f;
+        case ResidencyPriority::Normal:  return 0.5f; // the default priority of allocations
+        case ResidencyPriority::High:    return 0.75f;
+        case ResidencyPriority::Maximum: return 1.f;
+        default:
+            utils::InvalidEnum();
+            return 0.5f;
+        }
+    }
+
+    bool Device::getVideoMemoryBudget(VideoMemoryBudget& outBudget)
+    {
+        if (!m_Context.extensions.EXT_memory_budget)
+            return false;
+
+        vk::PhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties;
+        vk::PhysicalDeviceMemoryProperties2 memoryProperties;
+        memoryProperties.pNext = &budgetProperties;
+        m_Context.physicalDevice.getMemoryProperties2(&memoryProperties);
+
+        outBudget = VideoMemoryBudget();
+
+        const vk::PhysicalDeviceMemoryProperties& properties = memoryProperties.memoryProperties;
+        for (uint32_t heapIndex = 0; heapIndex < properties.memoryHeapCount; heapIndex++)
+        {
+            if (properties.memoryHeaps[heapIndex].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+            {
+                outBudget.localBudget += budgetProperties.heapBudget[heapIndex];
+                outBudget.localUsage += budgetProperties.heapUsage[heapIndex];
+            }
+            else
+            {
+                outBudget.nonLocalBudget += budgetProperties.heapBudget[heapIndex];
+                outBudget.nonLocalUsage += budgetProperties.heapUsage[heapIndex];
+            }
+        }
+
+        return true;
+    }
+
+    MemoryStatistics Device::getMemoryStatistics()
+    {
+        MemoryStatistics statistics = m_Context.memoryStatistics->getStatistics();
+
+        // Descriptor pools are allocated by the driver and not counted, only the descriptor buffer is
+        if (m_DescriptorBuffer)
+        {
+            MemoryCategoryStatistics& descriptorHeaps = statistics.get(MemoryCategory::DescriptorHeaps);
+            descriptorHeaps.usedBytes = std::min(m_DescriptorBuffer->getUsedSize(), descriptorHeaps.allocatedBytes);
+        }
+
+        return statistics;
+    }
+
+    void Device::setResidencyPriority(IResource* resource, ResidencyPriority priority)
+    {
+        const uint64_t memory = resource ? resource->getNativeObject(ObjectTypes::VK_DeviceMemory).integer : 0;
+        if (!memory)
+        {
+            m_Context.error("setResidencyPriority: the resource is not a texture, buffer or heap with bound memory");
+            return;
+        }
+
+        if (!m_Context.extensions.EXT_pageable_device_local_memory)
+            return;
+
+        if (m_Context.residency)
+            m_Context.residency->setPriority(memory, priority);
+
+        m_Context.device.setMemoryPriorityEXT(vk::DeviceMemory(VkDeviceMemory(memory)), convertResidencyPriority(priority));
+    }
+
+    void Device::makeReferencedResourcesResident(ICommandList* const* pCommandLists, size_t numCommandLists)
+    {
+        m_ResidencyKeys.clear();
+        m_ResidencyChanges.clear();
+
+        auto addResource = [this](IResource* resource)
+        {
+            if (!resource)
+                return;
+
+            if (const uint64_t memory = resource->getNativeObject(ObjectTypes::VK_DeviceMemory).integer)
+            {
+                m_ResidencyKeys.push_back(memory);
+            }
+            else if (BindingSet* bindingSet = dynamic_cast<BindingSet*>(resource))
+            {
+                // Binding sets without automatic barriers are the only reference to their resources
+                for (const auto& bindingResource : bindingSet->resources)
+                {
+                    if (!bindingResource)
+                        continue;
+
+                    if (const uint64_t bindingMemory = bindingResource->getNativeObject(ObjectTypes::VK_DeviceMemory).integer)
+                        m_ResidencyKeys.push_back(bindingMemory);
+                }
+            }
+        };
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            TrackedCommandBufferPtr commandBuffer = checked_cast<CommandList*>(pCommandLists[i])->getCurrentCmdBuf();
+
+            for (const auto& resource : commandBuffer->referencedResources)
+                addResource(resource);
+
+            for (const auto& bundle : commandBuffer->referencedBundles)
+            {
+                for (const auto& resource : bundle->referencedResources)
+                    addResource(resource);
+            }
+        }
+
+        m_Context.residency->markUsed(m_ResidencyKeys, m_ResidencyChanges);
+
+        // The demoted allocations get their priorities back; the driver pages them in as needed
+        for (uint64_t memory : m_ResidencyChanges)
+        {
+            m_Context.device.setMemoryPriorityEXT(vk::DeviceMemory(VkDeviceMemory(memory)),
+                convertResidencyPriority(m_Context.residency->getPriority(memory)));
+        }
+    }
+
+    void Device::updateResidency()
+    {
+        VideoMemoryBudget budget;
+        if (!getVideoMemoryBudget(budget))
+            return;
+
+        if (budget.localUsage <= budget.localBudget)
+            return;
+
+        if (m_Context.residency)
+        {
+            // Lowering the priority of memory is allowed while it's in use, so don't wait for the submissions
+            uint64_t completedInstances[size_t(CommandQueue::Count)];
+            for (uint64_t& instance : completedInstances)
+                instance = std::numeric_limits<uint64_t>::max();
+
+            m_ResidencyChanges.clear();
+            m_Context.residency->evict(budget.localUsage - budget.localBudget, completedInstances, m_ResidencyChanges);
+
+            for (uint64_t memory : m_ResidencyChanges)
+                m_Context.device.setMemoryPriorityEXT(vk::DeviceMemory(VkDeviceMemory(memory)), 0.f);
+        }
+
+        if (m_BudgetCallback)
+            m_BudgetCallback->budgetExceeded(budget);
+    }
+
+} // namespace nvrhi::vulkan
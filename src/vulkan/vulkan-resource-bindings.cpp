@@ -22,6 +22,7 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <algorithm>
 #include <sstream>
 
 namespace nvrhi::vulkan
@@ -65,6 +66,7 @@ namespace nvrhi::vulkan
         case ResourceType::ConstantBuffer:
         case ResourceType::VolatileConstantBuffer:
         case ResourceType::PushConstants:
+        case ResourceType::InlineUniformBlock:
             return bindingOffsets.constantBuffer;
             break;
 
@@ -84,6 +86,38 @@ namespace nvrhi::vulkan
     {
         vk::ShaderStageFlagBits shaderStageFlags = convertShaderTypeToShaderStageFlagBits(desc.visibility);
 
+        bool hasInlineUniformBlocks = false;
+        uint32_t numDescriptors = 0;
+        for (const BindingLayoutItem& binding : desc.bindings)
+        {
+            if (binding.type == ResourceType::InlineUniformBlock)
+                hasInlineUniformBlocks = true;
+            else if (binding.type != ResourceType::PushConstants)
+                numDescriptors += binding.size;
+        }
+
+        if (hasInlineUniformBlocks && !m_Context.extensions.EXT_inline_uniform_block)
+            m_Context.error("Inline uniform blocks are not supported by this device. VK_EXT_inline_uniform_block extension is required.");
+
+        if (desc.usePushDescriptors)
+        {
+            if (!m_Context.extensions.KHR_push_descriptor)
+                m_Context.warning("Push descriptors require VK_KHR_push_descriptor, the binding layout will use descriptor sets");
+            else if (m_Context.descriptorBuffer)
+                m_Context.warning("Push descriptors are not used when the device uses a descriptor buffer");
+            else if (hasInlineUniformBlocks)
+                m_Context.error("Inline uniform blocks cannot be used in binding layouts with usePushDescriptors");
+            else if (numDescriptors > m_Context.pushDescriptorProperties.maxPushDescriptors)
+            {
+                std::stringstream ss;
+                ss << "The binding layout has " << numDescriptors << " descriptors, more than maxPushDescriptors ("
+                    << m_Context.pushDescriptorProperties.maxPushDescriptors << "), it will use descriptor sets";
+                m_Context.warning(ss.str());
+            }
+            else
+                usesPushDescriptors = true;
+        }
+
         // iterate over all binding types and add to map
         for (const BindingLayoutItem& binding : desc.bindings)
         {
@@ -93,7 +127,13 @@ namespace nvrhi::vulkan
                 continue;
             }
 
-            vk::DescriptorType const descriptorType = convertResourceType(binding.type);
+            vk::DescriptorType descriptorType = convertResourceType(binding.type);
+
+            // Push descriptor sets cannot have dynamic descriptors, the volatile buffer versions are patched in when they're pushed
+            if (usesPushDescriptors && descriptorType == vk::DescriptorType::eUniformBufferDynamic)
+                descriptorType = vk::DescriptorType::eUniformBuffer;
+
+            // For inline uniform blocks, the descriptor count is the byte size of the block
             uint32_t const descriptorCount = binding.size;
             uint32_t const registerOffset = getRegisterOffsetForResourceType(_desc.bindingOffsets, binding.type);
 
@@ -181,7 +221,17 @@ namespace nvrhi::vulkan
             .setBindingCount(uint32_t(vulkanLayoutBindings.size()))
             .setPBindings(vulkanLayoutBindings.data());
 
-        std::vector<vk::DescriptorBindingFlags> bindFlag(vulkanLayoutBindings.size(), vk::DescriptorBindingFlagBits::ePartiallyBound);
+        // Descriptor buffers have no such restriction, and their layouts cannot use the update-after-bind pool flag
+        updateAfterBind = isBindless && m_Context.descriptorUpdateAfterBind && !m_Context.descriptorBuffer;
+
+        vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound;
+        if (updateAfterBind)
+        {
+            // Allows writing the descriptors that the GPU doesn't use while command buffers using the set are pending
+            bindingFlags |= vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+        }
+
+        std::vector<vk::DescriptorBindingFlags> bindFlag(vulkanLayoutBindings.size(), bindingFlags);
 
         auto extendedInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfo()
             .setBindingCount(uint32_t(vulkanLayoutBindings.size()))
@@ -231,6 +281,11 @@ namespace nvrhi::vulkan
 
         if (isBindless)
         {
+            if (updateAfterBind)
+            {
+                descriptorSetLayoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
+            }
+
             if (bindlessDesc.layoutType != BindlessLayoutDesc::LayoutType::Immutable)
             {
                 descriptorSetLayoutInfo.setPNext(&mutableDescriptorTypeCreateInfo);
@@ -241,11 +296,57 @@ namespace nvrhi::vulkan
             }
         }
 
+        if (usesPushDescriptors)
+        {
+            descriptorSetLayoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR);
+        }
+
+        if (m_Context.descriptorBuffer)
+        {
+            descriptorSetLayoutInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT);
+
+            // Dynamic descriptors cannot be used with descriptor buffers, the volatile buffer versions are patched in at bind time
+            for (auto& layoutBinding : vulkanLayoutBindings)
+            {
+                if (layoutBinding.descriptorType == vk::DescriptorType::eUniformBufferDynamic)
+                    layoutBinding.descriptorType = vk::DescriptorType::eUniformBuffer;
+            }
+        }
+
         const vk::Result res = m_Context.device.createDescriptorSetLayout(&descriptorSetLayoutInfo,
                                                                         m_Context.allocationCallbacks,
                                                                         &descriptorSetLayout);
         CHECK_VK_RETURN(res)
 
+        if (m_Context.descriptorBuffer)
+        {
+            descriptorBufferSize = m_Context.device.getDescriptorSetLayoutSizeEXT(descriptorSetLayout);
+
+            for (const auto& layoutBinding : vulkanLayoutBindings)
+            {
+                DescriptorBufferBinding& bufferBinding = descriptorBufferBindings[layoutBinding.binding];
+                bufferBinding.offset = m_Context.device.getDescriptorSetLayoutBindingOffsetEXT(descriptorSetLayout, layoutBinding.binding);
+
+                if (layoutBinding.descriptorType == vk::DescriptorType::eMutableEXT)
+                {
+                    // The elements of mutable bindings are as large as the largest type in the list
+                    for (uint32_t index = 0; index < pMutableDescriptorTypeLists->descriptorTypeCount; index++)
+                    {
+                        bufferBinding.stride = std::max<vk::DeviceSize>(bufferBinding.stride,
+                            m_Context.descriptorBuffer->getDescriptorSize(pMutableDescriptorTypeLists->pDescriptorTypes[index]));
+                    }
+                }
+                else
+                {
+                    bufferBinding.stride = m_Context.descriptorBuffer->getDescriptorSize(layoutBinding.descriptorType);
+                }
+            }
+        }
+
+        // push descriptor sets are not allocated from pools
+        if (usesPushDescriptors)
+            return vk::Result::eSuccess;
+
         // count the number of descriptors required per type
         std::unordered_map<vk::DescriptorType, uint32_t> poolSizeMap;
         for (auto layoutBinding : vulkanLayoutBindings)
@@ -269,9 +370,24 @@ namespace nvrhi::vulkan
             }
         }
 
+        // keep a stable order so that layouts with the same descriptor counts share pools, see DescriptorPoolAllocator
+        std::sort(descriptorPoolSizeInfo.begin(), descriptorPoolSizeInfo.end(),
+            [](const vk::DescriptorPoolSize& a, const vk::DescriptorPoolSize& b) { return a.type < b.type; });
+
         return vk::Result::eSuccess;
     }
 
+    uint32_t getMaxInlineUniformBlockBindings(const std::vector<vk::DescriptorPoolSize>& poolSizes)
+    {
+        for (const vk::DescriptorPoolSize& poolSize : poolSizes)
+        {
+            if (poolSize.type == vk::DescriptorType::eInlineUniformBlock)
+                return poolSize.descriptorCount / 4;
+        }
+
+        return 0;
+    }
+
     BindingLayout::~BindingLayout()
     {
         if (descriptorSetLayout)
@@ -303,39 +419,209 @@ namespace nvrhi::vulkan
         ret->desc = desc;
         ret->layout = layout;
 
-        const auto& descriptorSetLayout = layout->descriptorSetLayout;
-        const auto& poolSizes = layout->descriptorPoolSizeInfo;
+        vk::Result res;
 
-        // create descriptor pool to allocate a descriptor from
-        auto poolInfo = vk::DescriptorPoolCreateInfo()
-            .setPoolSizeCount(uint32_t(poolSizes.size()))
-            .setPPoolSizes(poolSizes.data())
-            .setMaxSets(1);
+        if (layout->usesPushDescriptors)
+        {
+            // The descriptors are written into the command buffers, nothing to allocate
+        }
+        else if (m_DescriptorBuffer)
+        {
+            if (layout->descriptorBufferSize > 0)
+            {
+                ret->descriptorBufferRange = m_DescriptorBuffer->allocate(layout->descriptorBufferSize);
+                if (!ret->descriptorBufferRange.isValid())
+                {
+                    m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                    delete ret;
+                    return nullptr;
+                }
+            }
+        }
+        else if (m_DescriptorPoolAllocator)
+        {
+            // allocate the descriptor set from a shared pool
+            res = m_DescriptorPoolAllocator->allocateDescriptorSet(layout, ret->descriptorPool, ret->descriptorSet);
+            CHECK_VK_FAIL(res)
 
-        vk::Result res = m_Context.device.createDescriptorPool(&poolInfo,
-                                                             m_Context.allocationCallbacks,
-                                                             &ret->descriptorPool);
-        CHECK_VK_FAIL(res)
+            ret->poolAllocator = m_DescriptorPoolAllocator.get();
+        }
+        else
+        {
+            const auto& descriptorSetLayout = layout->descriptorSetLayout;
+            const auto& poolSizes = layout->descriptorPoolSizeInfo;
+
+            auto inlineUniformBlockInfo = vk::DescriptorPoolInlineUniformBlockCreateInfoEXT()
+                .setMaxInlineUniformBlockBindings(getMaxInlineUniformBlockBindings(poolSizes));
+
+            // create descriptor pool to allocate a descriptor from
+            auto poolInfo = vk::DescriptorPoolCreateInfo()
+                .setPoolSizeCount(uint32_t(poolSizes.size()))
+                .setPPoolSizes(poolSizes.data())
+                .setMaxSets(1)
+                .setPNext(inlineUniformBlockInfo.maxInlineUniformBlockBindings ? &inlineUniformBlockInfo : nullptr);
+
+            res = m_Context.device.createDescriptorPool(&poolInfo,
+                                                      m_Context.allocationCallbacks,
+                                                      &ret->descriptorPool);
+            CHECK_VK_FAIL(res)
+
+            // create the descriptor set
+            auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
+                .setDescriptorPool(ret->descriptorPool)
+                .setDescriptorSetCount(1)
+                .setPSetLayouts(&descriptorSetLayout);
+
+            res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo,
+                &ret->descriptorSet);
+            CHECK_VK_FAIL(res)
+        }
         
-        // create the descriptor set
+        BindingSetWrites writes;
+        ret->writeDescriptors(writes);
+
+        return BindingSetHandle::Create(ret);
+    }
+
+    // Number of sets of the requesting layout that fit into a newly created transient descriptor pool
+    static constexpr uint32_t c_TransientDescriptorSetsPerPool = 256;
+
+    vk::Result CommandList::allocateTransientDescriptorSet(const BindingLayout* layout, vk::DescriptorSet& outSet)
+    {
+        auto& pools = m_CurrentCmdBuf->transientDescriptorPools;
+        size_t& poolIndex = m_CurrentCmdBuf->currentTransientDescriptorPool;
+
         auto descriptorSetAllocInfo = vk::DescriptorSetAllocateInfo()
-            .setDescriptorPool(ret->descriptorPool)
             .setDescriptorSetCount(1)
-            .setPSetLayouts(&descriptorSetLayout);
+            .setPSetLayouts(&layout->descriptorSetLayout);
+
+        // Allocate linearly: once a pool cannot fit a set, it is not revisited until the command buffer is retired
+        for (; poolIndex < pools.size(); poolIndex++)
+        {
+            descriptorSetAllocInfo.setDescriptorPool(pools[poolIndex]);
+
+            const vk::Result res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+            if (res == vk::Result::eSuccess)
+                return res;
+
+            if (res != vk::Result::eErrorOutOfPoolMemory && res != vk::Result::eErrorFragmentedPool)
+                return res;
+        }
+
+        std::vector<vk::DescriptorPoolSize> poolSizes = layout->descriptorPoolSizeInfo;
+        for (auto& poolSize : poolSizes)
+        {
+            poolSize.descriptorCount *= c_TransientDescriptorSetsPerPool;
+        }
+
+        auto inlineUniformBlockInfo = vk::DescriptorPoolInlineUniformBlockCreateInfoEXT()
+            .setMaxInlineUniformBlockBindings(getMaxInlineUniformBlockBindings(poolSizes));
+
+        auto poolInfo = vk::DescriptorPoolCreateInfo()
+            .setPoolSizeCount(uint32_t(poolSizes.size()))
+            .setPPoolSizes(poolSizes.data())
+            .setMaxSets(c_TransientDescriptorSetsPerPool)
+            .setPNext(inlineUniformBlockInfo.maxInlineUniformBlockBindings ? &inlineUniformBlockInfo : nullptr);
+
+        vk::DescriptorPool pool;
+        vk::Result res = m_Context.device.createDescriptorPool(&poolInfo, m_Context.allocationCallbacks, &pool);
+        CHECK_VK_RETURN(res)
+
+        pools.push_back(pool);
+        poolIndex = pools.size() - 1;
+
+        descriptorSetAllocInfo.setDescriptorPool(pool);
+        res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo, &outSet);
+        return res;
+    }
+
+    IBindingSet* CommandList::createTransientBindingSet(const BindingSetDesc& desc, IBindingLayout* _layout)
+    {
+        if (!m_CurrentCmdBuf)
+            return nullptr;
+
+        BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
+
+        // The set objects are owned by the command buffer and reused after it is retired,
+        // so that transient sets don't create objects or take references in the steady state
+        std::vector<BindingSetHandle>& transientBindingSets = m_CurrentCmdBuf->transientBindingSets;
+        if (m_CurrentCmdBuf->numTransientBindingSetsUsed == transientBindingSets.size())
+            transientBindingSets.push_back(BindingSetHandle::Create(new BindingSet(m_Context)));
+
+        BindingSet* bindingSet = checked_cast<BindingSet*>(transientBindingSets[m_CurrentCmdBuf->numTransientBindingSetsUsed].Get());
+
+        vk::DescriptorSet descriptorSet;
+        TlsfAllocator::Allocation descriptorBufferRange;
+
+        if (layout->usesPushDescriptors)
+        {
+            // The descriptors are written into the command buffer when the set is bound
+        }
+        else if (m_Context.descriptorBuffer)
+        {
+            // The range is released when the command buffer is retired
+            if (layout->descriptorBufferSize > 0)
+            {
+                descriptorBufferRange = m_Context.descriptorBuffer->allocate(layout->descriptorBufferSize);
+                if (!descriptorBufferRange.isValid())
+                {
+                    m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                    return nullptr;
+                }
+                m_CurrentCmdBuf->transientDescriptorBufferRanges.push_back(descriptorBufferRange);
+            }
+        }
+        else
+        {
+            const vk::Result res = allocateTransientDescriptorSet(layout, descriptorSet);
+            CHECK_VK_FAIL(res)
+        }
+
+        ++m_CurrentCmdBuf->numTransientBindingSetsUsed;
+
+        bindingSet->desc = desc;
+        // The command buffer keeps the set alive, binding it doesn't need to add a reference
+        bindingSet->desc.trackLiveness = false;
+        bindingSet->layout = layout;
+        bindingSet->descriptorSet = descriptorSet;
+        bindingSet->descriptorBufferRange = descriptorBufferRange;
+
+        bindingSet->writeDescriptors(m_TransientBindingSetWrites);
+
+        return bindingSet;
+    }
+
+    void BindingSetWrites::reset(size_t numBindings)
+    {
+        // The writes point into the other arrays, which must not be reallocated while they are collected
+        descriptorImageInfo.clear();
+        descriptorBufferInfo.clear();
+        descriptorWriteInfo.clear();
+        accelStructWriteInfo.clear();
+        texelBufferAddressInfo.clear();
+        inlineUniformBlockWriteInfo.clear();
+        descriptorImageInfo.reserve(numBindings);
+        descriptorBufferInfo.reserve(numBindings);
+        descriptorWriteInfo.reserve(numBindings);
+        accelStructWriteInfo.reserve(numBindings);
+        texelBufferAddressInfo.reserve(numBindings);
+        inlineUniformBlockWriteInfo.reserve(numBindings);
+    }
+
+    void BindingSet::writeDescriptors(BindingSetWrites& writes)
+    {
+        const BindingLayout* bindingLayout = checked_cast<const BindingLayout*>(layout.Get());
+
+        vk::Result res;
 
-        res = m_Context.device.allocateDescriptorSets(&descriptorSetAllocInfo,
-            &ret->descriptorSet);
-        CHECK_VK_FAIL(res)
-        
         // collect all of the descriptor write data
-        std::vector<vk::DescriptorImageInfo> descriptorImageInfo;
-        std::vector<vk::DescriptorBufferInfo> descriptorBufferInfo;
-        std::vector<vk::WriteDescriptorSet> descriptorWriteInfo;
-        std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> accelStructWriteInfo;
-        descriptorImageInfo.reserve(desc.bindings.size());
-        descriptorBufferInfo.reserve(desc.bindings.size());
-        descriptorWriteInfo.reserve(desc.bindings.size());
-        accelStructWriteInfo.reserve(desc.bindings.size());
+        writes.reset(desc.bindings.size());
+        std::vector<vk::DescriptorImageInfo>& descriptorImageInfo = writes.descriptorImageInfo;
+        std::vector<vk::DescriptorBufferInfo>& descriptorBufferInfo = writes.descriptorBufferInfo;
+        std::vector<vk::WriteDescriptorSet>& descriptorWriteInfo = writes.descriptorWriteInfo;
+        std::vector<vk::WriteDescriptorSetAccelerationStructureKHR>& accelStructWriteInfo = writes.accelStructWriteInfo;
+        std::vector<vk::DescriptorAddressInfoEXT>& texelBufferAddressInfo = writes.texelBufferAddressInfo;
+        std::vector<vk::WriteDescriptorSetInlineUniformBlockEXT>& inlineUniformBlockWriteInfo = writes.inlineUniformBlockWriteInfo;
 
         auto generateWriteDescriptorData =
             // generates a vk::WriteDescriptorSet struct in descriptorWriteInfo
@@ -349,7 +635,7 @@ namespace nvrhi::vulkan
         {
             descriptorWriteInfo.push_back(
                 vk::WriteDescriptorSet()
-                .setDstSet(ret->descriptorSet)
+                .setDstSet(descriptorSet)
                 .setDstBinding(bindingLocation)
                 .setDstArrayElement(arrayElement)
                 .setDescriptorCount(1)
@@ -365,15 +651,46 @@ namespace nvrhi::vulkan
         {
             const BindingSetItem& binding = desc.bindings[bindingIndex];
 
+            if (binding.type == ResourceType::InlineUniformBlock)
+            {
+                // The data is copied from desc, which the binding set keeps, so it can be referenced until the write
+                if (binding.range.byteOffset + binding.range.byteSize > desc.inlineUniformData.size())
+                {
+                    m_Context.error("The inline uniform block item refers to data outside of BindingSetDesc::inlineUniformData");
+                    continue;
+                }
+
+                auto& inlineUniformBlockWrite = inlineUniformBlockWriteInfo.emplace_back();
+                inlineUniformBlockWrite = vk::WriteDescriptorSetInlineUniformBlockEXT()
+                    .setDataSize(uint32_t(binding.range.byteSize))
+                    .setPData(desc.inlineUniformData.data() + binding.range.byteOffset);
+
+                // For inline uniform blocks, the array element and count are the byte offset and size of the update
+                descriptorWriteInfo.push_back(
+                    vk::WriteDescriptorSet()
+                    .setDstSet(descriptorSet)
+                    .setDstBinding(getRegisterOffsetForResourceType(bindingLayout->desc.bindingOffsets, binding.type) + binding.slot)
+                    .setDstArrayElement(0)
+                    .setDescriptorCount(uint32_t(binding.range.byteSize))
+                    .setDescriptorType(vk::DescriptorType::eInlineUniformBlock)
+                    .setPNext(&inlineUniformBlockWrite)
+                );
+
+                continue;
+            }
+
             if (binding.resourceHandle == nullptr)
             {
                 continue;
             }
 
-            ret->resources.push_back(binding.resourceHandle); // keep a strong reference to the resource
+            resources.push_back(binding.resourceHandle); // keep a strong reference to the resource
+
+            vk::DescriptorType descriptorType = convertResourceType(binding.type);
+            uint32_t const registerOffset = getRegisterOffsetForResourceType(bindingLayout->desc.bindingOffsets, binding.type);
 
-            vk::DescriptorType const descriptorType = convertResourceType(binding.type);
-            uint32_t const registerOffset = getRegisterOffsetForResourceType(layout->desc.bindingOffsets, binding.type);
+            if (bindingLayout->usesPushDescriptors && descriptorType == vk::DescriptorType::eUniformBufferDynamic)
+                descriptorType = vk::DescriptorType::eUniformBuffer;
             
             switch (binding.type)
             {
@@ -397,7 +714,7 @@ namespace nvrhi::vulkan
                     &imageInfo, nullptr, nullptr);
 
                 if (!texture->permanentState)
-                    ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                    bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                 else
                     verifyPermanentResourceState(texture->permanentState,
                         ResourceStates::ShaderResource,
@@ -426,7 +743,7 @@ namespace nvrhi::vulkan
                     &imageInfo, nullptr, nullptr);
 
                 if (!texture->permanentState)
-                    ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                    bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                 else
                     verifyPermanentResourceState(texture->permanentState,
                         ResourceStates::UnorderedAccess,
@@ -476,14 +793,25 @@ namespace nvrhi::vulkan
                     ASSERT_VK_OK(res);
                 }
 
+                // Descriptor buffers take the address of the range instead of a view, see DescriptorBufferAllocator::writeDescriptors
+                vk::DescriptorAddressInfoEXT* addressInfo = nullptr;
+                if (m_Context.descriptorBuffer)
+                {
+                    addressInfo = &texelBufferAddressInfo.emplace_back();
+                    *addressInfo = vk::DescriptorAddressInfoEXT()
+                        .setAddress(buffer->deviceAddress + range.byteOffset)
+                        .setRange(range.byteSize)
+                        .setFormat(vk::Format(vkformat));
+                }
+
                 generateWriteDescriptorData(
                     registerOffset + binding.slot,
                     binding.arrayElement,
                     descriptorType,
-                    nullptr, nullptr, &bufferViewRef);
+                    nullptr, nullptr, &bufferViewRef, addressInfo);
 
                 if (!buffer->permanentState)
-                    ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                    bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                 else
                     verifyPermanentResourceState(buffer->permanentState, 
                         isUAV ? ResourceStates::UnorderedAccess : ResourceStates::ShaderResource,
@@ -525,12 +853,21 @@ namespace nvrhi::vulkan
                 if (binding.type == ResourceType::VolatileConstantBuffer) 
                 {
                     assert(buffer->desc.isVolatile);
-                    ret->volatileConstantBuffers.push_back(buffer);
+                    volatileConstantBuffers.push_back(buffer);
+
+                    if (bindingLayout->usesPushDescriptors)
+                        pushVolatileBufferInfoIndices.push_back(uint32_t(descriptorBufferInfo.size() - 1));
+
+                    if (m_Context.descriptorBuffer)
+                    {
+                        const auto& bufferBinding = bindingLayout->descriptorBufferBindings.at(registerOffset + binding.slot);
+                        volatileConstantBufferDescriptorOffsets.push_back(bufferBinding.offset + binding.arrayElement * bufferBinding.stride);
+                    }
                 }
                 else
                 {
                     if (!buffer->permanentState)
-                        ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                        bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
                     else
                     {
                         ResourceStates requiredState;
@@ -580,7 +917,7 @@ namespace nvrhi::vulkan
                     descriptorType,
                     nullptr, nullptr, nullptr, &accelStructWrite);
 
-                ret->bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
+                bindingsThatNeedTransitions.push_back(static_cast<uint16_t>(bindingIndex));
             }
 
             break;
@@ -603,7 +940,7 @@ namespace nvrhi::vulkan
             case ResourceType::StructuredBuffer_UAV:
             case ResourceType::RawBuffer_UAV:
             case ResourceType::SamplerFeedbackTexture_UAV:
-                ret->hasUavBindings = true;
+                hasUavBindings = true;
                 break;
             default:
                 break;
@@ -611,14 +948,51 @@ namespace nvrhi::vulkan
 
         }
 
-        m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+        if (bindingLayout->usesPushDescriptors)
+        {
+            // Swapping the arrays keeps the pointers in the writes valid, and the scratch space gets the old arrays' memory
+            pushDescriptorWrites.swap(descriptorWriteInfo);
+            pushImageInfos.swap(descriptorImageInfo);
+            pushBufferInfos.swap(descriptorBufferInfo);
+            pushAccelStructInfos.swap(accelStructWriteInfo);
+        }
+        else if (m_Context.descriptorBuffer)
+            m_Context.descriptorBuffer->writeDescriptors(bindingLayout, descriptorBufferRange.offset, descriptorWriteInfo.data(), descriptorWriteInfo.size());
+        else
+            m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
+    }
 
-        return BindingSetHandle::Create(ret);
+    void BindingSet::resetTransient()
+    {
+        descriptorSet = vk::DescriptorSet();
+        descriptorBufferRange = TlsfAllocator::Allocation();
+        layout = nullptr;
+        resources.clear();
+        volatileConstantBuffers.resize(0);
+        volatileConstantBufferDescriptorOffsets.resize(0);
+        pushDescriptorWrites.clear();
+        pushImageInfos.clear();
+        pushBufferInfos.clear();
+        pushAccelStructInfos.clear();
+        pushVolatileBufferInfoIndices.resize(0);
+        bindingsThatNeedTransitions.clear();
+        hasUavBindings = false;
     }
 
     BindingSet::~BindingSet()
     {
-        if (descriptorPool)
+        if (descriptorBufferRange.isValid())
+        {
+            m_Context.descriptorBuffer->release(descriptorBufferRange);
+            descriptorBufferRange = TlsfAllocator::Allocation();
+        }
+        else if (poolAllocator)
+        {
+            poolAllocator->releaseDescriptorSet(checked_cast<BindingLayout*>(layout.Get()), descriptorPool, descriptorSet);
+            descriptorPool = vk::DescriptorPool();
+            descriptorSet = vk::DescriptorSet();
+        }
+        else if (descriptorPool)
         {
             m_Context.device.destroyDescriptorPool(descriptorPool, m_Context.allocationCallbacks);
             descriptorPool = vk::DescriptorPool();
@@ -639,12 +1013,32 @@ namespace nvrhi::vulkan
         }
     }
 
+    // Size of the descriptor buffer range that holds the first 'capacity' elements of every binding of a bindless layout.
+    // The binding offsets are fixed by the layout, so a smaller table just ends earlier.
+    static vk::DeviceSize getDescriptorTableBufferSize(const BindingLayout* layout, uint32_t capacity)
+    {
+        vk::DeviceSize size = 0;
+        for (const auto& [bindingIndex, bufferBinding] : layout->descriptorBufferBindings)
+        {
+            size = std::max(size, bufferBinding.offset + bufferBinding.stride * capacity);
+        }
+        return size;
+    }
+
     DescriptorTableHandle Device::createDescriptorTable(IBindingLayout* _layout)
     { 
         BindingLayout* layout = checked_cast<BindingLayout*>(_layout);
 
         DescriptorTable* ret = new DescriptorTable(m_Context);
         ret->layout = layout;
+
+        if (m_DescriptorBuffer)
+        {
+            // The range is allocated by resizeDescriptorTable
+            ret->capacity = 0;
+            return DescriptorTableHandle::Create(ret);
+        }
+
         ret->capacity = layout->vulkanLayoutBindings[0].descriptorCount;
 
         const auto& descriptorSetLayout = layout->descriptorSetLayout;
@@ -656,6 +1050,9 @@ namespace nvrhi::vulkan
             .setPPoolSizes(poolSizes.data())
             .setMaxSets(1);
 
+        if (layout->updateAfterBind)
+            poolInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
+
         vk::Result res = m_Context.device.createDescriptorPool(&poolInfo,
                                                              m_Context.allocationCallbacks,
                                                              &ret->descriptorPool);
@@ -676,6 +1073,12 @@ namespace nvrhi::vulkan
 
     DescriptorTable::~DescriptorTable()
     {
+        if (descriptorBufferRange.isValid())
+        {
+            m_Context.descriptorBuffer->release(descriptorBufferRange);
+            descriptorBufferRange = TlsfAllocator::Allocation();
+        }
+
         if (descriptorPool)
         {
             m_Context.device.destroyDescriptorPool(descriptorPool, m_Context.allocationCallbacks);
@@ -699,17 +1102,91 @@ namespace nvrhi::vulkan
 
     void Device::resizeDescriptorTable(IDescriptorTable* _descriptorTable, uint32_t newSize, bool keepContents)
     {
-        assert(newSize <= checked_cast<DescriptorTable*>(_descriptorTable)->layout->getBindlessDesc()->maxCapacity);
-        (void)_descriptorTable;
-        (void)newSize;
-        (void)keepContents;
+        DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
+        assert(newSize <= descriptorTable->layout->getBindlessDesc()->maxCapacity);
+
+        // Descriptor sets are always allocated with the maximum capacity
+        if (!m_DescriptorBuffer)
+            return;
+
+        if (newSize == descriptorTable->capacity)
+            return;
+
+        const BindingLayout* layout = checked_cast<const BindingLayout*>(descriptorTable->layout.Get());
+        const vk::DeviceSize oldRangeSize = getDescriptorTableBufferSize(layout, descriptorTable->capacity);
+        const vk::DeviceSize newRangeSize = getDescriptorTableBufferSize(layout, newSize);
+
+        TlsfAllocator::Allocation newRange;
+        if (newRangeSize > 0)
+        {
+            newRange = m_DescriptorBuffer->allocate(newRangeSize);
+            if (!newRange.isValid())
+            {
+                m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                return;
+            }
+        }
+
+        if (keepContents && descriptorTable->descriptorBufferRange.isValid() && newRange.isValid())
+        {
+            memcpy(m_DescriptorBuffer->getMappedMemory(newRange.offset),
+                m_DescriptorBuffer->getMappedMemory(descriptorTable->descriptorBufferRange.offset),
+                std::min(oldRangeSize, newRangeSize));
+        }
+
+        // The old range may still be used by the work submitted so far
+        m_DescriptorBuffer->release(descriptorTable->descriptorBufferRange);
+
+        descriptorTable->descriptorBufferRange = newRange;
+        descriptorTable->capacity = newSize;
+    }
+
+    void DescriptorTableWrites::reserve(size_t numItems)
+    {
+        // The writes point into the other arrays, which must not be reallocated while they are collected
+        const size_t maxWrites = numItems * c_MaxBindlessRegisterSpaces;
+        descriptorImageInfo.reserve(maxWrites);
+        descriptorBufferInfo.reserve(maxWrites);
+        descriptorWriteInfo.reserve(maxWrites);
+        texelBufferAddressInfo.reserve(maxWrites);
     }
 
     bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem& binding)
+    {
+        return writeDescriptorTable(_descriptorTable, &binding, 1);
+    }
+
+    bool Device::writeDescriptorTable(IDescriptorTable* _descriptorTable, const BindingSetItem* items, size_t numItems)
     {
         DescriptorTable* descriptorTable = checked_cast<DescriptorTable*>(_descriptorTable);
         BindingLayout* layout = checked_cast<BindingLayout*>(descriptorTable->layout.Get());
 
+        DescriptorTableWrites writes;
+        writes.reserve(numItems);
+
+        bool success = true;
+        for (size_t index = 0; index < numItems; index++)
+        {
+            if (!collectDescriptorTableWrites(descriptorTable, items[index], writes))
+                success = false;
+        }
+
+        // All items go into a single update
+        if (writes.descriptorWriteInfo.empty())
+            return success;
+
+        if (m_DescriptorBuffer)
+            m_DescriptorBuffer->writeDescriptors(layout, descriptorTable->descriptorBufferRange.offset, writes.descriptorWriteInfo.data(), writes.descriptorWriteInfo.size());
+        else
+            m_Context.device.updateDescriptorSets(uint32_t(writes.descriptorWriteInfo.size()), writes.descriptorWriteInfo.data(), 0, nullptr);
+
+        return success;
+    }
+
+    bool Device::collectDescriptorTableWrites(DescriptorTable* descriptorTable, const BindingSetItem& binding, DescriptorTableWrites& writes)
+    {
+        BindingLayout* layout = checked_cast<BindingLayout*>(descriptorTable->layout.Get());
+
         if (binding.slot >= descriptorTable->capacity)
             return false;
 
@@ -720,9 +1197,10 @@ namespace nvrhi::vulkan
         }
 
         // collect all of the descriptor write data
-        static_vector<vk::DescriptorImageInfo, c_MaxBindlessRegisterSpaces> descriptorImageInfo;
-        static_vector<vk::DescriptorBufferInfo, c_MaxBindlessRegisterSpaces> descriptorBufferInfo;
-        static_vector<vk::WriteDescriptorSet, c_MaxBindlessRegisterSpaces> descriptorWriteInfo;
+        std::vector<vk::DescriptorImageInfo>& descriptorImageInfo = writes.descriptorImageInfo;
+        std::vector<vk::DescriptorBufferInfo>& descriptorBufferInfo = writes.descriptorBufferInfo;
+        std::vector<vk::WriteDescriptorSet>& descriptorWriteInfo = writes.descriptorWriteInfo;
+        std::vector<vk::DescriptorAddressInfoEXT>& texelBufferAddressInfo = writes.texelBufferAddressInfo;
 
         auto generateWriteDescriptorData =
             // generates a vk::WriteDescriptorSet struct in descriptorWriteInfo
@@ -730,7 +1208,8 @@ namespace nvrhi::vulkan
                 vk::DescriptorType descriptorType,
                 vk::DescriptorImageInfo* imageInfo,
                 vk::DescriptorBufferInfo* bufferInfo,
-                vk::BufferView* bufferView)
+                vk::BufferView* bufferView,
+                const void* pNext = nullptr)
         {
             descriptorWriteInfo.push_back(
                 vk::WriteDescriptorSet()
@@ -742,6 +1221,7 @@ namespace nvrhi::vulkan
                 .setPImageInfo(imageInfo)
                 .setPBufferInfo(bufferInfo)
                 .setPTexelBufferView(bufferView)
+                .setPNext(pNext)
             );
         };
 
@@ -816,9 +1296,20 @@ namespace nvrhi::vulkan
                     ASSERT_VK_OK(res);
                 }
 
+                // Descriptor buffers take the address of the range instead of a view, see DescriptorBufferAllocator::writeDescriptors
+                vk::DescriptorAddressInfoEXT* addressInfo = nullptr;
+                if (m_DescriptorBuffer)
+                {
+                    addressInfo = &texelBufferAddressInfo.emplace_back();
+                    *addressInfo = vk::DescriptorAddressInfoEXT()
+                        .setAddress(buffer->deviceAddress + range.byteOffset)
+                        .setRange(range.byteSize)
+                        .setFormat(vk::Format(vkformat));
+                }
+
                 generateWriteDescriptorData(layoutBinding.binding,
                     convertResourceType(binding.type),
-                    nullptr, nullptr, &bufferViewRef);
+                    nullptr, nullptr, &bufferViewRef, addressInfo);
             }
             break;
 
@@ -865,6 +1356,7 @@ namespace nvrhi::vulkan
                 break;
 
             case ResourceType::PushConstants:
+            case ResourceType::InlineUniformBlock:
                 utils::NotSupported();
                 break;
 
@@ -894,19 +1386,37 @@ namespace nvrhi::vulkan
             }
         }
 
-        m_Context.device.updateDescriptorSets(uint32_t(descriptorWriteInfo.size()), descriptorWriteInfo.data(), 0, nullptr);
-
         return true;
     }
 
     void CommandList::bindBindingSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx)
     {
+        if (m_Context.descriptorBuffer)
+        {
+            bindDescriptorBufferOffsets(bindPoint, pipelineLayout, bindings, descriptorSetIdxToBindingIdx);
+            return;
+        }
+
         const uint32_t numBindings = (uint32_t)bindings.size();
         const uint32_t numDescriptorSets = descriptorSetIdxToBindingIdx.empty() ? numBindings : (uint32_t)descriptorSetIdxToBindingIdx.size();
 
         BindingVector<vk::DescriptorSet> descriptorSets;
         uint32_t nextDescriptorSetToBind = 0;
         static_vector<uint32_t, c_MaxVolatileConstantBuffers> dynamicOffsets;
+
+        auto bindContiguousDescriptorSets = [&]()
+        {
+            if (!descriptorSets.empty())
+            {
+                m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
+                    /* firstSet = */ nextDescriptorSetToBind, uint32_t(descriptorSets.size()), descriptorSets.data(),
+                    uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+
+                descriptorSets.resize(0);
+                dynamicOffsets.resize(0);
+            }
+        };
+
         for (uint32_t i = 0; i < numDescriptorSets; ++i)
         {
             IBindingSet* bindingSetHandle = nullptr;
@@ -922,29 +1432,31 @@ namespace nvrhi::vulkan
             if (bindingSetHandle == nullptr)
             {
                 // This is a hole in the descriptor sets, so bind the contiguous descriptor sets we've got so far
-                if (!descriptorSets.empty())
-                {
-                    m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
-                        /* firstSet = */ nextDescriptorSetToBind, uint32_t(descriptorSets.size()), descriptorSets.data(),
-                        uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
-
-                    descriptorSets.resize(0);
-                    dynamicOffsets.resize(0);
-                }
+                bindContiguousDescriptorSets();
                 nextDescriptorSetToBind = i + 1;
             }
             else
             {
                 const BindingSetDesc* desc = bindingSetHandle->getDesc();
-                if (desc)
+                BindingSet* bindingSet = desc ? checked_cast<BindingSet*>(bindingSetHandle) : nullptr;
+                if (bindingSet && checked_cast<BindingLayout*>(bindingSet->layout.Get())->usesPushDescriptors)
+                {
+                    // The pushed set also splits the bound sets
+                    bindContiguousDescriptorSets();
+                    pushDescriptorSet(bindPoint, pipelineLayout, i, bindingSet);
+                    nextDescriptorSetToBind = i + 1;
+
+                    if (desc->trackLiveness)
+                        m_CurrentCmdBuf->referencedResources.push_back(bindingSetHandle);
+                }
+                else if (bindingSet)
                 {
-                    BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
                     descriptorSets.push_back(bindingSet->descriptorSet);
 
                     for (Buffer* constantBuffer : bindingSet->volatileConstantBuffers)
                     {
-                        auto found = m_VolatileBufferStates.find(constantBuffer);
-                        if (found == m_VolatileBufferStates.end())
+                        const VolatileBufferState* volatileState = getVolatileBufferState(constantBuffer, false);
+                        if (!volatileState)
                         {
                             std::stringstream ss;
                             ss << "Binding volatile constant buffer " << utils::DebugNameToString(constantBuffer->desc.debugName)
@@ -955,7 +1467,7 @@ namespace nvrhi::vulkan
                         }
                         else
                         {
-                            uint32_t version = found->second.latestVersion;
+                            uint32_t version = volatileState->latestVersion;
                             uint64_t offset = version * constantBuffer->desc.byteSize;
                             assert(offset < std::numeric_limits<uint32_t>::max());
                             dynamicOffsets.push_back(uint32_t(offset));
@@ -972,13 +1484,170 @@ namespace nvrhi::vulkan
                 }
             }
         }
-        if (!descriptorSets.empty())
+
+        // Bind the remaining sets
+        bindContiguousDescriptorSets();
+    }
+
+    void CommandList::pushDescriptorSet(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, uint32_t set, const BindingSet* bindingSet)
+    {
+        if (bindingSet->pushDescriptorWrites.empty())
+            return;
+
+        const vk::WriteDescriptorSet* writes = bindingSet->pushDescriptorWrites.data();
+
+        if (!bindingSet->volatileConstantBuffers.empty())
         {
-            // Bind the remaining sets
-            m_CurrentCmdBuf->cmdBuf.bindDescriptorSets(bindPoint, pipelineLayout,
-                /* firstSet = */ nextDescriptorSetToBind, uint32_t(descriptorSets.size()), descriptorSets.data(),
-                uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+            // Patch the current versions of the volatile buffers into copies of the buffer infos
+            m_PushDescriptorBufferInfos.assign(bindingSet->pushBufferInfos.begin(), bindingSet->pushBufferInfos.end());
+
+            for (size_t index = 0; index < bindingSet->volatileConstantBuffers.size(); index++)
+            {
+                Buffer* constantBuffer = bindingSet->volatileConstantBuffers[index];
+                const VolatileBufferState* volatileState = getVolatileBufferState(constantBuffer, false);
+                if (!volatileState)
+                {
+                    std::stringstream ss;
+                    ss << "Binding volatile constant buffer " << utils::DebugNameToString(constantBuffer->desc.debugName)
+                        << " before writing into it is invalid.";
+                    m_Context.error(ss.str());
+                    continue;
+                }
+
+                m_PushDescriptorBufferInfos[bindingSet->pushVolatileBufferInfoIndices[index]]
+                    .setOffset(vk::DeviceSize(volatileState->latestVersion) * constantBuffer->desc.byteSize);
+            }
+
+            m_PushDescriptorWrites.assign(bindingSet->pushDescriptorWrites.begin(), bindingSet->pushDescriptorWrites.end());
+            for (vk::WriteDescriptorSet& write : m_PushDescriptorWrites)
+            {
+                if (write.pBufferInfo)
+                    write.pBufferInfo = m_PushDescriptorBufferInfos.data() + (write.pBufferInfo - bindingSet->pushBufferInfos.data());
+            }
+
+            writes = m_PushDescriptorWrites.data();
         }
+
+        m_CurrentCmdBuf->cmdBuf.pushDescriptorSetKHR(bindPoint, pipelineLayout, set,
+            uint32_t(bindingSet->pushDescriptorWrites.size()), writes);
+    }
+
+    void CommandList::bindDescriptorBufferOffsets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, const BindingSetVector& bindings, BindingVector<uint32_t> const& descriptorSetIdxToBindingIdx)
+    {
+        DescriptorBufferAllocator* descriptorBuffer = m_Context.descriptorBuffer;
+
+        if (!m_DescriptorBufferBound)
+        {
+            const vk::DescriptorBufferBindingInfoEXT bindingInfo = descriptorBuffer->getBindingInfo();
+            m_CurrentCmdBuf->cmdBuf.bindDescriptorBuffersEXT(1, &bindingInfo);
+            m_DescriptorBufferBound = true;
+        }
+
+        const uint32_t numBindings = (uint32_t)bindings.size();
+        const uint32_t numDescriptorSets = descriptorSetIdxToBindingIdx.empty() ? numBindings : (uint32_t)descriptorSetIdxToBindingIdx.size();
+
+        // All sets come from the same buffer at index 0
+        BindingVector<uint32_t> bufferIndices;
+        BindingVector<vk::DeviceSize> offsets;
+        uint32_t nextDescriptorSetToBind = 0;
+
+        auto setOffsets = [&]()
+        {
+            if (offsets.empty())
+                return;
+
+            m_CurrentCmdBuf->cmdBuf.setDescriptorBufferOffsetsEXT(bindPoint, pipelineLayout,
+                /* firstSet = */ nextDescriptorSetToBind, uint32_t(offsets.size()), bufferIndices.data(), offsets.data());
+
+            bufferIndices.resize(0);
+            offsets.resize(0);
+        };
+
+        for (uint32_t i = 0; i < numDescriptorSets; ++i)
+        {
+            IBindingSet* bindingSetHandle = nullptr;
+            if (descriptorSetIdxToBindingIdx.empty())
+            {
+                bindingSetHandle = bindings[i];
+            }
+            else if (descriptorSetIdxToBindingIdx[i] != 0xffffffff)
+            {
+                bindingSetHandle = bindings[descriptorSetIdxToBindingIdx[i]];
+            }
+
+            if (bindingSetHandle == nullptr)
+            {
+                // This is a hole in the descriptor sets, set the contiguous offsets we've got so far
+                setOffsets();
+                nextDescriptorSetToBind = i + 1;
+                continue;
+            }
+
+            vk::DeviceSize offset;
+
+            const BindingSetDesc* desc = bindingSetHandle->getDesc();
+            if (desc)
+            {
+                BindingSet* bindingSet = checked_cast<BindingSet*>(bindingSetHandle);
+                offset = bindingSet->descriptorBufferRange.offset;
+
+                if (!bindingSet->volatileConstantBuffers.empty())
+                {
+                    // There are no dynamic offsets with descriptor buffers, so bind a copy of the set
+                    // that points at the current versions of the volatile buffers instead
+                    const BindingLayout* layout = checked_cast<const BindingLayout*>(bindingSet->layout.Get());
+                    TlsfAllocator::Allocation copy = descriptorBuffer->allocate(layout->descriptorBufferSize);
+
+                    if (!copy.isValid())
+                    {
+                        m_Context.error("The descriptor buffer is full, increase DeviceDesc::descriptorBufferSize");
+                    }
+                    else
+                    {
+                        memcpy(descriptorBuffer->getMappedMemory(copy.offset), descriptorBuffer->getMappedMemory(offset), layout->descriptorBufferSize);
+
+                        for (size_t index = 0; index < bindingSet->volatileConstantBuffers.size(); index++)
+                        {
+                            Buffer* constantBuffer = bindingSet->volatileConstantBuffers[index];
+
+                            uint64_t version = 0; // use the first version just to use something
+                            const VolatileBufferState* volatileState = getVolatileBufferState(constantBuffer, false);
+                            if (!volatileState)
+                            {
+                                std::stringstream ss;
+                                ss << "Binding volatile constant buffer " << utils::DebugNameToString(constantBuffer->desc.debugName)
+                                    << " before writing into it is invalid.";
+                                m_Context.error(ss.str());
+                            }
+                            else
+                            {
+                                version = volatileState->latestVersion;
+                            }
+
+                            descriptorBuffer->writeUniformBufferDescriptor(copy.offset + bindingSet->volatileConstantBufferDescriptorOffsets[index],
+                                constantBuffer->deviceAddress + version * constantBuffer->desc.byteSize, constantBuffer->desc.byteSize);
+                        }
+
+                        m_CurrentCmdBuf->transientDescriptorBufferRanges.push_back(copy);
+                        offset = copy.offset;
+                    }
+                }
+
+                if (desc->trackLiveness)
+                    m_CurrentCmdBuf->referencedResources.push_back(bindingSetHandle);
+            }
+            else
+            {
+                DescriptorTable* table = checked_cast<DescriptorTable*>(bindingSetHandle);
+                offset = table->descriptorBufferRange.offset;
+            }
+
+            bufferIndices.push_back(0);
+            offsets.push_back(offset);
+        }
+
+        // Set the remaining offsets
+        setOffsets();
     }
 
     vk::Result createPipelineLayout(
@@ -1062,11 +1731,15 @@ namespace nvrhi::vulkan
 
         BindingVector<vk::DescriptorSetLayout> descriptorSetLayouts;
         uint32_t pushConstantSize = 0;
+        uint32_t numPushDescriptorSets = 0;
         outPushConstantVisibility = vk::ShaderStageFlagBits();
         for (BindingLayout const* layout : outBindingLayouts)
         {
             if (layout)
             {
+                if (layout->usesPushDescriptors)
+                    ++numPushDescriptorSets;
+
                 descriptorSetLayouts.push_back(layout->descriptorSetLayout);
 
                 if (!layout->isBindless)
@@ -1090,6 +1763,13 @@ namespace nvrhi::vulkan
             }
         }
 
+        if (numPushDescriptorSets > 1)
+        {
+            // Vulkan allows only one push descriptor set layout per pipeline layout
+            context.error("A pipeline can use at most one binding layout with push descriptors");
+            return vk::Result::eErrorInitializationFailed;
+        }
+
         auto pushConstantRange = vk::PushConstantRange()
             .setOffset(0)
             .setSize(pushConstantSize)
@@ -22,6 +22,7 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <optional>
 
 namespace nvrhi::vulkan
 {
@@ -66,16 +67,33 @@ namespace nvrhi::vulkan
         assert(constants);
         assert(numConstants != 0);
 
+        // The constants of a specialization replace those of its base, so the key uses the original shader.
+        // Equal specializations then get the same object, which lets pipeline deduplication find their pipelines.
+        IResource* originalShader = (baseShader->baseShader) ? baseShader->baseShader.Get() : baseShader;
+        std::optional<ShaderSpecializationKey> key;
+        if (m_Deduplication)
+        {
+            key.emplace(originalShader, constants, numConstants);
+
+            if (ShaderHandle existing = m_Deduplication->shaderSpecializations.find(*key))
+                return existing;
+        }
+
         Shader* newShader = new Shader(m_Context);
 
         // Hold a strong reference to the parent object
-        newShader->baseShader = (baseShader->baseShader) ? baseShader->baseShader : baseShader;
+        newShader->baseShader = originalShader;
         newShader->desc = baseShader->desc;
         newShader->shaderModule = baseShader->shaderModule;
         newShader->stageFlagBits = baseShader->stageFlagBits;
         newShader->specializationConstants.assign(constants, constants + numConstants);
 
-        return ShaderHandle::Create(newShader);
+        ShaderHandle handle = ShaderHandle::Create(newShader);
+
+        if (key)
+            handle = m_Deduplication->shaderSpecializations.insert(*key, handle);
+
+        return handle;
     }
 
 
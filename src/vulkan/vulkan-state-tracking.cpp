@@ -22,6 +22,8 @@
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
+#include <nvrhi/utils.h>
+#include <sstream>
 
 namespace nvrhi::vulkan
 {
@@ -128,6 +130,11 @@ namespace nvrhi::vulkan
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
 
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentGraphicsState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
         m_BindingStatesDirty = false;
     }
 
@@ -142,6 +149,11 @@ namespace nvrhi::vulkan
             requireBufferState(indirectParams, ResourceStates::IndirectArgument);
         }
 
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentComputeState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
         m_BindingStatesDirty = false;
     }
 
@@ -159,6 +171,11 @@ namespace nvrhi::vulkan
             requireBufferState(state.indirectParams, ResourceStates::IndirectArgument);
         }
 
+        if (state.indirectCountBuffer && (m_BindingStatesDirty || state.indirectCountBuffer != m_CurrentMeshletState.indirectCountBuffer))
+        {
+            requireBufferState(state.indirectCountBuffer, ResourceStates::IndirectArgument);
+        }
+
         m_BindingStatesDirty = false;
     }
 
@@ -169,10 +186,25 @@ namespace nvrhi::vulkan
         m_BindingStatesDirty = false;
     }
 
+    static void reportBundleStateConflict(const VulkanContext& context, const std::string& debugName)
+    {
+        std::stringstream ss;
+        ss << "Resource " << utils::DebugNameToString(debugName) << " is used in different states within the same "
+            "bundle, which requires a barrier that cannot be placed in a bundle";
+        context.error(ss.str());
+    }
+
     void CommandList::requireTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates state)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
 
+        if (m_CommandListParameters.isBundle)
+        {
+            if (!m_BundleStateRequirements.requireTextureState(texture, subresources, state))
+                reportBundleStateConflict(m_Context, texture->desc.debugName);
+            return;
+        }
+
         m_StateTracker.requireTextureState(texture, subresources, state);
     }
 
@@ -180,6 +212,13 @@ namespace nvrhi::vulkan
     {
         Buffer* buffer = checked_cast<Buffer*>(_buffer);
 
+        if (m_CommandListParameters.isBundle)
+        {
+            if (!m_BundleStateRequirements.requireBufferState(buffer, state))
+                reportBundleStateConflict(m_Context, buffer->desc.debugName);
+            return;
+        }
+
         m_StateTracker.requireBufferState(buffer, state);
     }
 
@@ -195,11 +234,20 @@ namespace nvrhi::vulkan
         vk::PipelineStageFlags beforeStageFlags = vk::PipelineStageFlags(0);
         vk::PipelineStageFlags afterStageFlags = vk::PipelineStageFlags(0);
 
+        // Split barriers need synchronization2, so only the ends of split transitions are executed here, as regular barriers
+
         for (const TextureBarrier& barrier : m_StateTracker.getTextureBarriers())
         {
+            if (barrier.split == SplitBarrier::Begin)
+                continue;
+
             ResourceStateMapping before = convertResourceState(barrier.stateBefore, true);
             ResourceStateMapping after = convertResourceState(barrier.stateAfter, true);
 
+            // Transitions of discarded textures start from the Unknown state, which has no stages
+            if (!before.stageFlags)
+                before.stageFlags = vk::PipelineStageFlagBits::eTopOfPipe;
+
             if ((before.stageFlags != beforeStageFlags || after.stageFlags != afterStageFlags) && !imageBarriers.empty())
             {
                 m_CurrentCmdBuf->cmdBuf.pipelineBarrier(beforeStageFlags, afterStageFlags,
@@ -224,9 +272,9 @@ namespace nvrhi::vulkan
 
             vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
                 .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
-                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
+                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : barrier.numArraySlices)
                 .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
-                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
+                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : barrier.numMipLevels)
                 .setAspectMask(aspectMask);
 
             imageBarriers.push_back(vk::ImageMemoryBarrier()
@@ -252,6 +300,9 @@ namespace nvrhi::vulkan
 
         for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
         {
+            if (barrier.split == SplitBarrier::Begin)
+                continue;
+
             ResourceStateMapping before = convertResourceState(barrier.stateBefore, false);
             ResourceStateMapping after = convertResourceState(barrier.stateAfter, false);
 
@@ -288,11 +339,78 @@ namespace nvrhi::vulkan
         m_StateTracker.clearBarriers();
     }
 
+    vk::Event CommandList::allocateSplitBarrierEvent()
+    {
+        auto& events = m_CurrentCmdBuf->splitBarrierEvents;
+        size_t& numUsed = m_CurrentCmdBuf->numSplitBarrierEventsUsed;
+
+        if (numUsed == events.size())
+        {
+            auto eventInfo = vk::EventCreateInfo();
+
+            vk::Event event;
+            const vk::Result res = m_Context.device.createEvent(&eventInfo, m_Context.allocationCallbacks, &event);
+            if (res != vk::Result::eSuccess)
+                return vk::Event();
+
+            events.push_back(event);
+        }
+
+        return events[numUsed++];
+    }
+
     void CommandList::commitBarriersInternal_synchronization2()
     {
         std::vector<vk::ImageMemoryBarrier2> imageBarriers;
         std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
 
+        // Split barriers are executed through events: the ends are waited for before the regular barriers,
+        // and the beginnings are set after them. The tracker guarantees that this preserves the order
+        // of the transitions of any single resource.
+        struct SplitBarrierInfo
+        {
+            vk::Event event;
+            bool isBegin = false;
+            bool isImage = false;
+            vk::ImageMemoryBarrier2 imageBarrier;
+            vk::BufferMemoryBarrier2 bufferBarrier;
+        };
+        std::vector<SplitBarrierInfo> splitBarriers;
+
+        // Returns false if the barrier has to be executed as a regular one
+        auto addSplitBarrier = [this, &splitBarriers](SplitBarrier split, const void* resource, SplitBarrierInfo& info)
+        {
+            if (split == SplitBarrier::None)
+                return false;
+
+            // Events are not reset between the executions of a reusable command buffer,
+            // so only the ends of its split transitions are executed, as regular barriers
+            if (m_CommandListParameters.reusable)
+                return split == SplitBarrier::Begin;
+
+            if (split == SplitBarrier::Begin)
+            {
+                info.event = allocateSplitBarrierEvent();
+                if (!info.event)
+                    return false;
+
+                m_SplitBarrierEvents[resource] = info.event;
+            }
+            else
+            {
+                auto found = m_SplitBarrierEvents.find(resource);
+                if (found == m_SplitBarrierEvents.end())
+                    return false;
+
+                info.event = found->second;
+                m_SplitBarrierEvents.erase(found);
+            }
+
+            info.isBegin = split == SplitBarrier::Begin;
+            splitBarriers.push_back(info);
+            return true;
+        };
+
         for (const TextureBarrier& barrier : m_StateTracker.getTextureBarriers())
         {
             ResourceStateMapping2 before = convertResourceState2(barrier.stateBefore, true);
@@ -311,12 +429,12 @@ namespace nvrhi::vulkan
 
             vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange()
                 .setBaseArrayLayer(barrier.entireTexture ? 0 : barrier.arraySlice)
-                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : 1)
+                .setLayerCount(barrier.entireTexture ? texture->desc.arraySize : barrier.numArraySlices)
                 .setBaseMipLevel(barrier.entireTexture ? 0 : barrier.mipLevel)
-                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : 1)
+                .setLevelCount(barrier.entireTexture ? texture->desc.mipLevels : barrier.numMipLevels)
                 .setAspectMask(aspectMask);
 
-            imageBarriers.push_back(vk::ImageMemoryBarrier2()
+            auto imageBarrier = vk::ImageMemoryBarrier2()
                 .setSrcAccessMask(before.accessMask)
                 .setDstAccessMask(after.accessMask)
                 .setSrcStageMask(before.stageFlags)
@@ -326,19 +444,16 @@ namespace nvrhi::vulkan
                 .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setImage(texture->image)
-                .setSubresourceRange(subresourceRange));
-        }
+                .setSubresourceRange(subresourceRange);
 
-        if (!imageBarriers.empty())
-        {
-            vk::DependencyInfo dep_info;
-            dep_info.setImageMemoryBarriers(imageBarriers);
+            SplitBarrierInfo splitInfo;
+            splitInfo.isImage = true;
+            splitInfo.imageBarrier = imageBarrier;
 
-            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
+            if (!addSplitBarrier(barrier.split, barrier.texture, splitInfo))
+                imageBarriers.push_back(imageBarrier);
         }
 
-        imageBarriers.clear();
-
         for (const BufferBarrier& barrier : m_StateTracker.getBufferBarriers())
         {
             ResourceStateMapping2 before = convertResourceState2(barrier.stateBefore, false);
@@ -346,7 +461,7 @@ namespace nvrhi::vulkan
 
             Buffer* buffer = static_cast<Buffer*>(barrier.buffer);
 
-            bufferBarriers.push_back(vk::BufferMemoryBarrier2()
+            auto bufferBarrier = vk::BufferMemoryBarrier2()
                 .setSrcAccessMask(before.accessMask)
                 .setDstAccessMask(after.accessMask)
                 .setSrcStageMask(before.stageFlags)
@@ -355,9 +470,53 @@ namespace nvrhi::vulkan
                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
                 .setBuffer(buffer->buffer)
                 .setOffset(0)
-                .setSize(buffer->desc.byteSize));
+                .setSize(buffer->desc.byteSize);
+
+            SplitBarrierInfo splitInfo;
+            splitInfo.bufferBarrier = bufferBarrier;
+
+            if (!addSplitBarrier(barrier.split, barrier.buffer, splitInfo))
+                bufferBarriers.push_back(bufferBarrier);
+        }
+
+        // The dependency infos passed to waitEvents2 must match the ones used in setEvent2,
+        // which they do because both halves are converted from the same pair of states
+        auto getSplitDependencyInfo = [](const SplitBarrierInfo& info)
+        {
+            vk::DependencyInfo dep_info;
+            if (info.isImage)
+                dep_info.setImageMemoryBarriers(info.imageBarrier);
+            else
+                dep_info.setBufferMemoryBarriers(info.bufferBarrier);
+            return dep_info;
+        };
+
+        std::vector<vk::Event> waitEvents;
+        std::vector<vk::DependencyInfo> waitDependencyInfos;
+        for (const SplitBarrierInfo& info : splitBarriers)
+        {
+            if (info.isBegin)
+                continue;
+
+            waitEvents.push_back(info.event);
+            waitDependencyInfos.push_back(getSplitDependencyInfo(info));
+        }
+
+        if (!waitEvents.empty())
+        {
+            m_CurrentCmdBuf->cmdBuf.waitEvents2(waitEvents, waitDependencyInfos);
+        }
+
+        if (!imageBarriers.empty())
+        {
+            vk::DependencyInfo dep_info;
+            dep_info.setImageMemoryBarriers(imageBarriers);
+
+            m_CurrentCmdBuf->cmdBuf.pipelineBarrier2(dep_info);
         }
 
+        imageBarriers.clear();
+
         if (!bufferBarriers.empty())
         {
             vk::DependencyInfo dep_info;
@@ -367,6 +526,15 @@ namespace nvrhi::vulkan
         }
         bufferBarriers.clear();
 
+        for (const SplitBarrierInfo& info : splitBarriers)
+        {
+            if (!info.isBegin)
+                continue;
+
+            vk::DependencyInfo dep_info = getSplitDependencyInfo(info);
+            m_CurrentCmdBuf->cmdBuf.setEvent2(info.event, dep_info);
+        }
+
         m_StateTracker.clearBarriers();
     }
 
@@ -401,6 +569,33 @@ namespace nvrhi::vulkan
         m_StateTracker.beginTrackingBufferState(buffer, stateBits);
     }
 
+    void CommandList::aliasingBarrier(IResource* resourceBefore, IResource* resourceAfter)
+    {
+        assert(m_CurrentCmdBuf);
+
+        endRenderPass();
+        commitBarriers();
+
+        // Vulkan has no dedicated aliasing barriers: order all accesses to the previous resource before
+        // any accesses to the new one through a global memory barrier
+        auto memoryBarrier = vk::MemoryBarrier()
+            .setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands,
+            vk::DependencyFlags(), { memoryBarrier }, {}, {});
+
+        // The new texture's contents are undefined, so its next transition can start from the undefined layout.
+        // Transitions from the undefined layout are the Vulkan equivalent of the discard that D3D12 needs here.
+        if (resourceAfter && resourceAfter->getNativeObject(ObjectTypes::VK_Image) != nullptr)
+            m_StateTracker.discardTextureContents(checked_cast<Texture*>(resourceAfter));
+
+        if (resourceBefore)
+            m_CurrentCmdBuf->referencedResources.push_back(resourceBefore);
+        if (resourceAfter)
+            m_CurrentCmdBuf->referencedResources.push_back(resourceAfter);
+    }
+
     void CommandList::setTextureState(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
@@ -455,6 +650,26 @@ namespace nvrhi::vulkan
             m_CurrentCmdBuf->referencedResources.push_back(buffer);
     }
 
+    void CommandList::beginTextureStateTransition(ITexture* _texture, TextureSubresourceSet subresources, ResourceStates stateBits)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+
+        m_StateTracker.beginTextureStateTransition(texture, subresources, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(texture);
+    }
+
+    void CommandList::beginBufferStateTransition(IBuffer* _buffer, ResourceStates stateBits)
+    {
+        Buffer* buffer = checked_cast<Buffer*>(_buffer);
+
+        m_StateTracker.beginBufferStateTransition(buffer, stateBits);
+
+        if (m_CurrentCmdBuf)
+            m_CurrentCmdBuf->referencedResources.push_back(buffer);
+    }
+
     ResourceStates CommandList::getTextureSubresourceState(ITexture* _texture, ArraySlice arraySlice, MipLevel mipLevel)
     {
         Texture* texture = checked_cast<Texture*>(_texture);
@@ -488,4 +703,46 @@ namespace nvrhi::vulkan
         m_StateTracker.setEnableUavBarriersForBuffer(buffer, enableBarriers);
     }
 
+    void CommandList::recordStateHandoffBarriers(const StateHandoffResolver& resolver)
+    {
+        m_StateTracker.addBarriers(resolver.getTextureBarriers(), resolver.getBufferBarriers());
+        commitBarriers();
+    }
+
+    void Device::resolveStateHandoff(ICommandList* const* pCommandLists, size_t numCommandLists, CommandQueue executionQueue)
+    {
+        auto& handoffCommandLists = m_StateHandoffCommandLists[uint32_t(executionQueue)];
+        size_t numHandoffCommandLists = 0;
+
+        m_StateHandoffSubmission.clear();
+
+        // Records the barriers produced by the resolver into an internal command list and adds it to the submission
+        auto submitHandoffBarriers = [this, &handoffCommandLists, &numHandoffCommandLists, executionQueue]()
+        {
+            if (numHandoffCommandLists == handoffCommandLists.size())
+                handoffCommandLists.push_back(createCommandList(CommandListParameters().setQueueType(executionQueue)));
+
+            CommandList* commandList = checked_cast<CommandList*>(handoffCommandLists[numHandoffCommandLists++].Get());
+            commandList->open();
+            commandList->recordStateHandoffBarriers(*m_StateHandoffResolver);
+            commandList->close();
+
+            m_StateHandoffResolver->clearBarriers();
+            m_StateHandoffSubmission.push_back(commandList);
+        };
+
+        for (size_t i = 0; i < numCommandLists; i++)
+        {
+            CommandList* commandList = checked_cast<CommandList*>(pCommandLists[i]);
+
+            if (m_StateHandoffResolver->resolveCommandList(commandList->getStateTracker()))
+                submitHandoffBarriers();
+
+            m_StateHandoffSubmission.push_back(commandList);
+        }
+
+        if (m_StateHandoffResolver->restoreInitialStates())
+            submitHandoffBarriers();
+    }
+
 } // namespace nvrhi::vulkan
@@ -0,0 +1,158 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vulkan-backend.h"
+#include <nvrhi/common/misc.h>
+#include <sstream>
+
+namespace nvrhi::vulkan
+{
+    extern vk::ImageAspectFlags guessImageAspectFlags(vk::Format format);
+
+    // Reads the files on the CPU like the common storage queue, and decompresses GDeflate data
+    // on the GPU with VK_NV_memory_decompression
+    class StorageQueue : public nvrhi::StorageQueue
+    {
+    public:
+        StorageQueue(IDevice* device, const StorageQueueDesc& desc)
+            : nvrhi::StorageQueue(device, desc)
+        { }
+
+    protected:
+        [[nodiscard]] bool isCompressionSupported(StorageCompression) const override { return true; }
+
+        void recordDecompression(ICommandList* commandList, const StorageRequest& request, const void* compressedData) override
+        {
+            checked_cast<CommandList*>(commandList)->decompressStorageRequest(request, compressedData);
+        }
+    };
+
+    StorageQueueHandle Device::createStorageQueue(const StorageQueueDesc& desc)
+    {
+        if (queryFeatureSupport(Feature::GpuDecompression))
+            return StorageQueueHandle::Create(new StorageQueue(this, desc));
+
+        return StorageQueueHandle::Create(new nvrhi::StorageQueue(this, desc));
+    }
+
+    void CommandList::decompressStorageRequest(const StorageRequest& request, const void* compressedData)
+    {
+        endRenderPass();
+
+        assert(m_CurrentCmdBuf);
+
+        const uint64_t currentVersion = MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false);
+
+        Buffer* uploadBuffer = nullptr;
+        uint64_t uploadOffset = 0;
+        void* uploadCpuVA = nullptr;
+        if (!m_UploadManager->suballocateBuffer(request.sourceSize, &uploadBuffer, &uploadOffset, &uploadCpuVA, currentVersion))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer for a storage request");
+            return;
+        }
+
+        memcpy(uploadCpuVA, compressedData, request.sourceSize);
+
+        // Buffers are decompressed in place, textures through scratch memory that is then copied into the image
+        Buffer* destBuffer = nullptr;
+        uint64_t destOffset = 0;
+        if (request.destBuffer)
+        {
+            destBuffer = checked_cast<Buffer*>(request.destBuffer);
+            destOffset = request.destOffset;
+
+            if (m_EnableAutomaticBarriers)
+                requireBufferState(destBuffer, ResourceStates::CopyDest);
+
+            m_CurrentCmdBuf->referencedResources.push_back(destBuffer);
+        }
+        else if (!m_ScratchManager->suballocateBuffer(request.uncompressedSize, &destBuffer, &destOffset, nullptr,
+            currentVersion, c_StorageTextureRowPitchAlignment))
+        {
+            std::stringstream ss;
+            ss << "Couldn't suballocate a scratch buffer for a storage request. The request requires "
+                << request.uncompressedSize << " bytes of scratch space.";
+            m_Context.error(ss.str());
+            return;
+        }
+
+        commitBarriers();
+
+        // Decompression doesn't run in one of the stages that the resource states map to,
+        // so order it against the surrounding commands with full memory barriers.
+        const auto memoryBarrier = vk::MemoryBarrier()
+            .setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands,
+            vk::DependencyFlags(), 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        const auto region = vk::DecompressMemoryRegionNV()
+            .setSrcAddress(uploadBuffer->deviceAddress + uploadOffset)
+            .setDstAddress(destBuffer->deviceAddress + destOffset)
+            .setCompressedSize(request.sourceSize)
+            .setDecompressedSize(request.uncompressedSize)
+            .setDecompressionMethod(vk::MemoryDecompressionMethodFlagBitsNV::eGdeflate10);
+
+        m_CurrentCmdBuf->cmdBuf.decompressMemoryNV(1, &region);
+
+        m_CurrentCmdBuf->cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands,
+            vk::DependencyFlags(), 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        if (!request.destTexture)
+            return;
+
+        Texture* dest = checked_cast<Texture*>(request.destTexture);
+
+        const StorageTextureLayout layout = getStorageTextureLayout(dest->desc, request.mipLevel);
+        const FormatInfo& formatInfo = getFormatInfo(dest->desc.format);
+
+        const auto imageCopy = vk::BufferImageCopy()
+            .setBufferOffset(destOffset)
+            .setBufferRowLength(uint32_t(layout.rowPitch / formatInfo.bytesPerBlock) * formatInfo.blockSize)
+            .setBufferImageHeight(layout.numRows * formatInfo.blockSize)
+            .setImageSubresource(vk::ImageSubresourceLayers()
+                .setAspectMask(guessImageAspectFlags(dest->imageInfo.format))
+                .setMipLevel(request.mipLevel)
+                .setBaseArrayLayer(request.arraySlice)
+                .setLayerCount(1))
+            .setImageExtent(vk::Extent3D()
+                .setWidth(std::max(dest->desc.width >> request.mipLevel, 1u))
+                .setHeight(std::max(dest->desc.height >> request.mipLevel, 1u))
+                .setDepth(layout.depth));
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(dest, TextureSubresourceSet(request.mipLevel, 1, request.arraySlice, 1), ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_CurrentCmdBuf->referencedResources.push_back(dest);
+
+        m_CurrentCmdBuf->cmdBuf.copyBufferToImage(destBuffer->buffer,
+            dest->image, vk::ImageLayout::eTransferDstOptimal,
+            1, &imageCopy);
+    }
+
+} // namespace nvrhi::vulkan
@@ -21,6 +21,7 @@
 */
 
 #include <algorithm>
+#include <sstream>
 
 #include "vulkan-backend.h"
 #include <nvrhi/common/misc.h>
@@ -102,6 +103,14 @@ namespace nvrhi::vulkan
     static vk::ImageUsageFlags pickImageUsage(const TextureDesc& d)
     {
         const FormatInfo& formatInfo = getFormatInfo(d.format);
+
+        // Transient attachments can only have the attachment usages
+        if (d.isTransientAttachment)
+        {
+            return vk::ImageUsageFlagBits::eTransientAttachment | ((formatInfo.hasDepth || formatInfo.hasStencil)
+                ? vk::ImageUsageFlagBits::eDepthStencilAttachment
+                : vk::ImageUsageFlagBits::eColorAttachment);
+        }
         
         vk::ImageUsageFlags ret = vk::ImageUsageFlagBits::eTransferSrc |
                                   vk::ImageUsageFlagBits::eTransferDst;
@@ -260,8 +269,7 @@ namespace nvrhi::vulkan
         Format format, vk::ImageUsageFlags usage, TextureSubresourceViewType viewtype)
     {
         // This function is called from createBindingSet etc. and therefore free-threaded.
-        // It modifies the subresourceViews map associated with the texture.
-        std::lock_guard lockGuard(m_Mutex);
+        // The subresourceViews cache is read without locking and only locks to create a view.
 
         if (dimension == TextureDimension::Unknown)
             dimension = desc.dimension;
@@ -274,56 +282,69 @@ namespace nvrhi::vulkan
         if (!desc.isTypeless)
             usage = vk::ImageUsageFlags(0);
 
-        auto cachekey = std::make_tuple(subresource, viewtype, dimension, format, usage);
-        auto iter = subresourceViews.find(cachekey);
-        if (iter != subresourceViews.end())
+        // The sampled view of the whole texture is by far the most common one, return it without hashing the key
+        const vk::ImageUsageFlags defaultUsage = desc.isTypeless ? vk::ImageUsageFlags(vk::ImageUsageFlagBits::eSampled) : vk::ImageUsageFlags(0);
+        const bool isDefaultView = viewtype == TextureSubresourceViewType::AllAspects
+            && dimension == desc.dimension
+            && format == desc.format
+            && usage == defaultUsage
+            && subresource.isEntireTexture(desc);
+
+        if (isDefaultView)
         {
-            return iter->second;
+            if (TextureSubresourceView* defaultView = m_DefaultView.load(std::memory_order_acquire))
+                return *defaultView;
         }
 
-        auto iter_pair = subresourceViews.emplace(cachekey, *this);
-        auto& view = std::get<0>(iter_pair)->second;
+        const auto cachekey = std::make_tuple(subresource, viewtype, dimension, format, usage);
+
+        TextureSubresourceView& result = subresourceViews.getOrCreate(cachekey, subresourceViews.hash(cachekey),
+            [&](TextureSubresourceView& view)
+            {
+                view.subresource = subresource;
 
-        view.subresource = subresource;
+                auto vkFormat = nvrhi::vulkan::convertFormat(format);
 
-        auto vkFormat = nvrhi::vulkan::convertFormat(format);
+                vk::ImageAspectFlags aspectFlags = guessSubresourceImageAspectFlags(vk::Format(vkFormat), viewtype);
+                view.subresourceRange = vk::ImageSubresourceRange()
+                                            .setAspectMask(aspectFlags)
+                                            .setBaseMipLevel(subresource.baseMipLevel)
+                                            .setLevelCount(subresource.numMipLevels)
+                                            .setBaseArrayLayer(subresource.baseArraySlice)
+                                            .setLayerCount(subresource.numArraySlices);
 
-        vk::ImageAspectFlags aspectFlags = guessSubresourceImageAspectFlags(vk::Format(vkFormat), viewtype);
-        view.subresourceRange = vk::ImageSubresourceRange()
-                                    .setAspectMask(aspectFlags)
-                                    .setBaseMipLevel(subresource.baseMipLevel)
-                                    .setLevelCount(subresource.numMipLevels)
-                                    .setBaseArrayLayer(subresource.baseArraySlice)
-                                    .setLayerCount(subresource.numArraySlices);
+                vk::ImageViewType imageViewType = textureDimensionToImageViewType(dimension);
 
-        vk::ImageViewType imageViewType = textureDimensionToImageViewType(dimension);
+                auto viewInfo = vk::ImageViewCreateInfo()
+                                .setImage(image)
+                                .setViewType(imageViewType)
+                                .setFormat(vk::Format(vkFormat))
+                                .setSubresourceRange(view.subresourceRange);
 
-        auto viewInfo = vk::ImageViewCreateInfo()
-                        .setImage(image)
-                        .setViewType(imageViewType)
-                        .setFormat(vk::Format(vkFormat))
-                        .setSubresourceRange(view.subresourceRange);
+                auto usageInfo = vk::ImageViewUsageCreateInfo()
+                                .setUsage(usage);
 
-        auto usageInfo = vk::ImageViewUsageCreateInfo()
-                        .setUsage(usage);
+                if (uint32_t(usage) != 0)
+                    viewInfo.setPNext(&usageInfo);
 
-        if (uint32_t(usage) != 0)
-            viewInfo.setPNext(&usageInfo);
+                if (viewtype == TextureSubresourceViewType::StencilOnly)
+                {
+                    // D3D / HLSL puts stencil values in the second component to keep the illusion of combined depth/stencil.
+                    // Set a component swizzle so we appear to do the same.
+                    viewInfo.components.setG(vk::ComponentSwizzle::eR);
+                }
 
-        if (viewtype == TextureSubresourceViewType::StencilOnly)
-        {
-            // D3D / HLSL puts stencil values in the second component to keep the illusion of combined depth/stencil.
-            // Set a component swizzle so we appear to do the same.
-            viewInfo.components.setG(vk::ComponentSwizzle::eR);
-        }
+                const vk::Result res = m_Context.device.createImageView(&viewInfo, m_Context.allocationCallbacks, &view.view);
+                ASSERT_VK_OK(res);
 
-        const vk::Result res = m_Context.device.createImageView(&viewInfo, m_Context.allocationCallbacks, &view.view);
-        ASSERT_VK_OK(res);
+                const std::string debugName = std::string("ImageView for: ") + utils::DebugNameToString(desc.debugName);
+                m_Context.nameVKObject(VkImageView(view.view), vk::ObjectType::eImageView, vk::DebugReportObjectTypeEXT::eImageView, debugName.c_str());
+            }, *this);
 
-        const std::string debugName = std::string("ImageView for: ") + utils::DebugNameToString(desc.debugName);
-        m_Context.nameVKObject(VkImageView(view.view), vk::ObjectType::eImageView, vk::DebugReportObjectTypeEXT::eImageView, debugName.c_str());
+        if (isDefaultView)
+            m_DefaultView.store(&result, std::memory_order_release);
 
-        return view;
+        return result;
     }
 
     TextureHandle Device::createTexture(const TextureDesc& desc)
@@ -332,6 +353,9 @@ namespace nvrhi::vulkan
         assert(texture);
         fillTextureInfo(texture, desc);
 
+        if ((m_DeferredDestructionFlags & DeferredDestructionFlags::Textures) != 0)
+            texture->setDestructionQueue(&m_DeferredDestruction);
+
         vk::Result res = m_Context.device.createImage(&texture->imageInfo, m_Context.allocationCallbacks, &texture->image);
         ASSERT_VK_OK(res);
         CHECK_VK_FAIL(res)
@@ -353,7 +377,8 @@ namespace nvrhi::vulkan
 #endif
             }
 
-            m_Context.nameVKObject(texture->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
+            if (!texture->isSuballocated())
+                m_Context.nameVKObject(texture->memory, vk::ObjectType::eDeviceMemory, vk::DebugReportObjectTypeEXT::eDeviceMemory, desc.debugName.c_str());
         }
 
         return TextureHandle::Create(texture);
@@ -471,56 +496,204 @@ namespace nvrhi::vulkan
             *depthOut = depth;
     }
 
-    void CommandList::writeTexture(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    void CommandList::writeTexture(ITexture* dest, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
     {
+        if (!beginTextureWrite(dest, arraySlice, mipLevel, nullptr, nullptr))
+            return;
+
+        const PendingTextureWrite& write = m_PendingTextureWrites.back();
+
+        size_t minRowPitch = std::min(size_t(write.rowPitch), rowPitch);
+        uint8_t* mappedPtr = (uint8_t*)write.cpuVA;
+        for (uint32_t slice = 0; slice < write.extent.depth; slice++)
+        {
+            const uint8_t* sourcePtr = (const uint8_t*)data + depthPitch * slice;
+            for (uint32_t row = 0; row < write.numRows; row++)
+            {
+                memcpy(mappedPtr, sourcePtr, minRowPitch);
+                mappedPtr += write.rowPitch;
+                sourcePtr += rowPitch;
+            }
+        }
+
+        endTextureWrite(dest, arraySlice, mipLevel);
+    }
+
+    void CommandList::writeTextureSubresources(ITexture* _dest, const TextureSubresourceData* subresources, size_t numSubresources)
+    {
+        if (numSubresources == 0)
+            return;
+
         endRenderPass();
 
         Texture* dest = checked_cast<Texture*>(_dest);
 
-        TextureDesc desc = dest->getDesc();
+        const TextureDesc& desc = dest->desc;
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
 
-        uint32_t mipWidth, mipHeight, mipDepth;
-        computeMipLevelInformation(desc, mipLevel, &mipWidth, &mipHeight, &mipDepth);
+        // Lay out all subresources in one upload buffer block with tightly packed rows
+        constexpr uint64_t subresourceAlignment = 256;
+        uint64_t deviceMemSize = 0;
+        for (size_t i = 0; i < numSubresources; i++)
+        {
+            uint32_t mipWidth, mipHeight, mipDepth;
+            computeMipLevelInformation(desc, subresources[i].mipLevel, &mipWidth, &mipHeight, &mipDepth);
 
-        const FormatInfo& formatInfo = getFormatInfo(desc.format);
-        uint32_t deviceNumCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
-        uint32_t deviceNumRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
-        uint32_t deviceRowPitch = deviceNumCols * formatInfo.bytesPerBlock;
-        uint64_t deviceMemSize = uint64_t(deviceRowPitch) * uint64_t(deviceNumRows) * mipDepth;
+            uint32_t deviceNumCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            uint32_t deviceNumRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+            deviceMemSize = align(deviceMemSize, subresourceAlignment);
+            deviceMemSize += uint64_t(deviceNumCols) * formatInfo.bytesPerBlock * deviceNumRows * mipDepth;
+        }
+
+        assert(m_CurrentCmdBuf);
 
         Buffer* uploadBuffer;
         uint64_t uploadOffset;
         void* uploadCpuVA;
-        m_UploadManager->suballocateBuffer(
+        if (!m_UploadManager->suballocateBuffer(
             deviceMemSize,
             &uploadBuffer,
             &uploadOffset,
             &uploadCpuVA,
-            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false));
+            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false)))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return;
+        }
 
-        size_t minRowPitch = std::min(size_t(deviceRowPitch), rowPitch);
-        uint8_t* mappedPtr = (uint8_t*)uploadCpuVA;
-        for (uint32_t slice = 0; slice < mipDepth; slice++)
+        const vk::ImageAspectFlags aspectMask = guessImageAspectFlags(dest->imageInfo.format);
+
+        m_BufferImageCopies.clear();
+        uint64_t offset = 0;
+        for (size_t i = 0; i < numSubresources; i++)
         {
-            const uint8_t* sourcePtr = (const uint8_t*)data + depthPitch * slice;
-            for (uint32_t row = 0; row < deviceNumRows; row++)
+            const TextureSubresourceData& subresource = subresources[i];
+
+            uint32_t mipWidth, mipHeight, mipDepth;
+            computeMipLevelInformation(desc, subresource.mipLevel, &mipWidth, &mipHeight, &mipDepth);
+
+            uint32_t deviceNumCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            uint32_t deviceNumRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+            uint32_t deviceRowPitch = deviceNumCols * formatInfo.bytesPerBlock;
+
+            offset = align(offset, subresourceAlignment);
+
+            size_t minRowPitch = std::min(size_t(deviceRowPitch), subresource.rowPitch);
+            uint8_t* mappedPtr = (uint8_t*)uploadCpuVA + offset;
+            for (uint32_t slice = 0; slice < mipDepth; slice++)
             {
-                memcpy(mappedPtr, sourcePtr, minRowPitch);
-                mappedPtr += deviceRowPitch;
-                sourcePtr += rowPitch;
+                const uint8_t* sourcePtr = (const uint8_t*)subresource.data + subresource.depthPitch * slice;
+                for (uint32_t row = 0; row < deviceNumRows; row++)
+                {
+                    memcpy(mappedPtr, sourcePtr, minRowPitch);
+                    mappedPtr += deviceRowPitch;
+                    sourcePtr += subresource.rowPitch;
+                }
+            }
+
+            m_BufferImageCopies.push_back(vk::BufferImageCopy()
+                .setBufferOffset(uploadOffset + offset)
+                .setBufferRowLength(deviceNumCols * formatInfo.blockSize)
+                .setBufferImageHeight(deviceNumRows * formatInfo.blockSize)
+                .setImageSubresource(vk::ImageSubresourceLayers()
+                    .setAspectMask(aspectMask)
+                    .setMipLevel(subresource.mipLevel)
+                    .setBaseArrayLayer(subresource.arraySlice)
+                    .setLayerCount(1))
+                .setImageExtent(vk::Extent3D().setWidth(mipWidth).setHeight(mipHeight).setDepth(mipDepth)));
+
+            offset += uint64_t(deviceRowPitch) * deviceNumRows * mipDepth;
+        }
+
+        if (m_EnableAutomaticBarriers)
+        {
+            for (size_t i = 0; i < numSubresources; i++)
+            {
+                requireTextureState(dest, TextureSubresourceSet(subresources[i].mipLevel, 1, subresources[i].arraySlice, 1), ResourceStates::CopyDest);
             }
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        m_CurrentCmdBuf->referencedResources.push_back(dest);
+
+        m_CurrentCmdBuf->cmdBuf.copyBufferToImage(uploadBuffer->buffer,
+            dest->image, vk::ImageLayout::eTransferDstOptimal,
+            uint32_t(m_BufferImageCopies.size()), m_BufferImageCopies.data());
+    }
+
+    void* CommandList::beginTextureWrite(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel, size_t* outRowPitch, size_t* outDepthPitch)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        TextureDesc desc = dest->getDesc();
+
+        uint32_t mipWidth, mipHeight, mipDepth;
+        computeMipLevelInformation(desc, mipLevel, &mipWidth, &mipHeight, &mipDepth);
+
+        const FormatInfo& formatInfo = getFormatInfo(desc.format);
+
+        PendingTextureWrite write;
+        write.dest = dest;
+        write.arraySlice = arraySlice;
+        write.mipLevel = mipLevel;
+        write.numCols = (mipWidth + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        write.numRows = (mipHeight + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        write.rowPitch = write.numCols * formatInfo.bytesPerBlock;
+        write.extent = vk::Extent3D().setWidth(mipWidth).setHeight(mipHeight).setDepth(mipDepth);
+
+        uint64_t deviceMemSize = uint64_t(write.rowPitch) * uint64_t(write.numRows) * mipDepth;
+
+        assert(m_CurrentCmdBuf);
+
+        if (!m_UploadManager->suballocateBuffer(
+            deviceMemSize,
+            &write.uploadBuffer,
+            &write.uploadOffset,
+            &write.cpuVA,
+            MakeVersion(m_CurrentCmdBuf->recordingID, m_CommandListParameters.queueType, false)))
+        {
+            m_Context.error("Couldn't suballocate an upload buffer");
+            return nullptr;
         }
 
+        if (outRowPitch)
+            *outRowPitch = write.rowPitch;
+        if (outDepthPitch)
+            *outDepthPitch = size_t(write.rowPitch) * write.numRows;
+
+        m_PendingTextureWrites.push_back(write);
+        return write.cpuVA;
+    }
+
+    void CommandList::endTextureWrite(ITexture* _dest, uint32_t arraySlice, uint32_t mipLevel)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+
+        auto it = std::find_if(m_PendingTextureWrites.begin(), m_PendingTextureWrites.end(), [dest, arraySlice, mipLevel](const PendingTextureWrite& write)
+            { return write.dest == dest && write.arraySlice == arraySlice && write.mipLevel == mipLevel; });
+
+        if (it == m_PendingTextureWrites.end())
+            return; // let the validation layer report it
+
+        const PendingTextureWrite write = *it;
+        m_PendingTextureWrites.erase(it);
+
+        endRenderPass();
+
+        const FormatInfo& formatInfo = getFormatInfo(dest->desc.format);
+
         auto imageCopy = vk::BufferImageCopy()
-            .setBufferOffset(uploadOffset)
-            .setBufferRowLength(deviceNumCols * formatInfo.blockSize)
-            .setBufferImageHeight(deviceNumRows * formatInfo.blockSize)
+            .setBufferOffset(write.uploadOffset)
+            .setBufferRowLength(write.numCols * formatInfo.blockSize)
+            .setBufferImageHeight(write.numRows * formatInfo.blockSize)
             .setImageSubresource(vk::ImageSubresourceLayers()
                 .setAspectMask(guessImageAspectFlags(dest->imageInfo.format))
                 .setMipLevel(mipLevel)
                 .setBaseArrayLayer(arraySlice)
                 .setLayerCount(1))
-            .setImageExtent(vk::Extent3D().setWidth(mipWidth).setHeight(mipHeight).setDepth(mipDepth));
+            .setImageExtent(write.extent);
 
         assert(m_CurrentCmdBuf);
 
@@ -533,7 +706,7 @@ namespace nvrhi::vulkan
 
         m_CurrentCmdBuf->referencedResources.push_back(dest);
 
-        m_CurrentCmdBuf->cmdBuf.copyBufferToImage(uploadBuffer->buffer,
+        m_CurrentCmdBuf->cmdBuf.copyBufferToImage(write.uploadBuffer->buffer,
             dest->image, vk::ImageLayout::eTransferDstOptimal,
             1, &imageCopy);
     }
@@ -581,6 +754,133 @@ namespace nvrhi::vulkan
         m_CurrentCmdBuf->cmdBuf.resolveImage(src->image, vk::ImageLayout::eTransferSrcOptimal, dest->image, vk::ImageLayout::eTransferDstOptimal, regions);
     }
 
+    static bool checkBlitFormat(const VulkanContext& context, const TextureDesc& desc, vk::FormatFeatureFlags requiredFeatures, const char* operation)
+    {
+        const vk::FormatProperties properties = context.physicalDevice.getFormatProperties(vk::Format(convertFormat(desc.format)));
+
+        if ((properties.optimalTilingFeatures & requiredFeatures) != requiredFeatures)
+        {
+            std::stringstream ss;
+            ss << operation << ": the format of texture " << utils::DebugNameToString(desc.debugName)
+                << " does not support the blit or linear filtering features required by this operation";
+            context.error(ss.str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void CommandList::generateMips(ITexture* _texture, TextureSubresourceSet subresources, bool linearFilter)
+    {
+        Texture* texture = checked_cast<Texture*>(_texture);
+        const TextureDesc& desc = texture->desc;
+
+        subresources = subresources.resolve(desc, false);
+
+        if (subresources.numMipLevels < 2)
+            return;
+
+        vk::FormatFeatureFlags requiredFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst;
+        if (linearFilter)
+            requiredFeatures |= vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+        if (!checkBlitFormat(m_Context, desc, requiredFeatures, "generateMips"))
+            return;
+
+        assert(m_CurrentCmdBuf);
+
+        endRenderPass();
+
+        m_CurrentCmdBuf->referencedResources.push_back(texture);
+
+        for (MipLevel mipLevel = subresources.baseMipLevel + 1; mipLevel < subresources.baseMipLevel + subresources.numMipLevels; mipLevel++)
+        {
+            // Each level is read after it has been written, so these transitions are placed
+            // even when automatic barriers are disabled
+            requireTextureState(texture, TextureSubresourceSet(mipLevel - 1, 1, subresources.baseArraySlice, subresources.numArraySlices), ResourceStates::CopySource);
+            requireTextureState(texture, TextureSubresourceSet(mipLevel, 1, subresources.baseArraySlice, subresources.numArraySlices), ResourceStates::CopyDest);
+            commitBarriers();
+
+            const auto imageBlit = vk::ImageBlit()
+                .setSrcSubresource(vk::ImageSubresourceLayers()
+                    .setAspectMask(vk::ImageAspectFlagBits::eColor)
+                    .setMipLevel(mipLevel - 1)
+                    .setBaseArrayLayer(subresources.baseArraySlice)
+                    .setLayerCount(subresources.numArraySlices))
+                .setSrcOffsets({ vk::Offset3D(0, 0, 0), vk::Offset3D(
+                    int32_t(std::max(desc.width >> (mipLevel - 1), 1u)),
+                    int32_t(std::max(desc.height >> (mipLevel - 1), 1u)), 1) })
+                .setDstSubresource(vk::ImageSubresourceLayers()
+                    .setAspectMask(vk::ImageAspectFlagBits::eColor)
+                    .setMipLevel(mipLevel)
+                    .setBaseArrayLayer(subresources.baseArraySlice)
+                    .setLayerCount(subresources.numArraySlices))
+                .setDstOffsets({ vk::Offset3D(0, 0, 0), vk::Offset3D(
+                    int32_t(std::max(desc.width >> mipLevel, 1u)),
+                    int32_t(std::max(desc.height >> mipLevel, 1u)), 1) });
+
+            m_CurrentCmdBuf->cmdBuf.blitImage(texture->image, vk::ImageLayout::eTransferSrcOptimal,
+                texture->image, vk::ImageLayout::eTransferDstOptimal,
+                { imageBlit }, linearFilter ? vk::Filter::eLinear : vk::Filter::eNearest);
+        }
+
+        m_BindingStatesDirty = true;
+    }
+
+    void CommandList::blitTexture(ITexture* _dest, const TextureSlice& destSlice, ITexture* _src, const TextureSlice& srcSlice, bool linearFilter)
+    {
+        Texture* dest = checked_cast<Texture*>(_dest);
+        Texture* src = checked_cast<Texture*>(_src);
+
+        const TextureSlice resolvedDestSlice = destSlice.resolve(dest->desc);
+        const TextureSlice resolvedSrcSlice = srcSlice.resolve(src->desc);
+
+        vk::FormatFeatureFlags srcFeatures = vk::FormatFeatureFlagBits::eBlitSrc;
+        if (linearFilter)
+            srcFeatures |= vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+        if (!checkBlitFormat(m_Context, src->desc, srcFeatures, "blitTexture") ||
+            !checkBlitFormat(m_Context, dest->desc, vk::FormatFeatureFlagBits::eBlitDst, "blitTexture"))
+            return;
+
+        assert(m_CurrentCmdBuf);
+
+        endRenderPass();
+
+        m_CurrentCmdBuf->referencedResources.push_back(dest);
+        m_CurrentCmdBuf->referencedResources.push_back(src);
+
+        if (m_EnableAutomaticBarriers)
+        {
+            requireTextureState(src, TextureSubresourceSet(resolvedSrcSlice.mipLevel, 1, resolvedSrcSlice.arraySlice, 1), ResourceStates::CopySource);
+            requireTextureState(dest, TextureSubresourceSet(resolvedDestSlice.mipLevel, 1, resolvedDestSlice.arraySlice, 1), ResourceStates::CopyDest);
+            m_BindingStatesDirty = true;
+        }
+        commitBarriers();
+
+        const auto imageBlit = vk::ImageBlit()
+            .setSrcSubresource(vk::ImageSubresourceLayers()
+                .setAspectMask(vk::ImageAspectFlagBits::eColor)
+                .setMipLevel(resolvedSrcSlice.mipLevel)
+                .setBaseArrayLayer(resolvedSrcSlice.arraySlice)
+                .setLayerCount(1))
+            .setSrcOffsets({
+                vk::Offset3D(int32_t(resolvedSrcSlice.x), int32_t(resolvedSrcSlice.y), 0),
+                vk::Offset3D(int32_t(resolvedSrcSlice.x + resolvedSrcSlice.width), int32_t(resolvedSrcSlice.y + resolvedSrcSlice.height), 1) })
+            .setDstSubresource(vk::ImageSubresourceLayers()
+                .setAspectMask(vk::ImageAspectFlagBits::eColor)
+                .setMipLevel(resolvedDestSlice.mipLevel)
+                .setBaseArrayLayer(resolvedDestSlice.arraySlice)
+                .setLayerCount(1))
+            .setDstOffsets({
+                vk::Offset3D(int32_t(resolvedDestSlice.x), int32_t(resolvedDestSlice.y), 0),
+                vk::Offset3D(int32_t(resolvedDestSlice.x + resolvedDestSlice.width), int32_t(resolvedDestSlice.y + resolvedDestSlice.height), 1) });
+
+        m_CurrentCmdBuf->cmdBuf.blitImage(src->image, vk::ImageLayout::eTransferSrcOptimal,
+            dest->image, vk::ImageLayout::eTransferDstOptimal,
+            { imageBlit }, linearFilter ? vk::Filter::eLinear : vk::Filter::eNearest);
+    }
+
     void CommandList::clearTexture(ITexture* _texture, TextureSubresourceSet subresources, const vk::ClearColorValue& clearValue)
     {
         endRenderPass();
@@ -751,13 +1051,11 @@ namespace nvrhi::vulkan
 
     Texture::~Texture()
     {
-        for (auto& viewIter : subresourceViews)
+        subresourceViews.forEach([this](const SubresourceViewKey&, TextureSubresourceView& subresourceView)
         {
-            auto& view = viewIter.second.view;
-            m_Context.device.destroyImageView(view, m_Context.allocationCallbacks);
-            view = vk::ImageView();
-        }
-        subresourceViews.clear();
+            m_Context.device.destroyImageView(subresourceView.view, m_Context.allocationCallbacks);
+            subresourceView.view = vk::ImageView();
+        });
 
         if (managed)
         {
@@ -823,6 +1121,12 @@ namespace nvrhi::vulkan
 
     SamplerHandle Device::createSampler(const SamplerDesc& desc)
     {
+        if (m_Deduplication)
+        {
+            if (SamplerHandle existing = m_Deduplication->samplers.find(desc))
+                return existing;
+        }
+
         Sampler *sampler = new Sampler(m_Context);
 
         const bool anisotropyEnable = desc.maxAnisotropy > 1.0f;
@@ -857,7 +1161,12 @@ namespace nvrhi::vulkan
         const vk::Result res = m_Context.device.createSampler(&sampler->samplerInfo, m_Context.allocationCallbacks, &sampler->sampler);
         CHECK_VK_FAIL(res)
         
-        return SamplerHandle::Create(sampler);
+        SamplerHandle handle = SamplerHandle::Create(sampler);
+
+        if (m_Deduplication)
+            handle = m_Deduplication->samplers.insert(desc, handle);
+
+        return handle;
     }
 
     Object Sampler::getNativeObject(ObjectType objectType)
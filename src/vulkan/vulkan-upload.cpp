@@ -38,7 +38,7 @@ namespace nvrhi::vulkan
             desc.debugName = "ScratchBufferChunk";
             desc.canHaveUAVs = true;
 
-            chunk->buffer = m_Device->createBuffer(desc);
+            chunk->buffer = m_Device->createBuffer(desc, MemoryCategory::ScratchChunks);
             chunk->mappedMemory = nullptr;
             chunk->bufferSize = size;
         }
@@ -53,17 +53,65 @@ namespace nvrhi::vulkan
             desc.isAccelStructBuildInput = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
             desc.isShaderBindingTable = m_Device->queryFeatureSupport(Feature::RayTracingAccelStruct);
 
-            chunk->buffer = m_Device->createBuffer(desc);
+            chunk->buffer = m_Device->createBuffer(desc, MemoryCategory::UploadChunks);
+            if (!chunk->buffer)
+                return nullptr;
+
             chunk->mappedMemory = m_Device->mapBuffer(chunk->buffer, CpuAccessMode::Write);
             chunk->bufferSize = size;
         }
 
+        if (!chunk->buffer)
+            return nullptr;
+
+        m_AllocatedMemory += size;
+
         return chunk;
     }
 
+    bool UploadManager::suballocateFromRing(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA,
+        uint64_t currentVersion, uint32_t alignment)
+    {
+        if (!m_RingChunk)
+        {
+            m_RingChunk = CreateChunk(m_Ring.getSize());
+
+            if (!m_RingChunk)
+            {
+                // Couldn't create the ring buffer, use chunks from now on
+                m_Ring.setSize(0);
+                return false;
+            }
+        }
+
+        uint64_t offset = 0;
+        if (!m_Ring.allocate(size, alignment, offset))
+        {
+            // Only query the queue when the ring is full and some of it may have been released by the GPU
+            if (!m_Ring.hasRetirableSpace())
+                return false;
+
+            m_Ring.retire(m_Device->queueGetCompletedInstance(VersionGetQueue(currentVersion)));
+
+            if (!m_Ring.allocate(size, alignment, offset))
+                return false;
+        }
+
+        *pBuffer = checked_cast<Buffer*>(m_RingChunk->buffer.Get());
+        *pOffset = offset;
+        if (pCpuVA)
+            *pCpuVA = (char*)m_RingChunk->mappedMemory + offset;
+
+        return true;
+    }
+
     bool UploadManager::suballocateBuffer(uint64_t size, Buffer** pBuffer, uint64_t* pOffset, void** pCpuVA,
         uint64_t currentVersion, uint32_t alignment)
     {
+        // Uploads that don't fit into the ring fall back to dedicated chunks
+        if (m_Ring.getSize() > 0 && suballocateFromRing(size, pBuffer, pOffset, pCpuVA, currentVersion, alignment))
+            return true;
+
         std::shared_ptr<BufferChunk> chunkToRetire;
 
         if (m_CurrentChunk)
@@ -121,6 +169,9 @@ namespace nvrhi::vulkan
                 return false;
 
             m_CurrentChunk = CreateChunk(sizeToAllocate);
+
+            if (!m_CurrentChunk)
+                return false;
         }
 
         m_CurrentChunk->version = currentVersion;
@@ -136,6 +187,8 @@ namespace nvrhi::vulkan
 
     void UploadManager::submitChunks(uint64_t currentVersion, uint64_t submittedVersion)
     {
+        m_Ring.submit(submittedVersion);
+
         if (m_CurrentChunk)
         {
             m_ChunkPool.push_back(m_CurrentChunk);
@@ -149,4 +202,33 @@ namespace nvrhi::vulkan
         }
     }
 
+    void UploadManager::getStatistics(MemoryStatistics& statistics) const
+    {
+        MemoryCategoryStatistics& result = statistics.get(m_IsScratchBuffer ? MemoryCategory::ScratchChunks : MemoryCategory::UploadChunks);
+
+        // Chunks are never freed before the manager, so the allocated memory is also the peak
+        result.allocatedBytes += m_AllocatedMemory;
+        result.peakAllocatedBytes += m_AllocatedMemory;
+
+        auto addChunk = [&result](const BufferChunk& chunk)
+        {
+            // Chunks with a zero version have been recycled and hold no data
+            if (chunk.version != 0)
+                result.usedBytes += chunk.writePointer;
+            ++result.allocationCount;
+        };
+
+        for (const auto& chunk : m_ChunkPool)
+            addChunk(*chunk);
+
+        if (m_CurrentChunk)
+            addChunk(*m_CurrentChunk);
+
+        if (m_RingChunk)
+        {
+            result.usedBytes += m_Ring.getUsedSize();
+            ++result.allocationCount;
+        }
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,294 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "bench.h"
+
+#include <nvrhi/null.h>
+
+#if NVRHI_BENCH_WITH_DX12
+#include <nvrhi/d3d12.h>
+#include <dxgi1_4.h>
+#endif
+
+#if NVRHI_BENCH_WITH_VULKAN
+#include <nvrhi/vulkan.h>
+#endif
+
+#if NVRHI_BENCH_WITH_CAPTURE
+#include <nvrhi/capture.h>
+#endif
+
+namespace nvrhi::bench
+{
+    namespace
+    {
+        class NullBenchDevice : public BenchDevice
+        {
+        public:
+            DeviceHandle device;
+
+            [[nodiscard]] IDevice* getDevice() const override { return device; }
+            [[nodiscard]] const char* getName() const override { return "null"; }
+            [[nodiscard]] const char* getShaderExtension() const override { return nullptr; }
+        };
+
+#if NVRHI_BENCH_WITH_CAPTURE
+        class CaptureBenchDevice : public BenchDevice
+        {
+        public:
+            std::unique_ptr<BenchDevice> underlyingDevice;
+            DeviceHandle device;
+
+            // The capture device is released first, which completes the file
+            ~CaptureBenchDevice() override { device = nullptr; }
+
+            [[nodiscard]] IDevice* getDevice() const override { return device; }
+            [[nodiscard]] const char* getName() const override { return underlyingDevice->getName(); }
+            [[nodiscard]] const char* getShaderExtension() const override { return underlyingDevice->getShaderExtension(); }
+        };
+#endif
+
+#if NVRHI_BENCH_WITH_DX12
+        class D3D12BenchDevice : public BenchDevice
+        {
+        public:
+            RefCountPtr<ID3D12Device> d3dDevice;
+            RefCountPtr<ID3D12CommandQueue> queues[3];
+            DeviceHandle device;
+
+            [[nodiscard]] IDevice* getDevice() const override { return device; }
+            [[nodiscard]] const char* getName() const override { return "d3d12"; }
+            [[nodiscard]] const char* getShaderExtension() const override { return "dxil"; }
+        };
+#endif
+
+#if NVRHI_BENCH_WITH_VULKAN
+        class VulkanBenchDevice : public BenchDevice
+        {
+        public:
+            VkInstance instance = VK_NULL_HANDLE;
+            VkDevice vkDevice = VK_NULL_HANDLE;
+            DeviceHandle device;
+
+            ~VulkanBenchDevice() override
+            {
+                // The NVRHI device must be gone before the Vulkan device is destroyed
+                device = nullptr;
+
+                if (vkDevice)
+                    vkDestroyDevice(vkDevice, nullptr);
+                if (instance)
+                    vkDestroyInstance(instance, nullptr);
+            }
+
+            [[nodiscard]] IDevice* getDevice() const override { return device; }
+            [[nodiscard]] const char* getName() const override { return "vulkan"; }
+            [[nodiscard]] const char* getShaderExtension() const override { return "spirv"; }
+        };
+#endif
+    }
+
+    std::unique_ptr<BenchDevice> createNullDevice(IMessageCallback* messageCallback)
+    {
+        null::DeviceDesc deviceDesc;
+        deviceDesc.messageCallback = messageCallback;
+
+        auto benchDevice = std::make_unique<NullBenchDevice>();
+        benchDevice->device = null::createDevice(deviceDesc);
+        if (!benchDevice->device)
+            return nullptr;
+
+        return benchDevice;
+    }
+
+#if NVRHI_BENCH_WITH_CAPTURE
+    std::unique_ptr<BenchDevice> createCaptureDevice(std::unique_ptr<BenchDevice> underlyingDevice, const std::string& fileName)
+    {
+        if (!underlyingDevice)
+            return nullptr;
+
+        auto benchDevice = std::make_unique<CaptureBenchDevice>();
+        benchDevice->device = capture::createCaptureLayer(underlyingDevice->getDevice(), capture::CaptureLayerDesc().setFileName(fileName));
+        if (!benchDevice->device)
+            return nullptr;
+
+        benchDevice->underlyingDevice = std::move(underlyingDevice);
+        return benchDevice;
+    }
+#endif
+
+#if NVRHI_BENCH_WITH_DX12
+    std::unique_ptr<BenchDevice> createD3D12Device(IMessageCallback* messageCallback)
+    {
+        RefCountPtr<IDXGIFactory1> factory;
+        if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))))
+            return nullptr;
+
+        auto benchDevice = std::make_unique<D3D12BenchDevice>();
+
+        // Use the first hardware adapter that supports D3D12
+        RefCountPtr<IDXGIAdapter1> adapter;
+        for (UINT adapterIndex = 0; factory->EnumAdapters1(adapterIndex, &adapter) != DXGI_ERROR_NOT_FOUND; adapterIndex++)
+        {
+            DXGI_ADAPTER_DESC1 adapterDesc = {};
+            adapter->GetDesc1(&adapterDesc);
+
+            if ((adapterDesc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0 &&
+                SUCCEEDED(D3D12CreateDevice(adapter, D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&benchDevice->d3dDevice))))
+                break;
+
+            adapter = nullptr;
+        }
+
+        if (!benchDevice->d3dDevice)
+            return nullptr;
+
+        const D3D12_COMMAND_LIST_TYPE queueTypes[] = {
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            D3D12_COMMAND_LIST_TYPE_COMPUTE,
+            D3D12_COMMAND_LIST_TYPE_COPY
+        };
+
+        for (int index = 0; index < 3; index++)
+        {
+            D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+            queueDesc.Type = queueTypes[index];
+
+            if (FAILED(benchDevice->d3dDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&benchDevice->queues[index]))))
+                return nullptr;
+        }
+
+        d3d12::DeviceDesc deviceDesc;
+        deviceDesc.errorCB = messageCallback;
+        deviceDesc.pDevice = benchDevice->d3dDevice;
+        deviceDesc.pGraphicsCommandQueue = benchDevice->queues[0];
+        deviceDesc.pComputeCommandQueue = benchDevice->queues[1];
+        deviceDesc.pCopyCommandQueue = benchDevice->queues[2];
+
+        benchDevice->device = d3d12::createDevice(deviceDesc);
+        if (!benchDevice->device)
+            return nullptr;
+
+        return benchDevice;
+    }
+#endif
+
+#if NVRHI_BENCH_WITH_VULKAN
+    std::unique_ptr<BenchDevice> createVulkanDevice(IMessageCallback* messageCallback)
+    {
+        auto benchDevice = std::make_unique<VulkanBenchDevice>();
+
+        VkApplicationInfo applicationInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+        applicationInfo.pApplicationName = "nvrhi-bench";
+        applicationInfo.apiVersion = VK_API_VERSION_1_3;
+
+        VkInstanceCreateInfo instanceInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+        instanceInfo.pApplicationInfo = &applicationInfo;
+
+        if (vkCreateInstance(&instanceInfo, nullptr, &benchDevice->instance) != VK_SUCCESS)
+            return nullptr;
+
+        uint32_t physicalDeviceCount = 0;
+        vkEnumeratePhysicalDevices(benchDevice->instance, &physicalDeviceCount, nullptr);
+        std::vector<VkPhysicalDevice> physicalDevices(physicalDeviceCount);
+        vkEnumeratePhysicalDevices(benchDevice->instance, &physicalDeviceCount, physicalDevices.data());
+
+        // Use the first device that supports Vulkan 1.3 and has a graphics queue
+        VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+        int graphicsQueueIndex = -1;
+        for (VkPhysicalDevice candidate : physicalDevices)
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(candidate, &properties);
+            if (properties.apiVersion < VK_API_VERSION_1_3)
+                continue;
+
+            uint32_t queueFamilyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, nullptr);
+            std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, queueFamilies.data());
+
+            for (uint32_t family = 0; family < queueFamilyCount; family++)
+            {
+                if (queueFamilies[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                {
+                    graphicsQueueIndex = int(family);
+                    break;
+                }
+            }
+
+            if (graphicsQueueIndex >= 0)
+            {
+                physicalDevice = candidate;
+                break;
+            }
+        }
+
+        if (!physicalDevice)
+            return nullptr;
+
+        VkPhysicalDeviceVulkan13Features features13 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+        features13.dynamicRendering = VK_TRUE;
+        features13.synchronization2 = VK_TRUE;
+
+        VkPhysicalDeviceVulkan12Features features12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+        features12.pNext = &features13;
+        features12.timelineSemaphore = VK_TRUE;
+        features12.bufferDeviceAddress = VK_TRUE;
+
+        const float queuePriority = 1.f;
+        VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+        queueInfo.queueFamilyIndex = uint32_t(graphicsQueueIndex);
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &queuePriority;
+
+        VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+        deviceInfo.pNext = &features12;
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+
+        if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &benchDevice->vkDevice) != VK_SUCCESS)
+            return nullptr;
+
+        VkQueue graphicsQueue = VK_NULL_HANDLE;
+        vkGetDeviceQueue(benchDevice->vkDevice, uint32_t(graphicsQueueIndex), 0, &graphicsQueue);
+
+        vulkan::DeviceDesc deviceDesc;
+        deviceDesc.errorCB = messageCallback;
+        deviceDesc.instance = benchDevice->instance;
+        deviceDesc.physicalDevice = physicalDevice;
+        deviceDesc.device = benchDevice->vkDevice;
+        deviceDesc.graphicsQueue = graphicsQueue;
+        deviceDesc.graphicsQueueIndex = graphicsQueueIndex;
+        deviceDesc.transferQueue = VK_NULL_HANDLE;
+        deviceDesc.computeQueue = VK_NULL_HANDLE;
+        deviceDesc.bufferDeviceAddressSupported = true;
+
+        benchDevice->device = vulkan::createDevice(deviceDesc);
+        if (!benchDevice->device)
+            return nullptr;
+
+        return benchDevice;
+    }
+#endif
+
+} // namespace nvrhi::bench
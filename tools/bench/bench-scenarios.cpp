@@ -0,0 +1,849 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "bench.h"
+
+#include <nvrhi/utils.h>
+
+#if NVRHI_STATIC_DISPATCH
+#include <nvrhi/static-dispatch.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+namespace nvrhi::bench
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr uint32_t c_DrawBindingSetCount = 16;
+        constexpr uint32_t c_DrawVertexBufferCount = 4;
+        constexpr uint32_t c_DrawsPerPipeline = 8;
+        constexpr uint32_t c_DrawsPerVertexBuffer = 4;
+        constexpr uint32_t c_StructuredElementCount = 64;
+        constexpr uint32_t c_StructuredElementSize = 16;
+
+        struct ScenarioContext
+        {
+            IDevice* device = nullptr;
+            const BenchDevice* benchDevice = nullptr;
+            const Options* options = nullptr;
+        };
+
+        // Resources shared by the scenarios that record draws
+        struct DrawResources
+        {
+            TextureHandle renderTarget;
+            FramebufferHandle framebuffer;
+            BindingLayoutHandle bindingLayout;
+            GraphicsPipelineHandle pipelines[2];
+            BufferHandle constantBuffers[c_DrawBindingSetCount];
+            BufferHandle structuredBuffer;
+            BindingSetHandle bindingSets[c_DrawBindingSetCount];
+            BufferHandle vertexBuffers[c_DrawVertexBufferCount];
+
+            // Works with ICommandList and with StaticCommandList
+            template<typename CommandList>
+            void recordDraws(CommandList& commandList, uint32_t drawCount) const
+            {
+                const Viewport viewport(float(renderTarget->getDesc().width), float(renderTarget->getDesc().height));
+
+                for (uint32_t i = 0; i < drawCount; i++)
+                {
+                    GraphicsState state;
+                    state.setPipeline(pipelines[(i / c_DrawsPerPipeline) % 2])
+                        .setFramebuffer(framebuffer)
+                        .setViewport(ViewportState().addViewportAndScissorRect(viewport))
+                        .addBindingSet(bindingSets[i % c_DrawBindingSetCount])
+                        .addVertexBuffer(VertexBufferBinding().setBuffer(vertexBuffers[(i / c_DrawsPerVertexBuffer) % c_DrawVertexBufferCount]));
+
+                    commandList.setGraphicsState(state);
+                    commandList.draw(DrawArguments().setVertexCount(3));
+                }
+            }
+        };
+
+        uint32_t scaled(const ScenarioContext& context, uint32_t count)
+        {
+            return std::max(1u, uint32_t(float(count) * context.options->scale));
+        }
+
+        bool startsWith(const std::string& s, const std::string& prefix)
+        {
+            return s.compare(0, prefix.size(), prefix) == 0;
+        }
+
+        double nanosecondsSince(Clock::time_point start)
+        {
+            return double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+
+        Result makeResult(const char* scenario, const char* operation, uint64_t operationCount, double nanoseconds)
+        {
+            Result result;
+            result.scenario = scenario;
+            result.operation = operation;
+            result.operationCount = operationCount;
+            result.nanosecondsPerOperation = nanoseconds / double(std::max<uint64_t>(operationCount, 1));
+            return result;
+        }
+
+        Result makeSkipped(const char* scenario, const std::string& reason)
+        {
+            Result result;
+            result.scenario = scenario;
+            result.skipped = true;
+            result.skipReason = reason;
+            return result;
+        }
+
+        ShaderHandle loadShader(const ScenarioContext& context, ShaderType shaderType, const char* name, std::string& outError)
+        {
+            const ShaderDesc shaderDesc = ShaderDesc().setShaderType(shaderType).setDebugName(name);
+
+            const char* extension = context.benchDevice->getShaderExtension();
+            if (!extension)
+            {
+                // The null device doesn't look at the bytecode
+                static const uint32_t dummyBytecode[] = { 0 };
+                return context.device->createShader(shaderDesc, dummyBytecode, sizeof(dummyBytecode));
+            }
+
+            if (context.options->shaderDirectory.empty())
+            {
+                outError = "no shader directory specified";
+                return nullptr;
+            }
+
+            const std::string path = context.options->shaderDirectory + "/" + name + "." + extension;
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                outError = "cannot open " + path;
+                return nullptr;
+            }
+
+            const std::vector<char> bytecode((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            ShaderHandle shader = context.device->createShader(shaderDesc, bytecode.data(), bytecode.size());
+            if (!shader)
+                outError = "cannot create a shader from " + path;
+
+            return shader;
+        }
+
+        bool createDrawResources(const ScenarioContext& context, DrawResources& res, std::string& outError)
+        {
+            IDevice* device = context.device;
+
+            ShaderHandle vertexShader = loadShader(context, ShaderType::Vertex, "bench_vs", outError);
+            if (!vertexShader)
+                return false;
+
+            ShaderHandle pixelShader = loadShader(context, ShaderType::Pixel, "bench_ps", outError);
+            if (!pixelShader)
+                return false;
+
+            const VertexAttributeDesc attribute = VertexAttributeDesc()
+                .setName("POSITION")
+                .setFormat(Format::RGB32_FLOAT)
+                .setElementStride(sizeof(float) * 3);
+
+            InputLayoutHandle inputLayout = device->createInputLayout(&attribute, 1, vertexShader);
+
+            res.renderTarget = device->createTexture(TextureDesc()
+                .setDimension(TextureDimension::Texture2D)
+                .setWidth(256)
+                .setHeight(256)
+                .setFormat(Format::RGBA8_UNORM)
+                .setIsRenderTarget(true)
+                .setInitialState(ResourceStates::RenderTarget)
+                .setKeepInitialState(true)
+                .setDebugName("bench render target"));
+
+            res.framebuffer = device->createFramebuffer(FramebufferDesc().addColorAttachment(res.renderTarget));
+
+            res.bindingLayout = device->createBindingLayout(BindingLayoutDesc()
+                .setVisibility(ShaderType::All)
+                .addItem(BindingLayoutItem::ConstantBuffer(0))
+                .addItem(BindingLayoutItem::StructuredBuffer_SRV(0)));
+
+            if (!inputLayout || !res.renderTarget || !res.framebuffer || !res.bindingLayout)
+            {
+                outError = "cannot create the draw resources";
+                return false;
+            }
+
+            RenderState renderState;
+            renderState.depthStencilState.setDepthTestEnable(false);
+
+            for (int index = 0; index < 2; index++)
+            {
+                renderState.rasterState.setCullMode(index == 0 ? RasterCullMode::Back : RasterCullMode::None);
+
+                res.pipelines[index] = device->createGraphicsPipeline(GraphicsPipelineDesc()
+                    .setPrimType(PrimitiveType::TriangleList)
+                    .setInputLayout(inputLayout)
+                    .setVertexShader(vertexShader)
+                    .setPixelShader(pixelShader)
+                    .setRenderState(renderState)
+                    .addBindingLayout(res.bindingLayout), res.framebuffer->getFramebufferInfo());
+
+                if (!res.pipelines[index])
+                {
+                    outError = "cannot create the graphics pipelines";
+                    return false;
+                }
+            }
+
+            res.structuredBuffer = device->createBuffer(BufferDesc()
+                .setByteSize(c_StructuredElementCount * c_StructuredElementSize)
+                .setStructStride(c_StructuredElementSize)
+                .setInitialState(ResourceStates::ShaderResource)
+                .setKeepInitialState(true)
+                .setDebugName("bench structured buffer"));
+
+            for (uint32_t index = 0; index < c_DrawBindingSetCount; index++)
+            {
+                res.constantBuffers[index] = device->createBuffer(BufferDesc()
+                    .setByteSize(256)
+                    .setIsConstantBuffer(true)
+                    .setInitialState(ResourceStates::ConstantBuffer)
+                    .setKeepInitialState(true)
+                    .setDebugName("bench constant buffer"));
+
+                res.bindingSets[index] = device->createBindingSet(BindingSetDesc()
+                    .addItem(BindingSetItem::ConstantBuffer(0, res.constantBuffers[index]))
+                    .addItem(BindingSetItem::StructuredBuffer_SRV(0, res.structuredBuffer)), res.bindingLayout);
+
+                if (!res.bindingSets[index])
+                {
+                    outError = "cannot create the binding sets";
+                    return false;
+                }
+            }
+
+            for (BufferHandle& vertexBuffer : res.vertexBuffers)
+            {
+                vertexBuffer = device->createBuffer(BufferDesc()
+                    .setByteSize(sizeof(float) * 3 * 3)
+                    .setIsVertexBuffer(true)
+                    .setInitialState(ResourceStates::VertexBuffer)
+                    .setKeepInitialState(true)
+                    .setDebugName("bench vertex buffer"));
+
+                if (!vertexBuffer)
+                {
+                    outError = "cannot create the vertex buffers";
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Records draws that change the pipeline, the binding set and the vertex buffer at different rates,
+        // which exercises the graphics state comparison, binding set transitions and reference tracking.
+        void runDrawStateChurn(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            const char* name = "draw-state-churn";
+
+            DrawResources res;
+            std::string error;
+            if (!createDrawResources(context, res, error))
+            {
+                results.push_back(makeSkipped(name, error));
+                return;
+            }
+
+            const uint32_t drawCount = scaled(context, 50000);
+            CommandListHandle commandList = context.device->createCommandList();
+
+            const Clock::time_point start = Clock::now();
+
+            commandList->open();
+            res.recordDraws(*commandList, drawCount);
+            commandList->close();
+            context.device->executeCommandList(commandList);
+
+            results.push_back(makeResult(name, "draw", drawCount, nanosecondsSince(start)));
+        }
+
+#if NVRHI_STATIC_DISPATCH
+        // The same draws as draw-state-churn, recorded through StaticCommandList without virtual calls
+        void runDrawStaticDispatch(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            const char* name = "draw-static-dispatch";
+
+            DrawResources res;
+            std::string error;
+            if (!createDrawResources(context, res, error))
+            {
+                results.push_back(makeSkipped(name, error));
+                return;
+            }
+
+            CommandListHandle commandList = context.device->createCommandList();
+            const StaticCommandList staticCommandList(commandList);
+            if (!staticCommandList)
+            {
+                results.push_back(makeSkipped(name, "the device is not the static dispatch backend"));
+                return;
+            }
+
+            const uint32_t drawCount = scaled(context, 50000);
+
+            const Clock::time_point start = Clock::now();
+
+            staticCommandList.open();
+            res.recordDraws(staticCommandList, drawCount);
+            staticCommandList.close();
+            context.device->executeCommandList(commandList);
+
+            results.push_back(makeResult(name, "draw", drawCount, nanosecondsSince(start)));
+        }
+#endif
+
+        // Records the draws of draw-state-churn once into a reusable command list and executes it many times,
+        // which measures the submission cost that remains when the recording is amortized
+        void runDrawReusable(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            const char* name = "draw-reusable";
+
+            DrawResources res;
+            std::string error;
+            if (!createDrawResources(context, res, error))
+            {
+                results.push_back(makeSkipped(name, error));
+                return;
+            }
+
+            CommandListHandle commandList = context.device->createCommandList(CommandListParameters()
+                .setEnableImmediateExecution(false)
+                .setReusable(true));
+            if (!commandList)
+            {
+                results.push_back(makeSkipped(name, "cannot create a reusable command list"));
+                return;
+            }
+
+            commandList->open();
+            res.recordDraws(*commandList, 1000);
+            commandList->close();
+
+            const uint32_t executionCount = scaled(context, 1000);
+
+            const Clock::time_point start = Clock::now();
+
+            for (uint32_t index = 0; index < executionCount; index++)
+                context.device->executeCommandList(commandList);
+
+            results.push_back(makeResult(name, "execute", executionCount, nanosecondsSince(start)));
+
+            context.device->waitForIdle();
+        }
+
+        // Creates many small binding sets, as done by renderers that build their sets every frame
+        void runBindingSetStorm(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            const char* name = "binding-set-storm";
+            IDevice* device = context.device;
+
+            BindingLayoutHandle bindingLayout = device->createBindingLayout(BindingLayoutDesc()
+                .setVisibility(ShaderType::All)
+                .addItem(BindingLayoutItem::ConstantBuffer(0))
+                .addItem(BindingLayoutItem::StructuredBuffer_SRV(0))
+                .addItem(BindingLayoutItem::Sampler(0)));
+
+            BufferHandle constantBuffer = device->createBuffer(BufferDesc()
+                .setByteSize(256)
+                .setIsConstantBuffer(true)
+                .setInitialState(ResourceStates::ConstantBuffer)
+                .setKeepInitialState(true)
+                .setDebugName("bench constant buffer"));
+
+            BufferHandle structuredBuffer = device->createBuffer(BufferDesc()
+                .setByteSize(c_StructuredElementCount * c_StructuredElementSize)
+                .setStructStride(c_StructuredElementSize)
+                .setInitialState(ResourceStates::ShaderResource)
+                .setKeepInitialState(true)
+                .setDebugName("bench structured buffer"));
+
+            SamplerHandle sampler = device->createSampler(SamplerDesc());
+
+            if (!bindingLayout || !constantBuffer || !structuredBuffer || !sampler)
+            {
+                results.push_back(makeSkipped(name, "cannot create the binding set resources"));
+                return;
+            }
+
+            const uint32_t setCount = scaled(context, 10000);
+            std::vector<BindingSetHandle> bindingSets;
+            bindingSets.reserve(setCount);
+
+            const Clock::time_point start = Clock::now();
+
+            for (uint32_t index = 0; index < setCount; index++)
+            {
+                // Use a different range in every set so that no two descriptors are the same
+                const uint64_t rangeOffset = (index % c_StructuredElementCount) * c_StructuredElementSize;
+
+                bindingSets.push_back(device->createBindingSet(BindingSetDesc()
+                    .addItem(BindingSetItem::ConstantBuffer(0, constantBuffer))
+                    .addItem(BindingSetItem::StructuredBuffer_SRV(0, structuredBuffer, Format::UNKNOWN,
+                        BufferRange(rangeOffset, c_StructuredElementSize)))
+                    .addItem(BindingSetItem::Sampler(0, sampler)), bindingLayout));
+            }
+
+            results.push_back(makeResult(name, "createBindingSet", setCount, nanosecondsSince(start)));
+        }
+
+        // Writes many small pieces of data into a buffer, which exercises the upload memory sub-allocation
+        void runWriteBufferFlood(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            const char* name = "write-buffer-flood";
+            constexpr uint64_t bufferSize = 16 * 1024 * 1024;
+            constexpr size_t writeSize = 256;
+
+            BufferHandle buffer = context.device->createBuffer(BufferDesc()
+                .setByteSize(bufferSize)
+                .setInitialState(ResourceStates::ShaderResource)
+                .setKeepInitialState(true)
+                .setDebugName("bench write target"));
+
+            if (!buffer)
+            {
+                results.push_back(makeSkipped(name, "cannot create the buffer"));
+                return;
+            }
+
+            const uint32_t writeCount = scaled(context, 100000);
+            const std::vector<uint8_t> data(writeSize, 0x5a);
+            CommandListHandle commandList = context.device->createCommandList();
+
+            const Clock::time_point start = Clock::now();
+
+            commandList->open();
+            for (uint32_t index = 0; index < writeCount; index++)
+            {
+                const uint64_t offset = (uint64_t(index) * writeSize) % bufferSize;
+                commandList->writeBuffer(buffer, data.data(), writeSize, offset);
+            }
+            commandList->close();
+            context.device->executeCommandList(commandList);
+
+            results.push_back(makeResult(name, "writeBuffer", writeCount, nanosecondsSince(start)));
+        }
+
+        // Builds a TLAS with many instances, which exercises the instance conversion and upload
+        void runTlasBuild(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            const char* name = "tlas-build";
+            IDevice* device = context.device;
+
+            if (!device->queryFeatureSupport(Feature::RayTracingAccelStruct))
+            {
+                results.push_back(makeSkipped(name, "ray tracing acceleration structures are not supported"));
+                return;
+            }
+
+            const float vertices[] = { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+
+            BufferHandle vertexBuffer = device->createBuffer(BufferDesc()
+                .setByteSize(sizeof(vertices))
+                .setIsAccelStructBuildInput(true)
+                .setInitialState(ResourceStates::AccelStructBuildInput)
+                .setKeepInitialState(true)
+                .setDebugName("bench BLAS vertices"));
+
+            const rt::GeometryDesc geometry = rt::GeometryDesc()
+                .setTriangles(rt::GeometryTriangles()
+                    .setVertexBuffer(vertexBuffer)
+                    .setVertexFormat(Format::RGB32_FLOAT)
+                    .setVertexCount(3)
+                    .setVertexStride(sizeof(float) * 3))
+                .setFlags(rt::GeometryFlags::Opaque);
+
+            const uint32_t instanceCount = scaled(context, 10000);
+
+            rt::AccelStructHandle blas = device->createAccelStruct(rt::AccelStructDesc()
+                .addBottomLevelGeometry(geometry)
+                .setDebugName("bench BLAS"));
+
+            rt::AccelStructHandle tlas = device->createAccelStruct(rt::AccelStructDesc()
+                .setTopLevelMaxInstances(instanceCount)
+                .setDebugName("bench TLAS"));
+
+            if (!vertexBuffer || !blas || !tlas)
+            {
+                results.push_back(makeSkipped(name, "cannot create the acceleration structures"));
+                return;
+            }
+
+            CommandListHandle commandList = device->createCommandList();
+            commandList->open();
+            commandList->writeBuffer(vertexBuffer, vertices, sizeof(vertices));
+            commandList->buildBottomLevelAccelStruct(blas, &geometry, 1);
+            commandList->close();
+            device->executeCommandList(commandList);
+            device->waitForIdle();
+
+            std::vector<rt::InstanceDesc> instances(instanceCount);
+            for (uint32_t index = 0; index < instanceCount; index++)
+            {
+                rt::AffineTransform transform;
+                memcpy(&transform, &rt::c_IdentityTransform, sizeof(transform));
+                transform[3] = float(index % 100);
+                transform[7] = float(index / 100);
+
+                instances[index]
+                    .setBLAS(blas)
+                    .setInstanceID(index)
+                    .setInstanceMask(0xff)
+                    .setTransform(transform);
+            }
+
+            const uint32_t buildCount = scaled(context, 20);
+
+            const Clock::time_point start = Clock::now();
+
+            commandList->open();
+            for (uint32_t build = 0; build < buildCount; build++)
+                commandList->buildTopLevelAccelStruct(tlas, instances.data(), instances.size());
+            commandList->close();
+            device->executeCommandList(commandList);
+
+            results.push_back(makeResult(name, "instance", uint64_t(buildCount) * instanceCount, nanosecondsSince(start)));
+        }
+
+        // Records command lists on several threads at once, sharing the same resources, which shows the contention
+        // in the device and in the resource lifetime tracking. The time is the wall time of the recording.
+        void runMultithreadedRecording(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            IDevice* device = context.device;
+
+            DrawResources res;
+            std::string error;
+            const bool useDraws = createDrawResources(context, res, error);
+
+            BufferHandle sourceBuffer;
+            BufferHandle destBuffer;
+            if (!useDraws)
+            {
+                // Draws need shaders; record copies instead so that the scenario still measures something useful
+                sourceBuffer = device->createBuffer(BufferDesc()
+                    .setByteSize(64 * 1024)
+                    .setInitialState(ResourceStates::CopySource)
+                    .setKeepInitialState(true)
+                    .setDebugName("bench copy source"));
+
+                destBuffer = device->createBuffer(BufferDesc()
+                    .setByteSize(64 * 1024)
+                    .setInitialState(ResourceStates::CopyDest)
+                    .setKeepInitialState(true)
+                    .setDebugName("bench copy destination"));
+            }
+
+            const uint32_t operationsPerThread = scaled(context, 10000);
+            const uint32_t threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+
+            for (uint32_t threadCount : threadCounts)
+            {
+                const std::string name = "mt-recording-" + std::to_string(threadCount);
+                if (!startsWith(name, context.options->scenarioFilter))
+                    continue;
+
+                std::vector<CommandListHandle> commandLists;
+                for (uint32_t index = 0; index < threadCount; index++)
+                    commandLists.push_back(device->createCommandList());
+
+                std::atomic<bool> go = false;
+                std::vector<std::thread> threads;
+
+                for (uint32_t index = 0; index < threadCount; index++)
+                {
+                    threads.emplace_back([&, index]()
+                    {
+                        while (!go.load())
+                            std::this_thread::yield();
+
+                        ICommandList* commandList = commandLists[index];
+                        commandList->open();
+
+                        if (useDraws)
+                        {
+                            res.recordDraws(*commandList, operationsPerThread);
+                        }
+                        else
+                        {
+                            for (uint32_t op = 0; op < operationsPerThread; op++)
+                            {
+                                const uint64_t offset = (op % 256) * 256;
+                                commandList->copyBuffer(destBuffer, offset, sourceBuffer, offset, 256);
+                            }
+                        }
+
+                        commandList->close();
+                    });
+                }
+
+                const Clock::time_point start = Clock::now();
+                go.store(true);
+
+                for (std::thread& thread : threads)
+                    thread.join();
+
+                const double nanoseconds = nanosecondsSince(start);
+
+                std::vector<ICommandList*> commandListPointers;
+                for (const CommandListHandle& commandList : commandLists)
+                    commandListPointers.push_back(commandList);
+                device->executeCommandLists(commandListPointers.data(), commandListPointers.size());
+                device->waitForIdle();
+
+                results.push_back(makeResult(name.c_str(), useDraws ? "draw" : "copyBuffer",
+                    uint64_t(operationsPerThread) * threadCount, nanoseconds));
+            }
+        }
+
+        // The BitSetAllocator that the word-based one replaced: a linear scan over std::vector<bool> from the
+        // last allocated index, serialized by a mutex. Kept here as the baseline for the bitset-allocator scenario.
+        class LegacyBitSetAllocator
+        {
+        public:
+            LegacyBitSetAllocator(size_t capacity, bool multithreaded)
+                : m_Allocated(capacity)
+                , m_MultiThreaded(multithreaded)
+            { }
+
+            int allocate()
+            {
+                if (m_MultiThreaded)
+                    m_Mutex.lock();
+
+                int result = -1;
+
+                const int capacity = static_cast<int>(m_Allocated.size());
+                for (int i = 0; i < capacity; i++)
+                {
+                    const int ii = (m_NextAvailable + i) % capacity;
+
+                    if (!m_Allocated[ii])
+                    {
+                        result = ii;
+                        m_NextAvailable = (ii + 1) % capacity;
+                        m_Allocated[ii] = true;
+                        break;
+                    }
+                }
+
+                if (m_MultiThreaded)
+                    m_Mutex.unlock();
+
+                return result;
+            }
+
+            void release(int index)
+            {
+                if (index >= 0 && index < static_cast<int>(m_Allocated.size()))
+                {
+                    if (m_MultiThreaded)
+                        m_Mutex.lock();
+
+                    m_Allocated[index] = false;
+                    m_NextAvailable = std::min(m_NextAvailable, index);
+
+                    if (m_MultiThreaded)
+                        m_Mutex.unlock();
+                }
+            }
+
+        private:
+            int m_NextAvailable = 0;
+            std::vector<bool> m_Allocated;
+            bool m_MultiThreaded;
+            std::mutex m_Mutex;
+        };
+
+        constexpr uint32_t c_BitSetAllocatorThreadCount = 8;
+
+        template<typename Allocator>
+        void measureBitSetAllocator(const ScenarioContext& context, const char* name, const char* implementation,
+            size_t capacity, uint32_t operationDivisor, std::vector<Result>& results)
+        {
+            const std::string prefix = std::string(implementation) + " ";
+
+            {
+                // Multithreaded, like the allocators of the descriptor heaps
+                Allocator allocator(capacity, true);
+
+                Clock::time_point start = Clock::now();
+
+                for (size_t index = 0; index < capacity; index++)
+                    allocator.allocate();
+
+                results.push_back(makeResult(name, (prefix + "allocate").c_str(), capacity, nanosecondsSince(start)));
+
+                // A stride that is coprime with the power-of-two capacities visits the indices in a scattered order
+                constexpr size_t stride = 7919;
+                const uint32_t churnCount = std::max(1u, scaled(context, 1000000) / operationDivisor);
+
+                start = Clock::now();
+
+                for (uint32_t op = 0; op < churnCount; op++)
+                {
+                    allocator.release(int((size_t(op) * stride) % capacity));
+                    allocator.allocate();
+                }
+
+                results.push_back(makeResult(name, (prefix + "release+allocate").c_str(), churnCount, nanosecondsSince(start)));
+            }
+
+            {
+                // Several threads release and re-allocate their own indices in a full allocator at the same time,
+                // like command lists that create and destroy descriptors on different threads
+                Allocator allocator(capacity, true);
+                for (size_t index = 0; index < capacity; index++)
+                    allocator.allocate();
+
+                const uint32_t churnCountPerThread = std::max(1u, scaled(context, 200000) / operationDivisor);
+
+                std::atomic<bool> go = false;
+                std::vector<std::thread> threads;
+
+                for (uint32_t thread = 0; thread < c_BitSetAllocatorThreadCount; thread++)
+                {
+                    threads.emplace_back([&, thread]()
+                    {
+                        while (!go.load())
+                            std::this_thread::yield();
+
+                        // Each thread starts with a scattered index that it owns
+                        int index = int((size_t(thread) * capacity) / c_BitSetAllocatorThreadCount);
+                        for (uint32_t op = 0; op < churnCountPerThread; op++)
+                        {
+                            allocator.release(index);
+                            const int allocated = allocator.allocate();
+                            if (allocated >= 0)
+                                index = allocated;
+                        }
+                    });
+                }
+
+                const Clock::time_point start = Clock::now();
+                go.store(true);
+
+                for (std::thread& thread : threads)
+                    thread.join();
+
+                const std::string operation = prefix + "release+allocate x" + std::to_string(c_BitSetAllocatorThreadCount);
+                results.push_back(makeResult(name, operation.c_str(), uint64_t(churnCountPerThread) * c_BitSetAllocatorThreadCount,
+                    nanosecondsSince(start)));
+            }
+        }
+
+        // Fills a BitSetAllocator as large as a descriptor heap and then releases and re-allocates scattered
+        // indices while it stays almost full, which is the worst case for the search, first on one thread and
+        // then on several threads at once. The legacy mutex-based allocator runs the same operations as a
+        // baseline. Doesn't use the device.
+        void runBitSetAllocator(const ScenarioContext& context, std::vector<Result>& results)
+        {
+            struct Variant
+            {
+                const char* name;
+                size_t capacity;
+            };
+
+            const Variant variants[] = {
+                { "bitset-allocator-1k", 1024 },
+                { "bitset-allocator-64k", 64 * 1024 },
+                { "bitset-allocator-1m", 1024 * 1024 },
+            };
+
+            for (const Variant& variant : variants)
+            {
+                const std::string name = variant.name;
+                if (!startsWith(name, context.options->scenarioFilter))
+                    continue;
+
+                // The legacy scan is linear in the capacity, so it runs fewer operations to finish in a similar time
+                const uint32_t legacyDivisor = uint32_t(variant.capacity / 1024);
+                measureBitSetAllocator<LegacyBitSetAllocator>(context, variant.name, "legacy", variant.capacity, legacyDivisor, results);
+                measureBitSetAllocator<utils::BitSetAllocator>(context, variant.name, "word", variant.capacity, 1, results);
+            }
+        }
+
+        struct Scenario
+        {
+            const char* name;
+            void (*run)(const ScenarioContext& context, std::vector<Result>& results);
+        };
+
+        const Scenario c_Scenarios[] = {
+            { "draw-state-churn", runDrawStateChurn },
+#if NVRHI_STATIC_DISPATCH
+            { "draw-static-dispatch", runDrawStaticDispatch },
+#endif
+            { "draw-reusable", runDrawReusable },
+            { "binding-set-storm", runBindingSetStorm },
+            { "write-buffer-flood", runWriteBufferFlood },
+            { "tlas-build", runTlasBuild },
+            { "mt-recording", runMultithreadedRecording },
+            { "bitset-allocator", runBitSetAllocator },
+        };
+    }
+
+    std::vector<Result> runScenarios(const BenchDevice& benchDevice, const Options& options)
+    {
+        ScenarioContext context;
+        context.device = benchDevice.getDevice();
+        context.benchDevice = &benchDevice;
+        context.options = &options;
+
+        std::vector<Result> results;
+
+        for (const Scenario& scenario : c_Scenarios)
+        {
+            // A filter like "mt-recording-4" selects one variant of a scenario, which checks the filter again
+            const std::string name = scenario.name;
+            if (!startsWith(name, options.scenarioFilter) && !startsWith(options.scenarioFilter, name))
+                continue;
+
+            scenario.run(context, results);
+
+            // Release everything the scenario created before the next one starts
+            context.device->waitForIdle();
+            context.device->runGarbageCollection();
+        }
+
+        return results;
+    }
+
+} // namespace nvrhi::bench
@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nvrhi::bench
+{
+    struct Options
+    {
+        // Directory with the shaders used by the draw scenarios on real devices, empty to skip those scenarios.
+        // The null device accepts any bytecode and doesn't need them.
+        std::string shaderDirectory;
+
+        // Multiplies the operation counts of all scenarios
+        float scale = 1.f;
+
+        // Runs only the scenarios whose names start with this string
+        std::string scenarioFilter;
+
+        // Records everything the scenarios do on the device into this capture file, see nvrhi::capture
+        std::string captureFile;
+
+        // Replays this capture file on the device instead of running the scenarios
+        std::string replayFile;
+    };
+
+    struct Result
+    {
+        std::string scenario;
+        std::string operation;
+        uint64_t operationCount = 0;
+        double nanosecondsPerOperation = 0.0;
+        bool skipped = false;
+        std::string skipReason;
+    };
+
+    // A device to run the scenarios on, with whatever native objects it needs to stay alive
+    class BenchDevice
+    {
+    public:
+        virtual ~BenchDevice() = default;
+
+        [[nodiscard]] virtual IDevice* getDevice() const = 0;
+        [[nodiscard]] virtual const char* getName() const = 0;
+
+        // File extension of the shader binaries for this device, "dxil" or "spirv", or nullptr if any bytes work
+        [[nodiscard]] virtual const char* getShaderExtension() const = 0;
+    };
+
+    std::unique_ptr<BenchDevice> createNullDevice(IMessageCallback* messageCallback);
+#if NVRHI_BENCH_WITH_DX12
+    std::unique_ptr<BenchDevice> createD3D12Device(IMessageCallback* messageCallback);
+#endif
+#if NVRHI_BENCH_WITH_VULKAN
+    std::unique_ptr<BenchDevice> createVulkanDevice(IMessageCallback* messageCallback);
+#endif
+
+#if NVRHI_BENCH_WITH_CAPTURE
+    // Wraps the device into a capture layer that writes the file
+    std::unique_ptr<BenchDevice> createCaptureDevice(std::unique_ptr<BenchDevice> underlyingDevice, const std::string& fileName);
+#endif
+
+    std::vector<Result> runScenarios(const BenchDevice& device, const Options& options);
+
+} // namespace nvrhi::bench
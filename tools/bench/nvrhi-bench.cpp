@@ -0,0 +1,217 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// nvrhi-bench measures the CPU cost of common NVRHI operations. On the null device, the numbers show the overhead
+// of NVRHI itself; on the real devices, they include the driver. Run with --help for the options.
+
+#include "bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if NVRHI_BENCH_WITH_CAPTURE
+#include <nvrhi/capture.h>
+#endif
+
+namespace
+{
+    class MessageCallback : public nvrhi::IMessageCallback
+    {
+    public:
+        void message(nvrhi::MessageSeverity severity, const char* messageText) override
+        {
+            if (severity == nvrhi::MessageSeverity::Error || severity == nvrhi::MessageSeverity::Fatal)
+                fprintf(stderr, "NVRHI error: %s\n", messageText);
+        }
+    };
+
+    void printUsage()
+    {
+        printf(
+            "Usage: nvrhi-bench [options]\n"
+            "  --api <name>       Device to run on: null (default), d3d12, vulkan, or all\n"
+            "  --scenario <name>  Run only the scenarios whose names start with <name>\n"
+            "  --shaders <dir>    Directory with bench_vs and bench_ps shader binaries (.dxil or .spirv)\n"
+            "                     for the draw scenarios on real devices\n"
+            "  --scale <factor>   Multiply the operation counts by <factor>\n"
+#if NVRHI_BENCH_WITH_CAPTURE
+            "  --capture <file>   Write everything the scenarios do into a capture file\n"
+            "  --replay <file>    Replay a capture file instead of running the scenarios,\n"
+            "                     and print the CPU and GPU time of each marker pass\n"
+#endif
+            );
+    }
+
+#if NVRHI_BENCH_WITH_CAPTURE
+    void replayOnDevice(const nvrhi::bench::BenchDevice& device, const std::string& fileName)
+    {
+        nvrhi::capture::ReplayResult result;
+        if (!nvrhi::capture::replayCapture(device.getDevice(), fileName, nvrhi::capture::ReplayDesc(), result))
+        {
+            printf("%-8s  cannot read the capture file %s\n", device.getName(), fileName.c_str());
+            return;
+        }
+
+        for (const nvrhi::capture::PassTiming& pass : result.passes)
+        {
+            const double gpuMilliseconds = pass.gpuCount ? pass.gpuMilliseconds / pass.gpuCount : 0.0;
+            printf("%-8s  %-32s  %6u times  %10.3f ms cpu  %10.3f ms gpu\n", device.getName(), pass.name.c_str(),
+                pass.count, pass.cpuMilliseconds / pass.count, gpuMilliseconds);
+        }
+
+        printf("%-8s  %llu calls replayed, %llu skipped, %.1f ms total\n", device.getName(),
+            (unsigned long long)result.callsReplayed, (unsigned long long)result.callsSkipped, result.totalMilliseconds);
+
+        for (const std::string& function : result.unsupportedFunctions)
+            printf("%-8s  not captured: %s\n", device.getName(), function.c_str());
+    }
+#endif
+
+    void runOnDevice(std::unique_ptr<nvrhi::bench::BenchDevice> device, const char* apiName, const nvrhi::bench::Options& options)
+    {
+        if (!device)
+        {
+            printf("%-8s  cannot create the device\n", apiName);
+            return;
+        }
+
+#if NVRHI_BENCH_WITH_CAPTURE
+        if (!options.replayFile.empty())
+        {
+            replayOnDevice(*device, options.replayFile);
+            return;
+        }
+
+        if (!options.captureFile.empty())
+        {
+            device = nvrhi::bench::createCaptureDevice(std::move(device), options.captureFile);
+            if (!device)
+            {
+                printf("%-8s  cannot create the capture file %s\n", apiName, options.captureFile.c_str());
+                return;
+            }
+        }
+#endif
+
+        for (const nvrhi::bench::Result& result : nvrhi::bench::runScenarios(*device, options))
+        {
+            if (result.skipped)
+            {
+                printf("%-8s  %-20s  skipped: %s\n", device->getName(), result.scenario.c_str(), result.skipReason.c_str());
+                continue;
+            }
+
+            printf("%-8s  %-20s  %-26s  %10llu ops  %10.1f ns/op\n", device->getName(), result.scenario.c_str(),
+                result.operation.c_str(), (unsigned long long)result.operationCount, result.nanosecondsPerOperation);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    nvrhi::bench::Options options;
+    std::string api = "null";
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+        {
+            printUsage();
+            return 0;
+        }
+
+        if (!value)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            printUsage();
+            return 1;
+        }
+
+        if (!strcmp(arg, "--api"))
+            api = value;
+        else if (!strcmp(arg, "--scenario"))
+            options.scenarioFilter = value;
+        else if (!strcmp(arg, "--shaders"))
+            options.shaderDirectory = value;
+        else if (!strcmp(arg, "--scale"))
+            options.scale = float(atof(value));
+#if NVRHI_BENCH_WITH_CAPTURE
+        else if (!strcmp(arg, "--capture"))
+            options.captureFile = value;
+        else if (!strcmp(arg, "--replay"))
+            options.replayFile = value;
+#endif
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            printUsage();
+            return 1;
+        }
+
+        i++;
+    }
+
+    if (options.scale <= 0.f)
+    {
+        fprintf(stderr, "The scale must be positive\n");
+        return 1;
+    }
+
+    MessageCallback messageCallback;
+    const bool all = api == "all";
+    bool known = all;
+
+    if (all || api == "null")
+    {
+        runOnDevice(nvrhi::bench::createNullDevice(&messageCallback), "null", options);
+        known = true;
+    }
+
+#if NVRHI_BENCH_WITH_DX12
+    if (all || api == "d3d12")
+    {
+        runOnDevice(nvrhi::bench::createD3D12Device(&messageCallback), "d3d12", options);
+        known = true;
+    }
+#endif
+
+#if NVRHI_BENCH_WITH_VULKAN
+    if (all || api == "vulkan")
+    {
+        runOnDevice(nvrhi::bench::createVulkanDevice(&messageCallback), "vulkan", options);
+        known = true;
+    }
+#endif
+
+    if (!known)
+    {
+        fprintf(stderr, "The %s device is unknown or not built into this benchmark\n", api.c_str());
+        return 1;
+    }
+
+    return 0;
+}